@@ -77,11 +77,24 @@ else()
 endif()
 
 set(SC_ENABLE_PTHREAD ${CMAKE_USE_PTHREADS_INIT})
+set(SC_ENABLE_OPENMP ${OpenMP_C_FOUND})
 set(SC_ENABLE_MEMALIGN 1)
+if(atomic_refcount)
+  set(SC_ENABLE_ATOMIC_REFCOUNT 1)
+endif()
 
 if(MPI_FOUND)
   set(SC_ENABLE_MPI 1)
-  check_symbol_exists(MPI_COMM_TYPE_SHARED mpi.h SC_ENABLE_MPICOMMSHARED)
+  # MPI_COMM_TYPE_SHARED may be an enumerator, so it is not a symbol
+  check_c_source_compiles("#include <mpi.h>
+  int main(void) {
+    MPI_Comm subcomm;
+    MPI_Init ((int *) 0, (char ***) 0);
+    MPI_Comm_split_type (MPI_COMM_WORLD, MPI_COMM_TYPE_SHARED, 0,
+                         MPI_INFO_NULL, &subcomm);
+    MPI_Finalize ();
+    return 0;
+  }" SC_ENABLE_MPICOMMSHARED)
   # perform check to set SC_ENABLE_MPIIO
   include(cmake/check_mpiio.cmake)
   check_symbol_exists(MPI_Init_thread mpi.h SC_ENABLE_MPITHREAD)
@@ -96,15 +109,30 @@ if(NOT SC_HAVE_ALIGNED_ALLOC)
   check_symbol_exists(_aligned_malloc malloc.h SC_HAVE_ALIGNED_MALLOC)
 endif()
 
+check_c_source_compiles("#include <stdint.h>
+int main (void) {
+  uint64_t v = 0, e = 0;
+  __atomic_fetch_add (&v, 1, __ATOMIC_RELAXED);
+  return !__atomic_compare_exchange_n (&v, &e, 2, 0,
+                                       __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE);
+}" SC_HAVE_ATOMIC_BUILTINS)
+
 check_symbol_exists(backtrace execinfo.h SC_HAVE_BACKTRACE)
 check_symbol_exists(backtrace_symbols execinfo.h SC_HAVE_BACKTRACE_SYMBOLS)
 
 check_include_file(execinfo.h SC_HAVE_EXECINFO_H)
 check_symbol_exists(fsync unistd.h SC_HAVE_FSYNC)
+check_symbol_exists(clock_gettime time.h SC_HAVE_CLOCK_GETTIME)
 check_include_file(inttypes.h SC_HAVE_INTTYPES_H)
 check_include_file(memory.h SC_HAVE_MEMORY_H)
 
 check_symbol_exists(posix_memalign stdlib.h SC_HAVE_POSIX_MEMALIGN)
+check_include_file(sys/mman.h SC_HAVE_SYS_MMAN_H)
+check_include_file(sys/uio.h SC_HAVE_SYS_UIO_H)
+check_symbol_exists(madvise sys/mman.h SC_HAVE_MADVISE)
+check_include_file(malloc.h SC_HAVE_MALLOC_H)
+check_include_file(linux/perf_event.h SC_HAVE_LINUX_PERF_EVENT_H)
+check_symbol_exists(malloc_usable_size malloc.h SC_HAVE_MALLOC_USABLE_SIZE)
 check_symbol_exists(basename libgen.h SC_HAVE_BASENAME)
 
 # requires -D_GNU_SOURCE, missing on MinGW
@@ -121,6 +149,12 @@ if(SC_HAVE_QSORT_R)
 	"void qsort_r(void *base, size_t nmemb, size_t size, void *thunk, int (*compar)(void *, const void *, const void *))"
 	"" "stdlib.h" SC_HAVE_BSD_QSORT_R)
 endif()
+if(SC_ENABLE_PTHREAD)
+  set(CMAKE_REQUIRED_LIBRARIES ${CMAKE_THREAD_LIBS_INIT})
+  check_symbol_exists(pthread_setaffinity_np pthread.h
+                      SC_HAVE_PTHREAD_SETAFFINITY_NP)
+  set(CMAKE_REQUIRED_LIBRARIES)
+endif()
 set(CMAKE_REQUIRED_DEFINITIONS)
 
 check_symbol_exists(fabs math.h SC_HAVE_FABS)
@@ -193,6 +227,10 @@ else()
   set(SC_ENABLE_DEBUG 0)
 endif()
 
+if(log_priority)
+  set(SC_LOG_PRIORITY ${log_priority})
+endif()
+
 configure_file(${CMAKE_CURRENT_LIST_DIR}/sc_config.h.in ${PROJECT_BINARY_DIR}/include/sc_config.h)
 
 # --- sanity check of MPI sc_config.h
@@ -4,8 +4,10 @@ include(GNUInstallDirs)
 option(mpi "use MPI library" off)
 option(openmp "use OpenMP" off)
 option(zlib "build ZLIB" on)
+option(atomic_refcount "make all reference counters thread safe" off)
 option(BUILD_TESTING "build libsc self-tests" on)
 option(BUILD_SHARED_LIBS "build shared libsc")
+set(log_priority "" CACHE STRING "compile out log messages below this priority, e.g. SC_LP_INFO")
 
 # --- default install directory under build/local
 # users can specify like "cmake -B build -DCMAKE_INSTALL_PREFIX=~/mydir"
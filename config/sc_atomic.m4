@@ -0,0 +1,25 @@
+
+dnl SC_CHECK_ATOMIC(PREFIX)
+dnl Check whether the compiler provides the __atomic builtins
+dnl
+dnl We link a test program with a 64-bit compare-and-swap.
+dnl On success, we define PREFIX_HAVE_ATOMIC_BUILTINS.
+dnl The PREFIX argument is currently unused but should be supplied.
+dnl
+AC_DEFUN([SC_CHECK_ATOMIC], [
+
+AC_MSG_CHECKING([for atomic builtins])
+AC_LINK_IFELSE([AC_LANG_PROGRAM(
+[[
+#include <stdint.h>
+]],[[
+  uint64_t v = 0, e = 0;
+  __atomic_fetch_add (&v, 1, __ATOMIC_RELAXED);
+  return !__atomic_compare_exchange_n (&v, &e, 2, 0,
+                                       __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE);
+]])],
+[AC_MSG_RESULT([successful])
+ AC_DEFINE([HAVE_ATOMIC_BUILTINS], 1,
+           [Define to 1 if the compiler provides __atomic builtins])],
+[AC_MSG_RESULT([not found])])
+])
@@ -389,6 +389,7 @@ SC_CHECK_PTHREAD([$1])
 SC_CHECK_OPENMP([$1])
 SC_CHECK_MEMALIGN([$1])
 SC_CHECK_QSORT_R([$1])
+SC_CHECK_ATOMIC([$1])
 SC_CHECK_V4L2([$1])
 dnl SC_CUDA([$1])
 ])
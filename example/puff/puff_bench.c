@@ -0,0 +1,141 @@
+/*
+  This file is part of the SC Library.
+  The SC Library provides support for parallel scientific applications.
+
+  Copyright (C) 2010 The University of Texas System
+  Additional copyright (C) 2011 individual authors
+
+  The SC Library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  The SC Library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with the SC Library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+  02110-1301, USA.
+*/
+
+/* Compare the inflate speed of sc_puff with the uncompress of zlib. */
+
+#include <sc_options.h>
+#include <sc_puff.h>
+#ifdef SC_HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+#ifdef SC_HAVE_ZLIB
+
+/** Fill a buffer with numbers printed as text, which compress well. */
+static void
+bench_fill (unsigned char *data, size_t size)
+{
+  size_t              zz;
+  int                 len;
+  char                word[32];
+
+  for (zz = 0; zz < size;) {
+    len = snprintf (word, 32, "%.6g ", (double) rand () / RAND_MAX);
+    memcpy (data + zz, word, SC_MIN ((size_t) len, size - zz));
+    zz += (size_t) len;
+  }
+}
+
+static void
+bench_run (size_t size, int level, int repetitions)
+{
+  int                 i, retval;
+  unsigned char      *data, *comp, *back;
+  uLongf              comp_length, back_length;
+  unsigned long       destlen, sourcelen;
+  double              t_zlib, t_puff, t1;
+
+  data = SC_ALLOC (unsigned char, size);
+  back = SC_ALLOC (unsigned char, size);
+  bench_fill (data, size);
+  comp_length = compressBound ((uLong) size);
+  comp = SC_ALLOC (unsigned char, comp_length);
+  retval = compress2 (comp, &comp_length, data, (uLong) size, level);
+  SC_CHECK_ABORT (retval == Z_OK, "zlib compress");
+
+  /* zlib decodes the zlib format */
+  t1 = sc_MPI_Wtime ();
+  for (i = 0; i < repetitions; ++i) {
+    back_length = (uLongf) size;
+    retval = uncompress (back, &back_length, comp, comp_length);
+    SC_CHECK_ABORT (retval == Z_OK && back_length == (uLongf) size,
+                    "zlib uncompress");
+  }
+  t_zlib = (sc_MPI_Wtime () - t1) / repetitions;
+  SC_CHECK_ABORT (!memcmp (data, back, size), "zlib mismatch");
+
+  /* puff decodes the deflate data after the 2 byte zlib header */
+  memset (back, 0, size);
+  t1 = sc_MPI_Wtime ();
+  for (i = 0; i < repetitions; ++i) {
+    destlen = (unsigned long) size;
+    sourcelen = (unsigned long) comp_length - 2;
+    retval = sc_puff (back, &destlen, comp + 2, &sourcelen);
+    SC_CHECK_ABORT (retval == 0 && destlen == (unsigned long) size,
+                    "sc_puff");
+  }
+  t_puff = (sc_MPI_Wtime () - t1) / repetitions;
+  SC_CHECK_ABORT (!memcmp (data, back, size), "sc_puff mismatch");
+
+  SC_GLOBAL_PRODUCTIONF ("Level %d ratio %.3f zlib %.1f MB/s puff %.1f MB/s"
+                         " slowdown %.2f\n", level,
+                         (double) comp_length / size, size / t_zlib * 1e-6,
+                         size / t_puff * 1e-6, t_puff / t_zlib);
+
+  SC_FREE (comp);
+  SC_FREE (back);
+  SC_FREE (data);
+}
+
+#endif /* SC_HAVE_ZLIB */
+
+int
+main (int argc, char **argv)
+{
+  int                 mpiret;
+  int                 first;
+  int                 repetitions;
+  size_t              size;
+  sc_options_t       *opt;
+
+  mpiret = sc_MPI_Init (&argc, &argv);
+  SC_CHECK_MPI (mpiret);
+  sc_init (sc_MPI_COMM_WORLD, 1, 1, NULL, SC_LP_DEFAULT);
+
+  opt = sc_options_new (argv[0]);
+  sc_options_add_size_t (opt, 's', "size", &size, 1 << 24,
+                         "Uncompressed bytes");
+  sc_options_add_int (opt, 'r', "repetitions", &repetitions, 10,
+                      "Repetitions of each decode");
+  first = sc_options_parse (sc_package_id, SC_LP_INFO, opt, argc, argv);
+  if (first < 0 || size == 0 || repetitions <= 0) {
+    sc_options_print_usage (sc_package_id, SC_LP_INFO, opt, NULL);
+    sc_abort_collective ("Usage error");
+  }
+
+#ifdef SC_HAVE_ZLIB
+  bench_run (size, Z_BEST_SPEED, repetitions);
+  bench_run (size, Z_DEFAULT_COMPRESSION, repetitions);
+  bench_run (size, Z_BEST_COMPRESSION, repetitions);
+#else
+  SC_GLOBAL_PRODUCTION ("The comparison requires zlib\n");
+#endif
+
+  sc_options_destroy (opt);
+  sc_finalize ();
+
+  mpiret = sc_MPI_Finalize ();
+  SC_CHECK_MPI (mpiret);
+
+  return 0;
+}
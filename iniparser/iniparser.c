@@ -618,6 +618,47 @@ static line_status iniparser_line(
     return sta ;
 }
 
+/** The input of the parser is a file or a memory buffer. */
+typedef struct ini_source
+{
+    FILE       * in ;
+    const char * buffer ;
+    size_t       pos ;
+    size_t       size ;
+}
+ini_source ;
+
+/*-------------------------------------------------------------------------*/
+/**
+  @brief    Read a line from the input like fgets
+  @param    s   Output space of at least n bytes
+  @param    n   Maximum number of bytes to store including the NUL
+  @param    src File or buffer to read from
+  @return   s or NULL if the input is exhausted
+ */
+/*--------------------------------------------------------------------------*/
+static char * ini_gets(char * s, int n, ini_source * src)
+{
+    int i ;
+
+    if (src->in != NULL) {
+        return fgets(s, n, src->in);
+    }
+    if (src->pos >= src->size || n <= 1) {
+        return NULL ;
+    }
+    for (i = 0 ; i < n - 1 && src->pos < src->size ; ) {
+        if ((s[i++] = src->buffer[src->pos++]) == '\n') {
+            break ;
+        }
+    }
+    s[i] = 0 ;
+    return s ;
+}
+
+static dictionary * iniparser_load_source(ini_source * src,
+                                          const char * ininame);
+
 /*-------------------------------------------------------------------------*/
 /**
   @brief    Parse an ini file and return an allocated dictionary object
@@ -635,7 +676,47 @@ static line_status iniparser_line(
 dictionary * iniparser_load(const char * ininame)
 {
     FILE * in ;
+    ini_source src ;
+    dictionary * dict ;
 
+    if ((in=fopen(ininame, "r"))==NULL) {
+        fprintf(stderr, "iniparser: cannot open %s\n", ininame);
+        return NULL ;
+    }
+    memset(&src, 0, sizeof(src));
+    src.in = in ;
+    dict = iniparser_load_source(&src, ininame);
+    fclose(in);
+    return dict ;
+}
+
+/*-------------------------------------------------------------------------*/
+/**
+  @brief    Parse ini data in memory and return an allocated dictionary
+  @param    buffer  The contents of an ini file, not necessarily
+                    NUL-terminated.
+  @param    size    Length of the buffer in bytes.
+  @param    ininame Name of the data to use in error messages.
+  @return   Pointer to newly allocated dictionary
+
+  This function behaves as iniparser_load() on a file with the contents
+  of the buffer.
+ */
+/*--------------------------------------------------------------------------*/
+dictionary * iniparser_load_buffer(const char * buffer, size_t size,
+                                   const char * ininame)
+{
+    ini_source src ;
+
+    memset(&src, 0, sizeof(src));
+    src.buffer = buffer ;
+    src.size = size ;
+    return iniparser_load_source(&src, ininame);
+}
+
+static dictionary * iniparser_load_source(ini_source * src,
+                                          const char * ininame)
+{
     char line    [ASCIILINESZ+1] ;
     char section [ASCIILINESZ+1] ;
     char key     [ASCIILINESZ+1] ;
@@ -649,14 +730,8 @@ dictionary * iniparser_load(const char * ininame)
 
     dictionary * dict ;
 
-    if ((in=fopen(ininame, "r"))==NULL) {
-        fprintf(stderr, "iniparser: cannot open %s\n", ininame);
-        return NULL ;
-    }
-
     dict = dictionary_new(0) ;
     if (!dict) {
-        fclose(in);
         return NULL ;
     }
 
@@ -666,7 +741,7 @@ dictionary * iniparser_load(const char * ininame)
     memset(val,     0, ASCIILINESZ+1);
     last=0 ;
 
-    while (fgets(line+last, ASCIILINESZ-last, in)!=NULL) {
+    while (ini_gets(line+last, ASCIILINESZ-last, src)!=NULL) {
         lineno++ ;
         len = (int)strlen(line)-1;
         if (len<=0)
@@ -678,7 +753,6 @@ dictionary * iniparser_load(const char * ininame)
                     ininame,
                     lineno);
             dictionary_del(dict);
-            fclose(in);
             return NULL ;
         }
         /* Get rid of \n and spaces at end of line */
@@ -731,7 +805,6 @@ dictionary * iniparser_load(const char * ininame)
         dictionary_del(dict);
         dict = NULL ;
     }
-    fclose(in);
     return dict ;
 }
 
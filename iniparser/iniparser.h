@@ -292,6 +292,21 @@ int iniparser_find_entry(dictionary * ini, const char * entry) ;
 /*--------------------------------------------------------------------------*/
 dictionary * iniparser_load(const char * ininame);
 
+/*-------------------------------------------------------------------------*/
+/**
+  @brief    Parse ini data in memory and return an allocated dictionary
+  @param    buffer  The contents of an ini file, not necessarily
+                    NUL-terminated.
+  @param    size    Length of the buffer in bytes.
+  @param    ininame Name of the data to use in error messages.
+  @return   Pointer to newly allocated dictionary
+
+  The returned dictionary must be freed using iniparser_freedict().
+ */
+/*--------------------------------------------------------------------------*/
+dictionary * iniparser_load_buffer(const char * buffer, size_t size,
+                                   const char * ininame);
+
 /*-------------------------------------------------------------------------*/
 /**
   @brief    Free all memory associated to an ini dictionary
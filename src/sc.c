@@ -22,6 +22,8 @@
 */
 
 #include <sc_private.h>
+#include <sc_atomic.h>
+#include <sc_flops.h>
 
 #ifdef SC_HAVE_SIGNAL_H
 #include <signal.h>
@@ -41,8 +43,47 @@ typedef void        (*sc_sig_t) (int);
 
 #ifdef SC_ENABLE_PTHREAD
 #include <pthread.h>
+#include <sched.h>
 #endif
 
+#ifndef SC_LOG_ASYNC_BYTES
+/** The default size of the ring buffer per thread of the async logger. */
+#define SC_LOG_ASYNC_BYTES (1 << 16)
+#endif
+
+#ifndef SC_LOG_ASYNC_MSEC
+/** The interval in milliseconds at which the async logger drains. */
+#define SC_LOG_ASYNC_MSEC 10
+#endif
+
+#ifdef SC_HAVE_MALLOC_H
+#include <malloc.h>
+#endif
+
+/* find out whether we can query the size of a block when freeing it */
+#ifdef SC_ENABLE_MEMALIGN
+#if defined SC_HAVE_ANY_MEMALIGN && \
+   (defined SC_HAVE_POSIX_MEMALIGN || defined SC_HAVE_ALIGNED_ALLOC)
+#ifdef SC_HAVE_MALLOC_USABLE_SIZE
+#define SC_MEMORY_BLOCK_SIZE(p) malloc_usable_size (p)
+#endif
+#elif !(defined SC_HAVE_ANY_MEMALIGN && defined SC_HAVE_ALIGNED_MALLOC)
+/* sc_malloc_aligned stores the requested size in front of the block */
+#define SC_MEMORY_BLOCK_SIZE(p) ((size_t) ((char **) (p))[-2])
+#endif
+#elif defined SC_HAVE_MALLOC_USABLE_SIZE
+#define SC_MEMORY_BLOCK_SIZE(p) malloc_usable_size (p)
+#endif
+
+/** Byte counters of a package that complement its allocation counts. */
+typedef struct sc_memory_bytes
+{
+  size_t              live;
+  size_t              peak;
+  size_t              histogram[SC_MEMORY_HISTOGRAM_BINS];
+}
+sc_memory_bytes_t;
+
 typedef struct sc_package
 {
   int                 is_registered;
@@ -51,6 +92,7 @@ typedef struct sc_package
   int                 log_indent;
   int                 malloc_count;
   int                 free_count;
+  sc_memory_bytes_t   bytes;
   int                 rc_active;
   int                 abort_mismatch;
   const char         *name;
@@ -96,6 +138,7 @@ int                 sc_trace_prio = SC_LP_STATISTICS;
 
 static int          default_malloc_count = 0;
 static int          default_free_count = 0;
+static sc_memory_bytes_t default_memory_bytes;
 static int          default_rc_active = 0;
 static int          default_abort_mismatch = 1;
 
@@ -114,15 +157,81 @@ static sc_sig_t     system_int_handler = NULL;
 static sc_sig_t     system_segv_handler = NULL;
 
 static int          sc_print_backtrace = 0;
+static int          sc_backtrace_symbolize = -1;
+static char         sc_backtrace_prefix[BUFSIZ];
+#ifdef SC_BACKTRACE
+static void        *sc_backtrace_buffer[SC_STACK_SIZE];
+#endif
+
+/* the event trace is written to this file if the name is not empty */
+static char         sc_flops_trace_name[BUFSIZ];
+
+/** The package table grows by segments of 1, 2, 4, ... entries.
+ * Since the entries never move, lookups need no lock.  Registration is
+ * serialized by \ref sc_registry_mutex and publishes a new segment before
+ * raising \ref sc_num_packages_alloc.
+ */
+#define SC_PACKAGE_SEGMENTS 24
 
 static int          sc_num_packages = 0;
 static int          sc_num_packages_alloc = 0;
-static sc_package_t *sc_packages = NULL;
+static sc_package_t *sc_package_segments[SC_PACKAGE_SEGMENTS];
+
+/* the writable view of the threshold cache read by the log macros;
+   caches outgrown by registration are kept for concurrent readers */
+static int         *sc_log_threshold_cache = NULL;
+static int          sc_log_threshold_alloc = 0;
+static int         *sc_log_threshold_retired[SC_PACKAGE_SEGMENTS];
+static int          sc_log_threshold_num_retired = 0;
+const int          *sc_log_thresholds = NULL;
+int                 sc_log_num_thresholds = 0;
+
+/** Return the entry of a package in the table of packages.
+ * \param [in] package  Index less than \ref sc_num_packages_alloc.
+ */
+static inline sc_package_t *
+sc_package_get (int package)
+{
+  const int           k = SC_LOG2_32 (package + 1);
+
+  return sc_package_segments[k] + (package + 1 - (1 << k));
+}
 
 #ifdef SC_ENABLE_PTHREAD
 
 static pthread_mutex_t sc_default_mutex = PTHREAD_MUTEX_INITIALIZER;
 static pthread_mutex_t sc_error_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_mutex_t sc_registry_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+/* the log indentation is kept per thread */
+static pthread_once_t sc_log_indent_once = PTHREAD_ONCE_INIT;
+static pthread_key_t sc_log_indent_key;
+
+/** The log indentation of one thread for every package. */
+typedef struct sc_log_indent
+{
+  int                 num_packages;
+  int                *indent;
+}
+sc_log_indent_t;
+
+static void
+sc_log_indent_free (void *arg)
+{
+  sc_log_indent_t    *li = (sc_log_indent_t *) arg;
+
+  free (li->indent);
+  free (li);
+}
+
+static void
+sc_log_indent_key_create (void)
+{
+  int                 pth;
+
+  pth = pthread_key_create (&sc_log_indent_key, sc_log_indent_free);
+  SC_CHECK_ABORT (pth == 0, "Log indent key creation");
+}
 
 int
 sc_get_package_id (void)
@@ -153,12 +262,83 @@ sc_package_mutex (int package)
     sc_check_abort_thread (sc_package_is_registered (package),
                            package, "sc_package_mutex");
 #endif
-    return &sc_packages[package].mutex;
+    return &sc_package_get (package)->mutex;
   }
 }
 
 #endif /* SC_ENABLE_PTHREAD */
 
+/** Serialize the changes to the package table and the threshold cache. */
+static void
+sc_registry_lock (void)
+{
+#ifdef SC_ENABLE_PTHREAD
+  pthread_mutex_lock (&sc_registry_mutex);
+#endif
+}
+
+static void
+sc_registry_unlock (void)
+{
+#ifdef SC_ENABLE_PTHREAD
+  pthread_mutex_unlock (&sc_registry_mutex);
+#endif
+}
+
+/** Return the log indentation of the calling thread for a package.
+ * \param [in] package  A registered package.
+ * \param [in] create   If false, we return NULL for a thread without
+ *                      entry.  Otherwise the entry is created.
+ */
+static int         *
+sc_log_indent_get (int package, int create)
+{
+#ifdef SC_ENABLE_PTHREAD
+  int                 i;
+  sc_log_indent_t    *li;
+
+  pthread_once (&sc_log_indent_once, sc_log_indent_key_create);
+  li = (sc_log_indent_t *) pthread_getspecific (sc_log_indent_key);
+  if (li == NULL || package >= li->num_packages) {
+    if (!create) {
+      return NULL;
+    }
+
+    /* this memory is not counted since it may outlive the thread */
+    if (li == NULL) {
+      li = (sc_log_indent_t *) calloc (1, sizeof (sc_log_indent_t));
+      SC_CHECK_ABORT (li != NULL, "Log indent allocation");
+      pthread_setspecific (sc_log_indent_key, li);
+    }
+    li->indent = (int *) realloc (li->indent, (package + 1) * sizeof (int));
+    SC_CHECK_ABORT (li->indent != NULL, "Log indent allocation");
+    for (i = li->num_packages; i <= package; ++i) {
+      li->indent[i] = 0;
+    }
+    li->num_packages = package + 1;
+  }
+  return &li->indent[package];
+#else
+  return &sc_package_get (package)->log_indent;
+#endif
+}
+
+/** Reset the log indentation of the calling thread. */
+static void
+sc_log_indent_reset (void)
+{
+#ifdef SC_ENABLE_PTHREAD
+  sc_log_indent_t    *li;
+
+  pthread_once (&sc_log_indent_once, sc_log_indent_key_create);
+  li = (sc_log_indent_t *) pthread_getspecific (sc_log_indent_key);
+  if (li != NULL) {
+    sc_log_indent_free (li);
+    pthread_setspecific (sc_log_indent_key, NULL);
+  }
+#endif
+}
+
 void
 sc_package_lock (int package)
 {
@@ -197,15 +377,24 @@ sc_package_rc_count_add (int package_id, int toadd)
   }
   else {
     SC_ASSERT (sc_package_is_registered (package_id));
-    pcount = &sc_packages[package_id].rc_active;
+    pcount = &sc_package_get (package_id)->rc_active;
   }
 
+#ifdef SC_HAVE_ATOMIC_BUILTINS
+  /* atomic reference counters may reach zero in concurrent threads */
+#ifdef SC_ENABLE_DEBUG
+  newvalue = SC_ATOMIC_FETCH_ADD (pcount, toadd) + toadd;
+#else
+  SC_ATOMIC_ADD_RELAXED (pcount, toadd);
+#endif
+#else
   sc_package_lock (package_id);
 #ifdef SC_ENABLE_DEBUG
   newvalue =
 #endif
     *pcount += toadd;
   sc_package_unlock (package_id);
+#endif
 
   SC_ASSERT (newvalue >= 0);
 #endif
@@ -255,32 +444,303 @@ sc_set_signal_handler (int catch_signals)
   }
 }
 
+#ifdef SC_ENABLE_PTHREAD
+
+/** A ring buffer of formatted log lines written by one thread.
+ * The owning thread advances the head and the drain the tail. */
+typedef struct sc_log_ring
+{
+  char               *data;
+  size_t              size;     /**< A power of two. */
+  size_t              head;
+  size_t              tail;
+  int                 orphan;   /**< Set when the owning thread exits. */
+  struct sc_log_ring *next;
+}
+sc_log_ring_t;
+
+/** The header of a line in the ring. */
+typedef struct sc_log_record
+{
+  FILE               *stream;
+  size_t              length;
+}
+sc_log_record_t;
+
+/** The streams written in one pass of the drain. */
+#define SC_LOG_ASYNC_STREAMS 4
+
+/* the mutex protects the list of rings and serializes the draining */
+static pthread_mutex_t sc_log_async_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t sc_log_async_cond = PTHREAD_COND_INITIALIZER;
+static pthread_t    sc_log_async_thread;
+static pthread_key_t sc_log_async_key;
+static int          sc_log_async_running = 0;
+static size_t       sc_log_async_bytes = 0;
+static sc_log_ring_t *sc_log_async_rings = NULL;
+
+static void
+sc_log_ring_copy_in (sc_log_ring_t * ring, size_t pos,
+                     const void *src, size_t n)
+{
+  const size_t        off = pos & (ring->size - 1);
+  const size_t        first = SC_MIN (n, ring->size - off);
+
+  memcpy (ring->data + off, src, first);
+  memcpy (ring->data, (const char *) src + first, n - first);
+}
+
+static void
+sc_log_ring_copy_out (sc_log_ring_t * ring, size_t pos, void *dest, size_t n)
+{
+  const size_t        off = pos & (ring->size - 1);
+  const size_t        first = SC_MIN (n, ring->size - off);
+
+  memcpy (dest, ring->data + off, first);
+  memcpy ((char *) dest + first, ring->data, n - first);
+}
+
+/** Write the lines of one ring to their streams.
+ * This function is called with the mutex locked.
+ * \param [in,out] streams  The streams written to so far in this pass.
+ * \return                  The number of streams in \a streams.
+ */
+static int
+sc_log_ring_drain (sc_log_ring_t * ring, FILE ** streams, int num_streams)
+{
+  int                 i;
+  size_t              head, tail, off, first;
+  sc_log_record_t     record;
+
+  head = SC_ATOMIC_LOAD (&ring->head);
+  for (tail = ring->tail; tail != head;
+       tail += sizeof (sc_log_record_t) + record.length) {
+    sc_log_ring_copy_out (ring, tail, &record, sizeof (sc_log_record_t));
+    off = (tail + sizeof (sc_log_record_t)) & (ring->size - 1);
+    first = SC_MIN (record.length, ring->size - off);
+    fwrite (ring->data + off, 1, first, record.stream);
+    fwrite (ring->data, 1, record.length - first, record.stream);
+
+    /* remember the stream for the flush at the end of the pass */
+    for (i = 0; i < num_streams && streams[i] != record.stream; ++i);
+    if (i == num_streams) {
+      if (num_streams < SC_LOG_ASYNC_STREAMS) {
+        streams[num_streams++] = record.stream;
+      }
+      else {
+        fflush (record.stream);
+      }
+    }
+  }
+  SC_ATOMIC_STORE (&ring->tail, tail);
+
+  return num_streams;
+}
+
+/** Drain all rings and free those of exited threads.
+ * This function is called with the mutex locked.
+ */
+static void
+sc_log_async_drain (void)
+{
+  int                 i, num_streams = 0;
+  FILE               *streams[SC_LOG_ASYNC_STREAMS];
+  sc_log_ring_t      *ring, **pring;
+
+  for (pring = &sc_log_async_rings; (ring = *pring) != NULL;) {
+    /* a ring is orphaned after its last line has been pushed */
+    if (SC_ATOMIC_LOAD (&ring->orphan)) {
+      num_streams = sc_log_ring_drain (ring, streams, num_streams);
+      *pring = ring->next;
+      free (ring->data);
+      free (ring);
+    }
+    else {
+      num_streams = sc_log_ring_drain (ring, streams, num_streams);
+      pring = &ring->next;
+    }
+  }
+  for (i = 0; i < num_streams; ++i) {
+    fflush (streams[i]);
+  }
+}
+
+static void        *
+sc_log_async_main (void *arg)
+{
+  struct timespec     ts;
+
+  pthread_mutex_lock (&sc_log_async_mutex);
+  while (sc_log_async_running) {
+    sc_log_async_drain ();
+    clock_gettime (CLOCK_REALTIME, &ts);
+    ts.tv_nsec += 1000000L * SC_LOG_ASYNC_MSEC;
+    ts.tv_sec += ts.tv_nsec / 1000000000L;
+    ts.tv_nsec %= 1000000000L;
+    pthread_cond_timedwait (&sc_log_async_cond, &sc_log_async_mutex, &ts);
+  }
+  sc_log_async_drain ();
+  pthread_mutex_unlock (&sc_log_async_mutex);
+
+  return NULL;
+}
+
+static void
+sc_log_ring_orphan (void *ring)
+{
+  SC_ATOMIC_STORE (&((sc_log_ring_t *) ring)->orphan, 1);
+}
+
+/** Return the ring of the calling thread, creating it if necessary. */
+static sc_log_ring_t *
+sc_log_ring_get (void)
+{
+  sc_log_ring_t      *ring;
+
+  ring = (sc_log_ring_t *) pthread_getspecific (sc_log_async_key);
+  if (ring == NULL) {
+    /* this memory is not counted since it may outlive the thread */
+    ring = (sc_log_ring_t *) malloc (sizeof (sc_log_ring_t));
+    SC_CHECK_ABORT (ring != NULL, "Log ring allocation");
+    ring->data = (char *) malloc (sc_log_async_bytes);
+    SC_CHECK_ABORT (ring->data != NULL, "Log ring allocation");
+    ring->size = sc_log_async_bytes;
+    ring->head = ring->tail = 0;
+    ring->orphan = 0;
+    pthread_mutex_lock (&sc_log_async_mutex);
+    ring->next = sc_log_async_rings;
+    sc_log_async_rings = ring;
+    pthread_mutex_unlock (&sc_log_async_mutex);
+    pthread_setspecific (sc_log_async_key, ring);
+  }
+  return ring;
+}
+
+/** Push a line into the ring of the calling thread.
+ * If the ring is full we wake the drain and wait until it has space.
+ */
+static void
+sc_log_ring_push (FILE * stream, const char *line, size_t length)
+{
+  sc_log_ring_t      *ring = sc_log_ring_get ();
+  sc_log_record_t     record;
+  size_t              need;
+
+  record.stream = stream;
+  record.length = SC_MIN (length, ring->size - sizeof (sc_log_record_t));
+  need = sizeof (sc_log_record_t) + record.length;
+  while (ring->size - (ring->head - SC_ATOMIC_LOAD (&ring->tail)) < need) {
+    pthread_cond_signal (&sc_log_async_cond);
+    sched_yield ();
+  }
+  sc_log_ring_copy_in (ring, ring->head, &record, sizeof (sc_log_record_t));
+  sc_log_ring_copy_in (ring, ring->head + sizeof (sc_log_record_t),
+                       line, record.length);
+  SC_ATOMIC_STORE (&ring->head, ring->head + need);
+}
+
+#endif /* SC_ENABLE_PTHREAD */
+
+void
+sc_log_async_start (size_t ring_bytes)
+{
+#ifdef SC_ENABLE_PTHREAD
+  int                 pth;
+
+  if (sc_log_async_running) {
+    return;
+  }
+
+  /* round up to a power of two that holds a few long lines */
+  sc_log_async_bytes = 4 * BUFSIZ;
+  while (sc_log_async_bytes < (ring_bytes ? ring_bytes : SC_LOG_ASYNC_BYTES)) {
+    sc_log_async_bytes *= 2;
+  }
+  pth = pthread_key_create (&sc_log_async_key, sc_log_ring_orphan);
+  SC_CHECK_ABORT (pth == 0, "Log key creation");
+  sc_log_async_running = 1;
+  pth = pthread_create (&sc_log_async_thread, NULL, sc_log_async_main, NULL);
+  SC_CHECK_ABORT (pth == 0, "Log thread creation");
+#endif
+}
+
+void
+sc_log_async_stop (void)
+{
+#ifdef SC_ENABLE_PTHREAD
+  sc_log_ring_t      *ring;
+
+  if (!sc_log_async_running) {
+    return;
+  }
+
+  /* the thread drains all rings before it quits */
+  pthread_mutex_lock (&sc_log_async_mutex);
+  sc_log_async_running = 0;
+  pthread_cond_signal (&sc_log_async_cond);
+  pthread_mutex_unlock (&sc_log_async_mutex);
+  pthread_join (sc_log_async_thread, NULL);
+
+  while ((ring = sc_log_async_rings) != NULL) {
+    SC_ASSERT (ring->head == ring->tail);
+    sc_log_async_rings = ring->next;
+    free (ring->data);
+    free (ring);
+  }
+  pthread_key_delete (sc_log_async_key);
+#endif
+}
+
+void
+sc_log_flush (void)
+{
+#ifdef SC_ENABLE_PTHREAD
+  if (sc_log_async_running) {
+    pthread_mutex_lock (&sc_log_async_mutex);
+    sc_log_async_drain ();
+    pthread_mutex_unlock (&sc_log_async_mutex);
+  }
+#endif
+  fflush (sc_log_stream != NULL ? sc_log_stream : stdout);
+  if (sc_trace_file != NULL) {
+    fflush (sc_trace_file);
+  }
+}
+
 static void
 sc_log_handler (FILE * log_stream, const char *filename, int lineno,
                 int package, int category, int priority, const char *msg)
 {
   int                 wp = 0, wi = 0;
   int                 lindent = 0;
+  int                 length = 0;
+  int                *pindent;
+  char                line[2 * BUFSIZ];
 
   if (package != -1) {
     if (!sc_package_is_registered (package))
       package = -1;
     else {
       wp = 1;
-      lindent = sc_packages[package].log_indent;
+      pindent = sc_log_indent_get (package, 0);
+      lindent = pindent != NULL ? *pindent : 0;
     }
   }
   wi = (category == SC_LC_NORMAL && sc_identifier >= 0);
 
+  /* format the line in memory and write it at once */
   if (wp || wi) {
-    fputc ('[', log_stream);
+    length += snprintf (line + length, sizeof (line) - length, "[");
     if (wp)
-      fprintf (log_stream, "%s", sc_packages[package].name);
+      length += snprintf (line + length, sizeof (line) - length, "%s",
+                          sc_package_get (package)->name);
     if (wp && wi)
-      fputc (' ', log_stream);
+      length += snprintf (line + length, sizeof (line) - length, " ");
     if (wi)
-      fprintf (log_stream, "%d", sc_identifier);
-    fprintf (log_stream, "] %*s", lindent, "");
+      length += snprintf (line + length, sizeof (line) - length, "%d",
+                          sc_identifier);
+    length += snprintf (line + length, sizeof (line) - length, "] %*s",
+                        lindent, "");
   }
 
   if (priority == SC_LP_TRACE) {
@@ -292,10 +752,20 @@ sc_log_handler (FILE * log_stream, const char *filename, int lineno,
 #else
     bp = basename (bn);
 #endif
-    fprintf (log_stream, "%s:%d ", bp, lineno);
+    length += snprintf (line + length, sizeof (line) - length, "%s:%d ",
+                        bp, lineno);
   }
 
-  fputs (msg, log_stream);
+  length += snprintf (line + length, sizeof (line) - length, "%s", msg);
+  length = SC_MIN (length, (int) sizeof (line) - 1);
+
+#ifdef SC_ENABLE_PTHREAD
+  if (sc_log_async_running) {
+    sc_log_ring_push (log_stream, line, (size_t) length);
+    return;
+  }
+#endif
+  fputs (line, log_stream);
   fflush (log_stream);
 }
 
@@ -308,7 +778,7 @@ sc_malloc_count (int package)
     return &default_malloc_count;
 
   SC_ASSERT (sc_package_is_registered (package));
-  return &sc_packages[package].malloc_count;
+  return &sc_package_get (package)->malloc_count;
 }
 
 static int         *
@@ -318,7 +788,101 @@ sc_free_count (int package)
     return &default_free_count;
 
   SC_ASSERT (sc_package_is_registered (package));
-  return &sc_packages[package].free_count;
+  return &sc_package_get (package)->free_count;
+}
+
+/** Update a memory counter without serializing the allocating threads.
+ * With atomic builtins we do not need the package lock. */
+static inline void
+sc_memory_count_add (int package, int *pcount, int toadd)
+{
+#ifdef SC_HAVE_ATOMIC_BUILTINS
+  SC_ATOMIC_ADD_RELAXED (pcount, toadd);
+#else
+#ifdef SC_ENABLE_PTHREAD
+  sc_package_lock (package);
+#endif
+  *pcount += toadd;
+#ifdef SC_ENABLE_PTHREAD
+  sc_package_unlock (package);
+#endif
+#endif
+}
+
+static sc_memory_bytes_t *
+sc_memory_bytes (int package)
+{
+  if (package == -1)
+    return &default_memory_bytes;
+
+  SC_ASSERT (sc_package_is_registered (package));
+  return &sc_package_get (package)->bytes;
+}
+
+/** Record an allocation request and the size of the block it returned.
+ * \param [in] size     Requested size, used for the histogram.
+ * \param [in] block    Size of the block or zero if not tracked.
+ */
+static void
+sc_memory_bytes_add (int package, size_t size, size_t block)
+{
+  sc_memory_bytes_t  *bytes = sc_memory_bytes (package);
+  int                 bin = SC_MAX (SC_LOG2_64 ((uint64_t) size), 0);
+#ifdef SC_HAVE_ATOMIC_BUILTINS
+  size_t              live, peak;
+
+  SC_ATOMIC_ADD_RELAXED (&bytes->histogram[bin], 1);
+  if (block > 0) {
+    live = SC_ATOMIC_FETCH_ADD (&bytes->live, block) + block;
+    peak = SC_ATOMIC_LOAD (&bytes->peak);
+    while (live > peak && !SC_ATOMIC_CAS (&bytes->peak, &peak, live)) {
+      /* peak has been reloaded by the failed exchange */
+    }
+  }
+#else
+#ifdef SC_ENABLE_PTHREAD
+  sc_package_lock (package);
+#endif
+  ++bytes->histogram[bin];
+  bytes->live += block;
+  bytes->peak = SC_MAX (bytes->peak, bytes->live);
+#ifdef SC_ENABLE_PTHREAD
+  sc_package_unlock (package);
+#endif
+#endif
+}
+
+/** Record that a block of the given size is released. */
+static void
+sc_memory_bytes_sub (int package, size_t block)
+{
+  sc_memory_bytes_t  *bytes = sc_memory_bytes (package);
+
+  if (block == 0) {
+    return;
+  }
+#ifdef SC_HAVE_ATOMIC_BUILTINS
+  SC_ATOMIC_ADD_RELAXED (&bytes->live, (size_t) 0 - block);
+#else
+#ifdef SC_ENABLE_PTHREAD
+  sc_package_lock (package);
+#endif
+  bytes->live -= block;
+#ifdef SC_ENABLE_PTHREAD
+  sc_package_unlock (package);
+#endif
+#endif
+}
+
+/** Return the size of an allocated block or zero if we cannot know it. */
+static size_t
+sc_memory_block_size (void *ptr)
+{
+#ifdef SC_MEMORY_BLOCK_SIZE
+  return ptr == NULL ? 0 : (size_t) SC_MEMORY_BLOCK_SIZE (ptr);
+#else
+  return 0;
+#endif
 }
 
 #endif
@@ -549,23 +1113,13 @@ sc_malloc (int package, size_t size)
 #endif
 
   /* count the allocations */
-#ifdef SC_ENABLE_PTHREAD
-  sc_package_lock (package);
-#endif
-
 #ifndef SC_NOCOUNT_MALLOC
-  if (size > 0) {
-    ++*malloc_count;
-  }
-  else {
-    *malloc_count += ((ret == NULL) ? 0 : 1);
+  if (size > 0 || ret != NULL) {
+    sc_memory_count_add (package, malloc_count, 1);
+    sc_memory_bytes_add (package, size, sc_memory_block_size (ret));
   }
 #endif
 
-#ifdef SC_ENABLE_PTHREAD
-  sc_package_unlock (package);
-#endif
-
   return ret;
 }
 
@@ -590,23 +1144,13 @@ sc_calloc (int package, size_t nmemb, size_t size)
 #endif
 
   /* count the allocations */
-#ifdef SC_ENABLE_PTHREAD
-  sc_package_lock (package);
-#endif
-
 #ifndef SC_NOCOUNT_MALLOC
-  if (nmemb * size > 0) {
-    ++*malloc_count;
-  }
-  else {
-    *malloc_count += ((ret == NULL) ? 0 : 1);
+  if (nmemb * size > 0 || ret != NULL) {
+    sc_memory_count_add (package, malloc_count, 1);
+    sc_memory_bytes_add (package, nmemb * size, sc_memory_block_size (ret));
   }
 #endif
 
-#ifdef SC_ENABLE_PTHREAD
-  sc_package_unlock (package);
-#endif
-
   return ret;
 }
 
@@ -622,6 +1166,9 @@ sc_realloc (int package, void *ptr, size_t size)
   }
   else {
     void               *ret;
+#ifndef SC_NOCOUNT_MALLOC
+    size_t              old_block = sc_memory_block_size (ptr);
+#endif
 
 #if defined SC_ENABLE_MEMALIGN
     ret = sc_realloc_aligned (ptr, SC_MEMALIGN_BYTES, size);
@@ -631,6 +1178,12 @@ sc_realloc (int package, void *ptr, size_t size)
                      (long long int) size);
 #endif
 
+    /* the number of blocks is unchanged, but their size is not */
+#ifndef SC_NOCOUNT_MALLOC
+    sc_memory_bytes_sub (package, old_block);
+    sc_memory_bytes_add (package, size, sc_memory_block_size (ret));
+#endif
+
     return ret;
   }
 }
@@ -661,19 +1214,8 @@ sc_free (int package, void *ptr)
   else {
     /* uncount the allocations */
 #ifndef SC_NOCOUNT_MALLOC
-    int                *free_count = sc_free_count (package);
-#endif
-
-#ifdef SC_ENABLE_PTHREAD
-    sc_package_lock (package);
-#endif
-
-#ifndef SC_NOCOUNT_MALLOC
-    ++*free_count;
-#endif
-
-#ifdef SC_ENABLE_PTHREAD
-    sc_package_unlock (package);
+    sc_memory_count_add (package, sc_free_count (package), 1);
+    sc_memory_bytes_sub (package, sc_memory_block_size (ptr));
 #endif
   }
 
@@ -691,13 +1233,41 @@ sc_memory_status (int package)
   sc_package_t       *p;
 
   if (package == -1) {
-    return (default_malloc_count - default_free_count);
+    return (SC_ATOMIC_LOAD (&default_malloc_count) -
+            SC_ATOMIC_LOAD (&default_free_count));
   }
   else {
     SC_ASSERT (sc_package_is_registered (package));
-    p = sc_packages + package;
-    return (p->malloc_count - p->free_count);
+    p = sc_package_get (package);
+    return (SC_ATOMIC_LOAD (&p->malloc_count) -
+            SC_ATOMIC_LOAD (&p->free_count));
+  }
+}
+
+void
+sc_memory_stats (int package, sc_memory_stats_t * stats)
+{
+#ifndef SC_NOCOUNT_MALLOC
+  int                 b;
+  sc_memory_bytes_t  *bytes;
+#endif
+
+  SC_ASSERT (stats != NULL);
+  memset (stats, 0, sizeof (sc_memory_stats_t));
+
+#ifndef SC_NOCOUNT_MALLOC
+  stats->malloc_count = SC_ATOMIC_LOAD (sc_malloc_count (package));
+  stats->free_count = SC_ATOMIC_LOAD (sc_free_count (package));
+#ifdef SC_MEMORY_BLOCK_SIZE
+  stats->bytes_tracked = 1;
+#endif
+  bytes = sc_memory_bytes (package);
+  stats->live_bytes = SC_ATOMIC_LOAD (&bytes->live);
+  stats->peak_bytes = SC_ATOMIC_LOAD (&bytes->peak);
+  for (b = 0; b < SC_MEMORY_HISTOGRAM_BINS; ++b) {
+    stats->histogram[b] = SC_ATOMIC_LOAD (&bytes->histogram[b]);
   }
+#endif
 }
 
 void
@@ -710,7 +1280,7 @@ sc_package_set_abort_alloc_mismatch (int package_id, int set_abort)
     sc_package_t       *p;
 
     SC_ASSERT (sc_package_is_registered (package_id));
-    p = sc_packages + package_id;
+    p = sc_package_get (package_id);
     p->abort_mismatch = set_abort;
   }
 }
@@ -725,7 +1295,7 @@ sc_memory_check_noabort (int package)
       SC_LERROR ("Leftover references (default)\n");
       ++num_errors;
     }
-    if (default_malloc_count != default_free_count) {
+    if (sc_memory_status (-1) != 0) {
       SC_LERROR ("Memory balance (default)\n");
       ++num_errors;
     }
@@ -736,13 +1306,13 @@ sc_memory_check_noabort (int package)
       ++num_errors;
     }
     else {
-      sc_package_t       *p = sc_packages + package;
+      sc_package_t       *p = sc_package_get (package);
 
       if (p->rc_active != 0) {
         SC_LERRORF ("Leftover references (%s)\n", p->name);
         ++num_errors;
       }
-      if (p->malloc_count != p->free_count) {
+      if (sc_memory_status (package) != 0) {
         SC_LERRORF ("Memory balance (%s)\n", p->name);
         ++num_errors;
       }
@@ -758,7 +1328,7 @@ sc_query_doabort (int package)
     return default_abort_mismatch;
   }
   else if (sc_package_is_registered (package)) {
-    return sc_packages[package].abort_mismatch;
+    return sc_package_get (package)->abort_mismatch;
   }
   else {
     return 1;
@@ -840,6 +1410,46 @@ sc_atol (const char *nptr)
   return strtol (nptr, NULL, 10);
 }
 
+/** Recompute the lowest logged priority of every package.
+ * It is the smaller of the log threshold and, with a trace file open,
+ * the trace priority.  Unregistered packages log like package -1.
+ * This function must be called whenever one of these inputs changes.
+ */
+static void
+sc_log_thresholds_update (void)
+{
+  int                 i, t;
+  const int           trace =
+    sc_trace_file != NULL ? sc_trace_prio : SC_LP_SILENT;
+  int                *cache;
+  sc_package_t       *p;
+
+  /* a reader may still hold an outgrown cache, which we keep valid */
+  sc_registry_lock ();
+  cache = sc_log_threshold_cache;
+  if (sc_log_threshold_alloc < sc_num_packages_alloc + 1) {
+    cache = (int *) malloc ((sc_num_packages_alloc + 1) * sizeof (int));
+    SC_CHECK_ABORT (cache != NULL, "Log threshold cache");
+    if (sc_log_threshold_cache != NULL) {
+      SC_ASSERT (sc_log_threshold_num_retired < SC_PACKAGE_SEGMENTS);
+      sc_log_threshold_retired[sc_log_threshold_num_retired++] =
+        sc_log_threshold_cache;
+    }
+    sc_log_threshold_alloc = sc_num_packages_alloc + 1;
+  }
+  SC_ATOMIC_STORE (&cache[0], SC_MIN (sc_default_log_threshold, trace));
+  for (i = 0; i < sc_num_packages_alloc; ++i) {
+    p = sc_package_get (i);
+    t = (!p->is_registered || p->log_threshold == SC_LP_DEFAULT) ?
+      sc_default_log_threshold : p->log_threshold;
+    SC_ATOMIC_STORE (&cache[i + 1], SC_MIN (t, trace));
+  }
+  sc_log_threshold_cache = cache;
+  SC_ATOMIC_STORE (&sc_log_thresholds, (const int *) cache);
+  SC_ATOMIC_STORE (&sc_log_num_thresholds, sc_num_packages_alloc + 1);
+  sc_registry_unlock ();
+}
+
 void
 sc_set_log_defaults (FILE * log_stream,
                      sc_log_handler_t log_handler, int log_threshold)
@@ -856,6 +1466,7 @@ sc_set_log_defaults (FILE * log_stream,
   }
 
   sc_log_stream = log_stream;
+  sc_log_thresholds_update ();
 }
 
 void
@@ -875,7 +1486,7 @@ sc_log (const char *filename, int lineno,
     log_handler = sc_default_log_handler;
   }
   else {
-    p = sc_packages + package;
+    p = sc_package_get (package);
     log_threshold =
       (p->log_threshold ==
        SC_LP_DEFAULT) ? sc_default_log_threshold : p->log_threshold;
@@ -889,8 +1500,11 @@ sc_log (const char *filename, int lineno,
   if (category == SC_LC_GLOBAL && sc_identifier > 0)
     return;
 
+  /* the builtin handler writes every line at once and needs no lock */
 #ifdef SC_ENABLE_PTHREAD
-  sc_package_lock (package);
+  if (log_handler != sc_log_handler) {
+    sc_package_lock (package);
+  }
 #endif
   if (sc_trace_file != NULL && priority >= sc_trace_prio)
     log_handler (sc_trace_file, filename, lineno,
@@ -900,7 +1514,9 @@ sc_log (const char *filename, int lineno,
     log_handler (sc_log_stream != NULL ? sc_log_stream : stdout,
                  filename, lineno, package, category, priority, msg);
 #ifdef SC_ENABLE_PTHREAD
-  sc_package_unlock (package);
+  if (log_handler != sc_log_handler) {
+    sc_package_unlock (package);
+  }
 #endif
 }
 
@@ -921,13 +1537,7 @@ sc_logv (const char *filename, int lineno,
 {
   char                buffer[BUFSIZ];
 
-#ifdef SC_ENABLE_PTHREAD
-  sc_package_lock (package);
-#endif
   vsnprintf (buffer, BUFSIZ, fmt, ap);
-#ifdef SC_ENABLE_PTHREAD
-  sc_package_unlock (package);
-#endif
   sc_log (filename, lineno, package, category, priority, buffer);
 }
 
@@ -946,34 +1556,29 @@ sc_log_indent_pop (void)
 void
 sc_log_indent_push_count (int package, int count)
 {
-  /* TODO: figure out a version that makes sense with threads */
+  /* with threads every thread has its own indentation */
 #ifndef SC_NOCOUNT_LOGINDENT
-#ifndef SC_ENABLE_PTHREAD
-  SC_ASSERT (package < sc_num_packages);
+  SC_ASSERT (package < sc_num_packages_alloc);
 
   if (package >= 0) {
-    sc_packages[package].log_indent += SC_MAX (0, count);
+    *sc_log_indent_get (package, 1) += SC_MAX (0, count);
   }
 #endif
-#endif
 }
 
 void
 sc_log_indent_pop_count (int package, int count)
 {
-  /* TODO: figure out a version that makes sense with threads */
 #ifndef SC_NOCOUNT_LOGINDENT
-#ifndef SC_ENABLE_PTHREAD
-  int                 new_indent;
+  int                *pindent;
 
-  SC_ASSERT (package < sc_num_packages);
+  SC_ASSERT (package < sc_num_packages_alloc);
 
   if (package >= 0) {
-    new_indent = sc_packages[package].log_indent - SC_MAX (0, count);
-    sc_packages[package].log_indent = SC_MAX (0, new_indent);
+    pindent = sc_log_indent_get (package, 1);
+    *pindent = SC_MAX (0, *pindent - SC_MAX (0, count));
   }
 #endif
-#endif
 }
 
 void
@@ -986,23 +1591,96 @@ sc_set_abort_handler (sc_abort_handler_t abort_handler)
 void
 sc_abort (void)
 {
+  /* a user supplied handler may not return to flush the log */
+  sc_log_flush ();
   sc_default_abort_handler ();
   abort ();                     /* if the user supplied callback incorrecty returns, abort */
 }
 
+void
+sc_set_backtrace_dump (int symbolize_ranks, const char *prefix)
+{
+  sc_backtrace_symbolize = symbolize_ranks;
+  if (prefix != NULL) {
+    snprintf (sc_backtrace_prefix, BUFSIZ, "%s", prefix);
+  }
+  else {
+    sc_backtrace_prefix[0] = '\0';
+  }
+#ifdef SC_BACKTRACE
+  /* the first call may allocate to load the unwinder */
+  (void) backtrace (sc_backtrace_buffer, 1);
+#endif
+}
+
+#ifdef SC_BACKTRACE
+
+/** Write the raw stack addresses and the executable mappings to a file.
+ * \param [in] bt_size      Number of valid entries in the buffer.
+ * \return                  True if the crash file has been written.
+ */
+static int
+sc_backtrace_dump (int bt_size)
+{
+  int                 i;
+  char                filename[BUFSIZ + 16];
+  char                line[BUFSIZ];
+  FILE               *file, *maps;
+
+  snprintf (filename, BUFSIZ + 16, "%s.%d", sc_backtrace_prefix,
+            SC_MAX (sc_identifier, 0));
+  if ((file = fopen (filename, "w")) == NULL) {
+    return 0;
+  }
+  fprintf (file, "sc_crash %d %d\n", sc_identifier, bt_size);
+  for (i = 0; i < bt_size; ++i) {
+    fprintf (file, "%p\n", sc_backtrace_buffer[i]);
+  }
+
+  /* the executable mappings relate the addresses to the object files */
+  if ((maps = fopen ("/proc/self/maps", "r")) != NULL) {
+    while (fgets (line, BUFSIZ, maps) != NULL) {
+      if (strstr (line, " r-xp ") != NULL) {
+        fputs (line, file);
+      }
+    }
+    fclose (maps);
+  }
+  return fclose (file) == 0;
+}
+
+#endif /* SC_BACKTRACE */
+
 static void
 sc_abort_handler (void)
 {
   if (0) {
   }
 #ifdef SC_BACKTRACE
+  else if (sc_print_backtrace && sc_backtrace_symbolize >= 0 &&
+           sc_identifier >= sc_backtrace_symbolize) {
+    int                 bt_size;
+
+    /* capture the raw addresses only and leave symbols to others */
+    bt_size = backtrace (sc_backtrace_buffer, SC_STACK_SIZE);
+    if (sc_backtrace_prefix[0] != '\0' && sc_backtrace_dump (bt_size)) {
+      SC_LERRORF ("Abort: %d stack frames written to %s.%d\n", bt_size,
+                  sc_backtrace_prefix, SC_MAX (sc_identifier, 0));
+    }
+    else {
+      SC_LERRORF ("Abort: Obtained %d stack frames\n", bt_size);
+    }
+  }
   else if (sc_print_backtrace) {
     int                 i, bt_size;
-    void               *bt_buffer[SC_STACK_SIZE];
+    void              **bt_buffer = sc_backtrace_buffer;
     char              **bt_strings;
     const char         *str;
 
     bt_size = backtrace (bt_buffer, SC_STACK_SIZE);
+    if (sc_backtrace_prefix[0] != '\0') {
+      (void) sc_backtrace_dump (bt_size);
+    }
     bt_strings = backtrace_symbols (bt_buffer, bt_size);
 
     SC_LERRORF ("Abort: Obtained %d stack frames\n", bt_size);
@@ -1028,6 +1706,7 @@ sc_abort_handler (void)
     SC_LERROR ("Abort\n");
   }
 
+  sc_log_flush ();
   fflush (stdout);
   fflush (stderr);
 #ifndef _MSC_VER
@@ -1092,7 +1771,7 @@ int
 sc_package_register (sc_log_handler_t log_handler, int log_threshold,
                      const char *name, const char *full)
 {
-  int                 i;
+  int                 i, k;
   sc_package_t       *p;
   sc_package_t       *new_package = NULL;
   int                 new_package_id = -1;
@@ -1105,16 +1784,16 @@ sc_package_register (sc_log_handler_t log_handler, int log_threshold,
   SC_CHECK_ABORT (strchr (name, ' ') == NULL,
                   "Packages name contains spaces");
 
-  /* sc_packages is static and thus initialized to all zeros */
+  sc_registry_lock ();
   for (i = 0; i < sc_num_packages_alloc; ++i) {
-    p = sc_packages + i;
+    p = sc_package_get (i);
     SC_CHECK_ABORTF (!p->is_registered || strcmp (p->name, name),
                      "Package %s is already registered", name);
   }
 
-  /* Try to find unused space in sc_packages  */
+  /* Try to find unused space in the package table */
   for (i = 0; i < sc_num_packages_alloc; ++i) {
-    p = sc_packages + i;
+    p = sc_package_get (i);
     if (!p->is_registered) {
       new_package = p;
       new_package_id = i;
@@ -1122,37 +1801,39 @@ sc_package_register (sc_log_handler_t log_handler, int log_threshold,
     }
   }
 
-  /* realloc if the space in sc_packages is used up */
+  /* add a segment of the size of all previous ones plus one */
   if (i == sc_num_packages_alloc) {
-    sc_packages = (sc_package_t *) realloc (sc_packages,
-                                            (2 * sc_num_packages_alloc +
-                                             1) * sizeof (sc_package_t));
-    SC_CHECK_ABORT (sc_packages, "Failed to allocate memory");
-    new_package = sc_packages + i;
+    k = SC_LOG2_32 (i + 1);
+    SC_CHECK_ABORT (k < SC_PACKAGE_SEGMENTS, "Too many packages");
+    sc_package_segments[k] =
+      (sc_package_t *) malloc ((1 << k) * sizeof (sc_package_t));
+    SC_CHECK_ABORT (sc_package_segments[k], "Failed to allocate memory");
+    new_package = sc_package_segments[k];
     new_package_id = i;
-    sc_num_packages_alloc = 2 * sc_num_packages_alloc + 1;
 
     /* initialize new packages */
-    for (; i < sc_num_packages_alloc; i++) {
-      p = sc_packages + i;
+    for (; i < 2 * sc_num_packages_alloc + 1; i++) {
+      p = sc_package_get (i);
       p->is_registered = 0;
       p->log_handler = NULL;
       p->log_threshold = SC_LP_SILENT;
       p->log_indent = 0;
       p->malloc_count = 0;
       p->free_count = 0;
+      memset (&p->bytes, 0, sizeof (sc_memory_bytes_t));
       p->rc_active = 0;
       p->name = NULL;
       p->full = NULL;
     }
+    SC_ATOMIC_STORE (&sc_num_packages_alloc, 2 * sc_num_packages_alloc + 1);
   }
 
-  new_package->is_registered = 1;
   new_package->log_handler = log_handler;
   new_package->log_threshold = log_threshold;
   new_package->log_indent = 0;
   new_package->malloc_count = 0;
   new_package->free_count = 0;
+  memset (&new_package->bytes, 0, sizeof (sc_memory_bytes_t));
   new_package->rc_active = 0;
   new_package->abort_mismatch = 1;
   new_package->name = name;
@@ -1161,10 +1842,13 @@ sc_package_register (sc_log_handler_t log_handler, int log_threshold,
   i = pthread_mutex_init (&new_package->mutex, NULL);
   SC_CHECK_ABORTF (i == 0, "Mutex init failed for package %s", name);
 #endif
+  SC_ATOMIC_STORE (&new_package->is_registered, 1);
 
   ++sc_num_packages;
   SC_ASSERT (sc_num_packages <= sc_num_packages_alloc);
   SC_ASSERT (0 <= new_package_id && new_package_id < sc_num_packages);
+  sc_registry_unlock ();
+  sc_log_thresholds_update ();
 
   return new_package_id;
 }
@@ -1175,8 +1859,10 @@ sc_package_is_registered (int package_id)
   if (package_id < 0) {
     SC_LERRORF ("Invalid package id %d\n", package_id);
   }
-  return (0 <= package_id && package_id < sc_num_packages_alloc &&
-          sc_packages[package_id].is_registered);
+  /* the table is read without lock on the hot path */
+  return (0 <= package_id &&
+          package_id < SC_ATOMIC_LOAD (&sc_num_packages_alloc) &&
+          SC_ATOMIC_LOAD (&sc_package_get (package_id)->is_registered));
 }
 
 void
@@ -1191,8 +1877,9 @@ sc_package_set_verbosity (int package_id, int log_priority)
                    log_priority <= SC_LP_SILENT),
                   "Invalid package log threshold");
 
-  p = sc_packages + package_id;
+  p = sc_package_get (package_id);
   p->log_threshold = log_priority;
+  sc_log_thresholds_update ();
 }
 
 static int
@@ -1210,11 +1897,13 @@ sc_package_unregister_noabort (int package_id)
     num_errors += sc_memory_check_noabort (package_id);
 
     /* clean internal package structure */
-    p = sc_packages + package_id;
-    p->is_registered = 0;
+    sc_registry_lock ();
+    p = sc_package_get (package_id);
+    SC_ATOMIC_STORE (&p->is_registered, 0);
     p->log_handler = NULL;
     p->log_threshold = SC_LP_DEFAULT;
     p->malloc_count = p->free_count = 0;
+    memset (&p->bytes, 0, sizeof (sc_memory_bytes_t));
     p->rc_active = 0;
 #ifdef SC_ENABLE_PTHREAD
     if (pthread_mutex_destroy (&p->mutex)) {
@@ -1224,6 +1913,8 @@ sc_package_unregister_noabort (int package_id)
 #endif
     p->name = p->full = NULL;
     --sc_num_packages;
+    sc_registry_unlock ();
+    sc_log_thresholds_update ();
   }
   return num_errors;
 }
@@ -1240,19 +1931,43 @@ sc_package_unregister (int package_id)
 void
 sc_package_print_summary (int log_priority)
 {
-  int                 i;
+  int                 i, b;
+  size_t              len;
+  char                hist[BUFSIZ];
   sc_package_t       *p;
+  sc_memory_stats_t   stats;
 
   SC_GEN_LOGF (sc_package_id, SC_LC_GLOBAL, log_priority,
                "Package summary (%d total):\n", sc_num_packages);
 
-  /* sc_packages is static and thus initialized to all zeros */
   for (i = 0; i < sc_num_packages_alloc; ++i) {
-    p = sc_packages + i;
+    p = sc_package_get (i);
     if (p->is_registered) {
+      sc_memory_stats (i, &stats);
       SC_GEN_LOGF (sc_package_id, SC_LC_GLOBAL, log_priority,
                    "   %3d: %-15s +%d-%d   %s\n",
-                   i, p->name, p->malloc_count, p->free_count, p->full);
+                   i, p->name, stats.malloc_count, stats.free_count,
+                   p->full);
+      if (stats.bytes_tracked) {
+        SC_GEN_LOGF (sc_package_id, SC_LC_GLOBAL, log_priority,
+                     "        bytes live %llu peak %llu\n",
+                     (unsigned long long) stats.live_bytes,
+                     (unsigned long long) stats.peak_bytes);
+      }
+
+      /* list the nonempty bins of the size histogram as log2:count */
+      len = 0;
+      hist[0] = '\0';
+      for (b = 0; b < SC_MEMORY_HISTOGRAM_BINS && len < BUFSIZ; ++b) {
+        if (stats.histogram[b] > 0) {
+          len += snprintf (hist + len, BUFSIZ - len, " %d:%llu", b,
+                           (unsigned long long) stats.histogram[b]);
+        }
+      }
+      if (hist[0] != '\0') {
+        SC_GEN_LOGF (sc_package_id, SC_LC_GLOBAL, log_priority,
+                     "        sizes%s\n", hist);
+      }
     }
   }
 }
@@ -1265,7 +1980,14 @@ sc_init (sc_MPI_Comm mpicomm,
   int                 w;
   const char         *trace_file_name;
   const char         *trace_file_prio;
-
+  const char         *mpi_profile;
+  const char         *log_async;
+  const char         *flops_trace;
+  const char         *flops_clock;
+  const char         *node_comms;
+  double              phase[4];
+
+  phase[0] = sc_MPI_Wtime ();
   sc_identifier = -1;
   sc_mpicomm = sc_MPI_COMM_NULL;
   sc_print_backtrace = print_backtrace;
@@ -1281,6 +2003,39 @@ sc_init (sc_MPI_Comm mpicomm,
   sc_set_signal_handler (catch_signals);
   sc_package_id = sc_package_register (log_handler, log_threshold,
                                        "libsc", "The SC Library");
+  phase[1] = sc_MPI_Wtime ();
+
+  log_async = getenv ("SC_LOG_ASYNC");
+  if (log_async != NULL && atol (log_async) > 0) {
+    sc_log_async_start ((size_t) atol (log_async));
+  }
+
+  sc_clock_init ();
+  flops_clock = getenv ("SC_FLOPS_CLOCK");
+  if (flops_clock != NULL && atoi (flops_clock) > 0) {
+    sc_flops_use_clock = 1;
+  }
+
+  flops_trace = getenv ("SC_FLOPS_TRACE");
+  if (flops_trace != NULL && flops_trace[0] != '\0') {
+    snprintf (sc_flops_trace_name, BUFSIZ, "%s", flops_trace);
+    sc_flops_trace_start (0);
+  }
+
+  mpi_profile = getenv ("SC_MPI_PROFILE");
+  if (mpi_profile != NULL && atoi (mpi_profile) > 0) {
+    sc_mpi_profile_reset ();
+    sc_mpi_profile_enable (atoi (mpi_profile));
+  }
+
+  /* the node communicators are split on first use without communication
+   * at startup, which matters on many processes */
+  node_comms = getenv ("SC_NODE_COMMS");
+  if (node_comms != NULL && node_comms[0] != '\0' &&
+      mpicomm != sc_MPI_COMM_NULL) {
+    sc_mpi_comm_attach_node_comms_lazy (mpicomm, atoi (node_comms));
+  }
+  phase[2] = sc_MPI_Wtime ();
 
   trace_file_name = getenv ("SC_TRACE_FILE");
   if (trace_file_name != NULL) {
@@ -1326,7 +2081,9 @@ sc_init (sc_MPI_Comm mpicomm,
         SC_ABORT ("Invalid trace priority");
       }
     }
+    sc_log_thresholds_update ();
   }
+  phase[3] = sc_MPI_Wtime ();
 
   w = 24;
   SC_GLOBAL_ESSENTIALF ("This is %s\n", SC_PACKAGE_STRING);
@@ -1349,6 +2106,12 @@ sc_init (sc_MPI_Comm mpicomm,
   SC_GLOBAL_PRODUCTIONF ("%-*s %s\n", w, "FLIBS", SC_FLIBS);
 #endif
 
+  /* the timings of the first process; we do not reduce at startup */
+  SC_GLOBAL_STATISTICSF ("Startup: registry %.3g"
+                         " clocks and profiling %.3g traces %.3g seconds\n",
+                         phase[1] - phase[0], phase[2] - phase[1],
+                         phase[3] - phase[2]);
+
   sc_initialized = 1;
 }
 
@@ -1364,16 +2127,38 @@ sc_finalize_noabort (void)
   int                 i;
   int                 num_errors = 0;
 
-  /* sc_packages is static and thus initialized to all zeros */
+  /* report the communication while the package is still registered */
+  if (sc_mpi_profile_is_enabled ()) {
+    if (sc_mpicomm != sc_MPI_COMM_NULL) {
+      sc_mpi_profile_report (sc_mpicomm);
+    }
+    sc_mpi_profile_enable (0);
+  }
+
+  if (sc_flops_trace_name[0] != '\0') {
+    if (sc_mpicomm != sc_MPI_COMM_NULL &&
+        sc_flops_trace_write (sc_mpicomm, sc_flops_trace_name)) {
+      ++num_errors;
+    }
+    sc_flops_trace_stop ();
+    sc_flops_trace_name[0] = '\0';
+  }
+
+  sc_stats_free_cache ();
+  sc_taskpool_free_global ();
+
   for (i = sc_num_packages_alloc - 1; i >= 0; --i)
-    if (sc_packages[i].is_registered)
+    if (sc_package_get (i)->is_registered)
       num_errors += sc_package_unregister_noabort (i);
 
   SC_ASSERT (sc_num_packages == 0);
   num_errors += sc_memory_check_noabort (-1);
 
-  free (sc_packages);
-  sc_packages = NULL;
+  sc_log_indent_reset ();
+  for (i = 0; i < SC_PACKAGE_SEGMENTS; ++i) {
+    free (sc_package_segments[i]);
+    sc_package_segments[i] = NULL;
+  }
   sc_num_packages_alloc = 0;
 
   /* with this argument the function will never abort */
@@ -1381,8 +2166,13 @@ sc_finalize_noabort (void)
   sc_mpicomm = sc_MPI_COMM_NULL;
 
   sc_print_backtrace = 0;
+  sc_backtrace_symbolize = -1;
+  sc_backtrace_prefix[0] = '\0';
   sc_identifier = -1;
 
+  /* write the pending lines before the trace file is closed */
+  sc_log_async_stop ();
+
   /* close trace file */
   if (sc_trace_file != NULL) {
     if (fclose (sc_trace_file)) {
@@ -1392,6 +2182,17 @@ sc_finalize_noabort (void)
     sc_trace_file = NULL;
   }
 
+  /* without the cache every message is passed to sc_log */
+  sc_log_num_thresholds = 0;
+  sc_log_thresholds = NULL;
+  free (sc_log_threshold_cache);
+  sc_log_threshold_cache = NULL;
+  sc_log_threshold_alloc = 0;
+  for (i = 0; i < sc_log_threshold_num_retired; ++i) {
+    free (sc_log_threshold_retired[i]);
+  }
+  sc_log_threshold_num_retired = 0;
+
   sc_package_id = -1;
   sc_initialized = 0;
 
@@ -221,6 +221,15 @@ extern FILE        *sc_trace_file;
 /** Optional minimum log priority for messages that go into the trace file. */
 extern int          sc_trace_prio;
 
+/** Lowest priority logged to any stream, indexed by package id plus one.
+ * This array is maintained by libsc and is meant to be read only.
+ * It is used by the log macros to skip a call without output.
+ */
+extern const int   *sc_log_thresholds;
+
+/** Number of entries in \ref sc_log_thresholds. */
+extern int          sc_log_num_thresholds;
+
 /** Define machine epsilon for the double type. */
 #define SC_EPS               2.220446049250313e-16
 
@@ -341,6 +350,14 @@ void                SC_CHECK_ABORTF (int success, const char *fmt, ...)
 #define SC_ATTR_ALIGN(n)
 #endif
 
+/* hint to fetch memory into the cache ahead of a read access */
+
+#if (defined __GNUC__) || (defined __clang__)
+#define SC_PREFETCH(p) __builtin_prefetch ((const void *) (p))
+#else
+#define SC_PREFETCH(p) SC_NOOP ()
+#endif
+
 /**
  * Sets n elements of a memory range to zero.
  * Assumes the pointer p is of the correct type.
@@ -414,7 +431,8 @@ void                SC_CHECK_ABORTF (int success, const char *fmt, ...)
 /** @} */
 
 /** The log priority for the sc package.
- *
+ * Messages of lower priority are compiled out of the log macros.
+ * It is set by configure --enable-logging=PRIO or cmake -Dlog_priority=PRIO.
  */
 #ifdef SC_LOG_PRIORITY
 #define SC_LP_THRESHOLD SC_LOG_PRIORITY
@@ -426,9 +444,35 @@ void                SC_CHECK_ABORTF (int success, const char *fmt, ...)
 #endif
 #endif
 
-/* generic log macros */
+/** Hint to the compiler that an expression is usually false. */
+#if defined __GNUC__ || defined __clang__
+#define SC_UNLIKELY(c) __builtin_expect (!!(c), 0)
+#else
+#define SC_UNLIKELY(c) (c)
+#endif
+
+/* the threshold cache may be updated by another thread */
+#ifdef SC_HAVE_ATOMIC_BUILTINS
+#define SC_LOG_LOAD(x) __atomic_load_n (&(x), __ATOMIC_ACQUIRE)
+#else
+#define SC_LOG_LOAD(x) (x)
+#endif
+
+/** Return false if a message of a package and priority is not logged.
+ * Priorities below \ref SC_LP_THRESHOLD are eliminated at compile time.
+ * The others are compared to the threshold cached for the package.
+ * Packages not known to the cache are passed on to the log function.
+ */
+#define SC_LOG_IS_ENABLED(package,priority)                             \
+  ((priority) >= SC_LP_THRESHOLD &&                                     \
+   !((unsigned) ((package) + 1) <                                       \
+     (unsigned) SC_LOG_LOAD (sc_log_num_thresholds) &&                  \
+     (priority) < SC_LOG_LOAD (SC_LOG_LOAD (sc_log_thresholds)          \
+                               [(package) + 1])))
+
+/* generic log macros, which predict the message to be dropped */
 #define SC_GEN_LOG(package,category,priority,s)                         \
-  ((priority) < SC_LP_THRESHOLD ? (void) 0 :                            \
+  (!SC_UNLIKELY (SC_LOG_IS_ENABLED ((package), (priority))) ? (void) 0 : \
    sc_log (__FILE__, __LINE__, (package), (category), (priority), (s)))
 #define SC_GLOBAL_LOG(p,s) SC_GEN_LOG (sc_package_id, SC_LC_GLOBAL, (p), (s))
 #define SC_LOG(p,s) SC_GEN_LOG (sc_package_id, SC_LC_NORMAL, (p), (s))
@@ -441,7 +485,7 @@ void                SC_LOGF (int priority, const char *fmt, ...)
   __attribute__ ((format (printf, 2, 3)));
 #ifndef __cplusplus
 #define SC_GEN_LOGF(package,category,priority,fmt,...)                  \
-  ((priority) < SC_LP_THRESHOLD ? (void) 0 :                            \
+  (!SC_UNLIKELY (SC_LOG_IS_ENABLED ((package), (priority))) ? (void) 0 : \
    sc_logf (__FILE__, __LINE__, (package), (category), (priority),      \
             (fmt), __VA_ARGS__))
 #define SC_GLOBAL_LOGF(p,fmt,...)                                       \
@@ -570,6 +614,39 @@ void                sc_memory_check (int package);
 /** Return error count or zero if all is ok. */
 int                 sc_memory_check_noerr (int package);
 
+/** Number of bins in the allocation size histogram of \ref
+ * sc_memory_stats_t.  Bin b counts requests of size in [2^b, 2^(b+1)),
+ * where bin 0 also holds requests of size zero. */
+#define SC_MEMORY_HISTOGRAM_BINS 64
+
+/** Memory usage of one package as returned by \ref sc_memory_stats.
+ * The byte counts are those reported by the system allocator for each
+ * block, which may be slightly larger than the requested sizes. */
+typedef struct sc_memory_stats
+{
+  int                 malloc_count;     /**< Number of allocations. */
+  int                 free_count;       /**< Number of frees. */
+  int                 bytes_tracked;    /**< True if the byte counts
+                                             below are available. */
+  size_t              live_bytes;       /**< Bytes currently held. */
+  size_t              peak_bytes;       /**< High-water mark of live. */
+  size_t              histogram[SC_MEMORY_HISTOGRAM_BINS];
+                                        /**< Count of allocation requests
+                                             binned by log2 of their size. */
+}
+sc_memory_stats_t;
+
+/** Query the memory usage of a package.
+ * The counters are updated atomically by \ref sc_malloc and friends, so
+ * this function may be called while other threads allocate memory; the
+ * result is then a consistent snapshot of each counter but not of all.
+ * \param [in] package     Registered package id or -1 for the default.
+ * \param [out] stats      Filled with the package's current statistics.
+ *                         Byte counts are only tracked if the allocator
+ *                         can report block sizes, see \b bytes_tracked.
+ */
+void                sc_memory_stats (int package, sc_memory_stats_t * stats);
+
 /* comparison functions for various integer sizes */
 
 int                 sc_int_compare (const void *v1, const void *v2);
@@ -603,12 +680,58 @@ void                sc_set_log_defaults (FILE * log_stream,
                                          sc_log_handler_t log_handler,
                                          int log_threshold);
 
+/** Write the lines of the builtin log handler from a background thread.
+ * Each thread formats its lines into its own ring buffer, which the
+ * background thread drains every few milliseconds.  The order of lines is
+ * kept per thread only.  A thread that finds its ring full waits for the
+ * drain.  Other log handlers are still called synchronously.
+ * The logger is stopped and flushed by \ref sc_finalize and flushed by
+ * \ref sc_abort.  It is also started by \ref sc_init if the environment
+ * variable SC_LOG_ASYNC holds a positive ring size in bytes.
+ * Without SC_ENABLE_PTHREAD this function does nothing.
+ * \param [in] ring_bytes   Minimum size of the ring buffer per thread,
+ *                          or 0 for the default.
+ */
+void                sc_log_async_start (size_t ring_bytes);
+
+/** Write all pending lines and stop the background thread of the logger.
+ * This function must not be called concurrently to logging.
+ */
+void                sc_log_async_stop (void);
+
+/** Write all pending lines of the logger and flush the log streams.
+ * Call this function before closing a stream passed to
+ * \ref sc_set_log_defaults while the async logger is running.
+ */
+void                sc_log_flush (void);
+
 /** Set the default SC abort behavior.
  * \param [in] abort_handler Set default SC above handler (NULL selects
  *                           builtin).  If it returns, we abort (2) then.
  */
 void                sc_set_abort_handler (sc_abort_handler_t abort_handler);
 
+/** Reduce the cost of the backtrace printed by the builtin abort handler.
+ * It applies if \ref sc_init has been called with print_backtrace true.
+ * The stack addresses are captured into a preallocated buffer.  Only the
+ * processes of lower rank than \a symbolize_ranks resolve them to symbol
+ * names, which is slow and verbose at scale.  The others log one line.
+ * If \a prefix is set, every aborting process writes the file
+ * <prefix>.<rank> for offline symbolization.  Its first line reads
+ * "sc_crash <rank> <count>", followed by one hexadecimal return address
+ * per line and the executable mappings from /proc/self/maps if available.
+ * An address minus the start of its mapping plus the mapping offset
+ * can be passed to addr2line -e for the mapped file.
+ * Both settings are reset by \ref sc_finalize.
+ * \param [in] symbolize_ranks  Negative to symbolize on all processes,
+ *                              which is the default, otherwise the
+ *                              number of processes to symbolize on.
+ * \param [in] prefix           Path prefix of the crash files.
+ *                              NULL or empty to write none.
+ */
+void                sc_set_backtrace_dump (int symbolize_ranks,
+                                           const char *prefix);
+
 /** The central log function to be called by all packages.
  * Dispatches the log calls by package and filters by category and priority.
  * \param [in] package   Must be a registered package id or -1.
@@ -725,6 +848,8 @@ void                sc_package_set_abort_alloc_mismatch (int package_id,
 void                sc_package_unregister (int package_id);
 
 /** Print a summary of all packages registered with SC.
+ * For each package we print its allocation counts and, where available,
+ * the live and peak bytes and the log2 histogram of allocation sizes.
  * Uses the SC_LC_GLOBAL log category which by default only prints on rank 0.
  * \param [in] log_priority     Priority passed to sc log functions.
  */
@@ -742,6 +867,13 @@ void                sc_package_print_summary (int log_priority);
  *                              If sc_MPI_COMM_NULL, the identifier is set to -1.
  *                              Otherwise, sc_MPI_Init must have been called.
  *                              Effectively, we just query size and rank.
+ *                              If the environment variable SC_NODE_COMMS
+ *                              is set, we attach node communicators with
+ *                              its value as processes per node by
+ *                              \ref sc_mpi_comm_attach_node_comms_lazy.
+ *                              No communication happens in this function.
+ *                              The time of its phases is logged at
+ *                              \ref SC_LP_STATISTICS.
  * \param [in] catch_signals    If true, signals INT and SEGV are caught.
  * \param [in] print_backtrace  If true, sc_abort prints a backtrace.
  */
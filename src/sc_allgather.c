@@ -22,6 +22,11 @@
 */
 
 #include <sc_allgather.h>
+#include <sc_containers.h>
+
+int                 sc_allgather_alltoall_max = SC_ALLGATHER_ALLTOALL_MAX;
+size_t              sc_allgather_bruck_bytes = SC_ALLGATHER_BRUCK_BYTES;
+size_t              sc_allgather_ring_bytes = SC_ALLGATHER_RING_BYTES;
 
 void
 sc_allgather_alltoall (sc_MPI_Comm mpicomm, char *data, int datasize,
@@ -69,7 +74,7 @@ sc_allgather_recursive (sc_MPI_Comm mpicomm, char *data, int datasize,
 
   SC_ASSERT (myoffset >= 0 && myoffset < groupsize);
 
-  if (groupsize > SC_ALLGATHER_ALLTOALL_MAX) {
+  if (groupsize > sc_allgather_alltoall_max) {
     if (myoffset < g2) {
       sc_allgather_recursive (mpicomm, data, datasize, g2, myoffset, myrank);
 
@@ -130,6 +135,83 @@ sc_allgather_recursive (sc_MPI_Comm mpicomm, char *data, int datasize,
   }
 }
 
+void
+sc_allgather_ring (sc_MPI_Comm mpicomm, char *data, int datasize,
+                   int groupsize, int myoffset, int myrank)
+{
+  int                 j;
+  int                 sendblock, recvblock;
+  int                 mpiret;
+  int                 left, right;
+  sc_MPI_Request      request;
+
+  SC_ASSERT (myoffset >= 0 && myoffset < groupsize);
+
+  left = myrank - myoffset + (myoffset + groupsize - 1) % groupsize;
+  right = myrank - myoffset + (myoffset + 1) % groupsize;
+
+  /* in step j we forward the block that originates j processes before us */
+  for (j = 0; j < groupsize - 1; ++j) {
+    sendblock = (myoffset - j + groupsize) % groupsize;
+    recvblock = (sendblock + groupsize - 1) % groupsize;
+
+    mpiret = sc_MPI_Irecv (data + recvblock * datasize, datasize,
+                           sc_MPI_BYTE, left, SC_TAG_AG_RING, mpicomm,
+                           &request);
+    SC_CHECK_MPI (mpiret);
+
+    mpiret = sc_MPI_Send (data + sendblock * datasize, datasize,
+                          sc_MPI_BYTE, right, SC_TAG_AG_RING, mpicomm);
+    SC_CHECK_MPI (mpiret);
+
+    mpiret = sc_MPI_Wait (&request, sc_MPI_STATUS_IGNORE);
+    SC_CHECK_MPI (mpiret);
+  }
+}
+
+void
+sc_allgather_bruck (sc_MPI_Comm mpicomm, char *data, int datasize,
+                    int groupsize, int myoffset, int myrank)
+{
+  int                 dist, nblocks;
+  int                 mpiret;
+  int                 sendto, recvfrom;
+  char               *work;
+  sc_MPI_Request      request;
+
+  SC_ASSERT (myoffset >= 0 && myoffset < groupsize);
+
+  /* block j of the work buffer belongs to offset myoffset + j */
+  work = SC_ALLOC (char, (size_t) groupsize * datasize);
+  memcpy (work, data + myoffset * datasize, datasize);
+
+  for (dist = 1; dist < groupsize; dist *= 2) {
+    nblocks = SC_MIN (dist, groupsize - dist);
+    sendto = myrank - myoffset + (myoffset - dist + groupsize) % groupsize;
+    recvfrom = myrank - myoffset + (myoffset + dist) % groupsize;
+
+    mpiret = sc_MPI_Irecv (work + dist * datasize, nblocks * datasize,
+                           sc_MPI_BYTE, recvfrom, SC_TAG_AG_BRUCK, mpicomm,
+                           &request);
+    SC_CHECK_MPI (mpiret);
+
+    mpiret = sc_MPI_Send (work, nblocks * datasize, sc_MPI_BYTE,
+                          sendto, SC_TAG_AG_BRUCK, mpicomm);
+    SC_CHECK_MPI (mpiret);
+
+    mpiret = sc_MPI_Wait (&request, sc_MPI_STATUS_IGNORE);
+    SC_CHECK_MPI (mpiret);
+  }
+
+  /* rotate the blocks into their final position */
+  memcpy (data + myoffset * datasize, work,
+          (size_t) (groupsize - myoffset) * datasize);
+  memcpy (data, work + (groupsize - myoffset) * datasize,
+          (size_t) myoffset * datasize);
+
+  SC_FREE (work);
+}
+
 int
 sc_allgather (void *sendbuf, int sendcount, sc_MPI_Datatype sendtype,
               void *recvbuf, int recvcount, sc_MPI_Datatype recvtype,
@@ -154,14 +236,159 @@ sc_allgather (void *sendbuf, int sendcount, sc_MPI_Datatype sendtype,
 
   SC_ASSERT (datasize == datasize2);
 
+  mpicomm = sc_mpi_comm_thread (mpicomm);
   mpiret = sc_MPI_Comm_size (mpicomm, &mpisize);
   SC_CHECK_MPI (mpiret);
   mpiret = sc_MPI_Comm_rank (mpicomm, &mpirank);
   SC_CHECK_MPI (mpiret);
 
   memcpy (((char *) recvbuf) + mpirank * datasize, sendbuf, datasize);
-  sc_allgather_recursive (mpicomm, (char *) recvbuf, (int) datasize,
-                          mpisize, mpirank, mpirank);
+  sc_mpi_profile_enter (SC_MPI_CALLER_ALLGATHER);
+  if (mpisize <= sc_allgather_alltoall_max) {
+    sc_allgather_alltoall (mpicomm, (char *) recvbuf, (int) datasize,
+                           mpisize, mpirank, mpirank);
+  }
+  else if (sc_allgather_ring_bytes > 0 &&
+           datasize * mpisize >= sc_allgather_ring_bytes) {
+    sc_allgather_ring (mpicomm, (char *) recvbuf, (int) datasize,
+                       mpisize, mpirank, mpirank);
+  }
+  else if (datasize <= sc_allgather_bruck_bytes) {
+    sc_allgather_bruck (mpicomm, (char *) recvbuf, (int) datasize,
+                        mpisize, mpirank, mpirank);
+  }
+  else {
+    sc_allgather_recursive (mpicomm, (char *) recvbuf, (int) datasize,
+                            mpisize, mpirank, mpirank);
+  }
+  sc_mpi_profile_leave ();
 
   return sc_MPI_SUCCESS;
 }
+
+/** Compute the byte counts and displacements of gathered arrays.
+ * \param [in] counts       Element counts of all processes.
+ * \param [in] mpisize      Number of processes.
+ * \param [in] elem_size    Element size of the arrays.
+ * \param [out] recvcounts  Byte counts of all processes.
+ * \param [out] displs      Byte displacements of all processes.
+ * \param [in,out] offsets  If not NULL, resized to the element offsets.
+ * \return                  The total number of elements.
+ */
+static size_t
+sc_array_gather_displs (const long long *counts, int mpisize,
+                        size_t elem_size, int *recvcounts, int *displs,
+                        sc_array_t * offsets)
+{
+  int                 q;
+  size_t              total, bytes;
+
+  if (offsets != NULL) {
+    SC_ASSERT (offsets->elem_size == sizeof (size_t));
+    sc_array_resize (offsets, (size_t) mpisize + 1);
+  }
+  total = 0;
+  for (q = 0; q < mpisize; ++q) {
+    if (offsets != NULL) {
+      *(size_t *) sc_array_index_int (offsets, q) = total;
+    }
+    bytes = (size_t) counts[q] * elem_size;
+    SC_CHECK_ABORT (total * elem_size + bytes <= (size_t) INT_MAX,
+                    "Gathered array exceeds the range of int");
+    displs[q] = (int) (total * elem_size);
+    recvcounts[q] = (int) bytes;
+    total += (size_t) counts[q];
+  }
+  if (offsets != NULL) {
+    *(size_t *) sc_array_index_int (offsets, mpisize) = total;
+  }
+  return total;
+}
+
+void
+sc_array_allgatherv (sc_array_t * send, sc_array_t * recv,
+                     sc_array_t * offsets, sc_MPI_Comm mpicomm)
+{
+  int                 mpiret;
+  int                 mpisize, mpirank;
+  int                *recvcounts, *displs;
+  long long           mycount, *counts;
+
+  SC_ASSERT (send != NULL && recv != NULL && send != recv);
+  SC_ASSERT (SC_ARRAY_IS_OWNER (recv));
+  SC_ASSERT (send->elem_size == recv->elem_size);
+
+  mpiret = sc_MPI_Comm_size (mpicomm, &mpisize);
+  SC_CHECK_MPI (mpiret);
+  mpiret = sc_MPI_Comm_rank (mpicomm, &mpirank);
+  SC_CHECK_MPI (mpiret);
+
+  /* one allgather of the counts determines all displacements */
+  counts = SC_ALLOC (long long, mpisize);
+  mycount = (long long) send->elem_count;
+  mpiret = sc_allgather (&mycount, 1, sc_MPI_LONG_LONG_INT,
+                         counts, 1, sc_MPI_LONG_LONG_INT, mpicomm);
+  SC_CHECK_MPI (mpiret);
+  recvcounts = SC_ALLOC (int, mpisize);
+  displs = SC_ALLOC (int, mpisize);
+  sc_array_resize (recv, sc_array_gather_displs (counts, mpisize,
+                                                 send->elem_size, recvcounts,
+                                                 displs, offsets));
+
+  mpiret = sc_MPI_Allgatherv (send->array, recvcounts[mpirank], sc_MPI_BYTE,
+                              recv->array, recvcounts, displs, sc_MPI_BYTE,
+                              mpicomm);
+  SC_CHECK_MPI (mpiret);
+
+  SC_FREE (displs);
+  SC_FREE (recvcounts);
+  SC_FREE (counts);
+}
+
+void
+sc_array_gatherv (sc_array_t * send, sc_array_t * recv,
+                  sc_array_t * offsets, int root, sc_MPI_Comm mpicomm)
+{
+  int                 mpiret;
+  int                 mpisize, mpirank;
+  int                *recvcounts = NULL, *displs = NULL;
+  long long           mycount, *counts = NULL;
+
+  SC_ASSERT (send != NULL);
+
+  mpiret = sc_MPI_Comm_size (mpicomm, &mpisize);
+  SC_CHECK_MPI (mpiret);
+  mpiret = sc_MPI_Comm_rank (mpicomm, &mpirank);
+  SC_CHECK_MPI (mpiret);
+  SC_ASSERT (0 <= root && root < mpisize);
+
+  if (mpirank == root) {
+    SC_ASSERT (recv != NULL && recv != send && SC_ARRAY_IS_OWNER (recv));
+    SC_ASSERT (send->elem_size == recv->elem_size);
+    counts = SC_ALLOC (long long, mpisize);
+    recvcounts = SC_ALLOC (int, mpisize);
+    displs = SC_ALLOC (int, mpisize);
+  }
+  mycount = (long long) send->elem_count;
+  mpiret = sc_MPI_Gather (&mycount, 1, sc_MPI_LONG_LONG_INT,
+                          counts, 1, sc_MPI_LONG_LONG_INT, root, mpicomm);
+  SC_CHECK_MPI (mpiret);
+  if (mpirank == root) {
+    sc_array_resize (recv, sc_array_gather_displs (counts, mpisize,
+                                                   send->elem_size,
+                                                   recvcounts, displs,
+                                                   offsets));
+  }
+
+  mpiret = sc_MPI_Gatherv (send->array,
+                           (int) (send->elem_count * send->elem_size),
+                           sc_MPI_BYTE, mpirank == root ? recv->array : NULL,
+                           recvcounts, displs, sc_MPI_BYTE, root, mpicomm);
+  SC_CHECK_MPI (mpiret);
+
+  if (mpirank == root) {
+    SC_FREE (displs);
+    SC_FREE (recvcounts);
+    SC_FREE (counts);
+  }
+}
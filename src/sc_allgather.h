@@ -24,8 +24,12 @@
 /** \file sc_allgather.h
  * Self-contained implementation of MPI_Allgather.
  *
- * The algorithm uses a binary communication tree.
+ * The default algorithm uses a binary communication tree.
  * The recursion terminates at a specified depth by an all-to-all step.
+ * In addition, we provide a ring and a Bruck algorithm.
+ * \ref sc_allgather selects one of them by the group size and the message
+ * size through thresholds that may be changed at runtime.
+ * The benchmark test/bench_allgather.c sweeps these parameters.
  *
  * \ingroup sc_parallelism
  */
@@ -33,15 +37,45 @@
 #ifndef SC_ALLGATHER_H
 #define SC_ALLGATHER_H
 
-#include <sc.h>
+#include <sc_containers.h>
 
 #ifndef SC_ALLGATHER_ALLTOALL_MAX
-/** The largest group size that uses direct all-to-all. */
+/** The default of \ref sc_allgather_alltoall_max. */
 #define SC_ALLGATHER_ALLTOALL_MAX   5
 #endif
 
+#ifndef SC_ALLGATHER_BRUCK_BYTES
+/** The default of \ref sc_allgather_bruck_bytes. */
+#define SC_ALLGATHER_BRUCK_BYTES    1024
+#endif
+
+#ifndef SC_ALLGATHER_RING_BYTES
+/** The default of \ref sc_allgather_ring_bytes. */
+#define SC_ALLGATHER_RING_BYTES     (1 << 20)
+#endif
+
 SC_EXTERN_C_BEGIN;
 
+/** The largest group size that uses direct all-to-all.
+ * This applies to \ref sc_allgather and the recursion of
+ * \ref sc_allgather_recursive.
+ * Initialized to \ref SC_ALLGATHER_ALLTOALL_MAX.
+ */
+extern int          sc_allgather_alltoall_max;
+
+/** \ref sc_allgather uses \ref sc_allgather_bruck for messages of at most
+ * this many bytes per process.  Zero disables the Bruck algorithm.
+ * Initialized to \ref SC_ALLGATHER_BRUCK_BYTES.
+ */
+extern size_t       sc_allgather_bruck_bytes;
+
+/** \ref sc_allgather uses \ref sc_allgather_ring when the gathered data
+ * has at least this many bytes.  This check comes before the one of
+ * \ref sc_allgather_bruck_bytes.  Zero disables the ring algorithm.
+ * Initialized to \ref SC_ALLGATHER_RING_BYTES.
+ */
+extern size_t       sc_allgather_ring_bytes;
+
 /** Allgather by direct point-to-point communication.
  * This function is only efficient for small group sizes.
  * \param [in] mpicomm      Valid MPI communicator.
@@ -57,7 +91,7 @@ void                sc_allgather_alltoall (sc_MPI_Comm mpicomm, char *data,
                                            int myoffset, int myrank);
 
 /** Perform recursive bisection allgather.
- * When size becomes less equal \ref SC_ALLGATHER_ALLTOALL_MAX, call \ref
+ * When size becomes less equal \ref sc_allgather_alltoall_max, call \ref
  * sc_allgather_alltoall.
  * \param [in] mpicomm      Valid MPI communicator.
  * \param [in,out] data     Send and receive buffer for a subgroup of the
@@ -71,7 +105,46 @@ void                sc_allgather_recursive (sc_MPI_Comm mpicomm, char *data,
                                             int datasize, int groupsize,
                                             int myoffset, int myrank);
 
+/** Allgather by passing the data around a ring.
+ * Each process forwards one block per step to its successor.
+ * The groupsize - 1 steps send the minimum volume of data.
+ * This function is efficient for large messages.
+ * \param [in] mpicomm      Valid MPI communicator.
+ * \param [in,out] data     Send and receive buffer for a subgroup of the
+                            communicator.
+ * \param [in] datasize     Number of bytes to send.
+ * \param [in] groupsize    Number of processes in the subgroup.
+ * \param [in] myoffset     Offset of the subgroup in the communicator.
+ * \param [in] myrank       MPI rank in the communicator.
+ */
+void                sc_allgather_ring (sc_MPI_Comm mpicomm, char *data,
+                                       int datasize, int groupsize,
+                                       int myoffset, int myrank);
+
+/** Allgather by the algorithm of Bruck et al.
+ * It takes the ceiling of log_2 groupsize steps for any group size,
+ * doubling the number of blocks known to each process in every step.
+ * This function is efficient for small messages.
+ * It allocates a temporary buffer of the size of the gathered data.
+ * \param [in] mpicomm      Valid MPI communicator.
+ * \param [in,out] data     Send and receive buffer for a subgroup of the
+                            communicator.
+ * \param [in] datasize     Number of bytes to send.
+ * \param [in] groupsize    Number of processes in the subgroup.
+ * \param [in] myoffset     Offset of the subgroup in the communicator.
+ * \param [in] myrank       MPI rank in the communicator.
+ */
+void                sc_allgather_bruck (sc_MPI_Comm mpicomm, char *data,
+                                        int datasize, int groupsize,
+                                        int myoffset, int myrank);
+
 /** Drop-in allgather replacement.
+ * Groups of at most \ref sc_allgather_alltoall_max processes use
+ * \ref sc_allgather_alltoall.  Otherwise, we use \ref sc_allgather_ring
+ * as configured by \ref sc_allgather_ring_bytes, then
+ * \ref sc_allgather_bruck as configured by \ref sc_allgather_bruck_bytes,
+ * and \ref sc_allgather_recursive in all other cases.
+ * The thresholds must be the same on all processes.
  * \param [in] sendbuf      Send buffer conforming to MPI specification.
  * \param [in] sendcount    Number of data items to send.
  * \param [in] sendtype     Valid MPI Datatype.
@@ -86,6 +159,40 @@ int                 sc_allgather (void *sendbuf, int sendcount,
                                   int recvcount, sc_MPI_Datatype recvtype,
                                   sc_MPI_Comm mpicomm);
 
+/** Gather the contents of an array from every process on all of them.
+ * The element counts are exchanged by one \ref sc_allgather, followed
+ * by one sc_MPI_Allgatherv of the data.  The total number of bytes must
+ * fit into an int.  For a result shared by the processes of each node,
+ * see \ref sc_shmem_array_allgatherv.
+ * \param [in] send         This process' elements, may be a view.
+ * \param [in,out] recv     Array of the same element size, not a view.
+ *                          Resized to the elements of all processes
+ *                          in rank order.
+ * \param [in,out] offsets  If not NULL, an array of element size
+ *                          sizeof (size_t) resized to one more entry than
+ *                          there are processes.  Entry q is the index of
+ *                          the first element of process q in \a recv.
+ * \param [in] mpicomm      Valid MPI communicator.
+ */
+void                sc_array_allgatherv (sc_array_t * send,
+                                         sc_array_t * recv,
+                                         sc_array_t * offsets,
+                                         sc_MPI_Comm mpicomm);
+
+/** Gather the contents of an array from every process on one of them.
+ * This is the rooted version of \ref sc_array_allgatherv.
+ * \param [in] send         This process' elements, may be a view.
+ * \param [in,out] recv     Only accessed on the root, see
+ *                          \ref sc_array_allgatherv.
+ * \param [in,out] offsets  Only accessed on the root, see
+ *                          \ref sc_array_allgatherv.
+ * \param [in] root         Rank of the receiving process.
+ * \param [in] mpicomm      Valid MPI communicator.
+ */
+void                sc_array_gatherv (sc_array_t * send, sc_array_t * recv,
+                                      sc_array_t * offsets, int root,
+                                      sc_MPI_Comm mpicomm);
+
 SC_EXTERN_C_END;
 
 #endif /* !SC_ALLGATHER_H */
@@ -22,38 +22,178 @@
 */
 
 #include <sc_amr.h>
+#include <sc_thread.h>
+
+/** The partial results of one chunk of errors. */
+typedef struct sc_amr_stats_chunk
+{
+  double              sum, squares, emin, emax;
+}
+sc_amr_stats_chunk_t;
+
+/** The shared data of the threads in sc_amr_error_stats_ext. */
+typedef struct sc_amr_stats_threads
+{
+  const double       *errors;
+  long                num_elements;
+  int                 num_chunks;
+  sc_amr_stats_chunk_t *chunks;
+  long               *buckets;
+}
+sc_amr_stats_threads_t;
+
+/* Map a double to an unsigned integer of the same order. */
+static inline uint64_t
+sc_amr_error_key (double e)
+{
+  uint64_t            k;
+
+  memcpy (&k, &e, sizeof (uint64_t));
+  return (k >> 63) ? ~k : k | ((uint64_t) 1 << 63);
+}
+
+/* The inverse of sc_amr_error_key. */
+static inline double
+sc_amr_error_value (uint64_t k)
+{
+  double              e;
+
+  k = (k >> 63) ? k & ~((uint64_t) 1 << 63) : ~k;
+  memcpy (&e, &k, sizeof (double));
+  return e;
+}
+
+/* The bucket of an error consists of its sign and exponent bits. */
+static inline int
+sc_amr_error_bucket (double e)
+{
+  return (int) (sc_amr_error_key (e) >> 52);
+}
+
+static void
+sc_amr_error_stats_chunks (int thread_id, int num_threads, void *user)
+{
+  sc_amr_stats_threads_t *st = (sc_amr_stats_threads_t *) user;
+  int                 c, j;
+  long                i, lo, hi;
+  long               *buckets;
+  double              e;
+  double              sum[4], squares[4], emin[4], emax[4];
+  const double       *errors;
+
+  for (c = thread_id; c < st->num_chunks; c += num_threads) {
+    lo = (long) ((double) c * st->num_elements / st->num_chunks);
+    hi = (long) ((double) (c + 1) * st->num_elements / st->num_chunks);
+    if (c == st->num_chunks - 1) {
+      hi = st->num_elements;
+    }
+    errors = st->errors + lo;
+    buckets = st->buckets + (size_t) c * SC_AMR_ERROR_BUCKETS;
+
+    /* independent accumulators let the compiler vectorize the loop */
+    for (j = 0; j < 4; ++j) {
+      sum[j] = squares[j] = 0.;
+      emin[j] = DBL_MAX;
+      emax[j] = -DBL_MAX;
+    }
+    for (i = 0; i + 4 <= hi - lo; i += 4) {
+      for (j = 0; j < 4; ++j) {
+        e = errors[i + j];
+        sum[j] += e;
+        squares[j] += e * e;
+        emin[j] = e < emin[j] ? e : emin[j];
+        emax[j] = e > emax[j] ? e : emax[j];
+        ++buckets[sc_amr_error_bucket (e)];
+      }
+    }
+    for (; i < hi - lo; ++i) {
+      e = errors[i];
+      sum[0] += e;
+      squares[0] += e * e;
+      emin[0] = SC_MIN (emin[0], e);
+      emax[0] = SC_MAX (emax[0], e);
+      ++buckets[sc_amr_error_bucket (e)];
+    }
+    st->chunks[c].sum = (sum[0] + sum[1]) + (sum[2] + sum[3]);
+    st->chunks[c].squares =
+      (squares[0] + squares[1]) + (squares[2] + squares[3]);
+    st->chunks[c].emin = SC_MIN (SC_MIN (emin[0], emin[1]),
+                                 SC_MIN (emin[2], emin[3]));
+    st->chunks[c].emax = SC_MAX (SC_MAX (emax[0], emax[1]),
+                                 SC_MAX (emax[2], emax[3]));
+  }
+}
 
 void
 sc_amr_error_stats (sc_MPI_Comm mpicomm, long num_elements,
                     const double *errors, sc_amr_control_t * amr)
+{
+  sc_amr_error_stats_ext (mpicomm, num_elements, errors, 0, amr);
+}
+
+void
+sc_amr_error_stats_ext (sc_MPI_Comm mpicomm, long num_elements,
+                        const double *errors, int num_threads,
+                        sc_amr_control_t * amr)
 {
   sc_statinfo_t      *si = &amr->estats;
   int                 mpiret;
   int                 mpisize;
-  long                i;
+  int                 c, b, T;
   double              sum, squares, emin, emax;
+  sc_amr_stats_threads_t st;
+
+  SC_ASSERT (num_elements >= 0);
 
   mpiret = sc_MPI_Comm_size (mpicomm, &mpisize);
   SC_CHECK_MPI (mpiret);
 
   amr->errors = errors;
+  amr->num_local_elements = num_elements;
 
+  /* one chunk per thread, each with its own buckets */
+  if (num_threads <= 0) {
+    num_threads = sc_thread_default_count ();
+  }
+  T = (int) SC_MIN ((long) num_threads,
+                    num_elements / SC_AMR_ERROR_STATS_PARALLEL_MIN);
+  T = SC_MAX (T, 1);
+  st.errors = errors;
+  st.num_elements = num_elements;
+  st.num_chunks = T;
+  st.chunks = SC_ALLOC (sc_amr_stats_chunk_t, T);
+  st.buckets = T == 1 ? amr->error_buckets :
+    SC_ALLOC (long, (size_t) T * SC_AMR_ERROR_BUCKETS);
+  memset (st.buckets, 0, (size_t) T * SC_AMR_ERROR_BUCKETS * sizeof (long));
+  sc_thread_fork_join (T, sc_amr_error_stats_chunks, &st);
+
+  /* combine the chunks in a fixed order */
   sum = squares = 0.;
   emin = DBL_MAX;
   emax = -DBL_MAX;
-  for (i = 0; i < num_elements; ++i) {
-    sum += errors[i];
-    squares += errors[i] * errors[i];
-    emin = SC_MIN (emin, errors[i]);
-    emax = SC_MAX (emax, errors[i]);
+  for (c = 0; c < T; ++c) {
+    sum += st.chunks[c].sum;
+    squares += st.chunks[c].squares;
+    emin = SC_MIN (emin, st.chunks[c].emin);
+    emax = SC_MAX (emax, st.chunks[c].emax);
   }
-  si->dirty = 1;
+  if (T > 1) {
+    for (b = 0; b < SC_AMR_ERROR_BUCKETS; ++b) {
+      amr->error_buckets[b] = 0;
+      for (c = 0; c < T; ++c) {
+        amr->error_buckets[b] += st.buckets[c * SC_AMR_ERROR_BUCKETS + b];
+      }
+    }
+    SC_FREE (st.buckets);
+  }
+  SC_FREE (st.chunks);
+
+  sc_stats_init (si, NULL);
   si->count = num_elements;
   si->sum_values = sum;
   si->sum_squares = squares;
   si->min = emin;
   si->max = emax;
-  si->variable = NULL;
   sc_stats_compute (mpicomm, 1, si);
 
   amr->mpicomm = mpicomm;
@@ -292,3 +432,198 @@ sc_amr_refine_search (int package_id, sc_amr_control_t * amr,
                "Estimated global number of elements = %ld\n",
                amr->num_total_estimated);
 }
+
+double
+sc_amr_select_error (sc_amr_control_t * amr, long rank, int num_bins,
+                     int max_rounds, int *num_rounds)
+{
+  const double       *errors = amr->errors;
+  const long          num_local = amr->num_local_elements;
+  int                 mpiret;
+  int                 b, round;
+  int                 closed;
+  int                 bmin, bmax;
+  long                i, below, inside;
+  long               *local_counts, *global_counts;
+  double              low, high, width, e;
+
+  SC_ASSERT (num_bins >= 2);
+  SC_ASSERT (max_rounds >= 0);
+
+  /* the extreme ranks are known from the error statistics */
+  round = 0;
+  low = amr->estats.min;
+  high = amr->estats.max;
+  if (rank <= 0 || low >= high || rank >= amr->num_total_elements) {
+    if (num_rounds != NULL) {
+      *num_rounds = round;
+    }
+    return rank <= 0 || low >= high ? low : high;
+  }
+
+  /* the interval [low, high) contains the error of the requested rank;
+     it is closed at the upper end only as long as high is the maximum */
+  bmin = sc_amr_error_bucket (low);
+  bmax = sc_amr_error_bucket (high);
+  local_counts = SC_ALLOC (long, 2 * SC_MAX (num_bins, bmax - bmin + 1));
+  global_counts = local_counts + SC_MAX (num_bins, bmax - bmin + 1);
+  closed = 1;
+  below = 0;
+  inside = amr->num_total_elements;
+
+  /* the first round reduces the buckets counted with the statistics */
+  if (round < max_rounds && bmin < bmax) {
+    mpiret = sc_MPI_Allreduce (amr->error_buckets + bmin, global_counts,
+                               bmax - bmin + 1, sc_MPI_LONG, sc_MPI_SUM,
+                               amr->mpicomm);
+    SC_CHECK_MPI (mpiret);
+    for (b = 0; b < bmax - bmin && below + global_counts[b] <= rank; ++b) {
+      below += global_counts[b];
+    }
+    inside = global_counts[b];
+    if (b < bmax - bmin) {
+      high = sc_amr_error_value ((uint64_t) (bmin + b + 1) << 52);
+      closed = 0;
+    }
+    if (b > 0) {
+      low = sc_amr_error_value ((uint64_t) (bmin + b) << 52);
+    }
+    ++round;
+  }
+
+  for (; round < max_rounds && inside > 1; ++round) {
+    width = (high - low) / num_bins;
+    if (!(low + width > low)) {
+      break;                    /* no resolution left */
+    }
+
+    /* count the local errors in each bin of the interval */
+    memset (local_counts, 0, num_bins * sizeof (long));
+    for (i = 0; i < num_local; ++i) {
+      e = errors[i];
+      if (e >= low && (e < high || (closed && e == high))) {
+        b = (int) ((e - low) / width);
+        ++local_counts[SC_MIN (b, num_bins - 1)];
+      }
+    }
+    mpiret = sc_MPI_Allreduce (local_counts, global_counts, num_bins,
+                               sc_MPI_LONG, sc_MPI_SUM, amr->mpicomm);
+    SC_CHECK_MPI (mpiret);
+
+    /* descend into the bin holding the requested rank */
+    for (b = 0; b < num_bins - 1 && below + global_counts[b] <= rank; ++b) {
+      below += global_counts[b];
+    }
+    inside = global_counts[b];
+    if (b < num_bins - 1) {
+      high = low + (b + 1) * width;
+      closed = 0;
+    }
+    low += b * width;
+  }
+  SC_FREE (local_counts);
+
+  if (num_rounds != NULL) {
+    *num_rounds = round;
+  }
+  if (inside <= 0 || rank <= below) {
+    return low;
+  }
+  return low + (high - low) * (double) (rank - below) / (double) inside;
+}
+
+void
+sc_amr_coarsen_select (int package_id, sc_amr_control_t * amr,
+                       long num_total_low, double coarsen_loss,
+                       int num_bins, int max_rounds,
+                       sc_amr_count_coarsen_fn cfn, void *user_data)
+{
+  const long          num_total_elements = amr->num_total_elements;
+  const long          num_total_refine = amr->num_total_refine;
+  int                 num_rounds;
+  long                rank;
+  double              coarsen_threshold;
+
+  SC_ASSERT (coarsen_loss > 0.);
+
+  SC_GEN_LOGF (package_id, SC_LC_GLOBAL, SC_LP_STATISTICS,
+               "Select coarsen threshold assuming %ld refinements\n",
+               num_total_refine);
+
+  if (cfn == NULL || num_total_elements + num_total_refine <= num_total_low) {
+    SC_GEN_LOG (package_id, SC_LC_GLOBAL, SC_LP_STATISTICS,
+                "Selection of coarsening skipped\n");
+    sc_amr_coarsen_specify (package_id, amr, amr->estats.min, NULL, NULL);
+    return;
+  }
+
+  /* the number of elements below the threshold that yields the target */
+  rank = (long) ceil ((num_total_elements + num_total_refine -
+                       num_total_low) / coarsen_loss);
+  coarsen_threshold = sc_amr_select_error (amr, rank, num_bins, max_rounds,
+                                           &num_rounds);
+  SC_GEN_LOGF (package_id, SC_LC_GLOBAL, SC_LP_STATISTICS,
+               "Selected threshold %g for %ld elements in %d rounds\n",
+               coarsen_threshold, rank, num_rounds);
+
+  sc_amr_coarsen_specify (package_id, amr, coarsen_threshold, cfn,
+                          user_data);
+  SC_GEN_LOGF (package_id, SC_LC_GLOBAL, SC_LP_INFO,
+               "Estimated global number of elements = %ld\n",
+               amr->num_total_estimated);
+}
+
+void
+sc_amr_refine_select (int package_id, sc_amr_control_t * amr,
+                      long num_total_high, double refine_gain,
+                      int num_bins, int max_rounds,
+                      sc_amr_count_refine_fn rfn, void *user_data)
+{
+  const long          num_total_elements = amr->num_total_elements;
+  const long          num_total_coarsen = amr->num_total_coarsen;
+  int                 mpiret;
+  int                 num_rounds;
+  long                rank;
+  long                local_refine, global_refine;
+
+  SC_ASSERT (refine_gain > 0.);
+
+  SC_GEN_LOGF (package_id, SC_LC_GLOBAL, SC_LP_STATISTICS,
+               "Select refine threshold assuming %ld coarsenings\n",
+               num_total_coarsen);
+
+  if (rfn == NULL ||
+      num_total_elements - num_total_coarsen >= num_total_high) {
+    SC_GEN_LOG (package_id, SC_LC_GLOBAL, SC_LP_STATISTICS,
+                "Selection of refinement skipped\n");
+    amr->refine_threshold = amr->estats.max;
+    amr->num_total_refine = 0;
+    amr->num_total_estimated = num_total_elements - num_total_coarsen;
+    return;
+  }
+
+  /* the number of elements above the threshold that yields the target */
+  rank = num_total_elements -
+    (long) ((num_total_high - num_total_elements + num_total_coarsen) /
+            refine_gain);
+  amr->refine_threshold = sc_amr_select_error (amr, rank, num_bins,
+                                               max_rounds, &num_rounds);
+  SC_GEN_LOGF (package_id, SC_LC_GLOBAL, SC_LP_STATISTICS,
+               "Selected threshold %g for %ld elements in %d rounds\n",
+               amr->refine_threshold, num_total_elements - rank, num_rounds);
+
+  /* call back once to count the elements to refine locally */
+  local_refine = rfn (amr, user_data);
+  mpiret = sc_MPI_Allreduce (&local_refine, &global_refine, 1, sc_MPI_LONG,
+                             sc_MPI_SUM, amr->mpicomm);
+  SC_CHECK_MPI (mpiret);
+  amr->num_total_refine = global_refine;
+  amr->num_total_estimated =
+    num_total_elements + global_refine - num_total_coarsen;
+
+  SC_GEN_LOGF (package_id, SC_LC_GLOBAL, SC_LP_STATISTICS,
+               "Global number of refinements = %ld\n", amr->num_total_refine);
+  SC_GEN_LOGF (package_id, SC_LC_GLOBAL, SC_LP_INFO,
+               "Estimated global number of elements = %ld\n",
+               amr->num_total_estimated);
+}
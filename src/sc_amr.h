@@ -28,9 +28,18 @@
 
 SC_EXTERN_C_BEGIN;
 
+/** Number of buckets of the local error histogram in \ref sc_amr_control_t.
+ * There is one bucket per sign and binary exponent of the errors. */
+#define SC_AMR_ERROR_BUCKETS 4096
+
+/** The minimum number of errors per thread in
+ * \ref sc_amr_error_stats_ext. */
+#define SC_AMR_ERROR_STATS_PARALLEL_MIN 65536
+
 typedef struct sc_amr_control
 {
   const double       *errors;
+  long                num_local_elements;
   sc_statinfo_t       estats;
   sc_MPI_Comm         mpicomm;
   long                num_procs_long;
@@ -40,12 +49,15 @@ typedef struct sc_amr_control
   long                num_total_coarsen;
   long                num_total_refine;
   long                num_total_estimated;
+  /** Local error counts by sign and exponent, filled by
+   * \ref sc_amr_error_stats and used by \ref sc_amr_select_error. */
+  long                error_buckets[SC_AMR_ERROR_BUCKETS];
 }
 sc_amr_control_t;
 
 /** Compute global error statistics.
+ * This is \ref sc_amr_error_stats_ext with the default number of threads.
  * \param [in] mpicomm        MPI communicator to use.
- * \param [in] mpisize        Number of MPI processes in this communicator.
  * \param [in] num_local_elements   Number of local elements.
  * \param [in] errors         The error values, one per local element.
  * \param [out] amr           Structure will be initialized and estats filled.
@@ -55,6 +67,26 @@ void                sc_amr_error_stats (sc_MPI_Comm mpicomm,
                                         const double *errors,
                                         sc_amr_control_t * amr);
 
+/** Compute global error statistics with threads.
+ * The errors are read once in chunks run by \ref sc_thread_fork_join.
+ * The same pass counts the errors by sign and binary exponent into
+ * the error_buckets member, which spares \ref sc_amr_select_error
+ * one pass over the errors.
+ * \param [in] mpicomm        MPI communicator to use.
+ * \param [in] num_local_elements   Number of local elements.
+ * \param [in] errors         The error values, one per local element.
+ * \param [in] num_threads    Number of threads to use.  If not positive,
+ *                            use \ref sc_thread_default_count.  At most one
+ *                            thread per \ref SC_AMR_ERROR_STATS_PARALLEL_MIN
+ *                            errors is used.
+ * \param [out] amr           Structure will be initialized and estats filled.
+ */
+void                sc_amr_error_stats_ext (sc_MPI_Comm mpicomm,
+                                            long num_local_elements,
+                                            const double *errors,
+                                            int num_threads,
+                                            sc_amr_control_t * amr);
+
 /** Count the local number of elements that will be coarsened.
  *
  * This is all elements whose error is below threshold
@@ -131,6 +163,85 @@ void                sc_amr_refine_search (int package_id,
                                           sc_amr_count_refine_fn rfn,
                                           void *user_data);
 
+/** Select an error value by its global rank with few collectives.
+ * The first round reduces the error buckets between the minimum and the
+ * maximum, which narrows the search to one binary order of magnitude.
+ * Each following round splits this range into equal bins whose global
+ * counts are reduced in one collective call.  The bin containing the
+ * requested rank is split again in the next round, and the result is
+ * interpolated within the last bin.  With b bins the range shrinks by a
+ * factor b per round.
+ * This function is collective over the communicator of \a amr.
+ *
+ * \param [in] amr                      Initialized by \ref sc_amr_error_stats.
+ * \param [in] rank                     Number of global errors that shall
+ *                                      lie below the returned value.
+ * \param [in] num_bins                 Number of bins per round, >= 2.
+ * \param [in] max_rounds               Upper bound on the count reductions.
+ *                                      Fewer are done when the rank is
+ *                                      pinned down to a single error.
+ * \param [out] num_rounds              If not NULL, the reductions done.
+ * \return                              A value such that approximately
+ *                                      \a rank errors are smaller.  The
+ *                                      deviation is bounded by the count of
+ *                                      the last bin.  For \a rank <= 0 it is
+ *                                      the minimum error and for \a rank at
+ *                                      least the global number of elements
+ *                                      it is the maximum.
+ */
+double              sc_amr_select_error (sc_amr_control_t * amr, long rank,
+                                         int num_bins, int max_rounds,
+                                         int *num_rounds);
+
+/** Select the coarsening threshold by the rank of the errors.
+ * Instead of calling the counting callback in each step of a search,
+ * the threshold is chosen by \ref sc_amr_select_error such that enough
+ * elements lie below it and the callback is called exactly once.
+ * Refinement counts remain unaffected, as in \ref sc_amr_coarsen_search.
+ *
+ * \param [in] package_id               Registered package id or -1.
+ * \param [in,out] amr                  AMR control structure.
+ * \param [in] num_total_ideal          Target number of global elements.
+ * \param [in] coarsen_loss             Expected net loss of elements per
+ *                                      element below the threshold, such as
+ *                                      1 - 1 / 2^d for families of 2^d.
+ * \param [in] num_bins                 Number of bins per round, >= 2.
+ * \param [in] max_rounds               Upper bound on the count reductions.
+ * \param [in] cfn                      Callback to count local coarsenings.
+ * \param [in] user_data                Will be passed to the cfn callback.
+ */
+void                sc_amr_coarsen_select (int package_id,
+                                           sc_amr_control_t * amr,
+                                           long num_total_ideal,
+                                           double coarsen_loss,
+                                           int num_bins, int max_rounds,
+                                           sc_amr_count_coarsen_fn cfn,
+                                           void *user_data);
+
+/** Select the refinement threshold by the rank of the errors.
+ * The threshold is chosen by \ref sc_amr_select_error such that the
+ * elements above it reach the target and the callback is called once.
+ * Coarsening counts remain unaffected, as in \ref sc_amr_refine_search.
+ *
+ * \param [in] package_id               Registered package id or -1.
+ * \param [in,out] amr                  AMR control structure.
+ * \param [in] num_total_ideal          Target number of global elements.
+ * \param [in] refine_gain              Expected net gain of elements per
+ *                                      element above the threshold, such as
+ *                                      2^d - 1 for 2^d children.
+ * \param [in] num_bins                 Number of bins per round, >= 2.
+ * \param [in] max_rounds               Upper bound on the count reductions.
+ * \param [in] rfn                      Callback to count local refinements.
+ * \param [in] user_data                Will be passed to the rfn callback.
+ */
+void                sc_amr_refine_select (int package_id,
+                                          sc_amr_control_t * amr,
+                                          long num_total_ideal,
+                                          double refine_gain,
+                                          int num_bins, int max_rounds,
+                                          sc_amr_count_refine_fn rfn,
+                                          void *user_data);
+
 SC_EXTERN_C_END;
 
 #endif /* !SC_AMR_H */
@@ -0,0 +1,73 @@
+/*
+  This file is part of the SC Library.
+  The SC Library provides support for parallel scientific applications.
+
+  Copyright (C) 2010 The University of Texas System
+  Additional copyright (C) 2011 individual authors
+
+  The SC Library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  The SC Library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with the SC Library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+  02110-1301, USA.
+*/
+
+#ifndef SC_ATOMIC_H
+#define SC_ATOMIC_H
+
+/** \file sc_atomic.h
+ *
+ * Minimal portable atomic operations on integer and pointer variables.
+ *
+ * If the compiler provides the `__atomic` builtins of GCC and Clang,
+ * SC_HAVE_ATOMIC_BUILTINS is defined and the macros are thread safe.
+ * Otherwise they fall back to plain memory accesses, which is correct
+ * only as long as a single thread accesses the variables.
+ * The pointer arguments must not have side effects.
+ */
+
+#include <sc.h>
+
+#ifdef SC_HAVE_ATOMIC_BUILTINS
+
+/** Load a variable with acquire semantics. */
+#define SC_ATOMIC_LOAD(p) __atomic_load_n ((p), __ATOMIC_ACQUIRE)
+
+/** Store a value into a variable with release semantics. */
+#define SC_ATOMIC_STORE(p,v) __atomic_store_n ((p), (v), __ATOMIC_RELEASE)
+
+/** Add to a variable and return its previous value. */
+#define SC_ATOMIC_FETCH_ADD(p,v) \
+  __atomic_fetch_add ((p), (v), __ATOMIC_ACQ_REL)
+
+/** Add to a variable that is not used to synchronize other memory. */
+#define SC_ATOMIC_ADD_RELAXED(p,v) \
+  ((void) __atomic_fetch_add ((p), (v), __ATOMIC_RELAXED))
+
+/** Replace *p by d if it equals *e, otherwise load *p into *e.
+ * \return          True if the value has been replaced. */
+#define SC_ATOMIC_CAS(p,e,d) \
+  __atomic_compare_exchange_n ((p), (e), (d), 0,                        \
+                               __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)
+
+#else
+
+#define SC_ATOMIC_LOAD(p) (*(p))
+#define SC_ATOMIC_STORE(p,v) ((void) (*(p) = (v)))
+#define SC_ATOMIC_FETCH_ADD(p,v) ((*(p) += (v)) - (v))
+#define SC_ATOMIC_ADD_RELAXED(p,v) ((void) (*(p) += (v)))
+#define SC_ATOMIC_CAS(p,e,d) \
+  ((*(p) == *(e)) ? (*(p) = (d), 1) : (*(e) = *(p), 0))
+
+#endif /* !SC_HAVE_ATOMIC_BUILTINS */
+
+#endif /* !SC_ATOMIC_H */
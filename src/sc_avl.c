@@ -177,17 +177,36 @@ avl_node_t *avl_search(const avl_tree_t *avltree, const void *item) {
 	return avl_search_closest(avltree, item, &node) ? NULL : node;
 }
 
-avl_tree_t *avl_init_tree(avl_tree_t *rc, avl_compare_t cmp, avl_freeitem_t freeitem) {
+avl_tree_t *avl_init_tree_ext(avl_tree_t *rc, avl_compare_t cmp, avl_freeitem_t freeitem, sc_mempool_t *mempool) {
+	SC_ASSERT (mempool == NULL || mempool->elem_size == sizeof(avl_node_t));
 	if(rc) {
 		rc->head = NULL;
 		rc->tail = NULL;
 		rc->top = NULL;
 		rc->cmp = cmp;
 		rc->freeitem = freeitem;
+		rc->mempool = mempool;
 	}
 	return rc;
 }
 
+avl_tree_t *avl_init_tree(avl_tree_t *rc, avl_compare_t cmp, avl_freeitem_t freeitem) {
+	return avl_init_tree_ext(rc, cmp, freeitem, NULL);
+}
+
+static avl_node_t *avl_new_node(avl_tree_t *avltree) {
+	if(avltree->mempool)
+		return (avl_node_t *) sc_mempool_alloc(avltree->mempool);
+	return SC_ALLOC(avl_node_t, 1);
+}
+
+static void avl_destroy_node(avl_tree_t *avltree, avl_node_t *node) {
+	if(avltree->mempool)
+		sc_mempool_free(avltree->mempool, node);
+	else
+		SC_FREE(node);
+}
+
 avl_tree_t *avl_alloc_tree(avl_compare_t cmp, avl_freeitem_t freeitem) {
         return avl_init_tree(SC_ALLOC(avl_tree_t, 1), cmp, freeitem);
 }
@@ -206,7 +225,7 @@ void avl_free_nodes(avl_tree_t *avltree) {
 		next = node->next;
 		if(freeitem)
 			freeitem(node->item);
-		SC_FREE(node);
+		avl_destroy_node(avltree, node);
 	}
 
 	avl_clear_tree(avltree);
@@ -324,11 +343,11 @@ avl_node_t *avl_insert_node(avl_tree_t *avltree, avl_node_t *newnode) {
 avl_node_t *avl_insert(avl_tree_t *avltree, void *item) {
 	avl_node_t *newnode;
 
-	newnode = avl_init_node(SC_ALLOC(avl_node_t, 1), item);
+	newnode = avl_init_node(avl_new_node(avltree), item);
 	if(newnode) {
 		if(avl_insert_node(avltree, newnode))
 			return newnode;
-		SC_FREE(newnode);
+		avl_destroy_node(avltree, newnode);
 		/* errno = EEXIST; */
                 return NULL;
 	}
@@ -403,7 +422,7 @@ void *avl_delete_node(avl_tree_t *avltree, avl_node_t *avlnode) {
 		avl_unlink_node(avltree, avlnode);
 		if(avltree->freeitem)
 			avltree->freeitem(item);
-		SC_FREE(avlnode);
+		avl_destroy_node(avltree, avlnode);
 	}
 	return item;
 }
@@ -667,4 +686,84 @@ avl_to_array (avl_tree_t * avltree, sc_array_t * array)
   SC_ASSERT (adata.iz == adata.array->elem_count);
 }
 
+/* build the subtree of the items [first, first + count) below parent */
+static avl_node_t  *
+avl_from_sorted_recursion (avl_tree_t * avltree, avl_node_t * parent,
+                           void **items, size_t first, size_t count)
+{
+  size_t              half;
+  avl_node_t         *node;
+
+  if (count == 0) {
+    return NULL;
+  }
+  half = count / 2;
+
+  node = avl_new_node (avltree);
+  SC_CHECK_ABORT (node != NULL, "avl_from_sorted_array node allocation");
+  node->item = items[first + half];
+  node->parent = parent;
+  node->count = (unsigned int) count;
+  node->left = avl_from_sorted_recursion (avltree, node, items,
+                                          first, half);
+  node->right = avl_from_sorted_recursion (avltree, node, items,
+                                           first + half + 1,
+                                           count - half - 1);
+  return node;
+}
+
+static void
+avl_from_sorted_link (avl_node_t * node, avl_node_t ** last)
+{
+  if (node->left != NULL)
+    avl_from_sorted_link (node->left, last);
+
+  node->prev = *last;
+  node->next = NULL;
+  if (*last != NULL) {
+    (*last)->next = node;
+  }
+  *last = node;
+
+  if (node->right != NULL)
+    avl_from_sorted_link (node->right, last);
+}
+
+void
+avl_from_sorted_array (avl_tree_t * avltree, sc_array_t * array)
+{
+  size_t              n = array->elem_count;
+  void              **items;
+  avl_node_t         *last;
+
+  SC_ASSERT (avltree->top == NULL);
+  SC_ASSERT (array->elem_size == sizeof (void *));
+  SC_ASSERT (n <= (size_t) UINT_MAX);
+
+  items = n > 0 ? (void **) sc_array_index (array, 0) : NULL;
+#ifdef SC_ENABLE_DEBUG
+  {
+    size_t              iz;
+
+    for (iz = 1; iz < n; ++iz) {
+      SC_ASSERT (avltree->cmp (items[iz - 1], items[iz]) < 0);
+    }
+  }
+#endif
+
+  avltree->top = avl_from_sorted_recursion (avltree, NULL, items, 0, n);
+  last = NULL;
+  if (avltree->top != NULL) {
+    avl_from_sorted_link (avltree->top, &last);
+    avltree->head = avltree->top;
+    while (avltree->head->left != NULL) {
+      avltree->head = avltree->head->left;
+    }
+  }
+  else {
+    avltree->head = NULL;
+  }
+  avltree->tail = last;
+}
+
 #endif /* AVL_COUNT */
@@ -87,6 +87,7 @@ typedef struct avl_tree_t {
 	avl_node_t *top;
 	avl_compare_t cmp;
 	avl_freeitem_t freeitem;
+	sc_mempool_t *mempool;
 } avl_tree_t;
 
 /* Initializes a new tree for elements that will be ordered using
@@ -95,6 +96,16 @@ typedef struct avl_tree_t {
  * O(1) */
 extern avl_tree_t *avl_init_tree(avl_tree_t *avltree, avl_compare_t, avl_freeitem_t);
 
+/* Like avl_init_tree, but the nodes created by avl_insert and freed by
+ * avl_delete, avl_free_nodes and avl_free_tree are taken from a mempool
+ * of element size sizeof (avl_node_t).  If mempool is NULL, the nodes
+ * are allocated one by one.  The mempool is not owned by the tree and
+ * may be shared between trees.  Nodes passed to avl_insert_node and
+ * friends must come from the same mempool.
+ * O(1) */
+extern avl_tree_t *avl_init_tree_ext(avl_tree_t *avltree, avl_compare_t,
+                                     avl_freeitem_t, sc_mempool_t *mempool);
+
 /* Allocates and initializes a new tree for elements that will be
  * ordered using the supplied strcmp()-like function.
  * Aborts if memory could not be allocated.
@@ -207,6 +218,13 @@ extern unsigned int avl_index(const avl_node_t *);
 * O(n) */
 extern void avl_to_array (avl_tree_t *, sc_array_t *);
 
+/* Builds a perfectly balanced tree from an array of void * whose items
+ * are strictly ascending with respect to the tree's compare function,
+ * such as the output of avl_to_array.  The tree must be empty.
+ * Aborts if memory for the nodes could not be allocated.
+ * O(n) */
+extern void avl_from_sorted_array (avl_tree_t *, sc_array_t *);
+
 #endif /* AVL_COUNT */
 
 SC_EXTERN_C_END;
@@ -0,0 +1,230 @@
+/*
+  This file is part of the SC Library.
+  The SC Library provides support for parallel scientific applications.
+
+  Copyright (C) 2010 The University of Texas System
+  Additional copyright (C) 2011 individual authors
+
+  The SC Library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  The SC Library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with the SC Library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+  02110-1301, USA.
+*/
+
+#include <sc_bitset.h>
+
+/** The number of words per block of the rank directory. */
+#define SC_BITSET_BLOCK_WORDS (SC_BITSET_BLOCK_BITS / 64)
+
+/* drop the rank directory */
+static void
+sc_bitset_free_rank (sc_bitset_t * bs)
+{
+  SC_FREE (bs->rank);
+  SC_FREE (bs->select);
+  bs->rank = NULL;
+  bs->select = NULL;
+  bs->num_blocks = bs->num_samples = 0;
+}
+
+/* clear the bits in the last word above num_bits */
+static void
+sc_bitset_mask_last (sc_bitset_t * bs)
+{
+  if (bs->num_bits & 63) {
+    bs->words[bs->num_words - 1] &=
+      ((uint64_t) 1 << (bs->num_bits & 63)) - 1;
+  }
+}
+
+sc_bitset_t        *
+sc_bitset_new (size_t num_bits)
+{
+  sc_bitset_t        *bs;
+
+  bs = SC_ALLOC_ZERO (sc_bitset_t, 1);
+  sc_bitset_resize (bs, num_bits);
+
+  return bs;
+}
+
+void
+sc_bitset_destroy (sc_bitset_t * bs)
+{
+  sc_bitset_free_rank (bs);
+  SC_FREE (bs->words);
+  SC_FREE (bs);
+}
+
+size_t
+sc_bitset_memory_used (sc_bitset_t * bs)
+{
+  return sizeof (sc_bitset_t) + bs->num_words * sizeof (uint64_t) +
+    (bs->rank != NULL ? (bs->num_blocks + 1) * sizeof (uint64_t) : 0) +
+    bs->num_samples * sizeof (size_t);
+}
+
+void
+sc_bitset_resize (sc_bitset_t * bs, size_t num_bits)
+{
+  size_t              num_words = (num_bits + 63) / 64;
+
+  sc_bitset_free_rank (bs);
+  if (num_words != bs->num_words) {
+    bs->words = SC_REALLOC (bs->words, uint64_t, num_words);
+    if (num_words > bs->num_words) {
+      memset (bs->words + bs->num_words, 0,
+              (num_words - bs->num_words) * sizeof (uint64_t));
+    }
+    bs->num_words = num_words;
+  }
+  bs->num_bits = num_bits;
+  sc_bitset_mask_last (bs);
+}
+
+void
+sc_bitset_fill (sc_bitset_t * bs, int value)
+{
+  if (bs->num_words > 0) {
+    memset (bs->words, value ? 0xff : 0, bs->num_words * sizeof (uint64_t));
+    sc_bitset_mask_last (bs);
+  }
+}
+
+size_t
+sc_bitset_count (sc_bitset_t * bs)
+{
+  size_t              w, count;
+
+  count = 0;
+  for (w = 0; w < bs->num_words; ++w) {
+    count += (size_t) sc_bitset_popcount (bs->words[w]);
+  }
+  return count;
+}
+
+size_t
+sc_bitset_next (sc_bitset_t * bs, size_t pos)
+{
+  size_t              w;
+  uint64_t            word;
+
+  SC_ASSERT (pos <= bs->num_bits);
+
+  if (pos >= bs->num_bits) {
+    return bs->num_bits;
+  }
+  w = pos >> 6;
+  word = bs->words[w] & (~(uint64_t) 0 << (pos & 63));
+  while (word == 0) {
+    if (++w == bs->num_words) {
+      return bs->num_bits;
+    }
+    word = bs->words[w];
+  }
+  return (w << 6) + (size_t) sc_bitset_ctz (word);
+}
+
+void
+sc_bitset_build_rank (sc_bitset_t * bs)
+{
+  size_t              b, w, end, sample;
+  uint64_t            count;
+
+  sc_bitset_free_rank (bs);
+
+  /* cumulative counts before each block */
+  bs->num_blocks = (bs->num_words + SC_BITSET_BLOCK_WORDS - 1) /
+    SC_BITSET_BLOCK_WORDS;
+  bs->rank = SC_ALLOC (uint64_t, bs->num_blocks + 1);
+  count = 0;
+  for (b = 0; b < bs->num_blocks; ++b) {
+    bs->rank[b] = count;
+    end = SC_MIN ((b + 1) * SC_BITSET_BLOCK_WORDS, bs->num_words);
+    for (w = b * SC_BITSET_BLOCK_WORDS; w < end; ++w) {
+      count += (uint64_t) sc_bitset_popcount (bs->words[w]);
+    }
+  }
+  bs->rank[bs->num_blocks] = count;
+
+  /* the block holding every sampled set bit */
+  bs->num_samples = (size_t) ((count + SC_BITSET_SELECT_SAMPLE - 1) /
+                              SC_BITSET_SELECT_SAMPLE);
+  bs->select = SC_ALLOC (size_t, bs->num_samples);
+  for (sample = 0, b = 0; b < bs->num_blocks; ++b) {
+    while (sample < bs->num_samples &&
+           (uint64_t) sample * SC_BITSET_SELECT_SAMPLE < bs->rank[b + 1]) {
+      bs->select[sample++] = b;
+    }
+  }
+  SC_ASSERT (sample == bs->num_samples);
+}
+
+size_t
+sc_bitset_rank (sc_bitset_t * bs, size_t pos)
+{
+  size_t              w, end, count;
+
+  SC_ASSERT (bs->rank != NULL);
+  SC_ASSERT (pos <= bs->num_bits);
+
+  end = pos >> 6;
+  w = (end / SC_BITSET_BLOCK_WORDS) * SC_BITSET_BLOCK_WORDS;
+  if (w == bs->num_words) {
+    return (size_t) bs->rank[bs->num_blocks];
+  }
+  count = (size_t) bs->rank[w / SC_BITSET_BLOCK_WORDS];
+  for (; w < end; ++w) {
+    count += (size_t) sc_bitset_popcount (bs->words[w]);
+  }
+  if (pos & 63) {
+    count += (size_t) sc_bitset_popcount
+      (bs->words[end] & (((uint64_t) 1 << (pos & 63)) - 1));
+  }
+  return count;
+}
+
+size_t
+sc_bitset_select (sc_bitset_t * bs, size_t k)
+{
+  int                 pc;
+  size_t              b, w;
+  uint64_t            word;
+
+  SC_ASSERT (bs->rank != NULL);
+
+  if ((uint64_t) k >= bs->rank[bs->num_blocks]) {
+    return bs->num_bits;
+  }
+
+  /* scan the blocks from the last sample on */
+  b = bs->select[k / SC_BITSET_SELECT_SAMPLE];
+  while (bs->rank[b + 1] <= (uint64_t) k) {
+    ++b;
+  }
+  k -= (size_t) bs->rank[b];
+
+  /* scan the words of the block and the bits of the word */
+  for (w = b * SC_BITSET_BLOCK_WORDS;; ++w) {
+    SC_ASSERT (w < bs->num_words);
+    word = bs->words[w];
+    pc = sc_bitset_popcount (word);
+    if (k < (size_t) pc) {
+      for (; k > 0; --k) {
+        word &= word - 1;
+      }
+      return (w << 6) + (size_t) sc_bitset_ctz (word);
+    }
+    k -= (size_t) pc;
+  }
+}
@@ -0,0 +1,198 @@
+/*
+  This file is part of the SC Library.
+  The SC Library provides support for parallel scientific applications.
+
+  Copyright (C) 2010 The University of Texas System
+  Additional copyright (C) 2011 individual authors
+
+  The SC Library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  The SC Library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with the SC Library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+  02110-1301, USA.
+*/
+
+#ifndef SC_BITSET_H
+#define SC_BITSET_H
+
+/** \file sc_bitset.h
+ *
+ * Fixed-size set of bits with rank and select queries.
+ *
+ * The bits are packed into 64-bit words, which takes an eighth of the
+ * memory of an array of char flags.  Counting uses the popcount and
+ * iteration the count-trailing-zeros instruction of the compiler
+ * builtins where available.  An optional directory of the cumulative
+ * counts per \ref SC_BITSET_BLOCK_BITS bits, built by
+ * \ref sc_bitset_build_rank, answers rank queries in constant time and
+ * select queries by a short scan from sampled positions.
+ *
+ * \ingroup sc_containers
+ */
+
+#include <sc.h>
+
+/** The number of bits per block of the rank directory. */
+#define SC_BITSET_BLOCK_BITS 512
+
+/** Every this many set bits we sample the block for select queries. */
+#define SC_BITSET_SELECT_SAMPLE 4096
+
+SC_EXTERN_C_BEGIN;
+
+/** The bitset data structure.
+ * Its fields may be read but must only be modified by the functions below.
+ */
+typedef struct sc_bitset
+{
+  /* interface variables */
+  size_t              num_bits;         /**< number of bits in the set */
+
+  /* implementation variables */
+  size_t              num_words;        /**< number of 64-bit words */
+  uint64_t           *words;    /**< bits above num_bits are zero */
+  size_t              num_blocks;       /**< blocks of the directory */
+  uint64_t           *rank;     /**< set bits before each block or NULL */
+  size_t              num_samples;      /**< entries of select */
+  size_t             *select;   /**< block of every sampled set bit */
+}
+sc_bitset_t;
+
+/** Return the number of set bits in a word. */
+/*@unused@*/
+static inline int
+sc_bitset_popcount (uint64_t w)
+{
+#if defined __GNUC__ || defined __clang__
+  return __builtin_popcountll ((unsigned long long) w);
+#else
+  w = w - ((w >> 1) & 0x5555555555555555ULL);
+  w = (w & 0x3333333333333333ULL) + ((w >> 2) & 0x3333333333333333ULL);
+  w = (w + (w >> 4)) & 0x0f0f0f0f0f0f0f0fULL;
+  return (int) ((w * 0x0101010101010101ULL) >> 56);
+#endif
+}
+
+/** Return the index of the lowest set bit of a nonzero word. */
+/*@unused@*/
+static inline int
+sc_bitset_ctz (uint64_t w)
+{
+  SC_ASSERT (w != 0);
+#if defined __GNUC__ || defined __clang__
+  return __builtin_ctzll ((unsigned long long) w);
+#else
+  return sc_bitset_popcount ((w & -w) - 1);
+#endif
+}
+
+/** Create a new bitset with all bits cleared.
+ * \param [in] num_bits     The number of bits, may be zero.
+ * \return                  Returns an allocated bitset.
+ */
+sc_bitset_t        *sc_bitset_new (size_t num_bits);
+
+/** Destroy a bitset and free all its memory.
+ * \param [in,out] bs       This bitset is invalid after the call.
+ */
+void                sc_bitset_destroy (sc_bitset_t * bs);
+
+/** Calculate the memory used by a bitset.
+ * \param [in] bs           Valid bitset.
+ * \return                  Memory used in bytes.
+ */
+size_t              sc_bitset_memory_used (sc_bitset_t * bs);
+
+/** Change the number of bits of a bitset.
+ * Existing bits below the new size are kept and new bits are cleared.
+ * The rank directory is dropped.
+ * \param [in,out] bs       Valid bitset.
+ * \param [in] num_bits     The new number of bits.
+ */
+void                sc_bitset_resize (sc_bitset_t * bs, size_t num_bits);
+
+/** Set all bits of a bitset to the same value.
+ * \param [in,out] bs       Valid bitset.
+ * \param [in] value        If true set all bits, otherwise clear them.
+ */
+void                sc_bitset_fill (sc_bitset_t * bs, int value);
+
+/** Return the number of set bits.
+ * \param [in] bs           Valid bitset.
+ * \return                  The number of set bits.
+ */
+size_t              sc_bitset_count (sc_bitset_t * bs);
+
+/** Return the position of the first set bit not below a position.
+ * All set bits are visited by the loop
+ * for (i = sc_bitset_next (bs, 0); i < bs->num_bits;
+ *      i = sc_bitset_next (bs, i + 1)).
+ * \param [in] bs           Valid bitset.
+ * \param [in] pos          Position to start, at most \a bs->num_bits.
+ * \return                  The position or \a bs->num_bits if none.
+ */
+size_t              sc_bitset_next (sc_bitset_t * bs, size_t pos);
+
+/** Build the directory for \ref sc_bitset_rank and \ref sc_bitset_select.
+ * It must be rebuilt after the bits have been modified.
+ * It uses one 64-bit integer per \ref SC_BITSET_BLOCK_BITS bits and one
+ * size_t per \ref SC_BITSET_SELECT_SAMPLE set bits.
+ * \param [in,out] bs       Valid bitset.
+ */
+void                sc_bitset_build_rank (sc_bitset_t * bs);
+
+/** Return the number of set bits below a position in constant time.
+ * \param [in] bs           Bitset with a current rank directory.
+ * \param [in] pos          Position at most \a bs->num_bits.
+ * \return                  The number of set bits in [0, pos).
+ */
+size_t              sc_bitset_rank (sc_bitset_t * bs, size_t pos);
+
+/** Return the position of a set bit by its rank.
+ * \param [in] bs           Bitset with a current rank directory.
+ * \param [in] k            Zero-based number of the set bit.
+ * \return                  The position of the set bit with k set bits
+ *                          below it, or \a bs->num_bits if k is not less
+ *                          than \ref sc_bitset_count.
+ */
+size_t              sc_bitset_select (sc_bitset_t * bs, size_t k);
+
+/** Set a bit. */
+/*@unused@*/
+static inline void
+sc_bitset_set (sc_bitset_t * bs, size_t pos)
+{
+  SC_ASSERT (pos < bs->num_bits);
+  bs->words[pos >> 6] |= (uint64_t) 1 << (pos & 63);
+}
+
+/** Clear a bit. */
+/*@unused@*/
+static inline void
+sc_bitset_clear (sc_bitset_t * bs, size_t pos)
+{
+  SC_ASSERT (pos < bs->num_bits);
+  bs->words[pos >> 6] &= ~((uint64_t) 1 << (pos & 63));
+}
+
+/** Return whether a bit is set. */
+/*@unused@*/
+static inline int
+sc_bitset_test (sc_bitset_t * bs, size_t pos)
+{
+  SC_ASSERT (pos < bs->num_bits);
+  return (int) ((bs->words[pos >> 6] >> (pos & 63)) & 1);
+}
+
+SC_EXTERN_C_END;
+
+#endif /* !SC_BITSET_H */
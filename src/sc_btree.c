@@ -0,0 +1,630 @@
+/*
+  This file is part of the SC Library.
+  The SC Library provides support for parallel scientific applications.
+
+  Copyright (C) 2010 The University of Texas System
+  Additional copyright (C) 2011 individual authors
+
+  The SC Library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  The SC Library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with the SC Library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+  02110-1301, USA.
+*/
+
+#include <sc_btree.h>
+
+/** A leaf holds up to leaf_max elements, with room for one more to split. */
+typedef struct sc_btree_leaf
+{
+  struct sc_btree_leaf *next;   /**< the leaf to the right or NULL */
+  int                 n;        /**< number of elements */
+  char               *elems;    /**< the elements follow the header */
+}
+sc_btree_leaf_t;
+
+/** An inner node holds up to inner_max children and one less separator.
+ * The elements below child i + 1 are not less than separator i, and those
+ * below child i are less than separator i.
+ */
+typedef struct sc_btree_inner
+{
+  int                 n;        /**< number of children */
+  void              **child;    /**< children, following the header */
+  size_t             *count;    /**< number of elements below each child */
+  char               *keys;     /**< separators, following the counts */
+}
+sc_btree_inner_t;
+
+struct sc_btree
+{
+  size_t              elem_size;
+  int                 (*compar) (const void *, const void *);
+  size_t              count;    /**< number of elements */
+  int                 height;   /**< number of inner levels above leaves */
+  void               *root;     /**< NULL if the tree is empty */
+  sc_btree_leaf_t    *first;    /**< the leftmost leaf */
+  int                 leaf_max, inner_max;
+  char               *split;    /**< separator passed up by a split */
+  sc_mempool_t       *leaves, *inners;
+};
+
+#define SC_BTREE_AT(tree,base,i) ((base) + (size_t) (i) * (tree)->elem_size)
+
+static sc_btree_leaf_t *
+sc_btree_leaf_new (sc_btree_t * tree)
+{
+  sc_btree_leaf_t    *leaf;
+
+  leaf = (sc_btree_leaf_t *) sc_mempool_alloc (tree->leaves);
+  leaf->next = NULL;
+  leaf->n = 0;
+  leaf->elems = (char *) leaf + sizeof (sc_btree_leaf_t);
+  return leaf;
+}
+
+static sc_btree_inner_t *
+sc_btree_inner_new (sc_btree_t * tree)
+{
+  sc_btree_inner_t   *inner;
+
+  inner = (sc_btree_inner_t *) sc_mempool_alloc (tree->inners);
+  inner->n = 0;
+  inner->child = (void **) ((char *) inner + sizeof (sc_btree_inner_t));
+  inner->count = (size_t *) (inner->child + tree->inner_max + 1);
+  inner->keys = (char *) (inner->count + tree->inner_max + 1);
+  return inner;
+}
+
+/** Return the number of elements below a node at a given level. */
+static size_t
+sc_btree_total (const sc_btree_t * tree, const void *node, int level)
+{
+  int                 j;
+  size_t              total;
+  const sc_btree_inner_t *inner;
+
+  if (level == 0) {
+    return (size_t) ((const sc_btree_leaf_t *) node)->n;
+  }
+  inner = (const sc_btree_inner_t *) node;
+  for (total = 0, j = 0; j < inner->n; ++j) {
+    total += inner->count[j];
+  }
+  return total;
+}
+
+/** Return the number of elements in a sorted range less than elem. */
+static int
+sc_btree_lower (const sc_btree_t * tree, const char *base, int n,
+                const void *elem)
+{
+  int                 low, high, mid;
+
+  for (low = 0, high = n; low < high;) {
+    mid = low + (high - low) / 2;
+    if (tree->compar (SC_BTREE_AT (tree, base, mid), elem) < 0) {
+      low = mid + 1;
+    }
+    else {
+      high = mid;
+    }
+  }
+  return low;
+}
+
+/** Return the child of an inner node that may contain elem. */
+static int
+sc_btree_child (const sc_btree_t * tree, const sc_btree_inner_t * inner,
+                const void *elem)
+{
+  int                 low, high, mid;
+
+  for (low = 0, high = inner->n - 1; low < high;) {
+    mid = low + (high - low) / 2;
+    if (tree->compar (SC_BTREE_AT (tree, inner->keys, mid), elem) <= 0) {
+      low = mid + 1;
+    }
+    else {
+      high = mid;
+    }
+  }
+  return low;
+}
+
+sc_btree_t         *
+sc_btree_new (size_t elem_size, int (*compar) (const void *, const void *))
+{
+  size_t              bytes;
+  sc_btree_t         *tree;
+
+  SC_ASSERT (elem_size > 0);
+  SC_ASSERT (compar != NULL);
+
+  tree = SC_ALLOC_ZERO (sc_btree_t, 1);
+  tree->elem_size = elem_size;
+  tree->compar = compar;
+  tree->split = SC_ALLOC (char, elem_size);
+
+  /* fit the nodes including one spare entry into the targeted size */
+  bytes = SC_BTREE_NODE_BYTES;
+  tree->leaf_max = SC_MAX (4, (int) ((bytes - sizeof (sc_btree_leaf_t)) /
+                                     elem_size) - 1);
+  tree->inner_max = SC_MAX (4, (int) ((bytes - sizeof (sc_btree_inner_t)) /
+                                      (sizeof (void *) + sizeof (size_t) +
+                                       elem_size)) - 1);
+
+  /* node sizes are rounded up to keep the nodes in a pool aligned */
+  bytes = sizeof (sc_btree_leaf_t) + (tree->leaf_max + 1) * elem_size;
+  tree->leaves = sc_mempool_new ((bytes + 7) & ~(size_t) 7);
+  bytes = sizeof (sc_btree_inner_t) + (tree->inner_max + 1) *
+    (sizeof (void *) + sizeof (size_t)) + tree->inner_max * elem_size;
+  tree->inners = sc_mempool_new ((bytes + 7) & ~(size_t) 7);
+
+  return tree;
+}
+
+void
+sc_btree_destroy (sc_btree_t * tree)
+{
+  sc_mempool_destroy (tree->leaves);
+  sc_mempool_destroy (tree->inners);
+  SC_FREE (tree->split);
+  SC_FREE (tree);
+}
+
+void
+sc_btree_reset (sc_btree_t * tree)
+{
+  sc_mempool_truncate (tree->leaves);
+  sc_mempool_truncate (tree->inners);
+  tree->count = 0;
+  tree->height = 0;
+  tree->root = NULL;
+  tree->first = NULL;
+}
+
+size_t
+sc_btree_memory_used (sc_btree_t * tree)
+{
+  return sizeof (sc_btree_t) + tree->elem_size +
+    sc_mempool_memory_used (tree->leaves) +
+    sc_mempool_memory_used (tree->inners);
+}
+
+size_t
+sc_btree_count (const sc_btree_t * tree)
+{
+  return tree->count;
+}
+
+/** Insert below a node and report a split through tree->split.
+ * \param [out] split   The new right sibling of the node, or NULL.
+ */
+static int
+sc_btree_insert_rec (sc_btree_t * tree, void *node, int level,
+                     const void *elem, void **found, void **split)
+{
+  const size_t        es = tree->elem_size;
+  int                 pos, nl, i, inserted;
+  void               *sub;
+  sc_btree_leaf_t    *leaf, *right;
+  sc_btree_inner_t   *inner, *iright;
+
+  *split = NULL;
+  if (level == 0) {
+    leaf = (sc_btree_leaf_t *) node;
+    pos = sc_btree_lower (tree, leaf->elems, leaf->n, elem);
+    if (pos < leaf->n &&
+        tree->compar (SC_BTREE_AT (tree, leaf->elems, pos), elem) == 0) {
+      *found = SC_BTREE_AT (tree, leaf->elems, pos);
+      return 0;
+    }
+    memmove (SC_BTREE_AT (tree, leaf->elems, pos + 1),
+             SC_BTREE_AT (tree, leaf->elems, pos), (leaf->n - pos) * es);
+    memcpy (SC_BTREE_AT (tree, leaf->elems, pos), elem, es);
+    if (++leaf->n > tree->leaf_max) {
+      /* move the upper half into a new leaf to the right */
+      right = sc_btree_leaf_new (tree);
+      nl = leaf->n / 2;
+      right->n = leaf->n - nl;
+      memcpy (right->elems, SC_BTREE_AT (tree, leaf->elems, nl),
+              right->n * es);
+      leaf->n = nl;
+      right->next = leaf->next;
+      leaf->next = right;
+      memcpy (tree->split, right->elems, es);
+      *split = right;
+      if (pos >= nl) {
+        leaf = right;
+        pos -= nl;
+      }
+    }
+    *found = SC_BTREE_AT (tree, leaf->elems, pos);
+    return 1;
+  }
+
+  inner = (sc_btree_inner_t *) node;
+  i = sc_btree_child (tree, inner, elem);
+  inserted = sc_btree_insert_rec (tree, inner->child[i], level - 1,
+                                  elem, found, &sub);
+  if (inserted) {
+    ++inner->count[i];
+  }
+  if (sub != NULL) {
+    /* the child has split: insert its new sibling and separator */
+    memmove (inner->child + i + 2, inner->child + i + 1,
+             (inner->n - i - 1) * sizeof (void *));
+    memmove (inner->count + i + 2, inner->count + i + 1,
+             (inner->n - i - 1) * sizeof (size_t));
+    memmove (SC_BTREE_AT (tree, inner->keys, i + 1),
+             SC_BTREE_AT (tree, inner->keys, i), (inner->n - i - 1) * es);
+    inner->child[i + 1] = sub;
+    memcpy (SC_BTREE_AT (tree, inner->keys, i), tree->split, es);
+    ++inner->n;
+    inner->count[i] = sc_btree_total (tree, inner->child[i], level - 1);
+    inner->count[i + 1] = sc_btree_total (tree, sub, level - 1);
+
+    if (inner->n > tree->inner_max) {
+      /* the middle separator moves up to the parent */
+      iright = sc_btree_inner_new (tree);
+      nl = inner->n / 2;
+      iright->n = inner->n - nl;
+      memcpy (iright->child, inner->child + nl, iright->n * sizeof (void *));
+      memcpy (iright->count, inner->count + nl, iright->n * sizeof (size_t));
+      memcpy (iright->keys, SC_BTREE_AT (tree, inner->keys, nl),
+              (iright->n - 1) * es);
+      memcpy (tree->split, SC_BTREE_AT (tree, inner->keys, nl - 1), es);
+      inner->n = nl;
+      *split = iright;
+    }
+  }
+  return inserted;
+}
+
+int
+sc_btree_insert (sc_btree_t * tree, const void *elem, void **found)
+{
+  int                 inserted;
+  void               *sub, *dummy;
+  sc_btree_inner_t   *root;
+
+  if (tree->root == NULL) {
+    tree->root = tree->first = sc_btree_leaf_new (tree);
+    tree->height = 0;
+  }
+  inserted = sc_btree_insert_rec (tree, tree->root, tree->height, elem,
+                                  found != NULL ? found : &dummy, &sub);
+  if (sub != NULL) {
+    /* the tree grows at the root */
+    root = sc_btree_inner_new (tree);
+    root->n = 2;
+    root->child[0] = tree->root;
+    root->child[1] = sub;
+    root->count[0] = sc_btree_total (tree, tree->root, tree->height);
+    root->count[1] = sc_btree_total (tree, sub, tree->height);
+    memcpy (root->keys, tree->split, tree->elem_size);
+    tree->root = root;
+    ++tree->height;
+  }
+  if (inserted) {
+    ++tree->count;
+  }
+  return inserted;
+}
+
+/** Remove child ri and separator ri - 1 of an inner node. */
+static void
+sc_btree_inner_erase (sc_btree_t * tree, sc_btree_inner_t * inner, int ri)
+{
+  memmove (inner->child + ri, inner->child + ri + 1,
+           (inner->n - ri - 1) * sizeof (void *));
+  memmove (inner->count + ri, inner->count + ri + 1,
+           (inner->n - ri - 1) * sizeof (size_t));
+  memmove (SC_BTREE_AT (tree, inner->keys, ri - 1),
+           SC_BTREE_AT (tree, inner->keys, ri),
+           (inner->n - ri - 1) * tree->elem_size);
+  --inner->n;
+}
+
+/** Refill child i of an inner node by borrowing from or merging with
+ * a neighbor.  The children are at the level below \a level. */
+static void
+sc_btree_fix (sc_btree_t * tree, sc_btree_inner_t * parent, int i, int level)
+{
+  const size_t        es = tree->elem_size;
+  const int           li = i > 0 ? i - 1 : i;
+  const int           ri = li + 1;
+  char               *sep = SC_BTREE_AT (tree, parent->keys, li);
+  size_t              moved;
+  sc_btree_leaf_t    *left, *right;
+  sc_btree_inner_t   *ileft, *iright;
+
+  if (level == 1) {
+    left = (sc_btree_leaf_t *) parent->child[li];
+    right = (sc_btree_leaf_t *) parent->child[ri];
+    if (left->n + right->n <= tree->leaf_max) {
+      memcpy (SC_BTREE_AT (tree, left->elems, left->n), right->elems, right->n * es);
+      left->n += right->n;
+      left->next = right->next;
+      sc_mempool_free (tree->leaves, right);
+      sc_btree_inner_erase (tree, parent, ri);
+    }
+    else if (i == li) {
+      memcpy (SC_BTREE_AT (tree, left->elems, left->n), right->elems, es);
+      ++left->n;
+      memmove (right->elems, SC_BTREE_AT (tree, right->elems, 1), --right->n * es);
+      memcpy (sep, right->elems, es);
+      parent->count[ri] = right->n;
+    }
+    else {
+      memmove (SC_BTREE_AT (tree, right->elems, 1), right->elems, right->n * es);
+      memcpy (right->elems, SC_BTREE_AT (tree, left->elems, --left->n), es);
+      ++right->n;
+      memcpy (sep, right->elems, es);
+      parent->count[ri] = right->n;
+    }
+    parent->count[li] = left->n;
+    return;
+  }
+
+  ileft = (sc_btree_inner_t *) parent->child[li];
+  iright = (sc_btree_inner_t *) parent->child[ri];
+  if (ileft->n + iright->n <= tree->inner_max) {
+    /* the separator comes down between the children of both */
+    memcpy (SC_BTREE_AT (tree, ileft->keys, ileft->n - 1), sep, es);
+    memcpy (SC_BTREE_AT (tree, ileft->keys, ileft->n), iright->keys,
+            (iright->n - 1) * es);
+    memcpy (ileft->child + ileft->n, iright->child, iright->n * sizeof (void *));
+    memcpy (ileft->count + ileft->n, iright->count, iright->n * sizeof (size_t));
+    ileft->n += iright->n;
+    sc_mempool_free (tree->inners, iright);
+    parent->count[li] += parent->count[ri];
+    sc_btree_inner_erase (tree, parent, ri);
+  }
+  else if (i == li) {
+    /* rotate the first child of the right node to the left */
+    memcpy (SC_BTREE_AT (tree, ileft->keys, ileft->n - 1), sep, es);
+    ileft->child[ileft->n] = iright->child[0];
+    moved = ileft->count[ileft->n] = iright->count[0];
+    ++ileft->n;
+    memcpy (sep, iright->keys, es);
+    memmove (iright->child, iright->child + 1, (iright->n - 1) * sizeof (void *));
+    memmove (iright->count, iright->count + 1, (iright->n - 1) * sizeof (size_t));
+    memmove (iright->keys, SC_BTREE_AT (tree, iright->keys, 1), (iright->n - 2) * es);
+    --iright->n;
+    parent->count[li] += moved;
+    parent->count[ri] -= moved;
+  }
+  else {
+    /* rotate the last child of the left node to the right */
+    memmove (iright->child + 1, iright->child, iright->n * sizeof (void *));
+    memmove (iright->count + 1, iright->count, iright->n * sizeof (size_t));
+    memmove (SC_BTREE_AT (tree, iright->keys, 1), iright->keys, (iright->n - 1) * es);
+    memcpy (iright->keys, sep, es);
+    iright->child[0] = ileft->child[ileft->n - 1];
+    moved = iright->count[0] = ileft->count[ileft->n - 1];
+    ++iright->n;
+    memcpy (sep, SC_BTREE_AT (tree, ileft->keys, ileft->n - 2), es);
+    --ileft->n;
+    parent->count[li] -= moved;
+    parent->count[ri] += moved;
+  }
+}
+
+static int
+sc_btree_remove_rec (sc_btree_t * tree, void *node, int level,
+                     const void *elem, void *removed)
+{
+  int                 pos, i, n;
+  sc_btree_leaf_t    *leaf;
+  sc_btree_inner_t   *inner;
+
+  if (level == 0) {
+    leaf = (sc_btree_leaf_t *) node;
+    pos = sc_btree_lower (tree, leaf->elems, leaf->n, elem);
+    if (pos == leaf->n ||
+        tree->compar (SC_BTREE_AT (tree, leaf->elems, pos), elem) != 0) {
+      return 0;
+    }
+    if (removed != NULL) {
+      memcpy (removed, SC_BTREE_AT (tree, leaf->elems, pos),
+              tree->elem_size);
+    }
+    --leaf->n;
+    memmove (SC_BTREE_AT (tree, leaf->elems, pos),
+             SC_BTREE_AT (tree, leaf->elems, pos + 1),
+             (leaf->n - pos) * tree->elem_size);
+    return 1;
+  }
+
+  inner = (sc_btree_inner_t *) node;
+  i = sc_btree_child (tree, inner, elem);
+  if (!sc_btree_remove_rec (tree, inner->child[i], level - 1, elem,
+                            removed)) {
+    return 0;
+  }
+  --inner->count[i];
+  n = level == 1 ? ((sc_btree_leaf_t *) inner->child[i])->n :
+    ((sc_btree_inner_t *) inner->child[i])->n;
+  if (n < (level == 1 ? tree->leaf_max : tree->inner_max) / 2) {
+    sc_btree_fix (tree, inner, i, level);
+  }
+  return 1;
+}
+
+int
+sc_btree_remove (sc_btree_t * tree, const void *elem, void *removed)
+{
+  sc_btree_inner_t   *root;
+
+  if (tree->root == NULL ||
+      !sc_btree_remove_rec (tree, tree->root, tree->height, elem, removed)) {
+    return 0;
+  }
+  --tree->count;
+
+  /* the tree shrinks at the root */
+  if (tree->height > 0 && (root = (sc_btree_inner_t *) tree->root)->n == 1) {
+    tree->root = root->child[0];
+    --tree->height;
+    sc_mempool_free (tree->inners, root);
+  }
+  else if (tree->height == 0 && tree->count == 0) {
+    sc_mempool_free (tree->leaves, tree->root);
+    tree->root = NULL;
+    tree->first = NULL;
+  }
+  return 1;
+}
+
+/** Descend to the leaf that may contain elem. */
+static sc_btree_leaf_t *
+sc_btree_find_leaf (const sc_btree_t * tree, const void *elem, size_t *rank)
+{
+  int                 level, i, j;
+  void               *node;
+  sc_btree_inner_t   *inner;
+
+  SC_ASSERT (tree->root != NULL);
+
+  node = tree->root;
+  for (level = tree->height; level > 0; --level) {
+    inner = (sc_btree_inner_t *) node;
+    i = sc_btree_child (tree, inner, elem);
+    if (rank != NULL) {
+      for (j = 0; j < i; ++j) {
+        *rank += inner->count[j];
+      }
+    }
+    node = inner->child[i];
+  }
+  return (sc_btree_leaf_t *) node;
+}
+
+void               *
+sc_btree_search (const sc_btree_t * tree, const void *elem)
+{
+  int                 pos;
+  sc_btree_leaf_t    *leaf;
+
+  if (tree->root == NULL) {
+    return NULL;
+  }
+  leaf = sc_btree_find_leaf (tree, elem, NULL);
+  pos = sc_btree_lower (tree, leaf->elems, leaf->n, elem);
+  if (pos < leaf->n &&
+      tree->compar (SC_BTREE_AT (tree, leaf->elems, pos), elem) == 0) {
+    return SC_BTREE_AT (tree, leaf->elems, pos);
+  }
+  return NULL;
+}
+
+int
+sc_btree_search_closest (const sc_btree_t * tree, const void *elem,
+                         void **found)
+{
+  int                 pos, result;
+  void               *closest;
+  sc_btree_leaf_t    *leaf;
+
+  if (tree->root == NULL) {
+    closest = NULL;
+    result = 0;
+  }
+  else {
+    leaf = sc_btree_find_leaf (tree, elem, NULL);
+    pos = sc_btree_lower (tree, leaf->elems, leaf->n, elem);
+    if (pos < leaf->n) {
+      closest = SC_BTREE_AT (tree, leaf->elems, pos);
+      result = tree->compar (closest, elem) == 0 ? 0 : 1;
+    }
+    else if (leaf->next != NULL) {
+      /* the separators guarantee that the next leaf is greater */
+      closest = leaf->next->elems;
+      result = 1;
+    }
+    else {
+      closest = SC_BTREE_AT (tree, leaf->elems, leaf->n - 1);
+      result = -1;
+    }
+  }
+  if (found != NULL) {
+    *found = closest;
+  }
+  return result;
+}
+
+void               *
+sc_btree_at (const sc_btree_t * tree, size_t index)
+{
+  int                 level, j;
+  void               *node;
+  sc_btree_inner_t   *inner;
+
+  if (index >= tree->count) {
+    return NULL;
+  }
+  node = tree->root;
+  for (level = tree->height; level > 0; --level) {
+    inner = (sc_btree_inner_t *) node;
+    for (j = 0; index >= inner->count[j]; ++j) {
+      index -= inner->count[j];
+    }
+    node = inner->child[j];
+  }
+  return SC_BTREE_AT (tree, ((sc_btree_leaf_t *) node)->elems, index);
+}
+
+size_t
+sc_btree_index (const sc_btree_t * tree, const void *elem)
+{
+  size_t              rank = 0;
+  sc_btree_leaf_t    *leaf;
+
+  if (tree->root == NULL) {
+    return 0;
+  }
+  leaf = sc_btree_find_leaf (tree, elem, &rank);
+  return rank + sc_btree_lower (tree, leaf->elems, leaf->n, elem);
+}
+
+void
+sc_btree_foreach (sc_btree_t * tree, void (*fn) (void *elem, void *user),
+                  void *user)
+{
+  int                 k;
+  sc_btree_leaf_t    *leaf;
+
+  for (leaf = tree->first; leaf != NULL; leaf = leaf->next) {
+    for (k = 0; k < leaf->n; ++k) {
+      fn (SC_BTREE_AT (tree, leaf->elems, k), user);
+    }
+  }
+}
+
+void
+sc_btree_to_array (const sc_btree_t * tree, sc_array_t * array)
+{
+  char               *pos;
+  sc_btree_leaf_t    *leaf;
+
+  SC_ASSERT (array->elem_size == tree->elem_size);
+
+  sc_array_resize (array, tree->count);
+  pos = array->array;
+  for (leaf = tree->first; leaf != NULL; leaf = leaf->next) {
+    memcpy (pos, leaf->elems, leaf->n * tree->elem_size);
+    pos += leaf->n * tree->elem_size;
+  }
+  SC_ASSERT (pos == array->array + tree->count * tree->elem_size);
+}
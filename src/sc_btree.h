@@ -0,0 +1,169 @@
+/*
+  This file is part of the SC Library.
+  The SC Library provides support for parallel scientific applications.
+
+  Copyright (C) 2010 The University of Texas System
+  Additional copyright (C) 2011 individual authors
+
+  The SC Library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  The SC Library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with the SC Library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+  02110-1301, USA.
+*/
+
+#ifndef SC_BTREE_H
+#define SC_BTREE_H
+
+/** \file sc_btree.h
+ *
+ * Ordered set of fixed-size elements in a B+ tree.
+ *
+ * The elements are stored by value in the leaves, which are linked in
+ * order, and the inner nodes hold copies of separating elements and the
+ * number of elements below each child.  The nodes have a size of
+ * \ref SC_BTREE_NODE_BYTES, a few cache lines, and are allocated from
+ * memory pools.  Compared to \ref sc_avl.h, which allocates one node of
+ * six words per item, this saves memory and cache misses for large sets.
+ * The operations of the AVL tree including the order statistics are
+ * provided.  Pointers to elements of the tree are valid only until the
+ * next insertion or removal.
+ *
+ * \ingroup sc_containers
+ */
+
+#include <sc_containers.h>
+
+/** The targeted size of a tree node in bytes.
+ * The number of elements per node is derived from the element size.
+ */
+#define SC_BTREE_NODE_BYTES 512
+
+SC_EXTERN_C_BEGIN;
+
+/** The B+ tree object is opaque. */
+typedef struct sc_btree sc_btree_t;
+
+/** Create a new empty B+ tree.
+ * \param [in] elem_size    Size of one element in bytes.
+ * \param [in] compar       Ordering of the elements like strcmp.
+ *                          Elements comparing equal are the same.
+ * \return                  Returns an allocated and initialized tree.
+ */
+sc_btree_t         *sc_btree_new (size_t elem_size,
+                                  int (*compar) (const void *,
+                                                 const void *));
+
+/** Destroy a B+ tree and free all its memory.
+ * \param [in,out] tree     This tree is invalid after the call.
+ */
+void                sc_btree_destroy (sc_btree_t * tree);
+
+/** Remove all elements from a tree, keeping its memory pools.
+ * \param [in,out] tree     This tree will be empty.
+ */
+void                sc_btree_reset (sc_btree_t * tree);
+
+/** Calculate the memory used by a tree.
+ * \param [in] tree         Valid tree.
+ * \return                  Memory used in bytes.
+ */
+size_t              sc_btree_memory_used (sc_btree_t * tree);
+
+/** Return the number of elements in a tree.
+ * \param [in] tree         Valid tree.
+ * \return                  The number of elements.
+ */
+size_t              sc_btree_count (const sc_btree_t * tree);
+
+/** Insert an element unless an equal one is in the tree.
+ * \param [in,out] tree     Valid tree.
+ * \param [in] elem         The element is copied into the tree.
+ * \param [out] found       If not NULL, set to the element in the tree
+ *                          that compares equal, newly inserted or not.
+ * \return                  True if the element has been inserted.
+ */
+int                 sc_btree_insert (sc_btree_t * tree, const void *elem,
+                                     void **found);
+
+/** Remove the element comparing equal to a given one.
+ * \param [in,out] tree     Valid tree.
+ * \param [in] elem         The element to remove.
+ * \param [out] removed     If not NULL, the removed element is copied here.
+ * \return                  True if an element has been removed.
+ */
+int                 sc_btree_remove (sc_btree_t * tree, const void *elem,
+                                     void *removed);
+
+/** Search for an element.
+ * \param [in] tree         Valid tree.
+ * \param [in] elem         The element to look for.
+ * \return                  The element in the tree that compares equal,
+ *                          or NULL if there is none.
+ */
+void               *sc_btree_search (const sc_btree_t * tree,
+                                     const void *elem);
+
+/** Search for the element closest to a given one.
+ * Like avl_search_closest, we return an equal element if it exists.
+ * Otherwise we return the smallest greater element, or the largest
+ * element if all are smaller.
+ * \param [in] tree         Valid tree.
+ * \param [in] elem         The element to look for.
+ * \param [out] found       If not NULL, set to the element found, or to
+ *                          NULL if the tree is empty.
+ * \return                  -1 if the element found is smaller,
+ *                          0 if it is equal or the tree is empty,
+ *                          1 if the element found is greater.
+ */
+int                 sc_btree_search_closest (const sc_btree_t * tree,
+                                             const void *elem,
+                                             void **found);
+
+/** Return an element by its rank.  Counting starts at 0.
+ * \param [in] tree         Valid tree.
+ * \param [in] index        Rank of the element.
+ * \return                  The element or NULL if the index is too large.
+ */
+void               *sc_btree_at (const sc_btree_t * tree, size_t index);
+
+/** Return the rank of an element, which need not be in the tree.
+ * \param [in] tree         Valid tree.
+ * \param [in] elem         The element to look for.
+ * \return                  The number of elements in the tree that are
+ *                          smaller.  This is the index of the element if
+ *                          it is in the tree.
+ */
+size_t              sc_btree_index (const sc_btree_t * tree,
+                                    const void *elem);
+
+/** Call a function for every element in order.
+ * \param [in] tree         Valid tree.  It must not be modified by \a fn.
+ * \param [in] fn           Called with each element and the user data.
+ *                          The element must not be changed in its order.
+ * \param [in,out] user     Passed to every call of \a fn.
+ */
+void                sc_btree_foreach (sc_btree_t * tree,
+                                      void (*fn) (void *elem, void *user),
+                                      void *user);
+
+/** Copy all elements in order into an array.
+ * \param [in] tree         Valid tree.
+ * \param [in,out] array    Resizable array of the element size of the
+ *                          tree.  It is resized to the number of elements.
+ */
+void                sc_btree_to_array (const sc_btree_t * tree,
+                                       sc_array_t * array);
+
+SC_EXTERN_C_END;
+
+#endif /* !SC_BTREE_H */
@@ -0,0 +1,504 @@
+/*
+  This file is part of the SC Library.
+  The SC Library provides support for parallel scientific applications.
+
+  Copyright (C) 2010 The University of Texas System
+  Additional copyright (C) 2011 individual authors
+
+  The SC Library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  The SC Library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with the SC Library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+  02110-1301, USA.
+*/
+
+#include <sc_checkpoint.h>
+
+/** One entry of the block index as kept in memory. */
+typedef struct sc_checkpoint_entry
+{
+  int                 writer;           /**< Rank of the writing process. */
+  size_t              local_index;      /**< Block number on the writer. */
+  sc_MPI_Offset       offset;           /**< Position in the file. */
+  size_t              stored;           /**< Bytes in the file. */
+  size_t              size;             /**< Bytes of the original data. */
+  size_t              elem_size;        /**< Original element size. */
+  unsigned            checksum;         /**< Checksum of the original data. */
+  int                 format;           /**< 0 or 'z'. */
+}
+sc_checkpoint_entry_t;
+
+struct sc_checkpoint
+{
+  sc_MPI_Comm         mpicomm;
+  sc_MPI_File         file;
+  int                 num_writers;
+  size_t              num_blocks;
+  size_t             *first;            /**< First block of each writer. */
+  sc_checkpoint_entry_t *entries;
+};
+
+/** Write a 64-bit number in big endian byte order. */
+static void
+sc_checkpoint_put (char *dest, uint64_t value)
+{
+  int                 i;
+
+  for (i = 0; i < 8; ++i) {
+    dest[i] = (char) ((value >> ((7 - i) * 8)) & 0xFF);
+  }
+}
+
+/** Read a 64-bit number in big endian byte order. */
+static uint64_t
+sc_checkpoint_get (const char *src)
+{
+  int                 i;
+  uint64_t            value = 0;
+
+  for (i = 0; i < 8; ++i) {
+    value |= ((uint64_t) (unsigned char) src[i]) << ((7 - i) * 8);
+  }
+  return value;
+}
+
+int
+sc_checkpoint_write (sc_MPI_Comm mpicomm, const char *filename,
+                     sc_array_t *blocks, int compression_level)
+{
+  int                 mpiret, errcode, errall, ocount;
+  int                 rank, size, format;
+  size_t              zz, n, bytes, pos;
+  long long           mine[2], before[2], total[2];
+  uint64_t            data_offset;
+  char                header[SC_CHECKPOINT_HEADER_BYTES];
+  char               *entry;
+  sc_array_t         *block, *enc;
+  sc_array_t         *index, *data;
+  sc_MPI_File         file;
+
+  SC_ASSERT (blocks != NULL && blocks->elem_size == sizeof (sc_array_t));
+  SC_ASSERT (0 <= compression_level && compression_level <= 9);
+
+  mpiret = sc_MPI_Comm_rank (mpicomm, &rank);
+  SC_CHECK_MPI (mpiret);
+  mpiret = sc_MPI_Comm_size (mpicomm, &size);
+  SC_CHECK_MPI (mpiret);
+
+  /* store each block in the smaller of the raw and the encoded format */
+  n = blocks->elem_count;
+  index = sc_array_new_count (SC_CHECKPOINT_ENTRY_BYTES, n);
+  data = sc_array_new (1);
+  enc = sc_array_new (1);
+  for (zz = 0; zz < n; ++zz) {
+    block = (sc_array_t *) sc_array_index (blocks, zz);
+    bytes = block->elem_count * block->elem_size;
+    format = 0;
+    if (compression_level > 0 && bytes > 0) {
+      sc_io_encode_zlib (block, enc, compression_level, '=');
+      if (enc->elem_count < bytes) {
+        format = 'z';
+      }
+    }
+    pos = data->elem_count;
+    if (format == 'z') {
+      sc_array_push_count (data, enc->elem_count);
+      memcpy (data->array + pos, enc->array, enc->elem_count);
+    }
+    else if (bytes > 0) {
+      sc_array_push_count (data, bytes);
+      memcpy (data->array + pos, block->array, bytes);
+    }
+
+    /* the offsets are made global below */
+    entry = (char *) sc_array_index (index, zz);
+    sc_checkpoint_put (entry, (uint64_t) rank);
+    sc_checkpoint_put (entry + 8, (uint64_t) zz);
+    sc_checkpoint_put (entry + 16, (uint64_t) pos);
+    sc_checkpoint_put (entry + 24, (uint64_t) (data->elem_count - pos));
+    sc_checkpoint_put (entry + 32, (uint64_t) bytes);
+    sc_checkpoint_put (entry + 40, (uint64_t) block->elem_size);
+    sc_checkpoint_put (entry + 48, (uint64_t) sc_array_checksum (block));
+    sc_checkpoint_put (entry + 56, (uint64_t) format);
+  }
+  sc_array_destroy (enc);
+  SC_CHECK_ABORT (index->elem_count * SC_CHECKPOINT_ENTRY_BYTES <=
+                  (size_t) INT_MAX && data->elem_count <= (size_t) INT_MAX,
+                  "checkpoint_write: data too large");
+
+  /* the ranks write their index entries and blocks in rank order */
+  mine[0] = (long long) n;
+  mine[1] = (long long) data->elem_count;
+  mpiret = sc_MPI_Scan (mine, before, 2, sc_MPI_LONG_LONG_INT,
+                        sc_MPI_SUM, mpicomm);
+  SC_CHECK_MPI (mpiret);
+  before[0] -= mine[0];
+  before[1] -= mine[1];
+  mpiret = sc_MPI_Allreduce (mine, total, 2, sc_MPI_LONG_LONG_INT,
+                             sc_MPI_SUM, mpicomm);
+  SC_CHECK_MPI (mpiret);
+  data_offset = SC_CHECKPOINT_HEADER_BYTES +
+    SC_CHECKPOINT_ENTRY_BYTES * (uint64_t) total[0];
+  for (zz = 0; zz < n; ++zz) {
+    entry = (char *) sc_array_index (index, zz);
+    sc_checkpoint_put (entry + 16, data_offset + (uint64_t) before[1] +
+                       sc_checkpoint_get (entry + 16));
+  }
+
+  errcode = sc_io_open (mpicomm, filename, SC_IO_WRITE_CREATE,
+                        sc_MPI_INFO_NULL, &file);
+  if (errcode != sc_MPI_SUCCESS) {
+    sc_array_destroy (index);
+    sc_array_destroy (data);
+    return errcode;
+  }
+
+  if (rank == 0) {
+    memset (header, 0, SC_CHECKPOINT_HEADER_BYTES);
+    memcpy (header, SC_CHECKPOINT_MAGIC, 8);
+    sc_checkpoint_put (header + 8, SC_CHECKPOINT_VERSION);
+    sc_checkpoint_put (header + 16, (uint64_t) size);
+    sc_checkpoint_put (header + 24, (uint64_t) total[0]);
+    sc_checkpoint_put (header + 32, data_offset);
+    sc_checkpoint_put (header + 40, data_offset + (uint64_t) total[1]);
+    errcode = sc_io_write_at (file, 0, header, SC_CHECKPOINT_HEADER_BYTES,
+                              sc_MPI_BYTE, &ocount);
+    if (errcode == sc_MPI_SUCCESS && ocount != SC_CHECKPOINT_HEADER_BYTES) {
+      errcode = sc_MPI_ERR_IO;
+    }
+  }
+  errall = errcode;
+
+  /* the processes continue after an error to complete the collectives */
+  errcode = sc_io_write_at_all (file, (sc_MPI_Offset)
+                                (SC_CHECKPOINT_HEADER_BYTES +
+                                 SC_CHECKPOINT_ENTRY_BYTES * before[0]),
+                                index->array,
+                                index->elem_count * SC_CHECKPOINT_ENTRY_BYTES,
+                                sc_MPI_BYTE, &ocount);
+  if (errcode == sc_MPI_SUCCESS &&
+      ocount != (int) (index->elem_count * SC_CHECKPOINT_ENTRY_BYTES)) {
+    errcode = sc_MPI_ERR_IO;
+  }
+  errall = errall != sc_MPI_SUCCESS ? errall : errcode;
+  errcode = sc_io_write_at_all (file, (sc_MPI_Offset)
+                                (data_offset + (uint64_t) before[1]),
+                                data->array, data->elem_count,
+                                sc_MPI_BYTE, &ocount);
+  if (errcode == sc_MPI_SUCCESS && ocount != (int) data->elem_count) {
+    errcode = sc_MPI_ERR_IO;
+  }
+  errall = errall != sc_MPI_SUCCESS ? errall : errcode;
+  sc_array_destroy (index);
+  sc_array_destroy (data);
+
+  errcode = sc_io_close (&file);
+  errall = errall != sc_MPI_SUCCESS ? errall : errcode;
+
+  /* report the same error on all processes */
+  mpiret = sc_MPI_Allreduce (&errall, &errcode, 1, sc_MPI_INT, sc_MPI_MAX,
+                             mpicomm);
+  SC_CHECK_MPI (mpiret);
+  return errcode;
+}
+
+/** Check the header and index and convert the index into memory.
+ * \return          0 on success and -1 if the data is malformed.
+ */
+static int
+sc_checkpoint_parse (sc_checkpoint_t * ckpt, const char *index,
+                     uint64_t file_size)
+{
+  int                 w;
+  size_t              zz, expected_local;
+  uint64_t            expected_offset, value;
+  const char         *entry;
+  sc_checkpoint_entry_t *e;
+
+  ckpt->first = SC_ALLOC (size_t, ckpt->num_writers + 1);
+  ckpt->entries = SC_ALLOC (sc_checkpoint_entry_t, ckpt->num_blocks);
+
+  /* the blocks are contiguous in order of writer and local index */
+  w = 0;
+  ckpt->first[0] = 0;
+  expected_local = 0;
+  expected_offset = SC_CHECKPOINT_HEADER_BYTES +
+    SC_CHECKPOINT_ENTRY_BYTES * (uint64_t) ckpt->num_blocks;
+  for (zz = 0; zz < ckpt->num_blocks; ++zz) {
+    entry = index + zz * SC_CHECKPOINT_ENTRY_BYTES;
+    e = ckpt->entries + zz;
+
+    value = sc_checkpoint_get (entry);
+    if (value < (uint64_t) w || value >= (uint64_t) ckpt->num_writers) {
+      return -1;
+    }
+    while (w < (int) value) {
+      ckpt->first[++w] = zz;
+      expected_local = 0;
+    }
+    e->writer = w;
+    e->local_index = (size_t) sc_checkpoint_get (entry + 8);
+    if (e->local_index != expected_local++) {
+      return -1;
+    }
+
+    value = sc_checkpoint_get (entry + 16);
+    if (value != expected_offset) {
+      return -1;
+    }
+    e->offset = (sc_MPI_Offset) value;
+    e->stored = (size_t) sc_checkpoint_get (entry + 24);
+    e->size = (size_t) sc_checkpoint_get (entry + 32);
+    e->elem_size = (size_t) sc_checkpoint_get (entry + 40);
+    e->checksum = (unsigned) sc_checkpoint_get (entry + 48);
+    e->format = (int) sc_checkpoint_get (entry + 56);
+    expected_offset += e->stored;
+    if (expected_offset > file_size || e->stored > (size_t) INT_MAX ||
+        e->elem_size == 0 || e->size % e->elem_size != 0) {
+      return -1;
+    }
+    if (!((e->format == 0 && e->stored == e->size) ||
+          (e->format == 'z' && e->stored > 0))) {
+      return -1;
+    }
+  }
+  while (w < ckpt->num_writers) {
+    ckpt->first[++w] = ckpt->num_blocks;
+  }
+  return expected_offset == file_size ? 0 : -1;
+}
+
+sc_checkpoint_t    *
+sc_checkpoint_open (sc_MPI_Comm mpicomm, const char *filename, int *errcode)
+{
+  int                 mpiret, retval, ocount, rank;
+  long long           info[4];
+  uint64_t            version, num_blocks;
+  char                header[SC_CHECKPOINT_HEADER_BYTES];
+  char               *index;
+  sc_checkpoint_t    *ckpt;
+
+  ckpt = SC_ALLOC_ZERO (sc_checkpoint_t, 1);
+  ckpt->mpicomm = mpicomm;
+  retval = sc_io_open (mpicomm, filename, SC_IO_READ, sc_MPI_INFO_NULL,
+                       &ckpt->file);
+  if (retval != sc_MPI_SUCCESS) {
+    SC_FREE (ckpt);
+    if (errcode != NULL) {
+      *errcode = retval;
+    }
+    return NULL;
+  }
+  mpiret = sc_MPI_Comm_rank (mpicomm, &rank);
+  SC_CHECK_MPI (mpiret);
+
+  /* the first process reads the header and the index */
+  index = NULL;
+  info[0] = sc_MPI_SUCCESS;
+  info[1] = info[2] = info[3] = 0;
+  if (rank == 0) {
+    retval = sc_io_read_at (ckpt->file, 0, header, SC_CHECKPOINT_HEADER_BYTES,
+                            sc_MPI_BYTE, &ocount);
+    if (retval == sc_MPI_SUCCESS && ocount == SC_CHECKPOINT_HEADER_BYTES) {
+      version = sc_checkpoint_get (header + 8);
+      info[1] = (long long) sc_checkpoint_get (header + 16);
+      num_blocks = sc_checkpoint_get (header + 24);
+      info[2] = (long long) num_blocks;
+      info[3] = (long long) sc_checkpoint_get (header + 40);
+      if (memcmp (header, SC_CHECKPOINT_MAGIC, 8) ||
+          version != SC_CHECKPOINT_VERSION ||
+          info[1] <= 0 || info[1] > (long long) INT_MAX ||
+          num_blocks > (uint64_t) (INT_MAX / SC_CHECKPOINT_ENTRY_BYTES) ||
+          sc_checkpoint_get (header + 32) != SC_CHECKPOINT_HEADER_BYTES +
+          SC_CHECKPOINT_ENTRY_BYTES * num_blocks) {
+        retval = sc_MPI_ERR_IO;
+      }
+    }
+    else if (retval == sc_MPI_SUCCESS) {
+      retval = sc_MPI_ERR_IO;
+    }
+    if (retval == sc_MPI_SUCCESS) {
+      index = SC_ALLOC (char, SC_CHECKPOINT_ENTRY_BYTES * info[2]);
+      retval = sc_io_read_at (ckpt->file, SC_CHECKPOINT_HEADER_BYTES, index,
+                              (int) (SC_CHECKPOINT_ENTRY_BYTES * info[2]),
+                              sc_MPI_BYTE, &ocount);
+      if (retval == sc_MPI_SUCCESS &&
+          ocount != (int) (SC_CHECKPOINT_ENTRY_BYTES * info[2])) {
+        retval = sc_MPI_ERR_IO;
+      }
+    }
+    info[0] = retval;
+  }
+  mpiret = sc_MPI_Bcast (info, 4, sc_MPI_LONG_LONG_INT, 0, mpicomm);
+  SC_CHECK_MPI (mpiret);
+  retval = (int) info[0];
+
+  /* every process keeps the complete index */
+  if (retval == sc_MPI_SUCCESS) {
+    ckpt->num_writers = (int) info[1];
+    ckpt->num_blocks = (size_t) info[2];
+    if (rank != 0) {
+      index = SC_ALLOC (char, SC_CHECKPOINT_ENTRY_BYTES * info[2]);
+    }
+    mpiret = sc_MPI_Bcast (index, (int) (SC_CHECKPOINT_ENTRY_BYTES * info[2]),
+                           sc_MPI_BYTE, 0, mpicomm);
+    SC_CHECK_MPI (mpiret);
+    if (sc_checkpoint_parse (ckpt, index, (uint64_t) info[3])) {
+      retval = sc_MPI_ERR_IO;
+    }
+  }
+  SC_FREE (index);
+
+  if (retval != sc_MPI_SUCCESS) {
+    sc_io_close (&ckpt->file);
+    SC_FREE (ckpt->first);
+    SC_FREE (ckpt->entries);
+    SC_FREE (ckpt);
+    ckpt = NULL;
+  }
+  if (errcode != NULL) {
+    *errcode = retval;
+  }
+  return ckpt;
+}
+
+int
+sc_checkpoint_num_writers (sc_checkpoint_t * ckpt)
+{
+  SC_ASSERT (ckpt != NULL);
+
+  return ckpt->num_writers;
+}
+
+size_t
+sc_checkpoint_num_blocks (sc_checkpoint_t * ckpt)
+{
+  SC_ASSERT (ckpt != NULL);
+
+  return ckpt->num_blocks;
+}
+
+size_t
+sc_checkpoint_find (sc_checkpoint_t * ckpt, int writer, size_t local_index)
+{
+  SC_ASSERT (ckpt != NULL);
+
+  if (writer < 0 || writer >= ckpt->num_writers ||
+      local_index >= ckpt->first[writer + 1] - ckpt->first[writer]) {
+    return SC_CHECKPOINT_NONE;
+  }
+  return ckpt->first[writer] + local_index;
+}
+
+void
+sc_checkpoint_block_info (sc_checkpoint_t * ckpt, size_t block,
+                          int *writer, size_t *local_index,
+                          size_t *size, size_t *elem_size)
+{
+  sc_checkpoint_entry_t *e;
+
+  SC_ASSERT (ckpt != NULL);
+  SC_ASSERT (block < ckpt->num_blocks);
+
+  e = ckpt->entries + block;
+  if (writer != NULL) {
+    *writer = e->writer;
+  }
+  if (local_index != NULL) {
+    *local_index = e->local_index;
+  }
+  if (size != NULL) {
+    *size = e->size;
+  }
+  if (elem_size != NULL) {
+    *elem_size = e->elem_size;
+  }
+}
+
+int
+sc_checkpoint_read_block (sc_checkpoint_t * ckpt, size_t block,
+                          sc_array_t *out)
+{
+  int                 errcode, retval, ocount, count;
+  char               *ptr;
+  sc_MPI_Offset       offset;
+  sc_array_t         *enc;
+  sc_checkpoint_entry_t *e;
+
+  SC_ASSERT (ckpt != NULL);
+  SC_ASSERT (block == SC_CHECKPOINT_NONE || block < ckpt->num_blocks);
+
+  /* processes without a suitable block take part in the collective read */
+  e = NULL;
+  enc = NULL;
+  ptr = NULL;
+  offset = 0;
+  count = 0;
+  retval = sc_MPI_SUCCESS;
+  if (block != SC_CHECKPOINT_NONE) {
+    SC_ASSERT (out != NULL);
+    e = ckpt->entries + block;
+    if (!SC_ARRAY_IS_OWNER (out) || e->size % out->elem_size != 0) {
+      retval = sc_MPI_ERR_ARG;
+      e = NULL;
+    }
+    else if (e->format == 0) {
+      sc_array_resize (out, e->size / out->elem_size);
+      ptr = out->array;
+    }
+    else {
+      enc = sc_array_new_count (1, e->stored);
+      ptr = enc->array;
+    }
+    if (e != NULL) {
+      offset = e->offset;
+      count = (int) e->stored;
+    }
+  }
+  errcode = sc_io_read_at_all (ckpt->file, offset, ptr, count, sc_MPI_BYTE,
+                               &ocount);
+  if (e == NULL) {
+    return errcode != sc_MPI_SUCCESS ? errcode : retval;
+  }
+  if (errcode == sc_MPI_SUCCESS && ocount != count) {
+    errcode = sc_MPI_ERR_IO;
+  }
+
+  /* decode and verify the data */
+  if (errcode == sc_MPI_SUCCESS && enc != NULL &&
+      (enc->array[e->stored - 1] != '\0' ||
+       sc_io_decode (enc, out, e->size, NULL) ||
+       out->elem_count * out->elem_size != e->size)) {
+    errcode = sc_MPI_ERR_IO;
+  }
+  if (errcode == sc_MPI_SUCCESS && sc_array_checksum (out) != e->checksum) {
+    errcode = sc_MPI_ERR_IO;
+  }
+  if (enc != NULL) {
+    sc_array_destroy (enc);
+  }
+  return errcode;
+}
+
+int
+sc_checkpoint_close (sc_checkpoint_t * ckpt)
+{
+  int                 errcode;
+
+  SC_ASSERT (ckpt != NULL);
+
+  errcode = sc_io_close (&ckpt->file);
+  SC_FREE (ckpt->first);
+  SC_FREE (ckpt->entries);
+  SC_FREE (ckpt);
+  return errcode;
+}
@@ -0,0 +1,172 @@
+/*
+  This file is part of the SC Library.
+  The SC Library provides support for parallel scientific applications.
+
+  Copyright (C) 2010 The University of Texas System
+  Additional copyright (C) 2011 individual authors
+
+  The SC Library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  The SC Library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with the SC Library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+  02110-1301, USA.
+*/
+
+/** \file sc_checkpoint.h
+ * Self-describing parallel container for restart data.
+ *
+ * A checkpoint file holds any number of data blocks per writing process.
+ * It is written collectively in one call and read back block by block,
+ * such that a restart on a different number of processes reads exactly
+ * the blocks that it needs.  The file functions of \ref sc_io.h are used
+ * and the format does not depend on MPI I/O being available.
+ *
+ * The file begins with a header of \ref SC_CHECKPOINT_HEADER_BYTES bytes:
+ * the 8 bytes of \ref SC_CHECKPOINT_MAGIC, then the format version,
+ * the number of writing processes, the number of blocks, the offset
+ * of the first data byte, the total file size and two zero words.
+ * It is followed by the block index, one entry of
+ * \ref SC_CHECKPOINT_ENTRY_BYTES bytes per block in order of writing
+ * rank and local block number.  Each entry holds the writing rank, the
+ * local block number, the file offset and the stored size of the block,
+ * its original size and element size, the \ref sc_array_checksum of the
+ * original data and the storage format.  The blocks follow the index
+ * in the same order.  All numbers are 8-byte big-endian integers.
+ *
+ * A block is stored either as is, format 0, or encoded by
+ * \ref sc_io_encode_zlib, format 'z', whichever is smaller.
+ *
+ * \ingroup sc_io
+ */
+
+#ifndef SC_CHECKPOINT_H
+#define SC_CHECKPOINT_H
+
+#include <sc_io.h>
+
+/** The first 8 bytes of a checkpoint file including a terminating NUL. */
+#define SC_CHECKPOINT_MAGIC             "sc_ckpt"
+
+/** The version of the checkpoint format written by this library. */
+#define SC_CHECKPOINT_VERSION           1
+
+/** Size of the checkpoint file header in bytes. */
+#define SC_CHECKPOINT_HEADER_BYTES      64
+
+/** Size of one entry of the block index in bytes. */
+#define SC_CHECKPOINT_ENTRY_BYTES       64
+
+/** Block number passed by processes that do not read in a collective call. */
+#define SC_CHECKPOINT_NONE              ((size_t) -1)
+
+SC_EXTERN_C_BEGIN;
+
+/** Opaque checkpoint file opened for reading. */
+typedef struct sc_checkpoint sc_checkpoint_t;
+
+/** Write a checkpoint file collectively.
+ * Every process contributes its own number of blocks, which may be zero.
+ * The blocks are numbered in the file by writing rank and local index.
+ * \param [in] mpicomm      The communicator of the writing processes.
+ * \param [in] filename     Name of the file to create or overwrite.
+ * \param [in] blocks       Array of element size sizeof (sc_array_t).
+ *                          Each element is an array holding the data of one
+ *                          block with arbitrary element size.
+ * \param [in] compression_level    With 0 we store the data as is.
+ *                          Between 1 and 9 we encode each block by
+ *                          \ref sc_io_encode_zlib with this level and
+ *                          keep the result if it is smaller than the data.
+ * \return                  A sc_MPI_ERR_* as defined in \ref sc_mpi.h,
+ *                          the same on all processes.
+ */
+int                 sc_checkpoint_write (sc_MPI_Comm mpicomm,
+                                         const char *filename,
+                                         sc_array_t *blocks,
+                                         int compression_level);
+
+/** Open a checkpoint file collectively for reading.
+ * The first process reads and verifies the header and the index and
+ * broadcasts them.  The communicator may differ in size from the one
+ * that has written the file.
+ * \param [in] mpicomm      The communicator of the reading processes.
+ * \param [in] filename     Name of an existing checkpoint file.
+ * \param [out] errcode     If not NULL, set to a sc_MPI_ERR_* code.
+ *                          A malformed file yields \ref sc_MPI_ERR_IO.
+ * \return                  The opened checkpoint or NULL on error,
+ *                          consistently on all processes.
+ */
+sc_checkpoint_t    *sc_checkpoint_open (sc_MPI_Comm mpicomm,
+                                        const char *filename, int *errcode);
+
+/** Return the number of processes that have written the checkpoint.
+ * \param [in] ckpt         Checkpoint opened by \ref sc_checkpoint_open.
+ * \return                  The size of the writing communicator.
+ */
+int                 sc_checkpoint_num_writers (sc_checkpoint_t * ckpt);
+
+/** Return the total number of blocks in the checkpoint.
+ * \param [in] ckpt         Checkpoint opened by \ref sc_checkpoint_open.
+ * \return                  The sum of the block counts of all writers.
+ */
+size_t              sc_checkpoint_num_blocks (sc_checkpoint_t * ckpt);
+
+/** Find the global number of a block by its writer and local index.
+ * \param [in] ckpt         Checkpoint opened by \ref sc_checkpoint_open.
+ * \param [in] writer       Rank of the writing process.
+ * \param [in] local_index  Local number of the block on the writer.
+ * \return                  The global block number or
+ *                          \ref SC_CHECKPOINT_NONE if there is no such block.
+ */
+size_t              sc_checkpoint_find (sc_checkpoint_t * ckpt,
+                                        int writer, size_t local_index);
+
+/** Query the index entry of a block.  This function is not collective.
+ * \param [in] ckpt         Checkpoint opened by \ref sc_checkpoint_open.
+ * \param [in] block        Global block number less than the block count.
+ * \param [out] writer      If not NULL, the rank of the writing process.
+ * \param [out] local_index If not NULL, the local number on the writer.
+ * \param [out] size        If not NULL, the original size in bytes.
+ * \param [out] elem_size   If not NULL, the original element size.
+ */
+void                sc_checkpoint_block_info (sc_checkpoint_t * ckpt,
+                                              size_t block, int *writer,
+                                              size_t *local_index,
+                                              size_t *size,
+                                              size_t *elem_size);
+
+/** Read one block per process collectively.
+ * Only the stored bytes of the requested block are read from the file.
+ * The data is decoded if necessary and verified against its checksum.
+ * \param [in] ckpt         Checkpoint opened by \ref sc_checkpoint_open.
+ * \param [in] block        Global block number to read on this process,
+ *                          or \ref SC_CHECKPOINT_NONE to read nothing.
+ * \param [in,out] out      If \a block is not \ref SC_CHECKPOINT_NONE,
+ *                          a resizable array whose element size divides
+ *                          the block size.  It is resized to the data.
+ * \return                  A sc_MPI_ERR_* as defined in \ref sc_mpi.h.
+ *                          An unsuitable output array yields
+ *                          \ref sc_MPI_ERR_ARG and corrupt data
+ *                          \ref sc_MPI_ERR_IO.  Such errors
+ *                          are only reported on the affected process.
+ */
+int                 sc_checkpoint_read_block (sc_checkpoint_t * ckpt,
+                                              size_t block, sc_array_t *out);
+
+/** Close a checkpoint collectively and free its memory.
+ * \param [in] ckpt         Checkpoint opened by \ref sc_checkpoint_open.
+ * \return                  A sc_MPI_ERR_* as defined in \ref sc_mpi.h.
+ */
+int                 sc_checkpoint_close (sc_checkpoint_t * ckpt);
+
+SC_EXTERN_C_END;
+
+#endif /* !SC_CHECKPOINT_H */
@@ -22,17 +22,89 @@
 */
 
 #include <sc_containers.h>
+#include <sc_atomic.h>
+#include <sc_bitset.h>
+#include <sc_uint128.h>
+#include <sc_thread.h>
+#include <sc_io.h>
+#include <sc_sort.h>
 #ifdef SC_HAVE_ZLIB
 #include <zlib.h>
 #endif
-
-/* array routines */
+#ifdef SC_ENABLE_PTHREAD
+#include <pthread.h>
+#endif
+#if defined (__SSE2__)
+#include <emmintrin.h>
+#define SC_ARRAY_STREAM_SSE2
+#endif
+#ifdef SC_HAVE_SYS_MMAN_H
+#include <sys/mman.h>
+#if defined SC_HAVE_SYS_STAT_H && defined SC_HAVE_FCNTL_H && \
+    defined SC_HAVE_UNISTD_H
+#define SC_ARRAY_MMAP
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+#endif
 
 size_t
 sc_array_memory_used (sc_array_t * array, int is_dynamic)
 {
+  return sc_array_memory_used_ext (array, is_dynamic, NULL);
+}
+
+size_t
+sc_array_memory_used_ext (sc_array_t * array, int is_dynamic, size_t *slack)
+{
+  if (slack != NULL) {
+    *slack = SC_ARRAY_IS_OWNER (array) ?
+      (size_t) array->byte_alloc - array->elem_count * array->elem_size : 0;
+  }
   return (is_dynamic ? sizeof (sc_array_t) : 0) +
-    (SC_ARRAY_IS_OWNER (array) ? array->byte_alloc : 0);
+    (SC_ARRAY_IS_OWNER (array) ? array->byte_alloc : 0) +
+    (array->ext != NULL && array->ext->is_owned ?
+     sizeof (sc_array_ext_t) : 0);
+}
+
+/** Return the extension of an array, creating it if necessary. */
+static sc_array_ext_t *
+sc_array_ext_get (sc_array_t * array)
+{
+  if (array->ext == NULL) {
+    array->ext = SC_ALLOC (sc_array_ext_t, 1);
+    array->ext->allocator = NULL;
+    array->ext->policy = NULL;
+    array->ext->byte_reserve = 0;
+    array->ext->is_owned = 1;
+  }
+  return array->ext;
+}
+
+/** Free the extension of an array if it only holds default settings. */
+static void
+sc_array_ext_trim (sc_array_t * array)
+{
+  sc_array_ext_t     *ext = array->ext;
+
+  if (ext != NULL && ext->is_owned && ext->allocator == NULL &&
+      ext->policy == NULL && ext->byte_reserve == 0) {
+    SC_FREE (ext);
+    array->ext = NULL;
+  }
+}
+
+static inline const sc_array_allocator_t *
+sc_array_get_allocator (sc_array_t * array)
+{
+  return array->ext != NULL ? array->ext->allocator : NULL;
+}
+
+static inline size_t
+sc_array_get_reserve (sc_array_t * array)
+{
+  return array->ext != NULL ? array->ext->byte_reserve : 0;
 }
 
 sc_array_t         *
@@ -83,12 +155,226 @@ sc_array_new_data (void *base, size_t elem_size, size_t elem_count)
   return view;
 }
 
+/* array allocators */
+
+static void        *
+sc_array_default_alloc (size_t size, void *user)
+{
+  return SC_ALLOC (char, size);
+}
+
+static void        *
+sc_array_default_realloc (void *ptr, size_t old_size, size_t new_size,
+                          void *user)
+{
+  return SC_REALLOC (ptr, char, new_size);
+}
+
+static void
+sc_array_default_free (void *ptr, size_t size, void *user)
+{
+  SC_FREE (ptr);
+}
+
+const sc_array_allocator_t sc_array_allocator_default = {
+  sc_array_default_alloc, sc_array_default_realloc, sc_array_default_free,
+  NULL
+};
+
+#if defined SC_HAVE_POSIX_MEMALIGN && defined SC_HAVE_MADVISE && \
+  defined MADV_HUGEPAGE
+#define SC_ARRAY_HUGEPAGE
+#endif
+
+#ifdef SC_ARRAY_HUGEPAGE
+
+static const size_t sc_array_hugepage_size = (size_t) 1 << 21;
+
+static void        *
+sc_array_hugepage_alloc (size_t size, void *user)
+{
+  int                 err;
+  void               *ptr;
+
+  if (size < (size_t) user) {
+    return SC_ALLOC (char, size);
+  }
+  err = posix_memalign (&ptr, sc_array_hugepage_size, size);
+  SC_CHECK_ABORTF (err == 0, "Huge page allocation (size %llu)",
+                   (unsigned long long) size);
+
+  /* this is only a hint that may be ignored by the system */
+  (void) madvise (ptr, size, MADV_HUGEPAGE);
+  return ptr;
+}
+
+static void
+sc_array_hugepage_free (void *ptr, size_t size, void *user)
+{
+  if (size < (size_t) user) {
+    SC_FREE (ptr);
+  }
+  else {
+    free (ptr);
+  }
+}
+
+static void        *
+sc_array_hugepage_realloc (void *ptr, size_t old_size, size_t new_size,
+                           void *user)
+{
+  void               *ret;
+
+  if (old_size < (size_t) user && new_size < (size_t) user) {
+    return SC_REALLOC (ptr, char, new_size);
+  }
+  ret = sc_array_hugepage_alloc (new_size, user);
+  if (ptr != NULL) {
+    memcpy (ret, ptr, SC_MIN (old_size, new_size));
+    sc_array_hugepage_free (ptr, old_size, user);
+  }
+  return ret;
+}
+
+#endif /* SC_ARRAY_HUGEPAGE */
+
+/** Allocate memory whose address is a multiple of a power of two.
+ * The memory is not registered with the counters of libsc when
+ * posix_memalign is available; otherwise we allocate a larger block
+ * and store its address just before the aligned one.
+ */
+static void        *
+sc_aligned_alloc (size_t size, size_t alignment)
+{
+  void               *ptr;
+#ifdef SC_HAVE_POSIX_MEMALIGN
+  int                 err;
+#else
+  char               *base;
+#endif
+
+  SC_ASSERT (alignment > 0 && (alignment & (alignment - 1)) == 0);
+
+  alignment = SC_MAX (alignment, sizeof (void *));
+#ifdef SC_HAVE_POSIX_MEMALIGN
+  err = posix_memalign (&ptr, alignment, SC_MAX (size, 1));
+  SC_CHECK_ABORTF (err == 0, "Aligned allocation (size %llu)",
+                   (unsigned long long) size);
+#else
+  base = SC_ALLOC (char, size + alignment + sizeof (void *));
+  ptr = (void *) (((uintptr_t) (base + sizeof (void *)) + alignment - 1) &
+                  ~(uintptr_t) (alignment - 1));
+  ((void **) ptr)[-1] = base;
+#endif
+  return ptr;
+}
+
+/** Free memory obtained from \ref sc_aligned_alloc. */
+static void
+sc_aligned_free (void *ptr)
+{
+  if (ptr == NULL) {
+    return;
+  }
+#ifdef SC_HAVE_POSIX_MEMALIGN
+  free (ptr);
+#else
+  SC_FREE (((void **) ptr)[-1]);
+#endif
+}
+
+static void        *
+sc_array_aligned_alloc (size_t size, void *user)
+{
+  return sc_aligned_alloc (size, (size_t) user);
+}
+
+static void
+sc_array_aligned_free (void *ptr, size_t size, void *user)
+{
+  sc_aligned_free (ptr);
+}
+
+static void        *
+sc_array_aligned_realloc (void *ptr, size_t old_size, size_t new_size,
+                          void *user)
+{
+  void               *ret;
+
+  ret = sc_aligned_alloc (new_size, (size_t) user);
+  if (ptr != NULL) {
+    memcpy (ret, ptr, SC_MIN (old_size, new_size));
+    sc_aligned_free (ptr);
+  }
+  return ret;
+}
+
+/* one static allocator for every alignment of sc_array_new_aligned */
+#define SC_ARRAY_ALIGNED(l) { sc_array_aligned_alloc,                   \
+      sc_array_aligned_realloc, sc_array_aligned_free,                  \
+      (void *) ((size_t) 1 << (l)) }
+
+static const sc_array_allocator_t sc_array_allocators_aligned[] = {
+  SC_ARRAY_ALIGNED (0), SC_ARRAY_ALIGNED (1), SC_ARRAY_ALIGNED (2),
+  SC_ARRAY_ALIGNED (3), SC_ARRAY_ALIGNED (4), SC_ARRAY_ALIGNED (5),
+  SC_ARRAY_ALIGNED (6), SC_ARRAY_ALIGNED (7), SC_ARRAY_ALIGNED (8),
+  SC_ARRAY_ALIGNED (9), SC_ARRAY_ALIGNED (10), SC_ARRAY_ALIGNED (11),
+  SC_ARRAY_ALIGNED (12), SC_ARRAY_ALIGNED (13), SC_ARRAY_ALIGNED (14),
+  SC_ARRAY_ALIGNED (15), SC_ARRAY_ALIGNED (16), SC_ARRAY_ALIGNED (17),
+  SC_ARRAY_ALIGNED (18), SC_ARRAY_ALIGNED (19), SC_ARRAY_ALIGNED (20),
+  SC_ARRAY_ALIGNED (21)
+};
+
+void
+sc_array_allocator_aligned (sc_array_allocator_t * allocator,
+                            size_t alignment)
+{
+  SC_ASSERT (allocator != NULL);
+  SC_ASSERT (alignment > 0 && (alignment & (alignment - 1)) == 0);
+
+  allocator->alloc = sc_array_aligned_alloc;
+  allocator->realloc = sc_array_aligned_realloc;
+  allocator->free = sc_array_aligned_free;
+  allocator->user = (void *) alignment;
+}
+
+sc_array_t         *
+sc_array_new_aligned (size_t elem_size, size_t alignment)
+{
+  int                 l;
+  sc_array_t         *array;
+
+  SC_ASSERT (alignment > 0 && (alignment & (alignment - 1)) == 0);
+  SC_ASSERT (alignment <= SC_ARRAY_ALIGN_MAX);
+
+  for (l = 0; ((size_t) 1 << l) < alignment; ++l);
+  array = SC_ALLOC (sc_array_t, 1);
+  sc_array_init_allocator (array, elem_size,
+                           &sc_array_allocators_aligned[l]);
+
+  return array;
+}
+
+void
+sc_array_allocator_hugepage (sc_array_allocator_t * allocator,
+                             size_t threshold)
+{
+#ifdef SC_ARRAY_HUGEPAGE
+  allocator->alloc = sc_array_hugepage_alloc;
+  allocator->realloc = sc_array_hugepage_realloc;
+  allocator->free = sc_array_hugepage_free;
+  allocator->user = (void *) threshold;
+#else
+  *allocator = sc_array_allocator_default;
+#endif
+}
+
+/* array routines */
+
 void
 sc_array_destroy (sc_array_t * array)
 {
-  if (SC_ARRAY_IS_OWNER (array)) {
-    SC_FREE (array->array);
-  }
+  sc_array_reset (array);
   SC_FREE (array);
 }
 
@@ -111,6 +397,170 @@ sc_array_init (sc_array_t * array, size_t elem_size)
   array->elem_count = 0;
   array->byte_alloc = 0;
   array->array = NULL;
+  array->ext = NULL;
+}
+
+void
+sc_array_init_allocator (sc_array_t * array, size_t elem_size,
+                         const sc_array_allocator_t * allocator)
+{
+  sc_array_init (array, elem_size);
+  if (allocator != NULL) {
+    sc_array_ext_get (array)->allocator = allocator;
+  }
+}
+
+void
+sc_array_init_arena (sc_array_t * array, size_t elem_size,
+                     sc_arena_t * arena)
+{
+  SC_ASSERT (arena != NULL);
+
+  sc_array_init_allocator (array, elem_size, &arena->allocator);
+}
+
+/* file-backed array routines */
+
+struct sc_array_mmap
+{
+  int                 fd;       /**< the open file */
+  sc_array_t         *array;    /**< the array using the file or NULL */
+  sc_array_allocator_t allocator;       /**< maps the file */
+  sc_array_ext_t      ext;      /**< settings of the array */
+};
+
+#ifdef SC_ARRAY_MMAP
+
+/** Resize the file and map it entirely. */
+static void        *
+sc_array_mmap_map (sc_array_mmap_t * mm, size_t size)
+{
+  void               *ptr;
+
+  SC_CHECK_ABORTF (ftruncate (mm->fd, (off_t) size) == 0,
+                   "Resize of array file (size %llu)",
+                   (unsigned long long) size);
+  ptr = mmap (NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, mm->fd, 0);
+  SC_CHECK_ABORTF (ptr != MAP_FAILED, "Mapping of array file (size %llu)",
+                   (unsigned long long) size);
+  return ptr;
+}
+
+static void        *
+sc_array_mmap_alloc (size_t size, void *user)
+{
+  return sc_array_mmap_map ((sc_array_mmap_t *) user, size);
+}
+
+static void        *
+sc_array_mmap_realloc (void *ptr, size_t old_size, size_t new_size,
+                       void *user)
+{
+  /* the data is preserved in the file while it is not mapped */
+  SC_CHECK_ABORT (munmap (ptr, old_size) == 0, "Unmapping of array file");
+  return sc_array_mmap_map ((sc_array_mmap_t *) user, new_size);
+}
+
+static void
+sc_array_mmap_free (void *ptr, size_t size, void *user)
+{
+  /* the file keeps its length until the mapping is destroyed */
+  SC_CHECK_ABORT (munmap (ptr, size) == 0, "Unmapping of array file");
+}
+
+#endif /* SC_ARRAY_MMAP */
+
+sc_array_mmap_t    *
+sc_array_mmap_new (const char *filename)
+{
+#ifdef SC_ARRAY_MMAP
+  int                 fd;
+  const char         *tmpdir;
+  char                name[BUFSIZ];
+  sc_array_mmap_t    *mm;
+
+  if (filename == NULL) {
+    /* the file vanishes with its last descriptor */
+    tmpdir = getenv ("TMPDIR");
+    snprintf (name, BUFSIZ, "%s/sc_array_XXXXXX",
+              tmpdir != NULL && tmpdir[0] != '\0' ? tmpdir : "/tmp");
+    fd = mkstemp (name);
+    if (fd >= 0) {
+      (void) unlink (name);
+    }
+  }
+  else {
+    fd = open (filename, O_RDWR | O_CREAT, 0644);
+  }
+  if (fd < 0) {
+    return NULL;
+  }
+
+  mm = SC_ALLOC (sc_array_mmap_t, 1);
+  mm->fd = fd;
+  mm->array = NULL;
+  mm->allocator.alloc = sc_array_mmap_alloc;
+  mm->allocator.realloc = sc_array_mmap_realloc;
+  mm->allocator.free = sc_array_mmap_free;
+  mm->allocator.user = mm;
+  mm->ext.allocator = &mm->allocator;
+  mm->ext.policy = NULL;
+  mm->ext.byte_reserve = 0;
+  mm->ext.is_owned = 0;
+  return mm;
+#else
+  return NULL;
+#endif
+}
+
+void
+sc_array_mmap_destroy (sc_array_mmap_t * mm)
+{
+#ifdef SC_ARRAY_MMAP
+  size_t              used;
+  sc_array_t         *array = mm->array;
+
+  if (array != NULL && array->ext == &mm->ext) {
+    used = array->elem_count * array->elem_size;
+    if (array->array != NULL) {
+      SC_CHECK_ABORT (munmap (array->array, (size_t) array->byte_alloc) ==
+                      0, "Unmapping of array file");
+    }
+    SC_CHECK_ABORT (ftruncate (mm->fd, (off_t) used) == 0,
+                    "Truncation of array file");
+    sc_array_init (array, array->elem_size);
+  }
+  (void) close (mm->fd);
+#endif
+  SC_FREE (mm);
+}
+
+void
+sc_array_init_mmap (sc_array_t * array, size_t elem_size,
+                    sc_array_mmap_t * mm)
+{
+#ifdef SC_ARRAY_MMAP
+  size_t              size;
+  struct stat         st;
+
+  SC_ASSERT (mm != NULL && mm->array == NULL);
+
+  sc_array_init (array, elem_size);
+  array->ext = &mm->ext;
+  mm->array = array;
+
+  /* an existing file provides the initial elements */
+  SC_CHECK_ABORT (fstat (mm->fd, &st) == 0, "Status of array file");
+  size = (size_t) st.st_size;
+  if (size > 0) {
+    SC_CHECK_ABORT (size % elem_size == 0, "Size of array file");
+    array->array = (char *) sc_array_mmap_map (mm, size);
+    array->byte_alloc = (ssize_t) size;
+    array->elem_count = size / elem_size;
+  }
+#else
+  SC_ABORT ("Memory mapped arrays are not available");
+#endif
 }
 
 void
@@ -128,6 +578,7 @@ sc_array_init_count (sc_array_t * array, size_t elem_size, size_t elem_count)
   array->elem_count = elem_count;
   array->byte_alloc = (ssize_t) (elem_size * elem_count);
   array->array = SC_ALLOC (char, (size_t) array->byte_alloc);
+  array->ext = NULL;
 }
 
 void
@@ -140,6 +591,7 @@ sc_array_init_view (sc_array_t * view, sc_array_t * array, size_t offset,
   view->elem_count = length;
   view->byte_alloc = -(ssize_t) (length * array->elem_size + 1);
   view->array = array->array + offset * array->elem_size;
+  view->ext = NULL;
 }
 
 void
@@ -164,6 +616,7 @@ sc_array_init_data (sc_array_t * view, void *base, size_t elem_size,
   view->elem_count = elem_count;
   view->byte_alloc = -(ssize_t) (elem_count * elem_size + 1);
   view->array = (char *) base;
+  view->ext = NULL;
 }
 
 void
@@ -172,16 +625,42 @@ sc_array_memset (sc_array_t * array, int c)
   memset (array->array, c, array->elem_count * array->elem_size);
 }
 
-void
-sc_array_reset (sc_array_t * array)
+/** Free the memory of an array and cancel its reservation.
+ * The allocator and growth policy are kept. */
+static void
+sc_array_free_data (sc_array_t * array)
 {
+  const sc_array_allocator_t *allocator = sc_array_get_allocator (array);
+
   if (SC_ARRAY_IS_OWNER (array)) {
-    SC_FREE (array->array);
+    if (allocator != NULL) {
+      if (array->array != NULL) {
+        allocator->free (array->array, (size_t) array->byte_alloc,
+                         allocator->user);
+      }
+    }
+    else {
+      SC_FREE (array->array);
+    }
   }
   array->array = NULL;
 
   array->elem_count = 0;
   array->byte_alloc = 0;
+  if (array->ext != NULL) {
+    array->ext->byte_reserve = 0;
+    sc_array_ext_trim (array);
+  }
+}
+
+void
+sc_array_reset (sc_array_t * array)
+{
+  sc_array_free_data (array);
+  if (array->ext != NULL && array->ext->is_owned) {
+    SC_FREE (array->ext);
+    array->ext = NULL;
+  }
 }
 
 void
@@ -204,23 +683,96 @@ sc_array_rewind (sc_array_t * array, size_t new_count)
   SC_ASSERT (array->elem_count >= new_count);
 
   if (new_count == 0 && SC_ARRAY_IS_OWNER (array)) {
-    sc_array_reset (array);
+    sc_array_free_data (array);
   }
   else {
     array->elem_count = new_count;
   }
 }
 
-void
-sc_array_resize (sc_array_t * array, size_t new_count)
+/** Return the allocation in bytes for newoffs bytes of elements.
+ * This is the current allocation if the growth policy keeps it.
+ */
+static size_t
+sc_array_policy_alloc (sc_array_t * array, size_t newoffs)
 {
-  size_t              newoffs, roundup, newsize;
-#if !defined SC_ENABLE_USE_REALLOC || defined SC_ENABLE_DEBUG
-  size_t              oldoffs, minoffs;
-#endif
+  size_t              oldalloc = (size_t) array->byte_alloc;
+  size_t              roundup, slack, page, target;
+  const sc_array_policy_t *policy =
+    array->ext != NULL ? array->ext->policy : NULL;
+
+  if (policy == NULL) {
+    roundup = (size_t) SC_ROUNDUP2_64 (newoffs);
+    SC_ASSERT (roundup >= newoffs && roundup <= 2 * newoffs);
+    target = (newoffs > oldalloc || roundup < oldalloc) ? roundup : oldalloc;
+  }
+  else {
+    SC_ASSERT (policy->growth > 1.);
+    slack = (size_t) ((policy->growth - 1.) * (double) newoffs);
+    if (policy->max_slack > 0) {
+      slack = SC_MIN (slack, policy->max_slack);
+    }
+    page = (policy->page_bytes > 0 && newoffs + slack >= policy->page_bytes) ?
+      policy->page_bytes : 0;
+    if (newoffs > oldalloc || oldalloc - newoffs > 2 * slack + page) {
+      target = SC_ALIGN_UP (newoffs + slack, page);
+    }
+    else {
+      target = oldalloc;
+    }
+  }
+
+  /* never shrink below a reservation */
+  return SC_MAX (target, sc_array_get_reserve (array));
+}
+
+/** Reallocate the memory of an array that is not a view.
+ * \param [in,out] array    Its allocation is set to newsize bytes.
+ * \param [in] newsize      New allocation, positive.
+ * \param [in] keepoffs     Number of leading bytes to preserve.
+ */
+static void
+sc_array_realloc_bytes (sc_array_t * array, size_t newsize, size_t keepoffs)
+{
+  size_t              oldalloc = (size_t) array->byte_alloc;
+  const sc_array_allocator_t *allocator = sc_array_get_allocator (array);
 #ifndef SC_ENABLE_USE_REALLOC
   char               *ptr;
 #endif
+
+  SC_ASSERT (SC_ARRAY_IS_OWNER (array));
+  SC_ASSERT (newsize > 0 && keepoffs <= newsize && keepoffs <= oldalloc);
+
+  if (allocator != NULL) {
+    array->array = (char *) (array->array == NULL ?
+                             allocator->alloc (newsize, allocator->user) :
+                             allocator->realloc (array->array, oldalloc,
+                                                 newsize, allocator->user));
+  }
+  else {
+#ifdef SC_ENABLE_USE_REALLOC
+    array->array = SC_REALLOC (array->array, char, newsize);
+#else
+    ptr = SC_ALLOC (char, newsize);
+    if (keepoffs > 0) {
+      /* avoid calling memcpy on less well supported corner cases */
+      memcpy (ptr, array->array, keepoffs);
+    }
+    SC_FREE (array->array);
+    array->array = ptr;
+#endif
+  }
+  array->byte_alloc = (ssize_t) newsize;
+
+#ifdef SC_ENABLE_DEBUG
+  memset (array->array + keepoffs, -1, newsize - keepoffs);
+#endif
+}
+
+void
+sc_array_resize (sc_array_t * array, size_t new_count)
+{
+  size_t              newoffs, oldoffs, newalloc;
 #ifdef SC_ENABLE_DEBUG
   size_t              i;
 #endif
@@ -234,28 +786,20 @@ sc_array_resize (sc_array_t * array, size_t new_count)
     return;
   }
 
-  /* We know that this array is not a view now so we can call reset. */
-  if (new_count == 0) {
-    sc_array_reset (array);
+  /* We know that this array is not a view now so we can free it. */
+  if (new_count == 0 && sc_array_get_reserve (array) == 0) {
+    sc_array_free_data (array);
     return;
   }
 
   /* Figure out how the array size will change */
   newoffs = new_count * array->elem_size;
-#if defined SC_ENABLE_DEBUG || !defined SC_ENABLE_USE_REALLOC
   oldoffs = array->elem_count * array->elem_size;
-  minoffs = SC_MIN (oldoffs, newoffs);
-#endif
   array->elem_count = new_count;
-  roundup = (size_t) SC_ROUNDUP2_64 (newoffs);
-  SC_ASSERT (roundup >= newoffs && roundup <= 2 * newoffs);
+  newalloc = sc_array_policy_alloc (array, newoffs);
+  SC_ASSERT (newalloc >= newoffs);
 
-  if (newoffs > (size_t) array->byte_alloc ||
-      roundup < (size_t) array->byte_alloc) {
-    /* we will reallocate the array memory, either grow or shrink it */
-    array->byte_alloc = (ssize_t) roundup;
-  }
-  else {
+  if (newalloc == (size_t) array->byte_alloc) {
 #ifdef SC_ENABLE_DEBUG
     if (newoffs < oldoffs) {
       memset (array->array + newoffs, -1, oldoffs - newoffs);
@@ -268,42 +812,167 @@ sc_array_resize (sc_array_t * array, size_t new_count)
     return;
   }
 
-  /* byte_alloc is the size to be realloced to, it may be smaller than oldoffs */
-  SC_ASSERT ((size_t) array->byte_alloc >= newoffs);
+  /* we reallocate the array memory, either grow or shrink it */
+  sc_array_realloc_bytes (array, newalloc, SC_MIN (oldoffs, newoffs));
+}
 
-  newsize = (size_t) array->byte_alloc;
-#ifdef SC_ENABLE_USE_REALLOC
-  array->array = SC_REALLOC (array->array, char, newsize);
-#else
-  ptr = SC_ALLOC (char, newsize);
-  if (minoffs > 0) {
-    /* avoid calling memcpy on less well supported corner cases */
-    memcpy (ptr, array->array, minoffs);
-  }
-  SC_FREE (array->array);
-  array->array = ptr;
-#endif
+void
+sc_array_set_policy (sc_array_t * array, const sc_array_policy_t * policy)
+{
+  SC_ASSERT (SC_ARRAY_IS_OWNER (array));
+  SC_ASSERT (policy == NULL || policy->growth > 1.);
 
-#ifdef SC_ENABLE_DEBUG
-  SC_ASSERT (minoffs <= newsize);
-  memset (array->array + minoffs, -1, newsize - minoffs);
-#endif
+  if (policy != NULL) {
+    sc_array_ext_get (array)->policy = policy;
+  }
+  else if (array->ext != NULL) {
+    array->ext->policy = NULL;
+    sc_array_ext_trim (array);
+  }
 }
 
 void
-sc_array_copy (sc_array_t * dest, sc_array_t * src)
+sc_array_reserve (sc_array_t * array, size_t elem_count)
 {
-  SC_ASSERT (SC_ARRAY_IS_OWNER (dest));
-  SC_ASSERT (dest->elem_size == src->elem_size);
+  size_t              bytes = elem_count * array->elem_size;
 
-  /* always resize the destination array as documented */
-  sc_array_resize (dest, src->elem_count);
+  SC_ASSERT (SC_ARRAY_IS_OWNER (array));
+
+  if (bytes > sc_array_get_reserve (array)) {
+    sc_array_ext_get (array)->byte_reserve = bytes;
+  }
+  if (bytes > (size_t) array->byte_alloc) {
+    sc_array_realloc_bytes (array, bytes,
+                            array->elem_count * array->elem_size);
+  }
+}
+
+void
+sc_array_shrink_to_fit (sc_array_t * array)
+{
+  size_t              offs = array->elem_count * array->elem_size;
+
+  SC_ASSERT (SC_ARRAY_IS_OWNER (array));
+
+  if (array->ext != NULL) {
+    array->ext->byte_reserve = 0;
+    sc_array_ext_trim (array);
+  }
+  if (offs == 0) {
+    sc_array_free_data (array);
+  }
+  else if (offs != (size_t) array->byte_alloc) {
+    sc_array_realloc_bytes (array, offs, offs);
+  }
+}
+
+size_t              sc_array_stream_bytes = SC_ARRAY_STREAM_BYTES;
+
+/** Copy bytes, bypassing the caches if \a stream is true and we can. */
+static void
+sc_array_memcpy_ext (char *dest, const char *src, size_t n, int stream)
+{
+#ifdef SC_ARRAY_STREAM_SSE2
+  size_t              head;
+  __m128i             a, b, c, d;
+
+  if (stream && n >= 128) {
+    /* the streaming stores require an aligned destination */
+    head = (size_t) (-(uintptr_t) dest) & 15;
+    memcpy (dest, src, head);
+    dest += head;
+    src += head;
+    n -= head;
+    for (; n >= 64; n -= 64, dest += 64, src += 64) {
+      a = _mm_loadu_si128 ((const __m128i *) src);
+      b = _mm_loadu_si128 ((const __m128i *) src + 1);
+      c = _mm_loadu_si128 ((const __m128i *) src + 2);
+      d = _mm_loadu_si128 ((const __m128i *) src + 3);
+      _mm_stream_si128 ((__m128i *) dest, a);
+      _mm_stream_si128 ((__m128i *) dest + 1, b);
+      _mm_stream_si128 ((__m128i *) dest + 2, c);
+      _mm_stream_si128 ((__m128i *) dest + 3, d);
+    }
+    /* order the streaming stores before any later store */
+    _mm_sfence ();
+  }
+#endif
+  memcpy (dest, src, n);
+}
+
+/** Copy bytes, bypassing the caches above \ref sc_array_stream_bytes. */
+static void
+sc_array_memcpy (char *dest, const char *src, size_t n)
+{
+  sc_array_memcpy_ext (dest, src, n, n >= sc_array_stream_bytes);
+}
+
+void
+sc_array_copy (sc_array_t * dest, sc_array_t * src)
+{
+  SC_ASSERT (SC_ARRAY_IS_OWNER (dest));
+  SC_ASSERT (dest->elem_size == src->elem_size);
+
+  /* always resize the destination array as documented */
+  sc_array_resize (dest, src->elem_count);
 
   if (src->elem_count == 0 || src->elem_size == 0) {
     /* avoid calling memcpy on less well supported corner cases */
     return;
   }
-  memcpy (dest->array, src->array, src->elem_count * src->elem_size);
+  sc_array_memcpy (dest->array, src->array, src->elem_count * src->elem_size);
+}
+
+/** State shared by the threads of \ref sc_array_copy_parallel. */
+typedef struct sc_array_copy_parallel
+{
+  char               *dest;
+  const char         *src;
+  size_t              bytes;
+  int                 stream;
+}
+sc_array_copy_parallel_t;
+
+static void
+sc_array_copy_parallel_chunk (int thread_id, int num_threads, void *user)
+{
+  sc_array_copy_parallel_t *cpt = (sc_array_copy_parallel_t *) user;
+  size_t              lo, hi;
+
+  /* cut at multiples of 64 bytes to keep the cache lines of threads apart */
+  lo = cpt->bytes / 64 * thread_id / num_threads * 64;
+  hi = thread_id == num_threads - 1 ? cpt->bytes :
+    cpt->bytes / 64 * (thread_id + 1) / num_threads * 64;
+  sc_array_memcpy_ext (cpt->dest + lo, cpt->src + lo, hi - lo, cpt->stream);
+}
+
+void
+sc_array_copy_parallel (sc_array_t * dest, sc_array_t * src, int num_threads)
+{
+  size_t              T;
+  sc_array_copy_parallel_t cpt;
+
+  SC_ASSERT (SC_ARRAY_IS_OWNER (dest));
+  SC_ASSERT (dest->elem_size == src->elem_size);
+
+  sc_array_resize (dest, src->elem_count);
+  cpt.dest = dest->array;
+  cpt.src = src->array;
+  cpt.bytes = src->elem_count * src->elem_size;
+  cpt.stream = cpt.bytes >= sc_array_stream_bytes;
+  if (cpt.bytes == 0) {
+    return;
+  }
+
+  if (num_threads <= 0) {
+    num_threads = sc_thread_default_count ();
+  }
+  T = SC_MIN ((size_t) num_threads, cpt.bytes / SC_ARRAY_COPY_PARALLEL_MIN);
+  if (T <= 1) {
+    sc_array_memcpy_ext (cpt.dest, cpt.src, cpt.bytes, cpt.stream);
+    return;
+  }
+  sc_thread_fork_join ((int) T, sc_array_copy_parallel_chunk, &cpt);
 }
 
 void
@@ -316,14 +985,18 @@ sc_array_copy_into (sc_array_t * dest, size_t dest_offset, sc_array_t * src)
     /* avoid calling memcpy on less well supported corner cases */
     return;
   }
-  memcpy (dest->array + dest_offset * dest->elem_size,
-          src->array, src->elem_count * src->elem_size);
+  sc_array_memcpy (dest->array + dest_offset * dest->elem_size,
+                   src->array, src->elem_count * src->elem_size);
 }
 
 void
 sc_array_move_part (sc_array_t * dest, size_t dest_offset,
                     sc_array_t * src, size_t src_offset, size_t count)
 {
+  char               *d;
+  const char         *s;
+  size_t              bytes;
+
   SC_ASSERT (dest->elem_size == src->elem_size);
   SC_ASSERT (dest_offset + count <= dest->elem_count);
   SC_ASSERT (src_offset + count <= src->elem_count);
@@ -332,8 +1005,15 @@ sc_array_move_part (sc_array_t * dest, size_t dest_offset,
     /* avoid calling memmove on less well supported corner cases */
     return;
   }
-  memmove (dest->array + dest_offset * dest->elem_size,
-           src->array + src_offset * src->elem_size, count * src->elem_size);
+  d = dest->array + dest_offset * dest->elem_size;
+  s = src->array + src_offset * src->elem_size;
+  bytes = count * src->elem_size;
+  if (bytes >= sc_array_stream_bytes && (d + bytes <= s || s + bytes <= d)) {
+    /* disjoint ranges may be copied with streaming stores */
+    sc_array_memcpy_ext (d, s, bytes, 1);
+    return;
+  }
+  memmove (d, s, bytes);
 }
 
 void
@@ -342,6 +1022,93 @@ sc_array_sort (sc_array_t * array, int (*compar) (const void *, const void *))
   qsort (array->array, array->elem_count, array->elem_size, compar);
 }
 
+/** Return the 8 bit digit d of the radix sort key of an element. */
+static inline unsigned
+sc_array_radix_digit (const char *key, size_t key_width, size_t d)
+{
+  uint32_t            k32;
+  uint64_t            k64;
+  sc_uint128_t        k128;
+
+  switch (key_width) {
+  case sizeof (uint32_t):
+    memcpy (&k32, key, sizeof (uint32_t));
+    return (unsigned) (k32 >> (8 * d)) & 0xff;
+  case sizeof (uint64_t):
+    memcpy (&k64, key, sizeof (uint64_t));
+    return (unsigned) (k64 >> (8 * d)) & 0xff;
+  default:
+    SC_ASSERT (key_width == sizeof (sc_uint128_t));
+    memcpy (&k128, key, sizeof (sc_uint128_t));
+    k64 = d < 8 ? k128.low_bits : k128.high_bits;
+    return (unsigned) (k64 >> (8 * (d % 8))) & 0xff;
+  }
+}
+
+void
+sc_array_sort_radix (sc_array_t * array, size_t key_offset,
+                     size_t key_width,
+                     int (*compar) (const void *, const void *))
+{
+  const size_t        count = array->elem_count;
+  const size_t        size = array->elem_size;
+  size_t              zz, d, pos, sum;
+  size_t             *counts, *c;
+  char               *src, *dest, *temp, *buffer;
+
+  SC_ASSERT (key_offset + key_width <= size);
+
+  if (key_width != sizeof (uint32_t) && key_width != sizeof (uint64_t) &&
+      key_width != sizeof (sc_uint128_t)) {
+    SC_ASSERT (compar != NULL);
+    sc_array_sort (array, compar);
+    return;
+  }
+  if (count <= 1) {
+    return;
+  }
+
+  /* count the occurrences of all digits in a single pass */
+  counts = SC_ALLOC_ZERO (size_t, 256 * key_width);
+  src = array->array;
+  for (zz = 0; zz < count; ++zz) {
+    for (d = 0; d < key_width; ++d) {
+      ++counts[256 * d +
+               sc_array_radix_digit (src + zz * size + key_offset,
+                                     key_width, d)];
+    }
+  }
+
+  /* sort by one digit after the other, least significant first */
+  buffer = SC_ALLOC (char, count * size);
+  dest = buffer;
+  for (d = 0; d < key_width; ++d) {
+    c = counts + 256 * d;
+    if (c[sc_array_radix_digit (src + key_offset, key_width, d)] == count) {
+      /* all keys share this digit */
+      continue;
+    }
+    for (sum = 0, zz = 0; zz < 256; ++zz) {
+      pos = c[zz];
+      c[zz] = sum;
+      sum += pos;
+    }
+    for (zz = 0; zz < count; ++zz) {
+      pos = c[sc_array_radix_digit (src + zz * size + key_offset,
+                                    key_width, d)]++;
+      memcpy (dest + pos * size, src + zz * size, size);
+    }
+    temp = src;
+    src = dest;
+    dest = temp;
+  }
+  if (src != array->array) {
+    memcpy (array->array, src, count * size);
+  }
+  SC_FREE (buffer);
+  SC_FREE (counts);
+}
+
 int
 sc_array_is_sorted (sc_array_t * array,
                     int (*compar) (const void *, const void *))
@@ -416,6 +1183,338 @@ sc_array_uniq (sc_array_t * array, int (*compar) (const void *, const void *))
   sc_array_resize (array, j);
 }
 
+/** The number of threads for a parallel operation on count entries. */
+static size_t
+sc_array_set_threads (size_t count, int num_threads)
+{
+  size_t              T;
+
+  if (num_threads <= 0) {
+    num_threads = sc_thread_default_count ();
+  }
+  T = SC_MIN ((size_t) num_threads, count / SC_ARRAY_SET_PARALLEL_MIN);
+  return SC_MAX (T, 1);
+}
+
+/** State shared by the threads of \ref sc_array_uniq_parallel. */
+typedef struct sc_array_uniq_parallel
+{
+  sc_array_t         *array;
+  int                 (*compar) (const void *, const void *);
+  size_t              num_chunks;
+  size_t             *offsets;  /**< kept entries, then write positions */
+  char               *output;   /**< NULL in the counting pass */
+}
+sc_array_uniq_parallel_t;
+
+static void
+sc_array_uniq_parallel_chunk (int thread_id, int num_threads, void *user)
+{
+  sc_array_uniq_parallel_t *upt = (sc_array_uniq_parallel_t *) user;
+  const size_t        n = upt->array->elem_count;
+  const size_t        size = upt->array->elem_size;
+  const char         *base = upt->array->array;
+  size_t              c, zz, lo, hi, kept;
+
+  for (c = (size_t) thread_id; c < upt->num_chunks;
+       c += (size_t) num_threads) {
+    lo = c * n / upt->num_chunks;
+    hi = (c + 1) * n / upt->num_chunks;
+    kept = 0;
+    for (zz = lo; zz < hi; ++zz) {
+      /* keep the first entry of each run of equal entries */
+      if (zz == 0 ||
+          upt->compar (base + (zz - 1) * size, base + zz * size) != 0) {
+        if (upt->output != NULL) {
+          memcpy (upt->output + (upt->offsets[c] + kept) * size,
+                  base + zz * size, size);
+        }
+        ++kept;
+      }
+    }
+    if (upt->output == NULL) {
+      upt->offsets[c + 1] = kept;
+    }
+  }
+}
+
+void
+sc_array_uniq_parallel (sc_array_t * array,
+                        int (*compar) (const void *, const void *),
+                        int num_threads)
+{
+  size_t              T, c;
+  sc_array_uniq_parallel_t upt;
+
+  SC_ASSERT (SC_ARRAY_IS_OWNER (array));
+
+  T = sc_array_set_threads (array->elem_count, num_threads);
+  if (T == 1) {
+    sc_array_uniq (array, compar);
+    return;
+  }
+
+  /* count the kept entries of each chunk and turn them into offsets */
+  upt.array = array;
+  upt.compar = compar;
+  upt.num_chunks = T;
+  upt.offsets = SC_ALLOC_ZERO (size_t, T + 1);
+  upt.output = NULL;
+  sc_thread_fork_join ((int) T, sc_array_uniq_parallel_chunk, &upt);
+  for (c = 0; c < T; ++c) {
+    upt.offsets[c + 1] += upt.offsets[c];
+  }
+
+  /* compact out of place since chunks would overwrite their neighbors */
+  upt.output = SC_ALLOC (char, upt.offsets[T] * array->elem_size);
+  sc_thread_fork_join ((int) T, sc_array_uniq_parallel_chunk, &upt);
+  memcpy (array->array, upt.output, upt.offsets[T] * array->elem_size);
+  sc_array_resize (array, upt.offsets[T]);
+  SC_FREE (upt.output);
+  SC_FREE (upt.offsets);
+}
+
+/** The sorted-set operations. */
+typedef enum sc_array_set_op
+{
+  SC_ARRAY_SET_MERGE,
+  SC_ARRAY_SET_INTERSECT,
+  SC_ARRAY_SET_DIFFERENCE
+}
+sc_array_set_op_t;
+
+/** Return the first index in [lo, hi) whose entry is not less than key,
+ * or hi.  We probe lo, lo + 1, lo + 3, lo + 7 and so on, and search the
+ * last interval by bisection, which is fast for a short distance. */
+static size_t
+sc_array_gallop (const char *base, size_t size, size_t lo, size_t hi,
+                 const void *key, int (*compar) (const void *, const void *))
+{
+  size_t              step, probe, mid;
+
+  step = 1;
+  probe = lo;
+  while (probe < hi && compar (base + probe * size, key) < 0) {
+    lo = probe + 1;
+    probe = lo + step;
+    step *= 2;
+  }
+  hi = SC_MIN (probe, hi);
+
+  /* the answer lies in [lo, hi] */
+  while (lo < hi) {
+    mid = lo + (hi - lo) / 2;
+    if (compar (base + mid * size, key) < 0) {
+      lo = mid + 1;
+    }
+    else {
+      hi = mid;
+    }
+  }
+  return lo;
+}
+
+/** Apply a set operation to the ranges [alo, ahi) of a and [blo, bhi) of b.
+ * If out is NULL, only count the output entries.
+ * \return          The number of output entries.
+ */
+static size_t
+sc_array_set_kernel (sc_array_set_op_t op, const char *a, size_t alo,
+                     size_t ahi, const char *b, size_t blo, size_t bhi,
+                     size_t size, int (*compar) (const void *, const void *),
+                     char *out)
+{
+  int                 cmp;
+  size_t              k, n;
+
+  n = 0;
+  while (alo < ahi && blo < bhi) {
+    cmp = compar (a + alo * size, b + blo * size);
+    if (cmp < 0) {
+      /* a run of a is less than the next entry of b */
+      k = sc_array_gallop (a, size, alo + 1, ahi, b + blo * size, compar);
+      if (op != SC_ARRAY_SET_INTERSECT) {
+        if (out != NULL) {
+          memcpy (out + n * size, a + alo * size, (k - alo) * size);
+        }
+        n += k - alo;
+      }
+      alo = k;
+    }
+    else if (cmp > 0) {
+      /* a run of b is less than the next entry of a */
+      k = sc_array_gallop (b, size, blo + 1, bhi, a + alo * size, compar);
+      if (op == SC_ARRAY_SET_MERGE) {
+        if (out != NULL) {
+          memcpy (out + n * size, b + blo * size, (k - blo) * size);
+        }
+        n += k - blo;
+      }
+      blo = k;
+    }
+    else {
+      if (op != SC_ARRAY_SET_DIFFERENCE) {
+        if (out != NULL) {
+          memcpy (out + n * size, a + alo * size, size);
+        }
+        ++n;
+      }
+      ++alo;
+      ++blo;
+    }
+  }
+
+  /* copy the remainders */
+  if (op != SC_ARRAY_SET_INTERSECT && alo < ahi) {
+    if (out != NULL) {
+      memcpy (out + n * size, a + alo * size, (ahi - alo) * size);
+    }
+    n += ahi - alo;
+  }
+  if (op == SC_ARRAY_SET_MERGE && blo < bhi) {
+    if (out != NULL) {
+      memcpy (out + n * size, b + blo * size, (bhi - blo) * size);
+    }
+    n += bhi - blo;
+  }
+  return n;
+}
+
+/** State shared by the threads of a sorted-set operation.
+ * Chunk c covers [acut[c], acut[c + 1]) of a and [bcut[c], bcut[c + 1])
+ * of b and writes its output from offsets[c] on. */
+typedef struct sc_array_set_parallel
+{
+  sc_array_set_op_t   op;
+  sc_array_t         *a, *b;
+  int                 (*compar) (const void *, const void *);
+  size_t              num_chunks;
+  size_t             *acut, *bcut, *offsets;
+  char               *output;   /**< NULL in the counting pass */
+}
+sc_array_set_parallel_t;
+
+static void
+sc_array_set_parallel_chunk (int thread_id, int num_threads, void *user)
+{
+  sc_array_set_parallel_t *spt = (sc_array_set_parallel_t *) user;
+  const size_t        size = spt->a->elem_size;
+  size_t              c, n;
+
+  for (c = (size_t) thread_id; c < spt->num_chunks;
+       c += (size_t) num_threads) {
+    n = sc_array_set_kernel (spt->op, spt->a->array, spt->acut[c],
+                             spt->acut[c + 1], spt->b->array, spt->bcut[c],
+                             spt->bcut[c + 1], size, spt->compar,
+                             spt->output == NULL ? NULL :
+                             spt->output + spt->offsets[c] * size);
+    if (spt->output == NULL) {
+      spt->offsets[c + 1] = n;
+    }
+  }
+}
+
+static void
+sc_array_set_operation (sc_array_set_op_t op, sc_array_t * dest,
+                        sc_array_t * a, sc_array_t * b,
+                        int (*compar) (const void *, const void *),
+                        int num_threads)
+{
+  const size_t        size = a->elem_size;
+  size_t              T, c, n;
+  size_t             *lcut, *scut;
+  sc_array_t         *large, *small;
+  sc_array_set_parallel_t spt;
+
+  SC_ASSERT (b->elem_size == size && dest->elem_size == size);
+  SC_ASSERT (dest != a && dest != b);
+  SC_ASSERT (sc_array_is_sorted (a, compar) && sc_array_is_sorted (b, compar));
+
+  T = sc_array_set_threads (a->elem_count + b->elem_count, num_threads);
+  if (T == 1) {
+    /* write into room for the largest possible output */
+    n = op == SC_ARRAY_SET_MERGE ? a->elem_count + b->elem_count :
+      op == SC_ARRAY_SET_INTERSECT ? SC_MIN (a->elem_count, b->elem_count) :
+      a->elem_count;
+    sc_array_resize (dest, n);
+    n = sc_array_set_kernel (op, a->array, 0, a->elem_count, b->array, 0,
+                             b->elem_count, size, compar, dest->array);
+    sc_array_resize (dest, n);
+    return;
+  }
+
+  /* cut the larger input evenly and the smaller one at the same keys */
+  spt.op = op;
+  spt.a = a;
+  spt.b = b;
+  spt.compar = compar;
+  spt.num_chunks = T;
+  spt.acut = SC_ALLOC (size_t, 3 * (T + 1));
+  spt.bcut = spt.acut + (T + 1);
+  spt.offsets = spt.bcut + (T + 1);
+  if (a->elem_count >= b->elem_count) {
+    large = a;
+    small = b;
+    lcut = spt.acut;
+    scut = spt.bcut;
+  }
+  else {
+    large = b;
+    small = a;
+    lcut = spt.bcut;
+    scut = spt.acut;
+  }
+  lcut[0] = scut[0] = 0;
+  for (c = 1; c < T; ++c) {
+    lcut[c] = c * large->elem_count / T;
+    scut[c] = sc_array_gallop (small->array, size, scut[c - 1],
+                               small->elem_count,
+                               large->array + lcut[c] * size, compar);
+  }
+  lcut[T] = large->elem_count;
+  scut[T] = small->elem_count;
+
+  /* count the output of each chunk and write it at the prefix sums */
+  spt.offsets[0] = 0;
+  spt.output = NULL;
+  sc_thread_fork_join ((int) T, sc_array_set_parallel_chunk, &spt);
+  for (c = 0; c < T; ++c) {
+    spt.offsets[c + 1] += spt.offsets[c];
+  }
+  sc_array_resize (dest, spt.offsets[T]);
+  if (spt.offsets[T] > 0) {
+    spt.output = dest->array;
+    sc_thread_fork_join ((int) T, sc_array_set_parallel_chunk, &spt);
+  }
+  SC_FREE (spt.acut);
+}
+
+void
+sc_array_merge (sc_array_t * dest, sc_array_t * a, sc_array_t * b,
+                int (*compar) (const void *, const void *), int num_threads)
+{
+  sc_array_set_operation (SC_ARRAY_SET_MERGE, dest, a, b, compar,
+                          num_threads);
+}
+
+void
+sc_array_intersect (sc_array_t * dest, sc_array_t * a, sc_array_t * b,
+                    int (*compar) (const void *, const void *),
+                    int num_threads)
+{
+  sc_array_set_operation (SC_ARRAY_SET_INTERSECT, dest, a, b, compar,
+                          num_threads);
+}
+
+void
+sc_array_difference (sc_array_t * dest, sc_array_t * a, sc_array_t * b,
+                     int (*compar) (const void *, const void *),
+                     int num_threads)
+{
+  sc_array_set_operation (SC_ARRAY_SET_DIFFERENCE, dest, a, b, compar,
+                          num_threads);
+}
+
 ssize_t
 sc_array_bsearch (sc_array_t * array, const void *key,
                   int (*compar) (const void *, const void *))
@@ -434,6 +1533,116 @@ sc_array_bsearch (sc_array_t * array, const void *key,
   return is;
 }
 
+/** Return an element of an array of int or int64_t. */
+static inline int64_t
+sc_array_isearch_value (sc_array_t * array, size_t iz)
+{
+  if (array->elem_size == sizeof (int64_t)) {
+    return ((const int64_t *) array->array)[iz];
+  }
+  return ((const int *) array->array)[iz];
+}
+
+/** Return the first position in [lo, hi) with a value not less than key.
+ * Interpolation steps alternate with bisections when the range does not
+ * shrink to at most half, which bounds the steps by twice log2 (hi - lo).
+ */
+static size_t
+sc_array_isearch_lower (sc_array_t * array, int64_t key, size_t lo,
+                        size_t hi)
+{
+  int                 bisect;
+  size_t              mid, old;
+  int64_t             vlo, vhi, v;
+
+  bisect = 0;
+  while (lo < hi) {
+    vlo = sc_array_isearch_value (array, lo);
+    if (key <= vlo) {
+      return lo;
+    }
+    vhi = sc_array_isearch_value (array, hi - 1);
+    if (key > vhi) {
+      return hi;
+    }
+
+    /* now vlo < key <= vhi; the answer is in (lo, hi - 1] */
+    old = hi - lo;
+    if (bisect) {
+      mid = lo + old / 2;
+    }
+    else {
+      mid = lo + 1 + (size_t) (((double) key - (double) vlo) /
+                               ((double) vhi - (double) vlo) *
+                               (double) (old - 2));
+      mid = SC_MIN (mid, hi - 1);
+    }
+    v = sc_array_isearch_value (array, mid);
+    if (v < key) {
+      lo = mid + 1;
+    }
+    else {
+      lo = lo + 1;
+      hi = mid + 1;
+    }
+    bisect = !bisect && hi - lo > old / 2;
+  }
+  return lo;
+}
+
+ssize_t
+sc_array_isearch (sc_array_t * array, int64_t key)
+{
+  size_t              pos;
+
+  SC_ASSERT (array->elem_size == sizeof (int) ||
+             array->elem_size == sizeof (int64_t));
+
+  pos = sc_array_isearch_lower (array, key, 0, array->elem_count);
+  return pos < array->elem_count &&
+    sc_array_isearch_value (array, pos) == key ? (ssize_t) pos : -1;
+}
+
+void
+sc_array_isearch_batch (sc_array_t * array, sc_array_t * keys,
+                        sc_array_t * positions)
+{
+  size_t              zz, lo, hi, step;
+  const size_t        count = array->elem_count;
+  int64_t             key, prev;
+
+  SC_ASSERT (array->elem_size == sizeof (int) ||
+             array->elem_size == sizeof (int64_t));
+  SC_ASSERT (keys->elem_size == array->elem_size);
+  SC_ASSERT (positions->elem_size == sizeof (ssize_t));
+
+  sc_array_resize (positions, keys->elem_count);
+  lo = 0;
+  prev = 0;
+  for (zz = 0; zz < keys->elem_count; ++zz) {
+    key = sc_array_isearch_value (keys, zz);
+    if (zz > 0 && key < prev) {
+      /* unsorted keys: the previous result is no lower limit */
+      lo = 0;
+    }
+    prev = key;
+
+    /* gallop forward to bracket the key, then search the bracket */
+    step = 1;
+    hi = lo;
+    while (hi < count && sc_array_isearch_value (array, hi) < key) {
+      lo = hi + 1;
+      hi = lo + step;
+      step *= 2;
+      hi = SC_MIN (hi, count);
+    }
+    lo = sc_array_isearch_lower (array, key, lo, SC_MIN (hi + 1, count));
+    *(ssize_t *) sc_array_index (positions, zz) =
+      lo < count && sc_array_isearch_value (array, lo) == key ?
+      (ssize_t) lo : -1;
+  }
+}
+
 void
 sc_array_split (sc_array_t * array, sc_array_t * offsets, size_t num_types,
                 sc_array_type_t type_fn, void *data)
@@ -528,6 +1737,141 @@ sc_array_split (sc_array_t * array, sc_array_t * offsets, size_t num_types,
   }
 }
 
+/** State shared by the threads of \ref sc_array_split_parallel.
+ * The array is cut into num_chunks chunks and counts holds num_types
+ * counters for each chunk, which are turned into write positions. */
+typedef struct sc_array_split_parallel
+{
+  sc_array_t         *array;
+  size_t              num_types;
+  sc_array_type_t     type_fn;
+  void               *data;
+  size_t              num_chunks;
+  size_t             *counts;
+  char               *output;
+}
+sc_array_split_parallel_t;
+
+static void
+sc_array_split_parallel_count (int thread_id, int num_threads, void *user)
+{
+  sc_array_split_parallel_t *spt = (sc_array_split_parallel_t *) user;
+  const size_t        n = spt->array->elem_count;
+  size_t              c, zz, lo, hi, type;
+  size_t             *counts;
+
+  for (c = (size_t) thread_id; c < spt->num_chunks;
+       c += (size_t) num_threads) {
+    lo = c * n / spt->num_chunks;
+    hi = (c + 1) * n / spt->num_chunks;
+    counts = spt->counts + c * spt->num_types;
+    for (zz = lo; zz < hi; ++zz) {
+      type = spt->type_fn (spt->array, zz, spt->data);
+      SC_ASSERT (type < spt->num_types);
+      ++counts[type];
+    }
+  }
+}
+
+static void
+sc_array_split_parallel_scatter (int thread_id, int num_threads, void *user)
+{
+  sc_array_split_parallel_t *spt = (sc_array_split_parallel_t *) user;
+  const size_t        n = spt->array->elem_count;
+  const size_t        size = spt->array->elem_size;
+  size_t              c, zz, lo, hi, type;
+  size_t             *pos;
+
+  for (c = (size_t) thread_id; c < spt->num_chunks;
+       c += (size_t) num_threads) {
+    lo = c * n / spt->num_chunks;
+    hi = (c + 1) * n / spt->num_chunks;
+    pos = spt->counts + c * spt->num_types;
+    for (zz = lo; zz < hi; ++zz) {
+      type = spt->type_fn (spt->array, zz, spt->data);
+      memcpy (spt->output + pos[type]++ * size,
+              spt->array->array + zz * size, size);
+    }
+  }
+}
+
+static void
+sc_array_split_parallel_copy (int thread_id, int num_threads, void *user)
+{
+  sc_array_split_parallel_t *spt = (sc_array_split_parallel_t *) user;
+  const size_t        n = spt->array->elem_count;
+  const size_t        size = spt->array->elem_size;
+  const size_t        lo = (size_t) thread_id * n / (size_t) num_threads;
+  const size_t        hi = (size_t) (thread_id + 1) * n /
+    (size_t) num_threads;
+
+  memcpy (spt->array->array + lo * size, spt->output + lo * size,
+          (hi - lo) * size);
+}
+
+void
+sc_array_split_parallel (sc_array_t * array, sc_array_t * offsets,
+                         size_t num_types, sc_array_type_t type_fn,
+                         void *data, int permute, int num_threads)
+{
+  const size_t        count = array->elem_count;
+  size_t              T, c, k, pos, cnt;
+  size_t             *zp;
+  sc_array_split_parallel_t spt;
+
+  SC_ASSERT (offsets->elem_size == sizeof (size_t));
+
+  if (num_threads <= 0) {
+    num_threads = sc_thread_default_count ();
+  }
+  T = SC_MIN ((size_t) num_threads, count / SC_ARRAY_SPLIT_PARALLEL_MIN);
+  T = SC_MAX (T, 1);
+  if (!permute && T == 1) {
+    /* the binary search is cheaper on a sorted array */
+    sc_array_split (array, offsets, num_types, type_fn, data);
+    return;
+  }
+
+  sc_array_resize (offsets, num_types + 1);
+  zp = (size_t *) offsets->array;
+  if (num_types == 0) {
+    SC_ASSERT (count == 0);
+    zp[0] = 0;
+    return;
+  }
+
+  /* count the types in each chunk */
+  spt.array = array;
+  spt.num_types = num_types;
+  spt.type_fn = type_fn;
+  spt.data = data;
+  spt.num_chunks = T;
+  spt.counts = SC_ALLOC_ZERO (size_t, T * num_types);
+  spt.output = NULL;
+  sc_thread_fork_join ((int) T, sc_array_split_parallel_count, &spt);
+
+  /* turn the counts into the first write position of each chunk and type */
+  for (pos = 0, k = 0; k < num_types; ++k) {
+    zp[k] = pos;
+    for (c = 0; c < T; ++c) {
+      cnt = spt.counts[c * num_types + k];
+      spt.counts[c * num_types + k] = pos;
+      pos += cnt;
+    }
+  }
+  zp[num_types] = pos;
+  SC_ASSERT (pos == count);
+
+  /* move the entries stably into type order */
+  if (permute && count > 0) {
+    spt.output = SC_ALLOC (char, count * array->elem_size);
+    sc_thread_fork_join ((int) T, sc_array_split_parallel_scatter, &spt);
+    sc_thread_fork_join ((int) T, sc_array_split_parallel_copy, &spt);
+    SC_FREE (spt.output);
+  }
+  SC_FREE (spt.counts);
+}
+
 int
 sc_array_is_permutation (sc_array_t * newindices)
 {
@@ -628,11 +1972,93 @@ sc_array_permute (sc_array_t * array, sc_array_t * newindices, int keepperm)
   SC_FREE (temp);
 }
 
-unsigned int
-sc_array_checksum (sc_array_t * array)
+/** Swap two array elements through a buffer of block_size bytes. */
+static inline void
+sc_array_permute_swap (char *a, char *b, char *temp, size_t esize,
+                       size_t block_size)
 {
-#ifdef SC_HAVE_ZLIB
-  /* these types have sufficient size for adler32 */
+  size_t              offset, bytes;
+
+  for (offset = 0; offset < esize; offset += bytes) {
+    bytes = SC_MIN (block_size, esize - offset);
+    memcpy (temp, a + offset, bytes);
+    memcpy (a + offset, b + offset, bytes);
+    memcpy (b + offset, temp, bytes);
+  }
+}
+
+/** Permute by following cycles and complementing visited indices. */
+static void
+sc_array_permute_cycles (sc_array_t * array, sc_array_t * newindices,
+                         size_t block_size)
+{
+  const size_t        esize = array->elem_size;
+  const size_t        count = array->elem_count;
+  size_t              zi, zk;
+  size_t             *newind;
+  char               *carray = array->array;
+  char               *temp;
+
+  SC_ASSERT (newindices->elem_size == sizeof (size_t));
+  SC_ASSERT (newindices->elem_count == count);
+  SC_ASSERT (sc_array_is_permutation (newindices));
+  if (count == 0 || esize == 0) {
+    return;
+  }
+  SC_ASSERT (block_size > 0);
+
+  /* a complemented index has its top bit set and marks a visited entry */
+  SC_ASSERT (count <= (~(size_t) 0) >> 1);
+  newind = (size_t *) newindices->array;
+  block_size = SC_MIN (block_size, esize);
+  temp = SC_ALLOC (char, block_size);
+
+  for (zi = 0; zi < count; ++zi) {
+    if (newind[zi] >= count) {
+      /* this entry belongs to a cycle already done */
+      continue;
+    }
+
+    /* the pivot zi holds the data that is to be moved to zk */
+    zk = newind[zi];
+    newind[zi] = ~zk;
+    while (zk != zi) {
+      SC_ASSERT (zk < count);
+      sc_array_permute_swap (carray + esize * zi, carray + esize * zk,
+                             temp, esize, block_size);
+      /* the pivot now holds the data that was in zk */
+      SC_ASSERT (newind[zk] < count);
+      newind[zk] = ~newind[zk];
+      zk = ~newind[zk];
+    }
+  }
+
+  /* restore the permutation */
+  for (zi = 0; zi < count; ++zi) {
+    newind[zi] = ~newind[zi];
+  }
+
+  SC_FREE (temp);
+}
+
+void
+sc_array_permute_inplace (sc_array_t * array, sc_array_t * newindices)
+{
+  sc_array_permute_cycles (array, newindices, array->elem_size);
+}
+
+void
+sc_array_permute_blocked (sc_array_t * array, sc_array_t * newindices,
+                          size_t block_size)
+{
+  sc_array_permute_cycles (array, newindices, block_size);
+}
+
+unsigned int
+sc_array_checksum (sc_array_t * array)
+{
+#ifdef SC_HAVE_ZLIB
+  /* these types have sufficient size for adler32 */
   unsigned int        crc;
   size_t              bytes;
 
@@ -646,9 +2072,8 @@ sc_array_checksum (sc_array_t * array)
 
   return crc;
 #else
-  SC_ABORT ("Configure did not find a recent enough zlib.  Abort.\n");
-
-  return 0;
+  return (unsigned int) sc_io_adler32 (1, array->array,
+                                       array->elem_count * array->elem_size);
 #endif
 }
 
@@ -775,18 +2200,40 @@ sc_mstamp_stamp (sc_mstamp_t * mst)
 
   /* make new stamp; the pointer is aligned to any builtin type */
   mst->cur_snext = 0;
-  *(void **) sc_array_push (&mst->remember) =
-    mst->current = SC_ALLOC (char, mst->stamp_size);
+  *(void **) sc_array_push (&mst->remember) = mst->current =
+    mst->stamp_align == 0 ? SC_ALLOC (char, mst->stamp_size) :
+    (char *) sc_aligned_alloc (mst->stamp_size, mst->stamp_align);
+}
+
+/** Free one stamp allocated by \ref sc_mstamp_stamp. */
+static void
+sc_mstamp_free_stamp (sc_mstamp_t * mst, void *stamp)
+{
+  if (mst->stamp_align == 0) {
+    SC_FREE (stamp);
+  }
+  else {
+    sc_aligned_free (stamp);
+  }
 }
 
 void
 sc_mstamp_init (sc_mstamp_t * mst, size_t stamp_unit, size_t elem_size)
+{
+  sc_mstamp_init_aligned (mst, stamp_unit, elem_size, 0);
+}
+
+void
+sc_mstamp_init_aligned (sc_mstamp_t * mst, size_t stamp_unit,
+                        size_t elem_size, size_t stamp_align)
 {
   SC_ASSERT (mst != NULL);
+  SC_ASSERT ((stamp_align & (stamp_align - 1)) == 0);
 
   /* basic initialization */
   memset (mst, 0, sizeof (sc_mstamp_t));
   mst->elem_size = elem_size;
+  mst->stamp_align = stamp_align;
   sc_array_init (&mst->remember, sizeof (void *));
 
   /* how many items per stamp we use */
@@ -811,7 +2258,8 @@ sc_mstamp_reset (sc_mstamp_t * mst)
   /* free all memory stamps we have created */
   znum = mst->remember.elem_count;
   for (zz = 0; zz < znum; zz++) {
-    SC_FREE (*(void **) sc_array_index (&mst->remember, zz));
+    sc_mstamp_free_stamp (mst, *(void **) sc_array_index (&mst->remember,
+                                                          zz));
   }
   sc_array_reset (&mst->remember);
 }
@@ -865,6 +2313,208 @@ sc_mstamp_memory_used (sc_mstamp_t * mst)
   return s;
 }
 
+/* arena routines */
+
+static const size_t sc_arena_default_block = (size_t) 1 << 16;
+
+/** Alignment of the array memory taken from an arena, as by malloc. */
+static const size_t sc_arena_array_align = 2 * sizeof (size_t);
+
+typedef struct sc_arena_block
+{
+  char               *data;
+  size_t              size;
+}
+sc_arena_block_t;
+
+static void        *
+sc_arena_array_alloc (size_t size, void *user)
+{
+  return sc_arena_alloc ((sc_arena_t *) user, size, sc_arena_array_align);
+}
+
+static void        *
+sc_arena_array_realloc (void *ptr, size_t old_size, size_t new_size,
+                        void *user)
+{
+  return sc_arena_realloc ((sc_arena_t *) user, ptr, old_size, new_size,
+                           sc_arena_array_align);
+}
+
+static void
+sc_arena_array_free (void *ptr, size_t size, void *user)
+{
+  /* the memory is reclaimed by rewinding the arena */
+}
+
+void
+sc_arena_init (sc_arena_t * arena, size_t block_size)
+{
+  SC_ASSERT (arena != NULL);
+
+  arena->block_size = block_size > 0 ? block_size : sc_arena_default_block;
+  arena->current = arena->offset = arena->last = 0;
+  sc_array_init (&arena->blocks, sizeof (sc_arena_block_t));
+
+  arena->allocator.alloc = sc_arena_array_alloc;
+  arena->allocator.realloc = sc_arena_array_realloc;
+  arena->allocator.free = sc_arena_array_free;
+  arena->allocator.user = arena;
+}
+
+void
+sc_arena_reset (sc_arena_t * arena)
+{
+  size_t              zz;
+
+  SC_ASSERT (arena != NULL);
+
+  for (zz = 0; zz < arena->blocks.elem_count; ++zz) {
+    SC_FREE (((sc_arena_block_t *)
+              sc_array_index (&arena->blocks, zz))->data);
+  }
+  sc_array_reset (&arena->blocks);
+}
+
+sc_arena_t         *
+sc_arena_new (size_t block_size)
+{
+  sc_arena_t         *arena;
+
+  arena = SC_ALLOC (sc_arena_t, 1);
+  sc_arena_init (arena, block_size);
+
+  return arena;
+}
+
+void
+sc_arena_destroy (sc_arena_t * arena)
+{
+  sc_arena_reset (arena);
+
+  SC_FREE (arena);
+}
+
+void               *
+sc_arena_alloc (sc_arena_t * arena, size_t size, size_t align)
+{
+  size_t              pad;
+  sc_arena_block_t   *blk;
+
+  SC_ASSERT (arena != NULL);
+
+  if (align == 0) {
+    align = sizeof (void *);
+  }
+  SC_ASSERT ((align & (align - 1)) == 0);
+
+  for (;;) {
+    if (arena->current < arena->blocks.elem_count) {
+      blk = (sc_arena_block_t *)
+        sc_array_index (&arena->blocks, arena->current);
+      pad = (size_t) (-(uintptr_t) (blk->data + arena->offset)) &
+        (align - 1);
+      if (arena->offset + pad + size <= blk->size) {
+        /* the item fits into the current block */
+        arena->last = arena->offset + pad;
+        arena->offset = arena->last + size;
+        return blk->data + arena->last;
+      }
+      if (arena->current + 1 < arena->blocks.elem_count) {
+        /* try the next block kept from before a rewind */
+        ++arena->current;
+        arena->offset = 0;
+        continue;
+      }
+    }
+
+    /* append a new block that is large enough for the item */
+    blk = (sc_arena_block_t *) sc_array_push (&arena->blocks);
+    blk->size = SC_MAX (arena->block_size, size + align - 1);
+    blk->data = SC_ALLOC (char, blk->size);
+    arena->current = arena->blocks.elem_count - 1;
+    arena->offset = 0;
+  }
+}
+
+void               *
+sc_arena_realloc (sc_arena_t * arena, void *ptr,
+                  size_t old_size, size_t new_size, size_t align)
+{
+  void               *ret;
+  sc_arena_block_t   *blk;
+
+  SC_ASSERT (arena != NULL);
+
+  if (ptr == NULL) {
+    return sc_arena_alloc (arena, new_size, align);
+  }
+
+  /* the most recent item may grow or shrink in place */
+  if (arena->current < arena->blocks.elem_count) {
+    blk = (sc_arena_block_t *)
+      sc_array_index (&arena->blocks, arena->current);
+    if ((char *) ptr == blk->data + arena->last &&
+        arena->offset == arena->last + old_size &&
+        arena->last + new_size <= blk->size) {
+      arena->offset = arena->last + new_size;
+      return ptr;
+    }
+  }
+
+  ret = sc_arena_alloc (arena, new_size, align);
+  memcpy (ret, ptr, SC_MIN (old_size, new_size));
+  return ret;
+}
+
+sc_arena_mark_t
+sc_arena_save (sc_arena_t * arena)
+{
+  sc_arena_mark_t     mark;
+
+  SC_ASSERT (arena != NULL);
+
+  mark.current = arena->current;
+  mark.offset = arena->offset;
+  return mark;
+}
+
+void
+sc_arena_rewind (sc_arena_t * arena, sc_arena_mark_t mark)
+{
+  SC_ASSERT (arena != NULL);
+  SC_ASSERT (mark.current < arena->current ||
+             (mark.current == arena->current &&
+              mark.offset <= arena->offset));
+
+  /* the last item is forgotten to prevent resizing it in place */
+  arena->current = mark.current;
+  arena->offset = arena->last = mark.offset;
+}
+
+void
+sc_arena_truncate (sc_arena_t * arena)
+{
+  SC_ASSERT (arena != NULL);
+
+  arena->current = arena->offset = arena->last = 0;
+}
+
+size_t
+sc_arena_memory_used (sc_arena_t * arena, int is_dynamic)
+{
+  size_t              zz, s;
+
+  SC_ASSERT (arena != NULL);
+
+  s = (is_dynamic ? sizeof (sc_arena_t) : 0) +
+    sc_array_memory_used (&arena->blocks, 0);
+  for (zz = 0; zz < arena->blocks.elem_count; ++zz) {
+    s += ((sc_arena_block_t *) sc_array_index (&arena->blocks, zz))->size;
+  }
+  return s;
+}
+
 /* mempool routines */
 
 size_t
@@ -878,20 +2528,32 @@ sc_mempool_memory_used (sc_mempool_t * mempool)
 /** This function is static; we do not like to expose _ext functions in libsc. */
 static void
 sc_mempool_init_ext (sc_mempool_t * mempool, size_t elem_size,
-                     int zero_and_persist)
+                     int zero_and_persist, size_t elem_align,
+                     size_t stamp_align)
 {
+  SC_ASSERT (elem_align > 0 && (elem_align & (elem_align - 1)) == 0);
+  SC_ASSERT ((stamp_align & (stamp_align - 1)) == 0);
+
   mempool->elem_size = elem_size;
   mempool->elem_count = 0;
   mempool->zero_and_persist = zero_and_persist;
 
-  sc_mstamp_init (&mempool->mstamp, 4096, elem_size);
+  /* pad the elements to their alignment and align the stamps with them */
+  if (elem_align > 1) {
+    stamp_align = SC_MAX (stamp_align, elem_align);
+    elem_size = SC_ALIGN_UP (elem_size, elem_align);
+  }
+  sc_mstamp_init_aligned (&mempool->mstamp, SC_MAX (4096, stamp_align),
+                          elem_size, stamp_align);
   sc_array_init (&mempool->freed, sizeof (void *));
+  mempool->trim_fraction = 0.;
+  mempool->trim_next = SC_MEMPOOL_TRIM_MIN;
 }
 
 void
 sc_mempool_init (sc_mempool_t * mempool, size_t elem_size)
 {
-  sc_mempool_init_ext (mempool, elem_size, 0);
+  sc_mempool_init_ext (mempool, elem_size, 0, 1, 0);
 }
 
 /** This function is static; we do not like to expose _ext functions in libsc. */
@@ -904,7 +2566,7 @@ sc_mempool_new_ext (size_t elem_size, int zero_and_persist)
 
   mempool = SC_ALLOC (sc_mempool_t, 1);
 
-  sc_mempool_init_ext (mempool, elem_size, zero_and_persist);
+  sc_mempool_init_ext (mempool, elem_size, zero_and_persist, 1, 0);
 
   return mempool;
 }
@@ -921,6 +2583,26 @@ sc_mempool_new_zero_and_persist (size_t elem_size)
   return sc_mempool_new_ext (elem_size, 1);
 }
 
+void
+sc_mempool_init_aligned (sc_mempool_t * mempool, size_t elem_size,
+                         size_t elem_align, size_t stamp_align)
+{
+  sc_mempool_init_ext (mempool, elem_size, 0, elem_align, stamp_align);
+}
+
+sc_mempool_t       *
+sc_mempool_new_aligned (size_t elem_size, size_t elem_align,
+                        size_t stamp_align)
+{
+  sc_mempool_t       *mempool;
+
+  mempool = SC_ALLOC (sc_mempool_t, 1);
+
+  sc_mempool_init_aligned (mempool, elem_size, elem_align, stamp_align);
+
+  return mempool;
+}
+
 void
 sc_mempool_reset (sc_mempool_t * mempool)
 {
@@ -951,108 +2633,517 @@ sc_mempool_truncate (sc_mempool_t * mempool)
   sc_array_reset (&mempool->freed);
   sc_mstamp_truncate (&mempool->mstamp);
   mempool->elem_count = 0;
+  mempool->trim_next = SC_MEMPOOL_TRIM_MIN;
 }
 
-/* list routines */
-
-size_t
-sc_list_memory_used (sc_list_t * list, int is_dynamic)
+static int
+sc_mempool_stamp_compare (const void *v1, const void *v2)
 {
-  return (is_dynamic ? sizeof (sc_list_t) : 0) +
-    (list->allocator_owned ? sc_mempool_memory_used (list->allocator) : 0);
+  const uintptr_t     p1 = (uintptr_t) * (void *const *) v1;
+  const uintptr_t     p2 = (uintptr_t) * (void *const *) v2;
+
+  return p1 < p2 ? -1 : p1 > p2;
 }
 
-sc_list_t          *
-sc_list_new (sc_mempool_t * allocator)
+/** Find the stamp of an element in the stamps sorted by address. */
+static size_t
+sc_mempool_stamp_find (sc_array_t * stamps, const void *elem)
 {
-  sc_list_t          *list;
+  size_t              lo, hi, mid;
+
+  /* the last stamp that does not start after the element */
+  lo = 0;
+  hi = stamps->elem_count;
+  while (hi - lo > 1) {
+    mid = lo + (hi - lo) / 2;
+    if ((uintptr_t) * (void **) sc_array_index (stamps, mid) <=
+        (uintptr_t) elem) {
+      lo = mid;
+    }
+    else {
+      hi = mid;
+    }
+  }
+  return lo;
+}
 
-  list = SC_ALLOC (sc_list_t, 1);
+size_t
+sc_mempool_trim (sc_mempool_t * mempool)
+{
+  sc_mstamp_t        *mst = &mempool->mstamp;
+  sc_array_t         *stamps = &mst->remember;
+  sc_array_t         *freed = &mempool->freed;
+  size_t              zz, kept, released, s;
+  size_t             *counts;
+  void               *elem, *stamp;
+
+  /* the next automatic trim waits for twice as many freed elements */
+  mempool->trim_next = SC_MAX (SC_MEMPOOL_TRIM_MIN,
+                               2 * freed->elem_count);
+  if (mst->elem_size == 0 || freed->elem_count < mst->per_stamp) {
+    return 0;
+  }
 
-  list->elem_count = 0;
-  list->first = NULL;
-  list->last = NULL;
+  /* count the freed elements of each stamp */
+  sc_array_sort (stamps, sc_mempool_stamp_compare);
+  counts = SC_ALLOC_ZERO (size_t, stamps->elem_count);
+  for (zz = 0; zz < freed->elem_count; ++zz) {
+    elem = *(void **) sc_array_index (freed, zz);
+    ++counts[sc_mempool_stamp_find (stamps, elem)];
+  }
 
-  if (allocator != NULL) {
-    SC_ASSERT (allocator->elem_size == sizeof (sc_link_t));
-    list->allocator = allocator;
-    list->allocator_owned = 0;
+  /* keep the freed elements on stamps that are in use */
+  for (zz = 0, kept = 0; zz < freed->elem_count; ++zz) {
+    elem = *(void **) sc_array_index (freed, zz);
+    s = sc_mempool_stamp_find (stamps, elem);
+    if (counts[s] < mst->per_stamp ||
+        *(void **) sc_array_index (stamps, s) == mst->current) {
+      *(void **) sc_array_index (freed, kept++) = elem;
+    }
   }
-  else {
-    list->allocator = sc_mempool_new (sizeof (sc_link_t));
-    list->allocator_owned = 1;
+  if (kept == freed->elem_count) {
+    SC_FREE (counts);
+    return 0;
   }
+  sc_array_resize (freed, kept);
 
-  return list;
+  /* free the complete stamps */
+  for (zz = 0, kept = 0; zz < stamps->elem_count; ++zz) {
+    stamp = *(void **) sc_array_index (stamps, zz);
+    if (counts[zz] == mst->per_stamp && stamp != mst->current) {
+      sc_mstamp_free_stamp (mst, stamp);
+    }
+    else {
+      *(void **) sc_array_index (stamps, kept++) = stamp;
+    }
+  }
+  released = (stamps->elem_count - kept) * mst->stamp_size;
+  sc_array_resize (stamps, kept);
+  SC_FREE (counts);
+
+  mempool->trim_next = SC_MAX (SC_MEMPOOL_TRIM_MIN,
+                               2 * freed->elem_count);
+  return released;
 }
 
 void
-sc_list_destroy (sc_list_t * list)
+sc_mempool_set_trim (sc_mempool_t * mempool, double fraction)
 {
+  SC_ASSERT (0. <= fraction && fraction <= 1.);
 
-  if (list->allocator_owned) {
-    sc_list_unlink (list);
-    sc_mempool_destroy (list->allocator);
-  }
-  else {
-    sc_list_reset (list);
-  }
-  SC_FREE (list);
+  mempool->trim_fraction = fraction;
 }
 
-void
-sc_list_init (sc_list_t * list, sc_mempool_t * allocator)
-{
-  list->elem_count = 0;
-  list->first = NULL;
-  list->last = NULL;
+/* concurrent mempool routines */
 
-  SC_ASSERT (allocator != NULL);
-  SC_ASSERT (allocator->elem_size == sizeof (sc_link_t));
+#define SC_MEMPOOL_MAGAZINE_SIZE 64
+#define SC_MEMPOOL_MAGAZINE_CHUNKS 26
 
-  list->allocator = allocator;
-  list->allocator_owned = 0;
+/** A magazine is a stack of free elements. */
+typedef struct sc_mempool_magazine
+{
+  uint32_t            next;     /**< depot successor index plus one */
+  uint32_t            index;    /**< position in the chunks of the pool */
+  int                 count;    /**< number of elements on the stack */
+  void               *elems[SC_MEMPOOL_MAGAZINE_SIZE];
 }
+sc_mempool_magazine_t;
 
-void
-sc_list_reset (sc_list_t * list)
+struct sc_mempool_concurrent
 {
-  sc_link_t          *lynk;
-  sc_link_t          *temp;
+  size_t              elem_size;
+  size_t              elem_count;       /**< added when caches die */
+  int                 num_caches;       /**< number of live caches */
+
+  /* The depots are stacks whose head holds a magazine index plus one in
+     the lower 32 bits and a tag in the upper 32 bits that changes with
+     every operation.  This protects against the ABA problem. */
+  uint64_t            full_depot, empty_depot;
+
+  /* all below is protected by the mutex */
+  sc_mempool_t       *backing;          /**< provides new elements */
+  size_t              num_magazines;    /**< chunk k has 2**k * SIZE */
+  sc_mempool_magazine_t *chunks[SC_MEMPOOL_MAGAZINE_CHUNKS];
+#ifdef SC_ENABLE_PTHREAD
+  pthread_mutex_t     mutex;
+#endif
+};
 
-  lynk = list->first;
-  while (lynk != NULL) {
-    temp = lynk->next;
-    sc_mempool_free (list->allocator, lynk);
-    lynk = temp;
-    --list->elem_count;
-  }
-  SC_ASSERT (list->elem_count == 0);
+struct sc_mempool_cache
+{
+  sc_mempool_concurrent_t *mempool;
+  sc_mempool_magazine_t *loaded, *previous;
+  long                elem_count;       /**< may be negative */
+};
 
-  list->first = list->last = NULL;
+static void
+sc_mempool_concurrent_lock (sc_mempool_concurrent_t * mempool)
+{
+#ifdef SC_ENABLE_PTHREAD
+  SC_EXECUTE_ASSERT_FALSE (pthread_mutex_lock (&mempool->mutex));
+#endif
 }
 
-void
-sc_list_unlink (sc_list_t * list)
+static void
+sc_mempool_concurrent_unlock (sc_mempool_concurrent_t * mempool)
 {
-  list->first = list->last = NULL;
-  list->elem_count = 0;
+#ifdef SC_ENABLE_PTHREAD
+  SC_EXECUTE_ASSERT_FALSE (pthread_mutex_unlock (&mempool->mutex));
+#endif
 }
 
-sc_link_t          *
-sc_list_prepend (sc_list_t * list, void *data)
+/** Return the chunk number of a magazine index. */
+static int
+sc_mempool_magazine_chunk (size_t index)
 {
-  sc_link_t          *lynk;
+  return SC_LOG2_64 (index / SC_MEMPOOL_MAGAZINE_SIZE + 1);
+}
 
-  lynk = (sc_link_t *) sc_mempool_alloc (list->allocator);
-  lynk->data = data;
-  lynk->next = list->first;
-  list->first = lynk;
-  if (list->last == NULL) {
-    list->last = lynk;
-  }
+static sc_mempool_magazine_t *
+sc_mempool_magazine_lookup (sc_mempool_concurrent_t * mempool, size_t index)
+{
+  const int           k = sc_mempool_magazine_chunk (index);
 
-  ++list->elem_count;
+  return mempool->chunks[k] +
+    (index - SC_MEMPOOL_MAGAZINE_SIZE * (((size_t) 1 << k) - 1));
+}
+
+/** Create an empty magazine.  This is the only place we allocate them. */
+static sc_mempool_magazine_t *
+sc_mempool_magazine_new (sc_mempool_concurrent_t * mempool)
+{
+  int                 k;
+  size_t              index;
+  sc_mempool_magazine_t *mag;
+
+  sc_mempool_concurrent_lock (mempool);
+  index = mempool->num_magazines++;
+  k = sc_mempool_magazine_chunk (index);
+  SC_CHECK_ABORT (k < SC_MEMPOOL_MAGAZINE_CHUNKS && index < UINT32_MAX,
+                  "Too many magazines in concurrent mempool");
+  if (mempool->chunks[k] == NULL) {
+    mempool->chunks[k] = SC_ALLOC (sc_mempool_magazine_t,
+                                   SC_MEMPOOL_MAGAZINE_SIZE << k);
+  }
+  mag = sc_mempool_magazine_lookup (mempool, index);
+  sc_mempool_concurrent_unlock (mempool);
+
+  mag->next = 0;
+  mag->index = (uint32_t) index;
+  mag->count = 0;
+  return mag;
+}
+
+/** Fill an empty magazine with new elements. */
+static void
+sc_mempool_magazine_fill (sc_mempool_concurrent_t * mempool,
+                          sc_mempool_magazine_t * mag)
+{
+  SC_ASSERT (mag->count == 0);
+
+  sc_mempool_concurrent_lock (mempool);
+  for (; mag->count < SC_MEMPOOL_MAGAZINE_SIZE; ++mag->count) {
+    mag->elems[mag->count] = sc_mempool_alloc (mempool->backing);
+  }
+  sc_mempool_concurrent_unlock (mempool);
+}
+
+static void
+sc_mempool_depot_push (uint64_t * depot, sc_mempool_magazine_t * mag)
+{
+  uint64_t            head, newhead;
+
+  head = SC_ATOMIC_LOAD (depot);
+  do {
+    SC_ATOMIC_STORE (&mag->next, (uint32_t) (head & 0xffffffffU));
+    newhead = (((head >> 32) + 1) << 32) | (uint64_t) (mag->index + 1);
+  }
+  while (!SC_ATOMIC_CAS (depot, &head, newhead));
+}
+
+static sc_mempool_magazine_t *
+sc_mempool_depot_pop (sc_mempool_concurrent_t * mempool, uint64_t * depot)
+{
+  uint32_t            top;
+  uint64_t            head, newhead;
+  sc_mempool_magazine_t *mag;
+
+  head = SC_ATOMIC_LOAD (depot);
+  do {
+    top = (uint32_t) (head & 0xffffffffU);
+    if (top == 0) {
+      return NULL;
+    }
+    /* magazines are never freed, so reading a stale one is harmless */
+    mag = sc_mempool_magazine_lookup (mempool, (size_t) top - 1);
+    newhead = (((head >> 32) + 1) << 32) |
+      (uint64_t) SC_ATOMIC_LOAD (&mag->next);
+  }
+  while (!SC_ATOMIC_CAS (depot, &head, newhead));
+
+  return mag;
+}
+
+static sc_mempool_magazine_t *
+sc_mempool_magazine_empty (sc_mempool_concurrent_t * mempool)
+{
+  sc_mempool_magazine_t *mag;
+
+  mag = sc_mempool_depot_pop (mempool, &mempool->empty_depot);
+  if (mag == NULL) {
+    mag = sc_mempool_magazine_new (mempool);
+  }
+  SC_ASSERT (mag->count == 0);
+  return mag;
+}
+
+sc_mempool_concurrent_t *
+sc_mempool_concurrent_new (size_t elem_size)
+{
+  sc_mempool_concurrent_t *mempool;
+
+  SC_ASSERT (elem_size > 0);
+
+  mempool = SC_ALLOC_ZERO (sc_mempool_concurrent_t, 1);
+  mempool->elem_size = elem_size;
+  mempool->backing = sc_mempool_new (elem_size);
+#ifdef SC_ENABLE_PTHREAD
+  SC_EXECUTE_ASSERT_FALSE (pthread_mutex_init (&mempool->mutex, NULL));
+#endif
+
+  return mempool;
+}
+
+void
+sc_mempool_concurrent_destroy (sc_mempool_concurrent_t * mempool)
+{
+  int                 k;
+
+  SC_ASSERT (mempool->num_caches == 0);
+
+  for (k = 0; k < SC_MEMPOOL_MAGAZINE_CHUNKS; ++k) {
+    SC_FREE (mempool->chunks[k]);
+  }
+  sc_mempool_destroy (mempool->backing);
+#ifdef SC_ENABLE_PTHREAD
+  SC_EXECUTE_ASSERT_FALSE (pthread_mutex_destroy (&mempool->mutex));
+#endif
+
+  SC_FREE (mempool);
+}
+
+size_t
+sc_mempool_concurrent_memory_used (sc_mempool_concurrent_t * mempool)
+{
+  int                 k;
+  size_t              mem;
+
+  sc_mempool_concurrent_lock (mempool);
+  mem = sizeof (sc_mempool_concurrent_t) +
+    sc_mempool_memory_used (mempool->backing);
+  for (k = 0; k < SC_MEMPOOL_MAGAZINE_CHUNKS; ++k) {
+    if (mempool->chunks[k] != NULL) {
+      mem += ((size_t) SC_MEMPOOL_MAGAZINE_SIZE << k) *
+        sizeof (sc_mempool_magazine_t);
+    }
+  }
+  sc_mempool_concurrent_unlock (mempool);
+
+  return mem;
+}
+
+size_t
+sc_mempool_concurrent_elem_count (sc_mempool_concurrent_t * mempool)
+{
+  return SC_ATOMIC_LOAD (&mempool->elem_count);
+}
+
+sc_mempool_cache_t *
+sc_mempool_cache_new (sc_mempool_concurrent_t * mempool)
+{
+  sc_mempool_cache_t *cache;
+
+  cache = SC_ALLOC (sc_mempool_cache_t, 1);
+  cache->mempool = mempool;
+  cache->loaded = sc_mempool_magazine_empty (mempool);
+  cache->previous = sc_mempool_magazine_empty (mempool);
+  cache->elem_count = 0;
+  SC_ATOMIC_ADD_RELAXED (&mempool->num_caches, 1);
+
+  return cache;
+}
+
+void
+sc_mempool_cache_destroy (sc_mempool_cache_t * cache)
+{
+  sc_mempool_concurrent_t *mempool = cache->mempool;
+
+  /* partially filled magazines go to the full depot */
+  sc_mempool_depot_push (cache->loaded->count > 0 ?
+                         &mempool->full_depot : &mempool->empty_depot,
+                         cache->loaded);
+  sc_mempool_depot_push (cache->previous->count > 0 ?
+                         &mempool->full_depot : &mempool->empty_depot,
+                         cache->previous);
+  (void) SC_ATOMIC_FETCH_ADD (&mempool->elem_count,
+                              (size_t) cache->elem_count);
+  SC_ATOMIC_ADD_RELAXED (&mempool->num_caches, -1);
+
+  SC_FREE (cache);
+}
+
+void               *
+sc_mempool_cache_alloc (sc_mempool_cache_t * cache)
+{
+  sc_mempool_concurrent_t *mempool = cache->mempool;
+  sc_mempool_magazine_t *mag;
+
+  if (cache->loaded->count == 0) {
+    if (cache->previous->count > 0) {
+      mag = cache->loaded;
+      cache->loaded = cache->previous;
+      cache->previous = mag;
+    }
+    else if ((mag = sc_mempool_depot_pop (mempool, &mempool->full_depot))
+             != NULL) {
+      sc_mempool_depot_push (&mempool->empty_depot, cache->previous);
+      cache->previous = cache->loaded;
+      cache->loaded = mag;
+    }
+    else {
+      sc_mempool_magazine_fill (mempool, cache->loaded);
+    }
+  }
+  SC_ASSERT (cache->loaded->count > 0);
+
+  ++cache->elem_count;
+  return cache->loaded->elems[--cache->loaded->count];
+}
+
+void
+sc_mempool_cache_free (sc_mempool_cache_t * cache, void *elem)
+{
+  sc_mempool_concurrent_t *mempool = cache->mempool;
+  sc_mempool_magazine_t *mag;
+
+  if (cache->loaded->count == SC_MEMPOOL_MAGAZINE_SIZE) {
+    if (cache->previous->count < SC_MEMPOOL_MAGAZINE_SIZE) {
+      mag = cache->loaded;
+      cache->loaded = cache->previous;
+      cache->previous = mag;
+    }
+    else {
+      sc_mempool_depot_push (&mempool->full_depot, cache->previous);
+      cache->previous = cache->loaded;
+      cache->loaded = sc_mempool_magazine_empty (mempool);
+    }
+  }
+  SC_ASSERT (cache->loaded->count < SC_MEMPOOL_MAGAZINE_SIZE);
+
+  --cache->elem_count;
+  cache->loaded->elems[cache->loaded->count++] = elem;
+}
+
+/* list routines */
+
+size_t
+sc_list_memory_used (sc_list_t * list, int is_dynamic)
+{
+  return (is_dynamic ? sizeof (sc_list_t) : 0) +
+    (list->allocator_owned ? sc_mempool_memory_used (list->allocator) : 0);
+}
+
+sc_list_t          *
+sc_list_new (sc_mempool_t * allocator)
+{
+  sc_list_t          *list;
+
+  list = SC_ALLOC (sc_list_t, 1);
+
+  list->elem_count = 0;
+  list->first = NULL;
+  list->last = NULL;
+
+  if (allocator != NULL) {
+    SC_ASSERT (allocator->elem_size == sizeof (sc_link_t));
+    list->allocator = allocator;
+    list->allocator_owned = 0;
+  }
+  else {
+    list->allocator = sc_mempool_new (sizeof (sc_link_t));
+    list->allocator_owned = 1;
+  }
+
+  return list;
+}
+
+void
+sc_list_destroy (sc_list_t * list)
+{
+
+  if (list->allocator_owned) {
+    sc_list_unlink (list);
+    sc_mempool_destroy (list->allocator);
+  }
+  else {
+    sc_list_reset (list);
+  }
+  SC_FREE (list);
+}
+
+void
+sc_list_init (sc_list_t * list, sc_mempool_t * allocator)
+{
+  list->elem_count = 0;
+  list->first = NULL;
+  list->last = NULL;
+
+  SC_ASSERT (allocator != NULL);
+  SC_ASSERT (allocator->elem_size == sizeof (sc_link_t));
+
+  list->allocator = allocator;
+  list->allocator_owned = 0;
+}
+
+void
+sc_list_reset (sc_list_t * list)
+{
+  sc_link_t          *lynk;
+  sc_link_t          *temp;
+
+  lynk = list->first;
+  while (lynk != NULL) {
+    temp = lynk->next;
+    sc_mempool_free (list->allocator, lynk);
+    lynk = temp;
+    --list->elem_count;
+  }
+  SC_ASSERT (list->elem_count == 0);
+
+  list->first = list->last = NULL;
+}
+
+void
+sc_list_unlink (sc_list_t * list)
+{
+  list->first = list->last = NULL;
+  list->elem_count = 0;
+}
+
+sc_link_t          *
+sc_list_prepend (sc_list_t * list, void *data)
+{
+  sc_link_t          *lynk;
+
+  lynk = (sc_link_t *) sc_mempool_alloc (list->allocator);
+  lynk->data = data;
+  lynk->next = list->first;
+  list->first = lynk;
+  if (list->last == NULL) {
+    list->last = lynk;
+  }
+
+  ++list->elem_count;
   return lynk;
 }
 
@@ -1182,118 +3273,380 @@ sc_hash_function_string (const void *s, const void *u)
   }
 }
 
-size_t
-sc_hash_memory_used (sc_hash_t * hash)
+/* constants and round structure of the 64-bit xxHash by Yann Collet */
+#define SC_HASH_PRIME1 0x9E3779B185EBCA87ULL
+#define SC_HASH_PRIME2 0xC2B2AE3D27D4EB4FULL
+#define SC_HASH_PRIME3 0x165667B19E3779F9ULL
+#define SC_HASH_PRIME4 0x85EBCA77C2B2AE63ULL
+#define SC_HASH_PRIME5 0x27D4EB2F165667C5ULL
+#define SC_HASH_ROTL64(x,k) (((x) << (k)) | ((x) >> (64 - (k))))
+
+/* Little-endian loads; compilers turn these into single moves. */
+static inline uint64_t
+sc_hash_read64 (const unsigned char *p)
 {
-  return sizeof (sc_hash_t) +
-    sc_array_memory_used (hash->slots, 1) +
-    (hash->allocator_owned ? sc_mempool_memory_used (hash->allocator) : 0);
+  return (uint64_t) p[0] | (uint64_t) p[1] << 8 |
+    (uint64_t) p[2] << 16 | (uint64_t) p[3] << 24 |
+    (uint64_t) p[4] << 32 | (uint64_t) p[5] << 40 |
+    (uint64_t) p[6] << 48 | (uint64_t) p[7] << 56;
 }
 
-static const size_t sc_hash_minimal_size = (size_t) ((1 << 8) - 1);
-static const size_t sc_hash_shrink_interval = (size_t) (1 << 8);
+static inline uint64_t
+sc_hash_read32 (const unsigned char *p)
+{
+  return (uint64_t) p[0] | (uint64_t) p[1] << 8 |
+    (uint64_t) p[2] << 16 | (uint64_t) p[3] << 24;
+}
 
-static void
-sc_hash_maybe_resize (sc_hash_t * hash)
+static inline uint64_t
+sc_hash_round (uint64_t acc, uint64_t input)
 {
-  size_t              i, j;
-  size_t              new_size, new_count;
-  sc_list_t          *old_list, *new_list;
-  sc_link_t          *lynk, *temp;
-  sc_array_t         *new_slots;
-  sc_array_t         *old_slots = hash->slots;
+  acc += input * SC_HASH_PRIME2;
+  acc = SC_HASH_ROTL64 (acc, 31);
+  return acc * SC_HASH_PRIME1;
+}
 
-  SC_ASSERT (old_slots->elem_count > 0);
+static inline uint64_t
+sc_hash_merge (uint64_t acc, uint64_t val)
+{
+  acc ^= sc_hash_round (0, val);
+  return acc * SC_HASH_PRIME1 + SC_HASH_PRIME4;
+}
 
-  ++hash->resize_checks;
-  if (hash->elem_count >= 4 * old_slots->elem_count) {
-    new_size = 4 * old_slots->elem_count - 1;
-  }
-  else if (hash->elem_count <= old_slots->elem_count / 4) {
-    new_size = old_slots->elem_count / 4 + 1;
-    if (new_size < sc_hash_minimal_size) {
-      return;
+uint64_t
+sc_hash_bytes64 (const void *data, size_t size, uint64_t seed)
+{
+  const unsigned char *p = (const unsigned char *) data;
+  const unsigned char *end = p + size;
+  uint64_t            h;
+
+  SC_ASSERT (data != NULL || size == 0);
+
+  if (size >= 32) {
+    const unsigned char *limit = end - 32;
+    uint64_t            v1 = seed + SC_HASH_PRIME1 + SC_HASH_PRIME2;
+    uint64_t            v2 = seed + SC_HASH_PRIME2;
+    uint64_t            v3 = seed;
+    uint64_t            v4 = seed - SC_HASH_PRIME1;
+
+    /* four independent lanes of one word each per 32 bytes */
+    do {
+      v1 = sc_hash_round (v1, sc_hash_read64 (p));
+      v2 = sc_hash_round (v2, sc_hash_read64 (p + 8));
+      v3 = sc_hash_round (v3, sc_hash_read64 (p + 16));
+      v4 = sc_hash_round (v4, sc_hash_read64 (p + 24));
+      p += 32;
     }
+    while (p <= limit);
+
+    h = SC_HASH_ROTL64 (v1, 1) + SC_HASH_ROTL64 (v2, 7) +
+      SC_HASH_ROTL64 (v3, 12) + SC_HASH_ROTL64 (v4, 18);
+    h = sc_hash_merge (h, v1);
+    h = sc_hash_merge (h, v2);
+    h = sc_hash_merge (h, v3);
+    h = sc_hash_merge (h, v4);
   }
   else {
-    return;
+    h = seed + SC_HASH_PRIME5;
   }
-  ++hash->resize_actions;
+  h += (uint64_t) size;
 
-  /* allocate new slot array */
-  new_slots = sc_array_new (sizeof (sc_list_t));
-  sc_array_resize (new_slots, new_size);
-  for (i = 0; i < new_size; ++i) {
-    new_list = (sc_list_t *) sc_array_index (new_slots, i);
-    sc_list_init (new_list, hash->allocator);
+  /* remaining words, then one half word, then single bytes */
+  for (; p + 8 <= end; p += 8) {
+    h ^= sc_hash_round (0, sc_hash_read64 (p));
+    h = SC_HASH_ROTL64 (h, 27) * SC_HASH_PRIME1 + SC_HASH_PRIME4;
   }
-
-  /* go through the old slots and move data to the new slots */
-  new_count = 0;
-  for (i = 0; i < old_slots->elem_count; ++i) {
-    old_list = (sc_list_t *) sc_array_index (old_slots, i);
-    lynk = old_list->first;
-    while (lynk != NULL) {
-      /* insert data into new slot list */
-      j = hash->hash_fn (lynk->data, hash->user_data) % new_size;
-      new_list = (sc_list_t *) sc_array_index (new_slots, j);
-      (void) sc_list_prepend (new_list, lynk->data);
-      ++new_count;
-
-      /* remove old list element */
-      temp = lynk->next;
-      sc_mempool_free (old_list->allocator, lynk);
-      lynk = temp;
-      --old_list->elem_count;
-    }
-    SC_ASSERT (old_list->elem_count == 0);
-    old_list->first = old_list->last = NULL;
+  if (p + 4 <= end) {
+    h ^= sc_hash_read32 (p) * SC_HASH_PRIME1;
+    h = SC_HASH_ROTL64 (h, 23) * SC_HASH_PRIME2 + SC_HASH_PRIME3;
+    p += 4;
+  }
+  for (; p < end; ++p) {
+    h ^= (uint64_t) *p * SC_HASH_PRIME5;
+    h = SC_HASH_ROTL64 (h, 11) * SC_HASH_PRIME1;
   }
-  SC_ASSERT (new_count == hash->elem_count);
 
-  /* replace old slots by new slots */
-  sc_array_destroy (old_slots);
-  hash->slots = new_slots;
+  /* avalanche such that every input bit affects every output bit */
+  h ^= h >> 33;
+  h *= SC_HASH_PRIME2;
+  h ^= h >> 29;
+  h *= SC_HASH_PRIME3;
+  h ^= h >> 32;
+  return h;
 }
 
-sc_hash_t          *
-sc_hash_new (sc_hash_function_t hash_fn, sc_equal_function_t equal_fn,
-             void *user_data, sc_mempool_t * allocator)
+/* Fold a 64-bit hash into the range of unsigned int. */
+static inline unsigned int
+sc_hash_fold64 (uint64_t h)
 {
-  size_t              i;
-  sc_hash_t          *hash;
-  sc_list_t          *list;
-  sc_array_t         *slots;
+  return (unsigned int) (h ^ (h >> 32));
+}
 
-  hash = SC_ALLOC (sc_hash_t, 1);
+unsigned int
+sc_hash_function_string_fast (const void *s, const void *u)
+{
+  return sc_hash_fold64 (sc_hash_bytes64 (s, strlen ((const char *) s), 0));
+}
 
-  if (allocator != NULL) {
-    SC_ASSERT (allocator->elem_size == sizeof (sc_link_t));
-    hash->allocator = allocator;
-    hash->allocator_owned = 0;
-  }
-  else {
-    hash->allocator = sc_mempool_new (sizeof (sc_link_t));
-    hash->allocator_owned = 1;
-  }
+unsigned int
+sc_hash_function_string_seeded (const void *s, const void *u)
+{
+  return sc_hash_fold64
+    (sc_hash_bytes64 (s, strlen ((const char *) s),
+                      u == NULL ? 0 : *(const uint64_t *) u));
+}
 
-  hash->elem_count = 0;
-  hash->resize_checks = 0;
-  hash->resize_actions = 0;
-  hash->hash_fn = hash_fn;
-  hash->equal_fn = equal_fn;
-  hash->user_data = user_data;
+unsigned int
+sc_hash_function_bytes (const void *v, const void *u)
+{
+  const sc_hash_bytes_t *b = (const sc_hash_bytes_t *) v;
 
-  hash->slots = slots = sc_array_new (sizeof (sc_list_t));
-  sc_array_resize (slots, sc_hash_minimal_size);
-  for (i = 0; i < slots->elem_count; ++i) {
+  return sc_hash_fold64 (sc_hash_bytes64 (b->data, b->size, u == NULL ? 0 :
+                                          *(const uint64_t *) u));
+}
+
+int
+sc_hash_equal_bytes (const void *v1, const void *v2, const void *u)
+{
+  const sc_hash_bytes_t *b1 = (const sc_hash_bytes_t *) v1;
+  const sc_hash_bytes_t *b2 = (const sc_hash_bytes_t *) v2;
+
+  return b1->size == b2->size &&
+    (b1->size == 0 || !memcmp (b1->data, b2->data, b1->size));
+}
+
+size_t
+sc_hash_memory_used (sc_hash_t * hash)
+{
+  return sizeof (sc_hash_t) +
+    sc_array_memory_used (hash->slots, 1) +
+    (hash->old_slots != NULL ? sc_array_memory_used (hash->old_slots, 1) :
+     0) +
+    (hash->allocator_owned ? sc_mempool_memory_used (hash->allocator) : 0);
+}
+
+static const size_t sc_hash_minimal_size = (size_t) ((1 << 8) - 1);
+static const size_t sc_hash_shrink_interval = (size_t) (1 << 8);
+static const size_t sc_hash_migrate_chains = 8;
+
+static sc_array_t  *
+sc_hash_new_slots (sc_hash_t * hash, size_t new_size)
+{
+  size_t              i;
+  sc_list_t          *list;
+  sc_array_t         *slots;
+
+  slots = sc_array_new (sizeof (sc_list_t));
+  sc_array_resize (slots, new_size);
+  for (i = 0; i < new_size; ++i) {
     list = (sc_list_t *) sc_array_index (slots, i);
     sc_list_init (list, hash->allocator);
   }
+  return slots;
+}
+
+/** Move all objects of one list into the current slots of the hash table.
+ * \return          The number of objects moved. */
+static size_t
+sc_hash_move_list (sc_hash_t * hash, sc_list_t * old_list)
+{
+  size_t              j, count;
+  const size_t        new_size = hash->slots->elem_count;
+  sc_list_t          *new_list;
+  sc_link_t          *lynk, *temp;
+
+  count = 0;
+  lynk = old_list->first;
+  while (lynk != NULL) {
+    /* insert data into new slot list */
+    j = hash->hash_fn (lynk->data, hash->user_data) % new_size;
+    new_list = (sc_list_t *) sc_array_index (hash->slots, j);
+    (void) sc_list_prepend (new_list, lynk->data);
+    ++count;
+
+    /* remove old list element */
+    temp = lynk->next;
+    sc_mempool_free (old_list->allocator, lynk);
+    lynk = temp;
+    --old_list->elem_count;
+  }
+  SC_ASSERT (old_list->elem_count == 0);
+  old_list->first = old_list->last = NULL;
+
+  return count;
+}
+
+/** Move a bounded number of chains during incremental rehashing.
+ * \param [in] num_chains   Maximum number of chains to move.
+ *                          The old slots are destroyed when done.
+ */
+static void
+sc_hash_migrate (sc_hash_t * hash, size_t num_chains)
+{
+  size_t              iz;
+  sc_array_t         *old_slots = hash->old_slots;
+
+  SC_ASSERT (old_slots != NULL);
+  SC_ASSERT (hash->migrate_pos < old_slots->elem_count);
+
+  for (iz = 0; iz < num_chains &&
+       hash->migrate_pos < old_slots->elem_count; ++iz) {
+    (void) sc_hash_move_list (hash, (sc_list_t *)
+                              sc_array_index (old_slots, hash->migrate_pos));
+    ++hash->migrate_pos;
+  }
+  if (hash->migrate_pos == old_slots->elem_count) {
+    sc_array_destroy (old_slots);
+    hash->old_slots = NULL;
+    hash->migrate_pos = 0;
+  }
+}
+
+static void
+sc_hash_resize (sc_hash_t * hash, size_t new_size)
+{
+  size_t              i;
+  size_t              new_count;
+  sc_array_t         *old_slots;
+
+  SC_ASSERT (new_size > 0);
+  ++hash->resize_actions;
+
+  /* a previous incremental resize is completed first */
+  if (hash->old_slots != NULL) {
+    sc_hash_migrate (hash, hash->old_slots->elem_count);
+  }
+
+  /* allocate new slot array */
+  old_slots = hash->slots;
+  hash->slots = sc_hash_new_slots (hash, new_size);
+  if (hash->incremental) {
+    /* the old slots are moved by subsequent insertions and removals */
+    hash->old_slots = old_slots;
+    hash->migrate_pos = 0;
+    return;
+  }
+
+  /* go through the old slots and move data to the new slots */
+  new_count = 0;
+  for (i = 0; i < old_slots->elem_count; ++i) {
+    new_count += sc_hash_move_list
+      (hash, (sc_list_t *) sc_array_index (old_slots, i));
+  }
+  SC_ASSERT (new_count == hash->elem_count);
+
+  /* replace old slots by new slots */
+  sc_array_destroy (old_slots);
+}
+
+static void
+sc_hash_maybe_resize (sc_hash_t * hash)
+{
+  size_t              new_size;
+  sc_array_t         *old_slots = hash->slots;
+
+  SC_ASSERT (old_slots->elem_count > 0);
+
+  ++hash->resize_checks;
+  if (hash->elem_count >= 4 * old_slots->elem_count) {
+    new_size = 4 * old_slots->elem_count - 1;
+  }
+  else if (hash->elem_count <= old_slots->elem_count / 4) {
+    new_size = old_slots->elem_count / 4 + 1;
+    if (new_size < hash->minimal_slots) {
+      return;
+    }
+  }
+  else {
+    return;
+  }
+  sc_hash_resize (hash, new_size);
+}
+
+/** Find the list that contains an object if it is in the hash table.
+ * During incremental resize, this is in the old slots if not yet moved. */
+static sc_list_t   *
+sc_hash_find_list (sc_hash_t * hash, void *v)
+{
+  size_t              hval, oval;
+
+  hval = hash->hash_fn (v, hash->user_data);
+  if (hash->old_slots != NULL) {
+    oval = hval % hash->old_slots->elem_count;
+    if (oval >= hash->migrate_pos) {
+      return (sc_list_t *) sc_array_index (hash->old_slots, oval);
+    }
+  }
+  return (sc_list_t *)
+    sc_array_index (hash->slots, hval % hash->slots->elem_count);
+}
+
+sc_hash_t          *
+sc_hash_new (sc_hash_function_t hash_fn, sc_equal_function_t equal_fn,
+             void *user_data, sc_mempool_t * allocator)
+{
+  return sc_hash_new_ext (hash_fn, equal_fn, user_data, allocator, 0, 0);
+}
+
+sc_hash_t          *
+sc_hash_new_ext (sc_hash_function_t hash_fn, sc_equal_function_t equal_fn,
+                 void *user_data, sc_mempool_t * allocator,
+                 size_t expected_count, int incremental)
+{
+  sc_hash_t          *hash;
+
+  hash = SC_ALLOC (sc_hash_t, 1);
+
+  if (allocator != NULL) {
+    SC_ASSERT (allocator->elem_size == sizeof (sc_link_t));
+    hash->allocator = allocator;
+    hash->allocator_owned = 0;
+  }
+  else {
+    hash->allocator = sc_mempool_new (sizeof (sc_link_t));
+    hash->allocator_owned = 1;
+  }
+
+  hash->elem_count = 0;
+  hash->resize_checks = 0;
+  hash->resize_actions = 0;
+  hash->hash_fn = hash_fn;
+  hash->equal_fn = equal_fn;
+  hash->user_data = user_data;
+
+  /* the expected count is reached without resize at average load two */
+  hash->minimal_slots = SC_MAX (sc_hash_minimal_size, expected_count / 2 + 1);
+  hash->incremental = incremental;
+  hash->old_slots = NULL;
+  hash->migrate_pos = 0;
+  hash->slots = sc_hash_new_slots (hash, hash->minimal_slots);
+  sc_hash_set_count_probes (hash, 0);
 
   return hash;
 }
 
+void
+sc_hash_set_count_probes (sc_hash_t * hash, int enabled)
+{
+  hash->count_probes = enabled;
+  hash->lookups = hash->hits = hash->probes = hash->max_chain = 0;
+}
+
+/** Update the probe counters after searching a list.
+ * \param [in] probes       Number of calls to equal_fn.
+ * \param [in] hit          Boolean: the object was found.
+ */
+static void
+sc_hash_count (sc_hash_t * hash, sc_list_t * list, size_t probes, int hit)
+{
+  if (hash->count_probes) {
+    ++hash->lookups;
+    hash->hits += hit ? 1 : 0;
+    hash->probes += probes;
+    hash->max_chain = SC_MAX (hash->max_chain, list->elem_count);
+  }
+}
+
 void
 sc_hash_destroy (sc_hash_t * hash)
 {
@@ -1306,6 +3659,9 @@ sc_hash_destroy (sc_hash_t * hash)
     sc_hash_truncate (hash);
   }
   sc_array_destroy (hash->slots);
+  if (hash->old_slots != NULL) {
+    sc_array_destroy (hash->old_slots);
+  }
 
   SC_FREE (hash);
 }
@@ -1327,6 +3683,7 @@ sc_hash_truncate (sc_hash_t * hash)
   size_t              count;
   sc_list_t          *list;
   sc_array_t         *slots = hash->slots;
+  sc_array_t         *old_slots = hash->old_slots;
 
   if (hash->elem_count == 0) {
     return;
@@ -1344,6 +3701,11 @@ sc_hash_truncate (sc_hash_t * hash)
     count += list->elem_count;
     sc_list_reset (list);
   }
+  for (i = 0; old_slots != NULL && i < old_slots->elem_count; ++i) {
+    list = (sc_list_t *) sc_array_index (old_slots, i);
+    count += list->elem_count;
+    sc_list_reset (list);
+  }
   SC_ASSERT (count == hash->elem_count);
 
   hash->elem_count = 0;
@@ -1355,12 +3717,18 @@ sc_hash_unlink (sc_hash_t * hash)
   size_t              i, count;
   sc_list_t          *list;
   sc_array_t         *slots = hash->slots;
+  sc_array_t         *old_slots = hash->old_slots;
 
   for (i = 0, count = 0; i < slots->elem_count; ++i) {
     list = (sc_list_t *) sc_array_index (slots, i);
     count += list->elem_count;
     sc_list_unlink (list);
   }
+  for (i = 0; old_slots != NULL && i < old_slots->elem_count; ++i) {
+    list = (sc_list_t *) sc_array_index (old_slots, i);
+    count += list->elem_count;
+    sc_list_unlink (list);
+  }
   SC_ASSERT (count == hash->elem_count);
 
   hash->elem_count = 0;
@@ -1373,6 +3741,9 @@ sc_hash_unlink_destroy (sc_hash_t * hash)
     sc_mempool_destroy (hash->allocator);
   }
   sc_array_destroy (hash->slots);
+  if (hash->old_slots != NULL) {
+    sc_array_destroy (hash->old_slots);
+  }
 
   SC_FREE (hash);
 }
@@ -1380,44 +3751,55 @@ sc_hash_unlink_destroy (sc_hash_t * hash)
 int
 sc_hash_lookup (sc_hash_t * hash, void *v, void ***found)
 {
-  size_t              hval;
+  size_t              probes;
   sc_list_t          *list;
   sc_link_t          *lynk;
 
-  hval = hash->hash_fn (v, hash->user_data) % hash->slots->elem_count;
-  list = (sc_list_t *) sc_array_index (hash->slots, hval);
+  list = sc_hash_find_list (hash, v);
 
+  probes = 0;
   for (lynk = list->first; lynk != NULL; lynk = lynk->next) {
     /* check if an equal object is contained in the hash table */
+    ++probes;
     if (hash->equal_fn (lynk->data, v, hash->user_data)) {
       if (found != NULL) {
         *found = &lynk->data;
       }
+      sc_hash_count (hash, list, probes, 1);
       return 1;
     }
   }
+  sc_hash_count (hash, list, probes, 0);
   return 0;
 }
 
 int
 sc_hash_insert_unique (sc_hash_t * hash, void *v, void ***found)
 {
-  size_t              hval;
+  int                 count_probes;
+  size_t              probes;
   sc_list_t          *list;
   sc_link_t          *lynk;
 
-  hval = hash->hash_fn (v, hash->user_data) % hash->slots->elem_count;
-  list = (sc_list_t *) sc_array_index (hash->slots, hval);
+  /* move a few chains before the links are addressed */
+  if (hash->old_slots != NULL) {
+    sc_hash_migrate (hash, sc_hash_migrate_chains);
+  }
+  list = sc_hash_find_list (hash, v);
 
   /* check if an equal object is already contained in the hash table */
+  probes = 0;
   for (lynk = list->first; lynk != NULL; lynk = lynk->next) {
+    ++probes;
     if (hash->equal_fn (lynk->data, v, hash->user_data)) {
       if (found != NULL) {
         *found = &lynk->data;
       }
+      sc_hash_count (hash, list, probes, 1);
       return 0;
     }
   }
+  sc_hash_count (hash, list, probes, 0);
 
   /* append new object to the list */
   (void) sc_list_append (list, v);
@@ -1430,7 +3812,11 @@ sc_hash_insert_unique (sc_hash_t * hash, void *v, void ***found)
   if (hash->elem_count % hash->slots->elem_count == 0) {
     sc_hash_maybe_resize (hash);
     if (found != NULL) {
+      /* this internal lookup is not counted */
+      count_probes = hash->count_probes;
+      hash->count_probes = 0;
       SC_EXECUTE_ASSERT_TRUE (sc_hash_lookup (hash, v, found));
+      hash->count_probes = count_probes;
     }
   }
 
@@ -1440,20 +3826,25 @@ sc_hash_insert_unique (sc_hash_t * hash, void *v, void ***found)
 int
 sc_hash_remove (sc_hash_t * hash, void *v, void **found)
 {
-  size_t              hval;
+  size_t              probes;
   sc_list_t          *list;
   sc_link_t          *lynk, *prev;
 
-  hval = hash->hash_fn (v, hash->user_data) % hash->slots->elem_count;
-  list = (sc_list_t *) sc_array_index (hash->slots, hval);
+  if (hash->old_slots != NULL) {
+    sc_hash_migrate (hash, sc_hash_migrate_chains);
+  }
+  list = sc_hash_find_list (hash, v);
 
   prev = NULL;
+  probes = 0;
   for (lynk = list->first; lynk != NULL; lynk = lynk->next) {
     /* check if an equal object is contained in the hash table */
+    ++probes;
     if (hash->equal_fn (lynk->data, v, hash->user_data)) {
       if (found != NULL) {
         *found = lynk->data;
       }
+      sc_hash_count (hash, list, probes, 1);
       (void) sc_list_remove (list, prev);
       --hash->elem_count;
 
@@ -1465,6 +3856,7 @@ sc_hash_remove (sc_hash_t * hash, void *v, void **found)
     }
     prev = lynk;
   }
+  sc_hash_count (hash, list, probes, 0);
   return 0;
 }
 
@@ -1474,6 +3866,7 @@ sc_hash_foreach (sc_hash_t * hash, sc_hash_foreach_t fn)
   size_t              slot;
   sc_list_t          *list;
   sc_link_t          *lynk;
+  sc_array_t         *old_slots = hash->old_slots;
 
   for (slot = 0; slot < hash->slots->elem_count; ++slot) {
     list = (sc_list_t *) sc_array_index (hash->slots, slot);
@@ -1483,6 +3876,17 @@ sc_hash_foreach (sc_hash_t * hash, sc_hash_foreach_t fn)
       }
     }
   }
+
+  /* the old slots below the migration position are empty */
+  for (slot = hash->migrate_pos;
+       old_slots != NULL && slot < old_slots->elem_count; ++slot) {
+    list = (sc_list_t *) sc_array_index (old_slots, slot);
+    for (lynk = list->first; lynk != NULL; lynk = lynk->next) {
+      if (!fn (&lynk->data, hash->user_data)) {
+        return;
+      }
+    }
+  }
 }
 
 void
@@ -1502,17 +3906,32 @@ sc_hash_print_statistics (int package_id, int log_priority, sc_hash_t * hash)
     sum += a;
     squaresum += a * a;
   }
+  if (hash->old_slots != NULL) {
+    /* the objects not yet moved are counted without their distribution */
+    for (i = hash->migrate_pos; i < hash->old_slots->elem_count; ++i) {
+      list = (sc_list_t *) sc_array_index (hash->old_slots, i);
+      sum += (double) list->elem_count;
+    }
+  }
   SC_ASSERT ((size_t) sum == hash->elem_count);
 
   divide = (double) slots->elem_count;
   avg = sum / divide;
   sqr = squaresum / divide - avg * avg;
-  std = sqrt (sqr);
+  std = sqrt (SC_MAX (sqr, 0.));
   SC_GEN_LOGF (package_id, SC_LC_NORMAL, log_priority,
                "Hash size %lu avg %.3g std %.3g checks %lu %lu\n",
                (unsigned long) slots->elem_count, avg, std,
                (unsigned long) hash->resize_checks,
                (unsigned long) hash->resize_actions);
+  if (hash->count_probes) {
+    SC_GEN_LOGF (package_id, SC_LC_NORMAL, log_priority,
+                 "Hash lookups %lu hits %lu probes %.3g max chain %lu\n",
+                 (unsigned long) hash->lookups, (unsigned long) hash->hits,
+                 hash->lookups > 0 ?
+                 (double) hash->probes / (double) hash->lookups : 0.,
+                 (unsigned long) hash->max_chain);
+  }
 }
 
 /* hash array routines */
@@ -1520,8 +3939,9 @@ sc_hash_print_statistics (int package_id, int log_priority, sc_hash_t * hash)
 size_t
 sc_hash_array_memory_used (sc_hash_array_t * ha)
 {
-  return sizeof (sc_hash_array_t) +
-    sc_array_memory_used (&ha->a, 0) + sc_hash_memory_used (ha->h);
+  return sizeof (sc_hash_array_t) + sc_array_memory_used (&ha->a, 0) +
+    (ha->h != NULL ? sc_hash_memory_used (ha->h) : 0) +
+    (ha->frozen != NULL ? (sizeof (size_t) << ha->frozen_bits) : 0);
 }
 
 static unsigned int
@@ -1571,14 +3991,29 @@ sc_hash_array_new (size_t elem_size, sc_hash_function_t hash_fn,
   hash_array->internal_data.current_item = NULL;
   hash_array->h = sc_hash_new (sc_hash_array_hash_fn, sc_hash_array_equal_fn,
                                &hash_array->internal_data, NULL);
+  hash_array->frozen = NULL;
+  hash_array->frozen_bits = 0;
 
   return hash_array;
 }
 
+/* free the hash table or the frozen index, whichever exists */
+static void
+sc_hash_array_free_index (sc_hash_array_t * hash_array)
+{
+  if (hash_array->h != NULL) {
+    sc_hash_destroy (hash_array->h);
+    hash_array->h = NULL;
+  }
+  SC_FREE (hash_array->frozen);
+  hash_array->frozen = NULL;
+  hash_array->frozen_bits = 0;
+}
+
 void
 sc_hash_array_destroy (sc_hash_array_t * hash_array)
 {
-  sc_hash_destroy (hash_array->h);
+  sc_hash_array_free_index (hash_array);
   sc_array_reset (&hash_array->a);
 
   SC_FREE (hash_array);
@@ -1605,16 +4040,107 @@ sc_hash_array_is_valid (sc_hash_array_t * hash_array)
 void
 sc_hash_array_truncate (sc_hash_array_t * hash_array)
 {
-  sc_hash_truncate (hash_array->h);
+  if (hash_array->frozen != NULL) {
+    sc_hash_array_free_index (hash_array);
+    hash_array->h = sc_hash_new (sc_hash_array_hash_fn,
+                                 sc_hash_array_equal_fn,
+                                 &hash_array->internal_data, NULL);
+  }
+  else {
+    sc_hash_truncate (hash_array->h);
+  }
   sc_array_reset (&hash_array->a);
 }
 
+/** The empty slot of the frozen index. */
+#define SC_HASH_ARRAY_FROZEN_EMPTY ((size_t) -1)
+
+/** Map a hash value to its home slot in the frozen index. */
+static inline size_t
+sc_hash_array_frozen_home (unsigned int h, int bits)
+{
+  return (size_t) (((uint64_t) h * 0x9E3779B97F4A7C15ULL) >> (64 - bits));
+}
+
+/** Find an object by linear probing in the frozen index. */
+static int
+sc_hash_array_frozen_lookup (sc_hash_array_t * hash_array, void *v,
+                             size_t *position)
+{
+  sc_hash_array_data_t *internal_data = &hash_array->internal_data;
+  const size_t        mask = (((size_t) 1) << hash_array->frozen_bits) - 1;
+  size_t              pos, zz;
+
+  pos = sc_hash_array_frozen_home (internal_data->hash_fn
+                                   (v, internal_data->user_data),
+                                   hash_array->frozen_bits);
+  while ((zz = hash_array->frozen[pos]) != SC_HASH_ARRAY_FROZEN_EMPTY) {
+    if (internal_data->equal_fn (sc_array_index (&hash_array->a, zz), v,
+                                 internal_data->user_data)) {
+      if (position != NULL) {
+        *position = zz;
+      }
+      return 1;
+    }
+    pos = (pos + 1) & mask;
+  }
+  return 0;
+}
+
+void
+sc_hash_array_freeze (sc_hash_array_t * hash_array)
+{
+  sc_hash_array_data_t *internal_data = &hash_array->internal_data;
+  const size_t        n = hash_array->a.elem_count;
+  int                 bits;
+  size_t              zz, pos, mask, num_slots, *frozen;
+
+  if (hash_array->frozen != NULL) {
+    return;
+  }
+  SC_ASSERT (hash_array->h != NULL && hash_array->h->elem_count == n);
+
+  /* keep the load at most one half */
+  for (bits = 1; (((size_t) 1) << bits) < 2 * n; ++bits);
+  num_slots = ((size_t) 1) << bits;
+  mask = num_slots - 1;
+  frozen = SC_ALLOC (size_t, num_slots);
+  for (pos = 0; pos < num_slots; ++pos) {
+    frozen[pos] = SC_HASH_ARRAY_FROZEN_EMPTY;
+  }
+
+  /* the objects are unique, so we insert without comparing */
+  for (zz = 0; zz < n; ++zz) {
+    pos = sc_hash_array_frozen_home (internal_data->hash_fn
+                                     (sc_array_index (&hash_array->a, zz),
+                                      internal_data->user_data), bits);
+    while (frozen[pos] != SC_HASH_ARRAY_FROZEN_EMPTY) {
+      pos = (pos + 1) & mask;
+    }
+    frozen[pos] = zz;
+  }
+
+  sc_hash_array_free_index (hash_array);
+  hash_array->frozen = frozen;
+  hash_array->frozen_bits = bits;
+}
+
+int
+sc_hash_array_is_frozen (sc_hash_array_t * hash_array)
+{
+  return hash_array->frozen != NULL;
+}
+
 int
 sc_hash_array_lookup (sc_hash_array_t * hash_array, void *v, size_t *position)
 {
   int                 found;
   void              **found_void;
 
+  if (hash_array->frozen != NULL) {
+    return sc_hash_array_frozen_lookup (hash_array, v, position);
+  }
+
   hash_array->internal_data.current_item = v;
   found = sc_hash_lookup (hash_array->h, (void *) (-1L), &found_void);
   hash_array->internal_data.current_item = NULL;
@@ -1637,6 +4163,7 @@ sc_hash_array_insert_unique (sc_hash_array_t * hash_array, void *v,
   int                 added;
   void              **found_void;
 
+  SC_ASSERT (hash_array->frozen == NULL);
   SC_ASSERT (hash_array->a.elem_count == hash_array->h->elem_count);
 
   hash_array->internal_data.current_item = v;
@@ -1658,20 +4185,653 @@ sc_hash_array_insert_unique (sc_hash_array_t * hash_array, void *v,
   }
 }
 
+/** Number of items to look ahead when prefetching in batch operations. */
+static const size_t sc_hash_array_prefetch = 8;
+
+/** Compute the hash slot of every item and store it in positions.
+ * Prefetch the first slots that will be probed. */
+static void
+sc_hash_array_slots_batch (sc_hash_array_t * hash_array, sc_array_t * items,
+                           size_t *pos)
+{
+  const size_t        n = items->elem_count;
+  const size_t        num_slots = hash_array->h->slots->elem_count;
+  sc_hash_array_data_t *internal_data = &hash_array->internal_data;
+  size_t              zz;
+
+  /* the hash array does not use incremental resize */
+  SC_ASSERT (hash_array->h->old_slots == NULL);
+
+  for (zz = 0; zz < n; ++zz) {
+    pos[zz] = internal_data->hash_fn (sc_array_index (items, zz),
+                                      internal_data->user_data) % num_slots;
+  }
+  for (zz = 0; zz < SC_MIN (n, sc_hash_array_prefetch); ++zz) {
+    SC_PREFETCH (sc_array_index (hash_array->h->slots, pos[zz]));
+  }
+}
+
+/** Find an item in the slot list whose slot has been computed before.
+ * Prefetch the slot list that is probed sc_hash_array_prefetch items later.
+ * \return          The link pointing to the contained item or NULL. */
+static sc_link_t   *
+sc_hash_array_probe_batch (sc_hash_array_t * hash_array, sc_array_t * items,
+                           size_t *pos, size_t zz, sc_list_t ** plist)
+{
+  sc_hash_array_data_t *internal_data = &hash_array->internal_data;
+  sc_array_t         *slots = hash_array->h->slots;
+  sc_link_t          *lynk;
+  void               *v;
+
+  if (zz + sc_hash_array_prefetch < items->elem_count) {
+    SC_PREFETCH (sc_array_index (slots, pos[zz + sc_hash_array_prefetch]));
+  }
+
+  v = sc_array_index (items, zz);
+  *plist = (sc_list_t *) sc_array_index (slots, pos[zz]);
+  for (lynk = (*plist)->first; lynk != NULL; lynk = lynk->next) {
+    if (internal_data->equal_fn (sc_array_index (&hash_array->a,
+                                                 (size_t) lynk->data), v,
+                                 internal_data->user_data)) {
+      return lynk;
+    }
+  }
+  return NULL;
+}
+
+size_t
+sc_hash_array_lookup_batch (sc_hash_array_t * hash_array,
+                            sc_array_t * items, sc_array_t * positions)
+{
+  size_t              zz, found;
+  size_t             *pos;
+  sc_list_t          *list;
+  sc_link_t          *lynk;
+
+  SC_ASSERT (items != NULL && items->elem_size == hash_array->a.elem_size);
+  SC_ASSERT (positions != NULL && positions->elem_size == sizeof (size_t));
+
+  sc_array_resize (positions, items->elem_count);
+  if (items->elem_count == 0) {
+    return 0;
+  }
+  pos = (size_t *) positions->array;
+  if (hash_array->frozen != NULL) {
+    for (zz = 0, found = 0; zz < items->elem_count; ++zz) {
+      if (sc_hash_array_frozen_lookup (hash_array,
+                                       sc_array_index (items, zz),
+                                       &pos[zz])) {
+        ++found;
+      }
+      else {
+        pos[zz] = (size_t) -1;
+      }
+    }
+    return found;
+  }
+  sc_hash_array_slots_batch (hash_array, items, pos);
+
+  /* the slot number of each item is replaced by its position */
+  for (zz = 0, found = 0; zz < items->elem_count; ++zz) {
+    lynk = sc_hash_array_probe_batch (hash_array, items, pos, zz, &list);
+    if (lynk != NULL) {
+      pos[zz] = (size_t) lynk->data;
+      ++found;
+    }
+    else {
+      pos[zz] = (size_t) -1;
+    }
+  }
+
+  return found;
+}
+
+size_t
+sc_hash_array_insert_batch (sc_hash_array_t * hash_array,
+                            sc_array_t * items, sc_array_t * positions)
+{
+  size_t              zz, added, expected;
+  size_t             *pos;
+  sc_hash_t          *h = hash_array->h;
+  sc_list_t          *list;
+  sc_link_t          *lynk;
+
+  SC_ASSERT (hash_array->frozen == NULL);
+  SC_ASSERT (hash_array->a.elem_count == h->elem_count);
+  SC_ASSERT (items != NULL && items->elem_size == hash_array->a.elem_size);
+  SC_ASSERT (items != &hash_array->a);
+  SC_ASSERT (positions != NULL && positions->elem_size == sizeof (size_t));
+
+  sc_array_resize (positions, items->elem_count);
+  if (items->elem_count == 0) {
+    return 0;
+  }
+  pos = (size_t *) positions->array;
+
+  /* resize once for the maximum number of elements after the batch */
+  expected = h->elem_count + items->elem_count;
+  if (expected >= 4 * h->slots->elem_count) {
+    sc_hash_resize (h, expected / 2 + 1);
+  }
+  sc_hash_array_slots_batch (hash_array, items, pos);
+
+  /* no resize is triggered below since we do not exceed expected */
+  for (zz = 0, added = 0; zz < items->elem_count; ++zz) {
+    lynk = sc_hash_array_probe_batch (hash_array, items, pos, zz, &list);
+    if (lynk != NULL) {
+      pos[zz] = (size_t) lynk->data;
+    }
+    else {
+      pos[zz] = hash_array->a.elem_count;
+      (void) sc_list_append (list, (void *) hash_array->a.elem_count);
+      memcpy (sc_array_push (&hash_array->a), sc_array_index (items, zz),
+              hash_array->a.elem_size);
+      ++h->elem_count;
+      ++added;
+    }
+  }
+
+  return added;
+}
+
 void
 sc_hash_array_rip (sc_hash_array_t * hash_array, sc_array_t * rip)
 {
-  sc_hash_destroy (hash_array->h);
+  sc_hash_array_free_index (hash_array);
   memcpy (rip, &hash_array->a, sizeof (sc_array_t));
 
   SC_FREE (hash_array);
 }
 
+/** Context to sort positions by the elements they refer to. */
+typedef struct sc_hash_array_sort
+{
+  sc_array_t         *array;
+  int                 (*compar) (const void *, const void *);
+}
+sc_hash_array_sort_t;
+
+static int
+sc_hash_array_compare_positions (const void *v1, const void *v2, void *arg)
+{
+  sc_hash_array_sort_t *s = (sc_hash_array_sort_t *) arg;
+  int                 c;
+  size_t              p1 = *(const size_t *) v1;
+  size_t              p2 = *(const size_t *) v2;
+
+  c = s->compar (sc_array_index (s->array, p1),
+                 sc_array_index (s->array, p2));
+  return c != 0 ? c : (p1 < p2 ? -1 : p1 > p2);
+}
+
+void
+sc_hash_array_rip_sorted (sc_hash_array_t * hash_array, sc_array_t * rip,
+                          int (*compar) (const void *, const void *),
+                          sc_array_t * newindices)
+{
+  size_t              zz, n, *order, *newpos;
+  sc_hash_array_sort_t s;
+
+  sc_hash_array_rip (hash_array, rip);
+  if (newindices == NULL) {
+    sc_array_sort (rip, compar);
+    return;
+  }
+  SC_ASSERT (newindices->elem_size == sizeof (size_t));
+
+  /* sort the positions and invert the order into the new indices */
+  n = rip->elem_count;
+  order = SC_ALLOC (size_t, n);
+  for (zz = 0; zz < n; ++zz) {
+    order[zz] = zz;
+  }
+  s.array = rip;
+  s.compar = compar;
+  sc_qsort_r (order, n, sizeof (size_t), sc_hash_array_compare_positions,
+              &s);
+  sc_array_resize (newindices, n);
+  newpos = (size_t *) newindices->array;
+  for (zz = 0; zz < n; ++zz) {
+    newpos[order[zz]] = zz;
+  }
+  SC_FREE (order);
+  sc_array_permute_inplace (rip, newindices);
+}
+
+/* open addressing hash table routines */
+
+static const int    sc_ohash_minimal_bits = 4;
+static const int    sc_ohash_maximal_dist = 255;
+
+/** Map a hash value to its home slot by Fibonacci hashing.
+ * This spreads the bits of weak hash functions over the whole table. */
+static inline size_t
+sc_ohash_home (unsigned int h, int bits)
+{
+  return (size_t) (((uint64_t) h * 0x9E3779B97F4A7C15ULL) >> (64 - bits));
+}
+
+static inline char *
+sc_ohash_slot (sc_ohash_t * ohash, size_t pos)
+{
+  return ohash->slots + pos * ohash->elem_size;
+}
+
+static void
+sc_ohash_alloc_slots (sc_ohash_t * ohash, int bits)
+{
+  SC_ASSERT (bits >= sc_ohash_minimal_bits && bits < 64);
+
+  ohash->slot_bits = bits;
+  ohash->slot_count = (size_t) 1 << bits;
+  ohash->dist = SC_ALLOC_ZERO (unsigned char, ohash->slot_count);
+  ohash->hval = SC_ALLOC (unsigned int, ohash->slot_count);
+  ohash->slots = SC_ALLOC (char, ohash->slot_count * ohash->elem_size);
+  ohash->stash = sc_array_new (ohash->elem_size);
+  ohash->stash_hval = sc_array_new (sizeof (unsigned int));
+}
+
+static void
+sc_ohash_free_slots (unsigned char *dist, unsigned int *hval, char *slots,
+                     sc_array_t * stash, sc_array_t * stash_hval)
+{
+  SC_FREE (dist);
+  SC_FREE (hval);
+  SC_FREE (slots);
+  sc_array_destroy (stash);
+  sc_array_destroy (stash_hval);
+}
+
+/** Move the element in the carry buffer into the overflow stash.
+ * 
+eturn          The address of the element in the stash.
+ */
+static char        *
+sc_ohash_stash_carry (sc_ohash_t * ohash, unsigned int h)
+{
+  char               *slot;
+
+  slot = (char *) sc_array_push (ohash->stash);
+  memcpy (slot, ohash->temp + ohash->elem_size, ohash->elem_size);
+  *(unsigned int *) sc_array_push (ohash->stash_hval) = h;
+  return slot;
+}
+
+/** Place the element in the carry buffer that is known not to be contained.
+ * \param [in,out] h        On input the hash value of the carried element.
+ *                          On failure, the hash value of the element that
+ *                          is left in the carry buffer.
+ * \param [in,out] first    If not NULL, set to the slot address of the
+ *                          element carried on input on success.
+ * \return                  True on success, false if the maximum probe
+ *                          distance would be exceeded.  Then the carry
+ *                          buffer contains an element not in the table.
+ */
+static int
+sc_ohash_place (sc_ohash_t * ohash, unsigned int *h, char **first)
+{
+  const size_t        es = ohash->elem_size;
+  const size_t        mask = ohash->slot_count - 1;
+  char               *temp = ohash->temp;
+  char               *carry = ohash->temp + es;
+  char               *slot;
+  unsigned char       dt;
+  unsigned int        ht, hc = *h;
+  size_t              pos;
+  int                 d;
+
+  pos = sc_ohash_home (hc, ohash->slot_bits);
+  for (d = 1; d <= sc_ohash_maximal_dist; ++d) {
+    slot = sc_ohash_slot (ohash, pos);
+    if (ohash->dist[pos] == 0) {
+      /* an empty slot terminates the insertion */
+      ohash->dist[pos] = (unsigned char) d;
+      ohash->hval[pos] = hc;
+      memcpy (slot, carry, es);
+      if (first != NULL && *first == NULL) {
+        *first = slot;
+      }
+      return 1;
+    }
+    if ((int) ohash->dist[pos] < d) {
+      /* the carried element is poorer than the resident: swap them */
+      memcpy (temp, slot, es);
+      memcpy (slot, carry, es);
+      memcpy (carry, temp, es);
+      dt = ohash->dist[pos];
+      ohash->dist[pos] = (unsigned char) d;
+      d = (int) dt;
+      ht = ohash->hval[pos];
+      ohash->hval[pos] = hc;
+      hc = ht;
+      if (first != NULL && *first == NULL) {
+        *first = slot;
+      }
+    }
+    pos = (pos + 1) & mask;
+  }
+
+  /* the probe sequence is too long */
+  *h = hc;
+  return 0;
+}
+
+/** Rehash all elements, including the stash, into 2**bits slots.
+ * Elements that exceed the maximal distance go into the new stash. */
+static void
+sc_ohash_rebuild (sc_ohash_t * ohash, int bits)
+{
+  const size_t        es = ohash->elem_size;
+  const size_t        old_count = ohash->slot_count;
+  unsigned char      *old_dist = ohash->dist;
+  unsigned int       *old_hval = ohash->hval;
+  char               *old_slots = ohash->slots;
+  sc_array_t         *old_stash = ohash->stash;
+  sc_array_t         *old_stash_hval = ohash->stash_hval;
+  unsigned int        h;
+  size_t              zz;
+
+  ++ohash->resize_actions;
+  sc_ohash_alloc_slots (ohash, bits);
+  for (zz = 0; zz < old_count; ++zz) {
+    if (old_dist[zz] == 0) {
+      continue;
+    }
+    memcpy (ohash->temp + es, old_slots + zz * es, es);
+    h = old_hval[zz];
+    if (!sc_ohash_place (ohash, &h, NULL)) {
+      (void) sc_ohash_stash_carry (ohash, h);
+    }
+  }
+  for (zz = 0; zz < old_stash->elem_count; ++zz) {
+    memcpy (ohash->temp + es, sc_array_index (old_stash, zz), es);
+    h = *(unsigned int *) sc_array_index (old_stash_hval, zz);
+    if (!sc_ohash_place (ohash, &h, NULL)) {
+      (void) sc_ohash_stash_carry (ohash, h);
+    }
+  }
+  sc_ohash_free_slots (old_dist, old_hval, old_slots,
+                       old_stash, old_stash_hval);
+}
+
+size_t
+sc_ohash_memory_used (sc_ohash_t * ohash)
+{
+  return sizeof (sc_ohash_t) + 2 * ohash->elem_size +
+    ohash->slot_count * (sizeof (unsigned char) + sizeof (unsigned int) +
+                         ohash->elem_size) +
+    sc_array_memory_used (ohash->stash, 1) +
+    sc_array_memory_used (ohash->stash_hval, 1);
+}
+
+sc_ohash_t         *
+sc_ohash_new (size_t elem_size, sc_hash_function_t hash_fn,
+              sc_equal_function_t equal_fn, void *user_data)
+{
+  sc_ohash_t         *ohash;
+
+  SC_ASSERT (elem_size > 0);
+  SC_ASSERT (hash_fn != NULL && equal_fn != NULL);
+
+  ohash = SC_ALLOC (sc_ohash_t, 1);
+  ohash->elem_size = elem_size;
+  ohash->elem_count = 0;
+  ohash->temp = SC_ALLOC (char, 2 * elem_size);
+  ohash->user_data = user_data;
+  ohash->hash_fn = hash_fn;
+  ohash->equal_fn = equal_fn;
+  ohash->resize_actions = 0;
+  sc_ohash_alloc_slots (ohash, sc_ohash_minimal_bits);
+
+  return ohash;
+}
+
+void
+sc_ohash_destroy (sc_ohash_t * ohash)
+{
+  sc_ohash_free_slots (ohash->dist, ohash->hval, ohash->slots,
+                       ohash->stash, ohash->stash_hval);
+  SC_FREE (ohash->temp);
+
+  SC_FREE (ohash);
+}
+
+void
+sc_ohash_truncate (sc_ohash_t * ohash)
+{
+  sc_ohash_free_slots (ohash->dist, ohash->hval, ohash->slots,
+                       ohash->stash, ohash->stash_hval);
+  sc_ohash_alloc_slots (ohash, sc_ohash_minimal_bits);
+  ohash->elem_count = 0;
+}
+
+/** Find the slot position of an object.
+ * \return          The position or slot_count if it is not contained. */
+static size_t
+sc_ohash_find (sc_ohash_t * ohash, const void *v, unsigned int h)
+{
+  const size_t        mask = ohash->slot_count - 1;
+  size_t              pos;
+  int                 d;
+
+  pos = sc_ohash_home (h, ohash->slot_bits);
+  for (d = 1;; ++d) {
+    /* an empty slot or a richer resident ends the search */
+    if ((int) ohash->dist[pos] < d) {
+      return ohash->slot_count;
+    }
+    if (ohash->hval[pos] == h &&
+        ohash->equal_fn (sc_ohash_slot (ohash, pos), v, ohash->user_data)) {
+      return pos;
+    }
+    pos = (pos + 1) & mask;
+  }
+}
+
+/** Find the stash position of an object.
+ * \return          The position or the stash count if it is not contained. */
+static size_t
+sc_ohash_find_stash (sc_ohash_t * ohash, const void *v, unsigned int h)
+{
+  const unsigned int *hval = (const unsigned int *) ohash->stash_hval->array;
+  const size_t        count = ohash->stash->elem_count;
+  size_t              zz;
+
+  for (zz = 0; zz < count; ++zz) {
+    if (hval[zz] == h &&
+        ohash->equal_fn (sc_array_index (ohash->stash, zz), v,
+                         ohash->user_data)) {
+      return zz;
+    }
+  }
+  return count;
+}
+
+int
+sc_ohash_lookup (sc_ohash_t * ohash, const void *v, void **found)
+{
+  unsigned int        h;
+  size_t              pos;
+
+  h = ohash->hash_fn (v, ohash->user_data);
+  pos = sc_ohash_find (ohash, v, h);
+  if (pos < ohash->slot_count) {
+    if (found != NULL) {
+      *found = sc_ohash_slot (ohash, pos);
+    }
+    return 1;
+  }
+  pos = sc_ohash_find_stash (ohash, v, h);
+  if (pos < ohash->stash->elem_count) {
+    if (found != NULL) {
+      *found = sc_array_index (ohash->stash, pos);
+    }
+    return 1;
+  }
+  return 0;
+}
+
+int
+sc_ohash_insert_unique (sc_ohash_t * ohash, const void *v, void **found)
+{
+  const size_t        es = ohash->elem_size;
+  unsigned int        h;
+  size_t              pos;
+  char               *first, *slot;
+
+  h = ohash->hash_fn (v, ohash->user_data);
+  pos = sc_ohash_find (ohash, v, h);
+  if (pos < ohash->slot_count) {
+    if (found != NULL) {
+      *found = sc_ohash_slot (ohash, pos);
+    }
+    return 0;
+  }
+  pos = sc_ohash_find_stash (ohash, v, h);
+  if (pos < ohash->stash->elem_count) {
+    if (found != NULL) {
+      *found = sc_array_index (ohash->stash, pos);
+    }
+    return 0;
+  }
+
+  /* keep the load factor below 7/8 */
+  if (8 * (ohash->elem_count + 1) > 7 * ohash->slot_count) {
+    sc_ohash_rebuild (ohash, ohash->slot_bits + 1);
+  }
+
+  first = NULL;
+  memcpy (ohash->temp + es, v, es);
+  if (!sc_ohash_place (ohash, &h, &first)) {
+    /* rare case: growing the table does not separate equal hash values,
+       so the element left over goes into the stash */
+    slot = sc_ohash_stash_carry (ohash, h);
+    if (first == NULL) {
+      /* the new element itself was never placed */
+      first = slot;
+    }
+  }
+  ++ohash->elem_count;
+
+  if (found != NULL) {
+    *found = first;
+  }
+  return 1;
+}
+
+int
+sc_ohash_remove (sc_ohash_t * ohash, const void *v, void *found)
+{
+  const size_t        es = ohash->elem_size;
+  const size_t        mask = ohash->slot_count - 1;
+  unsigned int        h;
+  size_t              pos, next, last;
+
+  h = ohash->hash_fn (v, ohash->user_data);
+  pos = sc_ohash_find (ohash, v, h);
+  if (pos < ohash->slot_count) {
+    if (found != NULL) {
+      memcpy (found, sc_ohash_slot (ohash, pos), es);
+    }
+
+    /* backward shift deletion keeps the table free of tombstones */
+    for (next = (pos + 1) & mask; ohash->dist[next] > 1;
+         pos = next, next = (next + 1) & mask) {
+      ohash->dist[pos] = (unsigned char) (ohash->dist[next] - 1);
+      ohash->hval[pos] = ohash->hval[next];
+      memcpy (sc_ohash_slot (ohash, pos), sc_ohash_slot (ohash, next), es);
+    }
+    ohash->dist[pos] = 0;
+  }
+  else {
+    pos = sc_ohash_find_stash (ohash, v, h);
+    if (pos == ohash->stash->elem_count) {
+      return 0;
+    }
+    if (found != NULL) {
+      memcpy (found, sc_array_index (ohash->stash, pos), es);
+    }
+
+    /* the stash is unordered: move its last element into the gap */
+    last = ohash->stash->elem_count - 1;
+    if (pos < last) {
+      memcpy (sc_array_index (ohash->stash, pos),
+              sc_array_index (ohash->stash, last), es);
+      *(unsigned int *) sc_array_index (ohash->stash_hval, pos) =
+        *(unsigned int *) sc_array_index (ohash->stash_hval, last);
+    }
+    sc_array_resize (ohash->stash, last);
+    sc_array_resize (ohash->stash_hval, last);
+  }
+  --ohash->elem_count;
+
+  /* shrink the table when it is mostly empty */
+  if (ohash->slot_bits > sc_ohash_minimal_bits &&
+      8 * ohash->elem_count < ohash->slot_count) {
+    sc_ohash_rebuild (ohash, ohash->slot_bits - 1);
+  }
+  return 1;
+}
+
+void
+sc_ohash_foreach (sc_ohash_t * ohash, sc_ohash_foreach_t fn)
+{
+  size_t              zz;
+
+  for (zz = 0; zz < ohash->slot_count; ++zz) {
+    if (ohash->dist[zz] > 0) {
+      if (!fn (sc_ohash_slot (ohash, zz), ohash->user_data)) {
+        return;
+      }
+    }
+  }
+  for (zz = 0; zz < ohash->stash->elem_count; ++zz) {
+    if (!fn (sc_array_index (ohash->stash, zz), ohash->user_data)) {
+      return;
+    }
+  }
+}
+
+void
+sc_ohash_print_statistics (int package_id, int log_priority,
+                           sc_ohash_t * ohash)
+{
+  size_t              zz, count;
+  int                 maxdist;
+  double              a, sum, squaresum;
+  double              avg, sqr, std;
+
+  count = 0;
+  maxdist = 0;
+  sum = squaresum = 0.;
+  for (zz = 0; zz < ohash->slot_count; ++zz) {
+    if (ohash->dist[zz] > 0) {
+      ++count;
+      a = (double) ohash->dist[zz];
+      sum += a;
+      squaresum += a * a;
+      maxdist = SC_MAX (maxdist, (int) ohash->dist[zz]);
+    }
+  }
+  SC_ASSERT (count + ohash->stash->elem_count == ohash->elem_count);
+
+  avg = count > 0 ? sum / (double) count : 0.;
+  sqr = count > 0 ? squaresum / (double) count - avg * avg : 0.;
+  std = sqrt (SC_MAX (sqr, 0.));
+  SC_GEN_LOGF (package_id, SC_LC_NORMAL, log_priority,
+               "Ohash size %lu load %.3g probes avg %.3g std %.3g max %d"
+               " stash %lu resizes %lu\n", (unsigned long) ohash->slot_count,
+               (double) count / (double) ohash->slot_count, avg, std,
+               maxdist, (unsigned long) ohash->stash->elem_count,
+               (unsigned long) ohash->resize_actions);
+}
+
 void
 sc_recycle_array_init (sc_recycle_array_t * rec_array, size_t elem_size)
 {
   sc_array_init (&rec_array->a, elem_size);
   sc_array_init (&rec_array->f, sizeof (size_t));
+  sc_array_init (&rec_array->v, sizeof (uint64_t));
 
   rec_array->elem_count = 0;
 }
@@ -1684,10 +4844,18 @@ sc_recycle_array_reset (sc_recycle_array_t * rec_array)
 
   sc_array_reset (&rec_array->a);
   sc_array_reset (&rec_array->f);
+  sc_array_reset (&rec_array->v);
 
   rec_array->elem_count = 0;
 }
 
+/* the word of the validity bitmap holding a slot */
+static inline uint64_t *
+sc_recycle_array_word (sc_recycle_array_t * rec_array, size_t position)
+{
+  return (uint64_t *) sc_array_index (&rec_array->v, position >> 6);
+}
+
 void               *
 sc_recycle_array_insert (sc_recycle_array_t * rec_array, size_t *position)
 {
@@ -1701,7 +4869,12 @@ sc_recycle_array_insert (sc_recycle_array_t * rec_array, size_t *position)
   else {
     newpos = rec_array->a.elem_count;
     newitem = sc_array_push (&rec_array->a);
+    if ((newpos & 63) == 0) {
+      *(uint64_t *) sc_array_push (&rec_array->v) = 0;
+    }
   }
+  SC_ASSERT (!sc_recycle_array_is_valid (rec_array, newpos));
+  *sc_recycle_array_word (rec_array, newpos) |= (uint64_t) 1 << (newpos & 63);
 
   if (position != NULL) {
     *position = newpos;
@@ -1715,9 +4888,93 @@ void               *
 sc_recycle_array_remove (sc_recycle_array_t * rec_array, size_t position)
 {
   SC_ASSERT (rec_array->elem_count > 0);
+  SC_ASSERT (sc_recycle_array_is_valid (rec_array, position));
 
   *(size_t *) sc_array_push (&rec_array->f) = position;
+  *sc_recycle_array_word (rec_array, position) &=
+    ~((uint64_t) 1 << (position & 63));
   --rec_array->elem_count;
 
   return sc_array_index (&rec_array->a, position);
 }
+
+int
+sc_recycle_array_is_valid (sc_recycle_array_t * rec_array, size_t position)
+{
+  SC_ASSERT (position < rec_array->a.elem_count);
+
+  return (int) ((*sc_recycle_array_word (rec_array, position) >>
+                 (position & 63)) & 1);
+}
+
+size_t
+sc_recycle_array_next (sc_recycle_array_t * rec_array, size_t position)
+{
+  size_t              wi;
+  uint64_t            w;
+
+  SC_ASSERT (position <= rec_array->a.elem_count);
+
+  if (position == rec_array->a.elem_count) {
+    return position;
+  }
+
+  /* bits above the array size are never set */
+  wi = position >> 6;
+  w = *(uint64_t *) sc_array_index (&rec_array->v, wi) &
+    (~(uint64_t) 0 << (position & 63));
+  while (w == 0) {
+    if (++wi == rec_array->v.elem_count) {
+      return rec_array->a.elem_count;
+    }
+    w = *(uint64_t *) sc_array_index (&rec_array->v, wi);
+  }
+  return (wi << 6) + (size_t) sc_bitset_ctz (w);
+}
+
+void
+sc_recycle_array_compact (sc_recycle_array_t * rec_array,
+                          sc_array_t * index_map)
+{
+  const size_t        size = rec_array->a.elem_size;
+  const size_t        old_count = rec_array->a.elem_count;
+  size_t              iz, jz, *map;
+
+  SC_ASSERT (index_map == NULL || index_map->elem_size == sizeof (size_t));
+  SC_ASSERT (old_count == rec_array->elem_count + rec_array->f.elem_count);
+
+  map = NULL;
+  if (index_map != NULL) {
+    sc_array_resize (index_map, old_count);
+    map = (size_t *) index_map->array;
+    for (iz = 0; iz < old_count; ++iz) {
+      map[iz] = SC_RECYCLE_ARRAY_NONE;
+    }
+  }
+
+  /* move the valid objects down, which never overlap */
+  jz = 0;
+  for (iz = sc_recycle_array_next (rec_array, 0); iz < old_count;
+       iz = sc_recycle_array_next (rec_array, iz + 1), ++jz) {
+    if (jz != iz) {
+      memcpy (rec_array->a.array + jz * size,
+              rec_array->a.array + iz * size, size);
+    }
+    if (map != NULL) {
+      map[iz] = jz;
+    }
+  }
+  SC_ASSERT (jz == rec_array->elem_count);
+
+  /* the first jz slots are valid and the others are gone */
+  sc_array_resize (&rec_array->a, jz);
+  sc_array_reset (&rec_array->f);
+  sc_array_resize (&rec_array->v, (jz + 63) >> 6);
+  for (iz = 0; iz < rec_array->v.elem_count; ++iz) {
+    *(uint64_t *) sc_array_index (&rec_array->v, iz) = ~(uint64_t) 0;
+  }
+  if ((jz & 63) != 0) {
+    *sc_recycle_array_word (rec_array, jz - 1) =
+      ((uint64_t) 1 << (jz & 63)) - 1;
+  }
+}
@@ -79,6 +79,95 @@ typedef int         (*sc_equal_function_t) (const void *v1,
  */
 typedef int         (*sc_hash_foreach_t) (void **v, const void *u);
 
+/** The allocator of the memory owned by an \ref sc_array_t.
+ * All functions receive the user context of the allocator.
+ * Views never call their allocator.
+ */
+typedef struct sc_array_allocator
+{
+  /** Return memory of size > 0 bytes, aborting if this fails. */
+  void               *(*alloc) (size_t size, void *user);
+  /** Resize memory, which may be NULL with old_size 0, to new_size > 0. */
+  void               *(*realloc) (void *ptr, size_t old_size,
+                                  size_t new_size, void *user);
+  /** Free memory of the given size returned by alloc or realloc. */
+  void                (*free) (void *ptr, size_t size, void *user);
+  void               *user;     /**< context passed to all functions */
+}
+sc_array_allocator_t;
+
+/** The default allocator of arrays using \ref sc_malloc and friends.
+ * These respect SC_ENABLE_MEMALIGN and the memory counters of libsc.
+ */
+extern const sc_array_allocator_t sc_array_allocator_default;
+
+/** Initialize an allocator that requests huge pages for large arrays.
+ * Allocations of at least threshold bytes are aligned to 2 MiB and passed
+ * to madvise (MADV_HUGEPAGE).  They are not registered with the memory
+ * counters of libsc.  Smaller allocations use \ref sc_malloc.
+ * Without posix_memalign and madvise, all allocations use sc_malloc.
+ * \param [out] allocator       The allocator to initialize.
+ * \param [in] threshold        Minimum size in bytes to use huge pages.
+ */
+void                sc_array_allocator_hugepage (sc_array_allocator_t *
+                                                 allocator,
+                                                 size_t threshold);
+
+/** The largest alignment accepted by \ref sc_array_new_aligned (2 MiB). */
+#define SC_ARRAY_ALIGN_MAX ((size_t) 1 << 21)
+
+/** Initialize an allocator whose memory is aligned to a power of two.
+ * With a 64 byte alignment the array begins on a cache line, and arrays
+ * of different threads do not share any.  Aligned allocation bypasses
+ * the memory counters of libsc if posix_memalign is available.
+ * Reallocation always copies the data to a new aligned block.
+ * \param [out] allocator       The allocator to initialize.
+ * \param [in] alignment        A positive power of two.
+ */
+void                sc_array_allocator_aligned (sc_array_allocator_t *
+                                                allocator,
+                                                size_t alignment);
+
+/** The growth policy of an \ref sc_array_t that owns its memory.
+ * Without a policy, \ref sc_array_resize allocates the next power of two
+ * of the required bytes and shrinks when half of that suffices.
+ * With a policy, growing allocates the required bytes plus a slack of
+ * (growth - 1) times the required bytes, limited to max_slack if that is
+ * positive.  Allocations of at least page_bytes bytes, if positive, are
+ * rounded up to a multiple of page_bytes, which is intended for the huge
+ * pages of \ref sc_array_allocator_hugepage.  Shrinking reallocates when
+ * the unused bytes exceed twice the slack plus one page.
+ * A policy may be shared by many arrays and must outlive them.
+ */
+typedef struct sc_array_policy
+{
+  double              growth;   /**< relative growth, greater than 1 */
+  size_t              max_slack;        /**< if positive, limit the slack */
+  size_t              page_bytes;       /**< if positive, page rounding */
+}
+sc_array_policy_t;
+
+/** The sc_arena object provides variable-size bump allocation, see below. */
+typedef struct sc_arena sc_arena_t;
+
+/** The opaque sc_array_mmap object backs an array with a mapped file. */
+typedef struct sc_array_mmap sc_array_mmap_t;
+
+/** Settings of an \ref sc_array_t that differ from the default.
+ * Most arrays use the default allocation, growth and no reservation and
+ * do not have this extension, which keeps the array structure small.
+ * It is created by \ref sc_array_init_allocator, \ref sc_array_set_policy
+ * and \ref sc_array_reserve, and \ref sc_array_reset frees it.
+ */
+typedef struct sc_array_ext
+{
+  const sc_array_allocator_t *allocator;    /**< NULL for the default */
+  const sc_array_policy_t *policy;  /**< NULL for the default growth */
+  size_t              byte_reserve;     /**< no shrinking below this */
+  int                 is_owned; /**< false if provided by a file mapping */
+}
+sc_array_ext_t;
+
 /** The sc_array object provides a dynamic array of equal-size elements.
  * Elements are accessed by their 0-based index.  Their address may change.
  * The number of elements (== elem_count) of the array can be changed by 
@@ -100,6 +189,7 @@ typedef struct sc_array
                                            distinguishes an array of size 0
                                            from a view of size 0 */
   char               *array;    /**< linear array to store elements */
+  sc_array_ext_t     *ext;      /**< NULL for default settings */
 }
 sc_array_t;
 
@@ -117,6 +207,17 @@ sc_array_t;
  */
 size_t              sc_array_memory_used (sc_array_t * array, int is_dynamic);
 
+/** Calculate the memory used by an array and the part of it not in use.
+ * \param [in] array       The array.
+ * \param [in] is_dynamic  True if created with sc_array_new,
+ *                         false if initialized with sc_array_init
+ * \param [out] slack      If not NULL, the number of allocated bytes
+ *                         beyond the elements; zero for views.
+ * \return                 Memory used in bytes.
+ */
+size_t              sc_array_memory_used_ext (sc_array_t * array,
+                                              int is_dynamic, size_t *slack);
+
 /** Creates a new array structure with 0 elements.
  * \param [in] elem_size    Size of one array element in bytes.
  * \return                  Return an allocated array of zero length.
@@ -131,6 +232,17 @@ sc_array_t         *sc_array_new (size_t elem_size);
  */
 sc_array_t         *sc_array_new_count (size_t elem_size, size_t elem_count);
 
+/** Creates a new array of 0 elements whose memory is aligned.
+ * The allocator is that of \ref sc_array_allocator_aligned and shared by
+ * all arrays of the same alignment.  To keep the elements on separate
+ * cache lines, pad elem_size to a multiple of the alignment.
+ * \param [in] elem_size    Size of one array element in bytes.
+ * \param [in] alignment    A power of two up to \ref SC_ARRAY_ALIGN_MAX.
+ * \return                  Return an allocated array of zero length.
+ */
+sc_array_t         *sc_array_new_aligned (size_t elem_size,
+                                          size_t alignment);
+
 /** Deprecated: use \ref sc_array_new_count. */
 #define sc_array_new_size(s,c) (sc_array_new_count ((s), (c)))
 
@@ -190,6 +302,71 @@ void                sc_array_init_size (sc_array_t * array,
 void                sc_array_init_count (sc_array_t * array,
                                          size_t elem_size, size_t elem_count);
 
+/** Initializes an already allocated (or static) array structure
+ * whose memory is managed by a given allocator.
+ * The allocator is kept when the array is resized to zero elements.
+ * \ref sc_array_reset restores the default allocation.
+ * \param [in,out]  array       Array structure to be initialized.
+ * \param [in] elem_size        Size of one array element in bytes.
+ * \param [in] allocator        The allocator must outlive the array.
+ *                              NULL selects the default allocation.
+ */
+void                sc_array_init_allocator (sc_array_t * array,
+                                             size_t elem_size,
+                                             const sc_array_allocator_t *
+                                             allocator);
+
+/** Initializes an already allocated (or static) array structure
+ * whose memory is taken from an arena.
+ * Freeing the array memory is a no-op; it is reclaimed by rewinding
+ * the arena.  Thus the array must not be used after such a rewind
+ * to before its memory was allocated, except to call sc_array_init again.
+ * \param [in,out]  array       Array structure to be initialized.
+ * \param [in] elem_size        Size of one array element in bytes.
+ * \param [in] arena            The arena must outlive the array.
+ */
+void                sc_array_init_arena (sc_array_t * array,
+                                         size_t elem_size,
+                                         sc_arena_t * arena);
+
+/** Open a file to hold the memory of an array out of core.
+ * The array memory is a shared mapping of the file, which grows and
+ * shrinks with the allocation of the array.  Growing extends the file
+ * sparsely, and the operating system pages the data in and out.
+ * Freeing the memory, for example by \ref sc_array_reset, unmaps the file
+ * without changing its length, which \ref sc_array_mmap_destroy sets.
+ * \param [in] filename     If NULL, an anonymous temporary file is created
+ *                          in the directory $TMPDIR or /tmp and removed
+ *                          when the mapping is destroyed.  Otherwise
+ *                          the named file is opened or created and kept.
+ * \return                  The file mapping to be passed to
+ *                          \ref sc_array_init_mmap, or NULL if the file
+ *                          cannot be opened or mmap(2) is not available.
+ */
+sc_array_mmap_t    *sc_array_mmap_new (const char *filename);
+
+/** Close a file mapping and detach its array.
+ * The file is truncated to the elements of the array, which is
+ * reinitialized as an empty array by \ref sc_array_init afterwards.
+ * An array initialized otherwise since \ref sc_array_init_mmap is
+ * left alone.
+ * \param [in] mm           File mapping created by \ref sc_array_mmap_new.
+ */
+void                sc_array_mmap_destroy (sc_array_mmap_t * mm);
+
+/** Initializes an array structure whose memory is a mapped file.
+ * An existing file is mapped as the initial elements of the array.
+ * The array may then be used with all array functions.
+ * Aborts if the file cannot be resized or mapped.
+ * \param [in,out]  array       Array structure to be initialized.
+ * \param [in] elem_size        Size of one array element in bytes.
+ *                              It must divide the size of an existing file.
+ * \param [in] mm               File mapping not used by any other array.
+ *                              It must outlive the array.
+ */
+void                sc_array_init_mmap (sc_array_t * array, size_t elem_size,
+                                        sc_array_mmap_t * mm);
+
 /** Initializes an already allocated (or static) view from existing sc_array_t.
  * The array view returned does not require sc_array_reset (doesn't hurt though).
  * \param [in,out] view  Array structure to be initialized.
@@ -242,6 +419,9 @@ void                sc_array_memset (sc_array_t * array, int c);
 
 /** Sets the array count to zero and frees all elements.
  * This function turns a view into a newly initialized array.
+ * An allocator, growth policy or reservation set for the array is
+ * dropped, except that an array of \ref sc_array_init_mmap stays
+ * attached to its file until \ref sc_array_mmap_destroy.
  * \param [in,out]  array       Array structure to be reset.
  * \note Calling sc_array_init, then any array operations,
  *       then sc_array_reset is memory neutral.
@@ -267,7 +447,9 @@ void                sc_array_truncate (sc_array_t * array);
  *                          array is reduced without reallocating memory.
  *                          The exception is a \b new_count of zero
  *                          specified for an array that is not a view:
- *                          In this case \ref sc_array_reset is equivalent.
+ *                          In this case the memory is freed as in
+ *                          \ref sc_array_reset, but the allocator and
+ *                          growth policy are kept.
  */
 void                sc_array_rewind (sc_array_t * array, size_t new_count);
 
@@ -279,19 +461,81 @@ void                sc_array_rewind (sc_array_t * array, size_t new_count);
  * \param [in,out] array    The element count and address is modified.
  * \param [in] new_count    New element count of the array.
  *                          If it is zero and the array is not a view,
- *                          the effect equals \ref sc_array_reset.
+ *                          the memory is freed as in \ref sc_array_reset
+ *                          unless it is reserved, but the allocator and
+ *                          growth policy are kept.
  */
 void                sc_array_resize (sc_array_t * array, size_t new_count);
 
+/** Set the growth policy of an array.
+ * The current allocation is kept until the next resize.
+ * The policy applies until it is changed or the array is reset.
+ * \param [in,out] array    Array that is not a view.
+ * \param [in] policy       The policy must outlive the array.
+ *                          NULL selects the default growth.
+ */
+void                sc_array_set_policy (sc_array_t * array,
+                                         const sc_array_policy_t * policy);
+
+/** Ensure that an array holds memory for a number of elements.
+ * Resizing the array up to this count does not reallocate, and no resize
+ * shrinks the allocation below it until \ref sc_array_shrink_to_fit or
+ * \ref sc_array_reset.  The element count is not changed.
+ * \param [in,out] array    Array that is not a view.
+ * \param [in] elem_count   Number of elements to reserve memory for.
+ */
+void                sc_array_reserve (sc_array_t * array, size_t elem_count);
+
+/** Reallocate an array to the exact size of its elements.
+ * This also cancels a previous \ref sc_array_reserve.
+ * An empty array frees its memory as in \ref sc_array_resize to zero.
+ * \param [in,out] array    Array that is not a view.
+ */
+void                sc_array_shrink_to_fit (sc_array_t * array);
+
+/** The default of \ref sc_array_stream_bytes. */
+#define SC_ARRAY_STREAM_BYTES ((size_t) 1 << 23)
+
+/** Copies of at least this many bytes bypass the caches.
+ * This applies to \ref sc_array_copy, \ref sc_array_copy_into,
+ * \ref sc_array_copy_parallel and, for disjoint ranges,
+ * \ref sc_array_move_part.  Such copies use non-temporal stores if the
+ * compiler targets SSE2, which avoids the eviction of useful data by a
+ * destination that is not read soon.  The default is
+ * \ref SC_ARRAY_STREAM_BYTES, which should exceed the size of the last
+ * level cache share of a process.  SIZE_MAX disables streaming.
+ */
+extern size_t       sc_array_stream_bytes;
+
 /** Copy the contents of one array into another.
  * Both arrays must have equal element sizes.
  * The source array may be a view.
  * We use memcpy (3):  If the two arrays overlap, results are undefined.
+ * Large copies bypass the caches; see \ref sc_array_stream_bytes.
  * \param [in] dest     Array (not a view) will be resized and get new data.
  * \param [in] src      Array used as source of new data, will not be changed.
  */
 void                sc_array_copy (sc_array_t * dest, sc_array_t * src);
 
+/** The minimum number of bytes per thread in \ref sc_array_copy_parallel. */
+#define SC_ARRAY_COPY_PARALLEL_MIN ((size_t) 1 << 20)
+
+/** Copy the contents of one array into another with threads.
+ * The result equals that of \ref sc_array_copy.  Each thread copies one
+ * contiguous range, which may speed up copies of several megabytes on
+ * machines whose memory bandwidth exceeds that of a single core.
+ * \param [in] dest         Array (not a view) will be resized.
+ * \param [in] src          Array used as source of new data.
+ *                          If the two arrays overlap, results are undefined.
+ * \param [in] num_threads  Number of threads to use.  If not positive,
+ *                          use \ref sc_thread_default_count.  At most one
+ *                          thread per \ref SC_ARRAY_COPY_PARALLEL_MIN
+ *                          bytes is used.
+ */
+void                sc_array_copy_parallel (sc_array_t * dest,
+                                            sc_array_t * src,
+                                            int num_threads);
+
 /** Copy the contents of one array into some portion of another.
  * Both arrays must have equal element sizes.
  * Either array may be a view.  The destination array must be large enough.
@@ -331,6 +575,25 @@ void                sc_array_sort (sc_array_t * array,
                                    int (*compar) (const void *,
                                                   const void *));
 
+/** Sort the array stably in ascending order of an unsigned integer key.
+ * This is an LSD radix sort with 8 bit digits that skips the digits
+ * shared by all keys.  It is much faster than \ref sc_array_sort on large
+ * arrays of Morton indices and similar keys.
+ * The key is read in native byte order from \b key_width bytes at
+ * \b key_offset within each element.  Widths 4 and 8 are interpreted as
+ * uint32_t and uint64_t, width 16 as sc_uint128_t.
+ * For other widths we fall back to \ref sc_array_sort, which is not stable.
+ * \param [in,out] array    The array to sort.
+ * \param [in] key_offset   Offset of the key in bytes within an element.
+ * \param [in] key_width    Width of the key in bytes.
+ * \param [in] compar       The comparison function for the fallback.
+ *                          It may be NULL if the key width is supported.
+ */
+void                sc_array_sort_radix (sc_array_t * array,
+                                         size_t key_offset, size_t key_width,
+                                         int (*compar) (const void *,
+                                                        const void *));
+
 /** Check whether the array is sorted wrt. the comparison function.
  * \param [in] array    The array to check.
  * \param [in] compar   The comparison function to be used.
@@ -358,6 +621,72 @@ void                sc_array_uniq (sc_array_t * array,
                                    int (*compar) (const void *,
                                                   const void *));
 
+/** The minimum number of input elements per thread in
+ * \ref sc_array_uniq_parallel and the sorted-set operations. */
+#define SC_ARRAY_SET_PARALLEL_MIN 65536
+
+/** Remove duplicate entries from a sorted array with threads.
+ * The result equals that of \ref sc_array_uniq.  Each thread compacts
+ * one chunk into a buffer of the array's size, which is copied back.
+ * \param [in,out] array     The array size will be reduced as necessary.
+ * \param [in] compar        The comparison function to be used.
+ * \param [in] num_threads   Number of threads to use.  If not positive,
+ *                           use \ref sc_thread_default_count.  At most one
+ *                           thread per \ref SC_ARRAY_SET_PARALLEL_MIN
+ *                           entries is used.
+ */
+void                sc_array_uniq_parallel (sc_array_t * array,
+                                            int (*compar) (const void *,
+                                                           const void *),
+                                            int num_threads);
+
+/** Compute the union of two sorted sets.
+ * The inputs are sorted strictly ascending wrt. the comparison function.
+ * Runs of elements of one input between two elements of the other are
+ * found by galloping search and copied at once, which makes the cost
+ * O(m log (n / m)) comparisons for inputs of sizes m <= n.
+ * With several threads, the larger input is cut into equal chunks and
+ * the smaller one at the matching positions found by binary search.
+ * \param [out] dest         Resizable array of the inputs' element size,
+ *                           different from both inputs.  It is resized to
+ *                           the elements of \a a or \a b in ascending order.
+ *                           An element in both inputs is copied from \a a.
+ * \param [in] a             First sorted input.
+ * \param [in] b             Second sorted input.
+ * \param [in] compar        The comparison function to be used.
+ * \param [in] num_threads   Number of threads to use.  If not positive,
+ *                           use \ref sc_thread_default_count.  At most one
+ *                           thread per \ref SC_ARRAY_SET_PARALLEL_MIN
+ *                           input entries is used.
+ */
+void                sc_array_merge (sc_array_t * dest, sc_array_t * a,
+                                    sc_array_t * b,
+                                    int (*compar) (const void *,
+                                                   const void *),
+                                    int num_threads);
+
+/** Compute the intersection of two sorted sets.
+ * The parameters are as in \ref sc_array_merge.
+ * \param [out] dest         Resized to the elements of \a a that are
+ *                           also in \a b, in ascending order.
+ */
+void                sc_array_intersect (sc_array_t * dest, sc_array_t * a,
+                                        sc_array_t * b,
+                                        int (*compar) (const void *,
+                                                       const void *),
+                                        int num_threads);
+
+/** Compute the difference of two sorted sets.
+ * The parameters are as in \ref sc_array_merge.
+ * \param [out] dest         Resized to the elements of \a a that are
+ *                           not in \a b, in ascending order.
+ */
+void                sc_array_difference (sc_array_t * dest, sc_array_t * a,
+                                         sc_array_t * b,
+                                         int (*compar) (const void *,
+                                                        const void *),
+                                         int num_threads);
+
 /** Performs a binary search on an array. The array must be sorted.
  * \param [in] array   A sorted array to search in.
  * \param [in] key     An element to be searched for.
@@ -369,6 +698,34 @@ ssize_t             sc_array_bsearch (sc_array_t * array,
                                       int (*compar) (const void *,
                                                      const void *));
 
+/** Performs an interpolation search on a sorted array of integers.
+ * The elements are of type int or int64_t, told apart by the element
+ * size.  Each step guesses the position of the key from the values at
+ * the ends of the remaining range, which takes O (log log N) steps for
+ * uniformly distributed keys such as global element numbers.  A step
+ * that does not halve the range is followed by a bisection, so skewed
+ * data costs at most twice the steps of \ref sc_array_bsearch.
+ * \param [in] array   A sorted array of int or int64_t.
+ * \param [in] key     The value to search for.
+ * \return Returns the index of an element equal to key, or -1.
+ */
+ssize_t             sc_array_isearch (sc_array_t * array, int64_t key);
+
+/** Search many keys in a sorted array of integers.
+ * Each result is one of \ref sc_array_isearch for the same key.
+ * Sorted keys are merged with the array: each search gallops forward
+ * from the result of the previous key, which costs
+ * O (K log (N / K)) comparisons for K keys instead of K searches.
+ * Unsorted keys are allowed and restart the search where they descend.
+ * \param [in] array       A sorted array of int or int64_t.
+ * \param [in] keys        Array of the same element type.
+ * \param [out] positions  Resized to the count of keys and filled with
+ *                         the ssize_t index of each key, or -1.
+ */
+void                sc_array_isearch_batch (sc_array_t * array,
+                                            sc_array_t * keys,
+                                            sc_array_t * positions);
+
 /** Function to determine the enumerable type of an object in an array.
  * \param [in] array   Array containing the object.
  * \param [in] index   The location of the object.
@@ -397,6 +754,44 @@ void                sc_array_split (sc_array_t * array, sc_array_t * offsets,
                                     size_t num_types, sc_array_type_t type_fn,
                                     void *data);
 
+/** The minimum number of array entries per thread in
+ * \ref sc_array_split_parallel. */
+#define SC_ARRAY_SPLIT_PARALLEL_MIN 4096
+
+/** Compute the offsets of groups of types in an array with threads.
+ * Each thread counts the types of one chunk of the array, a prefix sum
+ * over the counts yields the offsets and, if requested, the threads
+ * move their entries into their final position by a stable counting
+ * sort.  The threads are run by \ref sc_thread_fork_join.
+ * \param [in,out] array     Array with 0 <= \a type_fn (\a array, k,
+ *                           \a data) < \a num_types for all k.  If
+ *                           \a permute is false, it must be sorted
+ *                           ascending by type as for \ref sc_array_split.
+ *                           Otherwise it may be in any order and is
+ *                           permuted stably into ascending type order.
+ * \param [in,out] offsets   An initialized array of type size_t that is
+ *                           resized to \a num_types + 1 entries.  On output
+ *                           it is identical to the result of
+ *                           \ref sc_array_split on the split array.
+ * \param [in] num_types     The number of possible types of objects.
+ * \param [in] type_fn       Returns the type of an object in the array.
+ *                           It is called concurrently from several threads,
+ *                           and twice per object if \a permute is true.
+ * \param [in] data          Arbitrary user data passed to \a type_fn.
+ * \param [in] permute       If true, sort the array by type in place.
+ *                           This allocates a buffer of the array's size.
+ * \param [in] num_threads   Number of threads to use.  If not positive,
+ *                           use \ref sc_thread_default_count.  At most one
+ *                           thread per \ref SC_ARRAY_SPLIT_PARALLEL_MIN
+ *                           entries is used.
+ */
+void                sc_array_split_parallel (sc_array_t * array,
+                                             sc_array_t * offsets,
+                                             size_t num_types,
+                                             sc_array_type_t type_fn,
+                                             void *data, int permute,
+                                             int num_threads);
+
 /** Determine whether \a array is an array of size_t's whose entries include
  * every integer 0 <= i < array->elem_count.
  * \param [in] array         An array.
@@ -420,8 +815,35 @@ int                 sc_array_is_permutation (sc_array_t * array);
 void                sc_array_permute (sc_array_t * array,
                                       sc_array_t * newindices, int keepperm);
 
+/** Given permutation \a newindices, permute \a array in place.
+ * As \ref sc_array_permute, but \a newindices is unchanged on output
+ * and no memory proportional to the array length is allocated.
+ * We follow each cycle of the permutation and mark the visited entries
+ * of \a newindices by temporarily complementing them, which is undone
+ * in a final pass.  Thus \a newindices must not be accessed concurrently.
+ * \param [in,out] array      An array.
+ * \param [in,out] newindices Permutation array (see sc_array_is_permutation).
+ *                            Restored to its input values on output.
+ */
+void                sc_array_permute_inplace (sc_array_t * array,
+                                              sc_array_t * newindices);
+
+/** Permute an array in place moving large elements in blocks of bytes.
+ * This works as \ref sc_array_permute_inplace, but each element is swapped
+ * through a buffer of at most \a block_size bytes, so the temporary memory
+ * and the data touched by one copy stay bounded for large elements.
+ * \param [in,out] array      An array.
+ * \param [in,out] newindices Permutation array (see sc_array_is_permutation).
+ *                            Restored to its input values on output.
+ * \param [in] block_size     Positive number of bytes swapped at a time.
+ */
+void                sc_array_permute_blocked (sc_array_t * array,
+                                              sc_array_t * newindices,
+                                              size_t block_size);
+
 /** Computes the adler32 checksum of array data (see zlib documentation).
  * This is a faster checksum than crc32, and it works with zeros as data.
+ * Without zlib we compute it by \ref sc_io_adler32.
  */
 unsigned int        sc_array_checksum (sc_array_t * array);
 
@@ -603,6 +1025,150 @@ sc_array_push (sc_array_t * array)
   return sc_array_push_count (array, 1);
 }
 
+/** Define inline accessors of an \ref sc_array_t of elements of one type.
+ * The functions sc_array_<name>_<op> below use sizeof (type) in place of
+ * the element size stored in the array, so the compiler may fold the
+ * address arithmetic, vectorize loops over the elements and inline the
+ * comparisons.  The array must have been initialized with an element
+ * size of sizeof (type), which is asserted in debug mode.
+ * The sort and priority queue functions compare by the operator <.
+ * They are not stable and NaN values must not occur.
+ *
+ *  - type *sc_array_<name>_index (array, iz): address of element iz.
+ *  - type *sc_array_<name>_push (array): append an uninitialized element.
+ *  - void sc_array_<name>_sort (array): sort ascending in place.
+ *  - void sc_array_<name>_pqueue_add (array, value): insert into a heap
+ *    whose smallest element is at index 0.
+ *  - type sc_array_<name>_pqueue_pop (array): remove and return the
+ *    smallest element of a nonempty heap.
+ *
+ * The accessors for int, int64_t, size_t and double are predefined as
+ * sc_array_int_*, sc_array_int64_*, sc_array_size_t_* and
+ * sc_array_double_*.
+ * \param [in] name     Identifier to form the function names.
+ * \param [in] type     Type of the array elements.
+ */
+#define SC_ARRAY_DEFINE_TYPE(name,type)                                 \
+/*@unused@*/ static inline type *                                       \
+sc_array_##name##_index (sc_array_t * array, size_t iz)                 \
+{                                                                       \
+  SC_ASSERT (array->elem_size == sizeof (type));                        \
+  SC_ASSERT (iz < array->elem_count);                                   \
+  return (type *) array->array + iz;                                    \
+}                                                                       \
+/*@unused@*/ static inline type *                                       \
+sc_array_##name##_push (sc_array_t * array)                             \
+{                                                                       \
+  const size_t        old_count = array->elem_count;                    \
+  SC_ASSERT (array->elem_size == sizeof (type));                        \
+  SC_ASSERT (SC_ARRAY_IS_OWNER (array));                                \
+  if (sizeof (type) * (old_count + 1) > (size_t) array->byte_alloc) {   \
+    sc_array_resize (array, old_count + 1);                             \
+  }                                                                     \
+  else {                                                                \
+    array->elem_count = old_count + 1;                                  \
+  }                                                                     \
+  return (type *) array->array + old_count;                             \
+}                                                                       \
+/*@unused@*/ static inline void                                         \
+sc_array_##name##_sort (sc_array_t * array)                             \
+{                                                                       \
+  size_t              lo, hi, i, j, mid;                                \
+  size_t              stack[2 * 8 * sizeof (size_t)], depth;            \
+  type                pivot, t;                                         \
+  type               *a = (type *) array->array;                        \
+  SC_ASSERT (array->elem_size == sizeof (type));                        \
+  /* quicksort on the larger part iteratively, on the smaller first */  \
+  depth = 0;                                                            \
+  lo = 0;                                                               \
+  hi = array->elem_count;                                               \
+  for (;;) {                                                            \
+    while (hi - lo > 16) {                                              \
+      mid = lo + (hi - lo) / 2;                                         \
+      if (a[mid] < a[lo]) { t = a[mid]; a[mid] = a[lo]; a[lo] = t; }    \
+      if (a[hi - 1] < a[lo]) { t = a[hi - 1]; a[hi - 1] = a[lo];        \
+        a[lo] = t; }                                                    \
+      if (a[hi - 1] < a[mid]) { t = a[hi - 1]; a[hi - 1] = a[mid];      \
+        a[mid] = t; }                                                   \
+      pivot = a[mid];                                                   \
+      i = lo;                                                           \
+      j = hi - 1;                                                       \
+      for (;;) {                                                        \
+        while (a[i] < pivot) ++i;                                       \
+        while (pivot < a[j]) --j;                                       \
+        if (i >= j) break;                                              \
+        t = a[i]; a[i] = a[j]; a[j] = t;                                \
+        ++i;                                                            \
+        --j;                                                            \
+      }                                                                 \
+      /* now [lo, j] <= pivot <= [j + 1, hi) */                         \
+      if (j + 1 - lo < hi - j - 1) {                                    \
+        stack[depth++] = j + 1;                                         \
+        stack[depth++] = hi;                                            \
+        hi = j + 1;                                                     \
+      }                                                                 \
+      else {                                                            \
+        stack[depth++] = lo;                                            \
+        stack[depth++] = j + 1;                                         \
+        lo = j + 1;                                                     \
+      }                                                                 \
+    }                                                                   \
+    /* insertion sort of the short range */                             \
+    for (i = lo + 1; i < hi; ++i) {                                     \
+      t = a[i];                                                         \
+      for (j = i; j > lo && t < a[j - 1]; --j) {                        \
+        a[j] = a[j - 1];                                                \
+      }                                                                 \
+      a[j] = t;                                                         \
+    }                                                                   \
+    if (depth == 0) break;                                              \
+    hi = stack[--depth];                                                \
+    lo = stack[--depth];                                                \
+  }                                                                     \
+}                                                                       \
+/*@unused@*/ static inline void                                         \
+sc_array_##name##_pqueue_add (sc_array_t * array, type value)           \
+{                                                                       \
+  size_t              child, parent;                                    \
+  type               *a;                                                \
+  child = array->elem_count;                                            \
+  (void) sc_array_##name##_push (array);                                \
+  a = (type *) array->array;                                            \
+  while (child > 0 && value < a[parent = (child - 1) / 2]) {            \
+    a[child] = a[parent];                                               \
+    child = parent;                                                     \
+  }                                                                     \
+  a[child] = value;                                                     \
+}                                                                       \
+/*@unused@*/ static inline type                                         \
+sc_array_##name##_pqueue_pop (sc_array_t * array)                       \
+{                                                                       \
+  size_t              parent, child, n;                                 \
+  type                result, last;                                     \
+  type               *a = (type *) array->array;                        \
+  SC_ASSERT (array->elem_size == sizeof (type));                        \
+  SC_ASSERT (array->elem_count > 0);                                    \
+  result = a[0];                                                        \
+  n = array->elem_count - 1;                                            \
+  last = a[n];                                                          \
+  parent = 0;                                                           \
+  while ((child = 2 * parent + 1) < n) {                                \
+    if (child + 1 < n && a[child + 1] < a[child]) ++child;              \
+    if (!(a[child] < last)) break;                                      \
+    a[parent] = a[child];                                               \
+    parent = child;                                                     \
+  }                                                                     \
+  a[parent] = last;                                                     \
+  sc_array_resize (array, n);                                           \
+  return result;                                                        \
+}
+
+
+SC_ARRAY_DEFINE_TYPE (int, int)
+SC_ARRAY_DEFINE_TYPE (int64, int64_t)
+SC_ARRAY_DEFINE_TYPE (size_t, size_t)
+SC_ARRAY_DEFINE_TYPE (double, double)
+
 /** A data container to create memory items of the same size.
  * Allocations are bundled so it's fast for small memory sizes.
  * The items created will remain valid until the container is destroyed.
@@ -617,6 +1183,7 @@ typedef struct sc_mstamp
   size_t              cur_snext;   /**< Next number within a stamp */
   char               *current;     /**< Memory of current stamp */
   sc_array_t          remember;    /**< Collects all stamps */
+  size_t              stamp_align; /**< If positive, aligns the stamps */
 }
 sc_mstamp_t;
 
@@ -640,6 +1207,21 @@ sc_mstamp_t;
 void                sc_mstamp_init (sc_mstamp_t * mst,
                                     size_t stamp_unit, size_t elem_size);
 
+/** Initialize a memory stamp container with aligned stamps.
+ * The same as \ref sc_mstamp_init, except that every stamp begins at a
+ * multiple of stamp_align.  If elem_size is a multiple of the alignment,
+ * so is every item.  A stamp_unit of 2 MiB aligned to 2 MiB lets the
+ * system back each stamp by a huge page.
+ * \param [in,out] mst          Legal pointer to a stamp structure.
+ * \param [in] stamp_unit       See \ref sc_mstamp_init.
+ * \param [in] elem_size        See \ref sc_mstamp_init.
+ * \param [in] stamp_align      A power of two, or 0 for the default.
+ */
+void                sc_mstamp_init_aligned (sc_mstamp_t * mst,
+                                            size_t stamp_unit,
+                                            size_t elem_size,
+                                            size_t stamp_align);
+
 /** Free all memory in a stamp structure and all items previously returned.
  * \param [in,out] mst          Properly initialized stamp container.
  *                              On output, the structure is undefined.
@@ -673,6 +1255,106 @@ void               *sc_mstamp_alloc (sc_mstamp_t * mst);
  */
 size_t              sc_mstamp_memory_used (sc_mstamp_t * mst);
 
+/** The sc_arena provides aligned bump allocation of variable-size items.
+ * Memory is taken from a list of blocks that are kept until the arena is
+ * reset.  Items cannot be freed individually.  Instead, the state of the
+ * arena can be saved and rewound later, which frees all items allocated
+ * in between in O(1).  This is intended for temporaries of one phase.
+ * An arena may serve as backing memory of \ref sc_array_init_arena.
+ */
+struct sc_arena
+{
+  size_t              block_size;       /**< minimum size of a block */
+  size_t              current;          /**< index of current block */
+  size_t              offset;           /**< bytes used in current block */
+  size_t              last;             /**< offset of the last item */
+  sc_array_t          blocks;           /**< collects all blocks */
+  sc_array_allocator_t allocator;       /**< for sc_array_init_arena */
+};
+
+/** A saved state of an arena. */
+typedef struct sc_arena_mark
+{
+  size_t              current;          /**< index of current block */
+  size_t              offset;           /**< bytes used in current block */
+}
+sc_arena_mark_t;
+
+/** Initialize an arena.  No memory is allocated yet.
+ * \param [in,out] arena        Legal pointer to an arena structure.
+ * \param [in] block_size       Minimum bytes of each block we allocate.
+ *                              Larger items receive a block of their own.
+ *                              Passing 0 selects a default size.
+ */
+void                sc_arena_init (sc_arena_t * arena, size_t block_size);
+
+/** Free all memory of an arena and all items previously returned.
+ * \param [in,out] arena        On output, the structure is undefined.
+ */
+void                sc_arena_reset (sc_arena_t * arena);
+
+/** Allocate and initialize a new arena.
+ * \param [in] block_size       See \ref sc_arena_init.
+ * \return                      The arena, to be freed by sc_arena_destroy.
+ */
+sc_arena_t         *sc_arena_new (size_t block_size);
+
+/** Free all memory of an arena including the structure itself. */
+void                sc_arena_destroy (sc_arena_t * arena);
+
+/** Return an uninitialized item that stays valid until rewind or reset.
+ * \param [in,out] arena        Properly initialized arena.
+ * \param [in] size             Size of the item in bytes.
+ * \param [in] align            Alignment of the item: a power of two.
+ *                              Passing 0 selects sizeof (void *).
+ * \return                      Pointer to the new item.
+ */
+void               *sc_arena_alloc (sc_arena_t * arena,
+                                    size_t size, size_t align);
+
+/** Change the size of an item previously returned by the arena.
+ * If the item is the most recent allocation, it is resized in place
+ * whenever possible.  Otherwise a new item is allocated and the content is
+ * copied; the space of the old item is reclaimed by the next rewind.
+ * \param [in,out] arena        Properly initialized arena.
+ * \param [in] ptr              Item of this arena or NULL.
+ * \param [in] old_size         Previous size of the item in bytes.
+ * \param [in] new_size         New size of the item in bytes.
+ * \param [in] align            Alignment of the item as in sc_arena_alloc.
+ * \return                      Pointer to the resized item.
+ */
+void               *sc_arena_realloc (sc_arena_t * arena, void *ptr,
+                                      size_t old_size, size_t new_size,
+                                      size_t align);
+
+/** Save the current state of an arena for a later rewind.
+ * \param [in] arena            Properly initialized arena.
+ * \return                      The mark of the current state.
+ */
+sc_arena_mark_t     sc_arena_save (sc_arena_t * arena);
+
+/** Rewind an arena to a state saved earlier, freeing newer items in O(1).
+ * The memory blocks are kept for reuse.
+ * \param [in,out] arena        Properly initialized arena.
+ * \param [in] mark             Saved by sc_arena_save since the last
+ *                              reset, truncate, or rewind to an earlier mark.
+ */
+void                sc_arena_rewind (sc_arena_t * arena,
+                                     sc_arena_mark_t mark);
+
+/** Free all items of an arena, keeping its memory blocks for reuse.
+ * \param [in,out] arena        Properly initialized arena.
+ */
+void                sc_arena_truncate (sc_arena_t * arena);
+
+/** Return memory size in bytes of all blocks allocated by the arena.
+ * \param [in] arena            Properly initialized arena.
+ * \param [in] is_dynamic       True if created with sc_arena_new.
+ * \return                      Total memory size in bytes.
+ */
+size_t              sc_arena_memory_used (sc_arena_t * arena,
+                                          int is_dynamic);
+
 /** The sc_mempool object provides a large pool of equal-size elements.
  * The pool grows dynamically for element allocation.
  * Elements are referenced by their address which never changes.
@@ -692,9 +1374,16 @@ typedef struct sc_mempool
   /* implementation variables */
   sc_mstamp_t         mstamp;   /**< fixed-size chunk allocator */
   sc_array_t          freed;    /**< buffers the freed elements */
+  double              trim_fraction;    /**< see sc_mempool_set_trim */
+  size_t              trim_next;        /**< freed count of next trim */
 }
 sc_mempool_t;
 
+#ifndef SC_MEMPOOL_TRIM_MIN
+/** The fewest freed elements that trigger an automatic trim. */
+#define SC_MEMPOOL_TRIM_MIN 4096
+#endif
+
 /** Calculate the memory used by a memory pool.
  * \param [in] mempool     The memory pool.
  * \return                 Memory used in bytes.
@@ -720,6 +1409,29 @@ sc_mempool_t       *sc_mempool_new_zero_and_persist (size_t elem_size);
 void                sc_mempool_init (sc_mempool_t * mempool,
                                      size_t elem_size);
 
+/** Creates a new mempool structure whose elements are aligned.
+ * Each element is padded to a multiple of elem_align, so an alignment
+ * of 64 bytes gives every element its own cache lines and elements
+ * handed to different threads do not share any.  The stamps are aligned
+ * to the larger of elem_align and stamp_align and hold at least that
+ * many bytes.  A stamp_align of 2 MiB is suitable for huge pages.
+ * The zero_and_persist option is off.
+ * \param [in] elem_size    Size of one element in bytes.
+ * \param [in] elem_align   Alignment of the elements, a power of two.
+ * \param [in] stamp_align  Alignment of the stamps, a power of two,
+ *                          or 0 to align them as the elements.
+ * \return Returns an allocated and initialized memory pool.
+ */
+sc_mempool_t       *sc_mempool_new_aligned (size_t elem_size,
+                                            size_t elem_align,
+                                            size_t stamp_align);
+
+/** Same as \ref sc_mempool_new_aligned for an allocated sc_mempool_t. */
+void                sc_mempool_init_aligned (sc_mempool_t * mempool,
+                                             size_t elem_size,
+                                             size_t elem_align,
+                                             size_t stamp_align);
+
 /** Destroy a mempool structure.
  * All elements that are still in use are invalidated.
  * \param [in,out] mempool      Its memory is freed.
@@ -740,6 +1452,30 @@ void                sc_mempool_reset (sc_mempool_t * mempool);
  */
 void                sc_mempool_truncate (sc_mempool_t * mempool);
 
+/** Release the stamps of the pool whose elements are all freed.
+ * We sort the stamps by address and count the freed elements of each.
+ * The freed elements on complete stamps are removed from the pool and
+ * the stamps are returned to the allocator.  The stamp that serves new
+ * elements is kept.  This takes O ((F + S) log S) time for F freed
+ * elements and S stamps, and nothing is tracked by alloc and free.
+ * \param [in,out] mempool      The memory pool.
+ * \return                      The number of bytes released.
+ */
+size_t              sc_mempool_trim (sc_mempool_t * mempool);
+
+/** Trim the pool automatically when many of its elements are freed.
+ * \ref sc_mempool_free calls \ref sc_mempool_trim when more than this
+ * fraction of the elements on the stamps is freed.  After each trim the
+ * next one waits until the number of freed elements doubles, and for at
+ * least \ref SC_MEMPOOL_TRIM_MIN freed elements, so the cost per free
+ * stays logarithmic.
+ * \param [in,out] mempool      The memory pool.
+ * \param [in] fraction         Between 0 and 1.  Zero, the default,
+ *                              switches the automatic trim off.
+ */
+void                sc_mempool_set_trim (sc_mempool_t * mempool,
+                                         double fraction);
+
 /** Allocate a single element.
  * Elements previously returned to the pool are recycled.
  * \return Returns a new or recycled element pointer.
@@ -792,8 +1528,87 @@ sc_mempool_free (sc_mempool_t * mempool, void *elem)
   --mempool->elem_count;
 
   *(void **) sc_array_push (freed) = elem;
+
+  if (mempool->trim_fraction > 0. &&
+      freed->elem_count >= mempool->trim_next &&
+      (double) freed->elem_count > mempool->trim_fraction *
+      (double) (freed->elem_count + mempool->elem_count)) {
+    (void) sc_mempool_trim (mempool);
+  }
 }
 
+/** The sc_mempool_concurrent object is a memory pool for multiple threads.
+ * Every thread allocates and frees through its own \ref sc_mempool_cache_t,
+ * which holds two magazines of elements and needs no synchronization.
+ * Full and empty magazines are exchanged through a lock-free central depot,
+ * such that elements may be freed by another thread than allocated them.
+ * Only when the depot runs out of magazines, a mutex is taken to obtain
+ * new memory from an internal \ref sc_mempool_t.
+ * The object is opaque and all its functions are thread safe if the library
+ * is configured with pthread support and the compiler provides atomic
+ * builtins, see sc_atomic.h.
+ */
+typedef struct sc_mempool_concurrent sc_mempool_concurrent_t;
+
+/** The per-thread cache of a concurrent memory pool.
+ * A cache must only be used by one thread at a time.
+ */
+typedef struct sc_mempool_cache sc_mempool_cache_t;
+
+/** Create a new concurrent mempool.
+ * The contents of allocated elements are undefined.
+ * \param [in] elem_size    Size of one element in bytes.
+ * \return                  Returns an allocated and initialized memory pool.
+ */
+sc_mempool_concurrent_t *sc_mempool_concurrent_new (size_t elem_size);
+
+/** Destroy a concurrent mempool and free all its elements.
+ * \param [in,out] mempool  All caches of this pool must be destroyed.
+ */
+void                sc_mempool_concurrent_destroy (sc_mempool_concurrent_t *
+                                                   mempool);
+
+/** Calculate the memory used by a concurrent memory pool.
+ * This includes all elements and magazines, cached or not.
+ * \param [in] mempool      The memory pool.
+ * \return                  Memory used in bytes.
+ */
+size_t              sc_mempool_concurrent_memory_used
+  (sc_mempool_concurrent_t * mempool);
+
+/** Return the number of elements allocated from a concurrent mempool.
+ * The allocations through a cache are added when it is destroyed.
+ * \param [in] mempool      The memory pool.
+ * \return                  The number of elements not yet freed.
+ */
+size_t              sc_mempool_concurrent_elem_count
+  (sc_mempool_concurrent_t * mempool);
+
+/** Create a cache for the calling thread.
+ * \param [in] mempool      The concurrent memory pool to allocate from.
+ * \return                  The new cache, to be used by one thread only.
+ */
+sc_mempool_cache_t *sc_mempool_cache_new (sc_mempool_concurrent_t * mempool);
+
+/** Destroy a cache and return its cached elements to the pool.
+ * \param [in,out] cache    Its memory is freed.
+ */
+void                sc_mempool_cache_destroy (sc_mempool_cache_t * cache);
+
+/** Allocate a single element from a concurrent mempool.
+ * \param [in,out] cache    The cache of the calling thread.
+ * \return  Returns a new or previously freed element of the pool.
+ */
+void               *sc_mempool_cache_alloc (sc_mempool_cache_t * cache);
+
+/** Return a previously allocated element to a concurrent mempool.
+ * The element may have been allocated through any cache of the same pool.
+ * \param [in,out] cache    The cache of the calling thread.
+ * \param [in] elem         The element to be returned to the pool.
+ */
+void                sc_mempool_cache_free (sc_mempool_cache_t * cache,
+                                           void *elem);
+
 /** The sc_link structure is one link of a linked list.
  */
 typedef struct sc_link
@@ -899,6 +1714,9 @@ void               *sc_list_pop (sc_list_t * list);
 
 /** The sc_hash implements a hash table.
  * It uses an array which has linked lists as elements.
+ * In incremental mode, a resize allocates the new slots and keeps the old
+ * ones, whose lists are moved a few at a time by subsequent insertions and
+ * removals.  This bounds the cost of every single operation.
  */
 typedef struct sc_hash
 {
@@ -913,6 +1731,15 @@ typedef struct sc_hash
   size_t              resize_checks, resize_actions;
   int                 allocator_owned;
   sc_mempool_t       *allocator;        /**< must allocate sc_link_t */
+  size_t              minimal_slots;    /**< do not shrink below this */
+  int                 incremental;      /**< boolean: resize incrementally */
+  sc_array_t         *old_slots;        /**< NULL unless resize is ongoing */
+  size_t              migrate_pos;      /**< old slots below are moved */
+  int                 count_probes;     /**< boolean: update the counters */
+  size_t              lookups;  /**< lookups, insertions and removals */
+  size_t              hits;     /**< operations that found the object */
+  size_t              probes;   /**< calls to equal_fn by the operations */
+  size_t              max_chain;        /**< longest chain searched */
 }
 sc_hash_t;
 
@@ -924,6 +1751,62 @@ sc_hash_t;
  */
 unsigned int        sc_hash_function_string (const void *s, const void *u);
 
+/** A binary key of arbitrary length for \ref sc_hash_function_bytes. */
+typedef struct sc_hash_bytes
+{
+  const void         *data;     /**< The key bytes, any alignment. */
+  size_t              size;     /**< Number of bytes in the key. */
+}
+sc_hash_bytes_t;
+
+/** Compute a 64-bit hash value of arbitrary memory.
+ * The input is consumed eight bytes at a time in the manner of the 64-bit
+ * xxHash, whose results it reproduces.  It is much faster than the
+ * byte-wise mixing of \ref sc_hash_function_string for longer keys.
+ * This hash function is NOT cryptographically safe!
+ * \param [in] data     Memory to be hashed, any alignment.
+ *                      May be NULL if \a size is zero.
+ * \param [in] size     Number of bytes to hash.
+ * \param [in] seed     Varying the seed yields unrelated hash functions,
+ *                      which makes crafted collisions harder.
+ * \return              The computed hash value.
+ */
+uint64_t            sc_hash_bytes64 (const void *data, size_t size,
+                                     uint64_t seed);
+
+/** Compute a hash value from a null-terminated string word by word.
+ * \param [in] s        Null-terminated string to be hashed.
+ * \param [in] u        Not used.
+ * \return              The value of \ref sc_hash_bytes64 with seed 0,
+ *                      folded into an unsigned integer.
+ */
+unsigned int        sc_hash_function_string_fast (const void *s,
+                                                  const void *u);
+
+/** Compute a seeded hash value from a null-terminated string.
+ * \param [in] s        Null-terminated string to be hashed.
+ * \param [in] u        NULL for seed 0 or pointer to a uint64_t seed.
+ * \return              The computed hash value as an unsigned integer.
+ */
+unsigned int        sc_hash_function_string_seeded (const void *s,
+                                                    const void *u);
+
+/** Compute a seeded hash value from a binary key.
+ * \param [in] v        Pointer to a \ref sc_hash_bytes_t.
+ * \param [in] u        NULL for seed 0 or pointer to a uint64_t seed.
+ * \return              The computed hash value as an unsigned integer.
+ */
+unsigned int        sc_hash_function_bytes (const void *v, const void *u);
+
+/** Compare two binary keys to go along with \ref sc_hash_function_bytes.
+ * \param [in] v1       Pointer to a \ref sc_hash_bytes_t.
+ * \param [in] v2       Pointer to a \ref sc_hash_bytes_t.
+ * \param [in] u        Not used.
+ * \return              True if both keys have equal size and bytes.
+ */
+int                 sc_hash_equal_bytes (const void *v1, const void *v2,
+                                         const void *u);
+
 /** Calculate the memory used by a hash table.
  * \param [in] hash        The hash table.
  * \return                 Memory used in bytes.
@@ -941,6 +1824,26 @@ sc_hash_t          *sc_hash_new (sc_hash_function_t hash_fn,
                                  sc_equal_function_t equal_fn,
                                  void *user_data, sc_mempool_t * allocator);
 
+/** Create a new hash table with an expected number of objects.
+ * The number of hash slots is chosen such that the expected number of
+ * objects can be inserted without a resize.  The table does not shrink
+ * below this initial size.
+ * \param [in] hash_fn     Function to compute the hash value.
+ * \param [in] equal_fn    Function to test two objects for equality.
+ * \param [in] user_data   User data passed through to the hash function.
+ * \param [in] allocator   Memory allocator for sc_link_t, can be NULL.
+ * \param [in] expected_count  Expected number of objects, may be 0.
+ * \param [in] incremental If true, a resize allocates the new slots and
+ *                         later insertions and removals each move a bounded
+ *                         number of hash chains into them.  Otherwise, all
+ *                         objects are moved at once as in \ref sc_hash_new.
+ */
+sc_hash_t          *sc_hash_new_ext (sc_hash_function_t hash_fn,
+                                     sc_equal_function_t equal_fn,
+                                     void *user_data,
+                                     sc_mempool_t * allocator,
+                                     size_t expected_count, int incremental);
+
 /** Destroy a hash table.
  *
  * If the allocator is owned, this runs in O(1), otherwise in O(N).
@@ -1008,7 +1911,22 @@ int                 sc_hash_remove (sc_hash_t * hash, void *v, void **found);
  */
 void                sc_hash_foreach (sc_hash_t * hash, sc_hash_foreach_t fn);
 
+/** Switch the counting of lookups and probes of a hash table on or off.
+ * When on, \ref sc_hash_lookup, \ref sc_hash_insert_unique and
+ * \ref sc_hash_remove count their calls, the calls that find the object,
+ * the comparisons by equal_fn and the longest chain searched.  A poor
+ * hash function shows as many probes per lookup for the load of the
+ * table.  The counters are reset in either case.  They are printed by
+ * \ref sc_hash_print_statistics and may be reduced over processes with
+ * sc_statistics_set_hash.
+ * \param [in,out] hash     The hash table.
+ * \param [in] enabled      Boolean to count from now on.
+ */
+void                sc_hash_set_count_probes (sc_hash_t * hash,
+                                              int enabled);
+
 /** Compute and print statistical information about the occupancy.
+ * If probes are counted, see \ref sc_hash_set_count_probes, print them too.
  */
 void                sc_hash_print_statistics (int package_id,
                                               int log_priority,
@@ -1026,13 +1944,17 @@ sc_hash_array_data_t;
 
 /** The sc_hash_array implements an array backed up by a hash table.
  * This enables O(1) access for array elements.
+ * A hash array may be frozen by \ref sc_hash_array_freeze to drop the
+ * chained hash table in favor of a compact read-only index.
  */
 typedef struct sc_hash_array
 {
   /* implementation variables */
   sc_array_t          a;
   sc_hash_array_data_t internal_data;
-  sc_hash_t          *h;
+  sc_hash_t          *h;        /**< NULL if frozen */
+  size_t             *frozen;   /**< open addressing index or NULL */
+  int                 frozen_bits;      /**< log2 of the index size */
 }
 sc_hash_array_t;
 
@@ -1061,6 +1983,7 @@ void                sc_hash_array_destroy (sc_hash_array_t * hash_array);
 int                 sc_hash_array_is_valid (sc_hash_array_t * hash_array);
 
 /** Remove all elements from the hash array.
+ * A frozen hash array can be modified again afterwards.
  * \param [in,out] hash_array   Hash array to truncate.
  */
 void                sc_hash_array_truncate (sc_hash_array_t * hash_array);
@@ -1090,6 +2013,39 @@ int                 sc_hash_array_lookup (sc_hash_array_t * hash_array,
 void               *sc_hash_array_insert_unique (sc_hash_array_t * hash_array,
                                                  void *v, size_t *position);
 
+/** Look up many objects in a hash array at once.
+ * All hash values are computed up front and the hash slots are prefetched
+ * ahead of probing, which is faster than repeated \ref sc_hash_array_lookup.
+ *
+ * \param [in]  items      Array of objects of the hash array's element size.
+ * \param [in,out] positions  Array of element size sizeof (size_t).
+ *                         Resized to the count of items.  On output, each
+ *                         entry is the array position of the matching object
+ *                         or (size_t) -1 if it is not contained.
+ * \return                 The number of objects found.
+ */
+size_t              sc_hash_array_lookup_batch (sc_hash_array_t * hash_array,
+                                                sc_array_t * items,
+                                                sc_array_t * positions);
+
+/** Insert many objects into a hash array if they are not contained already.
+ * The hash table is resized at most once, before the objects are inserted.
+ * Contrary to \ref sc_hash_array_insert_unique, new objects are copied to
+ * the end of the array in the order of the items.  Duplicates within the
+ * items are recognized and inserted only once.
+ *
+ * \param [in]  items      Array of objects of the hash array's element size.
+ *                         Must not be the array of the hash array itself.
+ * \param [in,out] positions  Array of element size sizeof (size_t).
+ *                         Resized to the count of items.  On output, each
+ *                         entry is the array position of the contained or
+ *                         new object.
+ * \return                 The number of objects added.
+ */
+size_t              sc_hash_array_insert_batch (sc_hash_array_t * hash_array,
+                                                sc_array_t * items,
+                                                sc_array_t * positions);
+
 /** Extract the array data from a hash array and destroy everything else.
  * \param [in] hash_array   The hash array is destroyed after extraction.
  * \param [in] rip          Array structure that will be overwritten.
@@ -1099,10 +2055,169 @@ void               *sc_hash_array_insert_unique (sc_hash_array_t * hash_array,
 void                sc_hash_array_rip (sc_hash_array_t * hash_array,
                                        sc_array_t * rip);
 
+/** Extract the array data from a hash array sorted by a comparison.
+ * The hash table is freed before sorting, such that its memory is
+ * available to the sort.
+ * \param [in] hash_array   The hash array is destroyed after extraction.
+ * \param [in] rip          Array structure as in \ref sc_hash_array_rip.
+ * \param [in] compar       Comparison function for the elements.
+ * \param [out] newindices  If not NULL, an array of element size
+ *                          sizeof (size_t), resized to the element count.
+ *                          Entry i is the new position of the element
+ *                          that had position i in the hash array.
+ */
+void                sc_hash_array_rip_sorted (sc_hash_array_t * hash_array,
+                                              sc_array_t * rip,
+                                              int (*compar) (const void *,
+                                                             const void *),
+                                              sc_array_t * newindices);
+
+/** Make a hash array read-only and reduce its memory.
+ * The chained hash table with its links and their mempool is replaced by
+ * one array of positions with open addressing at a load of at most one
+ * half.  Lookups remain available and need no allocation of links.
+ * Insertions are no longer allowed until \ref sc_hash_array_truncate.
+ * Freezing a frozen hash array does nothing.
+ * \param [in,out] hash_array   The hash array to freeze.
+ */
+void                sc_hash_array_freeze (sc_hash_array_t * hash_array);
+
+/** Query whether a hash array has been frozen.
+ * \param [in] hash_array   Valid hash array.
+ * \return                  True if \ref sc_hash_array_freeze has been
+ *                          called and the array not truncated since.
+ */
+int                 sc_hash_array_is_frozen (sc_hash_array_t * hash_array);
+
+/** Function to call on every element of an open addressing hash table.
+ * \param [in,out] v   The address of the element stored in the table.
+ *                     It may be modified as long as its hash value
+ *                     and equality relations stay the same.
+ * \param [in] u       Arbitrary user data.
+ * \return Return true if the traversal should continue, false to stop.
+ */
+typedef int         (*sc_ohash_foreach_t) (void *v, const void *u);
+
+/** The sc_ohash implements a hash table with open addressing.
+ * Contrary to \ref sc_hash_t, the elements of fixed size are stored inline
+ * in one linear slot array, which avoids following pointers on lookup.
+ * We use Robin Hood probing with backward shift deletion.
+ * Next to every slot we store its probe distance and the element's hash
+ * value, such that most unequal elements can be skipped without calling
+ * the equality function, and resizing does not call the hash function.
+ * The callback types are those of \ref sc_hash_t and \ref sc_hash_array_t.
+ * The probe distance is limited to 255.  An element that would exceed it,
+ * which happens when many elements share one hash value, is kept in a
+ * linearly searched overflow stash instead.  The stash is emptied into
+ * the slots whenever the table is resized.
+ * The address of an element in the table may change on every insertion
+ * or removal, so pointers returned by the functions below are only valid
+ * until the table is modified next.
+ */
+typedef struct sc_ohash
+{
+  /* interface variables */
+  size_t              elem_size;        /**< size of a single element */
+  size_t              elem_count;       /**< number of valid elements */
+
+  /* implementation variables */
+  size_t              slot_count;       /**< a power of two */
+  int                 slot_bits;        /**< binary log of slot count */
+  unsigned char      *dist;     /**< zero is empty, otherwise probe
+                                     distance plus one */
+  unsigned int       *hval;     /**< hash value of each occupied slot */
+  char               *slots;    /**< element storage */
+  char               *temp;     /**< two elements of scratch space */
+  sc_array_t         *stash;    /**< elements beyond the maximal distance */
+  sc_array_t         *stash_hval;       /**< hash values of the stash */
+  void               *user_data;        /**< user data passed to callbacks */
+  sc_hash_function_t  hash_fn;
+  sc_equal_function_t equal_fn;
+  size_t              resize_actions;
+}
+sc_ohash_t;
+
+/** Calculate the memory used by an open addressing hash table.
+ * \param [in] ohash       The hash table.
+ * \return                 Memory used in bytes.
+ */
+size_t              sc_ohash_memory_used (sc_ohash_t * ohash);
+
+/** Create a new open addressing hash table.
+ * The number of hash slots is chosen dynamically.
+ * \param [in] elem_size   Size of one element in bytes.
+ * \param [in] hash_fn     Function to compute the hash value.
+ * \param [in] equal_fn    Function to test two objects for equality.
+ * \param [in] user_data   User data passed through to the callbacks.
+ * \return                 A new hash table that is empty.
+ */
+sc_ohash_t         *sc_ohash_new (size_t elem_size,
+                                  sc_hash_function_t hash_fn,
+                                  sc_equal_function_t equal_fn,
+                                  void *user_data);
+
+/** Destroy an open addressing hash table.
+ * \param [in,out] ohash   This table is invalidated and freed.
+ */
+void                sc_ohash_destroy (sc_ohash_t * ohash);
+
+/** Remove all elements from an open addressing hash table.
+ * The slot array is shrunk to its initial size.
+ * \param [in,out] ohash   The table is emptied.
+ */
+void                sc_ohash_truncate (sc_ohash_t * ohash);
+
+/** Check if an object is contained in an open addressing hash table.
+ * \param [in]  v      The object to be looked up.
+ * \param [out] found  If found != NULL and the object is contained,
+ *                     *found is set to the address of the element stored.
+ *                     It may be modified without changing its hash value.
+ * \return Returns true if object is found, false otherwise.
+ */
+int                 sc_ohash_lookup (sc_ohash_t * ohash,
+                                     const void *v, void **found);
+
+/** Insert an object into an open addressing hash table if it is not
+ * contained already.  The object is copied into the table.
+ * \param [in]  v      The object of size elem_size to be inserted.
+ * \param [out] found  If found != NULL, *found is set to the address of the
+ *                     already contained, or if not present, the new element.
+ * \return Returns true if object is added, false if it is already contained.
+ */
+int                 sc_ohash_insert_unique (sc_ohash_t * ohash,
+                                            const void *v, void **found);
+
+/** Remove an object from an open addressing hash table.
+ * \param [in]  v      The object to be removed.
+ * \param [out] found  If found != NULL, the element removed is copied
+ *                     to this memory of size elem_size if it exists.
+ * \return Returns true if object is found, false if is not contained.
+ */
+int                 sc_ohash_remove (sc_ohash_t * ohash,
+                                     const void *v, void *found);
+
+/** Invoke a callback for every element of the hash table.
+ * The functions hash_fn and equal_fn are not called by this function.
+ * The table must not be modified by the callback.
+ */
+void                sc_ohash_foreach (sc_ohash_t * ohash,
+                                      sc_ohash_foreach_t fn);
+
+/** Compute and print statistical information about the probe distances.
+ */
+void                sc_ohash_print_statistics (int package_id,
+                                               int log_priority,
+                                               sc_ohash_t * ohash);
+
+/** Index map entry of a slot that is not valid, see
+ * \ref sc_recycle_array_compact. */
+#define SC_RECYCLE_ARRAY_NONE ((size_t) -1)
+
 /** The sc_recycle_array object provides an array of slots that can be reused.
  *
  * It keeps a list of free slots in the array which will be used for insertion
  * while available.  Otherwise, the array is grown.
+ * A bitmap of the valid slots allows to skip 64 free slots at a time.
  */
 typedef struct sc_recycle_array
 {
@@ -1112,6 +2227,7 @@ typedef struct sc_recycle_array
   /* implementation variables */
   sc_array_t          a;
   sc_array_t          f;
+  sc_array_t          v;        /**< 64-bit words, one bit per valid slot */
 }
 sc_recycle_array_t;
 
@@ -1149,6 +2265,38 @@ void               *sc_recycle_array_insert (sc_recycle_array_t * rec_array,
 void               *sc_recycle_array_remove (sc_recycle_array_t * rec_array,
                                              size_t position);
 
+/** Determine whether a slot of the recycle array holds a valid object.
+ *
+ * \param [in] position   Index less than the array size rec_array->a.
+ * \return                True if the slot is occupied.
+ */
+int                 sc_recycle_array_is_valid (sc_recycle_array_t *
+                                               rec_array, size_t position);
+
+/** Find the first valid slot not below a position.
+ * All valid objects are visited by the loop
+ * for (i = sc_recycle_array_next (r, 0); i < r->a.elem_count;
+ *      i = sc_recycle_array_next (r, i + 1)).
+ *
+ * \param [in] position   Index to start, at most the array size.
+ * \return                The index of a valid slot or the array size
+ *                        rec_array->a.elem_count if there is none.
+ */
+size_t              sc_recycle_array_next (sc_recycle_array_t * rec_array,
+                                           size_t position);
+
+/** Move the valid objects to the front of the array in their order.
+ * The free slots are discarded and the memory of the array shrinks.
+ *
+ * \param [out] index_map If not NULL, an array of element size
+ *                        sizeof (size_t).  It is resized to the previous
+ *                        array size and maps each old index to the new
+ *                        one, or to \ref SC_RECYCLE_ARRAY_NONE for a slot
+ *                        that was free.
+ */
+void                sc_recycle_array_compact (sc_recycle_array_t * rec_array,
+                                              sc_array_t * index_map);
+
 SC_EXTERN_C_END;
 
 #endif /* !SC_CONTAINERS_H */
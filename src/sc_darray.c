@@ -0,0 +1,171 @@
+/*
+  This file is part of the SC Library.
+  The SC Library provides support for parallel scientific applications.
+
+  Copyright (C) 2010 The University of Texas System
+  Additional copyright (C) 2011 individual authors
+
+  The SC Library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  The SC Library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with the SC Library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+  02110-1301, USA.
+*/
+
+#include <sc_darray.h>
+
+/* the number of elements in front of a segment */
+static size_t
+sc_darray_segment_begin (sc_darray_t * darray, int segment)
+{
+  return ((((size_t) 1) << segment) - 1) << darray->first_log2;
+}
+
+/* the number of elements a segment holds */
+static size_t
+sc_darray_segment_count (sc_darray_t * darray, int segment)
+{
+  return ((size_t) 1) << (darray->first_log2 + segment);
+}
+
+/* the number of segments needed for a given number of elements */
+static int
+sc_darray_segments_needed (sc_darray_t * darray, size_t count)
+{
+  return count == 0 ? 0 :
+    SC_LOG2_64 (((count - 1) >> darray->first_log2) + 1) + 1;
+}
+
+void
+sc_darray_init (sc_darray_t * darray, size_t elem_size)
+{
+  size_t              first;
+
+  SC_ASSERT (elem_size > 0);
+
+  memset (darray, 0, sizeof (sc_darray_t));
+  darray->elem_size = elem_size;
+  first = SC_MAX (SC_DARRAY_FIRST_BYTES / elem_size, 1);
+  darray->first_log2 = SC_LOG2_64 (first);
+}
+
+void
+sc_darray_reset (sc_darray_t * darray)
+{
+  int                 k;
+
+  for (k = 0; k < darray->num_alloc; ++k) {
+    SC_FREE (darray->segments[k]);
+    darray->segments[k] = NULL;
+  }
+  darray->num_alloc = 0;
+  darray->elem_count = 0;
+}
+
+sc_darray_t        *
+sc_darray_new (size_t elem_size)
+{
+  sc_darray_t        *darray;
+
+  darray = SC_ALLOC (sc_darray_t, 1);
+  sc_darray_init (darray, elem_size);
+
+  return darray;
+}
+
+void
+sc_darray_destroy (sc_darray_t * darray)
+{
+  sc_darray_reset (darray);
+  SC_FREE (darray);
+}
+
+size_t
+sc_darray_memory_used (sc_darray_t * darray, int is_dynamic)
+{
+  int                 k;
+  size_t              mem;
+
+  mem = is_dynamic ? sizeof (sc_darray_t) : 0;
+  for (k = 0; k < darray->num_alloc; ++k) {
+    mem += sc_darray_segment_count (darray, k) * darray->elem_size;
+  }
+
+  return mem;
+}
+
+void
+sc_darray_resize (sc_darray_t * darray, size_t new_count)
+{
+  int                 needed;
+
+  needed = sc_darray_segments_needed (darray, new_count);
+  SC_CHECK_ABORT (needed <= SC_DARRAY_MAX_SEGMENTS,
+                  "Segmented array too large");
+
+  /* allocate the missing segments */
+  while (darray->num_alloc < needed) {
+    darray->segments[darray->num_alloc] = SC_ALLOC
+      (char, sc_darray_segment_count (darray, darray->num_alloc) *
+       darray->elem_size);
+    ++darray->num_alloc;
+  }
+
+  /* keep at most one unused segment */
+  while (darray->num_alloc > needed + 1) {
+    --darray->num_alloc;
+    SC_FREE (darray->segments[darray->num_alloc]);
+    darray->segments[darray->num_alloc] = NULL;
+  }
+
+  darray->elem_count = new_count;
+}
+
+int
+sc_darray_num_segments (sc_darray_t * darray)
+{
+  return sc_darray_segments_needed (darray, darray->elem_count);
+}
+
+size_t
+sc_darray_segment (sc_darray_t * darray, int segment, sc_array_t * view)
+{
+  size_t              begin, count;
+
+  SC_ASSERT (0 <= segment && segment < sc_darray_num_segments (darray));
+
+  begin = sc_darray_segment_begin (darray, segment);
+  count = SC_MIN (sc_darray_segment_count (darray, segment),
+                  darray->elem_count - begin);
+  sc_array_init_data (view, darray->segments[segment], darray->elem_size,
+                      count);
+
+  return begin;
+}
+
+void
+sc_darray_compact (sc_darray_t * darray, sc_array_t * dest)
+{
+  int                 k, num_segments;
+  size_t              begin;
+  sc_array_t          view;
+
+  SC_ASSERT (dest->elem_size == darray->elem_size);
+
+  sc_array_resize (dest, darray->elem_count);
+  num_segments = sc_darray_num_segments (darray);
+  for (k = 0; k < num_segments; ++k) {
+    begin = sc_darray_segment (darray, k, &view);
+    memcpy (dest->array + begin * dest->elem_size, view.array,
+            view.elem_count * view.elem_size);
+  }
+}
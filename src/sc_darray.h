@@ -0,0 +1,195 @@
+/*
+  This file is part of the SC Library.
+  The SC Library provides support for parallel scientific applications.
+
+  Copyright (C) 2010 The University of Texas System
+  Additional copyright (C) 2011 individual authors
+
+  The SC Library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  The SC Library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with the SC Library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+  02110-1301, USA.
+*/
+
+#ifndef SC_DARRAY_H
+#define SC_DARRAY_H
+
+/** \file sc_darray.h
+ *
+ * Segmented array of fixed-size elements with stable addresses.
+ *
+ * The elements are stored in segments whose sizes grow by powers of two.
+ * Segment 0 holds 2^first_log2 elements and segment k holds
+ * 2^(first_log2 + k) elements, such that the index of an element
+ * determines its segment by one base-2 logarithm.  Growing the array
+ * allocates new segments and never moves existing elements, so pointers
+ * to elements remain valid until the elements are removed.  In contrast
+ * to \ref sc_array_resize, which reallocates one block and temporarily
+ * needs twice the memory of a large array, the peak memory stays close
+ * to the array size.  Where a contiguous array is required, the segments
+ * may be viewed one by one as \ref sc_array_t or copied into one.
+ *
+ * \ingroup sc_containers
+ */
+
+#include <sc_containers.h>
+
+/** The targeted size of the first segment in bytes.
+ * The element count of the first segment is the largest power of two
+ * whose elements fit into this size, and at least one.
+ */
+#define SC_DARRAY_FIRST_BYTES 4096
+
+/** The maximum number of segments of an array. */
+#define SC_DARRAY_MAX_SEGMENTS 48
+
+SC_EXTERN_C_BEGIN;
+
+/** The segmented array data structure.
+ * Its fields may be read but must only be modified by the functions below.
+ */
+typedef struct sc_darray
+{
+  /* interface variables */
+  size_t              elem_size;        /**< size of one element in bytes */
+  size_t              elem_count;       /**< number of valid elements */
+
+  /* implementation variables */
+  int                 first_log2;       /**< log2 of first segment count */
+  int                 num_alloc;        /**< number of allocated segments */
+  char               *segments[SC_DARRAY_MAX_SEGMENTS];  /**< storage */
+}
+sc_darray_t;
+
+/** Initialize an empty segmented array in place.
+ * \param [out] darray      Array structure to initialize.
+ * \param [in] elem_size    Size of one element in bytes.
+ */
+void                sc_darray_init (sc_darray_t * darray, size_t elem_size);
+
+/** Free the memory of a segmented array initialized by \ref sc_darray_init.
+ * \param [in,out] darray   The array is empty and may be reused.
+ */
+void                sc_darray_reset (sc_darray_t * darray);
+
+/** Create a new empty segmented array.
+ * \param [in] elem_size    Size of one element in bytes.
+ * \return                  Returns an allocated array of zero length.
+ */
+sc_darray_t        *sc_darray_new (size_t elem_size);
+
+/** Destroy a segmented array created by \ref sc_darray_new.
+ * \param [in,out] darray   This array is invalid after the call.
+ */
+void                sc_darray_destroy (sc_darray_t * darray);
+
+/** Calculate the memory used by a segmented array.
+ * \param [in] darray       The array.
+ * \param [in] is_dynamic   True if created with \ref sc_darray_new,
+ *                          false if initialized with \ref sc_darray_init.
+ * \return                  Memory used in bytes.
+ */
+size_t              sc_darray_memory_used (sc_darray_t * darray,
+                                           int is_dynamic);
+
+/** Set the number of elements of a segmented array.
+ * Growing allocates the missing segments and leaves the new elements
+ * uninitialized.  Shrinking frees the segments beyond the first unused
+ * one, which is kept to avoid repeated allocation at a boundary.
+ * Elements below the new count never change their address.
+ * \param [in,out] darray   The array.
+ * \param [in] new_count    The new number of elements.
+ */
+void                sc_darray_resize (sc_darray_t * darray,
+                                      size_t new_count);
+
+/** Return the number of segments that hold elements.
+ * \param [in] darray       The array.
+ * \return                  The number of segments needed for the elements.
+ */
+int                 sc_darray_num_segments (sc_darray_t * darray);
+
+/** Initialize an array view of the elements in one segment.
+ * The view holds the elements of the segment in order and stays valid
+ * as long as these elements are not removed.
+ * \param [in] darray       The array.
+ * \param [in] segment      Less than \ref sc_darray_num_segments.
+ * \param [out] view        Array view of the used part of the segment.
+ * \return                  The index of the first element of the segment.
+ */
+size_t              sc_darray_segment (sc_darray_t * darray, int segment,
+                                       sc_array_t * view);
+
+/** Copy the elements into a flat array.
+ * \param [in] darray       The array.
+ * \param [in,out] dest     Resizable array of the same element size.
+ *                          It is resized to the count of \a darray and
+ *                          holds a copy of its elements.
+ */
+void                sc_darray_compact (sc_darray_t * darray,
+                                       sc_array_t * dest);
+
+/** Returns a pointer to an element of a segmented array.
+ * \param [in] darray       The array.
+ * \param [in] iz           Needs to be in [0]..[elem_count-1].
+ * \return                  Pointer to the indexed element.
+ */
+/*@unused@*/
+static inline void *
+sc_darray_index (sc_darray_t * darray, size_t iz)
+{
+  size_t              q;
+  int                 k;
+
+  SC_ASSERT (iz < darray->elem_count);
+
+  /* segment k begins at index (2^k - 1) * 2^first_log2 */
+  q = (iz >> darray->first_log2) + 1;
+  k = SC_LOG2_64 (q);
+  iz -= ((((size_t) 1) << k) - 1) << darray->first_log2;
+  return (void *) (darray->segments[k] + darray->elem_size * iz);
+}
+
+/** Enlarge a segmented array by one element.
+ * \param [in,out] darray   The array.
+ * \return                  Pointer to the new uninitialized element.
+ */
+/*@unused@*/
+static inline void *
+sc_darray_push (sc_darray_t * darray)
+{
+  sc_darray_resize (darray, darray->elem_count + 1);
+  return sc_darray_index (darray, darray->elem_count - 1);
+}
+
+/** Remove the last element from a segmented array.
+ * \param [in,out] darray   The array must not be empty.
+ * \return                  Pointer to the removed element, which stays
+ *                          valid until the array is resized again.
+ */
+/*@unused@*/
+static inline void *
+sc_darray_pop (sc_darray_t * darray)
+{
+  void               *last;
+
+  SC_ASSERT (darray->elem_count > 0);
+
+  last = sc_darray_index (darray, darray->elem_count - 1);
+  sc_darray_resize (darray, darray->elem_count - 1);
+  return last;
+}
+
+SC_EXTERN_C_END;
+
+#endif /* !SC_DARRAY_H */
@@ -0,0 +1,326 @@
+/*
+  This file is part of the SC Library.
+  The SC Library provides support for parallel scientific applications.
+
+  Copyright (C) 2010 The University of Texas System
+  Additional copyright (C) 2011 individual authors
+
+  The SC Library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  The SC Library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with the SC Library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+  02110-1301, USA.
+*/
+
+#include <sc_device.h>
+
+/** The size of the staging buffers of a device. */
+static size_t
+sc_device_stage_bytes (const sc_device_t * device)
+{
+  return device->stage_bytes > 0 ? device->stage_bytes :
+    (size_t) SC_DEVICE_STAGE_BYTES;
+}
+
+static void        *
+sc_device_host_alloc (const sc_device_t * device, size_t size)
+{
+  if (device->host_alloc != NULL) {
+    return device->host_alloc (size, device->user);
+  }
+  return SC_ALLOC (char, size);
+}
+
+static void
+sc_device_host_free (const sc_device_t * device, void *ptr)
+{
+  if (device->host_alloc != NULL) {
+    device->host_free (ptr, device->user);
+  }
+  else {
+    SC_FREE (ptr);
+  }
+}
+
+/** Copy within the device, staging through the host if necessary. */
+static void
+sc_device_copy (const sc_device_t * device, void *dest, const void *src,
+                size_t size)
+{
+  size_t              stage, offset, n;
+  char               *buffer;
+
+  if (device->on_device != NULL) {
+    device->on_device (dest, src, size, device->user);
+    return;
+  }
+  stage = SC_MIN (size, sc_device_stage_bytes (device));
+  buffer = (char *) sc_device_host_alloc (device, stage);
+  for (offset = 0; offset < size; offset += n) {
+    n = SC_MIN (stage, size - offset);
+    device->to_host (buffer, (const char *) src + offset, n, device->user);
+    device->to_device ((char *) dest + offset, buffer, n, device->user);
+  }
+  sc_device_host_free (device, buffer);
+}
+
+/* array allocators on the device and for host staging */
+
+static void        *
+sc_device_array_alloc (size_t size, void *user)
+{
+  const sc_device_t  *device = (const sc_device_t *) user;
+
+  return device->alloc (size, device->user);
+}
+
+static void
+sc_device_array_free (void *ptr, size_t size, void *user)
+{
+  const sc_device_t  *device = (const sc_device_t *) user;
+
+  device->free (ptr, device->user);
+}
+
+static void        *
+sc_device_array_realloc (void *ptr, size_t old_size, size_t new_size,
+                         void *user)
+{
+  void               *ret;
+  const sc_device_t  *device = (const sc_device_t *) user;
+
+  ret = device->alloc (new_size, device->user);
+  if (ptr != NULL) {
+    sc_device_copy (device, ret, ptr, SC_MIN (old_size, new_size));
+    device->free (ptr, device->user);
+  }
+  return ret;
+}
+
+void
+sc_device_array_allocator (sc_array_allocator_t * allocator,
+                           const sc_device_t * device)
+{
+  SC_ASSERT (allocator != NULL);
+  SC_ASSERT (device != NULL);
+  SC_ASSERT (device->alloc != NULL && device->free != NULL);
+  SC_ASSERT (device->to_host != NULL && device->to_device != NULL);
+  SC_ASSERT ((device->host_alloc == NULL) == (device->host_free == NULL));
+
+  allocator->alloc = sc_device_array_alloc;
+  allocator->realloc = sc_device_array_realloc;
+  allocator->free = sc_device_array_free;
+  allocator->user = (void *) device;
+}
+
+static void        *
+sc_device_stage_alloc (size_t size, void *user)
+{
+  return sc_device_host_alloc ((const sc_device_t *) user, size);
+}
+
+static void
+sc_device_stage_free (void *ptr, size_t size, void *user)
+{
+  sc_device_host_free ((const sc_device_t *) user, ptr);
+}
+
+static void        *
+sc_device_stage_realloc (void *ptr, size_t old_size, size_t new_size,
+                         void *user)
+{
+  void               *ret;
+
+  ret = sc_device_stage_alloc (new_size, user);
+  if (ptr != NULL) {
+    memcpy (ret, ptr, SC_MIN (old_size, new_size));
+    sc_device_stage_free (ptr, old_size, user);
+  }
+  return ret;
+}
+
+/** Initialize an allocator of host arrays in the staging memory. */
+static void
+sc_device_stage_allocator (sc_array_allocator_t * allocator,
+                           const sc_device_t * device)
+{
+  allocator->alloc = sc_device_stage_alloc;
+  allocator->realloc = sc_device_stage_realloc;
+  allocator->free = sc_device_stage_free;
+  allocator->user = (void *) device;
+}
+
+void
+sc_device_array_to_host (sc_array_t * dest, sc_array_t * src,
+                         const sc_device_t * device)
+{
+  SC_ASSERT (dest != NULL && src != NULL);
+  SC_ASSERT (dest->elem_size == src->elem_size);
+
+  sc_array_resize (dest, src->elem_count);
+  if (src->elem_count > 0) {
+    device->to_host (dest->array, src->array,
+                     src->elem_count * src->elem_size, device->user);
+  }
+}
+
+void
+sc_device_array_to_device (sc_array_t * dest, sc_array_t * src,
+                           const sc_device_t * device)
+{
+  SC_ASSERT (dest != NULL && src != NULL);
+  SC_ASSERT (dest->elem_size == src->elem_size);
+
+  sc_array_resize (dest, src->elem_count);
+  if (src->elem_count > 0) {
+    device->to_device (dest->array, src->array,
+                       src->elem_count * src->elem_size, device->user);
+  }
+}
+
+/* communication of device memory */
+
+void
+sc_device_notify_payload (sc_array_t * receivers, sc_array_t * senders,
+                          sc_array_t * in_payload, sc_array_t * out_payload,
+                          int sorted, sc_notify_t * notify,
+                          const sc_device_t * device)
+{
+  sc_array_allocator_t allocator;
+  sc_array_t          host_in, host_out;
+
+  SC_ASSERT (device != NULL);
+
+  /* the payload is packed with the notification on the host */
+  sc_device_stage_allocator (&allocator, device);
+  if (in_payload != NULL) {
+    sc_array_init_allocator (&host_in, in_payload->elem_size, &allocator);
+    sc_device_array_to_host (&host_in, in_payload, device);
+  }
+  if (out_payload != NULL) {
+    sc_array_init_allocator (&host_out, out_payload->elem_size, &allocator);
+  }
+  sc_notify_payload (receivers, senders,
+                     in_payload != NULL ? &host_in : NULL,
+                     out_payload != NULL ? &host_out : NULL, sorted, notify);
+
+  /* the result goes to the output array or replaces the input */
+  if (out_payload != NULL) {
+    sc_device_array_to_device (out_payload, &host_out, device);
+    sc_array_reset (&host_out);
+  }
+  else if (in_payload != NULL) {
+    sc_device_array_to_device (in_payload, &host_in, device);
+  }
+  if (in_payload != NULL) {
+    sc_array_reset (&host_in);
+  }
+}
+
+#ifdef SC_ENABLE_MPIIO
+
+/** Record the first error of a sequence of calls. */
+static void
+sc_device_io_error (int *errcode, int retval)
+{
+  if (*errcode == sc_MPI_SUCCESS) {
+    *errcode = retval;
+  }
+}
+
+/** Wait for a staged write and add its count. */
+static void
+sc_device_io_wait (sc_io_request_t ** request, int *ocount, int *errcode)
+{
+  int                 count;
+
+  if (*request != NULL) {
+    count = 0;
+    sc_device_io_error (errcode, sc_io_wait (request, &count));
+    *ocount += count;
+  }
+}
+
+#endif /* SC_ENABLE_MPIIO */
+
+int
+sc_device_io_write_at_all (sc_MPI_Comm mpicomm, sc_MPI_File mpifile,
+                           sc_MPI_Offset offset, const void *ptr,
+                           size_t zcount, sc_MPI_Datatype t, int *ocount,
+                           const sc_device_t * device)
+{
+  int                 errcode;
+  size_t              tsize;
+  void               *buffer;
+#ifdef SC_ENABLE_MPIIO
+  int                 mpiret, b;
+  long                num_pieces, max_pieces, k;
+  size_t              piece, first, n;
+  void               *buffers[2];
+  sc_io_request_t    *requests[2];
+#endif
+
+  SC_ASSERT (ocount != NULL);
+  SC_ASSERT (device != NULL);
+
+  if (device->mpi_aware) {
+    return sc_io_write_at_all (mpifile, offset, ptr, zcount, t, ocount);
+  }
+  tsize = sc_mpi_sizeof (t);
+
+#ifdef SC_ENABLE_MPIIO
+  /* every process issues the same number of collective writes */
+  piece = SC_MAX (sc_device_stage_bytes (device) / tsize, 1);
+  num_pieces = (long) ((zcount + piece - 1) / piece);
+  mpiret = sc_MPI_Allreduce (&num_pieces, &max_pieces, 1, sc_MPI_LONG,
+                             sc_MPI_MAX, mpicomm);
+  SC_CHECK_MPI (mpiret);
+  if (max_pieces > 1) {
+    /* copy one piece while writing the previous one */
+    errcode = sc_MPI_SUCCESS;
+    *ocount = 0;
+    for (b = 0; b < 2; ++b) {
+      buffers[b] = sc_device_host_alloc (device, piece * tsize);
+      requests[b] = NULL;
+    }
+    for (k = 0; k < max_pieces; ++k) {
+      b = (int) (k % 2);
+      sc_device_io_wait (&requests[b], ocount, &errcode);
+      first = (size_t) k * piece;
+      n = first < zcount ? SC_MIN (piece, zcount - first) : 0;
+      if (n > 0) {
+        device->to_host (buffers[b], (const char *) ptr + first * tsize,
+                         n * tsize, device->user);
+      }
+      sc_device_io_error (&errcode, sc_io_iwrite_at_all
+                          (mpifile, offset + (sc_MPI_Offset) (first * tsize),
+                           buffers[b], n, t, &requests[b]));
+    }
+    for (k = max_pieces; k < max_pieces + 2; ++k) {
+      sc_device_io_wait (&requests[k % 2], ocount, &errcode);
+    }
+    for (b = 0; b < 2; ++b) {
+      sc_device_host_free (device, buffers[b]);
+    }
+    return errcode;
+  }
+#endif
+
+  /* stage all data at once */
+  buffer = sc_device_host_alloc (device, zcount * tsize);
+  if (zcount > 0) {
+    device->to_host (buffer, ptr, zcount * tsize, device->user);
+  }
+  errcode = sc_io_write_at_all (mpifile, offset, buffer, zcount, t, ocount);
+  sc_device_host_free (device, buffer);
+  return errcode;
+}
@@ -0,0 +1,172 @@
+/*
+  This file is part of the SC Library.
+  The SC Library provides support for parallel scientific applications.
+
+  Copyright (C) 2010 The University of Texas System
+  Additional copyright (C) 2011 individual authors
+
+  The SC Library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  The SC Library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with the SC Library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+  02110-1301, USA.
+*/
+
+#ifndef SC_DEVICE_H
+#define SC_DEVICE_H
+
+/** \file sc_device.h
+ *
+ * Containers and communication with memory on accelerator devices.
+ *
+ * libsc does not link to CUDA, HIP or any other device runtime.  The
+ * application describes its device by the callbacks of an \ref
+ * sc_device_t, for example cudaMalloc or cudaMallocManaged,
+ * cudaFree and cudaMemcpy.  From there we provide an allocator that
+ * places the memory of an \ref sc_array_t on the device and variants of
+ * \ref sc_notify_payload and \ref sc_io_write_at_all for device arrays.
+ *
+ * The memory of a device array may only be accessed on the host if it
+ * is managed memory.  Otherwise, the array may be resized and passed to
+ * the functions of this file, but sc_array_index and friends only yield
+ * addresses to be used on the device.
+ *
+ * Data that the host must see is staged through host buffers, which may
+ * be pinned by the host_alloc callback to speed up the transfer.  A
+ * device known to the MPI library, as with CUDA-aware MPI, may skip the
+ * staging of file output by setting mpi_aware.
+ */
+
+#include <sc_containers.h>
+#include <sc_notify.h>
+#include <sc_io.h>
+
+SC_EXTERN_C_BEGIN;
+
+/** The callbacks that move memory onto and off a device.
+ * Every callback receives the user context.  Copies are synchronous:
+ * they return when the destination holds the data.
+ */
+typedef struct sc_device
+{
+  /** Allocate device memory of a size in bytes; must not return NULL. */
+  void               *(*alloc) (size_t size, void *user);
+  /** Free memory from alloc; ptr may be NULL. */
+  void                (*free) (void *ptr, void *user);
+  /** Copy bytes from the device to the host. */
+  void                (*to_host) (void *dest, const void *src, size_t size,
+                                  void *user);
+  /** Copy bytes from the host to the device. */
+  void                (*to_device) (void *dest, const void *src,
+                                    size_t size, void *user);
+  /** Copy bytes within the device.  If NULL, we stage them on the host. */
+  void                (*on_device) (void *dest, const void *src,
+                                    size_t size, void *user);
+  /** Allocate a host staging buffer.  If NULL, we use \ref sc_malloc. */
+  void               *(*host_alloc) (size_t size, void *user);
+  /** Free a buffer from host_alloc.  Must be set along with it. */
+  void                (*host_free) (void *ptr, void *user);
+  int                 mpi_aware;        /**< MPI accepts device pointers */
+  size_t              stage_bytes;      /**< size of one staging buffer;
+                                             0 selects SC_DEVICE_STAGE_BYTES */
+  void               *user;     /**< context passed to all callbacks */
+}
+sc_device_t;
+
+#ifndef SC_DEVICE_STAGE_BYTES
+/** The default size of one staging buffer. */
+#define SC_DEVICE_STAGE_BYTES (1 << 22)
+#endif
+
+/** Initialize an allocator that places array memory on a device.
+ * Reallocation copies the contents within the device.
+ * \param [out] allocator       Pass to \ref sc_array_init_allocator.
+ * \param [in] device           The device must outlive the allocator.
+ */
+void                sc_device_array_allocator (sc_array_allocator_t *
+                                               allocator,
+                                               const sc_device_t * device);
+
+/** Copy the contents of a device array into a host array.
+ * \param [out] dest            Host array of the same element size,
+ *                              resized to the count of \b src.
+ * \param [in] src              Array whose memory is on the device.
+ * \param [in] device           The device of \b src.
+ */
+void                sc_device_array_to_host (sc_array_t * dest,
+                                             sc_array_t * src,
+                                             const sc_device_t * device);
+
+/** Copy the contents of a host array into a device array.
+ * \param [out] dest            Device array of the same element size,
+ *                              resized to the count of \b src.
+ * \param [in] src              Array whose memory is on the host.
+ * \param [in] device           The device of \b dest.
+ */
+void                sc_device_array_to_device (sc_array_t * dest,
+                                               sc_array_t * src,
+                                               const sc_device_t * device);
+
+/** Collective notification with payload in device memory.
+ * This is \ref sc_notify_payload where \b in_payload and \b out_payload
+ * are arrays on the device.  The notification packs the payload on the
+ * host, so it is staged through host arrays in all cases.
+ * \param [in,out] receivers    See \ref sc_notify_payload.
+ * \param [in,out] senders      See \ref sc_notify_payload.
+ * \param [in,out] in_payload   If not NULL, a device array, see
+ *                              \ref sc_notify_payload.
+ * \param [in,out] out_payload  If not NULL, a device array, see
+ *                              \ref sc_notify_payload.
+ * \param [in] sorted           See \ref sc_notify_payload.
+ * \param [in] notify           See \ref sc_notify_payload.
+ * \param [in] device           The device of the payload arrays.
+ */
+void                sc_device_notify_payload (sc_array_t * receivers,
+                                              sc_array_t * senders,
+                                              sc_array_t * in_payload,
+                                              sc_array_t * out_payload,
+                                              int sorted,
+                                              sc_notify_t * notify,
+                                              const sc_device_t * device);
+
+/** Write device memory collectively to an MPI file at an offset.
+ * This is \ref sc_io_write_at_all for a pointer into device memory.
+ * If the device is mpi_aware, the pointer is passed to MPI directly.
+ * Otherwise, with MPI I/O the data is written in pieces of stage_bytes
+ * through two host buffers, such that the copy of one piece to the host
+ * overlaps the nonblocking write of the previous one.  Without MPI I/O
+ * the data is staged at once to keep the order of the ranks in the file.
+ * \param [in] mpicomm  The communicator of \b mpifile.
+ * \param [in,out] mpifile      See \ref sc_io_write_at_all.
+ * \param [in] offset   Starting offset in bytes, which assumes the
+ *                      default file view when writing in pieces.
+ * \param [in] ptr      Device memory to write to disk.
+ * \param [in] zcount   Number of array members.
+ * \param [in] t        The MPI type for each array member.
+ * \param [out] ocount  The number of written array members.
+ * \param [in] device   The device of \b ptr.
+ * \return              A sc_MPI_ERR_* as defined in \ref sc_mpi.h.
+ *                      All processes return after the same number of
+ *                      collective writes even if one of them fails.
+ */
+int                 sc_device_io_write_at_all (sc_MPI_Comm mpicomm,
+                                               sc_MPI_File mpifile,
+                                               sc_MPI_Offset offset,
+                                               const void *ptr,
+                                               size_t zcount,
+                                               sc_MPI_Datatype t,
+                                               int *ocount,
+                                               const sc_device_t * device);
+
+SC_EXTERN_C_END;
+
+#endif /* !SC_DEVICE_H */
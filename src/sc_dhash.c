@@ -0,0 +1,497 @@
+/*
+  This file is part of the SC Library.
+  The SC Library provides support for parallel scientific applications.
+
+  Copyright (C) 2010 The University of Texas System
+  Additional copyright (C) 2011 individual authors
+
+  The SC Library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  The SC Library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with the SC Library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+  02110-1301, USA.
+*/
+
+#include <sc_dhash.h>
+
+struct sc_dhash
+{
+  sc_MPI_Comm         mpicomm;
+  int                 mpisize, mpirank;
+  size_t              key_size, value_size, item_size;
+  sc_hash_function_t  hash_fn;
+  sc_equal_function_t equal_fn;
+  void               *user_data;
+  sc_notify_t        *notify;
+
+  /* the items owned by this process */
+  sc_mempool_t       *pool;
+  sc_hash_t          *hash;
+
+  /* the remote items looked up lately */
+  size_t              cache_capacity;
+  size_t              cache_hits;
+  sc_mempool_t       *cache_pool;
+  sc_hash_t          *cache;
+};
+
+/** A batch sorted by owner, split into the remote and the local part. */
+typedef struct sc_dhash_route
+{
+  sc_array_t          remote;   /**< Items of other owners by rank. */
+  sc_array_t          local;    /**< Items owned by this process. */
+  sc_array_t          receivers;        /**< Owners of the remote items. */
+  sc_array_t          send_offsets;     /**< Offsets into remote by owner. */
+  sc_array_t          senders;  /**< Processes that sent to us. */
+  sc_array_t          recv;     /**< Items received from the senders. */
+  sc_array_t          recv_offsets;     /**< Offsets into recv by sender. */
+}
+sc_dhash_route_t;
+
+sc_dhash_t         *
+sc_dhash_new (sc_MPI_Comm mpicomm, size_t key_size, size_t value_size,
+              sc_hash_function_t hash_fn, sc_equal_function_t equal_fn,
+              void *user_data)
+{
+  int                 mpiret;
+  sc_dhash_t         *dh;
+
+  SC_ASSERT (key_size > 0);
+  SC_ASSERT (hash_fn != NULL && equal_fn != NULL);
+
+  dh = SC_ALLOC_ZERO (sc_dhash_t, 1);
+  dh->mpicomm = mpicomm;
+  mpiret = sc_MPI_Comm_size (mpicomm, &dh->mpisize);
+  SC_CHECK_MPI (mpiret);
+  mpiret = sc_MPI_Comm_rank (mpicomm, &dh->mpirank);
+  SC_CHECK_MPI (mpiret);
+  dh->key_size = key_size;
+  dh->value_size = value_size;
+  dh->item_size = key_size + value_size;
+  dh->hash_fn = hash_fn;
+  dh->equal_fn = equal_fn;
+  dh->user_data = user_data;
+  dh->notify = sc_notify_new (mpicomm);
+
+  dh->pool = sc_mempool_new (dh->item_size);
+  dh->hash = sc_hash_new (hash_fn, equal_fn, user_data, NULL);
+  return dh;
+}
+
+/** Drop all cached items. */
+static void
+sc_dhash_cache_clear (sc_dhash_t * dh)
+{
+  if (dh->cache != NULL) {
+    sc_hash_truncate (dh->cache);
+    sc_mempool_truncate (dh->cache_pool);
+  }
+}
+
+void
+sc_dhash_destroy (sc_dhash_t * dh)
+{
+  SC_ASSERT (dh != NULL);
+
+  sc_dhash_set_cache (dh, 0);
+  sc_hash_destroy (dh->hash);
+  sc_mempool_destroy (dh->pool);
+  sc_notify_destroy (dh->notify);
+  SC_FREE (dh);
+}
+
+sc_notify_t        *
+sc_dhash_get_notify (sc_dhash_t * dh)
+{
+  return dh->notify;
+}
+
+void
+sc_dhash_set_cache (sc_dhash_t * dh, size_t capacity)
+{
+  SC_ASSERT (dh != NULL);
+
+  if (capacity == 0 && dh->cache != NULL) {
+    sc_hash_destroy (dh->cache);
+    sc_mempool_destroy (dh->cache_pool);
+    dh->cache = NULL;
+    dh->cache_pool = NULL;
+  }
+  else if (capacity > 0 && dh->cache == NULL) {
+    dh->cache_pool = sc_mempool_new (dh->item_size);
+    dh->cache = sc_hash_new (dh->hash_fn, dh->equal_fn, dh->user_data, NULL);
+  }
+  else if (dh->cache != NULL && dh->cache->elem_count > capacity) {
+    sc_dhash_cache_clear (dh);
+  }
+  dh->cache_capacity = capacity;
+}
+
+size_t
+sc_dhash_cache_hits (sc_dhash_t * dh)
+{
+  return dh->cache_hits;
+}
+
+int
+sc_dhash_owner (sc_dhash_t * dh, const void *key)
+{
+  uint64_t            h;
+
+  /* the high bits leave the low bits to the local hash tables */
+  h = (uint64_t) dh->hash_fn (key, dh->user_data);
+  return (int) ((h * (uint64_t) dh->mpisize) >> 32);
+}
+
+size_t
+sc_dhash_local_count (sc_dhash_t * dh)
+{
+  return dh->hash->elem_count;
+}
+
+/** Sort a batch by owner and exchange the remote part.
+ * \param [in] dh           Valid table.
+ * \param [in] batch        Items or keys; each element starts with a key.
+ * \param [out] route       All members are initialized.
+ * \param [out] perm        If not NULL, resized to the batch count.
+ *                          Entry i is the position of element i in the
+ *                          remote part, or the count of the remote part
+ *                          plus its position in the local part.
+ */
+static void
+sc_dhash_route (sc_dhash_t * dh, sc_array_t * batch,
+                sc_dhash_route_t * route, sc_array_t * perm)
+{
+  const size_t        n = batch->elem_count;
+  const size_t        size = batch->elem_size;
+  const int           P = dh->mpisize;
+  int                 q, s, *slot;
+  size_t              zz, nremote, *starts, *pos;
+
+  sc_array_init (&route->remote, size);
+  sc_array_init (&route->local, size);
+  sc_array_init (&route->receivers, sizeof (int));
+  sc_array_init (&route->send_offsets, sizeof (int));
+  sc_array_init (&route->senders, sizeof (int));
+  sc_array_init (&route->recv, size);
+  sc_array_init (&route->recv_offsets, sizeof (int));
+  *(int *) sc_array_push (&route->recv_offsets) = 0;
+
+  /* count by slot: the other owners by rank, then this process */
+  slot = SC_ALLOC (int, n);
+  starts = SC_ALLOC_ZERO (size_t, P + 1);
+  for (zz = 0; zz < n; ++zz) {
+    q = sc_dhash_owner (dh, sc_array_index (batch, zz));
+    s = q < dh->mpirank ? q : q > dh->mpirank ? q - 1 : P - 1;
+    slot[zz] = s;
+    ++starts[s + 1];
+  }
+  for (s = 0; s < P; ++s) {
+    starts[s + 1] += starts[s];
+  }
+  nremote = starts[P - 1];
+  SC_CHECK_ABORT (nremote <= (size_t) INT_MAX, "Batch too large");
+
+  /* the stable counting sort keeps the order of each owner's items */
+  sc_array_resize (&route->remote, nremote);
+  sc_array_resize (&route->local, n - nremote);
+  if (perm != NULL) {
+    SC_ASSERT (perm->elem_size == sizeof (size_t));
+    sc_array_resize (perm, n);
+  }
+  for (zz = 0; zz < n; ++zz) {
+    pos = &starts[slot[zz]];
+    memcpy (*pos < nremote ? sc_array_index (&route->remote, *pos) :
+            sc_array_index (&route->local, *pos - nremote),
+            sc_array_index (batch, zz), size);
+    if (perm != NULL) {
+      *(size_t *) sc_array_index (perm, zz) = *pos;
+    }
+    ++*pos;
+  }
+  SC_FREE (slot);
+
+  /* after the sort, starts[s] is the end of slot s */
+  *(int *) sc_array_push (&route->send_offsets) = 0;
+  for (s = 0; s < P - 1; ++s) {
+    if (starts[s] > (s == 0 ? 0 : starts[s - 1])) {
+      *(int *) sc_array_push (&route->receivers) =
+        s < dh->mpirank ? s : s + 1;
+      *(int *) sc_array_push (&route->send_offsets) = (int) starts[s];
+    }
+  }
+  SC_FREE (starts);
+
+  if (P > 1) {
+    sc_notify_payloadv (&route->receivers, &route->senders, &route->remote,
+                        &route->recv, &route->send_offsets,
+                        &route->recv_offsets, 1, dh->notify);
+  }
+}
+
+static void
+sc_dhash_route_reset (sc_dhash_route_t * route)
+{
+  sc_array_reset (&route->remote);
+  sc_array_reset (&route->local);
+  sc_array_reset (&route->receivers);
+  sc_array_reset (&route->send_offsets);
+  sc_array_reset (&route->senders);
+  sc_array_reset (&route->recv);
+  sc_array_reset (&route->recv_offsets);
+}
+
+/** Apply a function to the local and received parts in rank order.
+ * \param [in] dh           Valid table.
+ * \param [in] route        Routed batch.
+ * \param [in] fn           Called for every element.
+ */
+static void
+sc_dhash_apply (sc_dhash_t * dh, sc_dhash_route_t * route,
+                void (*fn) (sc_dhash_t * dh, void *elem))
+{
+  size_t              i, zz, nsenders;
+  int                 done_local = 0, *offsets;
+
+  nsenders = route->senders.elem_count;
+  offsets = (int *) route->recv_offsets.array;
+  for (i = 0; i <= nsenders; ++i) {
+    if (!done_local && (i == nsenders ||
+                        *(int *) sc_array_index (&route->senders, i) >
+                        dh->mpirank)) {
+      for (zz = 0; zz < route->local.elem_count; ++zz) {
+        fn (dh, sc_array_index (&route->local, zz));
+      }
+      done_local = 1;
+    }
+    if (i < nsenders) {
+      for (zz = (size_t) offsets[i]; zz < (size_t) offsets[i + 1]; ++zz) {
+        fn (dh, sc_array_index (&route->recv, zz));
+      }
+    }
+  }
+}
+
+static void
+sc_dhash_store (sc_dhash_t * dh, void *item)
+{
+  void              **found;
+  void               *entry;
+
+  if (sc_hash_lookup (dh->hash, item, &found)) {
+    memcpy ((char *) *found + dh->key_size, (char *) item + dh->key_size,
+            dh->value_size);
+    return;
+  }
+  entry = sc_mempool_alloc (dh->pool);
+  memcpy (entry, item, dh->item_size);
+  (void) sc_hash_insert_unique (dh->hash, entry, NULL);
+}
+
+static void
+sc_dhash_erase (sc_dhash_t * dh, void *key)
+{
+  void               *found;
+
+  if (sc_hash_remove (dh->hash, key, &found)) {
+    sc_mempool_free (dh->pool, found);
+  }
+}
+
+void
+sc_dhash_insert (sc_dhash_t * dh, sc_array_t * items)
+{
+  sc_dhash_route_t    route;
+
+  SC_ASSERT (items->elem_size == dh->item_size);
+
+  sc_dhash_cache_clear (dh);
+  sc_dhash_route (dh, items, &route, NULL);
+  sc_dhash_apply (dh, &route, sc_dhash_store);
+  sc_dhash_route_reset (&route);
+}
+
+void
+sc_dhash_remove (sc_dhash_t * dh, sc_array_t * keys)
+{
+  sc_dhash_route_t    route;
+
+  SC_ASSERT (keys->elem_size == dh->key_size);
+
+  sc_dhash_cache_clear (dh);
+  sc_dhash_route (dh, keys, &route, NULL);
+  sc_dhash_apply (dh, &route, sc_dhash_erase);
+  sc_dhash_route_reset (&route);
+}
+
+/** Answer a key owned by this process.
+ * \param [in] dh           Valid table.
+ * \param [in] key          Key to look up.
+ * \param [out] answer      The value followed by a byte that is true
+ *                          if the key is found.  The value is zero if not.
+ */
+static void
+sc_dhash_answer (sc_dhash_t * dh, void *key, char *answer)
+{
+  void              **found;
+
+  if (sc_hash_lookup (dh->hash, key, &found)) {
+    memcpy (answer, (char *) *found + dh->key_size, dh->value_size);
+    answer[dh->value_size] = 1;
+  }
+  else {
+    memset (answer, 0, dh->value_size + 1);
+  }
+}
+
+/** Remember a remote item, emptying a full cache first. */
+static void
+sc_dhash_cache_store (sc_dhash_t * dh, const void *key, const char *value)
+{
+  char               *entry;
+
+  if (dh->cache->elem_count >= dh->cache_capacity) {
+    sc_dhash_cache_clear (dh);
+  }
+  entry = (char *) sc_mempool_alloc (dh->cache_pool);
+  memcpy (entry, key, dh->key_size);
+  memcpy (entry + dh->key_size, value, dh->value_size);
+  if (!sc_hash_insert_unique (dh->cache, entry, NULL)) {
+    /* the key occurs more than once in the batch */
+    sc_mempool_free (dh->cache_pool, entry);
+  }
+}
+
+size_t
+sc_dhash_lookup (sc_dhash_t * dh, sc_array_t * keys, sc_array_t * values,
+                 sc_array_t * found)
+{
+  const size_t        n = keys->elem_count;
+  const size_t        asize = dh->value_size + 1;
+  int                 mpiret;
+  int                 i, nrecv, nsend, *offsets, *ranks;
+  size_t              zz, pos, nremote, nfound;
+  void              **hit;
+  char               *key, *result;
+  sc_array_t          results, query, qindex, perm, replies, answers;
+  sc_MPI_Request     *requests;
+  sc_dhash_route_t    route;
+
+  SC_ASSERT (keys->elem_size == dh->key_size);
+  SC_ASSERT (values == NULL || values->elem_size == dh->value_size);
+  SC_ASSERT (found == NULL || found->elem_size == sizeof (int));
+
+  /* keys of remote owners found in the cache are answered right away */
+  sc_array_init_count (&results, asize, n);
+  sc_array_init (&query, dh->key_size);
+  sc_array_init (&qindex, sizeof (size_t));
+  for (zz = 0; zz < n; ++zz) {
+    key = (char *) sc_array_index (keys, zz);
+    if (dh->cache != NULL && sc_hash_lookup (dh->cache, key, &hit)) {
+      result = (char *) sc_array_index (&results, zz);
+      memcpy (result, (char *) *hit + dh->key_size, dh->value_size);
+      result[dh->value_size] = 1;
+      ++dh->cache_hits;
+      continue;
+    }
+    memcpy (sc_array_push (&query), key, dh->key_size);
+    *(size_t *) sc_array_push (&qindex) = zz;
+  }
+  sc_array_init (&perm, sizeof (size_t));
+  sc_dhash_route (dh, &query, &route, &perm);
+
+  /* answer the received keys and return the answers to their senders */
+  sc_array_init_count (&replies, asize, route.recv.elem_count);
+  for (zz = 0; zz < route.recv.elem_count; ++zz) {
+    sc_dhash_answer (dh, sc_array_index (&route.recv, zz),
+                     (char *) sc_array_index (&replies, zz));
+  }
+  nremote = route.remote.elem_count;
+  SC_CHECK_ABORT (nremote * asize <= (size_t) INT_MAX &&
+                  replies.elem_count * asize <= (size_t) INT_MAX,
+                  "Lookup batch too large");
+  sc_array_init_count (&answers, asize, nremote);
+  nrecv = (int) route.receivers.elem_count;
+  nsend = (int) route.senders.elem_count;
+  requests = nrecv + nsend > 0 ?
+    SC_ALLOC (sc_MPI_Request, nrecv + nsend) : NULL;
+  offsets = (int *) route.send_offsets.array;
+  ranks = (int *) route.receivers.array;
+  for (i = 0; i < nrecv; ++i) {
+    /* we expect the answers of an owner in the order of our keys */
+    mpiret = sc_MPI_Irecv (answers.array + offsets[i] * asize,
+                           (int) ((offsets[i + 1] - offsets[i]) * asize),
+                           sc_MPI_BYTE, ranks[i], SC_TAG_DHASH, dh->mpicomm,
+                           &requests[i]);
+    SC_CHECK_MPI (mpiret);
+  }
+  offsets = (int *) route.recv_offsets.array;
+  ranks = (int *) route.senders.array;
+  for (i = 0; i < nsend; ++i) {
+    mpiret = sc_MPI_Isend (replies.array + offsets[i] * asize,
+                           (int) ((offsets[i + 1] - offsets[i]) * asize),
+                           sc_MPI_BYTE, ranks[i], SC_TAG_DHASH, dh->mpicomm,
+                           &requests[nrecv + i]);
+    SC_CHECK_MPI (mpiret);
+  }
+  if (requests != NULL) {
+    mpiret = sc_MPI_Waitall (nrecv + nsend, requests,
+                             sc_MPI_STATUSES_IGNORE);
+    SC_CHECK_MPI (mpiret);
+    SC_FREE (requests);
+  }
+  sc_array_reset (&replies);
+
+  /* combine the remote and the local answers in the order of the keys */
+  for (zz = 0; zz < query.elem_count; ++zz) {
+    pos = *(size_t *) sc_array_index (&perm, zz);
+    result = (char *) sc_array_index (&results,
+                                      *(size_t *) sc_array_index (&qindex,
+                                                                  zz));
+    if (pos < nremote) {
+      memcpy (result, sc_array_index (&answers, pos), asize);
+      if (dh->cache != NULL && result[dh->value_size]) {
+        sc_dhash_cache_store (dh, sc_array_index (&query, zz), result);
+      }
+    }
+    else {
+      sc_dhash_answer (dh, sc_array_index (&route.local, pos - nremote),
+                       result);
+    }
+  }
+  sc_array_reset (&answers);
+  sc_dhash_route_reset (&route);
+  sc_array_reset (&perm);
+  sc_array_reset (&qindex);
+  sc_array_reset (&query);
+
+  /* split the results into values and flags */
+  if (values != NULL) {
+    sc_array_resize (values, n);
+  }
+  if (found != NULL) {
+    sc_array_resize (found, n);
+  }
+  nfound = 0;
+  for (zz = 0; zz < n; ++zz) {
+    result = (char *) sc_array_index (&results, zz);
+    nfound += result[dh->value_size] != 0;
+    if (values != NULL) {
+      memcpy (sc_array_index (values, zz), result, dh->value_size);
+    }
+    if (found != NULL) {
+      *(int *) sc_array_index (found, zz) = result[dh->value_size] != 0;
+    }
+  }
+  sc_array_reset (&results);
+  return nfound;
+}
@@ -0,0 +1,146 @@
+/*
+  This file is part of the SC Library.
+  The SC Library provides support for parallel scientific applications.
+
+  Copyright (C) 2010 The University of Texas System
+  Additional copyright (C) 2011 individual authors
+
+  The SC Library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  The SC Library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with the SC Library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+  02110-1301, USA.
+*/
+
+#ifndef SC_DHASH_H
+#define SC_DHASH_H
+
+/** \file sc_dhash.h
+ *
+ * A hash table distributed over the processes of a communicator.
+ *
+ * Every key is owned by one process, which is determined by the hash value
+ * of the key.  The owner stores the key with its value.  Items are inserted,
+ * looked up and removed in batches by collective calls.  A batch is routed
+ * to the owners in one sparse exchange by \ref sc_notify_payloadv, and the
+ * answers to a lookup return by point-to-point messages, whose sizes are
+ * known to both sides.  The keys owned by the calling process are handled
+ * locally without messages.
+ *
+ * A process may keep a cache of the remote items it has looked up most
+ * recently.  A cache is only valid while the table does not change, so
+ * every insertion or removal batch clears the caches of all processes.
+ *
+ * \ingroup sc_parallelism
+ */
+
+#include <sc_containers.h>
+#include <sc_notify.h>
+
+SC_EXTERN_C_BEGIN;
+
+/** Opaque distributed hash table. */
+typedef struct sc_dhash sc_dhash_t;
+
+/** Create an empty distributed hash table.  Collective.
+ * An item consists of a key followed by its value.  The hash and equality
+ * functions are called with pointers to items or to bare keys and must
+ * only read the first \a key_size bytes.  The hash function must return
+ * the same value for a key on every process.
+ * \param [in] mpicomm      The processes sharing the table.
+ * \param [in] key_size     Size of a key in bytes, positive.
+ * \param [in] value_size   Size of a value in bytes, may be zero.
+ * \param [in] hash_fn      Hash function of keys.  The owner of a key is
+ *                          chosen by the high bits of its hash value, which
+ *                          should be well distributed over 32 bits.
+ * \param [in] equal_fn     Equality function of keys.
+ * \param [in] user_data    Passed to both functions.
+ * \return                  Table to be destroyed with \ref sc_dhash_destroy.
+ */
+sc_dhash_t         *sc_dhash_new (sc_MPI_Comm mpicomm, size_t key_size,
+                                  size_t value_size,
+                                  sc_hash_function_t hash_fn,
+                                  sc_equal_function_t equal_fn,
+                                  void *user_data);
+
+/** Destroy a distributed hash table.  Not collective.
+ * \param [in] dh           Table created by \ref sc_dhash_new.
+ */
+void                sc_dhash_destroy (sc_dhash_t * dh);
+
+/** Return the notify controller used to route the batches.
+ * Its type may be changed, consistently on all processes.
+ * \param [in] dh           Valid table.
+ * \return                  The controller owned by the table.
+ */
+sc_notify_t        *sc_dhash_get_notify (sc_dhash_t * dh);
+
+/** Set the number of remote items cached on this process.  Not collective.
+ * The cache is emptied when it is full and a new item is to be cached.
+ * \param [in,out] dh       Valid table.
+ * \param [in] capacity     Maximum number of cached items.  Zero, the
+ *                          default, disables and empties the cache.
+ */
+void                sc_dhash_set_cache (sc_dhash_t * dh, size_t capacity);
+
+/** Return the number of keys answered from the cache.  Not collective.
+ * \param [in] dh           Valid table.
+ * \return                  Count of cache hits since creation.
+ */
+size_t              sc_dhash_cache_hits (sc_dhash_t * dh);
+
+/** Return the process owning a key.  Not collective.
+ * \param [in] dh           Valid table.
+ * \param [in] key          Key of the table's key size.
+ * \return                  Rank in the communicator of the table.
+ */
+int                 sc_dhash_owner (sc_dhash_t * dh, const void *key);
+
+/** Return the number of items stored on this process.  Not collective.
+ * \param [in] dh           Valid table.
+ * \return                  Count of the items owned by this process.
+ */
+size_t              sc_dhash_local_count (sc_dhash_t * dh);
+
+/** Insert a batch of items or replace their values.  Collective.
+ * If several processes insert the same key in one batch, the value of the
+ * highest rank is kept.  Within the batch of one process, the last item
+ * of a key counts.
+ * \param [in,out] dh       Valid table.
+ * \param [in] items        Array of element size key plus value size.
+ */
+void                sc_dhash_insert (sc_dhash_t * dh, sc_array_t * items);
+
+/** Remove a batch of keys.  Collective.
+ * Keys that are not contained are ignored.
+ * \param [in,out] dh       Valid table.
+ * \param [in] keys         Array whose element size is the key size.
+ */
+void                sc_dhash_remove (sc_dhash_t * dh, sc_array_t * keys);
+
+/** Look up the values of a batch of keys.  Collective.
+ * \param [in,out] dh       Valid table.  Its cache may be updated.
+ * \param [in] keys         Array whose element size is the key size.
+ * \param [in,out] values   If not NULL, an array whose element size is the
+ *                          value size.  It is resized to the number of
+ *                          keys.  The values of keys not found are zero.
+ * \param [in,out] found    If not NULL, an array of element size
+ *                          sizeof (int) resized to the number of keys.
+ *                          Each entry is true if its key is contained.
+ * \return                  The number of keys found.
+ */
+size_t              sc_dhash_lookup (sc_dhash_t * dh, sc_array_t * keys,
+                                     sc_array_t * values, sc_array_t * found);
+
+SC_EXTERN_C_END;
+
+#endif /* !SC_DHASH_H */
@@ -22,6 +22,11 @@
 */
 
 #include <sc_flops.h>
+#include <sc_containers.h>
+#include <sc_private.h>
+#ifdef SC_HAVE_CLOCK_GETTIME
+#include <time.h>
+#endif
 
 #ifdef SC_PAPI
 #ifdef SC_HAVE_SYS_TYPES_H
@@ -29,6 +34,164 @@
 #endif
 #include <papi.h>
 #endif
+#ifdef SC_ENABLE_PTHREAD
+#include <pthread.h>
+#endif
+#ifdef SC_HAVE_LINUX_PERF_EVENT_H
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#ifdef SC_HAVE_UNISTD_H
+#include <unistd.h>
+#endif
+#endif
+
+const char         *sc_flops_counter_names[SC_FLOPS_NUM_COUNTERS] =
+  { "cycles", "instructions", "llc_references", "llc_misses",
+  "branch_misses"
+};
+
+int                 sc_flops_use_clock = 0;
+
+#ifdef SC_HAVE_CLOCK_GETTIME
+#ifdef CLOCK_MONOTONIC_RAW
+static clockid_t    sc_clock_id = CLOCK_MONOTONIC_RAW;
+#else
+static clockid_t    sc_clock_id = CLOCK_MONOTONIC;
+#endif
+static time_t       sc_clock_origin = 0;
+#endif
+static double       sc_clock_tick = 1.e-6;
+
+void
+sc_clock_init (void)
+{
+#ifdef SC_HAVE_CLOCK_GETTIME
+  struct timespec     ts;
+
+  /* the raw clock may not be supported by the running kernel */
+  if (clock_gettime (sc_clock_id, &ts) != 0) {
+    sc_clock_id = CLOCK_MONOTONIC;
+    SC_CHECK_ABORT (clock_gettime (sc_clock_id, &ts) == 0, "clock_gettime");
+  }
+  sc_clock_origin = ts.tv_sec;
+  if (clock_getres (sc_clock_id, &ts) == 0) {
+    sc_clock_tick = ts.tv_sec + 1.e-9 * ts.tv_nsec;
+  }
+#endif
+}
+
+double
+sc_clock (void)
+{
+#ifdef SC_HAVE_CLOCK_GETTIME
+  struct timespec     ts;
+
+  clock_gettime (sc_clock_id, &ts);
+  return (double) (ts.tv_sec - sc_clock_origin) + 1.e-9 * ts.tv_nsec;
+#else
+  return sc_MPI_Wtime ();
+#endif
+}
+
+double
+sc_clock_resolution (void)
+{
+  return sc_clock_tick;
+}
+
+int                 sc_probes_enabled = 0;
+
+/** The registered probe sites, most recent first. */
+static sc_probe_t  *sc_probes_head = NULL;
+
+void
+sc_probe_register (sc_probe_t * probe)
+{
+  int                 expected = 0;
+  sc_probe_t         *head;
+
+  /* only the first of concurrent callers links the probe */
+  if (!SC_ATOMIC_CAS (&probe->registered, &expected, 1)) {
+    return;
+  }
+  head = SC_ATOMIC_LOAD (&sc_probes_head);
+  do {
+    probe->next = head;
+  }
+  while (!SC_ATOMIC_CAS (&sc_probes_head, &head, probe));
+}
+
+void
+sc_probes_add_options (sc_options_t * opt)
+{
+  sc_options_add_bool (opt, '\0', "probes", &sc_probes_enabled,
+                       sc_probes_enabled,
+                       "Record the regions of probe sites");
+}
+
+void
+sc_probes_reset (void)
+{
+  sc_probe_t         *probe;
+
+  for (probe = SC_ATOMIC_LOAD (&sc_probes_head); probe != NULL;
+       probe = probe->next) {
+    probe->calls = probe->nanoseconds = 0;
+  }
+}
+
+void
+sc_probes_iterate (void (*fn) (sc_probe_t * probe, void *user), void *user)
+{
+  sc_probe_t         *probe;
+
+  for (probe = SC_ATOMIC_LOAD (&sc_probes_head); probe != NULL;
+       probe = probe->next) {
+    fn (probe, user);
+  }
+}
+
+static int          sc_flops_num_counters = 0;
+static int          sc_flops_counter_fds[SC_FLOPS_MAX_COUNTERS];
+static sc_flops_counter_t sc_flops_counter_events[SC_FLOPS_MAX_COUNTERS];
+
+#ifndef SC_FLOPS_TRACE_EVENTS
+/** The default maximum number of trace events per thread. */
+#define SC_FLOPS_TRACE_EVENTS (1 << 20)
+#endif
+
+/** One begin or end of a region. */
+typedef struct sc_flops_event
+{
+  const char         *name;
+  double              seconds;
+  int                 begin;
+}
+sc_flops_event_t;
+
+/** The events recorded by one thread. */
+typedef struct sc_flops_trace_buffer
+{
+  int                 tid;
+  size_t              num_events;
+  size_t              num_alloc;
+  size_t              num_dropped;
+  sc_flops_event_t   *events;
+  struct sc_flops_trace_buffer *next;
+}
+sc_flops_trace_buffer_t;
+
+static int          sc_flops_trace_active = 0;
+static size_t       sc_flops_trace_max_events;
+static double       sc_flops_trace_origin;
+static int          sc_flops_trace_num_threads;
+static sc_flops_trace_buffer_t *sc_flops_trace_buffers = NULL;
+
+#ifdef SC_ENABLE_PTHREAD
+/* the mutex protects the list of buffers */
+static pthread_mutex_t sc_flops_trace_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_key_t sc_flops_trace_key;
+#endif
 
 void
 sc_flops_papi (float *rtime, float *ptime, long long *flpops, float *mflops)
@@ -44,13 +207,101 @@ sc_flops_papi (float *rtime, float *ptime, long long *flpops, float *mflops)
 #endif
 }
 
+int
+sc_flops_counters_open (int num_counters, const sc_flops_counter_t * counters)
+{
+#ifdef SC_HAVE_LINUX_PERF_EVENT_H
+  int                 k, fd;
+  struct perf_event_attr attr;
+  static const unsigned long long configs[SC_FLOPS_NUM_COUNTERS] =
+    { PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS,
+    PERF_COUNT_HW_CACHE_REFERENCES, PERF_COUNT_HW_CACHE_MISSES,
+    PERF_COUNT_HW_BRANCH_MISSES
+  };
+#endif
+
+  SC_CHECK_ABORT (0 <= num_counters && num_counters <= SC_FLOPS_MAX_COUNTERS,
+                  "Invalid number of counters");
+  sc_flops_counters_close ();
+
+#ifdef SC_HAVE_LINUX_PERF_EVENT_H
+  for (k = 0; k < num_counters; ++k) {
+    SC_ASSERT (0 <= counters[k] && counters[k] < SC_FLOPS_NUM_COUNTERS);
+    memset (&attr, 0, sizeof (attr));
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.size = sizeof (attr);
+    attr.config = configs[counters[k]];
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    fd = (int) syscall (__NR_perf_event_open, &attr, 0, -1, -1, 0);
+    if (fd < 0) {
+      /* the kernel may not allow counting or lack the event */
+      SC_LDEBUGF ("Counter %s unavailable\n",
+                  sc_flops_counter_names[counters[k]]);
+      sc_flops_counters_close ();
+      return -1;
+    }
+    sc_flops_counter_fds[k] = fd;
+    sc_flops_counter_events[k] = counters[k];
+    sc_flops_num_counters = k + 1;
+  }
+  return 0;
+#else
+  return num_counters > 0 ? -1 : 0;
+#endif
+}
+
+int
+sc_flops_counters_num (void)
+{
+  return sc_flops_num_counters;
+}
+
+sc_flops_counter_t
+sc_flops_counters_event (int k)
+{
+  SC_ASSERT (0 <= k && k < sc_flops_num_counters);
+  return sc_flops_counter_events[k];
+}
+
+void
+sc_flops_counters_close (void)
+{
+#ifdef SC_HAVE_LINUX_PERF_EVENT_H
+  int                 k;
+
+  for (k = 0; k < sc_flops_num_counters; ++k) {
+    close (sc_flops_counter_fds[k]);
+  }
+#endif
+  sc_flops_num_counters = 0;
+}
+
+/** Read the open counters into an array. */
+static void
+sc_flops_counters_read (int num_counters, long long *values)
+{
+  int                 k;
+
+  for (k = 0; k < num_counters; ++k) {
+    values[k] = 0;
+#ifdef SC_HAVE_LINUX_PERF_EVENT_H
+    if (read (sc_flops_counter_fds[k], &values[k], sizeof (long long)) !=
+        (ssize_t) sizeof (long long)) {
+      values[k] = 0;
+    }
+#endif
+  }
+}
+
 static void
 sc_flops_start_internal (sc_flopinfo_t * fi, int use_papi)
 {
   float               rtime, ptime, mflops;
   long long           flpops;
 
-  fi->seconds = sc_MPI_Wtime ();
+  fi->use_clock = sc_flops_use_clock;
+  fi->seconds = fi->use_clock ? sc_clock () : sc_MPI_Wtime ();
   if (use_papi) {
     sc_flops_papi (&rtime, &ptime, &flpops, &mflops);     /* ignore results */
   }
@@ -64,6 +315,12 @@ sc_flops_start_internal (sc_flopinfo_t * fi, int use_papi)
   fi->iflpops = 0;
 
   fi->use_papi = use_papi;
+
+  fi->num_counters = sc_flops_num_counters;
+  memset (fi->ccounters, 0, sizeof (fi->ccounters));
+  memset (fi->icounters, 0, sizeof (fi->icounters));
+  memset (fi->rcounters, 0, sizeof (fi->rcounters));
+  sc_flops_counters_read (fi->num_counters, fi->rcounters);
 }
 
 void
@@ -85,7 +342,7 @@ sc_flops_count (sc_flopinfo_t * fi)
   float               rtime = 0., ptime = 0.;
   long long           flpops = 0;
 
-  seconds = sc_MPI_Wtime ();
+  seconds = fi->use_clock ? sc_clock () : sc_MPI_Wtime ();
   if (fi->use_papi) {
     sc_flops_papi (&rtime, &ptime, &flpops, &fi->mflops);
   }
@@ -99,6 +356,19 @@ sc_flops_count (sc_flopinfo_t * fi)
   fi->iflpops = flpops - fi->cflpops;
   fi->cflpops = flpops;
 
+  if (fi->num_counters > 0) {
+    int                 k;
+    long long           raw[SC_FLOPS_MAX_COUNTERS];
+
+    SC_ASSERT (fi->num_counters == sc_flops_num_counters);
+    sc_flops_counters_read (fi->num_counters, raw);
+    for (k = 0; k < fi->num_counters; ++k) {
+      fi->icounters[k] = raw[k] - fi->rcounters[k];
+      fi->ccounters[k] += fi->icounters[k];
+      fi->rcounters[k] = raw[k];
+    }
+  }
+
 #ifdef SC_PAPI
   if (fi->use_papi) {
     fi->irtime = rtime - fi->crtime;
@@ -132,6 +402,7 @@ sc_flops_shot (sc_flopinfo_t * fi, sc_flopinfo_t * snapshot)
 void
 sc_flops_shotv (sc_flopinfo_t * fi, ...)
 {
+  int                 k;
   sc_flopinfo_t      *snapshot;
   va_list             ap;
 
@@ -146,6 +417,12 @@ sc_flops_shotv (sc_flopinfo_t * fi, ...)
     snapshot->mflops =
       (float) ((double) snapshot->iflpops / 1.e6 / snapshot->irtime);
 
+    for (k = 0; k < fi->num_counters; ++k) {
+      snapshot->icounters[k] = fi->ccounters[k] - snapshot->ccounters[k];
+      snapshot->ccounters[k] = fi->ccounters[k];
+      snapshot->rcounters[k] = fi->rcounters[k];
+    }
+
     snapshot->seconds = fi->seconds;
     snapshot->cwtime = fi->cwtime;
     snapshot->crtime = fi->crtime;
@@ -154,3 +431,231 @@ sc_flops_shotv (sc_flopinfo_t * fi, ...)
   }
   va_end (ap);
 }
+
+void
+sc_flops_trace_start (size_t max_events)
+{
+#ifdef SC_ENABLE_PTHREAD
+  int                 pth;
+#endif
+
+  if (sc_flops_trace_active) {
+    return;
+  }
+#ifdef SC_ENABLE_PTHREAD
+  pth = pthread_key_create (&sc_flops_trace_key, NULL);
+  SC_CHECK_ABORT (pth == 0, "Trace key creation");
+#endif
+  sc_flops_trace_max_events =
+    max_events > 0 ? max_events : SC_FLOPS_TRACE_EVENTS;
+  sc_flops_trace_origin = sc_MPI_Wtime ();
+  sc_flops_trace_num_threads = 0;
+  sc_flops_trace_active = 1;
+}
+
+int
+sc_flops_trace_is_active (void)
+{
+  return sc_flops_trace_active;
+}
+
+/** Return the buffer of the calling thread, creating it if necessary. */
+static sc_flops_trace_buffer_t *
+sc_flops_trace_buffer (void)
+{
+  sc_flops_trace_buffer_t *buf;
+
+#ifdef SC_ENABLE_PTHREAD
+  buf = (sc_flops_trace_buffer_t *) pthread_getspecific (sc_flops_trace_key);
+#else
+  buf = sc_flops_trace_buffers;
+#endif
+  if (buf == NULL) {
+    /* the buffers are not counted since they may outlive the threads */
+    buf = (sc_flops_trace_buffer_t *)
+      calloc (1, sizeof (sc_flops_trace_buffer_t));
+    SC_CHECK_ABORT (buf != NULL, "Trace buffer allocation");
+#ifdef SC_ENABLE_PTHREAD
+    pthread_mutex_lock (&sc_flops_trace_mutex);
+#endif
+    buf->tid = sc_flops_trace_num_threads++;
+    buf->next = sc_flops_trace_buffers;
+    sc_flops_trace_buffers = buf;
+#ifdef SC_ENABLE_PTHREAD
+    pthread_mutex_unlock (&sc_flops_trace_mutex);
+    pthread_setspecific (sc_flops_trace_key, buf);
+#endif
+  }
+  return buf;
+}
+
+static void
+sc_flops_trace_record (const char *name, int begin)
+{
+  sc_flops_trace_buffer_t *buf;
+  sc_flops_event_t   *ev;
+
+  if (!sc_flops_trace_active) {
+    return;
+  }
+  buf = sc_flops_trace_buffer ();
+  if (buf->num_events == buf->num_alloc) {
+    if (buf->num_alloc == sc_flops_trace_max_events) {
+      ++buf->num_dropped;
+      return;
+    }
+    buf->num_alloc = SC_MIN (SC_MAX (2 * buf->num_alloc, 64),
+                             sc_flops_trace_max_events);
+    buf->events = (sc_flops_event_t *)
+      realloc (buf->events, buf->num_alloc * sizeof (sc_flops_event_t));
+    SC_CHECK_ABORT (buf->events != NULL, "Trace buffer allocation");
+  }
+  ev = buf->events + buf->num_events++;
+  ev->name = name;
+  ev->seconds = sc_MPI_Wtime ();
+  ev->begin = begin;
+}
+
+void
+sc_flops_trace_begin (const char *name)
+{
+  sc_flops_trace_record (name, 1);
+}
+
+void
+sc_flops_trace_end (const char *name)
+{
+  sc_flops_trace_record (name, 0);
+}
+
+/** Append formatted text to a byte array. */
+static void
+sc_flops_trace_printf (sc_array_t * text, const char *fmt, ...)
+  __attribute__ ((format (printf, 2, 3)));
+
+static void
+sc_flops_trace_printf (sc_array_t * text, const char *fmt, ...)
+{
+  char                line[BUFSIZ];
+  int                 length;
+  va_list             ap;
+
+  va_start (ap, fmt);
+  length = vsnprintf (line, BUFSIZ, fmt, ap);
+  va_end (ap);
+  length = SC_MIN (length, BUFSIZ - 1);
+  memcpy (sc_array_push_count (text, (size_t) length), line, length);
+}
+
+int
+sc_flops_trace_write (sc_MPI_Comm mpicomm, const char *filename)
+{
+  int                 mpiret;
+  int                 mpisize, mpirank;
+  int                 p, length, errcode = sc_MPI_SUCCESS;
+  int                *lengths = NULL, *offsets = NULL;
+  size_t              zz, num_dropped = 0;
+  char               *all = NULL;
+  FILE               *file;
+  sc_array_t          text;
+  sc_flops_event_t   *ev;
+  sc_flops_trace_buffer_t *buf;
+
+  mpiret = sc_MPI_Comm_size (mpicomm, &mpisize);
+  SC_CHECK_MPI (mpiret);
+  mpiret = sc_MPI_Comm_rank (mpicomm, &mpirank);
+  SC_CHECK_MPI (mpiret);
+
+  /* every event is preceded by a comma that is skipped for the first */
+  sc_array_init (&text, 1);
+  sc_flops_trace_printf (&text, ",\n{\"name\":\"process_name\",\"ph\":\"M\","
+                         "\"pid\":%d,\"args\":{\"name\":\"rank %d\"}}",
+                         mpirank, mpirank);
+#ifdef SC_ENABLE_PTHREAD
+  pthread_mutex_lock (&sc_flops_trace_mutex);
+#endif
+  for (buf = sc_flops_trace_buffers; buf != NULL; buf = buf->next) {
+    for (zz = 0; zz < buf->num_events; ++zz) {
+      ev = buf->events + zz;
+      sc_flops_trace_printf (&text, ",\n{\"name\":\"%s\",\"ph\":\"%c\","
+                             "\"ts\":%.3f,\"pid\":%d,\"tid\":%d}",
+                             ev->name, ev->begin ? 'B' : 'E',
+                             1.e6 * (ev->seconds - sc_flops_trace_origin),
+                             mpirank, buf->tid);
+    }
+    num_dropped += buf->num_dropped;
+  }
+#ifdef SC_ENABLE_PTHREAD
+  pthread_mutex_unlock (&sc_flops_trace_mutex);
+#endif
+  if (num_dropped > 0) {
+    SC_LERRORF ("Event trace dropped %llu events\n",
+                (unsigned long long) num_dropped);
+  }
+
+  /* gather the text of all processes to rank 0 */
+  SC_CHECK_ABORT (text.elem_count <= (size_t) INT_MAX, "Event trace size");
+  length = (int) text.elem_count;
+  if (mpirank == 0) {
+    lengths = SC_ALLOC (int, mpisize);
+    offsets = SC_ALLOC (int, mpisize + 1);
+  }
+  mpiret = sc_MPI_Gather (&length, 1, sc_MPI_INT,
+                          lengths, 1, sc_MPI_INT, 0, mpicomm);
+  SC_CHECK_MPI (mpiret);
+  if (mpirank == 0) {
+    offsets[0] = 0;
+    for (p = 0; p < mpisize; ++p) {
+      SC_CHECK_ABORT (offsets[p] <= INT_MAX - lengths[p], "Event trace size");
+      offsets[p + 1] = offsets[p] + lengths[p];
+    }
+    all = SC_ALLOC (char, offsets[mpisize]);
+  }
+  mpiret = sc_MPI_Gatherv (text.array, length, sc_MPI_CHAR,
+                           all, lengths, offsets, sc_MPI_CHAR, 0, mpicomm);
+  SC_CHECK_MPI (mpiret);
+  sc_array_reset (&text);
+
+  if (mpirank == 0) {
+    file = fopen (filename, "w");
+    if (file == NULL ||
+        fputs ("{\"traceEvents\":[", file) < 0 ||
+        fwrite (all + 1, 1, offsets[mpisize] - 1, file) !=
+        (size_t) offsets[mpisize] - 1 ||
+        fputs ("\n],\"displayTimeUnit\":\"ms\"}\n", file) < 0) {
+      errcode = sc_MPI_ERR_IO;
+    }
+    if (file != NULL && fclose (file)) {
+      errcode = sc_MPI_ERR_IO;
+    }
+    if (errcode != sc_MPI_SUCCESS) {
+      SC_LERRORF ("Event trace write to %s failed\n", filename);
+    }
+    SC_FREE (all);
+    SC_FREE (offsets);
+    SC_FREE (lengths);
+  }
+  mpiret = sc_MPI_Bcast (&errcode, 1, sc_MPI_INT, 0, mpicomm);
+  SC_CHECK_MPI (mpiret);
+
+  return errcode;
+}
+
+void
+sc_flops_trace_stop (void)
+{
+  sc_flops_trace_buffer_t *buf;
+
+  if (!sc_flops_trace_active) {
+    return;
+  }
+  sc_flops_trace_active = 0;
+  while ((buf = sc_flops_trace_buffers) != NULL) {
+    sc_flops_trace_buffers = buf->next;
+    free (buf->events);
+    free (buf);
+  }
+#ifdef SC_ENABLE_PTHREAD
+  pthread_key_delete (sc_flops_trace_key);
+#endif
+}
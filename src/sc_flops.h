@@ -24,10 +24,32 @@
 #ifndef SC_FLOPS_H
 #define SC_FLOPS_H
 
-#include <sc.h>
+#include <sc_atomic.h>
+#include <sc_options.h>
 
 SC_EXTERN_C_BEGIN;
 
+/** The maximum number of hardware counters in a sc_flopinfo_t. */
+#define SC_FLOPS_MAX_COUNTERS 4
+
+/** The hardware events that can be counted by \ref sc_flops_counters_open.
+ * The last level cache misses times the cache line size approximate the
+ * memory traffic of a region.
+ */
+typedef enum sc_flops_counter
+{
+  SC_FLOPS_CYCLES,              /**< Processor cycles. */
+  SC_FLOPS_INSTRUCTIONS,        /**< Retired instructions. */
+  SC_FLOPS_LLC_REFERENCES,      /**< Last level cache references. */
+  SC_FLOPS_LLC_MISSES,          /**< Last level cache misses. */
+  SC_FLOPS_BRANCH_MISSES,       /**< Mispredicted branches. */
+  SC_FLOPS_NUM_COUNTERS
+}
+sc_flops_counter_t;
+
+/** Short names of the counters, say for statistics variables. */
+extern const char  *sc_flops_counter_names[SC_FLOPS_NUM_COUNTERS];
+
 typedef struct sc_flopinfo
 {
   double              seconds;  /* current time from sc_MPI_Wtime */
@@ -47,9 +69,73 @@ typedef struct sc_flopinfo
 
   /* without SC_PAPI only seconds, ?wtime and ?rtime are meaningful */
   int                 use_papi;
+
+  /* the wall times are taken by sc_clock instead of sc_MPI_Wtime */
+  int                 use_clock;
+
+  /* the counters of sc_flops_counters_open at the time of sc_flops_start */
+  int                 num_counters;
+  long long           ccounters[SC_FLOPS_MAX_COUNTERS]; /* cumulative */
+  long long           icounters[SC_FLOPS_MAX_COUNTERS]; /* interval */
+  long long           rcounters[SC_FLOPS_MAX_COUNTERS]; /* last raw value */
 }
 sc_flopinfo_t;
 
+/**
+ * Open hardware counters for the calling thread.
+ * They are read by every sc_flopinfo_t started afterwards into the
+ * ccounters and icounters members, in the order given here.
+ * We use the Linux perf_event_open system call counting user space only.
+ * Counters already open are closed first.
+ *
+ * \param [in] num_counters At most \ref SC_FLOPS_MAX_COUNTERS.
+ * \param [in] counters     The events to count.
+ * \return                  0 on success, or -1 if the counters are not
+ *                          available, in which case none are open.
+ */
+int                 sc_flops_counters_open (int num_counters,
+                                            const sc_flops_counter_t *
+                                            counters);
+
+/**
+ * Return the number of open hardware counters.
+ */
+int                 sc_flops_counters_num (void);
+
+/**
+ * Return the event counted by an open counter.
+ *
+ * \param [in] k            Less than \ref sc_flops_counters_num.
+ */
+sc_flops_counter_t  sc_flops_counters_event (int k);
+
+/**
+ * Close the hardware counters.  Started sc_flopinfo_t must not be counted
+ * afterwards.
+ */
+void                sc_flops_counters_close (void);
+
+/** If nonzero, sc_flopinfo_t started afterwards measure their wall times
+ * by \ref sc_clock.  It is set by \ref sc_init if the environment variable
+ * SC_FLOPS_CLOCK is a positive number.  The default is 0.
+ */
+extern int          sc_flops_use_clock;
+
+/**
+ * Return the time in seconds of a monotonic high resolution clock.
+ * We use clock_gettime with CLOCK_MONOTONIC_RAW where available and
+ * fall back to CLOCK_MONOTONIC and finally to sc_MPI_Wtime.
+ * The clock is unaffected by adjustments of the system time, and its
+ * origin is set in \ref sc_init such that small differences of the
+ * results keep their full precision.  This function is thread safe.
+ */
+double              sc_clock (void);
+
+/**
+ * Return the resolution in seconds of the clock used by \ref sc_clock.
+ */
+double              sc_clock_resolution (void);
+
 /**
  * Calls PAPI_flops.  Aborts on PAPI error.
  * The first call sets up the performance counters.
@@ -116,23 +202,164 @@ void                sc_flops_shot (sc_flopinfo_t * fi,
  */
 void                sc_flops_shotv (sc_flopinfo_t * fi, ...);
 
+/**
+ * Start recording the begin and end of regions into an event trace.
+ * Each thread records into its own buffer that is kept until
+ * \ref sc_flops_trace_stop.  Nothing is recorded before this call.
+ * Recording is also started by \ref sc_init if the environment variable
+ * SC_FLOPS_TRACE holds a file name, and then written by \ref sc_finalize.
+ * This function must not be called concurrently to recording.
+ *
+ * \param [in] max_events   Maximum number of events per thread, further
+ *                          events of a thread are dropped.
+ *                          0 selects a default.
+ */
+void                sc_flops_trace_start (size_t max_events);
+
+/**
+ * Return whether events are currently recorded.
+ */
+int                 sc_flops_trace_is_active (void);
+
+/**
+ * Record the beginning of a region on the calling thread.
+ * Does nothing if the trace is not active.
+ *
+ * \param [in] name         Name of the region.  This must be a string
+ *                          that lives until the trace is written.
+ */
+void                sc_flops_trace_begin (const char *name);
+
+/**
+ * Record the end of a region on the calling thread.
+ * Does nothing if the trace is not active.
+ *
+ * \param [in] name         Name of the region as passed to the begin.
+ */
+void                sc_flops_trace_end (const char *name);
+
+/**
+ * Write the recorded events of all processes to one file.
+ * The format is the Chrome trace event JSON, with the process rank and
+ * thread number as pid and tid.  Times are in microseconds since the
+ * call to \ref sc_flops_trace_start on each process.
+ * This function is collective and the recording may continue after it.
+ *
+ * \param [in] mpicomm      The events are gathered to its rank 0.
+ * \param [in] filename     Name of the file written by rank 0.
+ * \return                  sc_MPI_SUCCESS or sc_MPI_ERR_IO if the file
+ *                          could not be written, the same on all ranks.
+ */
+int                 sc_flops_trace_write (sc_MPI_Comm mpicomm,
+                                          const char *filename);
+
+/**
+ * Stop recording and free the events of all threads.
+ * This function must not be called concurrently to recording.
+ */
+void                sc_flops_trace_stop (void);
+
 /**
  * Accumulate sc_flops_snap()/sc_flops_shot() statistics for a function into
- * an (sc_statistics_t *) */
+ * an (sc_statistics_t *) and record the region in an active event trace */
 #define SC_FUNC_SNAP(stat,flop,snap)              \
   do {                                            \
     if (!sc_statistics_has ((stat), __func__)) {  \
       sc_statistics_add_empty ((stat), __func__); \
     }                                             \
+    sc_flops_trace_begin (__func__);              \
     sc_flops_snap ((flop), (snap));               \
   } while (0)
 
 #define SC_FUNC_SHOT(stat,flop,snap)                             \
   do {                                                           \
     sc_flops_shot ((flop), (snap));                              \
+    sc_flops_trace_end (__func__);                               \
     sc_statistics_accumulate ((stat), __func__, (snap)->iwtime); \
+    if ((snap)->num_counters > 0) {                              \
+      sc_statistics_accumulate_counters ((stat), __func__,       \
+                                         (snap));                \
+    }                                                            \
   } while (0)
 
+/** A probe site counts the calls and the time spent in a code region.
+ * The members are updated by \ref SC_PROBE_BEGIN and \ref SC_PROBE_END
+ * and must not be accessed directly while probes are recorded.
+ */
+typedef struct sc_probe
+{
+  const char         *name;     /**< Name of the region. */
+  int                 registered;       /**< Nonzero once in the list. */
+  long long           calls;    /**< Number of completed regions. */
+  long long           nanoseconds;      /**< Time spent in the region. */
+  struct sc_probe    *next;     /**< Next registered probe site. */
+}
+sc_probe_t;
+
+/** If nonzero, probe sites record their regions.  The default is 0.
+ * It may be changed at any time, see \ref sc_probes_add_options.
+ */
+extern int          sc_probes_enabled;
+
+/**
+ * Add the probe site to the list of probes.
+ * This is called by \ref SC_PROBE_END on the first recorded region.
+ * This function is thread safe.
+ */
+void                sc_probe_register (sc_probe_t * probe);
+
+/**
+ * Add the option --probes that sets \ref sc_probes_enabled.
+ * Its default is the current value of the variable.
+ */
+void                sc_probes_add_options (sc_options_t * opt);
+
+/**
+ * Reset the calls and times of all registered probe sites to zero.
+ * This function must not be called concurrently to recording.
+ */
+void                sc_probes_reset (void);
+
+/**
+ * Call a function for all probe sites registered so far.
+ */
+void                sc_probes_iterate (void (*fn) (sc_probe_t * probe,
+                                                   void *user),
+                                       void *user);
+
+#ifndef SC_PROBES_DISABLE
+
+/** Begin a region recorded by a probe site local to the call.
+ * The region extends to the matching \ref SC_PROBE_END in the same block.
+ * Unless probes are enabled, the only cost is a test of one variable.
+ * Compiling with SC_PROBES_DISABLE defined removes the probes entirely.
+ * \param [in] pname        A string constant naming the region.
+ */
+#define SC_PROBE_BEGIN(pname)                                           \
+  do {                                                                  \
+    static sc_probe_t   sc_probe_site = { pname, 0, 0, 0, NULL };       \
+    const int           sc_probe_on = sc_probes_enabled;                \
+    const double        sc_probe_start = sc_probe_on ? sc_clock () : 0.;
+
+/** End a region begun by \ref SC_PROBE_BEGIN. */
+#define SC_PROBE_END                                                    \
+    if (SC_UNLIKELY (sc_probe_on)) {                                    \
+      SC_ATOMIC_ADD_RELAXED (&sc_probe_site.calls, 1);                  \
+      SC_ATOMIC_ADD_RELAXED (&sc_probe_site.nanoseconds, (long long)    \
+                             (1.e9 * (sc_clock () - sc_probe_start)));  \
+      if (!SC_ATOMIC_LOAD (&sc_probe_site.registered)) {                \
+        sc_probe_register (&sc_probe_site);                             \
+      }                                                                 \
+    }                                                                   \
+  } while (0)
+
+#else
+
+#define SC_PROBE_BEGIN(pname) do {
+#define SC_PROBE_END } while (0)
+
+#endif /* SC_PROBES_DISABLE */
+
 SC_EXTERN_C_END;
 
 #endif /* !SC_FLOPS_H */
@@ -142,6 +142,113 @@ sc_function1_invert (sc_function1_t func, void *data,
   SC_ABORTF ("sc_function1_invert did not converge after %d iterations", k);
 }
 
+void
+sc_function1_invert_batch (sc_function1_batch_t func, void *data,
+                           double x_low, double x_high, size_t n,
+                           const double *y, double *x, double rtol)
+{
+  const int           k_max = 100;
+  int                 k;
+  size_t              i, j, m, num_active;
+  size_t             *active;
+  double              ends[2], yends[2];
+  double              sign, xi, yt, y_tol;
+  double             *lo, *hi, *ylo, *yhi, *xe, *ye;
+
+  SC_ASSERT (x_low < x_high && rtol > 0.);
+
+  if (func == NULL) {
+    if (n > 0) {
+      memcpy (x, y, n * sizeof (double));
+    }
+    return;
+  }
+
+  ends[0] = x_low;
+  ends[1] = x_high;
+  func (2, ends, yends, data);
+  y_tol = rtol * fabs (yends[1] - yends[0]);
+  sign = (yends[0] <= yends[1]) ? 1. : -1.;
+
+  /* the brackets of all values and the compacted evaluation arrays */
+  lo = SC_ALLOC (double, 6 * n);
+  hi = lo + n;
+  ylo = hi + n;
+  yhi = ylo + n;
+  xe = yhi + n;
+  ye = xe + n;
+  active = SC_ALLOC (size_t, n);
+  for (i = 0; i < n; ++i) {
+    SC_ASSERT ((sign > 0. && yends[0] <= y[i] && y[i] <= yends[1]) ||
+               (sign < 0. && yends[1] <= y[i] && y[i] <= yends[0]));
+    lo[i] = x_low;
+    hi[i] = x_high;
+    ylo[i] = yends[0];
+    yhi[i] = yends[1];
+    active[i] = i;
+  }
+
+  for (num_active = n, k = 0; num_active > 0 && k < k_max; ++k) {
+    /* propose the next iterate and retire those clamped to the bracket */
+    for (m = 0, j = 0; j < num_active; ++j) {
+      i = active[j];
+      xi = lo[i] + (hi[i] - lo[i]) * (y[i] - ylo[i]) / (yhi[i] - ylo[i]);
+      if (xi <= lo[i]) {
+        x[i] = lo[i];
+      }
+      else if (xi >= hi[i]) {
+        x[i] = hi[i];
+      }
+      else {
+        active[m] = i;
+        xe[m++] = xi;
+      }
+    }
+    if ((num_active = m) == 0) {
+      break;
+    }
+
+    /* one call for all remaining values */
+    func (num_active, xe, ye, data);
+    for (m = 0, j = 0; j < num_active; ++j) {
+      i = active[j];
+      yt = sign * (ye[j] - y[i]);
+      if (yt < -y_tol) {
+        lo[i] = xe[j];
+        ylo[i] = ye[j];
+        active[m++] = i;
+      }
+      else if (yt > y_tol) {
+        hi[i] = xe[j];
+        yhi[i] = ye[j];
+        active[m++] = i;
+      }
+      else {
+        x[i] = xe[j];
+      }
+    }
+    num_active = m;
+  }
+  SC_FREE (lo);
+  SC_FREE (active);
+  if (num_active > 0) {
+    SC_ABORTF ("sc_function1_invert_batch did not converge after %d"
+               " iterations", k);
+  }
+}
+
+void
+sc_function3_eval_batch (sc_function3_t func, void *data, size_t n,
+                         const double *x, const double *y, const double *z,
+                         double *values)
+{
+  size_t              i;
+
+  for (i = 0; i < n; ++i) {
+    values[i] = func (x[i], y[i], z[i], data);
+  }
+}
+
 double
 sc_zero3 (double x, double y, double z, void *data)
 {
@@ -219,3 +326,144 @@ sc_tensor3 (double x, double y, double z, void *data)
   return meta->f1 (x, y, z, meta->data) *
     meta->f2 (x, y, z, meta->data) * meta->f3 (x, y, z, meta->data);
 }
+
+static void
+sc_fill3_batch (size_t n, double *_sc_restrict values, double value)
+{
+  size_t              i;
+
+  for (i = 0; i < n; ++i) {
+    values[i] = value;
+  }
+}
+
+void
+sc_zero3_batch (size_t n, const double *x, const double *y,
+                const double *z, double *values, void *data)
+{
+  sc_fill3_batch (n, values, 0.);
+}
+
+void
+sc_one3_batch (size_t n, const double *x, const double *y,
+               const double *z, double *values, void *data)
+{
+  sc_fill3_batch (n, values, 1.);
+}
+
+void
+sc_two3_batch (size_t n, const double *x, const double *y,
+               const double *z, double *values, void *data)
+{
+  sc_fill3_batch (n, values, 2.);
+}
+
+void
+sc_ten3_batch (size_t n, const double *x, const double *y,
+               const double *z, double *values, void *data)
+{
+  sc_fill3_batch (n, values, 10.);
+}
+
+void
+sc_constant3_batch (size_t n, const double *x, const double *y,
+                    const double *z, double *values, void *data)
+{
+  sc_fill3_batch (n, values, *(double *) data);
+}
+
+void
+sc_x3_batch (size_t n, const double *x, const double *y,
+             const double *z, double *values, void *data)
+{
+  if (n > 0) {
+    memcpy (values, x, n * sizeof (double));
+  }
+}
+
+void
+sc_y3_batch (size_t n, const double *x, const double *y,
+             const double *z, double *values, void *data)
+{
+  if (n > 0) {
+    memcpy (values, y, n * sizeof (double));
+  }
+}
+
+void
+sc_z3_batch (size_t n, const double *x, const double *y,
+             const double *z, double *values, void *data)
+{
+  if (n > 0) {
+    memcpy (values, z, n * sizeof (double));
+  }
+}
+
+/** Combine the values of up to three meta functions block by block.
+ * The constituents are evaluated into stack buffers, such that the
+ * combining loops have no indirection and vectorize.
+ * \param [in] op       0 for the sum, 1 for the product of f1 and f2
+ *                      or parameter2, 2 for the product of f1, f2 and f3.
+ */
+static void
+sc_meta3_batch (int op, size_t n, const double *x, const double *y,
+                const double *z, double *values, void *data)
+{
+  sc_function3_batch_meta_t *meta = (sc_function3_batch_meta_t *) data;
+  size_t              i, jb, nb;
+  double              t2[SC_FUNCTION_BATCH_BLOCK];
+  double              t3[SC_FUNCTION_BATCH_BLOCK];
+  double             *_sc_restrict v;
+
+  SC_ASSERT (meta != NULL && meta->f1 != NULL);
+  SC_ASSERT (op != 2 || (meta->f2 != NULL && meta->f3 != NULL));
+
+  for (jb = 0; jb < n; jb += SC_FUNCTION_BATCH_BLOCK) {
+    nb = SC_MIN (n - jb, (size_t) SC_FUNCTION_BATCH_BLOCK);
+    v = values + jb;
+    meta->f1 (nb, x + jb, y + jb, z + jb, v, meta->data);
+    if (meta->f2 != NULL) {
+      meta->f2 (nb, x + jb, y + jb, z + jb, t2, meta->data);
+    }
+    else {
+      sc_fill3_batch (nb, t2, meta->parameter2);
+    }
+    if (op == 0) {
+      for (i = 0; i < nb; ++i) {
+        v[i] += t2[i];
+      }
+    }
+    else if (op == 1) {
+      for (i = 0; i < nb; ++i) {
+        v[i] *= t2[i];
+      }
+    }
+    else {
+      meta->f3 (nb, x + jb, y + jb, z + jb, t3, meta->data);
+      for (i = 0; i < nb; ++i) {
+        v[i] = v[i] * t2[i] * t3[i];
+      }
+    }
+  }
+}
+
+void
+sc_sum3_batch (size_t n, const double *x, const double *y,
+               const double *z, double *values, void *data)
+{
+  sc_meta3_batch (0, n, x, y, z, values, data);
+}
+
+void
+sc_product3_batch (size_t n, const double *x, const double *y,
+                   const double *z, double *values, void *data)
+{
+  sc_meta3_batch (1, n, x, y, z, values, data);
+}
+
+void
+sc_tensor3_batch (size_t n, const double *x, const double *y,
+                  const double *z, double *values, void *data)
+{
+  sc_meta3_batch (2, n, x, y, z, values, data);
+}
@@ -88,11 +88,81 @@ typedef struct sc_function3_meta
 }
 sc_function3_meta_t;
 
+/** Evaluate a 1D function at an array of points.
+ * \param [in] n        Number of points.
+ * \param [in] x        Array of \a n arguments.
+ * \param [out] values  Array of \a n values, not overlapping the input.
+ * \param [in] data     User data of the function.
+ */
+typedef void        (*sc_function1_batch_t) (size_t n, const double *x,
+                                             double *values, void *data);
+
+/** Evaluate a 3D function at an array of points stored as
+ * structure of arrays.  This avoids one indirect call per point and
+ * allows the compiler to vectorize the loop over the points.
+ * \param [in] n        Number of points.
+ * \param [in] x, y, z  Arrays of \a n coordinates each.
+ * \param [out] values  Array of \a n values, not overlapping the input.
+ * \param [in] data     User data of the function.
+ */
+typedef void        (*sc_function3_batch_t) (size_t n, const double *x,
+                                             const double *y,
+                                             const double *z,
+                                             double *values, void *data);
+
+/** Number of points the batched meta functions process at a time.
+ * Their intermediate results are kept on the stack in blocks of this size.
+ */
+#define SC_FUNCTION_BATCH_BLOCK 128
+
+/** The data element of the batched meta functions.
+ * It has the same meaning as \ref sc_function3_meta_t.
+ */
+typedef struct sc_function3_batch_meta
+{
+  sc_function3_batch_t f1;
+  sc_function3_batch_t f2;
+  double              parameter2;
+  sc_function3_batch_t f3;
+  void               *data;
+}
+sc_function3_batch_meta_t;
+
 /* Evaluate the inverse function with regula falsi: x = func^{-1}(y) */
 double              sc_function1_invert (sc_function1_t func, void *data,
                                          double x_low, double x_high,
                                          double y, double rtol);
 
+/** Evaluate the inverse function at many values with regula falsi.
+ * Each value is iterated exactly as by \ref sc_function1_invert.
+ * In every iteration the function is called once for all values
+ * that have not yet converged.
+ * \param [in] func     Batched function, or NULL for the identity.
+ * \param [in] data     User data passed to \a func.
+ * \param [in] x_low    Lower end of the bracket common to all values.
+ * \param [in] x_high   Upper end of the bracket, larger than \a x_low.
+ * \param [in] n        Number of values.
+ * \param [in] y        Array of \a n values between the function values
+ *                      at the ends of the bracket.
+ * \param [out] x       Array of \a n results.
+ * \param [in] rtol     Positive tolerance relative to the range of values.
+ */
+void                sc_function1_invert_batch (sc_function1_batch_t func,
+                                               void *data, double x_low,
+                                               double x_high, size_t n,
+                                               const double *y, double *x,
+                                               double rtol);
+
+/** Evaluate a scalar 3D function at an array of points.
+ * This is a convenience for passing existing functions to batched code.
+ */
+void                sc_function3_eval_batch (sc_function3_t func,
+                                             void *data, size_t n,
+                                             const double *x,
+                                             const double *y,
+                                             const double *z,
+                                             double *values);
+
 /* Some basic 3D functions */
 double              sc_zero3 (double x, double y, double z, void *data);
 double              sc_one3 (double x, double y, double z, void *data);
@@ -112,6 +182,50 @@ double              sc_sum3 (double x, double y, double z, void *data);
 double              sc_product3 (double x, double y, double z, void *data);
 double              sc_tensor3 (double x, double y, double z, void *data);
 
+/* Batched versions of the basic 3D functions */
+void                sc_zero3_batch (size_t n, const double *x,
+                                    const double *y, const double *z,
+                                    double *values, void *data);
+void                sc_one3_batch (size_t n, const double *x,
+                                   const double *y, const double *z,
+                                   double *values, void *data);
+void                sc_two3_batch (size_t n, const double *x,
+                                   const double *y, const double *z,
+                                   double *values, void *data);
+void                sc_ten3_batch (size_t n, const double *x,
+                                   const double *y, const double *z,
+                                   double *values, void *data);
+
+/**
+ * \param data   needs to be *double with the value of the constant.
+ */
+void                sc_constant3_batch (size_t n, const double *x,
+                                        const double *y, const double *z,
+                                        double *values, void *data);
+
+void                sc_x3_batch (size_t n, const double *x,
+                                 const double *y, const double *z,
+                                 double *values, void *data);
+void                sc_y3_batch (size_t n, const double *x,
+                                 const double *y, const double *z,
+                                 double *values, void *data);
+void                sc_z3_batch (size_t n, const double *x,
+                                 const double *y, const double *z,
+                                 double *values, void *data);
+
+/* Batched meta functions.
+ * \param data   needs to be *sc_function3_batch_meta_t.
+ */
+void                sc_sum3_batch (size_t n, const double *x,
+                                   const double *y, const double *z,
+                                   double *values, void *data);
+void                sc_product3_batch (size_t n, const double *x,
+                                       const double *y, const double *z,
+                                       double *values, void *data);
+void                sc_tensor3_batch (size_t n, const double *x,
+                                      const double *y, const double *z,
+                                      double *values, void *data);
+
 SC_EXTERN_C_END;
 
 #endif /* !SC_FUNCTIONS_H */
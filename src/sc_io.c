@@ -23,7 +23,8 @@
 
 #include <sc_io.h>
 #include <sc_puff.h>
-#include <libb64.h>
+#include <sc_search.h>
+#include <sc_thread.h>
 #ifdef SC_HAVE_ZLIB
 #include <zlib.h>
 #else
@@ -36,6 +37,362 @@
 #ifndef SC_ENABLE_MPIIO
 #include <errno.h>
 #endif
+#if defined SC_HAVE_SYS_STAT_H && defined SC_HAVE_FCNTL_H && \
+    defined SC_HAVE_UNISTD_H
+#define SC_IO_HAVE_POSIX
+#include <errno.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#ifdef SC_HAVE_SYS_MMAN_H
+#define SC_IO_HAVE_MMAP
+#include <sys/mman.h>
+#endif
+#ifdef SC_HAVE_SYS_UIO_H
+#define SC_IO_HAVE_WRITEV
+#include <sys/uio.h>
+#ifdef IOV_MAX
+#define SC_IO_IOV_MAX ((size_t) IOV_MAX)
+#else
+#define SC_IO_IOV_MAX ((size_t) 16)
+#endif
+#endif
+#endif
+#ifdef SC_ENABLE_PTHREAD
+#include <pthread.h>
+#endif
+#if defined (__AVX2__)
+#include <immintrin.h>
+#define SC_IO_ADLER32_AVX2
+#define SC_IO_ADLER32_KERNEL "adler32 avx2"
+#else
+#define SC_IO_ADLER32_KERNEL "adler32 scalar"
+#endif
+#if defined (__SSE4_2__) && defined (__x86_64__)
+#include <nmmintrin.h>
+#define SC_IO_CRC32C_SSE42
+#define SC_IO_CRC32C_KERNEL "crc32c sse4.2"
+#elif defined (__ARM_FEATURE_CRC32) && defined (__aarch64__)
+#include <arm_acle.h>
+#define SC_IO_CRC32C_ARM
+#define SC_IO_CRC32C_KERNEL "crc32c armv8"
+#else
+#define SC_IO_CRC32C_KERNEL "crc32c table"
+#endif
+#if defined (__AVX2__)
+#define SC_IO_BASE64_AVX2
+#define SC_IO_BASE64_KERNEL "base64 avx2"
+#elif defined (__SSSE3__)
+#include <tmmintrin.h>
+#define SC_IO_BASE64_SSSE3
+#define SC_IO_BASE64_KERNEL "base64 ssse3"
+#elif defined (__ARM_NEON) && defined (__aarch64__)
+#include <arm_neon.h>
+#define SC_IO_BASE64_NEON
+#define SC_IO_BASE64_KERNEL "base64 neon"
+#else
+#define SC_IO_BASE64_KERNEL "base64 scalar"
+#endif
+#if defined (__SSSE3__)
+#include <tmmintrin.h>
+#define SC_IO_INTS_SSSE3
+#define SC_IO_INTS_KERNEL "ints ssse3"
+#else
+#define SC_IO_INTS_KERNEL "ints scalar"
+#endif
+#if defined (__SSE2__)
+#include <emmintrin.h>
+#define SC_IO_SHUFFLE_SSE2
+#define SC_IO_SHUFFLE_KERNEL "shuffle sse2"
+#else
+#define SC_IO_SHUFFLE_KERNEL "shuffle scalar"
+#endif
+
+#ifdef SC_IO_HAVE_POSIX
+
+/** State of a sink of type STAGED.  While one staging buffer is filled,
+ * the other may be written to the file by a background thread. */
+typedef struct sc_io_staged
+{
+  int                 fd;
+  int                 direct;   /**< O_DIRECT is in effect. */
+  size_t              page_size;
+  size_t              stage_size;       /**< Multiple of the page size. */
+  char               *alloc;    /**< Unaligned allocation of the buffers. */
+  char               *buffers[2];
+  int                 current;  /**< Index of the buffer being filled. */
+  size_t              fill;     /**< Bytes in the current buffer. */
+  int                 error;    /**< Any write has failed. */
+#ifdef SC_ENABLE_PTHREAD
+  int                 pending;  /**< The writer thread is running. */
+  pthread_t           writer;
+  const char         *pending_data;
+  size_t              pending_bytes;
+  int                 pending_error;
+#endif
+}
+sc_io_staged_t;
+
+/** Write all bytes to the file descriptor.
+ * If a direct write is refused, continue without O_DIRECT.
+ * \return          0 on success, -1 on error.
+ */
+static int
+sc_io_staged_write (sc_io_staged_t * st, const char *data, size_t bytes)
+{
+  int                 flags;
+  ssize_t             written;
+
+  while (bytes > 0) {
+    written = write (st->fd, data, bytes);
+    if (written < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+#ifdef O_DIRECT
+      if (errno == EINVAL && st->direct &&
+          (flags = fcntl (st->fd, F_GETFL)) != -1 &&
+          fcntl (st->fd, F_SETFL, flags & ~O_DIRECT) != -1) {
+        st->direct = 0;
+        continue;
+      }
+#endif
+      return -1;
+    }
+    data += written;
+    bytes -= (size_t) written;
+  }
+  return 0;
+}
+
+#ifdef SC_ENABLE_PTHREAD
+
+static void        *
+sc_io_staged_writer (void *arg)
+{
+  sc_io_staged_t     *st = (sc_io_staged_t *) arg;
+
+  st->pending_error =
+    sc_io_staged_write (st, st->pending_data, st->pending_bytes);
+  return NULL;
+}
+
+#endif
+
+/** Wait for the background write to finish. */
+static void
+sc_io_staged_wait (sc_io_staged_t * st)
+{
+#ifdef SC_ENABLE_PTHREAD
+  int                 pth;
+
+  if (st->pending) {
+    pth = pthread_join (st->writer, NULL);
+    SC_CHECK_ABORTF (pth == 0, "pthread_join %d failed", pth);
+    st->pending = 0;
+    st->error = st->error || st->pending_error;
+  }
+#endif
+}
+
+/** Write the current buffer and continue filling the other one.
+ * A full buffer is written in the background if threads are available.
+ * \param [in] full     If false, the buffer is written synchronously.
+ *                      With O_DIRECT such a partial write ends it.
+ */
+static void
+sc_io_staged_flush (sc_io_staged_t * st, int full)
+{
+  int                 flags;
+  const char         *data = st->buffers[st->current];
+  const size_t        bytes = st->fill;
+
+  sc_io_staged_wait (st);
+  if (bytes == 0) {
+    return;
+  }
+  st->current = !st->current;
+  st->fill = 0;
+
+  if (!full) {
+#ifdef O_DIRECT
+    /* the file offset will no longer be aligned */
+    if (st->direct && bytes % st->page_size != 0) {
+      flags = fcntl (st->fd, F_GETFL);
+      if (flags == -1 || fcntl (st->fd, F_SETFL, flags & ~O_DIRECT) == -1) {
+        st->error = 1;
+        return;
+      }
+      st->direct = 0;
+    }
+#else
+    (void) flags;
+#endif
+    st->error = st->error || sc_io_staged_write (st, data, bytes);
+    return;
+  }
+
+#ifdef SC_ENABLE_PTHREAD
+  st->pending_data = data;
+  st->pending_bytes = bytes;
+  st->pending_error = 0;
+  if (pthread_create (&st->writer, NULL, sc_io_staged_writer, st) == 0) {
+    st->pending = 1;
+    return;
+  }
+#endif
+  st->error = st->error || sc_io_staged_write (st, data, bytes);
+}
+
+/** Open the file and allocate the staging buffers.
+ * \return          The new state or NULL if the file cannot be opened.
+ */
+static sc_io_staged_t *
+sc_io_staged_new (const char *filename, int iomode,
+                  size_t stage_size, int flags)
+{
+  int                 oflags;
+  long                page;
+  off_t               offset;
+  sc_io_staged_t     *st;
+
+  st = SC_ALLOC_ZERO (sc_io_staged_t, 1);
+  page = sysconf (_SC_PAGESIZE);
+  st->page_size = page > 0 ? (size_t) page : 4096;
+  if (stage_size == 0) {
+    stage_size = SC_IO_STAGED_SIZE;
+  }
+  st->stage_size = (stage_size + st->page_size - 1) /
+    st->page_size * st->page_size;
+
+  /* prefer O_DIRECT if requested, but do without it if refused */
+  oflags = O_WRONLY | O_CREAT |
+    (iomode == SC_IO_MODE_WRITE ? O_TRUNC : O_APPEND);
+  st->fd = -1;
+#ifdef O_DIRECT
+  if (flags & SC_IO_STAGED_DIRECT) {
+    st->fd = open (filename, oflags | O_DIRECT, 0666);
+    st->direct = st->fd >= 0;
+  }
+#endif
+  if (st->fd < 0) {
+    st->fd = open (filename, oflags, 0666);
+    if (st->fd < 0) {
+      SC_FREE (st);
+      return NULL;
+    }
+  }
+  if (st->direct && iomode == SC_IO_MODE_APPEND) {
+    /* direct writes need an aligned file offset */
+    offset = lseek (st->fd, 0, SEEK_END);
+    if (offset < 0 || (size_t) offset % st->page_size != 0) {
+      (void) close (st->fd);
+      st->fd = open (filename, oflags, 0666);
+      st->direct = 0;
+      if (st->fd < 0) {
+        SC_FREE (st);
+        return NULL;
+      }
+    }
+  }
+
+  /* one extra page allows to align the buffers */
+  st->alloc = SC_ALLOC (char, 2 * st->stage_size + st->page_size);
+  st->buffers[0] = st->alloc + (st->page_size -
+                                (size_t) st->alloc % st->page_size) %
+    st->page_size;
+  st->buffers[1] = st->buffers[0] + st->stage_size;
+  return st;
+}
+
+/** Write all staged data and close the file.
+ * \return          0 on success, nonzero on any error.
+ */
+static int
+sc_io_staged_destroy (sc_io_staged_t * st)
+{
+  int                 retval;
+
+  sc_io_staged_flush (st, 0);
+  sc_io_staged_wait (st);
+  retval = close (st->fd) || st->error;
+  SC_FREE (st->alloc);
+  SC_FREE (st);
+  return retval;
+}
+
+#endif /* SC_IO_HAVE_POSIX */
+
+#ifdef SC_HAVE_ZLIB
+
+/** Size of the compressed data buffer of the encodings. */
+#define SC_IO_CODEC_BUFFER (1 << 16)
+
+/** State of a zlib stream through a sink or a source. */
+typedef struct sc_io_codec
+{
+  z_stream            zs;
+  int                 active;   /**< Sink: data written since finish. */
+  int                 ended;    /**< Source: at the end of one stream. */
+  int                 eof;      /**< Source: no more compressed data. */
+  char                buf[SC_IO_CODEC_BUFFER];
+}
+sc_io_codec_t;
+
+static sc_io_codec_t *
+sc_io_codec_new (int ioencode, int deflating)
+{
+  int                 zrv;
+  sc_io_codec_t      *codec;
+
+  SC_ASSERT (ioencode == SC_IO_ENCODE_ZLIB ||
+             ioencode == SC_IO_ENCODE_ZLIB_FAST);
+
+  codec = SC_ALLOC_ZERO (sc_io_codec_t, 1);
+  codec->ended = 1;
+  if (deflating) {
+    zrv = deflateInit (&codec->zs, ioencode == SC_IO_ENCODE_ZLIB_FAST ?
+                       Z_BEST_SPEED : Z_DEFAULT_COMPRESSION);
+  }
+  else {
+    zrv = inflateInit (&codec->zs);
+  }
+  SC_CHECK_ABORT (zrv == Z_OK, "Error on zlib initialization");
+  return codec;
+}
+
+#endif /* SC_HAVE_ZLIB */
+
+sc_io_sink_t       *
+sc_io_sink_new_staged (const char *filename, int iomode,
+                       size_t stage_size, int flags)
+{
+  sc_io_sink_t       *sink;
+
+  SC_ASSERT (filename != NULL);
+  SC_ASSERT (0 <= iomode && iomode < SC_IO_MODE_LAST);
+
+#ifdef SC_IO_HAVE_POSIX
+  sink = SC_ALLOC_ZERO (sc_io_sink_t, 1);
+  sink->iotype = SC_IO_TYPE_STAGED;
+  sink->mode = (sc_io_mode_t) iomode;
+  sink->encode = SC_IO_ENCODE_NONE;
+  sink->staged = sc_io_staged_new (filename, iomode, stage_size, flags);
+  if (sink->staged == NULL) {
+    SC_FREE (sink);
+    return NULL;
+  }
+#else
+  /* without POSIX files we use a large stdio buffer */
+  sink = sc_io_sink_new (SC_IO_TYPE_FILENAME, iomode, SC_IO_ENCODE_NONE,
+                         filename);
+  if (sink != NULL) {
+    (void) setvbuf (sink->file, NULL, _IOFBF, stage_size > 0 ?
+                    stage_size : SC_IO_STAGED_SIZE);
+  }
+#endif
+  return sink;
+}
 
 sc_io_sink_t       *
 sc_io_sink_new (int iotype, int iomode, int ioencode, ...)
@@ -46,6 +403,11 @@ sc_io_sink_new (int iotype, int iomode, int ioencode, ...)
   SC_ASSERT (0 <= iotype && iotype < SC_IO_TYPE_LAST);
   SC_ASSERT (0 <= iomode && iomode < SC_IO_MODE_LAST);
   SC_ASSERT (0 <= ioencode && ioencode < SC_IO_ENCODE_LAST);
+#ifndef SC_HAVE_ZLIB
+  if (ioencode != SC_IO_ENCODE_NONE) {
+    return NULL;
+  }
+#endif
 
   sink = SC_ALLOC_ZERO (sc_io_sink_t, 1);
   sink->iotype = (sc_io_type_t) iotype;
@@ -76,11 +438,33 @@ sc_io_sink_new (int iotype, int iomode, int ioencode, ...)
       return NULL;
     }
   }
+  else if (iotype == SC_IO_TYPE_STAGED) {
+    const char         *filename = va_arg (ap, const char *);
+
+    SC_FREE (sink);
+    sink = sc_io_sink_new_staged (filename, iomode, 0, 0);
+    if (sink == NULL) {
+      va_end (ap);
+      return NULL;
+    }
+    sink->encode = (sc_io_encode_t) ioencode;
+  }
+  else if (iotype == SC_IO_TYPE_MMAP) {
+    /* a mapping is only provided for reading */
+    va_end (ap);
+    SC_FREE (sink);
+    return NULL;
+  }
   else {
     SC_ABORT_NOT_REACHED ();
   }
   va_end (ap);
 
+#ifdef SC_HAVE_ZLIB
+  if (ioencode != SC_IO_ENCODE_NONE) {
+    sink->codec = sc_io_codec_new (ioencode, 1);
+  }
+#endif
   return sink;
 }
 
@@ -97,13 +481,29 @@ sc_io_sink_destroy (sc_io_sink_t * sink)
     /* Attempt close even on complete error */
     retval = fclose (sink->file) || retval;
   }
+#ifdef SC_IO_HAVE_POSIX
+  else if (sink->iotype == SC_IO_TYPE_STAGED) {
+    retval = sc_io_staged_destroy ((sc_io_staged_t *) sink->staged) ||
+      retval;
+  }
+#endif
+#ifdef SC_HAVE_ZLIB
+  if (sink->codec != NULL) {
+    (void) deflateEnd (&((sc_io_codec_t *) sink->codec)->zs);
+    SC_FREE (sink->codec);
+  }
+#endif
   SC_FREE (sink);
 
   return retval ? SC_IO_ERROR_FATAL : SC_IO_ERROR_NONE;
 }
 
-int
-sc_io_sink_write (sc_io_sink_t * sink, const void *data, size_t bytes_avail)
+/** Write data to the underlying buffer or file of a sink.
+ * \return          0 on success, nonzero on error.
+ */
+static int
+sc_io_sink_write_raw (sc_io_sink_t * sink, const void *data,
+                      size_t bytes_avail, size_t *pbytes_out)
 {
   size_t              bytes_out;
 
@@ -134,6 +534,93 @@ sc_io_sink_write (sc_io_sink_t * sink, const void *data, size_t bytes_avail)
       return SC_IO_ERROR_FATAL;
     }
   }
+#ifdef SC_IO_HAVE_POSIX
+  else if (sink->iotype == SC_IO_TYPE_STAGED) {
+    sc_io_staged_t     *st = (sc_io_staged_t *) sink->staged;
+    const char         *src = (const char *) data;
+    size_t              len;
+
+    SC_ASSERT (st != NULL);
+    for (bytes_out = 0; bytes_out < bytes_avail; bytes_out += len) {
+      if (st->fill == st->stage_size) {
+        sc_io_staged_flush (st, 1);
+      }
+      len = SC_MIN (bytes_avail - bytes_out, st->stage_size - st->fill);
+      memcpy (st->buffers[st->current] + st->fill, src + bytes_out, len);
+      st->fill += len;
+    }
+    if (st->error) {
+      return SC_IO_ERROR_FATAL;
+    }
+  }
+#endif
+
+  *pbytes_out = bytes_out;
+  return SC_IO_ERROR_NONE;
+}
+
+#ifdef SC_HAVE_ZLIB
+
+/** Compress data and write the output to the underlying sink.
+ * \return          0 on success, nonzero on error.
+ */
+static int
+sc_io_sink_deflate (sc_io_sink_t * sink, const void *data,
+                    size_t bytes_avail, int flush)
+{
+  int                 zrv;
+  size_t              chunk, have, bytes_out;
+  const char         *src = (const char *) data;
+  sc_io_codec_t      *codec = (sc_io_codec_t *) sink->codec;
+
+  codec->active = 1;
+  do {
+    chunk = SC_MIN (bytes_avail, (size_t) 1 << 30);
+    codec->zs.next_in = (Bytef *) src;
+    codec->zs.avail_in = (uInt) chunk;
+    src += chunk;
+    bytes_avail -= chunk;
+    do {
+      codec->zs.next_out = (Bytef *) codec->buf;
+      codec->zs.avail_out = SC_IO_CODEC_BUFFER;
+      zrv = deflate (&codec->zs, bytes_avail > 0 ? Z_NO_FLUSH : flush);
+      SC_CHECK_ABORT (zrv != Z_STREAM_ERROR, "Error on zlib compression");
+      have = SC_IO_CODEC_BUFFER - codec->zs.avail_out;
+      if (have > 0) {
+        if (sc_io_sink_write_raw (sink, codec->buf, have, &bytes_out)) {
+          return SC_IO_ERROR_FATAL;
+        }
+        sink->bytes_out += bytes_out;
+      }
+    }
+    while (codec->zs.avail_out == 0);
+    sink->bytes_in += chunk;
+  }
+  while (bytes_avail > 0);
+
+  if (flush == Z_FINISH) {
+    /* further writes begin a new stream */
+    (void) deflateReset (&codec->zs);
+    codec->active = 0;
+  }
+  return SC_IO_ERROR_NONE;
+}
+
+#endif /* SC_HAVE_ZLIB */
+
+int
+sc_io_sink_write (sc_io_sink_t * sink, const void *data, size_t bytes_avail)
+{
+  size_t              bytes_out;
+
+#ifdef SC_HAVE_ZLIB
+  if (sink->codec != NULL) {
+    return sc_io_sink_deflate (sink, data, bytes_avail, Z_NO_FLUSH);
+  }
+#endif
+  if (sc_io_sink_write_raw (sink, data, bytes_avail, &bytes_out)) {
+    return SC_IO_ERROR_FATAL;
+  }
 
   sink->bytes_in += bytes_avail;
   sink->bytes_out += bytes_out;
@@ -141,12 +628,162 @@ sc_io_sink_write (sc_io_sink_t * sink, const void *data, size_t bytes_avail)
   return SC_IO_ERROR_NONE;
 }
 
+#ifdef SC_IO_HAVE_WRITEV
+
+/** Write pieces of data to a file descriptor by as few calls as possible.
+ * Empty pieces are allowed.
+ * \return          0 on success, -1 on error.
+ */
+static int
+sc_io_writev_fd (int fd, const sc_io_vec_t * vec, size_t count)
+{
+  int                 retval = 0;
+  size_t              zz, first, num;
+  ssize_t             written;
+  struct iovec       *iov;
+
+  iov = SC_ALLOC (struct iovec, count);
+  for (zz = num = 0; zz < count; ++zz) {
+    if (vec[zz].bytes > 0) {
+      iov[num].iov_base = (void *) vec[zz].data;
+      iov[num].iov_len = vec[zz].bytes;
+      ++num;
+    }
+  }
+  first = 0;
+  while (first < num) {
+    written = writev (fd, iov + first, (int) SC_MIN (num - first,
+                                                      SC_IO_IOV_MAX));
+    if (written < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      retval = -1;
+      break;
+    }
+
+    /* continue after the last byte written */
+    while (first < num && (size_t) written >= iov[first].iov_len) {
+      written -= (ssize_t) iov[first].iov_len;
+      ++first;
+    }
+    if (first < num) {
+      iov[first].iov_base = (char *) iov[first].iov_base + written;
+      iov[first].iov_len -= (size_t) written;
+    }
+  }
+  SC_FREE (iov);
+  return retval;
+}
+
+#endif
+
+int
+sc_io_sink_writev (sc_io_sink_t * sink, const sc_io_vec_t * vec,
+                   size_t count, size_t bytes_align)
+{
+  int                 retval;
+  size_t              zz, total, fill_bytes, bytes_out;
+  char               *fill;
+
+  total = 0;
+  for (zz = 0; zz < count; ++zz) {
+    total += vec[zz].bytes;
+  }
+
+#ifdef SC_HAVE_ZLIB
+  if (sink->codec != NULL) {
+    for (zz = 0; zz < count; ++zz) {
+      if (sc_io_sink_deflate (sink, vec[zz].data, vec[zz].bytes,
+                              Z_NO_FLUSH)) {
+        return SC_IO_ERROR_FATAL;
+      }
+    }
+    return bytes_align > 1 ? sc_io_sink_align (sink, bytes_align) : 0;
+  }
+#endif
+
+  fill_bytes = bytes_align > 1 ? (bytes_align - (sink->bytes_out + total) %
+                                  bytes_align) % bytes_align : 0;
+  fill = fill_bytes > 0 ? SC_ALLOC_ZERO (char, fill_bytes) : NULL;
+  retval = 0;
+
+  if (sink->iotype == SC_IO_TYPE_BUFFER) {
+    size_t              elem_size, new_count;
+    char               *dest;
+
+    /* resize once for all pieces */
+    SC_ASSERT (sink->buffer != NULL);
+    elem_size = sink->buffer->elem_size;
+    new_count = (sink->buffer_bytes + total + fill_bytes + elem_size - 1) /
+      elem_size;
+    sc_array_resize (sink->buffer, new_count);
+    if (new_count * elem_size > SC_ARRAY_BYTE_ALLOC (sink->buffer)) {
+      SC_FREE (fill);
+      return SC_IO_ERROR_FATAL;
+    }
+
+    dest = sink->buffer->array + sink->buffer_bytes;
+    for (zz = 0; zz < count; ++zz) {
+      /* an empty entry may have a NULL pointer */
+      if (vec[zz].bytes > 0) {
+        memcpy (dest, vec[zz].data, vec[zz].bytes);
+        dest += vec[zz].bytes;
+      }
+    }
+    memset (dest, 0, fill_bytes);
+    sink->buffer_bytes += total + fill_bytes;
+  }
+#ifdef SC_IO_HAVE_WRITEV
+  else if ((sink->iotype == SC_IO_TYPE_FILENAME ||
+            sink->iotype == SC_IO_TYPE_FILEFILE) &&
+           total + fill_bytes >= BUFSIZ) {
+    sc_io_vec_t        *pieces;
+
+    /* small writes are better served by the stream buffer */
+    SC_ASSERT (sink->file != NULL);
+    pieces = SC_ALLOC (sc_io_vec_t, count + 1);
+    for (zz = 0; zz < count; ++zz) {
+      pieces[zz] = vec[zz];
+    }
+    pieces[count].data = fill;
+    pieces[count].bytes = fill_bytes;
+    retval = fflush (sink->file) ||
+      sc_io_writev_fd (fileno (sink->file), pieces, count + 1);
+    SC_FREE (pieces);
+  }
+#endif
+  else {
+    for (zz = 0; zz < count && !retval; ++zz) {
+      retval = sc_io_sink_write_raw (sink, vec[zz].data, vec[zz].bytes,
+                                     &bytes_out);
+    }
+    retval = retval ||
+      sc_io_sink_write_raw (sink, fill, fill_bytes, &bytes_out);
+  }
+  SC_FREE (fill);
+  if (retval) {
+    return SC_IO_ERROR_FATAL;
+  }
+
+  sink->bytes_in += total + fill_bytes;
+  sink->bytes_out += total + fill_bytes;
+
+  return SC_IO_ERROR_NONE;
+}
+
 int
 sc_io_sink_complete (sc_io_sink_t * sink, size_t *bytes_in, size_t *bytes_out)
 {
   int                 retval;
 
   retval = 0;
+#ifdef SC_HAVE_ZLIB
+  if (sink->codec != NULL && ((sc_io_codec_t *) sink->codec)->active &&
+      sc_io_sink_deflate (sink, NULL, 0, Z_FINISH)) {
+    return SC_IO_ERROR_FATAL;
+  }
+#endif
   if (sink->iotype == SC_IO_TYPE_BUFFER) {
     SC_ASSERT (sink->buffer != NULL);
     if (sink->buffer_bytes % sink->buffer->elem_size != 0) {
@@ -158,6 +795,15 @@ sc_io_sink_complete (sc_io_sink_t * sink, size_t *bytes_in, size_t *bytes_out)
     SC_ASSERT (sink->file != NULL);
     retval = fflush (sink->file);
   }
+#ifdef SC_IO_HAVE_POSIX
+  else if (sink->iotype == SC_IO_TYPE_STAGED) {
+    sc_io_staged_t     *st = (sc_io_staged_t *) sink->staged;
+
+    sc_io_staged_flush (st, 0);
+    sc_io_staged_wait (st);
+    retval = st->error;
+  }
+#endif
   if (retval) {
     return SC_IO_ERROR_FATAL;
   }
@@ -188,14 +834,257 @@ sc_io_sink_align (sc_io_sink_t * sink, size_t bytes_align)
   return retval;
 }
 
-sc_io_source_t     *
-sc_io_source_new (int iotype, int ioencode, ...)
+/** State of the read-ahead of a file source.  The file is read in chunks
+ * of the buffer size.  While one buffer is consumed, the next chunk may be
+ * read into the other one by a background thread. */
+typedef struct sc_io_readahead
 {
-  sc_io_source_t     *source;
-  va_list             ap;
+  FILE               *file;
+  size_t              size;     /**< Bytes per buffer. */
+  char               *alloc;    /**< Allocation of both buffers. */
+  char               *buffers[2];
+  int                 current;  /**< Index of the buffer being consumed. */
+  size_t              pos;      /**< Bytes consumed of the current one. */
+  size_t              fill;     /**< Bytes in the current buffer. */
+  size_t              ahead;    /**< Bytes read into the other buffer. */
+  int                 eof;      /**< The file has been read to its end. */
+  int                 error;    /**< Any read has failed. */
+#ifdef SC_ENABLE_PTHREAD
+  int                 prefetch; /**< Read ahead in the background. */
+  int                 pending;  /**< The reader thread is running. */
+  pthread_t           reader;
+#endif
+}
+sc_io_readahead_t;
 
-  SC_ASSERT (0 <= iotype && iotype < SC_IO_TYPE_LAST);
-  SC_ASSERT (0 <= ioencode && ioencode < SC_IO_ENCODE_LAST);
+/** A range of the file recorded by a zero-copy mirror. */
+typedef struct sc_io_extent
+{
+  long                offset;
+  size_t              bytes;
+}
+sc_io_extent_t;
+
+/** Read up to the buffer size from the file.
+ * \return          The number of bytes read.
+ */
+static size_t
+sc_io_readahead_fill (sc_io_readahead_t * ra, char *buf)
+{
+  size_t              got;
+
+  got = fread (buf, 1, ra->size, ra->file);
+  if (got < ra->size) {
+    ra->eof = 1;
+    ra->error = ra->error || !feof (ra->file) || ferror (ra->file);
+  }
+  return got;
+}
+
+#ifdef SC_ENABLE_PTHREAD
+
+static void        *
+sc_io_readahead_reader (void *arg)
+{
+  sc_io_readahead_t  *ra = (sc_io_readahead_t *) arg;
+
+  ra->ahead = sc_io_readahead_fill (ra, ra->buffers[!ra->current]);
+  return NULL;
+}
+
+#endif
+
+/** Wait for the background read to finish. */
+static void
+sc_io_readahead_wait (sc_io_readahead_t * ra)
+{
+#ifdef SC_ENABLE_PTHREAD
+  int                 pth;
+
+  if (ra->pending) {
+    pth = pthread_join (ra->reader, NULL);
+    SC_CHECK_ABORTF (pth == 0, "pthread_join %d failed", pth);
+    ra->pending = 0;
+  }
+#endif
+}
+
+/** Start reading the next chunk in the background if configured. */
+static void
+sc_io_readahead_start (sc_io_readahead_t * ra)
+{
+#ifdef SC_ENABLE_PTHREAD
+  if (ra->prefetch && !ra->pending && ra->ahead == 0 &&
+      !ra->eof && !ra->error) {
+    ra->pending =
+      pthread_create (&ra->reader, NULL, sc_io_readahead_reader, ra) == 0;
+  }
+#endif
+}
+
+/** Make the next chunk current after the current one is consumed. */
+static void
+sc_io_readahead_next (sc_io_readahead_t * ra)
+{
+  SC_ASSERT (ra->pos == ra->fill);
+
+  sc_io_readahead_wait (ra);
+  if (ra->ahead > 0) {
+    ra->current = !ra->current;
+    ra->fill = ra->ahead;
+    ra->ahead = 0;
+  }
+  else {
+    ra->fill = ra->eof ? 0 : sc_io_readahead_fill (ra,
+                                                   ra->buffers[ra->current]);
+  }
+  ra->pos = 0;
+  sc_io_readahead_start (ra);
+}
+
+/** Read or skip data through the buffers.
+ * Requests of at least the buffer size bypass the buffers if possible.
+ * \return          0 on success, nonzero on error.
+ */
+static int
+sc_io_readahead_read (sc_io_readahead_t * ra, char *data,
+                      size_t bytes_avail, size_t *pbytes_out)
+{
+  size_t              done, got, n;
+
+  done = 0;
+  while (done < bytes_avail && !ra->error) {
+    if (ra->pos == ra->fill) {
+      sc_io_readahead_wait (ra);
+      n = bytes_avail - done;
+      if (ra->ahead == 0 && !ra->eof && n >= ra->size) {
+        if (data != NULL) {
+          got = fread (data + done, 1, n, ra->file);
+          if (got < n) {
+            ra->eof = 1;
+            ra->error = !feof (ra->file) || ferror (ra->file);
+          }
+          done += got;
+        }
+        else {
+          ra->error = fseek (ra->file, (long) n, SEEK_CUR) != 0;
+          done += ra->error ? 0 : n;
+        }
+        continue;
+      }
+      sc_io_readahead_next (ra);
+      if (ra->fill == 0) {
+        break;
+      }
+    }
+    n = SC_MIN (ra->fill - ra->pos, bytes_avail - done);
+    if (data != NULL) {
+      memcpy (data + done, ra->buffers[ra->current] + ra->pos, n);
+    }
+    ra->pos += n;
+    done += n;
+  }
+
+  *pbytes_out = done;
+  return ra->error;
+}
+
+/** Return the number of bytes read from the file but not consumed.
+ * This waits for a background read to finish.
+ */
+static size_t
+sc_io_readahead_unconsumed (sc_io_readahead_t * ra)
+{
+  sc_io_readahead_wait (ra);
+  return ra->fill - ra->pos + ra->ahead;
+}
+
+/** Return the file offset of the next byte to read by the source.
+ * \return          The offset or -1 if the file is not seekable.
+ */
+static long
+sc_io_source_tell (sc_io_source_t * source)
+{
+  long                offset;
+
+  offset = ftell (source->file);
+  if (offset >= 0 && source->readahead != NULL) {
+    offset -= (long) sc_io_readahead_unconsumed
+      ((sc_io_readahead_t *) source->readahead);
+  }
+  return offset;
+}
+
+/** Free the read-ahead state of a source.
+ * For type FILEFILE the file position is moved back to the last byte read.
+ * \return          0 on success, nonzero on error.
+ */
+static int
+sc_io_source_readahead_destroy (sc_io_source_t * source)
+{
+  int                 retval = 0;
+  size_t              unconsumed;
+  sc_io_readahead_t  *ra = (sc_io_readahead_t *) source->readahead;
+
+  unconsumed = sc_io_readahead_unconsumed (ra);
+  if (source->iotype == SC_IO_TYPE_FILEFILE && unconsumed > 0) {
+    retval = fseek (ra->file, -(long) unconsumed, SEEK_CUR);
+  }
+  retval = retval || ra->error;
+  SC_FREE (ra->alloc);
+  SC_FREE (ra);
+  source->readahead = NULL;
+  return retval;
+}
+
+/** Map a file of the given name read-only into memory.
+ * \return          0 on success, nonzero on error or without mmap(2).
+ */
+static int
+sc_io_source_map (sc_io_source_t * source, const char *filename)
+{
+#ifdef SC_IO_HAVE_MMAP
+  int                 fd;
+  void               *map;
+  struct stat         st;
+
+  fd = open (filename, O_RDONLY);
+  if (fd < 0) {
+    return -1;
+  }
+  if (fstat (fd, &st) || st.st_size < 0) {
+    (void) close (fd);
+    return -1;
+  }
+  source->map_size = (size_t) st.st_size;
+  if (source->map_size > 0) {
+    /* the mapping stays valid after closing the file */
+    map = mmap (NULL, source->map_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (map == MAP_FAILED) {
+      (void) close (fd);
+      return -1;
+    }
+    source->map = (char *) map;
+  }
+  return close (fd);
+#else
+  return -1;
+#endif
+}
+
+sc_io_source_t     *
+sc_io_source_new (int iotype, int ioencode, ...)
+{
+  sc_io_source_t     *source;
+  va_list             ap;
+
+  SC_ASSERT (0 <= iotype && iotype < SC_IO_TYPE_LAST);
+  SC_ASSERT (0 <= ioencode && ioencode < SC_IO_ENCODE_LAST);
+#ifndef SC_HAVE_ZLIB
+  if (ioencode != SC_IO_ENCODE_NONE) {
+    return NULL;
+  }
+#endif
 
   source = SC_ALLOC_ZERO (sc_io_source_t, 1);
   source->iotype = (sc_io_type_t) iotype;
@@ -221,11 +1110,31 @@ sc_io_source_new (int iotype, int ioencode, ...)
       return NULL;
     }
   }
+  else if (iotype == SC_IO_TYPE_STAGED) {
+    /* staging is only provided for writing */
+    va_end (ap);
+    SC_FREE (source);
+    return NULL;
+  }
+  else if (iotype == SC_IO_TYPE_MMAP) {
+    const char         *filename = va_arg (ap, const char *);
+
+    if (sc_io_source_map (source, filename)) {
+      va_end (ap);
+      SC_FREE (source);
+      return NULL;
+    }
+  }
   else {
     SC_ABORT_NOT_REACHED ();
   }
   va_end (ap);
 
+#ifdef SC_HAVE_ZLIB
+  if (ioencode != SC_IO_ENCODE_NONE) {
+    source->codec = sc_io_codec_new (ioencode, 0);
+  }
+#endif
   return source;
 }
 
@@ -242,6 +1151,12 @@ sc_io_source_destroy (sc_io_source_t * source)
     retval = sc_io_sink_destroy (source->mirror) || retval;
     sc_array_destroy (source->mirror_buffer);
   }
+  if (source->mirror_extents != NULL) {
+    sc_array_destroy (source->mirror_extents);
+  }
+  if (source->readahead != NULL) {
+    retval = sc_io_source_readahead_destroy (source) || retval;
+  }
 
   /* The error value SC_IO_ERROR_AGAIN is turned into FATAL */
   if (source->iotype == SC_IO_TYPE_FILENAME) {
@@ -250,14 +1165,29 @@ sc_io_source_destroy (sc_io_source_t * source)
     /* Attempt close even on complete error */
     retval = fclose (source->file) || retval;
   }
+#ifdef SC_IO_HAVE_MMAP
+  if (source->map != NULL) {
+    SC_ASSERT (source->iotype == SC_IO_TYPE_MMAP);
+    retval = munmap (source->map, source->map_size) || retval;
+  }
+#endif
+#ifdef SC_HAVE_ZLIB
+  if (source->codec != NULL) {
+    (void) inflateEnd (&((sc_io_codec_t *) source->codec)->zs);
+    SC_FREE (source->codec);
+  }
+#endif
   SC_FREE (source);
 
   return retval ? SC_IO_ERROR_FATAL : SC_IO_ERROR_NONE;
 }
 
-int
-sc_io_source_read (sc_io_source_t * source, void *data,
-                   size_t bytes_avail, size_t *bytes_out)
+/** Read data from the underlying buffer or file of a source.
+ * \return          0 on success, nonzero on error.
+ */
+static int
+sc_io_source_read_raw (sc_io_source_t * source, void *data,
+                       size_t bytes_avail, size_t *pbytes_out)
 {
   int                 retval;
   size_t              bbytes_out;
@@ -267,7 +1197,7 @@ sc_io_source_read (sc_io_source_t * source, void *data,
 
   if (source->iotype == SC_IO_TYPE_BUFFER) {
     SC_ASSERT (source->buffer != NULL);
-    bbytes_out = SC_ARRAY_BYTE_ALLOC (source->buffer);
+    bbytes_out = source->buffer->elem_count * source->buffer->elem_size;
     SC_ASSERT (bbytes_out >= source->buffer_bytes);
     bbytes_out -= source->buffer_bytes;
     bbytes_out = SC_MIN (bbytes_out, bytes_avail);
@@ -277,23 +1207,153 @@ sc_io_source_read (sc_io_source_t * source, void *data,
     }
     source->buffer_bytes += bbytes_out;
   }
+  else if (source->iotype == SC_IO_TYPE_MMAP) {
+    SC_ASSERT (source->map_size >= source->buffer_bytes);
+    bbytes_out = source->map_size - source->buffer_bytes;
+    bbytes_out = SC_MIN (bbytes_out, bytes_avail);
+
+    if (data != NULL) {
+      memcpy (data, source->map + source->buffer_bytes, bbytes_out);
+    }
+    source->buffer_bytes += bbytes_out;
+  }
   else if (source->iotype == SC_IO_TYPE_FILENAME ||
            source->iotype == SC_IO_TYPE_FILEFILE) {
     SC_ASSERT (source->file != NULL);
-    if (data != NULL) {
+    if (source->readahead != NULL) {
+      retval = sc_io_readahead_read ((sc_io_readahead_t *) source->readahead,
+                                     (char *) data, bytes_avail, &bbytes_out);
+    }
+    else if (data != NULL) {
       bbytes_out = fread (data, 1, bytes_avail, source->file);
       if (bbytes_out < bytes_avail) {
         retval = !feof (source->file) || ferror (source->file);
       }
-      if (retval == SC_IO_ERROR_NONE && source->mirror != NULL) {
-        retval = sc_io_sink_write (source->mirror, data, bbytes_out);
-      }
     }
     else {
       retval = fseek (source->file, (long) bytes_avail, SEEK_CUR);
       bbytes_out = bytes_avail;
     }
   }
+
+  *pbytes_out = bbytes_out;
+  return retval;
+}
+
+#ifdef SC_HAVE_ZLIB
+
+/** Read compressed data from the underlying source and uncompress it.
+ * Consecutive zlib streams, as written by completing a sink in between,
+ * are read as one.
+ * \return          0 on success, nonzero on error.
+ */
+static int
+sc_io_source_inflate (sc_io_source_t * source, void *data,
+                      size_t bytes_avail, size_t *pbytes_out)
+{
+  int                 zrv;
+  size_t              got, len, produced;
+  char                skip[1 << 12];
+  sc_io_codec_t      *codec = (sc_io_codec_t *) source->codec;
+
+  produced = 0;
+  while (produced < bytes_avail) {
+    if (codec->zs.avail_in == 0 && !codec->eof) {
+      if (sc_io_source_read_raw (source, codec->buf, SC_IO_CODEC_BUFFER,
+                                 &got)) {
+        return SC_IO_ERROR_FATAL;
+      }
+      source->bytes_in += got;
+      codec->eof = got == 0;
+      codec->zs.next_in = (Bytef *) codec->buf;
+      codec->zs.avail_in = (uInt) got;
+    }
+    if (codec->zs.avail_in == 0 && codec->eof) {
+      /* a stream that is cut short is an error */
+      if (!codec->ended) {
+        return SC_IO_ERROR_FATAL;
+      }
+      break;
+    }
+    if (codec->ended) {
+      (void) inflateReset (&codec->zs);
+      codec->ended = 0;
+    }
+
+    /* uncompress into the output or discard the data */
+    len = SC_MIN (bytes_avail - produced, (size_t) 1 << 30);
+    if (data == NULL) {
+      len = SC_MIN (len, sizeof (skip));
+      codec->zs.next_out = (Bytef *) skip;
+    }
+    else {
+      codec->zs.next_out = (Bytef *) data + produced;
+    }
+    codec->zs.avail_out = (uInt) len;
+    zrv = inflate (&codec->zs, Z_NO_FLUSH);
+    if (zrv == Z_STREAM_END) {
+      codec->ended = 1;
+    }
+    else if (zrv != Z_OK && zrv != Z_BUF_ERROR) {
+      return SC_IO_ERROR_FATAL;
+    }
+    produced += len - codec->zs.avail_out;
+  }
+
+  *pbytes_out = produced;
+  return SC_IO_ERROR_NONE;
+}
+
+#endif /* SC_HAVE_ZLIB */
+
+/** Advance the position of a zero-copy mirror.
+ * \param [in] copied   Whether the bytes have been read or skipped.
+ */
+static void
+sc_io_source_record (sc_io_source_t * source, int copied, size_t bytes)
+{
+  sc_array_t         *extents = source->mirror_extents;
+  sc_io_extent_t     *ext;
+
+  if (copied && bytes > 0) {
+    ext = extents->elem_count == 0 ? NULL :
+      (sc_io_extent_t *) sc_array_index (extents, extents->elem_count - 1);
+    if (ext == NULL ||
+        ext->offset + (long) ext->bytes != source->mirror_position) {
+      ext = (sc_io_extent_t *) sc_array_push (extents);
+      ext->offset = source->mirror_position;
+      ext->bytes = 0;
+    }
+    ext->bytes += bytes;
+  }
+  source->mirror_position += (long) bytes;
+}
+
+int
+sc_io_source_read (sc_io_source_t * source, void *data,
+                   size_t bytes_avail, size_t *bytes_out)
+{
+  int                 retval;
+  size_t              bbytes_out;
+
+#ifdef SC_HAVE_ZLIB
+  if (source->codec != NULL) {
+    retval = sc_io_source_inflate (source, data, bytes_avail, &bbytes_out);
+  }
+  else
+#endif
+  {
+    retval = sc_io_source_read_raw (source, data, bytes_avail, &bbytes_out);
+    if (!retval) {
+      source->bytes_in += bbytes_out;
+    }
+  }
+  if (retval == SC_IO_ERROR_NONE && data != NULL && source->mirror != NULL) {
+    retval = sc_io_sink_write (source->mirror, data, bbytes_out);
+  }
+  if (retval == SC_IO_ERROR_NONE && source->mirror_extents != NULL) {
+    sc_io_source_record (source, data != NULL, bbytes_out);
+  }
   if (retval) {
     return SC_IO_ERROR_FATAL;
   }
@@ -304,7 +1364,6 @@ sc_io_source_read (sc_io_source_t * source, void *data,
   if (bytes_out != NULL) {
     *bytes_out = bbytes_out;
   }
-  source->bytes_in += bbytes_out;
   source->bytes_out += bbytes_out;
 
   return SC_IO_ERROR_NONE;
@@ -316,7 +1375,7 @@ sc_io_source_complete (sc_io_source_t * source,
 {
   int                 retval = SC_IO_ERROR_NONE;
 
-  if (source->iotype == SC_IO_TYPE_BUFFER) {
+  if (source->iotype == SC_IO_TYPE_BUFFER && source->codec == NULL) {
     SC_ASSERT (source->buffer != NULL);
     if (source->buffer_bytes % source->buffer->elem_size != 0) {
       return SC_IO_ERROR_AGAIN;
@@ -350,16 +1409,140 @@ sc_io_source_align (sc_io_source_t * source, size_t bytes_align)
   return sc_io_source_read (source, NULL, fill_bytes, NULL);
 }
 
+const char         *
+sc_io_source_peek (sc_io_source_t * source, size_t *bytes_avail)
+{
+  const char         *data = NULL;
+  size_t              bytes = 0;
+
+  if (source->codec != NULL) {
+    /* the data in memory is compressed */
+  }
+  else if (source->iotype == SC_IO_TYPE_BUFFER) {
+    SC_ASSERT (source->buffer != NULL);
+    bytes = source->buffer->elem_count * source->buffer->elem_size -
+      source->buffer_bytes;
+    data = source->buffer->array + source->buffer_bytes;
+  }
+  else if (source->iotype == SC_IO_TYPE_MMAP) {
+    bytes = source->map_size - source->buffer_bytes;
+    data = source->map == NULL ? "" : source->map + source->buffer_bytes;
+  }
+
+  if (bytes_avail != NULL) {
+    *bytes_avail = bytes;
+  }
+  return data;
+}
+
+int
+sc_io_source_advise (sc_io_source_t * source, int advice)
+{
+  SC_ASSERT (0 <= advice && advice < SC_IO_ADVICE_LAST);
+
+#if defined SC_IO_HAVE_MMAP && defined MADV_SEQUENTIAL
+  if (source->iotype == SC_IO_TYPE_MMAP && source->map != NULL) {
+    int                 madv;
+
+    switch (advice) {
+    case SC_IO_ADVICE_SEQUENTIAL:
+      madv = MADV_SEQUENTIAL;
+      break;
+    case SC_IO_ADVICE_RANDOM:
+      madv = MADV_RANDOM;
+      break;
+    case SC_IO_ADVICE_WILLNEED:
+      madv = MADV_WILLNEED;
+      break;
+    default:
+      madv = MADV_NORMAL;
+    }
+    if (madvise (source->map, source->map_size, madv)) {
+      return SC_IO_ERROR_FATAL;
+    }
+  }
+#endif
+#if defined SC_IO_HAVE_POSIX && defined POSIX_FADV_SEQUENTIAL
+  if (source->iotype == SC_IO_TYPE_FILENAME ||
+      source->iotype == SC_IO_TYPE_FILEFILE) {
+    int                 fadv;
+
+    switch (advice) {
+    case SC_IO_ADVICE_SEQUENTIAL:
+      fadv = POSIX_FADV_SEQUENTIAL;
+      break;
+    case SC_IO_ADVICE_RANDOM:
+      fadv = POSIX_FADV_RANDOM;
+      break;
+    case SC_IO_ADVICE_WILLNEED:
+      fadv = POSIX_FADV_WILLNEED;
+      break;
+    default:
+      fadv = POSIX_FADV_NORMAL;
+    }
+    /* pipes do not take advice, which is not an error */
+    if (posix_fadvise (fileno (source->file), 0, 0, fadv) == EBADF) {
+      return SC_IO_ERROR_FATAL;
+    }
+  }
+#endif
+  return SC_IO_ERROR_NONE;
+}
+
+int
+sc_io_source_set_readahead (sc_io_source_t * source, size_t bytes,
+                            int flags)
+{
+  sc_io_readahead_t  *ra;
+
+  if (source->iotype != SC_IO_TYPE_FILENAME &&
+      source->iotype != SC_IO_TYPE_FILEFILE) {
+    return SC_IO_ERROR_FATAL;
+  }
+  if (source->readahead != NULL) {
+    return SC_IO_ERROR_FATAL;
+  }
+  if (sc_io_source_advise (source, SC_IO_ADVICE_SEQUENTIAL)) {
+    return SC_IO_ERROR_FATAL;
+  }
+
+  ra = SC_ALLOC_ZERO (sc_io_readahead_t, 1);
+  ra->file = source->file;
+  ra->size = bytes > 0 ? bytes : SC_IO_READAHEAD_SIZE;
+  ra->alloc = SC_ALLOC (char, 2 * ra->size);
+  ra->buffers[0] = ra->alloc;
+  ra->buffers[1] = ra->alloc + ra->size;
+#ifdef SC_ENABLE_PTHREAD
+  ra->prefetch = (flags & SC_IO_READAHEAD_PREFETCH) != 0;
+#endif
+  source->readahead = ra;
+  return SC_IO_ERROR_NONE;
+}
+
 int
 sc_io_source_activate_mirror (sc_io_source_t * source)
 {
-  if (source->iotype == SC_IO_TYPE_BUFFER) {
+  if (source->iotype == SC_IO_TYPE_BUFFER ||
+      source->iotype == SC_IO_TYPE_MMAP) {
     return SC_IO_ERROR_FATAL;
   }
-  if (source->mirror != NULL) {
+  if (source->mirror != NULL || source->mirror_extents != NULL) {
     return SC_IO_ERROR_FATAL;
   }
 
+#ifdef SC_IO_HAVE_POSIX
+  if (source->codec == NULL) {
+    long                position = sc_io_source_tell (source);
+
+    /* record the ranges read and read them again on demand */
+    if (position >= 0) {
+      source->mirror_extents = sc_array_new (sizeof (sc_io_extent_t));
+      source->mirror_position = position;
+      return SC_IO_ERROR_NONE;
+    }
+  }
+#endif
+
   source->mirror_buffer = sc_array_new (sizeof (char));
   source->mirror = sc_io_sink_new (SC_IO_TYPE_BUFFER, SC_IO_MODE_WRITE,
                                    SC_IO_ENCODE_NONE, source->mirror_buffer);
@@ -367,6 +1550,51 @@ sc_io_source_activate_mirror (sc_io_source_t * source)
   return (source->mirror != NULL ? SC_IO_ERROR_NONE : SC_IO_ERROR_FATAL);
 }
 
+#ifdef SC_IO_HAVE_POSIX
+
+/** Read the ranges recorded by a zero-copy mirror from the file.
+ * The file position is not changed.
+ * \return          0 on success, nonzero on error.
+ */
+static int
+sc_io_source_read_extents (sc_io_source_t * source, char *data,
+                           size_t bytes_avail, size_t *bytes_out)
+{
+  int                 fd;
+  size_t              zz, done, n, got;
+  ssize_t             rd;
+  sc_io_extent_t     *ext;
+
+  fd = fileno (source->file);
+  done = 0;
+  for (zz = 0; zz < source->mirror_extents->elem_count &&
+       done < bytes_avail; ++zz) {
+    ext = (sc_io_extent_t *) sc_array_index (source->mirror_extents, zz);
+    n = SC_MIN (ext->bytes, bytes_avail - done);
+    for (got = 0; data != NULL && got < n; got += (size_t) rd) {
+      rd = pread (fd, data + done + got, n - got,
+                  (off_t) (ext->offset + (long) got));
+      if (rd < 0 && errno == EINTR) {
+        rd = 0;
+      }
+      else if (rd <= 0) {
+        return SC_IO_ERROR_FATAL;
+      }
+    }
+    done += n;
+  }
+
+  if (bytes_out == NULL && done < bytes_avail) {
+    return SC_IO_ERROR_FATAL;
+  }
+  if (bytes_out != NULL) {
+    *bytes_out = done;
+  }
+  return SC_IO_ERROR_NONE;
+}
+
+#endif
+
 int
 sc_io_source_read_mirror (sc_io_source_t * source, void *data,
                           size_t bytes_avail, size_t *bytes_out)
@@ -374,6 +1602,12 @@ sc_io_source_read_mirror (sc_io_source_t * source, void *data,
   sc_io_source_t     *mirror_src;
   int                 retval;
 
+#ifdef SC_IO_HAVE_POSIX
+  if (source->mirror_extents != NULL) {
+    return sc_io_source_read_extents (source, (char *) data, bytes_avail,
+                                      bytes_out);
+  }
+#endif
   if (source->mirror_buffer == NULL) {
     return SC_IO_ERROR_FATAL;
   }
@@ -402,45 +1636,230 @@ sc_io_source_read_mirror (sc_io_source_t * source, void *data,
 #define SC_IO_LBE (SC_IO_LBD + 1)   /* after second line break byte */
 #define SC_IO_LBF (SC_IO_LBE + 1)   /* after line break and NUL byte */
 
-/* see RFC 1950 and RFC 1951 for the uncompressed zlib format */
-#ifndef SC_HAVE_ZLIB
-#define SC_IO_NONCOMP_BLOCK 65531       /**< +5 byte header = 64k */
 #define SC_IO_ADLER32_PRIME 65521       /**< defined by RFC 1950 */
+#define SC_IO_ADLER32_NMAX 5552 /**< bytes before s2 may overflow */
 
-static void
-sc_io_adler32_init (uint32_t *adler)
+#ifdef SC_IO_ADLER32_AVX2
+
+/** Add up the eight 32-bit lanes of a vector. */
+static inline uint32_t
+sc_io_hsum_avx2 (__m256i v)
 {
-  SC_ASSERT (adler != NULL);
-  *adler = 1;
+  __m128i             x;
+
+  x = _mm_add_epi32 (_mm256_castsi256_si128 (v),
+                     _mm256_extracti128_si256 (v, 1));
+  x = _mm_add_epi32 (x, _mm_shuffle_epi32 (x, 0x4E));
+  x = _mm_add_epi32 (x, _mm_shuffle_epi32 (x, 0xB1));
+  return (uint32_t) _mm_cvtsi128_si32 (x);
 }
 
+/** Extend unreduced adler32 sums by a multiple of 32 bytes.
+ * Over a run of n bytes b_i, s2 grows by n * s1 + sum (n - i) b_i.
+ * We sum the bytes of each 32-byte chunk into s1, weigh them by
+ * 32 down to 1 into s2, and add 32 times the s1 of all earlier chunks.
+ */
 static void
-sc_io_adler32_update (uint32_t *adler, const char *buffer, size_t length)
+sc_io_adler32_avx2 (uint32_t *s1, uint32_t *s2,
+                    const unsigned char *p, size_t length)
 {
-  size_t              iz;
-  int16_t             cn;
-  uint32_t            s1, s2;
+  const __m256i       zero = _mm256_setzero_si256 ();
+  const __m256i       ones = _mm256_set1_epi16 (1);
+  const __m256i       weights =
+    _mm256_setr_epi8 (32, 31, 30, 29, 28, 27, 26, 25, 24, 23, 22, 21, 20,
+                      19, 18, 17, 16, 15, 14, 13, 12, 11, 10, 9, 8, 7, 6,
+                      5, 4, 3, 2, 1);
+  __m256i             vs1, vs2, vps, bytes;
+  size_t              k;
+
+  SC_ASSERT (length % 32 == 0);
+
+  vs1 = vs2 = vps = zero;
+  for (k = length / 32; k > 0; --k) {
+    bytes = _mm256_loadu_si256 ((const __m256i *) p);
+    vps = _mm256_add_epi32 (vps, vs1);
+    vs1 = _mm256_add_epi32 (vs1, _mm256_sad_epu8 (bytes, zero));
+    vs2 = _mm256_add_epi32
+      (vs2, _mm256_madd_epi16 (_mm256_maddubs_epi16 (bytes, weights), ones));
+    p += 32;
+  }
+  vs2 = _mm256_add_epi32 (vs2, _mm256_slli_epi32 (vps, 5));
 
-  SC_ASSERT (adler != NULL);
-  s1 = (*adler) & 0xFFFFU;
-  s2 = (*adler) >> 16;
+  *s2 += *s1 * (uint32_t) length + sc_io_hsum_avx2 (vs2);
+  *s1 += sc_io_hsum_avx2 (vs1);
+}
 
-  cn = 0;
-  for (iz = 0; iz < length; ++iz) {
-    unsigned char       uc = (unsigned char) buffer[iz];
-    if (cn == 5000) {
-      s1 = s1 % SC_IO_ADLER32_PRIME;
-      s2 = s2 % SC_IO_ADLER32_PRIME;
-      cn = 0;
-    }
-    s1 += uc;
-    s2 += s1;
-    ++cn;
+#endif /* SC_IO_ADLER32_AVX2 */
+
+uint32_t
+sc_io_adler32 (uint32_t adler, const void *buffer, size_t length)
+{
+  const unsigned char *p = (const unsigned char *) buffer;
+  uint32_t            s1, s2;
+  size_t              n;
+  int                 i;
+#ifdef SC_IO_ADLER32_AVX2
+  size_t              nv;
+#endif
+
+  SC_ASSERT (length == 0 || buffer != NULL);
+
+  s1 = adler & 0xFFFFU;
+  s2 = adler >> 16;
+  while (length > 0) {
+    /* reduce the sums modulo the prime before they may overflow */
+    n = SC_MIN (length, (size_t) SC_IO_ADLER32_NMAX);
+    length -= n;
+#ifdef SC_IO_ADLER32_AVX2
+    nv = n & ~(size_t) 31;
+    if (nv > 0) {
+      sc_io_adler32_avx2 (&s1, &s2, p, nv);
+      p += nv;
+      n -= nv;
+    }
+#endif
+    for (; n >= 16; n -= 16) {
+      for (i = 0; i < 16; ++i) {
+        s1 += p[i];
+        s2 += s1;
+      }
+      p += 16;
+    }
+    for (; n > 0; --n) {
+      s1 += *p++;
+      s2 += s1;
+    }
+    s1 %= SC_IO_ADLER32_PRIME;
+    s2 %= SC_IO_ADLER32_PRIME;
+  }
+  return (s2 << 16) | s1;
+}
+
+#if !defined SC_IO_CRC32C_SSE42 && !defined SC_IO_CRC32C_ARM
+
+/** Table of the reflected CRC32C polynomial 0x82F63B78 by byte. */
+static const uint32_t sc_io_crc32c_table[256] = {
+  0x00000000U, 0xf26b8303U, 0xe13b70f7U, 0x1350f3f4U,
+  0xc79a971fU, 0x35f1141cU, 0x26a1e7e8U, 0xd4ca64ebU,
+  0x8ad958cfU, 0x78b2dbccU, 0x6be22838U, 0x9989ab3bU,
+  0x4d43cfd0U, 0xbf284cd3U, 0xac78bf27U, 0x5e133c24U,
+  0x105ec76fU, 0xe235446cU, 0xf165b798U, 0x030e349bU,
+  0xd7c45070U, 0x25afd373U, 0x36ff2087U, 0xc494a384U,
+  0x9a879fa0U, 0x68ec1ca3U, 0x7bbcef57U, 0x89d76c54U,
+  0x5d1d08bfU, 0xaf768bbcU, 0xbc267848U, 0x4e4dfb4bU,
+  0x20bd8edeU, 0xd2d60dddU, 0xc186fe29U, 0x33ed7d2aU,
+  0xe72719c1U, 0x154c9ac2U, 0x061c6936U, 0xf477ea35U,
+  0xaa64d611U, 0x580f5512U, 0x4b5fa6e6U, 0xb93425e5U,
+  0x6dfe410eU, 0x9f95c20dU, 0x8cc531f9U, 0x7eaeb2faU,
+  0x30e349b1U, 0xc288cab2U, 0xd1d83946U, 0x23b3ba45U,
+  0xf779deaeU, 0x05125dadU, 0x1642ae59U, 0xe4292d5aU,
+  0xba3a117eU, 0x4851927dU, 0x5b016189U, 0xa96ae28aU,
+  0x7da08661U, 0x8fcb0562U, 0x9c9bf696U, 0x6ef07595U,
+  0x417b1dbcU, 0xb3109ebfU, 0xa0406d4bU, 0x522bee48U,
+  0x86e18aa3U, 0x748a09a0U, 0x67dafa54U, 0x95b17957U,
+  0xcba24573U, 0x39c9c670U, 0x2a993584U, 0xd8f2b687U,
+  0x0c38d26cU, 0xfe53516fU, 0xed03a29bU, 0x1f682198U,
+  0x5125dad3U, 0xa34e59d0U, 0xb01eaa24U, 0x42752927U,
+  0x96bf4dccU, 0x64d4cecfU, 0x77843d3bU, 0x85efbe38U,
+  0xdbfc821cU, 0x2997011fU, 0x3ac7f2ebU, 0xc8ac71e8U,
+  0x1c661503U, 0xee0d9600U, 0xfd5d65f4U, 0x0f36e6f7U,
+  0x61c69362U, 0x93ad1061U, 0x80fde395U, 0x72966096U,
+  0xa65c047dU, 0x5437877eU, 0x4767748aU, 0xb50cf789U,
+  0xeb1fcbadU, 0x197448aeU, 0x0a24bb5aU, 0xf84f3859U,
+  0x2c855cb2U, 0xdeeedfb1U, 0xcdbe2c45U, 0x3fd5af46U,
+  0x7198540dU, 0x83f3d70eU, 0x90a324faU, 0x62c8a7f9U,
+  0xb602c312U, 0x44694011U, 0x5739b3e5U, 0xa55230e6U,
+  0xfb410cc2U, 0x092a8fc1U, 0x1a7a7c35U, 0xe811ff36U,
+  0x3cdb9bddU, 0xceb018deU, 0xdde0eb2aU, 0x2f8b6829U,
+  0x82f63b78U, 0x709db87bU, 0x63cd4b8fU, 0x91a6c88cU,
+  0x456cac67U, 0xb7072f64U, 0xa457dc90U, 0x563c5f93U,
+  0x082f63b7U, 0xfa44e0b4U, 0xe9141340U, 0x1b7f9043U,
+  0xcfb5f4a8U, 0x3dde77abU, 0x2e8e845fU, 0xdce5075cU,
+  0x92a8fc17U, 0x60c37f14U, 0x73938ce0U, 0x81f80fe3U,
+  0x55326b08U, 0xa759e80bU, 0xb4091bffU, 0x466298fcU,
+  0x1871a4d8U, 0xea1a27dbU, 0xf94ad42fU, 0x0b21572cU,
+  0xdfeb33c7U, 0x2d80b0c4U, 0x3ed04330U, 0xccbbc033U,
+  0xa24bb5a6U, 0x502036a5U, 0x4370c551U, 0xb11b4652U,
+  0x65d122b9U, 0x97baa1baU, 0x84ea524eU, 0x7681d14dU,
+  0x2892ed69U, 0xdaf96e6aU, 0xc9a99d9eU, 0x3bc21e9dU,
+  0xef087a76U, 0x1d63f975U, 0x0e330a81U, 0xfc588982U,
+  0xb21572c9U, 0x407ef1caU, 0x532e023eU, 0xa145813dU,
+  0x758fe5d6U, 0x87e466d5U, 0x94b49521U, 0x66df1622U,
+  0x38cc2a06U, 0xcaa7a905U, 0xd9f75af1U, 0x2b9cd9f2U,
+  0xff56bd19U, 0x0d3d3e1aU, 0x1e6dcdeeU, 0xec064eedU,
+  0xc38d26c4U, 0x31e6a5c7U, 0x22b65633U, 0xd0ddd530U,
+  0x0417b1dbU, 0xf67c32d8U, 0xe52cc12cU, 0x1747422fU,
+  0x49547e0bU, 0xbb3ffd08U, 0xa86f0efcU, 0x5a048dffU,
+  0x8ecee914U, 0x7ca56a17U, 0x6ff599e3U, 0x9d9e1ae0U,
+  0xd3d3e1abU, 0x21b862a8U, 0x32e8915cU, 0xc083125fU,
+  0x144976b4U, 0xe622f5b7U, 0xf5720643U, 0x07198540U,
+  0x590ab964U, 0xab613a67U, 0xb831c993U, 0x4a5a4a90U,
+  0x9e902e7bU, 0x6cfbad78U, 0x7fab5e8cU, 0x8dc0dd8fU,
+  0xe330a81aU, 0x115b2b19U, 0x020bd8edU, 0xf0605beeU,
+  0x24aa3f05U, 0xd6c1bc06U, 0xc5914ff2U, 0x37faccf1U,
+  0x69e9f0d5U, 0x9b8273d6U, 0x88d28022U, 0x7ab90321U,
+  0xae7367caU, 0x5c18e4c9U, 0x4f48173dU, 0xbd23943eU,
+  0xf36e6f75U, 0x0105ec76U, 0x12551f82U, 0xe03e9c81U,
+  0x34f4f86aU, 0xc69f7b69U, 0xd5cf889dU, 0x27a40b9eU,
+  0x79b737baU, 0x8bdcb4b9U, 0x988c474dU, 0x6ae7c44eU,
+  0xbe2da0a5U, 0x4c4623a6U, 0x5f16d052U, 0xad7d5351U
+};
+
+#endif
+
+uint32_t
+sc_io_crc32c (uint32_t crc, const void *buffer, size_t length)
+{
+  const unsigned char *p = (const unsigned char *) buffer;
+#if defined SC_IO_CRC32C_SSE42 || defined SC_IO_CRC32C_ARM
+  uint64_t            word;
+#endif
+
+  SC_ASSERT (length == 0 || buffer != NULL);
+
+  crc = ~crc;
+#if defined SC_IO_CRC32C_SSE42
+  for (; length >= 8; length -= 8) {
+    memcpy (&word, p, 8);
+    crc = (uint32_t) _mm_crc32_u64 (crc, word);
+    p += 8;
+  }
+  for (; length > 0; --length) {
+    crc = _mm_crc32_u8 (crc, *p++);
+  }
+#elif defined SC_IO_CRC32C_ARM
+  for (; length >= 8; length -= 8) {
+    memcpy (&word, p, 8);
+    crc = __crc32cd (crc, word);
+    p += 8;
+  }
+  for (; length > 0; --length) {
+    crc = __crc32cb (crc, *p++);
   }
-  *adler = s2 % SC_IO_ADLER32_PRIME;
-  *adler = (*adler << 16) + (s1 % SC_IO_ADLER32_PRIME);
+#else
+  for (; length > 0; --length) {
+    crc = sc_io_crc32c_table[(crc ^ *p++) & 0xFF] ^ (crc >> 8);
+  }
+#endif
+  return ~crc;
+}
+
+const char         *
+sc_io_checksum_kernel (void)
+{
+  return SC_IO_ADLER32_KERNEL ", " SC_IO_CRC32C_KERNEL;
+}
+
+const char         *
+sc_io_base64_kernel (void)
+{
+  return SC_IO_BASE64_KERNEL;
 }
 
+/* see RFC 1950 and RFC 1951 for the uncompressed zlib format */
+#ifndef SC_HAVE_ZLIB
+#define SC_IO_NONCOMP_BLOCK 65531       /**< +5 byte header = 64k */
+
 static size_t
 sc_io_noncompress_bound (size_t length)
 {
@@ -450,10 +1869,207 @@ sc_io_noncompress_bound (size_t length)
   return 2 + 5 * SC_MAX (num_blocks, 1) + length + 4;
 }
 
+#define SC_IO_DEFLATE_WINDOW 32768      /**< maximum match distance */
+#define SC_IO_DEFLATE_HASH 15   /**< bits of the match start hash */
+#define SC_IO_DEFLATE_MAX 258   /**< maximum match length */
+
+/** Bit writer of the builtin deflate compressor. */
+typedef struct sc_io_bits
+{
+  unsigned char      *out;
+  size_t              pos, size;
+  uint32_t            buf;
+  int                 count;
+  int                 overflow;
+}
+sc_io_bits_t;
+
+/** Append the n low bits of value, least significant bit first. */
+static void
+sc_io_bits_put (sc_io_bits_t * bw, uint32_t value, int n)
+{
+  bw->buf |= value << bw->count;
+  bw->count += n;
+  while (bw->count >= 8) {
+    if (bw->pos < bw->size) {
+      bw->out[bw->pos++] = (unsigned char) (bw->buf & 0xFF);
+    }
+    else {
+      bw->overflow = 1;
+    }
+    bw->buf >>= 8;
+    bw->count -= 8;
+  }
+}
+
+/** Append a Huffman code, which deflate stores most significant bit first. */
+static void
+sc_io_bits_code (sc_io_bits_t * bw, uint32_t code, int n)
+{
+  uint32_t            rev;
+  int                 i;
+
+  for (rev = 0, i = 0; i < n; ++i) {
+    rev |= ((code >> i) & 1) << (n - 1 - i);
+  }
+  sc_io_bits_put (bw, rev, n);
+}
+
+/** Append a literal or length symbol of the fixed Huffman code. */
 static void
+sc_io_bits_fixed (sc_io_bits_t * bw, int symbol)
+{
+  if (symbol < 144) {
+    sc_io_bits_code (bw, 0x30 + symbol, 8);
+  }
+  else if (symbol < 256) {
+    sc_io_bits_code (bw, 0x190 + symbol - 144, 9);
+  }
+  else if (symbol < 280) {
+    sc_io_bits_code (bw, symbol - 256, 7);
+  }
+  else {
+    sc_io_bits_code (bw, 0xC0 + symbol - 280, 8);
+  }
+}
+
+/** Compress data into one deflate block of fixed Huffman codes.
+ * Matches are found by hash chains whose search length grows with
+ * the compression level.  A non-final block is followed by an empty
+ * stored block, such that the output always ends on a byte boundary.
+ * \return          The bytes written, or 0 if they would exceed dest_size.
+ */
+static size_t
+sc_io_deflate_fixed (char *dest, size_t dest_size, const char *src,
+                     size_t src_size, int final_block, int level)
+{
+  static const short  lbase[29] = {
+    3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+    35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258
+  };
+  static const short  lext[29] = {
+    0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+    3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0
+  };
+  static const int    dbase[30] = {
+    1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+    257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145,
+    8193, 12289, 16385, 24577
+  };
+  static const short  dext[30] = {
+    0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+    7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13
+  };
+  static const int    chains[10] = { 0, 4, 8, 16, 16, 32, 64, 128, 256,
+    1024
+  };
+  const unsigned char *in = (const unsigned char *) src;
+  unsigned char       lsym[SC_IO_DEFLATE_MAX + 1];
+  int                 chain, len, best, bdist, sym, cand, k;
+  int                *head, *prev;
+  size_t              pos, end;
+  uint32_t            h;
+  sc_io_bits_t        bw;
+
+  SC_ASSERT (-1 <= level && level <= 9 && level != 0);
+  chain = chains[level < 0 ? 6 : level];
+
+  /* symbol of each match length */
+  for (sym = 0; sym < 29; ++sym) {
+    for (len = lbase[sym]; len < (sym < 28 ? lbase[sym + 1] : 259); ++len) {
+      lsym[len] = (unsigned char) sym;
+    }
+  }
+
+  bw.out = (unsigned char *) dest;
+  bw.pos = 0;
+  bw.size = dest_size;
+  bw.buf = 0;
+  bw.count = 0;
+  bw.overflow = 0;
+  sc_io_bits_put (&bw, final_block ? 1 : 0, 1);
+  sc_io_bits_put (&bw, 1, 2);
+
+  head = SC_ALLOC (int, 1 << SC_IO_DEFLATE_HASH);
+  memset (head, -1, sizeof (int) << SC_IO_DEFLATE_HASH);
+  prev = SC_ALLOC (int, SC_MAX (src_size, 1));
+  for (pos = 0; pos < src_size && !bw.overflow;) {
+    best = 0;
+    bdist = 0;
+    if (pos + 3 <= src_size) {
+      /* walk the chain of earlier positions with the same hash */
+      h = (((uint32_t) in[pos] << 10) ^ ((uint32_t) in[pos + 1] << 5) ^
+           in[pos + 2]) & ((1 << SC_IO_DEFLATE_HASH) - 1);
+      end = SC_MIN (src_size - pos, SC_IO_DEFLATE_MAX);
+      for (k = 0, cand = head[h]; cand >= 0 && k < chain &&
+           pos - (size_t) cand <= SC_IO_DEFLATE_WINDOW;
+           ++k, cand = prev[cand]) {
+        len = 0;
+        while ((size_t) len < end && in[cand + len] == in[pos + len]) {
+          ++len;
+        }
+        if (len > best) {
+          best = len;
+          bdist = (int) (pos - (size_t) cand);
+          if ((size_t) len == end) {
+            break;
+          }
+        }
+      }
+      prev[pos] = head[h];
+      head[h] = (int) pos;
+    }
+    if (best < 3) {
+      sc_io_bits_fixed (&bw, in[pos]);
+      ++pos;
+      continue;
+    }
+
+    /* write the length and distance of the match */
+    sym = lsym[best];
+    sc_io_bits_fixed (&bw, 257 + sym);
+    sc_io_bits_put (&bw, (uint32_t) (best - lbase[sym]), lext[sym]);
+    for (sym = 29; dbase[sym] > bdist; --sym) {
+    }
+    sc_io_bits_code (&bw, (uint32_t) sym, 5);
+    sc_io_bits_put (&bw, (uint32_t) (bdist - dbase[sym]), dext[sym]);
+
+    /* enter the positions inside the match into the hash chains */
+    for (end = pos + (size_t) best, ++pos; pos < end; ++pos) {
+      if (pos + 3 <= src_size) {
+        h = (((uint32_t) in[pos] << 10) ^ ((uint32_t) in[pos + 1] << 5) ^
+             in[pos + 2]) & ((1 << SC_IO_DEFLATE_HASH) - 1);
+        prev[pos] = head[h];
+        head[h] = (int) pos;
+      }
+    }
+  }
+  SC_FREE (prev);
+  SC_FREE (head);
+
+  /* end of block, then align to a byte */
+  sc_io_bits_fixed (&bw, 256);
+  if (!final_block) {
+    sc_io_bits_put (&bw, 0, 3);
+  }
+  sc_io_bits_put (&bw, 0, (8 - bw.count) % 8);
+  if (!final_block) {
+    sc_io_bits_put (&bw, 0xFFFF0000U, 32);
+  }
+  return bw.overflow ? 0 : bw.pos;
+}
+
+/** Write data in zlib format without zlib.
+ * Each block is compressed by \ref sc_io_deflate_fixed unless the level
+ * is 0 or this does not pay off, in which case we store it.
+ * \return          The number of bytes written.
+ */
+static size_t
 sc_io_noncompress (char *dest, size_t dest_size,
-                   const char *src, size_t src_size)
+                   const char *src, size_t src_size, int level)
 {
+  char               *start = dest;
+  size_t              fsize;
   uint16_t            bsize, nsize;
   uint32_t            adler;
 
@@ -465,22 +2081,30 @@ sc_io_noncompress (char *dest, size_t dest_size,
   dest_size -= 2;
 
   /* prepare checksum */
-  sc_io_adler32_init (&adler);
+  adler = 1;
 
   /* write individual non-compressed blocks */
   do {
     /* write block header */
     SC_ASSERT (dest_size >= 5);
-    if (src_size > SC_IO_NONCOMP_BLOCK) {
-      /* not the final block */
-      bsize = SC_IO_NONCOMP_BLOCK;
-      dest[0] = 0;
-    }
-    else {
-      /* last block */
-      bsize = src_size;
-      dest[0] = 1;
+    bsize = (uint16_t) SC_MIN (src_size, SC_IO_NONCOMP_BLOCK);
+    SC_ASSERT (dest_size >= 5 + (size_t) bsize);
+#ifdef SC_PUFF_INCLUDED
+    if (level != 0) {
+      fsize = sc_io_deflate_fixed (dest, 5 + (size_t) bsize, src, bsize,
+                                   src_size == bsize, level);
+      if (fsize > 0) {
+        /* the compressed block is no longer than the stored one */
+        dest += fsize;
+        dest_size -= fsize;
+        adler = sc_io_adler32 (adler, src, bsize);
+        src += bsize;
+        src_size -= bsize;
+        continue;
+      }
     }
+#endif
+    dest[0] = (char) (src_size == bsize ? 1 : 0);
     nsize = ~bsize;
     dest[1] = (char) (bsize & 0xFF);
     dest[2] = (char) (bsize >> 8);
@@ -497,7 +2121,7 @@ sc_io_noncompress (char *dest, size_t dest_size,
     dest_size -= bsize;
 
     /* extend adler32 checksum */
-    sc_io_adler32_update (&adler, src, bsize);
+    adler = sc_io_adler32 (adler, src, bsize);
     src += bsize;
     src_size -= bsize;
   }
@@ -505,11 +2129,12 @@ sc_io_noncompress (char *dest, size_t dest_size,
 
   /* write adler32 checksum */
   SC_ASSERT (src_size == 0);
-  SC_ASSERT (dest_size == 4);
+  SC_ASSERT (dest_size >= 4);
   dest[0] = (char) (adler >> 24);
   dest[1] = (char) ((adler >> 16) & 0xFF);
   dest[2] = (char) ((adler >> 8) & 0xFF);
   dest[3] = (char) (adler & 0xFF);
+  return (size_t) (dest + 4 - start);
 }
 
 static int
@@ -551,7 +2176,7 @@ sc_io_nonuncompress (char *dest, size_t dest_size,
   src_size -= 2;
 
   /* prepare checksum */
-  sc_io_adler32_init (&adler);
+  adler = 1;
 
   /* go through zlib blocks */
   do {
@@ -577,7 +2202,7 @@ sc_io_nonuncompress (char *dest, size_t dest_size,
     }
 
     /* extend adler32 checksum */
-    sc_io_adler32_update (&adler, dest, dest_size);
+    adler = sc_io_adler32 (adler, dest, dest_size);
     src += sourcelen;
     src_size = 4;
     dest += destlen;
@@ -615,7 +2240,7 @@ sc_io_nonuncompress (char *dest, size_t dest_size,
     src_size -= bsize;
 
     /* extend adler32 checksum */
-    sc_io_adler32_update (&adler, dest, bsize);
+    adler = sc_io_adler32 (adler, dest, bsize);
     dest += bsize;
     dest_size -= bsize;
 #endif
@@ -641,545 +2266,2496 @@ sc_io_nonuncompress (char *dest, size_t dest_size,
 
 #endif /* !SC_HAVE_ZLIB */
 
+#define SC_IO_INTS_HEADER 9
 #define SC_IO_ENCODE_INFO_LEN 9
 
-void
-sc_io_encode (sc_array_t *data, sc_array_t *out)
+/** The base 64 alphabet of RFC 4648. */
+static const char   sc_io_base64_chars[] =
+  "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+/** Decoded value of each character, -1 for padding and -2 if invalid. */
+static const signed char sc_io_base64_values[128] = {
+  -2, -2, -2, -2, -2, -2, -2, -2, -2, -2, -2, -2, -2, -2, -2, -2,
+  -2, -2, -2, -2, -2, -2, -2, -2, -2, -2, -2, -2, -2, -2, -2, -2,
+  -2, -2, -2, -2, -2, -2, -2, -2, -2, -2, -2, 62, -2, -2, -2, 63,
+  52, 53, 54, 55, 56, 57, 58, 59, 60, 61, -2, -2, -2, -1, -2, -2,
+  -2, 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14,
+  15, 16, 17, 18, 19, 20, 21, 22, 23, 24, 25, -2, -2, -2, -2, -2,
+  -2, 26, 27, 28, 29, 30, 31, 32, 33, 34, 35, 36, 37, 38, 39, 40,
+  41, 42, 43, 44, 45, 46, 47, 48, 49, 50, 51, -2, -2, -2, -2, -2
+};
+
+#if defined SC_IO_BASE64_AVX2 || defined SC_IO_BASE64_SSSE3
+
+/** Translate 16 six-bit values into base 64 characters. */
+static inline __m128i
+sc_io_base64_translate_sse (__m128i indices)
 {
-  sc_io_encode_zlib (data, out, Z_BEST_COMPRESSION, '=');
+  const __m128i       shift = _mm_setr_epi8
+    ('a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+     '0' - 52, '0' - 52, '0' - 52, '0' - 52, '+' - 62, '/' - 63, 'A', 0, 0);
+  __m128i             r;
+
+  /* 0..25 map to 13, 26..51 to 0 and 52..63 to 1..12 */
+  r = _mm_subs_epu8 (indices, _mm_set1_epi8 (51));
+  r = _mm_or_si128 (r, _mm_and_si128 (_mm_cmpgt_epi8 (_mm_set1_epi8 (26),
+                                                      indices),
+                                      _mm_set1_epi8 (13)));
+  return _mm_add_epi8 (indices, _mm_shuffle_epi8 (shift, r));
 }
 
-void
-sc_io_encode_zlib (sc_array_t *data, sc_array_t *out,
-                   int zlib_compression_level, int line_break_character)
+/** Spread 12 bytes in the low 16 of a vector into 16 six-bit values. */
+static inline __m128i
+sc_io_base64_split_sse (__m128i in)
 {
-  int                 i;
-  size_t              input_size;
-#ifndef SC_HAVE_ZLIB
-  size_t              input_compress_bound;
-#else
-  int                 zrv;
-  uLong               input_compress_bound;
+  __m128i             t0, t1;
+
+  in = _mm_shuffle_epi8 (in, _mm_setr_epi8 (1, 0, 2, 1, 4, 3, 5, 4,
+                                            7, 6, 8, 7, 10, 9, 11, 10));
+  t0 = _mm_mulhi_epu16 (_mm_and_si128 (in, _mm_set1_epi32 (0x0fc0fc00)),
+                        _mm_set1_epi32 (0x04000040));
+  t1 = _mm_mullo_epi16 (_mm_and_si128 (in, _mm_set1_epi32 (0x003f03f0)),
+                        _mm_set1_epi32 (0x01000010));
+  return _mm_or_si128 (t0, t1);
+}
+
+/** Turn 16 base 64 characters into six-bit values.
+ * \return          Nonzero if a character is invalid or padding.
+ */
+static inline int
+sc_io_base64_values_sse (__m128i *str)
+{
+  const __m128i       lut_lo = _mm_setr_epi8
+    (0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11,
+     0x11, 0x11, 0x13, 0x1a, 0x1b, 0x1b, 0x1b, 0x1a);
+  const __m128i       lut_hi = _mm_setr_epi8
+    (0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08,
+     0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10);
+  const __m128i       lut_roll = _mm_setr_epi8
+    (0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0);
+  const __m128i       mask = _mm_set1_epi8 (0x2f);
+  __m128i             hi_nibbles, lo_nibbles, bad;
+
+  hi_nibbles = _mm_and_si128 (_mm_srli_epi32 (*str, 4), mask);
+  lo_nibbles = _mm_and_si128 (*str, mask);
+  bad = _mm_and_si128 (_mm_shuffle_epi8 (lut_lo, lo_nibbles),
+                       _mm_shuffle_epi8 (lut_hi, hi_nibbles));
+  if (_mm_movemask_epi8 (_mm_cmpeq_epi8 (bad, _mm_setzero_si128 ()))
+      != 0xffff) {
+    return 1;
+  }
+  hi_nibbles = _mm_add_epi8 (hi_nibbles, _mm_cmpeq_epi8 (*str, mask));
+  *str = _mm_add_epi8 (*str, _mm_shuffle_epi8 (lut_roll, hi_nibbles));
+  return 0;
+}
+
+/** Pack 16 six-bit values into 12 bytes in the low part of a vector. */
+static inline __m128i
+sc_io_base64_merge_sse (__m128i values)
+{
+  values = _mm_maddubs_epi16 (values, _mm_set1_epi32 (0x01400140));
+  values = _mm_madd_epi16 (values, _mm_set1_epi32 (0x00011000));
+  return _mm_shuffle_epi8 (values, _mm_setr_epi8 (2, 1, 0, 6, 5, 4, 10, 9,
+                                                  8, 14, 13, 12, -1, -1, -1,
+                                                  -1));
+}
+
+/** Store the low 12 bytes of a vector. */
+static inline void
+sc_io_base64_store12_sse (char *out, __m128i v)
+{
+  int                 last = _mm_cvtsi128_si32 (_mm_srli_si128 (v, 8));
+
+  _mm_storel_epi64 ((__m128i *) out, v);
+  memcpy (out + 8, &last, 4);
+}
+
+#endif /* SC_IO_BASE64_AVX2 || SC_IO_BASE64_SSSE3 */
+
+#ifdef SC_IO_BASE64_NEON
+
+/** Build the four lookup registers of one half of a 128 entry table. */
+static inline uint8x16x4_t
+sc_io_base64_table_neon (const uint8_t *table)
+{
+  uint8x16x4_t        t;
+
+  t.val[0] = vld1q_u8 (table);
+  t.val[1] = vld1q_u8 (table + 16);
+  t.val[2] = vld1q_u8 (table + 32);
+  t.val[3] = vld1q_u8 (table + 48);
+  return t;
+}
+
+#endif /* SC_IO_BASE64_NEON */
+
+/** Encode bytes to base 64 with padding and without line breaks.
+ * The output is not NUL-terminated.
+ * \return          The number of characters written, 4 * ceil (n / 3).
+ */
+static size_t
+sc_io_base64_encode_block (const char *input, size_t n, char *output)
+{
+  const unsigned char *in = (const unsigned char *) input;
+  char               *out = output;
+  size_t              zz = 0;
+  uint32_t            triple;
+
+#if defined SC_IO_BASE64_AVX2
+  /* each 128-bit lane encodes 12 bytes, loaded from two overlapping
+   * 16 byte windows */
+  for (; zz + 28 <= n; zz += 24, out += 32) {
+    __m256i             v, t0, t1, r;
+    const __m256i       shift = _mm256_setr_epi8
+      ('a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+       '0' - 52, '0' - 52, '0' - 52, '0' - 52, '+' - 62, '/' - 63, 'A', 0, 0,
+       'a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+       '0' - 52, '0' - 52, '0' - 52, '0' - 52, '+' - 62, '/' - 63, 'A', 0, 0);
+
+    v = _mm256_inserti128_si256
+      (_mm256_castsi128_si256 (_mm_loadu_si128 ((const __m128i *) (in + zz))),
+       _mm_loadu_si128 ((const __m128i *) (in + zz + 12)), 1);
+    v = _mm256_shuffle_epi8 (v, _mm256_setr_epi8
+                             (1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11,
+                              10, 1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9,
+                              11, 10));
+    t0 = _mm256_mulhi_epu16 (_mm256_and_si256
+                             (v, _mm256_set1_epi32 (0x0fc0fc00)),
+                             _mm256_set1_epi32 (0x04000040));
+    t1 = _mm256_mullo_epi16 (_mm256_and_si256
+                             (v, _mm256_set1_epi32 (0x003f03f0)),
+                             _mm256_set1_epi32 (0x01000010));
+    v = _mm256_or_si256 (t0, t1);
+    r = _mm256_subs_epu8 (v, _mm256_set1_epi8 (51));
+    r = _mm256_or_si256 (r, _mm256_and_si256
+                         (_mm256_cmpgt_epi8 (_mm256_set1_epi8 (26), v),
+                          _mm256_set1_epi8 (13)));
+    v = _mm256_add_epi8 (v, _mm256_shuffle_epi8 (shift, r));
+    _mm256_storeu_si256 ((__m256i *) out, v);
+  }
 #endif
-  char               *ipos, *opos;
-  char                base_out[2 * SC_IO_LBC];
-  size_t              base64_lines;
-  size_t              encoded_size;
-  size_t              zlin, irem;
-#ifdef SC_ENABLE_DEBUG
-  size_t              ocnt;
+#if defined SC_IO_BASE64_AVX2 || defined SC_IO_BASE64_SSSE3
+  for (; zz + 16 <= n; zz += 12, out += 16) {
+    __m128i             v;
+
+    v = _mm_loadu_si128 ((const __m128i *) (in + zz));
+    v = sc_io_base64_translate_sse (sc_io_base64_split_sse (v));
+    _mm_storeu_si128 ((__m128i *) out, v);
+  }
+#elif defined SC_IO_BASE64_NEON
+  if (n >= 48) {
+    uint8x16x4_t        table, o;
+    uint8x16x3_t        s;
+    const uint8x16_t    m3 = vdupq_n_u8 (3), m15 = vdupq_n_u8 (15);
+    const uint8x16_t    m63 = vdupq_n_u8 (63);
+
+    table = sc_io_base64_table_neon ((const uint8_t *) sc_io_base64_chars);
+    for (; zz + 48 <= n; zz += 48, out += 64) {
+      s = vld3q_u8 (in + zz);
+      o.val[0] = vshrq_n_u8 (s.val[0], 2);
+      o.val[1] = vorrq_u8 (vshlq_n_u8 (vandq_u8 (s.val[0], m3), 4),
+                           vshrq_n_u8 (s.val[1], 4));
+      o.val[2] = vorrq_u8 (vshlq_n_u8 (vandq_u8 (s.val[1], m15), 2),
+                           vshrq_n_u8 (s.val[2], 6));
+      o.val[3] = vandq_u8 (s.val[2], m63);
+      o.val[0] = vqtbl4q_u8 (table, o.val[0]);
+      o.val[1] = vqtbl4q_u8 (table, o.val[1]);
+      o.val[2] = vqtbl4q_u8 (table, o.val[2]);
+      o.val[3] = vqtbl4q_u8 (table, o.val[3]);
+      vst4q_u8 ((uint8_t *) out, o);
+    }
+  }
 #endif
-  unsigned char       original_size[SC_IO_ENCODE_INFO_LEN];
-  sc_array_t          compressed;
-  base64_encodestate  bstate;
 
-  SC_ASSERT (data != NULL);
-  if (out == NULL) {
-    /* in-place operation on string */
-    SC_ASSERT (SC_ARRAY_IS_OWNER (data));
-    SC_ASSERT (data->elem_size == 1);
+  /* the remaining full groups and the padded tail */
+  for (; zz + 3 <= n; zz += 3, out += 4) {
+    triple = ((uint32_t) in[zz] << 16) | ((uint32_t) in[zz + 1] << 8) |
+      in[zz + 2];
+    out[0] = sc_io_base64_chars[triple >> 18];
+    out[1] = sc_io_base64_chars[(triple >> 12) & 0x3f];
+    out[2] = sc_io_base64_chars[(triple >> 6) & 0x3f];
+    out[3] = sc_io_base64_chars[triple & 0x3f];
   }
-  else {
-    /* data is placed in output string */
-    SC_ASSERT (SC_ARRAY_IS_OWNER (out));
-    SC_ASSERT (out->elem_size == 1);
+  if (zz < n) {
+    triple = (uint32_t) in[zz] << 16;
+    if (zz + 1 < n) {
+      triple |= (uint32_t) in[zz + 1] << 8;
+    }
+    out[0] = sc_io_base64_chars[triple >> 18];
+    out[1] = sc_io_base64_chars[(triple >> 12) & 0x3f];
+    out[2] = zz + 1 < n ? sc_io_base64_chars[(triple >> 6) & 0x3f] : '=';
+    out[3] = '=';
+    out += 4;
+  }
+  return (size_t) (out - output);
+}
+
+/** Decode base 64 characters without line breaks.
+ * Padding ends the data, and a missing padding is accepted.
+ * \param [out] output_size     The number of bytes written.
+ * \return          0 on success, -1 on an invalid character or length.
+ */
+static int
+sc_io_base64_decode_block (const char *input, size_t n, char *output,
+                           size_t *output_size)
+{
+  const unsigned char *in = (const unsigned char *) input;
+  char               *out = output;
+  size_t              zz = 0, k;
+  int                 v, count;
+  uint32_t            quad;
+
+#if defined SC_IO_BASE64_AVX2
+  for (; zz + 32 <= n; zz += 32, out += 24) {
+    const __m256i       lut_lo = _mm256_setr_epi8
+      (0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11,
+       0x11, 0x11, 0x13, 0x1a, 0x1b, 0x1b, 0x1b, 0x1a,
+       0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11,
+       0x11, 0x11, 0x13, 0x1a, 0x1b, 0x1b, 0x1b, 0x1a);
+    const __m256i       lut_hi = _mm256_setr_epi8
+      (0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08,
+       0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10,
+       0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08,
+       0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10);
+    const __m256i       lut_roll = _mm256_setr_epi8
+      (0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0,
+       0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0);
+    const __m256i       mask = _mm256_set1_epi8 (0x2f);
+    __m256i             str, hi_nibbles, lo_nibbles, lo, hi;
+
+    str = _mm256_loadu_si256 ((const __m256i *) (in + zz));
+    hi_nibbles = _mm256_and_si256 (_mm256_srli_epi32 (str, 4), mask);
+    lo_nibbles = _mm256_and_si256 (str, mask);
+    lo = _mm256_shuffle_epi8 (lut_lo, lo_nibbles);
+    hi = _mm256_shuffle_epi8 (lut_hi, hi_nibbles);
+    if (!_mm256_testz_si256 (lo, hi)) {
+      /* leave padding and errors to the scalar loop */
+      break;
+    }
+    hi_nibbles = _mm256_add_epi8 (hi_nibbles,
+                                  _mm256_cmpeq_epi8 (str, mask));
+    str = _mm256_add_epi8 (str, _mm256_shuffle_epi8 (lut_roll, hi_nibbles));
+    str = _mm256_maddubs_epi16 (str, _mm256_set1_epi32 (0x01400140));
+    str = _mm256_madd_epi16 (str, _mm256_set1_epi32 (0x00011000));
+    str = _mm256_shuffle_epi8 (str, _mm256_setr_epi8
+                               (2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12,
+                                -1, -1, -1, -1, 2, 1, 0, 6, 5, 4, 10, 9, 8,
+                                14, 13, 12, -1, -1, -1, -1));
+    _mm_storeu_si128 ((__m128i *) out, _mm256_castsi256_si128 (str));
+    sc_io_base64_store12_sse (out + 12, _mm256_extracti128_si256 (str, 1));
   }
-  SC_ASSERT (-1 <= zlib_compression_level && zlib_compression_level <= 9);
-#ifdef SC_HAVE_ZLIB
-  SC_ASSERT (zlib_compression_level == Z_DEFAULT_COMPRESSION ||
-             (zlib_compression_level >= 0 && zlib_compression_level <= 9));
 #endif
+#if defined SC_IO_BASE64_AVX2 || defined SC_IO_BASE64_SSSE3
+  for (; zz + 16 <= n; zz += 16, out += 12) {
+    __m128i             str;
 
-  /* save original size to output */
-  input_size = data->elem_count * data->elem_size;
-  for (i = 0; i < 8; ++i) {
-    /* enforce big endian byte order for original size */
-    original_size[i] = (input_size >> ((7 - i) * 8)) & 0xFF;
+    str = _mm_loadu_si128 ((const __m128i *) (in + zz));
+    if (sc_io_base64_values_sse (&str)) {
+      break;
+    }
+    sc_io_base64_store12_sse (out, sc_io_base64_merge_sse (str));
+  }
+#elif defined SC_IO_BASE64_NEON
+  if (n >= 64) {
+    uint8x16x4_t        table_lo, table_hi, s;
+    uint8x16x3_t        o;
+    const uint8x16_t    c64 = vdupq_n_u8 (64), c128 = vdupq_n_u8 (128);
+    uint8_t             values[128];
+    uint8x16_t          bad;
+
+    /* invalid characters and padding map to 0xff */
+    for (k = 0; k < 128; ++k) {
+      values[k] = (uint8_t) sc_io_base64_values[k];
+    }
+    table_lo = sc_io_base64_table_neon (values);
+    table_hi = sc_io_base64_table_neon (values + 64);
+    for (; zz + 64 <= n; zz += 64, out += 48) {
+      s = vld4q_u8 (in + zz);
+      bad = vdupq_n_u8 (0);
+      for (k = 0; k < 4; ++k) {
+        bad = vorrq_u8 (bad, vandq_u8 (s.val[k], c128));
+        s.val[k] = vqtbx4q_u8 (vqtbl4q_u8 (table_lo, s.val[k]), table_hi,
+                               vsubq_u8 (s.val[k], c64));
+        bad = vorrq_u8 (bad, s.val[k]);
+      }
+      if (vmaxvq_u8 (bad) > 63) {
+        break;
+      }
+      o.val[0] = vorrq_u8 (vshlq_n_u8 (s.val[0], 2),
+                           vshrq_n_u8 (s.val[1], 4));
+      o.val[1] = vorrq_u8 (vshlq_n_u8 (s.val[1], 4),
+                           vshrq_n_u8 (s.val[2], 2));
+      o.val[2] = vorrq_u8 (vshlq_n_u8 (s.val[2], 6), s.val[3]);
+      vst3q_u8 ((uint8_t *) out, o);
+    }
   }
-  original_size[SC_IO_ENCODE_INFO_LEN - 1] = 'z';
+#endif
 
-  /* zlib compress input */
-#ifndef SC_HAVE_ZLIB
-  input_compress_bound = sc_io_noncompress_bound (input_size);
-#else
-  input_compress_bound = compressBound ((uLong) input_size);
-#endif /* SC_HAVE_ZLIB */
-  sc_array_init_count (&compressed, 1,
-                       SC_IO_ENCODE_INFO_LEN + input_compress_bound);
-  memcpy (compressed.array, original_size, SC_IO_ENCODE_INFO_LEN);
-#ifndef SC_HAVE_ZLIB
-  sc_io_noncompress (compressed.array + SC_IO_ENCODE_INFO_LEN,
-                     input_compress_bound, data->array, input_size);
-#else
-  zrv = compress2 ((Bytef *) compressed.array + SC_IO_ENCODE_INFO_LEN,
-                   &input_compress_bound, (Bytef *) data->array,
-                   (uLong) input_size, zlib_compression_level);
-  SC_CHECK_ABORT (zrv == Z_OK, "Error on zlib compression");
-#endif /* SC_HAVE_ZLIB */
+  /* the scalar loop handles the tail, padding and errors */
+  quad = 0;
+  count = 0;
+  for (; zz < n; ++zz) {
+    v = in[zz] < 128 ? sc_io_base64_values[in[zz]] : -2;
+    if (v == -2) {
+      return -1;
+    }
+    if (v == -1) {
+      break;
+    }
+    quad = (quad << 6) | (uint32_t) v;
+    if (++count == 4) {
+      out[0] = (char) (quad >> 16);
+      out[1] = (char) (quad >> 8);
+      out[2] = (char) quad;
+      out += 3;
+      quad = 0;
+      count = 0;
+    }
+  }
+  if (count == 1) {
+    return -1;
+  }
+  if (count > 1) {
+    quad <<= 6 * (4 - count);
+    out[0] = (char) (quad >> 16);
+    if (count == 3) {
+      out[1] = (char) (quad >> 8);
+    }
+    out += count - 1;
+  }
 
-  /* prepare output array */
-  if (out == NULL) {
-    out = data;
+  /* the padding may only be followed by padding */
+  for (k = zz; k < n; ++k) {
+    if (in[k] != '=') {
+      return -1;
+    }
   }
-  SC_ASSERT (out->elem_size == 1);
-  input_size = (size_t) (SC_IO_ENCODE_INFO_LEN + input_compress_bound);
-  base64_lines = (input_size + SC_IO_DBC - 1) / SC_IO_DBC;
-  encoded_size = 4 * ((input_size + 2) / 3) + 2 * base64_lines + 1;
-  sc_array_resize (out, encoded_size);
+  *output_size = (size_t) (out - output);
+  return 0;
+}
 
-  /* run base64 encoder */
-  base64_init_encodestate (&bstate);
-  ipos = compressed.array;
-  irem = input_size;
-  opos = out->array;
-#ifdef SC_ENABLE_DEBUG
-  ocnt = 0;
-#endif
-  SC_ASSERT (ocnt + 1 <= encoded_size);
-  opos[0] = '\0';
-  for (zlin = 0; zlin < base64_lines; ++zlin) {
-    size_t              lein = SC_MIN (irem, SC_IO_DBC);
-    size_t              lout =
-      base64_encode_block (ipos, lein, base_out, &bstate);
+/** Minimum number of base 64 lines per thread. */
+#define SC_IO_BASE64_LINES_MIN 1024
+
+/** State shared by the threads of a base 64 encode or decode.
+ * Each line of SC_IO_DBC data bytes is coded independently. */
+typedef struct sc_io_base64
+{
+  const char         *input;
+  size_t              input_size;       /**< Data bytes or code chars. */
+  char               *output;
+  size_t              num_lines;
+  int                 line_break_character;
+  size_t              final_size;       /**< Decoded bytes of last line. */
+  int                *errors;   /**< First decode error of each thread. */
+}
+sc_io_base64_t;
 
+static void
+sc_io_base64_encode_lines (int thread_id, int num_threads, void *user)
+{
+  sc_io_base64_t     *bt = (sc_io_base64_t *) user;
+  const size_t        lines = bt->num_lines;
+  size_t              zlin, end, lein, lout;
+  char               *opos;
+
+  zlin = lines * (size_t) thread_id / (size_t) num_threads;
+  end = lines * (size_t) (thread_id + 1) / (size_t) num_threads;
+  for (; zlin < end; ++zlin) {
+    lein = SC_MIN (bt->input_size - zlin * SC_IO_DBC, SC_IO_DBC);
+    opos = bt->output + zlin * SC_IO_LBE;
     SC_ASSERT (lein > 0);
-    if (zlin < base64_lines - 1) {
+
+    /* a full line has no padding, so each line is coded on its own */
+    lout = sc_io_base64_encode_block (bt->input + zlin * SC_IO_DBC, lein,
+                                      opos);
+    if (zlin < lines - 1) {
       /* not the final line */
-      SC_ASSERT (irem > SC_IO_DBC);
       SC_ASSERT (lout == SC_IO_LBC);
-      SC_ASSERT (ocnt + SC_IO_LBF <= encoded_size);
-      memcpy (opos, base_out, SC_IO_LBC);
-      opos[SC_IO_LBC] = (char) line_break_character;
-      opos[SC_IO_LBD] = '\n';
-      opos[SC_IO_LBE] = '\0';
-      opos += SC_IO_LBE;
-#ifdef SC_ENABLE_DEBUG
-      ocnt += SC_IO_LBE;
-#endif
-      ipos += SC_IO_DBC;
-      irem -= SC_IO_DBC;
     }
     else {
       /* the final line */
-      SC_ASSERT (irem <= SC_IO_DBC);
       SC_ASSERT (lout <= SC_IO_LBC);
-      SC_ASSERT (ocnt + lout <= encoded_size);
-      memcpy (opos, base_out, lout);
-      opos += lout;
-#ifdef SC_ENABLE_DEBUG
-      ocnt += lout;
-#endif
-      lout = base64_encode_blockend (base_out, &bstate);
-      SC_ASSERT (lout <= 4);
-      SC_ASSERT (ocnt + lout <= encoded_size);
-      memcpy (opos, base_out, lout);
-      opos += lout;
-#ifdef SC_ENABLE_DEBUG
-      ocnt += lout;
-#endif
-      SC_ASSERT (ocnt + 3 <= encoded_size);
-      opos[0] = (char) line_break_character;
-      opos[1] = '\n';
-      opos[2] = '\0';
-      opos = NULL;
-#ifdef SC_ENABLE_DEBUG
-      ocnt += 3;
-#endif
-      SC_ASSERT (ocnt == encoded_size);
-      ipos = NULL;
-      irem = 0;
+      opos[lout + 2] = '\0';
     }
+    opos[lout] = (char) bt->line_break_character;
+    opos[lout + 1] = '\n';
   }
-
-  /* free temporary memory */
-  sc_array_reset (&compressed);
 }
 
-int
-sc_io_decode_info (sc_array_t *data, size_t *original_size,
-                   char *format_char, void *re)
+/** Encode data to base 64 lines with line breaks and a final NUL. */
+static void
+sc_io_encode_base64 (const char *input, size_t input_size, sc_array_t *out,
+                     int line_break_character, int num_threads)
 {
-  int                 i;
-  size_t              osize;
-  char                dec[12];
-  base64_decodestate  bstate;
+  size_t              encoded_size, T;
+  sc_io_base64_t      bt;
 
-  /* in the future we will add runtime error reporting */
-  SC_ASSERT (re == NULL);
+  SC_ASSERT (input_size > 0);
+  SC_ASSERT (out->elem_size == 1);
 
-  /* basic checks */
-  SC_ASSERT (SC_IO_ENCODE_INFO_LEN == 9);
-  SC_ASSERT (data != NULL);
-  SC_ASSERT (data->elem_size == 1);
-  if (data->elem_count < 12) {
-    SC_LERROR ("sc_io_decode_info requires >= 12 bytes of input\n");
-    return -1;
-  }
+  bt.input = input;
+  bt.input_size = input_size;
+  bt.num_lines = (input_size + SC_IO_DBC - 1) / SC_IO_DBC;
+  bt.line_break_character = line_break_character;
+  encoded_size = 4 * ((input_size + 2) / 3) + 2 * bt.num_lines + 1;
+  sc_array_resize (out, encoded_size);
+  bt.output = out->array;
 
-  /* decode first 12 characters of encoded data */
-  memset (dec, 0, 12);
-  base64_init_decodestate (&bstate);
-  osize = base64_decode_block (data->array, 12, dec, &bstate);
-  if (osize != 9) {
-    SC_LERROR ("sc_io_decode_info base 64 error\n");
-    return -1;
+  T = (size_t) SC_MAX (num_threads, 1);
+  T = SC_MIN (T, bt.num_lines / SC_IO_BASE64_LINES_MIN);
+  if (T <= 1) {
+    sc_io_base64_encode_lines (0, 1, &bt);
   }
-
-#if 0
-  /* verify first byte for zlib format */
-  if (dec[8] != 'z') {
-    SC_LERROR ("sc_io_decode_info data format error\n");
-    return -1;
+  else {
+    sc_thread_fork_join ((int) T, sc_io_base64_encode_lines, &bt);
   }
-#endif
+  SC_ASSERT (out->array[encoded_size - 1] == '\0');
+}
 
-  /* decode original length of data */
-  if (original_size != NULL) {
-    unsigned char       uc;
-    osize = 0;
-    for (i = 0; i < 8; ++i) {
-      /* read original byte order in big endian */
-      uc = (unsigned char) dec[i];
-      osize |= ((size_t) uc) << ((7 - i) * 8);
+static void
+sc_io_base64_decode_lines (int thread_id, int num_threads, void *user)
+{
+  sc_io_base64_t     *bt = (sc_io_base64_t *) user;
+  const size_t        lines = bt->num_lines;
+  size_t              zlin, end, lein, lout;
+
+  zlin = lines * (size_t) thread_id / (size_t) num_threads;
+  end = lines * (size_t) (thread_id + 1) / (size_t) num_threads;
+  for (; zlin < end; ++zlin) {
+    lein = SC_MIN (bt->input_size - zlin * SC_IO_LBC, SC_IO_LBC);
+    SC_ASSERT (lein > 0);
+    if (sc_io_base64_decode_block (bt->input + zlin * SC_IO_LBE, lein,
+                                   bt->output + zlin * SC_IO_DBC, &lout)
+        || lout == 0) {
+      bt->errors[thread_id] = 1;
+      return;
     }
-    *original_size = osize;
+    if (zlin < lines - 1) {
+      SC_ASSERT (lein == SC_IO_LBC);
+      if (lout != SC_IO_DBC) {
+        bt->errors[thread_id] = 2;
+        return;
+      }
+    }
+    else {
+      SC_ASSERT (lout <= SC_IO_DBC);
+      bt->final_size = lout;
+    }
+  }
+}
+
+/** Decode the base 64 lines of encoded data into an initialized array.
+ * \return          0 on success, -1 on error.
+ */
+static int
+sc_io_decode_base64 (sc_array_t *data, sc_array_t *decoded, size_t *ocnt,
+                     int num_threads)
+{
+  const size_t        encoded_size = data->elem_count;
+  size_t              T, t;
+  int                 error;
+  sc_io_base64_t      bt;
+
+  SC_ASSERT (encoded_size > 0);
+  bt.num_lines = (encoded_size - 1 + SC_IO_LBD) / SC_IO_LBE;
+  if (encoded_size - 1 < 2 * bt.num_lines) {
+    SC_LERROR ("base 64 decode short\n");
+    return -1;
+  }
+  bt.input = data->array;
+  bt.input_size = encoded_size - 1 - 2 * bt.num_lines;
+  sc_array_resize (decoded, bt.num_lines * SC_IO_DBC);
+  bt.output = decoded->array;
+  bt.final_size = 0;
+
+  T = (size_t) SC_MAX (num_threads, 1);
+  T = SC_MAX (SC_MIN (T, bt.num_lines / SC_IO_BASE64_LINES_MIN), 1);
+  bt.errors = SC_ALLOC_ZERO (int, T);
+  if (T == 1) {
+    sc_io_base64_decode_lines (0, 1, &bt);
+  }
+  else {
+    sc_thread_fork_join ((int) T, sc_io_base64_decode_lines, &bt);
+  }
+  for (error = 0, t = 0; t < T && !error; ++t) {
+    error = bt.errors[t];
+  }
+  SC_FREE (bt.errors);
+  if (error == 1) {
+    SC_LERROR ("base 64 decode short\n");
+    return -1;
+  }
+  if (error == 2) {
+    SC_LERROR ("base 64 decode mismatch\n");
+    return -1;
+  }
+
+  *ocnt = (bt.num_lines - 1) * SC_IO_DBC + bt.final_size;
+  SC_ASSERT (*ocnt <= decoded->elem_count);
+  return 0;
+}
+
+/** Return an upper bound on the compressed size of some data. */
+static size_t
+sc_io_compress_bound (size_t length)
+{
+#ifndef SC_HAVE_ZLIB
+  return sc_io_noncompress_bound (length);
+#else
+  return (size_t) compressBound ((uLong) length);
+#endif
+}
+
+/** Write data in zlib format.
+ * \param [in,out] dest_size    On input the bound for the length,
+ *                              on output the length written.
+ */
+static void
+sc_io_compress_block (char *dest, size_t *dest_size,
+                      const char *src, size_t src_size,
+                      int zlib_compression_level)
+{
+#ifndef SC_HAVE_ZLIB
+  SC_ASSERT (*dest_size == sc_io_noncompress_bound (src_size));
+  *dest_size = sc_io_noncompress (dest, *dest_size, src, src_size,
+                                  zlib_compression_level);
+#else
+  int                 zrv;
+  uLong               bound = (uLong) * dest_size;
+
+  zrv = compress2 ((Bytef *) dest, &bound, (const Bytef *) src,
+                   (uLong) src_size, zlib_compression_level);
+  SC_CHECK_ABORT (zrv == Z_OK, "Error on zlib compression");
+  *dest_size = (size_t) bound;
+#endif
+}
+
+/** Uncompress zlib format data of known uncompressed length.
+ * \return          0 on success, -1 on error.
+ */
+static int
+sc_io_uncompress_block (char *dest, size_t dest_size,
+                        const char *src, size_t src_size)
+{
+#ifndef SC_HAVE_ZLIB
+  return sc_io_nonuncompress (dest, dest_size, src, src_size, NULL);
+#else
+  uLong               uncompsize = (uLong) dest_size;
+
+  if (uncompress ((Bytef *) dest, &uncompsize, (const Bytef *) src,
+                  (uLong) src_size) != Z_OK ||
+      uncompsize != (uLong) dest_size) {
+    return -1;
+  }
+  return 0;
+#endif
+}
+
+/** Write a 64-bit number in big endian byte order. */
+static void
+sc_io_put_be64 (char *dest, uint64_t value)
+{
+  int                 i;
+
+  for (i = 0; i < 8; ++i) {
+    dest[i] = (char) ((value >> ((7 - i) * 8)) & 0xFF);
+  }
+}
+
+/** Read a 64-bit number in big endian byte order. */
+static uint64_t
+sc_io_get_be64 (const char *src)
+{
+  int                 i;
+  uint64_t            value = 0;
+
+  for (i = 0; i < 8; ++i) {
+    value |= ((uint64_t) (unsigned char) src[i]) << ((7 - i) * 8);
+  }
+  return value;
+}
+
+/** State shared by the threads compressing or uncompressing blocks. */
+typedef struct sc_io_blocks
+{
+  char               *data;    /**< The uncompressed data. */
+  size_t              data_size;
+  char               *packed;   /**< The compressed blocks. */
+  size_t              block_size;
+  size_t              num_blocks;
+  size_t              bound;    /**< Compressed bound of one block. */
+  size_t             *sizes;    /**< Compressed size of each block. */
+  size_t             *offsets;  /**< Compressed offset of each block. */
+  int                 level;
+  int                *errors;   /**< Uncompression error of each block. */
+}
+sc_io_blocks_t;
+
+static void
+sc_io_blocks_compress (int thread_id, int num_threads, void *user)
+{
+  sc_io_blocks_t     *bt = (sc_io_blocks_t *) user;
+  size_t              b, lo, len;
+
+  for (b = (size_t) thread_id; b < bt->num_blocks;
+       b += (size_t) num_threads) {
+    lo = b * bt->block_size;
+    len = SC_MIN (bt->block_size, bt->data_size - lo);
+    bt->sizes[b] = sc_io_compress_bound (len);
+    sc_io_compress_block (bt->packed + b * bt->bound, &bt->sizes[b],
+                          bt->data + lo, len, bt->level);
+  }
+}
+
+static void
+sc_io_blocks_uncompress (int thread_id, int num_threads, void *user)
+{
+  sc_io_blocks_t     *bt = (sc_io_blocks_t *) user;
+  size_t              b, lo, len;
+
+  for (b = (size_t) thread_id; b < bt->num_blocks;
+       b += (size_t) num_threads) {
+    lo = b * bt->block_size;
+    len = SC_MIN (bt->block_size, bt->data_size - lo);
+    bt->errors[b] = sc_io_uncompress_block (bt->data + lo, len,
+                                            bt->packed + bt->offsets[b],
+                                            bt->sizes[b]);
+  }
+}
+
+void
+sc_io_encode (sc_array_t *data, sc_array_t *out)
+{
+  sc_io_encode_zlib (data, out, Z_BEST_COMPRESSION, '=');
+}
+
+void
+sc_io_encode_zlib (sc_array_t *data, sc_array_t *out,
+                   int zlib_compression_level, int line_break_character)
+{
+  sc_io_encode_ext (data, out, zlib_compression_level, line_break_character,
+                    SC_IO_CHECKSUM_ADLER32);
+}
+
+/** Check the arguments common to the encode functions. */
+static void
+sc_io_encode_check (sc_array_t *data, sc_array_t *out,
+                    int zlib_compression_level)
+{
+  SC_ASSERT (data != NULL);
+  if (out == NULL) {
+    /* in-place operation on string */
+    SC_ASSERT (SC_ARRAY_IS_OWNER (data));
+    SC_ASSERT (data->elem_size == 1);
+  }
+  else {
+    /* data is placed in output string */
+    SC_ASSERT (SC_ARRAY_IS_OWNER (out));
+    SC_ASSERT (out->elem_size == 1);
+  }
+  SC_ASSERT (-1 <= zlib_compression_level && zlib_compression_level <= 9);
+#ifdef SC_HAVE_ZLIB
+  SC_ASSERT (zlib_compression_level == Z_DEFAULT_COMPRESSION ||
+             (zlib_compression_level >= 0 && zlib_compression_level <= 9));
+#endif
+}
+
+void
+sc_io_encode_ext (sc_array_t *data, sc_array_t *out,
+                  int zlib_compression_level, int line_break_character,
+                  int checksum)
+{
+  int                 i;
+  size_t              input_size, checksum_size;
+  size_t              input_compress_bound;
+  uint32_t            crc;
+  sc_array_t          compressed;
+
+  sc_io_encode_check (data, out, zlib_compression_level);
+  SC_ASSERT (checksum == SC_IO_CHECKSUM_ADLER32 ||
+             checksum == SC_IO_CHECKSUM_CRC32C);
+
+  /* allocate output of header information and compressed data */
+  input_size = data->elem_count * data->elem_size;
+  input_compress_bound = sc_io_compress_bound (input_size);
+  checksum_size = checksum == SC_IO_CHECKSUM_CRC32C ? 4 : 0;
+  sc_array_init_count (&compressed, 1, SC_IO_ENCODE_INFO_LEN +
+                       input_compress_bound + checksum_size);
+
+  /* save original size to output in big endian byte order */
+  sc_io_put_be64 (compressed.array, (uint64_t) input_size);
+  if (checksum_size > 0) {
+    /* checksum the input before it may be overwritten in place */
+    compressed.array[SC_IO_ENCODE_INFO_LEN - 1] = 'C';
+    crc = sc_io_crc32c (0, data->array, input_size);
+  }
+  else {
+    compressed.array[SC_IO_ENCODE_INFO_LEN - 1] = 'z';
+    crc = 0;
+  }
+
+  /* zlib compress input */
+  sc_io_compress_block (compressed.array + SC_IO_ENCODE_INFO_LEN,
+                        &input_compress_bound, data->array, input_size,
+                        zlib_compression_level);
+
+  /* append the optional checksum of the original data in big endian */
+  for (i = 0; i < (int) checksum_size; ++i) {
+    compressed.array[SC_IO_ENCODE_INFO_LEN + input_compress_bound + i] =
+      (char) ((crc >> ((3 - i) * 8)) & 0xFF);
+  }
+
+  /* run base64 encoder */
+  if (out == NULL) {
+    out = data;
+  }
+  sc_io_encode_base64 (compressed.array, SC_IO_ENCODE_INFO_LEN +
+                       input_compress_bound + checksum_size, out,
+                       line_break_character, 1);
+
+  /* free temporary memory */
+  sc_array_reset (&compressed);
+}
+
+void
+sc_io_encode_parallel (sc_array_t *data, sc_array_t *out,
+                       int zlib_compression_level, int line_break_character,
+                       size_t block_size, int num_threads)
+{
+  size_t              input_size, header_size, b, pos;
+  sc_io_blocks_t      bt;
+  sc_array_t          compressed;
+
+  sc_io_encode_check (data, out, zlib_compression_level);
+  if (num_threads <= 0) {
+    num_threads = sc_thread_default_count ();
+  }
+  if (block_size == 0) {
+    block_size = SC_IO_ENCODE_BLOCK_SIZE;
+  }
+
+  /* compress the blocks independently */
+  input_size = data->elem_count * data->elem_size;
+  bt.data = data->array;
+  bt.data_size = input_size;
+  bt.block_size = block_size;
+  bt.num_blocks = SC_MAX ((input_size + block_size - 1) / block_size, 1);
+  bt.bound = sc_io_compress_bound (SC_MIN (block_size, input_size));
+  bt.packed = SC_ALLOC (char, bt.num_blocks * bt.bound);
+  bt.sizes = SC_ALLOC (size_t, bt.num_blocks);
+  bt.level = zlib_compression_level;
+  sc_thread_fork_join ((int) SC_MIN ((size_t) num_threads, bt.num_blocks),
+                       sc_io_blocks_compress, &bt);
+
+  /* write the header with the block index and append the blocks */
+  header_size = SC_IO_ENCODE_INFO_LEN + 8 * (1 + bt.num_blocks);
+  for (pos = header_size, b = 0; b < bt.num_blocks; ++b) {
+    pos += bt.sizes[b];
+  }
+  sc_array_init_count (&compressed, 1, pos);
+  sc_io_put_be64 (compressed.array, (uint64_t) input_size);
+  compressed.array[SC_IO_ENCODE_INFO_LEN - 1] = 'B';
+  sc_io_put_be64 (compressed.array + SC_IO_ENCODE_INFO_LEN,
+                  (uint64_t) block_size);
+  for (pos = header_size, b = 0; b < bt.num_blocks; ++b) {
+    sc_io_put_be64 (compressed.array + SC_IO_ENCODE_INFO_LEN + 8 * (1 + b),
+                    (uint64_t) bt.sizes[b]);
+    memcpy (compressed.array + pos, bt.packed + b * bt.bound, bt.sizes[b]);
+    pos += bt.sizes[b];
+  }
+  SC_FREE (bt.packed);
+  SC_FREE (bt.sizes);
+
+  /* run base64 encoder */
+  if (out == NULL) {
+    out = data;
+  }
+  sc_io_encode_base64 (compressed.array, compressed.elem_count, out,
+                       line_break_character, num_threads);
+  sc_array_reset (&compressed);
+}
+
+/** Number of bytes needed for a value, at least one. */
+static inline int
+sc_io_ints_length (uint64_t value)
+{
+  int                 len = 1;
+
+  while (len < 8 && (value >> (8 * len)) != 0) {
+    ++len;
+  }
+  return len;
+}
+
+/** Encode integers as the raw format of \ref sc_io_encode_ints.
+ * \param [in] src          Integers of \a elem_size bytes, any alignment.
+ * \param [in] count        Number of integers.
+ * \param [in] elem_size    Either 4 or 8.
+ * \param [out] out         Resized to the encoded bytes.
+ */
+static void
+sc_io_encode_ints_raw (const char *src, size_t count, size_t elem_size,
+                       sc_array_t *out)
+{
+  size_t              i, per, ncontrol;
+  int                 len, shift;
+  uint32_t            x32, prev32, z32;
+  uint64_t            x64, prev64, z64;
+  unsigned char      *control;
+  char               *dst;
+
+  SC_ASSERT (elem_size == 4 || elem_size == 8);
+  SC_ASSERT (out->elem_size == 1 && SC_ARRAY_IS_OWNER (out));
+
+  /* the codes of four 32-bit or two 64-bit values fill a control byte */
+  per = elem_size == 4 ? 4 : 2;
+  ncontrol = (count + per - 1) / per;
+  sc_array_resize (out, SC_IO_INTS_HEADER + ncontrol + count * elem_size);
+  out->array[0] = (char) elem_size;
+  sc_io_put_be64 (out->array + 1, (uint64_t) count);
+  control = (unsigned char *) out->array + SC_IO_INTS_HEADER;
+  memset (control, 0, ncontrol);
+  dst = (char *) control + ncontrol;
+
+  prev32 = 0;
+  prev64 = 0;
+  for (i = 0; i < count; ++i) {
+    /* store the zigzag encoded difference to the previous value */
+    if (elem_size == 4) {
+      memcpy (&x32, src + 4 * i, 4);
+      z32 = x32 - prev32;
+      z32 = (z32 << 1) ^ (0U - (z32 >> 31));
+      prev32 = x32;
+      z64 = z32;
+      len = sc_io_ints_length (z64);
+      control[i / 4] |= (unsigned char) ((len - 1) << (2 * (i % 4)));
+    }
+    else {
+      memcpy (&x64, src + 8 * i, 8);
+      z64 = x64 - prev64;
+      z64 = (z64 << 1) ^ (0ULL - (z64 >> 63));
+      prev64 = x64;
+      len = sc_io_ints_length (z64);
+      control[i / 2] |= (unsigned char) ((len - 1) << (4 * (i % 2)));
+    }
+    for (shift = 0; shift < len; ++shift) {
+      *dst++ = (char) ((z64 >> (8 * shift)) & 0xFF);
+    }
+  }
+  sc_array_resize (out, (size_t) (dst - out->array));
+}
+
+#ifdef SC_IO_INTS_SSSE3
+
+/** Decode groups of four 32-bit values by byte shuffles.
+ * \param [in] control      One control byte per group.
+ * \param [in,out] src      Encoded data, advanced past the groups.
+ * \param [in] end          End of the encoded data.
+ * \param [out] dst         Room for four values per group.
+ * \param [in] ngroups      Maximum number of groups to decode.
+ * \param [in,out] prev     The value preceding the groups.
+ * \return                  The number of groups decoded.  We stop early
+ *                          before reading beyond 16 bytes from the end.
+ */
+static size_t
+sc_io_decode_ints_ssse3 (const unsigned char *control, const char **src,
+                         const char *end, char *dst, size_t ngroups,
+                         uint32_t *prev)
+{
+  int                 c, j, k, o;
+  size_t              g;
+  unsigned char       lengths[256];
+  unsigned char       masks[256][16];
+  const char         *p = *src;
+  __m128i             v, one, zero, last;
+
+  /* the shuffle masks gather the bytes of each value into its lane */
+  for (c = 0; c < 256; ++c) {
+    for (o = 0, j = 0; j < 4; ++j) {
+      for (k = 0; k < 4; ++k) {
+        masks[c][4 * j + k] = (unsigned char)
+          (k <= ((c >> (2 * j)) & 3) ? o + k : 0xFF);
+      }
+      o += ((c >> (2 * j)) & 3) + 1;
+    }
+    lengths[c] = (unsigned char) o;
+  }
+
+  one = _mm_set1_epi32 (1);
+  zero = _mm_setzero_si128 ();
+  last = _mm_set1_epi32 ((int) *prev);
+  for (g = 0; g < ngroups && end - p >= 16; ++g) {
+    c = control[g];
+    v = _mm_loadu_si128 ((const __m128i *) p);
+    v = _mm_shuffle_epi8 (v, _mm_loadu_si128 ((const __m128i *) masks[c]));
+    p += lengths[c];
+
+    /* undo the zigzag and compute the prefix sum of the differences */
+    v = _mm_xor_si128 (_mm_srli_epi32 (v, 1),
+                       _mm_sub_epi32 (zero, _mm_and_si128 (v, one)));
+    v = _mm_add_epi32 (v, _mm_slli_si128 (v, 4));
+    v = _mm_add_epi32 (v, _mm_slli_si128 (v, 8));
+    v = _mm_add_epi32 (v, last);
+    _mm_storeu_si128 ((__m128i *) (dst + 16 * g), v);
+    last = _mm_shuffle_epi32 (v, 0xFF);
+  }
+  *prev = (uint32_t) _mm_cvtsi128_si32 (last);
+  *src = p;
+  return g;
+}
+
+#endif /* SC_IO_INTS_SSSE3 */
+
+/** Decode the raw format of \ref sc_io_encode_ints.
+ * \param [in] src          The encoded data.
+ * \param [in] size         Length of the encoded data in bytes.
+ * \param [in,out] out      Resized to the decoded data as a byte array of
+ *                          its element size, which must divide it.
+ * \return                  0 on success, -1 on malformed input.
+ */
+static int
+sc_io_decode_ints_raw (const char *src, size_t size, sc_array_t *out)
+{
+  size_t              i, count, elem_size, per, ncontrol, bytes;
+  int                 len, shift;
+  uint32_t            prev32;
+  uint64_t            z64, prev64;
+  const unsigned char *control;
+  const char         *end;
+  char               *dst;
+
+  if (size < SC_IO_INTS_HEADER) {
+    SC_LERROR ("encoded integers lack their header\n");
+    return -1;
+  }
+  elem_size = (size_t) (unsigned char) src[0];
+  count = (size_t) sc_io_get_be64 (src + 1);
+  if ((elem_size != 4 && elem_size != 8) ||
+      count > (size - SC_IO_INTS_HEADER) * (elem_size / 2)) {
+    SC_LERROR ("encoded integer header mismatch\n");
+    return -1;
+  }
+  per = elem_size == 4 ? 4 : 2;
+  ncontrol = (count + per - 1) / per;
+  if (size < SC_IO_INTS_HEADER + ncontrol + count) {
+    SC_LERROR ("encoded integers truncated\n");
+    return -1;
+  }
+  bytes = count * elem_size;
+  if (bytes % out->elem_size != 0) {
+    SC_LERROR ("encoded size not commensurable with output array\n");
+    return -1;
+  }
+  if (!SC_ARRAY_IS_OWNER (out) && bytes > out->elem_count * out->elem_size) {
+    SC_LERROR ("encoded size larger than byte size of view\n");
+    return -1;
+  }
+  sc_array_resize (out, bytes / out->elem_size);
+
+  control = (const unsigned char *) src + SC_IO_INTS_HEADER;
+  src = (const char *) control + ncontrol;
+  end = src - ncontrol - SC_IO_INTS_HEADER + size;
+  dst = out->array;
+  prev32 = 0;
+  prev64 = 0;
+  i = 0;
+#ifdef SC_IO_INTS_SSSE3
+  if (elem_size == 4 && count >= 64) {
+    /* building the shuffle table pays off for longer inputs only */
+    i = 4 * sc_io_decode_ints_ssse3 (control, &src, end, dst, count / 4,
+                                     &prev32);
+  }
+#endif
+  for (; i < count; ++i) {
+    len = elem_size == 4 ? ((control[i / 4] >> (2 * (i % 4))) & 3) + 1 :
+      ((control[i / 2] >> (4 * (i % 2))) & 7) + 1;
+    if (end - src < len) {
+      SC_LERROR ("encoded integers truncated\n");
+      return -1;
+    }
+    z64 = 0;
+    for (shift = 0; shift < len; ++shift) {
+      z64 |= (uint64_t) (unsigned char) *src++ << (8 * shift);
+    }
+    if (elem_size == 4) {
+      prev32 += ((uint32_t) z64 >> 1) ^ (0U - ((uint32_t) z64 & 1));
+      memcpy (dst + 4 * i, &prev32, 4);
+    }
+    else {
+      prev64 += (z64 >> 1) ^ (0ULL - (z64 & 1));
+      memcpy (dst + 8 * i, &prev64, 8);
+    }
+  }
+  if (src != end) {
+    SC_LERROR ("encoded integers have trailing data\n");
+    return -1;
+  }
+  return 0;
+}
+
+void
+sc_io_encode_ints (sc_array_t *data, sc_array_t *out)
+{
+  SC_ASSERT (data != NULL && out != NULL && data != out);
+  SC_ASSERT (data->elem_size == 4 || data->elem_size == 8);
+
+  sc_io_encode_ints_raw (data->array, data->elem_count, data->elem_size,
+                         out);
+}
+
+int
+sc_io_decode_ints (sc_array_t *data, sc_array_t *out)
+{
+  SC_ASSERT (data != NULL && out != NULL && data != out);
+  SC_ASSERT (data->elem_size == 1);
+
+  return sc_io_decode_ints_raw (data->array, data->elem_count, out);
+}
+
+void
+sc_io_encode_ints_zlib (sc_array_t *data, sc_array_t *out,
+                        int zlib_compression_level, int line_break_character)
+{
+  size_t              input_size, packed_size, bound;
+  sc_array_t          packed, compressed;
+
+  sc_io_encode_check (data, out, zlib_compression_level);
+  SC_ASSERT (data->elem_size == 4 || data->elem_size == 8);
+
+  /* the integers are packed before they are compressed */
+  input_size = data->elem_count * data->elem_size;
+  sc_array_init (&packed, 1);
+  sc_io_encode_ints_raw (data->array, data->elem_count, data->elem_size,
+                         &packed);
+  packed_size = packed.elem_count;
+
+  /* the header is followed by the packed size and the zlib data */
+  bound = sc_io_compress_bound (packed_size);
+  sc_array_init_count (&compressed, 1, SC_IO_ENCODE_INFO_LEN + 8 + bound);
+  sc_io_put_be64 (compressed.array, (uint64_t) input_size);
+  compressed.array[SC_IO_ENCODE_INFO_LEN - 1] = 'i';
+  sc_io_put_be64 (compressed.array + SC_IO_ENCODE_INFO_LEN,
+                  (uint64_t) packed_size);
+  sc_io_compress_block (compressed.array + SC_IO_ENCODE_INFO_LEN + 8,
+                        &bound, packed.array, packed_size,
+                        zlib_compression_level);
+  sc_array_reset (&packed);
+
+  if (out == NULL) {
+    out = data;
+  }
+  sc_io_encode_base64 (compressed.array, SC_IO_ENCODE_INFO_LEN + 8 + bound,
+                       out, line_break_character, 1);
+  sc_array_reset (&compressed);
+}
+
+const char         *
+sc_io_ints_kernel (void)
+{
+  return SC_IO_INTS_KERNEL;
+}
+
+#ifdef SC_IO_SHUFFLE_SSE2
+
+/** Interleave the bytes of the first and second half of the registers.
+ * Four rounds transpose 16 elements of 2, 4, 8 or 16 bytes held in as
+ * many registers into one register per byte position, and log2 of the
+ * element size rounds undo this transposition.
+ */
+static inline void
+sc_io_shuffle_round (__m128i *r, int n)
+{
+  int                 i, h = n / 2;
+  __m128i             t[16];
+
+  for (i = 0; i < h; ++i) {
+    t[2 * i] = _mm_unpacklo_epi8 (r[i], r[i + h]);
+    t[2 * i + 1] = _mm_unpackhi_epi8 (r[i], r[i + h]);
+  }
+  for (i = 0; i < n; ++i) {
+    r[i] = t[i];
+  }
+}
+
+#endif /* SC_IO_SHUFFLE_SSE2 */
+
+/** Group the bytes of all elements by their position within each element.
+ * \param [out] dest        Byte j of element e ends up at j * count + e.
+ * \param [in] src          The elements, contiguous.
+ * \param [in] count        Number of elements.
+ * \param [in] typesize     Bytes in each element.
+ */
+static void
+sc_io_shuffle_bytes (char *dest, const char *src, size_t count,
+                     size_t typesize)
+{
+  size_t              e, j;
+
+  e = 0;
+#ifdef SC_IO_SHUFFLE_SSE2
+  if (typesize == 2 || typesize == 4 || typesize == 8 || typesize == 16) {
+    int                 n = (int) typesize, k;
+    __m128i             r[16];
+
+    for (; e + 16 <= count; e += 16) {
+      for (k = 0; k < n; ++k) {
+        r[k] = _mm_loadu_si128 ((const __m128i *) (src + e * typesize) + k);
+      }
+      for (k = 0; k < 4; ++k) {
+        sc_io_shuffle_round (r, n);
+      }
+      for (k = 0; k < n; ++k) {
+        _mm_storeu_si128 ((__m128i *) (dest + k * count + e), r[k]);
+      }
+    }
+  }
+#endif
+  for (; e < count; ++e) {
+    for (j = 0; j < typesize; ++j) {
+      dest[j * count + e] = src[e * typesize + j];
+    }
+  }
+}
+
+/** Undo \ref sc_io_shuffle_bytes.
+ * \param [out] dest        The elements, contiguous.
+ * \param [in] src          Byte j of element e is found at j * count + e.
+ * \param [in] count        Number of elements.
+ * \param [in] typesize     Bytes in each element.
+ */
+static void
+sc_io_unshuffle_bytes (char *dest, const char *src, size_t count,
+                       size_t typesize)
+{
+  size_t              e, j;
+
+  e = 0;
+#ifdef SC_IO_SHUFFLE_SSE2
+  if (typesize == 2 || typesize == 4 || typesize == 8 || typesize == 16) {
+    int                 n = (int) typesize, k, rounds;
+    __m128i             r[16];
+
+    for (rounds = 0; (1 << rounds) < n; ++rounds);
+    for (; e + 16 <= count; e += 16) {
+      for (k = 0; k < n; ++k) {
+        r[k] = _mm_loadu_si128 ((const __m128i *) (src + k * count + e));
+      }
+      for (k = 0; k < rounds; ++k) {
+        sc_io_shuffle_round (r, n);
+      }
+      for (k = 0; k < n; ++k) {
+        _mm_storeu_si128 ((__m128i *) (dest + e * typesize) + k, r[k]);
+      }
+    }
+  }
+#endif
+  for (; e < count; ++e) {
+    for (j = 0; j < typesize; ++j) {
+      dest[e * typesize + j] = src[j * count + e];
+    }
+  }
+}
+
+/** Round floating point numbers to fewer mantissa bits in place.
+ * We round to nearest with ties away from zero, which may carry into the
+ * exponent as it should.  Infinities and NaNs are left alone.
+ * \param [in,out] data     Numbers of element size 4 (float) or 8 (double).
+ * \param [in] keep_bits    Number of explicit mantissa bits to keep.
+ */
+static void
+sc_io_truncate_mantissa (sc_array_t *data, int keep_bits)
+{
+  size_t              zz;
+  int                 drop;
+  uint32_t            u32;
+  uint64_t            u64;
+
+  if (data->elem_size == 4) {
+    drop = 23 - keep_bits;
+    for (zz = 0; drop > 0 && zz < data->elem_count; ++zz) {
+      memcpy (&u32, data->array + 4 * zz, 4);
+      if ((u32 & 0x7F800000U) != 0x7F800000U) {
+        u32 = (u32 + (1U << (drop - 1))) & ~((1U << drop) - 1);
+        memcpy (data->array + 4 * zz, &u32, 4);
+      }
+    }
+  }
+  else {
+    SC_ASSERT (data->elem_size == 8);
+    drop = 52 - keep_bits;
+    for (zz = 0; drop > 0 && zz < data->elem_count; ++zz) {
+      memcpy (&u64, data->array + 8 * zz, 8);
+      if ((u64 & 0x7FF0000000000000ULL) != 0x7FF0000000000000ULL) {
+        u64 = (u64 + (1ULL << (drop - 1))) & ~((1ULL << drop) - 1);
+        memcpy (data->array + 8 * zz, &u64, 8);
+      }
+    }
+  }
+}
+
+void
+sc_io_encode_shuffle (sc_array_t *data, sc_array_t *out,
+                      int zlib_compression_level, int line_break_character,
+                      int mantissa_bits)
+{
+  size_t              input_size, bound;
+  const char         *src;
+  sc_array_t          copy, shuffled, compressed;
+
+  sc_io_encode_check (data, out, zlib_compression_level);
+  SC_ASSERT (data->elem_size <= 255);
+  SC_ASSERT (mantissa_bits < 0 ||
+             data->elem_size == 4 || data->elem_size == 8);
+
+  /* round a copy of the numbers if requested */
+  input_size = data->elem_count * data->elem_size;
+  src = data->array;
+  sc_array_init (&copy, data->elem_size);
+  if (mantissa_bits >= 0) {
+    sc_array_copy (&copy, data);
+    sc_io_truncate_mantissa (&copy, mantissa_bits);
+    src = copy.array;
+  }
+
+  /* the byte positions of all elements follow each other */
+  sc_array_init_count (&shuffled, 1, input_size);
+  sc_io_shuffle_bytes (shuffled.array, src, data->elem_count,
+                       data->elem_size);
+  sc_array_reset (&copy);
+
+  /* the header is followed by the element size and the zlib data */
+  bound = sc_io_compress_bound (input_size);
+  sc_array_init_count (&compressed, 1, SC_IO_ENCODE_INFO_LEN + 1 + bound);
+  sc_io_put_be64 (compressed.array, (uint64_t) input_size);
+  compressed.array[SC_IO_ENCODE_INFO_LEN - 1] = 's';
+  compressed.array[SC_IO_ENCODE_INFO_LEN] = (char) data->elem_size;
+  sc_io_compress_block (compressed.array + SC_IO_ENCODE_INFO_LEN + 1,
+                        &bound, shuffled.array, input_size,
+                        zlib_compression_level);
+  sc_array_reset (&shuffled);
+
+  if (out == NULL) {
+    out = data;
+  }
+  sc_io_encode_base64 (compressed.array, SC_IO_ENCODE_INFO_LEN + 1 + bound,
+                       out, line_break_character, 1);
+  sc_array_reset (&compressed);
+}
+
+const char         *
+sc_io_shuffle_kernel (void)
+{
+  return SC_IO_SHUFFLE_KERNEL;
+}
+
+int
+sc_io_decode_info (sc_array_t *data, size_t *original_size,
+                   char *format_char, void *re)
+{
+  int                 i;
+  size_t              osize;
+  char                dec[12];
+
+  /* in the future we will add runtime error reporting */
+  SC_ASSERT (re == NULL);
+
+  /* basic checks */
+  SC_ASSERT (SC_IO_ENCODE_INFO_LEN == 9);
+  SC_ASSERT (data != NULL);
+  SC_ASSERT (data->elem_size == 1);
+  if (data->elem_count < 12) {
+    SC_LERROR ("sc_io_decode_info requires >= 12 bytes of input\n");
+    return -1;
+  }
+
+  /* decode first 12 characters of encoded data */
+  memset (dec, 0, 12);
+  if (sc_io_base64_decode_block (data->array, 12, dec, &osize) ||
+      osize != 9) {
+    SC_LERROR ("sc_io_decode_info base 64 error\n");
+    return -1;
+  }
+
+#if 0
+  /* verify first byte for zlib format */
+  if (dec[8] != 'z') {
+    SC_LERROR ("sc_io_decode_info data format error\n");
+    return -1;
+  }
+#endif
+
+  /* decode original length of data */
+  if (original_size != NULL) {
+    unsigned char       uc;
+    osize = 0;
+    for (i = 0; i < 8; ++i) {
+      /* read original byte order in big endian */
+      uc = (unsigned char) dec[i];
+      osize |= ((size_t) uc) << ((7 - i) * 8);
+    }
+    *original_size = osize;
+  }
+
+  /* return format character */
+  if (format_char != NULL) {
+    *format_char = dec[8];
+  }
+
+  /* success! */
+  return 0;
+}
+
+/** Uncompress the blocks of the chunked format in parallel.
+ * \return          0 on success, -1 on error.
+ */
+static int
+sc_io_decode_blocks (char *dest, size_t dest_size,
+                     char *src, size_t src_size, int num_threads)
+{
+  int                 retval = -1;
+  size_t              b, pos;
+  sc_io_blocks_t      bt;
+
+  /* read the block index */
+  if (src_size < 8) {
+    SC_LERROR ("block index missing\n");
+    return -1;
+  }
+  bt.block_size = (size_t) sc_io_get_be64 (src);
+  if (bt.block_size == 0) {
+    SC_LERROR ("block size invalid\n");
+    return -1;
+  }
+  bt.num_blocks = SC_MAX ((dest_size + bt.block_size - 1) / bt.block_size, 1);
+  if (bt.num_blocks > src_size / 8 - 1) {
+    SC_LERROR ("block index short\n");
+    return -1;
+  }
+  bt.data = dest;
+  bt.data_size = dest_size;
+  bt.packed = src;
+  bt.sizes = SC_ALLOC (size_t, bt.num_blocks);
+  bt.offsets = SC_ALLOC (size_t, bt.num_blocks);
+  bt.errors = SC_ALLOC (int, bt.num_blocks);
+  for (pos = 8 * (1 + bt.num_blocks), b = 0; b < bt.num_blocks; ++b) {
+    bt.sizes[b] = (size_t) sc_io_get_be64 (src + 8 * (1 + b));
+    bt.offsets[b] = pos;
+    if (bt.sizes[b] > src_size - pos) {
+      SC_LERROR ("block index exceeds data\n");
+      goto blocks_error;
+    }
+    pos += bt.sizes[b];
+  }
+  if (pos != src_size) {
+    SC_LERROR ("block index mismatch\n");
+    goto blocks_error;
+  }
+
+  /* uncompress the blocks */
+  sc_thread_fork_join ((int) SC_MIN ((size_t) num_threads, bt.num_blocks),
+                       sc_io_blocks_uncompress, &bt);
+  for (b = 0; b < bt.num_blocks; ++b) {
+    if (bt.errors[b]) {
+      SC_LERRORF ("uncompress error in block %llu\n",
+                  (unsigned long long) b);
+      goto blocks_error;
+    }
+  }
+  retval = 0;
+
+blocks_error:
+  SC_FREE (bt.sizes);
+  SC_FREE (bt.offsets);
+  SC_FREE (bt.errors);
+  return retval;
+}
+
+/** Decode the zlib data of \ref sc_io_encode_ints_zlib.
+ * \param [in] compressed   The base 64 decoded input.
+ * \param [in] ocnt         Its number of valid bytes.
+ * \param [in,out] out      The output array, checked for the size.
+ * \param [in] encoded_size The original size stored in the header.
+ * \return                  0 on success, -1 on error.
+ */
+static int
+sc_io_decode_ints_zlib (sc_array_t *compressed, size_t ocnt,
+                        sc_array_t *out, size_t encoded_size)
+{
+  int                 retval;
+  size_t              packed_size;
+  sc_array_t          packed;
+
+  if (ocnt < SC_IO_ENCODE_INFO_LEN + 8) {
+    SC_LERROR ("encoded integer size missing\n");
+    return -1;
+  }
+  packed_size = (size_t) sc_io_get_be64 (compressed->array +
+                                         SC_IO_ENCODE_INFO_LEN);
+  if (packed_size < SC_IO_INTS_HEADER ||
+      packed_size > SC_IO_INTS_HEADER + 9 * (encoded_size / 4 + 1)) {
+    SC_LERROR ("encoded integer size mismatch\n");
+    return -1;
+  }
+  sc_array_init_count (&packed, 1, packed_size);
+  retval = sc_io_uncompress_block
+    (packed.array, packed_size, compressed->array + SC_IO_ENCODE_INFO_LEN + 8,
+     ocnt - SC_IO_ENCODE_INFO_LEN - 8);
+  if (retval) {
+    SC_LERROR ("zlib uncompress error\n");
+  }
+  else if ((retval = sc_io_decode_ints_raw (packed.array, packed_size,
+                                            out)) == 0 &&
+           out->elem_count * out->elem_size != encoded_size) {
+    SC_LERROR ("encoded integers mismatch the original size\n");
+    retval = -1;
+  }
+  sc_array_reset (&packed);
+  return retval;
+}
+
+/** Decode the zlib data of \ref sc_io_encode_shuffle.
+ * \param [in] compressed   The base 64 decoded input.
+ * \param [in] ocnt         Its number of valid bytes.
+ * \param [in,out] out      Output array, already resized to fit.
+ * \param [in] encoded_size The original size stored in the header.
+ * \return                  0 on success, -1 on error.
+ */
+static int
+sc_io_decode_shuffle (sc_array_t *compressed, size_t ocnt,
+                      sc_array_t *out, size_t encoded_size)
+{
+  int                 retval;
+  size_t              typesize;
+  sc_array_t          shuffled;
+
+  if (ocnt < SC_IO_ENCODE_INFO_LEN + 1) {
+    SC_LERROR ("encoded element size missing\n");
+    return -1;
+  }
+  typesize = (size_t) (unsigned char)
+    compressed->array[SC_IO_ENCODE_INFO_LEN];
+  if (typesize == 0 || encoded_size % typesize != 0) {
+    SC_LERROR ("encoded element size mismatch\n");
+    return -1;
+  }
+  sc_array_init_count (&shuffled, 1, encoded_size);
+  retval = sc_io_uncompress_block
+    (shuffled.array, encoded_size,
+     compressed->array + SC_IO_ENCODE_INFO_LEN + 1,
+     ocnt - SC_IO_ENCODE_INFO_LEN - 1);
+  if (retval) {
+    SC_LERROR ("zlib uncompress error\n");
+  }
+  else {
+    sc_io_unshuffle_bytes (out->array, shuffled.array,
+                           encoded_size / typesize, typesize);
+  }
+  sc_array_reset (&shuffled);
+  return retval;
+}
+
+int
+sc_io_decode (sc_array_t *data, sc_array_t *out,
+              size_t max_original_size, void *re)
+{
+  int                 i;
+  int                 retval = -1;
+  int                 num_threads;
+  size_t              encoded_size;
+  size_t              current_size;
+  size_t              ocnt, checksum_size;
+  char                format_char;
+  sc_array_t          compressed;
+
+  /* in the future we will add runtime error reporting */
+  SC_ASSERT (re == NULL);
+
+  /* examine input data */
+  SC_ASSERT (data != NULL);
+  SC_ASSERT (data->elem_size == 1);
+  encoded_size = data->elem_count;
+  if (encoded_size == 0 ||
+      *(char *) sc_array_index (data, encoded_size - 1) != '\0') {
+    SC_LERROR ("input not NUL-terminated\n");
+    return -1;
+  }
+
+  /* decode line by line from base 64 */
+  num_threads = sc_thread_default_count ();
+  sc_array_init (&compressed, 1);
+  if (sc_io_decode_base64 (data, &compressed, &ocnt, num_threads)) {
+    goto decode_error;
+  }
+  if (ocnt < SC_IO_ENCODE_INFO_LEN) {
+    SC_LERRORF ("base 64 decodes to less than %d bytes\n",
+                SC_IO_ENCODE_INFO_LEN);
+    goto decode_error;
+  }
+  format_char = compressed.array[SC_IO_ENCODE_INFO_LEN - 1];
+  if (format_char != 'z' && format_char != 'C' && format_char != 'B' &&
+      format_char != 'i' && format_char != 's') {
+    SC_LERROR ("encoded format character mismatch\n");
+    goto decode_error;
+  }
+  checksum_size = 0;
+  if (format_char == 'C') {
+    /* the data ends in a CRC32C checksum of the original data */
+    checksum_size = 4;
+    if (ocnt < SC_IO_ENCODE_INFO_LEN + checksum_size) {
+      SC_LERROR ("encoded checksum missing\n");
+      goto decode_error;
+    }
+    ocnt -= checksum_size;
+  }
+
+  /* determine length of uncompressed data */
+  encoded_size = (size_t) sc_io_get_be64 (compressed.array);
+  if (out == NULL) {
+    /* allow for in-place operation */
+    out = data;
+  }
+  if (encoded_size % out->elem_size != 0) {
+    SC_LERROR ("encoded size not commensurable with output array\n");
+    goto decode_error;
+  }
+  if (max_original_size > 0 && encoded_size > max_original_size) {
+    SC_LERRORF ("encoded size %llu larger than specified maximum %llu\n",
+                (unsigned long long) encoded_size,
+                (unsigned long long) max_original_size);
+    goto decode_error;
+  }
+  if (!SC_ARRAY_IS_OWNER (out) &&
+      encoded_size > (current_size = out->elem_count * out->elem_size)) {
+    SC_LERRORF ("encoded size %llu larger than byte size of view %llu\n",
+                (unsigned long long) encoded_size,
+                (unsigned long long) current_size);
+    goto decode_error;
+  }
+  if (format_char == 'i') {
+    /* uncompress the packed integers and unpack them */
+    retval = sc_io_decode_ints_zlib (&compressed, ocnt, out, encoded_size);
+    sc_array_reset (&compressed);
+    return retval;
+  }
+  sc_array_resize (out, encoded_size / out->elem_size);
+
+  /* decompress decoded data */
+  if (format_char == 's') {
+    if (sc_io_decode_shuffle (&compressed, ocnt, out, encoded_size)) {
+      goto decode_error;
+    }
+  }
+  else if (format_char == 'B') {
+    if (sc_io_decode_blocks (out->array, encoded_size,
+                             compressed.array + SC_IO_ENCODE_INFO_LEN,
+                             ocnt - SC_IO_ENCODE_INFO_LEN, num_threads)) {
+      goto decode_error;
+    }
+  }
+  else if (sc_io_uncompress_block (out->array, encoded_size,
+                                   compressed.array + SC_IO_ENCODE_INFO_LEN,
+                                   ocnt - SC_IO_ENCODE_INFO_LEN)) {
+#ifndef SC_HAVE_ZLIB
+    SC_LERROR ("Please consider configuring the build"
+               " such that zlib is found.\n");
+#else
+    SC_LERROR ("zlib uncompress error\n");
+#endif
+    goto decode_error;
+  }
+
+  /* verify the optional checksum */
+  if (checksum_size > 0) {
+    uint32_t            crc = sc_io_crc32c (0, out->array, encoded_size);
+
+    for (i = 0; i < (int) checksum_size; ++i) {
+      if (compressed.array[ocnt + i] != (char) ((crc >> ((3 - i) * 8)) &
+                                                0xFF)) {
+        SC_LERROR ("crc32c checksum error\n");
+        goto decode_error;
+      }
+    }
+  }
+
+  /* exit cleanly */
+  retval = 0;
+decode_error:
+  sc_array_reset (&compressed);
+  return retval;
+}
+
+/** Size of the compressor buffers of the incremental encoder and decoder. */
+#define SC_IO_STREAM_BUFFER (1 << 14)
+
+/** Largest piece passed to zlib at once, which counts in uInt. */
+#define SC_IO_STREAM_CHUNK ((size_t) 1 << 30)
+
+struct sc_io_encoder
+{
+  sc_io_sink_t       *sink;
+  size_t              original_size;
+  size_t              bytes_in;
+  int                 line_break_character;
+  int                 error;
+  size_t              line_count;       /**< Pending bytes of the line. */
+  char                line[SC_IO_DBC];
+  char                code[SC_IO_LBF];
+#ifdef SC_HAVE_ZLIB
+  z_stream            zs;
+  char                zbuf[SC_IO_STREAM_BUFFER];
+#else
+  uint32_t            adler;
+  int                 level;
+  size_t              block_count;      /**< Pending bytes of the block. */
+  char                block[SC_IO_NONCOMP_BLOCK];
+  char                packed[SC_IO_NONCOMP_BLOCK + 5];
+#endif
+};
+
+/** Append compressed bytes and write out each full base 64 line.
+ * A full line is kept back until more bytes arrive, such that the
+ * final line is always written by \ref sc_io_encoder_destroy. */
+static void
+sc_io_encoder_put (sc_io_encoder_t * enc, const char *bin, size_t n)
+{
+  size_t              len, lout;
+
+  while (n > 0 && !enc->error) {
+    if (enc->line_count == SC_IO_DBC) {
+      lout = sc_io_base64_encode_block (enc->line, SC_IO_DBC, enc->code);
+      SC_ASSERT (lout == SC_IO_LBC);
+      enc->code[SC_IO_LBC] = (char) enc->line_break_character;
+      enc->code[SC_IO_LBD] = '\n';
+      if (sc_io_sink_write (enc->sink, enc->code, SC_IO_LBE)) {
+        SC_LERROR ("encoder sink error\n");
+        enc->error = 1;
+        break;
+      }
+      enc->line_count = 0;
+    }
+    len = SC_MIN (n, SC_IO_DBC - enc->line_count);
+    memcpy (enc->line + enc->line_count, bin, len);
+    enc->line_count += len;
+    bin += len;
+    n -= len;
+  }
+}
+
+#ifdef SC_HAVE_ZLIB
+
+/** Run the compressor on a piece of input and pass on its output. */
+static void
+sc_io_encoder_deflate (sc_io_encoder_t * enc, const char *data,
+                       size_t bytes, int flush)
+{
+  int                 zrv;
+  size_t              chunk;
+
+  do {
+    chunk = SC_MIN (bytes, SC_IO_STREAM_CHUNK);
+    enc->zs.next_in = (Bytef *) data;
+    enc->zs.avail_in = (uInt) chunk;
+    data += chunk;
+    bytes -= chunk;
+    do {
+      enc->zs.next_out = (Bytef *) enc->zbuf;
+      enc->zs.avail_out = SC_IO_STREAM_BUFFER;
+      zrv = deflate (&enc->zs, bytes > 0 ? Z_NO_FLUSH : flush);
+      SC_CHECK_ABORT (zrv != Z_STREAM_ERROR, "Error on zlib compression");
+      sc_io_encoder_put (enc, enc->zbuf,
+                         SC_IO_STREAM_BUFFER - enc->zs.avail_out);
+    }
+    while (enc->zs.avail_out == 0 && !enc->error);
+  }
+  while (bytes > 0 && !enc->error);
+}
+
+#else
+
+/** Write the pending data as one compressed or uncompressed zlib block. */
+static void
+sc_io_encoder_block (sc_io_encoder_t * enc, int final_block)
+{
+  char                header[5];
+  size_t              fsize;
+  uint16_t            bsize, nsize;
+
+  SC_ASSERT (enc->block_count <= SC_IO_NONCOMP_BLOCK);
+  enc->adler = sc_io_adler32 (enc->adler, enc->block, enc->block_count);
+#ifdef SC_PUFF_INCLUDED
+  if (enc->level != 0) {
+    fsize = sc_io_deflate_fixed (enc->packed, enc->block_count + 5,
+                                 enc->block, enc->block_count, final_block,
+                                 enc->level);
+    if (fsize > 0) {
+      sc_io_encoder_put (enc, enc->packed, fsize);
+      enc->block_count = 0;
+      return;
+    }
+  }
+#endif
+  bsize = (uint16_t) enc->block_count;
+  nsize = ~bsize;
+  header[0] = (char) (final_block ? 1 : 0);
+  header[1] = (char) (bsize & 0xFF);
+  header[2] = (char) (bsize >> 8);
+  header[3] = (char) (nsize & 0xFF);
+  header[4] = (char) (nsize >> 8);
+  sc_io_encoder_put (enc, header, 5);
+  sc_io_encoder_put (enc, enc->block, enc->block_count);
+  enc->block_count = 0;
+}
+
+#endif /* !SC_HAVE_ZLIB */
+
+sc_io_encoder_t    *
+sc_io_encoder_new (sc_io_sink_t * sink, size_t original_size,
+                   int zlib_compression_level, int line_break_character)
+{
+  char                header[SC_IO_ENCODE_INFO_LEN];
+  sc_io_encoder_t    *enc;
+
+  SC_ASSERT (sink != NULL);
+  SC_ASSERT (-1 <= zlib_compression_level && zlib_compression_level <= 9);
+
+  enc = SC_ALLOC (sc_io_encoder_t, 1);
+  enc->sink = sink;
+  enc->original_size = original_size;
+  enc->bytes_in = 0;
+  enc->line_break_character = line_break_character;
+  enc->error = 0;
+  enc->line_count = 0;
+
+  /* the header is the same as in the one-shot encoding */
+  sc_io_put_be64 (header, (uint64_t) original_size);
+  header[SC_IO_ENCODE_INFO_LEN - 1] = 'z';
+  sc_io_encoder_put (enc, header, SC_IO_ENCODE_INFO_LEN);
+
+#ifdef SC_HAVE_ZLIB
+  memset (&enc->zs, 0, sizeof (z_stream));
+  SC_CHECK_ABORT (deflateInit (&enc->zs, zlib_compression_level) == Z_OK,
+                  "Error on zlib initialization");
+#else
+  /* write zlib format header */
+  header[0] = (7 << 4) + 8;
+  header[1] = 1;
+  sc_io_encoder_put (enc, header, 2);
+  enc->adler = 1;
+  enc->level = zlib_compression_level;
+  enc->block_count = 0;
+#endif
+
+  return enc;
+}
+
+int
+sc_io_encoder_write (sc_io_encoder_t * enc, const void *data, size_t bytes)
+{
+#ifndef SC_HAVE_ZLIB
+  size_t              len;
+  const char         *src = (const char *) data;
+#endif
+
+  SC_ASSERT (enc != NULL);
+  SC_ASSERT (bytes == 0 || data != NULL);
+
+  if (enc->error) {
+    return -1;
+  }
+  if (bytes > enc->original_size - enc->bytes_in) {
+    SC_LERROR ("encoder input exceeds original size\n");
+    enc->error = 1;
+    return -1;
+  }
+  enc->bytes_in += bytes;
+
+#ifdef SC_HAVE_ZLIB
+  if (bytes > 0) {
+    sc_io_encoder_deflate (enc, (const char *) data, bytes, Z_NO_FLUSH);
+  }
+#else
+  while (bytes > 0 && !enc->error) {
+    if (enc->block_count == SC_IO_NONCOMP_BLOCK) {
+      /* a full block is final only if no more data follows */
+      sc_io_encoder_block (enc, 0);
+    }
+    len = SC_MIN (bytes, SC_IO_NONCOMP_BLOCK - enc->block_count);
+    memcpy (enc->block + enc->block_count, src, len);
+    enc->block_count += len;
+    src += len;
+    bytes -= len;
+  }
+#endif
+
+  return enc->error ? -1 : 0;
+}
+
+int
+sc_io_encoder_destroy (sc_io_encoder_t * enc)
+{
+  int                 retval;
+  size_t              lout;
+#ifndef SC_HAVE_ZLIB
+  int                 i;
+  char                trailer[4];
+#endif
+
+  SC_ASSERT (enc != NULL);
+
+  if (!enc->error && enc->bytes_in != enc->original_size) {
+    SC_LERROR ("encoder input short of original size\n");
+    enc->error = 1;
   }
 
-  /* return format character */
-  if (format_char != NULL) {
-    *format_char = dec[8];
+  /* flush the compressor */
+  if (!enc->error) {
+#ifdef SC_HAVE_ZLIB
+    sc_io_encoder_deflate (enc, NULL, 0, Z_FINISH);
+#else
+    sc_io_encoder_block (enc, 1);
+    for (i = 0; i < 4; ++i) {
+      trailer[i] = (char) ((enc->adler >> ((3 - i) * 8)) & 0xFF);
+    }
+    sc_io_encoder_put (enc, trailer, 4);
+#endif
   }
+#ifdef SC_HAVE_ZLIB
+  (void) deflateEnd (&enc->zs);
+#endif
 
-  /* success! */
-  return 0;
+  /* write the final line, which contains at least the header */
+  if (!enc->error) {
+    SC_ASSERT (enc->line_count > 0);
+    lout = sc_io_base64_encode_block (enc->line, enc->line_count,
+                                      enc->code);
+    SC_ASSERT (lout <= SC_IO_LBC);
+    enc->code[lout] = (char) enc->line_break_character;
+    enc->code[lout + 1] = '\n';
+    enc->code[lout + 2] = '\0';
+    if (sc_io_sink_write (enc->sink, enc->code, lout + 3)) {
+      SC_LERROR ("encoder sink error\n");
+      enc->error = 1;
+    }
+  }
+
+  retval = enc->error ? -1 : 0;
+  SC_FREE (enc);
+  return retval;
 }
 
-int
-sc_io_decode (sc_array_t *data, sc_array_t *out,
-              size_t max_original_size, void *re)
+/** Stages of the binary data read by the incremental decoder. */
+typedef enum sc_io_decoder_stage
 {
-  int                 i;
-  int                 zrv;
-  int                 retval = -1;
-  char               *ipos, *opos;
-  char                base_out[SC_IO_LBC];
-  size_t              compressed_size;
-  size_t              base64_lines;
-  size_t              encoded_size;
-  size_t              current_size;
-  size_t              zlin, irem;
-  size_t              ocnt;
+  SC_IO_DECODER_HEADER, /**< Original size and format character. */
+  SC_IO_DECODER_INDEX,  /**< Block size of the block format. */
+  SC_IO_DECODER_SKIP,   /**< Compressed block sizes, not needed. */
+  SC_IO_DECODER_STREAM, /**< The compressed data. */
+  SC_IO_DECODER_TRAILER /**< The optional checksum. */
+}
+sc_io_decoder_stage_t;
+
+struct sc_io_decoder
+{
+  sc_io_sink_t       *sink;
+  size_t              max_original_size;
+  int                 error;
+  int                 text_done;        /**< The NUL has been read. */
+  size_t              text_count;       /**< Pending characters. */
+  char                text[SC_IO_LBF];
+  char                line[SC_IO_DBC];
+  sc_io_decoder_stage_t stage;
+  size_t              stage_count;      /**< Bytes read of the stage. */
+  size_t              stage_size;       /**< Bytes expected in the stage. */
+  char                header[SC_IO_ENCODE_INFO_LEN];
+  char                index[8];
+  char                trailer[4];
+  char                format_char;
+  size_t              original_size;
+  size_t              bytes_out;
+  uint32_t            crc;
 #ifdef SC_HAVE_ZLIB
-  uLong               uncompsize;
+  size_t              num_blocks;
+  size_t              blocks_done;
+  z_stream            zs;
+  char                zbuf[SC_IO_STREAM_BUFFER];
+#else
+  sc_array_t          packed;   /**< Compressed data after the header. */
 #endif
-  sc_array_t          compressed;
-  base64_decodestate  bstate;
+};
 
-  /* in the future we will add runtime error reporting */
-  SC_ASSERT (re == NULL);
+static void
+sc_io_decoder_stage (sc_io_decoder_t * dec, sc_io_decoder_stage_t stage,
+                     size_t stage_size)
+{
+  dec->stage = stage;
+  dec->stage_count = 0;
+  dec->stage_size = stage_size;
+}
 
-  /* examine input data */
-  SC_ASSERT (data != NULL);
-  SC_ASSERT (data->elem_size == 1);
-  encoded_size = data->elem_count;
-  if (encoded_size == 0 ||
-      *(char *) sc_array_index (data, encoded_size - 1) != '\0') {
-    SC_LERROR ("input not NUL-terminated\n");
-    return -1;
+/** Read up to the remaining bytes of the current stage into a buffer.
+ * \return          The number of bytes consumed.
+ */
+static size_t
+sc_io_decoder_collect (sc_io_decoder_t * dec, char *buf,
+                       const char *bin, size_t n)
+{
+  size_t              take = SC_MIN (n, dec->stage_size - dec->stage_count);
+
+  if (buf != NULL) {
+    memcpy (buf + dec->stage_count, bin, take);
   }
+  dec->stage_count += take;
+  return take;
+}
 
-  /* decode line by line from base 64 */
-  base64_init_decodestate (&bstate);
-  base64_lines = (encoded_size - 1 + SC_IO_LBD) / SC_IO_LBE;
-  compressed_size = base64_lines * SC_IO_DBC;
-  ipos = data->array;
-  SC_ASSERT (encoded_size >= base64_lines + 1);
-  irem = encoded_size - 1 - 2 * base64_lines;
-  sc_array_init_count (&compressed, 1, compressed_size);
-  opos = compressed.array;
-  ocnt = 0;
-  for (zlin = 0; zlin < base64_lines; ++zlin) {
-    size_t              lein = SC_MIN (irem, SC_IO_LBC);
-    size_t              lout =
-      base64_decode_block (ipos, lein, base_out, &bstate);
+/** Pass uncompressed data to the sink. */
+static void
+sc_io_decoder_output (sc_io_decoder_t * dec, const char *buf, size_t len)
+{
+  if (len > dec->original_size - dec->bytes_out) {
+    SC_LERROR ("uncompressed data exceeds encoded size\n");
+    dec->error = 1;
+    return;
+  }
+  if (dec->format_char == 'C') {
+    dec->crc = sc_io_crc32c (dec->crc, buf, len);
+  }
+  if (sc_io_sink_write (dec->sink, buf, len)) {
+    SC_LERROR ("decoder sink error\n");
+    dec->error = 1;
+    return;
+  }
+  dec->bytes_out += len;
+}
 
-    SC_ASSERT (lein > 0);
-    if (lout == 0) {
-      SC_LERROR ("base 64 decode short\n");
-      goto decode_error;
+/** Interpret the completed header. */
+static void
+sc_io_decoder_header (sc_io_decoder_t * dec)
+{
+  dec->original_size = (size_t) sc_io_get_be64 (dec->header);
+  dec->format_char = dec->header[SC_IO_ENCODE_INFO_LEN - 1];
+  if (dec->format_char != 'z' && dec->format_char != 'C' &&
+      dec->format_char != 'B') {
+    SC_LERROR ("encoded format character mismatch\n");
+    dec->error = 1;
+    return;
+  }
+  if (dec->max_original_size > 0 &&
+      dec->original_size > dec->max_original_size) {
+    SC_LERRORF ("encoded size %llu larger than specified maximum %llu\n",
+                (unsigned long long) dec->original_size,
+                (unsigned long long) dec->max_original_size);
+    dec->error = 1;
+    return;
+  }
+#ifdef SC_HAVE_ZLIB
+  if (dec->format_char == 'B') {
+    sc_io_decoder_stage (dec, SC_IO_DECODER_INDEX, 8);
+  }
+  else {
+    sc_io_decoder_stage (dec, SC_IO_DECODER_STREAM, 0);
+  }
+#else
+  /* everything after the header is uncompressed at once */
+  sc_io_decoder_stage (dec, SC_IO_DECODER_STREAM, 0);
+#endif
+}
+
+#ifdef SC_HAVE_ZLIB
+
+/** Run the uncompressor on a piece of input and pass on its output.
+ * The compressed blocks of the block format follow each other directly.
+ * \return          The number of bytes consumed.
+ */
+static size_t
+sc_io_decoder_inflate (sc_io_decoder_t * dec, const char *bin, size_t n)
+{
+  int                 zrv;
+  size_t              chunk, take;
+
+  chunk = SC_MIN (n, SC_IO_STREAM_CHUNK);
+  dec->zs.next_in = (Bytef *) bin;
+  dec->zs.avail_in = (uInt) chunk;
+  do {
+    dec->zs.next_out = (Bytef *) dec->zbuf;
+    dec->zs.avail_out = SC_IO_STREAM_BUFFER;
+    zrv = inflate (&dec->zs, Z_NO_FLUSH);
+    if (zrv != Z_OK && zrv != Z_STREAM_END && zrv != Z_BUF_ERROR) {
+      SC_LERROR ("zlib uncompress error\n");
+      dec->error = 1;
+      return 0;
     }
-#if 0
-    if (ipos[lein] != '\n') {
-      SC_LERROR ("base 64 missing newline\n");
-      goto decode_error;
+    sc_io_decoder_output (dec, dec->zbuf,
+                          SC_IO_STREAM_BUFFER - dec->zs.avail_out);
+    if (dec->error) {
+      return 0;
     }
-#endif
-    if (zlin < base64_lines - 1) {
-      SC_ASSERT (lein == SC_IO_LBC);
-      if (lout != SC_IO_DBC) {
-        SC_LERROR ("base 64 decode mismatch\n");
-        goto decode_error;
-      }
-      memcpy (opos, base_out, SC_IO_DBC);
-      ipos += SC_IO_LBE;
-      SC_ASSERT (irem >= SC_IO_LBC);
-      irem -= SC_IO_LBC;
-      opos += SC_IO_DBC;
-      ocnt += SC_IO_DBC;
+  }
+  while (zrv != Z_STREAM_END && dec->zs.avail_out == 0);
+  take = chunk - dec->zs.avail_in;
+
+  if (zrv == Z_STREAM_END) {
+    if (++dec->blocks_done < dec->num_blocks) {
+      (void) inflateReset (&dec->zs);
     }
     else {
-      SC_ASSERT (lein <= SC_IO_LBC);
-      SC_ASSERT (lout <= SC_IO_DBC);
-      memcpy (opos, base_out, lout);
-      ipos += lein + 2;
-      SC_ASSERT (irem >= lein);
-      irem -= lein;
-      opos += lout;
-      ocnt += lout;
+      sc_io_decoder_stage (dec, SC_IO_DECODER_TRAILER,
+                           dec->format_char == 'C' ? 4 : 0);
     }
   }
-  SC_ASSERT (irem == 0);
-  SC_ASSERT (ocnt <= compressed_size);
-  SC_ASSERT (ipos + 1 == data->array + encoded_size);
-  if (ocnt < SC_IO_ENCODE_INFO_LEN) {
-    SC_LERRORF ("base 64 decodes to less than %d bytes\n",
-                SC_IO_ENCODE_INFO_LEN);
-    goto decode_error;
-  }
-  if (compressed.array[SC_IO_ENCODE_INFO_LEN - 1] != 'z') {
-    SC_LERROR ("encoded format character mismatch\n");
-    goto decode_error;
+  else if (take == 0) {
+    SC_LERROR ("zlib uncompress stalled\n");
+    dec->error = 1;
   }
+  return take;
+}
 
-  /* determine length of uncompressed data */
-  encoded_size = 0;
-  for (i = 0; i < 8; ++i) {
-    /* enforce big endian byte order for original size */
-    unsigned char       uc = (unsigned char) compressed.array[i];
-    encoded_size |= ((size_t) uc) << ((7 - i) * 8);
+#endif /* SC_HAVE_ZLIB */
+
+/** Consume the data decoded from base 64 according to the stage. */
+static void
+sc_io_decoder_put (sc_io_decoder_t * dec, const char *bin, size_t n)
+{
+  size_t              take;
+#ifdef SC_HAVE_ZLIB
+  size_t              block_size;
+#endif
+
+  while (n > 0 && !dec->error) {
+    switch (dec->stage) {
+    case SC_IO_DECODER_HEADER:
+      take = sc_io_decoder_collect (dec, dec->header, bin, n);
+      if (dec->stage_count == dec->stage_size) {
+        sc_io_decoder_header (dec);
+      }
+      break;
+#ifdef SC_HAVE_ZLIB
+    case SC_IO_DECODER_INDEX:
+      take = sc_io_decoder_collect (dec, dec->index, bin, n);
+      if (dec->stage_count == dec->stage_size) {
+        block_size = (size_t) sc_io_get_be64 (dec->index);
+        if (block_size == 0) {
+          SC_LERROR ("block size invalid\n");
+          dec->error = 1;
+          break;
+        }
+        dec->num_blocks = SC_MAX ((dec->original_size + block_size - 1) /
+                                  block_size, 1);
+        sc_io_decoder_stage (dec, SC_IO_DECODER_SKIP, 8 * dec->num_blocks);
+      }
+      break;
+    case SC_IO_DECODER_SKIP:
+      take = sc_io_decoder_collect (dec, NULL, bin, n);
+      if (dec->stage_count == dec->stage_size) {
+        sc_io_decoder_stage (dec, SC_IO_DECODER_STREAM, 0);
+      }
+      break;
+    case SC_IO_DECODER_STREAM:
+      take = sc_io_decoder_inflate (dec, bin, n);
+      break;
+#else
+    case SC_IO_DECODER_STREAM:
+      take = n;
+      memcpy (sc_array_push_count (&dec->packed, n), bin, n);
+      break;
+#endif
+    case SC_IO_DECODER_TRAILER:
+      take = sc_io_decoder_collect (dec, dec->trailer, bin, n);
+      if (take < n) {
+        SC_LERROR ("encoded data continues after its end\n");
+        dec->error = 1;
+      }
+      break;
+    default:
+      SC_ABORT_NOT_REACHED ();
+    }
+    bin += take;
+    n -= take;
   }
-  if (out == NULL) {
-    /* allow for in-place operation */
-    out = data;
+}
+
+#ifndef SC_HAVE_ZLIB
+
+/** Uncompress the collected data into a temporary buffer. */
+static void
+sc_io_decoder_uncompress (sc_io_decoder_t * dec)
+{
+  size_t              src_size = dec->packed.elem_count;
+  size_t              checksum_size = dec->format_char == 'C' ? 4 : 0;
+  char               *dest;
+
+  if (src_size < checksum_size) {
+    SC_LERROR ("encoded checksum missing\n");
+    dec->error = 1;
+    return;
   }
-  if (encoded_size % out->elem_size != 0) {
-    SC_LERROR ("encoded size not commensurable with output array\n");
-    goto decode_error;
+  src_size -= checksum_size;
+  sc_io_decoder_stage (dec, SC_IO_DECODER_TRAILER, checksum_size);
+  (void) sc_io_decoder_collect (dec, dec->trailer,
+                                dec->packed.array + src_size, checksum_size);
+
+  dest = SC_ALLOC (char, dec->original_size);
+  if (dec->format_char == 'B' ?
+      sc_io_decode_blocks (dest, dec->original_size, dec->packed.array,
+                           src_size, sc_thread_default_count ()) :
+      sc_io_uncompress_block (dest, dec->original_size, dec->packed.array,
+                              src_size)) {
+    SC_LERROR ("Please consider configuring the build"
+               " such that zlib is found.\n");
+    dec->error = 1;
   }
-  if (max_original_size > 0 && encoded_size > max_original_size) {
-    SC_LERRORF ("encoded size %llu larger than specified maximum %llu\n",
-                (unsigned long long) encoded_size,
-                (unsigned long long) max_original_size);
-    goto decode_error;
+  else {
+    sc_io_decoder_output (dec, dest, dec->original_size);
   }
-  if (!SC_ARRAY_IS_OWNER (out) &&
-      encoded_size > (current_size = out->elem_count * out->elem_size)) {
-    SC_LERRORF ("encoded size %llu larger than byte size of view %llu\n",
-                (unsigned long long) encoded_size,
-                (unsigned long long) current_size);
-    goto decode_error;
+  SC_FREE (dest);
+}
+
+#endif /* !SC_HAVE_ZLIB */
+
+sc_io_decoder_t    *
+sc_io_decoder_new (sc_io_sink_t * sink, size_t max_original_size)
+{
+  sc_io_decoder_t    *dec;
+
+  SC_ASSERT (sink != NULL);
+
+  dec = SC_ALLOC (sc_io_decoder_t, 1);
+  dec->sink = sink;
+  dec->max_original_size = max_original_size;
+  dec->error = 0;
+  dec->text_done = 0;
+  dec->text_count = 0;
+  sc_io_decoder_stage (dec, SC_IO_DECODER_HEADER, SC_IO_ENCODE_INFO_LEN);
+  dec->format_char = '\0';
+  dec->original_size = 0;
+  dec->bytes_out = 0;
+  dec->crc = 0;
+#ifdef SC_HAVE_ZLIB
+  dec->num_blocks = 1;
+  dec->blocks_done = 0;
+  memset (&dec->zs, 0, sizeof (z_stream));
+  SC_CHECK_ABORT (inflateInit (&dec->zs) == Z_OK,
+                  "Error on zlib initialization");
+#else
+  sc_array_init (&dec->packed, 1);
+#endif
+
+  return dec;
+}
+
+int
+sc_io_decoder_write (sc_io_decoder_t * dec, const void *data, size_t bytes)
+{
+  const char         *text = (const char *) data;
+  const char         *nul;
+  size_t              take, pos, lout;
+
+  SC_ASSERT (dec != NULL);
+  SC_ASSERT (bytes == 0 || data != NULL);
+
+  while (bytes > 0 && !dec->error) {
+    if (dec->text_done) {
+      SC_LERROR ("input continues after NUL\n");
+      dec->error = 1;
+      break;
+    }
+
+    /* we keep one character beyond a line to recognize the final one */
+    take = SC_MIN (bytes, SC_IO_LBF - dec->text_count);
+    nul = (const char *) memchr (text, '\0', take);
+    if (nul != NULL) {
+      take = (size_t) (nul - text) + 1;
+    }
+    memcpy (dec->text + dec->text_count, text, take);
+    dec->text_count += take;
+    text += take;
+    bytes -= take;
+
+    if (nul != NULL) {
+      /* the final line is followed by two line break bytes and NUL */
+      pos = dec->text_count - 1;
+      if (pos < 3) {
+        SC_LERROR ("base 64 final line error\n");
+        dec->error = 1;
+        break;
+      }
+      if (sc_io_base64_decode_block (dec->text, pos - 2, dec->line, &lout)
+          || lout == 0) {
+        SC_LERROR ("base 64 final line error\n");
+        dec->error = 1;
+        break;
+      }
+      dec->text_done = 1;
+      sc_io_decoder_put (dec, dec->line, lout);
+    }
+    else if (dec->text_count == SC_IO_LBF) {
+      /* a full line that is not the final one */
+      if (sc_io_base64_decode_block (dec->text, SC_IO_LBC, dec->line, &lout)
+          || lout != SC_IO_DBC) {
+        SC_LERROR ("base 64 line error\n");
+        dec->error = 1;
+        break;
+      }
+      dec->text[0] = dec->text[SC_IO_LBE];
+      dec->text_count = 1;
+      sc_io_decoder_put (dec, dec->line, lout);
+    }
   }
-  sc_array_resize (out, encoded_size / out->elem_size);
 
-  /* decompress decoded data */
+  return dec->error ? -1 : 0;
+}
+
+int
+sc_io_decoder_destroy (sc_io_decoder_t * dec, size_t *original_size)
+{
+  int                 i;
+  int                 retval;
+
+  SC_ASSERT (dec != NULL);
+
+  if (!dec->error && !dec->text_done) {
+    SC_LERROR ("input not NUL-terminated\n");
+    dec->error = 1;
+  }
 #ifndef SC_HAVE_ZLIB
-  zrv = sc_io_nonuncompress (out->array, encoded_size,
-                             compressed.array + SC_IO_ENCODE_INFO_LEN,
-                             ocnt - SC_IO_ENCODE_INFO_LEN, re);
-  if (zrv) {
-    SC_LERROR ("Please consider configuring the build"
-               " such that zlib is found.\n");
-    goto decode_error;
+  if (!dec->error && dec->stage == SC_IO_DECODER_STREAM) {
+    sc_io_decoder_uncompress (dec);
   }
-#else
-  uncompsize = (uLong) encoded_size;
-  zrv = uncompress ((Bytef *) out->array, &uncompsize,
-                    (Bytef *) (compressed.array + SC_IO_ENCODE_INFO_LEN),
-                    ocnt - SC_IO_ENCODE_INFO_LEN);
-  if (zrv != Z_OK) {
-    SC_LERROR ("zlib uncompress error\n");
-    goto decode_error;
+#endif
+  if (!dec->error && (dec->stage != SC_IO_DECODER_TRAILER ||
+                      dec->stage_count != dec->stage_size)) {
+    SC_LERROR ("encoded data incomplete\n");
+    dec->error = 1;
   }
-  if (uncompsize != (uLong) encoded_size) {
-    SC_LERROR ("zlib uncompress short\n");
-    goto decode_error;
+  if (!dec->error && dec->bytes_out != dec->original_size) {
+    SC_LERROR ("uncompressed data short of encoded size\n");
+    dec->error = 1;
   }
-#endif /* SC_HAVE_ZLIB */
 
-  /* exit cleanly */
-  retval = 0;
-decode_error:
-  sc_array_reset (&compressed);
+  /* verify the optional checksum */
+  if (!dec->error && dec->format_char == 'C') {
+    for (i = 0; i < 4; ++i) {
+      if (dec->trailer[i] != (char) ((dec->crc >> ((3 - i) * 8)) & 0xFF)) {
+        SC_LERROR ("crc32c checksum error\n");
+        dec->error = 1;
+        break;
+      }
+    }
+  }
+
+#ifdef SC_HAVE_ZLIB
+  (void) inflateEnd (&dec->zs);
+#else
+  sc_array_reset (&dec->packed);
+#endif
+  if (original_size != NULL) {
+    *original_size = dec->original_size;
+  }
+  retval = dec->error ? -1 : 0;
+  SC_FREE (dec);
   return retval;
 }
 
-int
-sc_vtk_write_binary (FILE * vtkfile, char *numeric_data, size_t byte_length)
+/** Block size of the VTK compressed format. */
+#define SC_IO_VTK_BLOCK_SIZE ((size_t) 1 << 15)
+
+/** Minimum number of base 64 groups per thread of the VTK encoders. */
+#define SC_IO_VTK_GROUPS_MIN ((size_t) 1 << 14)
+
+static void
+sc_io_base64_encode_groups (int thread_id, int num_threads, void *user)
 {
-  size_t              chunks, chunksize, remaining, writenow;
-  size_t              code_length, base_length;
+  sc_io_base64_t     *bt = (sc_io_base64_t *) user;
+  const size_t        groups = (bt->input_size + 2) / 3;
+  size_t              lo, hi;
+
+  /* each thread starts on a multiple of 3 bytes */
+  lo = 3 * (groups * (size_t) thread_id / (size_t) num_threads);
+  hi = 3 * (groups * (size_t) (thread_id + 1) / (size_t) num_threads);
+  hi = SC_MIN (hi, bt->input_size);
+  if (lo < hi) {
+    (void) sc_io_base64_encode_block (bt->input + lo, hi - lo,
+                                      bt->output + lo / 3 * 4);
+  }
+}
+
+/** Append padded base 64 code without line breaks to an array. */
+static void
+sc_io_vtk_base64 (sc_array_t *out, const char *input, size_t input_size,
+                  int num_threads)
+{
+  size_t              start, T;
+  sc_io_base64_t      bt;
+
+  start = out->elem_count;
+  sc_array_resize (out, start + 4 * ((input_size + 2) / 3));
+  bt.input = input;
+  bt.input_size = input_size;
+  bt.output = out->array + start;
+  T = (size_t) SC_MAX (num_threads, 1);
+  T = SC_MIN (T, (input_size + 2) / 3 / SC_IO_VTK_GROUPS_MIN);
+  if (T <= 1) {
+    sc_io_base64_encode_groups (0, 1, &bt);
+  }
+  else {
+    sc_thread_fork_join ((int) T, sc_io_base64_encode_groups, &bt);
+  }
+}
+
+void
+sc_vtk_encode_binary (sc_array_t *out, const char *numeric_data,
+                      size_t byte_length, int num_threads)
+{
+  size_t              head;
   uint32_t            int_header;
-  char               *base_data;
-  base64_encodestate  encode_state;
+  char                first[6];
 
   /* VTK format used 32bit header info */
   SC_ASSERT (byte_length <= (size_t) UINT32_MAX);
+  SC_ASSERT (out != NULL && out->elem_size == 1);
+  if (num_threads <= 0) {
+    num_threads = sc_thread_default_count ();
+  }
 
-  /* This value may be changed although this is not tested with VTK */
-  chunksize = (size_t) 1 << 15; /* 32768 */
+  /* the header and the data form one base 64 stream, so we code the
+   * header with the first two data bytes and the rest on a multiple of 3 */
   int_header = (uint32_t) byte_length;
+  memcpy (first, &int_header, 4);
+  head = SC_MIN (byte_length, 2);
+  memcpy (first + 4, numeric_data, head);
+  sc_array_resize (out, 0);
+  sc_io_vtk_base64 (out, first, 4 + head, 1);
+  if (byte_length > head) {
+    sc_io_vtk_base64 (out, numeric_data + head, byte_length - head,
+                      num_threads);
+  }
+}
+
+void
+sc_vtk_encode_compressed (sc_array_t *out, const char *numeric_data,
+                          size_t byte_length, int num_threads)
+{
+  size_t              b, pos, lastsize, header_entries;
+  uint32_t           *compression_header;
+  char               *comp;
+  sc_io_blocks_t      bt;
+
+  SC_ASSERT (byte_length <= (size_t) UINT32_MAX);
+  SC_ASSERT (out != NULL && out->elem_size == 1);
+  if (num_threads <= 0) {
+    num_threads = sc_thread_default_count ();
+  }
+
+  /* compress the blocks independently */
+  bt.data = (char *) numeric_data;
+  bt.data_size = byte_length;
+  bt.block_size = SC_IO_VTK_BLOCK_SIZE;
+  bt.num_blocks = (byte_length + bt.block_size - 1) / bt.block_size;
+  bt.bound = sc_io_compress_bound (bt.block_size);
+  bt.packed = SC_ALLOC (char, SC_MAX (bt.num_blocks, 1) * bt.bound);
+  bt.sizes = SC_ALLOC (size_t, SC_MAX (bt.num_blocks, 1));
+  bt.level = Z_BEST_COMPRESSION;
+  if (bt.num_blocks > 0) {
+    sc_thread_fork_join ((int) SC_MIN ((size_t) num_threads, bt.num_blocks),
+                         sc_io_blocks_compress, &bt);
+  }
+
+  /* the header lists the number and the sizes of the blocks */
+  lastsize = byte_length % bt.block_size;
+  header_entries = 3 + bt.num_blocks;
+  compression_header = SC_ALLOC (uint32_t, header_entries);
+  compression_header[0] = (uint32_t) bt.num_blocks;
+  compression_header[1] = (uint32_t) bt.block_size;
+  compression_header[2] = (uint32_t)
+    (lastsize > 0 || byte_length == 0 ? lastsize : bt.block_size);
+  for (pos = 0, b = 0; b < bt.num_blocks; ++b) {
+    compression_header[3 + b] = (uint32_t) bt.sizes[b];
+    pos += bt.sizes[b];
+  }
+
+  /* the header and the concatenated blocks are coded separately */
+  comp = SC_ALLOC (char, SC_MAX (pos, 1));
+  for (pos = 0, b = 0; b < bt.num_blocks; ++b) {
+    memcpy (comp + pos, bt.packed + b * bt.bound, bt.sizes[b]);
+    pos += bt.sizes[b];
+  }
+  sc_array_resize (out, 0);
+  sc_io_vtk_base64 (out, (const char *) compression_header,
+                    header_entries * sizeof (uint32_t), 1);
+  sc_io_vtk_base64 (out, comp, pos, num_threads);
+
+  SC_FREE (comp);
+  SC_FREE (compression_header);
+  SC_FREE (bt.sizes);
+  SC_FREE (bt.packed);
+}
+
+int
+sc_vtk_write_binary (FILE * vtkfile, char *numeric_data, size_t byte_length)
+{
+  sc_array_t          encoded;
 
-  /* Allocate sufficient memory for base64 encoder */
-  code_length = 2 * SC_MAX (chunksize, sizeof (int_header));
-  code_length = SC_MAX (code_length, 4) + 1;
-  base_data = SC_ALLOC (char, code_length);
-
-  base64_init_encodestate (&encode_state);
-  base_length =
-    base64_encode_block ((char *) &int_header, sizeof (int_header), base_data,
-                         &encode_state);
-  SC_ASSERT (base_length < code_length);
-  base_data[base_length] = '\0';
-  (void) fwrite (base_data, 1, base_length, vtkfile);
-
-  chunks = 0;
-  remaining = byte_length;
-  while (remaining > 0) {
-    writenow = SC_MIN (remaining, chunksize);
-    base_length = base64_encode_block (numeric_data + chunks * chunksize,
-                                       writenow, base_data, &encode_state);
-    SC_ASSERT (base_length < code_length);
-    base_data[base_length] = '\0';
-    (void) fwrite (base_data, 1, base_length, vtkfile);
-    remaining -= writenow;
-    ++chunks;
-  }
-
-  base_length = base64_encode_blockend (base_data, &encode_state);
-  SC_ASSERT (base_length < code_length);
-  base_data[base_length] = '\0';
-  (void) fwrite (base_data, 1, base_length, vtkfile);
-
-  SC_FREE (base_data);
+  sc_array_init (&encoded, 1);
+  sc_vtk_encode_binary (&encoded, numeric_data, byte_length, 1);
+  (void) fwrite (encoded.array, 1, encoded.elem_count, vtkfile);
+  sc_array_reset (&encoded);
   if (ferror (vtkfile)) {
     return -1;
   }
   return 0;
 }
 
-#define SC_IO_CHECK_ZLIB(r) SC_CHECK_ABORT ((r) == Z_OK, "zlib error")
-
 int
 sc_vtk_write_compressed (FILE * vtkfile, char *numeric_data,
                          size_t byte_length)
 {
-#ifdef SC_HAVE_ZLIB
-  int                 retval, fseek1, fseek2;
-  size_t              iz;
-  size_t              blocksize, lastsize;
-  size_t              theblock, numregularblocks, numfullblocks;
-  size_t              header_entries, header_size;
-  size_t              code_length, base_length;
-  long                header_pos, final_pos;
-  char               *comp_data, *base_data;
-  uint32_t           *compression_header;
-  uLongf              comp_length;
-  base64_encodestate  encode_state;
-
-  /* compute block sizes */
-  blocksize = (size_t) (1 << 15);       /* 32768 */
-  lastsize = byte_length % blocksize;
-  numregularblocks = byte_length / blocksize;
-  numfullblocks = numregularblocks + (lastsize > 0 ? 1 : 0);
-  header_entries = 3 + numfullblocks;
-  header_size = header_entries * sizeof (uint32_t);
-
-  /* allocate compression and base64 arrays */
-  code_length = 2 * SC_MAX (blocksize, header_size) + 4 + 1;
-  comp_data = SC_ALLOC (char, code_length);
-  base_data = SC_ALLOC (char, code_length);
-
-  /* figure out the size of the header and write a dummy */
-  compression_header = SC_ALLOC (uint32_t, header_entries);
-  compression_header[0] = (uint32_t) numfullblocks;
-  compression_header[1] = (uint32_t) blocksize;
-  compression_header[2] = (uint32_t)
-    (lastsize > 0 || byte_length == 0 ? lastsize : blocksize);
-  for (iz = 3; iz < header_entries; ++iz) {
-    compression_header[iz] = 0;
-  }
-  base64_init_encodestate (&encode_state);
-  base_length = base64_encode_block ((char *) compression_header,
-                                     header_size, base_data, &encode_state);
-  base_length +=
-    base64_encode_blockend (base_data + base_length, &encode_state);
-  SC_ASSERT (base_length < code_length);
-  base_data[base_length] = '\0';
-  header_pos = ftell (vtkfile);
-  (void) fwrite (base_data, 1, base_length, vtkfile);
-
-  /* write the regular data blocks */
-  base64_init_encodestate (&encode_state);
-  for (theblock = 0; theblock < numregularblocks; ++theblock) {
-    comp_length = code_length;
-    retval = compress2 ((Bytef *) comp_data, &comp_length,
-                        (const Bytef *) (numeric_data + theblock * blocksize),
-                        (uLong) blocksize, Z_BEST_COMPRESSION);
-    SC_IO_CHECK_ZLIB (retval);
-    compression_header[3 + theblock] = comp_length;
-    base_length = base64_encode_block (comp_data, comp_length,
-                                       base_data, &encode_state);
-    SC_ASSERT (base_length < code_length);
-    base_data[base_length] = '\0';
-    (void) fwrite (base_data, 1, base_length, vtkfile);
-  }
-
-  /* write odd-sized last block if necessary */
-  if (lastsize > 0) {
-    comp_length = code_length;
-    retval = compress2 ((Bytef *) comp_data, &comp_length,
-                        (const Bytef *) (numeric_data + theblock * blocksize),
-                        (uLong) lastsize, Z_BEST_COMPRESSION);
-    SC_IO_CHECK_ZLIB (retval);
-    compression_header[3 + theblock] = comp_length;
-    base_length = base64_encode_block (comp_data, comp_length,
-                                       base_data, &encode_state);
-    SC_ASSERT (base_length < code_length);
-    base_data[base_length] = '\0';
-    (void) fwrite (base_data, 1, base_length, vtkfile);
-  }
-
-  /* write base64 end block */
-  base_length = base64_encode_blockend (base_data, &encode_state);
-  SC_ASSERT (base_length < code_length);
-  base_data[base_length] = '\0';
-  (void) fwrite (base_data, 1, base_length, vtkfile);
-
-  /* seek back, write header block, seek forward */
-  final_pos = ftell (vtkfile);
-  base64_init_encodestate (&encode_state);
-  base_length = base64_encode_block ((char *) compression_header,
-                                     header_size, base_data, &encode_state);
-  base_length +=
-    base64_encode_blockend (base_data + base_length, &encode_state);
-  SC_ASSERT (base_length < code_length);
-  base_data[base_length] = '\0';
-  fseek1 = fseek (vtkfile, header_pos, SEEK_SET);
-  (void) fwrite (base_data, 1, base_length, vtkfile);
-  fseek2 = fseek (vtkfile, final_pos, SEEK_SET);
-
-  /* clean up and return */
-  SC_FREE (compression_header);
-  SC_FREE (comp_data);
-  SC_FREE (base_data);
-  if (fseek1 != 0 || fseek2 != 0 || ferror (vtkfile)) {
+  sc_array_t          encoded;
+
+  sc_array_init (&encoded, 1);
+  sc_vtk_encode_compressed (&encoded, numeric_data, byte_length, 1);
+  (void) fwrite (encoded.array, 1, encoded.elem_count, vtkfile);
+  sc_array_reset (&encoded);
+  if (ferror (vtkfile)) {
     return -1;
   }
-#else
-  SC_ABORT ("Configure did not find a recent enough zlib.  Abort.\n");
-#endif
+  return 0;
+}
+
+int
+sc_vtk_write_appended_all (sc_MPI_Comm mpicomm, sc_MPI_File mpifile,
+                           sc_MPI_Offset *offset, sc_array_t *encoded,
+                           sc_MPI_Offset *rank_offset)
+{
+  int                 mpiret, errcode, ocount;
+  long long           mine, before, total;
+
+  SC_ASSERT (offset != NULL && encoded != NULL);
+  SC_ASSERT (encoded->elem_size == 1);
+  SC_CHECK_ABORT (encoded->elem_count <= (size_t) INT_MAX,
+                  "vtk_write_appended_all: data too large");
+
+  /* the ranks write their pieces in rank order */
+  mine = (long long) encoded->elem_count;
+  mpiret = sc_MPI_Scan (&mine, &before, 1, sc_MPI_LONG_LONG_INT,
+                        sc_MPI_SUM, mpicomm);
+  SC_CHECK_MPI (mpiret);
+  before -= mine;
+  mpiret = sc_MPI_Allreduce (&mine, &total, 1, sc_MPI_LONG_LONG_INT,
+                             sc_MPI_SUM, mpicomm);
+  SC_CHECK_MPI (mpiret);
+  if (rank_offset != NULL) {
+    *rank_offset = (sc_MPI_Offset) before;
+  }
 
-  return 0;
+  errcode = sc_io_write_at_all (mpifile, *offset + (sc_MPI_Offset) before,
+                                encoded->array, encoded->elem_count,
+                                sc_MPI_BYTE, &ocount);
+  if (errcode == sc_MPI_SUCCESS && ocount != (int) encoded->elem_count) {
+    errcode = sc_MPI_ERR_IO;
+  }
+  *offset += (sc_MPI_Offset) total;
+  return errcode;
 }
 
 FILE               *
@@ -1458,6 +5034,170 @@ sc_io_open (sc_MPI_Comm mpicomm, const char *filename,
 #endif
 }
 
+void
+sc_io_hints_init (sc_io_hints_t * hints)
+{
+  memset (hints, 0, sizeof (*hints));
+  hints->stripe_bytes = SC_IO_HINTS_STRIPE_BYTES;
+}
+
+void
+sc_io_hints_add_options (sc_io_hints_t * hints, sc_options_t * opt)
+{
+  sc_options_add_int (opt, '\0', "striping-factor",
+                      &hints->striping_factor, hints->striping_factor,
+                      "Number of stripes, 0 for default, -1 automatic");
+  sc_options_add_size_t (opt, '\0', "striping-unit",
+                         &hints->striping_unit, hints->striping_unit,
+                         "Bytes per stripe, 0 for default");
+  sc_options_add_int (opt, '\0', "cb-nodes", &hints->cb_nodes,
+                      hints->cb_nodes, "Number of I/O aggregators");
+  sc_options_add_size_t (opt, '\0', "cb-buffer-size",
+                         &hints->cb_buffer_size, hints->cb_buffer_size,
+                         "Bytes of the collective buffer");
+  sc_options_add_string (opt, '\0', "cb-write", &hints->cb_write,
+                         hints->cb_write,
+                         "Collective buffering on write: enable, disable,"
+                         " automatic");
+  sc_options_add_string (opt, '\0', "cb-read", &hints->cb_read,
+                         hints->cb_read, "Collective buffering on read");
+  sc_options_add_string (opt, '\0', "io-hints", &hints->extra,
+                         hints->extra, "Further MPI I/O hints as"
+                         " key=value,key=value");
+  sc_options_add_size_t (opt, '\0', "stripe-bytes", &hints->stripe_bytes,
+                         hints->stripe_bytes,
+                         "Expected bytes per automatic stripe");
+  sc_options_add_int (opt, '\0', "max-stripes", &hints->max_stripes,
+                      hints->max_stripes,
+                      "Most automatic stripes if positive");
+}
+
+int
+sc_io_hints_stripes (const sc_io_hints_t * hints, int mpisize,
+                     size_t expected_size)
+{
+  size_t              n;
+
+  SC_ASSERT (mpisize > 0);
+
+  if (hints->striping_factor >= 0) {
+    return hints->striping_factor;
+  }
+
+  /* one stripe per expected stripe size and at most one per process */
+  SC_ASSERT (hints->stripe_bytes > 0);
+  n = (expected_size + hints->stripe_bytes - 1) / hints->stripe_bytes;
+  n = SC_MIN (n, (size_t) mpisize);
+  if (hints->max_stripes > 0) {
+    n = SC_MIN (n, (size_t) hints->max_stripes);
+  }
+  return (int) SC_MAX (n, 1);
+}
+
+#ifdef SC_ENABLE_MPIIO
+
+static void
+sc_io_hints_set_int (MPI_Info info, const char *key, long long value)
+{
+  int                 mpiret;
+  char                buffer[BUFSIZ];
+
+  if (value > 0) {
+    snprintf (buffer, BUFSIZ, "%lld", value);
+    mpiret = MPI_Info_set (info, key, buffer);
+    SC_CHECK_MPI (mpiret);
+  }
+}
+
+#endif
+
+void
+sc_io_hints_info (const sc_io_hints_t * hints, sc_MPI_Comm mpicomm,
+                  size_t expected_size, sc_MPI_Info * mpiinfo)
+{
+#ifdef SC_ENABLE_MPIIO
+  int                 mpiret;
+  int                 mpisize, stripes;
+  char               *extra, *pair, *next, *value;
+
+  mpiret = sc_MPI_Comm_size (mpicomm, &mpisize);
+  SC_CHECK_MPI (mpiret);
+  mpiret = MPI_Info_create (mpiinfo);
+  SC_CHECK_MPI (mpiret);
+
+  stripes = sc_io_hints_stripes (hints, mpisize, expected_size);
+  sc_io_hints_set_int (*mpiinfo, "striping_factor", stripes);
+  sc_io_hints_set_int (*mpiinfo, "striping_unit",
+                       (long long) hints->striping_unit);
+  sc_io_hints_set_int (*mpiinfo, "cb_nodes", hints->cb_nodes > 0 ?
+                       hints->cb_nodes : hints->striping_factor < 0 ?
+                       stripes : 0);
+  sc_io_hints_set_int (*mpiinfo, "cb_buffer_size",
+                       (long long) hints->cb_buffer_size);
+  if (hints->cb_write != NULL) {
+    mpiret = MPI_Info_set (*mpiinfo, "romio_cb_write", hints->cb_write);
+    SC_CHECK_MPI (mpiret);
+  }
+  if (hints->cb_read != NULL) {
+    mpiret = MPI_Info_set (*mpiinfo, "romio_cb_read", hints->cb_read);
+    SC_CHECK_MPI (mpiret);
+  }
+
+  /* the extra hints are split at commas and each at the first equal */
+  if (hints->extra != NULL) {
+    extra = SC_STRDUP (hints->extra);
+    for (pair = extra; pair != NULL; pair = next) {
+      if ((next = strchr (pair, ',')) != NULL) {
+        *next++ = '\0';
+      }
+      if (*pair == '\0') {
+        continue;
+      }
+      value = strchr (pair, '=');
+      SC_CHECK_ABORTF (value != NULL && value > pair,
+                       "Invalid I/O hint %s", pair);
+      *value++ = '\0';
+      mpiret = MPI_Info_set (*mpiinfo, pair, value);
+      SC_CHECK_MPI (mpiret);
+    }
+    SC_FREE (extra);
+  }
+#else
+  *mpiinfo = sc_MPI_INFO_NULL;
+#endif
+}
+
+void
+sc_io_hints_info_free (sc_MPI_Info * mpiinfo)
+{
+#ifdef SC_ENABLE_MPIIO
+  int                 mpiret;
+
+  if (*mpiinfo != MPI_INFO_NULL) {
+    mpiret = MPI_Info_free (mpiinfo);
+    SC_CHECK_MPI (mpiret);
+  }
+#endif
+  *mpiinfo = sc_MPI_INFO_NULL;
+}
+
+int
+sc_io_open_hints (sc_MPI_Comm mpicomm, const char *filename,
+                  sc_io_open_mode_t amode, const sc_io_hints_t * hints,
+                  size_t expected_size, sc_MPI_File * mpifile)
+{
+  int                 errcode;
+  sc_MPI_Info         mpiinfo = sc_MPI_INFO_NULL;
+
+  if (hints != NULL) {
+    sc_io_hints_info (hints, mpicomm, expected_size, &mpiinfo);
+  }
+  errcode = sc_io_open (mpicomm, filename, amode, mpiinfo, mpifile);
+  sc_io_hints_info_free (&mpiinfo);
+
+  return errcode;
+}
+
 void
 sc_io_read (sc_MPI_File mpifile, void *ptr, size_t zcount,
             sc_MPI_Datatype t, const char *errmsg)
@@ -1533,21 +5273,15 @@ sc_io_read_at_all (sc_MPI_File mpifile, sc_MPI_Offset offset, void *ptr,
 
   *ocount = 0;
 
-  if (zcount == 0) {
-    /* This should not be necessary according to the MPI standard but some
-     * MPI implementations trigger valgrind warnings due to uninitialized
-     * MPI status members.
-     */
-    mpiret = sc_MPI_SUCCESS;
-
-    retval = sc_io_error_class (mpiret, &errcode);
-    SC_CHECK_MPI (retval);
-
-    return errcode;
-  }
-
+  /* the call is collective, so processes without data take part as well */
   mpiret = MPI_File_read_at_all (mpifile, offset, ptr,
                                  (int) zcount, t, &mpistatus);
+  if (mpiret == sc_MPI_SUCCESS && zcount == 0) {
+    /* Some MPI implementations trigger valgrind warnings due to
+     * uninitialized MPI status members on empty access.
+     */
+    return sc_MPI_SUCCESS;
+  }
   if (mpiret == sc_MPI_SUCCESS) {
     mpiret = sc_MPI_Get_count (&mpistatus, t, ocount);
     SC_CHECK_MPI (mpiret);
@@ -1799,21 +5533,15 @@ sc_io_write_at_all (sc_MPI_File mpifile, sc_MPI_Offset offset,
 
   *ocount = 0;
 
-  if (zcount == 0) {
-    /* This should not be necessary according to the MPI standard but some
-     * MPI imlementations trigger valgrind warnings due to uninitialized
-     * MPI status members.
-     */
-    mpiret = sc_MPI_SUCCESS;
-
-    retval = sc_io_error_class (mpiret, &errcode);
-    SC_CHECK_MPI (retval);
-
-    return errcode;
-  }
-
+  /* the call is collective, so processes without data take part as well */
   mpiret = MPI_File_write_at_all (mpifile, offset, (void *) ptr,
                                   (int) zcount, t, &mpistatus);
+  if (mpiret == sc_MPI_SUCCESS && zcount == 0) {
+    /* Some MPI implementations trigger valgrind warnings due to
+     * uninitialized MPI status members on empty access.
+     */
+    return sc_MPI_SUCCESS;
+  }
   if (mpiret == sc_MPI_SUCCESS) {
     mpiret = sc_MPI_Get_count (&mpistatus, t, ocount);
     SC_CHECK_MPI (mpiret);
@@ -1984,6 +5712,499 @@ sc_io_write_all (sc_MPI_File mpifile, const void *ptr, size_t zcount,
   return sc_io_write_at_all (mpifile, 0, ptr, zcount, t, ocount);
 }
 
+int
+sc_io_write_at_all_aggregated (sc_MPI_Comm mpicomm, sc_MPI_File mpifile,
+                               sc_MPI_Offset offset, const void *ptr,
+                               size_t zcount, sc_MPI_Datatype t,
+                               int num_aggregators, int *ocount)
+{
+#ifndef SC_ENABLE_MPI
+  SC_ASSERT (mpicomm == sc_MPI_COMM_WORLD || mpicomm == sc_MPI_COMM_SELF);
+  return sc_io_write_at_all (mpifile, offset, ptr, zcount, t, ocount);
+#else
+  int                 mpiret, errcode;
+  int                 rank, mpisize, grank, gsize, size;
+  int                 color, i, mycount, oc;
+  int                 ext[2], bounds[2], contiguous, intrarank, nodes;
+  int                *counts, *displs;
+  long long           myoffset, total, *offsets;
+  char               *gathered;
+  sc_MPI_Comm         intranode, internode, group;
+#ifdef SC_ENABLE_MPIIO
+  int                 j, run;
+#else
+  sc_MPI_Comm         aggcomm, saved;
+#endif
+
+  *ocount = 0;
+  mpiret = sc_MPI_Comm_rank (mpicomm, &rank);
+  SC_CHECK_MPI (mpiret);
+  mpiret = sc_MPI_Comm_size (mpicomm, &mpisize);
+  SC_CHECK_MPI (mpiret);
+  mpiret = sc_MPI_Type_size (t, &size);
+  SC_CHECK_MPI (mpiret);
+  SC_CHECK_ABORT (zcount * (size_t) size <= (size_t) INT_MAX,
+                  "write_at_all_aggregated: data too large");
+  mycount = (int) (zcount * (size_t) size);
+
+  /* the aggregator groups are ranges of consecutive ranks */
+  color = -1;
+  if (num_aggregators <= 0) {
+    num_aggregators = 1;
+    sc_mpi_comm_get_node_comms (mpicomm, &intranode, &internode);
+    if (intranode != sc_MPI_COMM_NULL) {
+      /* use the nodes if their ranks are consecutive */
+      bounds[0] = -rank;
+      bounds[1] = rank;
+      mpiret = sc_MPI_Allreduce (bounds, ext, 2, sc_MPI_INT, sc_MPI_MAX,
+                                 intranode);
+      SC_CHECK_MPI (mpiret);
+      mpiret = sc_MPI_Comm_size (intranode, &gsize);
+      SC_CHECK_MPI (mpiret);
+      mpiret = sc_MPI_Comm_rank (intranode, &intrarank);
+      SC_CHECK_MPI (mpiret);
+      contiguous = ext[1] + ext[0] + 1 == gsize;
+      mpiret = sc_MPI_Allreduce (&contiguous, bounds, 1, sc_MPI_INT,
+                                 sc_MPI_MIN, mpicomm);
+      SC_CHECK_MPI (mpiret);
+      intrarank = intrarank == 0;
+      mpiret = sc_MPI_Allreduce (&intrarank, &nodes, 1, sc_MPI_INT,
+                                 sc_MPI_SUM, mpicomm);
+      SC_CHECK_MPI (mpiret);
+      if (bounds[0]) {
+        color = -ext[0];
+      }
+      else {
+        num_aggregators = nodes;
+      }
+    }
+  }
+  if (color < 0) {
+    num_aggregators = SC_MIN (num_aggregators, mpisize);
+    color = (int) ((long long) rank * num_aggregators / mpisize);
+  }
+  mpiret = sc_MPI_Comm_split (mpicomm, color, rank, &group);
+  SC_CHECK_MPI (mpiret);
+  mpiret = sc_MPI_Comm_rank (group, &grank);
+  SC_CHECK_MPI (mpiret);
+  mpiret = sc_MPI_Comm_size (group, &gsize);
+  SC_CHECK_MPI (mpiret);
+
+  /* gather the data of each group on its first rank */
+  counts = displs = NULL;
+  offsets = NULL;
+  gathered = NULL;
+  total = 0;
+  if (grank == 0) {
+    counts = SC_ALLOC (int, gsize);
+    displs = SC_ALLOC (int, gsize);
+    offsets = SC_ALLOC (long long, gsize);
+  }
+  myoffset = (long long) offset;
+  mpiret = sc_MPI_Gather (&mycount, 1, sc_MPI_INT, counts, 1, sc_MPI_INT,
+                          0, group);
+  SC_CHECK_MPI (mpiret);
+  mpiret = sc_MPI_Gather (&myoffset, 1, sc_MPI_LONG_LONG_INT, offsets, 1,
+                          sc_MPI_LONG_LONG_INT, 0, group);
+  SC_CHECK_MPI (mpiret);
+  if (grank == 0) {
+    for (i = 0; i < gsize; ++i) {
+      displs[i] = (int) total;
+      total += counts[i];
+      SC_CHECK_ABORT (total <= (long long) INT_MAX,
+                      "write_at_all_aggregated: group data too large");
+    }
+    gathered = SC_ALLOC (char, total);
+  }
+  mpiret = sc_MPI_Gatherv ((void *) ptr, mycount, sc_MPI_BYTE, gathered,
+                           counts, displs, sc_MPI_BYTE, 0, group);
+  SC_CHECK_MPI (mpiret);
+
+  /* the aggregators write large contiguous pieces */
+  errcode = sc_MPI_SUCCESS;
+#ifdef SC_ENABLE_MPIIO
+  if (grank == 0) {
+    for (i = 0; i < gsize && errcode == sc_MPI_SUCCESS; i = j) {
+      /* merge the following ranks whose data continues in the file */
+      for (run = counts[i], j = i + 1;
+           j < gsize && offsets[j] == offsets[i] + run; ++j) {
+        run += counts[j];
+      }
+      if (run > 0) {
+        errcode = sc_io_write_at (mpifile, (sc_MPI_Offset) offsets[i],
+                                  gathered + displs[i], (size_t) run,
+                                  sc_MPI_BYTE, &oc);
+        if (errcode == sc_MPI_SUCCESS && oc != run) {
+          errcode = sc_MPI_ERR_IO;
+        }
+      }
+    }
+  }
+#else
+  /* serialize the appends of the aggregators in rank order */
+  mpiret = sc_MPI_Comm_split (mpicomm, grank == 0 ? 0 : sc_MPI_UNDEFINED,
+                              rank, &aggcomm);
+  SC_CHECK_MPI (mpiret);
+  if (grank == 0) {
+    saved = mpifile->mpicomm;
+    mpifile->mpicomm = aggcomm;
+    errcode = sc_io_write_at_all (mpifile, offset, gathered, (size_t) total,
+                                  sc_MPI_BYTE, &oc);
+    mpifile->mpicomm = saved;
+    if (errcode == sc_MPI_SUCCESS && oc != (int) total) {
+      errcode = sc_MPI_ERR_IO;
+    }
+    mpiret = sc_MPI_Comm_free (&aggcomm);
+    SC_CHECK_MPI (mpiret);
+  }
+#endif
+
+  /* every rank learns the result of its aggregator */
+  mpiret = sc_MPI_Bcast (&errcode, 1, sc_MPI_INT, 0, group);
+  SC_CHECK_MPI (mpiret);
+  if (errcode == sc_MPI_SUCCESS) {
+    *ocount = (int) zcount;
+  }
+
+  SC_FREE (counts);
+  SC_FREE (displs);
+  SC_FREE (offsets);
+  SC_FREE (gathered);
+  mpiret = sc_MPI_Comm_free (&group);
+  SC_CHECK_MPI (mpiret);
+  return errcode;
+#endif
+}
+
+/** Bytes read by one aggregator in one collective call. */
+#define SC_IO_PARTITION_CHUNK ((size_t) 1 << 30)
+
+int
+sc_io_read_at_all_partition (sc_MPI_Comm mpicomm, sc_MPI_File mpifile,
+                             sc_MPI_Offset offset, void *ptr,
+                             size_t elem_size,
+                             const int64_t * old_partition, int old_size,
+                             const int64_t * new_partition,
+                             int num_aggregators)
+{
+  int                 mpiret, retval, errcode, errmax, oc;
+  int                 rank, mpisize, a, myagg, q, intrarank;
+  int64_t             total, lo, hi, *bounds;
+  long long           rounds, myrounds, r;
+  size_t              stripe_bytes, piece;
+  ssize_t             first;
+  char               *stripe, *dest;
+  sc_MPI_Comm         intranode, internode;
+  sc_array_t          requests;
+
+  mpiret = sc_MPI_Comm_rank (mpicomm, &rank);
+  SC_CHECK_MPI (mpiret);
+  mpiret = sc_MPI_Comm_size (mpicomm, &mpisize);
+  SC_CHECK_MPI (mpiret);
+  SC_ASSERT (old_size >= 0 && elem_size > 0);
+  SC_ASSERT (old_partition[0] == new_partition[0]);
+  SC_ASSERT (old_partition[old_size] == new_partition[mpisize]);
+
+  /* choose one aggregator per node or as requested */
+  if (num_aggregators <= 0) {
+    num_aggregators = 1;
+    sc_mpi_comm_get_node_comms (mpicomm, &intranode, &internode);
+    if (intranode != sc_MPI_COMM_NULL) {
+      mpiret = sc_MPI_Comm_rank (intranode, &intrarank);
+      SC_CHECK_MPI (mpiret);
+      intrarank = intrarank == 0;
+      mpiret = sc_MPI_Allreduce (&intrarank, &num_aggregators, 1,
+                                 sc_MPI_INT, sc_MPI_SUM, mpicomm);
+      SC_CHECK_MPI (mpiret);
+    }
+  }
+  num_aggregators = SC_MIN (num_aggregators, mpisize);
+  myagg = (int) (((long long) rank * num_aggregators + mpisize - 1) /
+                 mpisize);
+  if (myagg >= num_aggregators ||
+      (long long) myagg * mpisize / num_aggregators != rank) {
+    myagg = -1;
+  }
+
+  /* each stripe consists of the data of consecutive writers */
+  bounds = SC_ALLOC (int64_t, num_aggregators + 1);
+  total = old_partition[old_size] - old_partition[0];
+  for (a = 0; a < num_aggregators; ++a) {
+    lo = old_partition[0] + total / num_aggregators * a +
+      total % num_aggregators * a / num_aggregators;
+    first = sc_search_lower_bound64 (lo, old_partition,
+                                     (size_t) old_size + 1, 0);
+    SC_ASSERT (first >= 0);
+    bounds[a] = old_partition[first];
+  }
+  bounds[num_aggregators] = old_partition[old_size];
+
+  /* the aggregators read their stripes in few large pieces */
+  stripe = NULL;
+  stripe_bytes = 0;
+  if (myagg >= 0) {
+    stripe_bytes = (size_t) (bounds[myagg + 1] - bounds[myagg]) * elem_size;
+    stripe = SC_ALLOC (char, stripe_bytes);
+  }
+  myrounds = (long long) ((stripe_bytes + SC_IO_PARTITION_CHUNK - 1) /
+                          SC_IO_PARTITION_CHUNK);
+  mpiret = sc_MPI_Allreduce (&myrounds, &rounds, 1, sc_MPI_LONG_LONG_INT,
+                             sc_MPI_MAX, mpicomm);
+  SC_CHECK_MPI (mpiret);
+  errcode = sc_MPI_SUCCESS;
+  for (r = 0; r < rounds; ++r) {
+    piece = 0;
+    if (r < myrounds) {
+      piece = SC_MIN (SC_IO_PARTITION_CHUNK,
+                      stripe_bytes - (size_t) r * SC_IO_PARTITION_CHUNK);
+    }
+    retval = sc_io_read_at_all
+      (mpifile, offset + (sc_MPI_Offset)
+       ((size_t) (bounds[SC_MAX (myagg, 0)] - old_partition[0]) *
+        elem_size + (size_t) r * SC_IO_PARTITION_CHUNK),
+       stripe + (piece > 0 ? (size_t) r * SC_IO_PARTITION_CHUNK : 0),
+       (int) piece, sc_MPI_BYTE, &oc);
+    if (errcode == sc_MPI_SUCCESS) {
+      errcode = retval == sc_MPI_SUCCESS && oc != (int) piece ?
+        sc_MPI_ERR_IO : retval;
+    }
+  }
+  mpiret = sc_MPI_Allreduce (&errcode, &errmax, 1, sc_MPI_INT,
+                             sc_MPI_MAX, mpicomm);
+  SC_CHECK_MPI (mpiret);
+  if (errmax != sc_MPI_SUCCESS) {
+    SC_FREE (stripe);
+    SC_FREE (bounds);
+    return errmax;
+  }
+
+  /* receive the overlap of every stripe with the local range */
+  sc_array_init (&requests, sizeof (sc_MPI_Request));
+  for (a = 0; a < num_aggregators; ++a) {
+    q = (int) ((long long) a * mpisize / num_aggregators);
+    lo = SC_MAX (bounds[a], new_partition[rank]);
+    hi = SC_MIN (bounds[a + 1], new_partition[rank + 1]);
+    if (q == rank || lo >= hi) {
+      continue;
+    }
+    SC_CHECK_ABORT ((size_t) (hi - lo) * elem_size <= (size_t) INT_MAX,
+                    "read_at_all_partition: message too large");
+    dest = (char *) ptr + (size_t) (lo - new_partition[rank]) * elem_size;
+    mpiret = sc_MPI_Irecv (dest, (int) ((size_t) (hi - lo) * elem_size),
+                           sc_MPI_BYTE, q, SC_TAG_IO_PARTITION, mpicomm,
+                           (sc_MPI_Request *) sc_array_push (&requests));
+    SC_CHECK_MPI (mpiret);
+  }
+
+  /* send the stripe to the ranks whose new range overlaps it */
+  if (myagg >= 0 && bounds[myagg] < bounds[myagg + 1]) {
+    first = sc_search_lower_bound64 (bounds[myagg] + 1, new_partition + 1,
+                                     (size_t) mpisize, 0);
+    SC_ASSERT (first >= 0);
+    for (q = (int) first; q < mpisize &&
+         new_partition[q] < bounds[myagg + 1]; ++q) {
+      lo = SC_MAX (bounds[myagg], new_partition[q]);
+      hi = SC_MIN (bounds[myagg + 1], new_partition[q + 1]);
+      if (lo >= hi) {
+        continue;
+      }
+      dest = stripe + (size_t) (lo - bounds[myagg]) * elem_size;
+      if (q == rank) {
+        memcpy ((char *) ptr + (size_t) (lo - new_partition[rank]) *
+                elem_size, dest, (size_t) (hi - lo) * elem_size);
+        continue;
+      }
+      SC_CHECK_ABORT ((size_t) (hi - lo) * elem_size <= (size_t) INT_MAX,
+                      "read_at_all_partition: message too large");
+      mpiret = sc_MPI_Isend (dest, (int) ((size_t) (hi - lo) * elem_size),
+                             sc_MPI_BYTE, q, SC_TAG_IO_PARTITION, mpicomm,
+                             (sc_MPI_Request *) sc_array_push (&requests));
+      SC_CHECK_MPI (mpiret);
+    }
+  }
+  mpiret = sc_MPI_Waitall ((int) requests.elem_count,
+                           (sc_MPI_Request *) requests.array,
+                           sc_MPI_STATUSES_IGNORE);
+  SC_CHECK_MPI (mpiret);
+
+  sc_array_reset (&requests);
+  SC_FREE (stripe);
+  SC_FREE (bounds);
+  return sc_MPI_SUCCESS;
+}
+
+#if defined SC_ENABLE_MPIIO && \
+  (MPI_VERSION > 3 || (MPI_VERSION == 3 && MPI_SUBVERSION >= 1))
+#define SC_IO_HAVE_IMPIIO
+#endif
+
+struct sc_io_request
+{
+#ifdef SC_IO_HAVE_IMPIIO
+  sc_MPI_Request      request;
+  sc_MPI_Datatype     t;
+  int                 empty;    /**< No status is queried if true. */
+#endif
+  int                 done;     /**< The result below is final. */
+  int                 errcode;
+  int                 ocount;
+};
+
+#ifdef SC_IO_HAVE_IMPIIO
+
+/** Translate the return value of a nonblocking call into a request.
+ * An operation that fails to start completes with its error code.
+ */
+static void
+sc_io_irequest_start (sc_io_request_t * req, int mpiret)
+{
+  int                 retval;
+
+  if (mpiret != sc_MPI_SUCCESS) {
+    retval = sc_io_error_class (mpiret, &req->errcode);
+    SC_CHECK_MPI (retval);
+    req->done = 1;
+  }
+}
+
+/** Fill in the result of a completed nonblocking operation. */
+static void
+sc_io_irequest_finish (sc_io_request_t * req, int mpiret,
+                       sc_MPI_Status * mpistatus)
+{
+  int                 retval;
+
+  if (mpiret == sc_MPI_SUCCESS) {
+    if (!req->empty) {
+      mpiret = sc_MPI_Get_count (mpistatus, req->t, &req->ocount);
+      SC_CHECK_MPI (mpiret);
+    }
+    req->errcode = sc_MPI_SUCCESS;
+  }
+  else {
+    retval = sc_io_error_class (mpiret, &req->errcode);
+    SC_CHECK_MPI (retval);
+  }
+  req->done = 1;
+}
+
+#endif /* SC_IO_HAVE_IMPIIO */
+
+int
+sc_io_iread_at_all (sc_MPI_File mpifile, sc_MPI_Offset offset, void *ptr,
+                    int zcount, sc_MPI_Datatype t,
+                    sc_io_request_t ** request)
+{
+  sc_io_request_t    *req;
+
+  SC_ASSERT (request != NULL);
+
+  *request = req = SC_ALLOC_ZERO (sc_io_request_t, 1);
+#ifdef SC_IO_HAVE_IMPIIO
+  req->request = sc_MPI_REQUEST_NULL;
+  req->t = t;
+  /* the call is collective, so processes without data take part as well;
+     no status is queried for empty operations as in the blocking case */
+  req->empty = (zcount == 0);
+  sc_io_irequest_start (req, MPI_File_iread_at_all (mpifile, offset, ptr,
+                                                    zcount, t,
+                                                    &req->request));
+#else
+  /* the blocking call completes the operation right away */
+  req->errcode = sc_io_read_at_all (mpifile, offset, ptr, zcount, t,
+                                    &req->ocount);
+  req->done = 1;
+#endif
+  return req->done ? req->errcode : sc_MPI_SUCCESS;
+}
+
+int
+sc_io_iwrite_at_all (sc_MPI_File mpifile, sc_MPI_Offset offset,
+                     const void *ptr, size_t zcount, sc_MPI_Datatype t,
+                     sc_io_request_t ** request)
+{
+  sc_io_request_t    *req;
+
+  SC_ASSERT (request != NULL);
+
+  *request = req = SC_ALLOC_ZERO (sc_io_request_t, 1);
+#ifdef SC_IO_HAVE_IMPIIO
+  req->request = sc_MPI_REQUEST_NULL;
+  req->t = t;
+  /* the call is collective, so processes without data take part as well;
+     no status is queried for empty operations as in the blocking case */
+  req->empty = (zcount == 0);
+  sc_io_irequest_start (req, MPI_File_iwrite_at_all (mpifile, offset,
+                                                     (void *) ptr,
+                                                     (int) zcount, t,
+                                                     &req->request));
+#else
+  /* the blocking call completes the operation right away */
+  req->errcode = sc_io_write_at_all (mpifile, offset, ptr, zcount, t,
+                                     &req->ocount);
+  req->done = 1;
+#endif
+  return req->done ? req->errcode : sc_MPI_SUCCESS;
+}
+
+int
+sc_io_test (sc_io_request_t ** request, int *flag, int *ocount)
+{
+  int                 errcode;
+  sc_io_request_t    *req;
+
+  SC_ASSERT (request != NULL && *request != NULL);
+  SC_ASSERT (flag != NULL);
+
+  req = *request;
+#ifdef SC_IO_HAVE_IMPIIO
+  if (!req->done) {
+    int                 mpiret, completed;
+    sc_MPI_Status       mpistatus;
+
+    mpiret = MPI_Test (&req->request, &completed, &mpistatus);
+    if (mpiret != sc_MPI_SUCCESS || completed) {
+      sc_io_irequest_finish (req, mpiret, &mpistatus);
+    }
+  }
+#endif
+  *flag = req->done;
+  if (!req->done) {
+    return sc_MPI_SUCCESS;
+  }
+
+  /* the operation is complete and the request is freed */
+  errcode = req->errcode;
+  if (ocount != NULL) {
+    *ocount = req->ocount;
+  }
+  SC_FREE (req);
+  *request = NULL;
+  return errcode;
+}
+
+int
+sc_io_wait (sc_io_request_t ** request, int *ocount)
+{
+  int                 flag;
+  sc_io_request_t    *req;
+
+  SC_ASSERT (request != NULL && *request != NULL);
+
+  req = *request;
+#ifdef SC_IO_HAVE_IMPIIO
+  if (!req->done) {
+    int                 mpiret;
+    sc_MPI_Status       mpistatus;
+
+    mpiret = sc_MPI_Wait (&req->request, &mpistatus);
+    sc_io_irequest_finish (req, mpiret, &mpistatus);
+  }
+#endif
+  SC_ASSERT (req->done);
+  return sc_io_test (request, &flag, ocount);
+}
+
 int
 sc_io_close (sc_MPI_File * file)
 {
@@ -49,6 +49,7 @@
  */
 
 #include <sc_containers.h>
+#include <sc_options.h>
 
 /** Examine the MPI return value and print an error if there is one.
  * The message passed is appended to MPI, file and line information.
@@ -83,22 +84,80 @@ typedef enum
 }
 sc_io_mode_t;
 
+/** Transparent encodings of the data passing through sinks and sources.
+ * The compressing encodings require zlib; otherwise the sink and source
+ * constructors return NULL for them. */
 typedef enum
 {
   SC_IO_ENCODE_NONE,
+  SC_IO_ENCODE_ZLIB,    /**< Streaming zlib format, default level. */
+  SC_IO_ENCODE_ZLIB_FAST,       /**< Streaming zlib format, fastest level.
+                                     Read the same as SC_IO_ENCODE_ZLIB. */
   SC_IO_ENCODE_LAST     /**< Invalid entry to close list */
 }
 sc_io_encode_t;
 
+/** Checksum types selectable in \ref sc_io_encode_ext. */
+typedef enum
+{
+  SC_IO_CHECKSUM_ADLER32,       /**< Only the adler32 of the zlib format. */
+  SC_IO_CHECKSUM_CRC32C,        /**< Append a CRC32C of the original data. */
+  SC_IO_CHECKSUM_LAST           /**< Invalid entry to close list */
+}
+sc_io_checksum_t;
+
 typedef enum
 {
   SC_IO_TYPE_BUFFER,
   SC_IO_TYPE_FILENAME,
   SC_IO_TYPE_FILEFILE,
+  SC_IO_TYPE_MMAP,      /**< Source only: file mapped into memory. */
+  SC_IO_TYPE_STAGED,    /**< Sink only: file written through large
+                             aligned buffers, see
+                             \ref sc_io_sink_new_staged. */
   SC_IO_TYPE_LAST       /**< Invalid entry to close list */
 }
 sc_io_type_t;
 
+/** Flags for \ref sc_io_sink_new_staged. */
+typedef enum
+{
+  SC_IO_STAGED_DIRECT = 1       /**< Bypass the page cache by O_DIRECT. */
+}
+sc_io_staged_flags_t;
+
+/** The default size of each staging buffer of type STAGED in bytes. */
+#define SC_IO_STAGED_SIZE (1 << 22)
+
+/** Flags for \ref sc_io_source_set_readahead. */
+typedef enum
+{
+  SC_IO_READAHEAD_PREFETCH = 1  /**< Read the next chunk in the background. */
+}
+sc_io_readahead_flags_t;
+
+/** The default size of each read-ahead buffer of a file source in bytes. */
+#define SC_IO_READAHEAD_SIZE (1 << 20)
+
+/** Access pattern hints for \ref sc_io_source_advise. */
+typedef enum
+{
+  SC_IO_ADVICE_NORMAL,  /**< No particular access pattern. */
+  SC_IO_ADVICE_SEQUENTIAL,      /**< Read ahead aggressively. */
+  SC_IO_ADVICE_RANDOM,  /**< Do not read ahead. */
+  SC_IO_ADVICE_WILLNEED,        /**< Start reading the data now. */
+  SC_IO_ADVICE_LAST     /**< Invalid entry to close list */
+}
+sc_io_advice_t;
+
+/** One piece of data passed to \ref sc_io_sink_writev. */
+typedef struct sc_io_vec
+{
+  const void         *data;     /**< Start of the data. */
+  size_t              bytes;    /**< Number of bytes. */
+}
+sc_io_vec_t;
+
 typedef struct sc_io_sink
 {
   sc_io_type_t        iotype;
@@ -109,6 +168,8 @@ typedef struct sc_io_sink
   FILE               *file;
   size_t              bytes_in;
   size_t              bytes_out;
+  void               *staged;   /**< Internal state of type STAGED. */
+  void               *codec;    /**< Internal state of the encoding. */
 }
 sc_io_sink_t;
 
@@ -123,6 +184,15 @@ typedef struct sc_io_source
   size_t              bytes_out;
   sc_io_sink_t       *mirror;
   sc_array_t         *mirror_buffer;
+  sc_array_t         *mirror_extents;   /**< File ranges of a zero-copy
+                                             mirror. */
+  long                mirror_position;  /**< File offset of the next byte
+                                             read with a zero-copy mirror. */
+  char               *map;      /**< The mapping of type MMAP. */
+  size_t              map_size;
+  void               *readahead;        /**< Internal state of the
+                                             read-ahead of file types. */
+  void               *codec;    /**< Internal state of the encoding. */
 }
 sc_io_source_t;
 
@@ -139,19 +209,53 @@ sc_io_open_mode_t;
 
 /** Create a generic data sink.
  * \param [in] iotype           Type must be a value from \ref sc_io_type_t.
+ *                              The type MMAP is not supported for sinks.
  *                              Depending on iotype, varargs must follow:
  *                              BUFFER: sc_array_t * (existing array).
  *                              FILENAME: const char * (name of file to open).
  *                              FILEFILE: FILE * (file open for writing).
+ *                              STAGED: const char * (name of file to open),
+ *                              using the defaults of
+ *                              \ref sc_io_sink_new_staged.
  *                              These buffers are only borrowed by the sink.
  * \param [in] iomode           Mode must be a value from \ref sc_io_mode_t.
  *                              For type FILEFILE, data is always appended.
  * \param [in] ioencode         Must be a value from \ref sc_io_encode_t.
+ *                              With compression, bytes_in counts the data
+ *                              passed to write and bytes_out the encoded
+ *                              bytes.  Each sc_io_sink_complete ends one
+ *                              zlib stream, and a source of the same
+ *                              encoding reads the concatenation.
  * \return                      Newly allocated sink, or NULL on error.
  */
 sc_io_sink_t       *sc_io_sink_new (int iotype, int iomode,
                                     int ioencode, ...);
 
+/** Create a file sink that collects small writes in large buffers.
+ * Two page-aligned staging buffers are allocated.  When one buffer is
+ * full, it is written to the file by a background thread if pthreads are
+ * enabled, while the next writes fill the other buffer.  Only
+ * \ref sc_io_sink_complete and \ref sc_io_sink_destroy wait for the
+ * data to reach the file.  The counters bytes_in and bytes_out have the
+ * same meaning as for the type FILENAME.  Without POSIX file functions
+ * we return a sink of type FILENAME with a stdio buffer of this size.
+ * \param [in] filename         Name of the file to open for writing.
+ * \param [in] iomode           Mode must be a value from \ref sc_io_mode_t.
+ * \param [in] stage_size       Bytes in each staging buffer, rounded up
+ *                              to the page size.  If zero, we use
+ *                              \ref SC_IO_STAGED_SIZE.
+ * \param [in] flags            Bitwise or of \ref sc_io_staged_flags_t.
+ *                              With SC_IO_STAGED_DIRECT, full buffers are
+ *                              written with O_DIRECT where available.
+ *                              It is silently dropped if refused by the
+ *                              file system or when a partial buffer is
+ *                              written by \ref sc_io_sink_complete.
+ * \return                      Newly allocated sink, or NULL on error.
+ */
+sc_io_sink_t       *sc_io_sink_new_staged (const char *filename,
+                                           int iomode, size_t stage_size,
+                                           int flags);
+
 /** Free data sink.
  * Calls sc_io_sink_complete and discards the final counts.
  * Errors from complete lead to SC_IO_ERROR_FATAL returned from this function.
@@ -171,6 +275,23 @@ int                 sc_io_sink_destroy (sc_io_sink_t * sink);
 int                 sc_io_sink_write (sc_io_sink_t * sink,
                                       const void *data, size_t bytes_avail);
 
+/** Write several pieces of data to a sink in one call.
+ * For type BUFFER the array is resized once for the total size,
+ * and larger writes to the file types use writev(2) where available.
+ * Data may be buffered and sunk in a later call.
+ * The internal counters sink->bytes_in and sink->bytes_out are updated.
+ * \param [in,out] sink         The sink object to write to.
+ * \param [in] vec              Array of \a count pieces of data.
+ * \param [in] count            Number of pieces, may be zero.
+ * \param [in] bytes_align      If greater than 1, zero bytes are appended
+ *                              to align the output as by
+ *                              \ref sc_io_sink_align.
+ * \return                      0 on success, nonzero on error.
+ */
+int                 sc_io_sink_writev (sc_io_sink_t * sink,
+                                       const sc_io_vec_t * vec,
+                                       size_t count, size_t bytes_align);
+
 /** Flush all buffered output data to sink.
  * This function may return SC_IO_ERROR_AGAIN if another write is required.
  * Currently this may happen if BUFFER requires an integer multiple of bytes.
@@ -206,7 +327,15 @@ int                 sc_io_sink_align (sc_io_sink_t * sink,
  *                              BUFFER: sc_array_t * (existing array).
  *                              FILENAME: const char * (name of file to open).
  *                              FILEFILE: FILE * (file open for reading).
+ *                              MMAP: const char * (name of file to map).
+ *                              The file is mapped read-only as a whole
+ *                              and its data is accessible without copying
+ *                              by \ref sc_io_source_peek.  This type is
+ *                              only available with mmap(2) support.
  * \param [in] ioencode         Encoding value from \ref sc_io_encode_t.
+ *                              With compression, bytes_in counts the
+ *                              encoded bytes and bytes_out the data
+ *                              passed out by read.
  * \return                      Newly allocated source, or NULL on error.
  */
 sc_io_source_t     *sc_io_source_new (int iotype, int ioencode, ...);
@@ -266,7 +395,57 @@ int                 sc_io_source_complete (sc_io_source_t * source,
 int                 sc_io_source_align (sc_io_source_t * source,
                                         size_t bytes_align);
 
+/** Access the data of a source at its current position without copying.
+ * This works for the types BUFFER and MMAP, which hold all data in memory.
+ * The position is not changed; to advance it, call \ref sc_io_source_read
+ * with a NULL data buffer.  An \ref sc_array_t view of the data may be
+ * created with \ref sc_array_init_data, which must not be written to
+ * for type MMAP and remains valid until the source is destroyed.
+ * \param [in] source           The source object to access.
+ * \param [out] bytes_avail     If not NULL, the number of bytes that
+ *                              remain to be read.  Zero for other types.
+ * \return                      Pointer to the data at the current read
+ *                              position, or NULL for the file types
+ *                              and for compressing encodings.
+ */
+const char         *sc_io_source_peek (sc_io_source_t * source,
+                                       size_t *bytes_avail);
+
+/** Declare the expected access pattern of a source.
+ * For type MMAP this is passed to madvise(2) and for the file types
+ * to posix_fadvise(2), which may speed up reading.
+ * For type BUFFER, and where the hint is not supported, it is a noop.
+ * \param [in,out] source       The source object to advise on.
+ * \param [in] advice           A value from \ref sc_io_advice_t.
+ * \return                      0 on success, nonzero on error.
+ */
+int                 sc_io_source_advise (sc_io_source_t * source,
+                                         int advice);
+
+/** Read a file source through large buffers.
+ * Requests of any size are then served from memory, and the file is
+ * read in chunks of the buffer size.  The kernel is advised that the
+ * file is read sequentially.  This is only available for the file types
+ * and may be called once at any position in the file.
+ * For type FILEFILE, destroying the source moves the file position back
+ * to the last byte read if the file is seekable.
+ * \param [in,out] source       The source object to buffer.
+ * \param [in] bytes            Size of each buffer.  If 0, use
+ *                              \ref SC_IO_READAHEAD_SIZE.
+ * \param [in] flags            With SC_IO_READAHEAD_PREFETCH, the next
+ *                              chunk is read by a background thread while
+ *                              the current one is consumed, if threads
+ *                              are configured.  Otherwise pass 0.
+ * \return                      0 on success, nonzero on error.
+ */
+int                 sc_io_source_set_readahead (sc_io_source_t * source,
+                                                size_t bytes, int flags);
+
 /** Activate a buffer that mirrors (i.e., stores) the data that was read.
+ * This is not available for the in-memory types BUFFER and MMAP.
+ * Without encoding on a seekable file, the mirror does not copy any data
+ * but records the ranges of the file read, which
+ * \ref sc_io_source_read_mirror reads again.
  * \param [in,out] source       The source object to activate mirror in.
  * \return                      0 on success, nonzero on error.
  */
@@ -317,7 +496,10 @@ void                sc_io_encode (sc_array_t *data, sc_array_t *out);
  * We first compress the data into the zlib deflate format (RFC 1951).
  * The compressor must use no preset dictionary (this is the default).
  * If zlib is detected on configuration, we compress with the given level.
- * If zlib is not detected, we write data equivalent to Z_NO_COMPRESSION.
+ * If zlib is not detected, we use a builtin compressor that writes fixed
+ * Huffman blocks with matches found by hash chains, where the level scales
+ * the search effort, and store each block that does not compress.
+ * Level 0 writes data equivalent to Z_NO_COMPRESSION.
  * The status of zlib detection can be queried at compile time using
  * \#ifdef SC_HAVE_ZLIB or at run time using \ref sc_have_zlib.
  * Both types of result are readable by a standard zlib uncompress call.
@@ -356,6 +538,179 @@ void                sc_io_encode_zlib (sc_array_t *data, sc_array_t *out,
                                        int zlib_compression_level,
                                        int line_break_character);
 
+/** Encode a block of data as \ref sc_io_encode_zlib with a checksum choice.
+ * With \ref SC_IO_CHECKSUM_ADLER32 the output is identical to that of
+ * \ref sc_io_encode_zlib.  With \ref SC_IO_CHECKSUM_CRC32C we write the
+ * format character 'C' instead of 'z' and append the 4-byte big-endian
+ * CRC32C of the original data to the zlib data before base 64 encoding.
+ * Both formats are read by \ref sc_io_decode.
+ * \param [in,out] data     See \ref sc_io_encode_zlib.
+ * \param [in,out] out      See \ref sc_io_encode_zlib.
+ * \param [in] zlib_compression_level     See \ref sc_io_encode_zlib.
+ * \param [in] line_break_character       See \ref sc_io_encode_zlib.
+ * \param [in] checksum     A value of \ref sc_io_checksum_t.
+ */
+void                sc_io_encode_ext (sc_array_t *data, sc_array_t *out,
+                                      int zlib_compression_level,
+                                      int line_break_character,
+                                      int checksum);
+
+/** The default block size of \ref sc_io_encode_parallel in bytes. */
+#define SC_IO_ENCODE_BLOCK_SIZE (1 << 20)
+
+/** Encode a block of data compressing independent blocks in parallel.
+ * The input is cut into blocks of \a block_size bytes, the last one
+ * possibly shorter, which are each compressed into a separate zlib stream
+ * by their own thread as by \ref sc_io_encode_zlib.  The base 64 stage is
+ * threaded as well.  The format is as for \ref sc_io_encode_zlib, except
+ * that the format character is 'B' and followed by a block index:
+ * the block size as an 8-byte big-endian number and then the compressed
+ * size of each block in the same way, followed by the zlib streams.
+ * The number of blocks is the original size divided by the block size,
+ * rounded up, and at least one.  \ref sc_io_decode reads this format
+ * and uncompresses the blocks in parallel again.
+ * \param [in,out] data     See \ref sc_io_encode_zlib.
+ * \param [in,out] out      See \ref sc_io_encode_zlib.
+ * \param [in] zlib_compression_level     See \ref sc_io_encode_zlib.
+ * \param [in] line_break_character       See \ref sc_io_encode_zlib.
+ * \param [in] block_size   Uncompressed bytes per block.  If zero, use
+ *                          \ref SC_IO_ENCODE_BLOCK_SIZE.
+ * \param [in] num_threads  Number of threads run by \ref sc_thread_fork_join.
+ *                          If not positive, use \ref sc_thread_default_count.
+ */
+void                sc_io_encode_parallel (sc_array_t *data,
+                                           sc_array_t *out,
+                                           int zlib_compression_level,
+                                           int line_break_character,
+                                           size_t block_size,
+                                           int num_threads);
+
+/** Pack an array of 32-bit or 64-bit integers into few bytes.
+ * Each value is replaced by its difference to the previous one, the first
+ * by itself, computed with unsigned wrap-around and zigzag encoded such
+ * that small differences of either sign become small numbers.  These are
+ * stored with as few little-endian bytes as they need, at least one.
+ * The format is the element size as one byte, the number of values as an
+ * 8-byte big-endian number, then the length codes of all values and the
+ * value bytes.  A code byte holds the lengths minus one of four 32-bit
+ * values in two bits each or of two 64-bit values in four bits each,
+ * starting with the lowest bits.  Sorted indices and offsets shrink to
+ * about a quarter of their size and may be compressed further by zlib;
+ * see \ref sc_io_encode_ints_zlib.
+ * \param [in] data         Array of element size 4 or 8 holding integers.
+ *                          The data is read byte by byte, so any signed or
+ *                          unsigned type of that size qualifies.
+ * \param [in,out] out      Array of element size 1 that must not be a view.
+ *                          It is resized to the packed bytes.
+ */
+void                sc_io_encode_ints (sc_array_t *data, sc_array_t *out);
+
+/** Unpack the integers of \ref sc_io_encode_ints.
+ * The 32-bit decoding uses SSSE3 byte shuffles if the compiler targets them.
+ * This function detects malformed input by erroring out.
+ * \param [in] data         Array of element size 1 with the packed data.
+ * \param [in,out] out      Output array of element size dividing the total
+ *                          byte size of the integers.  It is resized to
+ *                          fit them exactly.  It may be a view, in which
+ *                          case it must be large enough.
+ * \return                  0 on success, negative on malformed input
+ *                          data or insufficient output space.
+ */
+int                 sc_io_decode_ints (sc_array_t *data, sc_array_t *out);
+
+/** Encode an array of integers packed and compressed to base 64.
+ * We pack the integers with \ref sc_io_encode_ints and compress the result.
+ * The format is as for \ref sc_io_encode_zlib, except that the format
+ * character is 'i' and the compressed data is preceded by the packed size
+ * as an 8-byte big-endian number.  \ref sc_io_decode reads this format and
+ * restores the original bytes; the incremental decoder does not.
+ * \param [in] data         Array of element size 4 or 8 holding integers.
+ * \param [in,out] out      See \ref sc_io_encode_zlib.  If NULL, we work
+ *                          in place.
+ * \param [in] zlib_compression_level     See \ref sc_io_encode_zlib.
+ * \param [in] line_break_character       See \ref sc_io_encode_zlib.
+ */
+void                sc_io_encode_ints_zlib (sc_array_t *data,
+                                            sc_array_t *out,
+                                            int zlib_compression_level,
+                                            int line_break_character);
+
+/** Encode an array of numbers with their bytes shuffled and compressed.
+ * Before compression we transpose the data such that the first bytes of
+ * all elements come first, then all second bytes, and so on.  The slowly
+ * varying sign and exponent bytes of floating point fields gather into
+ * runs that zlib compresses well and fast.  The transposition uses SSE2
+ * for element sizes 2, 4, 8 and 16 if the compiler targets it.
+ * The format is as for \ref sc_io_encode_zlib, except that the format
+ * character is 's' and the compressed data is preceded by the element
+ * size as one byte.  \ref sc_io_decode reads this format and restores the
+ * original bytes; the incremental decoder does not.
+ * \param [in,out] data     Array of element size from 1 to 255.
+ *                          Its element size is the size of a number.
+ *                          The numbers are not modified unless we work
+ *                          in place, in which case they are overwritten.
+ * \param [in,out] out      See \ref sc_io_encode_zlib.  If NULL, we work
+ *                          in place.
+ * \param [in] zlib_compression_level     See \ref sc_io_encode_zlib.
+ * \param [in] line_break_character       See \ref sc_io_encode_zlib.
+ * \param [in] mantissa_bits    If negative, the encoding is lossless.
+ *                          Otherwise the data must be float or double and
+ *                          we round the encoded numbers to this many of
+ *                          their 23 or 52 explicit mantissa bits, which is
+ *                          intended for visualization output.  Infinities
+ *                          and NaNs are kept as they are.
+ */
+void                sc_io_encode_shuffle (sc_array_t *data,
+                                          sc_array_t *out,
+                                          int zlib_compression_level,
+                                          int line_break_character,
+                                          int mantissa_bits);
+
+/** Return a description of the byte shuffle kernel compiled in.
+ * \return                  A static string, e.g. "shuffle sse2".
+ */
+const char         *sc_io_shuffle_kernel (void);
+
+/** Return a description of the integer decoding kernel compiled in.
+ * \return                  A static string, e.g. "ints ssse3".
+ */
+const char         *sc_io_ints_kernel (void);
+
+/** Update an adler32 checksum as the zlib function adler32 does.
+ * This function is available without zlib; it uses AVX2 if the compiler
+ * targets it and a sum over 16-byte runs otherwise.
+ * \param [in] adler        Checksum of the preceding data, 1 initially.
+ * \param [in] buffer       Data to add to the checksum.
+ * \param [in] length       Number of bytes in \a buffer.
+ * \return                  The updated checksum.
+ */
+uint32_t            sc_io_adler32 (uint32_t adler, const void *buffer,
+                                   size_t length);
+
+/** Update a CRC32C (Castagnoli) checksum.
+ * We use the SSE4.2 or ARMv8 crc32c instructions if the compiler targets
+ * them and a lookup table otherwise.  The checksum of "123456789" is
+ * 0xE3069283.
+ * \param [in] crc          Checksum of the preceding data, 0 initially.
+ * \param [in] buffer       Data to add to the checksum.
+ * \param [in] length       Number of bytes in \a buffer.
+ * \return                  The updated checksum.
+ */
+uint32_t            sc_io_crc32c (uint32_t crc, const void *buffer,
+                                  size_t length);
+
+/** Return a description of the checksum kernels compiled in.
+ * \return                  A static string, e.g. "adler32 avx2, crc32c table".
+ */
+const char         *sc_io_checksum_kernel (void);
+
+/** Return a description of the base 64 kernel compiled in.
+ * We use AVX2, SSSE3 or NEON instructions if the compiler targets them
+ * and a scalar loop otherwise.
+ * \return                  A static string, e.g. "base64 ssse3".
+ */
+const char         *sc_io_base64_kernel (void);
+
 /** Decode length and format of original input from encoded data.
  * We expect at least 12 bytes of the format produced by \ref sc_io_encode.
  * No matter how much data has been encoded by it, this much is available.
@@ -393,6 +748,15 @@ int                 sc_io_decode_info (sc_array_t *data,
  * 'z', and execute a zlib decompression on the remaining decoded data.
  * This function detects malformed input by erroring out.
  *
+ * The format character 'C' indicates that the decoded data ends in a
+ * CRC32C checksum of the original data as written by \ref sc_io_encode_ext,
+ * which we verify after decompression.  The character 'B' indicates the
+ * block format of \ref sc_io_encode_parallel, 'i' the packed integers
+ * of \ref sc_io_encode_ints_zlib and 's' the shuffled bytes of
+ * \ref sc_io_encode_shuffle.  The blocks of 'B' as well as
+ * the base 64 lines of any format are decoded by as many threads as
+ * \ref sc_thread_default_count returns.
+ *
  * If we should add another format in the future, the format character
  * may be something else than 'z', as permitted by our specification.
  * To this end, we reserve the characters A-C and d-z indefinitely.
@@ -443,6 +807,122 @@ int                 sc_io_decode_info (sc_array_t *data,
 int                 sc_io_decode (sc_array_t *data, sc_array_t *out,
                                   size_t max_original_size, void *re);
 
+/** Opaque incremental encoder writing to a sink. */
+typedef struct sc_io_encoder sc_io_encoder_t;
+
+/** Opaque incremental decoder writing to a sink. */
+typedef struct sc_io_decoder sc_io_decoder_t;
+
+/** Begin an incremental encoding in the format of \ref sc_io_encode_zlib.
+ * The data is passed in pieces by \ref sc_io_encoder_write and the
+ * encoded lines are written to the sink as soon as they are complete.
+ * Apart from the compressor state, memory use is independent of the size
+ * of the data.  Without zlib, we write uncompressed zlib format as usual.
+ * \param [in,out] sink     The encoded string is written to this sink.
+ *                          It must stay valid until the encoder is done.
+ * \param [in] original_size    The total number of bytes to be written,
+ *                          since it is recorded at the start of the format.
+ * \param [in] zlib_compression_level   Compression level between 0
+ *                          (no compression) and 9 (best compression).
+ *                          The value -1 indicates some default level.
+ * \param [in] line_break_character     This character is added at the
+ *                          end of the encoded lines as in
+ *                          \ref sc_io_encode_zlib.
+ * \return                  A valid encoder object.
+ */
+sc_io_encoder_t    *sc_io_encoder_new (sc_io_sink_t * sink,
+                                       size_t original_size,
+                                       int zlib_compression_level,
+                                       int line_break_character);
+
+/** Pass the next piece of data to an incremental encoder.
+ * \param [in,out] enc      Encoder from \ref sc_io_encoder_new.
+ * \param [in] data         Data of bytes length.  In total, the pieces
+ *                          must not exceed the original size.
+ * \param [in] bytes        Number of bytes, may be zero.
+ * \return                  0 on success, -1 on a sink error.  After an
+ *                          error, the encoder only accepts destroy.
+ */
+int                 sc_io_encoder_write (sc_io_encoder_t * enc,
+                                         const void *data, size_t bytes);
+
+/** Complete an incremental encoding and free the encoder.
+ * The final line and the terminating NUL are written to the sink.
+ * The sink itself is not completed or destroyed.
+ * \param [in,out] enc      Encoder from \ref sc_io_encoder_new.
+ *                          Exactly the original size must have been written.
+ * \return                  0 on success, -1 on any previous or final error.
+ */
+int                 sc_io_encoder_destroy (sc_io_encoder_t * enc);
+
+/** Begin an incremental decoding of the string formats produced by
+ * \ref sc_io_encode, \ref sc_io_encode_ext, \ref sc_io_encode_parallel
+ * and \ref sc_io_encoder_new.  The encoded string is passed in pieces by
+ * \ref sc_io_decoder_write and the original data is written to the sink
+ * as it is uncompressed.  With zlib, memory use is independent of the
+ * size of the data.  Without zlib, the compressed data is collected and
+ * uncompressed when the decoder is destroyed.
+ * \param [in,out] sink     The original data is written to this sink.
+ *                          It must stay valid until the decoder is done.
+ * \param [in] max_original_size    If nonzero, this is the maximal data
+ *                          size that we will accept after uncompression.
+ * \return                  A valid decoder object.
+ */
+sc_io_decoder_t    *sc_io_decoder_new (sc_io_sink_t * sink,
+                                       size_t max_original_size);
+
+/** Pass the next piece of an encoded string to an incremental decoder.
+ * \param [in,out] dec      Decoder from \ref sc_io_decoder_new.
+ * \param [in] data         Encoded characters of bytes length.  The last
+ *                          piece ends in the terminating NUL.
+ * \param [in] bytes        Number of bytes, may be zero.
+ * \return                  0 on success, -1 on malformed input or a sink
+ *                          error.  After an error, the decoder only
+ *                          accepts destroy.
+ */
+int                 sc_io_decoder_write (sc_io_decoder_t * dec,
+                                         const void *data, size_t bytes);
+
+/** Complete an incremental decoding and free the decoder.
+ * The sink itself is not completed or destroyed.
+ * \param [in,out] dec      Decoder from \ref sc_io_decoder_new.
+ * \param [out] original_size   If not NULL, the size of the decoded data.
+ * \return                  0 if the complete string has been decoded
+ *                          and verified, -1 on any error.
+ */
+int                 sc_io_decoder_destroy (sc_io_decoder_t * dec,
+                                           size_t *original_size);
+
+/** Encode numeric binary data in VTK base64 encoding into memory.
+ * The output is the same as written by \ref sc_vtk_write_binary: a 32-bit
+ * length header and the data, base 64 encoded as one string.
+ * \param [in,out] out   Resizable array of element size 1.  It is resized
+ *                       to the encoded string, which is not NUL-terminated.
+ * \param numeric_data   A pointer to a numeric data array.
+ * \param byte_length    The length of the data array in bytes.
+ * \param num_threads    Number of threads to encode with.  If not
+ *                       positive, we use \ref sc_thread_default_count.
+ */
+void                sc_vtk_encode_binary (sc_array_t *out,
+                                          const char *numeric_data,
+                                          size_t byte_length,
+                                          int num_threads);
+
+/** Encode numeric binary data in VTK compressed format into memory.
+ * The output is the same as written by \ref sc_vtk_write_compressed.
+ * The blocks are compressed and base 64 encoded in parallel.
+ * \param [in,out] out   Resizable array of element size 1.  It is resized
+ *                       to the encoded string, which is not NUL-terminated.
+ * \param numeric_data   A pointer to a numeric data array.
+ * \param byte_length    The length of the data array in bytes.
+ * \param num_threads    Number of threads to encode with.  If not
+ *                       positive, we use \ref sc_thread_default_count.
+ */
+void                sc_vtk_encode_compressed (sc_array_t *out,
+                                              const char *numeric_data,
+                                              size_t byte_length,
+                                              int num_threads);
+
 /** This function writes numeric binary data in VTK base64 encoding.
  * \param vtkfile        Stream opened for writing.
  * \param numeric_data   A pointer to a numeric data array.
@@ -453,6 +933,7 @@ int                 sc_vtk_write_binary (FILE * vtkfile, char *numeric_data,
                                          size_t byte_length);
 
 /** This function writes numeric binary data in VTK compressed format.
+ * Without zlib, we use the builtin compressor of \ref sc_io_encode_zlib.
  * \param vtkfile        Stream opened for writing.
  * \param numeric_data   A pointer to a numeric data array.
  * \param byte_length    The length of the data array in bytes.
@@ -462,6 +943,30 @@ int                 sc_vtk_write_compressed (FILE * vtkfile,
                                              char *numeric_data,
                                              size_t byte_length);
 
+/** Write encoded VTK data of all ranks into one appended data section.
+ * Each rank passes the output of \ref sc_vtk_encode_binary or
+ * \ref sc_vtk_encode_compressed for its piece.  The pieces are written
+ * collectively by \ref sc_io_write_at_all in rank order.  Since the
+ * encoded sizes are known before this call, the XML header can list the
+ * offsets of all pieces, which are the exclusive prefix sums of the sizes.
+ * This function is collective.
+ * \param [in] mpicomm  The communicator that the file was opened with.
+ * \param [in,out] mpifile      MPI file object opened for writing.
+ * \param [in,out] offset       On input, the byte offset in the file of
+ *                      the first piece, the same on all ranks.  Without
+ *                      MPI I/O, the file must end at this offset.  On
+ *                      output, the offset after the last piece.
+ * \param [in] encoded  The encoded piece of this rank.
+ * \param [out] rank_offset     If not NULL, the byte offset of this rank's
+ *                      piece relative to the input \b offset.
+ * \return              A sc_MPI_ERR_* as defined in \ref sc_mpi.h.
+ */
+int                 sc_vtk_write_appended_all (sc_MPI_Comm mpicomm,
+                                               sc_MPI_File mpifile,
+                                               sc_MPI_Offset *offset,
+                                               sc_array_t *encoded,
+                                               sc_MPI_Offset *rank_offset);
+
 /** Wrapper for fopen(3).
  * We provide an additional argument that contains the error message.
  */
@@ -513,6 +1018,104 @@ int                 sc_io_open (sc_MPI_Comm mpicomm,
                                 const char *filename, sc_io_open_mode_t amode,
                                 sc_MPI_Info mpiinfo, sc_MPI_File * mpifile);
 
+#ifndef SC_IO_HINTS_STRIPE_BYTES
+/** Default expected bytes per stripe of the automatic striping. */
+#define SC_IO_HINTS_STRIPE_BYTES ((size_t) 1 << 30)
+#endif
+
+/** Hints on the file system layout and the collective buffering.
+ * They are passed to MPI I/O by \ref sc_io_open_hints and ignored
+ * without it.  Zero or NULL members leave the choice to MPI.
+ * The striping is only applied when a file is created.
+ */
+typedef struct sc_io_hints
+{
+  int                 striping_factor;  /**< Number of stripes, or
+                                             negative for automatic. */
+  size_t              striping_unit;    /**< Bytes of one stripe. */
+  int                 cb_nodes;         /**< Number of aggregators.  In
+                                             automatic mode it defaults
+                                             to the number of stripes. */
+  size_t              cb_buffer_size;   /**< Bytes of an aggregator. */
+  const char         *cb_write;         /**< Value of romio_cb_write:
+                                             enable, disable, automatic. */
+  const char         *cb_read;          /**< Value of romio_cb_read. */
+  const char         *extra;            /**< Further hints in the form
+                                             key=value,key=value. */
+  size_t              stripe_bytes;     /**< Expected bytes per stripe
+                                             in automatic mode. */
+  int                 max_stripes;      /**< If positive, the most
+                                             stripes in automatic mode. */
+}
+sc_io_hints_t;
+
+/** Initialize hints that leave all choices to MPI.
+ * \param [out] hints    The automatic mode uses
+ *                       \ref SC_IO_HINTS_STRIPE_BYTES without limit.
+ */
+void                sc_io_hints_init (sc_io_hints_t * hints);
+
+/** Add options to set the members of the hints.
+ * The options are named after the MPI hints, such as --striping-factor,
+ * --striping-unit, --cb-nodes, --cb-buffer-size, --cb-write, --cb-read,
+ * and --io-hints for the extra hints, and --stripe-bytes and
+ * --max-stripes for the automatic mode.  Their defaults are the values
+ * of the members, which must stay alive while the options are in use.
+ * \param [in,out] hints  Initialized hints.
+ * \param [in,out] opt    Options to add to.  To add a prefix
+ *                        use \ref sc_options_add_suboptions.
+ */
+void                sc_io_hints_add_options (sc_io_hints_t * hints,
+                                             sc_options_t * opt);
+
+/** Return the number of stripes the hints ask for.
+ * In automatic mode there is one stripe per stripe_bytes of the expected
+ * file size, at least one and at most one per process and max_stripes.
+ * \param [in] hints          Valid hints.
+ * \param [in] mpisize        Number of processes that open the file.
+ * \param [in] expected_size  Expected bytes of the file, may be 0.
+ * \return                    Number of stripes, or 0 to leave it to MPI.
+ */
+int                 sc_io_hints_stripes (const sc_io_hints_t * hints,
+                                         int mpisize, size_t expected_size);
+
+/** Create an MPI info object from the hints.
+ * This function is collective since the hints must match.
+ * \param [in] hints          Valid hints.
+ * \param [in] mpicomm        The communicator that opens the file.
+ * \param [in] expected_size  Expected bytes of the file for the
+ *                            automatic mode, may be 0.
+ * \param [out] mpiinfo       Info object to pass to \ref sc_io_open and
+ *                            to free by \ref sc_io_hints_info_free.  It
+ *                            is \ref sc_MPI_INFO_NULL without MPI I/O.
+ */
+void                sc_io_hints_info (const sc_io_hints_t * hints,
+                                      sc_MPI_Comm mpicomm,
+                                      size_t expected_size,
+                                      sc_MPI_Info * mpiinfo);
+
+/** Free an info object created by \ref sc_io_hints_info.
+ * \param [in,out] mpiinfo    Set to \ref sc_MPI_INFO_NULL.
+ */
+void                sc_io_hints_info_free (sc_MPI_Info * mpiinfo);
+
+/** Open a file like \ref sc_io_open with an info object of hints.
+ * \param [in] mpicomm        MPI communicator
+ * \param [in] filename       The path to the file that we want to open.
+ * \param [in] amode          An access mode.
+ * \param [in] hints          Hints, or NULL for \ref sc_MPI_INFO_NULL.
+ * \param [in] expected_size  Expected bytes of the file for the
+ *                            automatic mode, may be 0.
+ * \param [out] mpifile       The file that is opened.
+ * \return                    A sc_MPI_ERR_* as defined in \ref sc_mpi.h.
+ */
+int                 sc_io_open_hints (sc_MPI_Comm mpicomm,
+                                      const char *filename,
+                                      sc_io_open_mode_t amode,
+                                      const sc_io_hints_t * hints,
+                                      size_t expected_size,
+                                      sc_MPI_File * mpifile);
+
 #define sc_mpi_read         sc_io_read   /**< For backwards compatibility. */
 
 /** Read MPI file content into memory.
@@ -662,6 +1265,149 @@ int                 sc_io_write_all (sc_MPI_File mpifile,
                                      const void *ptr, size_t zcount,
                                      sc_MPI_Datatype t, int *ocount);
 
+/** Write memory content collectively through a few aggregating ranks.
+ * The ranks are divided into groups of consecutive ranks.  Each group
+ * gathers its data on its first rank, which writes the data of ranks
+ * that continue each other in the file as one piece.  With MPI I/O, the
+ * aggregators write independently at the given offsets.  Without it,
+ * only the aggregators take part in the rank-serialized appends of
+ * \ref sc_io_write_at_all, which ignore the offset as documented there.
+ * \param [in] mpicomm  The communicator that the file was opened with.
+ * \param [in,out] mpifile      MPI file object opened for writing.
+ * \param [in] offset   Starting offset in bytes, assuming the default
+ *                      file view.
+ * \param [in] ptr      Data array to write to disk.
+ * \param [in] zcount   Number of array members.
+ * \param [in] t        The MPI type for each array member.
+ * \param [in] num_aggregators  Number of groups.  If not positive, we use
+ *                      one group per node if the node communicators
+ *                      of \ref sc_mpi_comm_attach_node_comms have been
+ *                      attached to \b mpicomm and each node holds
+ *                      consecutive ranks, and a single group otherwise.
+ * \param [out] ocount  The number of written array members.
+ * \return              A sc_MPI_ERR_* as defined in \ref sc_mpi.h.
+ *                      Each rank receives the result of its aggregator.
+ * \note                The data of a group must fit into an int of bytes.
+ */
+int                 sc_io_write_at_all_aggregated (sc_MPI_Comm mpicomm,
+                                                   sc_MPI_File mpifile,
+                                                   sc_MPI_Offset offset,
+                                                   const void *ptr,
+                                                   size_t zcount,
+                                                   sc_MPI_Datatype t,
+                                                   int num_aggregators,
+                                                   int *ocount);
+
+/** Read data collectively that is laid out by one partition of the file
+ * and distribute it by another one.
+ * Both partitions are cumulative element counts of the same global data,
+ * which is stored contiguously in the file.  The data of the writers of
+ * the old partition is divided into stripes of about equal size, each of
+ * which an aggregator rank reads in few large pieces by
+ * \ref sc_io_read_at_all.  The stripes are sent to the ranks of the new
+ * partition whose range they overlap.  Every rank computes the pattern of
+ * communication from the partitions without any notification.
+ * \param [in] mpicomm  The communicator that the file was opened with.
+ * \param [in] mpifile  MPI file object opened for reading.
+ * \param [in] offset   Offset in bytes of the first element in the file,
+ *                      assuming the default file view.
+ * \param [out] ptr     Array of the elements of this rank, which are
+ *                      those from new_partition[rank] to the next one.
+ * \param [in] elem_size        Size of one element in bytes, positive.
+ * \param [in] old_partition    Array of \a old_size + 1 offsets into the
+ *                      data, the ranges written by the old processes.
+ * \param [in] old_size Number of writing processes, may differ from the
+ *                      size of \a mpicomm.
+ * \param [in] new_partition    Array of size of \a mpicomm + 1 offsets
+ *                      with the same first and last entry as the old one.
+ * \param [in] num_aggregators  Number of reading ranks.  If not positive,
+ *                      we use one per node if the node communicators are
+ *                      attached to \b mpicomm and a single one otherwise.
+ * \return              A sc_MPI_ERR_* as defined in \ref sc_mpi.h,
+ *                      the same on all processes.
+ * \note                The data sent from one rank to another must fit
+ *                      into an int of bytes.
+ */
+int                 sc_io_read_at_all_partition (sc_MPI_Comm mpicomm,
+                                                 sc_MPI_File mpifile,
+                                                 sc_MPI_Offset offset,
+                                                 void *ptr,
+                                                 size_t elem_size,
+                                                 const int64_t *
+                                                 old_partition,
+                                                 int old_size,
+                                                 const int64_t *
+                                                 new_partition,
+                                                 int num_aggregators);
+
+/** Opaque handle of a nonblocking collective file operation. */
+typedef struct sc_io_request sc_io_request_t;
+
+/** Start reading MPI file content collectively for an explicit offset.
+ * With MPI I/O of version 3.1 or later, this calls MPI_File_iread_at_all.
+ * Otherwise, the operation is completed by \ref sc_io_read_at_all before
+ * this function returns and the request only holds its result.
+ * The data must not be accessed until the request is completed.
+ * \param [in,out] mpifile      MPI file object opened for reading.
+ * \param [in] offset   Starting offset in counts of the type \b t.
+ * \param [out] ptr     Data array to read from disk.
+ * \param [in] zcount   Number of array members.
+ * \param [in] t        The MPI type for each array member.
+ * \param [out] request Always a new request to be completed by
+ *                      \ref sc_io_wait or \ref sc_io_test.
+ * \return              A sc_MPI_ERR_* as defined in \ref sc_mpi.h.
+ *                      The same error is returned when completing.
+ */
+int                 sc_io_iread_at_all (sc_MPI_File mpifile,
+                                        sc_MPI_Offset offset, void *ptr,
+                                        int zcount, sc_MPI_Datatype t,
+                                        sc_io_request_t ** request);
+
+/** Start writing MPI file content collectively for an explicit offset.
+ * With MPI I/O of version 3.1 or later, this calls MPI_File_iwrite_at_all.
+ * Otherwise, the operation is completed by \ref sc_io_write_at_all before
+ * this function returns, with the same treatment of the offset.
+ * The data must not be modified until the request is completed.
+ * \param [in,out] mpifile      MPI file object opened for writing.
+ * \param [in] offset   Starting offset in etype, where the etype is given by
+ *                      the type t.
+ * \param [in] ptr      Data array to write to disk.
+ * \param [in] zcount   Number of array members.
+ * \param [in] t        The MPI type for each array member.
+ * \param [out] request Always a new request to be completed by
+ *                      \ref sc_io_wait or \ref sc_io_test.
+ * \return              A sc_MPI_ERR_* as defined in \ref sc_mpi.h.
+ *                      The same error is returned when completing.
+ */
+int                 sc_io_iwrite_at_all (sc_MPI_File mpifile,
+                                         sc_MPI_Offset offset,
+                                         const void *ptr, size_t zcount,
+                                         sc_MPI_Datatype t,
+                                         sc_io_request_t ** request);
+
+/** Wait for a nonblocking file operation to complete and free it.
+ * \param [in,out] request      Request from \ref sc_io_iread_at_all or
+ *                              \ref sc_io_iwrite_at_all, set to NULL.
+ * \param [out] ocount  If not NULL, the number of array members
+ *                      read or written.
+ * \return              A sc_MPI_ERR_* as defined in \ref sc_mpi.h.
+ */
+int                 sc_io_wait (sc_io_request_t ** request, int *ocount);
+
+/** Test whether a nonblocking file operation has completed.
+ * If so, the request is freed as in \ref sc_io_wait.
+ * \param [in,out] request      Request from \ref sc_io_iread_at_all or
+ *                              \ref sc_io_iwrite_at_all.  Set to NULL
+ *                              if the operation has completed.
+ * \param [out] flag    True if the operation has completed.
+ * \param [out] ocount  If not NULL and the operation has completed,
+ *                      the number of array members read or written.
+ * \return              A sc_MPI_ERR_* as defined in \ref sc_mpi.h.
+ *                      It refers to the operation if it has completed.
+ */
+int                 sc_io_test (sc_io_request_t ** request, int *flag,
+                                int *ocount);
+
 /** Close collectively a sc_MPI_File.
  * \param[in] file  MPI file object that is closed.
  * \return              A sc_MPI_ERR_* as defined in \ref sc_mpi.h.
@@ -26,6 +26,7 @@
 typedef struct sc_keyvalue_entry
 {
   const char         *key;
+  unsigned            hash;
   sc_keyvalue_entry_type_t type;
   union
   {
@@ -38,38 +39,86 @@ typedef struct sc_keyvalue_entry
 }
 sc_keyvalue_entry_t;
 
+/* the entries are stored inline in the slots of an open addressing table */
 struct sc_keyvalue
 {
-  sc_hash_t          *hash;
-  sc_mempool_t       *value_allocator;
+  sc_ohash_t         *hash;
 };
 
 static unsigned
 sc_keyvalue_entry_hash (const void *v, const void *u)
 {
-  const sc_keyvalue_entry_t *ov = (const sc_keyvalue_entry_t *) v;
-
-  return sc_hash_function_string (ov->key, NULL);
+  return ((const sc_keyvalue_entry_t *) v)->hash;
 }
 
 static int
 sc_keyvalue_entry_equal (const void *v1, const void *v2, const void *u)
 {
-
   const sc_keyvalue_entry_t *ov1 = (const sc_keyvalue_entry_t *) v1;
   const sc_keyvalue_entry_t *ov2 = (const sc_keyvalue_entry_t *) v2;
 
-  return !strcmp (ov1->key, ov2->key);
+  /* interned keys compare by their address */
+  return ov1->key == ov2->key || !strcmp (ov1->key, ov2->key);
+}
+
+void
+sc_keyvalue_key_init (sc_keyvalue_key_t * key, const char *string)
+{
+  SC_ASSERT (key != NULL);
+  SC_ASSERT (string != NULL);
+
+  key->key = string;
+  key->hash = sc_hash_function_string_fast (string, NULL);
+}
+
+/** Return the entry of a key or NULL if it does not exist. */
+static sc_keyvalue_entry_t *
+sc_keyvalue_find (sc_keyvalue_t * kv, const sc_keyvalue_key_t * key)
+{
+  void               *found;
+  sc_keyvalue_entry_t svalue;
+
+  SC_ASSERT (kv != NULL);
+  SC_ASSERT (key != NULL && key->key != NULL);
+
+  svalue.key = key->key;
+  svalue.hash = key->hash;
+  if (sc_ohash_lookup (kv->hash, &svalue, &found)) {
+    return (sc_keyvalue_entry_t *) found;
+  }
+  return NULL;
+}
+
+/** Return the entry of a key of the given type, which is created if the
+ * key does not exist.  The value of a new entry is undefined. */
+static sc_keyvalue_entry_t *
+sc_keyvalue_insert (sc_keyvalue_t * kv, const sc_keyvalue_key_t * key,
+                    sc_keyvalue_entry_type_t type)
+{
+  void               *found;
+  sc_keyvalue_entry_t svalue;
+
+  SC_ASSERT (kv != NULL);
+  SC_ASSERT (key != NULL && key->key != NULL);
+
+  svalue.key = key->key;
+  svalue.hash = key->hash;
+  svalue.type = type;
+  if (!sc_ohash_insert_unique (kv->hash, &svalue, &found)) {
+    /* Key already exists in hash table */
+    SC_ASSERT (((sc_keyvalue_entry_t *) found)->type == type);
+  }
+  return (sc_keyvalue_entry_t *) found;
 }
 
 sc_keyvalue_t      *
 sc_keyvalue_newv (va_list ap)
 {
   const char         *s;
-  int                 added;
-  void              **found;
   sc_keyvalue_t      *kv;
+  sc_keyvalue_key_t   key;
   sc_keyvalue_entry_t *value;
+  sc_keyvalue_entry_type_t type;
 
   /* Create the initial empty keyvalue object */
   kv = sc_keyvalue_new ();
@@ -82,32 +131,42 @@ sc_keyvalue_newv (va_list ap)
     }
     /* if this assertion blows then the type prefix might be missing */
     SC_ASSERT (s[0] != '\0' && s[1] == ':' && s[2] != '\0');
-    value = (sc_keyvalue_entry_t *) sc_mempool_alloc (kv->value_allocator);
-    value->key = &s[2];
     switch (s[0]) {
     case 'i':
-      value->type = SC_KEYVALUE_ENTRY_INT;
-      value->value.i = va_arg (ap, int);
+      type = SC_KEYVALUE_ENTRY_INT;
       break;
     case 'g':
-      value->type = SC_KEYVALUE_ENTRY_DOUBLE;
-      value->value.g = va_arg (ap, double);
+      type = SC_KEYVALUE_ENTRY_DOUBLE;
       break;
     case 's':
-      value->type = SC_KEYVALUE_ENTRY_STRING;
-      value->value.s = va_arg (ap, const char *);
+      type = SC_KEYVALUE_ENTRY_STRING;
       break;
     case 'p':
-      value->type = SC_KEYVALUE_ENTRY_POINTER;
-      value->value.p = va_arg (ap, void *);
+      type = SC_KEYVALUE_ENTRY_POINTER;
       break;
     default:
       SC_ABORTF ("invalid argument character %c", s[0]);
     }
-    added = sc_hash_insert_unique (kv->hash, value, &found);
-    if (!added) {
-      sc_mempool_free (kv->value_allocator, *found);
-      *found = value;
+
+    /* a repeated key replaces the previous entry of any type */
+    sc_keyvalue_key_init (&key, &s[2]);
+    value = sc_keyvalue_find (kv, &key);
+    if (value == NULL) {
+      value = sc_keyvalue_insert (kv, &key, type);
+    }
+    value->type = type;
+    switch (type) {
+    case SC_KEYVALUE_ENTRY_INT:
+      value->value.i = va_arg (ap, int);
+      break;
+    case SC_KEYVALUE_ENTRY_DOUBLE:
+      value->value.g = va_arg (ap, double);
+      break;
+    case SC_KEYVALUE_ENTRY_STRING:
+      value->value.s = va_arg (ap, const char *);
+      break;
+    default:
+      value->value.p = va_arg (ap, void *);
     }
   }
 
@@ -135,9 +194,9 @@ sc_keyvalue_new ()
   sc_keyvalue_t      *kv;
 
   kv = SC_ALLOC (sc_keyvalue_t, 1);
-  kv->hash = sc_hash_new (sc_keyvalue_entry_hash, sc_keyvalue_entry_equal,
-                          NULL, NULL);
-  kv->value_allocator = sc_mempool_new (sizeof (sc_keyvalue_entry_t));
+  kv->hash = sc_ohash_new (sizeof (sc_keyvalue_entry_t),
+                           sc_keyvalue_entry_hash, sc_keyvalue_entry_equal,
+                           NULL);
 
   return kv;
 }
@@ -145,8 +204,7 @@ sc_keyvalue_new ()
 void
 sc_keyvalue_destroy (sc_keyvalue_t * kv)
 {
-  sc_hash_destroy (kv->hash);
-  sc_mempool_destroy (kv->value_allocator);
+  sc_ohash_destroy (kv->hash);
 
   SC_FREE (kv);
 }
@@ -154,73 +212,55 @@ sc_keyvalue_destroy (sc_keyvalue_t * kv)
 sc_keyvalue_entry_type_t
 sc_keyvalue_exists (sc_keyvalue_t * kv, const char *key)
 {
-  void              **found;
-  sc_keyvalue_entry_t svalue, *pvalue = &svalue;
-  sc_keyvalue_entry_t *value;
-
-  SC_ASSERT (kv != NULL);
-  SC_ASSERT (key != NULL);
+  sc_keyvalue_key_t   skey;
 
-  pvalue->key = key;
-  pvalue->type = SC_KEYVALUE_ENTRY_NONE;
-  if (sc_hash_lookup (kv->hash, pvalue, &found)) {
-    value = (sc_keyvalue_entry_t *) (*found);
-    return value->type;
-  }
-  else
-    return SC_KEYVALUE_ENTRY_NONE;
+  sc_keyvalue_key_init (&skey, key);
+  return sc_keyvalue_exists_key (kv, &skey);
 }
 
 sc_keyvalue_entry_type_t
-sc_keyvalue_unset (sc_keyvalue_t * kv, const char *key)
+sc_keyvalue_exists_key (sc_keyvalue_t * kv, const sc_keyvalue_key_t * key)
 {
-  void               *found;
-  sc_keyvalue_entry_t svalue, *pvalue = &svalue;
   sc_keyvalue_entry_t *value;
 
-  int                 remove_test;
-  sc_keyvalue_entry_type_t type;
+  value = sc_keyvalue_find (kv, key);
+  return value != NULL ? value->type : SC_KEYVALUE_ENTRY_NONE;
+}
+
+sc_keyvalue_entry_type_t
+sc_keyvalue_unset (sc_keyvalue_t * kv, const char *key)
+{
+  sc_keyvalue_entry_t svalue, found;
 
   SC_ASSERT (kv != NULL);
   SC_ASSERT (key != NULL);
 
-  pvalue->key = key;
-  pvalue->type = SC_KEYVALUE_ENTRY_NONE;
-
-  /* Remove this entry */
-  remove_test = sc_hash_remove (kv->hash, pvalue, &found);
+  svalue.key = key;
+  svalue.hash = sc_hash_function_string_fast (key, NULL);
 
-  /* Check whether anything was removed */
-  if (!remove_test)
+  /* Remove this entry and check whether anything was removed */
+  if (!sc_ohash_remove (kv->hash, &svalue, &found)) {
     return SC_KEYVALUE_ENTRY_NONE;
+  }
+  return found.type;
+}
 
-  /* Code reaching this point must have found something */
-  SC_ASSERT (remove_test);
-  SC_ASSERT (found != NULL);
-
-  value = (sc_keyvalue_entry_t *) found;
-  type = value->type;
-
-  /* destroy the original hash entry */
-  sc_mempool_free (kv->value_allocator, value);
+int
+sc_keyvalue_get_int (sc_keyvalue_t * kv, const char *key, int dvalue)
+{
+  sc_keyvalue_key_t   skey;
 
-  return type;
+  sc_keyvalue_key_init (&skey, key);
+  return sc_keyvalue_get_int_key (kv, &skey, dvalue);
 }
 
 int
-sc_keyvalue_get_int (sc_keyvalue_t * kv, const char *key, int dvalue)
+sc_keyvalue_get_int_key (sc_keyvalue_t * kv, const sc_keyvalue_key_t * key,
+                         int dvalue)
 {
-  void              **found;
-  sc_keyvalue_entry_t svalue, *pvalue = &svalue;
   sc_keyvalue_entry_t *value;
 
-  SC_ASSERT (kv != NULL);
-  SC_ASSERT (key != NULL);
-
-  pvalue->key = key;
-  pvalue->type = SC_KEYVALUE_ENTRY_NONE;
-  if (sc_hash_lookup (kv->hash, pvalue, &found)) {
-    value = (sc_keyvalue_entry_t *) (*found);
+  if ((value = sc_keyvalue_find (kv, key)) != NULL) {
     SC_ASSERT (value->type == SC_KEYVALUE_ENTRY_INT);
     return value->value.i;
   }
@@ -231,17 +271,19 @@ sc_keyvalue_get_int (sc_keyvalue_t * kv, const char *key, int dvalue)
 double
 sc_keyvalue_get_double (sc_keyvalue_t * kv, const char *key, double dvalue)
 {
-  void              **found;
-  sc_keyvalue_entry_t svalue, *pvalue = &svalue;
-  sc_keyvalue_entry_t *value;
+  sc_keyvalue_key_t   skey;
 
-  SC_ASSERT (kv != NULL);
-  SC_ASSERT (key != NULL);
+  sc_keyvalue_key_init (&skey, key);
+  return sc_keyvalue_get_double_key (kv, &skey, dvalue);
+}
+
+double
+sc_keyvalue_get_double_key (sc_keyvalue_t * kv,
+                            const sc_keyvalue_key_t * key, double dvalue)
+{
+  sc_keyvalue_entry_t *value;
 
-  pvalue->key = key;
-  pvalue->type = SC_KEYVALUE_ENTRY_NONE;
-  if (sc_hash_lookup (kv->hash, pvalue, &found)) {
-    value = (sc_keyvalue_entry_t *) (*found);
+  if ((value = sc_keyvalue_find (kv, key)) != NULL) {
     SC_ASSERT (value->type == SC_KEYVALUE_ENTRY_DOUBLE);
     return value->value.g;
   }
@@ -253,17 +295,20 @@ const char         *
 sc_keyvalue_get_string (sc_keyvalue_t * kv, const char *key,
                         const char *dvalue)
 {
-  void              **found;
-  sc_keyvalue_entry_t svalue, *pvalue = &svalue;
-  sc_keyvalue_entry_t *value;
+  sc_keyvalue_key_t   skey;
 
-  SC_ASSERT (kv != NULL);
-  SC_ASSERT (key != NULL);
+  sc_keyvalue_key_init (&skey, key);
+  return sc_keyvalue_get_string_key (kv, &skey, dvalue);
+}
+
+const char         *
+sc_keyvalue_get_string_key (sc_keyvalue_t * kv,
+                            const sc_keyvalue_key_t * key,
+                            const char *dvalue)
+{
+  sc_keyvalue_entry_t *value;
 
-  pvalue->key = key;
-  pvalue->type = SC_KEYVALUE_ENTRY_NONE;
-  if (sc_hash_lookup (kv->hash, pvalue, &found)) {
-    value = (sc_keyvalue_entry_t *) (*found);
+  if ((value = sc_keyvalue_find (kv, key)) != NULL) {
     SC_ASSERT (value->type == SC_KEYVALUE_ENTRY_STRING);
     return value->value.s;
   }
@@ -274,17 +319,19 @@ sc_keyvalue_get_string (sc_keyvalue_t * kv, const char *key,
 void               *
 sc_keyvalue_get_pointer (sc_keyvalue_t * kv, const char *key, void *dvalue)
 {
-  void              **found;
-  sc_keyvalue_entry_t svalue, *pvalue = &svalue;
-  sc_keyvalue_entry_t *value;
+  sc_keyvalue_key_t   skey;
 
-  SC_ASSERT (kv != NULL);
-  SC_ASSERT (key != NULL);
+  sc_keyvalue_key_init (&skey, key);
+  return sc_keyvalue_get_pointer_key (kv, &skey, dvalue);
+}
+
+void               *
+sc_keyvalue_get_pointer_key (sc_keyvalue_t * kv,
+                             const sc_keyvalue_key_t * key, void *dvalue)
+{
+  sc_keyvalue_entry_t *value;
 
-  pvalue->key = key;
-  pvalue->type = SC_KEYVALUE_ENTRY_NONE;
-  if (sc_hash_lookup (kv->hash, pvalue, &found)) {
-    value = (sc_keyvalue_entry_t *) (*found);
+  if ((value = sc_keyvalue_find (kv, key)) != NULL) {
     SC_ASSERT (value->type == SC_KEYVALUE_ENTRY_POINTER);
     return value->value.p;
   }
@@ -297,8 +344,7 @@ sc_keyvalue_get_int_check (sc_keyvalue_t * kv, const char *key, int *status)
 {
   int                 result;
   int                 etype;
-  void              **found;
-  sc_keyvalue_entry_t svalue, *pvalue = &svalue;
+  sc_keyvalue_key_t   skey;
   sc_keyvalue_entry_t *value;
 
   SC_ASSERT (kv != NULL);
@@ -306,10 +352,8 @@ sc_keyvalue_get_int_check (sc_keyvalue_t * kv, const char *key, int *status)
 
   result = (status != NULL) ? *status : INT_MIN;
   etype = 1;
-  pvalue->key = key;
-  pvalue->type = SC_KEYVALUE_ENTRY_NONE;
-  if (sc_hash_lookup (kv->hash, pvalue, &found)) {
-    value = (sc_keyvalue_entry_t *) (*found);
+  sc_keyvalue_key_init (&skey, key);
+  if ((value = sc_keyvalue_find (kv, &skey)) != NULL) {
     if (value->type == SC_KEYVALUE_ENTRY_INT) {
       etype = 0;
       result = value->value.i;
@@ -328,126 +372,67 @@ sc_keyvalue_get_int_check (sc_keyvalue_t * kv, const char *key, int *status)
 void
 sc_keyvalue_set_int (sc_keyvalue_t * kv, const char *key, int newvalue)
 {
-  void              **found;
-  sc_keyvalue_entry_t svalue, *pvalue = &svalue;
-  sc_keyvalue_entry_t *value;
-
-  SC_ASSERT (kv != NULL);
-  SC_ASSERT (key != NULL);
+  sc_keyvalue_key_t   skey;
 
-  pvalue->key = key;
-  pvalue->type = SC_KEYVALUE_ENTRY_NONE;
-  if (sc_hash_lookup (kv->hash, pvalue, &found)) {
-    /* Key already exists in hash table */
-    value = (sc_keyvalue_entry_t *) (*found);
-    SC_ASSERT (value->type == SC_KEYVALUE_ENTRY_INT);
+  sc_keyvalue_key_init (&skey, key);
+  sc_keyvalue_set_int_key (kv, &skey, newvalue);
+}
 
-    value->value.i = newvalue;
-  }
-  else {
-    /* Key does not exist and must be created */
-    value = (sc_keyvalue_entry_t *) sc_mempool_alloc (kv->value_allocator);
-    value->key = key;
-    value->type = SC_KEYVALUE_ENTRY_INT;
-    value->value.i = newvalue;
-
-    /* Insert value into the hash table */
-    SC_EXECUTE_ASSERT_TRUE (sc_hash_insert_unique (kv->hash, value, &found));
-  }
+void
+sc_keyvalue_set_int_key (sc_keyvalue_t * kv, const sc_keyvalue_key_t * key,
+                         int newvalue)
+{
+  sc_keyvalue_insert (kv, key, SC_KEYVALUE_ENTRY_INT)->value.i = newvalue;
 }
 
 void
 sc_keyvalue_set_double (sc_keyvalue_t * kv, const char *key, double newvalue)
 {
-  void              **found;
-  sc_keyvalue_entry_t svalue, *pvalue = &svalue;
-  sc_keyvalue_entry_t *value;
-
-  SC_ASSERT (kv != NULL);
-  SC_ASSERT (key != NULL);
+  sc_keyvalue_key_t   skey;
 
-  pvalue->key = key;
-  pvalue->type = SC_KEYVALUE_ENTRY_NONE;
-  if (sc_hash_lookup (kv->hash, pvalue, &found)) {
-    /* Key already exists in hash table */
-    value = (sc_keyvalue_entry_t *) (*found);
-    SC_ASSERT (value->type == SC_KEYVALUE_ENTRY_DOUBLE);
+  sc_keyvalue_key_init (&skey, key);
+  sc_keyvalue_set_double_key (kv, &skey, newvalue);
+}
 
-    value->value.g = newvalue;
-  }
-  else {
-    /* Key does not exist and must be created */
-    value = (sc_keyvalue_entry_t *) sc_mempool_alloc (kv->value_allocator);
-    value->key = key;
-    value->type = SC_KEYVALUE_ENTRY_DOUBLE;
-    value->value.g = newvalue;
-
-    /* Insert value into the hash table */
-    SC_EXECUTE_ASSERT_TRUE (sc_hash_insert_unique (kv->hash, value, &found));
-  }
+void
+sc_keyvalue_set_double_key (sc_keyvalue_t * kv,
+                            const sc_keyvalue_key_t * key, double newvalue)
+{
+  sc_keyvalue_insert (kv, key, SC_KEYVALUE_ENTRY_DOUBLE)->value.g = newvalue;
 }
 
 void
 sc_keyvalue_set_string (sc_keyvalue_t * kv, const char *key,
                         const char *newvalue)
 {
-  void              **found;
-  sc_keyvalue_entry_t svalue, *pvalue = &svalue;
-  sc_keyvalue_entry_t *value;
+  sc_keyvalue_key_t   skey;
 
-  SC_ASSERT (kv != NULL);
-  SC_ASSERT (key != NULL);
-
-  pvalue->key = key;
-  pvalue->type = SC_KEYVALUE_ENTRY_NONE;
-  if (sc_hash_lookup (kv->hash, pvalue, &found)) {
-    /* Key already exists in hash table */
-    value = (sc_keyvalue_entry_t *) (*found);
-    SC_ASSERT (value->type == SC_KEYVALUE_ENTRY_STRING);
+  sc_keyvalue_key_init (&skey, key);
+  sc_keyvalue_set_string_key (kv, &skey, newvalue);
+}
 
-    value->value.s = newvalue;
-  }
-  else {
-    /* Key does not exist and must be created */
-    value = (sc_keyvalue_entry_t *) sc_mempool_alloc (kv->value_allocator);
-    value->key = key;
-    value->type = SC_KEYVALUE_ENTRY_STRING;
-    value->value.s = newvalue;
-
-    /* Insert value into the hash table */
-    SC_EXECUTE_ASSERT_TRUE (sc_hash_insert_unique (kv->hash, value, &found));
-  }
+void
+sc_keyvalue_set_string_key (sc_keyvalue_t * kv,
+                            const sc_keyvalue_key_t * key,
+                            const char *newvalue)
+{
+  sc_keyvalue_insert (kv, key, SC_KEYVALUE_ENTRY_STRING)->value.s = newvalue;
 }
 
 void
 sc_keyvalue_set_pointer (sc_keyvalue_t * kv, const char *key, void *newvalue)
 {
-  void              **found;
-  sc_keyvalue_entry_t svalue, *pvalue = &svalue;
-  sc_keyvalue_entry_t *value;
-
-  SC_ASSERT (kv != NULL);
-  SC_ASSERT (key != NULL);
+  sc_keyvalue_key_t   skey;
 
-  pvalue->key = key;
-  pvalue->type = SC_KEYVALUE_ENTRY_NONE;
-  if (sc_hash_lookup (kv->hash, pvalue, &found)) {
-    /* Key already exists in hash table */
-    value = (sc_keyvalue_entry_t *) (*found);
-    SC_ASSERT (value->type == SC_KEYVALUE_ENTRY_POINTER);
+  sc_keyvalue_key_init (&skey, key);
+  sc_keyvalue_set_pointer_key (kv, &skey, newvalue);
+}
 
-    value->value.p = (void *) newvalue;
-  }
-  else {
-    /* Key does not exist and must be created */
-    value = (sc_keyvalue_entry_t *) sc_mempool_alloc (kv->value_allocator);
-    value->key = key;
-    value->type = SC_KEYVALUE_ENTRY_POINTER;
-    value->value.p = (void *) newvalue;
-
-    /* Insert value into the hash table */
-    SC_EXECUTE_ASSERT_TRUE (sc_hash_insert_unique (kv->hash, value, &found));
-  }
+void
+sc_keyvalue_set_pointer_key (sc_keyvalue_t * kv,
+                             const sc_keyvalue_key_t * key, void *newvalue)
+{
+  sc_keyvalue_insert (kv, key, SC_KEYVALUE_ENTRY_POINTER)->value.p = newvalue;
 }
 
 typedef struct sc_kv_hash_data
@@ -458,10 +443,10 @@ typedef struct sc_kv_hash_data
 sc_kv_hash_data_t;
 
 static int
-sc_kv_hash_fn (void **v, const void *u)
+sc_kv_hash_fn (void *v, const void *u)
 {
   const sc_kv_hash_data_t *hdata = (const sc_kv_hash_data_t *) u;
-  sc_keyvalue_entry_t *hentry = (sc_keyvalue_entry_t *) * v;
+  sc_keyvalue_entry_t *hentry = (sc_keyvalue_entry_t *) v;
   const char         *key = hentry->key;
   sc_keyvalue_entry_type_t type = hentry->type;
   void               *entry = &(hentry->value.p);
@@ -481,7 +466,194 @@ sc_keyvalue_foreach (sc_keyvalue_t * kv, sc_keyvalue_foreach_t fn,
   SC_ASSERT (kv->hash->user_data == NULL);
   kv->hash->user_data = &hdata;
 
-  sc_hash_foreach (kv->hash, sc_kv_hash_fn);
+  sc_ohash_foreach (kv->hash, sc_kv_hash_fn);
 
   kv->hash->user_data = NULL;
 }
+
+/** Append bytes to a buffer of element size 1. */
+static void
+sc_keyvalue_pack_bytes (sc_array_t * buffer, const void *data, size_t size)
+{
+  memcpy (sc_array_push_count (buffer, size), data, size);
+}
+
+/** Append an integer length and a string with its terminating NUL. */
+static void
+sc_keyvalue_pack_string (sc_array_t * buffer, const char *s)
+{
+  int                 len = s == NULL ? -1 : (int) strlen (s) + 1;
+
+  sc_keyvalue_pack_bytes (buffer, &len, sizeof (int));
+  if (len > 0) {
+    sc_keyvalue_pack_bytes (buffer, s, (size_t) len);
+  }
+}
+
+typedef struct sc_kv_pack_data
+{
+  sc_array_t         *buffer;
+  int                 count;
+}
+sc_kv_pack_data_t;
+
+static int
+sc_keyvalue_pack_fn (void *v, const void *u)
+{
+  sc_kv_pack_data_t  *pdata = (sc_kv_pack_data_t *) u;
+  sc_array_t         *buffer = pdata->buffer;
+  sc_keyvalue_entry_t *hentry = (sc_keyvalue_entry_t *) v;
+  int                 type = (int) hentry->type;
+
+  if (hentry->type == SC_KEYVALUE_ENTRY_POINTER) {
+    /* pointers are meaningless in another address space */
+    return 1;
+  }
+  sc_keyvalue_pack_bytes (buffer, &type, sizeof (int));
+  sc_keyvalue_pack_string (buffer, hentry->key);
+  switch (hentry->type) {
+  case SC_KEYVALUE_ENTRY_INT:
+    sc_keyvalue_pack_bytes (buffer, &hentry->value.i, sizeof (int));
+    break;
+  case SC_KEYVALUE_ENTRY_DOUBLE:
+    sc_keyvalue_pack_bytes (buffer, &hentry->value.g, sizeof (double));
+    break;
+  case SC_KEYVALUE_ENTRY_STRING:
+    sc_keyvalue_pack_string (buffer, hentry->value.s);
+    break;
+  default:
+    SC_ABORT_NOT_REACHED ();
+  }
+  ++pdata->count;
+  return 1;
+}
+
+void
+sc_keyvalue_pack (sc_keyvalue_t * kv, sc_array_t * buffer)
+{
+  size_t              offset;
+  sc_kv_pack_data_t   pdata;
+
+  SC_ASSERT (kv != NULL);
+  SC_ASSERT (kv->hash->user_data == NULL);
+  SC_ASSERT (buffer != NULL && buffer->elem_size == 1);
+
+  /* the count is written in place when the entries are known */
+  pdata.buffer = buffer;
+  pdata.count = 0;
+  offset = buffer->elem_count;
+  sc_keyvalue_pack_bytes (buffer, &pdata.count, sizeof (int));
+  kv->hash->user_data = &pdata;
+  sc_ohash_foreach (kv->hash, sc_keyvalue_pack_fn);
+  kv->hash->user_data = NULL;
+  memcpy (sc_array_index (buffer, offset), &pdata.count, sizeof (int));
+}
+
+/** Return a pointer to the next bytes of a buffer or NULL if too short. */
+static const char  *
+sc_keyvalue_unpack_bytes (sc_array_t * buffer, size_t *position,
+                          size_t size)
+{
+  const char         *data;
+
+  if (size > buffer->elem_count - *position) {
+    return NULL;
+  }
+  data = buffer->array + *position;
+  *position += size;
+  return data;
+}
+
+/** Return a string inside the buffer.  It is NULL for a NULL string or
+ * on error, which is indicated by setting \a iserror. */
+static const char  *
+sc_keyvalue_unpack_string (sc_array_t * buffer, size_t *position,
+                           int *iserror)
+{
+  int                 len;
+  const char         *data;
+
+  if ((data = sc_keyvalue_unpack_bytes (buffer, position, sizeof (int)))
+      == NULL) {
+    *iserror = 1;
+    return NULL;
+  }
+  memcpy (&len, data, sizeof (int));
+  if (len < 0) {
+    return NULL;
+  }
+  if (len == 0 ||
+      (data = sc_keyvalue_unpack_bytes (buffer, position, (size_t) len))
+      == NULL || data[len - 1] != '\0') {
+    *iserror = 1;
+    return NULL;
+  }
+  return data;
+}
+
+int
+sc_keyvalue_unpack (sc_keyvalue_t * kv, sc_array_t * buffer,
+                    size_t *position)
+{
+  int                 iserror = 0;
+  int                 i, count, type;
+  const char         *data;
+  const char         *s;
+  sc_keyvalue_key_t   key;
+  sc_keyvalue_entry_t *found;
+
+  SC_ASSERT (kv != NULL);
+  SC_ASSERT (buffer != NULL && buffer->elem_size == 1);
+  SC_ASSERT (position != NULL && *position <= buffer->elem_count);
+
+  if ((data = sc_keyvalue_unpack_bytes (buffer, position, sizeof (int)))
+      == NULL) {
+    return -1;
+  }
+  memcpy (&count, data, sizeof (int));
+  for (i = 0; !iserror && i < count; ++i) {
+    if ((data = sc_keyvalue_unpack_bytes (buffer, position, sizeof (int)))
+        == NULL) {
+      return -1;
+    }
+    memcpy (&type, data, sizeof (int));
+    s = sc_keyvalue_unpack_string (buffer, position, &iserror);
+    if (iserror || s == NULL) {
+      return -1;
+    }
+    sc_keyvalue_key_init (&key, s);
+
+    /* an existing key of another type is an error */
+    found = sc_keyvalue_find (kv, &key);
+    if (found != NULL && (int) found->type != type) {
+      return -1;
+    }
+    switch (type) {
+    case SC_KEYVALUE_ENTRY_INT:
+      if ((data = sc_keyvalue_unpack_bytes (buffer, position, sizeof (int)))
+          == NULL) {
+        return -1;
+      }
+      found = sc_keyvalue_insert (kv, &key, SC_KEYVALUE_ENTRY_INT);
+      memcpy (&found->value.i, data, sizeof (int));
+      break;
+    case SC_KEYVALUE_ENTRY_DOUBLE:
+      if ((data = sc_keyvalue_unpack_bytes (buffer, position,
+                                            sizeof (double))) == NULL) {
+        return -1;
+      }
+      found = sc_keyvalue_insert (kv, &key, SC_KEYVALUE_ENTRY_DOUBLE);
+      memcpy (&found->value.g, data, sizeof (double));
+      break;
+    case SC_KEYVALUE_ENTRY_STRING:
+      s = sc_keyvalue_unpack_string (buffer, position, &iserror);
+      if (!iserror) {
+        sc_keyvalue_set_string_key (kv, &key, s);
+      }
+      break;
+    default:
+      return -1;
+    }
+  }
+  return iserror ? -1 : 0;
+}
@@ -43,9 +43,33 @@ typedef enum
 }
 sc_keyvalue_entry_type_t;
 
-/** The key-value container is an opaque structure. */
+/** The key-value container is an opaque structure.
+ * The entries are stored inline in an open addressing hash table,
+ * see \ref sc_ohash_t.  The keys are not copied and must stay valid
+ * as long as they are in the container.
+ */
 typedef struct sc_keyvalue sc_keyvalue_t;
 
+/** A key with its hash value computed once.
+ * Passing it to the functions ending in _key avoids hashing the string
+ * on every access, which is useful in loops over many containers with
+ * the same keys.  Keys of the same string address compare without
+ * looking at the characters.
+ */
+typedef struct sc_keyvalue_key
+{
+  const char         *key;      /**< The string of the key. */
+  unsigned            hash;     /**< Its hash value. */
+}
+sc_keyvalue_key_t;
+
+/** Prepare a key for the functions ending in _key.
+ * \param [out] key             Initialized to refer to \a string.
+ * \param [in] string           Key string that must outlive \a key.
+ */
+void                sc_keyvalue_key_init (sc_keyvalue_key_t * key,
+                                          const char *string);
+
 /** Create a new key-value container.
  * \return          The container is ready to use.
  */
@@ -193,6 +217,48 @@ void                sc_keyvalue_set_string (sc_keyvalue_t * kv,
 void                sc_keyvalue_set_pointer (sc_keyvalue_t * kv,
                                              const char *key, void *newvalue);
 
+/** @{ \name Access by keys prepared with \ref sc_keyvalue_key_init
+ * These functions behave like the ones without the suffix _key.
+ */
+
+sc_keyvalue_entry_type_t sc_keyvalue_exists_key (sc_keyvalue_t * kv,
+                                                 const sc_keyvalue_key_t *
+                                                 key);
+
+int                 sc_keyvalue_get_int_key (sc_keyvalue_t * kv,
+                                             const sc_keyvalue_key_t * key,
+                                             int dvalue);
+
+double              sc_keyvalue_get_double_key (sc_keyvalue_t * kv,
+                                                const sc_keyvalue_key_t *
+                                                key, double dvalue);
+
+const char         *sc_keyvalue_get_string_key (sc_keyvalue_t * kv,
+                                                const sc_keyvalue_key_t *
+                                                key, const char *dvalue);
+
+void               *sc_keyvalue_get_pointer_key (sc_keyvalue_t * kv,
+                                                 const sc_keyvalue_key_t *
+                                                 key, void *dvalue);
+
+void                sc_keyvalue_set_int_key (sc_keyvalue_t * kv,
+                                             const sc_keyvalue_key_t * key,
+                                             int newvalue);
+
+void                sc_keyvalue_set_double_key (sc_keyvalue_t * kv,
+                                                const sc_keyvalue_key_t *
+                                                key, double newvalue);
+
+void                sc_keyvalue_set_string_key (sc_keyvalue_t * kv,
+                                                const sc_keyvalue_key_t *
+                                                key, const char *newvalue);
+
+void                sc_keyvalue_set_pointer_key (sc_keyvalue_t * kv,
+                                                 const sc_keyvalue_key_t *
+                                                 key, void *newvalue);
+
+/** @} */
+
 /** Function to call on every key value pair
  * \param [in] key   The key for this pair
  * \param [in] type  The type of entry
@@ -206,6 +272,7 @@ typedef int         (*sc_keyvalue_foreach_t) (const char *key,
                                               const void *u);
 
 /** Iterate through all stored key-value pairs.
+ * The container must not be modified during the iteration.
  * \param [in] kv               Valid key-value container.
  * \param [in] fn               Function to call on each key-value pair.
  * \param [in,out] user_data    This pointer is passed through to \b fn.
@@ -214,6 +281,35 @@ void                sc_keyvalue_foreach (sc_keyvalue_t * kv,
                                          sc_keyvalue_foreach_t fn,
                                          void *user_data);
 
+/** Append the int, double and string entries to a byte buffer.
+ * Pointer entries are skipped.  The format is binary and only meant to be
+ * read by \ref sc_keyvalue_unpack on the same architecture, for example
+ * after sending the buffer in a message or storing it in a checkpoint.
+ * \param [in] kv               Valid key-value container.
+ * \param [in,out] buffer       Array of element size 1.  It is enlarged.
+ */
+void                sc_keyvalue_pack (sc_keyvalue_t * kv,
+                                      sc_array_t * buffer);
+
+/** Insert the entries written by \ref sc_keyvalue_pack into a container.
+ * Like the set functions, the container does not copy the strings:
+ * the keys and string values point into \a buffer, which must not be
+ * modified or destroyed while \a kv is in use.
+ * \param [in,out] kv           Valid key-value container.  Existing
+ *                              entries with the same keys are updated.
+ * \param [in] buffer           Array of element size 1.
+ * \param [in,out] position     On input, the byte offset into \a buffer
+ *                              to read from.  On output, the offset
+ *                              just after the entries that were read.
+ * \return                      Returns 0 on success and -1 if the buffer
+ *                              is corrupt or a key exists in \a kv with
+ *                              a different type.  In this case some
+ *                              entries may have been inserted already.
+ */
+int                 sc_keyvalue_unpack (sc_keyvalue_t * kv,
+                                        sc_array_t * buffer,
+                                        size_t *position);
+
 SC_EXTERN_C_END;
 
 #endif /* !SC_KEYVALUE_H */
@@ -0,0 +1,266 @@
+/*
+  This file is part of the SC Library.
+  The SC Library provides support for parallel scientific applications.
+
+  Copyright (C) 2010 The University of Texas System
+  Additional copyright (C) 2011 individual authors
+
+  The SC Library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  The SC Library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with the SC Library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+  02110-1301, USA.
+*/
+
+#include <sc_lists.h>
+
+/* the elements of a node begin at this offset, which keeps them aligned
+ * for any type of 16 bytes or less */
+#define SC_ULIST_HEADER_BYTES \
+  ((sizeof (sc_ulist_node_t) + 15) & ~((size_t) 15))
+
+/* the element at a position of a node */
+static inline char *
+sc_ulist_node_elem (sc_ulist_t * list, sc_ulist_node_t * node, size_t pos)
+{
+  return (char *) node + SC_ULIST_HEADER_BYTES + pos * list->elem_size;
+}
+
+static sc_ulist_node_t *
+sc_ulist_node_new (sc_ulist_t * list, size_t begin)
+{
+  sc_ulist_node_t    *node;
+
+  node = (sc_ulist_node_t *) sc_mempool_alloc (list->allocator);
+  node->next = node->prev = NULL;
+  node->begin = begin;
+  node->count = 0;
+  ++list->node_count;
+
+  return node;
+}
+
+static void
+sc_ulist_node_unlink (sc_ulist_t * list, sc_ulist_node_t * node)
+{
+  SC_ASSERT (node->count == 0);
+
+  if (node->prev == NULL) {
+    list->first = node->next;
+  }
+  else {
+    node->prev->next = node->next;
+  }
+  if (node->next == NULL) {
+    list->last = node->prev;
+  }
+  else {
+    node->next->prev = node->prev;
+  }
+  sc_mempool_free (list->allocator, node);
+  --list->node_count;
+}
+
+void
+sc_ulist_init (sc_ulist_t * list, size_t elem_size, size_t node_elems)
+{
+  SC_ASSERT (elem_size > 0);
+
+  if (node_elems == 0) {
+    node_elems = SC_MAX (SC_ULIST_NODE_BYTES / elem_size, 1);
+  }
+  list->elem_size = elem_size;
+  list->elem_count = 0;
+  list->node_elems = node_elems;
+  list->node_count = 0;
+  list->first = list->last = NULL;
+  list->allocator = sc_mempool_new (SC_ULIST_HEADER_BYTES +
+                                    node_elems * elem_size);
+}
+
+void
+sc_ulist_reset (sc_ulist_t * list)
+{
+  sc_mempool_destroy (list->allocator);
+  list->allocator = NULL;
+  list->first = list->last = NULL;
+  list->elem_count = list->node_count = 0;
+}
+
+sc_ulist_t         *
+sc_ulist_new (size_t elem_size, size_t node_elems)
+{
+  sc_ulist_t         *list;
+
+  list = SC_ALLOC (sc_ulist_t, 1);
+  sc_ulist_init (list, elem_size, node_elems);
+
+  return list;
+}
+
+void
+sc_ulist_destroy (sc_ulist_t * list)
+{
+  sc_ulist_reset (list);
+  SC_FREE (list);
+}
+
+void
+sc_ulist_truncate (sc_ulist_t * list)
+{
+  sc_ulist_node_t    *node, *next;
+
+  for (node = list->first; node != NULL; node = next) {
+    next = node->next;
+    sc_mempool_free (list->allocator, node);
+  }
+  list->first = list->last = NULL;
+  list->elem_count = list->node_count = 0;
+}
+
+size_t
+sc_ulist_memory_used (sc_ulist_t * list, int is_dynamic)
+{
+  return (is_dynamic ? sizeof (sc_ulist_t) : 0) +
+    sc_mempool_memory_used (list->allocator);
+}
+
+void               *
+sc_ulist_push_back (sc_ulist_t * list)
+{
+  sc_ulist_node_t    *node = list->last;
+
+  if (node == NULL || node->begin + node->count == list->node_elems) {
+    /* a new last node fills up from its beginning */
+    node = sc_ulist_node_new (list, 0);
+    node->prev = list->last;
+    if (list->last == NULL) {
+      list->first = node;
+    }
+    else {
+      list->last->next = node;
+    }
+    list->last = node;
+  }
+  ++node->count;
+  ++list->elem_count;
+
+  return sc_ulist_node_elem (list, node, node->begin + node->count - 1);
+}
+
+void               *
+sc_ulist_push_front (sc_ulist_t * list)
+{
+  sc_ulist_node_t    *node = list->first;
+
+  if (node == NULL || node->begin == 0) {
+    /* a new first node fills up from its end */
+    node = sc_ulist_node_new (list, list->node_elems);
+    node->next = list->first;
+    if (list->first == NULL) {
+      list->last = node;
+    }
+    else {
+      list->first->prev = node;
+    }
+    list->first = node;
+  }
+  --node->begin;
+  ++node->count;
+  ++list->elem_count;
+
+  return sc_ulist_node_elem (list, node, node->begin);
+}
+
+void               *
+sc_ulist_front (sc_ulist_t * list)
+{
+  if (list->first == NULL) {
+    return NULL;
+  }
+  return sc_ulist_node_elem (list, list->first, list->first->begin);
+}
+
+void               *
+sc_ulist_back (sc_ulist_t * list)
+{
+  sc_ulist_node_t    *node = list->last;
+
+  if (node == NULL) {
+    return NULL;
+  }
+  return sc_ulist_node_elem (list, node, node->begin + node->count - 1);
+}
+
+void
+sc_ulist_pop_front (sc_ulist_t * list, void *elem)
+{
+  sc_ulist_node_t    *node = list->first;
+
+  SC_ASSERT (list->elem_count > 0 && node != NULL && node->count > 0);
+
+  if (elem != NULL) {
+    memcpy (elem, sc_ulist_node_elem (list, node, node->begin),
+            list->elem_size);
+  }
+  ++node->begin;
+  --node->count;
+  --list->elem_count;
+  if (node->count == 0) {
+    sc_ulist_node_unlink (list, node);
+  }
+}
+
+void
+sc_ulist_pop_back (sc_ulist_t * list, void *elem)
+{
+  sc_ulist_node_t    *node = list->last;
+
+  SC_ASSERT (list->elem_count > 0 && node != NULL && node->count > 0);
+
+  --node->count;
+  --list->elem_count;
+  if (elem != NULL) {
+    memcpy (elem, sc_ulist_node_elem (list, node, node->begin + node->count),
+            list->elem_size);
+  }
+  if (node->count == 0) {
+    sc_ulist_node_unlink (list, node);
+  }
+}
+
+void               *
+sc_ulist_iter_first (sc_ulist_t * list, sc_ulist_iter_t * iter)
+{
+  iter->node = list->first;
+  iter->pos = 0;
+  if (iter->node == NULL) {
+    return NULL;
+  }
+  return sc_ulist_node_elem (list, iter->node, iter->node->begin);
+}
+
+void               *
+sc_ulist_iter_next (sc_ulist_t * list, sc_ulist_iter_t * iter)
+{
+  if (iter->node == NULL) {
+    return NULL;
+  }
+  if (++iter->pos == iter->node->count) {
+    iter->node = iter->node->next;
+    iter->pos = 0;
+    if (iter->node == NULL) {
+      return NULL;
+    }
+  }
+  return sc_ulist_node_elem (list, iter->node, iter->node->begin + iter->pos);
+}
@@ -0,0 +1,349 @@
+/*
+  This file is part of the SC Library.
+  The SC Library provides support for parallel scientific applications.
+
+  Copyright (C) 2010 The University of Texas System
+  Additional copyright (C) 2011 individual authors
+
+  The SC Library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  The SC Library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with the SC Library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+  02110-1301, USA.
+*/
+
+#ifndef SC_LISTS_H
+#define SC_LISTS_H
+
+/** \file sc_lists.h
+ *
+ * Linked lists that do not allocate a link per element.
+ *
+ * A \ref sc_list_t allocates one \ref sc_link_t per element, which points
+ * to the data in turn, such that a traversal follows two pointers per
+ * element.  The intrusive list \ref sc_ilist_t links structures of the
+ * user that contain an \ref sc_ilink_t member.  It does not allocate at all
+ * and removes any element in constant time.  The unrolled list
+ * \ref sc_ulist_t stores copies of fixed-size elements, many of them in
+ * each node, which it allocates from a \ref sc_mempool_t.
+ *
+ * \ingroup sc_containers
+ */
+
+#include <sc_containers.h>
+
+/** Obtain the structure containing an intrusive link.
+ * \param [in] link     Pointer to the \ref sc_ilink_t member.
+ * \param [in] type     The type of the containing structure.
+ * \param [in] member   The name of the \ref sc_ilink_t member.
+ */
+#define SC_ILIST_ENTRY(link,type,member) \
+  ((type *) ((char *) (link) - offsetof (type, member)))
+
+/** The default number of bytes of elements in an unrolled list node. */
+#define SC_ULIST_NODE_BYTES 512
+
+SC_EXTERN_C_BEGIN;
+
+/** The link of an intrusive list embedded in a structure of the user.
+ * Its fields must only be modified by the functions below.
+ */
+typedef struct sc_ilink
+{
+  struct sc_ilink    *next;
+  struct sc_ilink    *prev;
+}
+sc_ilink_t;
+
+/** The intrusive doubly linked list.
+ * The links form a ring through the head, which is not an element.
+ */
+typedef struct sc_ilist
+{
+  /* interface variables */
+  size_t              elem_count;
+
+  /* implementation variables */
+  sc_ilink_t          head;
+}
+sc_ilist_t;
+
+/** Initialize an empty intrusive list.
+ * An intrusive list owns no memory and needs no reset.
+ * \param [out] list        The list to initialize.
+ */
+static inline void
+sc_ilist_init (sc_ilist_t * list)
+{
+  list->elem_count = 0;
+  list->head.next = list->head.prev = &list->head;
+}
+
+/** Return the first link of a list or NULL if it is empty.
+ * \param [in] list         Valid list.
+ */
+static inline sc_ilink_t *
+sc_ilist_first (sc_ilist_t * list)
+{
+  return list->head.next == &list->head ? NULL : list->head.next;
+}
+
+/** Return the last link of a list or NULL if it is empty.
+ * \param [in] list         Valid list.
+ */
+static inline sc_ilink_t *
+sc_ilist_last (sc_ilist_t * list)
+{
+  return list->head.prev == &list->head ? NULL : list->head.prev;
+}
+
+/** Return the successor of a link or NULL at the end of the list.
+ * \param [in] list         Valid list.
+ * \param [in] link         A link in the list.
+ */
+static inline sc_ilink_t *
+sc_ilist_next (sc_ilist_t * list, sc_ilink_t * link)
+{
+  return link->next == &list->head ? NULL : link->next;
+}
+
+/** Return the predecessor of a link or NULL at the front of the list.
+ * \param [in] list         Valid list.
+ * \param [in] link         A link in the list.
+ */
+static inline sc_ilink_t *
+sc_ilist_prev (sc_ilist_t * list, sc_ilink_t * link)
+{
+  return link->prev == &list->head ? NULL : link->prev;
+}
+
+/** Insert a link after a given position.
+ * \param [in,out] list     Valid list.
+ * \param [in,out] pred     A link in the list or NULL to insert at the front.
+ * \param [out] link        A link that is not in any list.
+ */
+static inline void
+sc_ilist_insert (sc_ilist_t * list, sc_ilink_t * pred, sc_ilink_t * link)
+{
+  if (pred == NULL) {
+    pred = &list->head;
+  }
+  link->prev = pred;
+  link->next = pred->next;
+  pred->next->prev = link;
+  pred->next = link;
+  ++list->elem_count;
+}
+
+/** Insert a link at the front of a list.
+ * \param [in,out] list     Valid list.
+ * \param [out] link        A link that is not in any list.
+ */
+static inline void
+sc_ilist_prepend (sc_ilist_t * list, sc_ilink_t * link)
+{
+  sc_ilist_insert (list, NULL, link);
+}
+
+/** Insert a link at the end of a list.
+ * \param [in,out] list     Valid list.
+ * \param [out] link        A link that is not in any list.
+ */
+static inline void
+sc_ilist_append (sc_ilist_t * list, sc_ilink_t * link)
+{
+  sc_ilist_insert (list, list->head.prev, link);
+}
+
+/** Remove a link from a list in constant time.
+ * \param [in,out] list     Valid list.
+ * \param [in,out] link     A link in the list.  It is unlinked on output.
+ */
+static inline void
+sc_ilist_remove (sc_ilist_t * list, sc_ilink_t * link)
+{
+  SC_ASSERT (list->elem_count > 0 && link != &list->head);
+
+  link->prev->next = link->next;
+  link->next->prev = link->prev;
+  link->next = link->prev = NULL;
+  --list->elem_count;
+}
+
+/** Remove the first link of a list.
+ * \param [in,out] list     Valid list.
+ * \return                  The link removed, or NULL if the list is empty.
+ */
+static inline sc_ilink_t *
+sc_ilist_pop (sc_ilist_t * list)
+{
+  sc_ilink_t         *link = sc_ilist_first (list);
+
+  if (link != NULL) {
+    sc_ilist_remove (list, link);
+  }
+  return link;
+}
+
+/** Move all links of a list to the end of another in constant time.
+ * \param [in,out] list     Valid list receiving the links.
+ * \param [in,out] other    Valid list, which is empty on output.
+ */
+static inline void
+sc_ilist_concat (sc_ilist_t * list, sc_ilist_t * other)
+{
+  SC_ASSERT (list != other);
+
+  if (other->elem_count == 0) {
+    return;
+  }
+  other->head.next->prev = list->head.prev;
+  other->head.prev->next = &list->head;
+  list->head.prev->next = other->head.next;
+  list->head.prev = other->head.prev;
+  list->elem_count += other->elem_count;
+  sc_ilist_init (other);
+}
+
+/** One node of an unrolled list.  Its elements follow the header. */
+typedef struct sc_ulist_node
+{
+  struct sc_ulist_node *next;
+  struct sc_ulist_node *prev;
+  size_t              begin;    /**< position of the first element */
+  size_t              count;    /**< number of elements from begin */
+}
+sc_ulist_node_t;
+
+/** The unrolled doubly linked list of fixed-size elements.
+ * Each node holds up to node_elems consecutive elements.  Adding and
+ * removing at either end is constant time and moves no elements, such that
+ * pointers to elements remain valid until the elements are removed.
+ */
+typedef struct sc_ulist
+{
+  /* interface variables */
+  size_t              elem_size;        /**< size of one element in bytes */
+  size_t              elem_count;       /**< number of elements */
+
+  /* implementation variables */
+  size_t              node_elems;       /**< element capacity of a node */
+  size_t              node_count;       /**< number of nodes */
+  sc_ulist_node_t    *first;
+  sc_ulist_node_t    *last;
+  sc_mempool_t       *allocator;        /**< allocates the nodes */
+}
+sc_ulist_t;
+
+/** The position of an element during a traversal of an unrolled list. */
+typedef struct sc_ulist_iter
+{
+  sc_ulist_node_t    *node;
+  size_t              pos;
+}
+sc_ulist_iter_t;
+
+/** Initialize an empty unrolled list.
+ * \param [out] list        The list to initialize.
+ * \param [in] elem_size    Size of one element in bytes.
+ * \param [in] node_elems   Number of elements per node.  If 0, as many
+ *                          as fit into \ref SC_ULIST_NODE_BYTES and at
+ *                          least one.
+ */
+void                sc_ulist_init (sc_ulist_t * list, size_t elem_size,
+                                   size_t node_elems);
+
+/** Free the memory of a list initialized by \ref sc_ulist_init.
+ * \param [in,out] list     The list is invalid on output.
+ */
+void                sc_ulist_reset (sc_ulist_t * list);
+
+/** Allocate a new, empty unrolled list.
+ * \param [in] elem_size    Size of one element in bytes.
+ * \param [in] node_elems   As in \ref sc_ulist_init.
+ * \return                  The new list.
+ */
+sc_ulist_t         *sc_ulist_new (size_t elem_size, size_t node_elems);
+
+/** Destroy a list created by \ref sc_ulist_new.
+ * \param [in,out] list     All memory of the list is freed.
+ */
+void                sc_ulist_destroy (sc_ulist_t * list);
+
+/** Remove all elements and keep the nodes for reuse.
+ * \param [in,out] list     Valid list.
+ */
+void                sc_ulist_truncate (sc_ulist_t * list);
+
+/** Calculate the memory used by an unrolled list.
+ * \param [in] list         Valid list.
+ * \param [in] is_dynamic   True if created by \ref sc_ulist_new.
+ * \return                  Memory used in bytes.
+ */
+size_t              sc_ulist_memory_used (sc_ulist_t * list, int is_dynamic);
+
+/** Add an element at the end of a list.
+ * \param [in,out] list     Valid list.
+ * \return                  Pointer to the new, uninitialized element.
+ */
+void               *sc_ulist_push_back (sc_ulist_t * list);
+
+/** Add an element at the front of a list.
+ * \param [in,out] list     Valid list.
+ * \return                  Pointer to the new, uninitialized element.
+ */
+void               *sc_ulist_push_front (sc_ulist_t * list);
+
+/** Return the first element of a list.
+ * \param [in] list         Valid list.
+ * \return                  The first element or NULL if the list is empty.
+ */
+void               *sc_ulist_front (sc_ulist_t * list);
+
+/** Return the last element of a list.
+ * \param [in] list         Valid list.
+ * \return                  The last element or NULL if the list is empty.
+ */
+void               *sc_ulist_back (sc_ulist_t * list);
+
+/** Remove the first element of a non-empty list.
+ * \param [in,out] list     Valid, non-empty list.
+ * \param [out] elem        If not NULL, receives a copy of the element.
+ */
+void                sc_ulist_pop_front (sc_ulist_t * list, void *elem);
+
+/** Remove the last element of a non-empty list.
+ * \param [in,out] list     Valid, non-empty list.
+ * \param [out] elem        If not NULL, receives a copy of the element.
+ */
+void                sc_ulist_pop_back (sc_ulist_t * list, void *elem);
+
+/** Begin a traversal of an unrolled list.
+ * \param [in] list         Valid list, which must not change during the
+ *                          traversal.
+ * \param [out] iter        The position of the first element.
+ * \return                  The first element or NULL if the list is empty.
+ */
+void               *sc_ulist_iter_first (sc_ulist_t * list,
+                                         sc_ulist_iter_t * iter);
+
+/** Advance a traversal of an unrolled list.
+ * \param [in] list         The list passed to \ref sc_ulist_iter_first.
+ * \param [in,out] iter     The position, which is advanced by one.
+ * \return                  The next element or NULL at the end.
+ */
+void               *sc_ulist_iter_next (sc_ulist_t * list,
+                                        sc_ulist_iter_t * iter);
+
+SC_EXTERN_C_END;
+
+#endif /* !SC_LISTS_H */
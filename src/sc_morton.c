@@ -0,0 +1,320 @@
+/*
+  This file is part of the SC Library.
+  The SC Library provides support for parallel scientific applications.
+
+  Copyright (C) 2010 The University of Texas System
+  Additional copyright (C) 2011 individual authors
+
+  The SC Library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  The SC Library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with the SC Library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+  02110-1301, USA.
+*/
+
+#include <sc_morton.h>
+#if defined (__BMI2__) && defined (__x86_64__)
+#include <immintrin.h>
+#define SC_MORTON_BMI2
+#define SC_MORTON_KERNEL "morton bmi2"
+#else
+#define SC_MORTON_KERNEL "morton table"
+#endif
+
+/** The key bits of the first of two coordinates. */
+#define SC_MORTON_MASK2 0x5555555555555555ULL
+
+/** The key bits of the first of three coordinates. */
+#define SC_MORTON_MASK3 0x1249249249249249ULL
+
+#ifndef SC_MORTON_BMI2
+
+/* Spread the bits of a byte to every second bit, two bits at a time. */
+#define SC_MORTON_S2_2(n) (n), (n) + 1, (n) + 4, (n) + 5
+#define SC_MORTON_S2_4(n) SC_MORTON_S2_2 (n), SC_MORTON_S2_2 ((n) + 16), \
+    SC_MORTON_S2_2 ((n) + 64), SC_MORTON_S2_2 ((n) + 80)
+#define SC_MORTON_S2_6(n) SC_MORTON_S2_4 (n), SC_MORTON_S2_4 ((n) + 256), \
+    SC_MORTON_S2_4 ((n) + 1024), SC_MORTON_S2_4 ((n) + 1280)
+#define SC_MORTON_S2_8(n) SC_MORTON_S2_6 (n), SC_MORTON_S2_6 ((n) + 4096), \
+    SC_MORTON_S2_6 ((n) + 16384), SC_MORTON_S2_6 ((n) + 20480)
+
+/* Spread the bits of a byte to every third bit, two bits at a time. */
+#define SC_MORTON_S3_2(n) (n), (n) + 1, (n) + 8, (n) + 9
+#define SC_MORTON_S3_4(n) SC_MORTON_S3_2 (n), SC_MORTON_S3_2 ((n) + 64), \
+    SC_MORTON_S3_2 ((n) + 512), SC_MORTON_S3_2 ((n) + 576)
+#define SC_MORTON_S3_6(n) SC_MORTON_S3_4 (n), SC_MORTON_S3_4 ((n) + 4096), \
+    SC_MORTON_S3_4 ((n) + 32768), SC_MORTON_S3_4 ((n) + 36864)
+#define SC_MORTON_S3_8(n) SC_MORTON_S3_6 (n),                   \
+    SC_MORTON_S3_6 ((n) + 262144), SC_MORTON_S3_6 ((n) + 2097152), \
+    SC_MORTON_S3_6 ((n) + 2359296)
+
+static const uint16_t sc_morton_spread2[256] = { SC_MORTON_S2_8 (0U) };
+static const uint32_t sc_morton_spread3[256] = { SC_MORTON_S3_8 (0U) };
+
+#endif /* !SC_MORTON_BMI2 */
+
+const char         *
+sc_morton_kernel (void)
+{
+  return SC_MORTON_KERNEL;
+}
+
+/* Spread 32 bits to the even bits of a word. */
+static inline uint64_t
+sc_morton_spread_2 (uint32_t x)
+{
+#ifdef SC_MORTON_BMI2
+  return _pdep_u64 (x, SC_MORTON_MASK2);
+#else
+  return (uint64_t) sc_morton_spread2[x & 0xff] |
+    (uint64_t) sc_morton_spread2[(x >> 8) & 0xff] << 16 |
+    (uint64_t) sc_morton_spread2[(x >> 16) & 0xff] << 32 |
+    (uint64_t) sc_morton_spread2[x >> 24] << 48;
+#endif
+}
+
+/* Gather the even bits of a word. */
+static inline uint32_t
+sc_morton_compact_2 (uint64_t k)
+{
+#ifdef SC_MORTON_BMI2
+  return (uint32_t) _pext_u64 (k, SC_MORTON_MASK2);
+#else
+  k &= SC_MORTON_MASK2;
+  k = (k | k >> 1) & 0x3333333333333333ULL;
+  k = (k | k >> 2) & 0x0f0f0f0f0f0f0f0fULL;
+  k = (k | k >> 4) & 0x00ff00ff00ff00ffULL;
+  k = (k | k >> 8) & 0x0000ffff0000ffffULL;
+  return (uint32_t) (k | k >> 16);
+#endif
+}
+
+/* Spread 21 bits to every third bit of a word. */
+static inline uint64_t
+sc_morton_spread_3 (uint32_t x)
+{
+#ifdef SC_MORTON_BMI2
+  return _pdep_u64 (x, SC_MORTON_MASK3);
+#else
+  return (uint64_t) sc_morton_spread3[x & 0xff] |
+    (uint64_t) sc_morton_spread3[(x >> 8) & 0xff] << 24 |
+    (uint64_t) sc_morton_spread3[(x >> 16) & 0x1f] << 48;
+#endif
+}
+
+/* Gather every third bit of a word. */
+static inline uint32_t
+sc_morton_compact_3 (uint64_t k)
+{
+#ifdef SC_MORTON_BMI2
+  return (uint32_t) _pext_u64 (k, SC_MORTON_MASK3);
+#else
+  k &= SC_MORTON_MASK3;
+  k = (k | k >> 2) & 0x10c30c30c30c30c3ULL;
+  k = (k | k >> 4) & 0x100f00f00f00f00fULL;
+  k = (k | k >> 8) & 0x001f0000ff0000ffULL;
+  k = (k | k >> 16) & 0x001f00000000ffffULL;
+  return (uint32_t) ((k | k >> 32) & 0x1fffff);
+#endif
+}
+
+uint64_t
+sc_morton_encode2 (uint32_t x, uint32_t y)
+{
+  return sc_morton_spread_2 (x) | sc_morton_spread_2 (y) << 1;
+}
+
+void
+sc_morton_decode2 (uint64_t key, uint32_t * x, uint32_t * y)
+{
+  SC_ASSERT (x != NULL && y != NULL);
+  *x = sc_morton_compact_2 (key);
+  *y = sc_morton_compact_2 (key >> 1);
+}
+
+uint64_t
+sc_morton_encode3 (uint32_t x, uint32_t y, uint32_t z)
+{
+  return sc_morton_spread_3 (x & 0x1fffff) |
+    sc_morton_spread_3 (y & 0x1fffff) << 1 |
+    sc_morton_spread_3 (z & 0x1fffff) << 2;
+}
+
+void
+sc_morton_decode3 (uint64_t key, uint32_t * x, uint32_t * y, uint32_t * z)
+{
+  SC_ASSERT (x != NULL && y != NULL && z != NULL);
+  *x = sc_morton_compact_3 (key);
+  *y = sc_morton_compact_3 (key >> 1);
+  *z = sc_morton_compact_3 (key >> 2);
+}
+
+void
+sc_morton_encode2_128 (uint64_t x, uint64_t y, sc_uint128_t * key)
+{
+  SC_ASSERT (key != NULL);
+
+  /* the words of the key hold 32 bits of each coordinate */
+  key->low_bits = sc_morton_encode2 ((uint32_t) x, (uint32_t) y);
+  key->high_bits = sc_morton_encode2 ((uint32_t) (x >> 32),
+                                      (uint32_t) (y >> 32));
+}
+
+void
+sc_morton_decode2_128 (const sc_uint128_t * key, uint64_t * x, uint64_t * y)
+{
+  uint32_t            xl, yl, xh, yh;
+
+  SC_ASSERT (key != NULL && x != NULL && y != NULL);
+  sc_morton_decode2 (key->low_bits, &xl, &yl);
+  sc_morton_decode2 (key->high_bits, &xh, &yh);
+  *x = (uint64_t) xh << 32 | xl;
+  *y = (uint64_t) yh << 32 | yl;
+}
+
+void
+sc_morton_encode3_128 (uint64_t x, uint64_t y, uint64_t z,
+                       sc_uint128_t * key)
+{
+  sc_uint128_t        high;
+
+  SC_ASSERT (key != NULL);
+
+  /* the lower 63 and the upper 63 key bits hold 21 bits of each */
+  sc_uint128_init_inline (key, 0, sc_morton_encode3 ((uint32_t) x,
+                                                     (uint32_t) y,
+                                                     (uint32_t) z));
+  sc_uint128_init_inline (&high, 0,
+                          sc_morton_encode3 ((uint32_t) (x >> 21),
+                                             (uint32_t) (y >> 21),
+                                             (uint32_t) (z >> 21)));
+  sc_uint128_shift_left_inplace (&high, 63);
+  sc_uint128_bitwise_or_inplace_inline (key, &high);
+}
+
+void
+sc_morton_decode3_128 (const sc_uint128_t * key, uint64_t * x,
+                       uint64_t * y, uint64_t * z)
+{
+  uint32_t            xl, yl, zl, xh, yh, zh;
+  sc_uint128_t        high;
+
+  SC_ASSERT (key != NULL && x != NULL && y != NULL && z != NULL);
+  sc_morton_decode3 (key->low_bits, &xl, &yl, &zl);
+  sc_uint128_shift_right_inline (key, 63, &high);
+  sc_morton_decode3 (high.low_bits, &xh, &yh, &zh);
+  *x = (uint64_t) xh << 21 | xl;
+  *y = (uint64_t) yh << 21 | yl;
+  *z = (uint64_t) zh << 21 | zl;
+}
+
+void
+sc_morton_encode_array (sc_array_t * coords, int dim, sc_array_t * keys)
+{
+  const size_t        n = coords->elem_count;
+  const uint32_t     *c = (const uint32_t *) coords->array;
+  uint64_t           *k;
+  size_t              zz;
+
+  SC_ASSERT (dim == 2 || dim == 3);
+  SC_ASSERT (coords->elem_size == dim * sizeof (uint32_t));
+  SC_ASSERT (keys->elem_size == sizeof (uint64_t));
+
+  sc_array_resize (keys, n);
+  k = (uint64_t *) keys->array;
+  if (dim == 2) {
+    for (zz = 0; zz < n; ++zz) {
+      k[zz] = sc_morton_encode2 (c[2 * zz], c[2 * zz + 1]);
+    }
+  }
+  else {
+    for (zz = 0; zz < n; ++zz) {
+      k[zz] = sc_morton_encode3 (c[3 * zz], c[3 * zz + 1], c[3 * zz + 2]);
+    }
+  }
+}
+
+void
+sc_morton_decode_array (sc_array_t * keys, int dim, sc_array_t * coords)
+{
+  const size_t        n = keys->elem_count;
+  const uint64_t     *k = (const uint64_t *) keys->array;
+  uint32_t           *c;
+  size_t              zz;
+
+  SC_ASSERT (dim == 2 || dim == 3);
+  SC_ASSERT (keys->elem_size == sizeof (uint64_t));
+  SC_ASSERT (coords->elem_size == dim * sizeof (uint32_t));
+
+  sc_array_resize (coords, n);
+  c = (uint32_t *) coords->array;
+  if (dim == 2) {
+    for (zz = 0; zz < n; ++zz) {
+      sc_morton_decode2 (k[zz], &c[2 * zz], &c[2 * zz + 1]);
+    }
+  }
+  else {
+    for (zz = 0; zz < n; ++zz) {
+      sc_morton_decode3 (k[zz], &c[3 * zz], &c[3 * zz + 1], &c[3 * zz + 2]);
+    }
+  }
+}
+
+void
+sc_morton_encode_array_128 (sc_array_t * coords, int dim, sc_array_t * keys)
+{
+  const size_t        n = coords->elem_count;
+  const uint64_t     *c = (const uint64_t *) coords->array;
+  sc_uint128_t       *k;
+  size_t              zz;
+
+  SC_ASSERT (dim == 2 || dim == 3);
+  SC_ASSERT (coords->elem_size == dim * sizeof (uint64_t));
+  SC_ASSERT (keys->elem_size == sizeof (sc_uint128_t));
+
+  sc_array_resize (keys, n);
+  k = (sc_uint128_t *) keys->array;
+  for (zz = 0; zz < n; ++zz) {
+    if (dim == 2) {
+      sc_morton_encode2_128 (c[2 * zz], c[2 * zz + 1], &k[zz]);
+    }
+    else {
+      sc_morton_encode3_128 (c[3 * zz], c[3 * zz + 1], c[3 * zz + 2],
+                             &k[zz]);
+    }
+  }
+}
+
+void
+sc_morton_decode_array_128 (sc_array_t * keys, int dim, sc_array_t * coords)
+{
+  const size_t        n = keys->elem_count;
+  const sc_uint128_t *k = (const sc_uint128_t *) keys->array;
+  uint64_t           *c;
+  size_t              zz;
+
+  SC_ASSERT (dim == 2 || dim == 3);
+  SC_ASSERT (keys->elem_size == sizeof (sc_uint128_t));
+  SC_ASSERT (coords->elem_size == dim * sizeof (uint64_t));
+
+  sc_array_resize (coords, n);
+  c = (uint64_t *) coords->array;
+  for (zz = 0; zz < n; ++zz) {
+    if (dim == 2) {
+      sc_morton_decode2_128 (&k[zz], &c[2 * zz], &c[2 * zz + 1]);
+    }
+    else {
+      sc_morton_decode3_128 (&k[zz], &c[3 * zz], &c[3 * zz + 1],
+                             &c[3 * zz + 2]);
+    }
+  }
+}
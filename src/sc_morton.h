@@ -0,0 +1,158 @@
+/*
+  This file is part of the SC Library.
+  The SC Library provides support for parallel scientific applications.
+
+  Copyright (C) 2010 The University of Texas System
+  Additional copyright (C) 2011 individual authors
+
+  The SC Library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  The SC Library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with the SC Library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+  02110-1301, USA.
+*/
+
+#ifndef SC_MORTON_H
+#define SC_MORTON_H
+
+/** \file sc_morton.h
+ *
+ * Interleave coordinates into Morton keys and back.
+ *
+ * Bit b of coordinate c becomes bit b * dim + c of the key, such that the
+ * keys order the points along a Z-order space-filling curve.  The 64 bit
+ * keys hold 32 bits per coordinate in two dimensions and 21 bits in three
+ * dimensions.  The 128 bit keys hold twice as many, 64 and 42 bits.
+ * Higher coordinate bits are ignored.
+ *
+ * If the compiler targets BMI2, we interleave with the pdep and pext
+ * instructions.  Otherwise we encode bytewise by lookup tables and decode
+ * by shifts and masks.  The bit layout is the same for all kernels and
+ * agrees with \ref sc_uint128_interleave.
+ */
+
+#include <sc_containers.h>
+#include <sc_uint128.h>
+
+SC_EXTERN_C_BEGIN;
+
+/** Return a description of the interleaving kernel compiled in.
+ * \return          A static string like "morton bmi2" or "morton table".
+ */
+const char         *sc_morton_kernel (void);
+
+/** Interleave two coordinates into a 64 bit key.
+ * \param [in] x    The coordinate in the even bits.
+ * \param [in] y    The coordinate in the odd bits.
+ * \return          The Morton key.
+ */
+uint64_t            sc_morton_encode2 (uint32_t x, uint32_t y);
+
+/** Split a 64 bit key into two coordinates.
+ * \param [in] key  The Morton key.
+ * \param [out] x   The even bits of the key.
+ * \param [out] y   The odd bits of the key.
+ */
+void                sc_morton_decode2 (uint64_t key, uint32_t * x,
+                                       uint32_t * y);
+
+/** Interleave three coordinates of 21 bits into a 64 bit key.
+ * \param [in] x    The coordinate in bits 0, 3, 6 and so on.
+ * \param [in] y    The coordinate in bits 1, 4, 7 and so on.
+ * \param [in] z    The coordinate in bits 2, 5, 8 and so on.
+ * \return          The Morton key in the lower 63 bits.
+ */
+uint64_t            sc_morton_encode3 (uint32_t x, uint32_t y, uint32_t z);
+
+/** Split a 64 bit key into three coordinates of 21 bits.
+ * \param [in] key  The Morton key.  Its highest bit is ignored.
+ * \param [out] x   The bits 0, 3, 6 and so on of the key.
+ * \param [out] y   The bits 1, 4, 7 and so on of the key.
+ * \param [out] z   The bits 2, 5, 8 and so on of the key.
+ */
+void                sc_morton_decode3 (uint64_t key, uint32_t * x,
+                                       uint32_t * y, uint32_t * z);
+
+/** Interleave two 64 bit coordinates into a 128 bit key.
+ * \param [in] x    The coordinate in the even bits.
+ * \param [in] y    The coordinate in the odd bits.
+ * \param [out] key The Morton key.
+ */
+void                sc_morton_encode2_128 (uint64_t x, uint64_t y,
+                                           sc_uint128_t * key);
+
+/** Split a 128 bit key into two 64 bit coordinates.
+ * \param [in] key  The Morton key.
+ * \param [out] x   The even bits of the key.
+ * \param [out] y   The odd bits of the key.
+ */
+void                sc_morton_decode2_128 (const sc_uint128_t * key,
+                                           uint64_t * x, uint64_t * y);
+
+/** Interleave three coordinates of 42 bits into a 128 bit key.
+ * \param [in] x    The coordinate in bits 0, 3, 6 and so on.
+ * \param [in] y    The coordinate in bits 1, 4, 7 and so on.
+ * \param [in] z    The coordinate in bits 2, 5, 8 and so on.
+ * \param [out] key The Morton key in the lower 126 bits.
+ */
+void                sc_morton_encode3_128 (uint64_t x, uint64_t y,
+                                           uint64_t z, sc_uint128_t * key);
+
+/** Split a 128 bit key into three coordinates of 42 bits.
+ * \param [in] key  The Morton key.  Its highest two bits are ignored.
+ * \param [out] x   The bits 0, 3, 6 and so on of the key.
+ * \param [out] y   The bits 1, 4, 7 and so on of the key.
+ * \param [out] z   The bits 2, 5, 8 and so on of the key.
+ */
+void                sc_morton_decode3_128 (const sc_uint128_t * key,
+                                           uint64_t * x, uint64_t * y,
+                                           uint64_t * z);
+
+/** Interleave an array of points into 64 bit keys.
+ * \param [in] coords   Array whose elements are \a dim uint32_t each.
+ * \param [in] dim      The dimension, 2 or 3.
+ * \param [in,out] keys Array of element size sizeof (uint64_t).
+ *                      It is resized to the number of points.
+ */
+void                sc_morton_encode_array (sc_array_t * coords, int dim,
+                                            sc_array_t * keys);
+
+/** Split an array of 64 bit keys into points.
+ * \param [in] keys     Array of element size sizeof (uint64_t).
+ * \param [in] dim      The dimension, 2 or 3.
+ * \param [in,out] coords   Array whose elements are \a dim uint32_t each.
+ *                      It is resized to the number of keys.
+ */
+void                sc_morton_decode_array (sc_array_t * keys, int dim,
+                                            sc_array_t * coords);
+
+/** Interleave an array of points into 128 bit keys.
+ * \param [in] coords   Array whose elements are \a dim uint64_t each.
+ * \param [in] dim      The dimension, 2 or 3.
+ * \param [in,out] keys Array of element size sizeof (sc_uint128_t).
+ *                      It is resized to the number of points.
+ */
+void                sc_morton_encode_array_128 (sc_array_t * coords, int dim,
+                                                sc_array_t * keys);
+
+/** Split an array of 128 bit keys into points.
+ * \param [in] keys     Array of element size sizeof (sc_uint128_t).
+ * \param [in] dim      The dimension, 2 or 3.
+ * \param [in,out] coords   Array whose elements are \a dim uint64_t each.
+ *                      It is resized to the number of keys.
+ */
+void                sc_morton_decode_array_128 (sc_array_t * keys, int dim,
+                                                sc_array_t * coords);
+
+SC_EXTERN_C_END;
+
+#endif /* !SC_MORTON_H */
@@ -23,6 +23,97 @@
 
 /* including sc_mpi.h does not work here since sc_mpi.h is included by sc.h */
 #include <sc.h>
+#include <sc_statistics.h>
+#ifdef SC_ENABLE_PTHREAD
+#include <pthread.h>
+#endif
+
+/** The communication wrappers recorded by sc_mpi_profile_enable. */
+typedef enum
+{
+  SC_MPI_PROFILE_BARRIER,
+  SC_MPI_PROFILE_BCAST,
+  SC_MPI_PROFILE_GATHER,
+  SC_MPI_PROFILE_GATHERV,
+  SC_MPI_PROFILE_ALLGATHER,
+  SC_MPI_PROFILE_ALLGATHERV,
+  SC_MPI_PROFILE_ALLTOALL,
+  SC_MPI_PROFILE_REDUCE,
+  SC_MPI_PROFILE_ALLREDUCE,
+  SC_MPI_PROFILE_SCAN,
+  SC_MPI_PROFILE_EXSCAN,
+  SC_MPI_PROFILE_RECV,
+  SC_MPI_PROFILE_IRECV,
+  SC_MPI_PROFILE_SEND,
+  SC_MPI_PROFILE_ISEND,
+  SC_MPI_PROFILE_WAIT,
+  SC_MPI_PROFILE_WAITANY,
+  SC_MPI_PROFILE_WAITSOME,
+  SC_MPI_PROFILE_WAITALL,
+  SC_MPI_PROFILE_NUM_FUNCS
+}
+sc_mpi_profile_func_t;
+
+static const char  *sc_mpi_profile_func_names[SC_MPI_PROFILE_NUM_FUNCS] = {
+  "Barrier", "Bcast", "Gather", "Gatherv", "Allgather", "Allgatherv",
+  "Alltoall", "Reduce", "Allreduce", "Scan", "Exscan", "Recv", "Irecv",
+  "Send", "Isend", "Wait", "Waitany", "Waitsome", "Waitall"
+};
+
+static const char  *sc_mpi_profile_caller_names[SC_MPI_NUM_CALLERS] = {
+  "user", "sc_notify", "sc_psort", "sc_allgather", "sc_reduce", "sc_shmem"
+};
+
+/** The statistics of one wrapper called from one module. */
+typedef struct sc_mpi_profile_entry
+{
+  double              calls;
+  double              bytes;
+  double              time;
+}
+sc_mpi_profile_entry_t;
+
+static int          sc_mpi_profile_top = 0;
+static int          sc_mpi_profile_depth = 0;
+static sc_mpi_caller_t sc_mpi_profile_caller = SC_MPI_CALLER_USER;
+static sc_mpi_profile_entry_t
+  sc_mpi_profile_entries[SC_MPI_PROFILE_NUM_FUNCS][SC_MPI_NUM_CALLERS];
+
+#ifdef SC_ENABLE_MPI
+
+static void
+sc_mpi_profile_record (sc_mpi_profile_func_t func, int count,
+                       sc_MPI_Datatype datatype, double start)
+{
+  int                 mpiret;
+  int                 typesize = 0;
+  sc_mpi_profile_entry_t *entry;
+
+  if (count > 0 && datatype != MPI_DATATYPE_NULL) {
+    mpiret = MPI_Type_size (datatype, &typesize);
+    SC_CHECK_MPI (mpiret);
+  }
+  entry = &sc_mpi_profile_entries[func][sc_mpi_profile_caller];
+  entry->calls += 1.;
+  entry->bytes += (double) count * typesize;
+  entry->time += MPI_Wtime () - start;
+}
+
+/* the call is evaluated once; its arguments only when recording */
+#define SC_MPI_PROFILE_CALL(func,count,datatype,call)           \
+do {                                                            \
+  int                 mpiret;                                   \
+  double              start;                                    \
+  if (!sc_mpi_profile_top) {                                    \
+    return call;                                                \
+  }                                                             \
+  start = MPI_Wtime ();                                         \
+  mpiret = call;                                                \
+  sc_mpi_profile_record ((func), (count), (datatype), start);   \
+  return mpiret;                                                \
+} while (0)
+
+#endif /* SC_ENABLE_MPI */
 
 #ifndef SC_ENABLE_MPI
 
@@ -309,6 +400,41 @@ sc_MPI_Gatherv (void *p, int np, sc_MPI_Datatype tp,
   return sc_MPI_SUCCESS;
 }
 
+int
+sc_MPI_Scatter (void *p, int np, sc_MPI_Datatype tp,
+                void *q, int nq, sc_MPI_Datatype tq, int rank,
+                sc_MPI_Comm comm)
+{
+  return sc_MPI_Gather (p, np, tp, q, nq, tq, rank, comm);
+}
+
+int
+sc_MPI_Scatterv (void *p, int *sendc, int *displ, sc_MPI_Datatype tp,
+                 void *q, int nq, sc_MPI_Datatype tq, int rank,
+                 sc_MPI_Comm comm)
+{
+  size_t              lq;
+#ifdef SC_ENABLE_DEBUG
+  size_t              lp;
+  int                 np;
+
+  np = sendc[0];
+#endif
+  SC_ASSERT (rank == 0 && np >= 0 && nq >= 0);
+
+/* *INDENT-OFF* horrible indent bug */
+  lq = (size_t) nq * sc_mpi_sizeof (tq);
+#ifdef SC_ENABLE_DEBUG
+  lp = (size_t) np * sc_mpi_sizeof (tp);
+#endif
+/* *INDENT-ON* */
+
+  SC_ASSERT (lp == lq);
+  memcpy (q, (char *) p + displ[0] * sc_mpi_sizeof (tp), lq);
+
+  return sc_MPI_SUCCESS;
+}
+
 int
 sc_MPI_Allgather (void *p, int np, sc_MPI_Datatype tp,
                   void *q, int nq, sc_MPI_Datatype tq, sc_MPI_Comm comm)
@@ -410,6 +536,23 @@ sc_MPI_Isend (void *buf, int count, sc_MPI_Datatype datatype, int dest,
   return sc_MPI_SUCCESS;
 }
 
+int
+sc_MPI_Send_init (void *buf, int count, sc_MPI_Datatype datatype, int dest,
+                  int tag, sc_MPI_Comm comm, sc_MPI_Request * request)
+{
+  SC_ABORT ("non-MPI MPI_Send_init is not implemented");
+  return sc_MPI_SUCCESS;
+}
+
+int
+sc_MPI_Recv_init (void *buf, int count, sc_MPI_Datatype datatype,
+                  int source, int tag, sc_MPI_Comm comm,
+                  sc_MPI_Request * request)
+{
+  SC_ABORT ("non-MPI MPI_Recv_init is not implemented");
+  return sc_MPI_SUCCESS;
+}
+
 int
 sc_MPI_Probe (int source, int tag, sc_MPI_Comm comm, sc_MPI_Status * status)
 {
@@ -441,6 +584,23 @@ sc_MPI_Wait (sc_MPI_Request * request, sc_MPI_Status * status)
   return sc_MPI_SUCCESS;
 }
 
+int
+sc_MPI_Test (sc_MPI_Request * request, int *flag, sc_MPI_Status * status)
+{
+  SC_CHECK_ABORT (*request == sc_MPI_REQUEST_NULL,
+                  "non-MPI MPI_Test handles NULL request only");
+  *flag = 1;
+  return sc_MPI_SUCCESS;
+}
+
+int
+sc_MPI_Request_free (sc_MPI_Request * request)
+{
+  SC_CHECK_ABORT (*request == sc_MPI_REQUEST_NULL,
+                  "non-MPI MPI_Request_free handles NULL request only");
+  return sc_MPI_SUCCESS;
+}
+
 double
 sc_MPI_Wtime (void)
 {
@@ -454,6 +614,156 @@ sc_MPI_Wtime (void)
 }
 
 #else /* SC_ENABLE_MPI */
+
+int
+sc_MPI_Barrier (sc_MPI_Comm comm)
+{
+  SC_MPI_PROFILE_CALL (SC_MPI_PROFILE_BARRIER, 0, MPI_DATATYPE_NULL,
+                       MPI_Barrier (comm));
+}
+
+int
+sc_MPI_Bcast (void *p, int n, sc_MPI_Datatype t, int rank, sc_MPI_Comm comm)
+{
+  SC_MPI_PROFILE_CALL (SC_MPI_PROFILE_BCAST, n, t,
+                       MPI_Bcast (p, n, t, rank, comm));
+}
+
+int
+sc_MPI_Gather (void *p, int np, sc_MPI_Datatype tp,
+               void *q, int nq, sc_MPI_Datatype tq, int rank,
+               sc_MPI_Comm comm)
+{
+  SC_MPI_PROFILE_CALL (SC_MPI_PROFILE_GATHER, np, tp,
+                       MPI_Gather (p, np, tp, q, nq, tq, rank, comm));
+}
+
+int
+sc_MPI_Gatherv (void *p, int np, sc_MPI_Datatype tp,
+                void *q, int *recvc, int *displ,
+                sc_MPI_Datatype tq, int rank, sc_MPI_Comm comm)
+{
+  SC_MPI_PROFILE_CALL (SC_MPI_PROFILE_GATHERV, np, tp,
+                       MPI_Gatherv (p, np, tp, q, recvc, displ, tq, rank,
+                                    comm));
+}
+
+int
+sc_MPI_Allgather (void *p, int np, sc_MPI_Datatype tp,
+                  void *q, int nq, sc_MPI_Datatype tq, sc_MPI_Comm comm)
+{
+  SC_MPI_PROFILE_CALL (SC_MPI_PROFILE_ALLGATHER, np, tp,
+                       MPI_Allgather (p, np, tp, q, nq, tq, comm));
+}
+
+int
+sc_MPI_Allgatherv (void *p, int np, sc_MPI_Datatype tp,
+                   void *q, int *recvc, int *displ,
+                   sc_MPI_Datatype tq, sc_MPI_Comm comm)
+{
+  SC_MPI_PROFILE_CALL (SC_MPI_PROFILE_ALLGATHERV, np, tp,
+                       MPI_Allgatherv (p, np, tp, q, recvc, displ, tq,
+                                       comm));
+}
+
+static int
+sc_mpi_profile_size (sc_MPI_Comm comm)
+{
+  int                 mpiret;
+  int                 mpisize;
+
+  mpiret = MPI_Comm_size (comm, &mpisize);
+  SC_CHECK_MPI (mpiret);
+
+  return mpisize;
+}
+
+int
+sc_MPI_Alltoall (void *p, int np, sc_MPI_Datatype tp,
+                 void *q, int nq, sc_MPI_Datatype tq, sc_MPI_Comm comm)
+{
+  /* we send np items to every process */
+  SC_MPI_PROFILE_CALL (SC_MPI_PROFILE_ALLTOALL,
+                       np * sc_mpi_profile_size (comm), tp,
+                       MPI_Alltoall (p, np, tp, q, nq, tq, comm));
+}
+
+int
+sc_MPI_Reduce (void *p, void *q, int n, sc_MPI_Datatype t,
+               sc_MPI_Op op, int rank, sc_MPI_Comm comm)
+{
+  SC_MPI_PROFILE_CALL (SC_MPI_PROFILE_REDUCE, n, t,
+                       MPI_Reduce (p, q, n, t, op, rank, comm));
+}
+
+int
+sc_MPI_Allreduce (void *p, void *q, int n, sc_MPI_Datatype t,
+                  sc_MPI_Op op, sc_MPI_Comm comm)
+{
+  SC_MPI_PROFILE_CALL (SC_MPI_PROFILE_ALLREDUCE, n, t,
+                       MPI_Allreduce (p, q, n, t, op, comm));
+}
+
+int
+sc_MPI_Scan (void *sendbuf, void *recvbuf, int count,
+             sc_MPI_Datatype datatype, sc_MPI_Op op, sc_MPI_Comm comm)
+{
+  SC_MPI_PROFILE_CALL (SC_MPI_PROFILE_SCAN, count, datatype,
+                       MPI_Scan (sendbuf, recvbuf, count, datatype, op,
+                                 comm));
+}
+
+int
+sc_MPI_Exscan (void *sendbuf, void *recvbuf, int count,
+               sc_MPI_Datatype datatype, sc_MPI_Op op, sc_MPI_Comm comm)
+{
+  SC_MPI_PROFILE_CALL (SC_MPI_PROFILE_EXSCAN, count, datatype,
+                       MPI_Exscan (sendbuf, recvbuf, count, datatype, op,
+                                   comm));
+}
+
+int
+sc_MPI_Recv (void *buf, int count, sc_MPI_Datatype datatype, int source,
+             int tag, sc_MPI_Comm comm, sc_MPI_Status * status)
+{
+  SC_MPI_PROFILE_CALL (SC_MPI_PROFILE_RECV, count, datatype,
+                       MPI_Recv (buf, count, datatype, source, tag, comm,
+                                 status));
+}
+
+int
+sc_MPI_Irecv (void *buf, int count, sc_MPI_Datatype datatype, int source,
+              int tag, sc_MPI_Comm comm, sc_MPI_Request * request)
+{
+  SC_MPI_PROFILE_CALL (SC_MPI_PROFILE_IRECV, count, datatype,
+                       MPI_Irecv (buf, count, datatype, source, tag, comm,
+                                  request));
+}
+
+int
+sc_MPI_Send (void *buf, int count, sc_MPI_Datatype datatype,
+             int dest, int tag, sc_MPI_Comm comm)
+{
+  SC_MPI_PROFILE_CALL (SC_MPI_PROFILE_SEND, count, datatype,
+                       MPI_Send (buf, count, datatype, dest, tag, comm));
+}
+
+int
+sc_MPI_Isend (void *buf, int count, sc_MPI_Datatype datatype, int dest,
+              int tag, sc_MPI_Comm comm, sc_MPI_Request * request)
+{
+  SC_MPI_PROFILE_CALL (SC_MPI_PROFILE_ISEND, count, datatype,
+                       MPI_Isend (buf, count, datatype, dest, tag, comm,
+                                  request));
+}
+
+int
+sc_MPI_Wait (sc_MPI_Request * request, sc_MPI_Status * status)
+{
+  SC_MPI_PROFILE_CALL (SC_MPI_PROFILE_WAIT, 0, MPI_DATATYPE_NULL,
+                       MPI_Wait (request, status));
+}
+
 #ifndef SC_ENABLE_MPITHREAD
 
 /* default to non-threaded operation */
@@ -470,6 +780,28 @@ sc_MPI_Init_thread (int *argc, char ***argv, int required, int *provided)
 #endif /* !SC_ENABLE_MPITHREAD */
 #endif /* SC_ENABLE_MPI */
 
+int
+sc_MPI_Waitany (int count, sc_MPI_Request * array_of_requests,
+                int *index, sc_MPI_Status * status)
+{
+#ifdef SC_ENABLE_MPI
+  /* we do this to avoid warnings when the prototype uses [] */
+  SC_MPI_PROFILE_CALL (SC_MPI_PROFILE_WAITANY, 0, MPI_DATATYPE_NULL,
+                       MPI_Waitany (count, array_of_requests, index,
+                                    status));
+#else
+  int                 i;
+
+  for (i = 0; i < count; ++i) {
+    SC_CHECK_ABORT (array_of_requests[i] == sc_MPI_REQUEST_NULL,
+                    "non-MPI MPI_Waitany handles NULL requests only");
+  }
+  *index = sc_MPI_UNDEFINED;
+
+  return sc_MPI_SUCCESS;
+#endif
+}
+
 int
 sc_MPI_Waitsome (int incount, sc_MPI_Request * array_of_requests,
                  int *outcount, int *array_of_indices,
@@ -477,8 +809,9 @@ sc_MPI_Waitsome (int incount, sc_MPI_Request * array_of_requests,
 {
 #ifdef SC_ENABLE_MPI
   /* we do this to avoid warnings when the prototype uses [] */
-  return MPI_Waitsome (incount, array_of_requests, outcount,
-                       array_of_indices, array_of_statuses);
+  SC_MPI_PROFILE_CALL (SC_MPI_PROFILE_WAITSOME, 0, MPI_DATATYPE_NULL,
+                       MPI_Waitsome (incount, array_of_requests, outcount,
+                                     array_of_indices, array_of_statuses));
 #else
   int                 i;
 
@@ -498,7 +831,9 @@ sc_MPI_Waitall (int count, sc_MPI_Request * array_of_requests,
 {
 #ifdef SC_ENABLE_MPI
   /* we do this to avoid warnings when the prototype uses [] */
-  return MPI_Waitall (count, array_of_requests, array_of_statuses);
+  SC_MPI_PROFILE_CALL (SC_MPI_PROFILE_WAITALL, 0, MPI_DATATYPE_NULL,
+                       MPI_Waitall (count, array_of_requests,
+                                    array_of_statuses));
 #else
   int                 i;
 
@@ -524,75 +859,220 @@ sc_MPI_Testall (int count, sc_MPI_Request * array_of_requests, int *flag,
     SC_CHECK_ABORT (array_of_requests[i] == sc_MPI_REQUEST_NULL,
                     "non-MPI MPI_Testall handles NULL requests only");
   }
+  *flag = 1;
+
   return sc_MPI_SUCCESS;
 #endif
 }
 
 int
-sc_MPI_Error_class (int errorcode, int *errorclass)
+sc_MPI_Startall (int count, sc_MPI_Request * array_of_requests)
 {
-#ifdef SC_ENABLE_MPIIO
-  /* process error codes unchanged by MPI implementation */
-  return MPI_Error_class (errorcode, errorclass);
+#ifdef SC_ENABLE_MPI
+  /* we do this to avoid warnings when the prototype uses [] */
+  return MPI_Startall (count, array_of_requests);
 #else
-  if (errorclass == NULL) {
-    return sc_MPI_ERR_ARG;
-  }
+  int                 i;
 
-  /* these error classes are understood directly by libsc */
-  switch (errorcode) {
-  case sc_MPI_SUCCESS:
-  case sc_MPI_ERR_ARG:
-  case sc_MPI_ERR_UNKNOWN:
-  case sc_MPI_ERR_OTHER:
-  case sc_MPI_ERR_NO_MEM:
-  case sc_MPI_ERR_FILE:
-  case sc_MPI_ERR_NOT_SAME:
-  case sc_MPI_ERR_AMODE:
-  case sc_MPI_ERR_UNSUPPORTED_DATAREP:
-  case sc_MPI_ERR_UNSUPPORTED_OPERATION:
-  case sc_MPI_ERR_NO_SUCH_FILE:
-  case sc_MPI_ERR_FILE_EXISTS:
-  case sc_MPI_ERR_BAD_FILE:
-  case sc_MPI_ERR_ACCESS:
-  case sc_MPI_ERR_NO_SPACE:
-  case sc_MPI_ERR_QUOTA:
-  case sc_MPI_ERR_READ_ONLY:
-  case sc_MPI_ERR_FILE_IN_USE:
-  case sc_MPI_ERR_DUP_DATAREP:
-  case sc_MPI_ERR_CONVERSION:
-  case sc_MPI_ERR_IO:
-    *errorclass = errorcode;
-    return sc_MPI_SUCCESS;
+  for (i = 0; i < count; ++i) {
+    SC_CHECK_ABORT (array_of_requests[i] == sc_MPI_REQUEST_NULL,
+                    "non-MPI MPI_Startall handles NULL requests only");
   }
-#ifdef SC_ENABLE_MPI
-  /* there may by version 1.1 error codes we do not catch */
-  return MPI_Error_class (errorcode, errorclass);
-#else
-  /* there is no way to produce any other value without MPI */
-  return *errorclass = sc_MPI_ERR_UNKNOWN;
-#endif
+  return sc_MPI_SUCCESS;
 #endif
 }
 
+#if !defined SC_ENABLE_MPI || MPI_VERSION < 3
+
+/* the blocking operation completes the request right away */
+
 int
-sc_MPI_Error_string (int errorcode, char *string, int *resultlen)
+sc_MPI_Ibarrier (sc_MPI_Comm comm, sc_MPI_Request * request)
 {
-#ifdef SC_ENABLE_MPIIO
-  /* process error codes unchanged by MPI implementation */
-  return MPI_Error_string (errorcode, string, resultlen);
-#else
-  int                 retval;
-  const char         *tstr = NULL;
+  *request = sc_MPI_REQUEST_NULL;
+  return sc_MPI_Barrier (comm);
+}
 
-  if (string == NULL || resultlen == NULL) {
-    return sc_MPI_ERR_ARG;
-  }
+int
+sc_MPI_Ibcast (void *p, int n, sc_MPI_Datatype t, int rank,
+               sc_MPI_Comm comm, sc_MPI_Request * request)
+{
+  *request = sc_MPI_REQUEST_NULL;
+  return sc_MPI_Bcast (p, n, t, rank, comm);
+}
 
-  /* these error classes are understood directly by libsc */
-  switch (errorcode) {
-  case sc_MPI_SUCCESS:
-    tstr = "Success";
+int
+sc_MPI_Igather (void *p, int np, sc_MPI_Datatype tp,
+                void *q, int nq, sc_MPI_Datatype tq, int rank,
+                sc_MPI_Comm comm, sc_MPI_Request * request)
+{
+  *request = sc_MPI_REQUEST_NULL;
+  return sc_MPI_Gather (p, np, tp, q, nq, tq, rank, comm);
+}
+
+int
+sc_MPI_Igatherv (void *p, int np, sc_MPI_Datatype tp,
+                 void *q, int *recvc, int *displ, sc_MPI_Datatype tq,
+                 int rank, sc_MPI_Comm comm, sc_MPI_Request * request)
+{
+  *request = sc_MPI_REQUEST_NULL;
+  return sc_MPI_Gatherv (p, np, tp, q, recvc, displ, tq, rank, comm);
+}
+
+int
+sc_MPI_Iscatter (void *p, int np, sc_MPI_Datatype tp,
+                 void *q, int nq, sc_MPI_Datatype tq, int rank,
+                 sc_MPI_Comm comm, sc_MPI_Request * request)
+{
+  *request = sc_MPI_REQUEST_NULL;
+  return sc_MPI_Scatter (p, np, tp, q, nq, tq, rank, comm);
+}
+
+int
+sc_MPI_Iscatterv (void *p, int *sendc, int *displ, sc_MPI_Datatype tp,
+                  void *q, int nq, sc_MPI_Datatype tq, int rank,
+                  sc_MPI_Comm comm, sc_MPI_Request * request)
+{
+  *request = sc_MPI_REQUEST_NULL;
+  return sc_MPI_Scatterv (p, sendc, displ, tp, q, nq, tq, rank, comm);
+}
+
+int
+sc_MPI_Iallgather (void *p, int np, sc_MPI_Datatype tp,
+                   void *q, int nq, sc_MPI_Datatype tq,
+                   sc_MPI_Comm comm, sc_MPI_Request * request)
+{
+  *request = sc_MPI_REQUEST_NULL;
+  return sc_MPI_Allgather (p, np, tp, q, nq, tq, comm);
+}
+
+int
+sc_MPI_Iallgatherv (void *p, int np, sc_MPI_Datatype tp,
+                    void *q, int *recvc, int *displ, sc_MPI_Datatype tq,
+                    sc_MPI_Comm comm, sc_MPI_Request * request)
+{
+  *request = sc_MPI_REQUEST_NULL;
+  return sc_MPI_Allgatherv (p, np, tp, q, recvc, displ, tq, comm);
+}
+
+int
+sc_MPI_Ialltoall (void *p, int np, sc_MPI_Datatype tp,
+                  void *q, int nq, sc_MPI_Datatype tq,
+                  sc_MPI_Comm comm, sc_MPI_Request * request)
+{
+  *request = sc_MPI_REQUEST_NULL;
+  return sc_MPI_Alltoall (p, np, tp, q, nq, tq, comm);
+}
+
+int
+sc_MPI_Ireduce (void *p, void *q, int n, sc_MPI_Datatype t,
+                sc_MPI_Op op, int rank, sc_MPI_Comm comm,
+                sc_MPI_Request * request)
+{
+  *request = sc_MPI_REQUEST_NULL;
+  return sc_MPI_Reduce (p, q, n, t, op, rank, comm);
+}
+
+int
+sc_MPI_Iallreduce (void *p, void *q, int n, sc_MPI_Datatype t,
+                   sc_MPI_Op op, sc_MPI_Comm comm, sc_MPI_Request * request)
+{
+  *request = sc_MPI_REQUEST_NULL;
+  return sc_MPI_Allreduce (p, q, n, t, op, comm);
+}
+
+int
+sc_MPI_Ireduce_scatter_block (void *p, void *q, int n, sc_MPI_Datatype t,
+                              sc_MPI_Op op, sc_MPI_Comm comm,
+                              sc_MPI_Request * request)
+{
+  *request = sc_MPI_REQUEST_NULL;
+  return sc_MPI_Reduce_scatter_block (p, q, n, t, op, comm);
+}
+
+int
+sc_MPI_Iscan (void *p, void *q, int n, sc_MPI_Datatype t,
+              sc_MPI_Op op, sc_MPI_Comm comm, sc_MPI_Request * request)
+{
+  *request = sc_MPI_REQUEST_NULL;
+  return sc_MPI_Scan (p, q, n, t, op, comm);
+}
+
+int
+sc_MPI_Iexscan (void *p, void *q, int n, sc_MPI_Datatype t,
+                sc_MPI_Op op, sc_MPI_Comm comm, sc_MPI_Request * request)
+{
+  *request = sc_MPI_REQUEST_NULL;
+  return sc_MPI_Exscan (p, q, n, t, op, comm);
+}
+
+#endif /* !SC_ENABLE_MPI || MPI_VERSION < 3 */
+
+int
+sc_MPI_Error_class (int errorcode, int *errorclass)
+{
+#ifdef SC_ENABLE_MPIIO
+  /* process error codes unchanged by MPI implementation */
+  return MPI_Error_class (errorcode, errorclass);
+#else
+  if (errorclass == NULL) {
+    return sc_MPI_ERR_ARG;
+  }
+
+  /* these error classes are understood directly by libsc */
+  switch (errorcode) {
+  case sc_MPI_SUCCESS:
+  case sc_MPI_ERR_ARG:
+  case sc_MPI_ERR_UNKNOWN:
+  case sc_MPI_ERR_OTHER:
+  case sc_MPI_ERR_NO_MEM:
+  case sc_MPI_ERR_FILE:
+  case sc_MPI_ERR_NOT_SAME:
+  case sc_MPI_ERR_AMODE:
+  case sc_MPI_ERR_UNSUPPORTED_DATAREP:
+  case sc_MPI_ERR_UNSUPPORTED_OPERATION:
+  case sc_MPI_ERR_NO_SUCH_FILE:
+  case sc_MPI_ERR_FILE_EXISTS:
+  case sc_MPI_ERR_BAD_FILE:
+  case sc_MPI_ERR_ACCESS:
+  case sc_MPI_ERR_NO_SPACE:
+  case sc_MPI_ERR_QUOTA:
+  case sc_MPI_ERR_READ_ONLY:
+  case sc_MPI_ERR_FILE_IN_USE:
+  case sc_MPI_ERR_DUP_DATAREP:
+  case sc_MPI_ERR_CONVERSION:
+  case sc_MPI_ERR_IO:
+    *errorclass = errorcode;
+    return sc_MPI_SUCCESS;
+  }
+#ifdef SC_ENABLE_MPI
+  /* there may by version 1.1 error codes we do not catch */
+  return MPI_Error_class (errorcode, errorclass);
+#else
+  /* there is no way to produce any other value without MPI */
+  return *errorclass = sc_MPI_ERR_UNKNOWN;
+#endif
+#endif
+}
+
+int
+sc_MPI_Error_string (int errorcode, char *string, int *resultlen)
+{
+#ifdef SC_ENABLE_MPIIO
+  /* process error codes unchanged by MPI implementation */
+  return MPI_Error_string (errorcode, string, resultlen);
+#else
+  int                 retval;
+  const char         *tstr = NULL;
+
+  if (string == NULL || resultlen == NULL) {
+    return sc_MPI_ERR_ARG;
+  }
+
+  /* these error classes are understood directly by libsc */
+  switch (errorcode) {
+  case sc_MPI_SUCCESS:
+    tstr = "Success";
     break;
   case sc_MPI_ERR_ARG:
     tstr = "Error in function argument";
@@ -714,20 +1194,29 @@ sc_mpi_sizeof (sc_MPI_Datatype t)
 /* Make this a parameter to sc_mpi_comm_attach_node_comms and friends! */
 static int          sc_mpi_node_comm_keyval = sc_MPI_KEYVAL_INVALID;
 
+/** The communicators attached by sc_mpi_comm_attach_node_comms. */
+typedef struct sc_mpi_node_comms
+{
+  int                 processes_per_node;
+  int                 num_levels;       /**< Levels split so far. */
+  sc_MPI_Comm         comms[2 * SC_MPI_NUM_LEVELS];
+}
+sc_mpi_node_comms_t;
+
 static int
 sc_mpi_node_comms_destroy (sc_MPI_Comm comm, int comm_keyval,
                            void *attribute_val, void *extra_state)
 {
-  int                 mpiret;
-  sc_MPI_Comm        *node_comms = (sc_MPI_Comm *) attribute_val;
-
-  mpiret = sc_MPI_Comm_free (&node_comms[0]);
-  if (mpiret != sc_MPI_SUCCESS) {
-    return mpiret;
-  }
-  mpiret = sc_MPI_Comm_free (&node_comms[1]);
-  if (mpiret != sc_MPI_SUCCESS) {
-    return mpiret;
+  int                 mpiret, i;
+  sc_mpi_node_comms_t *node_comms = (sc_mpi_node_comms_t *) attribute_val;
+
+  for (i = 0; i < 2 * SC_MPI_NUM_LEVELS; ++i) {
+    if (node_comms->comms[i] != sc_MPI_COMM_NULL) {
+      mpiret = sc_MPI_Comm_free (&node_comms->comms[i]);
+      if (mpiret != sc_MPI_SUCCESS) {
+        return mpiret;
+      }
+    }
   }
   mpiret = sc_MPI_Free_mem (node_comms);
 
@@ -740,52 +1229,92 @@ sc_mpi_node_comms_copy (sc_MPI_Comm oldcomm, int comm_keyval,
                         void *attribute_val_in,
                         void *attribute_val_out, int *flag)
 {
-  sc_MPI_Comm        *node_comms_in = (sc_MPI_Comm *) attribute_val_in;
-  sc_MPI_Comm        *node_comms_out;
-  int                 mpiret;
+  sc_mpi_node_comms_t *node_comms_in =
+    (sc_mpi_node_comms_t *) attribute_val_in;
+  sc_mpi_node_comms_t *node_comms_out;
+  int                 mpiret, i;
 
   /* We can't used SC_ALLOC because these might be destroyed after
    * sc finalizes */
   mpiret =
-    sc_MPI_Alloc_mem (2 * sizeof (sc_MPI_Comm), sc_MPI_INFO_NULL,
-                      &node_comms_out);
-  if (mpiret != sc_MPI_SUCCESS) {
-    return mpiret;
-  }
-
-  mpiret = sc_MPI_Comm_dup (node_comms_in[0], &node_comms_out[0]);
+    sc_MPI_Alloc_mem (sizeof (sc_mpi_node_comms_t),
+                      sc_MPI_INFO_NULL, &node_comms_out);
   if (mpiret != sc_MPI_SUCCESS) {
     return mpiret;
   }
-  mpiret = sc_MPI_Comm_dup (node_comms_in[1], &node_comms_out[1]);
-  if (mpiret != sc_MPI_SUCCESS) {
-    return mpiret;
+  node_comms_out->processes_per_node = node_comms_in->processes_per_node;
+  node_comms_out->num_levels = node_comms_in->num_levels;
+
+  /* levels not yet split remain to be split on the duplicate */
+  for (i = 0; i < 2 * SC_MPI_NUM_LEVELS; ++i) {
+    node_comms_out->comms[i] = sc_MPI_COMM_NULL;
+    if (node_comms_in->comms[i] != sc_MPI_COMM_NULL) {
+      mpiret = sc_MPI_Comm_dup (node_comms_in->comms[i],
+                                &node_comms_out->comms[i]);
+      if (mpiret != sc_MPI_SUCCESS) {
+        return mpiret;
+      }
+    }
   }
 
-  *((sc_MPI_Comm **) attribute_val_out) = node_comms_out;
+  *((sc_mpi_node_comms_t **) attribute_val_out) = node_comms_out;
   *flag = 1;
 
   return sc_MPI_SUCCESS;
 }
 
-#endif /* SC_ENABLE_MPI && SC_ENABLE_MPICOMMSHARED */
-
-void
-sc_mpi_comm_attach_node_comms (sc_MPI_Comm comm, int processes_per_node)
+/* Split a communicator into the processes that share a hardware domain of
+ * the given level.  If the MPI implementation does not tell, the socket
+ * level is the whole communicator and the core level a single process. */
+static void
+sc_mpi_split_level (sc_MPI_Comm parent, sc_mpi_level_t level,
+                    sc_MPI_Comm * intra)
 {
-#if defined(SC_ENABLE_MPI) && defined (SC_ENABLE_MPICOMMSHARED)
-  int                 mpiret, rank, size;
-  sc_MPI_Comm        *node_comms, internode, intranode;
+  int                 mpiret, rank;
 
-  if (sc_mpi_node_comm_keyval == sc_MPI_KEYVAL_INVALID) {
-    /* register the node comm attachment with MPI */
-    mpiret =
-      sc_MPI_Comm_create_keyval (sc_mpi_node_comms_copy,
-                                 sc_mpi_node_comms_destroy,
-                                 &sc_mpi_node_comm_keyval, NULL);
+  mpiret = sc_MPI_Comm_rank (parent, &rank);
+  SC_CHECK_MPI (mpiret);
+
+  *intra = sc_MPI_COMM_NULL;
+#if defined(OPEN_MPI)
+  mpiret = MPI_Comm_split_type (parent, level == SC_MPI_LEVEL_SOCKET ?
+                                OMPI_COMM_TYPE_SOCKET : OMPI_COMM_TYPE_CORE,
+                                rank, MPI_INFO_NULL, intra);
+  SC_CHECK_MPI (mpiret);
+#elif MPI_VERSION >= 4
+  {
+    MPI_Info            info;
+
+    mpiret = MPI_Info_create (&info);
+    SC_CHECK_MPI (mpiret);
+    mpiret = MPI_Info_set (info, "mpi_hw_resource_type",
+                           level == SC_MPI_LEVEL_SOCKET ? "Package" : "Core");
+    SC_CHECK_MPI (mpiret);
+    mpiret = MPI_Comm_split_type (parent, MPI_COMM_TYPE_HW_GUIDED, rank,
+                                  info, intra);
+    SC_CHECK_MPI (mpiret);
+    mpiret = MPI_Info_free (&info);
     SC_CHECK_MPI (mpiret);
   }
-  SC_ASSERT (sc_mpi_node_comm_keyval != sc_MPI_KEYVAL_INVALID);
+#endif
+  if (*intra == sc_MPI_COMM_NULL) {
+    mpiret = sc_MPI_Comm_split (parent, level == SC_MPI_LEVEL_SOCKET ? 0 :
+                                rank, rank, intra);
+    SC_CHECK_MPI (mpiret);
+  }
+}
+
+#endif /* SC_ENABLE_MPI && SC_ENABLE_MPICOMMSHARED */
+
+#if defined(SC_ENABLE_MPI) && defined (SC_ENABLE_MPICOMMSHARED)
+
+/* Split the node level.  Return 0 if the node communicators found by MPI
+ * differ in size, which we do not accept. */
+static int
+sc_mpi_split_node (sc_MPI_Comm comm, int processes_per_node,
+                   sc_MPI_Comm * intranode, sc_MPI_Comm * internode)
+{
+  int                 mpiret, rank, size;
 
   mpiret = sc_MPI_Comm_size (comm, &size);
   SC_CHECK_MPI (mpiret);
@@ -793,39 +1322,37 @@ sc_mpi_comm_attach_node_comms (sc_MPI_Comm comm, int processes_per_node)
   SC_CHECK_MPI (mpiret);
 
   if (processes_per_node < 1) {
-    int                 intrasize, intrarank, maxintrasize, minintrasize;
+    int                 intrasize, intrarank, sizes[2], extremes[2];
 
     mpiret =
       sc_MPI_Comm_split_type (comm, sc_MPI_COMM_TYPE_SHARED, rank,
-                              sc_MPI_INFO_NULL, &intranode);
+                              sc_MPI_INFO_NULL, intranode);
     SC_CHECK_MPI (mpiret);
 
     /* We only accept node comms if they are all the same size */
-    mpiret = sc_MPI_Comm_size (intranode, &intrasize);
+    mpiret = sc_MPI_Comm_size (*intranode, &intrasize);
     SC_CHECK_MPI (mpiret);
-    mpiret = sc_MPI_Comm_rank (intranode, &intrarank);
+    mpiret = sc_MPI_Comm_rank (*intranode, &intrarank);
     SC_CHECK_MPI (mpiret);
 
+    /* one reduction yields both the maximum and the minimum */
+    sizes[0] = intrasize;
+    sizes[1] = -intrasize;
     mpiret =
-      sc_MPI_Allreduce (&intrasize, &maxintrasize, 1, sc_MPI_INT, sc_MPI_MAX,
-                        comm);
-    SC_CHECK_MPI (mpiret);
-    mpiret =
-      sc_MPI_Allreduce (&intrasize, &minintrasize, 1, sc_MPI_INT, sc_MPI_MIN,
-                        comm);
+      sc_MPI_Allreduce (sizes, extremes, 2, sc_MPI_INT, sc_MPI_MAX, comm);
     SC_CHECK_MPI (mpiret);
 
-    if (maxintrasize != minintrasize) {
+    if (extremes[0] != -extremes[1]) {
       SC_GLOBAL_LDEBUG
         ("node communicators are not the same size: not attaching\n");
 
-      mpiret = sc_MPI_Comm_free (&intranode);
+      mpiret = sc_MPI_Comm_free (intranode);
       SC_CHECK_MPI (mpiret);
 
-      return;
+      return 0;
     }
 
-    mpiret = sc_MPI_Comm_split (comm, intrarank, rank, &internode);
+    mpiret = sc_MPI_Comm_split (comm, intrarank, rank, internode);
     SC_CHECK_MPI (mpiret);
   }
   else {
@@ -836,24 +1363,151 @@ sc_mpi_comm_attach_node_comms (sc_MPI_Comm comm, int processes_per_node)
     node = rank / processes_per_node;
     offset = rank % processes_per_node;
 
-    mpiret = sc_MPI_Comm_split (comm, node, offset, &intranode);
+    mpiret = sc_MPI_Comm_split (comm, node, offset, intranode);
     SC_CHECK_MPI (mpiret);
 
-    mpiret = sc_MPI_Comm_split (comm, offset, node, &internode);
+    mpiret = sc_MPI_Comm_split (comm, offset, node, internode);
     SC_CHECK_MPI (mpiret);
   }
+  return 1;
+}
+
+/* Split the levels of the hierarchy up to but excluding \a num_levels
+ * that have not been split yet.  This function is collective. */
+static void
+sc_mpi_node_comms_split (sc_MPI_Comm comm, sc_mpi_node_comms_t * node_comms,
+                         int num_levels)
+{
+  int                 mpiret, level, intrarank, parentrank;
+  int                 first_level;
+  double              elapsed;
+  sc_MPI_Comm        *comms = node_comms->comms;
+
+  SC_ASSERT (num_levels <= SC_MPI_NUM_LEVELS);
+  if (node_comms->num_levels >= num_levels) {
+    return;
+  }
+
+  elapsed = -sc_MPI_Wtime ();
+  first_level = node_comms->num_levels;
+  if (first_level == 0) {
+    if (!sc_mpi_split_node (comm, node_comms->processes_per_node,
+                            &comms[0], &comms[1])) {
+      /* there is nothing to split below */
+      node_comms->num_levels = SC_MPI_NUM_LEVELS;
+      return;
+    }
+    node_comms->num_levels = 1;
+  }
+
+  /* each level below the node splits the domain of the level above */
+  for (level = node_comms->num_levels; level < num_levels; ++level) {
+    if (node_comms->processes_per_node < 1) {
+      sc_mpi_split_level (comms[2 * (level - 1)],
+                          (sc_mpi_level_t) level, &comms[2 * level]);
+    }
+    else {
+      /* the hardware below emulated nodes is unknown */
+      mpiret = sc_MPI_Comm_rank (comms[2 * (level - 1)], &intrarank);
+      SC_CHECK_MPI (mpiret);
+      mpiret = sc_MPI_Comm_split (comms[2 * (level - 1)],
+                                  level == SC_MPI_LEVEL_SOCKET ? 0 :
+                                  intrarank, intrarank, &comms[2 * level]);
+      SC_CHECK_MPI (mpiret);
+    }
+    mpiret = sc_MPI_Comm_rank (comms[2 * level], &intrarank);
+    SC_CHECK_MPI (mpiret);
+    mpiret = sc_MPI_Comm_rank (comms[2 * (level - 1)], &parentrank);
+    SC_CHECK_MPI (mpiret);
+    mpiret = sc_MPI_Comm_split (comms[2 * (level - 1)], intrarank,
+                                parentrank, &comms[2 * level + 1]);
+    SC_CHECK_MPI (mpiret);
+  }
+  node_comms->num_levels = num_levels;
+  elapsed += sc_MPI_Wtime ();
+
+  SC_GLOBAL_STATISTICSF ("Split levels %d to %d of the node communicators"
+                         " in %g seconds\n", first_level, num_levels - 1,
+                         elapsed);
+}
+
+/* Return the node communicators attached to a communicator or NULL.
+ * The levels up to \a num_levels are split if they have not been. */
+static sc_mpi_node_comms_t *
+sc_mpi_node_comms_get (sc_MPI_Comm comm, int num_levels)
+{
+  int                 mpiret, flag;
+  sc_mpi_node_comms_t *node_comms;
+
+  if (sc_mpi_node_comm_keyval == sc_MPI_KEYVAL_INVALID) {
+    return NULL;
+  }
+  mpiret =
+    sc_MPI_Comm_get_attr (comm, sc_mpi_node_comm_keyval, &node_comms, &flag);
+  SC_CHECK_MPI (mpiret);
+  if (!flag || node_comms == NULL) {
+    return NULL;
+  }
+  sc_mpi_node_comms_split (comm, node_comms, num_levels);
+  return node_comms;
+}
+
+/* Attach node communicators of which the first \a num_levels are split. */
+static void
+sc_mpi_node_comms_attach (sc_MPI_Comm comm, int processes_per_node,
+                          int num_levels)
+{
+  int                 mpiret, i;
+  sc_mpi_node_comms_t *node_comms;
+
+  if (sc_mpi_node_comm_keyval == sc_MPI_KEYVAL_INVALID) {
+    /* register the node comm attachment with MPI */
+    mpiret =
+      sc_MPI_Comm_create_keyval (sc_mpi_node_comms_copy,
+                                 sc_mpi_node_comms_destroy,
+                                 &sc_mpi_node_comm_keyval, NULL);
+    SC_CHECK_MPI (mpiret);
+  }
+  SC_ASSERT (sc_mpi_node_comm_keyval != sc_MPI_KEYVAL_INVALID);
 
   /* We can't used SC_ALLOC because these might be destroyed after
    * sc finalizes */
   mpiret =
-    sc_MPI_Alloc_mem (2 * sizeof (sc_MPI_Comm), sc_MPI_INFO_NULL,
-                      &node_comms);
+    sc_MPI_Alloc_mem (sizeof (sc_mpi_node_comms_t),
+                      sc_MPI_INFO_NULL, &node_comms);
   SC_CHECK_MPI (mpiret);
-  node_comms[0] = intranode;
-  node_comms[1] = internode;
+  node_comms->processes_per_node = processes_per_node;
+  node_comms->num_levels = 0;
+  for (i = 0; i < 2 * SC_MPI_NUM_LEVELS; ++i) {
+    node_comms->comms[i] = sc_MPI_COMM_NULL;
+  }
+
+  sc_mpi_node_comms_split (comm, node_comms, num_levels);
+  if (num_levels > 0 && node_comms->comms[0] == sc_MPI_COMM_NULL) {
+    mpiret = sc_MPI_Free_mem (node_comms);
+    SC_CHECK_MPI (mpiret);
+    return;
+  }
 
   mpiret = sc_MPI_Comm_set_attr (comm, sc_mpi_node_comm_keyval, node_comms);
   SC_CHECK_MPI (mpiret);
+}
+
+#endif /* SC_ENABLE_MPI && SC_ENABLE_MPICOMMSHARED */
+
+void
+sc_mpi_comm_attach_node_comms (sc_MPI_Comm comm, int processes_per_node)
+{
+#if defined(SC_ENABLE_MPI) && defined (SC_ENABLE_MPICOMMSHARED)
+  sc_mpi_node_comms_attach (comm, processes_per_node, 1);
+#endif
+}
+
+void
+sc_mpi_comm_attach_node_comms_lazy (sc_MPI_Comm comm, int processes_per_node)
+{
+#if defined(SC_ENABLE_MPI) && defined (SC_ENABLE_MPICOMMSHARED)
+  sc_mpi_node_comms_attach (comm, processes_per_node, 0);
 #endif
 }
 
@@ -875,8 +1529,7 @@ sc_mpi_comm_get_node_comms (sc_MPI_Comm comm,
                             sc_MPI_Comm * intranode, sc_MPI_Comm * internode)
 {
 #if defined(SC_ENABLE_MPI) && defined (SC_ENABLE_MPICOMMSHARED)
-  int                 mpiret, flag;
-  sc_MPI_Comm        *node_comms;
+  sc_mpi_node_comms_t *node_comms;
 #endif
 
   /* default return values */
@@ -884,15 +1537,33 @@ sc_mpi_comm_get_node_comms (sc_MPI_Comm comm,
   *internode = sc_MPI_COMM_NULL;
 
 #if defined(SC_ENABLE_MPI) && defined (SC_ENABLE_MPICOMMSHARED)
-  if (sc_mpi_node_comm_keyval == sc_MPI_KEYVAL_INVALID) {
-    return;
+  node_comms = sc_mpi_node_comms_get (comm, 1);
+  if (node_comms != NULL) {
+    *intranode = node_comms->comms[0];
+    *internode = node_comms->comms[1];
   }
-  mpiret =
-    sc_MPI_Comm_get_attr (comm, sc_mpi_node_comm_keyval, &node_comms, &flag);
-  SC_CHECK_MPI (mpiret);
-  if (flag && node_comms) {
-    *intranode = (sc_MPI_Comm) node_comms[0];
-    *internode = (sc_MPI_Comm) node_comms[1];
+#endif
+}
+
+void
+sc_mpi_comm_get_level_comms (sc_MPI_Comm comm, sc_mpi_level_t level,
+                             sc_MPI_Comm * intra, sc_MPI_Comm * inter)
+{
+#if defined(SC_ENABLE_MPI) && defined (SC_ENABLE_MPICOMMSHARED)
+  sc_mpi_node_comms_t *node_comms;
+#endif
+
+  SC_ASSERT (0 <= level && level < SC_MPI_NUM_LEVELS);
+
+  /* default return values */
+  *intra = sc_MPI_COMM_NULL;
+  *inter = sc_MPI_COMM_NULL;
+
+#if defined(SC_ENABLE_MPI) && defined (SC_ENABLE_MPICOMMSHARED)
+  node_comms = sc_mpi_node_comms_get (comm, (int) level + 1);
+  if (node_comms != NULL) {
+    *intra = node_comms->comms[2 * level];
+    *inter = node_comms->comms[2 * level + 1];
   }
 #endif
 }
@@ -917,3 +1588,305 @@ sc_mpi_comm_get_and_attach (sc_MPI_Comm mpicomm)
 
   return intrasize;
 }
+
+#ifdef SC_ENABLE_MPI
+
+/** The duplicates attached by sc_mpi_comm_attach_thread_comms. */
+typedef struct sc_mpi_thread_comms
+{
+  int                 num_slots;
+  sc_MPI_Comm        *comms;    /**< Stored behind this struct. */
+}
+sc_mpi_thread_comms_t;
+
+static int          sc_mpi_thread_comm_keyval = sc_MPI_KEYVAL_INVALID;
+
+static int
+sc_mpi_thread_comms_destroy (sc_MPI_Comm comm, int comm_keyval,
+                             void *attribute_val, void *extra_state)
+{
+  int                 mpiret, i;
+  sc_mpi_thread_comms_t *tc = (sc_mpi_thread_comms_t *) attribute_val;
+
+  for (i = 0; i < tc->num_slots; ++i) {
+    mpiret = sc_MPI_Comm_free (&tc->comms[i]);
+    if (mpiret != sc_MPI_SUCCESS) {
+      return mpiret;
+    }
+  }
+  return sc_MPI_Free_mem (tc);
+}
+
+static int
+sc_mpi_thread_comms_copy (sc_MPI_Comm oldcomm, int comm_keyval,
+                          void *extra_state,
+                          void *attribute_val_in,
+                          void *attribute_val_out, int *flag)
+{
+  /* a duplicate of the communicator has no slots of its own */
+  *flag = 0;
+  return sc_MPI_SUCCESS;
+}
+
+#endif /* SC_ENABLE_MPI */
+
+void
+sc_mpi_comm_attach_thread_comms (sc_MPI_Comm comm, int num_slots)
+{
+#ifdef SC_ENABLE_MPI
+  int                 mpiret, i;
+  sc_mpi_thread_comms_t *tc;
+
+  SC_ASSERT (num_slots >= 0);
+
+  if (sc_mpi_thread_comm_keyval == sc_MPI_KEYVAL_INVALID) {
+    mpiret =
+      sc_MPI_Comm_create_keyval (sc_mpi_thread_comms_copy,
+                                 sc_mpi_thread_comms_destroy,
+                                 &sc_mpi_thread_comm_keyval, NULL);
+    SC_CHECK_MPI (mpiret);
+  }
+  sc_mpi_comm_detach_thread_comms (comm);
+
+  /* We can't used SC_ALLOC because these might be destroyed after
+   * sc finalizes */
+  mpiret = sc_MPI_Alloc_mem (sizeof (sc_mpi_thread_comms_t) +
+                             num_slots * sizeof (sc_MPI_Comm),
+                             sc_MPI_INFO_NULL, &tc);
+  SC_CHECK_MPI (mpiret);
+  tc->num_slots = num_slots;
+  tc->comms = (sc_MPI_Comm *) (tc + 1);
+  for (i = 0; i < num_slots; ++i) {
+    mpiret = sc_MPI_Comm_dup (comm, &tc->comms[i]);
+    SC_CHECK_MPI (mpiret);
+  }
+
+  mpiret = sc_MPI_Comm_set_attr (comm, sc_mpi_thread_comm_keyval, tc);
+  SC_CHECK_MPI (mpiret);
+#endif
+}
+
+void
+sc_mpi_comm_detach_thread_comms (sc_MPI_Comm comm)
+{
+#ifdef SC_ENABLE_MPI
+  int                 mpiret, flag;
+  sc_mpi_thread_comms_t *tc;
+
+  if (comm == sc_MPI_COMM_NULL ||
+      sc_mpi_thread_comm_keyval == sc_MPI_KEYVAL_INVALID) {
+    return;
+  }
+  mpiret = sc_MPI_Comm_get_attr (comm, sc_mpi_thread_comm_keyval,
+                                 &tc, &flag);
+  SC_CHECK_MPI (mpiret);
+  if (flag) {
+    mpiret = sc_MPI_Comm_delete_attr (comm, sc_mpi_thread_comm_keyval);
+    SC_CHECK_MPI (mpiret);
+  }
+#endif
+}
+
+#ifdef SC_ENABLE_PTHREAD
+
+/* the slot plus one is stored as the thread specific pointer value */
+static pthread_once_t sc_mpi_thread_slot_once = PTHREAD_ONCE_INIT;
+static pthread_key_t sc_mpi_thread_slot_key;
+
+static void
+sc_mpi_thread_slot_create_key (void)
+{
+  int                 pth;
+
+  pth = pthread_key_create (&sc_mpi_thread_slot_key, NULL);
+  SC_CHECK_ABORT (pth == 0, "pthread_key_create for MPI thread slots");
+}
+
+#else
+
+static int          sc_mpi_thread_slot = -1;
+
+#endif /* SC_ENABLE_PTHREAD */
+
+void
+sc_mpi_thread_slot_set (int slot)
+{
+  SC_ASSERT (slot >= -1);
+#ifdef SC_ENABLE_PTHREAD
+  pthread_once (&sc_mpi_thread_slot_once, sc_mpi_thread_slot_create_key);
+  pthread_setspecific (sc_mpi_thread_slot_key,
+                       (void *) (size_t) (slot + 1));
+#else
+  sc_mpi_thread_slot = slot;
+#endif
+}
+
+int
+sc_mpi_thread_slot_get (void)
+{
+#ifdef SC_ENABLE_PTHREAD
+  pthread_once (&sc_mpi_thread_slot_once, sc_mpi_thread_slot_create_key);
+  return (int) (size_t) pthread_getspecific (sc_mpi_thread_slot_key) - 1;
+#else
+  return sc_mpi_thread_slot;
+#endif
+}
+
+sc_MPI_Comm
+sc_mpi_comm_thread (sc_MPI_Comm comm)
+{
+#ifdef SC_ENABLE_MPI
+  int                 mpiret, flag, slot;
+  sc_mpi_thread_comms_t *tc;
+
+  if (sc_mpi_thread_comm_keyval == sc_MPI_KEYVAL_INVALID ||
+      comm == sc_MPI_COMM_NULL || (slot = sc_mpi_thread_slot_get ()) < 0) {
+    return comm;
+  }
+  mpiret = sc_MPI_Comm_get_attr (comm, sc_mpi_thread_comm_keyval,
+                                 &tc, &flag);
+  SC_CHECK_MPI (mpiret);
+  if (flag && tc != NULL) {
+    SC_CHECK_ABORT (slot < tc->num_slots, "MPI thread slot out of range");
+    return tc->comms[slot];
+  }
+#endif
+  return comm;
+}
+
+void
+sc_mpi_profile_enable (int top)
+{
+  SC_ASSERT (top >= 0);
+  sc_mpi_profile_top = top;
+}
+
+int
+sc_mpi_profile_is_enabled (void)
+{
+  return sc_mpi_profile_top;
+}
+
+void
+sc_mpi_profile_reset (void)
+{
+  memset (sc_mpi_profile_entries, 0, sizeof (sc_mpi_profile_entries));
+}
+
+void
+sc_mpi_profile_enter (sc_mpi_caller_t caller)
+{
+  SC_ASSERT (0 <= caller && caller < SC_MPI_NUM_CALLERS);
+  if (sc_mpi_profile_depth++ == 0) {
+    sc_mpi_profile_caller = caller;
+  }
+}
+
+void
+sc_mpi_profile_leave (void)
+{
+  SC_ASSERT (sc_mpi_profile_depth > 0);
+  if (--sc_mpi_profile_depth == 0) {
+    sc_mpi_profile_caller = SC_MPI_CALLER_USER;
+  }
+}
+
+sc_mpi_caller_t
+sc_mpi_profile_get_caller (void)
+{
+  return sc_mpi_profile_caller;
+}
+
+/** A pair of wrapper and caller ordered by its time. */
+typedef struct sc_mpi_profile_rank
+{
+  double              time;
+  int                 pair;
+}
+sc_mpi_profile_rank_t;
+
+static int
+sc_mpi_profile_compare (const void *v1, const void *v2)
+{
+  const double        t1 = ((const sc_mpi_profile_rank_t *) v1)->time;
+  const double        t2 = ((const sc_mpi_profile_rank_t *) v2)->time;
+
+  /* the most expensive pair comes first */
+  return t1 < t2 ? 1 : t1 > t2 ? -1 : 0;
+}
+
+void
+sc_mpi_profile_report (sc_MPI_Comm mpicomm)
+{
+  const int           npairs =
+    SC_MPI_PROFILE_NUM_FUNCS * SC_MPI_NUM_CALLERS;
+  int                 top;
+  int                 k, f, c;
+  int                 printed;
+  double              caller_time;
+  sc_mpi_profile_entry_t *entry;
+  sc_mpi_profile_rank_t *ranks;
+  sc_statinfo_t      *stats;
+
+  /* do not record the communication of the report itself */
+  top = sc_mpi_profile_top;
+  sc_mpi_profile_top = 0;
+
+  /* for every pair the calls, the bytes and the time */
+  stats = SC_ALLOC (sc_statinfo_t, 3 * npairs);
+  for (k = 0; k < npairs; ++k) {
+    f = k / SC_MPI_NUM_CALLERS;
+    c = k % SC_MPI_NUM_CALLERS;
+    entry = &sc_mpi_profile_entries[f][c];
+    sc_stats_set1 (stats + 3 * k, entry->calls, "calls");
+    sc_stats_set1 (stats + 3 * k + 1, entry->bytes, "bytes");
+    sc_stats_set1 (stats + 3 * k + 2, entry->time, "time");
+  }
+  sc_stats_compute (mpicomm, 3 * npairs, stats);
+
+  ranks = SC_ALLOC (sc_mpi_profile_rank_t, npairs);
+  for (k = 0; k < npairs; ++k) {
+    ranks[k].time = stats[3 * k + 2].sum_values;
+    ranks[k].pair = k;
+  }
+  qsort (ranks, (size_t) npairs, sizeof (sc_mpi_profile_rank_t),
+         sc_mpi_profile_compare);
+
+  SC_GLOBAL_STATISTICSF ("MPI profile of the %d most expensive calls\n",
+                         top);
+  SC_GLOBAL_STATISTICSF ("%-12s %-12s %10s %12s %12s %12s\n", "function",
+                         "caller", "calls", "bytes", "avg time",
+                         "max time");
+  printed = 0;
+  for (k = 0; k < npairs && printed < top; ++k) {
+    const sc_statinfo_t *si = stats + 3 * ranks[k].pair;
+
+    if (si->sum_values <= 0.) {
+      /* the remaining pairs were never called */
+      break;
+    }
+    f = ranks[k].pair / SC_MPI_NUM_CALLERS;
+    c = ranks[k].pair % SC_MPI_NUM_CALLERS;
+    SC_GLOBAL_STATISTICSF ("%-12s %-12s %10.0f %12.0f %12.3e %12.3e\n",
+                           sc_mpi_profile_func_names[f],
+                           sc_mpi_profile_caller_names[c],
+                           si[0].sum_values, si[1].sum_values,
+                           si[2].average, si[2].max);
+    ++printed;
+  }
+  for (c = 0; c < SC_MPI_NUM_CALLERS; ++c) {
+    caller_time = 0.;
+    for (f = 0; f < SC_MPI_PROFILE_NUM_FUNCS; ++f) {
+      caller_time += stats[3 * (f * SC_MPI_NUM_CALLERS + c) + 2].average;
+    }
+    if (caller_time <= 0.) {
+      continue;
+    }
+    SC_GLOBAL_STATISTICSF ("MPI profile average time of %s %.3e\n",
+                           sc_mpi_profile_caller_names[c], caller_time);
+  }
+
+  SC_FREE (ranks);
+  SC_FREE (stats);
+  sc_mpi_profile_top = top;
+}
@@ -98,6 +98,15 @@ typedef enum
   SC_TAG_REDUCE = SC_TAG_NOTIFY_NARY + 32,  /**< Used in MPI reduce replacement. */
   SC_TAG_PSORT_LO,              /**< Internal tag to \ref sc_psort. */
   SC_TAG_PSORT_HI,              /**< Internal tag to \ref sc_psort. */
+  SC_TAG_NOTIFY_PLAN,           /**< Internal tag to \ref sc_notify. */
+  SC_TAG_NOTIFY_GRAPH,          /**< Internal tag to \ref sc_notify. */
+  SC_TAG_NOTIFY_VIEWS,          /**< Internal tag to \ref sc_notify. */
+  SC_TAG_AG_RING,               /**< Internal tag; do not use. */
+  SC_TAG_AG_BRUCK,              /**< Internal tag; do not use. */
+  SC_TAG_RANGES,                /**< Internal tag to \ref sc_ranges. */
+  SC_TAG_IO_PARTITION,          /**< Internal tag to \ref sc_io.h. */
+  SC_TAG_DHASH,                 /**< Internal tag to \ref sc_dhash.h. */
+  SC_TAG_PROGRESS_NOTIFY,       /**< Internal tag to \ref sc_progress.h. */
   SC_TAG_LAST                   /**< End marker of tag enumeration. */
 }
 sc_tag_t;
@@ -265,28 +274,20 @@ sc_MPI_IO_Errorcode_t;
 #define sc_MPI_Group_excl          MPI_Group_excl
 #define sc_MPI_Group_range_incl    MPI_Group_range_incl
 #define sc_MPI_Group_range_excl    MPI_Group_range_excl
-#define sc_MPI_Barrier             MPI_Barrier
-#define sc_MPI_Bcast               MPI_Bcast
-#define sc_MPI_Gather              MPI_Gather
-#define sc_MPI_Gatherv             MPI_Gatherv
-#define sc_MPI_Allgather           MPI_Allgather
-#define sc_MPI_Allgatherv          MPI_Allgatherv
-#define sc_MPI_Alltoall            MPI_Alltoall
-#define sc_MPI_Reduce              MPI_Reduce
+#define sc_MPI_Scatter             MPI_Scatter
+#define sc_MPI_Scatterv            MPI_Scatterv
 #define sc_MPI_Reduce_scatter_block MPI_Reduce_scatter_block
-#define sc_MPI_Allreduce           MPI_Allreduce
-#define sc_MPI_Scan                MPI_Scan
-#define sc_MPI_Exscan              MPI_Exscan
-#define sc_MPI_Recv                MPI_Recv
-#define sc_MPI_Irecv               MPI_Irecv
-#define sc_MPI_Send                MPI_Send
-#define sc_MPI_Isend               MPI_Isend
+#define sc_MPI_Send_init           MPI_Send_init
+#define sc_MPI_Recv_init           MPI_Recv_init
+#define sc_MPI_Request_free        MPI_Request_free
 #define sc_MPI_Probe               MPI_Probe
 #define sc_MPI_Iprobe              MPI_Iprobe
 #define sc_MPI_Get_count           MPI_Get_count
 #define sc_MPI_Wtime               MPI_Wtime
-#define sc_MPI_Wait                MPI_Wait
-/* The MPI_Waitsome, MPI_Waitall and MPI_Testall functions are wrapped. */
+#define sc_MPI_Test                MPI_Test
+/* The communication functions recorded by sc_mpi_profile_enable and
+   the MPI_Waitany, MPI_Waitsome, MPI_Waitall, MPI_Testall and MPI_Startall
+   functions are wrapped. */
 #define sc_MPI_Type_size           MPI_Type_size
 
 #else /* !SC_ENABLE_MPI */
@@ -469,6 +470,74 @@ int                 sc_MPI_Group_size (sc_MPI_Group mpigroup, int *size);
  */
 int                 sc_MPI_Group_rank (sc_MPI_Group mpigroup, int *rank);
 
+int                 sc_MPI_Scatter (void *, int, sc_MPI_Datatype, void *,
+                                    int, sc_MPI_Datatype, int, sc_MPI_Comm);
+int                 sc_MPI_Scatterv (void *, int *, int *, sc_MPI_Datatype,
+                                     void *, int, sc_MPI_Datatype, int,
+                                     sc_MPI_Comm);
+
+int                 sc_MPI_Reduce_scatter_block (void *, void *,
+                                                 int, sc_MPI_Datatype,
+                                                 sc_MPI_Op, sc_MPI_Comm);
+
+/** Execute the MPI_Wtime function.
+ * \return          Number of seconds since the epoch. */
+double              sc_MPI_Wtime (void);
+
+/** Return the input communicator in lieu of splitting.
+ * \return          MPI_SUCCESS.
+ */
+int                 sc_MPI_Comm_split (sc_MPI_Comm, int, int, sc_MPI_Comm *);
+
+/* These functions will run but their results/actions are not defined. */
+
+int                 sc_MPI_Comm_create (sc_MPI_Comm, sc_MPI_Group,
+                                        sc_MPI_Comm *);
+int                 sc_MPI_Comm_compare (sc_MPI_Comm, sc_MPI_Comm, int *);
+int                 sc_MPI_Comm_group (sc_MPI_Comm, sc_MPI_Group *);
+
+int                 sc_MPI_Group_free (sc_MPI_Group *);
+int                 sc_MPI_Group_translate_ranks (sc_MPI_Group, int, int *,
+                                                  sc_MPI_Group, int *);
+int                 sc_MPI_Group_compare (sc_MPI_Group, sc_MPI_Group, int *);
+int                 sc_MPI_Group_union (sc_MPI_Group, sc_MPI_Group,
+                                        sc_MPI_Group *);
+int                 sc_MPI_Group_intersection (sc_MPI_Group, sc_MPI_Group,
+                                               sc_MPI_Group *);
+int                 sc_MPI_Group_difference (sc_MPI_Group, sc_MPI_Group,
+                                             sc_MPI_Group *);
+int                 sc_MPI_Group_incl (sc_MPI_Group, int, int *,
+                                       sc_MPI_Group *);
+int                 sc_MPI_Group_excl (sc_MPI_Group, int, int *,
+                                       sc_MPI_Group *);
+int                 sc_MPI_Group_range_incl (sc_MPI_Group, int,
+                                             int ranges[][3], sc_MPI_Group *);
+int                 sc_MPI_Group_range_excl (sc_MPI_Group, int,
+                                             int ranges[][3], sc_MPI_Group *);
+
+/* These functions will abort. */
+
+int                 sc_MPI_Send_init (void *, int, sc_MPI_Datatype, int, int,
+                                      sc_MPI_Comm, sc_MPI_Request *);
+int                 sc_MPI_Recv_init (void *, int, sc_MPI_Datatype, int, int,
+                                      sc_MPI_Comm, sc_MPI_Request *);
+int                 sc_MPI_Probe (int, int, sc_MPI_Comm, sc_MPI_Status *);
+int                 sc_MPI_Iprobe (int, int, sc_MPI_Comm, int *,
+                                   sc_MPI_Status *);
+int                 sc_MPI_Get_count (sc_MPI_Status *, sc_MPI_Datatype,
+                                      int *);
+
+/* These functions are only allowed to be called with NULL requests. */
+
+int                 sc_MPI_Test (sc_MPI_Request *, int *, sc_MPI_Status *);
+int                 sc_MPI_Request_free (sc_MPI_Request *);
+
+#endif /* !SC_ENABLE_MPI */
+
+/* The following functions are wrapped to record the statistics enabled by
+   sc_mpi_profile_enable.  Without SC_ENABLE_MPI they are valid and
+   functional for a single process. */
+
 /** Execute a parallel barrier.
  * \param [in] mpicomm      Valid communicator.
  */
@@ -501,10 +570,6 @@ int                 sc_MPI_Alltoall (void *, int, sc_MPI_Datatype, void *,
 int                 sc_MPI_Reduce (void *, void *, int, sc_MPI_Datatype,
                                    sc_MPI_Op, int, sc_MPI_Comm);
 
-int                 sc_MPI_Reduce_scatter_block (void *, void *,
-                                                 int, sc_MPI_Datatype,
-                                                 sc_MPI_Op, sc_MPI_Comm);
-
 /** Execute the MPI_Allreduce algorithm. */
 int                 sc_MPI_Allreduce (void *, void *, int, sc_MPI_Datatype,
                                       sc_MPI_Op, sc_MPI_Comm);
@@ -517,42 +582,7 @@ int                 sc_MPI_Scan (void *, void *, int, sc_MPI_Datatype,
 int                 sc_MPI_Exscan (void *, void *, int, sc_MPI_Datatype,
                                    sc_MPI_Op, sc_MPI_Comm);
 
-/** Execute the MPI_Wtime function.
- * \return          Number of seconds since the epoch. */
-double              sc_MPI_Wtime (void);
-
-/** Return the input communicator in lieu of splitting.
- * \return          MPI_SUCCESS.
- */
-int                 sc_MPI_Comm_split (sc_MPI_Comm, int, int, sc_MPI_Comm *);
-
-/* These functions will run but their results/actions are not defined. */
-
-int                 sc_MPI_Comm_create (sc_MPI_Comm, sc_MPI_Group,
-                                        sc_MPI_Comm *);
-int                 sc_MPI_Comm_compare (sc_MPI_Comm, sc_MPI_Comm, int *);
-int                 sc_MPI_Comm_group (sc_MPI_Comm, sc_MPI_Group *);
-
-int                 sc_MPI_Group_free (sc_MPI_Group *);
-int                 sc_MPI_Group_translate_ranks (sc_MPI_Group, int, int *,
-                                                  sc_MPI_Group, int *);
-int                 sc_MPI_Group_compare (sc_MPI_Group, sc_MPI_Group, int *);
-int                 sc_MPI_Group_union (sc_MPI_Group, sc_MPI_Group,
-                                        sc_MPI_Group *);
-int                 sc_MPI_Group_intersection (sc_MPI_Group, sc_MPI_Group,
-                                               sc_MPI_Group *);
-int                 sc_MPI_Group_difference (sc_MPI_Group, sc_MPI_Group,
-                                             sc_MPI_Group *);
-int                 sc_MPI_Group_incl (sc_MPI_Group, int, int *,
-                                       sc_MPI_Group *);
-int                 sc_MPI_Group_excl (sc_MPI_Group, int, int *,
-                                       sc_MPI_Group *);
-int                 sc_MPI_Group_range_incl (sc_MPI_Group, int,
-                                             int ranges[][3], sc_MPI_Group *);
-int                 sc_MPI_Group_range_excl (sc_MPI_Group, int,
-                                             int ranges[][3], sc_MPI_Group *);
-
-/* These functions will abort. */
+/* The following functions are wrapped.  Without SC_ENABLE_MPI they abort. */
 
 int                 sc_MPI_Recv (void *, int, sc_MPI_Datatype, int, int,
                                  sc_MPI_Comm, sc_MPI_Status *);
@@ -562,25 +592,83 @@ int                 sc_MPI_Send (void *, int, sc_MPI_Datatype, int, int,
                                  sc_MPI_Comm);
 int                 sc_MPI_Isend (void *, int, sc_MPI_Datatype, int, int,
                                   sc_MPI_Comm, sc_MPI_Request *);
-int                 sc_MPI_Probe (int, int, sc_MPI_Comm, sc_MPI_Status *);
-int                 sc_MPI_Iprobe (int, int, sc_MPI_Comm, int *,
-                                   sc_MPI_Status *);
-int                 sc_MPI_Get_count (sc_MPI_Status *, sc_MPI_Datatype,
-                                      int *);
-
-/* This function is only allowed to be called with NULL requests. */
-
-int                 sc_MPI_Wait (sc_MPI_Request *, sc_MPI_Status *);
-
-#endif /* !SC_ENABLE_MPI */
 
 /* Without SC_ENABLE_MPI, only allowed to be called with NULL requests. */
 
+int                 sc_MPI_Wait (sc_MPI_Request *, sc_MPI_Status *);
+int                 sc_MPI_Waitany (int, sc_MPI_Request *, int *,
+                                    sc_MPI_Status *);
 int                 sc_MPI_Waitsome (int, sc_MPI_Request *,
                                      int *, int *, sc_MPI_Status *);
 int                 sc_MPI_Waitall (int, sc_MPI_Request *, sc_MPI_Status *);
 int                 sc_MPI_Testall (int, sc_MPI_Request *, int *,
                                     sc_MPI_Status *);
+int                 sc_MPI_Startall (int, sc_MPI_Request *);
+
+#if defined SC_ENABLE_MPI && MPI_VERSION >= 3
+
+#define sc_MPI_Ibarrier            MPI_Ibarrier
+#define sc_MPI_Ibcast              MPI_Ibcast
+#define sc_MPI_Igather             MPI_Igather
+#define sc_MPI_Igatherv            MPI_Igatherv
+#define sc_MPI_Iscatter            MPI_Iscatter
+#define sc_MPI_Iscatterv           MPI_Iscatterv
+#define sc_MPI_Iallgather          MPI_Iallgather
+#define sc_MPI_Iallgatherv         MPI_Iallgatherv
+#define sc_MPI_Ialltoall           MPI_Ialltoall
+#define sc_MPI_Ireduce             MPI_Ireduce
+#define sc_MPI_Iallreduce          MPI_Iallreduce
+#define sc_MPI_Ireduce_scatter_block MPI_Ireduce_scatter_block
+#define sc_MPI_Iscan               MPI_Iscan
+#define sc_MPI_Iexscan             MPI_Iexscan
+
+#else
+
+/* Without SC_ENABLE_MPI or before MPI 3, the nonblocking collectives
+   execute the blocking operation and return a null request. */
+
+/** \cond MPI_DOCUMENT_ALL */
+int                 sc_MPI_Ibarrier (sc_MPI_Comm, sc_MPI_Request *);
+int                 sc_MPI_Ibcast (void *, int, sc_MPI_Datatype, int,
+                                   sc_MPI_Comm, sc_MPI_Request *);
+int                 sc_MPI_Igather (void *, int, sc_MPI_Datatype, void *,
+                                    int, sc_MPI_Datatype, int, sc_MPI_Comm,
+                                    sc_MPI_Request *);
+int                 sc_MPI_Igatherv (void *, int, sc_MPI_Datatype, void *,
+                                     int *, int *, sc_MPI_Datatype, int,
+                                     sc_MPI_Comm, sc_MPI_Request *);
+int                 sc_MPI_Iscatter (void *, int, sc_MPI_Datatype, void *,
+                                     int, sc_MPI_Datatype, int, sc_MPI_Comm,
+                                     sc_MPI_Request *);
+int                 sc_MPI_Iscatterv (void *, int *, int *, sc_MPI_Datatype,
+                                      void *, int, sc_MPI_Datatype, int,
+                                      sc_MPI_Comm, sc_MPI_Request *);
+int                 sc_MPI_Iallgather (void *, int, sc_MPI_Datatype, void *,
+                                       int, sc_MPI_Datatype, sc_MPI_Comm,
+                                       sc_MPI_Request *);
+int                 sc_MPI_Iallgatherv (void *, int, sc_MPI_Datatype, void *,
+                                        int *, int *, sc_MPI_Datatype,
+                                        sc_MPI_Comm, sc_MPI_Request *);
+int                 sc_MPI_Ialltoall (void *, int, sc_MPI_Datatype, void *,
+                                      int, sc_MPI_Datatype, sc_MPI_Comm,
+                                      sc_MPI_Request *);
+int                 sc_MPI_Ireduce (void *, void *, int, sc_MPI_Datatype,
+                                    sc_MPI_Op, int, sc_MPI_Comm,
+                                    sc_MPI_Request *);
+int                 sc_MPI_Iallreduce (void *, void *, int, sc_MPI_Datatype,
+                                       sc_MPI_Op, sc_MPI_Comm,
+                                       sc_MPI_Request *);
+int                 sc_MPI_Ireduce_scatter_block (void *, void *, int,
+                                                  sc_MPI_Datatype, sc_MPI_Op,
+                                                  sc_MPI_Comm,
+                                                  sc_MPI_Request *);
+int                 sc_MPI_Iscan (void *, void *, int, sc_MPI_Datatype,
+                                  sc_MPI_Op, sc_MPI_Comm, sc_MPI_Request *);
+int                 sc_MPI_Iexscan (void *, void *, int, sc_MPI_Datatype,
+                                    sc_MPI_Op, sc_MPI_Comm, sc_MPI_Request *);
+/** \endcond */
+
+#endif /* !(SC_ENABLE_MPI && MPI_VERSION >= 3) */
 
 #if defined SC_ENABLE_MPI && defined SC_ENABLE_MPITHREAD
 
@@ -702,12 +790,29 @@ size_t              sc_mpi_sizeof (sc_MPI_Datatype t);
 
 /** \cond MPI_DOCUMENT_NODE_COMM */
 
+/** The levels of the hardware hierarchy known to the node communicators. */
+typedef enum
+{
+  SC_MPI_LEVEL_NODE,      /**< Processes that share memory. */
+  SC_MPI_LEVEL_SOCKET,    /**< Processes on one socket or NUMA domain. */
+  SC_MPI_LEVEL_CORE,      /**< Processes on one core. */
+  SC_MPI_NUM_LEVELS       /**< The number of levels. */
+}
+sc_mpi_level_t;
+
 /** Compute ``sc_intranode_comm'' and ``sc_internode_comm''
  * communicators and attach them to the current communicator.  This split
  * takes \a processes_per_node passed by the user at face value: there is no
  * hardware checking to see if this is the true affinity.
  *
- * This function does nothing if MPI_Comm_split_type is not found.
+ * In addition, each node is split by socket and each socket by core as
+ * far as the MPI implementation reports them, see
+ * \ref sc_mpi_comm_get_level_comms.  If it does not, and with a positive
+ * \a processes_per_node, the socket is the whole node and the core a single
+ * process.  These levels are split on their first query.
+ *
+ * This function is collective.  It does nothing if MPI_Comm_split_type
+ * is not found.
  *
  * \param [in/out] comm                 MPI communicator
  * \param [in]     processes_per_node   the size of the intranode
@@ -718,6 +823,24 @@ size_t              sc_mpi_sizeof (sc_MPI_Datatype t);
 void                sc_mpi_comm_attach_node_comms (sc_MPI_Comm comm,
                                                    int processes_per_node);
 
+/** Attach node communicators to be computed on their first use.
+ * The split of \ref sc_mpi_comm_attach_node_comms is deferred to the first
+ * call of \ref sc_mpi_comm_get_node_comms or
+ * \ref sc_mpi_comm_get_level_comms, which is then collective on \a comm.
+ * The functions of libsc querying the node communicators are collective
+ * themselves, such that an application may call this function right after
+ * startup and pay for the split only if it is needed.
+ * This function does not communicate.
+ * It does nothing if MPI_Comm_split_type is not found.
+ *
+ * \param [in/out] comm                 MPI communicator
+ * \param [in]     processes_per_node   As in
+ *                                      \ref sc_mpi_comm_attach_node_comms.
+ */
+void                sc_mpi_comm_attach_node_comms_lazy (sc_MPI_Comm comm,
+                                                        int
+                                                        processes_per_node);
+
 /** Destroy ``sc_intranode_comm'' and ``sc_internode_comm''
  * communicators that are stored as attributes to communicator ``comm''.
  * This routine enforces a call to the destroy callback for these attributes.
@@ -729,7 +852,9 @@ void                sc_mpi_comm_attach_node_comms (sc_MPI_Comm comm,
 void                sc_mpi_comm_detach_node_comms (sc_MPI_Comm comm);
 
 /** Get the communicators computed in sc_mpi_comm_attach_node_comms() if they
- * exist; return sc_MPI_COMM_NULL otherwise.
+ * exist; return sc_MPI_COMM_NULL otherwise.  If they have been attached
+ * by \ref sc_mpi_comm_attach_node_comms_lazy and not yet computed, this
+ * function computes them and is collective.
  *
  * \param[in] comm            Super communicator
  * \param[out] intranode      intranode communicator
@@ -739,6 +864,24 @@ void                sc_mpi_comm_get_node_comms (sc_MPI_Comm comm,
                                                 sc_MPI_Comm * intranode,
                                                 sc_MPI_Comm * internode);
 
+/** Get the communicators of one level computed in
+ * sc_mpi_comm_attach_node_comms() if they exist; return sc_MPI_COMM_NULL
+ * otherwise.  The level \ref SC_MPI_LEVEL_NODE yields the same as
+ * sc_mpi_comm_get_node_comms().  Below, the sizes of the domains may vary.
+ * The first query of a level below the node splits it and is collective.
+ *
+ * \param[in] comm            Super communicator
+ * \param[in] level           The level of the hierarchy.
+ * \param[out] intra          The processes sharing this process's domain
+ *                            of the level.
+ * \param[out] inter          The processes of the domain of the level
+ *                            above with the same rank in \a intra.
+ */
+void                sc_mpi_comm_get_level_comms (sc_MPI_Comm comm,
+                                                 sc_mpi_level_t level,
+                                                 sc_MPI_Comm * intra,
+                                                 sc_MPI_Comm * inter);
+
 /** Convenience function to get a node comm and attach it as an attribute.
  * \param [in,out] comm       As in \ref sc_mpu_comm_attach_node_comms.
  * \return                    If the intranode communicator cannot be
@@ -749,6 +892,117 @@ int                 sc_mpi_comm_get_and_attach (sc_MPI_Comm comm);
 
 /** \endcond */
 
+/** Attach duplicates of a communicator for concurrent communication.
+ * The collectives sc_notify, sc_allgather, sc_reduce and sc_allreduce and
+ * the sc_notify_t controllers use fixed tags and may not run concurrently
+ * on the same communicator.  With this function, each of up to \a num_slots
+ * threads selects its own duplicate by \ref sc_mpi_thread_slot_set, which
+ * these functions substitute for \a comm by \ref sc_mpi_comm_thread.
+ * Matching calls of different threads must then use the same slot on all
+ * processes.  Node communicators attached to \a comm are duplicated along.
+ *
+ * This function is collective and must not run concurrently with any other
+ * communication on \a comm.  To use the slots from multiple threads, MPI
+ * must be initialized with \ref sc_MPI_THREAD_MULTIPLE.
+ * This function does nothing without SC_ENABLE_MPI.
+ *
+ * \param [in,out] comm         MPI communicator.  Previously attached
+ *                              duplicates are freed.
+ * \param [in] num_slots        The number of duplicates, non-negative.
+ */
+void                sc_mpi_comm_attach_thread_comms (sc_MPI_Comm comm,
+                                                     int num_slots);
+
+/** Free the duplicates attached by \ref sc_mpi_comm_attach_thread_comms.
+ * This function is collective.  It does nothing if none are attached.
+ * \param [in,out] comm         MPI communicator.
+ */
+void                sc_mpi_comm_detach_thread_comms (sc_MPI_Comm comm);
+
+/** Select the duplicate communicator used by the calling thread.
+ * The slot is stored per thread if SC_ENABLE_PTHREAD is defined
+ * and for the whole process otherwise.
+ * \param [in] slot         A slot less than the number passed to
+ *                          \ref sc_mpi_comm_attach_thread_comms,
+ *                          or -1 to use the communicator itself.
+ */
+void                sc_mpi_thread_slot_set (int slot);
+
+/** Return the slot of the calling thread.
+ * \return                  The value last set by this thread, initially -1.
+ */
+int                 sc_mpi_thread_slot_get (void);
+
+/** Return the communicator of the calling thread's slot.
+ * \param [in] comm         MPI communicator.
+ * \return                  The duplicate attached to \a comm for the slot
+ *                          of the calling thread, or \a comm if there is
+ *                          no slot or no duplicates are attached.
+ */
+sc_MPI_Comm         sc_mpi_comm_thread (sc_MPI_Comm comm);
+
+/** The libsc modules that communication statistics are attributed to.
+ * A call belongs to the outermost module entered on the call stack.
+ */
+typedef enum
+{
+  SC_MPI_CALLER_USER,     /**< Calls outside of the modules below. */
+  SC_MPI_CALLER_NOTIFY,   /**< The sc_notify functions. */
+  SC_MPI_CALLER_PSORT,    /**< The parallel sort sc_psort functions. */
+  SC_MPI_CALLER_ALLGATHER,      /**< The sc_allgather function. */
+  SC_MPI_CALLER_REDUCE,   /**< The sc_reduce and sc_allreduce functions. */
+  SC_MPI_CALLER_SHMEM,    /**< The communicating sc_shmem functions. */
+  SC_MPI_NUM_CALLERS      /**< The number of callers. */
+}
+sc_mpi_caller_t;
+
+/** Record the calls, bytes and wall time of the communication wrappers.
+ * The wrappers are the sc_MPI functions from sc_MPI_Barrier to sc_MPI_Wait
+ * and sc_MPI_Waitany, sc_MPI_Waitsome and sc_MPI_Waitall.  The bytes are
+ * the send buffer sizes and for receives the receive buffer sizes.
+ * The statistics are kept per wrapper and \ref sc_mpi_caller_t.
+ * Without SC_ENABLE_MPI nothing is recorded.
+ * Recording is not thread safe and meant for single threaded communication.
+ * It is enabled at \ref sc_init if the environment variable SC_MPI_PROFILE
+ * holds a positive number and reported at \ref sc_finalize.
+ * \param [in] top          The number of the most expensive pairs of wrapper
+ *                          and caller printed by \ref sc_mpi_profile_report.
+ *                          Zero stops the recording.
+ */
+void                sc_mpi_profile_enable (int top);
+
+/** Return the number of report lines set by \ref sc_mpi_profile_enable.
+ * \return                  Zero if the recording is stopped.
+ */
+int                 sc_mpi_profile_is_enabled (void);
+
+/** Clear all statistics recorded so far. */
+void                sc_mpi_profile_reset (void);
+
+/** Attribute the following communication to a libsc module.
+ * Every call must be matched by \ref sc_mpi_profile_leave.
+ * Nested calls keep the outermost module.
+ * \param [in] caller       The module entered.
+ */
+void                sc_mpi_profile_enter (sc_mpi_caller_t caller);
+
+/** Leave the module given to the matching \ref sc_mpi_profile_enter. */
+void                sc_mpi_profile_leave (void);
+
+/** Return the module that communication is currently attributed to.
+ * \return                  The outermost module entered.
+ */
+sc_mpi_caller_t     sc_mpi_profile_get_caller (void);
+
+/** Aggregate the statistics over a communicator and print a report.
+ * For the most expensive pairs of wrapper and caller we print the sum
+ * of calls and bytes and the average and maximum time over the processes,
+ * followed by the time of each caller.  The output goes to the global
+ * statistics log of libsc.  This function is collective.
+ * \param [in] mpicomm      Communicator of the processes to aggregate.
+ */
+void                sc_mpi_profile_report (sc_MPI_Comm mpicomm);
+
 SC_EXTERN_C_END;
 
 #endif /* !SC_MPI_H */
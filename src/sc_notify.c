@@ -26,8 +26,10 @@
 #include <sc_ranges.h>
 #include <sc_flops.h>
 
+/* the snapshots also attribute the communication in between to sc_notify */
 #define SC_NOTIFY_FUNC_SNAP(notify,snap)                   \
 do {                                                       \
+  sc_mpi_profile_enter (SC_MPI_CALLER_NOTIFY);             \
   if (notify->stats) {                                     \
     SC_FUNC_SNAP (notify->stats, &(notify->flop), (snap)); \
   }                                                        \
@@ -38,8 +40,12 @@ do {                                                       \
   if (notify->stats) {                                     \
     SC_FUNC_SHOT (notify->stats, &(notify->flop), (snap)); \
   }                                                        \
+  sc_mpi_profile_leave ();                                 \
 } while (0)
 
+/* bytes moved at a time when permuting received payload */
+#define SC_NOTIFY_PERMUTE_BLOCK 4096
+
 /*== INTERFACE == */
 
 sc_notify_type_t    sc_notify_type_default = SC_NOTIFY_PEX;
@@ -67,9 +73,39 @@ typedef struct sc_notify_superset_s
 {
   sc_compute_superset_t compute_superset;
   void               *ctx;
+  int                 cache;    /**< Whether to keep the callback result. */
+  int                 cached;   /**< Whether the arrays below are valid. */
+  sc_array_t          super_receivers;  /**< Sorted union of receivers
+                                             and extra receivers. */
+  sc_array_t          super_senders;    /**< Sorted superset of senders. */
 }
 sc_notify_superset_t;
 
+/** Node topology and inter-node controller of \ref SC_NOTIFY_HIERARCHICAL. */
+typedef struct sc_notify_hierarchical_s
+{
+  sc_notify_type_t    inter_type;       /**< Algorithm among the leaders. */
+  int                 ready;    /**< Whether the members below are set. */
+  sc_MPI_Comm         intranode;        /**< Node comms the table is for. */
+  sc_MPI_Comm         internode;
+  int                *nodes;    /**< Per rank its node and node rank. */
+  sc_notify_t        *inter;    /**< Controller among the leaders or
+                                     over the whole communicator. */
+}
+sc_notify_hierarchical_t;
+
+/** Progress of the algorithm selection of \ref SC_NOTIFY_AUTO. */
+typedef struct sc_notify_auto_s
+{
+  int                 regime;   /**< Receiver count regime or -1. */
+  int                 next;     /**< Next candidate to time. */
+  int                 best;     /**< Fastest candidate so far. */
+  double              best_time;        /**< Its run time. */
+  int                 eager_next;       /**< 0, 1 for eager, lazy trial. */
+  double              eager_time;       /**< Run time of the eager trial. */
+}
+sc_notify_auto_t;
+
 struct sc_notify_s
 {
   sc_MPI_Comm         mpicomm;
@@ -77,11 +113,13 @@ struct sc_notify_s
   size_t              eager_threshold;
   sc_statistics_t    *stats;
   sc_flopinfo_t       flop;
+  sc_notify_auto_t    tune;
   union
   {
     sc_notify_nary_t    nary;
     sc_notify_ranges_t  ranges;
     sc_notify_superset_t superset;
+    sc_notify_hierarchical_t hierarchical;
   }
   data;
 };
@@ -96,15 +134,25 @@ const char         *sc_notify_type_strings[SC_NOTIFY_NUM_TYPES] = {
   SC_NOTIFY_STR_NBX,
   SC_NOTIFY_STR_RANGES,
   SC_NOTIFY_STR_SUPERSET,
+  SC_NOTIFY_STR_AUTO,
+  SC_NOTIFY_STR_HIERARCHICAL,
 };
 
+static void         sc_notify_nary_init (sc_notify_t * notify);
+static void         sc_notify_ranges_init (sc_notify_t * notify);
+static void         sc_notify_auto_init (sc_notify_t * notify);
+static void         sc_notify_hierarchical_init (sc_notify_t * notify);
+static void         sc_notify_hierarchical_reset (sc_notify_t * notify);
+static void         sc_notify_superset_init (sc_notify_t * notify);
+static void         sc_notify_superset_reset (sc_notify_t * notify);
+
 sc_notify_t        *
 sc_notify_new (sc_MPI_Comm comm)
 {
   sc_notify_t        *notify;
 
   notify = SC_ALLOC_ZERO (sc_notify_t, 1);
-  notify->mpicomm = comm;
+  notify->mpicomm = sc_mpi_comm_thread (comm);
   notify->type = SC_NOTIFY_DEFAULT;
   notify->eager_threshold = sc_notify_eager_threshold_default;
   SC_ASSERT (sc_notify_type_default >= 0
@@ -130,7 +178,13 @@ sc_notify_destroy (sc_notify_t * notify)
   case SC_NOTIFY_RSX:
   case SC_NOTIFY_NBX:
   case SC_NOTIFY_RANGES:
+  case SC_NOTIFY_AUTO:
+    break;
   case SC_NOTIFY_SUPERSET:
+    sc_notify_superset_reset (notify);
+    break;
+  case SC_NOTIFY_HIERARCHICAL:
+    sc_notify_hierarchical_reset (notify);
     break;
   default:
     SC_ABORT_NOT_REACHED ();
@@ -150,9 +204,6 @@ sc_notify_get_type (sc_notify_t * notify)
   return notify->type;
 }
 
-static void         sc_notify_nary_init (sc_notify_t * notify);
-static void         sc_notify_ranges_init (sc_notify_t * notify);
-
 int
 sc_notify_supports_type (sc_notify_type_t type)
 {
@@ -171,6 +222,12 @@ sc_notify_set_type (sc_notify_t * notify, sc_notify_type_t in_type)
     in_type = sc_notify_type_default;
   }
   if (current_type != in_type) {
+    if (current_type == SC_NOTIFY_HIERARCHICAL) {
+      sc_notify_hierarchical_reset (notify);
+    }
+    if (current_type == SC_NOTIFY_SUPERSET) {
+      sc_notify_superset_reset (notify);
+    }
     notify->type = in_type;
     /* initialize_data */
     switch (in_type) {
@@ -180,7 +237,9 @@ sc_notify_set_type (sc_notify_t * notify, sc_notify_type_t in_type)
     case SC_NOTIFY_PCX:
     case SC_NOTIFY_RSX:
     case SC_NOTIFY_NBX:
+      break;
     case SC_NOTIFY_SUPERSET:
+      sc_notify_superset_init (notify);
       break;
     case SC_NOTIFY_RANGES:
       sc_notify_ranges_init (notify);
@@ -188,6 +247,12 @@ sc_notify_set_type (sc_notify_t * notify, sc_notify_type_t in_type)
     case SC_NOTIFY_NARY:
       sc_notify_nary_init (notify);
       break;
+    case SC_NOTIFY_AUTO:
+      sc_notify_auto_init (notify);
+      break;
+    case SC_NOTIFY_HIERARCHICAL:
+      sc_notify_hierarchical_init (notify);
+      break;
     default:
       SC_ABORT_NOT_REACHED ();
     }
@@ -204,7 +269,7 @@ sc_notify_get_eager_threshold (sc_notify_t * notify)
 }
 
 void
-sc_notify_set_eagher_threshold (sc_notify_t * notify, size_t thresh)
+sc_notify_set_eager_threshold (sc_notify_t * notify, size_t thresh)
 {
   notify->eager_threshold = thresh;
 }
@@ -238,6 +303,10 @@ void
 sc_notify_set_stats (sc_notify_t * notify, sc_statistics_t * stats)
 {
   notify->stats = stats;
+  if (notify->type == SC_NOTIFY_HIERARCHICAL &&
+      notify->data.hierarchical.inter != NULL) {
+    sc_notify_set_stats (notify->data.hierarchical.inter, stats);
+  }
 }
 
 sc_statistics_t    *
@@ -248,6 +317,60 @@ sc_notify_get_stats (sc_notify_t * notify)
 
 /*== HELPER FUNCTIONS ==*/
 
+/** Replace the content of an array by that of a new one, which is freed.
+ * This hands received data to the caller without copying it.
+ */
+static void
+sc_notify_array_move (sc_array_t * dest, sc_array_t * src)
+{
+  SC_ASSERT (dest->elem_size == src->elem_size);
+  SC_ASSERT (SC_ARRAY_IS_OWNER (dest) && SC_ARRAY_IS_OWNER (src));
+
+  sc_array_reset (dest);
+  *dest = *src;
+  SC_FREE (src);
+}
+
+/** Sort the senders and permute the payload received from them alongside.
+ * The payload is permuted in place in bounded blocks of memory.
+ * \param [in,out] senders  Array of int in the order of arrival.
+ * \param [in,out] payload  NULL or one entry per sender.
+ */
+static void
+sc_notify_sort_senders (sc_array_t * senders, sc_array_t * payload)
+{
+  int                *pair;
+  size_t              zz, num_senders = senders->elem_count;
+  sc_array_t         *pairs, *newindices;
+
+  if (sc_array_is_sorted (senders, sc_int_compare)) {
+    return;
+  }
+  if (payload == NULL) {
+    sc_array_sort (senders, sc_int_compare);
+    return;
+  }
+  SC_ASSERT (payload->elem_count == num_senders);
+
+  /* the senders are unique, so sorting pairs by the first int suffices */
+  pairs = sc_array_new_count (2 * sizeof (int), num_senders);
+  for (zz = 0; zz < num_senders; ++zz) {
+    pair = (int *) sc_array_index (pairs, zz);
+    pair[0] = *(int *) sc_array_index (senders, zz);
+    pair[1] = (int) zz;
+  }
+  sc_array_sort (pairs, sc_int_compare);
+  newindices = sc_array_new_count (sizeof (size_t), num_senders);
+  for (zz = 0; zz < num_senders; ++zz) {
+    pair = (int *) sc_array_index (pairs, zz);
+    *(int *) sc_array_index (senders, zz) = pair[0];
+    *(size_t *) sc_array_index_int (newindices, pair[1]) = zz;
+  }
+  sc_array_permute_blocked (payload, newindices, SC_NOTIFY_PERMUTE_BLOCK);
+  sc_array_destroy (newindices);
+  sc_array_destroy (pairs);
+}
+
 /** Complete sc_notify_payload() using old-fashioned sc_notify()-like function
  * */
 static void
@@ -288,6 +411,7 @@ sc_notify_payload_wrapper (sc_array_t * receivers, sc_array_t * senders,
     sc_MPI_Request     *sendreq, *recvreq;
     char               *cpayload = (char *) in_payload->array;
     char               *rpayload;
+    sc_array_t         *recv_buf;
     int                 j;
     int                 num_receivers = (int) receivers->elem_count;
     int                *ireceivers = (int *) receivers->array;
@@ -295,13 +419,10 @@ sc_notify_payload_wrapper (sc_array_t * receivers, sc_array_t * senders,
 
     sendreq = SC_ALLOC (sc_MPI_Request, (num_receivers + num_senders));
     recvreq = &sendreq[num_receivers];
-    if (out_payload) {
-      sc_array_resize (out_payload, (size_t) num_senders);
-      rpayload = (char *) out_payload->array;
-    }
-    else {
-      rpayload = SC_ALLOC (char, num_senders * msg_size);
-    }
+    recv_buf = out_payload ? out_payload :
+      sc_array_new (in_payload->elem_size);
+    sc_array_resize (recv_buf, (size_t) num_senders);
+    rpayload = (char *) recv_buf->array;
 
     for (j = 0; j < num_receivers; j++) {
       mpiret =
@@ -321,10 +442,7 @@ sc_notify_payload_wrapper (sc_array_t * receivers, sc_array_t * senders,
                       sc_MPI_STATUSES_IGNORE);
     SC_CHECK_MPI (mpiret);
     if (!out_payload) {
-      sc_array_reset (in_payload);
-      sc_array_resize (in_payload, num_senders);
-      memcpy ((char *) in_payload->array, rpayload, num_senders * msg_size);
-      SC_FREE (rpayload);
+      sc_notify_array_move (in_payload, recv_buf);
       out_payload = in_payload;
     }
     SC_FREE (sendreq);
@@ -339,38 +457,36 @@ sc_notify_payload_wrapper (sc_array_t * receivers, sc_array_t * senders,
     SC_FREE (isenders);
     senders = receivers;
   }
-  if (sorted && !sc_array_is_sorted (senders, sc_int_compare)) {
-    if (!out_payload) {
-      sc_array_sort (senders, sc_int_compare);
+  if (sorted) {
+    sc_notify_sort_senders (senders, out_payload);
+  }
+  SC_NOTIFY_FUNC_SHOT (notify, &snap);
+}
+
+/** Finish array logic after data is received.
+ * \param [in,out] senders  The sending ranks in the order of arrival.
+ * \param [in] recv_buf     NULL or the payload received in the same order.
+ *                          Either \a out_payload or a new array whose data
+ *                          is handed to \a in_payload.
+ */
+static void
+sc_notify_payload_cleanup (sc_array_t * senders, sc_array_t * recv_buf,
+                           sc_array_t * in_payload, sc_array_t * out_payload,
+                           int sorted)
+{
+  if (sorted) {
+    sc_notify_sort_senders (senders, recv_buf);
+  }
+  if (in_payload) {
+    if (recv_buf == NULL) {
+      sc_array_resize (out_payload ? out_payload : in_payload,
+                       senders->elem_count);
     }
-    else {
-      sc_array_t         *sorter;
-      size_t              msg_size = out_payload->elem_size;
-      int                 j;
-
-      sorter =
-        sc_array_new_count (sizeof (int) + msg_size, (size_t) num_senders);
-      for (j = 0; j < num_senders; j++) {
-        int                *entry = (int *) sc_array_index_int (sorter, j);
-        char               *payl =
-          (char *) sc_array_index_int (out_payload, j);
-
-        entry[0] = *((int *) sc_array_index_int (senders, (size_t) j));
-        memcpy ((char *) (&entry[1]), payl, msg_size);
-      }
-      sc_array_sort (sorter, sc_int_compare);
-      for (j = 0; j < num_senders; j++) {
-        int                *entry = (int *) sc_array_index_int (sorter, j);
-        char               *payl =
-          (char *) sc_array_index_int (out_payload, j);
-
-        *((int *) sc_array_index_int (senders, (size_t) j)) = entry[0];
-        memcpy (payl, (char *) (&entry[1]), msg_size);
-      }
-      sc_array_destroy (sorter);
+    else if (recv_buf != out_payload) {
+      SC_ASSERT (out_payload == NULL);
+      sc_notify_array_move (in_payload, recv_buf);
     }
   }
-  SC_NOTIFY_FUNC_SHOT (notify, &snap);
 }
 
 /** Complete sc_notify_payload() using a function that gives a census
@@ -390,9 +506,7 @@ sc_notify_payload_census (sc_array_t * receivers, sc_array_t * senders,
   int                *isenders = NULL;
   sc_array_t         *recv_buf;
   size_t              msg_size = 0;
-  size_t              stride;
   char               *cpayload = NULL;
-  char               *crecv;
   sc_MPI_Request     *sendreqs;
   sc_MPI_Comm         mpicomm;
   sc_flopinfo_t       snap;
@@ -414,17 +528,6 @@ sc_notify_payload_census (sc_array_t * receivers, sc_array_t * senders,
     msg_size = in_payload->elem_size;
     cpayload = (char *) in_payload->array;
   }
-  stride = sizeof (int) + msg_size;
-
-  recv_buf = NULL;
-  if (!msg_size && senders) {
-    recv_buf = senders;
-    sc_array_resize (senders, num_senders);
-  }
-  else {
-    recv_buf = sc_array_new_count (stride, num_senders);
-  }
-  crecv = (char *) recv_buf->array;
 
   sendreqs = SC_ALLOC (sc_MPI_Request, num_receivers);
   for (i = 0; i < num_receivers; i++) {
@@ -434,113 +537,37 @@ sc_notify_payload_census (sc_array_t * receivers, sc_array_t * senders,
                            &sendreqs[i]);
     SC_CHECK_MPI (mpiret);
   }
-  for (i = 0; i < num_senders; i++) {
-    sc_MPI_Status       status;
-
-    mpiret =
-      sc_MPI_Recv (&crecv[i * stride + sizeof (int)], msg_size, sc_MPI_BYTE,
-                   sc_MPI_ANY_SOURCE, SC_TAG_NOTIFY_CENSUS, mpicomm, &status);
-    SC_CHECK_MPI (mpiret);
-    *((int *) &crecv[i * stride]) = status.MPI_SOURCE;
-  }
-
-  if (sorted) {
-    sc_array_sort (recv_buf, sc_int_compare);
-  }
-
-  mpiret = sc_MPI_Waitall (num_receivers, sendreqs, sc_MPI_STATUSES_IGNORE);
-  SC_CHECK_MPI (mpiret);
-  SC_FREE (sendreqs);
 
-  if (!msg_size && senders) {
-    if (in_payload && out_payload == NULL) {
-      sc_array_reset (in_payload);
-      out_payload = in_payload;
-    }
-    if (out_payload) {
-      sc_array_resize (out_payload, num_senders);
-    }
-    SC_NOTIFY_FUNC_SHOT (notify, &snap);
-    return;
+  /* we know the number of senders and receive into the final arrays */
+  recv_buf = NULL;
+  if (msg_size) {
+    recv_buf = out_payload ? out_payload : sc_array_new (msg_size);
+    sc_array_resize (recv_buf, (size_t) num_senders);
   }
-
   if (!senders) {
     sc_array_reset (receivers);
     senders = receivers;
   }
   sc_array_resize (senders, (size_t) num_senders);
   isenders = (int *) senders->array;
+  for (i = 0; i < num_senders; i++) {
+    sc_MPI_Status       status;
 
-  if (in_payload && out_payload == NULL) {
-    sc_array_reset (in_payload);
-    out_payload = in_payload;
-  }
-  if (out_payload) {
-    sc_array_resize (out_payload, (size_t) num_senders);
-    cpayload = (char *) out_payload->array;
-    for (i = 0; i < num_senders; i++) {
-      isenders[i] = *((int *) &crecv[i * stride]);
-      memcpy (&cpayload[i * msg_size], &crecv[i * stride + sizeof (int)],
-              msg_size);
-    }
-  }
-  else {
-    for (i = 0; i < num_senders; i++) {
-      isenders[i] = *((int *) &crecv[i * stride]);
-    }
-  }
-
-  sc_array_destroy (recv_buf);
-  SC_NOTIFY_FUNC_SHOT (notify, &snap);
-}
-
-/** Finish array logic after data is received */
-static void
-sc_notify_payload_cleanup (sc_array_t * senders, sc_array_t * recv_buf,
-                           sc_array_t * in_payload, sc_array_t * out_payload,
-                           int sorted)
-{
-  int                 num_senders;
-  int                *isenders;
-  int                 i;
-  int                 msg_size = in_payload ? (int) in_payload->elem_size : 0;
-  char               *cpayload;
-
-  num_senders =
-    recv_buf ? (int) recv_buf->elem_count : (int) senders->elem_count;
-  sc_array_resize (senders, num_senders);
-  isenders = (int *) senders->array;
-
-  if (sorted) {
-    if (msg_size) {
-      sc_array_sort (recv_buf, sc_int_compare);
-      for (i = 0; i < num_senders; i++) {
-        int                *r = (int *) sc_array_index_int (recv_buf, i);
-
-        isenders[i] = r[0];
-      }
-    }
-    else {
-      sc_array_sort (senders, sc_int_compare);
-    }
+    mpiret =
+      sc_MPI_Recv (msg_size ? sc_array_index_int (recv_buf, i) : NULL,
+                   msg_size, sc_MPI_BYTE, sc_MPI_ANY_SOURCE,
+                   SC_TAG_NOTIFY_CENSUS, mpicomm, &status);
+    SC_CHECK_MPI (mpiret);
+    isenders[i] = status.MPI_SOURCE;
   }
 
-  if (in_payload) {
-    if (!out_payload) {
-      sc_array_reset (in_payload);
-      out_payload = in_payload;
-    }
-    sc_array_resize (out_payload, (size_t) num_senders);
-    cpayload = (char *) out_payload->array;
-    if (recv_buf != out_payload) {
-      for (i = 0; i < num_senders; i++) {
-        int                *r = (int *) sc_array_index_int (recv_buf, i);
+  mpiret = sc_MPI_Waitall (num_receivers, sendreqs, sc_MPI_STATUSES_IGNORE);
+  SC_CHECK_MPI (mpiret);
+  SC_FREE (sendreqs);
 
-        memcpy (&cpayload[msg_size * i], &r[1], (size_t) msg_size);
-      }
-      sc_array_destroy (recv_buf);
-    }
-  }
+  sc_notify_payload_cleanup (senders, recv_buf, in_payload, out_payload,
+                             sorted);
+  SC_NOTIFY_FUNC_SHOT (notify, &snap);
 }
 
 /** Complete sc_notify_payloadv() using sc_notify_payload()
@@ -767,15 +794,18 @@ sc_notify_payloadv_census (sc_array_t * receivers, sc_array_t * senders,
   SC_CHECK_MPI (mpiret);
 
   if (out_payload != recv_buf) {
-    if (!out_payload) {
-      sc_array_reset (in_payload);
-      out_payload = in_payload;
-    }
-    sc_array_resize (out_payload, recv_size);
     if (!sorted) {
-      sc_array_copy (out_payload, recv_buf);
+      /* hand the received data to the caller without copying */
+      SC_ASSERT (out_payload == NULL);
+      sc_notify_array_move (in_payload, recv_buf);
+      recv_buf = out_payload = in_payload;
     }
     else {
+      if (!out_payload) {
+        sc_array_reset (in_payload);
+        out_payload = in_payload;
+      }
+      sc_array_resize (out_payload, recv_size);
       sc_array_sort (first_senders, sc_int_compare);
       isenders = (int *) senders->array;
       cout = (char *) out_payload->array;
@@ -1062,6 +1092,117 @@ sc_notify_merge (sc_array_t * output, sc_array_t * input, sc_array_t * second,
   SC_ASSERT (ir == (int) second->elem_count);
 }
 
+/*
+ * Messages of the tree algorithms without payload may encode a record
+ * by runs of consecutive fromranks: (torank, -howmanyruns,
+ * listof(firstrank, runlength)).  A record is encoded only if this is
+ * shorter, such that dense patterns send a fraction of the integers.
+ */
+
+/** Append a record without payload to a message, encoded if shorter.
+ * \param [in,out] sendbuf  Integer array holding the message.
+ * \param [in] pint         Record (torank, howmanyfroms, listoffromranks).
+ */
+static void
+sc_notify_push_runs (sc_array_t * sendbuf, const int *pint)
+{
+  int                 numfroms, nruns;
+  int                 i, k;
+  int                *pout;
+
+  SC_ASSERT (sendbuf->elem_size == sizeof (int));
+
+  numfroms = pint[1];
+  SC_ASSERT (numfroms > 0);
+  nruns = 1;
+  for (i = 1; i < numfroms; ++i) {
+    if (pint[2 + i] != pint[1 + i] + 1) {
+      ++nruns;
+    }
+  }
+  if (2 * nruns >= numfroms) {
+    pout = (int *) sc_array_push_count (sendbuf, 2 + numfroms);
+    memcpy (pout, pint, (2 + numfroms) * sizeof (int));
+    return;
+  }
+
+  pout = (int *) sc_array_push_count (sendbuf, 2 + 2 * nruns);
+  pout[0] = pint[0];
+  pout[1] = -nruns;
+  k = 0;
+  for (i = 0; i < numfroms; ++i) {
+    if (i == 0 || pint[2 + i] != pint[1 + i] + 1) {
+      pout[2 + 2 * k] = pint[2 + i];
+      pout[3 + 2 * k] = 0;
+      ++k;
+    }
+    ++pout[1 + 2 * k];
+  }
+  SC_ASSERT (k == nruns);
+}
+
+/** Expand the encoded records of a received message in place.
+ * \param [in,out] array    Message by \ref sc_notify_push_runs on input,
+ *                          records without payload in plain form on output.
+ */
+static void
+sc_notify_expand_runs (sc_array_t * array)
+{
+  int                 i, k, l;
+  int                 num_in, numfroms;
+  int                 encoded;
+  int                *pint, *pout;
+  sc_array_t          plain;
+
+  SC_ASSERT (array->elem_size == sizeof (int));
+
+  /* most messages of sparse patterns are not encoded at all */
+  num_in = (int) array->elem_count;
+  encoded = 0;
+  for (i = 0; i < num_in;) {
+    pint = (int *) sc_array_index_int (array, i);
+    if (pint[1] < 0) {
+      encoded = 1;
+      break;
+    }
+    i += 2 + pint[1];
+  }
+  if (!encoded) {
+    return;
+  }
+
+  sc_array_init (&plain, sizeof (int));
+  sc_array_reserve (&plain, (size_t) num_in);
+  for (i = 0; i < num_in;) {
+    pint = (int *) sc_array_index_int (array, i);
+    if (pint[1] > 0) {
+      pout = (int *) sc_array_push_count (&plain, 2 + pint[1]);
+      memcpy (pout, pint, (2 + pint[1]) * sizeof (int));
+      i += 2 + pint[1];
+      continue;
+    }
+    SC_ASSERT (pint[1] < 0);
+    numfroms = 0;
+    for (k = 0; k < -pint[1]; ++k) {
+      SC_ASSERT (pint[3 + 2 * k] > 0);
+      numfroms += pint[3 + 2 * k];
+    }
+    pout = (int *) sc_array_push_count (&plain, 2 + numfroms);
+    pout[0] = pint[0];
+    pout[1] = numfroms;
+    pout += 2;
+    for (k = 0; k < -pint[1]; ++k) {
+      for (l = 0; l < pint[3 + 2 * k]; ++l) {
+        *pout++ = pint[2 + 2 * k] + l;
+      }
+    }
+    i += 2 - 2 * pint[1];
+  }
+  SC_ASSERT (i == num_in);
+  sc_array_reset (array);
+  *array = plain;
+}
+
 /*== SC_NOTIFY_ALLGATHER ==*/
 
 int
@@ -1077,6 +1218,7 @@ sc_notify_allgather (int *receivers, int num_receivers,
   int                *offsets_num_receivers;
   int                *all_receivers;
 
+  mpicomm = sc_mpi_comm_thread (mpicomm);
   mpiret = sc_MPI_Comm_size (mpicomm, &mpisize);
   SC_CHECK_MPI (mpiret);
   mpiret = sc_MPI_Comm_rank (mpicomm, &mpirank);
@@ -1138,7 +1280,7 @@ sc_notify_nary_get_widths (sc_notify_t * notify, int *ntop, int *nint,
   if (nint)
     *nint = notify->data.nary.nint;
   if (nbot)
-    *nint = notify->data.nary.nbot;
+    *nbot = notify->data.nary.nbot;
 }
 
 void
@@ -1324,8 +1466,13 @@ sc_notify_recursive_nary (const sc_notify_nary_t * nary, int level,
       topart = (torank % length) / lengthn;
       sendbuf = (sc_array_t *) sc_array_index_int
         (topart == mypart ? &recvbufs : &sendbufs, topart);
-      pout = (int *) sc_array_push_count (sendbuf, itemlen);
-      memcpy (pout, pint, itemlen * sizeof (int));
+      if (topart != mypart && nary->npay == 0) {
+        sc_notify_push_runs (sendbuf, pint);
+      }
+      else {
+        pout = (int *) sc_array_push_count (sendbuf, itemlen);
+        memcpy (pout, pint, itemlen * sizeof (int));
+      }
       i += itemlen;
     }
     SC_ASSERT (i == num_ta);
@@ -1358,31 +1505,26 @@ sc_notify_recursive_nary (const sc_notify_nary_t * nary, int level,
     }
     SC_ASSERT (i == nsent);
 
-    /* receive all messages */
+    /* receive all messages by source: a message of a later call
+       from a faster process must not be taken for one of this call */
     for (i = 0; i < nrecv; ++i) {
-      mpiret = sc_MPI_Probe (sc_MPI_ANY_SOURCE, tag, mpicomm, &instatus);
-      SC_CHECK_MPI (mpiret);
-      source = instatus.MPI_SOURCE;
+      j = i < mypart ? i : i + 1;
+      source = j < divn ? me + (j - mypart) * lengthn :
+        start + length + (j - divn) * lengthn + (me - start) % lengthn;
       SC_ASSERT (start <= source && source < start + 2 * length - 1);
+      SC_ASSERT (source != me && (source - me + length) % lengthn == 0);
+      SC_ASSERT (source >= start + length ||
+                 j == mypart + (source - me) / lengthn);
+      SC_ASSERT (source < start + length ||
+                 j == divn + (source % length) / lengthn);
+      mpiret = sc_MPI_Probe (source, tag, mpicomm, &instatus);
+      SC_CHECK_MPI (mpiret);
 
 #if 0
       SC_LDEBUGF ("Length %d lengthn %d me %d source %d\n",
                   length, lengthn, me, source);
 #endif
 
-      SC_ASSERT (source != me && (source - me + length) % lengthn == 0);
-      if (source < me) {
-        j = mypart - (me - source) / lengthn;
-        SC_ASSERT (0 <= j && j < mypart);
-      }
-      else if (source < start + length) {
-        j = mypart + (source - me) / lengthn;
-        SC_ASSERT (mypart < j && j < divn);
-      }
-      else {
-        j = divn + (source % length) / lengthn;
-        SC_ASSERT (divn <= j && j < nrecv + 1);
-      }
       mpiret = sc_MPI_Get_count (&instatus, sc_MPI_INT, &count);
       SC_CHECK_MPI (mpiret);
       recvbuf = (sc_array_t *) sc_array_index_int (&recvbufs, j);
@@ -1390,6 +1532,9 @@ sc_notify_recursive_nary (const sc_notify_nary_t * nary, int level,
       mpiret = sc_MPI_Recv (recvbuf->array, count, sc_MPI_INT, source,
                             tag, mpicomm, sc_MPI_STATUS_IGNORE);
       SC_CHECK_MPI (mpiret);
+      if (nary->npay == 0) {
+        sc_notify_expand_runs (recvbuf);
+      }
     }
 
     /* run binary tree for a recursive merge of received data arrays */
@@ -1925,10 +2070,7 @@ sc_notify_payload_nbx (sc_array_t * receivers, sc_array_t * senders,
     senders = receivers;
   }
 
-  if (sorted && msg_size) {
-    recv_buf = sc_array_new ((size_t) msg_size + sizeof (int));
-  }
-  else if (msg_size) {
+  if (msg_size) {
     if (out_payload) {
       recv_buf = out_payload;
     }
@@ -1950,15 +2092,10 @@ sc_notify_payload_nbx (sc_array_t * receivers, sc_array_t * senders,
       char               *rc = NULL;
       j = status.MPI_SOURCE;
 
-      if (sorted && msg_size) {
-        r = (int *) sc_array_push (recv_buf);
-      }
-      else {
-        r = (int *) sc_array_push (senders);
-      }
+      r = (int *) sc_array_push (senders);
       r[0] = j;
       if (msg_size) {
-        rc = sorted ? (char *) &r[1] : (char *) sc_array_push (recv_buf);
+        rc = (char *) sc_array_push (recv_buf);
       }
 
       mpiret =
@@ -2113,11 +2250,7 @@ sc_notify_payloadv_nbx (sc_array_t * receivers, sc_array_t * senders,
   SC_FREE (sendreqs);
 
   if (!out_payload) {
-    sc_array_reset (in_payload);
-    out_payload = in_payload;
-    sc_array_resize (out_payload, recv_buf->elem_count);
-    sc_array_copy (out_payload, recv_buf);
-    sc_array_destroy (recv_buf);
+    sc_notify_array_move (in_payload, recv_buf);
   }
   SC_NOTIFY_FUNC_SHOT (notify, &snap);
 #else
@@ -2180,14 +2313,14 @@ sc_notify_payload_ranges (sc_array_t * receivers, sc_array_t * senders,
   sc_MPI_Comm         comm;
   int                 rank, size;
   int                 mpiret;
-  int                *all_ranges;
   int                 num_receivers_ranges = 0, num_senders_ranges = 0;
   int                *procs;
   int                *ireceivers;
-  int                 i;
+  int                 i, j;
   int                 first_peer, last_peer;
   int                *receiver_ranks_ranges;
   int                *sender_ranks_ranges;
+  sc_array_t          sender_array;
   sc_array_t         *sendbuf;
   sc_array_t         *recvbuf;
   size_t              msg_size;
@@ -2209,7 +2342,6 @@ sc_notify_payload_ranges (sc_array_t * receivers, sc_array_t * senders,
 
   my_ranges = SC_ALLOC (int, 2 * max_ranges);
   receiver_ranks_ranges = SC_ALLOC (int, size);
-  sender_ranks_ranges = SC_ALLOC (int, size);
   procs = SC_ALLOC_ZERO (int, size);
   num_procs = (int) receivers->elem_count;
   ireceivers = (int *) receivers->array;
@@ -2233,15 +2365,26 @@ sc_notify_payload_ranges (sc_array_t * receivers, sc_array_t * senders,
   maxpeers = first_peer;
   maxwin = last_peer;
   (void) sc_ranges_adaptive (package_id, comm, procs, &maxpeers, &maxwin,
-                             max_ranges, my_ranges, &all_ranges);
-  sc_ranges_decode (size, rank, maxwin, all_ranges,
-                    &num_receivers_ranges, receiver_ranks_ranges,
-                    &num_senders_ranges, sender_ranks_ranges);
+                             max_ranges, my_ranges, NULL);
+
+  /* the receivers are those in the local ranges except self */
+  for (i = 0; i < maxwin && my_ranges[2 * i] >= 0; ++i) {
+    for (j = my_ranges[2 * i]; j <= my_ranges[2 * i + 1]; ++j) {
+      if (j != rank) {
+        receiver_ranks_ranges[num_receivers_ranges++] = j;
+      }
+    }
+  }
+
+  /* find the senders without gathering everybody's ranges */
+  sc_array_init (&sender_array, sizeof (int));
+  sc_ranges_senders (comm, maxwin, my_ranges, &sender_array);
+  num_senders_ranges = (int) sender_array.elem_count;
+  sender_ranks_ranges = (int *) sender_array.array;
 #ifdef SC_ENABLE_DEBUG
   sc_ranges_statistics (package_id, SC_LP_STATISTICS,
                         comm, num_procs, procs, rank, max_ranges, my_ranges);
 #endif
-  SC_FREE (all_ranges);
   SC_FREE (my_ranges);
   msg_size = sizeof (int);
   if (in_payload) {
@@ -2354,7 +2497,7 @@ sc_notify_payload_ranges (sc_array_t * receivers, sc_array_t * senders,
   SC_FREE (sendreqs);
   sc_array_destroy (recvbuf);
   sc_array_destroy (sendbuf);
-  SC_FREE (sender_ranks_ranges);
+  sc_array_reset (&sender_array);
   SC_FREE (receiver_ranks_ranges);
   SC_NOTIFY_FUNC_SHOT (notify, &snap);
 }
@@ -2373,6 +2516,7 @@ sc_notify_superset_set_callback (sc_notify_t * notify,
 #endif
   notify->data.superset.compute_superset = compute_superset;
   notify->data.superset.ctx = ctx;
+  sc_notify_superset_invalidate (notify);
 }
 
 void
@@ -2390,43 +2534,163 @@ sc_notify_superset_get_callback (sc_notify_t * notify,
 }
 
 static void
-sc_notify_payload_superset (sc_array_t * receivers, sc_array_t * senders,
-                            sc_array_t * in_payload, sc_array_t * out_payload,
-                            int sorted, sc_notify_t * notify)
+sc_notify_superset_init (sc_notify_t * notify)
 {
-  int                 num_receivers, num_senders = 0;
-  int                 num_extra_receivers;
-  int                 num_super_senders;
-  int                *ireceivers, i, j;
-  int                 mpiret, rank, size;
-  char               *cpayload = NULL;
-  int                 msg_size = 0;
-  sc_MPI_Request     *sendreqs, *extrasendreqs;
-  sc_MPI_Comm         comm;
-  int                 queue;
-  sc_array_t         *recv_buf = NULL;
-  sc_compute_superset_t compute_superset = NULL;
-  void               *ctx = NULL;
-  sc_array_t         *extra_receivers, *super_senders;
-  sc_flopinfo_t       snap;
+  sc_notify_superset_t *superset = &notify->data.superset;
 
-  SC_NOTIFY_FUNC_SNAP (notify, &snap);
-  comm = sc_notify_get_comm (notify);
-  mpiret = sc_MPI_Comm_size (comm, &size);
-  SC_CHECK_MPI (mpiret);
-  mpiret = sc_MPI_Comm_rank (comm, &rank);
-  SC_CHECK_MPI (mpiret);
+  memset (superset, 0, sizeof (sc_notify_superset_t));
+  sc_array_init (&superset->super_receivers, sizeof (int));
+  sc_array_init (&superset->super_senders, sizeof (int));
+}
 
-  num_receivers = (int) receivers->elem_count;
-  ireceivers = (int *) receivers->array;
-  if (in_payload) {
-    msg_size = (int) in_payload->elem_size;
-    cpayload = (char *) in_payload->array;
-  }
+/** Free the cached superset. */
+static void
+sc_notify_superset_reset (sc_notify_t * notify)
+{
+  sc_notify_superset_t *superset = &notify->data.superset;
 
-  sendreqs = SC_ALLOC (sc_MPI_Request, num_receivers);
+  sc_array_reset (&superset->super_receivers);
+  sc_array_reset (&superset->super_senders);
+  superset->cached = 0;
+}
 
-  for (i = 0; i < num_receivers; i++) {
+int
+sc_notify_superset_get_cache (sc_notify_t * notify)
+{
+  SC_ASSERT (sc_notify_get_type (notify) == SC_NOTIFY_SUPERSET);
+  return notify->data.superset.cache;
+}
+
+void
+sc_notify_superset_set_cache (sc_notify_t * notify, int cache)
+{
+  SC_ASSERT (sc_notify_get_type (notify) == SC_NOTIFY_SUPERSET);
+  notify->data.superset.cache = cache;
+  if (!cache) {
+    sc_notify_superset_invalidate (notify);
+  }
+}
+
+void
+sc_notify_superset_invalidate (sc_notify_t * notify)
+{
+  SC_ASSERT (sc_notify_get_type (notify) == SC_NOTIFY_SUPERSET);
+  sc_notify_superset_reset (notify);
+}
+
+/** Store the result of the superset callback in the notify object.
+ * \param [in,out] superset        Superset data without a valid cache.
+ * \param [in] receivers           Receivers passed to the callback.
+ * \param [in] extra_receivers     Extra receivers it has returned.
+ * \param [in] super_senders       Superset of senders it has returned.
+ */
+static void
+sc_notify_superset_store (sc_notify_superset_t * superset,
+                          sc_array_t * receivers,
+                          sc_array_t * extra_receivers,
+                          sc_array_t * super_senders)
+{
+  sc_array_t         *all = &superset->super_receivers;
+
+  SC_ASSERT (!superset->cached);
+
+  sc_array_resize (all, receivers->elem_count +
+                   extra_receivers->elem_count);
+  sc_array_copy_into (all, 0, receivers);
+  sc_array_copy_into (all, receivers->elem_count, extra_receivers);
+  sc_array_sort (all, sc_int_compare);
+
+  sc_array_copy (&superset->super_senders, super_senders);
+  sc_array_sort (&superset->super_senders, sc_int_compare);
+  superset->cached = 1;
+}
+
+/** Find the extra receivers from the cached superset.
+ * \param [in] superset            Superset data with a valid cache.
+ * \param [in] receivers           The receivers of this call must be
+ *                                  contained in the cached superset.
+ * \param [out] extra_receivers    Cached receivers not in \a receivers.
+ */
+static void
+sc_notify_superset_extra (sc_notify_superset_t * superset,
+                          sc_array_t * receivers,
+                          sc_array_t * extra_receivers)
+{
+  size_t              zz, zr;
+  int                 rec;
+  sc_array_t         *sorted;
+
+  SC_ASSERT (superset->cached);
+  SC_ASSERT (extra_receivers->elem_count == 0);
+
+  if (sc_array_is_sorted (receivers, sc_int_compare)) {
+    sorted = receivers;
+  }
+  else {
+    sorted = sc_array_new_count (sizeof (int), receivers->elem_count);
+    sc_array_copy (sorted, receivers);
+    sc_array_sort (sorted, sc_int_compare);
+  }
+
+  /* both lists are sorted and we walk them in parallel */
+  zr = 0;
+  for (zz = 0; zz < superset->super_receivers.elem_count; ++zz) {
+    rec = *(int *) sc_array_index (&superset->super_receivers, zz);
+    if (zr < sorted->elem_count &&
+        *(int *) sc_array_index (sorted, zr) == rec) {
+      ++zr;
+    }
+    else {
+      *(int *) sc_array_push (extra_receivers) = rec;
+    }
+  }
+  SC_CHECK_ABORT (zr == sorted->elem_count,
+                  "Receivers not contained in the cached superset");
+
+  if (sorted != receivers) {
+    sc_array_destroy (sorted);
+  }
+}
+
+static void
+sc_notify_payload_superset (sc_array_t * receivers, sc_array_t * senders,
+                            sc_array_t * in_payload, sc_array_t * out_payload,
+                            int sorted, sc_notify_t * notify)
+{
+  int                 num_receivers, num_senders = 0;
+  int                 num_extra_receivers;
+  int                 num_super_senders;
+  int                *ireceivers, i, j;
+  int                 mpiret, rank, size;
+  char               *cpayload = NULL;
+  int                 msg_size = 0;
+  sc_MPI_Request     *sendreqs, *extrasendreqs;
+  sc_MPI_Comm         comm;
+  int                 queue;
+  sc_array_t         *recv_buf = NULL;
+  sc_compute_superset_t compute_superset = NULL;
+  void               *ctx = NULL;
+  sc_array_t         *extra_receivers, *super_senders;
+  sc_notify_superset_t *superset = &notify->data.superset;
+  sc_flopinfo_t       snap;
+
+  SC_NOTIFY_FUNC_SNAP (notify, &snap);
+  comm = sc_notify_get_comm (notify);
+  mpiret = sc_MPI_Comm_size (comm, &size);
+  SC_CHECK_MPI (mpiret);
+  mpiret = sc_MPI_Comm_rank (comm, &rank);
+  SC_CHECK_MPI (mpiret);
+
+  num_receivers = (int) receivers->elem_count;
+  ireceivers = (int *) receivers->array;
+  if (in_payload) {
+    msg_size = (int) in_payload->elem_size;
+    cpayload = (char *) in_payload->array;
+  }
+
+  sendreqs = SC_ALLOC (sc_MPI_Request, num_receivers);
+
+  for (i = 0; i < num_receivers; i++) {
     char               *buf = msg_size ? &cpayload[i * msg_size] : NULL;
 
     j = ireceivers[i];
@@ -2435,12 +2699,26 @@ sc_notify_payload_superset (sc_array_t * receivers, sc_array_t * senders,
     SC_CHECK_MPI (mpiret);
   }
 
-  sc_notify_superset_get_callback (notify, &compute_superset, (void *) &ctx);
-  SC_ASSERT (compute_superset);
   extra_receivers = sc_array_new (sizeof (int));
-  super_senders = sc_array_new (sizeof (int));
-  (*compute_superset) (receivers, extra_receivers, super_senders, notify,
-                       ctx);
+  if (superset->cached) {
+    /* the steady state costs no more than the point-to-point messages */
+    sc_notify_superset_extra (superset, receivers, extra_receivers);
+    super_senders = &superset->super_senders;
+  }
+  else {
+    sc_notify_superset_get_callback (notify, &compute_superset,
+                                     (void *) &ctx);
+    SC_ASSERT (compute_superset);
+    super_senders = sc_array_new (sizeof (int));
+    (*compute_superset) (receivers, extra_receivers, super_senders, notify,
+                         ctx);
+    if (superset->cache) {
+      sc_notify_superset_store (superset, receivers, extra_receivers,
+                                super_senders);
+      sc_array_destroy (super_senders);
+      super_senders = &superset->super_senders;
+    }
+  }
   num_extra_receivers = (int) extra_receivers->elem_count;
 
   extrasendreqs = SC_ALLOC (sc_MPI_Request, num_extra_receivers);
@@ -2454,7 +2732,9 @@ sc_notify_payload_superset (sc_array_t * receivers, sc_array_t * senders,
   }
 
 #ifdef SC_ENABLE_DEBUG
-  sc_array_sort (super_senders, sc_int_compare);
+  if (super_senders != &superset->super_senders) {
+    sc_array_sort (super_senders, sc_int_compare);
+  }
 #endif
   num_super_senders = (int) super_senders->elem_count;
 
@@ -2466,22 +2746,14 @@ sc_notify_payload_superset (sc_array_t * receivers, sc_array_t * senders,
   sc_array_truncate (senders);
 
   if (msg_size) {
-    if (sorted) {
-      recv_buf =
-        sc_array_new_count (msg_size + sizeof (int),
-                            (size_t) num_super_senders);
-      sc_array_truncate (recv_buf);
+    if (out_payload) {
+      recv_buf = out_payload;
     }
     else {
-      if (out_payload) {
-        recv_buf = out_payload;
-      }
-      else {
-        recv_buf = sc_array_new (msg_size);
-      }
-      sc_array_resize (recv_buf, (size_t) num_super_senders);
-      sc_array_truncate (recv_buf);
+      recv_buf = sc_array_new (msg_size);
     }
+    sc_array_resize (recv_buf, (size_t) num_super_senders);
+    sc_array_truncate (recv_buf);
   }
 
   for (queue = num_super_senders; queue > 0;) {
@@ -2498,15 +2770,9 @@ sc_notify_payload_superset (sc_array_t * receivers, sc_array_t * senders,
 
       j = status.MPI_SOURCE;
       SC_ASSERT (sc_array_bsearch (super_senders, &j, sc_int_compare) >= 0);
-      if (sorted && msg_size) {
-        r = (int *) sc_array_push (recv_buf);
-        c = (char *) &r[1];
-      }
-      else {
-        r = (int *) sc_array_push (senders);
-        if (msg_size) {
-          c = (char *) sc_array_push (recv_buf);
-        }
+      r = (int *) sc_array_push (senders);
+      if (msg_size) {
+        c = (char *) sc_array_push (recv_buf);
       }
       r[0] = j;
       mpiret =
@@ -2541,13 +2807,312 @@ sc_notify_payload_superset (sc_array_t * receivers, sc_array_t * senders,
   SC_CHECK_MPI (mpiret);
   SC_FREE (sendreqs);
   sc_array_destroy (extra_receivers);
-  sc_array_destroy (super_senders);
+  if (super_senders != &superset->super_senders) {
+    sc_array_destroy (super_senders);
+  }
 
   sc_notify_payload_cleanup (senders, recv_buf, in_payload, out_payload,
                              sorted);
   SC_NOTIFY_FUNC_SHOT (notify, &snap);
 }
 
+/*== SC_NOTIFY_HIERARCHICAL ==*/
+
+sc_notify_type_t
+sc_notify_hierarchical_get_type (sc_notify_t * notify)
+{
+  SC_ASSERT (notify->type == SC_NOTIFY_HIERARCHICAL);
+  return notify->data.hierarchical.inter_type;
+}
+
+void
+sc_notify_hierarchical_set_type (sc_notify_t * notify,
+                                 sc_notify_type_t inter_type)
+{
+  SC_ASSERT (notify->type == SC_NOTIFY_HIERARCHICAL);
+  SC_ASSERT (sc_notify_supports_type (inter_type));
+  SC_ASSERT (inter_type != SC_NOTIFY_SUPERSET &&
+             inter_type != SC_NOTIFY_HIERARCHICAL);
+
+  if (notify->data.hierarchical.inter_type != inter_type) {
+    sc_notify_hierarchical_reset (notify);
+    notify->data.hierarchical.inter_type = inter_type;
+  }
+}
+
+static void
+sc_notify_hierarchical_init (sc_notify_t * notify)
+{
+  memset (&notify->data.hierarchical, 0, sizeof (sc_notify_hierarchical_t));
+  notify->data.hierarchical.inter_type = SC_NOTIFY_PEX;
+}
+
+/** Free the node table and the inter-node controller. */
+static void
+sc_notify_hierarchical_reset (sc_notify_t * notify)
+{
+  sc_notify_hierarchical_t *hier = &notify->data.hierarchical;
+
+  if (hier->inter != NULL) {
+    sc_notify_destroy (hier->inter);
+    hier->inter = NULL;
+  }
+  SC_FREE (hier->nodes);
+  hier->nodes = NULL;
+  hier->ready = 0;
+}
+
+/** Look up the node communicators and update the data depending on them.
+ * On output, the intranode member is sc_MPI_COMM_NULL if there are none.
+ * Otherwise the inter-node controller is NULL on all but the leaders.
+ */
+static void
+sc_notify_hierarchical_setup (sc_notify_t * notify)
+{
+  int                 mpiret, intrarank, mine[2];
+  int                 mpisize;
+  sc_MPI_Comm         intranode, internode;
+  sc_notify_hierarchical_t *hier = &notify->data.hierarchical;
+
+  sc_mpi_comm_get_node_comms (notify->mpicomm, &intranode, &internode);
+  if (hier->ready &&
+      hier->intranode == intranode && hier->internode == internode) {
+    return;
+  }
+  sc_notify_hierarchical_reset (notify);
+  hier->intranode = intranode;
+  hier->internode = internode;
+  hier->ready = 1;
+
+  if (intranode == sc_MPI_COMM_NULL) {
+    hier->inter = sc_notify_new (notify->mpicomm);
+    sc_notify_set_type (hier->inter, hier->inter_type);
+    sc_notify_set_stats (hier->inter, notify->stats);
+    return;
+  }
+
+  /* for every rank store the rank of its leader among the leaders
+     and its rank within the node */
+  mpiret = sc_MPI_Comm_rank (intranode, &intrarank);
+  SC_CHECK_MPI (mpiret);
+  if (intrarank == 0) {
+    mpiret = sc_MPI_Comm_rank (internode, &mine[0]);
+    SC_CHECK_MPI (mpiret);
+    hier->inter = sc_notify_new (internode);
+    sc_notify_set_type (hier->inter, hier->inter_type);
+    sc_notify_set_stats (hier->inter, notify->stats);
+  }
+  mpiret = sc_MPI_Bcast (&mine[0], 1, sc_MPI_INT, 0, intranode);
+  SC_CHECK_MPI (mpiret);
+  mine[1] = intrarank;
+  mpiret = sc_MPI_Comm_size (notify->mpicomm, &mpisize);
+  SC_CHECK_MPI (mpiret);
+  hier->nodes = SC_ALLOC (int, 2 * mpisize);
+  mpiret = sc_MPI_Allgather (mine, 2, sc_MPI_INT, hier->nodes, 2,
+                             sc_MPI_INT, notify->mpicomm);
+  SC_CHECK_MPI (mpiret);
+}
+
+/** Order records of receiver, sender and payload by their sender. */
+static int
+sc_notify_hierarchical_compare (const void *v1, const void *v2)
+{
+  return sc_int_compare ((const int *) v1 + 1, (const int *) v2 + 1);
+}
+
+static void
+sc_notify_payload_hierarchical (sc_array_t * receivers, sc_array_t * senders,
+                                sc_array_t * in_payload,
+                                sc_array_t * out_payload,
+                                sc_notify_t * notify)
+{
+  int                 i, j;
+  int                 mpiret, mpirank;
+  int                 intrasize, intrarank;
+  int                 num_receivers, num_records, stride;
+  int                 count, *counts = NULL, *displs = NULL;
+  int                *ireceivers, *isenders, *nodes;
+  int                *sendbuf, *gathered = NULL, *scattered = NULL;
+  size_t              msg_size, record_size;
+  sc_array_t         *records;
+  sc_flopinfo_t       snap;
+  sc_notify_hierarchical_t *hier = &notify->data.hierarchical;
+
+  SC_NOTIFY_FUNC_SNAP (notify, &snap);
+
+  sc_notify_hierarchical_setup (notify);
+  if (hier->intranode == sc_MPI_COMM_NULL) {
+    sc_notify_payload (receivers, senders, in_payload, out_payload, 1,
+                       hier->inter);
+    SC_NOTIFY_FUNC_SHOT (notify, &snap);
+    return;
+  }
+  nodes = hier->nodes;
+
+  mpiret = sc_MPI_Comm_rank (notify->mpicomm, &mpirank);
+  SC_CHECK_MPI (mpiret);
+  mpiret = sc_MPI_Comm_size (hier->intranode, &intrasize);
+  SC_CHECK_MPI (mpiret);
+  mpiret = sc_MPI_Comm_rank (hier->intranode, &intrarank);
+  SC_CHECK_MPI (mpiret);
+
+  /* a record holds the receiver, the sender and the padded payload */
+  msg_size = in_payload != NULL ? in_payload->elem_size : 0;
+  stride = 2 + (int) ((msg_size + sizeof (int) - 1) / sizeof (int));
+  record_size = stride * sizeof (int);
+  num_receivers = (int) receivers->elem_count;
+  ireceivers = (int *) receivers->array;
+  sendbuf = SC_ALLOC_ZERO (int, stride * num_receivers);
+  for (i = 0; i < num_receivers; i++) {
+    sendbuf[stride * i + 0] = ireceivers[i];
+    sendbuf[stride * i + 1] = mpirank;
+    if (msg_size > 0) {
+      memcpy (&sendbuf[stride * i + 2], sc_array_index_int (in_payload, i),
+              msg_size);
+    }
+  }
+
+  /* the leader collects the records of its node */
+  count = stride * num_receivers;
+  if (intrarank == 0) {
+    counts = SC_ALLOC (int, 2 * intrasize);
+    displs = counts + intrasize;
+  }
+  mpiret = sc_MPI_Gather (&count, 1, sc_MPI_INT, counts, 1, sc_MPI_INT, 0,
+                          hier->intranode);
+  SC_CHECK_MPI (mpiret);
+  if (intrarank == 0) {
+    for (count = 0, i = 0; i < intrasize; i++) {
+      displs[i] = count;
+      count += counts[i];
+    }
+    gathered = SC_ALLOC (int, count);
+  }
+  mpiret = sc_MPI_Gatherv (sendbuf, stride * num_receivers, sc_MPI_INT,
+                           gathered, counts, displs, sc_MPI_INT, 0,
+                           hier->intranode);
+  SC_CHECK_MPI (mpiret);
+  SC_FREE (sendbuf);
+
+  if (intrarank == 0) {
+    int                 num_nodes, num_inter, *nodecounts;
+    int                *ooffsets;
+    sc_array_t         *irecv, *isend, *ipay, *opay, *ioff, *ooff;
+
+    /* sort the records by receiving node with one message per node */
+    num_records = count / stride;
+    mpiret = sc_MPI_Comm_size (hier->internode, &num_nodes);
+    SC_CHECK_MPI (mpiret);
+    nodecounts = SC_ALLOC_ZERO (int, num_nodes);
+    for (i = 0; i < num_records; i++) {
+      ++nodecounts[nodes[2 * gathered[stride * i]]];
+    }
+    irecv = sc_array_new (sizeof (int));
+    ioff = sc_array_new (sizeof (int));
+    *(int *) sc_array_push (ioff) = 0;
+    for (count = 0, j = 0; j < num_nodes; j++) {
+      if (nodecounts[j] > 0) {
+        *(int *) sc_array_push (irecv) = j;
+        *(int *) sc_array_push (ioff) = count + nodecounts[j];
+      }
+      i = nodecounts[j];
+      nodecounts[j] = count;
+      count += i;
+    }
+    ipay = sc_array_new_count (record_size, (size_t) num_records);
+    for (i = 0; i < num_records; i++) {
+      memcpy (sc_array_index_int
+              (ipay, nodecounts[nodes[2 * gathered[stride * i]]]++),
+              &gathered[stride * i], record_size);
+    }
+    SC_FREE (nodecounts);
+    SC_FREE (gathered);
+
+    /* exchange the records among the leaders */
+    isend = sc_array_new (sizeof (int));
+    opay = sc_array_new (record_size);
+    ooff = sc_array_new (sizeof (int));
+    sc_notify_payloadv (irecv, isend, ipay, opay, ioff, ooff, 0,
+                        hier->inter);
+    num_inter = (int) isend->elem_count;
+    ooffsets = (int *) ooff->array;
+    num_records = ooffsets[num_inter];
+    sc_array_destroy (irecv);
+    sc_array_destroy (isend);
+    sc_array_destroy (ipay);
+    sc_array_destroy (ioff);
+    sc_array_destroy (ooff);
+
+    /* sort the records by their receiver within the node */
+    for (i = 0; i < intrasize; i++) {
+      counts[i] = 0;
+    }
+    for (i = 0; i < num_records; i++) {
+      j = *(int *) sc_array_index_int (opay, i);
+      SC_ASSERT (nodes[2 * j] == nodes[2 * mpirank]);
+      counts[nodes[2 * j + 1]] += stride;
+    }
+    for (count = 0, i = 0; i < intrasize; i++) {
+      displs[i] = count;
+      count += counts[i];
+    }
+    gathered = SC_ALLOC (int, count);
+    for (i = 0; i < num_records; i++) {
+      j = *(int *) sc_array_index_int (opay, i);
+      memcpy (&gathered[displs[nodes[2 * j + 1]]],
+              sc_array_index_int (opay, i), record_size);
+      displs[nodes[2 * j + 1]] += stride;
+    }
+    for (i = 0; i < intrasize; i++) {
+      displs[i] -= counts[i];
+    }
+    sc_array_destroy (opay);
+  }
+
+  /* the leader distributes the records to the receivers in its node */
+  mpiret = sc_MPI_Scatter (counts, 1, sc_MPI_INT, &count, 1, sc_MPI_INT, 0,
+                           hier->intranode);
+  SC_CHECK_MPI (mpiret);
+  scattered = SC_ALLOC (int, count);
+  mpiret = sc_MPI_Scatterv (gathered, counts, displs, sc_MPI_INT,
+                            scattered, count, sc_MPI_INT, 0,
+                            hier->intranode);
+  SC_CHECK_MPI (mpiret);
+  if (intrarank == 0) {
+    SC_FREE (counts);
+    SC_FREE (gathered);
+  }
+
+  /* the senders are output in order */
+  num_records = count / stride;
+  records = sc_array_new_data (scattered, record_size, (size_t) num_records);
+  sc_array_sort (records, sc_notify_hierarchical_compare);
+  if (!senders) {
+    sc_array_reset (receivers);
+    senders = receivers;
+  }
+  sc_array_resize (senders, (size_t) num_records);
+  isenders = (int *) senders->array;
+  if (in_payload != NULL) {
+    if (out_payload == NULL) {
+      sc_array_reset (in_payload);
+      out_payload = in_payload;
+    }
+    sc_array_resize (out_payload, (size_t) num_records);
+  }
+  for (i = 0; i < num_records; i++) {
+    SC_ASSERT (scattered[stride * i] == mpirank);
+    isenders[i] = scattered[stride * i + 1];
+    if (msg_size > 0) {
+      memcpy (sc_array_index_int (out_payload, i),
+              &scattered[stride * i + 2], msg_size);
+    }
+  }
+  sc_array_destroy (records);
+  SC_FREE (scattered);
+  SC_NOTIFY_FUNC_SHOT (notify, &snap);
+}
+
 /*== SC_NOTIFY_BINARY ==*/
 
 /** Internally used function to execute the sc_notify recursion.
@@ -2574,7 +3139,7 @@ sc_notify_recursive (sc_MPI_Comm mpicomm, int start, int me, int length,
 #endif
   int                 peer, peer2, source;
   int                 tag, count;
-  int                *pint, *pout;
+  int                *pint;
   sc_array_t         *sendbuf, *recvbuf, morebuf;
   sc_MPI_Request      outrequest;
   sc_MPI_Status       instatus;
@@ -2635,8 +3200,7 @@ sc_notify_recursive (sc_MPI_Comm mpicomm, int start, int me, int length,
         SC_ASSERT (numfroms > 0);
         if (torank % length != me % length) {
           /* this set needs to be sent and is marked invalid in the array */
-          pout = (int *) sc_array_push_count (sendbuf, 2 + numfroms);
-          memcpy (pout, pint, (2 + numfroms) * sizeof (int));
+          sc_notify_push_runs (sendbuf, pint);
           pint[0] = -1;
         }
         else {
@@ -2662,6 +3226,7 @@ sc_notify_recursive (sc_MPI_Comm mpicomm, int start, int me, int length,
       mpiret = sc_MPI_Recv (recvbuf->array, count, sc_MPI_INT, source,
                             tag, mpicomm, sc_MPI_STATUS_IGNORE);
       SC_CHECK_MPI (mpiret);
+      sc_notify_expand_runs (recvbuf);
 
       if (peer2 >= 0) {
         /* merge the owned and received arrays */
@@ -2679,6 +3244,7 @@ sc_notify_recursive (sc_MPI_Comm mpicomm, int start, int me, int length,
         mpiret = sc_MPI_Recv (recvbuf->array, count, sc_MPI_INT, source,
                               tag, mpicomm, sc_MPI_STATUS_IGNORE);
         SC_CHECK_MPI (mpiret);
+        sc_notify_expand_runs (recvbuf);
 
         /* merge the second received array */
         sc_notify_merge (array, &morebuf, recvbuf, 0);
@@ -2734,6 +3300,7 @@ sc_notify (int *receivers, int num_receivers,
   int                 pow2length;
   sc_array_t          array;
 
+  mpicomm = sc_mpi_comm_thread (mpicomm);
   mpiret = sc_MPI_Comm_size (mpicomm, &mpisize);
   SC_CHECK_MPI (mpiret);
   mpiret = sc_MPI_Comm_rank (mpicomm, &mpirank);
@@ -2749,7 +3316,9 @@ sc_notify (int *receivers, int num_receivers,
                         mpisize, mpirank);
 
   /* execute the recursive algorithm */
+  sc_mpi_profile_enter (SC_MPI_CALLER_NOTIFY);
   sc_notify_recursive (mpicomm, 0, mpirank, pow2length, mpisize, &array);
+  sc_mpi_profile_leave ();
 
   /* convert internal format to output variables */
   sc_notify_reset_output (&array, senders, num_senders, NULL,
@@ -2758,6 +3327,267 @@ sc_notify (int *receivers, int num_receivers,
   return sc_MPI_SUCCESS;
 }
 
+/*== SC_NOTIFY_AUTO ==*/
+
+#ifndef SC_NOTIFY_AUTO_CACHE_SIZE
+/** The number of choices kept by \ref SC_NOTIFY_AUTO. */
+#define SC_NOTIFY_AUTO_CACHE_SIZE 16
+#endif
+
+/** An algorithm timed by \ref SC_NOTIFY_AUTO. */
+typedef struct sc_notify_auto_candidate_s
+{
+  sc_notify_type_t    type;
+  int                 width;    /**< Tree widths for SC_NOTIFY_NARY. */
+  const char         *name;     /**< Statistics variable of its trials. */
+}
+sc_notify_auto_candidate_t;
+
+/* the default comes first to decide ties */
+static const sc_notify_auto_candidate_t sc_notify_auto_candidates[] = {
+  {SC_NOTIFY_PEX, 0, "sc_notify_auto pex"},
+  {SC_NOTIFY_BINARY, 0, "sc_notify_auto binary"},
+  {SC_NOTIFY_NARY, 4, "sc_notify_auto nary 4"},
+  {SC_NOTIFY_NARY, 8, "sc_notify_auto nary 8"},
+  {SC_NOTIFY_ALLGATHER, 0, "sc_notify_auto allgather"},
+#if defined(SC_ENABLE_MPI) && (MPI_VERSION > 2 || (MPI_VERSION == 2 && MPI_SUBVERSION >= 2))
+  {SC_NOTIFY_PCX, 0, "sc_notify_auto pcx"},
+#endif
+#if defined(SC_ENABLE_MPI) && MPI_VERSION >= 2
+  {SC_NOTIFY_RSX, 0, "sc_notify_auto rsx"},
+#endif
+#if defined(SC_ENABLE_MPI) && MPI_VERSION >= 3
+  {SC_NOTIFY_NBX, 0, "sc_notify_auto nbx"},
+#endif
+};
+
+#define SC_NOTIFY_AUTO_NUM_CANDIDATES                   \
+  ((int) (sizeof (sc_notify_auto_candidates) /          \
+          sizeof (sc_notify_auto_candidate_t)))
+
+/** A choice of \ref SC_NOTIFY_AUTO for a communicator size and regime. */
+typedef struct sc_notify_auto_cache_s
+{
+  int                 mpisize;
+  int                 regime;
+  int                 best;
+  int                 eager_tuned;
+  size_t              eager_threshold;
+}
+sc_notify_auto_cache_t;
+
+static sc_notify_auto_cache_t sc_notify_auto_cache[SC_NOTIFY_AUTO_CACHE_SIZE];
+static int          sc_notify_auto_cache_count = 0;
+
+void
+sc_notify_auto_clear_cache (void)
+{
+  sc_notify_auto_cache_count = 0;
+}
+
+static void
+sc_notify_auto_init (sc_notify_t * notify)
+{
+  notify->tune.regime = -1;
+  notify->tune.next = 0;
+  notify->tune.best = 0;
+  notify->tune.best_time = 0.;
+  notify->tune.eager_next = 0;
+  notify->tune.eager_time = 0.;
+}
+
+sc_notify_type_t
+sc_notify_auto_get_type (sc_notify_t * notify, int *ntop, int *nint,
+                         int *nbot)
+{
+  const sc_notify_auto_candidate_t *c;
+
+  SC_ASSERT (sc_notify_get_type (notify) == SC_NOTIFY_AUTO);
+
+  if (notify->tune.next < SC_NOTIFY_AUTO_NUM_CANDIDATES) {
+    return SC_NOTIFY_AUTO;
+  }
+  c = &sc_notify_auto_candidates[notify->tune.best];
+  if (c->type == SC_NOTIFY_NARY) {
+    if (ntop)
+      *ntop = c->width;
+    if (nint)
+      *nint = c->width;
+    if (nbot)
+      *nbot = c->width;
+  }
+  return c->type;
+}
+
+/** Find the cache entry for the communicator size and regime of notify.
+ * \param [in] create   If no entry exists, create one instead of failing.
+ * \return              The cache entry or NULL.
+ */
+static sc_notify_auto_cache_t *
+sc_notify_auto_lookup (sc_notify_t * notify, int create)
+{
+  int                 i, mpiret, mpisize;
+  sc_notify_auto_cache_t *entry;
+
+  mpiret = sc_MPI_Comm_size (notify->mpicomm, &mpisize);
+  SC_CHECK_MPI (mpiret);
+  for (i = 0; i < SC_MIN (sc_notify_auto_cache_count,
+                          SC_NOTIFY_AUTO_CACHE_SIZE); ++i) {
+    entry = &sc_notify_auto_cache[i];
+    if (entry->mpisize == mpisize && entry->regime == notify->tune.regime) {
+      return entry;
+    }
+  }
+  if (!create) {
+    return NULL;
+  }
+
+  /* the oldest entry is replaced */
+  entry = &sc_notify_auto_cache[sc_notify_auto_cache_count++ %
+                                SC_NOTIFY_AUTO_CACHE_SIZE];
+  entry->mpisize = mpisize;
+  entry->regime = notify->tune.regime;
+  entry->eager_tuned = 0;
+  entry->eager_threshold = notify->eager_threshold;
+  return entry;
+}
+
+/** Run one call of sc_notify_payload or sc_notify_payloadv for type AUTO.
+ * The parameters are those of sc_notify_payloadv, where \a v indicates
+ * that the offsets are used.
+ */
+static void
+sc_notify_auto_run (sc_array_t * receivers, sc_array_t * senders,
+                    sc_array_t * in_payload, sc_array_t * out_payload,
+                    sc_array_t * in_offsets, sc_array_t * out_offsets,
+                    int sorted, sc_notify_t * notify, int v)
+{
+  int                 mpiret, mpisize, regime, timing;
+  size_t              zz, threshold, elem_size;
+  long                cached[5], agreed[5];
+  double              elapsed, maxtime;
+  sc_notify_auto_t   *tune = &notify->tune;
+  sc_notify_auto_cache_t *entry;
+  const sc_notify_auto_candidate_t *c;
+
+  /* agree on the regime and use a cached choice if there is one */
+  if (tune->regime < 0) {
+    for (regime = 0, zz = receivers->elem_count; zz > 0; zz >>= 1) {
+      ++regime;
+    }
+    mpiret = sc_MPI_Allreduce (&regime, &tune->regime, 1, sc_MPI_INT,
+                               sc_MPI_MAX, notify->mpicomm);
+    SC_CHECK_MPI (mpiret);
+    mpiret = sc_MPI_Comm_size (notify->mpicomm, &mpisize);
+    SC_CHECK_MPI (mpiret);
+    if (mpisize == 1) {
+      /* there is nothing to tune and the default is known to work */
+      tune->next = SC_NOTIFY_AUTO_NUM_CANDIDATES;
+      tune->eager_next = 2;
+    }
+    else {
+      /* communicators of equal size over different processes leave the
+         processes with different caches, so they agree on using one:
+         the maximum of a value and of its negative yields its range */
+      entry = sc_notify_auto_lookup (notify, 0);
+      cached[0] = entry == NULL;
+      cached[1] = entry != NULL ? entry->best : 0;
+      cached[2] = entry != NULL && entry->eager_tuned ?
+        (long) entry->eager_threshold : -1;
+      cached[3] = -cached[1];
+      cached[4] = -cached[2];
+      mpiret = sc_MPI_Allreduce (cached, agreed, 5, sc_MPI_LONG, sc_MPI_MAX,
+                                 notify->mpicomm);
+      SC_CHECK_MPI (mpiret);
+      if (!agreed[0] && agreed[1] == -agreed[3] && agreed[2] == -agreed[4]) {
+        tune->next = SC_NOTIFY_AUTO_NUM_CANDIDATES;
+        tune->best = (int) agreed[1];
+        if (agreed[2] >= 0) {
+          tune->eager_next = 2;
+          notify->eager_threshold = (size_t) agreed[2];
+        }
+      }
+    }
+  }
+
+  /* choose the next trial or the fastest candidate */
+  threshold = notify->eager_threshold;
+  elem_size = in_payload != NULL ? in_payload->elem_size : 0;
+  timing = 0;
+  if (tune->next < SC_NOTIFY_AUTO_NUM_CANDIDATES) {
+    c = &sc_notify_auto_candidates[tune->next];
+    timing = 1;
+  }
+  else {
+    c = &sc_notify_auto_candidates[tune->best];
+    if (!v && elem_size > 0 && tune->eager_next < 2) {
+      notify->eager_threshold =
+        tune->eager_next == 0 ? elem_size : elem_size - 1;
+      timing = 2;
+    }
+  }
+  notify->type = c->type;
+  if (c->type == SC_NOTIFY_NARY) {
+    sc_notify_nary_init (notify);
+    sc_notify_nary_set_widths (notify, c->width, c->width, c->width);
+  }
+
+  elapsed = -sc_MPI_Wtime ();
+  if (v) {
+    sc_notify_payloadv (receivers, senders, in_payload, out_payload,
+                        in_offsets, out_offsets, sorted, notify);
+  }
+  else {
+    sc_notify_payload (receivers, senders, in_payload, out_payload,
+                       sorted, notify);
+  }
+  elapsed += sc_MPI_Wtime ();
+  notify->type = SC_NOTIFY_AUTO;
+  notify->eager_threshold = threshold;
+  if (!timing) {
+    return;
+  }
+
+  /* all processes must take the same decision */
+  mpiret = sc_MPI_Allreduce (&elapsed, &maxtime, 1, sc_MPI_DOUBLE,
+                             sc_MPI_MAX, notify->mpicomm);
+  SC_CHECK_MPI (mpiret);
+  if (timing == 1) {
+    if (notify->stats != NULL) {
+      if (!sc_statistics_has (notify->stats, c->name)) {
+        sc_statistics_add_empty (notify->stats, c->name);
+      }
+      sc_statistics_accumulate (notify->stats, c->name, maxtime);
+    }
+    if (tune->next == 0 || maxtime < tune->best_time) {
+      tune->best = tune->next;
+      tune->best_time = maxtime;
+    }
+    if (++tune->next == SC_NOTIFY_AUTO_NUM_CANDIDATES) {
+      entry = sc_notify_auto_lookup (notify, 1);
+      entry->best = tune->best;
+      entry->eager_tuned = 0;
+      SC_GLOBAL_LDEBUGF ("Notify auto choice for regime %d: %s\n",
+                         tune->regime,
+                         sc_notify_auto_candidates[tune->best].name);
+    }
+  }
+  else if (tune->eager_next == 0) {
+    tune->eager_time = maxtime;
+    tune->eager_next = 1;
+  }
+  else {
+    /* payloads of this size and below are sent eagerly if it was faster */
+    notify->eager_threshold =
+      tune->eager_time <= maxtime ? elem_size : elem_size - 1;
+    tune->eager_next = 2;
+    entry = sc_notify_auto_lookup (notify, 1);
+    entry->best = tune->best;
+    entry->eager_tuned = 1;
+    entry->eager_threshold = notify->eager_threshold;
+  }
+}
+
 /*== SC_NOTIFY_PAYLOAD ==*/
 
 void
@@ -2772,6 +3602,12 @@ sc_notify_payload (sc_array_t * receivers, sc_array_t * senders,
   sc_array_t         *receivers_copy = NULL;
   sc_flopinfo_t       snap;
 
+  if (type == SC_NOTIFY_AUTO) {
+    sc_notify_auto_run (receivers, senders, in_payload, out_payload,
+                        NULL, NULL, sorted, notify, 0);
+    return;
+  }
+
   SC_NOTIFY_FUNC_SNAP (notify, &snap);
   SC_GLOBAL_LDEBUGF ("Into sc_notify_payload, type %s\n",
                      sc_notify_type_strings[type]);
@@ -2854,6 +3690,10 @@ sc_notify_payload (sc_array_t * receivers, sc_array_t * senders,
     sc_notify_payload_superset (receivers, senders, first_in_payload,
                                 first_out_payload, sorted, notify);
     break;
+  case SC_NOTIFY_HIERARCHICAL:
+    sc_notify_payload_hierarchical (receivers, senders, first_in_payload,
+                                    first_out_payload, notify);
+    break;
   default:
     SC_ABORT_NOT_REACHED ();
   }
@@ -2871,6 +3711,7 @@ sc_notify_payload (sc_array_t * receivers, sc_array_t * senders,
     sc_MPI_Request     *sendreq;
     sc_MPI_Comm         comm = sc_notify_get_comm (notify);
     char               *recv_payload = NULL;
+    sc_array_t         *recv_buf;
 
     num_receivers = (int) arecv->elem_count;
     sendreq = SC_ALLOC (sc_MPI_Request, num_receivers);
@@ -2880,13 +3721,10 @@ sc_notify_payload (sc_array_t * receivers, sc_array_t * senders,
                       irecv[i], SC_TAG_NOTIFY_PAYLOAD, comm, sendreq + i);
       SC_CHECK_MPI (mpiret);
     }
-    if (out_payload) {
-      sc_array_resize (out_payload, (size_t) num_senders);
-      recv_payload = (char *) out_payload->array;
-    }
-    else {
-      recv_payload = SC_ALLOC (char, msg_size * num_senders);
-    }
+    recv_buf = out_payload ? out_payload :
+      sc_array_new (in_payload->elem_size);
+    sc_array_resize (recv_buf, (size_t) num_senders);
+    recv_payload = (char *) recv_buf->array;
     for (i = 0; i < num_senders; i++) {
       mpiret =
         sc_MPI_Recv (&recv_payload[i * msg_size], msg_size, sc_MPI_BYTE,
@@ -2897,10 +3735,7 @@ sc_notify_payload (sc_array_t * receivers, sc_array_t * senders,
     mpiret = sc_MPI_Waitall (num_receivers, sendreq, sc_MPI_STATUSES_IGNORE);
     SC_CHECK_MPI (mpiret);
     if (!out_payload) {
-      sc_array_resize (in_payload, num_senders);
-      memcpy (in_payload->array, recv_payload,
-              (size_t) msg_size * num_senders);
-      SC_FREE (recv_payload);
+      sc_notify_array_move (in_payload, recv_buf);
     }
     SC_FREE (sendreq);
   }
@@ -2924,6 +3759,12 @@ sc_notify_payloadv (sc_array_t * receivers, sc_array_t * senders,
   sc_notify_type_t    type = sc_notify_get_type (notify);
   sc_flopinfo_t       snap;
 
+  if (type == SC_NOTIFY_AUTO) {
+    sc_notify_auto_run (receivers, senders, in_payload, out_payload,
+                        in_offsets, out_offsets, sorted, notify, 1);
+    return;
+  }
+
   SC_NOTIFY_FUNC_SNAP (notify, &snap);
   SC_GLOBAL_LDEBUGF ("Into sc_notify_payloadv, type %s\n",
                      sc_notify_type_strings[type]);
@@ -2977,6 +3818,7 @@ sc_notify_payloadv (sc_array_t * receivers, sc_array_t * senders,
   case SC_NOTIFY_PEX:
   case SC_NOTIFY_RANGES:
   case SC_NOTIFY_SUPERSET:
+  case SC_NOTIFY_HIERARCHICAL:
     sc_notify_payloadv_wrapper (receivers, senders, in_payload, out_payload,
                                 in_offsets, out_offsets, sorted, notify);
     break;
@@ -3002,6 +3844,112 @@ sc_notify_payloadv (sc_array_t * receivers, sc_array_t * senders,
   SC_NOTIFY_FUNC_SHOT (notify, &snap);
 }
 
+void
+sc_notify_payloadv_views (sc_array_t * receivers, sc_array_t * senders,
+                          sc_array_t * in_views, sc_array_t * out_buffer,
+                          sc_array_t * out_views, int sorted,
+                          sc_notify_t * notify)
+{
+  int                 i, k, mpiret, rank, peer, total;
+  int                 num_receivers, num_senders;
+  int                 self_send, self_recv;
+  int                *isizes;
+  size_t              elem_size;
+  sc_array_t         *sizes, *view;
+  sc_MPI_Request     *requests;
+  sc_MPI_Comm         comm;
+  sc_flopinfo_t       snap;
+
+  SC_ASSERT (receivers != NULL && receivers->elem_size == sizeof (int));
+  SC_ASSERT (senders != NULL && senders->elem_size == sizeof (int));
+  SC_ASSERT (SC_ARRAY_IS_OWNER (senders));
+  SC_ASSERT (in_views != NULL && in_views->elem_size == sizeof (sc_array_t));
+  SC_ASSERT (in_views->elem_count == receivers->elem_count);
+  SC_ASSERT (out_buffer != NULL && SC_ARRAY_IS_OWNER (out_buffer));
+  SC_ASSERT (out_views != NULL && SC_ARRAY_IS_OWNER (out_views));
+  SC_ASSERT (out_views->elem_size == sizeof (sc_array_t));
+
+  SC_NOTIFY_FUNC_SNAP (notify, &snap);
+
+  comm = sc_notify_get_comm (notify);
+  mpiret = sc_MPI_Comm_rank (comm, &rank);
+  SC_CHECK_MPI (mpiret);
+  elem_size = out_buffer->elem_size;
+  num_receivers = (int) receivers->elem_count;
+
+  /* the message sizes are sent with the notification */
+  sizes = sc_array_new_count (sizeof (int), (size_t) num_receivers);
+  isizes = (int *) sizes->array;
+  for (i = 0; i < num_receivers; ++i) {
+    view = (sc_array_t *) sc_array_index_int (in_views, i);
+    SC_ASSERT (view->elem_size == elem_size);
+    SC_ASSERT (view->elem_count * elem_size <= (size_t) INT_MAX);
+    isizes[i] = (int) view->elem_count;
+  }
+  sc_notify_payload (receivers, senders, sizes, NULL, sorted, notify);
+  num_senders = (int) senders->elem_count;
+  SC_ASSERT ((int) sizes->elem_count == num_senders);
+
+  /* the receive buffer has exactly the total size */
+  isizes = (int *) sizes->array;
+  for (total = 0, i = 0; i < num_senders; ++i) {
+    total += isizes[i];
+  }
+  SC_ASSERT ((size_t) total * elem_size <= (size_t) INT_MAX);
+  sc_array_resize (out_buffer, (size_t) total);
+  sc_array_resize (out_views, (size_t) num_senders);
+  for (total = 0, i = 0; i < num_senders; ++i) {
+    sc_array_init_view ((sc_array_t *) sc_array_index_int (out_views, i),
+                        out_buffer, (size_t) total, (size_t) isizes[i]);
+    total += isizes[i];
+  }
+
+  /* the messages go directly between the arrays of the caller;
+     a message to the own rank is copied */
+  requests = SC_ALLOC (sc_MPI_Request, num_receivers + num_senders);
+  self_send = self_recv = -1;
+  for (k = 0, i = 0; i < num_senders; ++i) {
+    peer = *(int *) sc_array_index_int (senders, i);
+    if (peer == rank) {
+      self_recv = i;
+      continue;
+    }
+    view = (sc_array_t *) sc_array_index_int (out_views, i);
+    mpiret = sc_MPI_Irecv (view->array, (int) (view->elem_count * elem_size),
+                           sc_MPI_BYTE, peer, SC_TAG_NOTIFY_VIEWS, comm,
+                           requests + k++);
+    SC_CHECK_MPI (mpiret);
+  }
+  for (i = 0; i < num_receivers; ++i) {
+    peer = *(int *) sc_array_index_int (receivers, i);
+    if (peer == rank) {
+      self_send = i;
+      continue;
+    }
+    view = (sc_array_t *) sc_array_index_int (in_views, i);
+    mpiret = sc_MPI_Isend (view->array, (int) (view->elem_count * elem_size),
+                           sc_MPI_BYTE, peer, SC_TAG_NOTIFY_VIEWS, comm,
+                           requests + k++);
+    SC_CHECK_MPI (mpiret);
+  }
+  SC_ASSERT ((self_send < 0) == (self_recv < 0));
+  if (self_send >= 0) {
+    view = (sc_array_t *) sc_array_index_int (in_views, self_send);
+    SC_ASSERT (view->elem_count == (size_t) isizes[self_recv]);
+    if (view->elem_count > 0) {
+      memcpy (((sc_array_t *) sc_array_index_int
+               (out_views, self_recv))->array, view->array,
+              view->elem_count * elem_size);
+    }
+  }
+  mpiret = sc_MPI_Waitall (k, requests, sc_MPI_STATUSES_IGNORE);
+  SC_CHECK_MPI (mpiret);
+  SC_FREE (requests);
+  sc_array_destroy (sizes);
+
+  SC_NOTIFY_FUNC_SHOT (notify, &snap);
+}
+
 void
 sc_notify_nary (sc_array_t * receivers, sc_array_t * senders,
                 sc_array_t * in_payload, sc_array_t * out_payload,
@@ -3026,3 +3974,411 @@ sc_notify_ext (sc_array_t * receivers, sc_array_t * senders,
   sc_notify_payload (receivers, senders, in_payload, out_payload, 1, notifyc);
   sc_notify_destroy (notifyc);
 }
+
+/*== SC_NOTIFY_PLAN ==*/
+
+struct sc_notify_plan
+{
+  sc_notify_t        *notify;
+  int                 discovered;       /**< The senders are valid. */
+  unsigned            checksum;         /**< Checksum of the receivers. */
+  sc_array_t         *receivers;        /**< Copy of the receivers. */
+  sc_array_t         *senders;          /**< Discovered senders. */
+  int                 have_requests;    /**< The requests are valid. */
+  size_t              elem_size;        /**< Payload size of the requests. */
+  int                 self_send;        /**< Receiver index of own rank. */
+  int                 self_recv;        /**< Sender index of own rank. */
+  int                 num_requests;
+  sc_MPI_Request     *requests;
+  char               *sendbuf;
+  char               *recvbuf;
+};
+
+sc_notify_plan_t   *
+sc_notify_plan_new (sc_notify_t * notify)
+{
+  sc_notify_plan_t   *plan;
+
+  SC_ASSERT (notify != NULL);
+
+  plan = SC_ALLOC_ZERO (sc_notify_plan_t, 1);
+  plan->notify = notify;
+  plan->receivers = sc_array_new (sizeof (int));
+  plan->senders = sc_array_new (sizeof (int));
+  return plan;
+}
+
+static void
+sc_notify_plan_free_requests (sc_notify_plan_t * plan)
+{
+  int                 i, mpiret;
+
+  if (!plan->have_requests) {
+    return;
+  }
+  for (i = 0; i < plan->num_requests; ++i) {
+    mpiret = sc_MPI_Request_free (plan->requests + i);
+    SC_CHECK_MPI (mpiret);
+  }
+  SC_FREE (plan->requests);
+  SC_FREE (plan->sendbuf);
+  SC_FREE (plan->recvbuf);
+  plan->have_requests = 0;
+}
+
+void
+sc_notify_plan_destroy (sc_notify_plan_t * plan)
+{
+  SC_ASSERT (plan != NULL);
+
+  sc_notify_plan_free_requests (plan);
+  sc_array_destroy (plan->receivers);
+  sc_array_destroy (plan->senders);
+  SC_FREE (plan);
+}
+
+/** Create the persistent requests for payloads of a given size. */
+static void
+sc_notify_plan_init_requests (sc_notify_plan_t * plan, size_t elem_size)
+{
+  int                 i, k, mpiret, rank, peer;
+  int                 num_receivers, num_senders;
+  sc_MPI_Comm         comm = sc_notify_get_comm (plan->notify);
+
+  SC_ASSERT (!plan->have_requests);
+  SC_ASSERT (elem_size <= (size_t) INT_MAX);
+
+  mpiret = sc_MPI_Comm_rank (comm, &rank);
+  SC_CHECK_MPI (mpiret);
+  num_receivers = (int) plan->receivers->elem_count;
+  num_senders = (int) plan->senders->elem_count;
+  plan->sendbuf = SC_ALLOC (char, num_receivers * elem_size);
+  plan->recvbuf = SC_ALLOC (char, num_senders * elem_size);
+  plan->requests = SC_ALLOC (sc_MPI_Request, num_receivers + num_senders);
+
+  /* a message to the own rank is copied */
+  plan->self_send = plan->self_recv = -1;
+  k = 0;
+  for (i = 0; i < num_senders; ++i) {
+    peer = *(int *) sc_array_index_int (plan->senders, i);
+    if (peer == rank) {
+      plan->self_recv = i;
+      continue;
+    }
+    mpiret = sc_MPI_Recv_init (plan->recvbuf + i * elem_size,
+                               (int) elem_size, sc_MPI_BYTE, peer,
+                               SC_TAG_NOTIFY_PLAN, comm, plan->requests + k);
+    SC_CHECK_MPI (mpiret);
+    ++k;
+  }
+  for (i = 0; i < num_receivers; ++i) {
+    peer = *(int *) sc_array_index_int (plan->receivers, i);
+    if (peer == rank) {
+      plan->self_send = i;
+      continue;
+    }
+    mpiret = sc_MPI_Send_init (plan->sendbuf + i * elem_size,
+                               (int) elem_size, sc_MPI_BYTE, peer,
+                               SC_TAG_NOTIFY_PLAN, comm, plan->requests + k);
+    SC_CHECK_MPI (mpiret);
+    ++k;
+  }
+  SC_ASSERT ((plan->self_send < 0) == (plan->self_recv < 0));
+  plan->num_requests = k;
+  plan->elem_size = elem_size;
+  plan->have_requests = 1;
+}
+
+void
+sc_notify_plan_exchange (sc_notify_plan_t * plan, sc_array_t * receivers,
+                         sc_array_t * senders, sc_array_t * in_payload,
+                         sc_array_t * out_payload)
+{
+  int                 mpiret, changed, anychanged;
+  unsigned            checksum;
+  size_t              elem_size;
+  sc_flopinfo_t       snap;
+
+  SC_ASSERT (plan != NULL);
+  SC_ASSERT (receivers != NULL && receivers->elem_size == sizeof (int));
+  SC_ASSERT (senders != NULL && senders->elem_size == sizeof (int));
+  SC_ASSERT (SC_ARRAY_IS_OWNER (senders));
+  SC_ASSERT ((in_payload == NULL) == (out_payload == NULL));
+
+  SC_NOTIFY_FUNC_SNAP (plan->notify, &snap);
+
+  /* rediscover the senders if any process has changed its receivers */
+  checksum = sc_array_checksum (receivers);
+  changed = !plan->discovered || checksum != plan->checksum ||
+    !sc_array_is_equal (receivers, plan->receivers);
+  mpiret = sc_MPI_Allreduce (&changed, &anychanged, 1, sc_MPI_INT,
+                             sc_MPI_MAX, sc_notify_get_comm (plan->notify));
+  SC_CHECK_MPI (mpiret);
+  if (anychanged) {
+    sc_notify_plan_free_requests (plan);
+    sc_array_copy (plan->receivers, receivers);
+    plan->checksum = checksum;
+    sc_notify_payload (plan->receivers, plan->senders, NULL, NULL, 1,
+                       plan->notify);
+    plan->discovered = 1;
+  }
+  sc_array_copy (senders, plan->senders);
+
+  if (in_payload != NULL) {
+    SC_ASSERT (in_payload->elem_count == receivers->elem_count);
+    SC_ASSERT (SC_ARRAY_IS_OWNER (out_payload));
+    SC_ASSERT (out_payload->elem_size == in_payload->elem_size);
+
+    elem_size = in_payload->elem_size;
+    if (plan->have_requests && plan->elem_size != elem_size) {
+      sc_notify_plan_free_requests (plan);
+    }
+    if (!plan->have_requests) {
+      sc_notify_plan_init_requests (plan, elem_size);
+    }
+
+    /* the persistent requests are bound to the buffers of the plan */
+    if (in_payload->elem_count > 0) {
+      memcpy (plan->sendbuf, in_payload->array,
+              in_payload->elem_count * elem_size);
+    }
+    mpiret = sc_MPI_Startall (plan->num_requests, plan->requests);
+    SC_CHECK_MPI (mpiret);
+    if (plan->self_send >= 0) {
+      memcpy (plan->recvbuf + plan->self_recv * elem_size,
+              plan->sendbuf + plan->self_send * elem_size, elem_size);
+    }
+    mpiret = sc_MPI_Waitall (plan->num_requests, plan->requests,
+                             sc_MPI_STATUSES_IGNORE);
+    SC_CHECK_MPI (mpiret);
+    sc_array_resize (out_payload, plan->senders->elem_count);
+    if (plan->senders->elem_count > 0) {
+      memcpy (out_payload->array, plan->recvbuf,
+              plan->senders->elem_count * elem_size);
+    }
+  }
+
+  SC_NOTIFY_FUNC_SHOT (plan->notify, &snap);
+}
+
+/*== SC_NOTIFY_GRAPH ==*/
+
+#if defined(SC_ENABLE_MPI) && MPI_VERSION >= 3
+#define SC_NOTIFY_GRAPH_NEIGHBOR
+#endif
+
+struct sc_notify_graph
+{
+  sc_MPI_Comm         mpicomm;
+#ifdef SC_NOTIFY_GRAPH_NEIGHBOR
+  MPI_Comm            graphcomm;        /**< Distributed graph topology. */
+#endif
+  int                 num_receivers;
+  int                 num_senders;
+  int                *receivers;        /**< Followed by the senders. */
+  int                *senders;
+  int                *counts;   /**< Send and receive counts and
+                                     displacements in bytes. */
+};
+
+sc_notify_graph_t  *
+sc_notify_graph_new (sc_MPI_Comm mpicomm, sc_array_t * receivers,
+                     sc_array_t * senders)
+{
+  int                 num_receivers, num_senders;
+  sc_notify_graph_t  *graph;
+#ifdef SC_NOTIFY_GRAPH_NEIGHBOR
+  int                 i, mpiret;
+#endif
+
+  SC_ASSERT (receivers != NULL && receivers->elem_size == sizeof (int));
+  SC_ASSERT (senders != NULL && senders->elem_size == sizeof (int));
+  SC_ASSERT (sc_array_is_sorted (receivers, sc_int_compare));
+  SC_ASSERT (sc_array_is_sorted (senders, sc_int_compare));
+
+  mpicomm = sc_mpi_comm_thread (mpicomm);
+  num_receivers = (int) receivers->elem_count;
+  num_senders = (int) senders->elem_count;
+  graph = SC_ALLOC (sc_notify_graph_t, 1);
+  graph->mpicomm = mpicomm;
+  graph->num_receivers = num_receivers;
+  graph->num_senders = num_senders;
+  graph->receivers = SC_ALLOC (int, num_receivers + num_senders + 1);
+  graph->senders = graph->receivers + num_receivers;
+  memcpy (graph->receivers, receivers->array, num_receivers * sizeof (int));
+  memcpy (graph->senders, senders->array, num_senders * sizeof (int));
+  graph->counts = SC_ALLOC (int, 2 * (num_receivers + num_senders) + 1);
+
+#ifdef SC_NOTIFY_GRAPH_NEIGHBOR
+  /* the ranks are kept such that the receiver list remains valid;
+     unit weights avoid the special value MPI_UNWEIGHTED */
+  for (i = 0; i < 2 * (num_receivers + num_senders) + 1; ++i) {
+    graph->counts[i] = 1;
+  }
+  mpiret = MPI_Dist_graph_create_adjacent
+    (mpicomm, num_senders, graph->senders, graph->counts,
+     num_receivers, graph->receivers, graph->counts,
+     MPI_INFO_NULL, 0, &graph->graphcomm);
+  SC_CHECK_MPI (mpiret);
+#endif
+
+  return graph;
+}
+
+void
+sc_notify_graph_destroy (sc_notify_graph_t * graph)
+{
+#ifdef SC_NOTIFY_GRAPH_NEIGHBOR
+  int                 mpiret;
+
+  mpiret = MPI_Comm_free (&graph->graphcomm);
+  SC_CHECK_MPI (mpiret);
+#endif
+  SC_FREE (graph->receivers);
+  SC_FREE (graph->counts);
+  SC_FREE (graph);
+}
+
+/** Exchange bytes with the neighbors as MPI_Neighbor_alltoallv does.
+ * The counts and displacements are those stored in the graph.
+ */
+static void
+sc_notify_graph_alltoallv (sc_notify_graph_t * graph,
+                           void *sendbuf, void *recvbuf)
+{
+  int                 mpiret;
+  int                *scounts = graph->counts;
+  int                *sdispls = scounts + graph->num_receivers;
+  int                *rcounts = sdispls + graph->num_receivers;
+  int                *rdispls = rcounts + graph->num_senders;
+#ifdef SC_NOTIFY_GRAPH_NEIGHBOR
+
+  /* the neighbors are ordered as passed to the graph constructor */
+  mpiret = MPI_Neighbor_alltoallv (sendbuf, scounts, sdispls, MPI_BYTE,
+                                   recvbuf, rcounts, rdispls, MPI_BYTE,
+                                   graph->graphcomm);
+  SC_CHECK_MPI (mpiret);
+#else
+  int                 i, k, rank, self_send, self_recv;
+  sc_MPI_Request     *requests;
+
+  /* a message to the own rank is copied */
+  mpiret = sc_MPI_Comm_rank (graph->mpicomm, &rank);
+  SC_CHECK_MPI (mpiret);
+  requests = SC_ALLOC (sc_MPI_Request,
+                       graph->num_receivers + graph->num_senders);
+  self_send = self_recv = -1;
+  for (k = 0, i = 0; i < graph->num_senders; ++i) {
+    if (graph->senders[i] == rank) {
+      self_recv = i;
+      continue;
+    }
+    mpiret = sc_MPI_Irecv ((char *) recvbuf + rdispls[i], rcounts[i],
+                           sc_MPI_BYTE, graph->senders[i],
+                           SC_TAG_NOTIFY_GRAPH, graph->mpicomm,
+                           requests + k++);
+    SC_CHECK_MPI (mpiret);
+  }
+  for (i = 0; i < graph->num_receivers; ++i) {
+    if (graph->receivers[i] == rank) {
+      self_send = i;
+      continue;
+    }
+    mpiret = sc_MPI_Isend ((char *) sendbuf + sdispls[i], scounts[i],
+                           sc_MPI_BYTE, graph->receivers[i],
+                           SC_TAG_NOTIFY_GRAPH, graph->mpicomm,
+                           requests + k++);
+    SC_CHECK_MPI (mpiret);
+  }
+  SC_ASSERT ((self_send < 0) == (self_recv < 0));
+  if (self_send >= 0) {
+    SC_ASSERT (scounts[self_send] == rcounts[self_recv]);
+    memcpy ((char *) recvbuf + rdispls[self_recv],
+            (char *) sendbuf + sdispls[self_send], scounts[self_send]);
+  }
+  mpiret = sc_MPI_Waitall (k, requests, sc_MPI_STATUSES_IGNORE);
+  SC_CHECK_MPI (mpiret);
+  SC_FREE (requests);
+#endif
+}
+
+void
+sc_notify_graph_exchange (sc_notify_graph_t * graph,
+                          sc_array_t * in_payload, sc_array_t * in_offsets,
+                          sc_array_t * out_payload, sc_array_t * out_offsets)
+{
+  int                 i, total;
+  int                 num_receivers = graph->num_receivers;
+  int                 num_senders = graph->num_senders;
+  int                *scounts = graph->counts;
+  int                *sdispls = scounts + num_receivers;
+  int                *rcounts = sdispls + num_receivers;
+  int                *rdispls = rcounts + num_senders;
+  int                *ioffsets, *ooffsets;
+  int                *isizes, *osizes;
+  size_t              elem_size;
+
+  SC_ASSERT (in_payload != NULL);
+  SC_ASSERT (out_payload != NULL && SC_ARRAY_IS_OWNER (out_payload));
+  SC_ASSERT (out_payload->elem_size == in_payload->elem_size);
+  SC_ASSERT ((in_offsets == NULL) == (out_offsets == NULL));
+
+  elem_size = in_payload->elem_size;
+  if (in_offsets == NULL) {
+    SC_ASSERT (in_payload->elem_count == (size_t) num_receivers);
+    ioffsets = NULL;
+  }
+  else {
+    SC_ASSERT (in_offsets->elem_size == sizeof (int));
+    SC_ASSERT (in_offsets->elem_count == (size_t) num_receivers + 1);
+    SC_ASSERT (out_offsets->elem_size == sizeof (int));
+    SC_ASSERT (SC_ARRAY_IS_OWNER (out_offsets));
+    ioffsets = (int *) in_offsets->array;
+    SC_ASSERT (ioffsets[num_receivers] == (int) in_payload->elem_count);
+  }
+  SC_ASSERT (in_payload->elem_count * elem_size <= (size_t) INT_MAX);
+
+  /* the receive sizes are obtained from the senders */
+  sc_array_resize (out_payload, 0);
+  if (ioffsets != NULL) {
+    isizes = SC_ALLOC (int, num_receivers + num_senders + 1);
+    osizes = isizes + num_receivers;
+    for (i = 0; i < num_receivers; ++i) {
+      isizes[i] = ioffsets[i + 1] - ioffsets[i];
+      scounts[i] = (int) sizeof (int);
+      sdispls[i] = i * (int) sizeof (int);
+    }
+    for (i = 0; i < num_senders; ++i) {
+      rcounts[i] = (int) sizeof (int);
+      rdispls[i] = i * (int) sizeof (int);
+    }
+    sc_notify_graph_alltoallv (graph, isizes, osizes);
+    sc_array_resize (out_offsets, (size_t) num_senders + 1);
+    ooffsets = (int *) out_offsets->array;
+    for (total = 0, i = 0; i < num_senders; ++i) {
+      ooffsets[i] = total;
+      total += osizes[i];
+    }
+    ooffsets[num_senders] = total;
+    SC_FREE (isizes);
+  }
+  else {
+    ooffsets = NULL;
+    total = num_senders;
+  }
+  SC_ASSERT ((size_t) total * elem_size <= (size_t) INT_MAX);
+  sc_array_resize (out_payload, (size_t) total);
+
+  /* exchange the payload in bytes */
+  for (i = 0; i < num_receivers; ++i) {
+    sdispls[i] = (int) elem_size * (ioffsets != NULL ? ioffsets[i] : i);
+    scounts[i] = (int) elem_size *
+      (ioffsets != NULL ? ioffsets[i + 1] - ioffsets[i] : 1);
+  }
+  for (i = 0; i < num_senders; ++i) {
+    rdispls[i] = (int) elem_size * (ooffsets != NULL ? ooffsets[i] : i);
+    rcounts[i] = (int) elem_size *
+      (ooffsets != NULL ? ooffsets[i + 1] - ooffsets[i] : 1);
+  }
+  sc_notify_graph_alltoallv (graph, in_payload->array, out_payload->array);
+}
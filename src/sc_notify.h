@@ -52,6 +52,18 @@
  *    setting its type and further parameters, and passing it into the general
  *    \ref sc_notify_payload or \ref sc_notify_payloadv functions.
  *
+ *    The type \ref SC_NOTIFY_AUTO runs each of the algorithms available in
+ *    the current MPI version once on the first calls of a controller,
+ *    including n-ary trees of several widths, and keeps the fastest one.
+ *    For payloads it then tunes the eager threshold.  The choice is cached
+ *    by communicator size and the order of magnitude of the largest number
+ *    of receivers, such that later controllers skip the trials if all
+ *    processes of their communicator hold the same choice.
+ *
+ *    The type \ref SC_NOTIFY_HIERARCHICAL uses the node communicators of
+ *    \ref sc_mpi_comm_attach_node_comms to send messages between nodes
+ *    only from one process per node.
+ *
  * \ingroup sc_parallelism
  */
 
@@ -176,6 +188,10 @@ typedef enum
   SC_NOTIFY_RANGES,        /**< Use the sc_ranges functionality.  Likely suboptimal. */
   SC_NOTIFY_SUPERSET,      /**< Use a computable superset of communicators, computed by
                                 a callback function. */
+  SC_NOTIFY_AUTO,          /**< Time the supported algorithms on the first calls
+                                and keep the fastest, see \ref sc_notify_auto_get_type. */
+  SC_NOTIFY_HIERARCHICAL,  /**< Aggregate the messages of each node on its first process
+                                and notify among these, see \ref sc_notify_hierarchical_set_type. */
   SC_NOTIFY_NUM_TYPES      /**< End of list marker for notify algorithms. */
 }
 sc_notify_type_t;
@@ -189,6 +205,8 @@ sc_notify_type_t;
 #define SC_NOTIFY_STR_NBX "nbx"             /**< String for the NBX variant. */
 #define SC_NOTIFY_STR_RANGES "ranges"       /**< String for the ranges variant. */
 #define SC_NOTIFY_STR_SUPERSET "superset"   /**< String for the superset variant. */
+#define SC_NOTIFY_STR_AUTO "auto"           /**< String for the autotuned variant. */
+#define SC_NOTIFY_STR_HIERARCHICAL "hierarchical" /**< String for the node-aware variant. */
 
 /** Names for each notify method */
 extern const char  *sc_notify_type_strings[SC_NOTIFY_NUM_TYPES];
@@ -205,6 +223,9 @@ extern size_t       sc_notify_eager_threshold_default;
 
 /** Create a notify controller that can be used in \ref sc_notify_payload
  * and \ref sc_notify_payloadv.
+ * If the calling thread has selected a slot by \ref sc_mpi_thread_slot_set,
+ * the controller communicates over the duplicate of \a mpicomm returned by
+ * \ref sc_mpi_comm_thread.  A controller must not be used concurrently.
  *
  * \param[in] mpicomm     The MPI communicator over which the notification occurs.
  * \return                Pointer to a notify controller that should be
@@ -261,7 +282,8 @@ void                sc_notify_set_stats (sc_notify_t * notify,
  *
  * \param[in] notify   The notify controller.
  * \return             The mpi communicator over which the notification
- *                     occurs.
+ *                     occurs, which may be a duplicate of the one passed
+ *                     to \ref sc_notify_new, see \ref sc_mpi_comm_thread.
  */
 sc_MPI_Comm         sc_notify_get_comm (sc_notify_t * notify);
 
@@ -313,6 +335,59 @@ void                sc_notify_nary_get_widths (sc_notify_t * notify,
 void                sc_notify_nary_set_widths (sc_notify_t * notify, int ntop,
                                                int nint, int nbot);
 
+/** Query the algorithm chosen by a notify controller of type
+ * \ref SC_NOTIFY_AUTO.  Every call to \ref sc_notify_payload or
+ * \ref sc_notify_payloadv while tuning runs one candidate algorithm.
+ * Its run time, maximized over the processes, is added to the statistics
+ * attached by \ref sc_notify_set_stats if any.  The receiver count regime
+ * and the use of a cached choice are agreed on by two extra allreduces on
+ * the first call of the controller.
+ * On a single process no trials are run and the choice is \ref SC_NOTIFY_PEX.
+ * \param [in] notify   The notify controller must be of type
+ *                      \ref SC_NOTIFY_AUTO.
+ * \param [out] ntop    If not NULL and the choice is \ref SC_NOTIFY_NARY,
+ *                      the number of children at the root node.
+ * \param [out] nint    If not NULL and the choice is \ref SC_NOTIFY_NARY,
+ *                      the number of children at intermediate nodes.
+ * \param [out] nbot    If not NULL and the choice is \ref SC_NOTIFY_NARY,
+ *                      the number of children at the deepest level.
+ * \return              The fastest type once all candidates have run,
+ *                      \ref SC_NOTIFY_AUTO while still tuning.
+ */
+sc_notify_type_t    sc_notify_auto_get_type (sc_notify_t * notify,
+                                             int *ntop, int *nint,
+                                             int *nbot);
+
+/** Forget the algorithms cached for \ref SC_NOTIFY_AUTO on this process.
+ * Controllers created afterwards run their trials again, also if the
+ * cache has been cleared on only some processes of their communicator.
+ */
+void                sc_notify_auto_clear_cache (void);
+
+/** Query the algorithm run among the nodes by \ref SC_NOTIFY_HIERARCHICAL.
+ * \param [in] notify   Must be of type \ref SC_NOTIFY_HIERARCHICAL.
+ * \return              The inter-node type, initially \ref SC_NOTIFY_PEX.
+ */
+sc_notify_type_t    sc_notify_hierarchical_get_type (sc_notify_t * notify);
+
+/** Set the algorithm run among the nodes by \ref SC_NOTIFY_HIERARCHICAL.
+ * The node communicators attached to the communicator of \a notify by
+ * \ref sc_mpi_comm_attach_node_comms are looked up on every call.
+ * The receivers and payloads of each node are gathered to its first
+ * process, exchanged between these node leaders with the inter-node type
+ * and scattered to the receiving processes of each node, such that only
+ * the leaders communicate between nodes.  Without node communicators the
+ * inter-node type runs on the whole communicator.  The senders are
+ * always output in sorted order.
+ * \param [in,out] notify   Must be of type \ref SC_NOTIFY_HIERARCHICAL.
+ * \param [in] inter_type   A supported type with its default parameters
+ *                          other than \ref SC_NOTIFY_SUPERSET and
+ *                          \ref SC_NOTIFY_HIERARCHICAL.
+ */
+void                sc_notify_hierarchical_set_type (sc_notify_t * notify,
+                                                     sc_notify_type_t
+                                                     inter_type);
+
 /** Query the number of ranges for the \ref SC_NOTIFY_RANGES method.
  * \param [in] notify       Must be of type \ref SC_NOTIFY_RANGES.
  * \return                  Number of ranges.
@@ -369,6 +444,32 @@ void                sc_notify_superset_get_callback
 void                sc_notify_superset_set_callback
   (sc_notify_t * notify, sc_compute_superset_t compute_superset, void *ctx);
 
+/** Query whether the \ref SC_NOTIFY_SUPERSET method caches the superset.
+ * \param [in] notify           Must be of type \ref SC_NOTIFY_SUPERSET.
+ * \return                      True if caching is enabled.
+ */
+int                 sc_notify_superset_get_cache (sc_notify_t * notify);
+
+/** Set whether the \ref SC_NOTIFY_SUPERSET method caches the superset.
+ * With caching, the callback is only executed if there is no valid cache.
+ * Its superset of receivers and senders is kept in the notify object
+ * and later calls only exchange the filtered point-to-point messages.
+ * Their receivers must be contained in the cached superset of receivers.
+ * Caching is disabled by default.
+ * \param [in,out] notify       Must be of type \ref SC_NOTIFY_SUPERSET.
+ * \param [in] cache            If false, any cached superset is dropped.
+ */
+void                sc_notify_superset_set_cache (sc_notify_t * notify,
+                                                  int cache);
+
+/** Drop the superset cached by the \ref SC_NOTIFY_SUPERSET method.
+ * The next call executes the callback again, for example after the
+ * application has repartitioned.  Setting the callback does the same.
+ * If the callback communicates, all processes must invalidate alike.
+ * \param [in,out] notify       Must be of type \ref SC_NOTIFY_SUPERSET.
+ */
+void                sc_notify_superset_invalidate (sc_notify_t * notify);
+
 /** Collective call to notify a set of receiver ranks of current rank.
  * This function aborts on MPI error.
  * \param [in,out] receivers    On input, sorted and uniqued array of type int.
@@ -456,6 +557,142 @@ void                sc_notify_payloadv (sc_array_t * receivers,
                                         sc_array_t * in_offsets,
                                         int sorted, sc_notify_t * notify);
 
+/** Collective call to notify a set of receiver ranks of current rank
+ * and send a variable size message to each without packing.
+ * Only the message sizes are communicated with the notification.
+ * The messages are then sent from the input arrays and received into
+ * one output buffer of exactly the total size.
+ * This function aborts on MPI error.
+ * \param [in] receivers        Sorted and uniqued array of type int.
+ *                              Contains the MPI ranks to inform.
+ * \param [in,out] senders      Array of type int that must not be a view.
+ *                              On output, the notifying ranks.
+ * \param [in] in_views         Array of type sc_array_t with one entry
+ *                              per receiver.  Each is an array, such as a
+ *                              view created by \ref sc_array_init_data,
+ *                              with the element size of \a out_buffer
+ *                              holding the message to the receiver.
+ * \param [in,out] out_buffer   Array that must not be a view.  The element
+ *                              size must be the same on every process.
+ *                              On output it holds all received messages.
+ * \param [in,out] out_views    Array of type sc_array_t that must not be
+ *                              a view.  On output it has one view into
+ *                              \a out_buffer per sender, which stays valid
+ *                              until \a out_buffer is modified.
+ * \param [in] sorted           whether \b senders and \b out_views
+ *                              are required to be sorted by MPI rank.
+ * \param [in] notify           Notify controller to use.
+ */
+void                sc_notify_payloadv_views (sc_array_t * receivers,
+                                              sc_array_t * senders,
+                                              sc_array_t * in_views,
+                                              sc_array_t * out_buffer,
+                                              sc_array_t * out_views,
+                                              int sorted,
+                                              sc_notify_t * notify);
+
+/** @} */
+
+/** @{ \name Persistent exchange with a fixed communication pattern. */
+
+/** Opaque object that keeps the result of a notification and persistent
+ * MPI requests for exchanging payloads along the discovered pattern.
+ */
+typedef struct sc_notify_plan sc_notify_plan_t;
+
+/** Create a plan for repeated exchanges with the same receivers.
+ * \param [in] notify   Notify controller used whenever the senders need to
+ *                      be discovered.  It must stay alive with the plan.
+ * \return              Plan to be destroyed with \ref sc_notify_plan_destroy.
+ */
+sc_notify_plan_t   *sc_notify_plan_new (sc_notify_t * notify);
+
+/** Destroy a plan and free its persistent requests.
+ * \param [in,out] plan The plan created by \ref sc_notify_plan_new.
+ */
+void                sc_notify_plan_destroy (sc_notify_plan_t * plan);
+
+/** Collective call to notify the receivers and to exchange payloads.
+ * The result is that of \ref sc_notify_payload with sorted output.
+ * The senders are discovered with the controller of the plan on the first
+ * call and whenever the receiver set changes on any process, which costs
+ * one allreduce of an integer per call to check.  The change is detected
+ * by the \ref sc_array_checksum of the receivers and confirmed by
+ * comparing with a copy.  Otherwise the payloads are sent with persistent
+ * requests created by the previous call for the same payload size.
+ * \param [in,out] plan         The plan created by \ref sc_notify_plan_new.
+ * \param [in] receivers        Sorted and unique array of type int.
+ * \param [in,out] senders      Array of type int that must not be a view.
+ *                              On output, the sorted notifying ranks.
+ * \param [in] in_payload       This array pointer may be NULL.  If not,
+ *                              it has one entry per receiver with the same
+ *                              element size on all processes.
+ * \param [in,out] out_payload  NULL if and only if \a in_payload is NULL.
+ *                              Otherwise it must not be a view, and on output
+ *                              it has the entry of each sender.
+ */
+void                sc_notify_plan_exchange (sc_notify_plan_t * plan,
+                                             sc_array_t * receivers,
+                                             sc_array_t * senders,
+                                             sc_array_t * in_payload,
+                                             sc_array_t * out_payload);
+
+/** @} */
+
+/** @{ \name Neighborhood exchange along a known pattern. */
+
+/** Opaque object that keeps a communicator along a communication pattern.
+ * With MPI-3 it is created by MPI_Dist_graph_create_adjacent and the
+ * payloads are exchanged by neighborhood collectives.  Otherwise the
+ * exchange posts point-to-point messages.
+ */
+typedef struct sc_notify_graph sc_notify_graph_t;
+
+/** Create a graph communicator collectively from a known pattern.
+ * The receivers and senders are usually the result of a notification.
+ * The graph is kept for any number of exchanges along this pattern.
+ * \param [in] mpicomm      The communicator of the pattern.
+ * \param [in] receivers    Sorted and unique array of type int.
+ * \param [in] senders      Sorted array of type int of the ranks that
+ *                          have this process among their receivers.
+ * \return                  Graph to be destroyed with
+ *                          \ref sc_notify_graph_destroy.
+ */
+sc_notify_graph_t  *sc_notify_graph_new (sc_MPI_Comm mpicomm,
+                                         sc_array_t * receivers,
+                                         sc_array_t * senders);
+
+/** Destroy a graph collectively and free its communicator.
+ * \param [in,out] graph    The graph created by \ref sc_notify_graph_new.
+ */
+void                sc_notify_graph_destroy (sc_notify_graph_t * graph);
+
+/** Collective call to send payloads to the receivers of a graph.
+ * \param [in] graph        The graph created by \ref sc_notify_graph_new.
+ * \param [in] in_payload   Array with the same element size on all
+ *                          processes.  Without \a in_offsets, one entry
+ *                          per receiver, otherwise the concatenated
+ *                          entries of all receivers.
+ * \param [in] in_offsets   If NULL, send one entry to each receiver.
+ *                          Otherwise an int array of size
+ *                          \b num_receivers + 1 of the first entry sent
+ *                          to each receiver, ending with the total.
+ * \param [in,out] out_payload  Array of the element size of
+ *                          \a in_payload that must not be a view.
+ *                          On output, the entries received from each
+ *                          sender in order.
+ * \param [in,out] out_offsets  NULL if and only if \a in_offsets is NULL.
+ *                          Otherwise an int array that must not be a view.
+ *                          On output, of size \b num_senders + 1 with the
+ *                          first entry received from each sender.  The
+ *                          sizes are exchanged before the payload.
+ */
+void                sc_notify_graph_exchange (sc_notify_graph_t * graph,
+                                              sc_array_t * in_payload,
+                                              sc_array_t * in_offsets,
+                                              sc_array_t * out_payload,
+                                              sc_array_t * out_offsets);
+
 /** @} */
 
 /** For the \ref SC_NOTIFY_RANGES method, the default is 25. */
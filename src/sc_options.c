@@ -24,7 +24,6 @@
 #include <sc_getopt.h>
 #include <sc_options.h>
 #include <sc_refcount.h>
-#include <iniparser.h>
 
 #include <errno.h>
 #ifdef SC_HAVE_JSON
@@ -83,24 +82,27 @@ struct sc_options
   int                 argc;
   char              **argv;
   sc_array_t         *subopt_names;
+  int                 char_index[256];  /**< First item of a short name. */
+  sc_MPI_Comm         mpicomm;  /**< Files are read collectively if set. */
 };
 
-static char        *sc_iniparser_invalid_key = (char *) -1;
-
 static const int    sc_options_space_type = 20;
 static const int    sc_options_space_help = 32;
 
+/** Convert the value of an .ini entry to an int.
+ * \param [in] str      The value or NULL if the entry is not found.
+ * \param [in] notfound Returned if \a str is NULL.
+ * \param [out] iserror Set to true if the value is out of range.
+ */
 static int
-sc_iniparser_getint (dictionary * d, const char *key, int notfound,
-                     int *iserror)
+sc_options_ini_getint (const char *str, int notfound, int *iserror)
 {
-  char               *str;
   long                l;
 
-  str = iniparser_getstring (d, key, sc_iniparser_invalid_key);
-  if (str == sc_iniparser_invalid_key) {
+  if (str == NULL) {
     return notfound;
   }
+  errno = 0;
   l = strtol (str, NULL, 0);
   if (iserror != NULL) {
     *iserror = (errno == ERANGE);
@@ -121,16 +123,14 @@ sc_iniparser_getint (dictionary * d, const char *key, int notfound,
 }
 
 static size_t
-sc_iniparser_getsizet (dictionary * d, const char *key, size_t notfound,
-                       int *iserror)
+sc_options_ini_getsizet (const char *str, size_t notfound, int *iserror)
 {
-  char               *str;
   long long           ll;
 
-  str = iniparser_getstring (d, key, sc_iniparser_invalid_key);
-  if (str == sc_iniparser_invalid_key) {
+  if (str == NULL) {
     return notfound;
   }
+  errno = 0;
 #ifndef SC_HAVE_STRTOLL
   ll = (long long) strtol (str, NULL, 0);
 #else
@@ -149,16 +149,14 @@ sc_iniparser_getsizet (dictionary * d, const char *key, size_t notfound,
 }
 
 static double
-sc_iniparser_getdouble (dictionary * d, const char *key, double notfound,
-                        int *iserror)
+sc_options_ini_getdouble (const char *str, double notfound, int *iserror)
 {
-  char               *str;
   double              dbl;
 
-  str = iniparser_getstring (d, key, sc_iniparser_invalid_key);
-  if (str == sc_iniparser_invalid_key) {
+  if (str == NULL) {
     return notfound;
   }
+  errno = 0;
   dbl = strtod (str, NULL);
   if (iserror != NULL) {
     *iserror = (errno == ERANGE);
@@ -166,6 +164,197 @@ sc_iniparser_getdouble (dictionary * d, const char *key, double notfound,
   return dbl;
 }
 
+/** Convert the value of an .ini entry to true or false by its first
+ * character, one of "yYtT1" or "nNfF0".
+ * \return              1 or 0, respectively, or \a notfound otherwise.
+ */
+static int
+sc_options_ini_getboolean (const char *str, int notfound)
+{
+  if (str == NULL) {
+    return notfound;
+  }
+  if (strchr ("yYtT1", str[0]) != NULL && str[0] != '\0') {
+    return 1;
+  }
+  if (strchr ("nNfF0", str[0]) != NULL && str[0] != '\0') {
+    return 0;
+  }
+  return notfound;
+}
+
+/** Callback of \ref sc_options_ini_parse for one key = value entry.
+ * \param [in] section      Lower case name of the current section,
+ *                          empty before the first section line.
+ * \param [in] key          Lower case key of the entry.
+ * \param [in] value        Value after removing quotes and comments.
+ * \param [in,out] user     Passed through from the parser.
+ */
+typedef void        (*sc_options_ini_entry_t) (const char *section,
+                                               const char *key,
+                                               const char *value,
+                                               void *user);
+
+/** Remove leading and trailing white space of a string in place. */
+static char        *
+sc_options_ini_strip (char *str)
+{
+  char               *end;
+
+  while (isspace ((unsigned char) *str)) {
+    ++str;
+  }
+  end = str + strlen (str);
+  while (end > str && isspace ((unsigned char) end[-1])) {
+    --end;
+  }
+  *end = '\0';
+  return str;
+}
+
+/** Convert a string to lower case in place. */
+static char        *
+sc_options_ini_lower (char *str)
+{
+  char               *c;
+
+  for (c = str; *c != '\0'; ++c) {
+    *c = (char) tolower ((unsigned char) *c);
+  }
+  return str;
+}
+
+/** Tokenize the contents of an .ini file in a single pass.
+ * The text is modified in place such that the strings passed to the
+ * callback need no allocation.  A line ending in a backslash continues
+ * on the next line.  The syntax follows the bundled iniparser: lines
+ * starting with ';' or '#' are comments, section names and keys are
+ * case insensitive, and values may be quoted or end in a comment.
+ * \param [in,out] text     The contents followed by one more byte.
+ * \param [in] size         Length of the contents without that byte.
+ * \param [in] entry        Called for every key = value line in order.
+ * \param [in,out] user     Passed to the callback.
+ * \param [out] lineno      On error, the number of the offending line.
+ * \return                  0 on success, -1 on a syntax error.
+ */
+static int
+sc_options_ini_parse (char *text, size_t size, sc_options_ini_entry_t entry,
+                      void *user, int *lineno)
+{
+  char               *r, *w, *end, *line, *eq, *q;
+  char               *section, *key, *value;
+  static char         empty[1] = "";
+
+  r = text;
+  end = text + size;
+  section = empty;
+  *lineno = 0;
+  while (r < end) {
+    /* join continued lines in place, which only ever shortens them */
+    line = w = r;
+    for (;;) {
+      ++*lineno;
+      while (r < end && *r != '\n') {
+        *w++ = *r++;
+      }
+      if (r < end) {
+        ++r;
+      }
+      while (w > line && isspace ((unsigned char) w[-1])) {
+        --w;
+      }
+      if (w > line && w[-1] == '\\') {
+        --w;
+        if (r < end) {
+          continue;
+        }
+      }
+      break;
+    }
+    *w = '\0';
+
+    line = sc_options_ini_strip (line);
+    if (line[0] == '\0' || line[0] == '#' || line[0] == ';') {
+      continue;
+    }
+    if (line[0] == '[' && line[strlen (line) - 1] == ']') {
+      *strchr (line, ']') = '\0';
+      section = sc_options_ini_lower (sc_options_ini_strip (line + 1));
+      continue;
+    }
+    if ((eq = strchr (line, '=')) == NULL || eq == line) {
+      return -1;
+    }
+    *eq = '\0';
+    key = sc_options_ini_lower (sc_options_ini_strip (line));
+
+    value = eq + 1;
+    while (isspace ((unsigned char) *value)) {
+      ++value;
+    }
+    if ((value[0] == '"' || value[0] == '\'') &&
+        value[1] != '\0' && value[1] != value[0]) {
+      /* the closing quote is optional */
+      if ((q = strchr (value + 1, value[0])) != NULL) {
+        *q = '\0';
+      }
+      value = sc_options_ini_strip (value + 1);
+    }
+    else {
+      if ((q = strpbrk (value, ";#")) != NULL) {
+        *q = '\0';
+      }
+      value = sc_options_ini_strip (value);
+      if (!strcmp (value, "\"\"") || !strcmp (value, "''")) {
+        value[0] = '\0';
+      }
+    }
+    entry (section, key, value, user);
+  }
+  return 0;
+}
+
+/** Read an .ini file or copy a buffer for \ref sc_options_ini_parse.
+ * \param [in] inifile      Name of the file or the buffer for messages.
+ * \param [in] buffer       If not NULL, the contents to copy.
+ * \param [in] size         Length of the buffer in bytes.
+ * \param [out] text        Resized to the contents and one more byte.
+ * \return                  0 on success, -1 if the file cannot be read.
+ */
+static int
+sc_options_ini_read (const char *inifile, const char *buffer, size_t size,
+                     sc_array_t * text)
+{
+  long                length;
+  FILE               *file;
+
+  SC_ASSERT (text->elem_size == 1);
+
+  if (buffer != NULL) {
+    sc_array_resize (text, size + 1);
+    memcpy (text->array, buffer, size);
+  }
+  else {
+    if ((file = fopen (inifile, "rb")) == NULL) {
+      return -1;
+    }
+    if (fseek (file, 0, SEEK_END) != 0 || (length = ftell (file)) < 0 ||
+        fseek (file, 0, SEEK_SET) != 0) {
+      fclose (file);
+      return -1;
+    }
+    size = (size_t) length;
+    sc_array_resize (text, size + 1);
+    if (fread (text->array, 1, size, file) != size) {
+      fclose (file);
+      return -1;
+    }
+    fclose (file);
+  }
+  text->array[size] = '\0';
+  return 0;
+}
+
 static sc_option_string_t *
 sc_options_string_new (const char **variable, const char *init_value)
 {
@@ -265,6 +454,8 @@ sc_options_new (const char *program_path)
   opt->first_arg = -1;
   opt->argc = 0;
   opt->argv = NULL;
+  memset (opt->char_index, -1, sizeof (opt->char_index));
+  opt->mpicomm = sc_MPI_COMM_NULL;
 
   /* set default spacing for printing option summary */
   sc_options_set_spacing (opt, -1, -1);
@@ -344,6 +535,11 @@ sc_options_add_item (sc_options_t * opt, int opt_char, const char *opt_name,
   SC_ASSERT (opt_char != '\0' || opt_name != NULL);
   SC_ASSERT (opt_name == NULL || opt_name[0] != '-');
 
+  /* the first item of a short name wins as in a linear search */
+  if (opt_char > 0 && opt_char < 256 && opt->char_index[opt_char] < 0) {
+    opt->char_index[opt_char] = (int) opt->option_items->elem_count;
+  }
+
   item = (sc_option_item_t *) sc_array_push (opt->option_items);
   memset (item, 0, sizeof (sc_option_item_t));
 
@@ -795,16 +991,131 @@ sc_options_load (int package_id, int err_priority,
   return sc_options_load_ini (package_id, err_priority, opt, file, NULL);
 }
 
-int
-sc_options_load_ini (int package_id, int err_priority,
-                     sc_options_t * opt, const char *inifile, void *re)
+/** Read a file on the first process and broadcast its contents.
+ * \param [out] buffer          Resized to the contents of the file.
+ * \return                      0 on success and -1 if the file could not
+ *                              be read, the same on all processes.
+ */
+static int
+sc_options_file_bcast (int package_id, int err_priority,
+                       sc_MPI_Comm mpicomm, const char *filename,
+                       sc_array_t * buffer)
 {
+  int                 mpiret, rank;
+  long                size = -1;
+  FILE               *file;
+
+  mpiret = sc_MPI_Comm_rank (mpicomm, &rank);
+  SC_CHECK_MPI (mpiret);
+
+  if (rank == 0 && (file = fopen (filename, "rb")) != NULL) {
+    if (fseek (file, 0, SEEK_END) == 0 && (size = ftell (file)) >= 0 &&
+        fseek (file, 0, SEEK_SET) == 0) {
+      sc_array_resize (buffer, (size_t) size);
+      if (fread (buffer->array, 1, (size_t) size, file) != (size_t) size) {
+        size = -1;
+      }
+    }
+    else {
+      size = -1;
+    }
+    fclose (file);
+  }
+
+  mpiret = sc_MPI_Bcast (&size, 1, sc_MPI_LONG, 0, mpicomm);
+  SC_CHECK_MPI (mpiret);
+  if (size < 0 || size > (long) INT_MAX) {
+    SC_GEN_LOGF (package_id, SC_LC_GLOBAL, err_priority,
+                 "Could not read file: %s\n", filename);
+    return -1;
+  }
+  sc_array_resize (buffer, (size_t) size);
+  mpiret = sc_MPI_Bcast (buffer->array, (int) size, sc_MPI_BYTE, 0,
+                         mpicomm);
+  SC_CHECK_MPI (mpiret);
+  return 0;
+}
+
+/** Option key looked up in an .ini file. */
+typedef struct sc_options_ini_key
+{
+  const char         *key;      /**< Lower case "section:key". */
+  size_t              item;     /**< Index of the option item. */
+  int                 is_long;  /**< Long or short name of the item. */
+}
+sc_options_ini_key_t;
+
+/** Context of \ref sc_options_ini_match. */
+typedef struct sc_options_ini_match
+{
+  sc_array_t          keys;     /**< Sorted \ref sc_options_ini_key_t. */
+  const char        **values;   /**< Short and long value per item. */
+  char                buf[BUFSIZ];      /**< Key of the current entry. */
+}
+sc_options_ini_match_t;
+
+static int
+sc_options_ini_key_compare (const void *v1, const void *v2)
+{
+  return strcmp (((const sc_options_ini_key_t *) v1)->key,
+                 ((const sc_options_ini_key_t *) v2)->key);
+}
+
+/** Record the value of an entry for the options of the same key. */
+static void
+sc_options_ini_match (const char *section, const char *key,
+                      const char *value, void *user)
+{
+  sc_options_ini_match_t *match = (sc_options_ini_match_t *) user;
+  sc_options_ini_key_t probe, *k;
+  ssize_t             pos;
+  size_t              zz;
+
+  snprintf (match->buf, BUFSIZ, "%s:%s", section, key);
+  probe.key = match->buf;
+  pos = sc_array_bsearch (&match->keys, &probe, sc_options_ini_key_compare);
+  if (pos < 0) {
+    return;
+  }
+
+  /* options differing only in case share a key; later entries win */
+  for (zz = (size_t) pos; zz > 0; --zz) {
+    k = (sc_options_ini_key_t *) sc_array_index (&match->keys, zz - 1);
+    if (strcmp (k->key, match->buf)) {
+      break;
+    }
+  }
+  for (; zz < match->keys.elem_count; ++zz) {
+    k = (sc_options_ini_key_t *) sc_array_index (&match->keys, zz);
+    if (strcmp (k->key, match->buf)) {
+      break;
+    }
+    match->values[2 * k->item + k->is_long] = value;
+  }
+}
+
+/** Load a file in .ini format from the file system or from memory.
+ * The file is tokenized in one pass, looking up each entry in a sorted
+ * table of the option keys, before the values are assigned in order of
+ * the options.  All strings live in the text and one arena of keys.
+ */
+static int
+sc_options_load_ini_internal (int package_id, int err_priority,
+                              sc_options_t * opt, const char *inifile,
+                              const char *buffer, size_t size)
+{
+  int                 retval;
+  int                 lineno;
   int                 found_short, found_long;
   size_t              iz;
   size_t              count;
+  size_t              total, len;
+  char               *c;
   sc_array_t         *items;
+  sc_array_t          text, names;
   sc_option_item_t   *item;
-  dictionary         *dict;
+  sc_options_ini_key_t *k;
+  sc_options_ini_match_t match;
   int                 iserror;
   int                 bvalue;
   int                *ivalue;
@@ -816,20 +1127,19 @@ sc_options_load_ini (int package_id, int err_priority,
   SC_ASSERT (opt != NULL);
   SC_ASSERT (inifile != NULL);
 
-  /* prepare for runtime error checking implementation */
-  SC_ASSERT (re == NULL);
-
   /* read .ini file in one go */
-  dict = iniparser_load (inifile);
-  if (dict == NULL) {
+  sc_array_init (&text, 1);
+  if (sc_options_ini_read (inifile, buffer, size, &text)) {
     SC_GEN_LOG (package_id, SC_LC_GLOBAL, err_priority,
                 "Could not load or parse .ini file\n");
+    sc_array_reset (&text);
     return -1;
   }
 
-  /* loop through option items */
+  /* collect the lower case keys of all options in one arena */
   items = opt->option_items;
   count = items->elem_count;
+  total = 0;
   for (iz = 0; iz < count; ++iz) {
     item = (sc_option_item_t *) sc_array_index (items, iz);
     if (item->opt_type == SC_OPTION_INIFILE ||
@@ -837,37 +1147,103 @@ sc_options_load_ini (int package_id, int err_priority,
         item->opt_type == SC_OPTION_CALLBACK) {
       continue;
     }
+    if (item->opt_char != '\0') {
+      total += sizeof ("options:-c");
+    }
+    if (item->opt_name != NULL) {
+      total += sizeof ("options:") + strlen (item->opt_name);
+    }
+  }
+  sc_array_init_count (&names, 1, total);
+  sc_array_init (&match.keys, sizeof (sc_options_ini_key_t));
+  match.values = SC_ALLOC_ZERO (const char *, 2 * count);
+  c = names.array;
+  for (iz = 0; iz < count; ++iz) {
+    item = (sc_option_item_t *) sc_array_index (items, iz);
+    if (item->opt_type == SC_OPTION_INIFILE ||
+        item->opt_type == SC_OPTION_JSONFILE ||
+        item->opt_type == SC_OPTION_CALLBACK) {
+      continue;
+    }
+    if (item->opt_char != '\0') {
+      k = (sc_options_ini_key_t *) sc_array_push (&match.keys);
+      k->key = c;
+      k->item = iz;
+      k->is_long = 0;
+      len = (size_t) snprintf (c, sizeof ("options:-c"), "options:-%c",
+                               item->opt_char);
+      c += len + 1;
+    }
+    if (item->opt_name != NULL) {
+      k = (sc_options_ini_key_t *) sc_array_push (&match.keys);
+      k->key = c;
+      k->item = iz;
+      k->is_long = 1;
+
+      /* if the name contains a section prefix, don't add "options:" */
+      len = strlen (item->opt_name) + 1;
+      if (strchr (item->opt_name, ':') == NULL) {
+        len += sizeof ("options:") - 1;
+        snprintf (c, len, "options:%s", item->opt_name);
+      }
+      else {
+        SC_ASSERT (item->opt_char == '\0');
+        memcpy (c, item->opt_name, len);
+      }
+      sc_options_ini_lower (c);
+      c += len;
+    }
+  }
+  SC_ASSERT (c <= names.array + total);
+  sc_array_sort (&match.keys, sc_options_ini_key_compare);
+
+  /* a single pass over the text records the value of every option */
+  retval = sc_options_ini_parse (text.array, text.elem_count - 1,
+                                 sc_options_ini_match, &match, &lineno);
+  if (retval) {
+    SC_GEN_LOGF (package_id, SC_LC_GLOBAL, err_priority,
+                 "Syntax error in line %d of .ini file: %s\n", lineno,
+                 inifile);
+  }
+
+  /* loop through option items */
+  for (iz = 0; retval == 0 && iz < count; ++iz) {
+    item = (sc_option_item_t *) sc_array_index (items, iz);
+    if (item->opt_type == SC_OPTION_INIFILE ||
+        item->opt_type == SC_OPTION_JSONFILE ||
+        item->opt_type == SC_OPTION_CALLBACK) {
+      continue;
+    }
 
     /* check existence of key */
     key = NULL;
     skey[0] = lkey[0] = '\0';
-    found_short = found_long = 0;
+    found_short = match.values[2 * iz] != NULL;
+    found_long = match.values[2 * iz + 1] != NULL;
     if (item->opt_char != '\0') {
       snprintf (skey, BUFSIZ, "Options:-%c", item->opt_char);
-      found_short = iniparser_find_entry (dict, skey);
     }
     if (item->opt_name != NULL) {
-      /* if the name contains a section prefix, don't add "Options:" */
       if (strchr (item->opt_name, ':') != NULL) {
-        SC_ASSERT (item->opt_char == '\0');
         snprintf (lkey, BUFSIZ, "%s", item->opt_name);
       }
       else {
         snprintf (lkey, BUFSIZ, "Options:%s", item->opt_name);
       }
-      found_long = iniparser_find_entry (dict, lkey);
     }
     if (found_short && found_long) {
       SC_GEN_LOGF (package_id, SC_LC_GLOBAL, err_priority,
                    "Duplicates %s %s in file: %s\n", skey, lkey, inifile);
-      iniparser_freedict (dict);
-      return -1;
+      retval = -1;
+      break;
     }
     else if (found_long) {
       key = lkey;
+      s = match.values[2 * iz + 1];
     }
     else if (found_short) {
       key = skey;
+      s = match.values[2 * iz];
     }
     else {
       continue;
@@ -877,91 +1253,128 @@ sc_options_load_ini (int package_id, int err_priority,
     ++item->called;
     switch (item->opt_type) {
     case SC_OPTION_SWITCH:
-      bvalue = iniparser_getboolean (dict, key, -1);
+      bvalue = sc_options_ini_getboolean (s, -1);
       if (bvalue == -1) {
-        bvalue = sc_iniparser_getint (dict, key, 0, &iserror);
+        bvalue = sc_options_ini_getint (s, 0, &iserror);
         if (bvalue <= 0 || iserror) {
           SC_GEN_LOGF (package_id, SC_LC_GLOBAL, err_priority,
                        "Invalid switch %s in file: %s\n", key, inifile);
-          iniparser_freedict (dict);
-          return -1;
+          retval = -1;
+          break;
         }
       }
       *(int *) item->opt_var = bvalue;
       break;
     case SC_OPTION_BOOL:
-      bvalue = iniparser_getboolean (dict, key, -1);
+      bvalue = sc_options_ini_getboolean (s, -1);
       if (bvalue == -1) {
         SC_GEN_LOGF (package_id, SC_LC_GLOBAL, err_priority,
                      "Invalid boolean %s in file: %s\n", key, inifile);
-        iniparser_freedict (dict);
-        return -1;
+        retval = -1;
+        break;
       }
       *(int *) item->opt_var = bvalue;
       break;
     case SC_OPTION_INT:
       ivalue = (int *) item->opt_var;
-      *ivalue = sc_iniparser_getint (dict, key, *ivalue, &iserror);
+      *ivalue = sc_options_ini_getint (s, *ivalue, &iserror);
       if (iserror) {
         SC_GEN_LOGF (package_id, SC_LC_GLOBAL, err_priority,
                      "Invalid int %s in file: %s\n", key, inifile);
-        iniparser_freedict (dict);
-        return -1;
+        retval = -1;
       }
       break;
     case SC_OPTION_SIZE_T:
       zvalue = (size_t *) item->opt_var;
-      *zvalue = sc_iniparser_getsizet (dict, key, *zvalue, &iserror);
+      *zvalue = sc_options_ini_getsizet (s, *zvalue, &iserror);
       if (iserror) {
         SC_GEN_LOGF (package_id, SC_LC_GLOBAL, err_priority,
                      "Invalid size_t %s in file: %s\n", key, inifile);
-        iniparser_freedict (dict);
-        return -1;
+        retval = -1;
       }
       break;
     case SC_OPTION_DOUBLE:
       dvalue = (double *) item->opt_var;
-      *dvalue = sc_iniparser_getdouble (dict, key, *dvalue, &iserror);
+      *dvalue = sc_options_ini_getdouble (s, *dvalue, &iserror);
       if (iserror) {
         SC_GEN_LOGF (package_id, SC_LC_GLOBAL, err_priority,
                      "Invalid double %s in file: %s\n", key, inifile);
-        iniparser_freedict (dict);
-        return -1;
+        retval = -1;
       }
       break;
     case SC_OPTION_STRING:
-      s = iniparser_getstring (dict, key, NULL);
-      if (s != NULL) {
-        sc_options_string_set ((sc_option_string_t *) item->opt_var, s);
-      }
+      sc_options_string_set ((sc_option_string_t *) item->opt_var, s);
       break;
     case SC_OPTION_KEYVALUE:
       SC_ASSERT (item->string_value != NULL);
-      s = iniparser_getstring (dict, key, NULL);
-      if (s != NULL) {
-        /* lookup the key and see if the result is valid */
-        iserror = *(ivalue = (int *) item->opt_var);
-        *ivalue = sc_keyvalue_get_int_check ((sc_keyvalue_t *)
-                                             item->user_data, s, &iserror);
-        if (iserror) {
-          /* key not found or of the wrong type; this cannot be ignored */
-          SC_GEN_LOGF (package_id, SC_LC_GLOBAL, err_priority,
-                       "Invalid keyvalue %s for option %s in file: %s\n",
-                       s, key, inifile);
-          iniparser_freedict (dict);
-          return -1;
-        }
-        SC_FREE (item->string_value);
-        item->string_value = SC_STRDUP (s);
+      /* lookup the key and see if the result is valid */
+      iserror = *(ivalue = (int *) item->opt_var);
+      *ivalue = sc_keyvalue_get_int_check ((sc_keyvalue_t *)
+                                           item->user_data, s, &iserror);
+      if (iserror) {
+        /* key not found or of the wrong type; this cannot be ignored */
+        SC_GEN_LOGF (package_id, SC_LC_GLOBAL, err_priority,
+                     "Invalid keyvalue %s for option %s in file: %s\n",
+                     s, key, inifile);
+        retval = -1;
+        break;
       }
+      SC_FREE (item->string_value);
+      item->string_value = SC_STRDUP (s);
       break;
     default:
       SC_ABORT_NOT_REACHED ();
     }
   }
 
-  iniparser_freedict (dict);
-  return 0;
+  SC_FREE (match.values);
+  sc_array_reset (&match.keys);
+  sc_array_reset (&names);
+  sc_array_reset (&text);
+  return retval;
+}
+
+int
+sc_options_load_ini (int package_id, int err_priority,
+                     sc_options_t * opt, const char *inifile, void *re)
+{
+  /* prepare for runtime error checking implementation */
+  SC_ASSERT (re == NULL);
+
+  return sc_options_load_ini_internal (package_id, err_priority,
+                                       opt, inifile, NULL, 0);
+}
+
+int
+sc_options_load_ini_buffer (int package_id, int err_priority,
+                            sc_options_t * opt, const char *buffer,
+                            size_t size, const char *name)
+{
+  SC_ASSERT (buffer != NULL || size == 0);
+
+  return sc_options_load_ini_internal (package_id, err_priority, opt,
+                                       name != NULL ? name : "<buffer>",
+                                       buffer != NULL ? buffer : "", size);
+}
+
+int
+sc_options_load_ini_collective (int package_id, int err_priority,
+                                sc_options_t * opt, const char *inifile,
+                                sc_MPI_Comm mpicomm)
+{
+  int                 retval;
+  sc_array_t         *buffer;
+
+  buffer = sc_array_new (1);
+  retval = sc_options_file_bcast (package_id, err_priority,
+                                  mpicomm, inifile, buffer);
+  if (!retval) {
+    retval = sc_options_load_ini_internal (package_id, err_priority,
+                                           opt, inifile, buffer->array,
+                                           buffer->elem_count);
+  }
+  sc_array_destroy (buffer);
+  return retval;
 }
 
 #ifdef SC_HAVE_JSON
@@ -1062,9 +1475,11 @@ sc_options_json_lookup (json_t *object, const char *keystring)
 
 #endif /* SC_HAVE_JSON */
 
-int
-sc_options_load_json (int package_id, int err_priority,
-                      sc_options_t *opt, const char *jsonfile, void *re)
+/** Load a file in JSON format from the file system or from memory. */
+static int
+sc_options_load_json_internal (int package_id, int err_priority,
+                               sc_options_t * opt, const char *jsonfile,
+                               const sc_array_t * buffer)
 {
   int                 retval = -1;
 #ifndef SC_HAVE_JSON
@@ -1089,12 +1504,10 @@ sc_options_load_json (int package_id, int err_priority,
   SC_ASSERT (opt != NULL);
   SC_ASSERT (jsonfile != NULL);
 
-  /* prepare for runtime error checking implementation */
-  SC_ASSERT (re == NULL);
-
   /* read JSON file in one go */
-  file = NULL;
-  if ((file = json_load_file (jsonfile, 0, &jerr)) == NULL) {
+  file = buffer == NULL ? json_load_file (jsonfile, 0, &jerr) :
+    json_loadb (buffer->array, buffer->elem_count, 0, &jerr);
+  if (file == NULL) {
     SC_GEN_LOGF (package_id, SC_LC_GLOBAL, err_priority,
                  "Could not load or parse JSON file %s line %d column %d\n",
                  jerr.source, jerr.line, jerr.column);
@@ -1272,6 +1685,42 @@ load_json_error:
   return retval;
 }
 
+int
+sc_options_load_json (int package_id, int err_priority,
+                      sc_options_t *opt, const char *jsonfile, void *re)
+{
+  /* prepare for runtime error checking implementation */
+  SC_ASSERT (re == NULL);
+
+  return sc_options_load_json_internal (package_id, err_priority,
+                                        opt, jsonfile, NULL);
+}
+
+int
+sc_options_load_json_collective (int package_id, int err_priority,
+                                 sc_options_t * opt, const char *jsonfile,
+                                 sc_MPI_Comm mpicomm)
+{
+  int                 retval;
+  sc_array_t         *buffer;
+
+  buffer = sc_array_new (1);
+  retval = sc_options_file_bcast (package_id, err_priority,
+                                  mpicomm, jsonfile, buffer);
+  if (!retval) {
+    retval = sc_options_load_json_internal (package_id, err_priority,
+                                            opt, jsonfile, buffer);
+  }
+  sc_array_destroy (buffer);
+  return retval;
+}
+
+void
+sc_options_set_collective (sc_options_t * opt, sc_MPI_Comm mpicomm)
+{
+  opt->mpicomm = mpicomm;
+}
+
 int
 sc_options_save (int package_id, int err_priority,
                  sc_options_t * opt, const char *inifile)
@@ -1442,6 +1891,235 @@ sc_options_save (int package_id, int err_priority,
   return 0;
 }
 
+/** Append bytes to a buffer of element size 1. */
+static void
+sc_options_pack_bytes (sc_array_t * buffer, const void *data, size_t size)
+{
+  memcpy (sc_array_push_count (buffer, size), data, size);
+}
+
+/** Append a string that may be NULL to a buffer of element size 1. */
+static void
+sc_options_pack_string (sc_array_t * buffer, const char *s)
+{
+  int                 len = s == NULL ? -1 : (int) strlen (s);
+
+  sc_options_pack_bytes (buffer, &len, sizeof (int));
+  if (len > 0) {
+    sc_options_pack_bytes (buffer, s, (size_t) len);
+  }
+}
+
+/** Remove bytes from the front of a packed buffer.
+ * \return              The position of the bytes or NULL if the buffer
+ *                      is too short.
+ */
+static const char  *
+sc_options_unpack_bytes (sc_array_t * buffer, size_t *position,
+                         size_t size)
+{
+  const char         *data;
+
+  if (*position + size > buffer->elem_count) {
+    return NULL;
+  }
+  data = buffer->array + *position;
+  *position += size;
+  return data;
+}
+
+/** Remove a string of \ref sc_options_pack_string from a buffer.
+ * \return              An allocated string or NULL.
+ */
+static char        *
+sc_options_unpack_string (sc_array_t * buffer, size_t *position,
+                          int *iserror)
+{
+  int                 len;
+  const char         *data;
+  char               *s;
+
+  if ((data = sc_options_unpack_bytes (buffer, position, sizeof (int)))
+      == NULL) {
+    *iserror = 1;
+    return NULL;
+  }
+  memcpy (&len, data, sizeof (int));
+  if (len < 0) {
+    return NULL;
+  }
+  if ((data = sc_options_unpack_bytes (buffer, position, (size_t) len))
+      == NULL) {
+    *iserror = 1;
+    return NULL;
+  }
+  s = SC_ALLOC (char, len + 1);
+  memcpy (s, data, (size_t) len);
+  s[len] = '\0';
+  return s;
+}
+
+void
+sc_options_pack (sc_options_t * opt, sc_array_t * buffer)
+{
+  int                 count;
+  size_t              iz;
+  sc_array_t         *items = opt->option_items;
+  sc_option_item_t   *item;
+
+  SC_ASSERT (buffer != NULL && buffer->elem_size == 1);
+
+  /* the values are packed in the order of the items */
+  count = (int) items->elem_count;
+  sc_options_pack_bytes (buffer, &count, sizeof (int));
+  for (iz = 0; iz < items->elem_count; ++iz) {
+    item = (sc_option_item_t *) sc_array_index (items, iz);
+    sc_options_pack_bytes (buffer, &item->called, sizeof (int));
+    switch (item->opt_type) {
+    case SC_OPTION_SWITCH:
+    case SC_OPTION_BOOL:
+    case SC_OPTION_INT:
+      sc_options_pack_bytes (buffer, item->opt_var, sizeof (int));
+      break;
+    case SC_OPTION_SIZE_T:
+      sc_options_pack_bytes (buffer, item->opt_var, sizeof (size_t));
+      break;
+    case SC_OPTION_DOUBLE:
+      sc_options_pack_bytes (buffer, item->opt_var, sizeof (double));
+      break;
+    case SC_OPTION_STRING:
+      sc_options_pack_string (buffer, sc_options_string_get
+                              ((sc_option_string_t *) item->opt_var));
+      break;
+    case SC_OPTION_KEYVALUE:
+      sc_options_pack_bytes (buffer, item->opt_var, sizeof (int));
+      sc_options_pack_string (buffer, item->string_value);
+      break;
+    default:
+      break;
+    }
+  }
+}
+
+int
+sc_options_unpack (sc_options_t * opt, sc_array_t * buffer,
+                   size_t *position)
+{
+  int                 iserror, count;
+  size_t              iz, size;
+  sc_array_t         *items = opt->option_items;
+  sc_option_item_t   *item;
+  const char         *data;
+  char               *value;
+
+  SC_ASSERT (buffer != NULL && buffer->elem_size == 1);
+  SC_ASSERT (position != NULL);
+
+  if ((data = sc_options_unpack_bytes (buffer, position, sizeof (int)))
+      == NULL) {
+    return -1;
+  }
+  memcpy (&count, data, sizeof (int));
+  iserror = count != (int) items->elem_count;
+  for (iz = 0; !iserror && iz < items->elem_count; ++iz) {
+    item = (sc_option_item_t *) sc_array_index (items, iz);
+    if ((data = sc_options_unpack_bytes (buffer, position, sizeof (int)))
+        == NULL) {
+      iserror = 1;
+      break;
+    }
+    memcpy (&item->called, data, sizeof (int));
+    switch (item->opt_type) {
+    case SC_OPTION_SWITCH:
+    case SC_OPTION_BOOL:
+    case SC_OPTION_INT:
+    case SC_OPTION_SIZE_T:
+    case SC_OPTION_DOUBLE:
+      size = item->opt_type == SC_OPTION_SIZE_T ? sizeof (size_t) :
+        item->opt_type == SC_OPTION_DOUBLE ? sizeof (double) : sizeof (int);
+      if ((data = sc_options_unpack_bytes (buffer, position, size)) == NULL) {
+        iserror = 1;
+        break;
+      }
+      memcpy (item->opt_var, data, size);
+      break;
+    case SC_OPTION_STRING:
+      value = sc_options_unpack_string (buffer, position, &iserror);
+      if (!iserror) {
+        sc_options_string_set ((sc_option_string_t *) item->opt_var, value);
+      }
+      SC_FREE (value);
+      break;
+    case SC_OPTION_KEYVALUE:
+      if ((data = sc_options_unpack_bytes (buffer, position, sizeof (int)))
+          == NULL) {
+        iserror = 1;
+        break;
+      }
+      memcpy (item->opt_var, data, sizeof (int));
+      value = sc_options_unpack_string (buffer, position, &iserror);
+      if (!iserror && value != NULL) {
+        SC_FREE (item->string_value);
+        item->string_value = value;
+      }
+      else {
+        SC_FREE (value);
+      }
+      break;
+    default:
+      break;
+    }
+  }
+  return iserror ? -1 : 0;
+}
+
+int
+sc_options_broadcast (sc_options_t * opt, sc_MPI_Comm mpicomm, int root,
+                      int *retval)
+{
+  int                 mpiret, rank;
+  int                 iserror, ivalue = 0;
+  size_t              position;
+  sc_array_t         *buffer;
+  const char         *data;
+
+  mpiret = sc_MPI_Comm_rank (mpicomm, &rank);
+  SC_CHECK_MPI (mpiret);
+
+  /* the return value is followed by the packed options */
+  buffer = sc_array_new (1);
+  if (rank == root) {
+    ivalue = retval == NULL ? 0 : *retval;
+    sc_options_pack_bytes (buffer, &ivalue, sizeof (int));
+    sc_options_pack (opt, buffer);
+    ivalue = (int) buffer->elem_count;
+  }
+
+  /* broadcast the size and the packed values */
+  mpiret = sc_MPI_Bcast (&ivalue, 1, sc_MPI_INT, root, mpicomm);
+  SC_CHECK_MPI (mpiret);
+  if (rank != root) {
+    sc_array_resize (buffer, (size_t) ivalue);
+  }
+  mpiret = sc_MPI_Bcast (buffer->array, ivalue, sc_MPI_BYTE, root, mpicomm);
+  SC_CHECK_MPI (mpiret);
+  if (rank == root) {
+    sc_array_destroy (buffer);
+    return 0;
+  }
+
+  /* unpack the values into the local variables */
+  position = 0;
+  data = sc_options_unpack_bytes (buffer, &position, sizeof (int));
+  if (retval != NULL) {
+    memcpy (retval, data, sizeof (int));
+  }
+  iserror = sc_options_unpack (opt, buffer, &position) ||
+    position != buffer->elem_count;
+  sc_array_destroy (buffer);
+  return iserror ? -1 : 0;
+}
+
 int
 sc_options_parse (int package_id, int err_priority, sc_options_t * opt,
                   int argc, char **argv)
@@ -1514,18 +2192,14 @@ sc_options_parse (int package_id, int err_priority, sc_options_t * opt,
       item = (sc_option_item_t *) sc_array_index (items, (size_t) item_index);
     }
     else {                      /* short option */
-      for (iz = 0; iz < count; ++iz) {
-        item = (sc_option_item_t *) sc_array_index (items, iz);
-        if (item->opt_char == c) {
-          break;
-        }
-      }
-      if (iz == count) {
+      if (c <= 0 || c >= 256 || opt->char_index[c] < 0) {
         SC_GEN_LOGF (package_id, SC_LC_GLOBAL, err_priority,
                      "Encountered invalid short option: -%c\n", c);
         retval = -1;
         break;
       }
+      item = (sc_option_item_t *)
+        sc_array_index_int (items, opt->char_index[c]);
     }
     SC_ASSERT (item != NULL);
 
@@ -1551,6 +2225,7 @@ sc_options_parse (int package_id, int err_priority, sc_options_t * opt,
       }
       break;
     case SC_OPTION_INT:
+      errno = 0;
       ilong = strtol (optarg, NULL, 0);
       if (ilong < (long) INT_MIN || ilong > (long) INT_MAX || errno == ERANGE) {
         SC_GEN_LOGF (package_id, SC_LC_GLOBAL, err_priority,
@@ -1562,6 +2237,7 @@ sc_options_parse (int package_id, int err_priority, sc_options_t * opt,
       }
       break;
     case SC_OPTION_SIZE_T:
+      errno = 0;
 #ifndef SC_HAVE_STRTOLL
       ilonglong = (long long) strtol (optarg, NULL, 0);
 #else
@@ -1577,6 +2253,7 @@ sc_options_parse (int package_id, int err_priority, sc_options_t * opt,
       }
       break;
     case SC_OPTION_DOUBLE:
+      errno = 0;
       dbl = strtod (optarg, NULL);
       if (errno == ERANGE) {
         SC_GEN_LOGF (package_id, SC_LC_GLOBAL, err_priority,
@@ -1591,15 +2268,20 @@ sc_options_parse (int package_id, int err_priority, sc_options_t * opt,
       sc_options_string_set ((sc_option_string_t *) item->opt_var, optarg);
       break;
     case SC_OPTION_INIFILE:
-      if (sc_options_load_ini (package_id, err_priority,
-                               opt, optarg, NULL)) {
+      if (opt->mpicomm != sc_MPI_COMM_NULL ?
+          sc_options_load_ini_collective (package_id, err_priority,
+                                          opt, optarg, opt->mpicomm) :
+          sc_options_load_ini (package_id, err_priority, opt, optarg, NULL)) {
         SC_GEN_LOGF (package_id, SC_LC_GLOBAL, err_priority,
                      "Error loading .ini file: %s\n", optarg);
         retval = -1;            /* this ends option processing */
       }
       break;
     case SC_OPTION_JSONFILE:
-      if (sc_options_load_json (package_id, err_priority,
+      if (opt->mpicomm != sc_MPI_COMM_NULL ?
+          sc_options_load_json_collective (package_id, err_priority,
+                                           opt, optarg, opt->mpicomm) :
+          sc_options_load_json (package_id, err_priority,
                                 opt, optarg, NULL)) {
         SC_GEN_LOGF (package_id, SC_LC_GLOBAL, err_priority,
                      "Error loading JSON file: %s\n", optarg);
@@ -1651,30 +2333,102 @@ sc_options_parse (int package_id, int err_priority, sc_options_t * opt,
   return opt->first_arg;
 }
 
+/** Entry of the [Arguments] section of an .ini file. */
+typedef struct sc_options_ini_arg
+{
+  long                index;    /**< Argument number or -1 for the count. */
+  const char         *value;
+}
+sc_options_ini_arg_t;
+
+/** Record the entries of the [Arguments] section in order. */
+static void
+sc_options_ini_args (const char *section, const char *key,
+                     const char *value, void *user)
+{
+  sc_options_ini_arg_t *arg;
+  long                l;
+  char               *end;
+
+  if (strcmp (section, "arguments")) {
+    return;
+  }
+  if (!strcmp (key, "count")) {
+    l = -1;
+  }
+  else {
+    /* only the canonical decimal numbers are argument keys */
+    if (!isdigit ((unsigned char) key[0]) || (key[0] == '0' && key[1])) {
+      return;
+    }
+    errno = 0;
+    l = strtol (key, &end, 10);
+    if (errno != 0 || *end != '\0' || l > (long) INT_MAX) {
+      return;
+    }
+  }
+  arg = (sc_options_ini_arg_t *) sc_array_push ((sc_array_t *) user);
+  arg->index = l;
+  arg->value = value;
+}
+
 int
 sc_options_load_args (int package_id, int err_priority, sc_options_t * opt,
                       const char *inifile)
 {
   int                 i, count;
+  int                 lineno;
   int                 iserror;
-  dictionary         *dict;
-  const char         *s;
-  char                key[BUFSIZ];
-
-  dict = iniparser_load (inifile);
-  if (dict == NULL) {
+  size_t              zz;
+  const char         *s, **values;
+  sc_options_ini_arg_t *arg;
+  sc_array_t          text, args;
+
+  sc_array_init (&text, 1);
+  sc_array_init (&args, sizeof (sc_options_ini_arg_t));
+  if (sc_options_ini_read (inifile, NULL, 0, &text) ||
+      sc_options_ini_parse (text.array, text.elem_count - 1,
+                            sc_options_ini_args, &args, &lineno)) {
     SC_GEN_LOG (package_id, SC_LC_GLOBAL, err_priority,
                 "Could not load or parse inifile\n");
+    sc_array_reset (&args);
+    sc_array_reset (&text);
     return -1;
   }
 
-  count = sc_iniparser_getint (dict, "Arguments:count", -1, &iserror);
+  /* later entries of the same key take precedence */
+  s = NULL;
+  for (zz = 0; zz < args.elem_count; ++zz) {
+    arg = (sc_options_ini_arg_t *) sc_array_index (&args, zz);
+    if (arg->index == -1) {
+      s = arg->value;
+    }
+  }
+  count = sc_options_ini_getint (s, -1, &iserror);
   if (count < 0 || iserror) {
     SC_GEN_LOG (package_id, SC_LC_GLOBAL, err_priority,
                 "Invalid or missing argument count\n");
-    iniparser_freedict (dict);
+    sc_array_reset (&args);
+    sc_array_reset (&text);
     return -1;
   }
+  values = SC_ALLOC_ZERO (const char *, count);
+  for (zz = 0; zz < args.elem_count; ++zz) {
+    arg = (sc_options_ini_arg_t *) sc_array_index (&args, zz);
+    if (0 <= arg->index && arg->index < (long) count) {
+      values[arg->index] = arg->value;
+    }
+  }
+  for (i = 0; i < count; ++i) {
+    if (values[i] == NULL) {
+      SC_GEN_LOG (package_id, SC_LC_GLOBAL, err_priority,
+                  "Invalid or missing argument count\n");
+      SC_FREE (values);
+      sc_array_reset (&args);
+      sc_array_reset (&text);
+      return -1;
+    }
+  }
 
   sc_options_free_args (opt);
   opt->args_alloced = 1;
@@ -1684,17 +2438,11 @@ sc_options_load_args (int package_id, int err_priority, sc_options_t * opt,
   memset (opt->argv, 0, count * sizeof (char *));
 
   for (i = 0; i < count; ++i) {
-    snprintf (key, BUFSIZ, "Arguments:%d", i);
-    s = iniparser_getstring (dict, key, NULL);
-    if (s == NULL) {
-      SC_GEN_LOG (package_id, SC_LC_GLOBAL, err_priority,
-                  "Invalid or missing argument count\n");
-      iniparser_freedict (dict);
-      return -1;
-    }
-    opt->argv[i] = SC_STRDUP (s);
+    opt->argv[i] = SC_STRDUP (values[i]);
   }
 
-  iniparser_freedict (dict);
+  SC_FREE (values);
+  sc_array_reset (&args);
+  sc_array_reset (&text);
   return 0;
 }
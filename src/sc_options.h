@@ -387,6 +387,45 @@ int                 sc_options_load_ini (int package_id, int err_priority,
                                          sc_options_t * opt,
                                          const char *inifile, void *re);
 
+/** Load options from the contents of a `.ini` file in memory.
+ * The contents are parsed as in \ref sc_options_load_ini, for example
+ * after receiving them by a broadcast.  The buffer is not modified.
+ * \param [in] package_id       Registered package id or -1.
+ * \param [in] err_priority     Error priority according to \ref sc_logprios.
+ * \param [in] opt              The option structure.
+ * \param [in] buffer           The contents, not necessarily NUL-terminated.
+ *                              May be NULL if \a size is 0.
+ * \param [in] size             Length of the contents in bytes.
+ * \param [in] name             Name used in error messages, may be NULL.
+ * \return                      Returns 0 on success, -1 on failure.
+ */
+int                 sc_options_load_ini_buffer (int package_id,
+                                                int err_priority,
+                                                sc_options_t * opt,
+                                                const char *buffer,
+                                                size_t size,
+                                                const char *name);
+
+/** Load a file in `.ini` format collectively.
+ * The first process of the communicator reads the file into memory and
+ * broadcasts its contents, which every process parses as in
+ * \ref sc_options_load_ini.  Thus only one process accesses the file.
+ * \param [in] package_id       Registered package id or -1.
+ * \param [in] err_priority     Error priority according to \ref sc_logprios.
+ * \param [in] opt              The option structure.
+ * \param [in] inifile          Filename of the ini file to load.
+ *                              It is only accessed on the first process.
+ * \param [in] mpicomm          Communicator of all calling processes.
+ * \return                      Returns 0 on success, -1 on failure.
+ *                              A file that cannot be read fails on all
+ *                              processes.
+ */
+int                 sc_options_load_ini_collective (int package_id,
+                                                    int err_priority,
+                                                    sc_options_t * opt,
+                                                    const char *inifile,
+                                                    sc_MPI_Comm mpicomm);
+
 /** Load a file in JSON format and update entries from object "Options".
  * An option whose name contains a colon such as "Prefix:basename" will be
  * updated by a "basename :" entry in a "Prefix" nested object.
@@ -402,6 +441,37 @@ int                 sc_options_load_json (int package_id, int err_priority,
                                           sc_options_t * opt,
                                           const char *jsonfile, void *re);
 
+/** Load a file in JSON format collectively.
+ * The first process reads the file and broadcasts its contents,
+ * which every process parses as in \ref sc_options_load_json.
+ * \param [in] package_id       Registered package id or -1.
+ * \param [in] err_priority     Error priority according to \ref sc_logprios.
+ * \param [in] opt              The option structure.
+ * \param [in] jsonfile         Filename of the JSON file to load.
+ *                              It is only accessed on the first process.
+ * \param [in] mpicomm          Communicator of all calling processes.
+ * \return                      Returns 0 on success, -1 on failure.
+ */
+int                 sc_options_load_json_collective (int package_id,
+                                                     int err_priority,
+                                                     sc_options_t * opt,
+                                                     const char *jsonfile,
+                                                     sc_MPI_Comm mpicomm);
+
+/** Read the files of \ref sc_options_add_inifile and
+ * \ref sc_options_add_jsonfile options collectively.
+ * Afterwards, \ref sc_options_parse is collective whenever such an option
+ * is given on the command line, and it calls
+ * \ref sc_options_load_ini_collective or
+ * \ref sc_options_load_json_collective on the file.
+ * \param [in,out] opt          The option structure.
+ * \param [in] mpicomm          The communicator used for reading files,
+ *                              or sc_MPI_COMM_NULL to return to reading
+ *                              the files on every process, the default.
+ */
+void                sc_options_set_collective (sc_options_t * opt,
+                                               sc_MPI_Comm mpicomm);
+
 /** Save all options and arguments to a file in `.ini` format.
  * This function must only be called after successful option parsing.
  * This function should only be called on rank 0.
@@ -430,6 +500,64 @@ int                 sc_options_load_args (int package_id, int err_priority,
                                           sc_options_t * opt,
                                           const char *inifile);
 
+/** Append the values of all options to a byte buffer.
+ * The values of switch, bool, int, size_t, double, string and keyvalue
+ * options are stored in the order the options were added; file and
+ * callback options are skipped.  The format is binary and only meant to
+ * be read by \ref sc_options_unpack on the same architecture, for example
+ * to checkpoint the configuration of a run or to send it in a message.
+ * \param [in] opt              The option structure.
+ * \param [in,out] buffer       Array of element size 1.  It is enlarged.
+ */
+void                sc_options_pack (sc_options_t * opt,
+                                     sc_array_t * buffer);
+
+/** Read the values of all options from a byte buffer.
+ * The options must have been added in the same order as for the call to
+ * \ref sc_options_pack that wrote the buffer.
+ * \param [in,out] opt          The option structure.  Its values and the
+ *                              counts of their occurrences are updated.
+ * \param [in] buffer           Array of element size 1.
+ * \param [in,out] position     On input, the byte offset into \a buffer
+ *                              to read from.  On output, the offset
+ *                              just after the values that were read.
+ * \return                      Returns 0 on success and -1 if the buffer
+ *                              is too short or has a different number
+ *                              of options.  In this case some values
+ *                              may have been updated already.
+ */
+int                 sc_options_unpack (sc_options_t * opt,
+                                       sc_array_t * buffer,
+                                       size_t *position);
+
+/** Broadcast the values of all options from one process.
+ * This allows to load configuration files on one process only, which
+ * avoids that every process accesses the file system at startup:
+ *
+ *     if (rank == 0) {
+ *       retval = sc_options_load_ini (package_id, err_priority, opt,
+ *                                     inifile, NULL);
+ *     }
+ *     sc_options_broadcast (opt, mpicomm, 0, &retval);
+ *
+ * All processes must have added the same options in the same order.
+ * The values of switch, bool, int, size_t, double, string and keyvalue
+ * options are transferred; file and callback options are ignored.
+ * This function is collective.
+ * \param [in,out] opt          The option structure.  Its values are
+ *                              updated on all processes except \a root.
+ * \param [in] mpicomm          The communicator to broadcast in.
+ * \param [in] root             The process that holds the values.
+ * \param [in,out] retval       If not NULL, the integer is broadcast too.
+ *                              This is useful for an error code of
+ *                              loading the values on \a root.
+ * \return                      Returns 0 on success and -1 if the
+ *                              options do not match those of \a root.
+ */
+int                 sc_options_broadcast (sc_options_t * opt,
+                                          sc_MPI_Comm mpicomm, int root,
+                                          int *retval);
+
 /** @} */
 
 /** Parse command line options.
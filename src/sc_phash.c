@@ -0,0 +1,385 @@
+/*
+  This file is part of the SC Library.
+  The SC Library provides support for parallel scientific applications.
+
+  Copyright (C) 2010 The University of Texas System
+  Additional copyright (C) 2011 individual authors
+
+  The SC Library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  The SC Library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with the SC Library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+  02110-1301, USA.
+*/
+
+#include <sc_phash.h>
+
+/** The number of pilot values tried per bucket. */
+#define SC_PHASH_NUM_PILOTS 65536
+
+/** The number of seeds tried before we give up on the keys. */
+#define SC_PHASH_NUM_SEEDS 32
+
+/** The number of table slots beyond the keys per thousand keys. */
+#define SC_PHASH_SLACK 30
+
+/** Marks the byte order of a written block. */
+#define SC_PHASH_BYTE_ORDER 0x0102030405060708ULL
+
+/* the final mixing of the 64-bit SplitMix generator */
+static inline uint64_t
+sc_phash_mix (uint64_t x)
+{
+  x ^= x >> 30;
+  x *= 0xbf58476d1ce4e5b9ULL;
+  x ^= x >> 27;
+  x *= 0x94d049bb133111ebULL;
+  x ^= x >> 31;
+  return x;
+}
+
+/* As in PTHash, 60 percent of the keys go into the first 30 percent of
+ * the buckets.  The large buckets are placed while most slots are free,
+ * which leaves the small ones for the end. */
+static inline size_t
+sc_phash_bucket (uint64_t h, size_t num_buckets)
+{
+  const uint64_t      x = h >> 32;
+  const size_t        dense = num_buckets * 3 / 10;
+
+  if (dense == 0) {
+    return (size_t) (x % (uint64_t) num_buckets);
+  }
+  if (x < 2576980378ULL) {
+    return (size_t) (x % (uint64_t) dense);
+  }
+  return dense + (size_t) (x % (uint64_t) (num_buckets - dense));
+}
+
+static inline size_t
+sc_phash_slot (uint64_t h, unsigned pilot, size_t table_size)
+{
+  return (size_t) (sc_phash_mix (h ^ (0x9e3779b97f4a7c15ULL *
+                                      (uint64_t) (pilot + 1))) %
+                   (uint64_t) table_size);
+}
+
+/* the size of the written block */
+static size_t
+sc_phash_block_bytes (uint64_t num_keys, uint64_t num_buckets,
+                      uint64_t table_size)
+{
+  return SC_PHASH_HEADER_BYTES +
+    (((size_t) (table_size - num_keys) * sizeof (uint32_t) +
+      (size_t) num_buckets * sizeof (uint16_t) + 7) & ~((size_t) 7));
+}
+
+/* check a header and return the size of its block or 0 if invalid */
+static size_t
+sc_phash_check_header (const uint64_t * header)
+{
+  if (memcmp (header, SC_PHASH_MAGIC, 8) ||
+      header[1] != SC_PHASH_VERSION || header[2] != SC_PHASH_BYTE_ORDER ||
+      header[3] == 0 || header[6] < header[4] ||
+      header[4] > (uint64_t) UINT32_MAX ||
+      (header[4] > 0) != (header[5] > 0)) {
+    return 0;
+  }
+  return sc_phash_block_bytes (header[4], header[5], header[6]);
+}
+
+/* check a block and refer to it without copying */
+static sc_phash_t  *
+sc_phash_parse (const char *data, size_t bytes)
+{
+  const uint64_t     *header = (const uint64_t *) data;
+  size_t              block_bytes;
+  sc_phash_t         *phash;
+
+  if (data == NULL || ((size_t) data & 7) != 0 ||
+      bytes < SC_PHASH_HEADER_BYTES ||
+      (block_bytes = sc_phash_check_header (header)) == 0 ||
+      bytes < block_bytes) {
+    return NULL;
+  }
+
+  phash = SC_ALLOC (sc_phash_t, 1);
+  phash->key_size = (size_t) header[3];
+  phash->num_keys = (size_t) header[4];
+  phash->num_buckets = (size_t) header[5];
+  phash->table_size = (size_t) header[6];
+  phash->seed = header[7];
+  phash->remap = (const uint32_t *) (data + SC_PHASH_HEADER_BYTES);
+  phash->pilots = (const uint16_t *)
+    (phash->remap + (phash->table_size - phash->num_keys));
+  phash->data = data;
+  phash->data_bytes = block_bytes;
+  phash->owned = NULL;
+
+  return phash;
+}
+
+/* Assign the pilots and the remapping for one seed.  Return 1 on success,
+ * 0 to try another seed and -1 if there are duplicate keys. */
+static int
+sc_phash_build (sc_array_t * keys, uint64_t seed, size_t num_buckets,
+                size_t table_size, uint16_t * pilots, uint32_t * remap)
+{
+  const size_t        n = keys->elem_count;
+  int                 retval;
+  unsigned            pilot;
+  size_t              iz, jz, kz, b, s, max_size, pos;
+  size_t             *offsets, *by_size, *sorted, *order, *slots;
+  uint64_t           *hashes, *bucket_hashes;
+  char               *taken;
+
+  /* sort the hash values of the keys into their buckets */
+  hashes = SC_ALLOC (uint64_t, n);
+  offsets = SC_ALLOC_ZERO (size_t, num_buckets + 1);
+  for (iz = 0; iz < n; ++iz) {
+    hashes[iz] = sc_hash_bytes64 (sc_array_index (keys, iz),
+                                  keys->elem_size, seed);
+    ++offsets[sc_phash_bucket (hashes[iz], num_buckets) + 1];
+  }
+  max_size = 0;
+  for (b = 0; b < num_buckets; ++b) {
+    max_size = SC_MAX (max_size, offsets[b + 1]);
+    offsets[b + 1] += offsets[b];
+  }
+  order = SC_ALLOC (size_t, n);
+  bucket_hashes = SC_ALLOC (uint64_t, n);
+  for (iz = 0; iz < n; ++iz) {
+    b = sc_phash_bucket (hashes[iz], num_buckets);
+    order[offsets[b]] = iz;
+    bucket_hashes[offsets[b]++] = hashes[iz];
+  }
+  for (b = num_buckets; b > 0; --b) {
+    offsets[b] = offsets[b - 1];
+  }
+  offsets[0] = 0;
+  SC_FREE (hashes);
+
+  /* order the buckets by decreasing size */
+  by_size = SC_ALLOC_ZERO (size_t, max_size + 2);
+  for (b = 0; b < num_buckets; ++b) {
+    ++by_size[max_size - (offsets[b + 1] - offsets[b]) + 1];
+  }
+  for (s = 0; s <= max_size; ++s) {
+    by_size[s + 1] += by_size[s];
+  }
+  sorted = SC_ALLOC (size_t, num_buckets);
+  for (b = 0; b < num_buckets; ++b) {
+    sorted[by_size[max_size - (offsets[b + 1] - offsets[b])]++] = b;
+  }
+  SC_FREE (by_size);
+  slots = SC_ALLOC (size_t, SC_MAX (max_size, 1));
+
+  /* find the first pilot placing all keys of a bucket into free slots */
+  retval = 1;
+  taken = SC_ALLOC_ZERO (char, table_size);
+  for (kz = 0; kz < num_buckets && retval == 1; ++kz) {
+    b = sorted[kz];
+    s = offsets[b + 1] - offsets[b];
+    if (s == 0) {
+      break;
+    }
+    for (pilot = 0; pilot < SC_PHASH_NUM_PILOTS; ++pilot) {
+      for (iz = 0; iz < s; ++iz) {
+        pos = sc_phash_slot (bucket_hashes[offsets[b] + iz], pilot,
+                             table_size);
+        if (taken[pos]) {
+          break;
+        }
+        for (jz = 0; jz < iz && slots[jz] != pos; ++jz);
+        if (jz < iz) {
+          break;
+        }
+        slots[iz] = pos;
+      }
+      if (iz == s) {
+        break;
+      }
+    }
+    if (pilot == SC_PHASH_NUM_PILOTS) {
+      /* equal hash values never separate, so check for equal keys */
+      retval = 0;
+      for (iz = offsets[b]; iz < offsets[b + 1] && retval == 0; ++iz) {
+        for (jz = offsets[b]; jz < iz; ++jz) {
+          if (bucket_hashes[iz] == bucket_hashes[jz] &&
+              !memcmp (sc_array_index (keys, order[iz]),
+                       sc_array_index (keys, order[jz]), keys->elem_size)) {
+            retval = -1;
+            break;
+          }
+        }
+      }
+      break;
+    }
+    pilots[b] = (uint16_t) pilot;
+    for (iz = 0; iz < s; ++iz) {
+      taken[slots[iz]] = 1;
+    }
+  }
+
+  /* the slots beyond the key count take the free slots below */
+  if (retval == 1) {
+    jz = 0;
+    for (pos = n; pos < table_size; ++pos) {
+      remap[pos - n] = 0;
+      if (taken[pos]) {
+        while (taken[jz]) {
+          ++jz;
+        }
+        SC_ASSERT (jz < n);
+        remap[pos - n] = (uint32_t) jz++;
+      }
+    }
+  }
+
+  SC_FREE (taken);
+  SC_FREE (slots);
+  SC_FREE (sorted);
+  SC_FREE (bucket_hashes);
+  SC_FREE (order);
+  SC_FREE (offsets);
+  return retval;
+}
+
+sc_phash_t         *
+sc_phash_new (sc_array_t * keys)
+{
+  const size_t        n = keys->elem_count;
+  int                 attempt, retval;
+  size_t              num_buckets, table_size, block_bytes;
+  uint64_t            seed, *header;
+  char               *data;
+  sc_phash_t         *phash;
+
+  SC_ASSERT (keys->elem_size > 0);
+  SC_ASSERT (n <= (size_t) UINT32_MAX);
+
+  /* a few more slots than keys speed up placing the last buckets */
+  num_buckets = (n + SC_PHASH_BUCKET_KEYS - 1) / SC_PHASH_BUCKET_KEYS;
+  table_size = n + (n * SC_PHASH_SLACK + 999) / 1000;
+  block_bytes = sc_phash_block_bytes (n, num_buckets, table_size);
+  data = SC_ALLOC_ZERO (char, block_bytes);
+  header = (uint64_t *) data;
+
+  retval = 0;
+  seed = 0;
+  for (attempt = 0; attempt < SC_PHASH_NUM_SEEDS && retval == 0; ++attempt) {
+    seed = sc_phash_mix ((uint64_t) attempt + 1);
+    retval = sc_phash_build (keys, seed, num_buckets, table_size,
+                             (uint16_t *) (data + SC_PHASH_HEADER_BYTES +
+                                           (table_size - n) *
+                                           sizeof (uint32_t)),
+                             (uint32_t *) (data + SC_PHASH_HEADER_BYTES));
+  }
+  if (retval != 1) {
+    SC_FREE (data);
+    return NULL;
+  }
+
+  memcpy (data, SC_PHASH_MAGIC, 8);
+  header[1] = SC_PHASH_VERSION;
+  header[2] = SC_PHASH_BYTE_ORDER;
+  header[3] = keys->elem_size;
+  header[4] = n;
+  header[5] = num_buckets;
+  header[6] = table_size;
+  header[7] = seed;
+
+  phash = sc_phash_parse (data, block_bytes);
+  SC_ASSERT (phash != NULL);
+  phash->owned = data;
+  return phash;
+}
+
+sc_phash_t         *
+sc_phash_new_view (const void *data, size_t bytes)
+{
+  return sc_phash_parse ((const char *) data, bytes);
+}
+
+sc_phash_t         *
+sc_phash_read (sc_io_source_t * source)
+{
+  size_t              avail, block_bytes;
+  uint64_t            header[SC_PHASH_HEADER_BYTES / 8];
+  const char         *peek;
+  char               *data;
+  sc_phash_t         *phash;
+
+  /* use the data of the source in place if we can */
+  peek = sc_io_source_peek (source, &avail);
+  if (peek != NULL && ((size_t) peek & 7) == 0) {
+    phash = sc_phash_parse (peek, avail);
+    if (phash != NULL &&
+        sc_io_source_read (source, NULL, phash->data_bytes, NULL)) {
+      sc_phash_destroy (phash);
+      phash = NULL;
+    }
+    return phash;
+  }
+
+  /* otherwise read the header to find out the size of the block */
+  if (sc_io_source_read (source, header, SC_PHASH_HEADER_BYTES, NULL) ||
+      (block_bytes = sc_phash_check_header (header)) == 0) {
+    return NULL;
+  }
+  data = SC_ALLOC (char, block_bytes);
+  memcpy (data, header, SC_PHASH_HEADER_BYTES);
+  if (sc_io_source_read (source, data + SC_PHASH_HEADER_BYTES,
+                         block_bytes - SC_PHASH_HEADER_BYTES, NULL)) {
+    SC_FREE (data);
+    return NULL;
+  }
+  phash = sc_phash_parse (data, block_bytes);
+  SC_ASSERT (phash != NULL);
+  phash->owned = data;
+  return phash;
+}
+
+int
+sc_phash_write (sc_phash_t * phash, sc_io_sink_t * sink)
+{
+  return sc_io_sink_write (sink, phash->data, phash->data_bytes);
+}
+
+void
+sc_phash_destroy (sc_phash_t * phash)
+{
+  SC_FREE (phash->owned);
+  SC_FREE (phash);
+}
+
+size_t
+sc_phash_memory_used (sc_phash_t * phash)
+{
+  return sizeof (sc_phash_t) + phash->data_bytes;
+}
+
+size_t
+sc_phash_lookup (sc_phash_t * phash, const void *key)
+{
+  uint64_t            h;
+  size_t              pos;
+
+  SC_ASSERT (phash->num_keys > 0);
+
+  h = sc_hash_bytes64 (key, phash->key_size, phash->seed);
+  pos = sc_phash_slot (h, phash->pilots[sc_phash_bucket
+                                        (h, phash->num_buckets)],
+                       phash->table_size);
+  return pos < phash->num_keys ? pos :
+    (size_t) phash->remap[pos - phash->num_keys];
+}
@@ -0,0 +1,154 @@
+/*
+  This file is part of the SC Library.
+  The SC Library provides support for parallel scientific applications.
+
+  Copyright (C) 2010 The University of Texas System
+  Additional copyright (C) 2011 individual authors
+
+  The SC Library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  The SC Library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with the SC Library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+  02110-1301, USA.
+*/
+
+#ifndef SC_PHASH_H
+#define SC_PHASH_H
+
+/** \file sc_phash.h
+ *
+ * Minimal perfect hash function for a static set of keys.
+ *
+ * A perfect hash maps each of n distinct keys to its own number in
+ * [0, n) without storing the keys.  It is built once from an array of
+ * fixed-size keys and answers a lookup by one hash of the key and one
+ * access to a small table, which makes it suited for read-only tables
+ * that are queried often: the values of the keys may be stored in an
+ * array indexed by the perfect hash.  Keys outside of the set are mapped
+ * to an arbitrary number in [0, n), so membership must be checked
+ * against a stored key if it is in doubt.
+ *
+ * The construction follows the hash-and-displace scheme of the CHD and
+ * PTHash algorithms.  The keys are distributed into buckets of
+ * \ref SC_PHASH_BUCKET_KEYS keys on average.  In order of decreasing size,
+ * each bucket is assigned the smallest 16-bit pilot value that places all
+ * of its keys into free slots of a table three percent larger than n.
+ * Slots at or beyond n are finally remapped to the free slots below n.
+ * This uses 16 / \ref SC_PHASH_BUCKET_KEYS bits per key for the pilots
+ * and one bit per key for the remapping.  The key count is limited to
+ * 2^32 - 1.
+ *
+ * A perfect hash is written to an \ref sc_io_sink_t as one block in the
+ * byte order of the machine.  It can be used in place, for example from
+ * a file mapped into memory through an \ref sc_io_source_t of type
+ * \ref SC_IO_TYPE_MMAP.
+ *
+ * \ingroup sc_containers
+ */
+
+#include <sc_io.h>
+
+/** The average number of keys in a bucket. */
+#define SC_PHASH_BUCKET_KEYS 6
+
+/** The first 8 bytes of a written perfect hash including a terminating NUL.
+ */
+#define SC_PHASH_MAGIC "sc_phsh"
+
+/** The version of the format written by this library. */
+#define SC_PHASH_VERSION 1
+
+/** Size of the header of a written perfect hash in bytes. */
+#define SC_PHASH_HEADER_BYTES 64
+
+SC_EXTERN_C_BEGIN;
+
+/** The perfect hash data structure.
+ * Its fields may be read but must only be modified by the functions below.
+ */
+typedef struct sc_phash
+{
+  /* interface variables */
+  size_t              key_size;         /**< size of one key in bytes */
+  size_t              num_keys;         /**< the size of the key set */
+
+  /* implementation variables */
+  size_t              num_buckets;
+  size_t              table_size;       /**< at least num_keys */
+  uint64_t            seed;     /**< seed of the key hash */
+  const uint32_t     *remap;    /**< free slots for table_size - num_keys */
+  const uint16_t     *pilots;   /**< one pilot per bucket */
+  const char         *data;     /**< the block in the written format */
+  size_t              data_bytes;       /**< size of the block */
+  char               *owned;    /**< data if allocated, otherwise NULL */
+}
+sc_phash_t;
+
+/** Build a perfect hash function for a set of keys.
+ * \param [in] keys         Array of distinct keys.  The element size of
+ *                          the array is the key size, which is positive.
+ *                          All bytes of a key are significant.
+ * \return                  The perfect hash, or NULL if the keys are
+ *                          not distinct.
+ */
+sc_phash_t         *sc_phash_new (sc_array_t * keys);
+
+/** Create a perfect hash from a written block without copying.
+ * \param [in] data         The block as written by \ref sc_phash_write,
+ *                          aligned to 8 bytes.  It must remain valid and
+ *                          unchanged until the perfect hash is destroyed.
+ * \param [in] bytes        The number of bytes available at \a data.
+ * \return                  The perfect hash, or NULL if the data is not
+ *                          a valid block of this byte order.
+ */
+sc_phash_t         *sc_phash_new_view (const void *data, size_t bytes);
+
+/** Read a perfect hash from a source.
+ * If the source data is accessible by \ref sc_io_source_peek and aligned,
+ * the perfect hash refers to it without copying and must be destroyed
+ * before the source.  Otherwise the block is read into allocated memory.
+ * \param [in,out] source   The source, positioned after the block
+ *                          on success.
+ * \return                  The perfect hash, or NULL on error.
+ */
+sc_phash_t         *sc_phash_read (sc_io_source_t * source);
+
+/** Write a perfect hash to a sink as one block.
+ * \param [in] phash        Valid perfect hash.
+ * \param [in,out] sink     The sink to write to.
+ * \return                  0 on success, nonzero on error.
+ */
+int                 sc_phash_write (sc_phash_t * phash, sc_io_sink_t * sink);
+
+/** Destroy a perfect hash and free the memory it owns.
+ * \param [in,out] phash    This perfect hash is invalid after the call.
+ */
+void                sc_phash_destroy (sc_phash_t * phash);
+
+/** Calculate the memory used by a perfect hash.
+ * \param [in] phash        Valid perfect hash.
+ * \return                  Memory used in bytes, including a block
+ *                          referred to without copying.
+ */
+size_t              sc_phash_memory_used (sc_phash_t * phash);
+
+/** Map a key to its number.
+ * \param [in] phash        Valid perfect hash with positive key count.
+ * \param [in] key          Memory of the key size of the perfect hash.
+ * \return                  The number less than phash->num_keys of a key
+ *                          of the set, or an arbitrary such number.
+ */
+size_t              sc_phash_lookup (sc_phash_t * phash, const void *key);
+
+SC_EXTERN_C_END;
+
+#endif /* !SC_PHASH_H */
@@ -27,18 +27,14 @@
 struct sc_polynom
 {
   int                 degree;   /* Degree of polynom sum_i=0^degree c_i x^i */
-  sc_array_t         *c;        /* Array of type double stores coefficients.
-                                   It holds degree < c->elem_count. */
+  int                 capacity; /* Number of coefficients c can hold.
+                                   It holds degree < capacity. */
+  double             *c;        /* Stores the coefficients, pointing either
+                                   to the member small or to allocated
+                                   memory of capacity doubles. */
+  double              small[SC_POLYNOM_SMALL_DEGREE + 1];
 };
 
-static const void  *
-sc_array_index_int_const (const sc_array_t * array, int i)
-{
-  SC_ASSERT (i >= 0 && (size_t) i < array->elem_count);
-
-  return (const void *) (array->array + (array->elem_size * (size_t) i));
-}
-
 #ifdef SC_ENABLE_DEBUG
 
 static int
@@ -51,13 +47,13 @@ sc_polynom_is_valid (const sc_polynom_t * p)
   if (p == NULL || p->degree < 0) {
     return 0;
   }
-  if (p->c->elem_size != sizeof (double) ||
-      p->c->elem_count <= (size_t) p->degree) {
+  if (p->c == NULL || p->capacity <= p->degree ||
+      (p->c == p->small) != (p->capacity == SC_POLYNOM_SMALL_DEGREE + 1)) {
     return 0;
   }
 #ifdef SC_ENABLE_DEBUG
-  for (i = p->degree + 1; i < (int) p->c->elem_count; ++i) {
-    if (*sc_polynom_coefficient_const (p, i) != -1.) {
+  for (i = p->degree + 1; i < p->capacity; ++i) {
+    if (p->c[i] != -1.) {
       return 0;
     }
   }
@@ -68,6 +64,41 @@ sc_polynom_is_valid (const sc_polynom_t * p)
 
 #endif
 
+/** Make room for the coefficients of a given degree.
+ * Storage never shrinks, so a polynomial reused as a scratch buffer
+ * stops allocating once it has reached its largest degree.
+ * The coefficients up to the current degree are preserved, all others
+ * are undefined, except in debug mode where they are set to -1.
+ */
+static void
+sc_polynom_reserve (sc_polynom_t * p, int degree)
+{
+  int                 capacity;
+#ifdef SC_ENABLE_DEBUG
+  int                 i;
+#endif
+
+  SC_ASSERT (degree >= 0);
+  if (degree < p->capacity) {
+    return;
+  }
+
+  capacity = SC_MAX (degree + 1, 2 * p->capacity);
+  if (p->c == p->small) {
+    p->c = SC_ALLOC (double, capacity);
+    memcpy (p->c, p->small, sizeof (double) * (size_t) (p->degree + 1));
+  }
+  else {
+    p->c = SC_REALLOC (p->c, double, capacity);
+  }
+#ifdef SC_ENABLE_DEBUG
+  for (i = p->capacity; i < capacity; ++i) {
+    p->c[i] = -1.;
+  }
+#endif
+  p->capacity = capacity;
+}
+
 int
 sc_polynom_degree (const sc_polynom_t * p)
 {
@@ -82,7 +113,7 @@ sc_polynom_coefficient (sc_polynom_t * p, int i)
   SC_ASSERT (sc_polynom_is_valid (p));
   SC_ASSERT (0 <= i && i <= p->degree);
 
-  return (double *) sc_array_index_int (p->c, i);
+  return p->c + i;
 }
 
 const double       *
@@ -91,7 +122,7 @@ sc_polynom_coefficient_const (const sc_polynom_t * p, int i)
   SC_ASSERT (sc_polynom_is_valid (p));
   SC_ASSERT (0 <= i && i <= p->degree);
 
-  return (const double *) sc_array_index_int_const (p->c, i);
+  return p->c + i;
 }
 
 void
@@ -99,7 +130,9 @@ sc_polynom_destroy (sc_polynom_t * p)
 {
   SC_ASSERT (sc_polynom_is_valid (p));
 
-  sc_array_destroy (p->c);
+  if (p->c != p->small) {
+    SC_FREE (p->c);
+  }
   SC_FREE (p);
 }
 
@@ -107,12 +140,24 @@ static sc_polynom_t *
 sc_polynom_new_uninitialized (int degree)
 {
   sc_polynom_t       *p;
+#ifdef SC_ENABLE_DEBUG
+  int                 i;
+#endif
 
   SC_ASSERT (degree >= 0);
 
+  /* small polynomials need a single allocation */
   p = SC_ALLOC (sc_polynom_t, 1);
+  p->degree = SC_MIN (degree, SC_POLYNOM_SMALL_DEGREE);
+  p->capacity = SC_POLYNOM_SMALL_DEGREE + 1;
+  p->c = p->small;
+#ifdef SC_ENABLE_DEBUG
+  for (i = 0; i < p->capacity; ++i) {
+    p->c[i] = -1.;
+  }
+#endif
+  sc_polynom_reserve (p, degree);
   p->degree = degree;
-  p->c = sc_array_new_size (sizeof (double), (size_t) degree + 1);
 
   SC_ASSERT (sc_polynom_is_valid (p));
   return p;
@@ -136,7 +181,7 @@ sc_polynom_new_from_coefficients (int degree, const double *coefficients)
   sc_polynom_t       *p;
 
   p = sc_polynom_new_uninitialized (degree);
-  memcpy (p->c->array, coefficients, p->c->elem_size * p->c->elem_count);
+  memcpy (p->c, coefficients, sizeof (double) * (size_t) (degree + 1));
 
   SC_ASSERT (sc_polynom_is_valid (p));
   return p;
@@ -148,39 +193,11 @@ sc_polynom_new_from_coefficients (int degree, const double *coefficients)
 sc_polynom_t       *
 sc_polynom_new_lagrange (int degree, int which, const double *points)
 {
-  int                 i;
-  double              denom, mp, mw;
-  sc_polynom_t       *p, *l;
-
-  SC_ASSERT (0 <= degree);
-  SC_ASSERT (0 <= which && which <= degree);
-
-  /* we will need these numbers */
-  denom = 1.;
-  mw = points[which];
-
-  /* begin with the unit polynom */
-  p = sc_polynom_new_constant (1.);
-
-  /* allocate memory for the linear factors */
-  l = sc_polynom_new_uninitialized (1);
-  *sc_polynom_coefficient (l, 1) = 1.;
-
-  /* multiply the linear factors and update denominator */
-  for (i = 0; i <= degree; ++i) {
-    if (i == which) {
-      continue;
-    }
-    *sc_polynom_coefficient (l, 0) = (mp = -points[i]);
-    sc_polynom_multiply (p, l);
-    denom *= mw + mp;
-  }
-  sc_polynom_destroy (l);
+  sc_polynom_t       *p;
 
-  /* divide by denominator */
-  sc_polynom_scale (p, 0, 1. / denom);
+  p = sc_polynom_new_uninitialized (0);
+  sc_polynom_set_lagrange (p, degree, which, points);
 
-  SC_ASSERT (sc_polynom_is_valid (p));
   return p;
 }
 
@@ -189,7 +206,7 @@ sc_polynom_new_from_polynom (const sc_polynom_t * q)
 {
   SC_ASSERT (sc_polynom_is_valid (q));
 
-  return sc_polynom_new_from_coefficients (q->degree, (double *) q->c->array);
+  return sc_polynom_new_from_coefficients (q->degree, q->c);
 }
 
 sc_polynom_t       *
@@ -221,47 +238,20 @@ sc_polynom_new_from_sum (const sc_polynom_t * q, const sc_polynom_t * r)
 {
   sc_polynom_t       *p;
 
-  SC_ASSERT (sc_polynom_is_valid (q));
-  SC_ASSERT (sc_polynom_is_valid (r));
-
-  if (q->degree >= r->degree) {
-    p = sc_polynom_new_from_polynom (q);
-    sc_polynom_add (p, r);
-  }
-  else {
-    p = sc_polynom_new_from_polynom (r);
-    sc_polynom_add (p, q);
-  }
+  p = sc_polynom_new_uninitialized (0);
+  sc_polynom_set_sum (p, q, r);
 
-  SC_ASSERT (sc_polynom_is_valid (p));
   return p;
 }
 
 sc_polynom_t       *
 sc_polynom_new_from_product (const sc_polynom_t * q, const sc_polynom_t * r)
 {
-  int                 degree;
-  int                 i, j, k;
-  double              sum;
   sc_polynom_t       *p;
 
-  SC_ASSERT (sc_polynom_is_valid (q));
-  SC_ASSERT (sc_polynom_is_valid (r));
-
-  p = sc_polynom_new_uninitialized (degree = q->degree + r->degree);
-
-  for (i = 0; i <= degree; ++i) {
-    sum = 0.;
-    k = SC_MIN (i, q->degree);
-    for (j = SC_MAX (0, i - r->degree); j <= k; ++j) {
-      sum +=
-        *sc_polynom_coefficient_const (q, j) *
-        *sc_polynom_coefficient_const (r, i - j);
-    }
-    *sc_polynom_coefficient (p, i) = sum;
-  }
+  p = sc_polynom_new_uninitialized (0);
+  sc_polynom_set_product (p, q, r);
 
-  SC_ASSERT (sc_polynom_is_valid (p));
   return p;
 }
 
@@ -275,12 +265,12 @@ sc_polynom_set_degree (sc_polynom_t * p, int degree)
 
 #ifdef SC_ENABLE_DEBUG
   for (i = degree; i < p->degree; ++i) {
-    *sc_polynom_coefficient (p, i + 1) = -1.;
+    p->c[i + 1] = -1.;
   }
 #endif
-  sc_array_resize (p->c, (size_t) degree + 1);
+  sc_polynom_reserve (p, degree);
   for (i = p->degree; i < degree; ++i) {
-    *sc_polynom_coefficient (p, i + 1) = 0.;
+    p->c[i + 1] = 0.;
   }
   p->degree = degree;
 
@@ -296,13 +286,150 @@ sc_polynom_set_constant (sc_polynom_t * p, double value)
   SC_ASSERT (sc_polynom_is_valid (p));
 }
 
+void
+sc_polynom_set_coefficients (sc_polynom_t * p, int degree,
+                             const double *coefficients)
+{
+  SC_ASSERT (degree >= 0);
+
+  sc_polynom_set_degree (p, degree);
+  memcpy (p->c, coefficients, sizeof (double) * (size_t) (degree + 1));
+
+  SC_ASSERT (sc_polynom_is_valid (p));
+}
+
 void
 sc_polynom_set_polynom (sc_polynom_t * p, const sc_polynom_t * q)
 {
   SC_ASSERT (sc_polynom_is_valid (q));
 
-  sc_polynom_set_degree (p, q->degree);
-  sc_array_copy (p->c, q->c);
+  if (p != q) {
+    sc_polynom_set_coefficients (p, q->degree, q->c);
+  }
+
+  SC_ASSERT (sc_polynom_is_valid (p));
+}
+
+void
+sc_polynom_set_lagrange (sc_polynom_t * p, int degree, int which,
+                         const double *points)
+{
+  int                 i, k, d;
+  double              denom, mp, mw;
+  double             *c;
+
+  SC_ASSERT (0 <= degree);
+  SC_ASSERT (0 <= which && which <= degree);
+
+  /* we will need these numbers */
+  denom = 1.;
+  mw = points[which];
+
+  /* begin with the unit polynom in the final storage */
+  sc_polynom_set_degree (p, degree);
+  c = p->c;
+  c[0] = 1.;
+
+  /* multiply the linear factors in place and update denominator */
+  for (d = 0, i = 0; i <= degree; ++i) {
+    if (i == which) {
+      continue;
+    }
+    mp = -points[i];
+    c[d + 1] = c[d];
+    for (k = d; k > 0; --k) {
+      c[k] = c[k - 1] + mp * c[k];
+    }
+    c[0] *= mp;
+    ++d;
+    denom *= mw + mp;
+  }
+  SC_ASSERT (d == degree);
+
+  /* divide by denominator */
+  mp = 1. / denom;
+  for (k = 0; k <= degree; ++k) {
+    c[k] *= mp;
+  }
+
+  SC_ASSERT (sc_polynom_is_valid (p));
+}
+
+void
+sc_polynom_set_sum (sc_polynom_t * p, const sc_polynom_t * q,
+                    const sc_polynom_t * r)
+{
+  SC_ASSERT (sc_polynom_is_valid (q));
+  SC_ASSERT (sc_polynom_is_valid (r));
+
+  if (p == r) {
+    sc_polynom_add (p, q);
+  }
+  else {
+    sc_polynom_set_polynom (p, q);
+    sc_polynom_add (p, r);
+  }
+
+  SC_ASSERT (sc_polynom_is_valid (p));
+}
+
+/** Compute the product of two polynomials into a separate array.
+ * \param [out] c       Array of q->degree + r->degree + 1 coefficients
+ *                      that must not overlap with the factors.
+ */
+static void
+sc_polynom_product_coefficients (double *_sc_restrict c,
+                                 const sc_polynom_t * q,
+                                 const sc_polynom_t * r)
+{
+  const int           degree = q->degree + r->degree;
+  int                 i, j, k;
+  double              sum;
+
+  for (i = 0; i <= degree; ++i) {
+    sum = 0.;
+    k = SC_MIN (i, q->degree);
+    for (j = SC_MAX (0, i - r->degree); j <= k; ++j) {
+      sum += q->c[j] * r->c[i - j];
+    }
+    c[i] = sum;
+  }
+}
+
+void
+sc_polynom_set_product (sc_polynom_t * p, const sc_polynom_t * q,
+                        const sc_polynom_t * r)
+{
+  int                 degree;
+  double              small[2 * SC_POLYNOM_SMALL_DEGREE + 1];
+  double             *c;
+
+  SC_ASSERT (sc_polynom_is_valid (q));
+  SC_ASSERT (sc_polynom_is_valid (r));
+
+  degree = q->degree + r->degree;
+  if (p == r) {
+    /* the product is commutative and may be formed in place of q */
+    r = q;
+    q = p;
+  }
+  if (p == q && p != r) {
+    sc_polynom_multiply (p, r);
+  }
+  else if (p != q) {
+    sc_polynom_set_degree (p, degree);
+    sc_polynom_product_coefficients (p->c, q, r);
+  }
+  else {
+    /* squaring in place needs a copy of the factor */
+    c = degree <= 2 * SC_POLYNOM_SMALL_DEGREE ? small :
+      SC_ALLOC (double, degree + 1);
+    sc_polynom_product_coefficients (c, p, p);
+    sc_polynom_set_coefficients (p, degree, c);
+    if (c != small) {
+      SC_FREE (c);
+    }
+  }
 
   SC_ASSERT (sc_polynom_is_valid (p));
 }
@@ -381,11 +508,33 @@ sc_polynom_AXPY (double A, const sc_polynom_t * X, sc_polynom_t * Y)
 void
 sc_polynom_multiply (sc_polynom_t * p, const sc_polynom_t * q)
 {
-  sc_polynom_t       *prod;
+  int                 degree;
+  int                 i, j, k;
+  double              sum;
+
+  SC_ASSERT (sc_polynom_is_valid (p));
+  SC_ASSERT (sc_polynom_is_valid (q));
 
-  prod = sc_polynom_new_from_product (p, q);
-  sc_polynom_set_polynom (p, prod);
-  sc_polynom_destroy (prod);
+  if (p == q) {
+    sc_polynom_set_product (p, p, p);
+    return;
+  }
+
+  /* coefficient i of the product only needs those of p up to i,
+     so we may overwrite p from the top without temporary storage */
+  degree = p->degree + q->degree;
+  sc_polynom_reserve (p, degree);
+  for (i = degree; i >= 0; --i) {
+    sum = 0.;
+    k = SC_MIN (i, p->degree);
+    for (j = SC_MAX (0, i - q->degree); j <= k; ++j) {
+      sum += p->c[j] * q->c[i - j];
+    }
+    p->c[i] = sum;
+  }
+  p->degree = degree;
+
+  SC_ASSERT (sc_polynom_is_valid (p));
 }
 
 double
@@ -405,6 +554,119 @@ sc_polynom_eval (const sc_polynom_t * p, double x)
   return v;
 }
 
+/** Number of points evaluated together by \ref sc_polynom_eval_points. */
+#define SC_POLYNOM_EVAL_BLOCK 64
+
+void
+sc_polynom_eval_points (const sc_polynom_t * p, size_t num_points,
+                        const double *_sc_restrict x,
+                        double *_sc_restrict values)
+{
+  int                 i;
+  int                 deg;
+  size_t              j, jb, nb;
+  double              ci;
+  const double       *xb;
+  double             *vb;
+
+  deg = sc_polynom_degree (p);
+  SC_ASSERT (deg >= 0);
+  SC_ASSERT (num_points == 0 || (x != NULL && values != NULL));
+
+  /* a block of values stays in cache while we run over the coefficients */
+  for (jb = 0; jb < num_points; jb += SC_POLYNOM_EVAL_BLOCK) {
+    nb = SC_MIN (num_points - jb, (size_t) SC_POLYNOM_EVAL_BLOCK);
+    xb = x + jb;
+    vb = values + jb;
+    ci = *sc_polynom_coefficient_const (p, deg);
+    for (j = 0; j < nb; ++j) {
+      vb[j] = ci;
+    }
+    for (i = deg - 1; i >= 0; --i) {
+      ci = *sc_polynom_coefficient_const (p, i);
+      for (j = 0; j < nb; ++j) {
+        vb[j] = xb[j] * vb[j] + ci;
+      }
+    }
+  }
+}
+
+void
+sc_polynom_lagrange_weights (int degree, const double *points,
+                             double *weights)
+{
+  int                 i, j;
+  double              w, pj;
+
+  SC_ASSERT (0 <= degree);
+  SC_ASSERT (points != NULL && weights != NULL);
+
+  for (j = 0; j <= degree; ++j) {
+    pj = points[j];
+    w = 1.;
+    for (i = 0; i <= degree; ++i) {
+      if (i != j) {
+        w *= pj - points[i];
+      }
+    }
+    SC_ASSERT (w != 0.);
+    weights[j] = 1. / w;
+  }
+}
+
+void
+sc_polynom_lagrange_eval (int degree, const double *points,
+                          const double *weights, size_t num_points,
+                          const double *x, double *_sc_restrict values)
+{
+  int                 j, hit;
+  size_t              k;
+  double              xk, s;
+  double             *own, *lk;
+  const double       *w;
+
+  SC_ASSERT (0 <= degree);
+  SC_ASSERT (points != NULL);
+  SC_ASSERT (num_points == 0 || (x != NULL && values != NULL));
+
+  own = NULL;
+  if ((w = weights) == NULL) {
+    w = own = SC_ALLOC (double, degree + 1);
+    sc_polynom_lagrange_weights (degree, points, own);
+  }
+
+  for (k = 0; k < num_points; ++k) {
+    xk = x[k];
+    lk = values + k * (size_t) (degree + 1);
+
+    /* an argument on an interpolation point has the exact unit values */
+    for (hit = -1, j = 0; j <= degree; ++j) {
+      if (xk == points[j]) {
+        hit = j;
+        break;
+      }
+    }
+    if (hit >= 0) {
+      for (j = 0; j <= degree; ++j) {
+        lk[j] = 0.;
+      }
+      lk[hit] = 1.;
+      continue;
+    }
+
+    /* the second barycentric formula is normalized to a partition of one */
+    s = 0.;
+    for (j = 0; j <= degree; ++j) {
+      s += (lk[j] = w[j] / (xk - points[j]));
+    }
+    s = 1. / s;
+    for (j = 0; j <= degree; ++j) {
+      lk[j] *= s;
+    }
+  }
+  SC_FREE (own);
+}
+
 int
 sc_polynom_roots (const sc_polynom_t * p, double *roots)
 {
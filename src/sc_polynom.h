@@ -26,6 +26,13 @@
 
 #include <sc.h>
 
+/** Polynomials up to this degree store their coefficients inline.
+ * They are created by a single allocation.  The storage of a polynomial
+ * never shrinks, so a polynomial may be reused as a scratch buffer for
+ * the sc_polynom_set_* functions below without further allocations.
+ */
+#define SC_POLYNOM_SMALL_DEGREE 8
+
 SC_EXTERN_C_BEGIN;
 
 /** Data structure is opaque */
@@ -67,7 +74,8 @@ sc_polynom_t       *sc_polynom_new (void);
 sc_polynom_t       *sc_polynom_new_constant (double c);
 
 /** Construct a Lagrange interpolation polynomial.
- * The computation is naive, successively multiplying linear factors.
+ * The coefficients are built in place by \ref sc_polynom_set_lagrange.  To evaluate all basis polynomials of a set of points, the
+ * barycentric form \ref sc_polynom_lagrange_eval is cheaper and stabler.
  * \param [in] degree           Must be non-negative.
  * \param [in] which            The index must be in [0, degree].
  * \param [in] points           A set of \a degree + 1 values.
@@ -117,6 +125,46 @@ void                sc_polynom_set_constant (sc_polynom_t * p, double value);
 void                sc_polynom_set_polynom (sc_polynom_t * p,
                                             const sc_polynom_t * q);
 
+/** Set a polynom to given monomial coefficients, reusing its storage.
+ * \param[in,out] p             A polynom that is overwritten.
+ * \param[in] degree            Degree of the polynom, >= 0.
+ * \param[in] coefficients      Monomial coefficients [0..degree].
+ */
+void                sc_polynom_set_coefficients (sc_polynom_t * p,
+                                                 int degree,
+                                                 const double
+                                                 *coefficients);
+
+/** Set a polynom to a Lagrange interpolation polynomial in place.
+ * This is the allocation-free variant of \ref sc_polynom_new_lagrange,
+ * successively multiplying linear factors into the storage of \a p.
+ * \param[in,out] p             A polynom that is overwritten.
+ * \param [in] degree           Must be non-negative.
+ * \param [in] which            The index must be in [0, degree].
+ * \param [in] points           A set of \a degree + 1 values.
+ */
+void                sc_polynom_set_lagrange (sc_polynom_t * p, int degree,
+                                             int which,
+                                             const double *points);
+
+/** Set a polynom to the sum of two others, reusing its storage.
+ * \param[in,out] p     Overwritten with q + r.  May be identical to either.
+ * \param[in] q         First summand.
+ * \param[in] r         Second summand.
+ */
+void                sc_polynom_set_sum (sc_polynom_t * p,
+                                        const sc_polynom_t * q,
+                                        const sc_polynom_t * r);
+
+/** Set a polynom to the product of two others, reusing its storage.
+ * \param[in,out] p     Overwritten with q * r.  May be identical to either.
+ * \param[in] q         First factor.
+ * \param[in] r         Second factor.
+ */
+void                sc_polynom_set_product (sc_polynom_t * p,
+                                            const sc_polynom_t * q,
+                                            const sc_polynom_t * r);
+
 /** Shift a polynom by (i.e., add) a monomial.
  * \param[in] exponent  Exponent of the monomial, >= 0.
  * \param[in] factor    Prefactor of the monomial.
@@ -152,6 +200,7 @@ void                sc_polynom_AXPY (double A, const sc_polynom_t * X,
                                      sc_polynom_t * Y);
 
 /** Modify a polynom by multiplying another.
+ * The product is computed in place without temporary storage.
  * \param[in,out] p     The polynom p will be set to p * q.
  * \param[in] q         The polynom that is multiplied with p; not changed.
  */
@@ -167,6 +216,52 @@ void                sc_polynom_multiply (sc_polynom_t * p,
  */
 double              sc_polynom_eval (const sc_polynom_t * p, double x);
 
+/** Evaluate a polynomial at many points using Horner's scheme.
+ * The points are processed in blocks with the loop over the points
+ * innermost, such that the compiler may vectorize it.
+ * \param [in] p        Valid polynomial.
+ * \param [in] num_points   Number of arguments.
+ * \param [in] x        Array of \a num_points arguments.
+ * \param [out] values  Array of \a num_points values, which must not
+ *                      overlap with \a x.
+ */
+void                sc_polynom_eval_points (const sc_polynom_t * p,
+                                            size_t num_points,
+                                            const double *x, double *values);
+
+/** Compute the barycentric weights of a set of interpolation points.
+ * The weight of point j is 1 / prod_{i \ne j} (p_j - p_i).
+ * \param [in] degree           Must be non-negative.
+ * \param [in] points           A set of \a degree + 1 distinct values.
+ * \param [out] weights         Array of \a degree + 1 weights.
+ */
+void                sc_polynom_lagrange_weights (int degree,
+                                                 const double *points,
+                                                 double *weights);
+
+/** Evaluate all Lagrange basis polynomials of a set of points at once.
+ * We use the barycentric formula and never build the coefficients.
+ * The cost is O(degree) per argument, in place of O(degree^2) for
+ * evaluating each basis polynomial of \ref sc_polynom_new_lagrange,
+ * and the values are exact where an argument equals an interpolation point.
+ * \param [in] degree           Must be non-negative.
+ * \param [in] points           A set of \a degree + 1 distinct values.
+ * \param [in] weights          The weights computed by
+ *                              \ref sc_polynom_lagrange_weights, or NULL
+ *                              to compute them internally.
+ * \param [in] num_points       Number of arguments.
+ * \param [in] x                Array of \a num_points arguments.
+ * \param [out] values          Array of \a num_points * (\a degree + 1)
+ *                              values.  The basis polynomial j at argument
+ *                              k is stored at index k * (degree + 1) + j.
+ */
+void                sc_polynom_lagrange_eval (int degree,
+                                              const double *points,
+                                              const double *weights,
+                                              size_t num_points,
+                                              const double *x,
+                                              double *values);
+
 /** Compute the roots of a polynomial up to quadratic degree.
  *
  * We use fuzzy criteria with threshold SC_1000_EPS, thus this function
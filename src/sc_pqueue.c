@@ -0,0 +1,296 @@
+/*
+  This file is part of the SC Library.
+  The SC Library provides support for parallel scientific applications.
+
+  Copyright (C) 2010 The University of Texas System
+  Additional copyright (C) 2011 individual authors
+
+  The SC Library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  The SC Library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with the SC Library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+  02110-1301, USA.
+*/
+
+#include <sc_pqueue.h>
+
+/** Position of a slot that is not in the heap. */
+#define SC_PQUEUE_NONE ((size_t) -1)
+
+struct sc_pqueue
+{
+  size_t              elem_size;
+  size_t              arity;
+  int                 (*compar) (const void *, const void *);
+  sc_array_t          slots;    /**< Element storage by handle. */
+  sc_array_t          pos;      /**< Heap position by handle. */
+  sc_array_t          heap;     /**< Handles in heap order. */
+  sc_array_t          freed;    /**< Handles available for reuse. */
+};
+
+/** Compare the elements of two handles. */
+static inline int
+sc_pqueue_less (sc_pqueue_t * pq, size_t h1, size_t h2)
+{
+  return pq->compar (pq->slots.array + h1 * pq->elem_size,
+                     pq->slots.array + h2 * pq->elem_size) < 0;
+}
+
+/** Move the handle at heap position i up to its place. */
+static void
+sc_pqueue_sift_up (sc_pqueue_t * pq, size_t i)
+{
+  size_t             *heap = (size_t *) pq->heap.array;
+  size_t             *pos = (size_t *) pq->pos.array;
+  size_t              h, p;
+
+  h = heap[i];
+  while (i > 0) {
+    p = (i - 1) / pq->arity;
+    if (!sc_pqueue_less (pq, h, heap[p])) {
+      break;
+    }
+    heap[i] = heap[p];
+    pos[heap[i]] = i;
+    i = p;
+  }
+  heap[i] = h;
+  pos[h] = i;
+}
+
+/** Move the handle at heap position i down to its place. */
+static void
+sc_pqueue_sift_down (sc_pqueue_t * pq, size_t i)
+{
+  const size_t        n = pq->heap.elem_count;
+  size_t             *heap = (size_t *) pq->heap.array;
+  size_t             *pos = (size_t *) pq->pos.array;
+  size_t              h, c, first, last, best;
+
+  h = heap[i];
+  for (;;) {
+    first = i * pq->arity + 1;
+    if (first >= n) {
+      break;
+    }
+
+    /* find the least child */
+    last = SC_MIN (first + pq->arity, n);
+    best = first;
+    for (c = first + 1; c < last; ++c) {
+      if (sc_pqueue_less (pq, heap[c], heap[best])) {
+        best = c;
+      }
+    }
+    if (!sc_pqueue_less (pq, heap[best], h)) {
+      break;
+    }
+    heap[i] = heap[best];
+    pos[heap[i]] = i;
+    i = best;
+  }
+  heap[i] = h;
+  pos[h] = i;
+}
+
+/** Restore the heap order after the element at position i changed. */
+static void
+sc_pqueue_sift (sc_pqueue_t * pq, size_t i)
+{
+  const size_t       *heap = (const size_t *) pq->heap.array;
+
+  if (i > 0 && sc_pqueue_less (pq, heap[i], heap[(i - 1) / pq->arity])) {
+    sc_pqueue_sift_up (pq, i);
+  }
+  else {
+    sc_pqueue_sift_down (pq, i);
+  }
+}
+
+sc_pqueue_t        *
+sc_pqueue_new (size_t elem_size, int arity,
+               int (*compar) (const void *, const void *))
+{
+  sc_pqueue_t        *pq;
+
+  SC_ASSERT (compar != NULL);
+  SC_ASSERT (arity <= 0 || arity >= 2);
+
+  pq = SC_ALLOC (sc_pqueue_t, 1);
+  pq->elem_size = elem_size;
+  pq->arity = (size_t) (arity > 0 ? arity : SC_PQUEUE_ARITY);
+  pq->compar = compar;
+  sc_array_init (&pq->slots, elem_size);
+  sc_array_init (&pq->pos, sizeof (size_t));
+  sc_array_init (&pq->heap, sizeof (size_t));
+  sc_array_init (&pq->freed, sizeof (size_t));
+
+  return pq;
+}
+
+sc_pqueue_t        *
+sc_pqueue_new_heapify (sc_array_t * array, int arity,
+                       int (*compar) (const void *, const void *))
+{
+  const size_t        n = array->elem_count;
+  size_t              zz, *heap, *pos;
+  sc_pqueue_t        *pq;
+
+  pq = sc_pqueue_new (array->elem_size, arity, compar);
+  sc_array_copy (&pq->slots, array);
+  sc_array_resize (&pq->pos, n);
+  sc_array_resize (&pq->heap, n);
+  heap = (size_t *) pq->heap.array;
+  pos = (size_t *) pq->pos.array;
+  for (zz = 0; zz < n; ++zz) {
+    heap[zz] = pos[zz] = zz;
+  }
+
+  /* sift down every inner node from the last one to the root */
+  if (n > 1) {
+    zz = (n - 2) / pq->arity + 1;
+    while (zz-- > 0) {
+      sc_pqueue_sift_down (pq, zz);
+    }
+  }
+
+  return pq;
+}
+
+void
+sc_pqueue_destroy (sc_pqueue_t * pq)
+{
+  sc_array_reset (&pq->slots);
+  sc_array_reset (&pq->pos);
+  sc_array_reset (&pq->heap);
+  sc_array_reset (&pq->freed);
+  SC_FREE (pq);
+}
+
+size_t
+sc_pqueue_count (sc_pqueue_t * pq)
+{
+  return pq->heap.elem_count;
+}
+
+size_t
+sc_pqueue_push (sc_pqueue_t * pq, const void *elem)
+{
+  size_t              handle, n;
+
+  /* find a slot for the element */
+  if (pq->freed.elem_count > 0) {
+    handle = *(size_t *) sc_array_pop (&pq->freed);
+  }
+  else {
+    handle = pq->slots.elem_count;
+    sc_array_push (&pq->slots);
+    sc_array_push (&pq->pos);
+  }
+  memcpy (pq->slots.array + handle * pq->elem_size, elem, pq->elem_size);
+
+  /* append it to the heap */
+  n = pq->heap.elem_count;
+  *(size_t *) sc_array_push (&pq->heap) = handle;
+  sc_pqueue_sift_up (pq, n);
+
+  return handle;
+}
+
+void               *
+sc_pqueue_top (sc_pqueue_t * pq, size_t *handle)
+{
+  size_t              h;
+
+  SC_ASSERT (pq->heap.elem_count > 0);
+
+  h = *(size_t *) pq->heap.array;
+  if (handle != NULL) {
+    *handle = h;
+  }
+  return pq->slots.array + h * pq->elem_size;
+}
+
+/** Remove the element at heap position i and free its handle. */
+static void
+sc_pqueue_remove_at (sc_pqueue_t * pq, size_t i, void *elem)
+{
+  size_t             *heap = (size_t *) pq->heap.array;
+  size_t             *pos = (size_t *) pq->pos.array;
+  size_t              h, n;
+
+  n = pq->heap.elem_count;
+  SC_ASSERT (i < n);
+  h = heap[i];
+  if (elem != NULL) {
+    memcpy (elem, pq->slots.array + h * pq->elem_size, pq->elem_size);
+  }
+  pos[h] = SC_PQUEUE_NONE;
+  *(size_t *) sc_array_push (&pq->freed) = h;
+
+  /* move the last heap entry into the gap */
+  --n;
+  if (i < n) {
+    heap[i] = heap[n];
+    pos[heap[i]] = i;
+  }
+  sc_array_resize (&pq->heap, n);
+  if (i < n) {
+    sc_pqueue_sift (pq, i);
+  }
+}
+
+size_t
+sc_pqueue_pop (sc_pqueue_t * pq, void *elem)
+{
+  size_t              h;
+
+  SC_ASSERT (pq->heap.elem_count > 0);
+
+  h = *(size_t *) pq->heap.array;
+  sc_pqueue_remove_at (pq, 0, elem);
+  return h;
+}
+
+int
+sc_pqueue_contains (sc_pqueue_t * pq, size_t handle)
+{
+  return handle < pq->pos.elem_count &&
+    ((size_t *) pq->pos.array)[handle] != SC_PQUEUE_NONE;
+}
+
+void               *
+sc_pqueue_get (sc_pqueue_t * pq, size_t handle)
+{
+  SC_ASSERT (sc_pqueue_contains (pq, handle));
+
+  return pq->slots.array + handle * pq->elem_size;
+}
+
+void
+sc_pqueue_update (sc_pqueue_t * pq, size_t handle, const void *elem)
+{
+  SC_ASSERT (sc_pqueue_contains (pq, handle));
+
+  if (elem != NULL) {
+    memcpy (pq->slots.array + handle * pq->elem_size, elem, pq->elem_size);
+  }
+  sc_pqueue_sift (pq, ((size_t *) pq->pos.array)[handle]);
+}
+
+void
+sc_pqueue_remove (sc_pqueue_t * pq, size_t handle, void *elem)
+{
+  SC_ASSERT (sc_pqueue_contains (pq, handle));
+
+  sc_pqueue_remove_at (pq, ((size_t *) pq->pos.array)[handle], elem);
+}
@@ -0,0 +1,142 @@
+/*
+  This file is part of the SC Library.
+  The SC Library provides support for parallel scientific applications.
+
+  Copyright (C) 2010 The University of Texas System
+  Additional copyright (C) 2011 individual authors
+
+  The SC Library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  The SC Library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with the SC Library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+  02110-1301, USA.
+*/
+
+#ifndef SC_PQUEUE_H
+#define SC_PQUEUE_H
+
+/** \file sc_pqueue.h
+ *
+ * A d-ary heap priority queue with handles for changing keys.
+ *
+ * The elements are stored in slots that do not move while an element is
+ * queued.  The heap itself only holds slot numbers, so sifting moves
+ * size_t's instead of whole elements.  Each queued element is identified
+ * by its slot number, called handle, which allows to update its key in
+ * place, as needed for decrease-key in graph algorithms, and to remove it.
+ * The heap is ordered such that the top element is a minimum by compar.
+ * An arity of 4 usually takes fewer cache misses than a binary heap.
+ */
+
+#include <sc_containers.h>
+
+SC_EXTERN_C_BEGIN;
+
+/** The default arity of the heap in \ref sc_pqueue_new. */
+#define SC_PQUEUE_ARITY 4
+
+/** Opaque priority queue object. */
+typedef struct sc_pqueue sc_pqueue_t;
+
+/** Create a new, empty priority queue.
+ * \param [in] elem_size    Size of one element in bytes.
+ * \param [in] arity        Number of children of each heap node, >= 2.
+ *                          If not positive, use \ref SC_PQUEUE_ARITY.
+ * \param [in] compar       Comparison function for the elements.
+ * \return                  Priority queue to free with
+ *                          \ref sc_pqueue_destroy.
+ */
+sc_pqueue_t        *sc_pqueue_new (size_t elem_size, int arity,
+                                   int (*compar) (const void *,
+                                                  const void *));
+
+/** Create a priority queue holding the elements of an array.
+ * The heap is built bottom-up in O(n) time.  The element at array
+ * position i receives the handle i.
+ * \param [in] array        Elements are copied; the array is unchanged.
+ * \param [in] arity        See \ref sc_pqueue_new.
+ * \param [in] compar       Comparison function for the elements.
+ * \return                  Priority queue to free with
+ *                          \ref sc_pqueue_destroy.
+ */
+sc_pqueue_t        *sc_pqueue_new_heapify (sc_array_t * array, int arity,
+                                           int (*compar) (const void *,
+                                                          const void *));
+
+/** Free a priority queue and all its elements. */
+void                sc_pqueue_destroy (sc_pqueue_t * pq);
+
+/** Return the number of queued elements. */
+size_t              sc_pqueue_count (sc_pqueue_t * pq);
+
+/** Add an element to the priority queue.
+ * \param [in,out] pq       The priority queue.
+ * \param [in] elem         The element is copied into the queue.
+ * \return                  Handle of the element until it leaves the queue.
+ *                          Handles of removed elements are reused.
+ */
+size_t              sc_pqueue_push (sc_pqueue_t * pq, const void *elem);
+
+/** Return a minimum element without removing it.
+ * \param [in] pq           The priority queue, must not be empty.
+ * \param [out] handle      If not NULL, set to the handle of the element.
+ * \return                  Pointer to the element inside the queue,
+ *                          valid until the next call of \ref sc_pqueue_push.
+ */
+void               *sc_pqueue_top (sc_pqueue_t * pq, size_t *handle);
+
+/** Remove a minimum element.
+ * \param [in,out] pq       The priority queue, must not be empty.
+ * \param [out] elem        If not NULL, the element is copied here.
+ * \return                  The handle that the element had.
+ */
+size_t              sc_pqueue_pop (sc_pqueue_t * pq, void *elem);
+
+/** Query whether a handle refers to a queued element.
+ * \param [in] pq           The priority queue.
+ * \param [in] handle       Any number.
+ * \return                  True if the handle refers to a queued element.
+ */
+int                 sc_pqueue_contains (sc_pqueue_t * pq, size_t handle);
+
+/** Access a queued element.
+ * If its key is modified, \ref sc_pqueue_update must be called next.
+ * The address is valid until the next call of \ref sc_pqueue_push.
+ * \param [in] pq           The priority queue.
+ * \param [in] handle       Handle of a queued element.
+ * \return                  Pointer to the element inside the queue.
+ */
+void               *sc_pqueue_get (sc_pqueue_t * pq, size_t handle);
+
+/** Change the key of a queued element and restore the heap order.
+ * The key may move in either direction; decreasing it is the
+ * decrease-key operation and takes O(log n / log arity) steps.
+ * \param [in,out] pq       The priority queue.
+ * \param [in] handle       Handle of a queued element.
+ * \param [in] elem         If not NULL, copied over the element.
+ *                          If NULL, the element has been changed in place
+ *                          through the pointer of \ref sc_pqueue_get.
+ */
+void                sc_pqueue_update (sc_pqueue_t * pq, size_t handle,
+                                      const void *elem);
+
+/** Remove a queued element by its handle.
+ * \param [in,out] pq       The priority queue.
+ * \param [in] handle       Handle of a queued element.
+ * \param [out] elem        If not NULL, the element is copied here.
+ */
+void                sc_pqueue_remove (sc_pqueue_t * pq, size_t handle,
+                                      void *elem);
+
+SC_EXTERN_C_END;
+
+#endif /* !SC_PQUEUE_H */
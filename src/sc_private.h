@@ -44,6 +44,15 @@ SC_EXTERN_C_BEGIN;
  */
 void                sc_package_rc_count_add (int package_id, int toadd);
 
+/** Select and calibrate the clock of \ref sc_clock. */
+void                sc_clock_init (void);
+
+/** Free the MPI datatypes and operation cached by sc_stats_compute. */
+void                sc_stats_free_cache (void);
+
+/** Join the threads of the pool returned by sc_taskpool_get and free it. */
+void                sc_taskpool_free_global (void);
+
 SC_EXTERN_C_END;
 
 #endif /* SC_PRIVATE_H */
@@ -0,0 +1,518 @@
+/*
+  This file is part of the SC Library.
+  The SC Library provides support for parallel scientific applications.
+
+  Copyright (C) 2010 The University of Texas System
+  Additional copyright (C) 2011 individual authors
+
+  The SC Library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  The SC Library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with the SC Library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+  02110-1301, USA.
+*/
+
+#include <sc_progress.h>
+#include <sc_notify.h>
+#ifdef SC_ENABLE_PTHREAD
+#include <pthread.h>
+#include <time.h>
+#endif
+
+struct sc_progress_op
+{
+  sc_progress_step_t  step;
+  sc_progress_finish_t finish;
+  void               *state;
+  int                 done;
+};
+
+struct sc_progress
+{
+  sc_array_t          pending;  /**< pointers to the incomplete operations */
+#ifdef SC_ENABLE_PTHREAD
+  pthread_mutex_t     mutex;    /**< protects everything above and below */
+  pthread_t           thread;
+  int                 running;
+  int                 stop;
+  long                sleep_us;
+#endif
+};
+
+static void
+sc_progress_lock (sc_progress_t * progress)
+{
+#ifdef SC_ENABLE_PTHREAD
+  int                 pth;
+
+  pth = pthread_mutex_lock (&progress->mutex);
+  SC_CHECK_ABORTF (pth == 0, "pthread_mutex_lock %d failed", pth);
+#endif
+}
+
+static void
+sc_progress_unlock (sc_progress_t * progress)
+{
+#ifdef SC_ENABLE_PTHREAD
+  int                 pth;
+
+  pth = pthread_mutex_unlock (&progress->mutex);
+  SC_CHECK_ABORTF (pth == 0, "pthread_mutex_unlock %d failed", pth);
+#endif
+}
+
+sc_progress_t      *
+sc_progress_new (void)
+{
+  sc_progress_t      *progress;
+
+  progress = SC_ALLOC_ZERO (sc_progress_t, 1);
+  sc_array_init (&progress->pending, sizeof (sc_progress_op_t *));
+#ifdef SC_ENABLE_PTHREAD
+  {
+    int                 pth;
+
+    pth = pthread_mutex_init (&progress->mutex, NULL);
+    SC_CHECK_ABORTF (pth == 0, "pthread_mutex_init %d failed", pth);
+  }
+#endif
+  return progress;
+}
+
+void
+sc_progress_destroy (sc_progress_t * progress)
+{
+  SC_ASSERT (progress != NULL);
+  SC_ASSERT (progress->pending.elem_count == 0);
+#ifdef SC_ENABLE_PTHREAD
+  SC_ASSERT (!progress->running);
+  (void) pthread_mutex_destroy (&progress->mutex);
+#endif
+
+  sc_array_reset (&progress->pending);
+  SC_FREE (progress);
+}
+
+sc_progress_op_t   *
+sc_progress_start (sc_progress_t * progress, sc_progress_step_t step,
+                   sc_progress_finish_t finish, void *state)
+{
+  sc_progress_op_t   *op;
+
+  SC_ASSERT (progress != NULL);
+  SC_ASSERT (step != NULL);
+
+  op = SC_ALLOC (sc_progress_op_t, 1);
+  op->step = step;
+  op->finish = finish;
+  op->state = state;
+
+  sc_progress_lock (progress);
+  op->done = step (state);
+  if (!op->done) {
+    *(sc_progress_op_t **) sc_array_push (&progress->pending) = op;
+  }
+  sc_progress_unlock (progress);
+  return op;
+}
+
+/** Step the pending operations.  The caller holds the lock. */
+static int
+sc_progress_poll_locked (sc_progress_t * progress)
+{
+  size_t              iz, last;
+  sc_progress_op_t  **ops;
+
+  /* completed operations are replaced by the last pending one */
+  ops = (sc_progress_op_t **) progress->pending.array;
+  for (iz = 0; iz < progress->pending.elem_count;) {
+    if (!(ops[iz]->done = ops[iz]->step (ops[iz]->state))) {
+      ++iz;
+      continue;
+    }
+    last = progress->pending.elem_count - 1;
+    ops[iz] = ops[last];
+    progress->pending.elem_count = last;
+  }
+  return (int) progress->pending.elem_count;
+}
+
+int
+sc_progress_poll (sc_progress_t * progress)
+{
+  int                 num_pending;
+
+  SC_ASSERT (progress != NULL);
+
+  sc_progress_lock (progress);
+  num_pending = sc_progress_poll_locked (progress);
+  sc_progress_unlock (progress);
+  return num_pending;
+}
+
+int
+sc_progress_test (sc_progress_t * progress, sc_progress_op_t * op)
+{
+  int                 done;
+
+  SC_ASSERT (progress != NULL);
+  SC_ASSERT (op != NULL);
+
+  sc_progress_lock (progress);
+  if (!(done = op->done)) {
+    sc_progress_poll_locked (progress);
+    done = op->done;
+  }
+  sc_progress_unlock (progress);
+  return done;
+}
+
+void
+sc_progress_wait (sc_progress_t * progress, sc_progress_op_t * op)
+{
+  while (!sc_progress_test (progress, op)) {
+    /* keep polling */
+  }
+  if (op->finish != NULL) {
+    op->finish (op->state);
+  }
+  SC_FREE (op);
+}
+
+/*== Requests ==*/
+
+typedef struct sc_progress_requests
+{
+  int                 num_requests;
+  sc_MPI_Request     *requests;
+}
+sc_progress_requests_t;
+
+static int
+sc_progress_requests_step (void *state)
+{
+  int                 mpiret, flag;
+  sc_progress_requests_t *reqs = (sc_progress_requests_t *) state;
+
+  mpiret = sc_MPI_Testall (reqs->num_requests, reqs->requests, &flag,
+                           sc_MPI_STATUSES_IGNORE);
+  SC_CHECK_MPI (mpiret);
+  return flag;
+}
+
+static void
+sc_progress_requests_finish (void *state)
+{
+  sc_progress_requests_t *reqs = (sc_progress_requests_t *) state;
+
+  SC_FREE (reqs->requests);
+  SC_FREE (reqs);
+}
+
+sc_progress_op_t   *
+sc_progress_requests (sc_progress_t * progress, int num_requests,
+                      sc_MPI_Request * requests)
+{
+  sc_progress_requests_t *reqs;
+
+  SC_ASSERT (num_requests >= 0);
+  SC_ASSERT (num_requests == 0 || requests != NULL);
+
+  reqs = SC_ALLOC (sc_progress_requests_t, 1);
+  reqs->num_requests = num_requests;
+  reqs->requests = SC_ALLOC (sc_MPI_Request, num_requests);
+  if (num_requests > 0) {
+    memcpy (reqs->requests, requests,
+            (size_t) num_requests * sizeof (sc_MPI_Request));
+  }
+  return sc_progress_start (progress, sc_progress_requests_step,
+                            sc_progress_requests_finish, reqs);
+}
+
+sc_progress_op_t   *
+sc_progress_allreduce (sc_progress_t * progress, void *sendbuf,
+                       void *recvbuf, int count, sc_MPI_Datatype datatype,
+                       sc_MPI_Op op, sc_MPI_Comm mpicomm)
+{
+  int                 mpiret;
+  sc_MPI_Request      request;
+
+  mpiret = sc_MPI_Iallreduce (sendbuf, recvbuf, count, datatype, op,
+                              mpicomm, &request);
+  SC_CHECK_MPI (mpiret);
+  return sc_progress_requests (progress, 1, &request);
+}
+
+/*== Notify ==*/
+
+#if defined SC_ENABLE_MPI && MPI_VERSION >= 3
+
+typedef struct sc_progress_notify
+{
+  sc_MPI_Comm         mpicomm;
+  sc_array_t         *senders;
+  sc_array_t         *out_payload;
+  int                 msg_size;
+  int                 num_receivers;
+  int                 barrier;  /**< the barrier has been started */
+  sc_MPI_Request     *sendreqs;
+  sc_MPI_Request      barreq;
+}
+sc_progress_notify_t;
+
+/** Sort the senders and permute their payloads along. */
+static void
+sc_progress_notify_sort (sc_progress_notify_t * notify)
+{
+  int                *pair, *senders;
+  size_t              iz, num_senders;
+  sc_array_t         *pairs, *payload;
+
+  num_senders = notify->senders->elem_count;
+  senders = (int *) notify->senders->array;
+  pairs = sc_array_new_count (2 * sizeof (int), num_senders);
+  for (iz = 0; iz < num_senders; ++iz) {
+    pair = (int *) sc_array_index (pairs, iz);
+    pair[0] = senders[iz];
+    pair[1] = (int) iz;
+  }
+  sc_array_sort (pairs, sc_int_compare);
+
+  payload = NULL;
+  if (notify->out_payload != NULL && notify->msg_size > 0) {
+    payload = sc_array_new_count ((size_t) notify->msg_size, num_senders);
+    sc_array_copy (payload, notify->out_payload);
+  }
+  for (iz = 0; iz < num_senders; ++iz) {
+    pair = (int *) sc_array_index (pairs, iz);
+    senders[iz] = pair[0];
+    if (payload != NULL) {
+      memcpy (sc_array_index (notify->out_payload, iz),
+              sc_array_index_int (payload, pair[1]),
+              (size_t) notify->msg_size);
+    }
+  }
+  if (payload != NULL) {
+    sc_array_destroy (payload);
+  }
+  sc_array_destroy (pairs);
+}
+
+static int
+sc_progress_notify_step (void *state)
+{
+  int                 mpiret, flag, done;
+  char               *buf;
+  sc_MPI_Status       status;
+  sc_progress_notify_t *notify = (sc_progress_notify_t *) state;
+
+  /* receive all notifications that have arrived */
+  for (;;) {
+    mpiret = sc_MPI_Iprobe (sc_MPI_ANY_SOURCE, SC_TAG_PROGRESS_NOTIFY,
+                            notify->mpicomm, &flag, &status);
+    SC_CHECK_MPI (mpiret);
+    if (!flag) {
+      break;
+    }
+    *(int *) sc_array_push (notify->senders) = status.MPI_SOURCE;
+    buf = NULL;
+    if (notify->out_payload != NULL) {
+      buf = (char *) sc_array_push (notify->out_payload);
+    }
+    mpiret = sc_MPI_Recv (buf, notify->msg_size, sc_MPI_BYTE,
+                          status.MPI_SOURCE, SC_TAG_PROGRESS_NOTIFY,
+                          notify->mpicomm, sc_MPI_STATUS_IGNORE);
+    SC_CHECK_MPI (mpiret);
+  }
+
+  /* once our messages are matched we join the barrier */
+  if (!notify->barrier) {
+    mpiret = sc_MPI_Testall (notify->num_receivers, notify->sendreqs, &flag,
+                             sc_MPI_STATUSES_IGNORE);
+    SC_CHECK_MPI (mpiret);
+    if (flag) {
+      mpiret = MPI_Ibarrier (notify->mpicomm, &notify->barreq);
+      SC_CHECK_MPI (mpiret);
+      notify->barrier = 1;
+    }
+    return 0;
+  }
+  mpiret = sc_MPI_Test (&notify->barreq, &done, sc_MPI_STATUS_IGNORE);
+  SC_CHECK_MPI (mpiret);
+  if (done) {
+    sc_progress_notify_sort (notify);
+  }
+  return done;
+}
+
+static void
+sc_progress_notify_finish (void *state)
+{
+  sc_progress_notify_t *notify = (sc_progress_notify_t *) state;
+
+  SC_FREE (notify->sendreqs);
+  SC_FREE (notify);
+}
+
+#else
+
+static int
+sc_progress_done_step (void *state)
+{
+  return 1;
+}
+
+#endif /* SC_ENABLE_MPI && MPI_VERSION >= 3 */
+
+sc_progress_op_t   *
+sc_progress_notify (sc_progress_t * progress, sc_array_t * receivers,
+                    sc_array_t * senders, sc_array_t * in_payload,
+                    sc_array_t * out_payload, sc_MPI_Comm mpicomm)
+{
+  SC_ASSERT (receivers != NULL && receivers->elem_size == sizeof (int));
+  SC_ASSERT (senders != NULL && senders->elem_size == sizeof (int));
+  SC_ASSERT (SC_ARRAY_IS_OWNER (senders) && senders != receivers);
+  SC_ASSERT ((in_payload == NULL) == (out_payload == NULL));
+  SC_ASSERT (in_payload == NULL ||
+             (in_payload->elem_count == receivers->elem_count &&
+              in_payload->elem_size == out_payload->elem_size &&
+              SC_ARRAY_IS_OWNER (out_payload) && in_payload != out_payload));
+
+#if defined SC_ENABLE_MPI && MPI_VERSION >= 3
+  {
+    int                 mpiret, i;
+    int                *ireceivers;
+    char               *buf;
+    sc_progress_notify_t *notify;
+
+    notify = SC_ALLOC (sc_progress_notify_t, 1);
+    notify->mpicomm = mpicomm;
+    notify->senders = senders;
+    notify->out_payload = out_payload;
+    notify->msg_size = in_payload == NULL ? 0 : (int) in_payload->elem_size;
+    notify->num_receivers = (int) receivers->elem_count;
+    notify->barrier = 0;
+    notify->sendreqs = SC_ALLOC (sc_MPI_Request, notify->num_receivers);
+    notify->barreq = sc_MPI_REQUEST_NULL;
+    sc_array_truncate (senders);
+    if (out_payload != NULL) {
+      sc_array_truncate (out_payload);
+    }
+
+    /* synchronous sends complete only when they are received */
+    ireceivers = (int *) receivers->array;
+    for (i = 0; i < notify->num_receivers; ++i) {
+      buf = in_payload == NULL ? NULL :
+        (char *) sc_array_index_int (in_payload, i);
+      mpiret = MPI_Issend (buf, notify->msg_size, sc_MPI_BYTE,
+                           ireceivers[i], SC_TAG_PROGRESS_NOTIFY, mpicomm,
+                           &notify->sendreqs[i]);
+      SC_CHECK_MPI (mpiret);
+    }
+    return sc_progress_start (progress, sc_progress_notify_step,
+                              sc_progress_notify_finish, notify);
+  }
+#else
+  {
+    sc_notify_t        *notify;
+
+    /* without nonblocking barriers we notify right away */
+    notify = sc_notify_new (mpicomm);
+    sc_notify_payload (receivers, senders, in_payload, out_payload, 1,
+                       notify);
+    sc_notify_destroy (notify);
+    return sc_progress_start (progress, sc_progress_done_step, NULL, NULL);
+  }
+#endif
+}
+
+/*== Thread ==*/
+
+#ifdef SC_ENABLE_PTHREAD
+
+static void        *
+sc_progress_thread (void *arg)
+{
+  int                 stop;
+  sc_progress_t      *progress = (sc_progress_t *) arg;
+  struct timespec     pause;
+
+  pause.tv_sec = progress->sleep_us / 1000000;
+  pause.tv_nsec = (progress->sleep_us % 1000000) * 1000;
+  for (;;) {
+    sc_progress_lock (progress);
+    sc_progress_poll_locked (progress);
+    stop = progress->stop;
+    sc_progress_unlock (progress);
+    if (stop) {
+      break;
+    }
+    nanosleep (&pause, NULL);
+  }
+  return NULL;
+}
+
+#endif
+
+int
+sc_progress_thread_start (sc_progress_t * progress, long sleep_us)
+{
+  SC_ASSERT (progress != NULL);
+  SC_ASSERT (sleep_us >= 0);
+
+#ifdef SC_ENABLE_PTHREAD
+  {
+    int                 pth;
+
+    SC_ASSERT (!progress->running);
+#ifdef SC_ENABLE_MPI
+    {
+      int                 mpiret, provided;
+
+      mpiret = MPI_Query_thread (&provided);
+      SC_CHECK_MPI (mpiret);
+      if (provided < MPI_THREAD_MULTIPLE) {
+        return 0;
+      }
+    }
+#endif
+    progress->stop = 0;
+    progress->sleep_us = sleep_us;
+    pth = pthread_create (&progress->thread, NULL, sc_progress_thread,
+                          progress);
+    SC_CHECK_ABORTF (pth == 0, "pthread_create %d failed", pth);
+    progress->running = 1;
+    return 1;
+  }
+#else
+  return 0;
+#endif
+}
+
+void
+sc_progress_thread_stop (sc_progress_t * progress)
+{
+  SC_ASSERT (progress != NULL);
+
+#ifdef SC_ENABLE_PTHREAD
+  if (progress->running) {
+    int                 pth;
+
+    sc_progress_lock (progress);
+    progress->stop = 1;
+    sc_progress_unlock (progress);
+    pth = pthread_join (progress->thread, NULL);
+    SC_CHECK_ABORTF (pth == 0, "pthread_join %d failed", pth);
+    progress->running = 0;
+  }
+#endif
+}
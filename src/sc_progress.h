@@ -0,0 +1,207 @@
+/*
+  This file is part of the SC Library.
+  The SC Library provides support for parallel scientific applications.
+
+  Copyright (C) 2010 The University of Texas System
+  Additional copyright (C) 2011 individual authors
+
+  The SC Library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  The SC Library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with the SC Library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+  02110-1301, USA.
+*/
+
+#ifndef SC_PROGRESS_H
+#define SC_PROGRESS_H
+
+/** \file sc_progress.h
+ *
+ * Nonblocking communication driven by polling.
+ *
+ * A progress engine holds operations that are state machines.  Each call
+ * to \ref sc_progress_poll advances every pending operation by one step
+ * without blocking, so the application may start a communication, poll
+ * while it computes on data that does not depend on the result, and
+ * complete it later by \ref sc_progress_wait:
+ *
+ *     op = sc_progress_notify (progress, receivers, senders,
+ *                              NULL, NULL, mpicomm);
+ *     for (i = 0; i < num_interior; ++i) {
+ *       compute (i);
+ *       if (i % 64 == 0) {
+ *         sc_progress_poll (progress);
+ *       }
+ *     }
+ *     sc_progress_wait (progress, op);
+ *
+ * We provide operations for arrays of MPI requests, nonblocking
+ * allreduce and the notification of \ref sc_notify_payload by the NBX
+ * algorithm.  Other state machines are added by \ref sc_progress_start.
+ * Without MPI 3, the collectives complete when they are started.
+ *
+ * The engine may also be driven by a thread of its own, see
+ * \ref sc_progress_thread_start.
+ */
+
+#include <sc_containers.h>
+
+SC_EXTERN_C_BEGIN;
+
+/** The opaque progress engine. */
+typedef struct sc_progress sc_progress_t;
+
+/** The opaque handle of one operation. */
+typedef struct sc_progress_op sc_progress_op_t;
+
+/** Advance an operation without blocking.
+ * \param [in,out] state    The state passed to \ref sc_progress_start.
+ * \return                  True if the operation is complete.  The
+ *                          function is not called again after that.
+ */
+typedef int         (*sc_progress_step_t) (void *state);
+
+/** Release the state of an operation after it completed.
+ * \param [in,out] state    The state passed to \ref sc_progress_start.
+ */
+typedef void        (*sc_progress_finish_t) (void *state);
+
+/** Create an empty progress engine.
+ * \return              The engine must be destroyed by
+ *                      \ref sc_progress_destroy.
+ */
+sc_progress_t      *sc_progress_new (void);
+
+/** Destroy a progress engine.
+ * All operations must have been completed by \ref sc_progress_wait,
+ * and its thread must have been stopped.
+ * \param [in,out] progress     The engine is freed.
+ */
+void                sc_progress_destroy (sc_progress_t * progress);
+
+/** Add an operation to a progress engine.
+ * The step function is called once right away, which allows to initiate
+ * the communication, and on every poll after that until it returns true.
+ * \param [in,out] progress     The engine.
+ * \param [in] step             Function to advance the operation.
+ * \param [in] finish           If not NULL, called by \ref
+ *                              sc_progress_wait after the completion.
+ * \param [in,out] state        Passed to \b step and \b finish.
+ * \return                      The handle of the operation.  It must be
+ *                              passed to \ref sc_progress_wait once.
+ */
+sc_progress_op_t   *sc_progress_start (sc_progress_t * progress,
+                                       sc_progress_step_t step,
+                                       sc_progress_finish_t finish,
+                                       void *state);
+
+/** Advance all pending operations by one step each.
+ * \param [in,out] progress     The engine.
+ * \return                      The number of operations still pending.
+ */
+int                 sc_progress_poll (sc_progress_t * progress);
+
+/** Advance the pending operations and query one of them.
+ * \param [in,out] progress     The engine.
+ * \param [in] op               Handle of a pending or completed operation
+ *                              that has not been passed to
+ *                              \ref sc_progress_wait yet.
+ * \return                      True if \b op is complete.
+ */
+int                 sc_progress_test (sc_progress_t * progress,
+                                      sc_progress_op_t * op);
+
+/** Poll until an operation is complete and release it.
+ * The other operations of the engine advance while we wait.
+ * \param [in,out] progress     The engine.
+ * \param [in,out] op           The handle is invalid on return.
+ */
+void                sc_progress_wait (sc_progress_t * progress,
+                                      sc_progress_op_t * op);
+
+/** Start an operation that completes with a set of MPI requests.
+ * \param [in,out] progress     The engine.
+ * \param [in] num_requests     The number of requests, non-negative.
+ * \param [in] requests         These requests are copied and tested by
+ *                              the engine, which frees them on completion.
+ * \return                      The handle of the operation.
+ */
+sc_progress_op_t   *sc_progress_requests (sc_progress_t * progress,
+                                          int num_requests,
+                                          sc_MPI_Request * requests);
+
+/** Start a nonblocking allreduce.
+ * The parameters are those of MPI_Allreduce.  The buffers must not be
+ * accessed until the operation is complete.  This function is collective.
+ * \return                      The handle of the operation.
+ */
+sc_progress_op_t   *sc_progress_allreduce (sc_progress_t * progress,
+                                           void *sendbuf, void *recvbuf,
+                                           int count,
+                                           sc_MPI_Datatype datatype,
+                                           sc_MPI_Op op,
+                                           sc_MPI_Comm mpicomm);
+
+/** Start the notification of receiver ranks with an optional payload.
+ * This is the nonblocking counterpart of \ref sc_notify_payload by
+ * the NBX algorithm.  It is collective and ends with a nonblocking
+ * barrier that each process enters at a different time.  Thus, no other
+ * collective may be started on the same communicator while it is pending:
+ * use a duplicate for concurrent operations.  None of the arrays may be
+ * accessed before completion.
+ * \param [in,out] progress     The engine.
+ * \param [in] receivers        Sorted array of type int with the distinct
+ *                              ranks to notify.
+ * \param [out] senders         Array of type int that must not be a view.
+ *                              On completion it contains the ranks that
+ *                              notified this process in ascending order.
+ * \param [in] in_payload       If not NULL, one entry per receiver that
+ *                              has the same size on all processes.
+ * \param [out] out_payload     Must be NULL if and only if \b in_payload
+ *                              is.  Otherwise, an array of the same element
+ *                              size that is not a view.  On completion it
+ *                              holds the payload of each sender, in the
+ *                              order of \b senders.
+ * \param [in] mpicomm          The communicator.
+ * \return                      The handle of the operation.
+ */
+sc_progress_op_t   *sc_progress_notify (sc_progress_t * progress,
+                                        sc_array_t * receivers,
+                                        sc_array_t * senders,
+                                        sc_array_t * in_payload,
+                                        sc_array_t * out_payload,
+                                        sc_MPI_Comm mpicomm);
+
+/** Drive the engine by a progress thread.
+ * The thread polls until \ref sc_progress_thread_stop and the functions
+ * of this file may then be called concurrently from the application.
+ * Since the thread calls MPI, we require that MPI has been initialized
+ * with \ref sc_MPI_THREAD_MULTIPLE.
+ * \param [in,out] progress     The engine without a running thread.
+ * \param [in] sleep_us         Pause in microseconds after each poll.
+ * \return                      True if the thread was started.  It is not
+ *                              without SC_ENABLE_PTHREAD or the required
+ *                              thread support of MPI, in which case the
+ *                              application must poll by itself.
+ */
+int                 sc_progress_thread_start (sc_progress_t * progress,
+                                              long sleep_us);
+
+/** Stop the progress thread if one is running.
+ * The pending operations remain and may be polled by the application.
+ * \param [in,out] progress     The engine.
+ */
+void                sc_progress_thread_stop (sc_progress_t * progress);
+
+SC_EXTERN_C_END;
+
+#endif /* !SC_PROGRESS_H */
@@ -33,9 +33,14 @@
  *     and moving the NIL #define into the .c file,
  *     as well as adding protection against multiple
  *     inclusion, an extern "C", and white space.
+ *     We have added a lookup table to decode() for codes of up to FASTBITS
+ *     bits, which are most codes in typical data, and keep the fixed code
+ *     tables in the state to make sc_puff() thread safe.  This raises the
+ *     stack size to about 6K bytes.
  */
 
 #include <sc_puff.h>            /* prototype for sc_puff() */
+#include <string.h>             /* for memcpy() */
 #ifndef NIL
 #  define NIL ((unsigned char *)0)      /* for no output option */
 #endif
@@ -107,6 +112,22 @@
 #define MAXDCODES 30            /* maximum number of distance codes */
 #define MAXCODES (MAXLCODES+MAXDCODES)  /* maximum codes lengths to read */
 #define FIXLCODES 288           /* number of fixed literal/length codes */
+#define FASTBITS 9              /* code bits resolved by one table lookup */
+
+/*
+ * Huffman code decoding tables.  count[1..MAXBITS] is the number of symbols of
+ * each length, which for a canonical code are stepped through in order.
+ * symbol[] are the symbol values in canonical order, where the number of
+ * entries is the sum of the counts in count[].  The decoding process can be
+ * seen in the function decode() below.  fast[] is indexed by the next
+ * FASTBITS bits of the stream and holds symbol * 16 + length for the codes
+ * of up to FASTBITS bits and zero otherwise.
+ */
+struct huffman {
+    short *count;       /* number of symbols of each length */
+    short *symbol;      /* canonically ordered symbols */
+    short *fast;        /* lookup table of short codes */
+};
 
 /* input and output state */
 struct state {
@@ -122,6 +143,12 @@ struct state {
     int bitbuf;                 /* bit buffer */
     int bitcnt;                 /* number of bits in bit buffer */
 
+    /* fixed code tables, built on the first fixed block */
+    int fixbuilt;
+    short lencnt[MAXBITS+1], lensym[FIXLCODES], lenfast[1 << FASTBITS];
+    short distcnt[MAXBITS+1], distsym[MAXDCODES], distfast[1 << FASTBITS];
+    struct huffman lencode, distcode;
+
     /* input limit error return state for bits() and decode() */
     jmp_buf env;
 };
@@ -210,18 +237,6 @@ local int stored(struct state *s)
     return 0;
 }
 
-/*
- * Huffman code decoding tables.  count[1..MAXBITS] is the number of symbols of
- * each length, which for a canonical code are stepped through in order.
- * symbol[] are the symbol values in canonical order, where the number of
- * entries is the sum of the counts in count[].  The decoding process can be
- * seen in the function decode() below.
- */
-struct huffman {
-    short *count;       /* number of symbols of each length */
-    short *symbol;      /* canonically ordered symbols */
-};
-
 /*
  * Decode a code from the stream s using huffman table h.  Return the symbol or
  * a negative value if there is an error.  If all of the lengths are zero, i.e.
@@ -246,7 +261,7 @@ struct huffman {
  *   in the deflate format.  See the format notes for fixed() and dynamic().
  */
 #ifdef SLOW
-local int decode(struct state *s, const struct huffman *h)
+local int canonical(struct state *s, const struct huffman *h)
 {
     int len;            /* current number of bits in code */
     int code;           /* len bits being decoded */
@@ -274,7 +289,7 @@ local int decode(struct state *s, const struct huffman *h)
  * a few percent larger.
  */
 #else /* !SLOW */
-local int decode(struct state *s, const struct huffman *h)
+local int canonical(struct state *s, const struct huffman *h)
 {
     int len;            /* current number of bits in code */
     int code;           /* len bits being decoded */
@@ -319,6 +334,44 @@ local int decode(struct state *s, const struct huffman *h)
 }
 #endif /* SLOW */
 
+/*
+ * Decode a code using the lookup table of h if the code has at most FASTBITS
+ * bits and fall back to canonical() otherwise, near the end of the input, or
+ * for the invalid codes of an incomplete code.  We peek at up to two bytes
+ * ahead and give back those that hold no bits of the code.  This maintains
+ * less than eight bits in the bit buffer, as bits() expects.
+ */
+local int decode(struct state *s, const struct huffman *h)
+{
+    long val;           /* bit buffer and bytes peeked at */
+    int have;           /* number of bits in val */
+    int entry;          /* table entry for the next FASTBITS bits */
+    int len;            /* length of the code */
+    unsigned long next; /* input position after the bytes peeked at */
+
+    val = s->bitbuf;
+    have = s->bitcnt;
+    next = s->incnt;
+    while (have < FASTBITS && next < s->inlen) {
+        val |= (long)(s->in[next++]) << have;
+        have += 8;
+    }
+    entry = h->fast[val & ((1L << FASTBITS) - 1)];
+    len = entry & 15;
+    if (len == 0 || len > have)
+        return canonical(s, h);
+
+    /* give back the bytes beyond the code and drop its bits */
+    while (have - len >= 8) {
+        next--;
+        have -= 8;
+    }
+    s->incnt = next;
+    s->bitcnt = have - len;
+    s->bitbuf = (int)((val >> len) & ((1L << s->bitcnt) - 1));
+    return entry >> 4;
+}
+
 /*
  * Given the list of code lengths length[0..n-1] representing a canonical
  * Huffman code for n symbols, construct the tables required to decode those
@@ -357,6 +410,14 @@ local int construct(struct huffman *h, const short *length, int n)
     int len;            /* current length when stepping through h->count[] */
     int left;           /* number of possible codes left of current length */
     short offs[MAXBITS+1];      /* offsets in symbol table for each length */
+    int code;           /* canonical code of the current symbol */
+    int rev;            /* code with its bits reversed as in the stream */
+    int index;          /* index of the current symbol in h->symbol[] */
+    int bit;            /* bit of the code being reversed */
+    int k;              /* number of codes of the current length done */
+
+    /* an entry of zero sends decode() to canonical() */
+    memset(h->fast, 0, sizeof(short) << FASTBITS);
 
     /* count number of codes of each length */
     for (len = 0; len <= MAXBITS; len++)
@@ -388,6 +449,24 @@ local int construct(struct huffman *h, const short *length, int n)
         if (length[symbol] != 0)
             h->symbol[offs[length[symbol]]++] = symbol;
 
+    /*
+     * fill the lookup table with the short codes, where each entry is
+     * repeated for all values of the bits following the code
+     */
+    code = index = 0;
+    for (len = 1; len <= FASTBITS; len++) {
+        for (k = 0; k < h->count[len]; k++) {
+            rev = 0;
+            for (bit = 0; bit < len; bit++)
+                rev |= ((code >> bit) & 1) << (len - 1 - bit);
+            symbol = h->symbol[index++];
+            for (; rev < (1 << FASTBITS); rev += 1 << len)
+                h->fast[rev] = (short)((symbol << 4) | len);
+            code++;
+        }
+        code <<= 1;
+    }
+
     /* return zero for complete set, positive for incomplete set */
     return left;
 }
@@ -504,6 +583,15 @@ local int codes(struct state *s,
             if (s->out != NIL) {
                 if (s->outcnt + len > s->outlen)
                     return 1;
+#ifndef INFLATE_ALLOW_INVALID_DISTANCE_TOOFAR_ARRR
+                if (dist >= (unsigned)len) {
+                    /* the source does not overlap the copy */
+                    memcpy(s->out + s->outcnt, s->out + s->outcnt - dist,
+                           (size_t)len);
+                    s->outcnt += len;
+                    len = 0;
+                }
+#endif
                 while (len--) {
                     s->out[s->outcnt] =
 #ifdef INFLATE_ALLOW_INVALID_DISTANCE_TOOFAR_ARRR
@@ -549,21 +637,18 @@ local int codes(struct state *s,
  */
 local int fixed(struct state *s)
 {
-    static int virgin = 1;
-    static short lencnt[MAXBITS+1], lensym[FIXLCODES];
-    static short distcnt[MAXBITS+1], distsym[MAXDCODES];
-    static struct huffman lencode, distcode;
-
-    /* build fixed huffman tables if first call (may not be thread safe) */
-    if (virgin) {
+    /* build fixed huffman tables if first call for this state */
+    if (!s->fixbuilt) {
         int symbol;
         short lengths[FIXLCODES];
 
         /* construct lencode and distcode */
-        lencode.count = lencnt;
-        lencode.symbol = lensym;
-        distcode.count = distcnt;
-        distcode.symbol = distsym;
+        s->lencode.count = s->lencnt;
+        s->lencode.symbol = s->lensym;
+        s->lencode.fast = s->lenfast;
+        s->distcode.count = s->distcnt;
+        s->distcode.symbol = s->distsym;
+        s->distcode.fast = s->distfast;
 
         /* literal/length table */
         for (symbol = 0; symbol < 144; symbol++)
@@ -574,19 +659,19 @@ local int fixed(struct state *s)
             lengths[symbol] = 7;
         for (; symbol < FIXLCODES; symbol++)
             lengths[symbol] = 8;
-        construct(&lencode, lengths, FIXLCODES);
+        construct(&s->lencode, lengths, FIXLCODES);
 
         /* distance table */
         for (symbol = 0; symbol < MAXDCODES; symbol++)
             lengths[symbol] = 5;
-        construct(&distcode, lengths, MAXDCODES);
+        construct(&s->distcode, lengths, MAXDCODES);
 
         /* do this just once */
-        virgin = 0;
+        s->fixbuilt = 1;
     }
 
     /* decode data until end-of-block code */
-    return codes(s, &lencode, &distcode);
+    return codes(s, &s->lencode, &s->distcode);
 }
 
 /*
@@ -684,6 +769,7 @@ local int dynamic(struct state *s)
     short lengths[MAXCODES];            /* descriptor code lengths */
     short lencnt[MAXBITS+1], lensym[MAXLCODES];         /* lencode memory */
     short distcnt[MAXBITS+1], distsym[MAXDCODES];       /* distcode memory */
+    short lenfast[1 << FASTBITS], distfast[1 << FASTBITS];  /* lookups */
     struct huffman lencode, distcode;   /* length and distance codes */
     static const short order[19] =      /* permutation of code length codes */
         {16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15};
@@ -691,8 +777,10 @@ local int dynamic(struct state *s)
     /* construct lencode and distcode */
     lencode.count = lencnt;
     lencode.symbol = lensym;
+    lencode.fast = lenfast;
     distcode.count = distcnt;
     distcode.symbol = distsym;
+    distcode.fast = distfast;
 
     /* get number of lengths in each table, check lengths */
     nlen = bits(s, 5) + 257;
@@ -825,6 +913,7 @@ sc_puff (unsigned char *dest,           /* pointer to destination pointer */
     s.incnt = 0;
     s.bitbuf = 0;
     s.bitcnt = 0;
+    s.fixbuilt = 0;
 
     /* return if bits() or decode() tries to read past available input */
     if (setjmp(s.env) != 0)             /* if came back here via longjmp() */
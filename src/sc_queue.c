@@ -0,0 +1,220 @@
+/*
+  This file is part of the SC Library.
+  The SC Library provides support for parallel scientific applications.
+
+  Copyright (C) 2010 The University of Texas System
+  Additional copyright (C) 2011 individual authors
+
+  The SC Library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  The SC Library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with the SC Library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+  02110-1301, USA.
+*/
+
+#include <sc_queue.h>
+#include <sc_atomic.h>
+
+/** The distance in bytes that keeps positions off each other's line. */
+#define SC_QUEUE_CACHE_LINE 64
+
+/** One end of the queue with the last seen position of the other end. */
+typedef struct sc_queue_end
+{
+  size_t              pos;      /**< The next position to push or pop. */
+  size_t              cache;    /**< Avoids loading the other position. */
+  char                pad[SC_QUEUE_CACHE_LINE - 2 * sizeof (size_t)];
+}
+sc_queue_end_t;
+
+struct sc_queue
+{
+  /* these members are not changed after creation */
+  size_t              elem_size;
+  size_t              mask;     /**< The capacity minus one. */
+  int                 multi;
+  char               *data;
+  size_t             *ready;    /**< Position plus one once written. */
+  char                pad[SC_QUEUE_CACHE_LINE];
+
+  sc_queue_end_t      producer;
+  sc_queue_end_t      consumer;
+};
+
+sc_queue_t         *
+sc_queue_new (size_t elem_size, size_t capacity, int multi_producer)
+{
+  size_t              cap;
+  sc_queue_t         *queue;
+
+  SC_ASSERT (elem_size > 0);
+  SC_ASSERT (capacity > 0);
+
+  for (cap = 1; cap < capacity; cap <<= 1);
+
+  queue = SC_ALLOC_ZERO (sc_queue_t, 1);
+  queue->elem_size = elem_size;
+  queue->mask = cap - 1;
+  queue->multi = multi_producer;
+  queue->data = SC_ALLOC (char, cap * elem_size);
+
+  /* no position plus one is zero, so no slot is ready initially */
+  queue->ready = multi_producer ? SC_ALLOC_ZERO (size_t, cap) : NULL;
+
+  return queue;
+}
+
+void
+sc_queue_destroy (sc_queue_t * queue)
+{
+  SC_FREE (queue->ready);
+  SC_FREE (queue->data);
+  SC_FREE (queue);
+}
+
+size_t
+sc_queue_capacity (sc_queue_t * queue)
+{
+  return queue->mask + 1;
+}
+
+size_t
+sc_queue_count (sc_queue_t * queue)
+{
+  size_t              head, tail;
+
+  /* loading the head first keeps the tail from being older */
+  head = SC_ATOMIC_LOAD (&queue->consumer.pos);
+  tail = SC_ATOMIC_LOAD (&queue->producer.pos);
+  return SC_MIN (tail - head, queue->mask + 1);
+}
+
+/** Copy elements into the ring buffer in at most two pieces. */
+static void
+sc_queue_copy_in (sc_queue_t * queue, size_t pos, const void *elems,
+                  size_t k)
+{
+  const size_t        first = pos & queue->mask;
+  const size_t        n1 = SC_MIN (k, queue->mask + 1 - first);
+  const size_t        es = queue->elem_size;
+
+  memcpy (queue->data + first * es, elems, n1 * es);
+  if (n1 < k) {
+    memcpy (queue->data, (const char *) elems + n1 * es, (k - n1) * es);
+  }
+}
+
+/** Copy elements out of the ring buffer in at most two pieces. */
+static void
+sc_queue_copy_out (sc_queue_t * queue, size_t pos, void *elems, size_t k)
+{
+  const size_t        first = pos & queue->mask;
+  const size_t        n1 = SC_MIN (k, queue->mask + 1 - first);
+  const size_t        es = queue->elem_size;
+
+  memcpy (elems, queue->data + first * es, n1 * es);
+  if (n1 < k) {
+    memcpy ((char *) elems + n1 * es, queue->data, (k - n1) * es);
+  }
+}
+
+int
+sc_queue_push (sc_queue_t * queue, const void *elem)
+{
+  return sc_queue_push_batch (queue, elem, 1) == 1;
+}
+
+size_t
+sc_queue_push_batch (sc_queue_t * queue, const void *elems, size_t n)
+{
+  const size_t        cap = queue->mask + 1;
+  size_t              pos, used, k, i;
+
+  if (n == 0) {
+    return 0;
+  }
+
+  if (!queue->multi) {
+    /* the single producer owns its position and the cached head */
+    pos = queue->producer.pos;
+    if (cap - (pos - queue->producer.cache) < n) {
+      queue->producer.cache = SC_ATOMIC_LOAD (&queue->consumer.pos);
+    }
+    k = SC_MIN (n, cap - (pos - queue->producer.cache));
+    if (k == 0) {
+      return 0;
+    }
+    sc_queue_copy_in (queue, pos, elems, k);
+    SC_ATOMIC_STORE (&queue->producer.pos, pos + k);
+    return k;
+  }
+
+  /* reserve consecutive slots against the other producers */
+  pos = SC_ATOMIC_LOAD (&queue->producer.pos);
+  for (;;) {
+    used = pos - SC_ATOMIC_LOAD (&queue->consumer.pos);
+    if (used > cap) {
+      /* the consumer has passed our stale position */
+      pos = SC_ATOMIC_LOAD (&queue->producer.pos);
+      continue;
+    }
+    k = SC_MIN (n, cap - used);
+    if (k == 0) {
+      return 0;
+    }
+    if (SC_ATOMIC_CAS (&queue->producer.pos, &pos, pos + k)) {
+      break;
+    }
+  }
+
+  /* the consumer takes each slot once it is marked with its position */
+  sc_queue_copy_in (queue, pos, elems, k);
+  for (i = 0; i < k; ++i) {
+    SC_ATOMIC_STORE (&queue->ready[(pos + i) & queue->mask], pos + i + 1);
+  }
+  return k;
+}
+
+int
+sc_queue_pop (sc_queue_t * queue, void *elem)
+{
+  return sc_queue_pop_batch (queue, elem, 1) == 1;
+}
+
+size_t
+sc_queue_pop_batch (sc_queue_t * queue, void *elems, size_t n)
+{
+  size_t              pos, k;
+
+  pos = queue->consumer.pos;
+  if (!queue->multi) {
+    if (queue->consumer.cache - pos < n) {
+      queue->consumer.cache = SC_ATOMIC_LOAD (&queue->producer.pos);
+    }
+    k = SC_MIN (n, queue->consumer.cache - pos);
+  }
+  else {
+    /* a slot of the previous round is marked one capacity lower */
+    for (k = 0; k < n; ++k) {
+      if (SC_ATOMIC_LOAD (&queue->ready[(pos + k) & queue->mask]) !=
+          pos + k + 1) {
+        break;
+      }
+    }
+  }
+  if (k == 0) {
+    return 0;
+  }
+  sc_queue_copy_out (queue, pos, elems, k);
+  SC_ATOMIC_STORE (&queue->consumer.pos, pos + k);
+  return k;
+}
@@ -0,0 +1,120 @@
+/*
+  This file is part of the SC Library.
+  The SC Library provides support for parallel scientific applications.
+
+  Copyright (C) 2010 The University of Texas System
+  Additional copyright (C) 2011 individual authors
+
+  The SC Library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  The SC Library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with the SC Library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+  02110-1301, USA.
+*/
+
+#ifndef SC_QUEUE_H
+#define SC_QUEUE_H
+
+/** \file sc_queue.h
+ *
+ * Bounded lock-free queues of fixed size elements between threads.
+ *
+ * A queue is a ring buffer whose capacity is a power of two.  It is
+ * either single-producer single-consumer or multi-producer single-
+ * consumer.  In both cases exactly one thread at a time may pop.
+ * The position of the producers and that of the consumer live on
+ * separate cache lines so they do not invalidate each other.
+ * Producers of a multiple producer queue reserve slots by a compare and
+ * swap and mark each slot ready, which the consumer waits for in order.
+ *
+ * No function blocks: a push into a full queue and a pop from an empty
+ * one return zero and the caller decides whether to spin or do other
+ * work.  The batch functions move as many elements as fit at once.
+ *
+ * The queues are thread safe if SC_HAVE_ATOMIC_BUILTINS is defined,
+ * see \ref sc_atomic.h.  Otherwise they work within one thread only.
+ */
+
+#include <sc.h>
+
+SC_EXTERN_C_BEGIN;
+
+/** Opaque bounded queue. */
+typedef struct sc_queue sc_queue_t;
+
+/** Create an empty queue.
+ * \param [in] elem_size      Positive size of one element in bytes.
+ * \param [in] capacity       Minimum number of elements that fit.
+ *                            It is rounded up to a power of two.
+ * \param [in] multi_producer If true, any number of threads may push
+ *                            concurrently.  Otherwise only one thread
+ *                            at a time, which is faster.
+ * \return                    The queue is freed by \ref sc_queue_destroy.
+ */
+sc_queue_t         *sc_queue_new (size_t elem_size, size_t capacity,
+                                  int multi_producer);
+
+/** Destroy a queue whether or not it is empty.
+ * \param [in,out] queue      No thread may still access the queue.
+ */
+void                sc_queue_destroy (sc_queue_t * queue);
+
+/** Return the number of elements that fit into the queue. */
+size_t              sc_queue_capacity (sc_queue_t * queue);
+
+/** Return the number of queued elements.
+ * While other threads push or pop this is only a snapshot.
+ */
+size_t              sc_queue_count (sc_queue_t * queue);
+
+/** Copy one element into the queue if it is not full.
+ * \param [in,out] queue      Valid queue.
+ * \param [in] elem           Element of the queue's element size.
+ * \return                    True if the element has been queued.
+ */
+int                 sc_queue_push (sc_queue_t * queue, const void *elem);
+
+/** Copy as many elements of a batch into the queue as fit.
+ * The queued elements are consecutive in the queue, also with several
+ * producers, and they are the first ones of the batch.
+ * \param [in,out] queue      Valid queue.
+ * \param [in] elems          Array of \a n elements.
+ * \param [in] n              Number of elements to push.
+ * \return                    The number of elements queued, from zero
+ *                            if the queue is full up to \a n.
+ */
+size_t              sc_queue_push_batch (sc_queue_t * queue,
+                                         const void *elems, size_t n);
+
+/** Copy the oldest element out of the queue if there is one.
+ * Only the consumer thread may call this function.
+ * \param [in,out] queue      Valid queue.
+ * \param [out] elem          Receives the element.
+ * \return                    True if an element has been popped.
+ */
+int                 sc_queue_pop (sc_queue_t * queue, void *elem);
+
+/** Copy up to \a n of the oldest elements out of the queue.
+ * Only the consumer thread may call this function.  With several
+ * producers we stop at the first element that is reserved but not yet
+ * written completely.
+ * \param [in,out] queue      Valid queue.
+ * \param [out] elems         Array of room for \a n elements.
+ * \param [in] n              Maximum number of elements to pop.
+ * \return                    The number of elements popped.
+ */
+size_t              sc_queue_pop_batch (sc_queue_t * queue,
+                                        void *elems, size_t n);
+
+SC_EXTERN_C_END;
+
+#endif /* !SC_QUEUE_H */
@@ -30,22 +30,64 @@ static const uint32_t sc_rand_rc2[SC_RANDOM_ITER] =
   { 0x4b0f3b58U, 0xe874f0c3U, 0x6955c5a6U, 0x55a7ca46U };
 static const double iump = 1. / (UINT32_MAX + 1.);
 
-/** Run different versions of Poisson PRNG and compare them.
- * Going through several different mean values as specified.
- * This function returns nothing, just outputs by sc_infof.
- * \param [in,out] state        Internal state of random number generator.
- * \param [in] mean_min         Minimum mean value to be tested.
- * \param [in] mean_max         Maximum mean value to be tested.
- * \param [in] mean_steps       Varying mean in so many subintervals.
- * \param [in] n                Number of draws.
+/* The ziggurat of Marsaglia and Tsang as modified by Doornik (2005):
+   128 strips of equal area under the normal density, the base strip
+   including the tail beyond SC_RANDOM_ZIGGURAT_R.  Entry i is the right
+   edge of strip i, computed by the recursion given there. */
+#define SC_RANDOM_ZIGGURAT_C 128
+#define SC_RANDOM_ZIGGURAT_R 3.442619855899
+static const double sc_rand_zig_x[SC_RANDOM_ZIGGURAT_C + 1] = {
+  3.7130862467425505, 3.4426198558990002, 3.2230849845811416,
+  3.0832288582168683, 2.9786962526477803, 2.8943440070215289,
+  2.8231253505489105, 2.7611693723871769, 2.7061135731218195,
+  2.6564064112613597, 2.6109722484318474, 2.5690336259249378,
+  2.5300096723888275, 2.4934545220953721, 2.4590181774118305,
+  2.4264206455337498, 2.3954342780110625, 2.3658713701176386,
+  2.3375752413392368, 2.310413683698763, 2.2842740596774718,
+  2.2590595738691985, 2.2346863955909795, 2.2110814088787034,
+  2.1881804320760492, 2.1659267937489219, 2.1442701823603953,
+  2.1231657086739766, 2.1025731351892385, 2.0824562379920168,
+  2.0627822745083084, 2.0435215366550676, 2.0246469733773855,
+  2.0061338699634721, 1.9879595741276199, 1.9701032608543265,
+  1.9525457295535567, 1.9352692282966228, 1.9182573008645099,
+  1.9014946531051511, 1.884967035707759, 1.8686611409944887,
+  1.8525645117280911, 1.836665460258446, 1.8209529965961255,
+  1.8054167642192285, 1.7900469825998586, 1.7748343955860695,
+  1.7597702248995934, 1.7448461281138004, 1.7300541605637305,
+  1.7153867407136676, 1.7008366185699169, 1.6863968467791681,
+  1.6720607540976009, 1.6578219209540241, 1.6436741568628686,
+  1.6296114794706347, 1.615628095043161, 1.6017183802213781,
+  1.5878768648905761, 1.5740982160230008, 1.5603772223661689,
+  1.5467087798599104, 1.5330878776740433, 1.5195095847659401,
+  1.5059690368632033, 1.492461423781354, 1.4789819769899242,
+  1.4655259573427108, 1.4520886428892246, 1.4386653166845635,
+  1.4252512545140601, 1.4118417124470577, 1.3984319141310053,
+  1.3850170377326518, 1.3715922024273426, 1.3581524543301435,
+  1.344692751753547, 1.3312079496656273, 1.3176927832094141,
+  1.3041418501286168, 1.2905495919261964, 1.2769102735601556,
+  1.2632179614546211, 1.2494664995730682, 1.2356494832633627,
+  1.2217602305399964, 1.2077917504159497, 1.1937367078331287,
+  1.1795873846639882, 1.1653356361647524, 1.1509728421488674,
+  1.1364898520131608, 1.1218769225825422, 1.107123647534036,
+  1.0922188769072774, 1.0771506248928957, 1.0619059636948243,
+  1.0464709007640454, 1.0308302360681956, 1.0149673952513305,
+  0.99886423349298359, 0.98250080351542901, 0.9658550794011499,
+  0.94890262551130644, 0.93161619661515083, 0.91396525102303228,
+  0.89591535258093769, 0.87742742911292337, 0.85845684319381321,
+  0.83895221429757738, 0.81885390670035729, 0.79809206064405691,
+  0.77658398789475991, 0.75423066445405562, 0.73091191064248884,
+  0.70647961133543646, 0.68074791866915463, 0.65347863873997525,
+  0.6243585973360507, 0.59296294247144832, 0.55869217840818519,
+  0.52065603876206057, 0.47743783729668982, 0.42654798635542351,
+  0.36287143109703196, 0.27232086481396467, 0
+};
+
+/** The pseudo-DES rounds, a bijection of 64 bit words.
+ * They work on 32 bit words only and have no data-dependent branches,
+ * such that the loops over independent counters below vectorize.
  */
-void                sc_rand_test_poisson (sc_rand_state_t * state,
-                                          double mean_min,
-                                          double mean_max,
-                                          int mean_steps, int n);
-
-double
-sc_rand (sc_rand_state_t * state)
+static inline uint64_t
+sc_rand_des (uint64_t x)
 {
   int                 i;
   uint32_t            a, b, c;
@@ -53,10 +95,8 @@ sc_rand (sc_rand_state_t * state)
   uint32_t            ltemp, htemp;
   uint32_t            swap;
 
-  SC_ASSERT (state != NULL);
-
-  lword = *state >> 32;
-  rword = *state & 0xffffffff;
+  lword = (uint32_t) (x >> 32);
+  rword = (uint32_t) (x & 0xffffffff);
   for (i = 0; i < SC_RANDOM_ITER; ++i) {
     a = (swap = rword) ^ sc_rand_rc1[i];
     htemp = a >> 16;
@@ -66,9 +106,64 @@ sc_rand (sc_rand_state_t * state)
     rword = lword ^ (htemp * ltemp + c);
     lword = swap;
   }
-  ++(*state);
+  return ((uint64_t) lword << 32) | rword;
+}
 
-  return rword * iump;
+double
+sc_rand (sc_rand_state_t * state)
+{
+  SC_ASSERT (state != NULL);
+
+  return (uint32_t) sc_rand_des ((*state)++) * iump;
+}
+
+double
+sc_rand_at (sc_rand_state_t state, uint64_t index)
+{
+  return (uint32_t) sc_rand_des (state + index) * iump;
+}
+
+void
+sc_rand_fill (sc_rand_state_t * state, double *out, size_t n)
+{
+  const sc_rand_state_t start = *state;
+  size_t              i;
+
+  SC_ASSERT (state != NULL);
+  SC_ASSERT (out != NULL || n == 0);
+
+  for (i = 0; i < n; ++i) {
+    out[i] = (uint32_t) sc_rand_des (start + i) * iump;
+  }
+  *state = start + n;
+}
+
+void
+sc_rand_fill_streams (sc_rand_state_t * states, size_t num_streams,
+                      double *out, size_t n)
+{
+  size_t              i, s;
+
+  SC_ASSERT (states != NULL || num_streams == 0);
+  SC_ASSERT (out != NULL || n * num_streams == 0);
+
+  /* the streams are the lanes of the inner loop */
+  for (i = 0; i < n; ++i) {
+    for (s = 0; s < num_streams; ++s) {
+      out[i * num_streams + s] =
+        (uint32_t) sc_rand_des (states[s] + i) * iump;
+    }
+  }
+  for (s = 0; s < num_streams; ++s) {
+    states[s] += n;
+  }
+}
+
+sc_rand_state_t
+sc_rand_split (sc_rand_state_t seed, uint64_t stream)
+{
+  /* a bijection in the stream for every seed */
+  return sc_rand_des (sc_rand_des (seed) ^ stream);
 }
 
 double
@@ -90,6 +185,60 @@ sc_rand_normal (sc_rand_state_t * state, double *second_result)
   return u * s;
 }
 
+/* Sample the normal tail beyond r by the method of Marsaglia (1964). */
+static double
+sc_rand_normal_tail (sc_rand_state_t * state, double r, int negative)
+{
+  double              x, y;
+
+  do {
+    x = log (1. - sc_rand (state)) / r;
+    y = log (1. - sc_rand (state));
+  }
+  while (-2. * y < x * x);
+  return negative ? x - r : r - x;
+}
+
+void
+sc_rand_normal_fill (sc_rand_state_t * state, double *out, size_t n)
+{
+  const double       *zx = sc_rand_zig_x;
+  int                 i;
+  size_t              k;
+  uint64_t            bits;
+  double              u, x, f0, f1;
+
+  SC_ASSERT (state != NULL);
+  SC_ASSERT (out != NULL || n == 0);
+
+  for (k = 0; k < n; ++k) {
+    for (;;) {
+      /* one permutation yields the uniform and the strip index */
+      bits = sc_rand_des ((*state)++);
+      u = 2. * ((uint32_t) bits * iump) - 1.;
+      i = (int) (bits >> 32) & (SC_RANDOM_ZIGGURAT_C - 1);
+      x = u * zx[i];
+
+      /* most draws are inside the rectangle below the next strip */
+      if (fabs (x) < zx[i + 1]) {
+        break;
+      }
+      if (i == 0) {
+        x = sc_rand_normal_tail (state, SC_RANDOM_ZIGGURAT_R, u < 0.);
+        break;
+      }
+
+      /* accept the wedge under the density */
+      f0 = exp (-.5 * (zx[i] * zx[i] - x * x));
+      f1 = exp (-.5 * (zx[i + 1] * zx[i + 1] - x * x));
+      if (f1 + sc_rand (state) * (f0 - f1) < 1.) {
+        break;
+      }
+    }
+    out[k] = x;
+  }
+}
+
 int
 sc_rand_small (sc_rand_state_t * state, double d)
 {
@@ -132,18 +281,56 @@ sc_rand_poisson_knuth (sc_rand_state_t * state, double mean)
   return n;
 }
 
+/* The transformed rejection with squeeze of Hoermann (1993) for mean >= 10.
+   Most draws are accepted with two uniforms and no transcendental call. */
+static int
+sc_rand_poisson_ptrs (sc_rand_state_t * state, double mean)
+{
+  const double        slam = sqrt (mean);
+  const double        loglam = log (mean);
+  const double        b = .931 + 2.53 * slam;
+  const double        a = -.059 + .02483 * b;
+  const double        invalpha = 1.1239 + 1.1328 / (b - 3.4);
+  const double        vr = .9277 - 3.6224 / (b - 2.);
+  double              u, v, us, k;
+
+  SC_ASSERT (mean >= 10.);
+
+  for (;;) {
+    u = sc_rand (state) - .5;
+    v = sc_rand (state);
+    us = .5 - fabs (u);
+    k = floor ((2. * a / us + b) * u + mean + .43);
+    if (us >= .07 && v <= vr) {
+      return (int) k;
+    }
+    if (k < 0. || (us < .013 && v > us)) {
+      continue;
+    }
+    if (log (v) + log (invalpha) - log (a / (us * us) + b) <=
+        -mean + k * loglam - lgamma (k + 1.)) {
+      return (int) k;
+    }
+  }
+}
+
 int
 sc_rand_poisson (sc_rand_state_t * state, double mean)
 {
-  double              sq, lnmean, correct;
-  double              p, t, x;
-
   /* use Knuth's method for not-so-large mean values */
   if (mean < 12.) {
     return sc_rand_poisson_knuth (state, mean);
   }
+  return sc_rand_poisson_ptrs (state, mean);
+}
+
+/* The former rejection method for large means, kept for comparison. */
+static int
+sc_rand_poisson_rejection (sc_rand_state_t * state, double mean)
+{
+  double              sq, lnmean, correct;
+  double              p, t, x;
 
-  /* use rejection method */
   sq = sqrt (2. * mean);
   lnmean = log (mean);
   correct = mean * lnmean - lgamma (mean + 1.);
@@ -190,16 +377,31 @@ draw_poisson_cumulative (sc_rand_state_t * state, double *cumud, int ncumu)
   }
 }
 
-static void
+/* Count a failure if a sample deviates from its expectation by more
+   than six of its standard deviations. */
+static int
+test_deviation (const char *what, int method, double sample,
+                double expected, double sigma)
+{
+  if (fabs (sample - expected) > 6. * sigma) {
+    SC_LERRORF ("Method %d %s %g expected %g\n", method, what, sample,
+                expected);
+    return 1;
+  }
+  return 0;
+}
+
+static int
 test_poisson_mean (sc_rand_state_t * state, double mean, int n)
 {
   int                 i, k;
   int                 ncumu;
-  int                 draw[3];
+  int                 draw;
+  int                 num_failed = 0;
   double              p, cp;
   double             *cumud;
-  double              sumsv[3], sumsq[3];
-  double              meanv[3], varia[3];
+  double              sumsv, sumsq;
+  double              meanv, varia, elapsed;
 
   SC_INFOF ("Computing Poisson test for mean %g and %d draws\n", mean, n);
 
@@ -214,54 +416,109 @@ test_poisson_mean (sc_rand_state_t * state, double mean, int n)
   cp = p = exp (-mean);
   for (i = 1; i < ncumu - 1; ++i) {
     cumud[i] = cp;
-#if 0
-    if (i < 10) {
-      SC_INFOF ("Mean %g i %d p %g cumu %g\n", mean, i, p, cp);
-    }
-#endif
     cp += (p *= mean / i);
   }
   SC_ASSERT (cumud[i - 1] < 1.);
   cumud[i] = 1.;
 
-  /* draw n times */
-  for (k = 0; k < 3; ++k) {
-    sumsv[k] = sumsq[k] = 0.;
-  }
-  for (i = 0; i < n; ++i) {
-    draw[0] = draw_poisson_cumulative (state, cumud, ncumu);
-    draw[1] = sc_rand_poisson_knuth (state, mean);
-    draw[2] = sc_rand_poisson (state, mean);
-    for (k = 0; k < 3; ++k) {
-      p = (double) draw[k];
-      sumsv[k] += p;
-      sumsq[k] += p * p;
+  /* draw n times with each method that applies to this mean:
+     cumulative, Knuth, the former rejection and PTRS */
+  for (k = 0; k < 4; ++k) {
+    if ((k == 1 && mean > 700.) || (k == 2 && mean < 12.) ||
+        (k == 3 && mean < 10.)) {
+      continue;
     }
-  }
-  for (k = 0; k < 3; ++k) {
-    /* compute sampled mean and variance */
-    meanv[k] = sumsv[k] / n;
-    varia[k] = sumsq[k] / n - meanv[k] * meanv[k];
-
-    /* subtract the known mean and variance, relative */
-    meanv[k] = meanv[k] / mean - 1.;
-    varia[k] = varia[k] / mean - 1.;
-  }
+    sumsv = sumsq = 0.;
+    elapsed = -sc_MPI_Wtime ();
+    for (i = 0; i < n; ++i) {
+      draw = k == 0 ? draw_poisson_cumulative (state, cumud, ncumu) :
+        k == 1 ? sc_rand_poisson_knuth (state, mean) :
+        k == 2 ? sc_rand_poisson_rejection (state, mean) :
+        sc_rand_poisson_ptrs (state, mean);
+      p = (double) draw;
+      sumsv += p;
+      sumsq += p * p;
+    }
+    elapsed += sc_MPI_Wtime ();
 
-  /* print results */
-  for (k = 0; k < 3; ++k) {
-    SC_INFOF ("Method %d dev mean %g variance %g\n", k, meanv[k], varia[k]);
+    /* compute sampled mean and variance */
+    meanv = sumsv / n;
+    varia = sumsq / n - meanv * meanv;
+    SC_INFOF ("Method %d dev mean %g variance %g time per draw %g\n",
+              k, meanv / mean - 1., varia / mean - 1., elapsed / n);
+
+    /* the cumulative sum is cut off at five standard deviations */
+    num_failed += test_deviation ("mean", k, meanv, mean,
+                                  sqrt (mean / n));
+    num_failed += test_deviation ("variance", k, varia, mean,
+                                  mean * sqrt ((2. + 1. / mean) / n));
   }
 
   /* cleanup */
   SC_FREE (cumud);
+  return num_failed;
 }
 
-void
+static int
+test_normal (sc_rand_state_t * state, int n)
+{
+  const double        p3 = .0026997960632601866;
+  int                 i, k;
+  int                 num_failed = 0;
+  double              x, y, elapsed;
+  double              sumsv, sumsq, beyond;
+  double             *draws;
+
+  SC_INFOF ("Computing normal test for %d draws\n", n);
+
+  /* compare the polar method with the ziggurat */
+  draws = SC_ALLOC (double, n);
+  for (k = 0; k < 2; ++k) {
+    elapsed = -sc_MPI_Wtime ();
+    if (k == 0) {
+      for (i = 0; i + 1 < n; i += 2) {
+        draws[i] = sc_rand_normal (state, &y);
+        draws[i + 1] = y;
+      }
+      if (i < n) {
+        draws[i] = sc_rand_normal (state, NULL);
+      }
+    }
+    else {
+      sc_rand_normal_fill (state, draws, (size_t) n);
+    }
+    elapsed += sc_MPI_Wtime ();
+
+    /* the fraction beyond three standard deviations checks the tail */
+    sumsv = sumsq = beyond = 0.;
+    for (i = 0; i < n; ++i) {
+      x = draws[i];
+      sumsv += x;
+      sumsq += x * x;
+      beyond += fabs (x) > 3.;
+    }
+    sumsv /= n;
+    sumsq = sumsq / n - sumsv * sumsv;
+    beyond /= n;
+    SC_INFOF ("Method %d mean %g variance %g beyond 3 %g"
+              " time per draw %g\n", k, sumsv, sumsq, beyond, elapsed / n);
+    num_failed += test_deviation ("normal mean", k, sumsv, 0.,
+                                  sqrt (1. / n));
+    num_failed += test_deviation ("normal variance", k, sumsq, 1.,
+                                  sqrt (2. / n));
+    num_failed += test_deviation ("normal tail", k, beyond, p3,
+                                  sqrt (p3 * (1. - p3) / n));
+  }
+  SC_FREE (draws);
+  return num_failed;
+}
+
+int
 sc_rand_test_poisson (sc_rand_state_t * state, double mean_min,
                       double mean_max, int mean_steps, int n)
 {
   int                 i;
+  int                 num_failed = 0;
   double              mh;
 
   SC_ASSERT (0. < mean_min && mean_min <= mean_max);
@@ -271,6 +528,10 @@ sc_rand_test_poisson (sc_rand_state_t * state, double mean_min,
 
   /* test a series of mean values */
   for (i = 0; i <= mean_steps; ++i) {
-    test_poisson_mean (state, mean_min + i * mh, n);
+    num_failed += test_poisson_mean (state, mean_min + i * mh, n);
   }
+
+  /* test the normal samplers */
+  num_failed += test_normal (state, n);
+  return num_failed;
 }
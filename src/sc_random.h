@@ -41,6 +41,56 @@ typedef uint64_t    sc_rand_state_t;
  */
 double              sc_rand (sc_rand_state_t * state);
 
+/** Draw the same number as \ref sc_rand after some calls, by counter.
+ * The generator is counter-based: each number is a keyless pseudo-DES
+ * permutation of the state, which is then incremented by one.
+ * \param [in] state            State of the random number generator.
+ * \param [in] index            Number of calls to \ref sc_rand to skip.
+ * \return                      Number in [0, 1), equal to the result of
+ *                              the (\a index + 1)-th call to \ref sc_rand
+ *                              on a copy of \a state.
+ */
+double              sc_rand_at (sc_rand_state_t state, uint64_t index);
+
+/** Draw many uniformly distributed variables in [0, 1) in one call.
+ * The result is identical to \a n calls to \ref sc_rand, but
+ * the numbers are independent of each other and computed in a loop that
+ * the compiler can vectorize.
+ * \param [in,out] state        Internal state of random number generator.
+ *                              It is advanced by \a n.
+ * \param [out] out             Array of \a n numbers in [0, 1).
+ * \param [in] n                Number of variables to draw.
+ */
+void                sc_rand_fill (sc_rand_state_t * state, double *out,
+                                  size_t n);
+
+/** Draw from several independent streams in lockstep.
+ * Each stream contributes the same numbers as \ref sc_rand_fill on its
+ * own state.  The streams form the innermost vectorized loop.
+ * \param [in,out] states       Array of \a num_streams states, for example
+ *                              from \ref sc_rand_split.  Each is advanced
+ *                              by \a n.
+ * \param [in] num_streams      Number of streams.
+ * \param [out] out             Array of \a n * \a num_streams numbers.
+ *                              The k-th number of stream s is placed at
+ *                              index k * \a num_streams + s.
+ * \param [in] n                Number of variables to draw per stream.
+ */
+void                sc_rand_fill_streams (sc_rand_state_t * states,
+                                          size_t num_streams, double *out,
+                                          size_t n);
+
+/** Derive the state of an independent stream from a common seed.
+ * Without communication, each thread or process can obtain a reproducible
+ * stream, for example numbered by its global rank and thread number.
+ * Different stream numbers yield different states that start at
+ * pseudo-random positions of the period of 2^64.
+ * \param [in] seed             The seed shared by all streams.
+ * \param [in] stream           Number of the stream.
+ * \return                      The initial state of the stream.
+ */
+sc_rand_state_t     sc_rand_split (sc_rand_state_t seed, uint64_t stream);
+
 /** Sample the Gauss standard normal distribution.
  * Implements polar form of the Box Muller transform based on \ref sc_rand.
  * \param [in,out] state        Internal state of random number generator.
@@ -53,6 +103,18 @@ double              sc_rand (sc_rand_state_t * state);
 double              sc_rand_normal (sc_rand_state_t * state,
                                     double *second_result);
 
+/** Sample many values of the Gauss standard normal distribution.
+ * Implements the ziggurat method of Marsaglia and Tsang with 128 strips.
+ * Most samples cost one step of the generator and one multiplication.
+ * The sequence differs from the one of \ref sc_rand_normal.
+ * \param [in,out] state        Internal state of random number generator.
+ *                              It is advanced by at least \a n.
+ * \param [out] out             Array of \a n samples.
+ * \param [in] n                Number of samples to draw.
+ */
+void                sc_rand_normal_fill (sc_rand_state_t * state,
+                                         double *out, size_t n);
+
 /** Randomly draw either 0 or 1 where the probability for 1 is small.
  * \param [in,out] state        Internal state of random number generator.
  * \param [in] d                Probability of drawing ones.
@@ -61,10 +123,31 @@ double              sc_rand_normal (sc_rand_state_t * state,
 int                 sc_rand_small (sc_rand_state_t * state, double d);
 
 /** Draw from a random variable following the Poisson distribution.
+ * For means of at least 12 we use the transformed rejection method with
+ * squeeze (PTRS) by Hoermann, otherwise Knuth's multiplication method.
  * \param [in,out] state        Internal state of random number generator.
  * \param [in] mean             Mean value of Poisson distribution.
  * \return                      Non-negative integer.
  */
 int                 sc_rand_poisson (sc_rand_state_t * state, double mean);
 
+/** Run different versions of Poisson PRNG and compare them.
+ * Going through several different mean values as specified, the
+ * cumulative distribution, Knuth's method, the former rejection method
+ * and the PTRS method are timed and their sampled mean and variance are
+ * compared with the exact values.  Afterwards the polar method and the
+ * ziggurat for normal sampling are compared in the same way.
+ * \param [in,out] state        Internal state of random number generator.
+ * \param [in] mean_min         Minimum mean value to be tested.
+ * \param [in] mean_max         Maximum mean value to be tested.
+ * \param [in] mean_steps       Varying mean in so many subintervals.
+ * \param [in] n                Number of draws.
+ * \return                      The number of sampled moments that deviate
+ *                              by more than six standard deviations.
+ */
+int                 sc_rand_test_poisson (sc_rand_state_t * state,
+                                          double mean_min,
+                                          double mean_max,
+                                          int mean_steps, int n);
+
 #endif /* !SC_RANDOM_H */
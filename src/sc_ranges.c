@@ -226,6 +226,140 @@ sc_ranges_adaptive (int package_id, sc_MPI_Comm mpicomm,
   return nwin;
 }
 
+/** Append the part of a range within [\a first, \a last] to an array.
+ * \param [in,out] items   Array of three int per range: the rank of its
+ *                         origin and its first and last process.
+ */
+static void
+sc_ranges_push (sc_array_t * items, const int *item, int first, int last)
+{
+  int                *pushed;
+
+  first = SC_MAX (item[1], first);
+  last = SC_MIN (item[2], last);
+  if (first <= last) {
+    pushed = (int *) sc_array_push_count (items, 3);
+    pushed[0] = item[0];
+    pushed[1] = first;
+    pushed[2] = last;
+  }
+}
+
+void
+sc_ranges_senders (sc_MPI_Comm mpicomm, int num_ranges,
+                   const int *ranges, sc_array_t *senders)
+{
+  int                 mpiret;
+  int                 num_procs, rank;
+  int                 i, count;
+  int                 lo, hi, mid, n1, n2;
+  int                 dest, num_sources, sources[2];
+  int                *item;
+  size_t              zz, offset;
+  sc_array_t          items, keep, send, swap;
+  sc_MPI_Request      request;
+  sc_MPI_Status       status;
+
+  SC_ASSERT (senders != NULL && senders->elem_size == sizeof (int));
+
+  mpiret = sc_MPI_Comm_size (mpicomm, &num_procs);
+  SC_CHECK_MPI (mpiret);
+  mpiret = sc_MPI_Comm_rank (mpicomm, &rank);
+  SC_CHECK_MPI (mpiret);
+
+  /* the items are triples of int: origin, first and last process */
+  sc_array_init (&items, sizeof (int));
+  sc_array_init (&keep, sizeof (int));
+  sc_array_init (&send, sizeof (int));
+  for (i = 0; i < num_ranges && ranges[2 * i] >= 0; ++i) {
+    item = (int *) sc_array_push_count (&items, 3);
+    item[0] = rank;
+    item[1] = ranges[2 * i];
+    item[2] = ranges[2 * i + 1];
+    SC_ASSERT (0 <= item[1] && item[1] <= item[2] && item[2] < num_procs);
+  }
+
+  /* halve the group of this process until it is alone */
+  for (lo = 0, hi = num_procs; hi - lo > 1;) {
+    /* the lower half is not smaller than the upper one */
+    n1 = (hi - lo + 1) / 2;
+    mid = lo + n1;
+    n2 = hi - mid;
+
+    /* each process has one partner in the other half; if the lower half is
+       larger, its last process sends to the last process of the upper one */
+    if (rank < mid) {
+      dest = mid + SC_MIN (rank - lo, n2 - 1);
+      num_sources = 0;
+      if (rank - lo < n2) {
+        sources[num_sources++] = mid + rank - lo;
+      }
+    }
+    else {
+      dest = lo + rank - mid;
+      num_sources = 0;
+      sources[num_sources++] = dest;
+      if (n1 > n2 && rank == hi - 1) {
+        sources[num_sources++] = lo + n2;
+      }
+    }
+
+    /* keep the parts in this half and send the parts in the other */
+    sc_array_truncate (&keep);
+    sc_array_truncate (&send);
+    for (zz = 0; zz < items.elem_count; zz += 3) {
+      item = (int *) sc_array_index (&items, zz);
+      sc_ranges_push (rank < mid ? &keep : &send, item, lo, mid - 1);
+      sc_ranges_push (rank < mid ? &send : &keep, item, mid, hi - 1);
+    }
+    mpiret = sc_MPI_Isend (send.array, (int) send.elem_count, sc_MPI_INT,
+                           dest, SC_TAG_RANGES, mpicomm, &request);
+    SC_CHECK_MPI (mpiret);
+    for (i = 0; i < num_sources; ++i) {
+      mpiret = sc_MPI_Probe (sources[i], SC_TAG_RANGES, mpicomm, &status);
+      SC_CHECK_MPI (mpiret);
+      mpiret = sc_MPI_Get_count (&status, sc_MPI_INT, &count);
+      SC_CHECK_MPI (mpiret);
+      SC_ASSERT (count % 3 == 0);
+      offset = keep.elem_count;
+      sc_array_resize (&keep, offset + (size_t) count);
+      mpiret = sc_MPI_Recv ((int *) keep.array + offset, count,
+                            sc_MPI_INT, sources[i], SC_TAG_RANGES, mpicomm,
+                            sc_MPI_STATUS_IGNORE);
+      SC_CHECK_MPI (mpiret);
+    }
+    mpiret = sc_MPI_Wait (&request, sc_MPI_STATUS_IGNORE);
+    SC_CHECK_MPI (mpiret);
+
+    /* continue with the half of this process */
+    swap = items;
+    items = keep;
+    keep = swap;
+    if (rank < mid) {
+      hi = mid;
+    }
+    else {
+      lo = mid;
+    }
+  }
+  SC_ASSERT (lo == rank && hi == rank + 1);
+
+  /* every remaining range contains this process */
+  sc_array_truncate (senders);
+  for (zz = 0; zz < items.elem_count; zz += 3) {
+    item = (int *) sc_array_index (&items, zz);
+    SC_ASSERT (item[1] == rank && item[2] == rank);
+    if (item[0] != rank) {
+      *(int *) sc_array_push (senders) = item[0];
+    }
+  }
+  sc_array_sort (senders, sc_int_compare);
+
+  sc_array_reset (&items);
+  sc_array_reset (&keep);
+  sc_array_reset (&send);
+}
+
 void
 sc_ranges_decode (int num_procs, int rank,
                   int max_ranges, const int *global_ranges,
@@ -24,7 +24,7 @@
 #ifndef SC_RANGES_H
 #define SC_RANGES_H
 
-#include <sc.h>
+#include <sc_containers.h>
 
 SC_EXTERN_C_BEGIN;
 
@@ -77,6 +77,27 @@ int                 sc_ranges_adaptive (int package_id, sc_MPI_Comm mpicomm,
                                         int num_ranges, int *ranges,
                                         int **global_ranges);
 
+/** Find the processes whose ranges contain this process.
+ * This is the scalable replacement of the sender output of
+ * sc_ranges_decode and does not need the global ranges.
+ * The ranges are routed by recursive halving of the communicator, where
+ * a range is split at the boundary of the halves it overlaps.  This takes
+ * log P rounds of at most two messages, and the memory per process is
+ * on the order of num_ranges * log P plus the number of senders.
+ *
+ * \param [in] mpicomm      MPI Communicator; the call is collective.
+ * \param [in] num_ranges   The maximum number of ranges, which need not be
+ *                          the same on all processes.
+ * \param [in] ranges       Array [2 * num_ranges] of local ranges as filled
+ *                          by sc_ranges_compute or sc_ranges_adaptive.
+ * \param [in,out] senders  Array of int that is resized to the ranks of
+ *                          the processes with a range containing this
+ *                          process, in ascending order and without self.
+ */
+void                sc_ranges_senders (sc_MPI_Comm mpicomm, int num_ranges,
+                                       const int *ranges,
+                                       sc_array_t *senders);
+
 /** Determine an array of receivers and an array of senders from ranges.
  * This function is intended for compatibility and debugging only.
  * In particular, sc_ranges_adaptive may include non-receiving processors.
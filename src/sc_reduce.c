@@ -23,6 +23,7 @@
 
 #include <sc_reduce.h>
 #include <sc_search.h>
+#include <sc_thread.h>
 
 static void
 sc_reduce_alltoall (sc_MPI_Comm mpicomm,
@@ -133,17 +134,101 @@ sc_reduce_alltoall (sc_MPI_Comm mpicomm,
   }
 }
 
+int                 sc_reduce_alltoall_level = SC_REDUCE_ALLTOALL_LEVEL;
+size_t              sc_reduce_segment_bytes = SC_REDUCE_SEGMENT_BYTES;
+size_t              sc_reduce_rabenseifner_bytes =
+  SC_REDUCE_RABENSEIFNER_BYTES;
+
+/** Send data to a peer in segments of at most \a segment items.
+ * A segment of 0 sends the data in one message.
+ */
+static void
+sc_reduce_send (sc_MPI_Comm mpicomm, void *data, int count,
+                sc_MPI_Datatype datatype, int segment, int peer)
+{
+  int                 mpiret;
+  int                 k, nseg;
+  size_t              typesize;
+  sc_MPI_Request     *requests;
+
+  typesize = sc_mpi_sizeof (datatype);
+  if (segment <= 0 || count <= segment) {
+    mpiret = sc_MPI_Send (data, (int) (count * typesize), sc_MPI_BYTE,
+                          peer, SC_TAG_REDUCE, mpicomm);
+    SC_CHECK_MPI (mpiret);
+    return;
+  }
+
+  nseg = (count + segment - 1) / segment;
+  requests = SC_ALLOC (sc_MPI_Request, nseg);
+  for (k = 0; k < nseg; ++k) {
+    mpiret = sc_MPI_Isend ((char *) data + (size_t) k * segment * typesize,
+                           (int) (SC_MIN (segment, count - k * segment) *
+                                  typesize), sc_MPI_BYTE, peer,
+                           SC_TAG_REDUCE, mpicomm, requests + k);
+    SC_CHECK_MPI (mpiret);
+  }
+  mpiret = sc_MPI_Waitall (nseg, requests, sc_MPI_STATUSES_IGNORE);
+  SC_CHECK_MPI (mpiret);
+  SC_FREE (requests);
+}
+
+/** Receive data from a peer as sent by \ref sc_reduce_send and reduce it.
+ * Each segment is reduced into \a data while the next ones arrive.
+ * \param [in] scratch     Buffer of the size of the data for receiving.
+ */
+static void
+sc_reduce_receive (sc_MPI_Comm mpicomm, void *data, int count,
+                   sc_MPI_Datatype datatype, int segment, int peer,
+                   char *scratch, sc_reduce_t reduce_fn)
+{
+  int                 mpiret;
+  int                 k, nseg;
+  size_t              typesize, offset;
+  sc_MPI_Request     *requests;
+
+  typesize = sc_mpi_sizeof (datatype);
+  if (segment <= 0 || count <= segment) {
+    mpiret = sc_MPI_Recv (scratch, (int) (count * typesize), sc_MPI_BYTE,
+                          peer, SC_TAG_REDUCE, mpicomm, sc_MPI_STATUS_IGNORE);
+    SC_CHECK_MPI (mpiret);
+    reduce_fn (scratch, data, count, datatype);
+    return;
+  }
+
+  nseg = (count + segment - 1) / segment;
+  requests = SC_ALLOC (sc_MPI_Request, nseg);
+  for (k = 0; k < nseg; ++k) {
+    mpiret = sc_MPI_Irecv (scratch + (size_t) k * segment * typesize,
+                           (int) (SC_MIN (segment, count - k * segment) *
+                                  typesize), sc_MPI_BYTE, peer,
+                           SC_TAG_REDUCE, mpicomm, requests + k);
+    SC_CHECK_MPI (mpiret);
+  }
+  for (k = 0; k < nseg; ++k) {
+    mpiret = sc_MPI_Wait (requests + k, sc_MPI_STATUS_IGNORE);
+    SC_CHECK_MPI (mpiret);
+    offset = (size_t) k * segment * typesize;
+    reduce_fn (scratch + offset, (char *) data + offset,
+               SC_MIN (segment, count - k * segment), datatype);
+  }
+  SC_FREE (requests);
+}
+
+/** Reduce along a binary tree.
+ * \param [in] scratch     Buffer of the size of the data for receiving.
+ * \param [in] segment     Number of items per message or 0 for one message.
+ */
 static void
 sc_reduce_recursive (sc_MPI_Comm mpicomm,
                      void *data, int count, sc_MPI_Datatype datatype,
                      int groupsize, int target,
                      int maxlevel, int level, int branch,
-                     sc_reduce_t reduce_fn)
+                     char *scratch, int segment, sc_reduce_t reduce_fn)
 {
   int                 mpiret;
   int                 orig_target, doall;
   int                 myrank, peer, higher;
-  char               *peerdata;
   size_t              datasize;
   sc_MPI_Status       rstatus;
 
@@ -164,7 +249,7 @@ sc_reduce_recursive (sc_MPI_Comm mpicomm,
   if (level == 0) {
     /* result is in data */
   }
-  else if (level <= SC_REDUCE_ALLTOALL_LEVEL) {
+  else if (level <= sc_reduce_alltoall_level) {
     /* all-to-all communication */
     sc_reduce_alltoall (mpicomm, data, count, datatype,
                         groupsize, orig_target,
@@ -180,22 +265,16 @@ sc_reduce_recursive (sc_MPI_Comm mpicomm,
     higher = sc_search_bias (maxlevel, level - 1, branch / 2, target);
     if (myrank == higher) {
       if (peer < groupsize) {
-        /* temporary data to compare against peer */
-        peerdata = SC_ALLOC (char, datasize);
-
-        mpiret = sc_MPI_Recv (peerdata, datasize, sc_MPI_BYTE,
-                              peer, SC_TAG_REDUCE, mpicomm, &rstatus);
-        SC_CHECK_MPI (mpiret);
-
         /* execute reduction operation here */
-        reduce_fn (peerdata, data, count, datatype);
-        SC_FREE (peerdata);
+        sc_reduce_receive (mpicomm, data, count, datatype, segment, peer,
+                           scratch, reduce_fn);
       }
 
       /* execute next higher level of recursion */
       sc_reduce_recursive (mpicomm, data, count, datatype,
                            groupsize, orig_target,
-                           maxlevel, level - 1, branch / 2, reduce_fn);
+                           maxlevel, level - 1, branch / 2,
+                           scratch, segment, reduce_fn);
 
       if (doall && peer < groupsize) {
         /* if allreduce send back result of reduction */
@@ -206,9 +285,7 @@ sc_reduce_recursive (sc_MPI_Comm mpicomm,
     }
     else {
       if (peer < groupsize) {
-        mpiret = sc_MPI_Send (data, datasize, sc_MPI_BYTE,
-                              peer, SC_TAG_REDUCE, mpicomm);
-        SC_CHECK_MPI (mpiret);
+        sc_reduce_send (mpicomm, data, count, datatype, segment, peer);
         if (doall) {
           /* if allreduce receive back result of reduction */
           mpiret = sc_MPI_Recv (data, datasize, sc_MPI_BYTE,
@@ -227,81 +304,70 @@ sc_reduce_max (void *sendbuf, void *recvbuf,
   int                 i;
 
   if (sendtype == sc_MPI_CHAR || sendtype == sc_MPI_BYTE) {
-    const char         *s = (char *) sendbuf;
-    char               *r = (char *) recvbuf;
+    const char         *_sc_restrict s = (const char *) sendbuf;
+    char               *_sc_restrict r = (char *) recvbuf;
     for (i = 0; i < sendcount; ++i)
-      if (s[i] > r[i])
-        r[i] = s[i];
+      r[i] = s[i] > r[i] ? s[i] : r[i];
   }
   else if (sendtype == sc_MPI_SHORT) {
-    const short        *s = (short *) sendbuf;
-    short              *r = (short *) recvbuf;
+    const short        *_sc_restrict s = (const short *) sendbuf;
+    short              *_sc_restrict r = (short *) recvbuf;
     for (i = 0; i < sendcount; ++i)
-      if (s[i] > r[i])
-        r[i] = s[i];
+      r[i] = s[i] > r[i] ? s[i] : r[i];
   }
   else if (sendtype == sc_MPI_UNSIGNED_SHORT) {
-    const unsigned short *s = (unsigned short *) sendbuf;
-    unsigned short     *r = (unsigned short *) recvbuf;
+    const unsigned short *_sc_restrict s = (const unsigned short *) sendbuf;
+    unsigned short     *_sc_restrict r = (unsigned short *) recvbuf;
     for (i = 0; i < sendcount; ++i)
-      if (s[i] > r[i])
-        r[i] = s[i];
+      r[i] = s[i] > r[i] ? s[i] : r[i];
   }
   else if (sendtype == sc_MPI_INT) {
-    const int          *s = (int *) sendbuf;
-    int                *r = (int *) recvbuf;
+    const int          *_sc_restrict s = (const int *) sendbuf;
+    int                *_sc_restrict r = (int *) recvbuf;
     for (i = 0; i < sendcount; ++i)
-      if (s[i] > r[i])
-        r[i] = s[i];
+      r[i] = s[i] > r[i] ? s[i] : r[i];
   }
   else if (sendtype == sc_MPI_UNSIGNED) {
-    const unsigned     *s = (unsigned *) sendbuf;
-    unsigned           *r = (unsigned *) recvbuf;
+    const unsigned     *_sc_restrict s = (const unsigned *) sendbuf;
+    unsigned           *_sc_restrict r = (unsigned *) recvbuf;
     for (i = 0; i < sendcount; ++i)
-      if (s[i] > r[i])
-        r[i] = s[i];
+      r[i] = s[i] > r[i] ? s[i] : r[i];
   }
   else if (sendtype == sc_MPI_LONG) {
-    const long         *s = (long *) sendbuf;
-    long               *r = (long *) recvbuf;
+    const long         *_sc_restrict s = (const long *) sendbuf;
+    long               *_sc_restrict r = (long *) recvbuf;
     for (i = 0; i < sendcount; ++i)
-      if (s[i] > r[i])
-        r[i] = s[i];
+      r[i] = s[i] > r[i] ? s[i] : r[i];
   }
   else if (sendtype == sc_MPI_UNSIGNED_LONG) {
-    const unsigned long *s = (unsigned long *) sendbuf;
-    unsigned long      *r = (unsigned long *) recvbuf;
+    const unsigned long *_sc_restrict s = (const unsigned long *) sendbuf;
+    unsigned long      *_sc_restrict r = (unsigned long *) recvbuf;
     for (i = 0; i < sendcount; ++i)
-      if (s[i] > r[i])
-        r[i] = s[i];
+      r[i] = s[i] > r[i] ? s[i] : r[i];
   }
   else if (sendtype == sc_MPI_LONG_LONG_INT) {
-    const long long    *s = (long long *) sendbuf;
-    long long          *r = (long long *) recvbuf;
+    const long long    *_sc_restrict s = (const long long *) sendbuf;
+    long long          *_sc_restrict r = (long long *) recvbuf;
     for (i = 0; i < sendcount; ++i)
-      if (s[i] > r[i])
-        r[i] = s[i];
+      r[i] = s[i] > r[i] ? s[i] : r[i];
   }
   else if (sendtype == sc_MPI_FLOAT) {
-    const float        *s = (float *) sendbuf;
-    float              *r = (float *) recvbuf;
+    const float        *_sc_restrict s = (const float *) sendbuf;
+    float              *_sc_restrict r = (float *) recvbuf;
     for (i = 0; i < sendcount; ++i)
-      if (s[i] > r[i])
-        r[i] = s[i];
+      r[i] = s[i] > r[i] ? s[i] : r[i];
   }
   else if (sendtype == sc_MPI_DOUBLE) {
-    const double       *s = (double *) sendbuf;
-    double             *r = (double *) recvbuf;
+    const double       *_sc_restrict s = (const double *) sendbuf;
+    double             *_sc_restrict r = (double *) recvbuf;
     for (i = 0; i < sendcount; ++i)
-      if (s[i] > r[i])
-        r[i] = s[i];
+      r[i] = s[i] > r[i] ? s[i] : r[i];
   }
   else if (sendtype == sc_MPI_LONG_DOUBLE) {
-    const long double  *s = (long double *) sendbuf;
-    long double        *r = (long double *) recvbuf;
+    const long double  *_sc_restrict s = (const long double *) sendbuf;
+    long double        *_sc_restrict r = (long double *) recvbuf;
     for (i = 0; i < sendcount; ++i)
-      if (s[i] > r[i])
-        r[i] = s[i];
+      r[i] = s[i] > r[i] ? s[i] : r[i];
   }
   else {
     SC_ABORT ("Unsupported MPI datatype in sc_reduce_max");
@@ -315,81 +381,70 @@ sc_reduce_min (void *sendbuf, void *recvbuf,
   int                 i;
 
   if (sendtype == sc_MPI_CHAR || sendtype == sc_MPI_BYTE) {
-    const char         *s = (char *) sendbuf;
-    char               *r = (char *) recvbuf;
+    const char         *_sc_restrict s = (const char *) sendbuf;
+    char               *_sc_restrict r = (char *) recvbuf;
     for (i = 0; i < sendcount; ++i)
-      if (s[i] < r[i])
-        r[i] = s[i];
+      r[i] = s[i] < r[i] ? s[i] : r[i];
   }
   else if (sendtype == sc_MPI_SHORT) {
-    const short        *s = (short *) sendbuf;
-    short              *r = (short *) recvbuf;
+    const short        *_sc_restrict s = (const short *) sendbuf;
+    short              *_sc_restrict r = (short *) recvbuf;
     for (i = 0; i < sendcount; ++i)
-      if (s[i] < r[i])
-        r[i] = s[i];
+      r[i] = s[i] < r[i] ? s[i] : r[i];
   }
   else if (sendtype == sc_MPI_UNSIGNED_SHORT) {
-    const unsigned short *s = (unsigned short *) sendbuf;
-    unsigned short     *r = (unsigned short *) recvbuf;
+    const unsigned short *_sc_restrict s = (const unsigned short *) sendbuf;
+    unsigned short     *_sc_restrict r = (unsigned short *) recvbuf;
     for (i = 0; i < sendcount; ++i)
-      if (s[i] < r[i])
-        r[i] = s[i];
+      r[i] = s[i] < r[i] ? s[i] : r[i];
   }
   else if (sendtype == sc_MPI_INT) {
-    const int          *s = (int *) sendbuf;
-    int                *r = (int *) recvbuf;
+    const int          *_sc_restrict s = (const int *) sendbuf;
+    int                *_sc_restrict r = (int *) recvbuf;
     for (i = 0; i < sendcount; ++i)
-      if (s[i] < r[i])
-        r[i] = s[i];
+      r[i] = s[i] < r[i] ? s[i] : r[i];
   }
   else if (sendtype == sc_MPI_UNSIGNED) {
-    const unsigned     *s = (unsigned *) sendbuf;
-    unsigned           *r = (unsigned *) recvbuf;
+    const unsigned     *_sc_restrict s = (const unsigned *) sendbuf;
+    unsigned           *_sc_restrict r = (unsigned *) recvbuf;
     for (i = 0; i < sendcount; ++i)
-      if (s[i] < r[i])
-        r[i] = s[i];
+      r[i] = s[i] < r[i] ? s[i] : r[i];
   }
   else if (sendtype == sc_MPI_LONG) {
-    const long         *s = (long *) sendbuf;
-    long               *r = (long *) recvbuf;
+    const long         *_sc_restrict s = (const long *) sendbuf;
+    long               *_sc_restrict r = (long *) recvbuf;
     for (i = 0; i < sendcount; ++i)
-      if (s[i] < r[i])
-        r[i] = s[i];
+      r[i] = s[i] < r[i] ? s[i] : r[i];
   }
   else if (sendtype == sc_MPI_UNSIGNED_LONG) {
-    const unsigned long *s = (unsigned long *) sendbuf;
-    unsigned long      *r = (unsigned long *) recvbuf;
+    const unsigned long *_sc_restrict s = (const unsigned long *) sendbuf;
+    unsigned long      *_sc_restrict r = (unsigned long *) recvbuf;
     for (i = 0; i < sendcount; ++i)
-      if (s[i] < r[i])
-        r[i] = s[i];
+      r[i] = s[i] < r[i] ? s[i] : r[i];
   }
   else if (sendtype == sc_MPI_LONG_LONG_INT) {
-    const long long    *s = (long long *) sendbuf;
-    long long          *r = (long long *) recvbuf;
+    const long long    *_sc_restrict s = (const long long *) sendbuf;
+    long long          *_sc_restrict r = (long long *) recvbuf;
     for (i = 0; i < sendcount; ++i)
-      if (s[i] < r[i])
-        r[i] = s[i];
+      r[i] = s[i] < r[i] ? s[i] : r[i];
   }
   else if (sendtype == sc_MPI_FLOAT) {
-    const float        *s = (float *) sendbuf;
-    float              *r = (float *) recvbuf;
+    const float        *_sc_restrict s = (const float *) sendbuf;
+    float              *_sc_restrict r = (float *) recvbuf;
     for (i = 0; i < sendcount; ++i)
-      if (s[i] < r[i])
-        r[i] = s[i];
+      r[i] = s[i] < r[i] ? s[i] : r[i];
   }
   else if (sendtype == sc_MPI_DOUBLE) {
-    const double       *s = (double *) sendbuf;
-    double             *r = (double *) recvbuf;
+    const double       *_sc_restrict s = (const double *) sendbuf;
+    double             *_sc_restrict r = (double *) recvbuf;
     for (i = 0; i < sendcount; ++i)
-      if (s[i] < r[i])
-        r[i] = s[i];
+      r[i] = s[i] < r[i] ? s[i] : r[i];
   }
   else if (sendtype == sc_MPI_LONG_DOUBLE) {
-    const long double  *s = (long double *) sendbuf;
-    long double        *r = (long double *) recvbuf;
+    const long double  *_sc_restrict s = (const long double *) sendbuf;
+    long double        *_sc_restrict r = (long double *) recvbuf;
     for (i = 0; i < sendcount; ++i)
-      if (s[i] < r[i])
-        r[i] = s[i];
+      r[i] = s[i] < r[i] ? s[i] : r[i];
   }
   else {
     SC_ABORT ("Unsupported MPI datatype in sc_reduce_min");
@@ -403,68 +458,68 @@ sc_reduce_sum (void *sendbuf, void *recvbuf,
   int                 i;
 
   if (sendtype == sc_MPI_CHAR || sendtype == sc_MPI_BYTE) {
-    const char         *s = (char *) sendbuf;
-    char               *r = (char *) recvbuf;
+    const char         *_sc_restrict s = (const char *) sendbuf;
+    char               *_sc_restrict r = (char *) recvbuf;
     for (i = 0; i < sendcount; ++i)
       r[i] += s[i];
   }
   else if (sendtype == sc_MPI_SHORT) {
-    const short        *s = (short *) sendbuf;
-    short              *r = (short *) recvbuf;
+    const short        *_sc_restrict s = (const short *) sendbuf;
+    short              *_sc_restrict r = (short *) recvbuf;
     for (i = 0; i < sendcount; ++i)
       r[i] += s[i];
   }
   else if (sendtype == sc_MPI_UNSIGNED_SHORT) {
-    const unsigned short *s = (unsigned short *) sendbuf;
-    unsigned short     *r = (unsigned short *) recvbuf;
+    const unsigned short *_sc_restrict s = (const unsigned short *) sendbuf;
+    unsigned short     *_sc_restrict r = (unsigned short *) recvbuf;
     for (i = 0; i < sendcount; ++i)
       r[i] += s[i];
   }
   else if (sendtype == sc_MPI_INT) {
-    const int          *s = (int *) sendbuf;
-    int                *r = (int *) recvbuf;
+    const int          *_sc_restrict s = (const int *) sendbuf;
+    int                *_sc_restrict r = (int *) recvbuf;
     for (i = 0; i < sendcount; ++i)
       r[i] += s[i];
   }
   else if (sendtype == sc_MPI_UNSIGNED) {
-    const unsigned     *s = (unsigned *) sendbuf;
-    unsigned           *r = (unsigned *) recvbuf;
+    const unsigned     *_sc_restrict s = (const unsigned *) sendbuf;
+    unsigned           *_sc_restrict r = (unsigned *) recvbuf;
     for (i = 0; i < sendcount; ++i)
       r[i] += s[i];
   }
   else if (sendtype == sc_MPI_LONG) {
-    const long         *s = (long *) sendbuf;
-    long               *r = (long *) recvbuf;
+    const long         *_sc_restrict s = (const long *) sendbuf;
+    long               *_sc_restrict r = (long *) recvbuf;
     for (i = 0; i < sendcount; ++i)
       r[i] += s[i];
   }
   else if (sendtype == sc_MPI_UNSIGNED_LONG) {
-    const unsigned long *s = (unsigned long *) sendbuf;
-    unsigned long      *r = (unsigned long *) recvbuf;
+    const unsigned long *_sc_restrict s = (const unsigned long *) sendbuf;
+    unsigned long      *_sc_restrict r = (unsigned long *) recvbuf;
     for (i = 0; i < sendcount; ++i)
       r[i] += s[i];
   }
   else if (sendtype == sc_MPI_LONG_LONG_INT) {
-    const long long    *s = (long long *) sendbuf;
-    long long          *r = (long long *) recvbuf;
+    const long long    *_sc_restrict s = (const long long *) sendbuf;
+    long long          *_sc_restrict r = (long long *) recvbuf;
     for (i = 0; i < sendcount; ++i)
       r[i] += s[i];
   }
   else if (sendtype == sc_MPI_FLOAT) {
-    const float        *s = (float *) sendbuf;
-    float              *r = (float *) recvbuf;
+    const float        *_sc_restrict s = (const float *) sendbuf;
+    float              *_sc_restrict r = (float *) recvbuf;
     for (i = 0; i < sendcount; ++i)
       r[i] += s[i];
   }
   else if (sendtype == sc_MPI_DOUBLE) {
-    const double       *s = (double *) sendbuf;
-    double             *r = (double *) recvbuf;
+    const double       *_sc_restrict s = (const double *) sendbuf;
+    double             *_sc_restrict r = (double *) recvbuf;
     for (i = 0; i < sendcount; ++i)
       r[i] += s[i];
   }
   else if (sendtype == sc_MPI_LONG_DOUBLE) {
-    const long double  *s = (long double *) sendbuf;
-    long double        *r = (long double *) recvbuf;
+    const long double  *_sc_restrict s = (const long double *) sendbuf;
+    long double        *_sc_restrict r = (long double *) recvbuf;
     for (i = 0; i < sendcount; ++i)
       r[i] += s[i];
   }
@@ -473,16 +528,20 @@ sc_reduce_sum (void *sendbuf, void *recvbuf,
   }
 }
 
+/** Run the reduction.
+ * \param [in] segment     Number of items per message or 0 for one message.
+ */
 static int
 sc_reduce_custom_dispatch (void *sendbuf, void *recvbuf, int sendcount,
                            sc_MPI_Datatype sendtype, sc_reduce_t reduce_fn,
-                           int target, sc_MPI_Comm mpicomm)
+                           int segment, int target, sc_MPI_Comm mpicomm)
 {
   int                 mpiret;
   int                 mpisize;
   int                 mpirank;
   int                 maxlevel;
   size_t              datasize;
+  char               *scratch;
 
   SC_ASSERT (sendcount >= 0);
 
@@ -491,6 +550,7 @@ sc_reduce_custom_dispatch (void *sendbuf, void *recvbuf, int sendcount,
   /* *INDENT-ON* */
   memcpy (recvbuf, sendbuf, datasize);
 
+  mpicomm = sc_mpi_comm_thread (mpicomm);
   mpiret = sc_MPI_Comm_size (mpicomm, &mpisize);
   SC_CHECK_MPI (mpiret);
   mpiret = sc_MPI_Comm_rank (mpicomm, &mpirank);
@@ -498,9 +558,16 @@ sc_reduce_custom_dispatch (void *sendbuf, void *recvbuf, int sendcount,
 
   SC_ASSERT (-1 <= target && target < mpisize);
 
+  /* one receive buffer serves all levels of the recursion */
   maxlevel = SC_LOG2_32 (mpisize - 1) + 1;
+  scratch = maxlevel > sc_reduce_alltoall_level ?
+    SC_ALLOC (char, datasize) : NULL;
+  sc_mpi_profile_enter (SC_MPI_CALLER_REDUCE);
   sc_reduce_recursive (mpicomm, recvbuf, sendcount, sendtype, mpisize,
-                       target, maxlevel, maxlevel, mpirank, reduce_fn);
+                       target, maxlevel, maxlevel, mpirank,
+                       scratch, segment, reduce_fn);
+  sc_mpi_profile_leave ();
+  SC_FREE (scratch);
 
   return sc_MPI_SUCCESS;
 }
@@ -511,7 +578,7 @@ sc_allreduce_custom (void *sendbuf, void *recvbuf, int sendcount,
                      sc_MPI_Comm mpicomm)
 {
   return sc_reduce_custom_dispatch (sendbuf, recvbuf, sendcount,
-                                    sendtype, reduce_fn, -1, mpicomm);
+                                    sendtype, reduce_fn, 0, -1, mpicomm);
 }
 
 int
@@ -523,7 +590,149 @@ sc_reduce_custom (void *sendbuf, void *recvbuf, int sendcount,
                   "sc_reduce_custom requires non-negative target");
 
   return sc_reduce_custom_dispatch (sendbuf, recvbuf, sendcount,
-                                    sendtype, reduce_fn, target, mpicomm);
+                                    sendtype, reduce_fn, 0, target, mpicomm);
+}
+
+/** Exchange a range of blocks with a peer.
+ * We send the blocks [\a slo, \a shi) of \a data and receive the blocks
+ * [\a rlo, \a rhi) into \a rbuf.  Block b begins at item \a displs[b].
+ */
+static void
+sc_reduce_exchange (sc_MPI_Comm mpicomm, char *data, char *rbuf,
+                    size_t typesize, const int *displs,
+                    int slo, int shi, int rlo, int rhi, int peer)
+{
+  int                 mpiret;
+  sc_MPI_Request      request;
+
+  mpiret = sc_MPI_Irecv (rbuf, (int) ((displs[rhi] - displs[rlo]) *
+                                      typesize), sc_MPI_BYTE, peer,
+                         SC_TAG_REDUCE, mpicomm, &request);
+  SC_CHECK_MPI (mpiret);
+  mpiret = sc_MPI_Send (data + displs[slo] * typesize,
+                        (int) ((displs[shi] - displs[slo]) * typesize),
+                        sc_MPI_BYTE, peer, SC_TAG_REDUCE, mpicomm);
+  SC_CHECK_MPI (mpiret);
+  mpiret = sc_MPI_Wait (&request, sc_MPI_STATUS_IGNORE);
+  SC_CHECK_MPI (mpiret);
+}
+
+/** Allreduce by recursive halving and doubling after Rabenseifner.
+ * The first 2 r processes, with r the excess over the power of two p,
+ * combine in pairs into the odd one.  The remaining p processes split the
+ * data into p blocks and reduce-scatter them by recursive halving, such
+ * that each ends up with one reduced block, and then gather all blocks by
+ * recursive doubling.  Finally the odd processes return the result.
+ */
+static void
+sc_allreduce_rabenseifner (sc_MPI_Comm mpicomm, void *data, int count,
+                           sc_MPI_Datatype datatype, sc_reduce_t reduce_fn)
+{
+  int                 mpiret;
+  int                 mpisize, mpirank;
+  int                 p, r, newrank, newpeer, peer, mask, b;
+  int                 lo, hi, mid;
+  int                *displs;
+  size_t              typesize;
+  char               *cdata, *scratch;
+
+  mpiret = sc_MPI_Comm_size (mpicomm, &mpisize);
+  SC_CHECK_MPI (mpiret);
+  mpiret = sc_MPI_Comm_rank (mpicomm, &mpirank);
+  SC_CHECK_MPI (mpiret);
+
+  p = 1 << SC_LOG2_32 (mpisize);
+  r = mpisize - p;
+  SC_ASSERT (p <= count && r < p);
+
+  cdata = (char *) data;
+  typesize = sc_mpi_sizeof (datatype);
+  scratch = SC_ALLOC (char, (size_t) count * typesize);
+
+  /* fold the excess processes into their odd neighbors */
+  if (mpirank < 2 * r) {
+    if (mpirank % 2 == 0) {
+      mpiret = sc_MPI_Send (data, (int) (count * typesize), sc_MPI_BYTE,
+                            mpirank + 1, SC_TAG_REDUCE, mpicomm);
+      SC_CHECK_MPI (mpiret);
+      newrank = -1;
+    }
+    else {
+      mpiret = sc_MPI_Recv (scratch, (int) (count * typesize), sc_MPI_BYTE,
+                            mpirank - 1, SC_TAG_REDUCE, mpicomm,
+                            sc_MPI_STATUS_IGNORE);
+      SC_CHECK_MPI (mpiret);
+      reduce_fn (scratch, data, count, datatype);
+      newrank = mpirank / 2;
+    }
+  }
+  else {
+    newrank = mpirank - r;
+  }
+
+  if (newrank >= 0) {
+    displs = SC_ALLOC (int, p + 1);
+    for (b = 0; b <= p; ++b) {
+      displs[b] = (int) ((long long) count * b / p);
+    }
+
+    /* reduce-scatter: keep the half of the blocks that contains our own */
+    lo = 0;
+    hi = p;
+    for (mask = p / 2; mask > 0; mask /= 2) {
+      newpeer = newrank ^ mask;
+      peer = newpeer < r ? 2 * newpeer + 1 : newpeer + r;
+      mid = lo + (hi - lo) / 2;
+      if (newrank & mask) {
+        sc_reduce_exchange (mpicomm, cdata, scratch, typesize, displs,
+                            lo, mid, mid, hi, peer);
+        lo = mid;
+      }
+      else {
+        sc_reduce_exchange (mpicomm, cdata, scratch, typesize, displs,
+                            mid, hi, lo, mid, peer);
+        hi = mid;
+      }
+      reduce_fn (scratch, cdata + displs[lo] * typesize,
+                 displs[hi] - displs[lo], datatype);
+    }
+    SC_ASSERT (lo == newrank && hi == newrank + 1);
+
+    /* allgather: double the range of blocks by the one of the peer */
+    for (mask = 1; mask < p; mask *= 2) {
+      newpeer = newrank ^ mask;
+      peer = newpeer < r ? 2 * newpeer + 1 : newpeer + r;
+      if (newrank & mask) {
+        sc_reduce_exchange (mpicomm, cdata, cdata + displs[lo - mask] *
+                            typesize, typesize, displs,
+                            lo, hi, lo - mask, lo, peer);
+        lo -= mask;
+      }
+      else {
+        sc_reduce_exchange (mpicomm, cdata, cdata + displs[hi] * typesize,
+                            typesize, displs, lo, hi, hi, hi + mask, peer);
+        hi += mask;
+      }
+    }
+    SC_ASSERT (lo == 0 && hi == p);
+    SC_FREE (displs);
+  }
+
+  /* return the result to the excess processes */
+  if (mpirank < 2 * r) {
+    if (mpirank % 2 == 0) {
+      mpiret = sc_MPI_Recv (data, (int) (count * typesize), sc_MPI_BYTE,
+                            mpirank + 1, SC_TAG_REDUCE, mpicomm,
+                            sc_MPI_STATUS_IGNORE);
+      SC_CHECK_MPI (mpiret);
+    }
+    else {
+      mpiret = sc_MPI_Send (data, (int) (count * typesize), sc_MPI_BYTE,
+                            mpirank - 1, SC_TAG_REDUCE, mpicomm);
+      SC_CHECK_MPI (mpiret);
+    }
+  }
+  SC_FREE (scratch);
 }
 
 static int
@@ -531,6 +740,9 @@ sc_reduce_dispatch (void *sendbuf, void *recvbuf, int sendcount,
                     sc_MPI_Datatype sendtype, sc_MPI_Op operation,
                     int target, sc_MPI_Comm mpicomm)
 {
+  int                 mpiret;
+  int                 mpisize;
+  int                 segment;
   sc_reduce_t         reduce_fn;
 
   if (operation == sc_MPI_MAX)
@@ -542,8 +754,34 @@ sc_reduce_dispatch (void *sendbuf, void *recvbuf, int sendcount,
   else
     SC_ABORT ("Unsupported operation in sc_allreduce or sc_reduce");
 
+  /* large allreduce by reduce-scatter and allgather */
+  if (target == -1 && sc_reduce_rabenseifner_bytes > 0 &&
+      (size_t) sendcount * sc_mpi_sizeof (sendtype) >=
+      sc_reduce_rabenseifner_bytes) {
+    mpicomm = sc_mpi_comm_thread (mpicomm);
+    mpiret = sc_MPI_Comm_size (mpicomm, &mpisize);
+    SC_CHECK_MPI (mpiret);
+    if (mpisize > 1 && sendcount >= (1 << SC_LOG2_32 (mpisize))) {
+      memcpy (recvbuf, sendbuf, (size_t) sendcount *
+              sc_mpi_sizeof (sendtype));
+      sc_mpi_profile_enter (SC_MPI_CALLER_REDUCE);
+      sc_allreduce_rabenseifner (mpicomm, recvbuf, sendcount, sendtype,
+                                 reduce_fn);
+      sc_mpi_profile_leave ();
+      return sc_MPI_SUCCESS;
+    }
+  }
+
+  /* the builtin operations work item by item and may be segmented */
+  segment = (int) SC_MIN (sc_reduce_segment_bytes /
+                          sc_mpi_sizeof (sendtype), (size_t) INT_MAX);
+  if (sc_reduce_segment_bytes > 0 && segment == 0) {
+    segment = 1;
+  }
+
   return sc_reduce_custom_dispatch (sendbuf, recvbuf, sendcount,
-                                    sendtype, reduce_fn, target, mpicomm);
+                                    sendtype, reduce_fn, segment, target,
+                                    mpicomm);
 }
 
 int
@@ -565,3 +803,205 @@ sc_reduce (void *sendbuf, void *recvbuf, int sendcount,
   return sc_reduce_dispatch (sendbuf, recvbuf, sendcount,
                              sendtype, operation, target, mpicomm);
 }
+
+/* Expand a statement for every type supported by sc_array_exscan. */
+#define SC_EXSCAN_DISPATCH(type,M) do {                         \
+  if ((type) == sc_MPI_INT) M (int);                            \
+  else if ((type) == sc_MPI_UNSIGNED) M (unsigned);             \
+  else if ((type) == sc_MPI_LONG) M (long);                     \
+  else if ((type) == sc_MPI_UNSIGNED_LONG) M (unsigned long);   \
+  else if ((type) == sc_MPI_LONG_LONG_INT) M (long long);       \
+  else if ((type) == sc_MPI_FLOAT) M (float);                   \
+  else if ((type) == sc_MPI_DOUBLE) M (double);                 \
+  else SC_ABORT ("Unsupported datatype in sc_array_exscan");    \
+} while (0)
+
+/* Sum the items of a chunk, which vectorizes. */
+#define SC_EXSCAN_SUM(T) do {                                   \
+  const T            *_sc_restrict v = (const T *) et->data;    \
+  T                   sum = 0;                                  \
+  for (zz = lo; zz < hi; ++zz) {                                \
+    sum += v[zz];                                               \
+  }                                                             \
+  ((T *) et->sums)[c] = sum;                                    \
+} while (0)
+
+/* Replace the items of a chunk by the sums of their predecessors. */
+#define SC_EXSCAN_APPLY(T) do {                                 \
+  T                  *_sc_restrict v = (T *) et->data;          \
+  T                   sum = ((T *) et->sums)[c], x;             \
+  for (zz = lo; zz < hi; ++zz) {                                \
+    x = v[zz];                                                  \
+    v[zz] = sum;                                                \
+    sum += x;                                                   \
+  }                                                             \
+} while (0)
+
+/* Turn the chunk sums into chunk offsets starting at the rank offset. */
+#define SC_EXSCAN_OFFSETS(T) do {                               \
+  T                  *sums = (T *) et.sums, sum = 0, x;         \
+  for (c = 0; c < et.num_chunks; ++c) {                         \
+    x = sums[c];                                                \
+    sums[c] = sum;                                              \
+    sum += x;                                                   \
+  }                                                             \
+  *(T *) local = sum;                                           \
+  mpiret = sc_MPI_Exscan (local, offset, 1, type, sc_MPI_SUM,   \
+                          mpicomm);                             \
+  SC_CHECK_MPI (mpiret);                                        \
+  if (mpirank == 0) {                                           \
+    *(T *) offset = 0;                                          \
+  }                                                             \
+  for (c = 0; c < et.num_chunks; ++c) {                         \
+    sums[c] += *(T *) offset;                                   \
+  }                                                             \
+} while (0)
+
+/** State shared by the threads of \ref sc_array_exscan. */
+typedef struct sc_reduce_exscan
+{
+  char               *data;
+  size_t              count;
+  sc_MPI_Datatype     type;
+  int                 num_chunks;
+  char               *sums;     /**< One item per chunk. */
+  int                 apply;    /**< False in the summing pass. */
+}
+sc_reduce_exscan_t;
+
+static void
+sc_reduce_exscan_chunk (int thread_id, int num_threads, void *user)
+{
+  sc_reduce_exscan_t *et = (sc_reduce_exscan_t *) user;
+  int                 c;
+  size_t              zz, lo, hi;
+
+  for (c = thread_id; c < et->num_chunks; c += num_threads) {
+    lo = et->count * c / et->num_chunks;
+    hi = et->count * (c + 1) / et->num_chunks;
+    if (et->apply) {
+      SC_EXSCAN_DISPATCH (et->type, SC_EXSCAN_APPLY);
+    }
+    else {
+      SC_EXSCAN_DISPATCH (et->type, SC_EXSCAN_SUM);
+    }
+  }
+}
+
+void
+sc_array_exscan (sc_array_t * values, sc_MPI_Datatype type,
+                 void *total, int num_threads, sc_MPI_Comm mpicomm)
+{
+  int                 mpiret;
+  int                 mpirank, c;
+  size_t              T;
+  char                local[16], offset[16];
+  sc_reduce_exscan_t  et;
+
+  SC_ASSERT (values != NULL);
+  SC_ASSERT (values->elem_size == sc_mpi_sizeof (type));
+  SC_ASSERT (values->elem_size <= sizeof (local));
+
+  mpiret = sc_MPI_Comm_rank (mpicomm, &mpirank);
+  SC_CHECK_MPI (mpiret);
+
+  if (num_threads <= 0) {
+    num_threads = sc_thread_default_count ();
+  }
+  T = SC_MIN ((size_t) num_threads,
+              values->elem_count / SC_REDUCE_EXSCAN_PARALLEL_MIN);
+  et.data = values->array;
+  et.count = values->elem_count;
+  et.type = type;
+  et.num_chunks = (int) SC_MAX (T, 1);
+  et.sums = SC_ALLOC (char, et.num_chunks * values->elem_size);
+
+  /* the local sums of the chunks, then one scan over the processes */
+  et.apply = 0;
+  if (et.num_chunks > 1) {
+    sc_thread_fork_join (et.num_chunks, sc_reduce_exscan_chunk, &et);
+  }
+  else {
+    sc_reduce_exscan_chunk (0, 1, &et);
+  }
+  SC_EXSCAN_DISPATCH (type, SC_EXSCAN_OFFSETS);
+
+  /* the second pass writes the scan starting from the chunk offsets */
+  et.apply = 1;
+  if (et.num_chunks > 1) {
+    sc_thread_fork_join (et.num_chunks, sc_reduce_exscan_chunk, &et);
+  }
+  else {
+    sc_reduce_exscan_chunk (0, 1, &et);
+  }
+  SC_FREE (et.sums);
+
+  if (total != NULL) {
+    mpiret = sc_allreduce (local, total, 1, type, sc_MPI_SUM, mpicomm);
+    SC_CHECK_MPI (mpiret);
+  }
+}
+
+/* Count the items of a type into the buckets by binary search. */
+#define SC_HISTOGRAM_COUNT(T) do {                              \
+  const T            *v = (const T *) values->array;            \
+  for (zz = 0; zz < values->elem_count; ++zz) {                 \
+    x = (double) v[zz];                                         \
+    if (!(x >= edges[0] && x < edges[num_buckets])) {           \
+      continue;                                                 \
+    }                                                           \
+    lo = 0;                                                     \
+    hi = num_buckets;                                           \
+    while (hi - lo > 1) {                                       \
+      mid = (lo + hi) / 2;                                      \
+      if (x < edges[mid]) {                                     \
+        hi = mid;                                               \
+      }                                                         \
+      else {                                                    \
+        lo = mid;                                               \
+      }                                                         \
+    }                                                           \
+    ++local[lo];                                                \
+  }                                                             \
+} while (0)
+
+void
+sc_array_histogram (sc_array_t * values, sc_MPI_Datatype type,
+                    int num_buckets, const double *edges,
+                    long long *counts, sc_MPI_Comm mpicomm)
+{
+  int                 mpiret;
+  int                 lo, hi, mid;
+  size_t              zz;
+  double              x;
+  long long          *local;
+
+  SC_ASSERT (values != NULL && edges != NULL && counts != NULL);
+  SC_ASSERT (values->elem_size == sc_mpi_sizeof (type));
+  SC_ASSERT (num_buckets > 0);
+
+  local = SC_ALLOC_ZERO (long long, num_buckets);
+  if (type == sc_MPI_INT) {
+    SC_HISTOGRAM_COUNT (int);
+  }
+  else if (type == sc_MPI_LONG) {
+    SC_HISTOGRAM_COUNT (long);
+  }
+  else if (type == sc_MPI_LONG_LONG_INT) {
+    SC_HISTOGRAM_COUNT (long long);
+  }
+  else if (type == sc_MPI_FLOAT) {
+    SC_HISTOGRAM_COUNT (float);
+  }
+  else if (type == sc_MPI_DOUBLE) {
+    SC_HISTOGRAM_COUNT (double);
+  }
+  else {
+    SC_ABORT ("Unsupported datatype in sc_array_histogram");
+  }
+
+  mpiret = sc_allreduce (local, counts, num_buckets, sc_MPI_LONG_LONG_INT,
+                         sc_MPI_SUM, mpicomm);
+  SC_CHECK_MPI (mpiret);
+  SC_FREE (local);
+}
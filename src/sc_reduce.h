@@ -30,6 +30,10 @@
  * not suffer from random or otherwise obscure influences.
  *
  * Both algorithms use a binary communication tree.
+ * A large \ref sc_allreduce with a builtin operation may instead use a
+ * reduce-scatter followed by an allgather, see
+ * \ref sc_reduce_rabenseifner_bytes.  Its associativity depends on the
+ * size of the communicator and the count only.
  * We provide implementations via a customizable reduction operator
  * as well as drop-in replacements for minimum, maximum, and sum.
  * We do not currently support user-defined MPI datatypes.
@@ -40,15 +44,59 @@
 #ifndef SC_REDUCE_H
 #define SC_REDUCE_H
 
-#include <sc.h>
+#include <sc_containers.h>
 
 #ifndef SC_REDUCE_ALLTOALL_LEVEL
-/** The highest recursion level that uses direct all-to-all. */
+/** The default of \ref sc_reduce_alltoall_level. */
 #define SC_REDUCE_ALLTOALL_LEVEL        3
 #endif
 
+#ifndef SC_REDUCE_SEGMENT_BYTES
+/** The default of \ref sc_reduce_segment_bytes. */
+#define SC_REDUCE_SEGMENT_BYTES         (1 << 16)
+#endif
+
+#ifndef SC_REDUCE_RABENSEIFNER_BYTES
+/** The default of \ref sc_reduce_rabenseifner_bytes. */
+#define SC_REDUCE_RABENSEIFNER_BYTES    (1 << 20)
+#endif
+
+#ifndef SC_REDUCE_EXSCAN_PARALLEL_MIN
+/** The minimum number of items per thread in \ref sc_array_exscan. */
+#define SC_REDUCE_EXSCAN_PARALLEL_MIN   (1 << 16)
+#endif
+
 SC_EXTERN_C_BEGIN;
 
+/** The highest recursion level that uses direct all-to-all.
+ * Below, each step of the binary tree exchanges one message.
+ * The result does not depend on this value.  It must be the same on all
+ * processes of a reduction.  Initialized to \ref SC_REDUCE_ALLTOALL_LEVEL.
+ */
+extern int          sc_reduce_alltoall_level;
+
+/** Messages of \ref sc_reduce and \ref sc_allreduce longer than this
+ * many bytes are sent in segments, such that a segment is reduced while
+ * the next ones are in transit.  Zero sends every message in one piece.
+ * The result does not depend on this value.  It must be the same on all
+ * processes of a reduction.  Initialized to \ref SC_REDUCE_SEGMENT_BYTES.
+ * The custom reductions are never segmented since their operator may
+ * combine more than one item.
+ */
+extern size_t       sc_reduce_segment_bytes;
+
+/** An \ref sc_allreduce of at least this many bytes with a builtin
+ * operation uses a reduce-scatter by recursive halving followed by an
+ * allgather by recursive doubling.  Each process sends about twice the
+ * data in total instead of the data per level of the binary tree.
+ * A communicator size not a power of two is folded into the next lower
+ * power of two by pairing the first processes.  The algorithm is only
+ * used when the count is at least that power of two.  Zero disables it.
+ * It must be the same on all processes of a reduction.
+ * Initialized to \ref SC_REDUCE_RABENSEIFNER_BYTES.
+ */
+extern size_t       sc_reduce_rabenseifner_bytes;
+
 /** Prototype for a user-defined reduce operation. */
 typedef void        (*sc_reduce_t) (void *sendbuf, void *recvbuf,
                                     int sendcount, sc_MPI_Datatype sendtype);
@@ -114,6 +162,51 @@ int                 sc_reduce (void *sendbuf, void *recvbuf, int sendcount,
                                sc_MPI_Datatype sendtype, sc_MPI_Op operation,
                                int target, sc_MPI_Comm mpicomm);
 
+/** Replace distributed values by their global exclusive prefix sums.
+ * The arrays of all processes form one sequence in rank order and every
+ * value is replaced by the sum of the values before it, the first by 0.
+ * Each process sums chunks of its array with threads, scans the chunk
+ * sums, and calls sc_MPI_Exscan once.  A second threaded pass writes the
+ * prefix sums.  The summation order of floating point data depends on
+ * the number of threads.
+ * \param [in,out] values   Array of values of \a type, may be a view.
+ * \param [in] type         One of \ref sc_MPI_INT, \ref sc_MPI_UNSIGNED,
+ *                          \ref sc_MPI_LONG, \ref sc_MPI_UNSIGNED_LONG,
+ *                          \ref sc_MPI_LONG_LONG_INT, \ref sc_MPI_FLOAT
+ *                          and \ref sc_MPI_DOUBLE.  We abort otherwise.
+ * \param [out] total       If not NULL, the sum of all values is stored
+ *                          here by a \ref sc_allreduce.  This must be NULL
+ *                          on all processes or on none.
+ * \param [in] num_threads  Number of threads to use.  If not positive,
+ *                          use \ref sc_thread_default_count.  At most one
+ *                          thread per \ref SC_REDUCE_EXSCAN_PARALLEL_MIN
+ *                          values is used.
+ * \param [in] mpicomm      Valid MPI communicator.
+ */
+void                sc_array_exscan (sc_array_t * values,
+                                     sc_MPI_Datatype type, void *total,
+                                     int num_threads, sc_MPI_Comm mpicomm);
+
+/** Count distributed values into buckets over all processes.
+ * Bucket b holds the values x with edges[b] <= x < edges[b + 1].
+ * Values outside of all buckets and NaN are not counted.  The counts
+ * are summed by \ref sc_allreduce.
+ * \param [in] values       Array of values of \a type, may be a view.
+ * \param [in] type         One of \ref sc_MPI_INT, \ref sc_MPI_LONG,
+ *                          \ref sc_MPI_LONG_LONG_INT, \ref sc_MPI_FLOAT
+ *                          and \ref sc_MPI_DOUBLE.  We abort otherwise.
+ * \param [in] num_buckets  Positive number of buckets.
+ * \param [in] edges        Ascending array of \a num_buckets + 1 bucket
+ *                          boundaries, the same on all processes.
+ * \param [out] counts      Array of \a num_buckets global counts.
+ * \param [in] mpicomm      Valid MPI communicator.
+ */
+void                sc_array_histogram (sc_array_t * values,
+                                        sc_MPI_Datatype type,
+                                        int num_buckets, const double *edges,
+                                        long long *counts,
+                                        sc_MPI_Comm mpicomm);
+
 SC_EXTERN_C_END;
 
 #endif /* !SC_REDUCE_H */
@@ -23,6 +23,21 @@
 
 #include <sc_private.h>
 #include <sc_refcount.h>
+#include <sc_atomic.h>
+
+#ifdef SC_ENABLE_ATOMIC_REFCOUNT
+#define SC_REFCOUNT_IS_ATOMIC(rc) 1
+#else
+#define SC_REFCOUNT_IS_ATOMIC(rc) ((rc)->is_atomic)
+#endif
+
+/** Load the count, which may be changed by other threads if atomic. */
+static int
+sc_refcount_load (const sc_refcount_t * rc)
+{
+  return SC_REFCOUNT_IS_ATOMIC (rc) ? SC_ATOMIC_LOAD (&rc->refcount) :
+    rc->refcount;
+}
 
 void
 sc_refcount_init_invalid (sc_refcount_t * rc)
@@ -31,6 +46,11 @@ sc_refcount_init_invalid (sc_refcount_t * rc)
 
   rc->package_id = -1;
   rc->refcount = -1;
+#ifdef SC_ENABLE_ATOMIC_REFCOUNT
+  rc->is_atomic = 1;
+#else
+  rc->is_atomic = 0;
+#endif
 }
 
 void
@@ -41,12 +61,24 @@ sc_refcount_init (sc_refcount_t * rc, int package_id)
 
   rc->package_id = package_id;
   rc->refcount = 1;
+#ifdef SC_ENABLE_ATOMIC_REFCOUNT
+  rc->is_atomic = 1;
+#else
+  rc->is_atomic = 0;
+#endif
 
 #ifdef SC_ENABLE_DEBUG
   sc_package_rc_count_add (rc->package_id, 1);
 #endif
 }
 
+void
+sc_refcount_init_atomic (sc_refcount_t * rc, int package_id)
+{
+  sc_refcount_init (rc, package_id);
+  rc->is_atomic = 1;
+}
+
 sc_refcount_t      *
 sc_refcount_new (int package_id)
 {
@@ -62,7 +94,7 @@ void
 sc_refcount_destroy (sc_refcount_t * rc)
 {
   SC_ASSERT (rc != NULL);
-  SC_ASSERT (rc->refcount == 0);
+  SC_ASSERT (sc_refcount_load (rc) == 0);
 
   SC_FREE (rc);
 }
@@ -70,19 +102,42 @@ sc_refcount_destroy (sc_refcount_t * rc)
 void
 sc_refcount_ref (sc_refcount_t * rc)
 {
+#ifdef SC_ENABLE_DEBUG
+  int                 oldvalue;
+#endif
+
   SC_ASSERT (rc != NULL);
-  SC_ASSERT (rc->refcount > 0);
 
-  ++rc->refcount;
+  if (SC_REFCOUNT_IS_ATOMIC (rc)) {
+#ifdef SC_ENABLE_DEBUG
+    oldvalue = SC_ATOMIC_FETCH_ADD (&rc->refcount, 1);
+    SC_ASSERT (oldvalue > 0);
+#else
+    (void) SC_ATOMIC_FETCH_ADD (&rc->refcount, 1);
+#endif
+  }
+  else {
+    SC_ASSERT (rc->refcount > 0);
+    ++rc->refcount;
+  }
 }
 
 int
 sc_refcount_unref (sc_refcount_t * rc)
 {
+  int                 newvalue;
+
   SC_ASSERT (rc != NULL);
-  SC_ASSERT (rc->refcount > 0);
 
-  if (--rc->refcount == 0) {
+  if (SC_REFCOUNT_IS_ATOMIC (rc)) {
+    newvalue = SC_ATOMIC_FETCH_ADD (&rc->refcount, -1) - 1;
+  }
+  else {
+    newvalue = --rc->refcount;
+  }
+  SC_ASSERT (newvalue >= 0);
+
+  if (newvalue == 0) {
 #ifdef SC_ENABLE_DEBUG
     sc_package_rc_count_add (rc->package_id, -1);
 #endif
@@ -98,7 +153,7 @@ sc_refcount_is_active (const sc_refcount_t * rc)
 {
   SC_ASSERT (rc != NULL);
 
-  return rc->refcount > 0;
+  return sc_refcount_load (rc) > 0;
 }
 
 int
@@ -106,5 +161,5 @@ sc_refcount_is_last (const sc_refcount_t * rc)
 {
   SC_ASSERT (rc != NULL);
 
-  return rc->refcount == 1;
+  return sc_refcount_load (rc) == 1;
 }
@@ -27,6 +27,15 @@
  * The functions in this file can be used for multiple purposes.
  * The current setup is not so much targeted at garbage collection but rather
  * intended for debugging and verification.
+ *
+ * A counter may be made atomic, such that an object can be shared and
+ * released by multiple threads without an external lock.  Its changes
+ * have acquire and release semantics, so the thread that removes the last
+ * reference sees all writes to the object made before other unrefs.
+ * Counters initialized by \ref sc_refcount_init are atomic if the library
+ * is configured with --enable-atomic-refcount or -Datomic_refcount=on,
+ * and counters initialized by \ref sc_refcount_init_atomic always are.
+ * This requires the atomic builtins described in sc_atomic.h.
  */
 
 #ifndef SC_REFCOUNT_H
@@ -46,6 +55,9 @@ typedef struct sc_refcount
 
   /** The reference count is always positive for a valid counter. */
   int                 refcount;
+
+  /** True if the count is modified by atomic operations. */
+  int                 is_atomic;
 }
 sc_refcount_t;
 
@@ -70,6 +82,15 @@ void                sc_refcount_init_invalid (sc_refcount_t * rc);
  */
 void                sc_refcount_init (sc_refcount_t * rc, int package_id);
 
+/** Initialize an atomic reference counter to 1.
+ * It may be referenced and unreferenced by multiple threads concurrently.
+ * \param [out] rc          This reference counter is initialized to one.
+ *                          The object's contents may be undefined on input.
+ * \param [in] package_id   Either -1 or a package registered to libsc.
+ */
+void                sc_refcount_init_atomic (sc_refcount_t * rc,
+                                             int package_id);
+
 /** Create a new reference counter with count initialized to 1.
  * Equivalent to calling \ref sc_refcount_init on a newly allocated rc object.
  * \param [in] package_id   Either -1 or a package registered to libsc.
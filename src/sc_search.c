@@ -22,6 +22,41 @@
 */
 
 #include <sc_search.h>
+#if defined (__AVX2__)
+#include <immintrin.h>
+#define SC_SEARCH_TREE_AVX2
+#define SC_SEARCH_BIAS_AVX2
+#elif defined (__ARM_NEON) && defined (__aarch64__)
+#include <arm_neon.h>
+#define SC_SEARCH_TREE_NEON
+#define SC_SEARCH_BIAS_NEON
+#endif
+
+/** Node number of child i of node k in the search tree layout. */
+#define SC_SEARCH_TREE_CHILD(k,i) ((k) * (SC_SEARCH_TREE_NODE + 1) + (i) + 1)
+
+/** Number of tree descents interleaved by the batched search. */
+#define SC_SEARCH_TREE_GROUP 8
+
+struct sc_search_tree
+{
+  size_t              nmemb;
+  size_t              num_nodes;
+  int64_t            *keys;     /**< Node keys aligned to 64 bytes. */
+  size_t             *pos;      /**< Array position of each key slot. */
+  void               *alloc;    /**< Unaligned allocation of keys. */
+};
+
+struct sc_search_index
+{
+  const int64_t      *array;
+  size_t              nmemb;
+  int                 shift;    /**< Bucket width is 2**shift. */
+  size_t              num_buckets;      /**< A power of two. */
+  size_t             *table;    /**< First position of each bucket. */
+  void               *alloc;    /**< Unaligned allocation of table. */
+  double              build_time;
+};
 
 int
 sc_search_bias (int maxlevel, int level, int interval, int target)
@@ -34,8 +69,7 @@ sc_search_bias (int maxlevel, int level, int interval, int target)
   SC_ASSERT (0 <= interval && interval < 1 << level);
   SC_ASSERT (0 <= left && left < right && right <= 1 << maxlevel);
 
-  result = target < left ? left : target >= right ? right - 1 :
-    left + (target & ((1 << (maxlevel - level)) - 1));
+  result = sc_search_bias_inline (maxlevel, level, interval, target);
 
   SC_ASSERT (left <= result && result < right);
   SC_ASSERT (0 <= result && result < 1 << maxlevel);
@@ -43,6 +77,56 @@ sc_search_bias (int maxlevel, int level, int interval, int target)
   return result;
 }
 
+void
+sc_search_bias_array (int maxlevel, int level, const int *intervals,
+                      const int *targets, size_t n, int *results)
+{
+  size_t              zz = 0;
+#if defined SC_SEARCH_BIAS_AVX2 || defined SC_SEARCH_BIAS_NEON
+  const int           shift = maxlevel - level;
+  const int           width1 = (1 << shift) - 1;
+#endif
+
+  SC_ASSERT (0 <= level && level <= maxlevel && maxlevel < 31);
+  SC_ASSERT (n == 0 || (intervals != NULL && targets != NULL &&
+                        results != NULL));
+
+#ifdef SC_SEARCH_BIAS_AVX2
+  {
+    const __m128i       count = _mm_cvtsi32_si128 (shift);
+    const __m256i       w = _mm256_set1_epi32 (width1);
+    __m256i             left, t;
+
+    /* clamp the targets to [left, left + width - 1] */
+    for (; zz + 8 <= n; zz += 8) {
+      left = _mm256_sll_epi32
+        (_mm256_loadu_si256 ((const __m256i *) (intervals + zz)), count);
+      t = _mm256_loadu_si256 ((const __m256i *) (targets + zz));
+      t = _mm256_min_epi32 (_mm256_max_epi32 (t, left),
+                            _mm256_add_epi32 (left, w));
+      _mm256_storeu_si256 ((__m256i *) (results + zz), t);
+    }
+  }
+#elif defined SC_SEARCH_BIAS_NEON
+  {
+    const int32x4_t     count = vdupq_n_s32 (shift);
+    const int32x4_t     w = vdupq_n_s32 (width1);
+    int32x4_t           left, t;
+
+    for (; zz + 4 <= n; zz += 4) {
+      left = vshlq_s32 (vld1q_s32 (intervals + zz), count);
+      t = vld1q_s32 (targets + zz);
+      t = vminq_s32 (vmaxq_s32 (t, left), vaddq_s32 (left, w));
+      vst1q_s32 (results + zz, t);
+    }
+  }
+#endif
+  for (; zz < n; ++zz) {
+    results[zz] = sc_search_bias_inline (maxlevel, level, intervals[zz],
+                                         targets[zz]);
+  }
+}
+
 ssize_t
 sc_search_lower_bound64 (int64_t target, const int64_t * array,
                          size_t nmemb, size_t guess)
@@ -141,3 +225,426 @@ sc_bsearch_range (const void *key, const void *base, size_t nmemb,
   SC_ASSERT (compar (ckey, cbase + (guess + 1) * size) < 0);
   return guess;
 }
+
+/** Return the lowest position in [lo, nmemb] with array[k] >= target.
+ * Requires that all positions below lo hold values less than target.
+ */
+static size_t
+sc_search_gallop64 (int64_t target, const int64_t * array,
+                    size_t nmemb, size_t lo)
+{
+  size_t              hi, step, mid;
+
+  /* widen the search window exponentially from lo */
+  step = 1;
+  hi = lo;
+  while (hi < nmemb && array[hi] < target) {
+    lo = hi + 1;
+    hi = lo + step;
+    step *= 2;
+    if (hi > nmemb) {
+      hi = nmemb;
+    }
+  }
+
+  /* the result lies in [lo, hi] and array[hi] >= target if hi < nmemb */
+  while (lo < hi) {
+    mid = lo + (hi - lo) / 2;
+    if (array[mid] < target) {
+      lo = mid + 1;
+    }
+    else {
+      hi = mid;
+    }
+  }
+  return lo;
+}
+
+void
+sc_search_lower_bound64_batch (const int64_t * targets, size_t num_targets,
+                               const int64_t * array, size_t nmemb,
+                               ssize_t * positions)
+{
+  size_t              zz, lo;
+
+  SC_ASSERT (num_targets == 0 || (targets != NULL && positions != NULL));
+
+  lo = 0;
+  for (zz = 0; zz < num_targets; ++zz) {
+    if (zz > 0 && targets[zz] < targets[zz - 1]) {
+      /* unsorted input: the previous result is no lower limit */
+      lo = 0;
+    }
+    lo = sc_search_gallop64 (targets[zz], array, nmemb, lo);
+    positions[zz] = lo < nmemb ? (ssize_t) lo : -1;
+  }
+}
+
+/** Return the lowest position in [lo, nmemb + 1] with base[k] > key.
+ * Requires that all positions below lo hold values less or equal key.
+ */
+static size_t
+sc_bsearch_gallop (const void *key, const char *cbase, size_t nmemb,
+                   size_t size, int (*compar) (const void *, const void *),
+                   size_t lo)
+{
+  const size_t        count = nmemb + 1;
+  size_t              hi, step, mid;
+
+  step = 1;
+  hi = lo;
+  while (hi < count && compar (cbase + hi * size, key) <= 0) {
+    lo = hi + 1;
+    hi = lo + step;
+    step *= 2;
+    if (hi > count) {
+      hi = count;
+    }
+  }
+  while (lo < hi) {
+    mid = lo + (hi - lo) / 2;
+    if (compar (cbase + mid * size, key) <= 0) {
+      lo = mid + 1;
+    }
+    else {
+      hi = mid;
+    }
+  }
+  return lo;
+}
+
+void
+sc_bsearch_range_batch (const void *keys, size_t num_keys,
+                        const void *base, size_t nmemb, size_t size,
+                        int (*compar) (const void *, const void *),
+                        size_t *positions)
+{
+  const char         *ckeys = (const char *) keys;
+  const char         *cbase = (const char *) base;
+  size_t              zz, lo;
+
+  SC_ASSERT (num_keys == 0 || (keys != NULL && positions != NULL));
+
+  if (nmemb == 0) {
+    for (zz = 0; zz < num_keys; ++zz) {
+      positions[zz] = nmemb;
+    }
+    return;
+  }
+
+  lo = 0;
+  for (zz = 0; zz < num_keys; ++zz) {
+    if (zz > 0 && compar (ckeys + zz * size, ckeys + (zz - 1) * size) < 0) {
+      lo = 0;
+    }
+    lo = sc_bsearch_gallop (ckeys + zz * size, cbase, nmemb, size,
+                            compar, lo);
+
+    /* lo is the first entry greater than the key */
+    positions[zz] = (lo == 0 || lo > nmemb) ? nmemb : lo - 1;
+  }
+}
+
+/** Assign the sorted array to the tree slots in in-order. */
+static void
+sc_search_tree_build (sc_search_tree_t * tree, const int64_t * array,
+                      size_t k, size_t *next)
+{
+  size_t              slot;
+  int                 i;
+
+  if (k >= tree->num_nodes) {
+    return;
+  }
+  for (i = 0; i < SC_SEARCH_TREE_NODE; ++i) {
+    sc_search_tree_build (tree, array, SC_SEARCH_TREE_CHILD (k, i), next);
+    slot = k * SC_SEARCH_TREE_NODE + i;
+    if (*next < tree->nmemb) {
+      tree->keys[slot] = array[*next];
+      tree->pos[slot] = *next;
+    }
+    else {
+      /* padding sorts last and maps to not found */
+      tree->keys[slot] = INT64_MAX;
+      tree->pos[slot] = tree->nmemb;
+    }
+    ++*next;
+  }
+  sc_search_tree_build (tree, array,
+                        SC_SEARCH_TREE_CHILD (k, SC_SEARCH_TREE_NODE), next);
+}
+
+sc_search_tree_t   *
+sc_search_tree_new (const int64_t * array, size_t nmemb)
+{
+  sc_search_tree_t   *tree;
+  size_t              num_slots, next;
+#ifdef SC_ENABLE_DEBUG
+  size_t              zz;
+#endif
+
+  SC_ASSERT (nmemb == 0 || array != NULL);
+#ifdef SC_ENABLE_DEBUG
+  for (zz = 1; zz < nmemb; ++zz) {
+    SC_ASSERT (array[zz - 1] <= array[zz]);
+  }
+#endif
+
+  tree = SC_ALLOC (sc_search_tree_t, 1);
+  tree->nmemb = nmemb;
+  tree->num_nodes =
+    (nmemb + SC_SEARCH_TREE_NODE - 1) / SC_SEARCH_TREE_NODE;
+  num_slots = tree->num_nodes * SC_SEARCH_TREE_NODE;
+
+  /* one extra node allows to align the keys to a cache line */
+  tree->alloc = SC_ALLOC (int64_t, num_slots + SC_SEARCH_TREE_NODE);
+  tree->keys = (int64_t *)
+    (((size_t) tree->alloc + 63) & ~(size_t) 63);
+  tree->pos = SC_ALLOC (size_t, num_slots);
+
+  next = 0;
+  sc_search_tree_build (tree, array, 0, &next);
+  SC_ASSERT (next == num_slots);
+
+  return tree;
+}
+
+void
+sc_search_tree_destroy (sc_search_tree_t * tree)
+{
+  SC_ASSERT (tree != NULL);
+
+  SC_FREE (tree->alloc);
+  SC_FREE (tree->pos);
+  SC_FREE (tree);
+}
+
+const char         *
+sc_search_tree_kernel (void)
+{
+#if defined (SC_SEARCH_TREE_AVX2)
+  return "avx2";
+#elif defined (SC_SEARCH_TREE_NEON)
+  return "neon";
+#else
+  return "scalar";
+#endif
+}
+
+/** Count the keys of one node that are less than target. */
+static inline int
+sc_search_tree_rank (const int64_t * node, int64_t target)
+{
+#if defined (SC_SEARCH_TREE_AVX2)
+  const __m256i       t = _mm256_set1_epi64x (target);
+  __m256i             sum;
+  __m128i             half;
+
+  /* each comparison lane is -1 if the key is less than target */
+  sum = _mm256_add_epi64
+    (_mm256_cmpgt_epi64 (t, _mm256_load_si256 ((const __m256i *) node)),
+     _mm256_cmpgt_epi64 (t,
+                         _mm256_load_si256 ((const __m256i *) (node + 4))));
+  half = _mm_add_epi64 (_mm256_castsi256_si128 (sum),
+                        _mm256_extracti128_si256 (sum, 1));
+  return (int) -(_mm_cvtsi128_si64 (half) + _mm_extract_epi64 (half, 1));
+#elif defined (SC_SEARCH_TREE_NEON)
+  const int64x2_t     t = vdupq_n_s64 (target);
+  int64x2_t           sum;
+
+  sum = vaddq_s64
+    (vaddq_s64 (vreinterpretq_s64_u64 (vcltq_s64 (vld1q_s64 (node), t)),
+                vreinterpretq_s64_u64 (vcltq_s64 (vld1q_s64 (node + 2),
+                                                  t))),
+     vaddq_s64 (vreinterpretq_s64_u64 (vcltq_s64 (vld1q_s64 (node + 4), t)),
+                vreinterpretq_s64_u64 (vcltq_s64 (vld1q_s64 (node + 6),
+                                                  t))));
+  return (int) -vaddvq_s64 (sum);
+#else
+  int                 i, rank;
+
+  /* branchless such that the compiler may vectorize it */
+  rank = 0;
+  for (i = 0; i < SC_SEARCH_TREE_NODE; ++i) {
+    rank += node[i] < target;
+  }
+  return rank;
+#endif
+}
+
+ssize_t
+sc_search_tree_lower_bound (const sc_search_tree_t * tree, int64_t target)
+{
+  size_t              k, result;
+  int                 rank;
+
+  SC_ASSERT (tree != NULL);
+
+  result = tree->nmemb;
+  k = 0;
+  while (k < tree->num_nodes) {
+    rank = sc_search_tree_rank (tree->keys + k * SC_SEARCH_TREE_NODE,
+                                target);
+    if (rank < SC_SEARCH_TREE_NODE) {
+      result = tree->pos[k * SC_SEARCH_TREE_NODE + rank];
+    }
+    k = SC_SEARCH_TREE_CHILD (k, rank);
+  }
+  return result < tree->nmemb ? (ssize_t) result : -1;
+}
+
+void
+sc_search_tree_lower_bound_batch (const sc_search_tree_t * tree,
+                                  const int64_t * targets,
+                                  size_t num_targets, ssize_t * positions)
+{
+  size_t              zz, zg, count;
+  size_t              k[SC_SEARCH_TREE_GROUP];
+  size_t              result[SC_SEARCH_TREE_GROUP];
+  int                 g, active, rank;
+
+  SC_ASSERT (tree != NULL);
+  SC_ASSERT (num_targets == 0 || (targets != NULL && positions != NULL));
+
+  for (zz = 0; zz < num_targets; zz += SC_SEARCH_TREE_GROUP) {
+    count = SC_MIN (num_targets - zz, (size_t) SC_SEARCH_TREE_GROUP);
+    for (zg = 0; zg < count; ++zg) {
+      k[zg] = 0;
+      result[zg] = tree->nmemb;
+    }
+
+    /* advance all descents of the group one level at a time */
+    do {
+      active = 0;
+      for (g = 0; g < (int) count; ++g) {
+        if (k[g] >= tree->num_nodes) {
+          continue;
+        }
+        rank = sc_search_tree_rank (tree->keys + k[g] * SC_SEARCH_TREE_NODE,
+                                    targets[zz + g]);
+        if (rank < SC_SEARCH_TREE_NODE) {
+          result[g] = tree->pos[k[g] * SC_SEARCH_TREE_NODE + rank];
+        }
+        k[g] = SC_SEARCH_TREE_CHILD (k[g], rank);
+        if (k[g] < tree->num_nodes) {
+          SC_PREFETCH (tree->keys + k[g] * SC_SEARCH_TREE_NODE);
+          active = 1;
+        }
+      }
+    }
+    while (active);
+
+    for (zg = 0; zg < count; ++zg) {
+      positions[zz + zg] =
+        result[zg] < tree->nmemb ? (ssize_t) result[zg] : -1;
+    }
+  }
+}
+
+sc_search_index_t  *
+sc_search_index_new (const int64_t * array, size_t nmemb)
+{
+  sc_search_index_t  *index;
+  size_t              zz, bz;
+  uint64_t            range, bound;
+  double              start;
+
+  SC_ASSERT (nmemb == 0 || array != NULL);
+
+  start = sc_MPI_Wtime ();
+  index = SC_ALLOC_ZERO (sc_search_index_t, 1);
+  index->array = array;
+  index->nmemb = nmemb;
+
+  /* at least as many buckets as entries and wide enough for the range;
+     two buckets of width 2**63 cover any int64_t range */
+  index->num_buckets = 2;
+  while (index->num_buckets < nmemb) {
+    index->num_buckets *= 2;
+  }
+  range = nmemb > 0 ? (uint64_t) array[nmemb - 1] - (uint64_t) array[0] : 0;
+  while (index->shift < 63 &&
+         (range >> index->shift) >= (uint64_t) index->num_buckets) {
+    ++index->shift;
+  }
+
+  /* the table has one more entry to close the last bucket */
+  index->alloc = SC_ALLOC (char, (index->num_buckets + 1) * sizeof (size_t)
+                           + 64);
+  index->table = (size_t *) (((size_t) index->alloc + 63) & ~(size_t) 63);
+  zz = 0;
+  for (bz = 0; bz < index->num_buckets; ++bz) {
+    bound = (uint64_t) bz << index->shift;
+    while (zz < nmemb &&
+           (uint64_t) array[zz] - (uint64_t) array[0] < bound) {
+      SC_ASSERT (zz == 0 || array[zz - 1] <= array[zz]);
+      ++zz;
+    }
+    index->table[bz] = zz;
+  }
+  index->table[index->num_buckets] = nmemb;
+
+  index->build_time = sc_MPI_Wtime () - start;
+  return index;
+}
+
+void
+sc_search_index_destroy (sc_search_index_t * index)
+{
+  SC_ASSERT (index != NULL);
+
+  SC_FREE (index->alloc);
+  SC_FREE (index);
+}
+
+size_t
+sc_search_index_memory_used (const sc_search_index_t * index)
+{
+  SC_ASSERT (index != NULL);
+
+  return sizeof (sc_search_index_t) +
+    (index->num_buckets + 1) * sizeof (size_t) + 64;
+}
+
+double
+sc_search_index_build_time (const sc_search_index_t * index)
+{
+  SC_ASSERT (index != NULL);
+
+  return index->build_time;
+}
+
+ssize_t
+sc_search_index_lower_bound (const sc_search_index_t * index,
+                             int64_t target)
+{
+  const int64_t      *array;
+  size_t              bz, lo, hi, mid;
+
+  SC_ASSERT (index != NULL);
+
+  array = index->array;
+  if (index->nmemb == 0 || target > array[index->nmemb - 1]) {
+    return -1;
+  }
+  if (target <= array[0]) {
+    return 0;
+  }
+
+  /* the result lies in the bucket of the target or starts the next one */
+  bz = (size_t) (((uint64_t) target - (uint64_t) array[0]) >> index->shift);
+  SC_ASSERT (bz < index->num_buckets);
+  lo = index->table[bz];
+  hi = index->table[bz + 1];
+  while (lo < hi) {
+    mid = lo + (hi - lo) / 2;
+    if (array[mid] < target) {
+      lo = mid + 1;
+    }
+    else {
+      hi = mid;
+    }
+  }
+  SC_ASSERT (lo < index->nmemb);
+  return (ssize_t) lo;
+}
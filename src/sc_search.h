@@ -38,6 +38,40 @@ SC_EXTERN_C_BEGIN;
 int                 sc_search_bias (int maxlevel, int level,
                                     int interval, int target);
 
+/** Inline version of \ref sc_search_bias for loops with fixed levels.
+ * The branch is the target clamped to the interval, so a compiler may
+ * hoist the width of the interval out of a loop and vectorize it.
+ */
+/*@unused@*/
+static inline int
+sc_search_bias_inline (int maxlevel, int level, int interval, int target)
+{
+  const int           width = 1 << (maxlevel - level);
+  const int           left = interval << (maxlevel - level);
+
+  SC_ASSERT (0 <= level && level <= maxlevel);
+  SC_ASSERT (0 <= interval && interval < 1 << level);
+
+  return target < left ? left : target >= left + width ?
+    left + width - 1 : target;
+}
+
+/** Find the branches biased towards many targets on the same level.
+ * Each result equals \ref sc_search_bias for the same arguments.
+ * With AVX2 or NEON eight or four results are computed at once.
+ * \param [in] maxlevel     Depth of the tree.
+ * \param [in] level        Level of the branches for all targets.
+ * \param [in] intervals    Array of n branch numbers on level.
+ * \param [in] targets      Array of n targets.
+ * \param [in] n            Number of entries.
+ * \param [out] results     Array of n branch positions.
+ *                          May be the same as intervals or targets.
+ */
+void                sc_search_bias_array (int maxlevel, int level,
+                                          const int *intervals,
+                                          const int *targets, size_t n,
+                                          int *results);
+
 /** Find lowest position k in a sorted array such that array[k] >= target.
  * \param [in]  target  The target lower bound to binary search for.
  * \param [in]  array   The 64bit integer array to binary search in.
@@ -67,6 +101,146 @@ size_t              sc_bsearch_range (const void *key, const void *base,
                                       int (*compar) (const void *,
                                                      const void *));
 
+/** Find the lower bound positions of many targets in a sorted array.
+ * Each result is identical to calling \ref sc_search_lower_bound64.
+ * When the targets are sorted ascending, each search gallops forward
+ * from the position of the previous target, which costs
+ * O(num_targets * log (nmemb / num_targets)) comparisons in total.
+ * Unsorted targets are allowed and fall back to a full binary search
+ * whenever a target is less than its predecessor.
+ * \param [in]  targets     Array of targets to search for.
+ * \param [in]  num_targets Number of entries in targets.
+ * \param [in]  array       The sorted 64bit integer array to search in.
+ * \param [in]  nmemb       The number of int64_t's in the array.
+ * \param [out] positions   Array of length num_targets to receive the
+ *                          matching positions, or -1 where not found.
+ */
+void                sc_search_lower_bound64_batch (const int64_t * targets,
+                                                   size_t num_targets,
+                                                   const int64_t * array,
+                                                   size_t nmemb,
+                                                   ssize_t * positions);
+
+/** Search many keys in a sorted array range as \ref sc_bsearch_range does.
+ * Sorted keys are searched by galloping from the previous result.
+ * \param [in]  keys      Array of num_keys keys of size bytes each.
+ * \param [in]  num_keys  Number of keys to search.
+ * \param [in]  base      The array to binary search in.
+ * \param [in]  nmemb     Number of entries in the array MINUS ONE.
+ * \param [in]  size      Size of one key and array entry in bytes.
+ * \param [in]  compar    Comparison function as for \ref sc_bsearch_range.
+ * \param [out] positions Array of length num_keys to receive the results
+ *                        of \ref sc_bsearch_range for each key.
+ */
+void                sc_bsearch_range_batch (const void *keys,
+                                            size_t num_keys,
+                                            const void *base, size_t nmemb,
+                                            size_t size,
+                                            int (*compar) (const void *,
+                                                           const void *),
+                                            size_t *positions);
+
+/** Number of keys in one node of the \ref sc_search_tree_t layout.
+ * Eight 64bit integers fill one cache line of 64 bytes. */
+#define SC_SEARCH_TREE_NODE 8
+
+/** A sorted 64bit integer array copied into a static B-tree layout.
+ * Each node holds \ref SC_SEARCH_TREE_NODE keys in one cache line and
+ * the children of node k are numbered k * (NODE + 1) + 1 + i, which
+ * generalizes the Eytzinger layout of a binary heap.  A lower bound
+ * search touches one cache line per tree level and compares all keys
+ * of a node at once, using AVX2 or NEON when the compiler targets it.
+ */
+typedef struct sc_search_tree sc_search_tree_t;
+
+/** Build a search tree from a sorted array.
+ * \param [in] array   The sorted 64bit integer array, may contain
+ *                     duplicates.  It is copied and not referenced later.
+ * \param [in] nmemb   The number of int64_t's in the array.
+ * \return             A search tree to be freed with
+ *                     \ref sc_search_tree_destroy.
+ */
+sc_search_tree_t   *sc_search_tree_new (const int64_t * array,
+                                        size_t nmemb);
+
+/** Free a search tree created by \ref sc_search_tree_new. */
+void                sc_search_tree_destroy (sc_search_tree_t * tree);
+
+/** Return the name of the node compare kernel compiled in.
+ * \return             One of "avx2", "neon" or "scalar".
+ */
+const char         *sc_search_tree_kernel (void);
+
+/** Find lowest position k in the original array such that array[k] >= target.
+ * \param [in] tree    A search tree built by \ref sc_search_tree_new.
+ * \param [in] target  The target lower bound to search for.
+ * \return             The result of \ref sc_search_lower_bound64
+ *                     on the original array.
+ */
+ssize_t             sc_search_tree_lower_bound (const sc_search_tree_t *
+                                                tree, int64_t target);
+
+/** Find the lower bounds of many targets in a search tree.
+ * The descents for consecutive targets are interleaved in small groups,
+ * such that the memory accesses of one group overlap.
+ * \param [in]  tree        A search tree built by \ref sc_search_tree_new.
+ * \param [in]  targets     Array of targets in any order.
+ * \param [in]  num_targets Number of entries in targets.
+ * \param [out] positions   Array of length num_targets to receive the
+ *                          results of \ref sc_search_tree_lower_bound.
+ */
+void                sc_search_tree_lower_bound_batch (const sc_search_tree_t
+                                                      * tree,
+                                                      const int64_t * targets,
+                                                      size_t num_targets,
+                                                      ssize_t * positions);
+
+/** An interpolation index over a sorted 64bit integer array.
+ * The value range of the array is cut into a power of two of equally
+ * wide buckets, at least as many as there are array entries, and a
+ * cache-aligned table stores the first array position of each bucket.
+ * A lower bound query computes its bucket by a subtraction and a shift
+ * and searches only the entries between two consecutive table values.
+ * For evenly spread values, such as partition offsets, this is O(1).
+ * The array is referenced and must stay unchanged while the index lives.
+ */
+typedef struct sc_search_index sc_search_index_t;
+
+/** Build a search index for a sorted array.
+ * \param [in] array   The sorted 64bit integer array, may contain
+ *                     duplicates.  It is referenced, not copied.
+ * \param [in] nmemb   The number of int64_t's in the array.
+ * \return             An index to be freed by \ref sc_search_index_destroy.
+ */
+sc_search_index_t  *sc_search_index_new (const int64_t * array,
+                                         size_t nmemb);
+
+/** Free a search index created by \ref sc_search_index_new. */
+void                sc_search_index_destroy (sc_search_index_t * index);
+
+/** Return the bytes of memory held by a search index.
+ * \param [in] index   A valid search index.
+ * \return             Memory used by the index, excluding the array.
+ */
+size_t              sc_search_index_memory_used (const sc_search_index_t *
+                                                 index);
+
+/** Return the wall clock time it took to build a search index.
+ * \param [in] index   A valid search index.
+ * \return             Build time in seconds as measured by sc_MPI_Wtime.
+ */
+double              sc_search_index_build_time (const sc_search_index_t *
+                                                index);
+
+/** Find lowest position k in the indexed array such that array[k] >= target.
+ * \param [in] index   A valid search index.
+ * \param [in] target  The target lower bound to search for.
+ * \return             The result of \ref sc_search_lower_bound64
+ *                     on the indexed array.
+ */
+ssize_t             sc_search_index_lower_bound (const sc_search_index_t *
+                                                 index, int64_t target);
+
 SC_EXTERN_C_END;
 
 #endif /* !SC_SEARCH_H */
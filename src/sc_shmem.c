@@ -22,6 +22,7 @@
 */
 
 #include <sc_shmem.h>
+#include <sc_containers.h>
 
 #if defined(__bgq__)
 /** for sc_allgather_final_*_bgq routines to work on BG/Q, you must
@@ -43,122 +44,75 @@ const char         *sc_shmem_type_to_string[SC_SHMEM_NUM_TYPES] = {
 #endif
 };
 
+/* Add the previous row to each row, or the row offset if it is not NULL.
+ * The rows do not overlap, such that the inner loop vectorizes. */
+#define SC_SCAN_ROWS(T) do {                                    \
+  for (p = first; p <= last; p++) {                             \
+    T                  *_sc_restrict cur =                      \
+      (T *) recvchar + (size_t) count * p;                      \
+    const T            *_sc_restrict prev = offset != NULL ?    \
+      (const T *) offset : cur - count;                         \
+    for (c = 0; c < count; c++) {                               \
+      cur[c] += prev[c];                                        \
+    }                                                           \
+  }                                                             \
+} while (0)
+
+/* Scan the rows first through last of count items each.  With an offset,
+ * add it to each of these rows instead. */
 static void
-sc_scan_on_array (void *recvchar, int size, int count, int typesize,
-                  sc_MPI_Datatype type, sc_MPI_Op op)
+sc_scan_on_array (void *recvchar, const void *offset, int first, int last,
+                  int count, int typesize, sc_MPI_Datatype type,
+                  sc_MPI_Op op)
 {
   int                 p, c;
 
+  SC_ASSERT (offset != NULL || first >= 1);
+
   if (op == sc_MPI_SUM) {
     if (type == sc_MPI_CHAR || type == sc_MPI_BYTE) {
-      char               *array = (char *) recvchar;
-
-      SC_ASSERT (sizeof (*array) == typesize);
-      for (p = 1; p <= size; p++) {
-        for (c = 0; c < count; c++) {
-          array[count * p + c] += array[count * (p - 1) + c];
-        }
-      }
+      SC_ASSERT (sizeof (char) == typesize);
+      SC_SCAN_ROWS (char);
     }
     else if (type == sc_MPI_SHORT) {
-      short              *array = (short *) recvchar;
-
-      SC_ASSERT (sizeof (*array) == typesize);
-      for (p = 1; p <= size; p++) {
-        for (c = 0; c < count; c++) {
-          array[count * p + c] += array[count * (p - 1) + c];
-        }
-      }
+      SC_ASSERT (sizeof (short) == typesize);
+      SC_SCAN_ROWS (short);
     }
     else if (type == sc_MPI_UNSIGNED_SHORT) {
-      unsigned short     *array = (unsigned short *) recvchar;
-
-      SC_ASSERT (sizeof (*array) == typesize);
-      for (p = 1; p <= size; p++) {
-        for (c = 0; c < count; c++) {
-          array[count * p + c] += array[count * (p - 1) + c];
-        }
-      }
+      SC_ASSERT (sizeof (unsigned short) == typesize);
+      SC_SCAN_ROWS (unsigned short);
     }
     else if (type == sc_MPI_INT) {
-      int                *array = (int *) recvchar;
-
-      SC_ASSERT (sizeof (*array) == typesize);
-      for (p = 1; p <= size; p++) {
-        for (c = 0; c < count; c++) {
-          array[count * p + c] += array[count * (p - 1) + c];
-        }
-      }
+      SC_ASSERT (sizeof (int) == typesize);
+      SC_SCAN_ROWS (int);
     }
     else if (type == sc_MPI_UNSIGNED) {
-      unsigned           *array = (unsigned *) recvchar;
-
-      SC_ASSERT (sizeof (*array) == typesize);
-      for (p = 1; p <= size; p++) {
-        for (c = 0; c < count; c++) {
-          array[count * p + c] += array[count * (p - 1) + c];
-        }
-      }
+      SC_ASSERT (sizeof (unsigned) == typesize);
+      SC_SCAN_ROWS (unsigned);
     }
     else if (type == sc_MPI_LONG) {
-      long               *array = (long *) recvchar;
-
-      SC_ASSERT (sizeof (*array) == typesize);
-      for (p = 1; p <= size; p++) {
-        for (c = 0; c < count; c++) {
-          array[count * p + c] += array[count * (p - 1) + c];
-        }
-      }
+      SC_ASSERT (sizeof (long) == typesize);
+      SC_SCAN_ROWS (long);
     }
     else if (type == sc_MPI_UNSIGNED_LONG) {
-      unsigned long      *array = (unsigned long *) recvchar;
-
-      SC_ASSERT (sizeof (*array) == typesize);
-      for (p = 1; p <= size; p++) {
-        for (c = 0; c < count; c++) {
-          array[count * p + c] += array[count * (p - 1) + c];
-        }
-      }
+      SC_ASSERT (sizeof (unsigned long) == typesize);
+      SC_SCAN_ROWS (unsigned long);
     }
     else if (type == sc_MPI_LONG_LONG_INT) {
-      long long          *array = (long long *) recvchar;
-
-      SC_ASSERT (sizeof (*array) == typesize);
-      for (p = 1; p <= size; p++) {
-        for (c = 0; c < count; c++) {
-          array[count * p + c] += array[count * (p - 1) + c];
-        }
-      }
+      SC_ASSERT (sizeof (long long) == typesize);
+      SC_SCAN_ROWS (long long);
     }
     else if (type == sc_MPI_FLOAT) {
-      float              *array = (float *) recvchar;
-
-      SC_ASSERT (sizeof (*array) == typesize);
-      for (p = 1; p <= size; p++) {
-        for (c = 0; c < count; c++) {
-          array[count * p + c] += array[count * (p - 1) + c];
-        }
-      }
+      SC_ASSERT (sizeof (float) == typesize);
+      SC_SCAN_ROWS (float);
     }
     else if (type == sc_MPI_DOUBLE) {
-      double             *array = (double *) recvchar;
-
-      SC_ASSERT (sizeof (*array) == typesize);
-      for (p = 1; p <= size; p++) {
-        for (c = 0; c < count; c++) {
-          array[count * p + c] += array[count * (p - 1) + c];
-        }
-      }
+      SC_ASSERT (sizeof (double) == typesize);
+      SC_SCAN_ROWS (double);
     }
     else if (type == sc_MPI_LONG_DOUBLE) {
-      long double        *array = (long double *) recvchar;
-
-      SC_ASSERT (sizeof (*array) == typesize);
-      for (p = 1; p <= size; p++) {
-        for (c = 0; c < count; c++) {
-          array[count * p + c] += array[count * (p - 1) + c];
-        }
-      }
+      SC_ASSERT (sizeof (long double) == typesize);
+      SC_SCAN_ROWS (long double);
     }
     else {
       SC_ABORT ("MPI_Datatype not supported\n");
@@ -173,6 +127,7 @@ sc_scan_on_array (void *recvchar, int size, int count, int typesize,
 #define SC_SHMEM_DEFAULT SC_SHMEM_BASIC
 #endif
 sc_shmem_type_t     sc_shmem_default_type = SC_SHMEM_DEFAULT;
+size_t              sc_shmem_prefix_node_items = SC_SHMEM_PREFIX_NODE_ITEMS;
 
 #ifdef SC_ENABLE_MPI
 
@@ -244,6 +199,69 @@ sc_shmem_set_type (sc_MPI_Comm comm, sc_shmem_type_t type)
 #endif
 }
 
+sc_shmem_type_t
+sc_shmem_set_type_probe (sc_MPI_Comm comm, int count, int repetitions)
+{
+  int                 mpiret, size, itype, r;
+  long int           *myval, *recv, *scan;
+  double              elapsed[2], slowest[2], best = -1.;
+  sc_shmem_type_t     type, fastest = SC_SHMEM_BASIC;
+
+  SC_ASSERT (count >= 0 && repetitions > 0);
+
+  mpiret = sc_MPI_Comm_size (comm, &size);
+  SC_CHECK_MPI (mpiret);
+
+  myval = SC_ALLOC_ZERO (long int, count);
+  for (itype = 0; itype < (int) SC_SHMEM_NUM_TYPES; ++itype) {
+    type = (sc_shmem_type_t) itype;
+    sc_shmem_set_type (comm, type);
+    recv = SC_SHMEM_ALLOC (long int, (size_t) count * size, comm);
+    scan = SC_SHMEM_ALLOC (long int, (size_t) count * (size + 1), comm);
+
+    mpiret = sc_MPI_Barrier (comm);
+    SC_CHECK_MPI (mpiret);
+    elapsed[0] = -sc_MPI_Wtime ();
+    for (r = 0; r < repetitions; ++r) {
+      sc_shmem_allgather (myval, count, sc_MPI_LONG, recv, count,
+                          sc_MPI_LONG, comm);
+    }
+    elapsed[0] += sc_MPI_Wtime ();
+
+    mpiret = sc_MPI_Barrier (comm);
+    SC_CHECK_MPI (mpiret);
+    elapsed[1] = -sc_MPI_Wtime ();
+    for (r = 0; r < repetitions; ++r) {
+      sc_shmem_prefix (myval, scan, count, sc_MPI_LONG, sc_MPI_SUM, comm);
+    }
+    elapsed[1] += sc_MPI_Wtime ();
+
+    SC_SHMEM_FREE (scan, comm);
+    SC_SHMEM_FREE (recv, comm);
+
+    /* all processes agree on the slowest times */
+    mpiret = sc_MPI_Allreduce (elapsed, slowest, 2, sc_MPI_DOUBLE,
+                               sc_MPI_MAX, comm);
+    SC_CHECK_MPI (mpiret);
+    SC_GLOBAL_STATISTICSF ("sc_shmem type %s: allgather %g prefix %g\n",
+                           sc_shmem_type_to_string[itype],
+                           slowest[0] / repetitions,
+                           slowest[1] / repetitions);
+    if (best < 0. || slowest[0] + slowest[1] < best) {
+      best = slowest[0] + slowest[1];
+      fastest = type;
+    }
+  }
+  SC_FREE (myval);
+
+  SC_GLOBAL_STATISTICSF ("sc_shmem type probe selects %s\n",
+                         sc_shmem_type_to_string[fastest]);
+  sc_shmem_set_type (comm, fastest);
+
+  /* without MPI the type is always basic */
+  return sc_shmem_get_type (comm);
+}
+
 static              sc_shmem_type_t
 sc_shmem_get_type_default (sc_MPI_Comm comm)
 {
@@ -320,7 +338,7 @@ sc_shmem_prefix_basic (void *sendbuf, void *recvbuf, int count,
   SC_CHECK_MPI (mpiret);
   mpiret = sc_MPI_Comm_size (comm, &size);
   SC_CHECK_MPI (mpiret);
-  sc_scan_on_array (recvbuf, size, count, typesize, type, op);
+  sc_scan_on_array (recvbuf, NULL, 1, size, count, typesize, type, op);
 }
 
 /* PRESCAN implementation */
@@ -349,6 +367,14 @@ sc_shmem_prefix_prescan (void *sendbuf, void *recvbuf, int count,
 
 /* common to SHARED and WINDOW */
 
+#if defined(SC_ENABLE_MPIWINSHARED)
+static void         sc_shmem_prefix_node (void *recvbuf, int size, int count,
+                                          int typesize, sc_MPI_Datatype type,
+                                          sc_MPI_Op op, sc_MPI_Comm comm,
+                                          sc_MPI_Comm intranode,
+                                          sc_MPI_Comm internode);
+#endif
+
 #if defined(__bgq__) || defined(SC_ENABLE_MPIWINSHARED)
 
 static void
@@ -408,6 +434,7 @@ sc_shmem_prefix_common (void *sendbuf, void *recvbuf, int count,
 {
   size_t              typesize;
   int                 mpiret, intrarank, intrasize, size;
+  int                 split = 0;
   char               *noderecvchar = NULL;
 
   typesize = sc_mpi_sizeof (type);
@@ -418,6 +445,11 @@ sc_shmem_prefix_common (void *sendbuf, void *recvbuf, int count,
   SC_CHECK_MPI (mpiret);
   mpiret = sc_MPI_Comm_size (intranode, &intrasize);
   SC_CHECK_MPI (mpiret);
+#if defined(SC_ENABLE_MPIWINSHARED)
+  /* the processes of the node share the scan of large arrays */
+  split = sc_shmem_get_type (comm) == SC_SHMEM_WINDOW && intrasize > 1 &&
+    (size_t) size * count >= sc_shmem_prefix_node_items;
+#endif
 
   /* node root gathers from node */
   if (!intrarank) {
@@ -437,9 +469,17 @@ sc_shmem_prefix_common (void *sendbuf, void *recvbuf, int count,
                         count * intrasize, type, internode);
     SC_CHECK_MPI (mpiret);
     SC_FREE (noderecvchar);
-    sc_scan_on_array (recvbuf, size, count, typesize, type, op);
+    if (!split) {
+      sc_scan_on_array (recvbuf, NULL, 1, size, count, typesize, type, op);
+    }
   }
   sc_shmem_write_end (recvbuf, comm);
+#if defined(SC_ENABLE_MPIWINSHARED)
+  if (split) {
+    sc_shmem_prefix_node (recvbuf, size, count, typesize, type, op, comm,
+                          intranode, internode);
+  }
+#endif
 }
 
 static void
@@ -669,6 +709,207 @@ sc_shmem_write_end_window (void *array, sc_MPI_Comm comm,
   SC_CHECK_MPI (mpiret);
 }
 
+/* Allocate a window of winsize bytes on the node root and lock it for all.
+ * The returned pointer is the beginning of the shared memory. */
+static char        *
+sc_shmem_node_window (size_t winsize, sc_MPI_Comm intranode, MPI_Win * win)
+{
+  char               *array = NULL;
+  int                 mpiret, disp_unit, intrarank;
+  MPI_Aint            querysize;
+
+  mpiret = sc_MPI_Comm_rank (intranode, &intrarank);
+  SC_CHECK_MPI (mpiret);
+  mpiret = MPI_Win_allocate_shared ((MPI_Aint) (intrarank ? 0 : winsize), 1,
+                                    MPI_INFO_NULL, intranode, &array, win);
+  SC_CHECK_MPI (mpiret);
+  mpiret = MPI_Win_shared_query (*win, 0, &querysize, &disp_unit, &array);
+  SC_CHECK_MPI (mpiret);
+  mpiret = MPI_Win_lock_all (MPI_MODE_NOCHECK, *win);
+  SC_CHECK_MPI (mpiret);
+  return array;
+}
+
+/* Make the writes to the window visible to all processes on the node. */
+static void
+sc_shmem_node_sync (sc_MPI_Comm intranode, MPI_Win win)
+{
+  int                 mpiret;
+
+  mpiret = MPI_Win_sync (win);
+  SC_CHECK_MPI (mpiret);
+  mpiret = sc_MPI_Barrier (intranode);
+  SC_CHECK_MPI (mpiret);
+  mpiret = MPI_Win_sync (win);
+  SC_CHECK_MPI (mpiret);
+}
+
+static void
+sc_shmem_node_window_free (MPI_Win * win)
+{
+  int                 mpiret;
+
+  mpiret = MPI_Win_unlock_all (*win);
+  SC_CHECK_MPI (mpiret);
+  mpiret = MPI_Win_free (win);
+  SC_CHECK_MPI (mpiret);
+}
+
+static void
+sc_shmem_node_allgather_window (void *sendbuf, size_t datasize,
+                                void *recvbuf, sc_MPI_Comm comm,
+                                sc_MPI_Comm intranode, sc_MPI_Comm internode)
+{
+  int                 mpiret, mpisize, mpirank, intrasize, intrarank;
+  int                 i, *noderanks = NULL, *allranks;
+  char               *shared, *nodedata, *alldata;
+  MPI_Win             win;
+
+  mpiret = sc_MPI_Comm_size (comm, &mpisize);
+  SC_CHECK_MPI (mpiret);
+  mpiret = sc_MPI_Comm_rank (comm, &mpirank);
+  SC_CHECK_MPI (mpiret);
+  mpiret = sc_MPI_Comm_size (intranode, &intrasize);
+  SC_CHECK_MPI (mpiret);
+  mpiret = sc_MPI_Comm_rank (intranode, &intrarank);
+  SC_CHECK_MPI (mpiret);
+
+  /* the processes of a node need not be contiguous in comm */
+  if (!intrarank) {
+    noderanks = SC_ALLOC (int, intrasize);
+  }
+  mpiret = sc_MPI_Gather (&mpirank, 1, sc_MPI_INT, noderanks, 1, sc_MPI_INT,
+                          0, intranode);
+  SC_CHECK_MPI (mpiret);
+
+  /* every process writes its contribution into the shared result */
+  shared = sc_shmem_node_window ((size_t) mpisize * datasize, intranode,
+                                 &win);
+  memcpy (shared + mpirank * datasize, sendbuf, datasize);
+  sc_shmem_node_sync (intranode, win);
+
+  /* only the node roots exchange the data of their nodes */
+  if (!intrarank) {
+    allranks = SC_ALLOC (int, mpisize);
+    mpiret = sc_MPI_Allgather (noderanks, intrasize, sc_MPI_INT,
+                               allranks, intrasize, sc_MPI_INT, internode);
+    SC_CHECK_MPI (mpiret);
+
+    nodedata = SC_ALLOC (char, intrasize * datasize);
+    alldata = SC_ALLOC (char, mpisize * datasize);
+    for (i = 0; i < intrasize; ++i) {
+      memcpy (nodedata + i * datasize, shared + noderanks[i] * datasize,
+              datasize);
+    }
+    mpiret = sc_MPI_Allgather (nodedata, (int) (intrasize * datasize),
+                               sc_MPI_BYTE, alldata,
+                               (int) (intrasize * datasize), sc_MPI_BYTE,
+                               internode);
+    SC_CHECK_MPI (mpiret);
+    for (i = 0; i < mpisize; ++i) {
+      memcpy (shared + allranks[i] * datasize, alldata + i * datasize,
+              datasize);
+    }
+    SC_FREE (alldata);
+    SC_FREE (nodedata);
+    SC_FREE (allranks);
+    SC_FREE (noderanks);
+  }
+  sc_shmem_node_sync (intranode, win);
+
+  memcpy (recvbuf, shared, mpisize * datasize);
+  sc_shmem_node_window_free (&win);
+}
+
+static void
+sc_shmem_node_allreduce_window (void *sendbuf, void *recvbuf, int count,
+                                sc_MPI_Datatype type, sc_MPI_Op op,
+                                sc_MPI_Comm intranode, sc_MPI_Comm internode)
+{
+  int                 mpiret, intrasize, intrarank;
+  int                 q, lo, hi;
+  size_t              typesize, datasize;
+  char               *shared;
+  MPI_Win             win;
+
+  mpiret = sc_MPI_Comm_size (intranode, &intrasize);
+  SC_CHECK_MPI (mpiret);
+  mpiret = sc_MPI_Comm_rank (intranode, &intrarank);
+  SC_CHECK_MPI (mpiret);
+
+  /* one slot per process of the node followed by the result */
+  typesize = sc_mpi_sizeof (type);
+  datasize = (size_t) count * typesize;
+  shared = sc_shmem_node_window ((intrasize + 1) * datasize, intranode,
+                                 &win);
+  memcpy (shared + intrarank * datasize, sendbuf, datasize);
+  sc_shmem_node_sync (intranode, win);
+
+  /* each process reduces its share of the items into the first slot */
+  lo = (int) ((long long) count * intrarank / intrasize);
+  hi = (int) ((long long) count * (intrarank + 1) / intrasize);
+  for (q = 1; q < intrasize; ++q) {
+    mpiret = MPI_Reduce_local (shared + q * datasize + lo * typesize,
+                               shared + lo * typesize, hi - lo, type, op);
+    SC_CHECK_MPI (mpiret);
+  }
+  sc_shmem_node_sync (intranode, win);
+
+  /* only the node roots reduce between nodes */
+  if (!intrarank) {
+    mpiret = sc_MPI_Allreduce (shared, shared + intrasize * datasize, count,
+                               type, op, internode);
+    SC_CHECK_MPI (mpiret);
+  }
+  sc_shmem_node_sync (intranode, win);
+
+  memcpy (recvbuf, shared + intrasize * datasize, datasize);
+  sc_shmem_node_window_free (&win);
+}
+
+/* Scan the rows 1 through size of a window array by blocks of rows, one
+ * per process of the node.  Each process scans its block, adds the sum of
+ * the last rows of the blocks before it, then adds this to its block. */
+static void
+sc_shmem_prefix_node (void *recvbuf, int size, int count, int typesize,
+                      sc_MPI_Datatype type, sc_MPI_Op op, sc_MPI_Comm comm,
+                      sc_MPI_Comm intranode, sc_MPI_Comm internode)
+{
+  int                 mpiret, intrarank, intrasize, i, lo, hi, last;
+  char               *offset;
+  MPI_Win             win;
+
+  win = sc_shmem_get_win (recvbuf, comm, intranode, internode);
+  mpiret = sc_MPI_Comm_rank (intranode, &intrarank);
+  SC_CHECK_MPI (mpiret);
+  mpiret = sc_MPI_Comm_size (intranode, &intrasize);
+  SC_CHECK_MPI (mpiret);
+
+  lo = 1 + (int) ((long long) size * intrarank / intrasize);
+  hi = (int) ((long long) size * (intrarank + 1) / intrasize);
+  if (lo < hi) {
+    sc_scan_on_array (recvbuf, NULL, lo + 1, hi, count, typesize, type, op);
+  }
+  sc_shmem_node_sync (intranode, win);
+
+  offset = SC_ALLOC_ZERO (char, (size_t) count * typesize);
+  for (i = 0; i < intrarank; ++i) {
+    last = (int) ((long long) size * (i + 1) / intrasize);
+    if (last >= 1 + (int) ((long long) size * i / intrasize)) {
+      sc_scan_on_array (offset, (char *) recvbuf +
+                        (size_t) count * typesize * last, 0, 0, count,
+                        typesize, type, op);
+    }
+  }
+  sc_shmem_node_sync (intranode, win);
+
+  if (intrarank > 0 && lo <= hi) {
+    sc_scan_on_array (recvbuf, offset, lo, hi, count, typesize, type, op);
+  }
+  SC_FREE (offset);
+  sc_shmem_node_sync (intranode, win);
+}
+
 #endif /* SC_ENABLE_MPIWINSHARED */
 
 void               *
@@ -858,6 +1099,7 @@ sc_shmem_allgather (void *sendbuf, int sendcount,
   if (intranode == sc_MPI_COMM_NULL || internode == sc_MPI_COMM_NULL) {
     type = SC_SHMEM_BASIC;
   }
+  sc_mpi_profile_enter (SC_MPI_CALLER_SHMEM);
   switch (type) {
   case SC_SHMEM_BASIC:
   case SC_SHMEM_PRESCAN:
@@ -882,6 +1124,7 @@ sc_shmem_allgather (void *sendbuf, int sendcount,
   default:
     SC_ABORT_NOT_REACHED ();
   }
+  sc_mpi_profile_leave ();
 }
 
 void
@@ -897,6 +1140,7 @@ sc_shmem_prefix (void *sendbuf, void *recvbuf, int count,
   if (intranode == sc_MPI_COMM_NULL || internode == sc_MPI_COMM_NULL) {
     type = SC_SHMEM_BASIC;
   }
+  sc_mpi_profile_enter (SC_MPI_CALLER_SHMEM);
   switch (type) {
   case SC_SHMEM_BASIC:
     sc_shmem_prefix_basic (sendbuf, recvbuf, count, dtype, op, comm,
@@ -931,4 +1175,301 @@ sc_shmem_prefix (void *sendbuf, void *recvbuf, int count,
   default:
     SC_ABORT_NOT_REACHED ();
   }
+  sc_mpi_profile_leave ();
+}
+
+void
+sc_shmem_node_allgather (void *sendbuf, int sendcount,
+                         sc_MPI_Datatype sendtype, void *recvbuf,
+                         int recvcount, sc_MPI_Datatype recvtype,
+                         sc_MPI_Comm comm)
+{
+  int                 mpiret;
+  sc_MPI_Comm         intranode = sc_MPI_COMM_NULL, internode =
+    sc_MPI_COMM_NULL;
+
+  SC_ASSERT ((size_t) sendcount * sc_mpi_sizeof (sendtype) ==
+             (size_t) recvcount * sc_mpi_sizeof (recvtype));
+
+  sc_mpi_comm_get_node_comms (comm, &intranode, &internode);
+  sc_mpi_profile_enter (SC_MPI_CALLER_SHMEM);
+#if defined(SC_ENABLE_MPIWINSHARED)
+  if (intranode != sc_MPI_COMM_NULL && internode != sc_MPI_COMM_NULL) {
+    sc_shmem_node_allgather_window (sendbuf, (size_t) sendcount *
+                                    sc_mpi_sizeof (sendtype), recvbuf,
+                                    comm, intranode, internode);
+    sc_mpi_profile_leave ();
+    return;
+  }
+#endif
+  mpiret = sc_MPI_Allgather (sendbuf, sendcount, sendtype,
+                             recvbuf, recvcount, recvtype, comm);
+  SC_CHECK_MPI (mpiret);
+  sc_mpi_profile_leave ();
+}
+
+void
+sc_shmem_node_allreduce (void *sendbuf, void *recvbuf, int count,
+                         sc_MPI_Datatype type, sc_MPI_Op op, sc_MPI_Comm comm)
+{
+  int                 mpiret;
+  sc_MPI_Comm         intranode = sc_MPI_COMM_NULL, internode =
+    sc_MPI_COMM_NULL;
+
+  sc_mpi_comm_get_node_comms (comm, &intranode, &internode);
+  sc_mpi_profile_enter (SC_MPI_CALLER_SHMEM);
+#if defined(SC_ENABLE_MPIWINSHARED)
+  if (intranode != sc_MPI_COMM_NULL && internode != sc_MPI_COMM_NULL) {
+    sc_shmem_node_allreduce_window (sendbuf, recvbuf, count, type, op,
+                                    intranode, internode);
+    sc_mpi_profile_leave ();
+    return;
+  }
+#endif
+  mpiret = sc_MPI_Allreduce (sendbuf, recvbuf, count, type, op, comm);
+  SC_CHECK_MPI (mpiret);
+  sc_mpi_profile_leave ();
+}
+
+struct sc_shmem_array
+{
+  sc_MPI_Comm         comm, intranode, internode;
+  size_t              elem_size, elem_count;
+  int                 num_versions, current;
+  char               *versions[2];
+  sc_array_t          pending; /**< slices written here since the commit */
+  sc_array_t          received; /**< slices of other nodes in the commit */
+#if defined(SC_ENABLE_MPIWINSHARED)
+  int                 shared;
+  MPI_Win             win;
+#endif
+};
+
+/* Slices are packed as two size_t for first and count followed by data. */
+#define SC_SHMEM_SLICE_HEADER (2 * sizeof (size_t))
+
+static void
+sc_shmem_array_sync (sc_shmem_array_t * sarr)
+{
+#if defined(SC_ENABLE_MPIWINSHARED)
+  if (sarr->shared) {
+    sc_shmem_node_sync (sarr->intranode, sarr->win);
+  }
+#endif
+}
+
+/* Write packed slices into one version.  With from not NULL, we copy the
+ * ranges of the slices from there instead of their data. */
+static void
+sc_shmem_array_apply (sc_shmem_array_t * sarr, char *dest, const char *src,
+                      size_t bytes, const char *from)
+{
+  size_t              pos, first, count, size;
+
+  for (pos = 0; pos < bytes; pos += SC_SHMEM_SLICE_HEADER + size) {
+    memcpy (&first, src + pos, sizeof (size_t));
+    memcpy (&count, src + pos + sizeof (size_t), sizeof (size_t));
+    size = count * sarr->elem_size;
+    SC_ASSERT (first + count <= sarr->elem_count);
+    memcpy (dest + first * sarr->elem_size,
+            from != NULL ? from + first * sarr->elem_size :
+            src + pos + SC_SHMEM_SLICE_HEADER, size);
+  }
+  SC_ASSERT (pos == bytes);
+}
+
+sc_shmem_array_t   *
+sc_shmem_array_new (sc_MPI_Comm comm, size_t elem_size, size_t elem_count,
+                    int double_buffered)
+{
+  size_t              bytes;
+  sc_shmem_array_t   *sarr;
+
+  sarr = SC_ALLOC_ZERO (sc_shmem_array_t, 1);
+  sarr->comm = comm;
+  sarr->elem_size = elem_size;
+  sarr->elem_count = elem_count;
+  sarr->num_versions = double_buffered ? 2 : 1;
+  sc_array_init (&sarr->pending, 1);
+  sc_array_init (&sarr->received, 1);
+
+  sarr->intranode = sarr->internode = sc_MPI_COMM_NULL;
+  sc_mpi_comm_get_node_comms (comm, &sarr->intranode, &sarr->internode);
+  bytes = elem_size * elem_count;
+#if defined(SC_ENABLE_MPIWINSHARED)
+  if (sarr->intranode != sc_MPI_COMM_NULL &&
+      sarr->internode != sc_MPI_COMM_NULL) {
+    int                 mpiret, intrarank;
+
+    sarr->shared = 1;
+    sarr->versions[0] = sc_shmem_node_window (sarr->num_versions * bytes,
+                                              sarr->intranode, &sarr->win);
+    mpiret = sc_MPI_Comm_rank (sarr->intranode, &intrarank);
+    SC_CHECK_MPI (mpiret);
+    if (!intrarank) {
+      memset (sarr->versions[0], 0, sarr->num_versions * bytes);
+    }
+    sc_shmem_array_sync (sarr);
+  }
+  else
+#endif
+  {
+    /* every process is a node of its own */
+    sarr->intranode = sc_MPI_COMM_NULL;
+    sarr->internode = comm;
+    sarr->versions[0] = SC_ALLOC_ZERO (char, sarr->num_versions * bytes);
+  }
+  sarr->versions[1] = sarr->versions[0] + (sarr->num_versions - 1) * bytes;
+
+  return sarr;
+}
+
+void
+sc_shmem_array_destroy (sc_shmem_array_t * sarr)
+{
+#if defined(SC_ENABLE_MPIWINSHARED)
+  if (sarr->shared) {
+    sc_shmem_node_window_free (&sarr->win);
+  }
+  else
+#endif
+  {
+    SC_FREE (sarr->versions[0]);
+  }
+  sc_array_reset (&sarr->pending);
+  sc_array_reset (&sarr->received);
+  SC_FREE (sarr);
+}
+
+const void         *
+sc_shmem_array_read (sc_shmem_array_t * sarr)
+{
+  return sarr->versions[sarr->current];
+}
+
+void
+sc_shmem_array_write (sc_shmem_array_t * sarr, size_t first, size_t count,
+                      const void *data)
+{
+  size_t              size;
+  char               *slice;
+
+  SC_ASSERT (first + count <= sarr->elem_count);
+  SC_ASSERT (count == 0 || data != NULL);
+
+  size = count * sarr->elem_size;
+  memcpy (sarr->versions[sarr->current ^ (sarr->num_versions - 1)] +
+          first * sarr->elem_size, data, size);
+
+  /* remember the slice for the other nodes */
+  slice = (char *) sc_array_push_count (&sarr->pending,
+                                        SC_SHMEM_SLICE_HEADER + size);
+  memcpy (slice, &first, sizeof (size_t));
+  memcpy (slice + sizeof (size_t), &count, sizeof (size_t));
+  memcpy (slice + SC_SHMEM_SLICE_HEADER, data, size);
+}
+
+void
+sc_shmem_array_commit (sc_shmem_array_t * sarr)
+{
+  int                 mpiret, num_procs, myproc, q, mybytes;
+  int                *counts, *displs;
+  char               *back;
+
+  /* exchange the slices between processes of the same node position */
+  sc_mpi_profile_enter (SC_MPI_CALLER_SHMEM);
+  mpiret = sc_MPI_Comm_size (sarr->internode, &num_procs);
+  SC_CHECK_MPI (mpiret);
+  mpiret = sc_MPI_Comm_rank (sarr->internode, &myproc);
+  SC_CHECK_MPI (mpiret);
+  counts = SC_ALLOC (int, 2 * num_procs);
+  displs = counts + num_procs;
+  mybytes = (int) sarr->pending.elem_count;
+  mpiret = sc_MPI_Allgather (&mybytes, 1, sc_MPI_INT, counts, 1, sc_MPI_INT,
+                             sarr->internode);
+  SC_CHECK_MPI (mpiret);
+  displs[0] = 0;
+  for (q = 1; q < num_procs; ++q) {
+    displs[q] = displs[q - 1] + counts[q - 1];
+  }
+  sc_array_resize (&sarr->received,
+                   (size_t) (displs[num_procs - 1] + counts[num_procs - 1]));
+  if (sarr->received.elem_count > 0) {
+    mpiret = sc_MPI_Allgatherv (sarr->pending.array, mybytes, sc_MPI_BYTE,
+                                sarr->received.array, counts, displs,
+                                sc_MPI_BYTE, sarr->internode);
+    SC_CHECK_MPI (mpiret);
+  }
+
+  /* the own slices are in the back version already */
+  back = sarr->versions[sarr->current ^ (sarr->num_versions - 1)];
+  for (q = 0; q < num_procs; ++q) {
+    if (q != myproc) {
+      sc_shmem_array_apply (sarr, back, sarr->received.array + displs[q],
+                            (size_t) counts[q], NULL);
+    }
+  }
+  SC_FREE (counts);
+  sc_shmem_array_sync (sarr);
+
+  if (sarr->num_versions == 2) {
+    /* swap and copy the slices of this commit into the new back version */
+    sarr->current ^= 1;
+    sc_shmem_array_apply (sarr, sarr->versions[sarr->current ^ 1],
+                          sarr->received.array, sarr->received.elem_count,
+                          sarr->versions[sarr->current]);
+    sc_shmem_array_sync (sarr);
+  }
+  sc_array_truncate (&sarr->pending);
+  sc_array_truncate (&sarr->received);
+  sc_mpi_profile_leave ();
+}
+
+sc_shmem_array_t   *
+sc_shmem_array_allgatherv (sc_array_t * send, sc_array_t * offsets,
+                           sc_MPI_Comm comm)
+{
+  int                 mpiret;
+  int                 size, rank, q;
+  size_t              first, total;
+  long long           mycount, *counts;
+  sc_shmem_array_t   *sarr;
+
+  SC_ASSERT (send != NULL);
+  SC_ASSERT (offsets == NULL || offsets->elem_size == sizeof (size_t));
+
+  mpiret = sc_MPI_Comm_size (comm, &size);
+  SC_CHECK_MPI (mpiret);
+  mpiret = sc_MPI_Comm_rank (comm, &rank);
+  SC_CHECK_MPI (mpiret);
+
+  /* the counts determine every process' slice of the shared array */
+  counts = SC_ALLOC (long long, size);
+  mycount = (long long) send->elem_count;
+  sc_shmem_node_allgather (&mycount, 1, sc_MPI_LONG_LONG_INT,
+                           counts, 1, sc_MPI_LONG_LONG_INT, comm);
+  if (offsets != NULL) {
+    sc_array_resize (offsets, (size_t) size + 1);
+  }
+  first = total = 0;
+  for (q = 0; q < size; ++q) {
+    if (offsets != NULL) {
+      *(size_t *) sc_array_index_int (offsets, q) = total;
+    }
+    if (q == rank) {
+      first = total;
+    }
+    total += (size_t) counts[q];
+  }
+  if (offsets != NULL) {
+    *(size_t *) sc_array_index_int (offsets, size) = total;
+  }
+  SC_FREE (counts);
+
+  sarr = sc_shmem_array_new (comm, send->elem_size, total, 0);
+  if (send->elem_count > 0) {
+    sc_shmem_array_write (sarr, first, send->elem_count, send->array);
+  }
+  sc_shmem_array_commit (sarr);
+  return sarr;
 }
@@ -24,7 +24,7 @@
 #ifndef SC_SHMEM_H
 #define SC_SHMEM_H
 
-#include <sc.h>
+#include <sc_containers.h>
 
 SC_EXTERN_C_BEGIN;
 
@@ -56,6 +56,19 @@ extern const char  *sc_shmem_type_to_string[SC_SHMEM_NUM_TYPES];
 
 extern sc_shmem_type_t sc_shmem_default_type;
 
+#ifndef SC_SHMEM_PREFIX_NODE_ITEMS
+/** The default of \ref sc_shmem_prefix_node_items. */
+#define SC_SHMEM_PREFIX_NODE_ITEMS (1 << 14)
+#endif
+
+/** With \ref SC_SHMEM_WINDOW, a \ref sc_shmem_prefix of at least this many
+ * items in total is scanned by all processes of the node, each taking a
+ * block of the rows.  The summation order of floating point data thus
+ * depends on the node size.  It must be the same on all processes.
+ * Initialized to \ref SC_SHMEM_PREFIX_NODE_ITEMS.
+ */
+extern size_t       sc_shmem_prefix_node_items;
+
 /* ALL sc_shmem routines should be considered collective: called on
  * every process in the communicator */
 
@@ -75,6 +88,22 @@ void                sc_shmem_set_type (sc_MPI_Comm comm,
  */
 sc_shmem_type_t     sc_shmem_get_type (sc_MPI_Comm comm);
 
+/** Time every type on this communicator and set the fastest one.
+ *
+ * For each type we time \ref sc_shmem_allgather and \ref sc_shmem_prefix
+ * with \a count long integers per process, repeated \a repetitions times.
+ * The slowest process counts.  The timings are logged at
+ * \ref SC_LP_STATISTICS.  Node communicators should be attached before.
+ *
+ * \param[in,out] comm        the mpi communicator
+ * \param[in]     count       the number of items per process
+ * \param[in]     repetitions the number of repetitions per type
+ *
+ * \return the type set on the communicator, the same on all processes.
+ */
+sc_shmem_type_t     sc_shmem_set_type_probe (sc_MPI_Comm comm, int count,
+                                             int repetitions);
+
 /** Allocate a shmem array: an array that is redundant on every process.
  *
  * \param[in] package         package requesting memory
@@ -163,6 +192,138 @@ void                sc_shmem_allgather (void *sendbuf, int sendcount,
 void                sc_shmem_prefix (void *sendbuf, void *recvbuf,
                                      int count, sc_MPI_Datatype type,
                                      sc_MPI_Op op, sc_MPI_Comm comm);
+
+/** Allgather into a private array using shared memory on each node.
+ *
+ * If node communicators are attached to \a comm and MPI shared windows
+ * are available, every process writes its data into a window on its node,
+ * only the node roots communicate, and each process copies the result out
+ * of the window.  Otherwise this is a plain allgather.
+ * The arguments are those of MPI_Allgather.
+ *
+ * \param[in] sendbuf         the source from this process
+ * \param[in] sendcount       the number of items to allgather
+ * \param[in] sendtype        the type of items to allgather
+ * \param[out] recvbuf        the private destination array
+ * \param[in] recvcount       the number of items to allgather
+ * \param[in] recvtype        the type of items to allgather
+ * \param[in] comm            the mpi communicator
+ */
+void                sc_shmem_node_allgather (void *sendbuf, int sendcount,
+                                             sc_MPI_Datatype sendtype,
+                                             void *recvbuf, int recvcount,
+                                             sc_MPI_Datatype recvtype,
+                                             sc_MPI_Comm comm);
+
+/** Allreduce into a private array using shared memory on each node.
+ *
+ * If node communicators are attached to \a comm and MPI shared windows
+ * are available, the processes of a node write their data into a window
+ * and reduce it in parallel, each one a share of the items.  Only the node
+ * roots communicate and each process copies the result out of the window.
+ * Otherwise this is a plain allreduce.
+ *
+ * \param[in] sendbuf         the source from this process
+ * \param[out] recvbuf        the private destination array
+ * \param[in] count           the number of items to reduce
+ * \param[in] type            the type of items to reduce
+ * \param[in] op              the operation to reduce by (e.g., sc_MPI_SUM)
+ * \param[in] comm            the mpi communicator
+ */
+void                sc_shmem_node_allreduce (void *sendbuf, void *recvbuf,
+                                             int count, sc_MPI_Datatype type,
+                                             sc_MPI_Op op, sc_MPI_Comm comm);
+
+/** A persistent array that is redundant on every process and updated in
+ * slices.
+ *
+ * If node communicators are attached to the communicator and MPI shared
+ * windows are available, the processes of a node share one copy of the
+ * array that lives as long as the handle.  Otherwise every process holds
+ * a private copy.  A process writes slices of the array with
+ * \ref sc_shmem_array_write and all processes then call
+ * \ref sc_shmem_array_commit, which sends only the written slices and
+ * synchronizes each node by a barrier.
+ *
+ * A double buffered array keeps a second version that receives the writes.
+ * The version returned by \ref sc_shmem_array_read does not change before
+ * the commit, such that readers never wait for writers.  The commit swaps
+ * the versions and brings the new back version up to date by copying the
+ * written slices only.
+ */
+typedef struct sc_shmem_array sc_shmem_array_t;
+
+/** Create a persistent shared array initialized to zero.  Collective.
+ *
+ * \param[in] comm            the mpi communicator
+ * \param[in] elem_size       the size of each element in the array
+ * \param[in] elem_count      the number of elements in the array
+ * \param[in] double_buffered if true, writes go to a second version
+ *
+ * \return the array handle
+ */
+sc_shmem_array_t   *sc_shmem_array_new (sc_MPI_Comm comm, size_t elem_size,
+                                        size_t elem_count,
+                                        int double_buffered);
+
+/** Destroy a persistent shared array.  Collective.
+ *
+ * \param[in] sarr            the array handle
+ */
+void                sc_shmem_array_destroy (sc_shmem_array_t * sarr);
+
+/** Return the current version of the array for reading.  Not collective.
+ *
+ * The pointer becomes invalid by \ref sc_shmem_array_commit.
+ *
+ * \param[in] sarr            the array handle
+ *
+ * \return the elements of the array as of the last commit
+ */
+const void         *sc_shmem_array_read (sc_shmem_array_t * sarr);
+
+/** Write a slice of the array.  Not collective.
+ *
+ * The slices written by the processes between two commits must not overlap.
+ * Without double buffering, the processes on the node see the slice right
+ * away, such that all reading must be done before the first write and may
+ * resume after the commit.
+ *
+ * \param[in] sarr            the array handle
+ * \param[in] first           the index of the first element to write
+ * \param[in] count           the number of elements to write
+ * \param[in] data            \a count elements of the array's size
+ */
+void                sc_shmem_array_write (sc_shmem_array_t * sarr,
+                                          size_t first, size_t count,
+                                          const void *data);
+
+/** Make the slices written since the last commit visible.  Collective.
+ *
+ * \param[in] sarr            the array handle
+ */
+void                sc_shmem_array_commit (sc_shmem_array_t * sarr);
+
+/** Gather the contents of an array from every process into a shared array.
+ * This is the node-aware version of \ref sc_array_allgatherv.  The element
+ * counts are exchanged by \ref sc_shmem_node_allgather and each process
+ * writes its elements as a slice of a new persistent shared array, such
+ * that the data exists once per node if shared windows are available.
+ * Collective.
+ *
+ * \param[in] send            this process' elements, may be a view
+ * \param[in,out] offsets     if not NULL, an array of element size
+ *                            sizeof (size_t) resized to one more entry
+ *                            than there are processes; entry q is the
+ *                            index of the first element of process q
+ * \param[in] comm            the mpi communicator
+ *
+ * \return a committed array handle of the element size of \a send, to be
+ * read by \ref sc_shmem_array_read and destroyed by the caller
+ */
+sc_shmem_array_t   *sc_shmem_array_allgatherv (sc_array_t * send,
+                                               sc_array_t * offsets,
+                                               sc_MPI_Comm comm);
 SC_EXTERN_C_END;
 
 #endif /* SC_SHMEM_H */
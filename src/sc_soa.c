@@ -0,0 +1,247 @@
+/*
+  This file is part of the SC Library.
+  The SC Library provides support for parallel scientific applications.
+
+  Copyright (C) 2010 The University of Texas System
+  Additional copyright (C) 2011 individual authors
+
+  The SC Library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  The SC Library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with the SC Library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+  02110-1301, USA.
+*/
+
+#include <sc_soa.h>
+#include <sc_sort.h>
+
+#ifdef SC_HAVE_POSIX_MEMALIGN
+
+/* column memory is aligned and not registered with the memory counters */
+static void        *
+sc_soa_aligned_alloc (size_t size, void *user)
+{
+  int                 err;
+  void               *ptr;
+
+  err = posix_memalign (&ptr, SC_SOA_ALIGN, size);
+  SC_CHECK_ABORTF (err == 0, "Aligned column allocation (size %llu)",
+                   (unsigned long long) size);
+  return ptr;
+}
+
+static void
+sc_soa_aligned_free (void *ptr, size_t size, void *user)
+{
+  free (ptr);
+}
+
+static void        *
+sc_soa_aligned_realloc (void *ptr, size_t old_size, size_t new_size,
+                        void *user)
+{
+  void               *ret;
+
+  ret = sc_soa_aligned_alloc (new_size, user);
+  if (ptr != NULL) {
+    memcpy (ret, ptr, SC_MIN (old_size, new_size));
+    free (ptr);
+  }
+  return ret;
+}
+
+#endif /* SC_HAVE_POSIX_MEMALIGN */
+
+sc_soa_t           *
+sc_soa_new (size_t num_columns, const size_t *elem_sizes)
+{
+  size_t              c;
+  sc_soa_t           *soa;
+
+  SC_ASSERT (num_columns > 0);
+
+  soa = SC_ALLOC (sc_soa_t, 1);
+  soa->elem_count = 0;
+  soa->num_columns = num_columns;
+#ifdef SC_HAVE_POSIX_MEMALIGN
+  soa->allocator.alloc = sc_soa_aligned_alloc;
+  soa->allocator.realloc = sc_soa_aligned_realloc;
+  soa->allocator.free = sc_soa_aligned_free;
+  soa->allocator.user = NULL;
+#else
+  soa->allocator = sc_array_allocator_default;
+#endif
+
+  soa->columns = SC_ALLOC (sc_array_t, num_columns);
+  for (c = 0; c < num_columns; ++c) {
+    SC_ASSERT (elem_sizes[c] > 0);
+    sc_array_init_allocator (soa->columns + c, elem_sizes[c],
+                             &soa->allocator);
+  }
+
+  return soa;
+}
+
+void
+sc_soa_destroy (sc_soa_t * soa)
+{
+  size_t              c;
+
+  for (c = 0; c < soa->num_columns; ++c) {
+    sc_array_reset (soa->columns + c);
+  }
+  SC_FREE (soa->columns);
+  SC_FREE (soa);
+}
+
+size_t
+sc_soa_memory_used (sc_soa_t * soa)
+{
+  size_t              c, mem;
+
+  mem = sizeof (sc_soa_t) + soa->num_columns * sizeof (sc_array_t);
+  for (c = 0; c < soa->num_columns; ++c) {
+    mem += sc_array_memory_used (soa->columns + c, 0);
+  }
+
+  return mem;
+}
+
+void
+sc_soa_resize (sc_soa_t * soa, size_t new_count)
+{
+  size_t              c;
+
+  for (c = 0; c < soa->num_columns; ++c) {
+    sc_array_resize (soa->columns + c, new_count);
+  }
+  soa->elem_count = new_count;
+}
+
+void
+sc_soa_permute (sc_soa_t * soa, sc_array_t * newindices, int keepperm)
+{
+  size_t              c;
+
+  SC_ASSERT (newindices->elem_count == soa->elem_count);
+
+  /* only the last column may consume the permutation */
+  for (c = 0; c + 1 < soa->num_columns; ++c) {
+    sc_array_permute (soa->columns + c, newindices, 1);
+  }
+  sc_array_permute (soa->columns + c, newindices, keepperm);
+}
+
+typedef struct sc_soa_sort_data
+{
+  sc_array_t         *keys;
+  int                 (*compar) (const void *, const void *);
+}
+sc_soa_sort_data_t;
+
+/* compare two element indices by their keys and break ties by index */
+static int
+sc_soa_sort_compare (const void *a, const void *b, void *arg)
+{
+  int                 result;
+  size_t              ia = *(const size_t *) a;
+  size_t              ib = *(const size_t *) b;
+  sc_soa_sort_data_t *sdata = (sc_soa_sort_data_t *) arg;
+
+  result = sdata->compar (sc_array_index (sdata->keys, ia),
+                          sc_array_index (sdata->keys, ib));
+  if (result != 0) {
+    return result;
+  }
+  return ia < ib ? -1 : ia > ib ? 1 : 0;
+}
+
+void
+sc_soa_sort (sc_soa_t * soa, size_t column,
+             int (*compar) (const void *, const void *))
+{
+  size_t              iz, n = soa->elem_count;
+  size_t             *order, *newind;
+  sc_array_t         *newindices;
+  sc_soa_sort_data_t  sdata;
+
+  if (n <= 1) {
+    return;
+  }
+
+  /* sort the element indices by key */
+  sdata.keys = sc_soa_column (soa, column);
+  sdata.compar = compar;
+  order = SC_ALLOC (size_t, n);
+  for (iz = 0; iz < n; ++iz) {
+    order[iz] = iz;
+  }
+  sc_qsort_r (order, n, sizeof (size_t), sc_soa_sort_compare, &sdata);
+
+  /* the element in position iz of the sorted order moves there */
+  newindices = sc_array_new_count (sizeof (size_t), n);
+  newind = (size_t *) newindices->array;
+  for (iz = 0; iz < n; ++iz) {
+    newind[order[iz]] = iz;
+  }
+  SC_FREE (order);
+
+  sc_soa_permute (soa, newindices, 0);
+  sc_array_destroy (newindices);
+}
+
+void
+sc_soa_split (sc_soa_t * soa, size_t column, sc_array_t * offsets,
+              size_t num_types, sc_array_type_t type_fn, void *data,
+              int permute)
+{
+  size_t              iz, k, type, n = soa->elem_count;
+  size_t             *offs, *newind;
+  sc_array_t         *keys, *newindices;
+
+  keys = sc_soa_column (soa, column);
+  if (!permute) {
+    sc_array_split (keys, offsets, num_types, type_fn, data);
+    return;
+  }
+
+  SC_ASSERT (offsets->elem_size == sizeof (size_t));
+
+  /* count the types, remembering them in the permutation */
+  sc_array_resize (offsets, num_types + 1);
+  offs = (size_t *) offsets->array;
+  memset (offs, 0, (num_types + 1) * sizeof (size_t));
+  newindices = sc_array_new_count (sizeof (size_t), n);
+  newind = (size_t *) newindices->array;
+  for (iz = 0; iz < n; ++iz) {
+    type = type_fn (keys, iz, data);
+    SC_ASSERT (type < num_types);
+    newind[iz] = type;
+    ++offs[type + 1];
+  }
+  for (k = 0; k < num_types; ++k) {
+    offs[k + 1] += offs[k];
+  }
+
+  /* a stable counting sort yields the new index of every element */
+  for (iz = 0; iz < n; ++iz) {
+    type = newind[iz];
+    newind[iz] = offs[type]++;
+  }
+  for (k = num_types; k > 0; --k) {
+    offs[k] = offs[k - 1];
+  }
+  offs[0] = 0;
+
+  sc_soa_permute (soa, newindices, 0);
+  sc_array_destroy (newindices);
+}
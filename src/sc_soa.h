@@ -0,0 +1,172 @@
+/*
+  This file is part of the SC Library.
+  The SC Library provides support for parallel scientific applications.
+
+  Copyright (C) 2010 The University of Texas System
+  Additional copyright (C) 2011 individual authors
+
+  The SC Library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  The SC Library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with the SC Library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+  02110-1301, USA.
+*/
+
+#ifndef SC_SOA_H
+#define SC_SOA_H
+
+/** \file sc_soa.h
+ *
+ * Structure of arrays: several columns of equal length.
+ *
+ * Where \ref sc_array_t stores one record of \a elem_size bytes per
+ * element, the structure of arrays stores each field of the records in
+ * a separate \ref sc_array_t column.  Loops over a few fields of many
+ * elements then access contiguous and aligned memory suitable for SIMD.
+ * All columns share the element count and are resized, permuted and
+ * sorted together.  Column memory is aligned to \ref SC_SOA_ALIGN bytes
+ * where posix_memalign is available.
+ *
+ * \ingroup sc_containers
+ */
+
+#include <sc_containers.h>
+
+/** The alignment of every column in bytes. */
+#define SC_SOA_ALIGN 64
+
+SC_EXTERN_C_BEGIN;
+
+/** The structure of arrays.
+ * Its fields may be read but must only be modified by the functions below.
+ * The columns themselves may be accessed as read-write arrays, but not
+ * resized individually.
+ */
+typedef struct sc_soa
+{
+  /* interface variables */
+  size_t              elem_count;       /**< number of elements per column */
+  size_t              num_columns;      /**< number of columns */
+
+  /* implementation variables */
+  sc_array_t         *columns;  /**< the columns */
+  sc_array_allocator_t allocator;       /**< aligned column memory */
+}
+sc_soa_t;
+
+/** Create a new structure of arrays with zero elements.
+ * \param [in] num_columns      Number of columns, at least one.
+ * \param [in] elem_sizes       Element size in bytes of each column.
+ * \return                      Returns an allocated structure of arrays.
+ */
+sc_soa_t           *sc_soa_new (size_t num_columns, const size_t *elem_sizes);
+
+/** Destroy a structure of arrays and free all its memory.
+ * \param [in,out] soa          This object is invalid after the call.
+ */
+void                sc_soa_destroy (sc_soa_t * soa);
+
+/** Calculate the memory used by a structure of arrays.
+ * \param [in] soa              Valid structure of arrays.
+ * \return                      Memory used in bytes.
+ */
+size_t              sc_soa_memory_used (sc_soa_t * soa);
+
+/** Set the element count of all columns.
+ * \param [in,out] soa          Valid structure of arrays.
+ * \param [in] new_count        New number of elements.  New elements are
+ *                              uninitialized, as in \ref sc_array_resize.
+ */
+void                sc_soa_resize (sc_soa_t * soa, size_t new_count);
+
+/** Permute all columns in place, see \ref sc_array_permute.
+ * \param [in,out] soa          Valid structure of arrays.
+ * \param [in,out] newindices   Permutation array of size_t.  The element
+ *                              at index i moves to index newindices[i].
+ * \param [in] keepperm         As in \ref sc_array_permute.
+ */
+void                sc_soa_permute (sc_soa_t * soa, sc_array_t * newindices,
+                                    int keepperm);
+
+/** Sort all columns by the values of one column.
+ * The sort is stable: elements with equal keys keep their order.
+ * \param [in,out] soa          Valid structure of arrays.
+ * \param [in] column           The column holding the sort keys.
+ * \param [in] compar           Comparison of two keys like strcmp.
+ */
+void                sc_soa_sort (sc_soa_t * soa, size_t column,
+                                 int (*compar) (const void *,
+                                                const void *));
+
+/** Compute the offsets of groups of types, see \ref sc_array_split.
+ * \param [in,out] soa          Valid structure of arrays.
+ *                              If \a permute is false, it must be sorted
+ *                              ascending by type.  Otherwise all columns
+ *                              are permuted stably into ascending type order.
+ * \param [in] column           The column passed to \a type_fn.
+ * \param [in,out] offsets      An initialized array of type size_t that is
+ *                              resized to \a num_types + 1 entries.  The
+ *                              elements of type k have the indices
+ *                              \a offsets[k] <= j < \a offsets[k + 1].
+ * \param [in] num_types        The number of possible types of elements.
+ * \param [in] type_fn          Returns the type of an element, called with
+ *                              the column \a column and the element index.
+ * \param [in] data             Arbitrary user data passed to \a type_fn.
+ * \param [in] permute          If true, sort the elements by type first.
+ */
+void                sc_soa_split (sc_soa_t * soa, size_t column,
+                                  sc_array_t * offsets, size_t num_types,
+                                  sc_array_type_t type_fn, void *data,
+                                  int permute);
+
+/** Return a column of a structure of arrays.
+ * \param [in] soa              Valid structure of arrays.
+ * \param [in] column           Index less than \a soa->num_columns.
+ * \return                      The column, which must not be resized.
+ */
+/*@unused@*/
+static inline sc_array_t *
+sc_soa_column (sc_soa_t * soa, size_t column)
+{
+  SC_ASSERT (column < soa->num_columns);
+
+  return soa->columns + column;
+}
+
+/** Return a pointer to one field of an element.
+ * \param [in] soa              Valid structure of arrays.
+ * \param [in] column           Index less than \a soa->num_columns.
+ * \param [in] iz               Element index less than \a soa->elem_count.
+ * \return                      Pointer to the element in the column.
+ */
+/*@unused@*/
+static inline void *
+sc_soa_index (sc_soa_t * soa, size_t column, size_t iz)
+{
+  return sc_array_index (sc_soa_column (soa, column), iz);
+}
+
+/** Enlarge all columns by one element.
+ * \param [in,out] soa          Valid structure of arrays.
+ * \return                      The index of the new uninitialized element.
+ */
+/*@unused@*/
+static inline size_t
+sc_soa_push (sc_soa_t * soa)
+{
+  sc_soa_resize (soa, soa->elem_count + 1);
+  return soa->elem_count - 1;
+}
+
+SC_EXTERN_C_END;
+
+#endif /* !SC_SOA_H */
@@ -21,8 +21,20 @@
   02110-1301, USA.
 */
 
-#include <sc_containers.h>
+#include <sc_allgather.h>
+#include <sc_notify.h>
 #include <sc_sort.h>
+#include <sc_thread.h>
+
+/** Key types recognized by their comparison function for faster sorting. */
+typedef enum sc_sort_key
+{
+  SC_SORT_KEY_GENERIC,
+  SC_SORT_KEY_INT32,
+  SC_SORT_KEY_INT64,
+  SC_SORT_KEY_DOUBLE
+}
+sc_sort_key_t;
 
 typedef struct sc_psort_peer
 {
@@ -44,59 +56,512 @@ typedef struct sc_psort
   size_t             *gmemb;
   char               *my_base;
   int                 (*compar) (const void *, const void *);
+  sc_sort_key_t       key;
 }
 sc_psort_t;
 
+/** Ranges up to this length are sorted by insertion. */
+#define SC_SORT_INSERTION_MAX 16
+
+static              sc_sort_key_t
+sc_sort_key_type (int (*compar) (const void *, const void *), size_t size)
+{
+  if ((compar == sc_int32_compare ||
+       (compar == sc_int_compare && sizeof (int) == sizeof (int32_t))) &&
+      size == sizeof (int32_t)) {
+    return SC_SORT_KEY_INT32;
+  }
+  if (compar == sc_int64_compare && size == sizeof (int64_t)) {
+    return SC_SORT_KEY_INT64;
+  }
+  if (compar == sc_double_compare && size == sizeof (double)) {
+    return SC_SORT_KEY_DOUBLE;
+  }
+  return SC_SORT_KEY_GENERIC;
+}
+
+/* *INDENT-OFF* */
+
+/** Define a quick sort for a primitive type that compares inline.
+ * The median of three is moved to the front as pivot and guards the scans.
+ * We recurse into the smaller part and loop over the larger one. */
+#define SC_SORT_TYPED(name,type)                                        \
+static void                                                             \
+name (type * a, size_t n)                                               \
+{                                                                       \
+  size_t              i, j, m;                                          \
+  type                v, t;                                             \
+                                                                        \
+  while (n > SC_SORT_INSERTION_MAX) {                                   \
+    m = n / 2;                                                          \
+    if (a[m] < a[0]) { t = a[m]; a[m] = a[0]; a[0] = t; }               \
+    if (a[n - 1] < a[0]) { t = a[n - 1]; a[n - 1] = a[0]; a[0] = t; }   \
+    if (a[n - 1] < a[m]) { t = a[n - 1]; a[n - 1] = a[m]; a[m] = t; }   \
+    v = a[m]; a[m] = a[0]; a[0] = v;                                    \
+    i = 0;                                                              \
+    j = n;                                                              \
+    for (;;) {                                                          \
+      while (a[++i] < v);                                               \
+      while (v < a[--j]);                                               \
+      if (i >= j) break;                                                \
+      t = a[i]; a[i] = a[j]; a[j] = t;                                  \
+    }                                                                   \
+    a[0] = a[j]; a[j] = v;                                              \
+    if (j < n - j - 1) {                                                \
+      name (a, j);                                                      \
+      a += j + 1;                                                       \
+      n -= j + 1;                                                       \
+    }                                                                   \
+    else {                                                              \
+      name (a + j + 1, n - j - 1);                                      \
+      n = j;                                                            \
+    }                                                                   \
+  }                                                                     \
+  for (i = 1; i < n; ++i) {                                             \
+    v = a[i];                                                           \
+    for (j = i; j > 0 && v < a[j - 1]; --j) {                           \
+      a[j] = a[j - 1];                                                  \
+    }                                                                   \
+    a[j] = v;                                                           \
+  }                                                                     \
+}
+
+SC_SORT_TYPED (sc_sort_int32, int32_t)
+SC_SORT_TYPED (sc_sort_int64, int64_t)
+SC_SORT_TYPED (sc_sort_double, double)
+
+/* *INDENT-ON* */
+
+/** Sort with a specialized routine if the key type allows.
+ * \return          True if the items have been sorted, false otherwise.
+ */
+static int
+sc_sort_typed (void *base, size_t nmemb, sc_sort_key_t key)
+{
+  switch (key) {
+  case SC_SORT_KEY_INT32:
+    sc_sort_int32 ((int32_t *) base, nmemb);
+    return 1;
+  case SC_SORT_KEY_INT64:
+    sc_sort_int64 ((int64_t *) base, nmemb);
+    return 1;
+  case SC_SORT_KEY_DOUBLE:
+    sc_sort_double ((double *) base, nmemb);
+    return 1;
+  default:
+    return 0;
+  }
+}
+
+static void
+sc_sort_swap (char *a, char *b, size_t size)
+{
+  char                temp[64];
+  size_t              chunk;
+
+  while (size > 0) {
+    chunk = SC_MIN (size, sizeof (temp));
+    memcpy (temp, a, chunk);
+    memcpy (a, b, chunk);
+    memcpy (b, temp, chunk);
+    a += chunk;
+    b += chunk;
+    size -= chunk;
+  }
+}
+
+#if !defined SC_HAVE_QSORT_R || defined SC_HAVE_BSD_QSORT_R
+
+/** The context for calling a GNU style comparison function. */
+typedef struct sc_sort_context
+{
+  int                 (*compar) (const void *, const void *, void *);
+  void               *arg;
+}
+sc_sort_context_t;
+
+#endif
+
 #ifndef SC_HAVE_QSORT_R
 
-/* qsort is not reentrant, so we do the inverse static */
-static int          (*sc_compare) (const void *, const void *);
+/** Reentrant quick sort used if the system does not provide qsort_r.
+ * It works like the typed version with generic items and comparisons. */
+static void
+sc_sort_generic (char *a, size_t n, size_t size,
+                 const sc_sort_context_t * ctx)
+{
+  size_t              i, j, m;
+
+#define SC_SORT_AT(k) (a + (k) * size)
+#define SC_SORT_LESS(x,y) (ctx->compar ((x), (y), ctx->arg) < 0)
+  while (n > SC_SORT_INSERTION_MAX) {
+    m = n / 2;
+    if (SC_SORT_LESS (SC_SORT_AT (m), SC_SORT_AT (0))) {
+      sc_sort_swap (SC_SORT_AT (m), SC_SORT_AT (0), size);
+    }
+    if (SC_SORT_LESS (SC_SORT_AT (n - 1), SC_SORT_AT (0))) {
+      sc_sort_swap (SC_SORT_AT (n - 1), SC_SORT_AT (0), size);
+    }
+    if (SC_SORT_LESS (SC_SORT_AT (n - 1), SC_SORT_AT (m))) {
+      sc_sort_swap (SC_SORT_AT (n - 1), SC_SORT_AT (m), size);
+    }
+
+    /* the pivot stays in front during the partitioning */
+    sc_sort_swap (SC_SORT_AT (m), SC_SORT_AT (0), size);
+    i = 0;
+    j = n;
+    for (;;) {
+      while (SC_SORT_LESS (SC_SORT_AT (++i), SC_SORT_AT (0)));
+      while (SC_SORT_LESS (SC_SORT_AT (0), SC_SORT_AT (--j)));
+      if (i >= j) {
+        break;
+      }
+      sc_sort_swap (SC_SORT_AT (i), SC_SORT_AT (j), size);
+    }
+    sc_sort_swap (SC_SORT_AT (0), SC_SORT_AT (j), size);
+    if (j < n - j - 1) {
+      sc_sort_generic (a, j, size, ctx);
+      a = SC_SORT_AT (j + 1);
+      n -= j + 1;
+    }
+    else {
+      sc_sort_generic (SC_SORT_AT (j + 1), n - j - 1, size, ctx);
+      n = j;
+    }
+  }
+  for (i = 1; i < n; ++i) {
+    for (j = i; j > 0 && SC_SORT_LESS (SC_SORT_AT (j), SC_SORT_AT (j - 1));
+         --j) {
+      sc_sort_swap (SC_SORT_AT (j), SC_SORT_AT (j - 1), size);
+    }
+  }
+#undef SC_SORT_LESS
+#undef SC_SORT_AT
+}
+
+#elif defined SC_HAVE_BSD_QSORT_R
+
+/* translate to the argument order of the BSD qsort_r */
 static int
-sc_icompare (const void *v1, const void *v2)
+sc_sort_compare_bsd (void *arg, const void *v1, const void *v2)
 {
-  return sc_compare (v2, v1);
+  const sc_sort_context_t *ctx = (const sc_sort_context_t *) arg;
+  return ctx->compar (v1, v2, ctx->arg);
 }
 
+#endif
+
+void
+sc_qsort_r (void *base, size_t nmemb, size_t size,
+            int (*compar) (const void *, const void *, void *), void *arg)
+{
+#if !defined SC_HAVE_QSORT_R || defined SC_HAVE_BSD_QSORT_R
+  sc_sort_context_t   ctx;
+
+  ctx.compar = compar;
+  ctx.arg = arg;
+#endif
+
+  if (nmemb <= 1) {
+    return;
+  }
+#ifndef SC_HAVE_QSORT_R
+  sc_sort_generic ((char *) base, nmemb, size, &ctx);
+#elif defined SC_HAVE_BSD_QSORT_R
+  qsort_r (base, nmemb, size, &ctx, sc_sort_compare_bsd);
 #else
+  qsort_r (base, nmemb, size, compar, arg);
+#endif
+}
 
-#ifndef SC_HAVE_BSD_QSORT_R
+/** Sort process-local items, with a specialized routine if possible. */
+static void
+sc_sort_local (void *base, size_t nmemb, size_t size,
+               int (*compar) (const void *, const void *))
+{
+  if (!sc_sort_typed (base, nmemb, sc_sort_key_type (compar, size))) {
+    qsort (base, nmemb, size, compar);
+  }
+}
 
-/* qsort_r comparator functions conforming to GNU standard */
+/** Return the first position in a sorted range whose item is not less than
+ * the given key. */
+static              size_t
+sc_sort_lower_bound (const char *base, size_t n, size_t size,
+                     const void *key,
+                     int (*compar) (const void *, const void *))
+{
+  size_t              lo, hi, mid;
+
+  lo = 0;
+  hi = n;
+  while (lo < hi) {
+    mid = lo + (hi - lo) / 2;
+    if (compar (base + mid * size, key) < 0) {
+      lo = mid + 1;
+    }
+    else {
+      hi = mid;
+    }
+  }
+  return lo;
+}
 
-static int
-sc_compare_r (const void *v1, const void *v2, void *arg)
+/** Merge two sorted runs into a separate destination. */
+static void
+sc_sort_merge_two (char *dest, const char *a, size_t na,
+                   const char *b, size_t nb, size_t size,
+                   int (*compar) (const void *, const void *))
 {
-  sc_psort_t         *pst = (sc_psort_t *) arg;
-  return pst->compar (v1, v2);
+  while (na > 0 && nb > 0) {
+    if (compar (b, a) < 0) {
+      memcpy (dest, b, size);
+      b += size;
+      --nb;
+    }
+    else {
+      memcpy (dest, a, size);
+      a += size;
+      --na;
+    }
+    dest += size;
+  }
+  memcpy (dest, a, na * size);
+  memcpy (dest + na * size, b, nb * size);
 }
 
-static int
-sc_icompare_r (const void *v1, const void *v2, void *arg)
+/** Merge consecutive sorted runs in place by pairwise merging.
+ * \param [in,out] data     The runs are merged into one sorted sequence.
+ * \param [in,out] buffer   Scratch space of the same size as \a data.
+ * \param [in,out] offs     Offsets of the runs, num_runs + 1 entries.
+ *                          They are overwritten by this function.
+ */
+static void
+sc_sort_merge_runs (char *data, char *buffer, size_t size,
+                    size_t *offs, size_t num_runs,
+                    int (*compar) (const void *, const void *))
 {
-  sc_psort_t         *pst = (sc_psort_t *) arg;
-  return pst->compar (v2, v1);
+  const size_t        n = offs[num_runs] - offs[0];
+  size_t              nr, r;
+  size_t              lo, mid, hi;
+  char               *src, *dest, *temp;
+
+  SC_ASSERT (offs[0] == 0);
+
+  /* merge pairs of adjacent runs until only one is left */
+  src = data;
+  dest = buffer;
+  while (num_runs > 1) {
+    for (nr = 0, r = 0; r < num_runs; r += 2, ++nr) {
+      lo = offs[r];
+      mid = offs[r + 1];
+      hi = r + 1 < num_runs ? offs[r + 2] : mid;
+      sc_sort_merge_two (dest + lo * size, src + lo * size, mid - lo,
+                         src + mid * size, hi - mid, size, compar);
+      offs[nr] = lo;
+    }
+    offs[nr] = n;
+    num_runs = nr;
+    temp = src;
+    src = dest;
+    dest = temp;
+  }
+  if (src != data) {
+    memcpy (data, src, n * size);
+  }
 }
 
-#else /* SC_HAVE_BSD_QSORT_R */
+/** State shared by the threads of a parallel local sort.
+ * The input is cut into one chunk per thread that is sorted first.
+ * Splitters cut each sorted chunk into one piece per thread, and we
+ * merge the pieces of equal number into their place in the output. */
+typedef struct sc_sort_parallel
+{
+  char               *base;
+  char               *output;
+  size_t              count, size;
+  int                 (*compar) (const void *, const void *);
+  int                 num_chunks;
+  size_t             *bounds;   /**< Piece offsets for each chunk. */
+  size_t             *offsets;  /**< Offsets of merged pieces in output. */
+}
+sc_sort_parallel_t;
 
-/* qsort_r comparator functions conforming to BSD standard */
+static void
+sc_sort_parallel_chunks (int thread_id, int num_threads, void *user)
+{
+  sc_sort_parallel_t *spt = (sc_sort_parallel_t *) user;
+  const size_t        n = spt->count;
+  const size_t        T = (size_t) spt->num_chunks;
+  size_t              c, lo, hi;
+
+  for (c = (size_t) thread_id; c < T; c += (size_t) num_threads) {
+    lo = c * n / T;
+    hi = (c + 1) * n / T;
+    sc_sort_local (spt->base + lo * spt->size, hi - lo, spt->size,
+                   spt->compar);
+  }
+}
 
-static int
-sc_compare_r (void *arg, const void *v1, const void *v2)
+static void
+sc_sort_parallel_merge (int thread_id, int num_threads, void *user)
 {
-  sc_psort_t         *pst = (sc_psort_t *) arg;
-  return pst->compar (v1, v2);
+  sc_sort_parallel_t *spt = (sc_sort_parallel_t *) user;
+  const size_t        size = spt->size;
+  const size_t        T = (size_t) spt->num_chunks;
+  size_t              p, c, lo, hi, pos;
+  size_t             *offs;
+  char               *dest, *buffer;
+
+  offs = SC_ALLOC (size_t, T + 1);
+  for (p = (size_t) thread_id; p < T; p += (size_t) num_threads) {
+    /* gather piece p of every chunk */
+    dest = spt->output + spt->offsets[p] * size;
+    for (pos = 0, c = 0; c < T; ++c) {
+      lo = spt->bounds[c * (T + 1) + p];
+      hi = spt->bounds[c * (T + 1) + p + 1];
+      offs[c] = pos;
+      memcpy (dest + pos * size, spt->base + lo * size, (hi - lo) * size);
+      pos += hi - lo;
+    }
+    offs[T] = pos;
+    SC_ASSERT (pos == spt->offsets[p + 1] - spt->offsets[p]);
+
+    buffer = SC_ALLOC (char, pos * size);
+    sc_sort_merge_runs (dest, buffer, size, offs, T, spt->compar);
+    SC_FREE (buffer);
+  }
+  SC_FREE (offs);
 }
 
-static int
-sc_icompare_r (void *arg, const void *v1, const void *v2)
+static void
+sc_sort_parallel_copy (int thread_id, int num_threads, void *user)
 {
-  sc_psort_t         *pst = (sc_psort_t *) arg;
-  return pst->compar (v2, v1);
+  sc_sort_parallel_t *spt = (sc_sort_parallel_t *) user;
+  const size_t        n = spt->count;
+  const size_t        lo = (size_t) thread_id * n / (size_t) num_threads;
+  const size_t        hi = (size_t) (thread_id + 1) * n /
+    (size_t) num_threads;
+
+  memcpy (spt->base + lo * spt->size, spt->output + lo * spt->size,
+          (hi - lo) * spt->size);
 }
 
-#endif /* SC_HAVE_BSD_QSORT_R */
-#endif /* SC_HAVE_QSORT_R */
+/** Sort process-local items with multiple threads.
+ * \param [in] num_threads  If not positive, use the default thread count.
+ */
+static void
+sc_sort_parallel (void *base, size_t nmemb, size_t size,
+                  int (*compar) (const void *, const void *),
+                  int num_threads)
+{
+  const size_t        S = SC_SORT_PARALLEL_SAMPLES;
+  size_t              T, c, j, zz, ns, lo, hi;
+  char               *samples, *chunk;
+  sc_sort_parallel_t  spt;
+
+  if (num_threads <= 0) {
+    num_threads = sc_thread_default_count ();
+  }
+  T = SC_MIN ((size_t) num_threads, nmemb / SC_SORT_PARALLEL_MIN);
+  if (T <= 1) {
+    sc_sort_local (base, nmemb, size, compar);
+    return;
+  }
+
+  spt.base = (char *) base;
+  spt.count = nmemb;
+  spt.size = size;
+  spt.compar = compar;
+  spt.num_chunks = (int) T;
+  sc_thread_fork_join ((int) T, sc_sort_parallel_chunks, &spt);
+
+  /* select splitters from regular samples of the sorted chunks */
+  ns = T * S;
+  samples = SC_ALLOC (char, ns * size);
+  for (c = 0; c < T; ++c) {
+    lo = c * nmemb / T;
+    hi = (c + 1) * nmemb / T;
+    for (j = 0; j < S; ++j) {
+      memcpy (samples + (c * S + j) * size,
+              spt.base + (lo + j * (hi - lo) / S) * size, size);
+    }
+  }
+  sc_sort_local (samples, ns, size, compar);
+  spt.bounds = SC_ALLOC (size_t, T * (T + 1));
+  spt.offsets = SC_ALLOC_ZERO (size_t, T + 1);
+  for (c = 0; c < T; ++c) {
+    lo = c * nmemb / T;
+    hi = (c + 1) * nmemb / T;
+    chunk = spt.base + lo * size;
+    spt.bounds[c * (T + 1)] = lo;
+    for (j = 1; j < T; ++j) {
+      zz = sc_sort_lower_bound (chunk, hi - lo, size,
+                                samples + (j * ns / T) * size, compar);
+      spt.bounds[c * (T + 1) + j] = lo + zz;
+    }
+    spt.bounds[c * (T + 1) + T] = hi;
+    for (j = 0; j < T; ++j) {
+      spt.offsets[j + 1] +=
+        spt.bounds[c * (T + 1) + j + 1] - spt.bounds[c * (T + 1) + j];
+    }
+  }
+  for (j = 0; j < T; ++j) {
+    spt.offsets[j + 1] += spt.offsets[j];
+  }
+  SC_ASSERT (spt.offsets[T] == nmemb);
+  SC_FREE (samples);
+
+  /* merge the pieces and copy the result back */
+  spt.output = SC_ALLOC (char, nmemb * size);
+  sc_thread_fork_join ((int) T, sc_sort_parallel_merge, &spt);
+  sc_thread_fork_join ((int) T, sc_sort_parallel_copy, &spt);
+
+  SC_FREE (spt.output);
+  SC_FREE (spt.offsets);
+  SC_FREE (spt.bounds);
+}
+
+void
+sc_array_sort_parallel (sc_array_t * array,
+                        int (*compar) (const void *, const void *),
+                        int num_threads)
+{
+  sc_sort_parallel (array->array, array->elem_count, array->elem_size,
+                    compar, num_threads);
+}
+
+/** Compare two items in the order requested by the bitonic recursion,
+ * with inline comparisons for the recognized key types. */
+static inline int
+sc_psort_greater (const sc_psort_t * pst, const void *v1, const void *v2)
+{
+  switch (pst->key) {
+  case SC_SORT_KEY_INT32:
+    return *(const int32_t *) v1 > *(const int32_t *) v2;
+  case SC_SORT_KEY_INT64:
+    return *(const int64_t *) v1 > *(const int64_t *) v2;
+  case SC_SORT_KEY_DOUBLE:
+    return *(const double *) v1 > *(const double *) v2;
+  default:
+    return pst->compar (v1, v2) > 0;
+  }
+}
+
+/** Sort a local range in increasing (dir true) or decreasing order. */
+static void
+sc_psort_local (sc_psort_t * pst, char *base, size_t n, int dir)
+{
+  size_t              zz;
+
+  sc_sort_parallel (base, n, pst->size, pst->compar, 0);
+  if (!dir) {
+    for (zz = 0; zz < n / 2; ++zz) {
+      sc_sort_swap (base + zz * pst->size,
+                    base + (n - 1 - zz) * pst->size, pst->size);
+    }
+  }
+}
 
 static              size_t
 sc_bsearch_cumulative (const size_t * cumulative, size_t nmemb,
@@ -274,7 +739,7 @@ sc_merge_bitonic (sc_psort_t * pst, size_t lo, size_t hi, int dir)
         lo_data = pst->my_base + (lo + offset - pst->my_lo) * size;
         hi_data = pst->my_base + (hi_beg + offset - pst->my_lo) * size;
         for (zz = 0; zz < max_length; ++zz) {
-          if (dir == (pst->compar (lo_data, hi_data) > 0)) {
+          if (dir == sc_psort_greater (pst, lo_data, hi_data)) {
             memcpy (temp, lo_data, size);
             memcpy (lo_data, hi_data, size);
             memcpy (hi_data, temp, size);
@@ -329,7 +794,7 @@ sc_merge_bitonic (sc_psort_t * pst, size_t lo, size_t hi, int dir)
               lo_data = peer->my_start;
               hi_data = peer->buffer;
               for (zz = 0; zz < peer->length; ++zz) {
-                if (dir == (pst->compar (lo_data, hi_data) > 0)) {
+                if (dir == sc_psort_greater (pst, lo_data, hi_data)) {
                   memcpy (lo_data, hi_data, size);
                 }
                 lo_data += size;
@@ -340,7 +805,7 @@ sc_merge_bitonic (sc_psort_t * pst, size_t lo, size_t hi, int dir)
               lo_data = peer->buffer;
               hi_data = peer->my_start;
               for (zz = 0; zz < peer->length; ++zz) {
-                if (dir == (pst->compar (lo_data, hi_data) > 0)) {
+                if (dir == sc_psort_greater (pst, lo_data, hi_data)) {
                   memcpy (hi_data, lo_data, size);
                 }
                 lo_data += size;
@@ -378,7 +843,7 @@ sc_merge_bitonic (sc_psort_t * pst, size_t lo, size_t hi, int dir)
               lo_data = peer->my_start;
               hi_data = peer->buffer;
               for (zz = 0; zz < peer->length; ++zz) {
-                if (dir == (pst->compar (lo_data, hi_data) > 0)) {
+                if (dir == sc_psort_greater (pst, lo_data, hi_data)) {
                   memcpy (lo_data, hi_data, size);
                 }
                 lo_data += size;
@@ -389,7 +854,7 @@ sc_merge_bitonic (sc_psort_t * pst, size_t lo, size_t hi, int dir)
               lo_data = peer->buffer;
               hi_data = peer->my_start;
               for (zz = 0; zz < peer->length; ++zz) {
-                if (dir == (pst->compar (lo_data, hi_data) > 0)) {
+                if (dir == sc_psort_greater (pst, lo_data, hi_data)) {
                   memcpy (hi_data, lo_data, size);
                 }
                 lo_data += size;
@@ -434,19 +899,8 @@ sc_psort_bitonic (sc_psort_t * pst, size_t lo, size_t hi, int dir)
 
   if (n > 1 && pst->my_hi > lo && pst->my_lo < hi) {
     if (lo >= pst->my_lo && hi <= pst->my_hi) {
-#ifndef SC_HAVE_QSORT_R
-      qsort (pst->my_base + (lo - pst->my_lo) * pst->size,
-             n, pst->size, dir ? sc_compare : sc_icompare);
-#else
-#ifndef SC_HAVE_BSD_QSORT_R
-      qsort_r (pst->my_base + (lo - pst->my_lo) * pst->size,
-               n, pst->size, dir ? sc_compare_r : sc_icompare_r, pst);
-
-#else
-      qsort_r (pst->my_base + (lo - pst->my_lo) * pst->size,
-               n, pst->size, pst, dir ? sc_compare_r : sc_icompare_r);
-#endif
-#endif
+      sc_psort_local (pst, pst->my_base + (lo - pst->my_lo) * pst->size,
+                      n, dir);
     }
     else {
       const size_t        n2 = n / 2;
@@ -469,10 +923,6 @@ sc_psort (sc_MPI_Comm mpicomm, void *base, size_t *nmemb, size_t size,
   size_t             *gmemb;
   sc_psort_t          pst;
 
-#ifndef SC_HAVE_QSORT_R
-  SC_ASSERT (sc_compare == NULL);
-#endif
-
   /* get basic MPI information */
   mpiret = sc_MPI_Comm_size (mpicomm, &num_procs);
   SC_CHECK_MPI (mpiret);
@@ -498,16 +948,388 @@ sc_psort (sc_MPI_Comm mpicomm, void *base, size_t *nmemb, size_t size,
   pst.gmemb = gmemb;
   pst.my_base = (char *) base;
   pst.compar = compar;
-#ifndef SC_HAVE_QSORT_R
-  sc_compare = compar;
-#endif
+  pst.key = sc_sort_key_type (compar, size);
   total = gmemb[num_procs];
   SC_GLOBAL_LDEBUGF ("Total values to sort %lld\n", (long long) total);
+  sc_mpi_profile_enter (SC_MPI_CALLER_PSORT);
   sc_psort_bitonic (&pst, 0, total, 1);
+  sc_mpi_profile_leave ();
 
   /* clean up and free memory */
-#ifndef SC_HAVE_QSORT_R
-  sc_compare = NULL;
-#endif
   SC_FREE (gmemb);
 }
+
+/** Merge consecutive sorted runs of an array in place.
+ * \param [in,out] data     The runs are merged into one sorted sequence.
+ * \param [in] offsets      Array of int with the number of runs plus one
+ *                          entries, the offsets of the runs in \a data.
+ */
+static void
+sc_psort_merge_runs (sc_array_t * data, sc_array_t * offsets,
+                     int (*compar) (const void *, const void *))
+{
+  size_t              num_runs, r;
+  size_t             *offs;
+  char               *buffer;
+
+  SC_ASSERT (offsets->elem_size == sizeof (int));
+  SC_ASSERT (offsets->elem_count >= 1);
+  num_runs = offsets->elem_count - 1;
+  if (num_runs <= 1) {
+    return;
+  }
+
+  offs = SC_ALLOC (size_t, num_runs + 1);
+  for (r = 0; r <= num_runs; ++r) {
+    offs[r] = (size_t) *(int *) sc_array_index (offsets, r);
+  }
+  SC_ASSERT (offs[num_runs] == data->elem_count);
+  buffer = SC_ALLOC (char, data->elem_count * data->elem_size);
+  sc_sort_merge_runs (data->array, buffer, data->elem_size, offs, num_runs,
+                      compar);
+  SC_FREE (buffer);
+  SC_FREE (offs);
+}
+
+/** Send the ranges of sorted local data to their destination processes.
+ * \param [in] notify       Notify controller used for the exchange.
+ * \param [in] data         Array of local items, may be a view.
+ * \param [in] bounds       Array of num_procs + 1 offsets into \a data.
+ *                          The items for process q start at bounds[q].
+ * \param [out] recv        Array of the same element size as \a data,
+ *                          the received items ordered by source rank.
+ * \param [out] offsets     Array of int with the offsets into \a recv
+ *                          of the data received from each source.
+ */
+static void
+sc_psort_exchange (sc_notify_t * notify, sc_array_t * data,
+                   const size_t * bounds, int num_procs,
+                   sc_array_t * recv, sc_array_t * offsets)
+{
+  int                 q;
+  sc_array_t          receivers, senders, send_offsets;
+
+  SC_CHECK_ABORT (data->elem_count <= (size_t) INT_MAX,
+                  "Too many items for sc_psort_sample");
+  SC_ASSERT (bounds[0] == 0 && bounds[num_procs] == data->elem_count);
+
+  /* the ranges of the nonempty destinations are contiguous in data */
+  sc_array_init (&receivers, sizeof (int));
+  sc_array_init (&senders, sizeof (int));
+  sc_array_init (&send_offsets, sizeof (int));
+  *(int *) sc_array_push (&send_offsets) = 0;
+  for (q = 0; q < num_procs; ++q) {
+    if (bounds[q + 1] > bounds[q]) {
+      *(int *) sc_array_push (&receivers) = q;
+      *(int *) sc_array_push (&send_offsets) = (int) bounds[q + 1];
+    }
+  }
+
+  sc_notify_payloadv (&receivers, &senders, data, recv,
+                      &send_offsets, offsets, 1, notify);
+
+  sc_array_reset (&receivers);
+  sc_array_reset (&senders);
+  sc_array_reset (&send_offsets);
+}
+
+/** Select splitters from regular samples and compute where to send data.
+ * \param [in] local        Locally sorted items.
+ * \param [in] nmemb        Item counts of all processes.
+ * \param [in] targets      Array of num_procs + 1 desired cumulative item
+ *                          counts, that is offsets of the output partition.
+ * \param [out] bounds      Array of num_procs + 1 offsets into \a local.
+ */
+static void
+sc_psort_splitters (sc_MPI_Comm mpicomm, int num_procs, int rank,
+                    sc_array_t * local, const size_t * nmemb,
+                    const size_t * targets, size_t * bounds,
+                    int (*compar) (const void *, const void *))
+{
+  const size_t        size = local->elem_size;
+  const size_t        n = local->elem_count;
+  const size_t        woff = (size + sizeof (size_t) - 1) /
+    sizeof (size_t) * sizeof (size_t);
+  const size_t        stride = woff + sizeof (size_t);
+  const size_t        bytes = SC_PSORT_SAMPLES * stride;
+  int                 mpiret;
+  int                 q, j;
+  size_t              zz, kr, count, nsamples;
+  size_t              weight;
+  char               *mine, *samples, *sample;
+
+  SC_ASSERT (bytes <= (size_t) INT_MAX);
+
+  /* each sample carries the number of items it represents */
+  mine = SC_ALLOC_ZERO (char, bytes);
+  kr = SC_MIN ((size_t) SC_PSORT_SAMPLES, n);
+  for (zz = 0; zz < kr; ++zz) {
+    weight = (zz + 1) * n / kr - zz * n / kr;
+    memcpy (mine + zz * stride, local->array + zz * n / kr * size, size);
+    memcpy (mine + zz * stride + woff, &weight, sizeof (size_t));
+  }
+  samples = SC_ALLOC (char, (size_t) num_procs * bytes);
+  mpiret = sc_allgather (mine, (int) bytes, sc_MPI_BYTE,
+                         samples, (int) bytes, sc_MPI_BYTE, mpicomm);
+  SC_CHECK_MPI (mpiret);
+  SC_FREE (mine);
+
+  /* compact the valid samples and sort them */
+  nsamples = 0;
+  for (q = 0; q < num_procs; ++q) {
+    kr = SC_MIN ((size_t) SC_PSORT_SAMPLES, nmemb[q]);
+    memmove (samples + nsamples * stride, samples + q * bytes, kr * stride);
+    nsamples += kr;
+  }
+  qsort (samples, nsamples, stride, compar);
+
+  /* splitter j is the first sample preceded by at least targets[j] items */
+  bounds[0] = 0;
+  count = 0;
+  zz = 0;
+  for (j = 1; j < num_procs; ++j) {
+    for (; zz < nsamples && count < targets[j]; ++zz) {
+      memcpy (&weight, samples + zz * stride + woff, sizeof (size_t));
+      count += weight;
+    }
+    if (zz < nsamples) {
+      sample = samples + zz * stride;
+      bounds[j] = sc_sort_lower_bound (local->array, n, size, sample,
+                                       compar);
+      bounds[j] = SC_MAX (bounds[j], bounds[j - 1]);
+    }
+    else {
+      bounds[j] = n;
+    }
+  }
+  bounds[num_procs] = n;
+  SC_FREE (samples);
+}
+
+void
+sc_psort_sample_ext (sc_MPI_Comm mpicomm, sc_array_t * array,
+                     size_t *nmemb,
+                     int (*compar) (const void *, const void *),
+                     sc_psort_partition_t partition)
+{
+  const size_t        size = array->elem_size;
+  int                 mpiret;
+  int                 num_procs, rank;
+  int                 q, isizet, changed;
+  size_t              total, offset, mine;
+  size_t             *gmemb, *bounds, *counts;
+  sc_notify_t        *notify;
+  sc_array_t          recv, offsets, shifted;
+
+  SC_ASSERT (partition == SC_PSORT_PERFECT ||
+             partition == SC_PSORT_BALANCED);
+
+  /* get basic MPI information */
+  mpiret = sc_MPI_Comm_size (mpicomm, &num_procs);
+  SC_CHECK_MPI (mpiret);
+  mpiret = sc_MPI_Comm_rank (mpicomm, &rank);
+  SC_CHECK_MPI (mpiret);
+  SC_ASSERT (array->elem_count == nmemb[rank]);
+
+  /* sort locally */
+  sc_sort_parallel (array->array, array->elem_count, size, compar, 0);
+  if (num_procs == 1) {
+    return;
+  }
+
+  /* compute the input and the desired output partition */
+  gmemb = SC_ALLOC (size_t, num_procs + 1);
+  gmemb[0] = 0;
+  for (q = 0; q < num_procs; ++q) {
+    gmemb[q + 1] = gmemb[q] + nmemb[q];
+  }
+  total = gmemb[num_procs];
+  SC_GLOBAL_LDEBUGF ("Total values to sample sort %lld\n", (long long) total);
+  if (total == 0) {
+    SC_FREE (gmemb);
+    return;
+  }
+  sc_mpi_profile_enter (SC_MPI_CALLER_PSORT);
+  bounds = SC_ALLOC (size_t, num_procs + 1);
+  if (partition == SC_PSORT_BALANCED) {
+    for (q = 0; q <= num_procs; ++q) {
+      gmemb[q] = total / num_procs * q + SC_MIN ((size_t) q,
+                                                 total % num_procs);
+    }
+  }
+
+  /* redistribute by splitters and merge the received sorted runs */
+  notify = sc_notify_new (mpicomm);
+  sc_psort_splitters (mpicomm, num_procs, rank, array, nmemb, gmemb,
+                      bounds, compar);
+  sc_array_init (&recv, size);
+  sc_array_init (&offsets, sizeof (int));
+  sc_psort_exchange (notify, array, bounds, num_procs, &recv, &offsets);
+  sc_psort_merge_runs (&recv, &offsets, compar);
+
+  /* find the partition after the splitter exchange */
+  counts = SC_ALLOC (size_t, num_procs);
+  mine = recv.elem_count;
+  isizet = (int) sizeof (size_t);
+  mpiret = sc_MPI_Allgather (&mine, isizet, sc_MPI_BYTE,
+                             counts, isizet, sc_MPI_BYTE, mpicomm);
+  SC_CHECK_MPI (mpiret);
+
+  if (partition == SC_PSORT_PERFECT) {
+    /* shift the sorted items to restore the input partition */
+    changed = 0;
+    offset = 0;
+    for (q = 0; q < num_procs; ++q) {
+      changed = changed || counts[q] != nmemb[q];
+      offset += q < rank ? counts[q] : 0;
+    }
+    if (changed) {
+      for (q = 0; q <= num_procs; ++q) {
+        bounds[q] = SC_MAX (gmemb[q], offset) - offset;
+        bounds[q] = SC_MIN (bounds[q], mine);
+      }
+      sc_array_init (&shifted, size);
+      sc_psort_exchange (notify, &recv, bounds, num_procs,
+                         &shifted, &offsets);
+      sc_array_reset (&recv);
+      recv = shifted;
+    }
+    SC_ASSERT (recv.elem_count == array->elem_count);
+  }
+  else {
+    memcpy (nmemb, counts, num_procs * sizeof (size_t));
+    sc_array_resize (array, recv.elem_count);
+  }
+  memcpy (array->array, recv.array, recv.elem_count * size);
+
+  /* clean up and free memory */
+  sc_notify_destroy (notify);
+  sc_array_reset (&recv);
+  sc_array_reset (&offsets);
+  SC_FREE (counts);
+  SC_FREE (bounds);
+  SC_FREE (gmemb);
+  sc_mpi_profile_leave ();
+}
+
+void
+sc_psort_sample (sc_MPI_Comm mpicomm, void *base, size_t *nmemb,
+                 size_t size, int (*compar) (const void *, const void *))
+{
+  int                 mpiret;
+  int                 rank;
+  sc_array_t          view;
+
+  mpiret = sc_MPI_Comm_rank (mpicomm, &rank);
+  SC_CHECK_MPI (mpiret);
+
+  sc_array_init_data (&view, base, size, nmemb[rank]);
+  sc_psort_sample_ext (mpicomm, &view, nmemb, compar, SC_PSORT_PERFECT);
+}
+
+void
+sc_partition_weighted (sc_MPI_Comm mpicomm, sc_array_t * array,
+                       sc_array_t * weights, size_t *nmemb,
+                       sc_statinfo_t * imbalance)
+{
+  const size_t        size = array->elem_size;
+  const size_t        woff = (size + sizeof (double) - 1) /
+    sizeof (double) * sizeof (double);
+  const size_t        stride = woff + sizeof (double);
+  int                 mpiret;
+  int                 num_procs, rank;
+  int                 q, dest, isizet;
+  size_t              zz, n, mine;
+  size_t             *bounds;
+  double              local, total, before, w;
+  char               *item;
+  sc_notify_t        *notify;
+  sc_array_t          packed, recv, offsets;
+
+  SC_ASSERT (weights->elem_size == sizeof (double));
+  SC_ASSERT (weights->elem_count == array->elem_count);
+
+  mpiret = sc_MPI_Comm_size (mpicomm, &num_procs);
+  SC_CHECK_MPI (mpiret);
+  mpiret = sc_MPI_Comm_rank (mpicomm, &rank);
+  SC_CHECK_MPI (mpiret);
+  n = array->elem_count;
+
+  /* find the weight before the local items and the total weight */
+  local = 0.;
+  for (zz = 0; zz < n; ++zz) {
+    w = *(double *) sc_array_index (weights, zz);
+    SC_ASSERT (w >= 0.);
+    local += w;
+  }
+  mpiret = sc_MPI_Exscan (&local, &before, 1, sc_MPI_DOUBLE, sc_MPI_SUM,
+                          mpicomm);
+  SC_CHECK_MPI (mpiret);
+  if (rank == 0) {
+    before = 0.;
+  }
+  mpiret = sc_MPI_Allreduce (&local, &total, 1, sc_MPI_DOUBLE, sc_MPI_SUM,
+                             mpicomm);
+  SC_CHECK_MPI (mpiret);
+
+  if (num_procs > 1 && total > 0.) {
+    sc_mpi_profile_enter (SC_MPI_CALLER_PSORT);
+
+    /* the midpoint of an item's weight determines its destination,
+       which does not decrease with the items */
+    bounds = SC_ALLOC (size_t, num_procs + 1);
+    sc_array_init_count (&packed, stride, n);
+    for (q = 0, zz = 0; zz < n; ++zz) {
+      w = *(double *) sc_array_index (weights, zz);
+      dest = (int) ((before + .5 * w) / total * num_procs);
+      dest = SC_MIN (SC_MAX (dest, q == 0 ? 0 : q - 1), num_procs - 1);
+      for (; q <= dest; ++q) {
+        bounds[q] = zz;
+      }
+      before += w;
+      item = (char *) sc_array_index (&packed, zz);
+      memcpy (item, sc_array_index (array, zz), size);
+      memcpy (item + woff, &w, sizeof (double));
+    }
+    for (; q <= num_procs; ++q) {
+      bounds[q] = n;
+    }
+
+    /* move the items and their weights in one sparse exchange */
+    notify = sc_notify_new (mpicomm);
+    sc_array_init (&recv, stride);
+    sc_array_init (&offsets, sizeof (int));
+    sc_psort_exchange (notify, &packed, bounds, num_procs, &recv, &offsets);
+    sc_notify_destroy (notify);
+
+    n = recv.elem_count;
+    sc_array_resize (array, n);
+    sc_array_resize (weights, n);
+    for (zz = 0; zz < n; ++zz) {
+      item = (char *) sc_array_index (&recv, zz);
+      memcpy (sc_array_index (array, zz), item, size);
+      memcpy (sc_array_index (weights, zz), item + woff, sizeof (double));
+    }
+    sc_array_reset (&packed);
+    sc_array_reset (&recv);
+    sc_array_reset (&offsets);
+    SC_FREE (bounds);
+    sc_mpi_profile_leave ();
+  }
+
+  if (nmemb != NULL) {
+    mine = n;
+    isizet = (int) sizeof (size_t);
+    mpiret = sc_MPI_Allgather (&mine, isizet, sc_MPI_BYTE,
+                               nmemb, isizet, sc_MPI_BYTE, mpicomm);
+    SC_CHECK_MPI (mpiret);
+  }
+  if (imbalance != NULL) {
+    local = 0.;
+    for (zz = 0; zz < n; ++zz) {
+      local += *(double *) sc_array_index (weights, zz);
+    }
+    sc_stats_set1 (imbalance, local, "Partition weight");
+    sc_stats_compute (mpicomm, 1, imbalance);
+  }
+}
@@ -23,25 +23,87 @@
 
 /** \file sc_sort.h
  *
- * Provide a parallel sort algorithm.
- * We use a variant of the bitonic sort algorithm.
+ * Provide parallel sort algorithms.
+ * The classic \ref sc_psort uses a variant of the bitonic sort algorithm.
+ * The sample sort \ref sc_psort_sample needs only a constant number of
+ * communication rounds and is preferable on many processes.
  * Within each process we rely on the system quick sort function.
- * The partition of data on input is arbitrary and remains invariant.
+ * The partition of data on input is arbitrary and remains invariant,
+ * unless a balanced output partition is requested explicitly.
  */
 
 #ifndef SC_SORT_H
 #define SC_SORT_H
 
-#include <sc.h>
+#include <sc_containers.h>
+#include <sc_statistics.h>
+
+#ifndef SC_SORT_PARALLEL_MIN
+/** The minimum number of items per thread in \ref sc_array_sort_parallel. */
+#define SC_SORT_PARALLEL_MIN 4096
+#endif
+
+#ifndef SC_SORT_PARALLEL_SAMPLES
+/** The number of samples per thread in \ref sc_array_sort_parallel. */
+#define SC_SORT_PARALLEL_SAMPLES 16
+#endif
+
+#ifndef SC_PSORT_SAMPLES
+/** The number of regular samples per process used by the sample sort. */
+#define SC_PSORT_SAMPLES 32
+#endif
 
 SC_EXTERN_C_BEGIN;
 
+/** The output partition produced by \ref sc_psort_sample_ext. */
+typedef enum sc_psort_partition
+{
+  SC_PSORT_PERFECT,     /**< Keep the item counts of each process. */
+  SC_PSORT_BALANCED     /**< Roughly equal counts, saves one exchange. */
+}
+sc_psort_partition_t;
+
+/** Sort an array with a comparison function that takes a context argument.
+ * This is a portable version of the GNU qsort_r (3) function.
+ * We use the system qsort_r in either its GNU or BSD variant if available,
+ * and a built-in quick sort otherwise.  Thus this function is reentrant.
+ * \param [in,out] base         Array of \b nmemb items to sort.
+ * \param [in] nmemb            Number of items.
+ * \param [in] size             Size in bytes of one item.
+ * \param [in] compar           Comparison function called with the context.
+ * \param [in] arg              Context passed to \b compar.
+ */
+void                sc_qsort_r (void *base, size_t nmemb, size_t size,
+                                int (*compar) (const void *, const void *,
+                                               void *), void *arg);
+
+/** Sort an array with multiple threads of the calling process.
+ * Each thread sorts one chunk of the array.  The sorted chunks are cut by
+ * splitters chosen from regular samples, and each thread merges the
+ * pieces of one bucket from all chunks by multiway merging.
+ * The threads are run by \ref sc_thread_fork_join.
+ * Arrays with less than \ref SC_SORT_PARALLEL_MIN items per thread are
+ * sorted with fewer threads, down to the serial \ref sc_array_sort.
+ * \param [in,out] array        The array to sort in ascending order.
+ * \param [in] compar           The comparison function to be used.
+ * \param [in] num_threads      The number of threads to use.  If not
+ *                              positive, use \ref sc_thread_default_count,
+ *                              which follows the OpenMP configuration.
+ */
+void                sc_array_sort_parallel (sc_array_t * array,
+                                            int (*compar) (const void *,
+                                                           const void *),
+                                            int num_threads);
+
 /** Sort a distributed set of fixed-size data items in parallel.
  * This algorithm uses bitonic sort between processors and qsort locally.
+ * The local sorts use \ref sc_array_sort_parallel with the default number
+ * of threads.
  *
- * This function is thread-safe if src/sc_config.h \#defines SC_HAVE_QSORT_R.
- * Otherwise, it uses a static read-only variable for the comparison function,
- * and calling \ref sc_psort concurrently is likely to fail.
+ * This function is thread-safe and keeps no global state.
+ * If \b compar is one of \ref sc_int32_compare, \ref sc_int64_compare,
+ * \ref sc_double_compare or \ref sc_int_compare on matching item sizes,
+ * it is not called at all and the items are compared inline.
  *
  * The partition of the data can be arbitrary and is not changed.
  *
@@ -60,6 +122,73 @@ void                sc_psort (sc_MPI_Comm mpicomm, void *base,
                               size_t * nmemb, size_t size,
                               int (*compar) (const void *, const void *));
 
+/** Sort a distributed set of fixed-size data items by parallel sample sort.
+ * This function is a drop-in replacement for \ref sc_psort.
+ * Each process sorts locally and contributes \ref SC_PSORT_SAMPLES regular
+ * samples that are gathered by \ref sc_allgather to select splitters.
+ * The items are redistributed by one sparse all-to-all exchange through
+ * \ref sc_notify_payloadv and a second one to restore the partition.
+ * This function is thread-safe.
+ *
+ * \param [in] mpicomm          Communicator to use.
+ * \param [in] base             Pointer to the process-local data items.
+ * \param [in] nmemb            Array of mpisize counts of data items.  For
+ *                              each process, the number of its local items.
+ *                              This array must be identical on all processes.
+ * \param [in] size             Size in bytes of one data item.
+ * \param [in] compar           Comparison function to use; see man (3) qsort.
+ */
+void                sc_psort_sample (sc_MPI_Comm mpicomm, void *base,
+                                     size_t * nmemb, size_t size,
+                                     int (*compar) (const void *,
+                                                    const void *));
+
+/** Sort a distributed set of data items by sample sort into a chosen
+ * output partition.
+ * With \ref SC_PSORT_BALANCED the data is exchanged only once and the
+ * result is distributed as balanced as the samples allow.
+ *
+ * \param [in] mpicomm          Communicator to use.
+ * \param [in,out] array        Array of process-local items to sort.
+ *                              Resized on output if the partition changes,
+ *                              and thus it must not be a view in that case.
+ * \param [in,out] nmemb        Array of mpisize counts of data items,
+ *                              identical on all processes.  Updated on
+ *                              output to the new partition.
+ * \param [in] compar           Comparison function to use; see man (3) qsort.
+ * \param [in] partition        The requested output partition.
+ */
+void                sc_psort_sample_ext (sc_MPI_Comm mpicomm,
+                                         sc_array_t * array, size_t * nmemb,
+                                         int (*compar) (const void *,
+                                                        const void *),
+                                         sc_psort_partition_t partition);
+
+/** Repartition weighted items such that each process gets equal weight.
+ * The global order of the items is kept.  Each item goes to the process
+ * whose share of the total weight contains the midpoint of the item's
+ * weight, which is placed by an exclusive scan of the process weights.
+ * The items and their weights are moved together by one sparse exchange
+ * through \ref sc_notify_payloadv.  Without any weight, nothing is moved.
+ *
+ * \param [in] mpicomm          Communicator to use.
+ * \param [in,out] array        Array of process-local items, resized to
+ *                              the items received.  Must not be a view.
+ * \param [in,out] weights      Array of non-negative doubles, one per item.
+ *                              Resized and moved along with the items.
+ * \param [out] nmemb           If not NULL, array of mpisize entries set
+ *                              to the new item counts of all processes.
+ * \param [out] imbalance       If not NULL, the statistics of the weight
+ *                              per process computed by \ref sc_stats_compute.
+ *                              The ratio of its max and average is the
+ *                              achieved imbalance.
+ */
+void                sc_partition_weighted (sc_MPI_Comm mpicomm,
+                                           sc_array_t * array,
+                                           sc_array_t * weights,
+                                           size_t *nmemb,
+                                           sc_statinfo_t * imbalance);
+
 SC_EXTERN_C_END;
 
 #endif /* SC_SORT_H */
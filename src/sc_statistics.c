@@ -22,6 +22,13 @@
 */
 
 #include <sc_statistics.h>
+#include <sc_private.h>
+
+/* the reduced entries of a variable: count, sums of values and squares,
+   minimum, maximum and their ranks, then the window sums and optionally
+   the histogram */
+#define SC_STATS_WINDOW 7
+#define SC_STATS_STRIDE 10
 
 #ifdef SC_ENABLE_MPI
 
@@ -29,14 +36,30 @@ static void
 sc_stats_mpifunc (void *invec, void *inoutvec, int *len,
                   sc_MPI_Datatype * datatype)
 {
-  int                 i;
+  int                 i, j, stride;
+  int                 mpiret;
   double             *in = (double *) invec;
   double             *inout = (double *) inoutvec;
+  double              window[3];
+
+  /* the data sets may be followed by histograms */
+  mpiret = MPI_Type_size (*datatype, &stride);
+  SC_CHECK_MPI (mpiret);
+  stride /= (int) sizeof (double);
 
   for (i = 0; i < *len; ++i) {
-    /* sum count, values and their squares */
-    inout[0] += in[0];
-    if (in[0]) {                /* ignore statistics when no count */
+    /* the windows may hold values while the counts were reset */
+    for (j = 0; j < 3; ++j) {
+      window[j] = inout[SC_STATS_WINDOW + j] + in[SC_STATS_WINDOW + j];
+    }
+
+    if (!inout[0]) {
+      /* take the statistics when there are none so far */
+      memcpy (inout, in, stride * sizeof (double));
+    }
+    else if (in[0]) {           /* ignore statistics when no count */
+      /* sum count, values and their squares */
+      inout[0] += in[0];
       inout[1] += in[1];
       inout[2] += in[2];
 
@@ -57,11 +80,17 @@ sc_stats_mpifunc (void *invec, void *inoutvec, int *len,
       else if (in[4] == inout[4]) {     /* ignore the comparison warning */
         inout[6] = SC_MIN (in[6], inout[6]);
       }
+
+      /* add the histograms */
+      for (j = SC_STATS_STRIDE; j < stride; ++j) {
+        inout[j] += in[j];
+      }
     }
+    memcpy (inout + SC_STATS_WINDOW, window, sizeof (window));
 
     /* advance to next data set */
-    in += 7;
-    inout += 7;
+    in += stride;
+    inout += stride;
   }
 }
 
@@ -70,6 +99,52 @@ sc_stats_mpifunc (void *invec, void *inoutvec, int *len,
 const int           sc_stats_group_all = -2;
 const int           sc_stats_prio_all = -3;
 
+static int
+sc_stats_has_histogram (const sc_statinfo_t * stats)
+{
+  return stats->hist_lower < stats->hist_upper;
+}
+
+/** Count a value into the histogram of a variable. */
+static void
+sc_stats_histogram_add (sc_statinfo_t * stats, double value)
+{
+  int                 b;
+
+  if (value < stats->hist_lower) {
+    b = 0;
+  }
+  else if (value >= stats->hist_upper) {
+    b = SC_STATS_HISTOGRAM_BUCKETS + 1;
+  }
+  else {
+    b = 1 + (int) (SC_STATS_HISTOGRAM_BUCKETS *
+                   log (value / stats->hist_lower) /
+                   log (stats->hist_upper / stats->hist_lower));
+    b = SC_MIN (b, SC_STATS_HISTOGRAM_BUCKETS);
+  }
+  stats->histogram[b] += 1.;
+}
+
+static void
+sc_stats_histogram_clear (sc_statinfo_t * stats, int disable)
+{
+  if (disable) {
+    stats->hist_lower = stats->hist_upper = 0.;
+  }
+  memset (stats->histogram, 0, sizeof (stats->histogram));
+}
+
+static void
+sc_stats_window_clear (sc_statinfo_t * stats, int disable)
+{
+  if (disable) {
+    stats->window_steps = 0;
+  }
+  stats->window_weight = stats->window_sum = stats->window_squares = 0.;
+  stats->window_average = stats->window_standev = 0.;
+}
+
 void
 sc_stats_set1 (sc_statinfo_t * stats, double value, const char *variable)
 {
@@ -101,6 +176,8 @@ sc_stats_set1_ext (sc_statinfo_t * stats, double value, const char *variable,
   }
   stats->group = stats_group;
   stats->prio = stats_prio;
+  sc_stats_histogram_clear (stats, 1);
+  sc_stats_window_clear (stats, 1);
 }
 
 void
@@ -132,6 +209,8 @@ sc_stats_init_ext (sc_statinfo_t * stats, const char *variable,
   }
   stats->group = stats_group;
   stats->prio = stats_prio;
+  sc_stats_histogram_clear (stats, 1);
+  sc_stats_window_clear (stats, 1);
 }
 
 void
@@ -151,6 +230,71 @@ sc_stats_reset (sc_statinfo_t * stats, int reset_vgp)
     stats->group = sc_stats_group_all;
     stats->prio = sc_stats_prio_all;
   }
+  sc_stats_histogram_clear (stats, reset_vgp);
+  if (reset_vgp) {
+    sc_stats_window_clear (stats, 1);
+  }
+}
+
+void
+sc_stats_set_histogram (sc_statinfo_t * stats, double lower, double upper)
+{
+  SC_ASSERT (stats->dirty);
+  SC_CHECK_ABORT (0. < lower && lower < upper, "Invalid histogram bounds");
+  SC_CHECK_ABORT (stats->count <= 1, "Histogram set after accumulation");
+
+  stats->hist_lower = lower;
+  stats->hist_upper = upper;
+  sc_stats_histogram_clear (stats, 0);
+  if (stats->count == 1) {
+    sc_stats_histogram_add (stats, stats->min);
+  }
+}
+
+double
+sc_stats_quantile (const sc_statinfo_t * stats, double q)
+{
+  int                 b;
+  double              target, below, ratio, lo;
+
+  SC_ASSERT (sc_stats_has_histogram (stats));
+  SC_ASSERT (0. <= q && q <= 1.);
+
+  if (stats->count <= 0) {
+    return 0.;
+  }
+
+  /* find the bucket that contains the quantile */
+  target = q * (double) stats->count;
+  below = 0.;
+  for (b = 0; b < SC_STATS_HISTOGRAM_BUCKETS + 1; ++b) {
+    if (below + stats->histogram[b] >= target && stats->histogram[b] > 0.) {
+      break;
+    }
+    below += stats->histogram[b];
+  }
+  if (b == 0) {
+    return stats->min;
+  }
+  if (b == SC_STATS_HISTOGRAM_BUCKETS + 1) {
+    return stats->max;
+  }
+
+  /* interpolate between the bounds of the bucket */
+  ratio = pow (stats->hist_upper / stats->hist_lower,
+               1. / SC_STATS_HISTOGRAM_BUCKETS);
+  lo = stats->hist_lower * pow (ratio, b - 1);
+  lo *= pow (ratio, (target - below) / stats->histogram[b]);
+  return SC_MAX (stats->min, SC_MIN (lo, stats->max));
+}
+
+void
+sc_stats_set_window (sc_statinfo_t * stats, int steps)
+{
+  SC_CHECK_ABORT (steps > 0, "Invalid window length");
+
+  sc_stats_window_clear (stats, 0);
+  stats->window_steps = steps;
 }
 
 void
@@ -167,6 +311,8 @@ sc_stats_set_group_prio (sc_statinfo_t * stats,
 void
 sc_stats_accumulate (sc_statinfo_t * stats, double value)
 {
+  double              decay;
+
   SC_ASSERT (stats->dirty);
   if (stats->count) {
     stats->count++;
@@ -182,71 +328,180 @@ sc_stats_accumulate (sc_statinfo_t * stats, double value)
     stats->min = value;
     stats->max = value;
   }
+  if (sc_stats_has_histogram (stats)) {
+    sc_stats_histogram_add (stats, value);
+  }
+  if (stats->window_steps > 0) {
+    decay = 1. - 1. / stats->window_steps;
+    stats->window_weight = decay * stats->window_weight + 1.;
+    stats->window_sum = decay * stats->window_sum + value;
+    stats->window_squares = decay * stats->window_squares + value * value;
+  }
 }
 
+#ifdef SC_ENABLE_MPI
+
+/* the reduction type with and without histograms and the operation
+   are created on first use and freed by sc_finalize */
+static MPI_Datatype sc_stats_types[2] = { MPI_DATATYPE_NULL,
+  MPI_DATATYPE_NULL
+};
+static MPI_Op       sc_stats_op = MPI_OP_NULL;
+
+static MPI_Datatype
+sc_stats_type (int stride)
+{
+  int                 mpiret;
+  const int           h = stride > SC_STATS_STRIDE;
+
+  if (sc_stats_types[h] == MPI_DATATYPE_NULL) {
+    mpiret = MPI_Type_contiguous (stride, MPI_DOUBLE, &sc_stats_types[h]);
+    SC_CHECK_MPI (mpiret);
+
+    mpiret = MPI_Type_commit (&sc_stats_types[h]);
+    SC_CHECK_MPI (mpiret);
+  }
+  if (sc_stats_op == MPI_OP_NULL) {
+    mpiret = MPI_Op_create ((MPI_User_function *) sc_stats_mpifunc, 1,
+                            &sc_stats_op);
+    SC_CHECK_MPI (mpiret);
+  }
+  return sc_stats_types[h];
+}
+
+#endif /* SC_ENABLE_MPI */
+
 void
-sc_stats_compute (sc_MPI_Comm mpicomm, int nvars, sc_statinfo_t * stats)
+sc_stats_free_cache (void)
+{
+#ifdef SC_ENABLE_MPI
+  int                 mpiret;
+  int                 h;
+
+  for (h = 0; h < 2; ++h) {
+    if (sc_stats_types[h] != MPI_DATATYPE_NULL) {
+      mpiret = MPI_Type_free (&sc_stats_types[h]);
+      SC_CHECK_MPI (mpiret);
+    }
+  }
+  if (sc_stats_op != MPI_OP_NULL) {
+    mpiret = MPI_Op_free (&sc_stats_op);
+    SC_CHECK_MPI (mpiret);
+  }
+#endif
+}
+
+struct sc_stats_request
+{
+  int                 nvars;
+  int                 stride;
+  sc_statinfo_t      *stats;
+  double             *flat;
+  sc_MPI_Request      request;
+};
+
+sc_stats_request_t *
+sc_stats_compute_begin (sc_MPI_Comm mpicomm, int nvars,
+                        sc_statinfo_t * stats)
 {
   int                 i;
   int                 mpiret;
   int                 rank;
-  double              cnt, avg;
-  double             *flat;
+  int                 stride;
   double             *flatin;
   double             *flatout;
+  double             *in;
+  sc_stats_request_t *req;
 #ifdef SC_ENABLE_MPI
-  sc_MPI_Op           op;
-  sc_MPI_Datatype     ctype;
+  MPI_Datatype        ctype;
 #endif
 
   mpiret = sc_MPI_Comm_rank (mpicomm, &rank);
   SC_CHECK_MPI (mpiret);
 
-  flat = SC_ALLOC (double, 2 * 7 * nvars);
-  flatin = flat;
-  flatout = flat + 7 * nvars;
+  /* we only send histograms if a variable has one on every process */
+  stride = SC_STATS_STRIDE;
+  for (i = 0; i < nvars; ++i) {
+    if (sc_stats_has_histogram (&stats[i])) {
+      stride += SC_STATS_HISTOGRAM_BUCKETS + 2;
+      break;
+    }
+  }
+
+  req = SC_ALLOC (sc_stats_request_t, 1);
+  req->nvars = nvars;
+  req->stride = stride;
+  req->stats = stats;
+  req->flat = SC_ALLOC (double, 2 * stride * nvars);
+  flatin = req->flat;
+  flatout = req->flat + stride * nvars;
 
   for (i = 0; i < nvars; ++i) {
+    in = flatin + stride * i;
     if (!stats[i].dirty) {
-      memset (flatin + 7 * i, 0, 7 * sizeof (*flatin));
+      memset (in, 0, stride * sizeof (*flatin));
       continue;
     }
-    flatin[7 * i + 0] = (double) stats[i].count;
-    flatin[7 * i + 1] = stats[i].sum_values;
-    flatin[7 * i + 2] = stats[i].sum_squares;
-    flatin[7 * i + 3] = stats[i].min;
-    flatin[7 * i + 4] = stats[i].max;
-    flatin[7 * i + 5] = (double) rank;  /* rank that attains minimum */
-    flatin[7 * i + 6] = (double) rank;  /* rank that attains maximum */
+    in[0] = (double) stats[i].count;
+    in[1] = stats[i].sum_values;
+    in[2] = stats[i].sum_squares;
+    in[3] = stats[i].min;
+    in[4] = stats[i].max;
+    in[5] = (double) rank;      /* rank that attains minimum */
+    in[6] = (double) rank;      /* rank that attains maximum */
+    in[SC_STATS_WINDOW] = stats[i].window_weight;
+    in[SC_STATS_WINDOW + 1] = stats[i].window_sum;
+    in[SC_STATS_WINDOW + 2] = stats[i].window_squares;
+    if (stride > SC_STATS_STRIDE) {
+      if (sc_stats_has_histogram (&stats[i])) {
+        memcpy (in + SC_STATS_STRIDE, stats[i].histogram,
+                sizeof (stats[i].histogram));
+      }
+      else {
+        memset (in + SC_STATS_STRIDE, 0, sizeof (stats[i].histogram));
+      }
+    }
   }
 
 #ifndef SC_ENABLE_MPI
-  memcpy (flatout, flatin, 7 * nvars * sizeof (*flatout));
+  memcpy (flatout, flatin, stride * nvars * sizeof (*flatout));
+  req->request = sc_MPI_REQUEST_NULL;
 #else
-  mpiret = MPI_Type_contiguous (7, MPI_DOUBLE, &ctype);
+  /* this call also creates the operation */
+  ctype = sc_stats_type (stride);
+#if MPI_VERSION >= 3
+  mpiret = MPI_Iallreduce (flatin, flatout, nvars, ctype,
+                           sc_stats_op, mpicomm, &req->request);
   SC_CHECK_MPI (mpiret);
-
-  mpiret = MPI_Type_commit (&ctype);
-  SC_CHECK_MPI (mpiret);
-
-  mpiret = MPI_Op_create ((MPI_User_function *) sc_stats_mpifunc, 1, &op);
+#else
+  mpiret = MPI_Allreduce (flatin, flatout, nvars, ctype,
+                          sc_stats_op, mpicomm);
   SC_CHECK_MPI (mpiret);
+  req->request = sc_MPI_REQUEST_NULL;
+#endif
+#endif /* SC_ENABLE_MPI */
 
-  mpiret = MPI_Allreduce (flatin, flatout, nvars, ctype, op, mpicomm);
-  SC_CHECK_MPI (mpiret);
+  return req;
+}
 
-  mpiret = MPI_Op_free (&op);
-  SC_CHECK_MPI (mpiret);
+void
+sc_stats_compute_end (sc_stats_request_t * req)
+{
+  int                 i;
+  int                 mpiret;
+  double              cnt, avg, weight;
+  double             *out;
+  sc_statinfo_t      *stats = req->stats;
 
-  mpiret = MPI_Type_free (&ctype);
+  mpiret = sc_MPI_Wait (&req->request, sc_MPI_STATUS_IGNORE);
   SC_CHECK_MPI (mpiret);
-#endif /* SC_ENABLE_MPI */
 
-  for (i = 0; i < nvars; ++i) {
+  for (i = 0; i < req->nvars; ++i) {
     if (!stats[i].dirty) {
       continue;
     }
-    cnt = flatout[7 * i + 0];
+    out = req->flat + req->stride * (req->nvars + i);
+    cnt = out[0];
     stats[i].count = (long) cnt;
     if (!cnt) {
       /* initialize output variables */
@@ -255,22 +510,41 @@ sc_stats_compute (sc_MPI_Comm mpicomm, int nvars, sc_statinfo_t * stats)
     }
     else {
       stats[i].dirty = 0;
-      stats[i].sum_values = flatout[7 * i + 1];
-      stats[i].sum_squares = flatout[7 * i + 2];
-      stats[i].min = flatout[7 * i + 3];
-      stats[i].max = flatout[7 * i + 4];
-      stats[i].min_at_rank = (int) flatout[7 * i + 5];
-      stats[i].max_at_rank = (int) flatout[7 * i + 6];
+      stats[i].sum_values = out[1];
+      stats[i].sum_squares = out[2];
+      stats[i].min = out[3];
+      stats[i].max = out[4];
+      stats[i].min_at_rank = (int) out[5];
+      stats[i].max_at_rank = (int) out[6];
       stats[i].average = avg = stats[i].sum_values / cnt;
       stats[i].variance = stats[i].sum_squares / cnt - avg * avg;
       stats[i].variance = SC_MAX (stats[i].variance, 0.);
       stats[i].variance_mean = stats[i].variance / cnt;
+      if (sc_stats_has_histogram (&stats[i])) {
+        memcpy (stats[i].histogram, out + SC_STATS_STRIDE,
+                sizeof (stats[i].histogram));
+      }
     }
     stats[i].standev = sqrt (stats[i].variance);
     stats[i].standev_mean = sqrt (stats[i].variance_mean);
+
+    /* the window is kept on the processes and only its result changes */
+    weight = out[SC_STATS_WINDOW];
+    if (stats[i].window_steps > 0 && weight > 0.) {
+      stats[i].window_average = avg = out[SC_STATS_WINDOW + 1] / weight;
+      stats[i].window_standev =
+        sqrt (SC_MAX (out[SC_STATS_WINDOW + 2] / weight - avg * avg, 0.));
+    }
   }
 
-  SC_FREE (flat);
+  SC_FREE (req->flat);
+  SC_FREE (req);
+}
+
+void
+sc_stats_compute (sc_MPI_Comm mpicomm, int nvars, sc_statinfo_t * stats)
+{
+  sc_stats_compute_end (sc_stats_compute_begin (mpicomm, nvars, stats));
 }
 
 void
@@ -286,6 +560,8 @@ sc_stats_compute1 (sc_MPI_Comm mpicomm, int nvars, sc_statinfo_t * stats)
     stats[i].sum_squares = value * value;
     stats[i].min = value;
     stats[i].max = value;
+    sc_stats_histogram_clear (&stats[i], 1);
+    sc_stats_window_clear (&stats[i], 1);
   }
 
   sc_stats_compute (mpicomm, nvars, stats);
@@ -366,6 +642,12 @@ sc_stats_print_ext (int package_id, int log_priority,
       SC_GEN_LOGF (package_id, SC_LC_GLOBAL, log_priority,
                    "   Maximum attained at rank %7d: %g\n",
                    si->max_at_rank, si->max);
+      if (sc_stats_has_histogram (si)) {
+        SC_GEN_LOGF (package_id, SC_LC_GLOBAL, log_priority,
+                     "   Quantiles 50/95/99%%:              %g %g %g\n",
+                     sc_stats_quantile (si, .5), sc_stats_quantile (si, .95),
+                     sc_stats_quantile (si, .99));
+      }
     }
   }
   else {
@@ -431,6 +713,32 @@ sc_stats_print_ext (int package_id, int log_priority,
   }
 }
 
+void
+sc_stats_print_window (int package_id, int log_priority,
+                       int nvars, sc_statinfo_t * stats)
+{
+  int                 i;
+  sc_statinfo_t      *si;
+  char                buffer[BUFSIZ];
+
+  for (i = 0; i < nvars; ++i) {
+    si = &stats[i];
+    if (si->window_steps <= 0) {
+      continue;
+    }
+    if (si->variable != NULL) {
+      snprintf (buffer, BUFSIZ, "for %s:", si->variable);
+    }
+    else {
+      snprintf (buffer, BUFSIZ, "for %3d:", i);
+    }
+    SC_GEN_LOGF (package_id, SC_LC_GLOBAL, log_priority,
+                 "Window %d (sigma) %-23s %g (%.3g) run %g\n",
+                 si->window_steps, buffer, si->window_average,
+                 si->window_standev, si->average);
+  }
+}
+
 sc_statistics_t    *
 sc_statistics_new (sc_MPI_Comm mpicomm)
 {
@@ -447,13 +755,36 @@ sc_statistics_new (sc_MPI_Comm mpicomm)
 void
 sc_statistics_destroy (sc_statistics_t * stats)
 {
+  size_t              zz;
+  sc_statinfo_t      *si;
+
+  for (zz = 0; zz < stats->sarray->elem_count; ++zz) {
+    si = (sc_statinfo_t *) sc_array_index (stats->sarray, zz);
+    if (si->variable_owned != NULL) {
+      SC_FREE (si->variable_owned);
+    }
+  }
   sc_keyvalue_destroy (stats->kv);
   sc_array_destroy (stats->sarray);
 
   SC_FREE (stats);
 }
 
-void
+/** Return the handle of an existing variable or abort. */
+static int
+sc_statistics_lookup (sc_statistics_t * stats, const char *name)
+{
+  int                 i;
+
+  i = sc_keyvalue_get_int (stats->kv, name, -1);
+
+  /* always check for wrong usage and output adequate error message */
+  SC_CHECK_ABORTF (i >= 0, "Statistics variable \"%s\" does not exist", name);
+
+  return i;
+}
+
+int
 sc_statistics_add (sc_statistics_t * stats, const char *name)
 {
   int                 i;
@@ -468,25 +799,30 @@ sc_statistics_add (sc_statistics_t * stats, const char *name)
   sc_stats_set1 (si, 0, name);
 
   sc_keyvalue_set_int (stats->kv, name, i);
+  return i;
 }
 
 void
 sc_statistics_set (sc_statistics_t * stats, const char *name, double value)
 {
-  int                 i;
-  sc_statinfo_t      *si;
-
-  i = sc_keyvalue_get_int (stats->kv, name, -1);
-
-  /* always check for wrong usage and output adequate error message */
-  SC_CHECK_ABORTF (i >= 0, "Statistics variable \"%s\" does not exist", name);
+  sc_statistics_set_handle (stats, sc_statistics_lookup (stats, name),
+                            value);
+}
 
-  si = (sc_statinfo_t *) sc_array_index_int (stats->sarray, i);
+void
+sc_statistics_set_handle (sc_statistics_t * stats, int handle, double value)
+{
+  char               *owned;
+  sc_statinfo_t      *si;
 
-  sc_stats_set1 (si, value, name);
+  si = (sc_statinfo_t *) sc_array_index_int (stats->sarray, handle);
+  /* keep a copied name, which may be the key of the variable */
+  owned = si->variable_owned;
+  sc_stats_set1 (si, value, si->variable);
+  si->variable_owned = owned;
 }
 
-void
+int
 sc_statistics_add_empty (sc_statistics_t * stats, const char *name)
 {
   int                 i;
@@ -501,6 +837,29 @@ sc_statistics_add_empty (sc_statistics_t * stats, const char *name)
   sc_stats_init (si, name);
 
   sc_keyvalue_set_int (stats->kv, name, i);
+  return i;
+}
+
+void
+sc_statistics_set_histogram (sc_statistics_t * stats, const char *name,
+                             double lower, double upper)
+{
+  sc_stats_set_histogram ((sc_statinfo_t *)
+                          sc_array_index_int (stats->sarray,
+                                              sc_statistics_lookup (stats,
+                                                                    name)),
+                          lower, upper);
+}
+
+void
+sc_statistics_set_window (sc_statistics_t * stats, const char *name,
+                          int steps)
+{
+  sc_stats_set_window ((sc_statinfo_t *)
+                       sc_array_index_int (stats->sarray,
+                                           sc_statistics_lookup (stats,
+                                                                 name)),
+                       steps);
 }
 
 int
@@ -509,21 +868,159 @@ sc_statistics_has (sc_statistics_t * stats, const char *name)
   return sc_keyvalue_exists (stats->kv, name);
 }
 
+int
+sc_statistics_get_handle (sc_statistics_t * stats, const char *name)
+{
+  return sc_keyvalue_get_int (stats->kv, name, -1);
+}
+
 void
 sc_statistics_accumulate (sc_statistics_t * stats, const char *name,
                           double value)
+{
+  sc_statistics_accumulate_handle (stats, sc_statistics_lookup (stats, name),
+                                   value);
+}
+
+void
+sc_statistics_accumulate_handle (sc_statistics_t * stats, int handle,
+                                 double value)
+{
+  SC_ASSERT (0 <= handle && (size_t) handle < stats->sarray->elem_count);
+
+  sc_stats_accumulate ((sc_statinfo_t *)
+                       sc_array_index_int (stats->sarray, handle), value);
+}
+
+void
+sc_statistics_accumulate_counters (sc_statistics_t * stats,
+                                   const char *name,
+                                   const sc_flopinfo_t * snapshot)
+{
+  int                 k, i;
+  char                counter_name[BUFSIZ];
+  sc_statinfo_t      *si;
+
+  for (k = 0; k < snapshot->num_counters; ++k) {
+    snprintf (counter_name, BUFSIZ, "%s %s", name,
+              sc_flops_counter_names[sc_flops_counters_event (k)]);
+    i = sc_keyvalue_get_int (stats->kv, counter_name, -1);
+    if (i < 0) {
+      /* the key must outlive the array element, so we copy the name */
+      i = (int) stats->sarray->elem_count;
+      si = (sc_statinfo_t *) sc_array_push (stats->sarray);
+      sc_stats_init_ext (si, counter_name, 1,
+                         sc_stats_group_all, sc_stats_prio_all);
+      sc_keyvalue_set_int (stats->kv, si->variable_owned, i);
+    }
+    sc_statistics_accumulate_handle (stats, i,
+                                     (double) snapshot->icounters[k]);
+  }
+}
+
+/** Return the handle of a variable with an owned name, created if missing. */
+static int
+sc_statistics_owned_handle (sc_statistics_t * stats, const char *name)
 {
   int                 i;
   sc_statinfo_t      *si;
 
   i = sc_keyvalue_get_int (stats->kv, name, -1);
+  if (i < 0) {
+    i = (int) stats->sarray->elem_count;
+    si = (sc_statinfo_t *) sc_array_push (stats->sarray);
+    sc_stats_init_ext (si, name, 1, sc_stats_group_all, sc_stats_prio_all);
+    sc_keyvalue_set_int (stats->kv, si->variable_owned, i);
+  }
+  return i;
+}
 
-  /* always check for wrong usage and output adequate error message */
-  SC_CHECK_ABORTF (i >= 0, "Statistics variable \"%s\" does not exist", name);
+/** Set a variable that is created with an owned name if it is missing. */
+static void
+sc_statistics_set_owned (sc_statistics_t * stats, const char *name,
+                         double value)
+{
+  sc_statistics_set_handle (stats, sc_statistics_owned_handle (stats, name),
+                            value);
+}
+
+static void
+sc_statistics_probe_push (sc_probe_t * probe, void *user)
+{
+  *(sc_probe_t **) sc_array_push ((sc_array_t *) user) = probe;
+}
+
+static int
+sc_statistics_probe_compare (const void *v1, const void *v2)
+{
+  return strcmp ((*(sc_probe_t * const *) v1)->name,
+                 (*(sc_probe_t * const *) v2)->name);
+}
+
+void
+sc_statistics_set_probes (sc_statistics_t * stats)
+{
+  size_t              zz, zy;
+  long long           calls, nanoseconds;
+  char                name[BUFSIZ];
+  sc_array_t         *probes;
+  sc_probe_t         *probe, *other;
+
+  /* the registration order differs between processes */
+  probes = sc_array_new (sizeof (sc_probe_t *));
+  sc_probes_iterate (sc_statistics_probe_push, probes);
+  sc_array_sort (probes, sc_statistics_probe_compare);
+
+  /* several sites may share a name */
+  for (zz = 0; zz < probes->elem_count; zz = zy) {
+    probe = *(sc_probe_t **) sc_array_index (probes, zz);
+    calls = nanoseconds = 0;
+    for (zy = zz; zy < probes->elem_count; ++zy) {
+      other = *(sc_probe_t **) sc_array_index (probes, zy);
+      if (strcmp (other->name, probe->name)) {
+        break;
+      }
+      calls += SC_ATOMIC_LOAD (&other->calls);
+      nanoseconds += SC_ATOMIC_LOAD (&other->nanoseconds);
+    }
+    snprintf (name, BUFSIZ, "%s calls", probe->name);
+    sc_statistics_set_owned (stats, name, (double) calls);
+    snprintf (name, BUFSIZ, "%s seconds", probe->name);
+    sc_statistics_set_owned (stats, name, 1.e-9 * nanoseconds);
+  }
+  sc_array_destroy (probes);
+}
 
-  si = (sc_statinfo_t *) sc_array_index_int (stats->sarray, i);
+void
+sc_statistics_set_hash (sc_statistics_t * stats, const char *name,
+                        sc_hash_t * hash)
+{
+  size_t              zz;
+  char                vname[BUFSIZ];
+  sc_statinfo_t      *si;
+  sc_list_t          *list;
+
+  /* the chain lengths of all slots form one distribution */
+  snprintf (vname, BUFSIZ, "%s chain length", name);
+  si = (sc_statinfo_t *) sc_array_index_int
+    (stats->sarray, sc_statistics_owned_handle (stats, vname));
+  sc_stats_reset (si, 0);
+  for (zz = 0; zz < hash->slots->elem_count; ++zz) {
+    list = (sc_list_t *) sc_array_index (hash->slots, zz);
+    sc_stats_accumulate (si, (double) list->elem_count);
+  }
 
-  sc_stats_accumulate (si, value);
+  /* the counters are zero unless switched on */
+  snprintf (vname, BUFSIZ, "%s lookups", name);
+  sc_statistics_set_owned (stats, vname, (double) hash->lookups);
+  snprintf (vname, BUFSIZ, "%s hit rate", name);
+  sc_statistics_set_owned (stats, vname, hash->lookups == 0 ? 0. :
+                           (double) hash->hits / (double) hash->lookups);
+  snprintf (vname, BUFSIZ, "%s probes per lookup", name);
+  sc_statistics_set_owned (stats, vname, hash->lookups == 0 ? 0. :
+                           (double) hash->probes / (double) hash->lookups);
+  snprintf (vname, BUFSIZ, "%s longest search", name);
+  sc_statistics_set_owned (stats, vname, (double) hash->max_chain);
 }
 
 void
@@ -541,3 +1038,293 @@ sc_statistics_print (sc_statistics_t * stats,
                   (int) stats->sarray->elem_count,
                   (sc_statinfo_t *) stats->sarray->array, full, summary);
 }
+
+void
+sc_statistics_reset (sc_statistics_t * stats)
+{
+  size_t              zz;
+
+  for (zz = 0; zz < stats->sarray->elem_count; ++zz) {
+    sc_stats_reset ((sc_statinfo_t *) sc_array_index (stats->sarray, zz), 0);
+  }
+}
+
+void
+sc_statistics_print_window (sc_statistics_t * stats,
+                            int package_id, int log_priority)
+{
+  sc_stats_print_window (package_id, log_priority,
+                         (int) stats->sarray->elem_count,
+                         (sc_statinfo_t *) stats->sarray->array);
+}
+
+/** One region in a tree of timers.  Node 0 is the root of the tree. */
+typedef struct sc_timer_node
+{
+  char               *name;
+  int                 parent;
+  int                 first_child, last_child, next_sibling;
+  long                calls;
+  double              inclusive;        /**< Seconds spent in the region. */
+  double              children;         /**< Inclusive seconds of children. */
+  sc_flopinfo_t       snap;             /**< Taken when the region opens. */
+}
+sc_timer_node_t;
+
+struct sc_timer_tree
+{
+  sc_flopinfo_t       fi;
+  sc_array_t          nodes;
+  int                 current;
+};
+
+static void
+sc_timer_nodes_init (sc_array_t * nodes)
+{
+  sc_timer_node_t    *root;
+
+  sc_array_init (nodes, sizeof (sc_timer_node_t));
+  root = (sc_timer_node_t *) sc_array_push (nodes);
+  memset (root, 0, sizeof (sc_timer_node_t));
+  root->parent = root->first_child = root->last_child = -1;
+  root->next_sibling = -1;
+}
+
+static void
+sc_timer_nodes_reset (sc_array_t * nodes)
+{
+  size_t              zz;
+
+  for (zz = 0; zz < nodes->elem_count; ++zz) {
+    SC_FREE (((sc_timer_node_t *) sc_array_index (nodes, zz))->name);
+  }
+  sc_array_reset (nodes);
+}
+
+/** Find a child by name and append it if it does not exist. */
+static int
+sc_timer_nodes_child (sc_array_t * nodes, int parent, const char *name)
+{
+  int                 i, child;
+  sc_timer_node_t    *node;
+
+  for (i = ((sc_timer_node_t *) sc_array_index_int (nodes, parent))
+       ->first_child; i != -1; i = node->next_sibling) {
+    node = (sc_timer_node_t *) sc_array_index_int (nodes, i);
+    if (!strcmp (node->name, name)) {
+      return i;
+    }
+  }
+
+  child = (int) nodes->elem_count;
+  node = (sc_timer_node_t *) sc_array_push (nodes);
+  memset (node, 0, sizeof (sc_timer_node_t));
+  node->name = SC_STRDUP (name);
+  node->parent = parent;
+  node->first_child = node->last_child = node->next_sibling = -1;
+
+  node = (sc_timer_node_t *) sc_array_index_int (nodes, parent);
+  if (node->last_child == -1) {
+    node->first_child = child;
+  }
+  else {
+    ((sc_timer_node_t *) sc_array_index_int (nodes, node->last_child))
+      ->next_sibling = child;
+  }
+  node->last_child = child;
+
+  return child;
+}
+
+/** Append the nodes below a parent in preorder with their depth. */
+static void
+sc_timer_nodes_preorder (sc_array_t * nodes, int parent, int depth,
+                         sc_array_t * order, sc_array_t * depths)
+{
+  int                 i;
+
+  for (i = ((sc_timer_node_t *) sc_array_index_int (nodes, parent))
+       ->first_child; i != -1;
+       i = ((sc_timer_node_t *) sc_array_index_int (nodes, i))
+       ->next_sibling) {
+    *(int *) sc_array_push (order) = i;
+    *(int *) sc_array_push (depths) = depth;
+    sc_timer_nodes_preorder (nodes, i, depth + 1, order, depths);
+  }
+}
+
+sc_timer_tree_t    *
+sc_timer_tree_new (void)
+{
+  sc_timer_tree_t    *tree;
+
+  tree = SC_ALLOC (sc_timer_tree_t, 1);
+  sc_flops_start_nopapi (&tree->fi);
+  sc_timer_nodes_init (&tree->nodes);
+  tree->current = 0;
+
+  return tree;
+}
+
+void
+sc_timer_tree_destroy (sc_timer_tree_t * tree)
+{
+  sc_timer_nodes_reset (&tree->nodes);
+  SC_FREE (tree);
+}
+
+void
+sc_timer_push (sc_timer_tree_t * tree, const char *name)
+{
+  sc_timer_node_t    *node;
+
+  tree->current = sc_timer_nodes_child (&tree->nodes, tree->current, name);
+  node = (sc_timer_node_t *) sc_array_index_int (&tree->nodes,
+                                                 tree->current);
+  sc_flops_snap (&tree->fi, &node->snap);
+}
+
+void
+sc_timer_pop (sc_timer_tree_t * tree, const char *name)
+{
+  sc_timer_node_t    *node;
+
+  SC_CHECK_ABORT (tree->current > 0, "Timer pop without open region");
+  node = (sc_timer_node_t *) sc_array_index_int (&tree->nodes,
+                                                 tree->current);
+  SC_CHECK_ABORTF (!strcmp (node->name, name),
+                   "Timer pop %s does not match %s", name, node->name);
+
+  sc_flops_shot (&tree->fi, &node->snap);
+  ++node->calls;
+  node->inclusive += node->snap.iwtime;
+  tree->current = node->parent;
+  ((sc_timer_node_t *) sc_array_index_int (&tree->nodes, tree->current))
+    ->children += node->snap.iwtime;
+}
+
+void
+sc_timer_tree_print (sc_timer_tree_t * tree, sc_MPI_Comm mpicomm,
+                     int package_id, int log_priority)
+{
+  int                 mpiret;
+  int                 mpisize, mpirank;
+  int                 p, k, depth, length, num, stack_alloc;
+  int                *lengths, *offsets, *stack;
+  size_t              zz, pos;
+  char               *all, label[BUFSIZ];
+  sc_array_t          text, order, depths, mine, merged;
+  sc_timer_node_t    *node;
+  sc_statinfo_t      *stats, *si;
+
+  mpiret = sc_MPI_Comm_size (mpicomm, &mpisize);
+  SC_CHECK_MPI (mpiret);
+  mpiret = sc_MPI_Comm_rank (mpicomm, &mpirank);
+  SC_CHECK_MPI (mpiret);
+
+  /* write the local regions in preorder as depth and name */
+  sc_array_init (&order, sizeof (int));
+  sc_array_init (&depths, sizeof (int));
+  sc_timer_nodes_preorder (&tree->nodes, 0, 0, &order, &depths);
+  sc_array_init (&text, 1);
+  for (zz = 0; zz < order.elem_count; ++zz) {
+    node = (sc_timer_node_t *) sc_array_index_int
+      (&tree->nodes, *(int *) sc_array_index (&order, zz));
+    length = (int) strlen (node->name) + 1;
+    memcpy (sc_array_push_count (&text, sizeof (int)),
+            sc_array_index (&depths, zz), sizeof (int));
+    memcpy (sc_array_push_count (&text, (size_t) length), node->name,
+            (size_t) length);
+  }
+
+  /* every process merges all trees in order of rank */
+  SC_CHECK_ABORT (text.elem_count <= (size_t) INT_MAX, "Timer tree size");
+  length = (int) text.elem_count;
+  lengths = SC_ALLOC (int, mpisize);
+  offsets = SC_ALLOC (int, mpisize + 1);
+  mpiret = sc_MPI_Allgather (&length, 1, sc_MPI_INT,
+                             lengths, 1, sc_MPI_INT, mpicomm);
+  SC_CHECK_MPI (mpiret);
+  offsets[0] = 0;
+  for (p = 0; p < mpisize; ++p) {
+    SC_CHECK_ABORT (offsets[p] <= INT_MAX - lengths[p], "Timer tree size");
+    offsets[p + 1] = offsets[p] + lengths[p];
+  }
+  all = SC_ALLOC (char, offsets[mpisize]);
+  mpiret = sc_MPI_Allgatherv (text.array, length, sc_MPI_CHAR,
+                              all, lengths, offsets, sc_MPI_CHAR, mpicomm);
+  SC_CHECK_MPI (mpiret);
+  sc_array_reset (&text);
+
+  sc_timer_nodes_init (&merged);
+  sc_array_init (&mine, sizeof (int));
+  stack_alloc = 8;
+  stack = SC_ALLOC (int, stack_alloc);
+  stack[0] = 0;
+  for (p = 0; p < mpisize; ++p) {
+    for (pos = offsets[p]; pos < (size_t) offsets[p + 1];) {
+      memcpy (&depth, all + pos, sizeof (int));
+      pos += sizeof (int);
+
+      /* the parent of a region is the last one found one level up */
+      if (depth + 2 > stack_alloc) {
+        stack_alloc = 2 * (depth + 2);
+        stack = SC_REALLOC (stack, int, stack_alloc);
+      }
+      k = sc_timer_nodes_child (&merged, stack[depth], all + pos);
+      stack[depth + 1] = k;
+      pos += strlen (all + pos) + 1;
+      if (p == mpirank) {
+        *(int *) sc_array_push (&mine) = k;
+      }
+    }
+  }
+  SC_FREE (stack);
+  SC_FREE (all);
+  SC_FREE (offsets);
+  SC_FREE (lengths);
+
+  /* three variables per merged region and only the local ones are set */
+  num = (int) merged.elem_count;
+  stats = SC_ALLOC (sc_statinfo_t, 3 * num);
+  for (k = 0; k < 3 * num; ++k) {
+    sc_stats_init (stats + k, NULL);
+  }
+  SC_ASSERT (mine.elem_count == order.elem_count);
+  for (zz = 0; zz < mine.elem_count; ++zz) {
+    node = (sc_timer_node_t *) sc_array_index_int
+      (&tree->nodes, *(int *) sc_array_index (&order, zz));
+    k = *(int *) sc_array_index (&mine, zz);
+    sc_stats_accumulate (stats + 3 * k, (double) node->calls);
+    sc_stats_accumulate (stats + 3 * k + 1, node->inclusive);
+    sc_stats_accumulate (stats + 3 * k + 2,
+                         node->inclusive - node->children);
+  }
+  sc_stats_compute (mpicomm, 3 * num, stats);
+
+  /* print the merged regions in preorder */
+  sc_array_truncate (&order);
+  sc_array_truncate (&depths);
+  sc_timer_nodes_preorder (&merged, 0, 0, &order, &depths);
+  SC_GEN_LOGF (package_id, SC_LC_GLOBAL, log_priority,
+               "%-30s %5s %9s %29s %29s\n", "Timer region", "procs",
+               "calls", "inclusive min/avg/max", "exclusive min/avg/max");
+  for (zz = 0; zz < order.elem_count; ++zz) {
+    k = *(int *) sc_array_index (&order, zz);
+    node = (sc_timer_node_t *) sc_array_index_int (&merged, k);
+    si = stats + 3 * k;
+    snprintf (label, BUFSIZ, "%*s%s",
+              2 * *(int *) sc_array_index (&depths, zz), "", node->name);
+    SC_GEN_LOGF (package_id, SC_LC_GLOBAL, log_priority,
+                 "%-30s %5ld %9.3g %9.3g %9.3g %9.3g %9.3g %9.3g %9.3g\n",
+                 label, si[0].count, si[0].average,
+                 si[1].min, si[1].average, si[1].max,
+                 si[2].min, si[2].average, si[2].max);
+  }
+
+  SC_FREE (stats);
+  sc_timer_nodes_reset (&merged);
+  sc_array_reset (&mine);
+  sc_array_reset (&order);
+  sc_array_reset (&depths);
+}
@@ -30,6 +30,7 @@
 #define SC_STATISTICS_H
 
 #include <sc_keyvalue.h>
+#include <sc_flops.h>
 
 SC_EXTERN_C_BEGIN;
 
@@ -39,6 +40,11 @@ extern const int    sc_stats_group_all;
 /** This special group number (negative) will refer to any priority. */
 extern const int    sc_stats_prio_all;
 
+#ifndef SC_STATS_HISTOGRAM_BUCKETS
+/** Number of logarithmic buckets between the bounds of a histogram. */
+#define SC_STATS_HISTOGRAM_BUCKETS 64
+#endif
+
 /** Store information of one random variable. */
 typedef struct sc_statinfo
 {
@@ -55,6 +61,15 @@ typedef struct sc_statinfo
   char               *variable_owned;   /**< NULL or deep copy of variable. */
   int                 group;            /**< Grouping identifier. */
   int                 prio;             /**< Priority identifier. */
+  double              hist_lower;       /**< Lower bound of the histogram. */
+  double              hist_upper;       /**< Unused histogram if not larger. */
+  /** Inout; counts below the lower bound, in the buckets and above. */
+  double              histogram[SC_STATS_HISTOGRAM_BUCKETS + 2];
+  int                 window_steps;     /**< Window length, 0 if unused. */
+  double              window_weight;    /**< Local decayed count. */
+  double              window_sum;       /**< Local decayed sum of values. */
+  double              window_squares;   /**< Local decayed sum of squares. */
+  double              window_average, window_standev;   /* out */
 }
 sc_statinfo_t;
 
@@ -130,6 +145,45 @@ void                sc_stats_init_ext (sc_statinfo_t * stats,
  */
 void                sc_stats_reset (sc_statinfo_t * stats, int reset_vgp);
 
+/** Record the values of a variable in a histogram to estimate quantiles.
+ * The range between the bounds is split into \ref SC_STATS_HISTOGRAM_BUCKETS
+ * buckets of equal ratio.  Values outside count below or above the range.
+ * The histogram is reduced by \ref sc_stats_compute in the same call.
+ * Every process must set the same bounds for a variable.
+ * Without this call, which is reset by the set1, init and reset functions
+ * with reset_vgp true, no histogram is kept.
+ * \param [in,out] stats      Must be dirty with a count of at most one.
+ * \param [in] lower          Positive lower bound of the histogram.
+ * \param [in] upper          Upper bound larger than \a lower.
+ */
+void                sc_stats_set_histogram (sc_statinfo_t * stats,
+                                            double lower, double upper);
+
+/** Estimate a quantile of a variable from its histogram.
+ * Inside a bucket we interpolate logarithmically.
+ * The result is clamped to the minimum and maximum of the values.
+ * \param [in] stats          Statistics with a histogram, normally
+ *                            after \ref sc_stats_compute.
+ * \param [in] q              Number between 0 and 1, e.g. 0.99.
+ * \return                    Estimated value, or 0 with a count of 0.
+ */
+double              sc_stats_quantile (const sc_statinfo_t * stats, double q);
+
+/** Keep a rolling mean and variance over about the latest values.
+ * Every \ref sc_stats_accumulate multiplies the weight of the previous
+ * values by 1 - 1 / \a steps, which weighs a value from \a steps calls
+ * ago by about 37%.  The decayed sums live on the process and are not
+ * touched by \ref sc_stats_compute or by \ref sc_stats_reset without
+ * reset_vgp, so a loop accumulating, computing, printing and resetting
+ * the statistics follows the recent values over the whole run.
+ * The global window is reduced by \ref sc_stats_compute into the fields
+ * window_average and window_standev.  The set1 and init functions and
+ * reset with reset_vgp true remove the window.
+ * \param [in,out] stats      The window is started anew.
+ * \param [in] steps          Positive number of accumulations per window.
+ */
+void                sc_stats_set_window (sc_statinfo_t * stats, int steps);
+
 /** Set/update the group and priority information for a stats item.
  * \param [out] stats          Only group and stats entries are updated.
  * \param [in] stats_group     Non-negative number or \ref sc_stats_group_all.
@@ -159,6 +213,7 @@ void                sc_stats_accumulate (sc_statinfo_t * stats, double value);
  *    sum_squares   Sum of squares for each process.
  *    min, max      Minimum and maximum of values for each process.
  *    variable      String describing the variable, or NULL.
+ *    hist_*        Zero or set by \ref sc_stats_set_histogram.
  * On output, the fields have the following meaning.
  *    count                        Global number of values.
  *    sum_values                   Global sum of values.
@@ -167,15 +222,41 @@ void                sc_stats_accumulate (sc_statinfo_t * stats, double value);
  *    min_at_rank, max_at_rank     The ranks that attain min and max.
  *    average, variance, standev   Global statistical measures.
  *    variance_mean, standev_mean  Statistical measures of the mean.
+ *    histogram                    Global counts if a histogram is set.
+ *    window_average               Global mean within the window if set.
+ *    window_standev               Global deviation within the window.
  */
 void                sc_stats_compute (sc_MPI_Comm mpicomm, int nvars,
                                       sc_statinfo_t * stats);
 
+/** Opaque handle of a reduction started by \ref sc_stats_compute_begin. */
+typedef struct sc_stats_request sc_stats_request_t;
+
+/** Start the computation of \ref sc_stats_compute without blocking.
+ * With MPI 3 the reduction progresses while we return, otherwise it is
+ * completed in this call.  The variables must not be accessed before
+ * \ref sc_stats_compute_end.  This function is collective.
+ * \param [in]     mpicomm   MPI communicator to use.
+ * \param [in]     nvars     Number of variables to be examined.
+ * \param [in,out] stats     Set of statisics items as for
+ *                           \ref sc_stats_compute.
+ * \return                   The handle to pass to the end call.
+ */
+sc_stats_request_t *sc_stats_compute_begin (sc_MPI_Comm mpicomm, int nvars,
+                                            sc_statinfo_t * stats);
+
+/** Complete a computation started by \ref sc_stats_compute_begin.
+ * On output the variables are set as by \ref sc_stats_compute.
+ * \param [in] req           The handle is freed.
+ */
+void                sc_stats_compute_end (sc_stats_request_t * req);
+
 /**
  * Version of sc_statistics_statistics that assumes count=1.
  * On input, the field sum_values needs to be set to the value
  * and the field variable must contain a valid string or NULL.
  * Only updates dirty variables. Then removes the dirty flag.
+ * No histogram is kept for these variables.
  */
 void                sc_stats_compute1 (sc_MPI_Comm mpicomm, int nvars,
                                        sc_statinfo_t * stats);
@@ -227,6 +308,20 @@ void                sc_stats_print_ext (int package_id, int log_priority,
                                         int stats_group, int stats_prio,
                                         int full, int summary);
 
+/** Print one line for each variable with a window, see
+ * \ref sc_stats_set_window, after \ref sc_stats_compute.
+ * The line holds the mean and deviation within the window and the mean
+ * of the values since the last reset for comparison.
+ * This function uses the SC_LC_GLOBAL log category.
+ * \param [in] package_id       Registered package id or -1.
+ * \param [in] log_priority     Log priority for output according to sc.h.
+ * \param [in] nvars            Number of stats items in input array.
+ * \param [in] stats            Input array of stats variable items.
+ */
+void                sc_stats_print_window (int package_id, int log_priority,
+                                           int nvars,
+                                           sc_statinfo_t * stats);
+
 /** Create a new statistics structure that can grow dynamically.
  */
 sc_statistics_t    *sc_statistics_new (sc_MPI_Comm mpicomm);
@@ -238,19 +333,41 @@ void                sc_statistics_destroy (sc_statistics_t * stats);
 
 /** Register a statistics variable by name and set its value to 0.
  * This variable must not exist already.
+ * \return     A handle to access the variable without looking up its name.
  */
-void                sc_statistics_add (sc_statistics_t * stats,
+int                 sc_statistics_add (sc_statistics_t * stats,
                                        const char *name);
 
 /** Register a statistics variable by name and set its count to 0.
  * This variable must not exist already.
+ * \return     A handle to access the variable without looking up its name.
  */
-void                sc_statistics_add_empty (sc_statistics_t * stats,
+int                 sc_statistics_add_empty (sc_statistics_t * stats,
                                              const char *name);
 
+/** Keep a histogram of a variable, see sc_stats_set_histogram.
+ * The variable must previously be added with sc_statistics_add_empty.
+ */
+void                sc_statistics_set_histogram (sc_statistics_t * stats,
+                                                 const char *name,
+                                                 double lower, double upper);
+
+/** Keep a rolling window of a variable, see sc_stats_set_window.
+ * The variable must previously be added with sc_statistics_add_empty.
+ */
+void                sc_statistics_set_window (sc_statistics_t * stats,
+                                              const char *name, int steps);
+
 /** Returns true if the stats include a variable with the given name */
 int                 sc_statistics_has (sc_statistics_t * stats,
                                        const char *name);
+
+/** Return the handle of a variable or -1 if it does not exist.
+ * The handle stays valid until the stats are destroyed.
+ */
+int                 sc_statistics_get_handle (sc_statistics_t * stats,
+                                              const char *name);
+
 /** Set the value of a statistics variable, see sc_stats_set1.
  * The variable must previously be added with sc_statistics_add.
  * This assumes count=1 as in the sc_stats_set1 function above.
@@ -258,12 +375,56 @@ int                 sc_statistics_has (sc_statistics_t * stats,
 void                sc_statistics_set (sc_statistics_t * stats,
                                        const char *name, double value);
 
+/** Set the value of a statistics variable by its handle.
+ * This is \ref sc_statistics_set without the lookup of the name.
+ */
+void                sc_statistics_set_handle (sc_statistics_t * stats,
+                                              int handle, double value);
+
 /** Add an instance of a statistics variable, see sc_stats_accumulate
  * The variable must previously be added with sc_statistics_add_empty.
  */
 void                sc_statistics_accumulate (sc_statistics_t * stats,
                                               const char *name, double value);
 
+/** Add an instance of a statistics variable by its handle.
+ * This is \ref sc_statistics_accumulate without the lookup of the name.
+ */
+void                sc_statistics_accumulate_handle (sc_statistics_t *
+                                                     stats, int handle,
+                                                     double value);
+
+/** Add the hardware counter intervals of a snapshot.
+ * For each counter in \a snapshot, see \ref sc_flops_counters_open,
+ * the variable "<name> <counter>" is accumulated and created on first use.
+ * All processes must open the same counters and pass the same names
+ * before the statistics are computed.
+ */
+void                sc_statistics_accumulate_counters (sc_statistics_t *
+                                                       stats,
+                                                       const char *name,
+                                                       const sc_flopinfo_t *
+                                                       snapshot);
+
+/** Set the variables "<name> calls" and "<name> seconds" to the totals
+ * of the probe sites of each name, see \ref SC_PROBE_BEGIN.
+ * The variables are created on first use and sorted by name.
+ * All processes must have registered the same probe names.
+ */
+void                sc_statistics_set_probes (sc_statistics_t * stats);
+
+/** Set the variables describing the chains and probes of a hash table.
+ * The variable "<name> chain length" accumulates the length of every
+ * slot, so its maximum and deviation reveal a poor hash function.
+ * The variables "<name> lookups", "<name> hit rate", "<name> probes per
+ * lookup" and "<name> longest search" are taken from the counters of
+ * \ref sc_hash_set_count_probes.  The variables are created on first use.
+ * All processes must pass the same names before computing the statistics.
+ */
+void                sc_statistics_set_hash (sc_statistics_t * stats,
+                                            const char *name,
+                                            sc_hash_t * hash);
+
 /** Compute statistics for all variables, see sc_stats_compute.
  */
 void                sc_statistics_compute (sc_statistics_t * stats);
@@ -274,6 +435,63 @@ void                sc_statistics_print (sc_statistics_t * stats,
                                          int package_id, int log_priority,
                                          int full, int summary);
 
+/** Reset the values of all variables to accumulate them again.
+ * Names, histogram bounds and windows are kept, see sc_stats_reset.
+ */
+void                sc_statistics_reset (sc_statistics_t * stats);
+
+/** Print the variables with a window, see sc_stats_print_window.
+ */
+void                sc_statistics_print_window (sc_statistics_t * stats,
+                                                int package_id,
+                                                int log_priority);
+
+/** Opaque tree of nested timer regions. */
+typedef struct sc_timer_tree sc_timer_tree_t;
+
+/** Create an empty tree of timer regions and start its clock.
+ * \return                 The tree has no open region.
+ */
+sc_timer_tree_t    *sc_timer_tree_new (void);
+
+/** Destroy a tree of timer regions.
+ * \param [in,out] tree    Valid object is invalidated.
+ */
+void                sc_timer_tree_destroy (sc_timer_tree_t * tree);
+
+/** Open a region as a child of the currently open region.
+ * A region is identified by its name and the path of its parents.
+ * Each time it is opened its call count is incremented.
+ * \param [in,out] tree    The tree of timer regions.
+ * \param [in] name        The name of the region.  It is copied.
+ */
+void                sc_timer_push (sc_timer_tree_t * tree, const char *name);
+
+/** Close the currently open region and add its time.
+ * The inclusive time of a region counts all time while it is open.
+ * The exclusive time is the inclusive time minus that of its children.
+ * \param [in,out] tree    The tree of timer regions.
+ * \param [in] name        Must match the name of the open region.
+ */
+void                sc_timer_pop (sc_timer_tree_t * tree, const char *name);
+
+/** Print the regions of a tree reduced over all processes.
+ * The trees may differ between processes.  Each region is printed once in
+ * the order it is first found on the lowest rank, indented by its depth.
+ * We print the number of processes that have entered it, the average call
+ * count and the minimum, average and maximum of the inclusive and
+ * exclusive times computed by \ref sc_stats_compute.
+ * This function is collective and uses the SC_LC_GLOBAL log category.
+ * Regions still open are reported as of their last close.
+ * \param [in] tree        The tree of timer regions.
+ * \param [in] mpicomm     The trees of these processes are reduced.
+ * \param [in] package_id  Registered package id or -1.
+ * \param [in] log_priority        Log priority for output.
+ */
+void                sc_timer_tree_print (sc_timer_tree_t * tree,
+                                         sc_MPI_Comm mpicomm,
+                                         int package_id, int log_priority);
+
 SC_EXTERN_C_END;
 
 #endif /* !SC_STATISTICS_H */
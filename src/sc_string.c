@@ -100,3 +100,172 @@ sc_string_get_content (sc_string_t * scs, int *length)
   }
   return scs->buffer;
 }
+
+/* string builder routines */
+
+static char        *
+sc_strbuf_data (sc_strbuf_t * sb)
+{
+  return sb->heap != NULL ? sb->heap : sb->small;
+}
+
+/** Make room for a string of a given length and its trailing '\0'. */
+static void
+sc_strbuf_reserve (sc_strbuf_t * sb, size_t length)
+{
+  size_t              capacity;
+
+  if (length < sb->capacity) {
+    return;
+  }
+  capacity = SC_MAX (length + 1, 2 * sb->capacity);
+  if (sb->heap == NULL) {
+    sb->heap = SC_ALLOC (char, capacity);
+    memcpy (sb->heap, sb->small, sb->length + 1);
+  }
+  else {
+    sb->heap = SC_REALLOC (sb->heap, char, capacity);
+  }
+  sb->capacity = capacity;
+}
+
+void
+sc_strbuf_init (sc_strbuf_t * sb)
+{
+  SC_ASSERT (sb != NULL);
+
+  sb->length = 0;
+  sb->capacity = SC_STRBUF_SMALL;
+  sb->heap = NULL;
+  sb->small[0] = '\0';
+}
+
+void
+sc_strbuf_reset (sc_strbuf_t * sb)
+{
+  SC_ASSERT (sb != NULL);
+
+  SC_FREE (sb->heap);
+  sc_strbuf_init (sb);
+}
+
+void
+sc_strbuf_truncate (sc_strbuf_t * sb)
+{
+  SC_ASSERT (sb != NULL);
+
+  sb->length = 0;
+  sc_strbuf_data (sb)[0] = '\0';
+}
+
+int
+sc_strbuf_putc (sc_strbuf_t * sb, int c)
+{
+  char               *data;
+
+  SC_ASSERT (sb != NULL);
+
+  sc_strbuf_reserve (sb, sb->length + 1);
+  data = sc_strbuf_data (sb);
+  data[sb->length++] = (char) (unsigned char) c;
+  data[sb->length] = '\0';
+  return 0;
+}
+
+int
+sc_strbuf_puts (sc_strbuf_t * sb, const char *s)
+{
+  size_t              len;
+
+  SC_ASSERT (sb != NULL);
+  SC_ASSERT (s != NULL);
+
+  len = strlen (s);
+  sc_strbuf_reserve (sb, sb->length + len);
+  memcpy (sc_strbuf_data (sb) + sb->length, s, len + 1);
+  sb->length += len;
+  return 0;
+}
+
+int
+sc_strbuf_putf (sc_strbuf_t * sb, const char *fmt, ...)
+{
+  int                 result;
+  va_list             val;
+
+  va_start (val, fmt);
+  result = sc_strbuf_putv (sb, fmt, val);
+  va_end (val);
+
+  return result;
+}
+
+int
+sc_strbuf_putv (sc_strbuf_t * sb, const char *fmt, va_list ap)
+{
+  int                 result;
+  size_t              remain;
+  va_list             aq;
+
+  SC_ASSERT (sb != NULL);
+  SC_ASSERT (sb->length < sb->capacity);
+
+  /* we print into the free space and learn the length required */
+  remain = sb->capacity - sb->length;
+  va_copy (aq, ap);
+  result = vsnprintf (sc_strbuf_data (sb) + sb->length, remain, fmt, aq);
+  va_end (aq);
+  if (result < 0) {
+    sc_strbuf_data (sb)[sb->length] = '\0';
+    return -1;
+  }
+  if ((size_t) result >= remain) {
+    /* grow and print again, which happens rarely due to doubling */
+    sc_strbuf_reserve (sb, sb->length + (size_t) result);
+    result = vsnprintf (sc_strbuf_data (sb) + sb->length,
+                        sb->capacity - sb->length, fmt, ap);
+    SC_ASSERT (result >= 0 && (size_t) result < sb->capacity - sb->length);
+  }
+  sb->length += (size_t) result;
+  return 0;
+}
+
+const char         *
+sc_strbuf_get_content (const sc_strbuf_t * sb, size_t *length)
+{
+  SC_ASSERT (sb != NULL);
+  SC_ASSERT (sb->length < sb->capacity);
+
+  if (length != NULL) {
+    *length = sb->length;
+  }
+  return sb->heap != NULL ? sb->heap : sb->small;
+}
+
+int
+sc_strbuf_write (const sc_strbuf_t * sb, sc_io_sink_t * sink)
+{
+  size_t              length;
+  const char         *content;
+
+  content = sc_strbuf_get_content (sb, &length);
+  return sc_io_sink_write (sink, content, length);
+}
+
+char               *
+sc_strbuf_detach (sc_strbuf_t * sb, size_t *length)
+{
+  char               *s;
+
+  SC_ASSERT (sb != NULL);
+
+  if (length != NULL) {
+    *length = sb->length;
+  }
+  if ((s = sb->heap) == NULL) {
+    s = SC_ALLOC (char, sb->length + 1);
+    memcpy (s, sb->small, sb->length + 1);
+  }
+  sc_strbuf_init (sb);
+  return s;
+}
@@ -24,10 +24,12 @@
 #ifndef SC_STRING_H
 #define SC_STRING_H
 
-#include <sc.h>
+#include <sc_io.h>
 
 /** \file sc_string.h
  * This file declares a simple string object that can be appended to.
+ * The fixed size \ref sc_string_t needs no allocation at all, while the
+ * string builder \ref sc_strbuf_t grows on the heap without limit.
  *
  * \ingroup sc_containers
  */
@@ -106,4 +108,105 @@ int                 sc_string_putv (sc_string_t * scs, const char *fmt,
  */
 const char         *sc_string_get_content (sc_string_t * scs, int *length);
 
+/** Size of the storage of a string builder before it goes to the heap. */
+#define SC_STRBUF_SMALL 248
+
+/** A string builder that grows geometrically on the heap.
+ * It offers the same put functions as \ref sc_string_t.  Short strings
+ * are stored in the object itself, which may be declared on the stack.
+ * The object may be copied by value as long as it holds no more than
+ * \ref SC_STRBUF_SMALL - 1 characters.
+ * This is really an opaque object: its members shall not be accessed directly.
+ */
+typedef struct sc_strbuf
+{
+  size_t              length;   /**< Opaque object: do not access. */
+  size_t              capacity; /**< Opaque object: do not access. */
+  char               *heap;     /**< Opaque object: do not access. */
+  char                small[SC_STRBUF_SMALL];   /**< Opaque object. */
+}
+sc_strbuf_t;
+
+/** Initialize to an empty string.
+ * \param [out] sb              After returning, a valid object containing
+ *                              the empty string.  Its contents may be
+ *                              undefined on input.
+ */
+void                sc_strbuf_init (sc_strbuf_t * sb);
+
+/** Free the memory of a string builder and make it empty.
+ * \param [in,out] sb           A valid object, afterwards empty.
+ */
+void                sc_strbuf_reset (sc_strbuf_t * sb);
+
+/** Make a string builder empty, but keep its memory for reuse.
+ * \param [in,out] sb           A valid object, afterwards empty.
+ */
+void                sc_strbuf_truncate (sc_strbuf_t * sb);
+
+/** Append a single character to the string builder.
+ * \param [in,out] sb           A valid string builder.
+ * \param [in] c                Converted to an unsigned char and appended.
+ * \return                      Zero.
+ */
+int                 sc_strbuf_putc (sc_strbuf_t * sb, int c);
+
+/** Append a string to the string builder.
+ * \param [in,out] sb           A valid string builder.
+ * \param [in] s                This string is appended.
+ * \return                      Zero.
+ */
+int                 sc_strbuf_puts (sc_strbuf_t * sb, const char *s);
+
+/** Append to the string builder using a format string and arguments.
+ * \param [in,out] sb           A valid string builder.
+ * \param [in] fmt              Format string as used with printf and friends.
+ * \return                      Zero if everything has been appended and a
+ *                              negative value on an output error of
+ *                              vsnprintf, in which case nothing is appended.
+ */
+int                 sc_strbuf_putf (sc_strbuf_t * sb, const char *fmt, ...)
+  __attribute__ ((format (printf, 2, 3)));
+
+/** Append to the string builder using a format string and a vararg pointer.
+ * \param [in,out] sb           A valid string builder.
+ * \param [in] fmt              Format string as used with printf and friends.
+ * \param [in,out] ap           Argument list pointer as defined in stdarg.h.
+ * \return                      Zero if everything has been appended and a
+ *                              negative value on an output error of
+ *                              vsnprintf, in which case nothing is appended.
+ */
+int                 sc_strbuf_putv (sc_strbuf_t * sb, const char *fmt,
+                                    va_list ap);
+
+/** Access the content of the string builder.
+ * \param [in] sb               A valid string builder.
+ * \param [out] length          If not NULL, assign length without trailing
+ *                              '\0'.
+ * \return                      Pointer to the internal string.  It is valid
+ *                              until the next modification of \b sb.
+ */
+const char         *sc_strbuf_get_content (const sc_strbuf_t * sb,
+                                           size_t *length);
+
+/** Write the content of the string builder to a sink without copying it.
+ * The trailing '\0' is not written.  The string builder is not changed.
+ * \param [in] sb               A valid string builder.
+ * \param [in,out] sink         The content is passed to \ref
+ *                              sc_io_sink_write.
+ * \return                      The return value of \ref sc_io_sink_write.
+ */
+int                 sc_strbuf_write (const sc_strbuf_t * sb,
+                                     sc_io_sink_t * sink);
+
+/** Take over the content of a string builder, which is left empty.
+ * \param [in,out] sb           A valid string builder.
+ * \param [out] length          If not NULL, assign length without trailing
+ *                              '\0'.
+ * \return                      The string, allocated by SC_ALLOC.
+ *                              The caller must release it with SC_FREE.
+ *                              Only a short string is copied.
+ */
+char               *sc_strbuf_detach (sc_strbuf_t * sb, size_t *length);
+
 #endif /* !SC_STRING_H */
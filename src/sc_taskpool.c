@@ -0,0 +1,488 @@
+/*
+  This file is part of the SC Library.
+  The SC Library provides support for parallel scientific applications.
+
+  Copyright (C) 2010 The University of Texas System
+  Additional copyright (C) 2011 individual authors
+
+  The SC Library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  The SC Library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with the SC Library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+  02110-1301, USA.
+*/
+
+#include <sc_taskpool.h>
+#include <sc_atomic.h>
+#include <sc_private.h>
+#include <sc_thread.h>
+#ifdef SC_ENABLE_PTHREAD
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+/** The initial number of tasks that fit into a deque. */
+#define SC_TASKPOOL_DEQUE_SIZE 64
+
+/** The interval in milliseconds at which an idle worker wakes up. */
+#define SC_TASKPOOL_IDLE_MSEC 10
+
+/** A task queued for execution. */
+typedef struct sc_taskpool_task
+{
+  sc_taskpool_fn_t    fn;
+  void               *user;
+  sc_taskgroup_t     *group;
+}
+sc_taskpool_task_t;
+
+#ifdef SC_ENABLE_PTHREAD
+
+/** A ring of tasks with the owner working at the tail.
+ * The head and tail are increasing counters reduced modulo the size.
+ */
+typedef struct sc_taskpool_deque
+{
+  pthread_mutex_t     mutex;
+  sc_taskpool_task_t *tasks;
+  size_t              size;     /**< A power of two. */
+  size_t              head;
+  size_t              tail;
+}
+sc_taskpool_deque_t;
+
+/** The identity of a worker thread. */
+typedef struct sc_taskpool_worker
+{
+  sc_taskpool_t      *pool;
+  int                 index;
+  pthread_t           thread;
+}
+sc_taskpool_worker_t;
+
+#endif
+
+struct sc_taskpool
+{
+  int                 num_threads;
+#ifdef SC_ENABLE_PTHREAD
+  int                 num_workers;
+  int                 running;
+  int                 sleeping;
+  long                queued;   /**< Tasks in all deques. */
+  pthread_mutex_t     mutex;
+  pthread_cond_t      cond;
+  pthread_key_t       key;
+  sc_taskpool_worker_t *workers;
+  sc_taskpool_deque_t *deques;  /**< The last one is shared. */
+#endif
+};
+
+/* the pool of the library and the lock of its creation */
+static sc_taskpool_t *sc_taskpool_global = NULL;
+#ifdef SC_ENABLE_PTHREAD
+static pthread_mutex_t sc_taskpool_global_mutex = PTHREAD_MUTEX_INITIALIZER;
+#endif
+
+static void
+sc_taskpool_run (sc_taskpool_task_t * task)
+{
+  task->fn (task->user);
+  (void) SC_ATOMIC_FETCH_ADD (&task->group->pending, -1L);
+}
+
+#ifdef SC_ENABLE_PTHREAD
+
+static void
+sc_taskpool_deque_push (sc_taskpool_deque_t * dq,
+                        const sc_taskpool_task_t * task)
+{
+  size_t              i, count;
+  sc_taskpool_task_t *tasks;
+
+  pthread_mutex_lock (&dq->mutex);
+  count = dq->tail - dq->head;
+  if (count == dq->size) {
+    /* unroll the ring into an array of twice the size */
+    tasks = SC_ALLOC (sc_taskpool_task_t, 2 * dq->size);
+    for (i = 0; i < count; ++i) {
+      tasks[i] = dq->tasks[(dq->head + i) & (dq->size - 1)];
+    }
+    SC_FREE (dq->tasks);
+    dq->tasks = tasks;
+    dq->size *= 2;
+    dq->head = 0;
+    dq->tail = count;
+  }
+  dq->tasks[dq->tail++ & (dq->size - 1)] = *task;
+  pthread_mutex_unlock (&dq->mutex);
+}
+
+/** Take the newest task if \a newest is true and the oldest otherwise.
+ * \return          True if a task has been taken.
+ */
+static int
+sc_taskpool_deque_take (sc_taskpool_deque_t * dq, int newest,
+                        sc_taskpool_task_t * task)
+{
+  int                 found = 0;
+
+  pthread_mutex_lock (&dq->mutex);
+  if (dq->head != dq->tail) {
+    if (newest) {
+      *task = dq->tasks[--dq->tail & (dq->size - 1)];
+    }
+    else {
+      *task = dq->tasks[dq->head++ & (dq->size - 1)];
+    }
+    found = 1;
+  }
+  pthread_mutex_unlock (&dq->mutex);
+  return found;
+}
+
+/** The deque of the calling thread in a pool. */
+static int
+sc_taskpool_self (sc_taskpool_t * pool)
+{
+  sc_taskpool_worker_t *worker;
+
+  worker = (sc_taskpool_worker_t *) pthread_getspecific (pool->key);
+  return worker == NULL ? pool->num_workers : worker->index;
+}
+
+/** Find a task in the own deque first and steal one otherwise.
+ * \return          True if a task has been found.
+ */
+static int
+sc_taskpool_find (sc_taskpool_t * pool, int self, sc_taskpool_task_t * task)
+{
+  const int           num_deques = pool->num_workers + 1;
+  int                 k;
+
+  if (SC_ATOMIC_LOAD (&pool->queued) <= 0) {
+    return 0;
+  }
+  if (sc_taskpool_deque_take (&pool->deques[self], self < num_deques - 1,
+                              task)) {
+    (void) SC_ATOMIC_FETCH_ADD (&pool->queued, -1L);
+    return 1;
+  }
+  for (k = 1; k < num_deques; ++k) {
+    if (sc_taskpool_deque_take (&pool->deques[(self + k) % num_deques],
+                                0, task)) {
+      (void) SC_ATOMIC_FETCH_ADD (&pool->queued, -1L);
+      return 1;
+    }
+  }
+  return 0;
+}
+
+/** Pin the thread of a worker to one processor of the process. */
+static void
+sc_taskpool_pin (sc_taskpool_worker_t * worker)
+{
+#ifdef SC_HAVE_PTHREAD_SETAFFINITY_NP
+  int                 cpu, count, n;
+  cpu_set_t           allowed, one;
+
+  if (sched_getaffinity (0, sizeof (allowed), &allowed) != 0 ||
+      (count = CPU_COUNT (&allowed)) <= 0) {
+    return;
+  }
+
+  /* the calling thread keeps the first processor */
+  n = (worker->index + 1) % count;
+  for (cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+    if (CPU_ISSET (cpu, &allowed) && n-- == 0) {
+      CPU_ZERO (&one);
+      CPU_SET (cpu, &one);
+      (void) pthread_setaffinity_np (worker->thread, sizeof (one), &one);
+      return;
+    }
+  }
+#endif
+}
+
+static void        *
+sc_taskpool_main (void *arg)
+{
+  sc_taskpool_worker_t *worker = (sc_taskpool_worker_t *) arg;
+  sc_taskpool_t      *pool = worker->pool;
+  sc_taskpool_task_t  task;
+  struct timespec     ts;
+
+  pthread_setspecific (pool->key, worker);
+  while (SC_ATOMIC_LOAD (&pool->running)) {
+    if (sc_taskpool_find (pool, worker->index, &task)) {
+      sc_taskpool_run (&task);
+      continue;
+    }
+
+    /* the timeout covers a wakeup missed between the check and the wait */
+    pthread_mutex_lock (&pool->mutex);
+    if (SC_ATOMIC_LOAD (&pool->running) &&
+        SC_ATOMIC_LOAD (&pool->queued) <= 0) {
+      clock_gettime (CLOCK_REALTIME, &ts);
+      ts.tv_nsec += 1000000L * SC_TASKPOOL_IDLE_MSEC;
+      ts.tv_sec += ts.tv_nsec / 1000000000L;
+      ts.tv_nsec %= 1000000000L;
+      SC_ATOMIC_STORE (&pool->sleeping, pool->sleeping + 1);
+      pthread_cond_timedwait (&pool->cond, &pool->mutex, &ts);
+      SC_ATOMIC_STORE (&pool->sleeping, pool->sleeping - 1);
+    }
+    pthread_mutex_unlock (&pool->mutex);
+  }
+  return NULL;
+}
+
+#endif /* SC_ENABLE_PTHREAD */
+
+void
+sc_taskgroup_init (sc_taskgroup_t * group)
+{
+  SC_ASSERT (group != NULL);
+  group->pending = 0;
+}
+
+sc_taskpool_t      *
+sc_taskpool_new (int num_threads, int pin)
+{
+  sc_taskpool_t      *pool;
+#ifdef SC_ENABLE_PTHREAD
+  int                 i, pth;
+  sc_taskpool_deque_t *dq;
+#endif
+
+  if (num_threads <= 0) {
+    num_threads = sc_thread_default_count ();
+  }
+  pool = SC_ALLOC_ZERO (sc_taskpool_t, 1);
+  pool->num_threads = num_threads;
+
+#ifdef SC_ENABLE_PTHREAD
+  pool->num_workers = num_threads - 1;
+  pool->running = 1;
+  pthread_mutex_init (&pool->mutex, NULL);
+  pthread_cond_init (&pool->cond, NULL);
+  pth = pthread_key_create (&pool->key, NULL);
+  SC_CHECK_ABORTF (pth == 0, "pthread_key_create %d failed", pth);
+  pool->deques = SC_ALLOC (sc_taskpool_deque_t, pool->num_workers + 1);
+  for (i = 0; i <= pool->num_workers; ++i) {
+    dq = &pool->deques[i];
+    pthread_mutex_init (&dq->mutex, NULL);
+    dq->size = SC_TASKPOOL_DEQUE_SIZE;
+    dq->tasks = SC_ALLOC (sc_taskpool_task_t, dq->size);
+    dq->head = dq->tail = 0;
+  }
+  pool->workers = SC_ALLOC (sc_taskpool_worker_t, pool->num_workers);
+  for (i = 0; i < pool->num_workers; ++i) {
+    pool->workers[i].pool = pool;
+    pool->workers[i].index = i;
+    pth = pthread_create (&pool->workers[i].thread, NULL,
+                          sc_taskpool_main, &pool->workers[i]);
+    SC_CHECK_ABORTF (pth == 0, "pthread_create %d failed", pth);
+    if (pin) {
+      sc_taskpool_pin (&pool->workers[i]);
+    }
+  }
+#endif
+
+  return pool;
+}
+
+void
+sc_taskpool_destroy (sc_taskpool_t * pool)
+{
+#ifdef SC_ENABLE_PTHREAD
+  int                 i, pth;
+#endif
+
+  SC_ASSERT (pool != NULL);
+
+#ifdef SC_ENABLE_PTHREAD
+  SC_ASSERT (pool->queued == 0);
+
+  pthread_mutex_lock (&pool->mutex);
+  SC_ATOMIC_STORE (&pool->running, 0);
+  pthread_cond_broadcast (&pool->cond);
+  pthread_mutex_unlock (&pool->mutex);
+  for (i = 0; i < pool->num_workers; ++i) {
+    pth = pthread_join (pool->workers[i].thread, NULL);
+    SC_CHECK_ABORTF (pth == 0, "pthread_join %d failed", pth);
+  }
+  SC_FREE (pool->workers);
+  for (i = 0; i <= pool->num_workers; ++i) {
+    SC_FREE (pool->deques[i].tasks);
+    pthread_mutex_destroy (&pool->deques[i].mutex);
+  }
+  SC_FREE (pool->deques);
+  pthread_key_delete (pool->key);
+  pthread_cond_destroy (&pool->cond);
+  pthread_mutex_destroy (&pool->mutex);
+#endif
+
+  SC_FREE (pool);
+}
+
+sc_taskpool_t      *
+sc_taskpool_get (void)
+{
+  int                 pin;
+  const char         *env;
+
+  SC_ASSERT (sc_is_initialized ());
+
+#ifdef SC_ENABLE_PTHREAD
+  pthread_mutex_lock (&sc_taskpool_global_mutex);
+#endif
+  if (sc_taskpool_global == NULL) {
+    env = getenv ("OMP_PROC_BIND");
+    pin = env != NULL && strcmp (env, "false") && strcmp (env, "FALSE");
+    sc_taskpool_global = sc_taskpool_new (0, pin);
+  }
+#ifdef SC_ENABLE_PTHREAD
+  pthread_mutex_unlock (&sc_taskpool_global_mutex);
+#endif
+
+  return sc_taskpool_global;
+}
+
+void
+sc_taskpool_free_global (void)
+{
+  if (sc_taskpool_global != NULL) {
+    sc_taskpool_destroy (sc_taskpool_global);
+    sc_taskpool_global = NULL;
+  }
+}
+
+int
+sc_taskpool_num_threads (sc_taskpool_t * pool)
+{
+  SC_ASSERT (pool != NULL);
+  return pool->num_threads;
+}
+
+void
+sc_taskpool_spawn (sc_taskpool_t * pool, sc_taskgroup_t * group,
+                   sc_taskpool_fn_t fn, void *user)
+{
+  sc_taskpool_task_t  task;
+
+  SC_ASSERT (pool != NULL);
+  SC_ASSERT (group != NULL);
+  SC_ASSERT (fn != NULL);
+
+  task.fn = fn;
+  task.user = user;
+  task.group = group;
+  (void) SC_ATOMIC_FETCH_ADD (&group->pending, 1L);
+
+#ifdef SC_ENABLE_PTHREAD
+  if (pool->num_workers > 0) {
+    sc_taskpool_deque_push (&pool->deques[sc_taskpool_self (pool)], &task);
+    (void) SC_ATOMIC_FETCH_ADD (&pool->queued, 1L);
+    if (SC_ATOMIC_LOAD (&pool->sleeping) > 0) {
+      pthread_mutex_lock (&pool->mutex);
+      pthread_cond_signal (&pool->cond);
+      pthread_mutex_unlock (&pool->mutex);
+    }
+    return;
+  }
+#endif
+
+  /* without workers the task is executed right away */
+  sc_taskpool_run (&task);
+}
+
+void
+sc_taskpool_wait (sc_taskpool_t * pool, sc_taskgroup_t * group)
+{
+#ifdef SC_ENABLE_PTHREAD
+  int                 self;
+  sc_taskpool_task_t  task;
+#endif
+
+  SC_ASSERT (pool != NULL);
+  SC_ASSERT (group != NULL);
+
+#ifdef SC_ENABLE_PTHREAD
+  self = sc_taskpool_self (pool);
+  while (SC_ATOMIC_LOAD (&group->pending) > 0) {
+    if (sc_taskpool_find (pool, self, &task)) {
+      sc_taskpool_run (&task);
+    }
+    else {
+      sched_yield ();
+    }
+  }
+#endif
+  SC_ASSERT (group->pending == 0);
+}
+
+/** A subrange of a parallel loop that is a task of its own. */
+typedef struct sc_taskpool_range
+{
+  sc_taskpool_t      *pool;
+  sc_taskgroup_t     *group;
+  size_t              begin, end, grain;
+  sc_taskpool_range_fn_t fn;
+  void               *user;
+}
+sc_taskpool_range_t;
+
+static void
+sc_taskpool_range (void *arg)
+{
+  sc_taskpool_range_t *range = (sc_taskpool_range_t *) arg;
+  sc_taskpool_range_t *half;
+
+  /* give away the upper halves and keep working on the lower one */
+  while (range->end - range->begin > range->grain) {
+    half = SC_ALLOC (sc_taskpool_range_t, 1);
+    *half = *range;
+    half->begin = range->begin + (range->end - range->begin) / 2;
+    range->end = half->begin;
+    sc_taskpool_spawn (range->pool, range->group, sc_taskpool_range, half);
+  }
+  range->fn (range->begin, range->end, range->user);
+  SC_FREE (range);
+}
+
+void
+sc_taskpool_parallel_for (sc_taskpool_t * pool, size_t begin, size_t end,
+                          size_t grain, sc_taskpool_range_fn_t fn,
+                          void *user)
+{
+  sc_taskgroup_t      group;
+  sc_taskpool_range_t *range;
+
+  SC_ASSERT (pool != NULL);
+  SC_ASSERT (begin <= end);
+  SC_ASSERT (fn != NULL);
+
+  if (begin == end) {
+    return;
+  }
+  sc_taskgroup_init (&group);
+  range = SC_ALLOC (sc_taskpool_range_t, 1);
+  range->pool = pool;
+  range->group = &group;
+  range->begin = begin;
+  range->end = end;
+  range->grain = SC_MAX (grain, 1);
+  range->fn = fn;
+  range->user = user;
+  sc_taskpool_spawn (pool, &group, sc_taskpool_range, range);
+  sc_taskpool_wait (pool, &group);
+}
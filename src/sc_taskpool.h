@@ -0,0 +1,147 @@
+/*
+  This file is part of the SC Library.
+  The SC Library provides support for parallel scientific applications.
+
+  Copyright (C) 2010 The University of Texas System
+  Additional copyright (C) 2011 individual authors
+
+  The SC Library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  The SC Library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with the SC Library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+  02110-1301, USA.
+*/
+
+#ifndef SC_TASKPOOL_H
+#define SC_TASKPOOL_H
+
+/** \file sc_taskpool.h
+ *
+ * A work-stealing task scheduler on a pool of threads.
+ *
+ * Every worker thread owns a deque of tasks.  It runs its own tasks in
+ * last-in first-out order and steals the oldest tasks of other workers
+ * when it runs out of work.  Threads outside of the pool share one more
+ * deque.  A thread waiting for a group of tasks executes tasks itself
+ * until the group is complete, so tasks may spawn and wait recursively.
+ *
+ * The pool is implemented with pthreads.  Without them all tasks are
+ * executed immediately by the spawning thread.
+ */
+
+#include <sc.h>
+
+SC_EXTERN_C_BEGIN;
+
+/** Opaque pool of threads. */
+typedef struct sc_taskpool sc_taskpool_t;
+
+/** A function that is executed as a task.
+ * \param [in,out] user     The pointer passed to \ref sc_taskpool_spawn.
+ */
+typedef void        (*sc_taskpool_fn_t) (void *user);
+
+/** A function called for each subrange by \ref sc_taskpool_parallel_for.
+ * \param [in] begin        First index of the subrange.
+ * \param [in] end          One past the last index, larger than \a begin.
+ * \param [in,out] user     The pointer passed to the parallel loop.
+ */
+typedef void        (*sc_taskpool_range_fn_t) (size_t begin, size_t end,
+                                               void *user);
+
+/** The tasks spawned into a group are waited for together.
+ * The members are internal and must not be accessed directly.
+ */
+typedef struct sc_taskgroup
+{
+  long                pending;  /**< Spawned tasks not yet finished. */
+}
+sc_taskgroup_t;
+
+/** Initialize an empty task group.
+ * \param [out] group       Group ready for \ref sc_taskpool_spawn.
+ */
+void                sc_taskgroup_init (sc_taskgroup_t * group);
+
+/** Create a pool of threads.
+ * \param [in] num_threads  The number of threads that execute tasks,
+ *                          including a thread that waits for a group.
+ *                          We start one worker less than this number.
+ *                          If not positive, we use
+ *                          \ref sc_thread_default_count.
+ * \param [in] pin          If true and supported, pin every worker to
+ *                          another processor out of the affinity mask of
+ *                          the process.  The calling thread is not pinned.
+ * \return                  A new pool to free by \ref sc_taskpool_destroy.
+ */
+sc_taskpool_t      *sc_taskpool_new (int num_threads, int pin);
+
+/** Join the worker threads and free the pool.
+ * \param [in] pool         No task of this pool must be pending.
+ */
+void                sc_taskpool_destroy (sc_taskpool_t * pool);
+
+/** Return the pool of the library, creating it on first use.
+ * The number of threads is \ref sc_thread_default_count, which honors
+ * OMP_NUM_THREADS.  The workers are pinned if OMP_PROC_BIND is set to
+ * a value other than false.  The pool is destroyed by \ref sc_finalize.
+ * \return                  The pool shared by all callers.
+ */
+sc_taskpool_t      *sc_taskpool_get (void);
+
+/** Return the number of threads of a pool, including the waiting one.
+ * \param [in] pool         Valid pool.
+ * \return                  The number of threads as created.
+ */
+int                 sc_taskpool_num_threads (sc_taskpool_t * pool);
+
+/** Queue a task for execution by any thread of the pool.
+ * This function may be called by the tasks themselves.
+ * \param [in,out] pool     Valid pool.
+ * \param [in,out] group    The task counts as pending in this group
+ *                          until it has returned.
+ * \param [in] fn           The function to execute.
+ * \param [in,out] user     Passed to \a fn.
+ */
+void                sc_taskpool_spawn (sc_taskpool_t * pool,
+                                       sc_taskgroup_t * group,
+                                       sc_taskpool_fn_t fn, void *user);
+
+/** Execute tasks until all tasks of a group have returned.
+ * Afterwards the group may be used for further tasks.
+ * \param [in,out] pool     Valid pool.
+ * \param [in,out] group    Group of tasks spawned into \a pool.
+ */
+void                sc_taskpool_wait (sc_taskpool_t * pool,
+                                      sc_taskgroup_t * group);
+
+/** Call a function for subranges of an index range in parallel.
+ * The range is split recursively in halves until the pieces are no
+ * larger than the grain size.  Each half is a task and may be stolen.
+ * We return when the function has been called for all subranges.
+ * \param [in,out] pool     Valid pool.
+ * \param [in] begin        First index.
+ * \param [in] end          One past the last index.  May equal \a begin.
+ * \param [in] grain        No subrange is larger than this.
+ *                          A value of 0 is treated as 1.
+ * \param [in] fn           Called once for every subrange.
+ * \param [in,out] user     Passed to \a fn.
+ */
+void                sc_taskpool_parallel_for (sc_taskpool_t * pool,
+                                              size_t begin, size_t end,
+                                              size_t grain,
+                                              sc_taskpool_range_fn_t fn,
+                                              void *user);
+
+SC_EXTERN_C_END;
+
+#endif /* !SC_TASKPOOL_H */
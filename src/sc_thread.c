@@ -0,0 +1,118 @@
+/*
+  This file is part of the SC Library.
+  The SC Library provides support for parallel scientific applications.
+
+  Copyright (C) 2010 The University of Texas System
+  Additional copyright (C) 2011 individual authors
+
+  The SC Library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  The SC Library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with the SC Library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+  02110-1301, USA.
+*/
+
+#include <sc_thread.h>
+#ifdef SC_ENABLE_OPENMP
+#include <omp.h>
+#elif defined SC_ENABLE_PTHREAD
+#include <pthread.h>
+#endif
+
+#if !defined SC_ENABLE_OPENMP && defined SC_ENABLE_PTHREAD
+
+/** The arguments of one thread started by pthread_create. */
+typedef struct sc_thread_job
+{
+  sc_thread_fn_t      fn;
+  int                 thread_id;
+  int                 num_threads;
+  void               *user;
+}
+sc_thread_job_t;
+
+static void        *
+sc_thread_start (void *arg)
+{
+  sc_thread_job_t    *job = (sc_thread_job_t *) arg;
+
+  job->fn (job->thread_id, job->num_threads, job->user);
+  return NULL;
+}
+
+#endif
+
+int
+sc_thread_default_count (void)
+{
+#ifdef SC_ENABLE_OPENMP
+  return SC_MAX (omp_get_max_threads (), 1);
+#else
+  const char         *env = getenv ("OMP_NUM_THREADS");
+
+  /* the variable may contain a comma-separated list for nested levels */
+  return env == NULL ? 1 : SC_MAX (sc_atoi (env), 1);
+#endif
+}
+
+void
+sc_thread_fork_join (int num_threads, sc_thread_fn_t fn, void *user)
+{
+  if (num_threads <= 0) {
+    num_threads = sc_thread_default_count ();
+  }
+  if (num_threads == 1) {
+    fn (0, 1, user);
+    return;
+  }
+
+#ifdef SC_ENABLE_OPENMP
+#pragma omp parallel num_threads (num_threads)
+  {
+    fn (omp_get_thread_num (), omp_get_num_threads (), user);
+  }
+#elif defined SC_ENABLE_PTHREAD
+  {
+    int                 i, pth;
+    pthread_t          *threads;
+    sc_thread_job_t    *jobs;
+
+    threads = SC_ALLOC (pthread_t, num_threads);
+    jobs = SC_ALLOC (sc_thread_job_t, num_threads);
+    for (i = 0; i < num_threads; ++i) {
+      jobs[i].fn = fn;
+      jobs[i].thread_id = i;
+      jobs[i].num_threads = num_threads;
+      jobs[i].user = user;
+    }
+    for (i = 1; i < num_threads; ++i) {
+      pth = pthread_create (&threads[i], NULL, sc_thread_start, &jobs[i]);
+      SC_CHECK_ABORTF (pth == 0, "pthread_create %d failed", pth);
+    }
+    fn (0, num_threads, user);
+    for (i = 1; i < num_threads; ++i) {
+      pth = pthread_join (threads[i], NULL);
+      SC_CHECK_ABORTF (pth == 0, "pthread_join %d failed", pth);
+    }
+    SC_FREE (jobs);
+    SC_FREE (threads);
+  }
+#else
+  {
+    int                 i;
+
+    for (i = 0; i < num_threads; ++i) {
+      fn (i, num_threads, user);
+    }
+  }
+#endif
+}
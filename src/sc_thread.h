@@ -0,0 +1,69 @@
+/*
+  This file is part of the SC Library.
+  The SC Library provides support for parallel scientific applications.
+
+  Copyright (C) 2010 The University of Texas System
+  Additional copyright (C) 2011 individual authors
+
+  The SC Library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  The SC Library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with the SC Library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+  02110-1301, USA.
+*/
+
+#ifndef SC_THREAD_H
+#define SC_THREAD_H
+
+/** \file sc_thread.h
+ *
+ * Minimal fork-join parallelism within one process.
+ *
+ * If libsc is configured with OpenMP, we run the threads in an OpenMP
+ * parallel region.  Otherwise we use pthreads if they are enabled, and
+ * without either we call the thread function for each thread in turn.
+ * Thus the threads of one fork-join call must never wait for each other.
+ */
+
+#include <sc.h>
+
+SC_EXTERN_C_BEGIN;
+
+/** The function executed by each thread of \ref sc_thread_fork_join.
+ * \param [in] thread_id    Number of this thread, from 0 to num_threads - 1.
+ * \param [in] num_threads  The number of threads actually running.
+ * \param [in,out] user     The user data passed to the fork-join call.
+ */
+typedef void        (*sc_thread_fn_t) (int thread_id, int num_threads,
+                                       void *user);
+
+/** Return the number of threads to use if none is given explicitly.
+ * With OpenMP this is omp_get_max_threads ().  Otherwise we read the first
+ * number in the environment variable OMP_NUM_THREADS and default to 1.
+ * \return              A positive number of threads.
+ */
+int                 sc_thread_default_count (void);
+
+/** Run a function on a set of threads and wait until all are done.
+ * The calling thread takes part as the thread of number 0.
+ * \param [in] num_threads  The number of threads to run.  If not positive,
+ *                          we use \ref sc_thread_default_count.
+ *                          OpenMP may provide fewer threads than requested.
+ * \param [in] fn           Function called once per thread.
+ * \param [in,out] user     Passed to every call of \b fn.
+ */
+void                sc_thread_fork_join (int num_threads, sc_thread_fn_t fn,
+                                         void *user);
+
+SC_EXTERN_C_END;
+
+#endif /* !SC_THREAD_H */
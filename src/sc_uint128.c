@@ -29,231 +29,132 @@
 
 #include <sc_uint128.h>
 
-void
-sc_uint128_init (sc_uint128_t * input, uint64_t high, uint64_t low)
+int
+sc_uint128_compare (const void *va, const void *vb)
 {
-  SC_ASSERT (input != NULL);
-  input->high_bits = high;
-  input->low_bits = low;
+  return sc_uint128_compare_inline (va, vb);
 }
 
 int
-sc_uint128_chk_bit (const sc_uint128_t * input, int exponent)
+sc_uint128_is_equal (const sc_uint128_t * a, const sc_uint128_t * b)
 {
-  SC_ASSERT (input != NULL);
-  SC_ASSERT (exponent >= 0);
-
-  if (exponent < 64) {
-    /* returns 0 or 1 according to the C99 standard */
-    return (input->low_bits & ((uint64_t) 1) << exponent) != 0;
-  }
-  else {
-    SC_ASSERT (exponent < 128);
-    return (input->high_bits & ((uint64_t) 1) << (exponent - 64)) != 0;
-  }
+  return sc_uint128_is_equal_inline (a, b);
 }
 
 void
-sc_uint128_set_bit (sc_uint128_t * input, int exponent)
+sc_uint128_init (sc_uint128_t * a, uint64_t high, uint64_t low)
 {
-  SC_ASSERT (input != NULL);
-  SC_ASSERT (exponent >= 0);
-
-  if (exponent < 64) {
-    input->low_bits |= ((uint64_t) 1) << exponent;
-  }
-  else {
-    SC_ASSERT (exponent < 128);
-    input->high_bits |= ((uint64_t) 1) << (exponent - 64);
-  }
+  sc_uint128_init_inline (a, high, low);
 }
 
-void
-sc_uint128_copy (const sc_uint128_t * input, sc_uint128_t * output)
+int
+sc_uint128_chk_bit (const sc_uint128_t * input, int exponent)
 {
-  SC_ASSERT (input != NULL && output != NULL);
-  output->high_bits = input->high_bits;
-  output->low_bits = input->low_bits;
+  return sc_uint128_chk_bit_inline (input, exponent);
 }
 
-int
-sc_uint128_is_equal (const sc_uint128_t * a, const sc_uint128_t * b)
+void
+sc_uint128_set_bit (sc_uint128_t * a, int exponent)
 {
-  SC_ASSERT (a != NULL && b != NULL);
-  return a->high_bits == b->high_bits && a->low_bits == b->low_bits;
+  sc_uint128_set_bit_inline (a, exponent);
 }
 
-int
-sc_uint128_compare (const void *va, const void *vb)
+void
+sc_uint128_copy (const sc_uint128_t * input, sc_uint128_t * output)
 {
-  SC_ASSERT (va != NULL && vb != NULL);
-  const sc_uint128_t *a = (sc_uint128_t *) va;
-  const sc_uint128_t *b = (sc_uint128_t *) vb;
-
-  if (a->high_bits < b->high_bits) {
-    return -1;
-  }
-  else if (a->high_bits > b->high_bits) {
-    return 1;
-  }
-  else if (a->low_bits < b->low_bits) {
-    return -1;
-  }
-  else if (a->low_bits > b->low_bits) {
-    return 1;
-  }
-  return 0;
+  sc_uint128_copy_inline (input, output);
 }
 
 void
 sc_uint128_add (const sc_uint128_t * a, const sc_uint128_t * b,
                 sc_uint128_t * result)
 {
-  SC_ASSERT (a != NULL && b != NULL && result != NULL);
-  SC_ASSERT (result != a && result != b);
-  result->high_bits = a->high_bits + b->high_bits;
-  result->low_bits = a->low_bits + b->low_bits;
-  if (result->low_bits < a->low_bits) {
-    ++result->high_bits;
-  }
+  sc_uint128_add_inline (a, b, result);
 }
 
- /* we assume result >= 0 and calculate a - b */
 void
 sc_uint128_sub (const sc_uint128_t * a, const sc_uint128_t * b,
                 sc_uint128_t * result)
 {
-  SC_ASSERT (a != NULL && b != NULL && result != NULL);
-  SC_ASSERT (result != a && result != b);
-  result->high_bits = a->high_bits - b->high_bits;
-  result->low_bits = a->low_bits - b->low_bits;
-  if (a->low_bits < result->low_bits) {
-    --result->high_bits;
-  }
+  sc_uint128_sub_inline (a, b, result);
 }
 
 void
 sc_uint128_bitwise_neg (const sc_uint128_t * a, sc_uint128_t * result)
 {
-  SC_ASSERT (a != NULL && result != NULL);
-  result->high_bits = ~a->high_bits;
-  result->low_bits = ~a->low_bits;
+  sc_uint128_bitwise_neg_inline (a, result);
 }
 
 void
 sc_uint128_bitwise_or (const sc_uint128_t * a, const sc_uint128_t * b,
                        sc_uint128_t * result)
 {
-  SC_ASSERT (a != NULL && b != NULL && result != NULL);
-  result->high_bits = a->high_bits | b->high_bits;
-  result->low_bits = a->low_bits | b->low_bits;
+  sc_uint128_bitwise_or_inline (a, b, result);
 }
 
 void
 sc_uint128_bitwise_and (const sc_uint128_t * a, const sc_uint128_t * b,
                         sc_uint128_t * result)
 {
-  SC_ASSERT (a != NULL && b != NULL && result != NULL);
-  result->high_bits = a->high_bits & b->high_bits;
-  result->low_bits = a->low_bits & b->low_bits;
+  sc_uint128_bitwise_and_inline (a, b, result);
 }
 
 void
 sc_uint128_shift_right (const sc_uint128_t * input, int shift_count,
                         sc_uint128_t * result)
 {
-  SC_ASSERT (input != NULL && result != NULL);
-  SC_ASSERT (shift_count >= 0);
-  if (shift_count >= 128) {
-    result->high_bits = 0;
-    result->low_bits = 0;
-    return;
-  }
-
-  result->high_bits = input->high_bits;
-  result->low_bits = input->low_bits;
-  if (shift_count == 0)
-    return;
-
-  if (shift_count >= 64) {
-    result->low_bits = input->high_bits;
-    result->high_bits = 0;
-    result->low_bits >>= (shift_count - 64);
-  }
-  else {
-    result->low_bits =
-      (result->high_bits << (64 - shift_count)) |
-      (input->low_bits >> shift_count);
-    result->high_bits >>= shift_count;
-  }
+  sc_uint128_shift_right_inline (input, shift_count, result);
 }
 
 void
 sc_uint128_shift_left (const sc_uint128_t * input, int shift_count,
                        sc_uint128_t * result)
 {
-  SC_ASSERT (input != NULL && result != NULL);
-  SC_ASSERT (shift_count >= 0);
-  if (shift_count >= 128) {
-    result->high_bits = 0;
-    result->low_bits = 0;
-    return;
-  }
-
-  result->high_bits = input->high_bits;
-  result->low_bits = input->low_bits;
-  if (shift_count == 0)
-    return;
-
-  if (shift_count >= 64) {
-    result->high_bits = input->low_bits;
-    result->low_bits = 0;
-    result->high_bits <<= (shift_count - 64);
-  }
-  else {
-    result->high_bits =
-      (result->high_bits << shift_count) | (input->
-                                            low_bits >> (64 - shift_count));
-    result->low_bits <<= shift_count;
-  }
+  sc_uint128_shift_left_inline (input, shift_count, result);
 }
 
 void
 sc_uint128_add_inplace (sc_uint128_t * a, const sc_uint128_t * b)
 {
-  SC_ASSERT (a != NULL && b != NULL);
-  uint64_t            temp = a->low_bits;
-  a->high_bits += b->high_bits;
-  a->low_bits += b->low_bits;
-  if (a->low_bits < temp) {
-    ++a->high_bits;
-  }
+  sc_uint128_add_inplace_inline (a, b);
 }
 
 void
 sc_uint128_sub_inplace (sc_uint128_t * a, const sc_uint128_t * b)
 {
-  SC_ASSERT (a != NULL && b != NULL);
-  uint64_t            temp = a->low_bits;
-  a->high_bits -= b->high_bits;
-  a->low_bits -= b->low_bits;
-  if (temp < a->low_bits) {
-    --a->high_bits;
-  }
+  sc_uint128_sub_inplace_inline (a, b);
 }
 
 void
 sc_uint128_bitwise_or_inplace (sc_uint128_t * a, const sc_uint128_t * b)
 {
-  SC_ASSERT (a != NULL && b != NULL);
-  a->low_bits |= b->low_bits;
-  a->high_bits |= b->high_bits;
+  sc_uint128_bitwise_or_inplace_inline (a, b);
 }
 
 void
 sc_uint128_bitwise_and_inplace (sc_uint128_t * a, const sc_uint128_t * b)
 {
-  SC_ASSERT (a != NULL && b != NULL);
-  a->high_bits &= b->high_bits;
-  a->low_bits &= b->low_bits;
+  sc_uint128_bitwise_and_inplace_inline (a, b);
+}
+
+void
+sc_uint128_interleave (const uint64_t * coords, int num_coords, int bits,
+                       sc_uint128_t * result)
+{
+  int                 b, c;
+  sc_uint128_t        bit;
+
+  SC_ASSERT (coords != NULL && result != NULL);
+  SC_ASSERT (num_coords >= 1 && bits >= 0);
+  SC_ASSERT (bits * num_coords <= 128);
+
+  /* shift in one group of coordinate bits at a time, highest first */
+  sc_uint128_init_inline (result, 0, 0);
+  for (b = bits - 1; b >= 0; --b) {
+    for (c = num_coords - 1; c >= 0; --c) {
+      sc_uint128_shift_left_inplace (result, 1);
+      sc_uint128_init_inline (&bit, 0, (coords[c] >> b) & 1);
+      sc_uint128_bitwise_or_inplace_inline (result, &bit);
+    }
+  }
 }
@@ -34,10 +34,22 @@
  *
  * Routines for managing unsigned 128 bit integers.
  * We do this to have a portable way on systems that have no native support.
+ * Every routine exported by the library has an inline version of the same
+ * name with the suffix _inline for use in hot loops.  The newer routines
+ * are inline only.  If the compiler provides unsigned __int128 and
+ * SC_UINT128_PORTABLE is not defined, the arithmetic uses it and otherwise
+ * carries between the two 64 bit words explicitly.
  */
 
 #include <sc.h>
 
+#if defined __SIZEOF_INT128__ && !defined SC_UINT128_PORTABLE
+/** Defined if the routines use the native 128 bit type of the compiler. */
+#define SC_UINT128_NATIVE 1
+#endif
+
+SC_EXTERN_C_BEGIN;
+
 /** An unsigned 128 bit integer represented as two uint64_t. */
 typedef struct sc_uint128
 {
@@ -46,6 +58,28 @@ typedef struct sc_uint128
 }
 sc_uint128_t;
 
+#ifdef SC_UINT128_NATIVE
+
+/** The native unsigned 128 bit type of the compiler. */
+__extension__ typedef unsigned __int128 sc_uint128_native_t;
+
+/** Convert to the native type. */
+static inline       sc_uint128_native_t
+sc_uint128_to_native (const sc_uint128_t * a)
+{
+  return ((sc_uint128_native_t) a->high_bits << 64) | a->low_bits;
+}
+
+/** Convert from the native type. */
+static inline void
+sc_uint128_from_native (sc_uint128_t * a, sc_uint128_native_t n)
+{
+  a->high_bits = (uint64_t) (n >> 64);
+  a->low_bits = (uint64_t) n;
+}
+
+#endif /* SC_UINT128_NATIVE */
+
 /** Compare the sc_uint128_t \a a and the sc_uint128_t \a b.
  * \param [in]  a A pointer to a sc_uint128_t.
  * \param [in]  b A pointer to a sc_uint128_t.
@@ -55,6 +89,20 @@ sc_uint128_t;
  */
 int                 sc_uint128_compare (const void *a, const void *b);
 
+/** Inline version of \ref sc_uint128_compare. */
+static inline int
+sc_uint128_compare_inline (const void *va, const void *vb)
+{
+  const sc_uint128_t *a = (const sc_uint128_t *) va;
+  const sc_uint128_t *b = (const sc_uint128_t *) vb;
+
+  SC_ASSERT (va != NULL && vb != NULL);
+  if (a->high_bits != b->high_bits) {
+    return a->high_bits < b->high_bits ? -1 : 1;
+  }
+  return (a->low_bits > b->low_bits) - (a->low_bits < b->low_bits);
+}
+
 /** Checks if the sc_uint128_t \a a and the sc_uint128_t \a b are equal.
  * \param [in]  a A pointer to a sc_uint128_t.
  * \param [in]  b A pointer to a sc_uint128_t.
@@ -64,6 +112,14 @@ int                 sc_uint128_compare (const void *a, const void *b);
 int                 sc_uint128_is_equal (const sc_uint128_t * a,
                                          const sc_uint128_t * b);
 
+/** Inline version of \ref sc_uint128_is_equal. */
+static inline int
+sc_uint128_is_equal_inline (const sc_uint128_t * a, const sc_uint128_t * b)
+{
+  SC_ASSERT (a != NULL && b != NULL);
+  return a->high_bits == b->high_bits && a->low_bits == b->low_bits;
+}
+
 /** Initializes an unsigned 128 bit integer to a given value.
  * \param [in,out] a        A pointer to the sc_uint128_t that will be
  *                          initialized.
@@ -73,6 +129,15 @@ int                 sc_uint128_is_equal (const sc_uint128_t * a,
 void                sc_uint128_init (sc_uint128_t * a,
                                      uint64_t high, uint64_t low);
 
+/** Inline version of \ref sc_uint128_init. */
+static inline void
+sc_uint128_init_inline (sc_uint128_t * a, uint64_t high, uint64_t low)
+{
+  SC_ASSERT (a != NULL);
+  a->high_bits = high;
+  a->low_bits = low;
+}
+
 /** Returns the bit_number-th bit of \a input.
  * This function checks a bit of an existing, initialized value.
  * \param [in]     input      A pointer to a sc_uint128_t.
@@ -84,6 +149,20 @@ void                sc_uint128_init (sc_uint128_t * a,
 int                 sc_uint128_chk_bit (const sc_uint128_t * input,
                                         int exponent);
 
+/** Inline version of \ref sc_uint128_chk_bit. */
+static inline int
+sc_uint128_chk_bit_inline (const sc_uint128_t * input, int exponent)
+{
+  SC_ASSERT (input != NULL);
+  SC_ASSERT (0 <= exponent && exponent < 128);
+
+  if (exponent < 64) {
+    /* returns 0 or 1 according to the C99 standard */
+    return (input->low_bits & ((uint64_t) 1) << exponent) != 0;
+  }
+  return (input->high_bits & ((uint64_t) 1) << (exponent - 64)) != 0;
+}
+
 /** Sets the exponent-th bit of \a a to one and keep all other bits.
  * This function modifies an existing, initialized value.
  * \param [in,out] a        A pointer to a sc_uint128_t.
@@ -93,6 +172,21 @@ int                 sc_uint128_chk_bit (const sc_uint128_t * input,
  */
 void                sc_uint128_set_bit (sc_uint128_t * a, int exponent);
 
+/** Inline version of \ref sc_uint128_set_bit. */
+static inline void
+sc_uint128_set_bit_inline (sc_uint128_t * a, int exponent)
+{
+  SC_ASSERT (a != NULL);
+  SC_ASSERT (0 <= exponent && exponent < 128);
+
+  if (exponent < 64) {
+    a->low_bits |= ((uint64_t) 1) << exponent;
+  }
+  else {
+    a->high_bits |= ((uint64_t) 1) << (exponent - 64);
+  }
+}
+
 /** Copies an initialized sc_uint128_t to a sc_uint128_t.
  * \param [in]     input    A pointer to the sc_uint128 that is copied.
  * \param [in,out] output   A pointer to a sc_uint128_t.
@@ -103,6 +197,15 @@ void                sc_uint128_set_bit (sc_uint128_t * a, int exponent);
 void                sc_uint128_copy (const sc_uint128_t * input,
                                      sc_uint128_t * output);
 
+/** Inline version of \ref sc_uint128_copy. */
+static inline void
+sc_uint128_copy_inline (const sc_uint128_t * input, sc_uint128_t * output)
+{
+  SC_ASSERT (input != NULL && output != NULL);
+  output->high_bits = input->high_bits;
+  output->low_bits = input->low_bits;
+}
+
 /** Adds the uint128_t \a b to the uint128_t \a a.
  * \a result == \a a or \a result == \a b is not allowed.
  * \a a == \a b is allowed.
@@ -115,6 +218,25 @@ void                sc_uint128_add (const sc_uint128_t * a,
                                     const sc_uint128_t * b,
                                     sc_uint128_t * result);
 
+/** Inline version of \ref sc_uint128_add. */
+static inline void
+sc_uint128_add_inline (const sc_uint128_t * a, const sc_uint128_t * b,
+                       sc_uint128_t * result)
+{
+  SC_ASSERT (a != NULL && b != NULL && result != NULL);
+  SC_ASSERT (result != a && result != b);
+#ifdef SC_UINT128_NATIVE
+  sc_uint128_from_native (result, sc_uint128_to_native (a) +
+                          sc_uint128_to_native (b));
+#else
+  result->high_bits = a->high_bits + b->high_bits;
+  result->low_bits = a->low_bits + b->low_bits;
+  if (result->low_bits < a->low_bits) {
+    ++result->high_bits;
+  }
+#endif
+}
+
 /** Subtracts the uint128_t \a b from the uint128_t \a a.
  * This function assumes that the result is >= 0.
  * \a result == \a a or \a result == \a b is not allowed.
@@ -128,6 +250,25 @@ void                sc_uint128_sub (const sc_uint128_t * a,
                                     const sc_uint128_t * b,
                                     sc_uint128_t * result);
 
+/** Inline version of \ref sc_uint128_sub. */
+static inline void
+sc_uint128_sub_inline (const sc_uint128_t * a, const sc_uint128_t * b,
+                       sc_uint128_t * result)
+{
+  SC_ASSERT (a != NULL && b != NULL && result != NULL);
+  SC_ASSERT (result != a && result != b);
+#ifdef SC_UINT128_NATIVE
+  sc_uint128_from_native (result, sc_uint128_to_native (a) -
+                          sc_uint128_to_native (b));
+#else
+  result->high_bits = a->high_bits - b->high_bits;
+  result->low_bits = a->low_bits - b->low_bits;
+  if (a->low_bits < result->low_bits) {
+    --result->high_bits;
+  }
+#endif
+}
+
 /** Calculates the bitwise negation of the uint128_t \a a.
  * \a a == \a result is allowed.
  * \param[in]  a        A pointer to a sc_uint128_t.
@@ -138,6 +279,15 @@ void                sc_uint128_sub (const sc_uint128_t * a,
 void                sc_uint128_bitwise_neg (const sc_uint128_t * a,
                                             sc_uint128_t * result);
 
+/** Inline version of \ref sc_uint128_bitwise_neg. */
+static inline void
+sc_uint128_bitwise_neg_inline (const sc_uint128_t * a, sc_uint128_t * result)
+{
+  SC_ASSERT (a != NULL && result != NULL);
+  result->high_bits = ~a->high_bits;
+  result->low_bits = ~a->low_bits;
+}
+
 /** Calculates the bitwise or of the uint128_t \a a and \a b.
  * \a a == \a result is allowed. Furthermore, \a a == \a result
  * and/or \a b == \a result is allowed.
@@ -151,6 +301,16 @@ void                sc_uint128_bitwise_or (const sc_uint128_t * a,
                                            const sc_uint128_t * b,
                                            sc_uint128_t * result);
 
+/** Inline version of \ref sc_uint128_bitwise_or. */
+static inline void
+sc_uint128_bitwise_or_inline (const sc_uint128_t * a, const sc_uint128_t * b,
+                              sc_uint128_t * result)
+{
+  SC_ASSERT (a != NULL && b != NULL && result != NULL);
+  result->high_bits = a->high_bits | b->high_bits;
+  result->low_bits = a->low_bits | b->low_bits;
+}
+
 /** Calculates the bitwise and of the uint128_t \a a and the uint128_t \a b.
  * \a a == \a result is allowed. Furthermore, \a a == \a result
  * and/or \a b == \a result is allowed.
@@ -164,6 +324,16 @@ void                sc_uint128_bitwise_and (const sc_uint128_t * a,
                                             const sc_uint128_t * b,
                                             sc_uint128_t * result);
 
+/** Inline version of \ref sc_uint128_bitwise_and. */
+static inline void
+sc_uint128_bitwise_and_inline (const sc_uint128_t * a, const sc_uint128_t * b,
+                               sc_uint128_t * result)
+{
+  SC_ASSERT (a != NULL && b != NULL && result != NULL);
+  result->high_bits = a->high_bits & b->high_bits;
+  result->low_bits = a->low_bits & b->low_bits;
+}
+
 /** Calculates the bit right shift of uint128_t \a input by shift_count bits.
  * We shift in zeros from the left. If \a shift_count >= 128, \a result is 0.
  * All bits right from the zeroth bit (counted from the right hand side)
@@ -178,6 +348,37 @@ void                sc_uint128_shift_right (const sc_uint128_t * input,
                                             int shift_count,
                                             sc_uint128_t * result);
 
+/** Inline version of \ref sc_uint128_shift_right. */
+static inline void
+sc_uint128_shift_right_inline (const sc_uint128_t * input, int shift_count,
+                               sc_uint128_t * result)
+{
+  SC_ASSERT (input != NULL && result != NULL);
+  SC_ASSERT (shift_count >= 0);
+  if (shift_count >= 128) {
+    result->high_bits = 0;
+    result->low_bits = 0;
+    return;
+  }
+#ifdef SC_UINT128_NATIVE
+  sc_uint128_from_native (result, sc_uint128_to_native (input)
+                          >> shift_count);
+#else
+  if (shift_count >= 64) {
+    result->low_bits = input->high_bits >> (shift_count - 64);
+    result->high_bits = 0;
+  }
+  else if (shift_count > 0) {
+    result->low_bits = (input->high_bits << (64 - shift_count)) |
+      (input->low_bits >> shift_count);
+    result->high_bits = input->high_bits >> shift_count;
+  }
+  else {
+    *result = *input;
+  }
+#endif
+}
+
 /** Calculates the bit left shift of uint128_t \a input by shift_count bits.
  * We shift in zeros from the right. If \a shift_count >= 128, \a result is 0.
  * All bits left from the 127th bit (counted zero based from the right
@@ -192,6 +393,37 @@ void                sc_uint128_shift_left (const sc_uint128_t * input,
                                            int shift_count,
                                            sc_uint128_t * result);
 
+/** Inline version of \ref sc_uint128_shift_left. */
+static inline void
+sc_uint128_shift_left_inline (const sc_uint128_t * input, int shift_count,
+                              sc_uint128_t * result)
+{
+  SC_ASSERT (input != NULL && result != NULL);
+  SC_ASSERT (shift_count >= 0);
+  if (shift_count >= 128) {
+    result->high_bits = 0;
+    result->low_bits = 0;
+    return;
+  }
+#ifdef SC_UINT128_NATIVE
+  sc_uint128_from_native (result, sc_uint128_to_native (input)
+                          << shift_count);
+#else
+  if (shift_count >= 64) {
+    result->high_bits = input->low_bits << (shift_count - 64);
+    result->low_bits = 0;
+  }
+  else if (shift_count > 0) {
+    result->high_bits = (input->high_bits << shift_count) |
+      (input->low_bits >> (64 - shift_count));
+    result->low_bits = input->low_bits << shift_count;
+  }
+  else {
+    *result = *input;
+  }
+#endif
+}
+
 /** Adds the uint128 \a b to the uint128_t \a a.
  * The result is saved in \a a. \a a == \a b is allowed.
  * \param [in, out] a   A pointer to a sc_uint128_t. \a a
@@ -201,6 +433,27 @@ void                sc_uint128_shift_left (const sc_uint128_t * input,
 void                sc_uint128_add_inplace (sc_uint128_t * a,
                                             const sc_uint128_t * b);
 
+/** Inline version of \ref sc_uint128_add_inplace. */
+static inline void
+sc_uint128_add_inplace_inline (sc_uint128_t * a, const sc_uint128_t * b)
+{
+  SC_ASSERT (a != NULL && b != NULL);
+#ifdef SC_UINT128_NATIVE
+  sc_uint128_from_native (a, sc_uint128_to_native (a) +
+                          sc_uint128_to_native (b));
+#else
+  {
+    const uint64_t      temp = a->low_bits;
+
+    a->high_bits += b->high_bits;
+    a->low_bits += b->low_bits;
+    if (a->low_bits < temp) {
+      ++a->high_bits;
+    }
+  }
+#endif
+}
+
 /** Subtracts the uint128_t \a b from the uint128_t \a a.
  * The result is saved in \a a. \a a == \a b is allowed.
  * This function assumes that the result is >= 0.
@@ -211,6 +464,27 @@ void                sc_uint128_add_inplace (sc_uint128_t * a,
 void                sc_uint128_sub_inplace (sc_uint128_t * a,
                                             const sc_uint128_t * b);
 
+/** Inline version of \ref sc_uint128_sub_inplace. */
+static inline void
+sc_uint128_sub_inplace_inline (sc_uint128_t * a, const sc_uint128_t * b)
+{
+  SC_ASSERT (a != NULL && b != NULL);
+#ifdef SC_UINT128_NATIVE
+  sc_uint128_from_native (a, sc_uint128_to_native (a) -
+                          sc_uint128_to_native (b));
+#else
+  {
+    const uint64_t      temp = a->low_bits;
+
+    a->high_bits -= b->high_bits;
+    a->low_bits -= b->low_bits;
+    if (temp < a->low_bits) {
+      --a->high_bits;
+    }
+  }
+#endif
+}
+
 /** Calculates the bitwise or of the uint128_t \a a and the uint128_t \a b.
  * \a a == \a b is allowed.
  * \param [in,out]  a   A pointer to a sc_uint128_t.
@@ -220,6 +494,15 @@ void                sc_uint128_sub_inplace (sc_uint128_t * a,
 void                sc_uint128_bitwise_or_inplace (sc_uint128_t * a,
                                                    const sc_uint128_t * b);
 
+/** Inline version of \ref sc_uint128_bitwise_or_inplace. */
+static inline void
+sc_uint128_bitwise_or_inplace_inline (sc_uint128_t * a, const sc_uint128_t * b)
+{
+  SC_ASSERT (a != NULL && b != NULL);
+  a->high_bits |= b->high_bits;
+  a->low_bits |= b->low_bits;
+}
+
 /** Calculates the bitwise and of the uint128_t \a a and the uint128_t \a b.
  * \a a == \a b is allowed.
  * \param [in,out]  a   A pointer to a sc_uint128_t.
@@ -229,4 +512,107 @@ void                sc_uint128_bitwise_or_inplace (sc_uint128_t * a,
 void                sc_uint128_bitwise_and_inplace (sc_uint128_t * a,
                                                     const sc_uint128_t * b);
 
+/** Inline version of \ref sc_uint128_bitwise_and_inplace. */
+static inline void
+sc_uint128_bitwise_and_inplace_inline (sc_uint128_t * a,
+                                       const sc_uint128_t * b)
+{
+  SC_ASSERT (a != NULL && b != NULL);
+  a->high_bits &= b->high_bits;
+  a->low_bits &= b->low_bits;
+}
+
+/** Calculates the bit right shift of \a a by shift_count bits in place.
+ * \param [in,out]  a           A pointer to a sc_uint128_t.
+ * \param [in]      shift_count Bits to shift. \a shift_count >= 0.
+ *                              See \ref sc_uint128_shift_right.
+ */
+static inline void
+sc_uint128_shift_right_inplace (sc_uint128_t * a, int shift_count)
+{
+  sc_uint128_shift_right_inline (a, shift_count, a);
+}
+
+/** Calculates the bit left shift of \a a by shift_count bits in place.
+ * \param [in,out]  a           A pointer to a sc_uint128_t.
+ * \param [in]      shift_count Bits to shift. \a shift_count >= 0.
+ *                              See \ref sc_uint128_shift_left.
+ */
+static inline void
+sc_uint128_shift_left_inplace (sc_uint128_t * a, int shift_count)
+{
+  sc_uint128_shift_left_inline (a, shift_count, a);
+}
+
+/** Computes the full 128 bit product of two 64 bit unsigned integers.
+ * \param [in]  a       A 64 bit factor.
+ * \param [in]  b       A 64 bit factor.
+ * \param[out]  result  A pointer to a sc_uint128_t.
+ *                      The product \a a * \a b will be saved in \a result.
+ */
+static inline void
+sc_uint128_mul_64 (uint64_t a, uint64_t b, sc_uint128_t * result)
+{
+  SC_ASSERT (result != NULL);
+#ifdef SC_UINT128_NATIVE
+  sc_uint128_from_native (result, (sc_uint128_native_t) a * b);
+#else
+  {
+    /* schoolbook multiplication of 32 bit halves */
+    const uint64_t      al = a & 0xffffffffU, ah = a >> 32;
+    const uint64_t      bl = b & 0xffffffffU, bh = b >> 32;
+    const uint64_t      ll = al * bl, lh = al * bh;
+    const uint64_t      hl = ah * bl, hh = ah * bh;
+    const uint64_t      mid = (ll >> 32) + (lh & 0xffffffffU) +
+      (hl & 0xffffffffU);
+
+    result->low_bits = (mid << 32) | (ll & 0xffffffffU);
+    result->high_bits = hh + (lh >> 32) + (hl >> 32) + (mid >> 32);
+  }
+#endif
+}
+
+/** Multiplies the uint128_t \a a and \a b modulo 2^128.
+ * \a a == \a b is allowed.  Furthermore, \a a == \a result
+ * and/or \a b == \a result is allowed.
+ * \param [in]  a       A pointer to a sc_uint128_t.
+ * \param [in]  b       A pointer to a sc_uint128_t.
+ * \param[out]  result  A pointer to a sc_uint128_t.
+ *                      The lower 128 bits of the product \a a * \a b
+ *                      will be saved in \a result.
+ */
+static inline void
+sc_uint128_mul (const sc_uint128_t * a, const sc_uint128_t * b,
+                sc_uint128_t * result)
+{
+  SC_ASSERT (a != NULL && b != NULL && result != NULL);
+#ifdef SC_UINT128_NATIVE
+  sc_uint128_from_native (result, sc_uint128_to_native (a) *
+                          sc_uint128_to_native (b));
+#else
+  {
+    const uint64_t      cross = a->high_bits * b->low_bits +
+      a->low_bits * b->high_bits;
+
+    sc_uint128_mul_64 (a->low_bits, b->low_bits, result);
+    result->high_bits += cross;
+  }
+#endif
+}
+
+/** Interleave the bits of several coordinates into a Morton key.
+ * Bit b of coordinate c becomes bit b * \a num_coords + c of the key,
+ * such that the keys sort like a Z-order space-filling curve.
+ * \param [in]  coords          Array of \a num_coords coordinates.
+ * \param [in]  num_coords      Number of coordinates, at least 1.
+ * \param [in]  bits            Number of lowest bits used per coordinate.
+ *                              Require \a bits * \a num_coords <= 128.
+ * \param [out] result          The interleaved key.  Higher bits are zero.
+ */
+void                sc_uint128_interleave (const uint64_t * coords,
+                                           int num_coords, int bits,
+                                           sc_uint128_t * result);
+
+SC_EXTERN_C_END;
+
 #endif /* !SC_UINT128_H */
@@ -22,6 +22,10 @@
 */
 
 #include <sc_unique_counter.h>
+#include <sc_atomic.h>
+#ifdef SC_ENABLE_PTHREAD
+#include <pthread.h>
+#endif
 
 sc_unique_counter_t *
 sc_unique_counter_new (int start_value)
@@ -75,3 +79,180 @@ sc_unique_counter_release (sc_unique_counter_t * uc, int *counter)
 
   sc_mempool_free (uc->mempool, counter);
 }
+
+/* concurrent unique counter routines */
+
+#define SC_UNIQUE_COUNTER_CHUNKS 26
+
+struct sc_unique_counter_concurrent
+{
+  int                 start_value;
+  size_t              count;            /**< number of values in use */
+  size_t              num_words;        /**< words in allocated chunks */
+
+  /* The hint holds a word index in the lower 32 bits, below which there
+     is no free bit, and a tag in the upper 32 bits that is changed by
+     every release.  Thus an add cannot raise the hint past a word that
+     has been freed since the add has read the hint. */
+  uint64_t            hint;
+
+  /* chunk k holds 2**k words and is only allocated under the mutex */
+  uint64_t           *chunks[SC_UNIQUE_COUNTER_CHUNKS];
+#ifdef SC_ENABLE_PTHREAD
+  pthread_mutex_t     mutex;
+#endif
+};
+
+/** Return the chunk number of a word index. */
+static int
+sc_unique_counter_chunk (size_t word)
+{
+  return SC_LOG2_64 (word + 1);
+}
+
+static uint64_t    *
+sc_unique_counter_word (sc_unique_counter_concurrent_t * uc, size_t word)
+{
+  const int           k = sc_unique_counter_chunk (word);
+  uint64_t           *chunk;
+
+  chunk = (uint64_t *) SC_ATOMIC_LOAD (&uc->chunks[k]);
+  SC_ASSERT (chunk != NULL);
+  return chunk + (word - (((size_t) 1 << k) - 1));
+}
+
+/** Append a chunk unless another thread has done so since \a num_words. */
+static void
+sc_unique_counter_grow (sc_unique_counter_concurrent_t * uc,
+                        size_t num_words)
+{
+  int                 k;
+  uint64_t           *chunk;
+
+#ifdef SC_ENABLE_PTHREAD
+  SC_EXECUTE_ASSERT_FALSE (pthread_mutex_lock (&uc->mutex));
+#endif
+  if (SC_ATOMIC_LOAD (&uc->num_words) == num_words) {
+    k = sc_unique_counter_chunk (num_words);
+    SC_CHECK_ABORT (k < SC_UNIQUE_COUNTER_CHUNKS &&
+                    64. * (num_words + ((size_t) 1 << k)) <=
+                    (double) INT_MAX - uc->start_value,
+                    "Too many values in concurrent unique counter");
+    chunk = SC_ALLOC_ZERO (uint64_t, (size_t) 1 << k);
+    SC_ATOMIC_STORE (&uc->chunks[k], chunk);
+    SC_ATOMIC_STORE (&uc->num_words, num_words + ((size_t) 1 << k));
+  }
+#ifdef SC_ENABLE_PTHREAD
+  SC_EXECUTE_ASSERT_FALSE (pthread_mutex_unlock (&uc->mutex));
+#endif
+}
+
+sc_unique_counter_concurrent_t *
+sc_unique_counter_concurrent_new (int start_value)
+{
+  sc_unique_counter_concurrent_t *uc;
+
+  uc = SC_ALLOC_ZERO (sc_unique_counter_concurrent_t, 1);
+  uc->start_value = start_value;
+#ifdef SC_ENABLE_PTHREAD
+  SC_EXECUTE_ASSERT_FALSE (pthread_mutex_init (&uc->mutex, NULL));
+#endif
+
+  return uc;
+}
+
+void
+sc_unique_counter_concurrent_destroy (sc_unique_counter_concurrent_t * uc)
+{
+  int                 k;
+
+  SC_ASSERT (uc->count == 0);
+
+  for (k = 0; k < SC_UNIQUE_COUNTER_CHUNKS; ++k) {
+    SC_FREE (uc->chunks[k]);
+  }
+#ifdef SC_ENABLE_PTHREAD
+  SC_EXECUTE_ASSERT_FALSE (pthread_mutex_destroy (&uc->mutex));
+#endif
+  SC_FREE (uc);
+}
+
+size_t
+sc_unique_counter_concurrent_memory_used (sc_unique_counter_concurrent_t *
+                                          uc)
+{
+  return sizeof (sc_unique_counter_concurrent_t) +
+    SC_ATOMIC_LOAD (&uc->num_words) * sizeof (uint64_t);
+}
+
+size_t
+sc_unique_counter_concurrent_count (sc_unique_counter_concurrent_t * uc)
+{
+  return SC_ATOMIC_LOAD (&uc->count);
+}
+
+int
+sc_unique_counter_concurrent_add (sc_unique_counter_concurrent_t * uc)
+{
+  size_t              w, num_words;
+  uint64_t            v, bit, hint;
+  uint64_t           *word;
+
+  hint = SC_ATOMIC_LOAD (&uc->hint);
+  for (w = (size_t) (hint & 0xffffffffU);; ++w) {
+    num_words = SC_ATOMIC_LOAD (&uc->num_words);
+    if (w == num_words) {
+      sc_unique_counter_grow (uc, num_words);
+    }
+    word = sc_unique_counter_word (uc, w);
+    v = SC_ATOMIC_LOAD (word);
+    while (v != ~(uint64_t) 0) {
+      /* try to claim the lowest clear bit; a failure reloads the word */
+      bit = ~v & (v + 1);
+      if (SC_ATOMIC_CAS (word, &v, v | bit)) {
+        /* advance the hint past full words unless a release intervened */
+        if (w > (hint & 0xffffffffU)) {
+          (void) SC_ATOMIC_CAS (&uc->hint, &hint,
+                                (hint & ~(uint64_t) 0xffffffffU) | w);
+        }
+        SC_ATOMIC_ADD_RELAXED (&uc->count, 1);
+        return uc->start_value + (int) (64 * w) + SC_LOG2_64 (bit);
+      }
+    }
+  }
+}
+
+void
+sc_unique_counter_concurrent_release (sc_unique_counter_concurrent_t * uc,
+                                      int value)
+{
+  size_t              w;
+  uint64_t            bit, hint, lowered;
+  uint64_t           *word;
+#ifdef SC_ENABLE_DEBUG
+  uint64_t            v;
+#endif
+
+  SC_ASSERT (value >= uc->start_value);
+  w = (size_t) (value - uc->start_value) / 64;
+  bit = (uint64_t) 1 << ((value - uc->start_value) % 64);
+  SC_ASSERT (w < SC_ATOMIC_LOAD (&uc->num_words));
+
+  /* the bit is set, so subtracting it clears exactly this bit */
+  word = sc_unique_counter_word (uc, w);
+#ifdef SC_ENABLE_DEBUG
+  v = SC_ATOMIC_FETCH_ADD (word, -bit);
+  SC_ASSERT (v & bit);
+#else
+  (void) SC_ATOMIC_FETCH_ADD (word, -bit);
+#endif
+  SC_ATOMIC_ADD_RELAXED (&uc->count, (size_t) -1);
+
+  /* make the freed word visible to the search and bump the tag */
+  hint = SC_ATOMIC_LOAD (&uc->hint);
+  do {
+    lowered = ((hint >> 32) + 1) << 32 |
+      SC_MIN ((uint64_t) w, hint & 0xffffffffU);
+  }
+  while (!SC_ATOMIC_CAS (&uc->hint, &hint, lowered));
+}
@@ -73,4 +73,61 @@ int                *sc_unique_counter_add (sc_unique_counter_t * uc);
 void                sc_unique_counter_release (sc_unique_counter_t * uc,
                                                int *counter);
 
+/** The concurrent unique counter hands out integers to multiple threads.
+ * The values in use are the set bits of an atomic bitmap, which is
+ * searched from the lowest word that may have a free bit.  Released
+ * values are thus reused first, and the memory is bounded by the largest
+ * number of values in use at the same time.  Adding and releasing values
+ * is lock-free; only when the bitmap grows, a mutex is taken.
+ * The object is opaque and all its functions are thread safe if the library
+ * is configured with pthread support and the compiler provides atomic
+ * builtins, see sc_atomic.h.
+ */
+typedef struct sc_unique_counter_concurrent sc_unique_counter_concurrent_t;
+
+/** Create a thread safe factory for unique integers.
+ * \param [in] start_value      The smallest value to be returned.
+ * \return                      Fully initialized counter factory.
+ */
+sc_unique_counter_concurrent_t *sc_unique_counter_concurrent_new (int
+                                                                  start_value);
+
+/** Destroy the concurrent counter factory.
+ * All values added must have been released before calling this function.
+ * \param [in,out] uc           This memory will be released.
+ */
+void                sc_unique_counter_concurrent_destroy
+  (sc_unique_counter_concurrent_t * uc);
+
+/** Return the size in bytes allocated by a concurrent counter factory.
+ * \param [in] uc               Its total memory used will be counted.
+ */
+size_t              sc_unique_counter_concurrent_memory_used
+  (sc_unique_counter_concurrent_t * uc);
+
+/** Return the number of values currently in use.
+ * \param [in] uc               The factory, which may be in concurrent use.
+ */
+size_t              sc_unique_counter_concurrent_count
+  (sc_unique_counter_concurrent_t * uc);
+
+/** Request a unique integer value.  This function is thread safe.
+ * The same value is never returned twice, unless it has been released.
+ * \param [in,out] uc           The factory to return a unique value.
+ * \return                      The smallest value not in use that was
+ *                              found in the search of the bitmap.
+ */
+int                 sc_unique_counter_concurrent_add
+  (sc_unique_counter_concurrent_t * uc);
+
+/** Release a value to the factory.  This function is thread safe.
+ * It may be returned by any subsequent call to the add function.
+ * \param [in,out] uc           The factory that returned the value.
+ * \param [in] value            A value returned by
+ *                              \ref sc_unique_counter_concurrent_add
+ *                              and not since released.
+ */
+void                sc_unique_counter_concurrent_release
+  (sc_unique_counter_concurrent_t * uc, int value);
+
 #endif /* !SC_UNIQUE_COUNTER */
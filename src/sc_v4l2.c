@@ -22,6 +22,8 @@
 */
 
 #include <sc_v4l2.h>
+#include <sc_atomic.h>
+#include <sc_thread.h>
 
 #include <errno.h>
 
@@ -31,6 +33,9 @@
 #ifdef SC_HAVE_SYS_IOCTL_H
 #include <sys/ioctl.h>
 #endif
+#ifdef SC_HAVE_SYS_MMAN_H
+#include <sys/mman.h>
+#endif
 #ifdef SC_HAVE_SYS_SELECT_H
 #include <sys/select.h>
 #endif
@@ -49,11 +54,33 @@
 #ifdef SC_HAVE_UNISTD_H
 #include <unistd.h>
 #endif
+#ifdef SC_ENABLE_PTHREAD
+#include <pthread.h>
+#include <sched.h>
+#endif
 
 #ifndef SC_BUFSIZE
 #define SC_BUFSIZE BUFSIZ
 #endif
 
+/** The minimum number of rows converted by each thread. */
+#define SC_V4L2_CONVERT_PARALLEL_MIN 32
+
+#if defined SC_ENABLE_V4L2 && defined SC_HAVE_SYS_MMAN_H
+#define SC_V4L2_STREAMING
+#endif
+
+#if defined SC_ENABLE_V4L2 && defined SC_ENABLE_PTHREAD && \
+  defined SC_HAVE_ATOMIC_BUILTINS
+#define SC_V4L2_ASYNC
+
+/** The interval in milliseconds at which an idle writer thread wakes up. */
+#define SC_V4L2_ASYNC_MSEC 2
+
+/** The value of the in-flight index while the writer thread is idle. */
+#define SC_V4L2_ASYNC_IDLE ((size_t) -1)
+#endif
+
 struct sc_v4l2_device
 {
   int                 fd;
@@ -66,6 +93,34 @@ struct sc_v4l2_device
   struct v4l2_output  output;
   struct v4l2_format  format;
   struct v4l2_pix_format *pix;
+#endif
+  sc_v4l2_pixel_t     pixel;
+  char               *convert;
+#ifdef SC_V4L2_STREAMING
+  int                 stream_mapped;
+  int                 stream_on;
+  unsigned            num_buffers;
+  unsigned            num_fresh;
+  int                 current;
+  char               *buffer_start[SC_V4L2_MAX_BUFFERS];
+  size_t              buffer_length[SC_V4L2_MAX_BUFFERS];
+#endif
+#ifdef SC_V4L2_ASYNC
+  int                 async_running;
+  sc_v4l2_async_policy_t async_policy;
+  unsigned            async_usec;
+  pthread_t           async_thread;
+  pthread_mutex_t     async_mutex;
+  pthread_cond_t      async_cond;
+  char               *async_data;
+  size_t              async_frame_bytes;
+  size_t              async_queue;
+  size_t              async_head;
+  size_t              async_tail;
+  size_t              async_busy;
+  size_t              async_written;
+  size_t              async_dropped;
+  int                 async_errno;
 #endif
   char                devname[SC_BUFSIZE];
   char                devstring[SC_BUFSIZE];
@@ -210,20 +265,283 @@ sc_v4l2_device_is_streaming (const sc_v4l2_device_t * vd)
   return vd != NULL && vd->fd >= 0 && vd->support_streaming;
 }
 
+/* BT.601 limited range in 8 bit fixed point, with the chroma offset folded
+   into the rounding term to keep the shifted values non-negative */
+#define SC_V4L2_Y(r,g,b) \
+  ((unsigned char) (((66 * (r) + 129 * (g) + 25 * (b) + 128) >> 8) + 16))
+#define SC_V4L2_U(r,g,b) \
+  ((unsigned char) ((-38 * (r) - 74 * (g) + 112 * (b) + 32896) >> 8))
+#define SC_V4L2_V(r,g,b) \
+  ((unsigned char) ((112 * (r) - 94 * (g) - 18 * (b) + 32896) >> 8))
+
+/** Arguments of a conversion shared by the threads. */
+typedef struct sc_v4l2_convert
+{
+  sc_v4l2_pixel_t     srcformat;
+  const unsigned char *src;
+  size_t              srcstride;
+  sc_v4l2_pixel_t     destformat;
+  unsigned char      *dest;
+  size_t              bytesperline;
+  unsigned            width;
+  unsigned            height;
+}
+sc_v4l2_convert_t;
+
+/* The row kernels are written as simple loops over independent pixels
+   with a compile-time pixel stride such that the compiler vectorizes. */
+
+static void
+convert_row_rgb565 (const unsigned char *s, int bpp, unsigned char *d,
+                    unsigned width)
+{
+  unsigned            i;
+  unsigned            p;
+
+  for (i = 0; i < width; ++i) {
+    p = ((unsigned) (s[bpp * i] >> 3) << 11) |
+      ((unsigned) (s[bpp * i + 1] >> 2) << 5) |
+      (unsigned) (s[bpp * i + 2] >> 3);
+    d[2 * i] = (unsigned char) (p & 0xff);
+    d[2 * i + 1] = (unsigned char) (p >> 8);
+  }
+}
+
+static void
+convert_row_yuyv (const unsigned char *s, int bpp, unsigned char *d,
+                  unsigned width)
+{
+  unsigned            i;
+  int                 r, g, b;
+  const unsigned char *s0, *s1;
+
+  for (i = 0; i < width / 2; ++i) {
+    s0 = s + 2 * bpp * i;
+    s1 = s0 + bpp;
+    r = (s0[0] + s1[0] + 1) >> 1;
+    g = (s0[1] + s1[1] + 1) >> 1;
+    b = (s0[2] + s1[2] + 1) >> 1;
+    d[4 * i] = SC_V4L2_Y (s0[0], s0[1], s0[2]);
+    d[4 * i + 1] = SC_V4L2_U (r, g, b);
+    d[4 * i + 2] = SC_V4L2_Y (s1[0], s1[1], s1[2]);
+    d[4 * i + 3] = SC_V4L2_V (r, g, b);
+  }
+}
+
+static void
+convert_row_luma (const unsigned char *s, int bpp, unsigned char *d,
+                  unsigned width)
+{
+  unsigned            i;
+
+  for (i = 0; i < width; ++i) {
+    d[i] = SC_V4L2_Y (s[bpp * i], s[bpp * i + 1], s[bpp * i + 2]);
+  }
+}
+
+/** Compute the chroma of two rows averaged over 2x2 pixel blocks.
+ * The values are stored with stride \a step, starting at \a u and \a v.
+ */
+static void
+convert_row_chroma (const unsigned char *s, const unsigned char *t,
+                    int bpp, unsigned char *u, unsigned char *v,
+                    int step, unsigned width)
+{
+  unsigned            i;
+  int                 r, g, b;
+  const unsigned char *s0, *t0;
+
+  for (i = 0; i < width / 2; ++i) {
+    s0 = s + 2 * bpp * i;
+    t0 = t + 2 * bpp * i;
+    r = (s0[0] + s0[bpp] + t0[0] + t0[bpp] + 2) >> 2;
+    g = (s0[1] + s0[bpp + 1] + t0[1] + t0[bpp + 1] + 2) >> 2;
+    b = (s0[2] + s0[bpp + 2] + t0[2] + t0[bpp + 2] + 2) >> 2;
+    u[step * i] = SC_V4L2_U (r, g, b);
+    v[step * i] = SC_V4L2_V (r, g, b);
+  }
+}
+
+/** Convert one row, or one pair of rows for the 4:2:0 formats. */
+static void
+convert_unit (const sc_v4l2_convert_t * c, int bpp, unsigned k)
+{
+  const size_t        bpl = c->bytesperline;
+  const size_t        luma = bpl * c->height;
+  const unsigned char *s, *t;
+  unsigned char      *d;
+
+  s = c->src + c->srcstride * k;
+  d = c->dest + bpl * k;
+  switch (c->destformat) {
+  case SC_V4L2_PIXEL_RGB565:
+    convert_row_rgb565 (s, bpp, d, c->width);
+    break;
+  case SC_V4L2_PIXEL_YUYV:
+    convert_row_yuyv (s, bpp, d, c->width);
+    break;
+  case SC_V4L2_PIXEL_NV12:
+    s = c->src + c->srcstride * 2 * k;
+    t = s + c->srcstride;
+    d = c->dest + bpl * 2 * k;
+    convert_row_luma (s, bpp, d, c->width);
+    convert_row_luma (t, bpp, d + bpl, c->width);
+    d = c->dest + luma + bpl * k;
+    convert_row_chroma (s, t, bpp, d, d + 1, 2, c->width);
+    break;
+  case SC_V4L2_PIXEL_I420:
+    s = c->src + c->srcstride * 2 * k;
+    t = s + c->srcstride;
+    d = c->dest + bpl * 2 * k;
+    convert_row_luma (s, bpp, d, c->width);
+    convert_row_luma (t, bpp, d + bpl, c->width);
+    d = c->dest + luma + bpl / 2 * k;
+    convert_row_chroma (s, t, bpp, d, d + luma / 4, 1, c->width);
+    break;
+  default:
+    SC_ABORT_NOT_REACHED ();
+  }
+}
+
+static void
+convert_band (int thread_id, int num_threads, void *user)
+{
+  const sc_v4l2_convert_t *c = (const sc_v4l2_convert_t *) user;
+  const unsigned      units = c->destformat >= SC_V4L2_PIXEL_NV12 ?
+    c->height / 2 : c->height;
+  const unsigned      begin = (unsigned)
+    ((unsigned long) units * thread_id / num_threads);
+  const unsigned      end = (unsigned)
+    ((unsigned long) units * (thread_id + 1) / num_threads);
+  unsigned            k;
+
+  /* a constant pixel stride lets the kernels be specialized when inlined */
+  if (c->srcformat == SC_V4L2_PIXEL_RGB24) {
+    for (k = begin; k < end; ++k) {
+      convert_unit (c, 3, k);
+    }
+  }
+  else {
+    for (k = begin; k < end; ++k) {
+      convert_unit (c, 4, k);
+    }
+  }
+}
+
+void
+sc_v4l2_convert (sc_v4l2_pixel_t srcformat, const char *src,
+                 size_t srcstride, sc_v4l2_pixel_t destformat, char *dest,
+                 size_t bytesperline, unsigned width, unsigned height,
+                 int num_threads)
+{
+  int                 T;
+  unsigned            units;
+  sc_v4l2_convert_t   c;
+
+  SC_ASSERT (srcformat == SC_V4L2_PIXEL_RGB24 ||
+             srcformat == SC_V4L2_PIXEL_RGBA);
+  SC_ASSERT (destformat >= SC_V4L2_PIXEL_RGB565 &&
+             destformat <= SC_V4L2_PIXEL_I420);
+  SC_ASSERT (src != NULL && dest != NULL);
+  SC_ASSERT (srcstride >= (srcformat == SC_V4L2_PIXEL_RGB24 ? 3 : 4) *
+             (size_t) width);
+  SC_ASSERT (destformat == SC_V4L2_PIXEL_RGB565 || width % 2 == 0);
+  SC_ASSERT (destformat < SC_V4L2_PIXEL_NV12 || height % 2 == 0);
+  SC_ASSERT (bytesperline >= (destformat <= SC_V4L2_PIXEL_YUYV ? 2 : 1) *
+             (size_t) width);
+  SC_ASSERT (destformat != SC_V4L2_PIXEL_I420 || bytesperline % 2 == 0);
+
+  c.srcformat = srcformat;
+  c.src = (const unsigned char *) src;
+  c.srcstride = srcstride;
+  c.destformat = destformat;
+  c.dest = (unsigned char *) dest;
+  c.bytesperline = bytesperline;
+  c.width = width;
+  c.height = height;
+
+  /* split the rows into bands of similar size */
+  if (num_threads <= 0) {
+    num_threads = sc_thread_default_count ();
+  }
+  units = destformat >= SC_V4L2_PIXEL_NV12 ? height / 2 : height;
+  T = (int) SC_MIN ((unsigned) num_threads,
+                    units / SC_V4L2_CONVERT_PARALLEL_MIN);
+  T = SC_MAX (T, 1);
+  if (T == 1) {
+    convert_band (0, 1, &c);
+  }
+  else {
+    sc_thread_fork_join (T, convert_band, &c);
+  }
+}
+
+int
+sc_v4l2_device_write_rgb (sc_v4l2_device_t * vd, sc_v4l2_pixel_t srcformat,
+                          const char *src, size_t srcstride, int num_threads)
+{
+#ifdef SC_ENABLE_V4L2
+  char               *frame;
+#endif
+
+  SC_ASSERT (vd != NULL);
+  SC_ASSERT (vd->fd >= 0);
+
+#ifdef SC_ENABLE_V4L2
+  SC_ASSERT (vd->pix != NULL);
+
+#ifdef SC_V4L2_STREAMING
+  if (vd->stream_mapped) {
+    /* convert directly into the next buffer of the ring */
+    if ((frame = sc_v4l2_device_stream_frame (vd)) == NULL) {
+      return -1;
+    }
+    sc_v4l2_convert (srcformat, src, srcstride, vd->pixel, frame,
+                     vd->pix->bytesperline, vd->pix->width, vd->pix->height,
+                     num_threads);
+    return sc_v4l2_device_stream_queue (vd);
+  }
+#endif
+  if (vd->convert == NULL) {
+    vd->convert = SC_ALLOC (char, vd->pix->sizeimage);
+  }
+  frame = vd->convert;
+  sc_v4l2_convert (srcformat, src, srcstride, vd->pixel, frame,
+                   vd->pix->bytesperline, vd->pix->width, vd->pix->height,
+                   num_threads);
+  return sc_v4l2_device_write (vd, frame);
+#else
+  errno = ENOSYS;
+  return -1;
+#endif
+}
+
 int
 sc_v4l2_device_format (sc_v4l2_device_t * vd,
                        unsigned int *width, unsigned int *height,
                        unsigned int *bytesperline, unsigned int *sizeimage)
+{
+  return sc_v4l2_device_format_ext (vd, SC_V4L2_PIXEL_RGB565, width, height,
+                                    bytesperline, sizeimage);
+}
+
+int
+sc_v4l2_device_format_ext (sc_v4l2_device_t * vd, sc_v4l2_pixel_t pixel,
+                           unsigned int *width, unsigned int *height,
+                           unsigned int *bytesperline,
+                           unsigned int *sizeimage)
 {
 #ifdef SC_ENABLE_V4L2
   int                 retval;
   int                 output_index;
   __u32               pixelformat;
+  __u32               minline, minimage;
 #endif
 
   SC_ASSERT (vd != NULL);
   SC_ASSERT (vd->fd >= 0);
   SC_ASSERT (vd->support_output);
+  SC_ASSERT (pixel >= SC_V4L2_PIXEL_RGB565 && pixel <= SC_V4L2_PIXEL_I420);
 
   SC_ASSERT (width != NULL);
   SC_ASSERT (height != NULL);
@@ -261,20 +579,32 @@ sc_v4l2_device_format (sc_v4l2_device_t * vd,
   /* set desired values */
   vd->pix->width = *width;
   vd->pix->height = *height;
-#if 0
-  pixelformat = V4L2_PIX_FMT_ARGB555;
-  pixelformat = V4L2_PIX_FMT_ABGR555;
-  pixelformat = V4L2_PIX_FMT_RGBA555;
-#else
-  pixelformat = V4L2_PIX_FMT_RGB565;
-#endif
+  switch (pixel) {
+  case SC_V4L2_PIXEL_YUYV:
+    pixelformat = V4L2_PIX_FMT_YUYV;
+    break;
+  case SC_V4L2_PIXEL_NV12:
+    pixelformat = V4L2_PIX_FMT_NV12;
+    break;
+  case SC_V4L2_PIXEL_I420:
+    pixelformat = V4L2_PIX_FMT_YUV420;
+    break;
+  default:
+    pixelformat = V4L2_PIX_FMT_RGB565;
+  }
   vd->pix->pixelformat = pixelformat;
   vd->pix->field = V4L2_FIELD_NONE;
-  vd->pix->bytesperline = 2 * vd->pix->width;
+  vd->pix->bytesperline = pixel <= SC_V4L2_PIXEL_YUYV ?
+    2 * vd->pix->width : vd->pix->width;
   vd->pix->sizeimage = vd->pix->bytesperline * vd->pix->height;
+  if (pixel >= SC_V4L2_PIXEL_NV12) {
+    vd->pix->sizeimage += vd->pix->sizeimage / 2;
+  }
   vd->pix->colorspace = V4L2_COLORSPACE_SRGB;
-  vd->pix->ycbcr_enc = V4L2_YCBCR_ENC_DEFAULT;
-  vd->pix->quantization = V4L2_QUANTIZATION_DEFAULT;
+  vd->pix->ycbcr_enc = pixel == SC_V4L2_PIXEL_RGB565 ?
+    V4L2_YCBCR_ENC_DEFAULT : V4L2_YCBCR_ENC_601;
+  vd->pix->quantization = pixel == SC_V4L2_PIXEL_RGB565 ?
+    V4L2_QUANTIZATION_DEFAULT : V4L2_QUANTIZATION_LIM_RANGE;
   vd->pix->xfer_func = V4L2_XFER_FUNC_DEFAULT;
 
   /* set desired format */
@@ -287,11 +617,25 @@ sc_v4l2_device_format (sc_v4l2_device_t * vd,
     errno = EINVAL;
     return -1;
   }
-  if (vd->pix->bytesperline < 2 * vd->pix->width ||
-      vd->pix->sizeimage < vd->pix->bytesperline * vd->pix->height) {
+  if (pixel != SC_V4L2_PIXEL_RGB565 &&
+      (vd->pix->width % 2 != 0 ||
+       (pixel != SC_V4L2_PIXEL_YUYV && vd->pix->height % 2 != 0))) {
+    errno = EINVAL;
+    return -1;
+  }
+  minline = pixel <= SC_V4L2_PIXEL_YUYV ? 2 * vd->pix->width :
+    vd->pix->width;
+  minimage = vd->pix->bytesperline * vd->pix->height;
+  if (pixel >= SC_V4L2_PIXEL_NV12) {
+    minimage += minimage / 2;
+  }
+  if (vd->pix->bytesperline < minline || vd->pix->sizeimage < minimage) {
     errno = EINVAL;
     return -1;
   }
+  vd->pixel = pixel;
+  SC_FREE (vd->convert);
+  vd->convert = NULL;
 
   /* report back negotiated format */
   *width = vd->pix->width;
@@ -366,6 +710,474 @@ sc_v4l2_device_write (sc_v4l2_device_t * vd, const char *wbuf)
   return 0;
 }
 
+#ifdef SC_V4L2_STREAMING
+
+/** Unmap the buffers and release them in the driver. */
+static int
+stream_release (sc_v4l2_device_t * vd)
+{
+  int                 retval = 0;
+  unsigned            i;
+  struct v4l2_requestbuffers req;
+
+  for (i = 0; i < vd->num_buffers; ++i) {
+    if (munmap (vd->buffer_start[i], vd->buffer_length[i]) != 0) {
+      retval = -1;
+    }
+  }
+  vd->num_buffers = vd->num_fresh = 0;
+  vd->current = -1;
+  vd->stream_mapped = 0;
+
+  memset (&req, 0, sizeof (req));
+  req.count = 0;
+  req.type = V4L2_BUF_TYPE_VIDEO_OUTPUT;
+  req.memory = V4L2_MEMORY_MMAP;
+  if (ioctl (vd->fd, VIDIOC_REQBUFS, &req) != 0) {
+    retval = -1;
+  }
+  return retval;
+}
+
+#endif /* SC_V4L2_STREAMING */
+
+int
+sc_v4l2_device_stream_start (sc_v4l2_device_t * vd,
+                             unsigned int *num_buffers)
+{
+#ifdef SC_V4L2_STREAMING
+  int                 retval;
+  unsigned            i;
+  struct v4l2_requestbuffers req;
+  struct v4l2_buffer  buf;
+  void               *start;
+#endif
+
+  SC_ASSERT (vd != NULL);
+  SC_ASSERT (vd->fd >= 0);
+  SC_ASSERT (num_buffers != NULL);
+
+#ifdef SC_V4L2_STREAMING
+  SC_ASSERT (vd->pix != NULL);
+  SC_ASSERT (!vd->stream_mapped);
+
+  if (!vd->support_streaming || *num_buffers == 0) {
+    errno = EINVAL;
+    return -1;
+  }
+
+  /* ask the driver for a ring of memory mapped buffers */
+  memset (&req, 0, sizeof (req));
+  req.count = SC_MIN (*num_buffers, SC_V4L2_MAX_BUFFERS);
+  req.type = V4L2_BUF_TYPE_VIDEO_OUTPUT;
+  req.memory = V4L2_MEMORY_MMAP;
+  if ((retval = ioctl (vd->fd, VIDIOC_REQBUFS, &req)) != 0) {
+    return retval;
+  }
+  if (req.count == 0 || req.count > SC_V4L2_MAX_BUFFERS) {
+    errno = ENOMEM;
+    return -1;
+  }
+
+  /* map every buffer into our address space */
+  vd->stream_mapped = 1;
+  vd->num_buffers = 0;
+  for (i = 0; i < req.count; ++i) {
+    memset (&buf, 0, sizeof (buf));
+    buf.index = i;
+    buf.type = V4L2_BUF_TYPE_VIDEO_OUTPUT;
+    buf.memory = V4L2_MEMORY_MMAP;
+    if ((retval = ioctl (vd->fd, VIDIOC_QUERYBUF, &buf)) != 0) {
+      stream_release (vd);
+      return retval;
+    }
+    if (buf.length < vd->pix->sizeimage) {
+      stream_release (vd);
+      errno = EINVAL;
+      return -1;
+    }
+    start = mmap (NULL, buf.length, PROT_READ | PROT_WRITE, MAP_SHARED,
+                  vd->fd, buf.m.offset);
+    if (start == MAP_FAILED) {
+      stream_release (vd);
+      return -1;
+    }
+    vd->buffer_start[i] = (char *) start;
+    vd->buffer_length[i] = buf.length;
+    ++vd->num_buffers;
+  }
+  vd->num_fresh = vd->num_buffers;
+  vd->current = -1;
+  vd->stream_on = 0;
+
+  *num_buffers = vd->num_buffers;
+  return 0;
+#else
+  errno = ENOSYS;
+  return -1;
+#endif
+}
+
+char               *
+sc_v4l2_device_stream_frame (sc_v4l2_device_t * vd)
+{
+#ifdef SC_V4L2_STREAMING
+  struct v4l2_buffer  buf;
+#endif
+
+  SC_ASSERT (vd != NULL);
+  SC_ASSERT (vd->fd >= 0);
+
+#ifdef SC_V4L2_STREAMING
+  SC_ASSERT (vd->stream_mapped);
+
+  if (vd->current < 0) {
+    if (vd->num_fresh > 0) {
+      /* hand out the buffers that have never been queued first */
+      vd->current = (int) (vd->num_buffers - vd->num_fresh--);
+    }
+    else {
+      /* wait for the driver to return a buffer that has been output */
+      memset (&buf, 0, sizeof (buf));
+      buf.type = V4L2_BUF_TYPE_VIDEO_OUTPUT;
+      buf.memory = V4L2_MEMORY_MMAP;
+      if (ioctl (vd->fd, VIDIOC_DQBUF, &buf) != 0) {
+        return NULL;
+      }
+      SC_ASSERT (buf.index < vd->num_buffers);
+      vd->current = (int) buf.index;
+    }
+  }
+  return vd->buffer_start[vd->current];
+#else
+  errno = ENOSYS;
+  return NULL;
+#endif
+}
+
+int
+sc_v4l2_device_stream_queue (sc_v4l2_device_t * vd)
+{
+#ifdef SC_V4L2_STREAMING
+  int                 retval;
+  int                 type;
+  struct v4l2_buffer  buf;
+#endif
+
+  SC_ASSERT (vd != NULL);
+  SC_ASSERT (vd->fd >= 0);
+
+#ifdef SC_V4L2_STREAMING
+  SC_ASSERT (vd->stream_mapped);
+  SC_ASSERT (vd->current >= 0);
+
+  memset (&buf, 0, sizeof (buf));
+  buf.index = (__u32) vd->current;
+  buf.type = V4L2_BUF_TYPE_VIDEO_OUTPUT;
+  buf.memory = V4L2_MEMORY_MMAP;
+  buf.bytesused = vd->pix->sizeimage;
+  buf.field = V4L2_FIELD_NONE;
+  if ((retval = ioctl (vd->fd, VIDIOC_QBUF, &buf)) != 0) {
+    return retval;
+  }
+  vd->current = -1;
+
+  /* the stream starts with its first queued frame */
+  if (!vd->stream_on) {
+    type = V4L2_BUF_TYPE_VIDEO_OUTPUT;
+    if ((retval = ioctl (vd->fd, VIDIOC_STREAMON, &type)) != 0) {
+      return retval;
+    }
+    vd->stream_on = 1;
+  }
+  return 0;
+#else
+  errno = ENOSYS;
+  return -1;
+#endif
+}
+
+int
+sc_v4l2_device_stream_stop (sc_v4l2_device_t * vd)
+{
+#ifdef SC_V4L2_STREAMING
+  int                 retval = 0;
+  int                 type;
+#endif
+
+  SC_ASSERT (vd != NULL);
+  SC_ASSERT (vd->fd >= 0);
+
+#ifdef SC_V4L2_STREAMING
+  if (!vd->stream_mapped) {
+    return 0;
+  }
+  if (vd->stream_on) {
+    type = V4L2_BUF_TYPE_VIDEO_OUTPUT;
+    retval = ioctl (vd->fd, VIDIOC_STREAMOFF, &type);
+    vd->stream_on = 0;
+  }
+  if (stream_release (vd) != 0) {
+    retval = -1;
+  }
+  return retval;
+#else
+  return 0;
+#endif
+}
+
+#ifdef SC_V4L2_ASYNC
+
+/** Output one frame of the queue when the device is ready.
+ * \return          True if the frame has been written.
+ */
+static int
+async_output (sc_v4l2_device_t * vd, const char *frame)
+{
+  int                 retval;
+  char               *buffer;
+
+  /* wait for readiness but give up on a stalled device when stopping */
+  while ((retval = sc_v4l2_device_select (vd, vd->async_usec)) == 0) {
+    if (!SC_ATOMIC_LOAD (&vd->async_running)) {
+      return 0;
+    }
+  }
+  if (retval < 0) {
+    vd->async_errno = errno;
+    return 0;
+  }
+
+#ifdef SC_V4L2_STREAMING
+  if (vd->stream_mapped) {
+    if ((buffer = sc_v4l2_device_stream_frame (vd)) == NULL) {
+      vd->async_errno = errno;
+      return 0;
+    }
+    memcpy (buffer, frame, vd->async_frame_bytes);
+    if (sc_v4l2_device_stream_queue (vd) != 0) {
+      vd->async_errno = errno;
+      return 0;
+    }
+    return 1;
+  }
+#endif
+  if (sc_v4l2_device_write (vd, frame) != 0) {
+    vd->async_errno = errno;
+    return 0;
+  }
+  return 1;
+}
+
+static void        *
+async_main (void *arg)
+{
+  sc_v4l2_device_t   *vd = (sc_v4l2_device_t *) arg;
+  const size_t        num_slots = vd->async_queue + 1;
+  size_t              tail;
+  struct timespec     ts;
+
+  pthread_mutex_lock (&vd->async_mutex);
+  for (;;) {
+    tail = SC_ATOMIC_LOAD (&vd->async_tail);
+    if (tail == SC_ATOMIC_LOAD (&vd->async_head)) {
+      /* the queue is drained before the thread quits */
+      if (!SC_ATOMIC_LOAD (&vd->async_running)) {
+        break;
+      }
+      clock_gettime (CLOCK_REALTIME, &ts);
+      ts.tv_nsec += 1000000L * SC_V4L2_ASYNC_MSEC;
+      ts.tv_sec += ts.tv_nsec / 1000000000L;
+      ts.tv_nsec %= 1000000000L;
+      pthread_cond_timedwait (&vd->async_cond, &vd->async_mutex, &ts);
+      continue;
+    }
+    pthread_mutex_unlock (&vd->async_mutex);
+
+    /* claim the oldest frame against a concurrent drop by the producer */
+    SC_ATOMIC_STORE (&vd->async_busy, tail);
+    if (SC_ATOMIC_CAS (&vd->async_tail, &tail, tail + 1)) {
+      if (async_output (vd, vd->async_data + (tail % num_slots) *
+                        vd->async_frame_bytes)) {
+        SC_ATOMIC_ADD_RELAXED (&vd->async_written, 1);
+      }
+      else {
+        SC_ATOMIC_ADD_RELAXED (&vd->async_dropped, 1);
+      }
+    }
+    SC_ATOMIC_STORE (&vd->async_busy, SC_V4L2_ASYNC_IDLE);
+    pthread_mutex_lock (&vd->async_mutex);
+  }
+  pthread_mutex_unlock (&vd->async_mutex);
+
+  return NULL;
+}
+
+#endif /* SC_V4L2_ASYNC */
+
+int
+sc_v4l2_device_async_start (sc_v4l2_device_t * vd, unsigned int queue_frames,
+                            sc_v4l2_async_policy_t policy, unsigned usec)
+{
+#ifdef SC_V4L2_ASYNC
+  int                 retval;
+#endif
+
+  SC_ASSERT (vd != NULL);
+  SC_ASSERT (vd->fd >= 0);
+  SC_ASSERT (queue_frames > 0);
+
+#ifdef SC_V4L2_ASYNC
+  SC_ASSERT (vd->pix != NULL);
+  SC_ASSERT (!vd->async_running);
+
+  /* one slot more than the queue length for the frame in flight */
+  vd->async_frame_bytes = vd->pix->sizeimage;
+  vd->async_queue = queue_frames;
+  vd->async_data = SC_ALLOC (char, (queue_frames + 1) *
+                             vd->async_frame_bytes);
+  vd->async_policy = policy;
+  vd->async_usec = usec;
+  vd->async_head = vd->async_tail = 0;
+  vd->async_busy = SC_V4L2_ASYNC_IDLE;
+  vd->async_written = vd->async_dropped = 0;
+  vd->async_errno = 0;
+
+  pthread_mutex_init (&vd->async_mutex, NULL);
+  pthread_cond_init (&vd->async_cond, NULL);
+  vd->async_running = 1;
+  if ((retval = pthread_create (&vd->async_thread, NULL,
+                                async_main, vd)) != 0) {
+    vd->async_running = 0;
+    pthread_cond_destroy (&vd->async_cond);
+    pthread_mutex_destroy (&vd->async_mutex);
+    SC_FREE (vd->async_data);
+    errno = retval;
+    return -1;
+  }
+  return 0;
+#else
+  errno = ENOSYS;
+  return -1;
+#endif
+}
+
+int
+sc_v4l2_device_async_push (sc_v4l2_device_t * vd, const char *frame)
+{
+#ifdef SC_V4L2_ASYNC
+  size_t              head, tail, busy;
+  size_t              num_slots;
+#endif
+
+  SC_ASSERT (vd != NULL);
+  SC_ASSERT (vd->fd >= 0);
+  SC_ASSERT (frame != NULL);
+
+#ifdef SC_V4L2_ASYNC
+  SC_ASSERT (vd->async_running);
+
+  num_slots = vd->async_queue + 1;
+  head = vd->async_head;
+  for (;;) {
+    tail = SC_ATOMIC_LOAD (&vd->async_tail);
+    if (head - tail < vd->async_queue) {
+      /* the ring may still wrap onto the frame being output */
+      busy = SC_ATOMIC_LOAD (&vd->async_busy);
+      if (busy == SC_V4L2_ASYNC_IDLE || (head - busy) % num_slots != 0) {
+        break;
+      }
+      if (vd->async_policy != SC_V4L2_ASYNC_BLOCK) {
+        SC_ATOMIC_ADD_RELAXED (&vd->async_dropped, 1);
+        return 1;
+      }
+    }
+    else if (vd->async_policy == SC_V4L2_ASYNC_DROP_NEWEST) {
+      SC_ATOMIC_ADD_RELAXED (&vd->async_dropped, 1);
+      return 1;
+    }
+    else if (vd->async_policy == SC_V4L2_ASYNC_DROP_OLDEST) {
+      /* the writer thread may have claimed this frame meanwhile */
+      if (SC_ATOMIC_CAS (&vd->async_tail, &tail, tail + 1)) {
+        SC_ATOMIC_ADD_RELAXED (&vd->async_dropped, 1);
+      }
+      continue;
+    }
+    pthread_cond_signal (&vd->async_cond);
+    sched_yield ();
+  }
+
+  memcpy (vd->async_data + (head % num_slots) * vd->async_frame_bytes,
+          frame, vd->async_frame_bytes);
+  SC_ATOMIC_STORE (&vd->async_head, head + 1);
+  pthread_cond_signal (&vd->async_cond);
+  return 0;
+#else
+  errno = ENOSYS;
+  return -1;
+#endif
+}
+
+void
+sc_v4l2_device_async_stats (sc_v4l2_device_t * vd,
+                            size_t *written, size_t *dropped, int *error)
+{
+  SC_ASSERT (vd != NULL);
+  SC_ASSERT (vd->fd >= 0);
+
+#ifdef SC_V4L2_ASYNC
+  if (written != NULL) {
+    *written = SC_ATOMIC_LOAD (&vd->async_written);
+  }
+  if (dropped != NULL) {
+    *dropped = SC_ATOMIC_LOAD (&vd->async_dropped);
+  }
+  if (error != NULL) {
+    *error = vd->async_errno;
+  }
+#else
+  if (written != NULL) {
+    *written = 0;
+  }
+  if (dropped != NULL) {
+    *dropped = 0;
+  }
+  if (error != NULL) {
+    *error = 0;
+  }
+#endif
+}
+
+int
+sc_v4l2_device_async_stop (sc_v4l2_device_t * vd)
+{
+  SC_ASSERT (vd != NULL);
+  SC_ASSERT (vd->fd >= 0);
+
+#ifdef SC_V4L2_ASYNC
+  if (!vd->async_running) {
+    return 0;
+  }
+
+  /* the thread outputs the queued frames before it quits */
+  pthread_mutex_lock (&vd->async_mutex);
+  SC_ATOMIC_STORE (&vd->async_running, 0);
+  pthread_cond_signal (&vd->async_cond);
+  pthread_mutex_unlock (&vd->async_mutex);
+  pthread_join (vd->async_thread, NULL);
+
+  pthread_cond_destroy (&vd->async_cond);
+  pthread_mutex_destroy (&vd->async_mutex);
+  SC_FREE (vd->async_data);
+  vd->async_data = NULL;
+  if (vd->async_errno != 0) {
+    errno = vd->async_errno;
+    return -1;
+  }
+#endif
+  return 0;
+}
+
 int
 sc_v4l2_device_close (sc_v4l2_device_t * vd)
 {
@@ -376,6 +1188,13 @@ sc_v4l2_device_close (sc_v4l2_device_t * vd)
   SC_ASSERT (vd != NULL);
   SC_ASSERT (vd->fd >= 0);
 
+#ifdef SC_V4L2_ASYNC
+  sc_v4l2_device_async_stop (vd);
+#endif
+#ifdef SC_V4L2_STREAMING
+  sc_v4l2_device_stream_stop (vd);
+#endif
+  SC_FREE (vd->convert);
 #ifdef SC_ENABLE_V4L2
   if ((retval = close (vd->fd)) != 0) {
     SC_FREE (vd);
@@ -31,11 +31,36 @@
 
 #include <sc.h>
 
+/** Maximum number of buffers in the ring used for streaming output. */
+#define SC_V4L2_MAX_BUFFERS 32
+
 SC_EXTERN_C_BEGIN;
 
 /** Opaque structure for a video device. */
 typedef struct sc_v4l2_device sc_v4l2_device_t;
 
+/** Pixel formats of rendered images and of the device output. */
+typedef enum sc_v4l2_pixel
+{
+  SC_V4L2_PIXEL_RGB24,          /**< Source: 3 bytes red, green, blue. */
+  SC_V4L2_PIXEL_RGBA,           /**< Source: 4 bytes, alpha is ignored. */
+  SC_V4L2_PIXEL_RGB565,         /**< Output: 2 bytes little endian. */
+  SC_V4L2_PIXEL_YUYV,           /**< Output: packed 4:2:2. */
+  SC_V4L2_PIXEL_NV12,           /**< Output: luma and interleaved 4:2:0
+                                     chroma planes. */
+  SC_V4L2_PIXEL_I420            /**< Output: luma, Cb and Cr planes. */
+}
+sc_v4l2_pixel_t;
+
+/** What to do with a frame pushed into a full asynchronous queue. */
+typedef enum sc_v4l2_async_policy
+{
+  SC_V4L2_ASYNC_BLOCK,          /**< Wait for the writer thread. */
+  SC_V4L2_ASYNC_DROP_NEWEST,    /**< Discard the pushed frame. */
+  SC_V4L2_ASYNC_DROP_OLDEST     /**< Replace the oldest queued frame. */
+}
+sc_v4l2_async_policy_t;
+
 /** Open a video device by special file name.
  * The device is queried but its state is not modified.
  * \param [in] devname      Special file name such as `/dev/video8`.
@@ -44,6 +69,7 @@ typedef struct sc_v4l2_device sc_v4l2_device_t;
 sc_v4l2_device_t   *sc_v4l2_device_open (const char *devname);
 
 /** Close a video device.
+ * A writer thread and a running stream are stopped first.
  * \param [in,out] vd   Close this device and deallocate associated resources.
  * \return              0 on success, -1 otherwise.
  */
@@ -100,6 +126,7 @@ int                 sc_v4l2_device_write (sc_v4l2_device_t * vd,
 
 /** Set output configuration of device.
  * We demand sRGB color space with RGB 565 pixel format (2 bytes).
+ * This is \ref sc_v4l2_device_format_ext with \ref SC_V4L2_PIXEL_RGB565.
  * The image size values on output define the buffer size to allocate.
  * \param [in,out] vd   Device must support the desired output format.
  * \param [in,out] width    Desired width on input, actual width on output.
@@ -114,6 +141,157 @@ int                 sc_v4l2_device_format (sc_v4l2_device_t * vd,
                                            unsigned int *bytesperline,
                                            unsigned int *sizeimage);
 
+/** Set up streaming output through a ring of memory mapped buffers.
+ * The frames are written directly into driver memory, which avoids the
+ * copy and system call of \ref sc_v4l2_device_write per frame.
+ * Call \ref sc_v4l2_device_format before and do not mix with writing.
+ * \param [in,out] vd   Device that supports streaming I/O.
+ * \param [in,out] num_buffers  Desired number of buffers on input, at most
+ *                              \ref SC_V4L2_MAX_BUFFERS are requested.
+ *                              Number granted by the driver on output.
+ * \return          0 on success, -1 otherwise and setting errno.
+ */
+int                 sc_v4l2_device_stream_start (sc_v4l2_device_t * vd,
+                                                 unsigned int *num_buffers);
+
+/** Return a buffer of the ring to write the next frame into.
+ * Initially the buffers are handed out in order.  Once all of them have
+ * been queued, we block until the driver has output one and return it.
+ * Repeated calls return the same buffer until it is queued.
+ * \param [in,out] vd   Device with streaming started.
+ * \return          Writable buffer of at least \a sizeimage many bytes
+ *                  as returned by \ref sc_v4l2_device_format,
+ *                  or NULL on error setting errno.
+ */
+char               *sc_v4l2_device_stream_frame (sc_v4l2_device_t * vd);
+
+/** Queue the buffer returned by \ref sc_v4l2_device_stream_frame for output.
+ * The buffer must not be accessed afterwards.  The first call turns on
+ * the stream.
+ * \param [in,out] vd   Device with a buffer handed out.
+ * \return          0 on success, -1 otherwise and setting errno.
+ */
+int                 sc_v4l2_device_stream_queue (sc_v4l2_device_t * vd);
+
+/** Stop streaming and release the buffers of the ring.
+ * It is legal to call this function when streaming is not started.
+ * \param [in,out] vd   Opened device.
+ * \return          0 on success, -1 otherwise and setting errno.
+ */
+int                 sc_v4l2_device_stream_stop (sc_v4l2_device_t * vd);
+
+/** Start a background thread that outputs frames from a bounded queue.
+ * The queue is lock-free between one pushing thread and the writer.
+ * The writer waits for the device by \ref sc_v4l2_device_select and uses
+ * the streaming buffers if \ref sc_v4l2_device_stream_start has been
+ * called before, and \ref sc_v4l2_device_write otherwise.  Until
+ * \ref sc_v4l2_device_async_stop the device must not be used otherwise.
+ * This requires thread support and fails with ENOSYS if not configured.
+ * \param [in,out] vd   Device with its format set.
+ * \param [in] queue_frames     Positive number of frames to queue.
+ * \param [in] policy   Behavior of \ref sc_v4l2_device_async_push when
+ *                      the queue is full.
+ * \param [in] usec     Microseconds for each wait on the device.
+ * \return          0 on success, -1 otherwise and setting errno.
+ */
+int                 sc_v4l2_device_async_start (sc_v4l2_device_t * vd,
+                                                unsigned int queue_frames,
+                                                sc_v4l2_async_policy_t
+                                                policy, unsigned usec);
+
+/** Copy a frame into the queue of the writer thread.
+ * Except for \ref SC_V4L2_ASYNC_BLOCK this function never waits.
+ * If the only free slot holds the frame currently being output, the
+ * pushed frame is dropped with \ref SC_V4L2_ASYNC_DROP_OLDEST as well.
+ * \param [in,out] vd   Device with the writer thread started.
+ * \param [in] frame    Buffer holding at least \a sizeimage many bytes.
+ * \return          0 if queued, 1 if dropped by the policy, -1 on error.
+ */
+int                 sc_v4l2_device_async_push (sc_v4l2_device_t * vd,
+                                               const char *frame);
+
+/** Query the counters of the writer thread.
+ * \param [in] vd       Opened device.
+ * \param [out] written If not NULL, the number of frames output.
+ * \param [out] dropped If not NULL, the number of frames dropped by the
+ *                      policy, by errors or by stopping a stalled device.
+ * \param [out] error   If not NULL, the errno of the last failed output
+ *                      or 0.
+ */
+void                sc_v4l2_device_async_stats (sc_v4l2_device_t * vd,
+                                                size_t *written,
+                                                size_t *dropped, int *error);
+
+/** Stop the writer thread after it has output the queued frames.
+ * Frames still queued when the device is not ready are dropped.
+ * It is legal to call this function when the thread is not started.
+ * The counters remain available afterwards.
+ * \param [in,out] vd   Opened device.
+ * \return          0 on success, -1 if an output has failed, setting errno.
+ */
+int                 sc_v4l2_device_async_stop (sc_v4l2_device_t * vd);
+
+/** Set output configuration of device with a choice of pixel format.
+ * The YUV formats are requested with BT.601 limited range encoding
+ * and need an even width, and the 4:2:0 formats an even height.
+ * The planes of \ref SC_V4L2_PIXEL_NV12 and \ref SC_V4L2_PIXEL_I420
+ * follow each other in one buffer, the chroma planes of the latter with
+ * half of \a bytesperline.
+ * \param [in,out] vd   Device must support the desired output format.
+ * \param [in] pixel    One of the output formats of \ref sc_v4l2_pixel_t.
+ * \param [in,out] width    Desired width on input, actual width on output.
+ * \param [in,out] height   Desired height on input, actual height on output.
+ * \param [out] bytesperline    Bytes per line of the first plane.
+ * \param [out] sizeimage       Bytes per image, including padding.
+ * \return          0 on success, -1 otherwise and setting errno.
+ */
+int                 sc_v4l2_device_format_ext (sc_v4l2_device_t * vd,
+                                               sc_v4l2_pixel_t pixel,
+                                               unsigned int *width,
+                                               unsigned int *height,
+                                               unsigned int *bytesperline,
+                                               unsigned int *sizeimage);
+
+/** Convert an RGB image into one of the output pixel formats.
+ * This function does not need a device and is always available.
+ * The layout of the output is the one of \ref sc_v4l2_device_format_ext.
+ * The rows are converted in bands by \ref sc_thread_fork_join.
+ * \param [in] srcformat    \ref SC_V4L2_PIXEL_RGB24 or SC_V4L2_PIXEL_RGBA.
+ * \param [in] src          Image of \a height rows.
+ * \param [in] srcstride    Bytes between consecutive rows of \a src.
+ * \param [in] destformat   One of the output formats.  The YUV formats
+ *                          need an even width, the 4:2:0 an even height.
+ * \param [out] dest        Buffer of the output image size.
+ * \param [in] bytesperline Bytes per line of the first output plane.
+ * \param [in] width        Width of the image in pixels.
+ * \param [in] height       Height of the image in pixels.
+ * \param [in] num_threads  Number of threads, or if not positive
+ *                          \ref sc_thread_default_count.
+ *                          Small images use fewer threads.
+ */
+void                sc_v4l2_convert (sc_v4l2_pixel_t srcformat,
+                                     const char *src, size_t srcstride,
+                                     sc_v4l2_pixel_t destformat, char *dest,
+                                     size_t bytesperline, unsigned width,
+                                     unsigned height, int num_threads);
+
+/** Convert an RGB image to the format of the device and output it.
+ * If streaming is started, the image is converted directly into the next
+ * buffer of the ring, and otherwise into a buffer of the device that is
+ * passed to \ref sc_v4l2_device_write.
+ * \param [in,out] vd   Device with its format set.
+ * \param [in] srcformat    \ref SC_V4L2_PIXEL_RGB24 or SC_V4L2_PIXEL_RGBA.
+ * \param [in] src          Image of the width and height of the format.
+ * \param [in] srcstride    Bytes between consecutive rows of \a src.
+ * \param [in] num_threads  Passed to \ref sc_v4l2_convert.
+ * \return          0 on success, -1 otherwise and setting errno.
+ */
+int                 sc_v4l2_device_write_rgb (sc_v4l2_device_t * vd,
+                                              sc_v4l2_pixel_t srcformat,
+                                              const char *src,
+                                              size_t srcstride,
+                                              int num_threads);
+
 SC_EXTERN_C_END;
 
 #endif /* SC_V4L2_H */
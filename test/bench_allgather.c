@@ -0,0 +1,194 @@
+/*
+  This file is part of the SC Library.
+  The SC Library provides support for parallel scientific applications.
+
+  Copyright (C) 2010 The University of Texas System
+  Additional copyright (C) 2011 individual authors
+
+  The SC Library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  The SC Library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with the SC Library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+  02110-1301, USA.
+*/
+
+/*
+ * Benchmark the allgather algorithms over group and message sizes.
+ * For every group size we print one line per message size with the
+ * slowest time of each algorithm and a line whenever the fastest one
+ * changes.  The thresholds of sc_allgather may be set on the command line
+ * to time its selection, which is reported in the last column.
+ */
+
+#include <sc_allgather.h>
+#include <sc_options.h>
+
+#define BENCH_NUM_ALGOS 5
+
+typedef void        (*bench_allgather_t) (sc_MPI_Comm mpicomm, char *data,
+                                          int datasize, int groupsize,
+                                          int myoffset, int myrank);
+
+static const char  *bench_names[BENCH_NUM_ALGOS] =
+  { "alltoall", "recursive", "ring", "bruck", "selected" };
+
+static void
+bench_selected (sc_MPI_Comm mpicomm, char *data, int datasize,
+                int groupsize, int myoffset, int myrank)
+{
+  int                 mpiret;
+
+  mpiret = sc_allgather (data + myoffset * datasize, datasize, sc_MPI_BYTE,
+                         data, datasize, sc_MPI_BYTE, mpicomm);
+  SC_CHECK_MPI (mpiret);
+}
+
+static const bench_allgather_t bench_algos[BENCH_NUM_ALGOS] =
+  { sc_allgather_alltoall, sc_allgather_recursive, sc_allgather_ring,
+  sc_allgather_bruck, bench_selected
+};
+
+static double
+bench_time (sc_MPI_Comm mpicomm, bench_allgather_t algo, char *data,
+            int datasize, int groupsize, int myrank, int repetitions)
+{
+  int                 mpiret;
+  int                 r;
+  double              elapsed, slowest;
+
+  mpiret = sc_MPI_Barrier (mpicomm);
+  SC_CHECK_MPI (mpiret);
+  elapsed = -sc_MPI_Wtime ();
+  for (r = 0; r < repetitions; ++r) {
+    algo (mpicomm, data, datasize, groupsize, myrank, myrank);
+  }
+  elapsed += sc_MPI_Wtime ();
+
+  mpiret = sc_MPI_Allreduce (&elapsed, &slowest, 1, sc_MPI_DOUBLE,
+                             sc_MPI_MAX, mpicomm);
+  SC_CHECK_MPI (mpiret);
+  return slowest / repetitions;
+}
+
+static void
+bench_group (sc_MPI_Comm mpicomm, int groupsize, int max_bytes,
+             int repetitions)
+{
+  int                 mpiret;
+  int                 myrank;
+  int                 datasize;
+  int                 a, fastest, last_fastest;
+  double              t[BENCH_NUM_ALGOS];
+  char               *data;
+
+  mpiret = sc_MPI_Comm_rank (mpicomm, &myrank);
+  SC_CHECK_MPI (mpiret);
+
+  SC_GLOBAL_PRODUCTIONF ("Group size %d\n", groupsize);
+  SC_GLOBAL_PRODUCTIONF ("%10s %12s %12s %12s %12s %12s\n", "bytes",
+                         bench_names[0], bench_names[1], bench_names[2],
+                         bench_names[3], bench_names[4]);
+
+  data = SC_ALLOC (char, (size_t) groupsize * max_bytes);
+  memset (data, 0, (size_t) groupsize * max_bytes);
+  last_fastest = -1;
+  for (datasize = 1; datasize <= max_bytes; datasize *= 2) {
+    fastest = 0;
+    for (a = 0; a < BENCH_NUM_ALGOS; ++a) {
+      t[a] = bench_time (mpicomm, bench_algos[a], data, datasize,
+                         groupsize, myrank, repetitions);
+      if (a < BENCH_NUM_ALGOS - 1 && t[a] < t[fastest]) {
+        fastest = a;
+      }
+    }
+    SC_GLOBAL_PRODUCTIONF ("%10d %12.3e %12.3e %12.3e %12.3e %12.3e\n",
+                           datasize, t[0], t[1], t[2], t[3], t[4]);
+    if (fastest != last_fastest) {
+      SC_GLOBAL_PRODUCTIONF ("Crossover to %s at group size %d"
+                             " and %d bytes\n", bench_names[fastest],
+                             groupsize, datasize);
+      last_fastest = fastest;
+    }
+  }
+  SC_FREE (data);
+}
+
+int
+main (int argc, char **argv)
+{
+  int                 mpiret;
+  int                 mpisize, mpirank;
+  int                 first_arg;
+  int                 groupsize, max_bytes, repetitions;
+  int                 alltoall_max;
+  size_t              ring_bytes, bruck_bytes;
+  sc_MPI_Comm         mpicomm, subcomm;
+  sc_options_t       *opt;
+
+  mpiret = sc_MPI_Init (&argc, &argv);
+  SC_CHECK_MPI (mpiret);
+  mpicomm = sc_MPI_COMM_WORLD;
+  mpiret = sc_MPI_Comm_size (mpicomm, &mpisize);
+  SC_CHECK_MPI (mpiret);
+  mpiret = sc_MPI_Comm_rank (mpicomm, &mpirank);
+  SC_CHECK_MPI (mpiret);
+
+  sc_init (mpicomm, 1, 1, NULL, SC_LP_PRODUCTION);
+
+  opt = sc_options_new (argv[0]);
+  sc_options_add_int (opt, 'm', "max-bytes", &max_bytes, 1 << 20,
+                      "Largest message size per process");
+  sc_options_add_int (opt, 'r', "repetitions", &repetitions, 10,
+                      "Repetitions per measurement");
+  sc_options_add_int (opt, 'a', "alltoall-max", &alltoall_max,
+                      sc_allgather_alltoall_max,
+                      "Largest group size using all-to-all");
+  sc_options_add_size_t (opt, 'g', "ring-bytes", &ring_bytes,
+                         sc_allgather_ring_bytes,
+                         "Smallest gathered size using the ring");
+  sc_options_add_size_t (opt, 'b', "bruck-bytes", &bruck_bytes,
+                         sc_allgather_bruck_bytes,
+                         "Largest message size using Bruck");
+  first_arg = sc_options_parse (sc_package_id, SC_LP_ERROR, opt, argc, argv);
+  if (first_arg < 0 || max_bytes <= 0 || repetitions <= 0) {
+    sc_options_print_usage (sc_package_id, SC_LP_ERROR, opt, NULL);
+    sc_abort_collective ("Option parsing failed");
+  }
+  sc_options_print_summary (sc_package_id, SC_LP_PRODUCTION, opt);
+
+  sc_allgather_alltoall_max = alltoall_max;
+  sc_allgather_ring_bytes = ring_bytes;
+  sc_allgather_bruck_bytes = bruck_bytes;
+
+  /* use the first processes for every power of two and the full size */
+  for (groupsize = 2; groupsize < 2 * mpisize; groupsize *= 2) {
+    groupsize = SC_MIN (groupsize, mpisize);
+    mpiret = sc_MPI_Comm_split (mpicomm, mpirank < groupsize ? 0 :
+                                sc_MPI_UNDEFINED, mpirank, &subcomm);
+    SC_CHECK_MPI (mpiret);
+    if (subcomm != sc_MPI_COMM_NULL) {
+      bench_group (subcomm, groupsize, max_bytes, repetitions);
+      mpiret = sc_MPI_Comm_free (&subcomm);
+      SC_CHECK_MPI (mpiret);
+    }
+    mpiret = sc_MPI_Barrier (mpicomm);
+    SC_CHECK_MPI (mpiret);
+  }
+
+  sc_options_destroy (opt);
+  sc_finalize ();
+
+  mpiret = sc_MPI_Finalize ();
+  SC_CHECK_MPI (mpiret);
+
+  return 0;
+}
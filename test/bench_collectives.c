@@ -0,0 +1,493 @@
+/*
+  This file is part of the SC Library.
+  The SC Library provides support for parallel scientific applications.
+
+  Copyright (C) 2010 The University of Texas System
+  Additional copyright (C) 2011 individual authors
+
+  The SC Library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  The SC Library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with the SC Library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+  02110-1301, USA.
+*/
+
+/*
+ * Benchmark the collective algorithms of the library to choose defaults.
+ * We use the first processes for every power of two and the full size as
+ * in bench_allgather.  On each group we time every notify type on three
+ * sparsity patterns, the allgather and reduction variants and every shmem
+ * type over message sizes, and both parallel sorts.  The times of all
+ * repetitions and processes of a group are summarized by sc_stats_compute
+ * and printed, and optionally written as CSV.
+ */
+
+#include <sc_allgather.h>
+#include <sc_notify.h>
+#include <sc_options.h>
+#include <sc_random.h>
+#include <sc_reduce.h>
+#include <sc_shmem.h>
+#include <sc_sort.h>
+#include <sc_statistics.h>
+
+/** The sparsity patterns of the notify benchmark. */
+typedef enum
+{
+  BENCH_PATTERN_RANDOM,         /**< Random distinct receivers. */
+  BENCH_PATTERN_NEIGHBOR,       /**< The nearest ranks on a ring. */
+  BENCH_PATTERN_POWERLAW,       /**< Few processes send to many. */
+  BENCH_NUM_PATTERNS
+}
+bench_pattern_t;
+
+static const char  *bench_pattern_names[BENCH_NUM_PATTERNS] =
+  { "random", "neighbor", "powerlaw" };
+
+#define BENCH_NUM_ALLGATHERS 6
+
+typedef void        (*bench_allgather_t) (sc_MPI_Comm mpicomm, char *data,
+                                          int datasize, int groupsize,
+                                          int myoffset, int myrank);
+
+static const char  *bench_allgather_names[BENCH_NUM_ALLGATHERS] =
+  { "alltoall", "recursive", "ring", "bruck", "selected", "mpi" };
+
+/** The state of one group of processes. */
+typedef struct bench_group
+{
+  sc_MPI_Comm         mpicomm;
+  int                 size, rank;
+  int                 repetitions;
+  FILE               *csv;      /**< NULL except on the first process. */
+}
+bench_group_t;
+
+static void
+bench_selected (sc_MPI_Comm mpicomm, char *data, int datasize,
+                int groupsize, int myoffset, int myrank)
+{
+  int                 mpiret;
+
+  mpiret = sc_allgather (data + myoffset * datasize, datasize, sc_MPI_BYTE,
+                         data, datasize, sc_MPI_BYTE, mpicomm);
+  SC_CHECK_MPI (mpiret);
+}
+
+static void
+bench_mpi (sc_MPI_Comm mpicomm, char *data, int datasize,
+           int groupsize, int myoffset, int myrank)
+{
+  int                 mpiret;
+  char               *sendbuf;
+
+  /* the send buffer must not alias the receive buffer */
+  sendbuf = SC_ALLOC (char, datasize);
+  memcpy (sendbuf, data + myoffset * datasize, datasize);
+  mpiret = sc_MPI_Allgather (sendbuf, datasize, sc_MPI_BYTE,
+                             data, datasize, sc_MPI_BYTE, mpicomm);
+  SC_CHECK_MPI (mpiret);
+  SC_FREE (sendbuf);
+}
+
+static const bench_allgather_t bench_allgathers[BENCH_NUM_ALLGATHERS] =
+  { sc_allgather_alltoall, sc_allgather_recursive, sc_allgather_ring,
+  sc_allgather_bruck, bench_selected, bench_mpi
+};
+
+/** Summarize the times of a phase over the group and print them. */
+static void
+bench_report (bench_group_t * g, const char *phase, const char *variant,
+              const char *pattern, size_t bytes, sc_statinfo_t * stats)
+{
+  sc_stats_compute (g->mpicomm, 1, stats);
+  SC_GLOBAL_PRODUCTIONF ("%6d %-10s %-14s %-9s %9llu %12.3e %12.3e"
+                         " %12.3e\n", g->size, phase, variant, pattern,
+                         (unsigned long long) bytes, stats->average,
+                         stats->min, stats->max);
+  if (g->csv != NULL) {
+    fprintf (g->csv, "%d,%s,%s,%s,%llu,%ld,%.6e,%.6e,%.6e,%.6e\n",
+             g->size, phase, variant, pattern, (unsigned long long) bytes,
+             stats->count, stats->average, stats->standev, stats->min,
+             stats->max);
+  }
+}
+
+/** Time one call on every process after a barrier. */
+#define BENCH_TIME(g,stats,call) do {                                   \
+    int                 bench_r, bench_mpiret;                          \
+    double              bench_t;                                        \
+    sc_stats_init ((stats), NULL);                                      \
+    for (bench_r = -1; bench_r < (g)->repetitions; ++bench_r) {         \
+      bench_mpiret = sc_MPI_Barrier ((g)->mpicomm);                     \
+      SC_CHECK_MPI (bench_mpiret);                                      \
+      bench_t = -sc_MPI_Wtime ();                                       \
+      call;                                                             \
+      bench_t += sc_MPI_Wtime ();                                       \
+      if (bench_r >= 0) {                                               \
+        sc_stats_accumulate ((stats), bench_t);                         \
+      }                                                                 \
+    }} while (0)
+
+/** Choose the sorted receivers of this process for a pattern. */
+static void
+bench_receivers (bench_group_t * g, bench_pattern_t pattern, int degree,
+                 sc_array_t * receivers)
+{
+  int                 i, k, num;
+  sc_rand_state_t     state = (sc_rand_state_t) g->rank;
+
+  sc_array_truncate (receivers);
+  if (g->size == 1) {
+    return;
+  }
+  num = SC_MIN (degree, g->size - 1);
+  if (pattern == BENCH_PATTERN_POWERLAW) {
+    /* the degree falls off like 1 / (rank + 1) about the given mean */
+    num = (int) ((double) degree * g->size /
+                 ((g->rank + 1) * (1. + SC_LOG2_32 (g->size))));
+    num = SC_MAX (1, SC_MIN (num, g->size - 1));
+  }
+  if (pattern == BENCH_PATTERN_NEIGHBOR) {
+    for (k = 1; (int) receivers->elem_count < num; ++k) {
+      *(int *) sc_array_push (receivers) = (g->rank + k) % g->size;
+      if ((int) receivers->elem_count < num) {
+        *(int *) sc_array_push (receivers) =
+          (g->rank + g->size - k) % g->size;
+      }
+    }
+  }
+  else {
+    for (i = 0; i < num; ++i) {
+      do {
+        k = (int) (sc_rand (&state) * g->size);
+      }
+      while (k == g->rank);
+      *(int *) sc_array_push (receivers) = k;
+    }
+  }
+  sc_array_sort (receivers, sc_int_compare);
+  sc_array_uniq (receivers, sc_int_compare);
+}
+
+static void
+bench_notify_payload (sc_array_t * receivers, sc_array_t * senders,
+                      sc_array_t * payload, sc_array_t * in_payload,
+                      sc_array_t * out_payload, sc_notify_t * notify)
+{
+  /* some algorithms expect empty output arrays and consume the input */
+  sc_array_copy (in_payload, payload);
+  sc_array_truncate (senders);
+  sc_array_truncate (out_payload);
+  sc_notify_payload (receivers, senders, in_payload, out_payload, 1,
+                     notify);
+}
+
+/** Return whether a name is an entry of a comma separated list. */
+static int
+bench_listed (const char *list, const char *name)
+{
+  size_t              len = strlen (name);
+
+  while (list != NULL) {
+    if (!strncmp (list, name, len) &&
+        (list[len] == ',' || list[len] == '\0')) {
+      return 1;
+    }
+    list = strchr (list, ',');
+    if (list != NULL) {
+      ++list;
+    }
+  }
+  return 0;
+}
+
+static void
+bench_notify (bench_group_t * g, const char *types, int degree,
+              int payload_bytes)
+{
+  int                 p, t;
+  sc_array_t         *receivers, *senders, *payload;
+  sc_array_t         *in_payload, *out_payload;
+  sc_notify_t        *notify;
+  sc_statinfo_t       stats;
+
+  receivers = sc_array_new (sizeof (int));
+  senders = sc_array_new (sizeof (int));
+  payload = sc_array_new (payload_bytes);
+  in_payload = sc_array_new (payload_bytes);
+  out_payload = sc_array_new (payload_bytes);
+  for (p = 0; p < BENCH_NUM_PATTERNS; ++p) {
+    bench_receivers (g, (bench_pattern_t) p, degree, receivers);
+    sc_array_resize (payload, receivers->elem_count);
+    memset (payload->array, 0, payload->elem_count * payload_bytes);
+    for (t = 0; t < SC_NOTIFY_NUM_TYPES; ++t) {
+      /* the superset type needs an application callback */
+      if (t == SC_NOTIFY_SUPERSET || (types != NULL &&
+                                      !bench_listed (types,
+                                                     sc_notify_type_strings
+                                                     [t]))) {
+        continue;
+      }
+#ifndef SC_ENABLE_MPI
+      if (t == SC_NOTIFY_PCX || t == SC_NOTIFY_RSX || t == SC_NOTIFY_NBX) {
+        continue;
+      }
+#endif
+      notify = sc_notify_new (g->mpicomm);
+      sc_notify_set_type (notify, (sc_notify_type_t) t);
+      BENCH_TIME (g, &stats,
+                  bench_notify_payload (receivers, senders, payload,
+                                        in_payload, out_payload, notify));
+      bench_report (g, "notify", sc_notify_type_strings[t],
+                    bench_pattern_names[p], (size_t) payload_bytes,
+                    &stats);
+      sc_notify_destroy (notify);
+    }
+  }
+  sc_array_destroy (receivers);
+  sc_array_destroy (senders);
+  sc_array_destroy (payload);
+  sc_array_destroy (in_payload);
+  sc_array_destroy (out_payload);
+}
+
+static void
+bench_allgather (bench_group_t * g, int max_bytes)
+{
+  int                 a, bytes;
+  char               *data;
+  sc_statinfo_t       stats;
+
+  data = SC_ALLOC_ZERO (char, (size_t) g->size * max_bytes);
+  for (bytes = 1; bytes <= max_bytes; bytes *= 4) {
+    for (a = 0; a < BENCH_NUM_ALLGATHERS; ++a) {
+      BENCH_TIME (g, &stats, bench_allgathers[a] (g->mpicomm, data, bytes,
+                                                  g->size, g->rank,
+                                                  g->rank));
+      bench_report (g, "allgather", bench_allgather_names[a], "",
+                    (size_t) bytes, &stats);
+    }
+  }
+  SC_FREE (data);
+}
+
+static void
+bench_mpi_allreduce (int *sendbuf, int *recvbuf, int count,
+                     sc_MPI_Comm mpicomm)
+{
+  int                 mpiret;
+
+  mpiret = sc_MPI_Allreduce (sendbuf, recvbuf, count, sc_MPI_INT,
+                             sc_MPI_SUM, mpicomm);
+  SC_CHECK_MPI (mpiret);
+}
+
+static void
+bench_reduce (bench_group_t * g, int max_bytes)
+{
+  int                 count;
+  size_t              bytes;
+  int                *sendbuf, *recvbuf;
+  sc_statinfo_t       stats;
+
+  count = SC_MAX (1, max_bytes / (int) sizeof (int));
+  sendbuf = SC_ALLOC_ZERO (int, count);
+  recvbuf = SC_ALLOC (int, count);
+  for (count = 1; count * sizeof (int) <= (size_t) SC_MAX (max_bytes, 4);
+       count *= 4) {
+    bytes = count * sizeof (int);
+    BENCH_TIME (g, &stats, sc_allreduce (sendbuf, recvbuf, count,
+                                         sc_MPI_INT, sc_MPI_SUM,
+                                         g->mpicomm));
+    bench_report (g, "reduce", "sc_allreduce", "", bytes, &stats);
+    BENCH_TIME (g, &stats, sc_reduce (sendbuf, recvbuf, count, sc_MPI_INT,
+                                      sc_MPI_SUM, 0, g->mpicomm));
+    bench_report (g, "reduce", "sc_reduce", "", bytes, &stats);
+    BENCH_TIME (g, &stats, bench_mpi_allreduce (sendbuf, recvbuf, count,
+                                                g->mpicomm));
+    bench_report (g, "reduce", "mpi", "", bytes, &stats);
+  }
+  SC_FREE (sendbuf);
+  SC_FREE (recvbuf);
+}
+
+static void
+bench_shmem (bench_group_t * g, int max_bytes)
+{
+  int                 t, bytes;
+  char               *sendbuf, *array;
+  sc_statinfo_t       stats;
+
+  sendbuf = SC_ALLOC_ZERO (char, max_bytes);
+  for (t = 0; t < SC_SHMEM_NUM_TYPES; ++t) {
+    sc_shmem_set_type (g->mpicomm, (sc_shmem_type_t) t);
+    for (bytes = 1; bytes <= max_bytes; bytes *= 4) {
+      array = (char *) sc_shmem_malloc (sc_package_id, 1,
+                                        (size_t) g->size * bytes,
+                                        g->mpicomm);
+      BENCH_TIME (g, &stats, sc_shmem_allgather (sendbuf, bytes,
+                                                 sc_MPI_BYTE, array, bytes,
+                                                 sc_MPI_BYTE, g->mpicomm));
+      bench_report (g, "shmem", sc_shmem_type_to_string[t], "",
+                    (size_t) bytes, &stats);
+      sc_shmem_free (sc_package_id, array, g->mpicomm);
+    }
+  }
+  SC_FREE (sendbuf);
+}
+
+static void
+bench_psort (bench_group_t * g, int max_bytes)
+{
+  int                 v, r, i, mpiret;
+  size_t              n, *nmemb;
+  double             *data, t;
+  sc_rand_state_t     state = (sc_rand_state_t) g->rank;
+  sc_statinfo_t       stats;
+
+  n = SC_MAX (1, (size_t) max_bytes / sizeof (double));
+  data = SC_ALLOC (double, n);
+  nmemb = SC_ALLOC (size_t, g->size);
+  for (i = 0; i < g->size; ++i) {
+    nmemb[i] = n;
+  }
+  for (v = 0; v < 2; ++v) {
+    /* the data is renewed outside of the time of every repetition */
+    sc_stats_init (&stats, NULL);
+    for (r = -1; r < g->repetitions; ++r) {
+      for (i = 0; i < (int) n; ++i) {
+        data[i] = sc_rand (&state);
+      }
+      mpiret = sc_MPI_Barrier (g->mpicomm);
+      SC_CHECK_MPI (mpiret);
+      t = -sc_MPI_Wtime ();
+      if (v == 0) {
+        sc_psort (g->mpicomm, data, nmemb, sizeof (double),
+                  sc_double_compare);
+      }
+      else {
+        sc_psort_sample (g->mpicomm, data, nmemb, sizeof (double),
+                         sc_double_compare);
+      }
+      t += sc_MPI_Wtime ();
+      if (r >= 0) {
+        sc_stats_accumulate (&stats, t);
+      }
+    }
+    bench_report (g, "psort", v == 0 ? "bitonic" : "sample", "",
+                  n * sizeof (double), &stats);
+  }
+  SC_FREE (data);
+  SC_FREE (nmemb);
+}
+
+int
+main (int argc, char **argv)
+{
+  int                 mpiret;
+  int                 mpisize, mpirank;
+  int                 first_arg;
+  int                 groupsize, max_bytes, repetitions, degree, payload;
+  int                 sort_bytes;
+  const char         *csvname, *types;
+  FILE               *csv = NULL;
+  sc_MPI_Comm         mpicomm, subcomm;
+  sc_options_t       *opt;
+  bench_group_t       g;
+
+  mpiret = sc_MPI_Init (&argc, &argv);
+  SC_CHECK_MPI (mpiret);
+  mpicomm = sc_MPI_COMM_WORLD;
+  mpiret = sc_MPI_Comm_size (mpicomm, &mpisize);
+  SC_CHECK_MPI (mpiret);
+  mpiret = sc_MPI_Comm_rank (mpicomm, &mpirank);
+  SC_CHECK_MPI (mpiret);
+
+  sc_init (mpicomm, 1, 1, NULL, SC_LP_PRODUCTION);
+
+  opt = sc_options_new (argv[0]);
+  sc_options_add_int (opt, 'm', "max-bytes", &max_bytes, 1 << 16,
+                      "Largest message size per process");
+  sc_options_add_int (opt, 'r', "repetitions", &repetitions, 5,
+                      "Repetitions per measurement");
+  sc_options_add_int (opt, 'd', "degree", &degree, 8,
+                      "Typical number of receivers in sc_notify");
+  sc_options_add_int (opt, 'p', "payload", &payload, 8,
+                      "Payload bytes per message in sc_notify");
+  sc_options_add_int (opt, 's', "sort-bytes", &sort_bytes, 1 << 20,
+                      "Bytes per process to sort");
+  sc_options_add_string (opt, 't', "notify-types", &types, NULL,
+                         "Comma separated sc_notify types to run"
+                         " instead of all");
+  sc_options_add_string (opt, 'c', "csv", &csvname, NULL,
+                         "Write the summaries to this CSV file");
+  first_arg = sc_options_parse (sc_package_id, SC_LP_ERROR, opt, argc, argv);
+  if (first_arg < 0 || max_bytes <= 0 || repetitions <= 0 ||
+      degree <= 0 || payload <= 0 || sort_bytes <= 0) {
+    sc_options_print_usage (sc_package_id, SC_LP_ERROR, opt, NULL);
+    sc_abort_collective ("Option parsing failed");
+  }
+  sc_options_print_summary (sc_package_id, SC_LP_PRODUCTION, opt);
+
+  if (csvname != NULL && mpirank == 0) {
+    csv = fopen (csvname, "w");
+    SC_CHECK_ABORT (csv != NULL, "Open CSV file");
+    fprintf (csv, "processes,phase,variant,pattern,bytes,count,"
+             "mean,standev,min,max\n");
+  }
+  SC_GLOBAL_PRODUCTIONF ("%6s %-10s %-14s %-9s %9s %12s %12s %12s\n",
+                         "procs", "phase", "variant", "pattern", "bytes",
+                         "mean", "min", "max");
+
+  /* use the first processes for every power of two and the full size */
+  for (groupsize = 1; groupsize < 2 * mpisize; groupsize *= 2) {
+    groupsize = SC_MIN (groupsize, mpisize);
+    mpiret = sc_MPI_Comm_split (mpicomm, mpirank < groupsize ? 0 :
+                                sc_MPI_UNDEFINED, mpirank, &subcomm);
+    SC_CHECK_MPI (mpiret);
+    if (subcomm != sc_MPI_COMM_NULL) {
+      g.mpicomm = subcomm;
+      g.size = groupsize;
+      mpiret = sc_MPI_Comm_rank (subcomm, &g.rank);
+      SC_CHECK_MPI (mpiret);
+      g.repetitions = repetitions;
+      g.csv = csv;
+
+      /* the hierarchical notify and the shmem windows need them */
+      sc_mpi_comm_attach_node_comms (subcomm, 0);
+      bench_notify (&g, types, degree, payload);
+      bench_allgather (&g, max_bytes);
+      bench_reduce (&g, max_bytes);
+      bench_shmem (&g, max_bytes);
+      bench_psort (&g, sort_bytes);
+      sc_mpi_comm_detach_node_comms (subcomm);
+
+      mpiret = sc_MPI_Comm_free (&subcomm);
+      SC_CHECK_MPI (mpiret);
+    }
+    mpiret = sc_MPI_Barrier (mpicomm);
+    SC_CHECK_MPI (mpiret);
+  }
+
+  if (csv != NULL) {
+    SC_CHECK_ABORT (fclose (csv) == 0, "Close CSV file");
+  }
+
+  sc_options_destroy (opt);
+  sc_finalize ();
+
+  mpiret = sc_MPI_Finalize ();
+  SC_CHECK_MPI (mpiret);
+
+  return 0;
+}
@@ -0,0 +1,432 @@
+/*
+  This file is part of the SC Library.
+  The SC Library provides support for parallel scientific applications.
+
+  Copyright (C) 2010 The University of Texas System
+  Additional copyright (C) 2011 individual authors
+
+  The SC Library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  The SC Library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with the SC Library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+  02110-1301, USA.
+*/
+
+/*
+ * Benchmark the containers and the sorting and searching functions.
+ * Each case runs on a random permutation of the numbers below a size that
+ * grows by a factor of four.  We time every repetition by sc_flops and
+ * reduce the times of all processes into a sc_statinfo_t per case and size.
+ * A table is printed and the summaries may be written as JSON to a file,
+ * to be compared between versions of the library.  The array_copy cases
+ * compare cached, streaming and threaded copies to locate the crossover
+ * size for sc_array_stream_bytes.
+ */
+
+#include <sc_avl.h>
+#include <sc_containers.h>
+#include <sc_options.h>
+#include <sc_random.h>
+#include <sc_search.h>
+#include <sc_statistics.h>
+
+/** The data shared by the benchmark cases of one size. */
+typedef struct bench_data
+{
+  size_t              n;
+  int                *keys;     /**< Random permutation of 0 ... n - 1. */
+  int                *sorted;   /**< The numbers 0 ... n - 1. */
+  int64_t            *sorted64; /**< Same as 64-bit integers. */
+  void              **ptrs;     /**< Workspace of n pointers. */
+  sc_array_t          work;     /**< Workspace of integers. */
+  size_t              checksum; /**< Defeat dead code elimination. */
+}
+bench_data_t;
+
+typedef void        (*bench_fn_t) (bench_data_t * d);
+
+/** A benchmark case with optional untimed preparation. */
+typedef struct bench_case
+{
+  const char         *name;
+  bench_fn_t          prepare;
+  bench_fn_t          run;
+}
+bench_case_t;
+
+static unsigned int
+bench_int_hash (const void *v, const void *u)
+{
+  return (unsigned int) *(const int *) v * 2654435761U;
+}
+
+static int
+bench_int_equal (const void *v1, const void *v2, const void *u)
+{
+  return *(const int *) v1 == *(const int *) v2;
+}
+
+static void
+bench_copy_keys (bench_data_t * d)
+{
+  sc_array_resize (&d->work, d->n);
+  memcpy (d->work.array, d->keys, d->n * sizeof (int));
+}
+
+static void
+bench_copy_sorted (bench_data_t * d, int stream, int threads)
+{
+  size_t              saved = sc_array_stream_bytes;
+  sc_array_t          view;
+
+  sc_array_init_data (&view, d->sorted, sizeof (int), d->n);
+  sc_array_stream_bytes = stream ? 0 : SIZE_MAX;
+  if (threads) {
+    sc_array_copy_parallel (&d->work, &view, 0);
+  }
+  else {
+    sc_array_copy (&d->work, &view);
+  }
+  sc_array_stream_bytes = saved;
+  d->checksum += (size_t) *(int *) sc_array_index (&d->work, d->n - 1);
+}
+
+static void
+bench_array_copy (bench_data_t * d)
+{
+  bench_copy_sorted (d, 0, 0);
+}
+
+static void
+bench_array_copy_stream (bench_data_t * d)
+{
+  bench_copy_sorted (d, 1, 0);
+}
+
+static void
+bench_array_copy_threads (bench_data_t * d)
+{
+  bench_copy_sorted (d, 0, 1);
+}
+
+static void
+bench_array_copy_both (bench_data_t * d)
+{
+  bench_copy_sorted (d, 1, 1);
+}
+
+static void
+bench_array_push (bench_data_t * d)
+{
+  size_t              i;
+  sc_array_t          a;
+
+  sc_array_init (&a, sizeof (int));
+  for (i = 0; i < d->n; ++i) {
+    *(int *) sc_array_push (&a) = d->keys[i];
+  }
+  d->checksum += a.elem_count;
+  sc_array_reset (&a);
+}
+
+static void
+bench_array_sort (bench_data_t * d)
+{
+  sc_array_sort (&d->work, sc_int_compare);
+  d->checksum += *(int *) sc_array_index (&d->work, d->n - 1);
+}
+
+static void
+bench_array_sort_radix (bench_data_t * d)
+{
+  sc_array_sort_radix (&d->work, 0, sizeof (int), sc_int_compare);
+  d->checksum += *(int *) sc_array_index (&d->work, d->n - 1);
+}
+
+static void
+bench_array_bsearch (bench_data_t * d)
+{
+  size_t              i;
+  sc_array_t          view;
+
+  sc_array_init_data (&view, d->sorted, sizeof (int), d->n);
+  for (i = 0; i < d->n; ++i) {
+    d->checksum += (size_t) sc_array_bsearch (&view, &d->keys[i],
+                                              sc_int_compare);
+  }
+}
+
+static void
+bench_lower_bound64 (bench_data_t * d)
+{
+  size_t              i;
+
+  for (i = 0; i < d->n; ++i) {
+    d->checksum += (size_t) sc_search_lower_bound64 (d->keys[i],
+                                                     d->sorted64, d->n,
+                                                     d->n / 2);
+  }
+}
+
+static void
+bench_hash (bench_data_t * d)
+{
+  size_t              i;
+  void              **found;
+  sc_hash_t          *hash;
+
+  hash = sc_hash_new (bench_int_hash, bench_int_equal, NULL, NULL);
+  for (i = 0; i < d->n; ++i) {
+    sc_hash_insert_unique (hash, &d->keys[i], NULL);
+  }
+  for (i = 0; i < d->n; ++i) {
+    d->checksum += (size_t) sc_hash_lookup (hash, &d->sorted[i], &found);
+  }
+  sc_hash_destroy (hash);
+}
+
+static void
+bench_mempool (bench_data_t * d)
+{
+  size_t              i;
+  sc_mempool_t       *mempool;
+
+  mempool = sc_mempool_new (sizeof (int));
+  for (i = 0; i < d->n; ++i) {
+    d->ptrs[i] = sc_mempool_alloc (mempool);
+    *(int *) d->ptrs[i] = d->keys[i];
+  }
+  /* return the elements in random order */
+  for (i = 0; i < d->n; ++i) {
+    sc_mempool_free (mempool, d->ptrs[d->keys[i]]);
+  }
+  d->checksum += mempool->elem_count;
+  sc_mempool_destroy (mempool);
+}
+
+static void
+bench_list (bench_data_t * d)
+{
+  size_t              i;
+  sc_list_t          *list;
+
+  list = sc_list_new (NULL);
+  for (i = 0; i < d->n; ++i) {
+    sc_list_append (list, &d->keys[i]);
+  }
+  while (list->elem_count > 0) {
+    d->checksum += (size_t) *(int *) sc_list_pop (list);
+  }
+  sc_list_destroy (list);
+}
+
+static void
+bench_avl (bench_data_t * d)
+{
+  size_t              i;
+  avl_tree_t         *tree;
+
+  tree = avl_alloc_tree (sc_int_compare, NULL);
+  for (i = 0; i < d->n; ++i) {
+    avl_insert (tree, &d->keys[i]);
+  }
+  for (i = 0; i < d->n; ++i) {
+    d->checksum += avl_search (tree, &d->sorted[i]) != NULL;
+  }
+  avl_free_tree (tree);
+}
+
+static const bench_case_t bench_cases[] = {
+  {"array_push", NULL, bench_array_push},
+  {"array_copy", bench_copy_keys, bench_array_copy},
+  {"array_copy_stream", bench_copy_keys, bench_array_copy_stream},
+  {"array_copy_threads", bench_copy_keys, bench_array_copy_threads},
+  {"array_copy_both", bench_copy_keys, bench_array_copy_both},
+  {"array_sort", bench_copy_keys, bench_array_sort},
+  {"array_sort_radix", bench_copy_keys, bench_array_sort_radix},
+  {"array_bsearch", NULL, bench_array_bsearch},
+  {"lower_bound64", NULL, bench_lower_bound64},
+  {"hash", NULL, bench_hash},
+  {"mempool", NULL, bench_mempool},
+  {"list", NULL, bench_list},
+  {"avl", NULL, bench_avl},
+  {NULL, NULL, NULL}
+};
+
+static void
+bench_data_init (bench_data_t * d, size_t n, sc_rand_state_t * state)
+{
+  size_t              i, j;
+  int                 swap;
+
+  d->n = n;
+  d->keys = SC_ALLOC (int, n);
+  d->sorted = SC_ALLOC (int, n);
+  d->sorted64 = SC_ALLOC (int64_t, n);
+  d->ptrs = SC_ALLOC (void *, n);
+  for (i = 0; i < n; ++i) {
+    d->keys[i] = d->sorted[i] = (int) i;
+    d->sorted64[i] = (int64_t) i;
+  }
+  for (i = n - 1; i > 0; --i) {
+    j = (size_t) (sc_rand (state) * (i + 1));
+    swap = d->keys[i];
+    d->keys[i] = d->keys[j];
+    d->keys[j] = swap;
+  }
+  sc_array_init (&d->work, sizeof (int));
+}
+
+static void
+bench_data_reset (bench_data_t * d)
+{
+  SC_FREE (d->keys);
+  SC_FREE (d->sorted);
+  SC_FREE (d->sorted64);
+  SC_FREE (d->ptrs);
+  sc_array_reset (&d->work);
+}
+
+/** Time the repetitions of one case into a summary over all processes. */
+static void
+bench_run (const bench_case_t * bc, bench_data_t * d, int warmups,
+           int repetitions, sc_flopinfo_t * fi, sc_statinfo_t * stats)
+{
+  int                 r;
+  sc_flopinfo_t       snap;
+
+  sc_stats_init (stats, bc->name);
+  sc_stats_set_histogram (stats, 1e-9, 1e3);
+  for (r = -warmups; r < repetitions; ++r) {
+    if (bc->prepare != NULL) {
+      bc->prepare (d);
+    }
+    sc_flops_snap (fi, &snap);
+    bc->run (d);
+    sc_flops_shot (fi, &snap);
+    if (r >= 0) {
+      sc_stats_accumulate (stats, snap.iwtime);
+    }
+  }
+  sc_stats_compute (sc_MPI_COMM_WORLD, 1, stats);
+}
+
+static void
+bench_json_entry (FILE * file, int first, size_t n, sc_statinfo_t * stats)
+{
+  fprintf (file, "%s\n    {\"name\": \"%s\", \"size\": %llu, "
+           "\"count\": %ld,\n     \"mean\": %.6e, \"standev\": %.6e, "
+           "\"min\": %.6e, \"max\": %.6e,\n     \"median\": %.6e, "
+           "\"ns_per_item\": %.6e}", first ? "" : ",", stats->variable,
+           (unsigned long long) n, stats->count, stats->average,
+           stats->standev, stats->min, stats->max,
+           sc_stats_quantile (stats, .5), 1e9 * stats->average / n);
+}
+
+int
+main (int argc, char **argv)
+{
+  int                 mpiret;
+  int                 mpisize, mpirank;
+  int                 first_arg;
+  int                 min_size, max_size, repetitions, warmups;
+  int                 c, first;
+  const char         *only, *json;
+  size_t              n;
+  FILE               *file = NULL;
+  bench_data_t        data;
+  sc_rand_state_t     state;
+  sc_flopinfo_t       fi;
+  sc_statinfo_t       stats;
+  sc_options_t       *opt;
+
+  mpiret = sc_MPI_Init (&argc, &argv);
+  SC_CHECK_MPI (mpiret);
+  mpiret = sc_MPI_Comm_size (sc_MPI_COMM_WORLD, &mpisize);
+  SC_CHECK_MPI (mpiret);
+  mpiret = sc_MPI_Comm_rank (sc_MPI_COMM_WORLD, &mpirank);
+  SC_CHECK_MPI (mpiret);
+
+  sc_init (sc_MPI_COMM_WORLD, 1, 1, NULL, SC_LP_PRODUCTION);
+
+  opt = sc_options_new (argv[0]);
+  sc_options_add_int (opt, 'n', "min-size", &min_size, 1 << 10,
+                      "Smallest number of items");
+  sc_options_add_int (opt, 'N', "max-size", &max_size, 1 << 20,
+                      "Largest number of items");
+  sc_options_add_int (opt, 'r', "repetitions", &repetitions, 10,
+                      "Timed repetitions per case and size");
+  sc_options_add_int (opt, 'w', "warmups", &warmups, 1,
+                      "Untimed repetitions before");
+  sc_options_add_string (opt, 'b', "bench", &only, NULL,
+                         "Run only the cases containing this string");
+  sc_options_add_string (opt, 'j', "json", &json, NULL,
+                         "Write the summaries to this JSON file");
+  first_arg = sc_options_parse (sc_package_id, SC_LP_ERROR, opt, argc, argv);
+  if (first_arg < 0 || min_size <= 0 || max_size < min_size ||
+      repetitions <= 0 || warmups < 0) {
+    sc_options_print_usage (sc_package_id, SC_LP_ERROR, opt, NULL);
+    sc_abort_collective ("Option parsing failed");
+  }
+  sc_options_print_summary (sc_package_id, SC_LP_PRODUCTION, opt);
+
+  if (json != NULL && mpirank == 0) {
+    file = fopen (json, "w");
+    SC_CHECK_ABORT (file != NULL, "Open JSON file");
+    fprintf (file, "{\n  \"benchmark\": \"sc_bench_containers\",\n"
+             "  \"version\": \"%s\",\n  \"processes\": %d,\n"
+             "  \"repetitions\": %d,\n  \"results\": [", sc_version (),
+             mpisize, repetitions);
+  }
+
+  SC_GLOBAL_PRODUCTIONF ("%-18s %10s %12s %12s %12s %12s %10s\n", "case",
+                         "size", "mean", "standev", "min", "max",
+                         "ns/item");
+  sc_flops_start_nopapi (&fi);
+  state = 0;
+  first = 1;
+  data.checksum = 0;
+  for (n = (size_t) min_size; n <= (size_t) max_size; n *= 4) {
+    bench_data_init (&data, n, &state);
+    for (c = 0; bench_cases[c].name != NULL; ++c) {
+      if (only != NULL && strstr (bench_cases[c].name, only) == NULL) {
+        continue;
+      }
+      bench_run (&bench_cases[c], &data, warmups, repetitions, &fi, &stats);
+      SC_GLOBAL_PRODUCTIONF ("%-18s %10llu %12.3e %12.3e %12.3e %12.3e"
+                             " %10.2f\n", bench_cases[c].name,
+                             (unsigned long long) n, stats.average,
+                             stats.standev, stats.min, stats.max,
+                             1e9 * stats.average / n);
+      if (file != NULL) {
+        bench_json_entry (file, first, n, &stats);
+      }
+      first = 0;
+      sc_stats_reset (&stats, 1);
+    }
+    bench_data_reset (&data);
+  }
+  SC_GLOBAL_LDEBUGF ("Checksum %llu\n", (unsigned long long) data.checksum);
+
+  if (file != NULL) {
+    fprintf (file, "\n  ]\n}\n");
+    SC_CHECK_ABORT (fclose (file) == 0, "Close JSON file");
+  }
+
+  sc_options_destroy (opt);
+  sc_finalize ();
+
+  mpiret = sc_MPI_Finalize ();
+  SC_CHECK_MPI (mpiret);
+
+  return 0;
+}
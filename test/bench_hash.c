@@ -0,0 +1,139 @@
+/*
+  This file is part of the SC Library.
+  The SC Library provides support for parallel scientific applications.
+
+  Copyright (C) 2010 The University of Texas System
+  Additional copyright (C) 2011 individual authors
+
+  The SC Library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  The SC Library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with the SC Library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+  02110-1301, USA.
+*/
+
+/*
+ * Benchmark the throughput of the string hash functions over key lengths.
+ * For every length we hash a set of distinct keys repeatedly and print
+ * the bytes hashed per second by the byte-wise and the word-wise hash.
+ * Each process measures on its own and the slowest result is reported.
+ */
+
+#include <sc_containers.h>
+#include <sc_options.h>
+
+#define BENCH_NUM_HASHES 3
+
+static const char  *bench_names[BENCH_NUM_HASHES] =
+  { "string", "string_fast", "bytes" };
+
+static unsigned int
+bench_bytes (const void *v, const void *u)
+{
+  sc_hash_bytes_t     b;
+
+  b.data = v;
+  b.size = *(const size_t *) u;
+  return sc_hash_function_bytes (&b, NULL);
+}
+
+static const sc_hash_function_t bench_hashes[BENCH_NUM_HASHES] =
+  { sc_hash_function_string, sc_hash_function_string_fast, bench_bytes };
+
+static double
+bench_rate (sc_hash_function_t hash_fn, const char *keys, size_t keylen,
+            int num_keys, int repetitions, unsigned int *sum)
+{
+  int                 mpiret;
+  int                 r, k;
+  double              elapsed, slowest;
+
+  elapsed = -sc_MPI_Wtime ();
+  for (r = 0; r < repetitions; ++r) {
+    for (k = 0; k < num_keys; ++k) {
+      *sum += hash_fn (keys + k * (keylen + 1), &keylen);
+    }
+  }
+  elapsed += sc_MPI_Wtime ();
+
+  mpiret = sc_MPI_Allreduce (&elapsed, &slowest, 1, sc_MPI_DOUBLE,
+                             sc_MPI_MAX, sc_MPI_COMM_WORLD);
+  SC_CHECK_MPI (mpiret);
+  return (double) keylen * num_keys * repetitions / slowest;
+}
+
+int
+main (int argc, char **argv)
+{
+  int                 mpiret;
+  int                 first_arg;
+  int                 max_length, num_keys, repetitions;
+  int                 h, k;
+  size_t              keylen, i;
+  unsigned int        sum;
+  double              rate[BENCH_NUM_HASHES];
+  char               *keys;
+  sc_options_t       *opt;
+
+  mpiret = sc_MPI_Init (&argc, &argv);
+  SC_CHECK_MPI (mpiret);
+
+  sc_init (sc_MPI_COMM_WORLD, 1, 1, NULL, SC_LP_PRODUCTION);
+
+  opt = sc_options_new (argv[0]);
+  sc_options_add_int (opt, 'l', "max-length", &max_length, 4096,
+                      "Longest key in bytes");
+  sc_options_add_int (opt, 'k', "num-keys", &num_keys, 1000,
+                      "Number of distinct keys per length");
+  sc_options_add_int (opt, 'r', "repetitions", &repetitions, 0,
+                      "Repetitions per length, 0 for about 1e8 bytes");
+  first_arg = sc_options_parse (sc_package_id, SC_LP_ERROR, opt, argc, argv);
+  if (first_arg < 0 || max_length <= 0 || num_keys <= 0 ||
+      repetitions < 0) {
+    sc_options_print_usage (sc_package_id, SC_LP_ERROR, opt, NULL);
+    sc_abort_collective ("Option parsing failed");
+  }
+  sc_options_print_summary (sc_package_id, SC_LP_PRODUCTION, opt);
+
+  SC_GLOBAL_PRODUCTIONF ("%10s %14s %14s %14s\n", "bytes", bench_names[0],
+                         bench_names[1], bench_names[2]);
+  sum = 0;
+  for (keylen = 1; keylen <= (size_t) max_length; keylen *= 2) {
+    /* distinct printable keys stored back to back with terminators */
+    keys = SC_ALLOC (char, (keylen + 1) * num_keys);
+    for (k = 0; k < num_keys; ++k) {
+      for (i = 0; i < keylen; ++i) {
+        keys[k * (keylen + 1) + i] = (char) ('a' + (k + i * 7) % 26);
+      }
+      keys[k * (keylen + 1) + keylen] = '\0';
+    }
+    for (h = 0; h < BENCH_NUM_HASHES; ++h) {
+      rate[h] = bench_rate (bench_hashes[h], keys, keylen, num_keys,
+                            repetitions > 0 ? repetitions :
+                            (int) SC_MAX (1, 100000000 /
+                                          (keylen * num_keys)), &sum);
+    }
+    SC_GLOBAL_PRODUCTIONF ("%10llu %14.3e %14.3e %14.3e\n",
+                           (unsigned long long) keylen,
+                           rate[0], rate[1], rate[2]);
+    SC_FREE (keys);
+  }
+  SC_GLOBAL_LDEBUGF ("Checksum %u\n", sum);
+
+  sc_options_destroy (opt);
+  sc_finalize ();
+
+  mpiret = sc_MPI_Finalize ();
+  SC_CHECK_MPI (mpiret);
+
+  return 0;
+}
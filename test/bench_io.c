@@ -0,0 +1,415 @@
+/*
+  This file is part of the SC Library.
+  The SC Library provides support for parallel scientific applications.
+
+  Copyright (C) 2010 The University of Texas System
+  Additional copyright (C) 2011 individual authors
+
+  The SC Library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  The SC Library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with the SC Library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+  02110-1301, USA.
+*/
+
+/*
+ * Benchmark the throughput of the I/O functions of the library.
+ * Every process writes and reads its own data through the sinks and
+ * sources of each type, encodes and decodes it at several compression
+ * levels and writes it in the compressed VTK format.  Then the first
+ * processes for every power of two and all of them write and read one
+ * block each collectively by sc_io_write_at_all and sc_io_read_at_all.
+ * We report the slowest process and the bytes of all processes per second,
+ * and for encoded data the ratio of original to encoded bytes.
+ * The file operations are timed from opening to closing the file.
+ * The collective files are opened with the MPI I/O hints of the options.
+ */
+
+#include <sc_io.h>
+#include <sc_options.h>
+
+/** The state shared by all phases. */
+typedef struct bench_io
+{
+  sc_MPI_Comm         mpicomm;
+  int                 size, rank;
+  int                 repetitions;
+  const char         *prefix;   /**< Prefix of the file names. */
+  char                filename[BUFSIZ];         /**< Of this process. */
+  size_t              bytes;    /**< Of data per process. */
+  char               *data;
+  sc_io_hints_t       hints;    /**< Of the collective files. */
+}
+bench_io_t;
+
+/** Return the slowest time over all processes of a communicator. */
+static double
+bench_slowest (sc_MPI_Comm mpicomm, double elapsed)
+{
+  int                 mpiret;
+  double              slowest;
+
+  mpiret = sc_MPI_Allreduce (&elapsed, &slowest, 1, sc_MPI_DOUBLE,
+                             sc_MPI_MAX, mpicomm);
+  SC_CHECK_MPI (mpiret);
+  return slowest;
+}
+
+static void
+bench_barrier (sc_MPI_Comm mpicomm)
+{
+  int                 mpiret;
+
+  mpiret = sc_MPI_Barrier (mpicomm);
+  SC_CHECK_MPI (mpiret);
+}
+
+/** Print one result with the bytes of all processes per second. */
+static void
+bench_report (const char *phase, const char *variant, size_t param,
+              int procs, size_t bytes, double seconds, double ratio)
+{
+  SC_GLOBAL_PRODUCTIONF ("%-8s %-12s %9llu %6d %11llu %12.3e %9.3f"
+                         " %7.3f\n", phase, variant,
+                         (unsigned long long) param, procs,
+                         (unsigned long long) bytes, seconds,
+                         (double) procs * bytes / seconds * 1e-9, ratio);
+}
+
+/** Write the data through a sink in pieces of a given size. */
+static void
+bench_sink_write (sc_io_sink_t * sink, const char *data, size_t bytes,
+                  size_t chunk, size_t *bytes_in, size_t *bytes_out)
+{
+  int                 retval;
+  size_t              pos;
+
+  SC_CHECK_ABORT (sink != NULL, "Sink creation");
+  for (pos = 0; pos < bytes; pos += chunk) {
+    retval = sc_io_sink_write (sink, data + pos, SC_MIN (chunk,
+                                                         bytes - pos));
+    SC_CHECK_ABORT (retval == 0, "Sink write");
+  }
+  retval = sc_io_sink_complete (sink, bytes_in, bytes_out);
+  SC_CHECK_ABORT (retval == 0, "Sink complete");
+  retval = sc_io_sink_destroy (sink);
+  SC_CHECK_ABORT (retval == 0, "Sink destroy");
+}
+
+static void
+bench_sinks (bench_io_t * b, size_t min_chunk)
+{
+  static const char  *names[5] =
+    { "buffer", "buffer_zlib", "buffer_fast", "filename", "staged" };
+  int                 v, r;
+  size_t              chunk, bytes_in, bytes_out;
+  double              elapsed, ratio;
+  sc_array_t         *buffer;
+  sc_io_sink_t       *sink;
+
+  buffer = sc_array_new (1);
+  for (chunk = min_chunk; chunk <= b->bytes; chunk *= 16) {
+    for (v = 0; v < 5; ++v) {
+      elapsed = ratio = 0.;
+      for (r = 0; r < b->repetitions; ++r) {
+        sc_array_reset (buffer);
+        bench_barrier (b->mpicomm);
+        elapsed -= sc_MPI_Wtime ();
+        if (v < 3) {
+          sink = sc_io_sink_new (SC_IO_TYPE_BUFFER, SC_IO_MODE_WRITE,
+                                 v == 0 ? SC_IO_ENCODE_NONE : v == 1 ?
+                                 SC_IO_ENCODE_ZLIB : SC_IO_ENCODE_ZLIB_FAST,
+                                 buffer);
+        }
+        else if (v == 3) {
+          sink = sc_io_sink_new (SC_IO_TYPE_FILENAME, SC_IO_MODE_WRITE,
+                                 SC_IO_ENCODE_NONE, b->filename);
+        }
+        else {
+          sink = sc_io_sink_new_staged (b->filename, SC_IO_MODE_WRITE,
+                                        0, 0);
+        }
+        bench_sink_write (sink, b->data, b->bytes, chunk, &bytes_in,
+                          &bytes_out);
+        elapsed += sc_MPI_Wtime ();
+        ratio = bytes_out > 0 ? (double) bytes_in / bytes_out : 0.;
+      }
+      bench_report ("sink", names[v], chunk, b->size, b->bytes,
+                    bench_slowest (b->mpicomm, elapsed / b->repetitions),
+                    ratio);
+    }
+  }
+  sc_array_destroy (buffer);
+}
+
+static void
+bench_sources (bench_io_t * b, size_t min_chunk)
+{
+  static const char  *names[2] = { "filename", "mmap" };
+  int                 v, r, retval;
+  size_t              chunk, pos, bytes_out;
+  double              elapsed;
+  char               *back;
+  sc_io_source_t     *source;
+
+  /* the file left by the sinks is read back */
+  back = SC_ALLOC (char, b->bytes);
+  for (chunk = min_chunk; chunk <= b->bytes; chunk *= 16) {
+    for (v = 0; v < 2; ++v) {
+      elapsed = 0.;
+      for (r = 0; r < b->repetitions; ++r) {
+        bench_barrier (b->mpicomm);
+        elapsed -= sc_MPI_Wtime ();
+        source = sc_io_source_new (v == 0 ? SC_IO_TYPE_FILENAME :
+                                   SC_IO_TYPE_MMAP, SC_IO_ENCODE_NONE,
+                                   b->filename);
+        if (source == NULL) {
+          /* memory mapping is not available */
+          SC_CHECK_ABORT (v == 1, "Source creation");
+          break;
+        }
+        for (pos = 0; pos < b->bytes; pos += bytes_out) {
+          retval = sc_io_source_read (source, back + pos,
+                                      SC_MIN (chunk, b->bytes - pos),
+                                      &bytes_out);
+          SC_CHECK_ABORT (retval == 0 && bytes_out > 0, "Source read");
+        }
+        retval = sc_io_source_destroy (source);
+        SC_CHECK_ABORT (retval == 0, "Source destroy");
+        elapsed += sc_MPI_Wtime ();
+      }
+      if (r == b->repetitions) {
+        SC_CHECK_ABORT (!memcmp (back, b->data, b->bytes), "Source data");
+        bench_report ("source", names[v], chunk, b->size, b->bytes,
+                      bench_slowest (b->mpicomm,
+                                     elapsed / b->repetitions), 1.);
+      }
+    }
+  }
+  SC_FREE (back);
+}
+
+static void
+bench_encode (bench_io_t * b)
+{
+  static const int    levels[4] = { 0, 1, 6, 9 };
+  int                 l, r, retval;
+  double              encode, decode;
+  sc_array_t          view, *encoded, *decoded;
+
+  sc_array_init_data (&view, b->data, 1, b->bytes);
+  encoded = sc_array_new (1);
+  decoded = sc_array_new (1);
+  for (l = 0; l < 5; ++l) {
+    encode = decode = 0.;
+    for (r = 0; r < b->repetitions; ++r) {
+      bench_barrier (b->mpicomm);
+      encode -= sc_MPI_Wtime ();
+      if (l < 4) {
+        sc_io_encode_zlib (&view, encoded, levels[l], 'x');
+      }
+      else {
+        sc_io_encode_parallel (&view, encoded, -1, 'x', 0, 0);
+      }
+      encode += sc_MPI_Wtime ();
+      bench_barrier (b->mpicomm);
+      decode -= sc_MPI_Wtime ();
+      retval = sc_io_decode (encoded, decoded, b->bytes, NULL);
+      decode += sc_MPI_Wtime ();
+      SC_CHECK_ABORT (retval == 0 && decoded->elem_count == b->bytes,
+                      "Decode");
+    }
+    SC_CHECK_ABORT (!memcmp (decoded->array, b->data, b->bytes),
+                    "Decoded data");
+    bench_report ("encode", l < 4 ? "zlib" : "parallel",
+                  (size_t) (l < 4 ? levels[l] : 6), b->size, b->bytes,
+                  bench_slowest (b->mpicomm, encode / b->repetitions),
+                  (double) b->bytes / encoded->elem_count);
+    bench_report ("decode", l < 4 ? "zlib" : "parallel",
+                  (size_t) (l < 4 ? levels[l] : 6), b->size, b->bytes,
+                  bench_slowest (b->mpicomm, decode / b->repetitions),
+                  (double) b->bytes / encoded->elem_count);
+  }
+  sc_array_destroy (encoded);
+  sc_array_destroy (decoded);
+}
+
+static void
+bench_vtk (bench_io_t * b)
+{
+  int                 r, retval;
+  long                written = 0;
+  double              elapsed = 0.;
+  FILE               *file;
+
+  for (r = 0; r < b->repetitions; ++r) {
+    bench_barrier (b->mpicomm);
+    elapsed -= sc_MPI_Wtime ();
+    file = fopen (b->filename, "wb");
+    SC_CHECK_ABORT (file != NULL, "VTK open");
+    retval = sc_vtk_write_compressed (file, b->data, b->bytes);
+    SC_CHECK_ABORT (retval == 0, "VTK write");
+    written = ftell (file);
+    SC_CHECK_ABORT (fclose (file) == 0, "VTK close");
+    elapsed += sc_MPI_Wtime ();
+  }
+  bench_report ("vtk", "compressed", 0, b->size, b->bytes,
+                bench_slowest (b->mpicomm, elapsed / b->repetitions),
+                written > 0 ? (double) b->bytes / written : 0.);
+}
+
+/** Write and read one block per process collectively. */
+static void
+bench_collective (bench_io_t * b, sc_MPI_Comm mpicomm, size_t block)
+{
+  int                 mpiret, errcode;
+  int                 size, rank, r, ocount;
+  double              write = 0., read = 0.;
+  char                filename[BUFSIZ];
+  char               *back;
+  sc_MPI_File         file;
+
+  mpiret = sc_MPI_Comm_size (mpicomm, &size);
+  SC_CHECK_MPI (mpiret);
+  mpiret = sc_MPI_Comm_rank (mpicomm, &rank);
+  SC_CHECK_MPI (mpiret);
+  snprintf (filename, BUFSIZ, "%s_all.dat", b->prefix);
+  back = SC_ALLOC (char, block);
+
+  for (r = 0; r < b->repetitions; ++r) {
+    bench_barrier (mpicomm);
+    write -= sc_MPI_Wtime ();
+    errcode = sc_io_open_hints (mpicomm, filename, SC_IO_WRITE_CREATE,
+                                &b->hints, block * size, &file);
+    SC_CHECK_ABORT (errcode == sc_MPI_SUCCESS, "Collective open");
+    errcode = sc_io_write_at_all (file, (sc_MPI_Offset) (block * rank),
+                                  b->data, block, sc_MPI_BYTE, &ocount);
+    SC_CHECK_ABORT (errcode == sc_MPI_SUCCESS && ocount == (int) block,
+                    "Collective write");
+    errcode = sc_io_close (&file);
+    SC_CHECK_ABORT (errcode == sc_MPI_SUCCESS, "Collective close");
+    write += sc_MPI_Wtime ();
+
+    bench_barrier (mpicomm);
+    read -= sc_MPI_Wtime ();
+    errcode = sc_io_open_hints (mpicomm, filename, SC_IO_READ,
+                                &b->hints, block * size, &file);
+    SC_CHECK_ABORT (errcode == sc_MPI_SUCCESS, "Collective open");
+    errcode = sc_io_read_at_all (file, (sc_MPI_Offset) (block * rank),
+                                 back, (int) block, sc_MPI_BYTE, &ocount);
+    SC_CHECK_ABORT (errcode == sc_MPI_SUCCESS && ocount == (int) block,
+                    "Collective read");
+    errcode = sc_io_close (&file);
+    SC_CHECK_ABORT (errcode == sc_MPI_SUCCESS, "Collective close");
+    read += sc_MPI_Wtime ();
+    SC_CHECK_ABORT (!memcmp (back, b->data, block), "Collective data");
+  }
+  bench_barrier (mpicomm);
+  if (rank == 0) {
+    (void) remove (filename);
+  }
+  SC_FREE (back);
+
+  bench_report ("write_at", "all", block, size, block,
+                bench_slowest (mpicomm, write / b->repetitions), 1.);
+  bench_report ("read_at", "all", block, size, block,
+                bench_slowest (mpicomm, read / b->repetitions), 1.);
+}
+
+int
+main (int argc, char **argv)
+{
+  int                 mpiret;
+  int                 first_arg;
+  int                 groupsize, megabytes, min_chunk, min_block;
+  int                 repetitions;
+  size_t              i, block;
+  double             *values;
+  sc_MPI_Comm         subcomm;
+  sc_options_t       *opt;
+  bench_io_t          b;
+
+  mpiret = sc_MPI_Init (&argc, &argv);
+  SC_CHECK_MPI (mpiret);
+  b.mpicomm = sc_MPI_COMM_WORLD;
+  mpiret = sc_MPI_Comm_size (b.mpicomm, &b.size);
+  SC_CHECK_MPI (mpiret);
+  mpiret = sc_MPI_Comm_rank (b.mpicomm, &b.rank);
+  SC_CHECK_MPI (mpiret);
+
+  sc_init (b.mpicomm, 1, 1, NULL, SC_LP_PRODUCTION);
+
+  opt = sc_options_new (argv[0]);
+  sc_options_add_int (opt, 'm', "megabytes", &megabytes, 16,
+                      "Megabytes of data per process");
+  sc_options_add_int (opt, 'c', "min-chunk", &min_chunk, 64,
+                      "Smallest write to sinks and read from sources");
+  sc_options_add_int (opt, 'b', "min-block", &min_block, 1 << 12,
+                      "Smallest block per process written collectively");
+  sc_options_add_int (opt, 'r', "repetitions", &repetitions, 3,
+                      "Repetitions per measurement");
+  sc_options_add_string (opt, 'f', "prefix", &b.prefix, "sc_bench_io",
+                         "Prefix of the files written");
+  sc_io_hints_init (&b.hints);
+  sc_io_hints_add_options (&b.hints, opt);
+  first_arg = sc_options_parse (sc_package_id, SC_LP_ERROR, opt, argc, argv);
+  if (first_arg < 0 || megabytes <= 0 || megabytes > 1024 ||
+      min_chunk <= 0 || min_block <= 0 || repetitions <= 0) {
+    sc_options_print_usage (sc_package_id, SC_LP_ERROR, opt, NULL);
+    sc_abort_collective ("Option parsing failed");
+  }
+  sc_options_print_summary (sc_package_id, SC_LP_PRODUCTION, opt);
+
+  /* a smooth field of integer values compresses like simulation output */
+  b.repetitions = repetitions;
+  b.bytes = (size_t) megabytes << 20;
+  b.data = SC_ALLOC (char, b.bytes);
+  values = (double *) b.data;
+  for (i = 0; i < b.bytes / sizeof (double); ++i) {
+    values[i] = floor (1000. * sin (1e-3 * i + b.rank));
+  }
+  snprintf (b.filename, BUFSIZ, "%s_%d.dat", b.prefix, b.rank);
+
+  SC_GLOBAL_PRODUCTIONF ("%-8s %-12s %9s %6s %11s %12s %9s %7s\n",
+                         "phase", "variant", "param", "procs", "bytes",
+                         "seconds", "GB/s", "ratio");
+  bench_sinks (&b, (size_t) min_chunk);
+  bench_sources (&b, (size_t) min_chunk);
+  bench_encode (&b);
+  bench_vtk (&b);
+  (void) remove (b.filename);
+
+  /* use the first processes for every power of two and the full size */
+  for (groupsize = 1; groupsize < 2 * b.size; groupsize *= 2) {
+    groupsize = SC_MIN (groupsize, b.size);
+    mpiret = sc_MPI_Comm_split (b.mpicomm, b.rank < groupsize ? 0 :
+                                sc_MPI_UNDEFINED, b.rank, &subcomm);
+    SC_CHECK_MPI (mpiret);
+    if (subcomm != sc_MPI_COMM_NULL) {
+      for (block = (size_t) min_block; block <= b.bytes; block *= 16) {
+        bench_collective (&b, subcomm, block);
+      }
+      mpiret = sc_MPI_Comm_free (&subcomm);
+      SC_CHECK_MPI (mpiret);
+    }
+    bench_barrier (b.mpicomm);
+  }
+
+  SC_FREE (b.data);
+  sc_options_destroy (opt);
+  sc_finalize ();
+
+  mpiret = sc_MPI_Finalize ();
+  SC_CHECK_MPI (mpiret);
+
+  return 0;
+}
@@ -0,0 +1,178 @@
+/*
+  This file is part of the SC Library.
+  The SC Library provides support for parallel scientific applications.
+
+  Copyright (C) 2010 The University of Texas System
+  Additional copyright (C) 2011 individual authors
+
+  The SC Library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  The SC Library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with the SC Library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+  02110-1301, USA.
+*/
+
+/*
+ * Benchmark the throughput of the lock-free queues over batch sizes.
+ * One or several producer threads push a number of elements that the
+ * calling thread pops, and we print the elements moved per second with
+ * a single producer queue and with a multiple producer queue.
+ * Each process measures on its own and the slowest result is reported.
+ */
+
+#include <sc_queue.h>
+#include <sc_options.h>
+#if defined SC_ENABLE_PTHREAD && defined SC_HAVE_ATOMIC_BUILTINS
+#include <pthread.h>
+#include <sched.h>
+#define BENCH_QUEUE_THREADS
+#endif
+
+#ifdef BENCH_QUEUE_THREADS
+
+typedef struct bench_queue
+{
+  sc_queue_t         *queue;
+  size_t              elem_size;
+  size_t              batch;
+  size_t              count;    /**< Elements pushed by each producer. */
+}
+bench_queue_t;
+
+static void        *
+bench_produce (void *arg)
+{
+  bench_queue_t      *bq = (bench_queue_t *) arg;
+  size_t              pushed, k;
+  char               *elems;
+
+  elems = SC_ALLOC_ZERO (char, bq->batch * bq->elem_size);
+  for (pushed = 0; pushed < bq->count; pushed += k) {
+    k = SC_MIN (bq->batch, bq->count - pushed);
+    k = sc_queue_push_batch (bq->queue, elems, k);
+    if (k == 0) {
+      /* let the consumer run when there are fewer cores than threads */
+      sched_yield ();
+    }
+  }
+  SC_FREE (elems);
+  return NULL;
+}
+
+static double
+bench_rate (int num_producers, int multi, size_t elem_size,
+            size_t capacity, size_t batch, size_t count)
+{
+  int                 mpiret;
+  int                 p, pth;
+  size_t              popped, total, k;
+  double              elapsed, slowest;
+  char               *elems;
+  pthread_t          *threads;
+  bench_queue_t       bq;
+
+  bq.queue = sc_queue_new (elem_size, capacity, multi);
+  bq.elem_size = elem_size;
+  bq.batch = batch;
+  bq.count = count;
+  elems = SC_ALLOC (char, batch * elem_size);
+  threads = SC_ALLOC (pthread_t, num_producers);
+
+  elapsed = -sc_MPI_Wtime ();
+  for (p = 0; p < num_producers; ++p) {
+    pth = pthread_create (&threads[p], NULL, bench_produce, &bq);
+    SC_CHECK_ABORTF (pth == 0, "pthread_create %d failed", pth);
+  }
+  total = count * (size_t) num_producers;
+  for (popped = 0; popped < total; popped += k) {
+    k = sc_queue_pop_batch (bq.queue, elems, batch);
+    if (k == 0) {
+      sched_yield ();
+    }
+  }
+  for (p = 0; p < num_producers; ++p) {
+    pth = pthread_join (threads[p], NULL);
+    SC_CHECK_ABORTF (pth == 0, "pthread_join %d failed", pth);
+  }
+  elapsed += sc_MPI_Wtime ();
+
+  SC_FREE (threads);
+  SC_FREE (elems);
+  sc_queue_destroy (bq.queue);
+
+  mpiret = sc_MPI_Allreduce (&elapsed, &slowest, 1, sc_MPI_DOUBLE,
+                             sc_MPI_MAX, sc_MPI_COMM_WORLD);
+  SC_CHECK_MPI (mpiret);
+  return (double) total / slowest;
+}
+
+#endif /* BENCH_QUEUE_THREADS */
+
+int
+main (int argc, char **argv)
+{
+  int                 mpiret;
+  int                 first_arg;
+  int                 num_producers, max_batch, elem_size, capacity;
+  int                 batch;
+  size_t              count;
+  sc_options_t       *opt;
+
+  mpiret = sc_MPI_Init (&argc, &argv);
+  SC_CHECK_MPI (mpiret);
+
+  sc_init (sc_MPI_COMM_WORLD, 1, 1, NULL, SC_LP_PRODUCTION);
+
+  opt = sc_options_new (argv[0]);
+  sc_options_add_int (opt, 'p', "producers", &num_producers, 3,
+                      "Producer threads of the multiple producer queue");
+  sc_options_add_int (opt, 'b', "max-batch", &max_batch, 64,
+                      "Largest number of elements per push and pop");
+  sc_options_add_int (opt, 'e', "elem-size", &elem_size, 16,
+                      "Bytes per element");
+  sc_options_add_int (opt, 'c', "capacity", &capacity, 1024,
+                      "Minimum capacity of the queue");
+  sc_options_add_size_t (opt, 'n', "count", &count, 1 << 22,
+                         "Elements pushed by each producer");
+  first_arg = sc_options_parse (sc_package_id, SC_LP_ERROR, opt, argc, argv);
+  if (first_arg < 0 || num_producers <= 0 || max_batch <= 0 ||
+      elem_size <= 0 || capacity <= 0 || count == 0) {
+    sc_options_print_usage (sc_package_id, SC_LP_ERROR, opt, NULL);
+    sc_abort_collective ("Option parsing failed");
+  }
+  sc_options_print_summary (sc_package_id, SC_LP_PRODUCTION, opt);
+
+#ifdef BENCH_QUEUE_THREADS
+  SC_GLOBAL_PRODUCTIONF ("%10s %16s %16s\n", "batch", "spsc/s", "mpsc/s");
+  for (batch = 1; batch <= max_batch; batch *= 2) {
+    SC_GLOBAL_PRODUCTIONF ("%10d %16.4e %16.4e\n", batch,
+                           bench_rate (1, 0, (size_t) elem_size,
+                                       (size_t) capacity, (size_t) batch,
+                                       count),
+                           bench_rate (num_producers, 1, (size_t) elem_size,
+                                       (size_t) capacity, (size_t) batch,
+                                       count));
+  }
+#else
+  batch = 0;
+  SC_GLOBAL_PRODUCTION ("The queue benchmark requires threads"
+                        " and atomic builtins\n");
+#endif
+
+  sc_options_destroy (opt);
+  sc_finalize ();
+
+  mpiret = sc_MPI_Finalize ();
+  SC_CHECK_MPI (mpiret);
+
+  return 0;
+}
@@ -30,10 +30,15 @@ main (int argc, char **argv)
   int                 mpiret;
   int                 mpisize;
   int                 mpirank;
-  int                 i;
+  int                 i, k;
   int                *idata;
+  size_t              ring_bytes, bruck_bytes;
+  size_t              zz, first;
+  sc_array_t         *asend, *arecv, *offsets;
   double              elapsed_alltoall = 0.;
   double              elapsed_recursive;
+  double              elapsed_ring;
+  double              elapsed_bruck;
   double              dsend;
   double             *ddata1;
   double             *ddata2;
@@ -80,8 +85,91 @@ main (int argc, char **argv)
     SC_ASSERT (idata[i] == i);
   }
 
+  SC_GLOBAL_INFO ("Testing sc_allgather_ring\n");
+
+  for (i = 0; i < mpisize; ++i) {
+    idata[i] = (i == mpirank) ? mpirank : -1;
+  }
+  elapsed_ring = -sc_MPI_Wtime ();
+  sc_allgather_ring (mpicomm, (char *) idata, (int) sizeof (int),
+                     mpisize, mpirank, mpirank);
+  elapsed_ring += sc_MPI_Wtime ();
+  for (i = 0; i < mpisize; ++i) {
+    SC_CHECK_ABORT (idata[i] == i, "Ring mismatch");
+  }
+
+  SC_GLOBAL_INFO ("Testing sc_allgather_bruck\n");
+
+  for (i = 0; i < mpisize; ++i) {
+    idata[i] = (i == mpirank) ? mpirank : -1;
+  }
+  elapsed_bruck = -sc_MPI_Wtime ();
+  sc_allgather_bruck (mpicomm, (char *) idata, (int) sizeof (int),
+                      mpisize, mpirank, mpirank);
+  elapsed_bruck += sc_MPI_Wtime ();
+  for (i = 0; i < mpisize; ++i) {
+    SC_CHECK_ABORT (idata[i] == i, "Bruck mismatch");
+  }
+
+  SC_GLOBAL_INFO ("Testing sc_allgather algorithm selection\n");
+
+  /* force each algorithm in turn through the thresholds */
+  ring_bytes = sc_allgather_ring_bytes;
+  bruck_bytes = sc_allgather_bruck_bytes;
+  for (k = 0; k < 3; ++k) {
+    sc_allgather_ring_bytes = k == 0 ? 1 : 0;
+    sc_allgather_bruck_bytes = k == 1 ? sizeof (int) : 0;
+    sc_allgather_alltoall_max = k == 2 ? SC_ALLGATHER_ALLTOALL_MAX : 1;
+    i = mpirank;
+    sc_allgather (&i, 1, sc_MPI_INT, idata, 1, sc_MPI_INT, mpicomm);
+    for (i = 0; i < mpisize; ++i) {
+      SC_CHECK_ABORT (idata[i] == i, "Allgather mismatch");
+    }
+  }
+  sc_allgather_ring_bytes = ring_bytes;
+  sc_allgather_bruck_bytes = bruck_bytes;
+  sc_allgather_alltoall_max = SC_ALLGATHER_ALLTOALL_MAX;
+
   SC_FREE (idata);
 
+  SC_GLOBAL_INFO ("Testing sc_array_allgatherv and sc_array_gatherv\n");
+
+  /* process q contributes q elements */
+  asend = sc_array_new_count (sizeof (int), (size_t) mpirank);
+  for (i = 0; i < mpirank; ++i) {
+    *(int *) sc_array_index_int (asend, i) = 100 * mpirank + i;
+  }
+  arecv = sc_array_new (sizeof (int));
+  offsets = sc_array_new (sizeof (size_t));
+  for (k = 0; k < 2; ++k) {
+    if (k == 0) {
+      sc_array_allgatherv (asend, arecv, offsets, mpicomm);
+    }
+    else if (mpirank == mpisize - 1) {
+      sc_array_gatherv (asend, arecv, offsets, mpisize - 1, mpicomm);
+    }
+    else {
+      sc_array_gatherv (asend, NULL, NULL, mpisize - 1, mpicomm);
+      continue;
+    }
+    SC_CHECK_ABORT (arecv->elem_count ==
+                    (size_t) mpisize * (mpisize - 1) / 2 &&
+                    offsets->elem_count == (size_t) mpisize + 1,
+                    "Gathered array size mismatch");
+    for (i = 0; i < mpisize; ++i) {
+      first = *(size_t *) sc_array_index_int (offsets, i);
+      SC_CHECK_ABORT (first == (size_t) i * (i - 1) / 2,
+                      "Gathered offset mismatch");
+      for (zz = 0; zz < (size_t) i; ++zz) {
+        SC_CHECK_ABORT (*(int *) sc_array_index (arecv, first + zz) ==
+                        100 * i + (int) zz, "Gathered array mismatch");
+      }
+    }
+  }
+  sc_array_destroy (offsets);
+  sc_array_destroy (arecv);
+  sc_array_destroy (asend);
+
   ddata1 = SC_ALLOC (double, mpisize);
   ddata2 = SC_ALLOC (double, mpisize);
 
@@ -118,9 +206,11 @@ main (int argc, char **argv)
   SC_FREE (ddata2);
 
   SC_GLOBAL_STATISTICSF ("Timings with threshold %d on %d cores\n",
-                         SC_ALLGATHER_ALLTOALL_MAX, mpisize);
+                         sc_allgather_alltoall_max, mpisize);
   SC_GLOBAL_STATISTICSF ("   alltoall %g\n", elapsed_alltoall);
   SC_GLOBAL_STATISTICSF ("   recursive %g\n", elapsed_recursive);
+  SC_GLOBAL_STATISTICSF ("   ring %g\n", elapsed_ring);
+  SC_GLOBAL_STATISTICSF ("   bruck %g\n", elapsed_bruck);
   SC_GLOBAL_STATISTICSF ("   allgather %g\n", elapsed_allgather);
   SC_GLOBAL_STATISTICSF ("   replacement %g\n", elapsed_replacement);
 
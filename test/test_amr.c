@@ -0,0 +1,174 @@
+/*
+  This file is part of the SC Library.
+  The SC Library provides support for parallel scientific applications.
+
+  Copyright (C) 2010 The University of Texas System
+  Additional copyright (C) 2011 individual authors
+
+  The SC Library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  The SC Library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with the SC Library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+  02110-1301, USA.
+*/
+
+#include <sc_amr.h>
+
+static long
+test_amr_count_coarsen (sc_amr_control_t * amr, void *user_data)
+{
+  long                i, count;
+
+  for (i = count = 0; i < amr->num_local_elements; ++i) {
+    count += amr->errors[i] < amr->coarsen_threshold;
+  }
+  return count;
+}
+
+static long
+test_amr_count_refine (sc_amr_control_t * amr, void *user_data)
+{
+  long                i, count;
+
+  for (i = count = 0; i < amr->num_local_elements; ++i) {
+    count += amr->errors[i] > amr->refine_threshold;
+  }
+  return 3 * count;
+}
+
+static int
+test_amr_select (sc_MPI_Comm mpicomm)
+{
+  const long          num_local = 1000;
+  int                 num_failed_tests = 0;
+  int                 mpiret, mpirank, num_rounds;
+  long                i, rank, count, total;
+  double             *errors, value;
+  sc_amr_control_t    amr, amr2;
+
+  mpiret = sc_MPI_Comm_rank (mpicomm, &mpirank);
+  SC_CHECK_MPI (mpiret);
+
+  /* skewed errors that differ between processes */
+  errors = SC_ALLOC (double, num_local);
+  for (i = 0; i < num_local; ++i) {
+    value = (double) ((i * 7919 + mpirank * 104729) % 10007) / 10007.;
+    errors[i] = value * value * value;
+  }
+  sc_amr_error_stats (mpicomm, num_local, errors, &amr);
+  total = amr.num_total_elements;
+
+  /* the selected value has the requested rank up to rounding */
+  rank = total / 3;
+  value = sc_amr_select_error (&amr, rank, 32, 4, &num_rounds);
+  amr.coarsen_threshold = value;
+  count = test_amr_count_coarsen (&amr, NULL);
+  mpiret = sc_MPI_Allreduce (&count, &i, 1, sc_MPI_LONG, sc_MPI_SUM,
+                             mpicomm);
+  SC_CHECK_MPI (mpiret);
+  if (num_rounds > 4 || i < rank - 2 || i > rank + 2) {
+    SC_GLOBAL_LERRORF ("amr select rank %ld counted %ld in %d rounds\n",
+                       rank, i, num_rounds);
+    ++num_failed_tests;
+  }
+  if (sc_amr_select_error (&amr, 0, 32, 4, NULL) != amr.estats.min ||
+      sc_amr_select_error (&amr, total, 32, 4, NULL) != amr.estats.max) {
+    SC_GLOBAL_LERROR ("amr select bounds\n");
+    ++num_failed_tests;
+  }
+
+  /* coarsen to about 60 percent and then refine to about 150 percent */
+  sc_amr_coarsen_select (sc_package_id, &amr, total * 6 / 10, 1., 32, 4,
+                         test_amr_count_coarsen, NULL);
+  if (amr.num_total_estimated < total * 6 / 10 ||
+      amr.num_total_estimated > total * 6 / 10 + 3) {
+    SC_GLOBAL_LERRORF ("amr coarsen select estimated %ld\n",
+                       amr.num_total_estimated);
+    ++num_failed_tests;
+  }
+  sc_amr_coarsen_specify (sc_package_id, &amr, 0., NULL, NULL);
+  sc_amr_refine_select (sc_package_id, &amr, total * 3 / 2, 3., 32, 4,
+                        test_amr_count_refine, NULL);
+  if (amr.num_total_estimated > total * 3 / 2 ||
+      amr.num_total_estimated < total * 3 / 2 - 12) {
+    SC_GLOBAL_LERRORF ("amr refine select estimated %ld\n",
+                       amr.num_total_estimated);
+    ++num_failed_tests;
+  }
+
+  SC_FREE (errors);
+
+  /* chunks on several threads give the same statistics and buckets */
+  errors = SC_ALLOC (double, 4 * SC_AMR_ERROR_STATS_PARALLEL_MIN + 3);
+  for (i = 0; i < 4 * SC_AMR_ERROR_STATS_PARALLEL_MIN + 3; ++i) {
+    errors[i] = ldexp (1. + (i % 101) / 101., -(int) (i % 40)) *
+      (i % 7 == 0 ? -1. : 1.);
+  }
+  sc_amr_error_stats_ext (mpicomm, 4 * SC_AMR_ERROR_STATS_PARALLEL_MIN + 3,
+                          errors, 1, &amr);
+  sc_amr_error_stats_ext (mpicomm, 4 * SC_AMR_ERROR_STATS_PARALLEL_MIN + 3,
+                          errors, 4, &amr2);
+  if (amr.estats.min != amr2.estats.min ||
+      amr.estats.max != amr2.estats.max ||
+      fabs (amr.estats.average - amr2.estats.average) > 1.e-12 ||
+      memcmp (amr.error_buckets, amr2.error_buckets,
+              sizeof (amr.error_buckets))) {
+    SC_GLOBAL_LERROR ("amr threaded error statistics\n");
+    ++num_failed_tests;
+  }
+
+  /* the buckets resolve errors spanning many orders of magnitude */
+  total = amr2.num_total_elements;
+  rank = total / 2;
+  amr2.coarsen_threshold =
+    sc_amr_select_error (&amr2, rank, 32, 4, &num_rounds);
+  count = test_amr_count_coarsen (&amr2, NULL);
+  mpiret = sc_MPI_Allreduce (&count, &i, 1, sc_MPI_LONG, sc_MPI_SUM,
+                             mpicomm);
+  SC_CHECK_MPI (mpiret);
+  if (i < rank - total / 1000 || i > rank + total / 1000) {
+    SC_GLOBAL_LERRORF ("amr select rank %ld counted %ld in %d rounds\n",
+                       rank, i, num_rounds);
+    ++num_failed_tests;
+  }
+  SC_FREE (errors);
+
+  return num_failed_tests;
+}
+
+int
+main (int argc, char **argv)
+{
+  int                 mpiret;
+  sc_MPI_Comm         mpicomm;
+  int                 num_failed_tests;
+
+  /* standard initialization */
+  mpiret = sc_MPI_Init (&argc, &argv);
+  SC_CHECK_MPI (mpiret);
+  mpicomm = sc_MPI_COMM_WORLD;
+
+  sc_init (mpicomm, 1, 1, NULL, SC_LP_DEFAULT);
+
+  num_failed_tests = 0;
+
+  /* test the threshold selection of sc_amr */
+  num_failed_tests += test_amr_select (mpicomm);
+
+  /* clean up and exit */
+  sc_finalize ();
+
+  mpiret = sc_MPI_Finalize ();
+  SC_CHECK_MPI (mpiret);
+
+  return num_failed_tests ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -22,6 +22,10 @@
 */
 
 #include <sc_containers.h>
+#include <sc_uint128.h>
+#ifdef SC_HAVE_UNISTD_H
+#include <unistd.h>
+#endif
 
 static              ssize_t
 sc_array_bsearch_range (sc_array_t * array, size_t begin, size_t end,
@@ -144,6 +148,858 @@ test_mstamp (void)
   }
 }
 
+static void
+test_arena (void)
+{
+  const size_t        align[4] = { 0, 1, 16, 256 };
+  int                 i, j;
+  size_t              used;
+  char               *pc;
+  sc_array_t          a;
+  sc_arena_t          sarena, *arena = &sarena;
+  sc_arena_mark_t     mark;
+
+  sc_arena_init (arena, 1000);
+  for (j = 0; j < 4; ++j) {
+    for (i = 0; i < 100; ++i) {
+      pc = (char *) sc_arena_alloc (arena, (size_t) (7 * i + 1), align[j]);
+      SC_CHECK_ABORT (align[j] == 0 ||
+                      (size_t) pc % align[j] == 0, "Arena alignment");
+      memset (pc, -1, (size_t) (7 * i + 1));
+    }
+  }
+
+  /* rewinding reuses the same memory */
+  mark = sc_arena_save (arena);
+  used = sc_arena_memory_used (arena, 0);
+  for (j = 0; j < 3; ++j) {
+    pc = (char *) sc_arena_alloc (arena, 5000, 0);
+    memset (pc, -1, 5000);
+    sc_array_init_arena (&a, sizeof (int), arena);
+    for (i = 0; i < 10000; ++i) {
+      *(int *) sc_array_push (&a) = i;
+    }
+    for (i = 0; i < 10000; ++i) {
+      SC_CHECK_ABORT (*(int *) sc_array_index_int (&a, i) == i,
+                      "Arena array content");
+    }
+    sc_array_reset (&a);
+    sc_arena_rewind (arena, mark);
+    if (j == 0) {
+      used = sc_arena_memory_used (arena, 0);
+    }
+    SC_CHECK_ABORT (used == sc_arena_memory_used (arena, 0),
+                    "Arena rewind growth");
+  }
+  SC_GLOBAL_INFOF ("Memory used arena %lld\n", (long long) used);
+
+  /* the most recent item is resized in place */
+  sc_arena_truncate (arena);
+  pc = (char *) sc_arena_alloc (arena, 10, 0);
+  SC_CHECK_ABORT (sc_arena_realloc (arena, pc, 10, 500, 0) == pc,
+                  "Arena realloc in place");
+  sc_arena_reset (arena);
+}
+
+static void
+test_allocator (void)
+{
+  int                 i, j;
+  sc_array_t          a;
+  sc_array_t         *b;
+  sc_array_allocator_t allocator;
+
+  for (j = 0; j < 3; ++j) {
+    if (j == 0) {
+      allocator = sc_array_allocator_default;
+    }
+    else if (j == 1) {
+      sc_array_allocator_hugepage (&allocator, (size_t) 1 << 20);
+    }
+    else {
+      sc_array_allocator_aligned (&allocator, 64);
+    }
+    sc_array_init_allocator (&a, sizeof (int), &allocator);
+    for (i = 0; i < 1000000; ++i) {
+      *(int *) sc_array_push (&a) = i;
+      SC_CHECK_ABORT (j < 2 || (uintptr_t) a.array % 64 == 0,
+                      "Allocator alignment");
+    }
+    sc_array_resize (&a, 1000);
+    for (i = 0; i < 1000; ++i) {
+      SC_CHECK_ABORT (*(int *) sc_array_index_int (&a, i) == i,
+                      "Allocator content");
+    }
+    sc_array_resize (&a, 0);
+    SC_CHECK_ABORT (a.ext != NULL && a.ext->allocator == &allocator,
+                    "Allocator resize");
+    sc_array_reset (&a);
+    SC_CHECK_ABORT (a.ext == NULL, "Allocator reset");
+  }
+
+  /* the aligned arrays keep their alignment when growing and shrinking */
+  for (j = 0; j <= 21; j += 3) {
+    b = sc_array_new_aligned (3, (size_t) 1 << j);
+    for (i = 0; i < 5000; i += 1 + i / 2) {
+      sc_array_resize (b, (size_t) i);
+      SC_CHECK_ABORT (i == 0 || (uintptr_t) b->array % ((size_t) 1 << j)
+                      == 0, "Aligned array");
+    }
+    sc_array_destroy (b);
+  }
+}
+
+/* push many elements and return the number of allocation changes */
+static int
+test_policy_push (sc_array_t * a, int count, size_t *max_slack)
+{
+  int                 i, changes;
+  ssize_t             alloc;
+  size_t              slack;
+
+  changes = 0;
+  alloc = a->byte_alloc;
+  *max_slack = 0;
+  for (i = 0; i < count; ++i) {
+    *(int *) sc_array_push (a) = i;
+    if (a->byte_alloc != alloc) {
+      alloc = a->byte_alloc;
+      ++changes;
+    }
+    (void) sc_array_memory_used_ext (a, 0, &slack);
+    SC_CHECK_ABORT (slack == (size_t) a->byte_alloc -
+                    a->elem_count * sizeof (int), "Policy slack");
+    *max_slack = SC_MAX (*max_slack, slack);
+  }
+  for (i = 0; i < count; ++i) {
+    SC_CHECK_ABORT (*(int *) sc_array_index_int (a, i) == i,
+                    "Policy content");
+  }
+  return changes;
+}
+
+static void
+test_policy (void)
+{
+  int                 changes, changes_default;
+  size_t              max_slack, slack;
+  sc_array_t          a;
+  sc_array_policy_t   policy;
+
+  /* the default doubles and may leave up to half of the memory unused */
+  sc_array_init (&a, sizeof (int));
+  changes_default = test_policy_push (&a, 100000, &max_slack);
+  SC_CHECK_ABORT (max_slack >= 100000, "Default slack");
+  SC_CHECK_ABORT (a.ext == NULL, "Default settings");
+  sc_array_reset (&a);
+
+  /* limit the slack */
+  policy.growth = 2.;
+  policy.max_slack = 4096;
+  policy.page_bytes = 0;
+  sc_array_set_policy (&a, &policy);
+  changes = test_policy_push (&a, 100000, &max_slack);
+  SC_CHECK_ABORT (max_slack <= 4096, "Limited slack");
+  SC_CHECK_ABORT (changes > changes_default, "Limited slack changes");
+  sc_array_resize (&a, 50000);
+  (void) sc_array_memory_used_ext (&a, 0, &slack);
+  SC_CHECK_ABORT (slack <= 4096, "Limited slack shrink");
+  sc_array_rewind (&a, 0);
+  SC_CHECK_ABORT (a.ext != NULL && a.ext->policy == &policy, "Policy rewind");
+  sc_array_reset (&a);
+  SC_CHECK_ABORT (a.ext == NULL, "Policy reset");
+
+  /* grow tiny arrays fast and round large ones to pages */
+  policy.growth = 8.;
+  policy.max_slack = 0;
+  policy.page_bytes = 65536;
+  sc_array_set_policy (&a, &policy);
+  changes = test_policy_push (&a, 100000, &max_slack);
+  SC_CHECK_ABORT (changes < changes_default, "Fast growth changes");
+  SC_CHECK_ABORT (a.byte_alloc % 65536 == 0, "Page rounding");
+  sc_array_reset (&a);
+
+  /* reserved memory is neither regrown nor shrunk */
+  sc_array_set_policy (&a, NULL);
+  sc_array_reserve (&a, 10000);
+  SC_CHECK_ABORT (a.byte_alloc == 10000 * sizeof (int) && a.elem_count == 0,
+                  "Reserve");
+  changes = test_policy_push (&a, 10000, &max_slack);
+  SC_CHECK_ABORT (changes == 0, "Reserve changes");
+  sc_array_resize (&a, 1);
+  sc_array_resize (&a, 0);
+  SC_CHECK_ABORT (a.byte_alloc == 10000 * sizeof (int), "Reserve shrink");
+  *(int *) sc_array_push (&a) = 7;
+  sc_array_shrink_to_fit (&a);
+  SC_CHECK_ABORT (a.byte_alloc == sizeof (int) &&
+                  *(int *) sc_array_index_int (&a, 0) == 7, "Shrink to fit");
+  sc_array_resize (&a, 0);
+  SC_CHECK_ABORT (a.byte_alloc == 0 && a.array == NULL && a.ext == NULL,
+                  "Shrink reset");
+  sc_array_reset (&a);
+}
+
+static void
+test_mmap (void)
+{
+  int                 i, j;
+  char                filename[BUFSIZ];
+  FILE               *fp;
+  sc_array_t          a;
+  sc_array_mmap_t    *mm;
+
+  /* the test may run as several independent processes */
+#ifdef SC_HAVE_UNISTD_H
+  snprintf (filename, BUFSIZ, "sc_test_arrays_mmap_%ld.dat",
+            (long) getpid ());
+#else
+  snprintf (filename, BUFSIZ, "sc_test_arrays_mmap.dat");
+#endif
+
+  /* an anonymous temporary file grows with the array */
+  mm = sc_array_mmap_new (NULL);
+  if (mm == NULL) {
+    SC_GLOBAL_INFO ("Memory mapped arrays are not available\n");
+    return;
+  }
+  sc_array_init_mmap (&a, sizeof (int), mm);
+  SC_CHECK_ABORT (a.elem_count == 0, "Mmap empty");
+  for (i = 0; i < 1000000; ++i) {
+    *(int *) sc_array_push (&a) = 999999 - i;
+  }
+  sc_array_sort (&a, sc_int_compare);
+  for (i = 0; i < 1000000; ++i) {
+    SC_CHECK_ABORT (*(int *) sc_array_index_int (&a, i) == i,
+                    "Mmap content");
+  }
+  sc_array_resize (&a, 1000);
+  SC_CHECK_ABORT (*(int *) sc_array_index_int (&a, 999) == 999,
+                  "Mmap shrink");
+  sc_array_reset (&a);
+  *(int *) sc_array_push (&a) = 1;
+  sc_array_mmap_destroy (mm);
+  SC_CHECK_ABORT (a.elem_count == 0 && a.ext == NULL, "Mmap detach");
+  sc_array_reset (&a);
+
+  /* a named file keeps the elements */
+  (void) remove (filename);
+  mm = sc_array_mmap_new (filename);
+  SC_CHECK_ABORT (mm != NULL, "Mmap file");
+  sc_array_init_mmap (&a, sizeof (int), mm);
+  for (i = 0; i < 5000; ++i) {
+    *(int *) sc_array_push (&a) = i;
+  }
+  sc_array_mmap_destroy (mm);
+  mm = sc_array_mmap_new (filename);
+  SC_CHECK_ABORT (mm != NULL, "Mmap reopen");
+  sc_array_init_mmap (&a, sizeof (int), mm);
+  SC_CHECK_ABORT (a.elem_count == 5000, "Mmap persistent count");
+  for (i = 0; i < 5000; ++i) {
+    SC_CHECK_ABORT (*(int *) sc_array_index_int (&a, i) == i,
+                    "Mmap persistent content");
+  }
+  *(int *) sc_array_push (&a) = 5000;
+
+  /* resetting the array unmaps the file without erasing it */
+  sc_array_reset (&a);
+  fp = fopen (filename, "rb");
+  SC_CHECK_ABORT (fp != NULL, "Mmap file after reset");
+  for (i = 0; i <= 5000; ++i) {
+    SC_CHECK_ABORT (fread (&j, sizeof (int), 1, fp) == 1 && j == i,
+                    "Mmap file content after reset");
+  }
+  SC_CHECK_ABORT (fclose (fp) == 0, "Mmap file close");
+  sc_array_mmap_destroy (mm);
+  SC_CHECK_ABORT (remove (filename) == 0, "Mmap remove");
+}
+
+#define TEST_SET_DOMAIN 400000
+
+/* fill a sorted set with the integers below the domain size for which
+ * a hash falls below a percentage */
+static void
+test_set_fill (sc_array_t * set, char *member, int percent, int seed)
+{
+  int                 i;
+
+  sc_array_resize (set, 0);
+  for (i = 0; i < TEST_SET_DOMAIN; ++i) {
+    member[i] = (char) ((((unsigned) i * 2654435761u + seed) >> 7) % 10000
+                        < (unsigned) percent);
+    if (member[i]) {
+      *(int *) sc_array_push (set) = i;
+    }
+  }
+}
+
+/* check a set operation against the membership of both inputs */
+static void
+test_set_check (sc_array_t * out, const char *ma, const char *mb, int op)
+{
+  int                 i;
+  size_t              zz;
+  char                want;
+
+  zz = 0;
+  for (i = 0; i < TEST_SET_DOMAIN; ++i) {
+    want = op == 0 ? (ma[i] || mb[i]) : op == 1 ? (ma[i] && mb[i]) :
+      (ma[i] && !mb[i]);
+    if (want) {
+      SC_CHECK_ABORT (zz < out->elem_count &&
+                      *(int *) sc_array_index (out, zz) == i, "Set entry");
+      ++zz;
+    }
+  }
+  SC_CHECK_ABORT (zz == out->elem_count, "Set count");
+}
+
+static void
+test_sets (void)
+{
+  int                 c, op, threads, i;
+  const int           percent[4][2] = {
+    {5000, 5000}, {1, 9000}, {9000, 3}, {0, 2000}
+  };
+  char               *ma, *mb;
+  sc_array_t         *a, *b, *out, *dup, *ref;
+
+  ma = SC_ALLOC (char, TEST_SET_DOMAIN);
+  mb = SC_ALLOC (char, TEST_SET_DOMAIN);
+  a = sc_array_new (sizeof (int));
+  b = sc_array_new (sizeof (int));
+  out = sc_array_new (sizeof (int));
+  for (c = 0; c < 4; ++c) {
+    test_set_fill (a, ma, percent[c][0], 3 * c);
+    test_set_fill (b, mb, percent[c][1], 3 * c + 1);
+    for (threads = 1; threads <= 4; threads += 3) {
+      for (op = 0; op < 3; ++op) {
+        if (op == 0) {
+          sc_array_merge (out, a, b, sc_int_compare, threads);
+        }
+        else if (op == 1) {
+          sc_array_intersect (out, a, b, sc_int_compare, threads);
+        }
+        else {
+          sc_array_difference (out, a, b, sc_int_compare, threads);
+        }
+        test_set_check (out, ma, mb, op);
+      }
+    }
+  }
+
+  /* parallel removal of duplicates agrees with the serial one */
+  dup = sc_array_new (sizeof (int));
+  for (i = 0; i < 4 * SC_ARRAY_SET_PARALLEL_MIN; ++i) {
+    *(int *) sc_array_push (dup) = i / 3 + (i % 7 == 0);
+  }
+  sc_array_sort (dup, sc_int_compare);
+  ref = sc_array_new (sizeof (int));
+  sc_array_copy (ref, dup);
+  sc_array_uniq (ref, sc_int_compare);
+  sc_array_uniq_parallel (dup, sc_int_compare, 4);
+  SC_CHECK_ABORT (sc_array_is_equal (dup, ref), "Parallel uniq");
+
+  sc_array_destroy (ref);
+  sc_array_destroy (dup);
+  sc_array_destroy (out);
+  sc_array_destroy (b);
+  sc_array_destroy (a);
+  SC_FREE (mb);
+  SC_FREE (ma);
+}
+
+static void
+test_copy_stream (void)
+{
+  const size_t        sizes[5] = { 0, 1, 127, 1000, 3 * (1 << 20) + 5 };
+  const size_t        saved = sc_array_stream_bytes;
+  size_t              zs, zz, n, offs;
+  sc_array_t         *src, *dest, view, part;
+
+  /* stream every copy to exercise the unaligned head and the tail */
+  sc_array_stream_bytes = 0;
+  src = sc_array_new (1);
+  dest = sc_array_new (1);
+  for (zs = 0; zs < 5; ++zs) {
+    n = sizes[zs];
+    sc_array_resize (src, n + 3);
+    for (zz = 0; zz < n + 3; ++zz) {
+      src->array[zz] = (char) (zz * 7 + zs);
+    }
+    for (offs = 0; offs < 3; offs += 2) {
+      sc_array_init_view (&view, src, offs, n);
+      sc_array_copy (dest, &view);
+      SC_CHECK_ABORT (sc_array_is_equal (dest, &view), "Stream copy");
+      sc_array_resize (dest, 0);
+      sc_array_copy_parallel (dest, &view, 4);
+      SC_CHECK_ABORT (sc_array_is_equal (dest, &view), "Parallel copy");
+      sc_array_resize (dest, n + 1);
+      sc_array_copy_into (dest, 1, &view);
+      sc_array_init_view (&part, dest, 1, n);
+      SC_CHECK_ABORT (sc_array_is_equal (&part, &view), "Stream copy into");
+    }
+
+    /* disjoint parts are streamed and overlapping ones moved */
+    sc_array_resize (dest, 2 * n + 1);
+    memset (dest->array, 0, 2 * n + 1);
+    sc_array_init_view (&view, src, 0, n);
+    sc_array_copy_into (dest, 0, &view);
+    sc_array_move_part (dest, n + 1, dest, 0, n);
+    sc_array_init_view (&part, dest, n + 1, n);
+    SC_CHECK_ABORT (sc_array_is_equal (&part, &view), "Stream move");
+    if (n > 1) {
+      sc_array_move_part (dest, 1, dest, n + 1, n);
+      sc_array_init_view (&part, dest, 1, n);
+      SC_CHECK_ABORT (sc_array_is_equal (&part, &view), "Overlapping move");
+    }
+  }
+  sc_array_destroy (dest);
+  sc_array_destroy (src);
+  sc_array_stream_bytes = saved;
+}
+
+typedef struct test_radix
+{
+  int                 index;
+  uint32_t            k32;
+  uint64_t            k64;
+  sc_uint128_t        k128;
+  uint16_t            k16;
+}
+test_radix_t;
+
+static int
+test_typed_compare (const void *v1, const void *v2)
+{
+  const int64_t       i1 = *(const int64_t *) v1;
+  const int64_t       i2 = *(const int64_t *) v2;
+
+  return i1 < i2 ? -1 : i1 > i2;
+}
+
+static void
+test_typed (void)
+{
+  int                 k;
+  size_t              zz, n;
+  double              d, prev;
+  sc_array_t         *a, *b, *q;
+
+  /* the typed sort agrees with the generic one, also with duplicates */
+  for (k = 0; k < 3; ++k) {
+    n = k == 0 ? 10 : 10000;
+    a = sc_array_new (sizeof (int64_t));
+    for (zz = 0; zz < n; ++zz) {
+      *sc_array_int64_push (a) = k == 2 ? rand () % 7 :
+        ((int64_t) rand () << 20) - (int64_t) rand ();
+    }
+    b = sc_array_new_count (sizeof (int64_t), n);
+    sc_array_copy (b, a);
+    sc_array_int64_sort (a);
+    sc_array_sort (b, test_typed_compare);
+    SC_CHECK_ABORT (a->elem_count == n && sc_array_is_equal (a, b),
+                    "Typed sort");
+    SC_CHECK_ABORT (n == 0 || *sc_array_int64_index (a, n - 1) ==
+                    *(int64_t *) sc_array_index (b, n - 1), "Typed index");
+    sc_array_destroy (a);
+    sc_array_destroy (b);
+  }
+
+  /* the typed priority queue returns its elements in ascending order */
+  q = sc_array_new (sizeof (double));
+  for (zz = 0; zz < 1000; ++zz) {
+    sc_array_double_pqueue_add (q, (double) ((zz * 7919) % 1000));
+  }
+  prev = -1.;
+  for (zz = 0; zz < 1000; ++zz) {
+    d = sc_array_double_pqueue_pop (q);
+    SC_CHECK_ABORT (d == prev + 1., "Typed priority queue");
+    prev = d;
+  }
+  SC_CHECK_ABORT (q->elem_count == 0, "Typed priority queue empty");
+  sc_array_destroy (q);
+}
+
+static int
+test_radix_compare16 (const void *v1, const void *v2)
+{
+  const test_radix_t *r1 = (const test_radix_t *) v1;
+  const test_radix_t *r2 = (const test_radix_t *) v2;
+
+  return r1->k16 == r2->k16 ? 0 : r1->k16 < r2->k16 ? -1 : 1;
+}
+
+static void
+test_radix (void)
+{
+  const size_t        n = 10000;
+  int                 which, cmp;
+  size_t              zz, offset, width;
+  test_radix_t       *r, *prev;
+  sc_array_t         *a;
+
+  a = sc_array_new_count (sizeof (test_radix_t), n);
+  for (which = 0; which < 4; ++which) {
+    for (zz = 0; zz < n; ++zz) {
+      r = (test_radix_t *) sc_array_index (a, zz);
+      r->index = (int) zz;
+      r->k32 = (uint32_t) rand () % 1000;
+      r->k64 = ((uint64_t) rand () << 40) | (uint64_t) (rand () % 100);
+      r->k128.high_bits = (uint64_t) (rand () % 10);
+      r->k128.low_bits = (uint64_t) rand () << 20;
+      r->k16 = (uint16_t) (rand () % 50);
+    }
+    switch (which) {
+    case 0:
+      offset = offsetof (test_radix_t, k32);
+      width = sizeof (uint32_t);
+      break;
+    case 1:
+      offset = offsetof (test_radix_t, k64);
+      width = sizeof (uint64_t);
+      break;
+    case 2:
+      offset = offsetof (test_radix_t, k128);
+      width = sizeof (sc_uint128_t);
+      break;
+    default:
+      offset = offsetof (test_radix_t, k16);
+      width = sizeof (uint16_t);
+    }
+    sc_array_sort_radix (a, offset, width, test_radix_compare16);
+
+    /* verify order and, for the radix sorted keys, stability */
+    for (zz = 1; zz < n; ++zz) {
+      prev = (test_radix_t *) sc_array_index (a, zz - 1);
+      r = (test_radix_t *) sc_array_index (a, zz);
+      switch (which) {
+      case 0:
+        cmp = prev->k32 == r->k32 ? 0 : prev->k32 < r->k32 ? -1 : 1;
+        break;
+      case 1:
+        cmp = prev->k64 == r->k64 ? 0 : prev->k64 < r->k64 ? -1 : 1;
+        break;
+      case 2:
+        cmp = sc_uint128_compare (&prev->k128, &r->k128);
+        break;
+      default:
+        cmp = test_radix_compare16 (prev, r);
+      }
+      SC_CHECK_ABORT (cmp <= 0, "Radix sort order");
+      SC_CHECK_ABORT (which == 3 || cmp < 0 || prev->index < r->index,
+                      "Radix sort stability");
+    }
+  }
+  sc_array_destroy (a);
+}
+
+static size_t
+test_split_type (sc_array_t * array, size_t index, void *data)
+{
+  return (size_t) ((int *) sc_array_index (array, index))[0];
+}
+
+static int
+test_isearch_compare (const void *v1, const void *v2)
+{
+  const int           i1 = *(const int *) v1;
+  const int           i2 = *(const int *) v2;
+
+  return i1 < i2 ? -1 : i1 > i2;
+}
+
+static void
+test_isearch (void)
+{
+  int                 k, key;
+  const size_t        n = 5000;
+  size_t              zz;
+  ssize_t             pos;
+  int64_t             v;
+  sc_array_t         *a, *b, *keys, *positions;
+
+  /* uniform, skewed and clustered strictly increasing values */
+  for (k = 0; k < 3; ++k) {
+    a = sc_array_new (sizeof (int64_t));
+    b = sc_array_new (sizeof (int));
+    for (zz = 0, v = -7; zz < n; ++zz) {
+      v += k == 0 ? 1 + rand () % 5 : k == 1 ? 1 + (int64_t) (zz * zz / 100)
+        : zz % 1000 == 0 ? 100000 : 1;
+      *(int64_t *) sc_array_push (a) = v;
+      *(int *) sc_array_push (b) = (int) (v % 1000000);
+    }
+    keys = sc_array_new (sizeof (int64_t));
+    for (v = -10; v < *(int64_t *) sc_array_index (a, n - 1) + 10;
+         v += 1 + (int64_t) rand () % (k == 1 ? 2000 : 3)) {
+      *(int64_t *) sc_array_push (keys) = v;
+    }
+    positions = sc_array_new (sizeof (ssize_t));
+    sc_array_isearch_batch (a, keys, positions);
+    for (zz = 0; zz < keys->elem_count; ++zz) {
+      v = *(int64_t *) sc_array_index (keys, zz);
+      pos = sc_array_isearch (a, v);
+      SC_CHECK_ABORT (pos == *(ssize_t *) sc_array_index (positions, zz),
+                      "Interpolation search batch");
+      SC_CHECK_ABORT (pos == sc_array_bsearch (a, &v, test_typed_compare),
+                      "Interpolation search");
+    }
+
+    /* unsorted keys restart the merge */
+    for (zz = 0; zz < keys->elem_count / 2; ++zz) {
+      v = *(int64_t *) sc_array_index (keys, zz);
+      *(int64_t *) sc_array_index (keys, zz) = *(int64_t *)
+        sc_array_index (keys, keys->elem_count - 1 - zz);
+      *(int64_t *) sc_array_index (keys, keys->elem_count - 1 - zz) = v;
+    }
+    sc_array_isearch_batch (a, keys, positions);
+    for (zz = 0; zz < keys->elem_count; ++zz) {
+      v = *(int64_t *) sc_array_index (keys, zz);
+      SC_CHECK_ABORT (sc_array_isearch (a, v) ==
+                      *(ssize_t *) sc_array_index (positions, zz),
+                      "Interpolation search unsorted");
+    }
+
+    /* arrays of int agree with the binary search when sorted */
+    if (k == 0) {
+      for (key = -10; key < 10000; ++key) {
+        SC_CHECK_ABORT (sc_array_isearch (b, key) ==
+                        sc_array_bsearch (b, &key, test_isearch_compare),
+                        "Interpolation search int");
+      }
+    }
+    sc_array_destroy (positions);
+    sc_array_destroy (keys);
+    sc_array_destroy (b);
+    sc_array_destroy (a);
+  }
+}
+
+static void
+test_split (void)
+{
+  const size_t        n = 50000, num_types = 37;
+  int                 permute, *e, *prev;
+  size_t              zz;
+  sc_array_t         *a, *offsets, *expect;
+
+  a = sc_array_new_count (2 * sizeof (int), n);
+  offsets = sc_array_new (sizeof (size_t));
+  expect = sc_array_new (sizeof (size_t));
+  for (zz = 0; zz < n; ++zz) {
+    e = (int *) sc_array_index (a, zz);
+    e[0] = rand () % (int) num_types;
+    e[1] = (int) zz;
+  }
+
+  /* first sort stably by type, then split the sorted array */
+  for (permute = 1; permute >= 0; --permute) {
+    sc_array_split_parallel (a, offsets, num_types, test_split_type, NULL,
+                             permute, 4);
+    for (zz = 1; zz < n; ++zz) {
+      prev = (int *) sc_array_index (a, zz - 1);
+      e = (int *) sc_array_index (a, zz);
+      SC_CHECK_ABORT (prev[0] < e[0] || (prev[0] == e[0] && prev[1] < e[1]),
+                      "Split permutation");
+    }
+    sc_array_split (a, expect, num_types, test_split_type, NULL);
+    SC_CHECK_ABORT (sc_array_is_equal (offsets, expect), "Split offsets");
+  }
+
+  sc_array_destroy (a);
+  sc_array_destroy (offsets);
+  sc_array_destroy (expect);
+}
+
+static void
+test_permute_inplace (void)
+{
+  const size_t        n = 1000, esize = 3 * sizeof (int);
+  int                 blocked, *e;
+  size_t              zz, zj, *perm, temp;
+  sc_array_t         *a, *p;
+
+  a = sc_array_new_count (esize, n);
+  p = sc_array_new_count (sizeof (size_t), n);
+  perm = (size_t *) p->array;
+  for (zz = 0; zz < n; ++zz) {
+    perm[zz] = zz;
+  }
+  for (zz = n - 1; zz > 0; --zz) {
+    zj = (size_t) rand () % (zz + 1);
+    temp = perm[zz];
+    perm[zz] = perm[zj];
+    perm[zj] = temp;
+  }
+
+  for (blocked = 0; blocked < 2; ++blocked) {
+    for (zz = 0; zz < n; ++zz) {
+      e = (int *) sc_array_index (a, zz);
+      e[0] = e[1] = e[2] = (int) zz;
+    }
+    if (blocked) {
+      sc_array_permute_blocked (a, p, 5);
+    }
+    else {
+      sc_array_permute_inplace (a, p);
+    }
+    SC_CHECK_ABORT (sc_array_is_permutation (p), "Permutation restored");
+    for (zz = 0; zz < n; ++zz) {
+      e = (int *) sc_array_index (a, perm[zz]);
+      SC_CHECK_ABORT (e[0] == (int) zz && e[1] == (int) zz &&
+                      e[2] == (int) zz, "Permutation in place");
+    }
+  }
+
+  sc_array_destroy (a);
+  sc_array_destroy (p);
+}
+
+static int
+test_uint128_is (const sc_uint128_t * a, uint64_t high, uint64_t low)
+{
+  return a->high_bits == high && a->low_bits == low;
+}
+
+static void
+test_uint128 (void)
+{
+  const uint64_t      m = ~(uint64_t) 0;
+  const uint64_t      coords[3] = { 5, 3, 6 };
+  int                 i;
+  sc_uint128_t        a, b, c, r;
+
+  /* carry and borrow between the words */
+  sc_uint128_init (&a, 0, m);
+  sc_uint128_init (&b, 0, 1);
+  sc_uint128_add (&a, &b, &r);
+  SC_CHECK_ABORT (test_uint128_is (&r, 1, 0), "Uint128 add carry");
+  sc_uint128_sub (&r, &b, &a);
+  SC_CHECK_ABORT (test_uint128_is (&a, 0, m), "Uint128 sub borrow");
+  sc_uint128_sub_inplace (&r, &a);
+  SC_CHECK_ABORT (test_uint128_is (&r, 0, 1), "Uint128 sub inplace");
+  sc_uint128_add_inplace (&a, &b);
+  SC_CHECK_ABORT (test_uint128_is (&a, 1, 0), "Uint128 add inplace");
+
+  /* shifts across the word boundary and out of range */
+  sc_uint128_init (&a, 0x8000000000000001ULL, 0x8000000000000001ULL);
+  sc_uint128_shift_left (&a, 0, &r);
+  SC_CHECK_ABORT (sc_uint128_is_equal (&a, &r), "Uint128 shift zero");
+  sc_uint128_shift_left (&a, 1, &r);
+  SC_CHECK_ABORT (test_uint128_is (&r, 3, 2), "Uint128 shift left");
+  sc_uint128_shift_left (&a, 65, &r);
+  SC_CHECK_ABORT (test_uint128_is (&r, 2, 0), "Uint128 shift left 65");
+  sc_uint128_shift_right (&a, 63, &r);
+  SC_CHECK_ABORT (test_uint128_is (&r, 1, 3), "Uint128 shift right");
+  sc_uint128_shift_right (&a, 127, &r);
+  SC_CHECK_ABORT (test_uint128_is (&r, 0, 1), "Uint128 shift right 127");
+  r = a;
+  sc_uint128_shift_right_inplace (&r, 128);
+  SC_CHECK_ABORT (test_uint128_is (&r, 0, 0), "Uint128 shift right 128");
+  r = a;
+  sc_uint128_shift_left_inplace (&r, 64);
+  SC_CHECK_ABORT (test_uint128_is (&r, a.low_bits, 0), "Uint128 shift 64");
+
+  /* products, compared with repeated addition */
+  sc_uint128_mul_64 (m, m, &r);
+  SC_CHECK_ABORT (test_uint128_is (&r, m - 1, 1), "Uint128 mul 64");
+  sc_uint128_init (&a, 0x123456789ULL, 0xfedcba9876543210ULL);
+  sc_uint128_init (&b, 0, 7);
+  sc_uint128_mul (&a, &b, &b);
+  sc_uint128_init (&r, 0, 0);
+  for (i = 0; i < 7; ++i) {
+    sc_uint128_add_inplace (&r, &a);
+  }
+  SC_CHECK_ABORT (sc_uint128_is_equal (&r, &b), "Uint128 mul");
+  sc_uint128_init (&b, 1, 0);
+  sc_uint128_mul (&a, &b, &r);
+  SC_CHECK_ABORT (test_uint128_is (&r, a.low_bits, 0), "Uint128 mul wrap");
+
+  /* the coordinates 101, 011 and 110 interleave to 101 110 011 */
+  sc_uint128_interleave (coords, 3, 3, &r);
+  SC_CHECK_ABORT (test_uint128_is (&r, 0, 0x173), "Uint128 interleave");
+  SC_CHECK_ABORT (sc_uint128_compare (&a, &r) > 0 &&
+                  sc_uint128_compare (&r, &a) < 0 &&
+                  sc_uint128_compare (&a, &a) == 0, "Uint128 compare");
+
+  /* the exported routines agree with their inline versions */
+  sc_uint128_add_inline (&a, &r, &b);
+  sc_uint128_add (&a, &r, &c);
+  SC_CHECK_ABORT (sc_uint128_is_equal_inline (&b, &c) &&
+                  sc_uint128_compare_inline (&a, &r) ==
+                  sc_uint128_compare (&a, &r), "Uint128 inline");
+}
+
+/* remove most slots, iterate over the rest and compact them */
+static void
+test_recycle_array (void)
+{
+  const size_t        n = 1000;
+  size_t              iz, pos, count, mem;
+  sc_recycle_array_t  rec;
+  sc_array_t         *map;
+
+  sc_recycle_array_init (&rec, sizeof (size_t));
+  for (iz = 0; iz < n; ++iz) {
+    *(size_t *) sc_recycle_array_insert (&rec, &pos) = iz;
+    SC_CHECK_ABORT (pos == iz, "Recycle insert");
+  }
+  for (iz = 0; iz < n; ++iz) {
+    if (iz % 7 != 3 && iz != 65) {
+      sc_recycle_array_remove (&rec, iz);
+    }
+  }
+  SC_CHECK_ABORT (sc_recycle_array_is_valid (&rec, 3) &&
+                  !sc_recycle_array_is_valid (&rec, 4), "Recycle valid");
+
+  /* the freed slots are reused */
+  *(size_t *) sc_recycle_array_insert (&rec, &pos) = pos;
+  SC_CHECK_ABORT (pos < n && sc_recycle_array_is_valid (&rec, pos),
+                  "Recycle reuse");
+  sc_recycle_array_remove (&rec, pos);
+
+  count = 0;
+  for (iz = sc_recycle_array_next (&rec, 0); iz < rec.a.elem_count;
+       iz = sc_recycle_array_next (&rec, iz + 1)) {
+    SC_CHECK_ABORT ((iz % 7 == 3 || iz == 65) &&
+                    *(size_t *) sc_array_index (&rec.a, iz) == iz,
+                    "Recycle next");
+    ++count;
+  }
+  SC_CHECK_ABORT (count == rec.elem_count, "Recycle count");
+
+  mem = rec.a.byte_alloc;
+  map = sc_array_new (sizeof (size_t));
+  sc_recycle_array_compact (&rec, map);
+  SC_CHECK_ABORT (rec.a.elem_count == count && rec.f.elem_count == 0 &&
+                  map->elem_count == n && (size_t) rec.a.byte_alloc < mem,
+                  "Recycle compact");
+  for (iz = 0; iz < n; ++iz) {
+    pos = *(size_t *) sc_array_index (map, iz);
+    if (pos == SC_RECYCLE_ARRAY_NONE) {
+      SC_CHECK_ABORT (iz % 7 != 3 && iz != 65, "Recycle map hole");
+    }
+    else {
+      SC_CHECK_ABORT (*(size_t *) sc_array_index (&rec.a, pos) == iz &&
+                      sc_recycle_array_is_valid (&rec, pos),
+                      "Recycle map");
+    }
+  }
+  SC_CHECK_ABORT (sc_recycle_array_next (&rec, count - 1) == count - 1,
+                  "Recycle compact last");
+
+  /* inserting after compaction appends */
+  sc_recycle_array_insert (&rec, &pos);
+  SC_CHECK_ABORT (pos == count, "Recycle append");
+
+  sc_array_destroy (map);
+  sc_recycle_array_remove (&rec, pos);
+  sc_recycle_array_compact (&rec, NULL);
+  for (iz = 0; iz < count; ++iz) {
+    sc_recycle_array_remove (&rec, iz);
+  }
+  sc_recycle_array_reset (&rec);
+}
+
 int
 main (int argc, char **argv)
 {
@@ -186,6 +1042,8 @@ main (int argc, char **argv)
   test_new_count (a);
   test_new_view (a);
   test_new_data (a);
+  test_split ();
+  test_isearch ();
 
   for (i = 0; i < N; ++i) {
     pe = (int *) sc_array_index_int (a, i);
@@ -272,6 +1130,17 @@ main (int argc, char **argv)
   SC_FREE (data);
 
   test_mstamp ();
+  test_arena ();
+  test_allocator ();
+  test_policy ();
+  test_mmap ();
+  test_sets ();
+  test_radix ();
+  test_typed ();
+  test_copy_stream ();
+  test_permute_inplace ();
+  test_uint128 ();
+  test_recycle_array ();
 
   sc_finalize ();
 
@@ -0,0 +1,138 @@
+/*
+  This file is part of the SC Library.
+  The SC Library provides support for parallel scientific applications.
+
+  Copyright (C) 2010 The University of Texas System
+  Additional copyright (C) 2011 individual authors
+
+  The SC Library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  The SC Library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with the SC Library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+  02110-1301, USA.
+*/
+
+#include <sc_bitset.h>
+#include <sc_random.h>
+
+/* compare all queries against an array of char flags */
+static void
+test_bitset_verify (sc_bitset_t * bs, const char *flags)
+{
+  size_t              pos, count, next;
+
+  sc_bitset_build_rank (bs);
+  count = 0;
+  next = sc_bitset_next (bs, 0);
+  for (pos = 0; pos < bs->num_bits; ++pos) {
+    SC_CHECK_ABORT (sc_bitset_test (bs, pos) == flags[pos], "Test bit");
+    SC_CHECK_ABORT (sc_bitset_rank (bs, pos) == count, "Rank");
+    if (flags[pos]) {
+      SC_CHECK_ABORT (next == pos, "Next");
+      SC_CHECK_ABORT (sc_bitset_select (bs, count) == pos, "Select");
+      next = sc_bitset_next (bs, pos + 1);
+      ++count;
+    }
+  }
+  SC_CHECK_ABORT (next == bs->num_bits, "Next end");
+  SC_CHECK_ABORT (sc_bitset_rank (bs, bs->num_bits) == count, "Rank end");
+  SC_CHECK_ABORT (sc_bitset_select (bs, count) == bs->num_bits,
+                  "Select end");
+  SC_CHECK_ABORT (sc_bitset_count (bs) == count, "Count");
+}
+
+static void
+test_bitset_random (size_t num_bits, double density, sc_rand_state_t * state)
+{
+  size_t              pos;
+  char               *flags;
+  sc_bitset_t        *bs;
+
+  bs = sc_bitset_new (num_bits);
+  flags = SC_ALLOC_ZERO (char, num_bits + 1);
+  test_bitset_verify (bs, flags);
+  for (pos = 0; pos < num_bits; ++pos) {
+    if (sc_rand (state) < density) {
+      sc_bitset_set (bs, pos);
+      flags[pos] = 1;
+    }
+  }
+  test_bitset_verify (bs, flags);
+
+  /* clear some bits again */
+  for (pos = 0; pos < num_bits; pos += 3) {
+    sc_bitset_clear (bs, pos);
+    flags[pos] = 0;
+  }
+  test_bitset_verify (bs, flags);
+
+  /* grow and shrink keeping the common bits */
+  sc_bitset_resize (bs, num_bits + 100);
+  flags = SC_REALLOC (flags, char, num_bits + 100);
+  memset (flags + num_bits, 0, 100);
+  test_bitset_verify (bs, flags);
+  sc_bitset_resize (bs, num_bits / 2 + 1);
+  test_bitset_verify (bs, flags);
+
+  /* all set */
+  sc_bitset_fill (bs, 1);
+  memset (flags, 1, bs->num_bits);
+  test_bitset_verify (bs, flags);
+  sc_bitset_fill (bs, 0);
+  memset (flags, 0, bs->num_bits);
+  test_bitset_verify (bs, flags);
+
+  SC_FREE (flags);
+  sc_bitset_destroy (bs);
+}
+
+int
+main (int argc, char **argv)
+{
+  int                 mpiret;
+  size_t              pos;
+  sc_rand_state_t     state = 3;
+  sc_bitset_t        *bs;
+
+  mpiret = sc_MPI_Init (&argc, &argv);
+  SC_CHECK_MPI (mpiret);
+
+  sc_init (sc_MPI_COMM_WORLD, 1, 1, NULL, SC_LP_DEFAULT);
+
+  test_bitset_random (0, .5, &state);
+  test_bitset_random (1, .5, &state);
+  test_bitset_random (63, .5, &state);
+  test_bitset_random (64, .5, &state);
+  test_bitset_random (1000, .01, &state);
+  test_bitset_random (100000, .5, &state);
+  test_bitset_random (100003, .001, &state);
+  test_bitset_random (SC_BITSET_BLOCK_BITS * 7, .99, &state);
+
+  /* one bit per flag and an eighth of that for the directory */
+  bs = sc_bitset_new (1000000);
+  for (pos = 0; pos < 1000000; pos += 7) {
+    sc_bitset_set (bs, pos);
+  }
+  sc_bitset_build_rank (bs);
+  SC_CHECK_ABORT (sc_bitset_memory_used (bs) < 1000000 / 8 * 114 / 100 +
+                  sizeof (sc_bitset_t) + 1024, "Memory used");
+  SC_CHECK_ABORT (sc_bitset_select (bs, 1000) == 7000, "Select sample");
+  SC_CHECK_ABORT (sc_bitset_rank (bs, 7001) == 1001, "Rank sample");
+  sc_bitset_destroy (bs);
+
+  sc_finalize ();
+
+  mpiret = sc_MPI_Finalize ();
+  SC_CHECK_MPI (mpiret);
+
+  return 0;
+}
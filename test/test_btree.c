@@ -0,0 +1,307 @@
+/*
+  This file is part of the SC Library.
+  The SC Library provides support for parallel scientific applications.
+
+  Copyright (C) 2010 The University of Texas System
+  Additional copyright (C) 2011 individual authors
+
+  The SC Library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  The SC Library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with the SC Library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+  02110-1301, USA.
+*/
+
+#include <sc_btree.h>
+#include <sc_avl.h>
+#include <sc_random.h>
+
+#define TEST_BTREE_COUNT 20000
+
+static int
+test_btree_compare (const void *a, const void *b)
+{
+  const long          x = *(const long *) a, y = *(const long *) b;
+
+  return x < y ? -1 : x > y;
+}
+
+/* insert into or remove from the sorted reference array */
+static void
+test_btree_ref_insert (sc_array_t * ref, size_t pos, long v)
+{
+  long               *a;
+
+  (void) sc_array_push (ref);
+  a = (long *) ref->array;
+  memmove (a + pos + 1, a + pos, (ref->elem_count - 1 - pos) * sizeof (long));
+  a[pos] = v;
+}
+
+static void
+test_btree_ref_remove (sc_array_t * ref, size_t pos)
+{
+  long               *a = (long *) ref->array;
+
+  memmove (a + pos, a + pos + 1, (ref->elem_count - 1 - pos) * sizeof (long));
+  sc_array_resize (ref, ref->elem_count - 1);
+}
+
+static void
+test_btree_sum (void *elem, void *user)
+{
+  *(long *) user += *(long *) elem;
+}
+
+/* compare the tree with a sorted reference array of its elements */
+static void
+test_btree_verify (sc_btree_t * tree, sc_array_t * ref, sc_array_t * out)
+{
+  size_t              i;
+  long                v, sum, refsum;
+  void               *found;
+
+  SC_CHECK_ABORT (sc_btree_count (tree) == ref->elem_count, "Count");
+  sc_btree_to_array (tree, out);
+  SC_CHECK_ABORT (out->elem_count == ref->elem_count &&
+                  (ref->elem_count == 0 ||
+                   !memcmp (out->array, ref->array,
+                            ref->elem_count * sizeof (long))), "To array");
+
+  for (refsum = 0, i = 0; i < ref->elem_count; ++i) {
+    v = *(long *) sc_array_index (ref, i);
+    refsum += v;
+    SC_CHECK_ABORT (*(long *) sc_btree_at (tree, i) == v, "At");
+    SC_CHECK_ABORT (sc_btree_index (tree, &v) == i, "Index");
+    SC_CHECK_ABORT (sc_btree_search (tree, &v) == sc_btree_at (tree, i),
+                    "Search");
+    SC_CHECK_ABORT (sc_btree_search_closest (tree, &v, &found) == 0 &&
+                    *(long *) found == v, "Closest equal");
+
+    /* odd values are never inserted */
+    ++v;
+    SC_CHECK_ABORT (sc_btree_search (tree, &v) == NULL &&
+                    sc_btree_index (tree, &v) == i + 1, "Absent");
+    if (i + 1 < ref->elem_count) {
+      SC_CHECK_ABORT (sc_btree_search_closest (tree, &v, &found) == 1 &&
+                      found == sc_btree_at (tree, i + 1), "Closest next");
+    }
+    else {
+      SC_CHECK_ABORT (sc_btree_search_closest (tree, &v, &found) == -1 &&
+                      found == sc_btree_at (tree, i), "Closest last");
+    }
+  }
+  SC_CHECK_ABORT (sc_btree_at (tree, ref->elem_count) == NULL, "At end");
+
+  sum = 0;
+  sc_btree_foreach (tree, test_btree_sum, &sum);
+  SC_CHECK_ABORT (sum == refsum, "Foreach");
+}
+
+/* wide elements give the smallest fanout and deep trees */
+static void
+test_btree_wide (sc_rand_state_t * state)
+{
+  int                 i, k;
+  long                wide[20], prev;
+  size_t              j;
+  sc_btree_t         *tree;
+
+  tree = sc_btree_new (sizeof (wide), test_btree_compare);
+  memset (wide, 0, sizeof (wide));
+  for (k = 0; k < 2; ++k) {
+    for (i = 0; i < 4000; ++i) {
+      wide[0] = (long) (sc_rand (state) * 3000.);
+      wide[19] = -wide[0];
+      if (sc_rand (state) < .7 - .5 * k) {
+        (void) sc_btree_insert (tree, wide, NULL);
+      }
+      else {
+        (void) sc_btree_remove (tree, wide, NULL);
+      }
+      SC_CHECK_ABORT (sc_btree_search (tree, wide) == NULL ||
+                      sc_btree_index (tree, wide) < sc_btree_count (tree),
+                      "Wide search");
+    }
+    for (prev = -1, j = 0; j < sc_btree_count (tree); ++j) {
+      memcpy (wide, sc_btree_at (tree, j), sizeof (wide));
+      SC_CHECK_ABORT (wide[0] > prev && wide[19] == -wide[0] &&
+                      sc_btree_index (tree, wide) == j, "Wide order");
+      prev = wide[0];
+    }
+  }
+  sc_btree_destroy (tree);
+}
+
+/* insert into a mempool-backed AVL tree and rebuild it in bulk */
+static void
+test_btree_avl_pool (sc_array_t * keys, double t_avl)
+{
+  unsigned int        u, n;
+  size_t              pos;
+  double              t_pool, t_bulk;
+  void              **pp;
+  sc_array_t         *items;
+  sc_mempool_t       *pool;
+  avl_tree_t          avl, bulk;
+  avl_node_t         *node;
+
+  pool = sc_mempool_new (sizeof (avl_node_t));
+  avl_init_tree_ext (&avl, test_btree_compare, NULL, pool);
+  t_pool = -sc_MPI_Wtime ();
+  for (pos = 0; pos < keys->elem_count; ++pos) {
+    (void) avl_insert (&avl, sc_array_index (keys, pos));
+  }
+  t_pool += sc_MPI_Wtime ();
+
+  items = sc_array_new (sizeof (void *));
+  avl_to_array (&avl, items);
+  n = avl_count (&avl);
+  avl_init_tree_ext (&bulk, test_btree_compare, NULL, pool);
+  t_bulk = -sc_MPI_Wtime ();
+  avl_from_sorted_array (&bulk, items);
+  t_bulk += sc_MPI_Wtime ();
+  SC_GLOBAL_STATISTICSF ("AVL tree %g with mempool %g bulk build %g\n",
+                         t_avl, t_pool, t_bulk);
+
+  /* the bulk tree must agree with the incremental one */
+  SC_CHECK_ABORT (avl_count (&bulk) == n, "AVL bulk count");
+  for (u = 0, node = bulk.head; u < n; ++u, node = node->next) {
+    pp = (void **) sc_array_index (items, (size_t) u);
+    SC_CHECK_ABORT (node != NULL && node->item == *pp, "AVL bulk order");
+    SC_CHECK_ABORT (avl_at (&bulk, u) == node && avl_index (node) == u,
+                    "AVL bulk rank");
+    SC_CHECK_ABORT (avl_search (&bulk, *pp) == node, "AVL bulk search");
+  }
+  SC_CHECK_ABORT (node == NULL && (n == 0 || bulk.tail->item ==
+                                   *(void **) sc_array_index (items,
+                                                              n - 1)),
+                  "AVL bulk tail");
+
+  /* the bulk tree stays usable for deletion and insertion */
+  for (u = 0; u < n; u += 2) {
+    pp = (void **) sc_array_index (items, (size_t) u);
+    (void) avl_delete (&bulk, *pp);
+  }
+  for (u = 0; u < n; u += 2) {
+    pp = (void **) sc_array_index (items, (size_t) u);
+    SC_CHECK_ABORT (avl_insert (&bulk, *pp) != NULL, "AVL bulk insert");
+  }
+  SC_CHECK_ABORT (avl_count (&bulk) == n, "AVL bulk reinsert");
+  SC_CHECK_ABORT (pool->elem_count == 2 * (size_t) n, "AVL pool count");
+
+  avl_free_nodes (&bulk);
+  avl_free_nodes (&avl);
+  SC_CHECK_ABORT (pool->elem_count == 0, "AVL pool empty");
+  sc_mempool_destroy (pool);
+  sc_array_destroy (items);
+}
+
+int
+main (int argc, char **argv)
+{
+  int                 mpiret;
+  int                 i, round;
+  size_t              pos;
+  long                v, removed, *found;
+  double              t_btree, t_avl;
+  sc_rand_state_t     state = 11;
+  sc_array_t         *ref, *out, *keys;
+  sc_btree_t         *tree;
+  avl_tree_t         *avl;
+
+  mpiret = sc_MPI_Init (&argc, &argv);
+  SC_CHECK_MPI (mpiret);
+
+  sc_init (sc_MPI_COMM_WORLD, 1, 1, NULL, SC_LP_DEFAULT);
+
+  tree = sc_btree_new (sizeof (long), test_btree_compare);
+  ref = sc_array_new (sizeof (long));
+  out = sc_array_new (sizeof (long));
+  test_btree_verify (tree, ref, out);
+
+  /* grow and shrink the tree through several heights */
+  for (round = 0; round < 4; ++round) {
+    for (i = 0; i < TEST_BTREE_COUNT; ++i) {
+      v = 2 * (long) (sc_rand (&state) * TEST_BTREE_COUNT);
+      pos = sc_array_bsearch (ref, &v, test_btree_compare) < 0 ?
+        (size_t) sc_btree_index (tree, &v) : (size_t) -1;
+      SC_CHECK_ABORT (sc_btree_insert (tree, &v, (void **) &found) ==
+                      (pos != (size_t) -1) && *found == v, "Insert");
+      if (pos != (size_t) -1) {
+        test_btree_ref_insert (ref, pos, v);
+      }
+    }
+    test_btree_verify (tree, ref, out);
+
+    /* remove a random subset, more of it in later rounds */
+    for (i = 0; i < TEST_BTREE_COUNT * (round + 1) / 4; ++i) {
+      v = 2 * (long) (sc_rand (&state) * TEST_BTREE_COUNT);
+      pos = (size_t) sc_array_bsearch (ref, &v, test_btree_compare);
+      SC_CHECK_ABORT (sc_btree_remove (tree, &v, &removed) ==
+                      (pos != (size_t) -1), "Remove");
+      if (pos != (size_t) -1) {
+        SC_CHECK_ABORT (removed == v, "Removed element");
+        test_btree_ref_remove (ref, pos);
+      }
+    }
+    test_btree_verify (tree, ref, out);
+  }
+
+  /* remove everything and reuse the tree */
+  while (ref->elem_count > 0) {
+    pos = (size_t) (sc_rand (&state) * ref->elem_count);
+    SC_CHECK_ABORT (sc_btree_remove
+                    (tree, sc_array_index (ref, pos), NULL), "Remove all");
+    test_btree_ref_remove (ref, pos);
+  }
+  test_btree_verify (tree, ref, out);
+  test_btree_wide (&state);
+  SC_GLOBAL_STATISTICSF ("B+ tree memory %llu\n", (unsigned long long)
+                         sc_btree_memory_used (tree));
+
+  /* time the insertion of many keys against the AVL tree */
+  keys = sc_array_new_count (sizeof (long), 10 * TEST_BTREE_COUNT);
+  for (pos = 0; pos < keys->elem_count; ++pos) {
+    *(long *) sc_array_index (keys, pos) =
+      (long) (sc_rand (&state) * 1e12);
+  }
+  sc_btree_reset (tree);
+  t_btree = -sc_MPI_Wtime ();
+  for (pos = 0; pos < keys->elem_count; ++pos) {
+    (void) sc_btree_insert (tree, sc_array_index (keys, pos), NULL);
+  }
+  t_btree += sc_MPI_Wtime ();
+  avl = avl_alloc_tree (test_btree_compare, NULL);
+  t_avl = -sc_MPI_Wtime ();
+  for (pos = 0; pos < keys->elem_count; ++pos) {
+    (void) avl_insert (avl, sc_array_index (keys, pos));
+  }
+  t_avl += sc_MPI_Wtime ();
+  SC_CHECK_ABORT (avl_count (avl) == sc_btree_count (tree), "AVL count");
+  SC_GLOBAL_STATISTICSF ("Insert %llu keys: B+ tree %g AVL tree %g\n",
+                         (unsigned long long) keys->elem_count, t_btree,
+                         t_avl);
+  avl_free_tree (avl);
+  test_btree_avl_pool (keys, t_avl);
+
+  sc_array_destroy (keys);
+  sc_array_destroy (ref);
+  sc_array_destroy (out);
+  sc_btree_destroy (tree);
+  sc_finalize ();
+
+  mpiret = sc_MPI_Finalize ();
+  SC_CHECK_MPI (mpiret);
+
+  return 0;
+}
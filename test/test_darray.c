@@ -0,0 +1,164 @@
+/*
+  This file is part of the SC Library.
+  The SC Library provides support for parallel scientific applications.
+
+  Copyright (C) 2010 The University of Texas System
+  Additional copyright (C) 2011 individual authors
+
+  The SC Library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  The SC Library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with the SC Library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+  02110-1301, USA.
+*/
+
+#include <sc_darray.h>
+
+#define TEST_DARRAY_COUNT 100000
+
+/* check the elements by index, through the segment views and flattened */
+static void
+test_darray_verify (sc_darray_t * darray, sc_array_t * flat)
+{
+  int                 k, num_segments;
+  size_t              iz, begin, total;
+  sc_array_t          view;
+
+  for (iz = 0; iz < darray->elem_count; ++iz) {
+    SC_CHECK_ABORT (*(long *) sc_darray_index (darray, iz) == (long) iz,
+                    "Index");
+  }
+
+  total = 0;
+  num_segments = sc_darray_num_segments (darray);
+  SC_CHECK_ABORT (num_segments <= darray->num_alloc &&
+                  darray->num_alloc <= num_segments + 1, "Segment count");
+  for (k = 0; k < num_segments; ++k) {
+    begin = sc_darray_segment (darray, k, &view);
+    SC_CHECK_ABORT (begin == total && view.elem_count > 0, "Segment begin");
+    SC_CHECK_ABORT (sc_array_index (&view, 0) ==
+                    sc_darray_index (darray, begin), "Segment view");
+    for (iz = 0; iz < view.elem_count; ++iz) {
+      SC_CHECK_ABORT (*(long *) sc_array_index (&view, iz) ==
+                      (long) (begin + iz), "Segment element");
+    }
+    total += view.elem_count;
+  }
+  SC_CHECK_ABORT (total == darray->elem_count, "Segment total");
+
+  sc_darray_compact (darray, flat);
+  SC_CHECK_ABORT (flat->elem_count == darray->elem_count, "Compact count");
+  for (iz = 0; iz < flat->elem_count; ++iz) {
+    SC_CHECK_ABORT (*(long *) sc_array_index (flat, iz) == (long) iz,
+                    "Compact element");
+  }
+}
+
+/* elements larger than the first segment yield one element in it */
+static void
+test_darray_wide (void)
+{
+  const size_t        wide = SC_DARRAY_FIRST_BYTES + 8;
+  size_t              iz;
+  char               *elem;
+  sc_darray_t         darray;
+
+  sc_darray_init (&darray, wide);
+  SC_CHECK_ABORT (darray.first_log2 == 0, "Wide first segment");
+  for (iz = 0; iz < 100; ++iz) {
+    elem = (char *) sc_darray_push (&darray);
+    memset (elem, (int) iz, wide);
+  }
+  for (iz = 0; iz < 100; ++iz) {
+    elem = (char *) sc_darray_index (&darray, iz);
+    SC_CHECK_ABORT (elem[0] == (char) iz && elem[wide - 1] == (char) iz,
+                    "Wide element");
+  }
+  SC_CHECK_ABORT (sc_darray_num_segments (&darray) == 7, "Wide segments");
+  sc_darray_reset (&darray);
+  SC_CHECK_ABORT (sc_darray_memory_used (&darray, 0) == 0, "Wide reset");
+}
+
+int
+main (int argc, char **argv)
+{
+  int                 mpiret;
+  size_t              iz, mem;
+  long               *first, *middle;
+  sc_darray_t        *darray;
+  sc_array_t         *flat;
+
+  mpiret = sc_MPI_Init (&argc, &argv);
+  SC_CHECK_MPI (mpiret);
+
+  sc_init (sc_MPI_COMM_WORLD, 1, 1, NULL, SC_LP_DEFAULT);
+
+  darray = sc_darray_new (sizeof (long));
+  flat = sc_array_new (sizeof (long));
+  test_darray_verify (darray, flat);
+
+  /* elements keep their address while the array grows */
+  first = middle = NULL;
+  for (iz = 0; iz < TEST_DARRAY_COUNT; ++iz) {
+    *(long *) sc_darray_push (darray) = (long) iz;
+    if (iz == 0) {
+      first = (long *) sc_darray_index (darray, 0);
+    }
+    else if (iz == TEST_DARRAY_COUNT / 10) {
+      middle = (long *) sc_darray_index (darray, iz);
+    }
+  }
+  SC_CHECK_ABORT (first == sc_darray_index (darray, 0) &&
+                  middle == sc_darray_index (darray, TEST_DARRAY_COUNT / 10),
+                  "Stable addresses");
+  test_darray_verify (darray, flat);
+
+  /* the unused part is less than the used part */
+  mem = sc_darray_memory_used (darray, 1);
+  SC_CHECK_ABORT (mem < sizeof (sc_darray_t) +
+                  2 * TEST_DARRAY_COUNT * sizeof (long), "Memory used");
+  SC_GLOBAL_STATISTICSF ("Segmented array of %llu longs uses %llu bytes"
+                         " in %d segments\n",
+                         (unsigned long long) darray->elem_count,
+                         (unsigned long long) mem,
+                         sc_darray_num_segments (darray));
+
+  /* shrink, pop and grow again */
+  sc_darray_resize (darray, TEST_DARRAY_COUNT / 10 + 1);
+  SC_CHECK_ABORT (sc_darray_memory_used (darray, 1) < mem, "Shrink");
+  SC_CHECK_ABORT (*(long *) sc_darray_pop (darray) ==
+                  TEST_DARRAY_COUNT / 10, "Pop");
+  test_darray_verify (darray, flat);
+  for (iz = darray->elem_count; iz < 2 * TEST_DARRAY_COUNT; ++iz) {
+    *(long *) sc_darray_push (darray) = (long) iz;
+  }
+  SC_CHECK_ABORT (first == sc_darray_index (darray, 0), "Stable again");
+  test_darray_verify (darray, flat);
+
+  /* pop across segment boundaries down to the empty array */
+  while (darray->elem_count > 0) {
+    iz = darray->elem_count - 1;
+    SC_CHECK_ABORT (*(long *) sc_darray_pop (darray) == (long) iz,
+                    "Pop all");
+  }
+  test_darray_verify (darray, flat);
+  test_darray_wide ();
+
+  sc_array_destroy (flat);
+  sc_darray_destroy (darray);
+  sc_finalize ();
+
+  mpiret = sc_MPI_Finalize ();
+  SC_CHECK_MPI (mpiret);
+
+  return 0;
+}
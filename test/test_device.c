@@ -0,0 +1,231 @@
+/*
+  This file is part of the SC Library.
+  The SC Library provides support for parallel scientific applications.
+
+  Copyright (C) 2010 The University of Texas System
+  Additional copyright (C) 2011 individual authors
+
+  The SC Library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  The SC Library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with the SC Library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+  02110-1301, USA.
+*/
+
+#include <sc_device.h>
+
+/* the device is emulated by host memory that counts the transfers */
+typedef struct test_device_counts
+{
+  int                 allocs;
+  int                 copies;
+}
+test_device_counts_t;
+
+static void        *
+test_device_alloc (size_t size, void *user)
+{
+  ++((test_device_counts_t *) user)->allocs;
+  return malloc (SC_MAX (size, 1));
+}
+
+static void
+test_device_free (void *ptr, void *user)
+{
+  if (ptr != NULL) {
+    --((test_device_counts_t *) user)->allocs;
+    free (ptr);
+  }
+}
+
+static void
+test_device_memcpy (void *dest, const void *src, size_t size, void *user)
+{
+  ++((test_device_counts_t *) user)->copies;
+  memcpy (dest, src, size);
+}
+
+static void
+test_device_init (sc_device_t * device, test_device_counts_t * counts)
+{
+  memset (device, 0, sizeof (sc_device_t));
+  memset (counts, 0, sizeof (test_device_counts_t));
+  device->alloc = test_device_alloc;
+  device->free = test_device_free;
+  device->to_host = test_device_memcpy;
+  device->to_device = test_device_memcpy;
+  device->stage_bytes = 96;
+  device->user = counts;
+}
+
+static void
+test_device_array (void)
+{
+  int                 i;
+  sc_array_t          darr, *harr;
+  sc_array_allocator_t allocator;
+  sc_device_t         device;
+  test_device_counts_t counts;
+
+  test_device_init (&device, &counts);
+  sc_device_array_allocator (&allocator, &device);
+  sc_array_init_allocator (&darr, sizeof (int), &allocator);
+
+  /* growing the device array stages its contents in small pieces */
+  harr = sc_array_new_count (sizeof (int), 100);
+  for (i = 0; i < 100; ++i) {
+    *(int *) sc_array_index_int (harr, i) = i;
+  }
+  sc_device_array_to_device (&darr, harr, &device);
+  SC_CHECK_ABORT (counts.allocs == 1 && counts.copies == 1,
+                  "Device upload");
+  sc_array_resize (&darr, 1000);
+  SC_CHECK_ABORT (counts.allocs == 1 && counts.copies >= 1 + 2 * 5 &&
+                  counts.copies % 2 == 1, "Device staged reallocation");
+  sc_array_resize (harr, 0);
+  sc_array_resize (&darr, 100);
+  sc_device_array_to_host (harr, &darr, &device);
+  for (i = 0; i < 100; ++i) {
+    SC_CHECK_ABORT (*(int *) sc_array_index_int (harr, i) == i,
+                    "Device download");
+  }
+  sc_array_reset (&darr);
+  SC_CHECK_ABORT (counts.allocs == 0, "Device free");
+  sc_array_destroy (harr);
+}
+
+static void
+test_device_notify (sc_MPI_Comm mpicomm)
+{
+  int                 mpiret;
+  int                 mpisize, mpirank;
+  int                 i;
+  sc_array_t         *rec, *snd, *hpay;
+  sc_array_t          dpay;
+  sc_array_allocator_t allocator;
+  sc_device_t         device;
+  sc_notify_t        *notify;
+  test_device_counts_t counts;
+
+  mpiret = sc_MPI_Comm_size (mpicomm, &mpisize);
+  SC_CHECK_MPI (mpiret);
+  mpiret = sc_MPI_Comm_rank (mpicomm, &mpirank);
+  SC_CHECK_MPI (mpiret);
+
+  /* every rank notifies the next one with its number times ten */
+  test_device_init (&device, &counts);
+  sc_device_array_allocator (&allocator, &device);
+  rec = sc_array_new_count (sizeof (int), 1);
+  *(int *) sc_array_index (rec, 0) = (mpirank + 1) % mpisize;
+  snd = sc_array_new (sizeof (int));
+  hpay = sc_array_new_count (sizeof (int), 1);
+  *(int *) sc_array_index (hpay, 0) = 10 * mpirank;
+  sc_array_init_allocator (&dpay, sizeof (int), &allocator);
+  sc_device_array_to_device (&dpay, hpay, &device);
+
+  notify = sc_notify_new (mpicomm);
+  sc_device_notify_payload (rec, snd, &dpay, NULL, 1, notify, &device);
+  sc_notify_destroy (notify);
+
+  sc_device_array_to_host (hpay, &dpay, &device);
+  SC_CHECK_ABORT (snd->elem_count == 1 && hpay->elem_count == 1,
+                  "Device notify count");
+  i = *(int *) sc_array_index (snd, 0);
+  SC_CHECK_ABORT (i == (mpirank + mpisize - 1) % mpisize &&
+                  *(int *) sc_array_index (hpay, 0) == 10 * i,
+                  "Device notify payload");
+  sc_array_reset (&dpay);
+  SC_CHECK_ABORT (counts.allocs == 0, "Device notify free");
+  sc_array_destroy (hpay);
+  sc_array_destroy (snd);
+  sc_array_destroy (rec);
+}
+
+static void
+test_device_write (sc_MPI_Comm mpicomm, int mpi_aware, const char *filename)
+{
+  int                 mpiret, errcode;
+  int                 mpirank, ocount;
+  int                 i, n, first;
+  int                *data, *back;
+  sc_MPI_File         file;
+  sc_device_t         device;
+  test_device_counts_t counts;
+
+  mpiret = sc_MPI_Comm_rank (mpicomm, &mpirank);
+  SC_CHECK_MPI (mpiret);
+
+  /* the ranks write different numbers of staging pieces */
+  test_device_init (&device, &counts);
+  device.mpi_aware = mpi_aware;
+  n = 50 * (mpirank + 1);
+  first = 25 * mpirank * (mpirank + 1);
+  data = (int *) device.alloc (n * sizeof (int), device.user);
+  back = SC_ALLOC (int, n);
+  for (i = 0; i < n; ++i) {
+    data[i] = first + i;
+  }
+
+  errcode = sc_io_open (mpicomm, filename, SC_IO_WRITE_CREATE,
+                        sc_MPI_INFO_NULL, &file);
+  SC_CHECK_ABORT (errcode == sc_MPI_SUCCESS, "Device open");
+  errcode = sc_device_io_write_at_all (mpicomm, file, (sc_MPI_Offset)
+                                       (first * sizeof (int)), data, n,
+                                       sc_MPI_INT, &ocount, &device);
+  SC_CHECK_ABORT (errcode == sc_MPI_SUCCESS && ocount == n,
+                  "Device write");
+  SC_CHECK_ABORT (mpi_aware ? counts.copies == 0 : counts.copies > 0,
+                  "Device write staging");
+  errcode = sc_io_close (&file);
+  SC_CHECK_ABORT (errcode == sc_MPI_SUCCESS, "Device close");
+
+  errcode = sc_io_open (mpicomm, filename, SC_IO_READ,
+                        sc_MPI_INFO_NULL, &file);
+  SC_CHECK_ABORT (errcode == sc_MPI_SUCCESS, "Device open");
+  errcode = sc_io_read_at_all (file, (sc_MPI_Offset) (first * sizeof (int)),
+                               back, n, sc_MPI_INT, &ocount);
+  SC_CHECK_ABORT (errcode == sc_MPI_SUCCESS && ocount == n &&
+                  !memcmp (data, back, n * sizeof (int)), "Device read");
+  errcode = sc_io_close (&file);
+  SC_CHECK_ABORT (errcode == sc_MPI_SUCCESS, "Device close");
+
+  mpiret = sc_MPI_Barrier (mpicomm);
+  SC_CHECK_MPI (mpiret);
+  if (mpirank == 0) {
+    (void) remove (filename);
+  }
+  SC_FREE (back);
+  device.free (data, device.user);
+}
+
+int
+main (int argc, char **argv)
+{
+  int                 mpiret;
+
+  mpiret = sc_MPI_Init (&argc, &argv);
+  SC_CHECK_MPI (mpiret);
+
+  sc_init (sc_MPI_COMM_WORLD, 1, 1, NULL, SC_LP_DEFAULT);
+
+  test_device_array ();
+  test_device_notify (sc_MPI_COMM_WORLD);
+  test_device_write (sc_MPI_COMM_WORLD, 0, "sc_test_device.bin");
+  test_device_write (sc_MPI_COMM_WORLD, 1, "sc_test_device.bin");
+
+  sc_finalize ();
+
+  mpiret = sc_MPI_Finalize ();
+  SC_CHECK_MPI (mpiret);
+
+  return 0;
+}
@@ -0,0 +1,192 @@
+/*
+  This file is part of the SC Library.
+  The SC Library provides support for parallel scientific applications.
+
+  Copyright (C) 2010 The University of Texas System
+  Additional copyright (C) 2011 individual authors
+
+  The SC Library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  The SC Library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with the SC Library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+  02110-1301, USA.
+*/
+
+#include <sc_dhash.h>
+
+#define TEST_DHASH_KEYS 100
+
+/** An item of the distributed table. */
+typedef struct test_item
+{
+  uint64_t            key;
+  int64_t             value;
+}
+test_item_t;
+
+static unsigned int
+test_hash (const void *v, const void *u)
+{
+  return (unsigned int) sc_hash_bytes64 (v, sizeof (uint64_t), 0);
+}
+
+static int
+test_equal (const void *v1, const void *v2, const void *u)
+{
+  return !memcmp (v1, v2, sizeof (uint64_t));
+}
+
+/** Look up the keys of all processes plus as many missing ones.
+ * \return              The number of mismatches.
+ */
+static int
+test_lookup_all (sc_dhash_t * dh, int mpisize, int removed)
+{
+  int                 q, i, num_errors = 0;
+  int                 expect;
+  size_t              zz, nfound, nexpect = 0;
+  uint64_t            key;
+  sc_array_t         *keys, *values, *found;
+
+  keys = sc_array_new (sizeof (uint64_t));
+  for (q = 0; q <= mpisize; ++q) {
+    for (i = 0; i < TEST_DHASH_KEYS; ++i) {
+      *(uint64_t *) sc_array_push (keys) = 1000 * (uint64_t) q + i;
+    }
+  }
+  values = sc_array_new (sizeof (int64_t));
+  found = sc_array_new (sizeof (int));
+  nfound = sc_dhash_lookup (dh, keys, values, found);
+  for (zz = 0; zz < keys->elem_count; ++zz) {
+    key = *(uint64_t *) sc_array_index (keys, zz);
+    expect = key < 1000 * (uint64_t) mpisize && (!removed || key % 2);
+    nexpect += expect;
+    if (*(int *) sc_array_index (found, zz) != expect ||
+        *(int64_t *) sc_array_index (values, zz) !=
+        (expect ? 3 * (int64_t) key : 0)) {
+      ++num_errors;
+    }
+  }
+  if (nfound != nexpect) {
+    ++num_errors;
+  }
+  sc_array_destroy (found);
+  sc_array_destroy (values);
+  sc_array_destroy (keys);
+  return num_errors;
+}
+
+int
+main (int argc, char **argv)
+{
+  int                 mpiret;
+  int                 mpisize, mpirank;
+  int                 q, i, num_errors = 0;
+  long                local, total;
+  size_t              hits, remote;
+  uint64_t            key;
+  test_item_t        *item;
+  sc_array_t         *items, *keys, *values;
+  sc_dhash_t         *dh;
+  sc_MPI_Comm         mpicomm;
+
+  mpiret = sc_MPI_Init (&argc, &argv);
+  SC_CHECK_MPI (mpiret);
+  mpicomm = sc_MPI_COMM_WORLD;
+  mpiret = sc_MPI_Comm_size (mpicomm, &mpisize);
+  SC_CHECK_MPI (mpiret);
+  mpiret = sc_MPI_Comm_rank (mpicomm, &mpirank);
+  SC_CHECK_MPI (mpiret);
+
+  sc_init (mpicomm, 1, 1, NULL, SC_LP_DEFAULT);
+
+  dh = sc_dhash_new (mpicomm, sizeof (uint64_t), sizeof (int64_t),
+                     test_hash, test_equal, NULL);
+  SC_CHECK_ABORT (sizeof (test_item_t) == 2 * sizeof (uint64_t),
+                  "Item padding");
+
+  /* every process inserts its keys, a wrong value first */
+  items = sc_array_new (sizeof (test_item_t));
+  for (i = 0; i < TEST_DHASH_KEYS; ++i) {
+    item = (test_item_t *) sc_array_push (items);
+    item->key = 1000 * (uint64_t) mpirank + i;
+    item->value = -1;
+  }
+  for (i = 0; i < TEST_DHASH_KEYS; ++i) {
+    item = (test_item_t *) sc_array_push (items);
+    item->key = 1000 * (uint64_t) mpirank + i;
+    item->value = 3 * (int64_t) item->key;
+  }
+  sc_dhash_insert (dh, items);
+  local = (long) sc_dhash_local_count (dh);
+  mpiret = sc_MPI_Allreduce (&local, &total, 1, sc_MPI_LONG, sc_MPI_SUM,
+                             mpicomm);
+  SC_CHECK_MPI (mpiret);
+  SC_CHECK_ABORT (total == (long) mpisize * TEST_DHASH_KEYS, "Insert count");
+  num_errors += test_lookup_all (dh, mpisize, 0);
+
+  /* the same key inserted by all processes keeps the highest rank's value */
+  sc_array_resize (items, 1);
+  item = (test_item_t *) sc_array_index (items, 0);
+  item->key = 999999;
+  item->value = mpirank;
+  sc_dhash_insert (dh, items);
+  keys = sc_array_new_count (sizeof (uint64_t), 1);
+  *(uint64_t *) sc_array_index (keys, 0) = 999999;
+  values = sc_array_new (sizeof (int64_t));
+  if (sc_dhash_lookup (dh, keys, values, NULL) != 1 ||
+      *(int64_t *) sc_array_index (values, 0) != mpisize - 1) {
+    ++num_errors;
+  }
+  sc_dhash_remove (dh, keys);
+  if (sc_dhash_lookup (dh, keys, NULL, NULL) != 0) {
+    ++num_errors;
+  }
+  SC_CHECK_ABORT (!num_errors, "Distributed hash insert and lookup");
+
+  /* a repeated lookup is answered from the cache */
+  sc_dhash_set_cache (dh, 10 * TEST_DHASH_KEYS * mpisize);
+  num_errors += test_lookup_all (dh, mpisize, 0);
+  hits = sc_dhash_cache_hits (dh);
+  num_errors += test_lookup_all (dh, mpisize, 0);
+  for (remote = 0, q = 0; q < mpisize; ++q) {
+    for (i = 0; i < TEST_DHASH_KEYS; ++i) {
+      key = 1000 * (uint64_t) q + i;
+      remote += sc_dhash_owner (dh, &key) != mpirank;
+    }
+  }
+  SC_CHECK_ABORT (hits == 0 && sc_dhash_cache_hits (dh) == remote,
+                  "Distributed hash cache");
+
+  /* every process removes its even keys, which clears the caches */
+  sc_array_resize (keys, 0);
+  for (i = 0; i < TEST_DHASH_KEYS; i += 2) {
+    *(uint64_t *) sc_array_push (keys) = 1000 * (uint64_t) mpirank + i;
+  }
+  sc_dhash_remove (dh, keys);
+  hits = sc_dhash_cache_hits (dh);
+  num_errors += test_lookup_all (dh, mpisize, 1);
+  SC_CHECK_ABORT (!num_errors && sc_dhash_cache_hits (dh) == hits,
+                  "Distributed hash remove");
+
+  sc_array_destroy (values);
+  sc_array_destroy (keys);
+  sc_array_destroy (items);
+  sc_dhash_destroy (dh);
+
+  sc_finalize ();
+
+  mpiret = sc_MPI_Finalize ();
+  SC_CHECK_MPI (mpiret);
+
+  return 0;
+}
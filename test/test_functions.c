@@ -0,0 +1,137 @@
+/*
+  This file is part of the SC Library.
+  The SC Library provides support for parallel scientific applications.
+
+  Copyright (C) 2010 The University of Texas System
+  Additional copyright (C) 2011 individual authors
+
+  The SC Library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  The SC Library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with the SC Library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+  02110-1301, USA.
+*/
+
+#include <sc_functions.h>
+
+static double
+test_cubic1 (double x, void *data)
+{
+  return x * (1. + .25 * x * x);
+}
+
+static void
+test_cubic1_batch (size_t n, const double *x, double *values, void *data)
+{
+  size_t              i;
+
+  for (i = 0; i < n; ++i) {
+    values[i] = x[i] * (1. + .25 * x[i] * x[i]);
+  }
+}
+
+static int
+test_functions_batch (void)
+{
+  int                 num_failed_tests = 0;
+  size_t              i;
+  const size_t        n = 300;
+  double              x[300], y[300], z[300], u[300], v[300];
+  double              scalar;
+  sc_function3_meta_t sum, prod, tens;
+  sc_function3_batch_meta_t bsum, bprod, btens;
+
+  for (i = 0; i < n; ++i) {
+    x[i] = -1. + i / 150.;
+    y[i] = .5 * x[i] * x[i];
+    z[i] = 2. - x[i];
+  }
+
+  /* (x + 2) * y * z composed of scalar and of batched meta functions */
+  sum.f1 = sc_x3;
+  sum.f2 = NULL;
+  sum.parameter2 = 2.;
+  sum.data = NULL;
+  prod.f1 = sc_sum3;
+  prod.f2 = sc_y3;
+  prod.data = &sum;
+  tens.f1 = sc_product3;
+  tens.f2 = sc_product3;
+  tens.f3 = sc_z3;
+  tens.data = &prod;
+  bsum.f1 = sc_x3_batch;
+  bsum.f2 = NULL;
+  bsum.parameter2 = 2.;
+  bsum.data = NULL;
+  bprod.f1 = sc_sum3_batch;
+  bprod.f2 = sc_y3_batch;
+  bprod.data = &bsum;
+  btens.f1 = sc_product3_batch;
+  btens.f2 = sc_product3_batch;
+  btens.f3 = sc_z3_batch;
+  btens.data = &bprod;
+
+  sc_function3_eval_batch (sc_tensor3, &tens, n, x, y, z, u);
+  sc_tensor3_batch (n, x, y, z, v, &btens);
+  for (i = 0; i < n; ++i) {
+    scalar = (x[i] + 2.) * y[i];
+    if (u[i] != v[i] || fabs (v[i] - scalar * scalar * z[i]) > 1e-12) {
+      ++num_failed_tests;
+    }
+  }
+
+  /* the batched inversion follows the scalar iteration */
+  for (i = 0; i < n; ++i) {
+    y[i] = -1.25 + 5.25 * i / (n - 1.);
+  }
+  sc_function1_invert_batch (test_cubic1_batch, NULL, -1., 2., n, y, v,
+                             1e-6);
+  for (i = 0; i < n; ++i) {
+    if (v[i] != sc_function1_invert (test_cubic1, NULL, -1., 2., y[i],
+                                     1e-6)) {
+      ++num_failed_tests;
+    }
+  }
+
+  if (num_failed_tests) {
+    SC_GLOBAL_LERRORF ("functions batch %d mismatches\n", num_failed_tests);
+  }
+  return num_failed_tests;
+}
+
+int
+main (int argc, char **argv)
+{
+  int                 mpiret;
+  sc_MPI_Comm         mpicomm;
+  int                 num_failed_tests;
+
+  /* standard initialization */
+  mpiret = sc_MPI_Init (&argc, &argv);
+  SC_CHECK_MPI (mpiret);
+  mpicomm = sc_MPI_COMM_WORLD;
+
+  sc_init (mpicomm, 1, 1, NULL, SC_LP_DEFAULT);
+
+  num_failed_tests = 0;
+
+  /* test the batched function evaluators */
+  num_failed_tests += test_functions_batch ();
+
+  /* clean up and exit */
+  sc_finalize ();
+
+  mpiret = sc_MPI_Finalize ();
+  SC_CHECK_MPI (mpiret);
+
+  return num_failed_tests ? EXIT_FAILURE : EXIT_SUCCESS;
+}
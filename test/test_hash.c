@@ -0,0 +1,264 @@
+/*
+  This file is part of the SC Library.
+  The SC Library provides support for parallel scientific applications.
+
+  Copyright (C) 2010 The University of Texas System
+  Additional copyright (C) 2011 individual authors
+
+  The SC Library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  The SC Library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with the SC Library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+  02110-1301, USA.
+*/
+
+#include <sc_containers.h>
+#include <sc_statistics.h>
+typedef struct test_hash_entry
+{
+  int                 key;
+  int                 value;
+}
+test_hash_entry_t;
+
+static unsigned int
+test_hash_entry_hash (const void *v, const void *u)
+{
+  const test_hash_entry_t *e = (const test_hash_entry_t *) v;
+  uint32_t            a, b, c;
+
+  a = (uint32_t) e->key;
+  b = 0xdeadbeef;
+  c = 0;
+  sc_hash_mix (a, b, c);
+  sc_hash_final (a, b, c);
+
+  return (unsigned int) c;
+}
+
+static int
+test_hash_entry_equal (const void *v1, const void *v2, const void *u)
+{
+  return ((const test_hash_entry_t *) v1)->key ==
+    ((const test_hash_entry_t *) v2)->key;
+}
+
+static int
+test_hash_count (void **v, const void *u)
+{
+  ++*(size_t *) u;
+  return 1;
+}
+
+/* check the word-wise hashes against published results of the xxHash */
+static void
+test_hash_bytes (void)
+{
+  const char         *text = "Nobody inspects the spammish repetition";
+  char                buffer[64];
+  size_t              len = strlen (text);
+  uint64_t            seed = 1;
+  sc_hash_bytes_t     b1, b2;
+  sc_hash_t          *h;
+
+  SC_CHECK_ABORT (sc_hash_bytes64 (NULL, 0, 0) == 0xEF46DB3751D8E999ULL,
+                  "Hash empty");
+  SC_CHECK_ABORT (sc_hash_bytes64 ("a", 1, 0) == 0xD24EC4F1A98C6E5BULL,
+                  "Hash one byte");
+  SC_CHECK_ABORT (sc_hash_bytes64 ("abc", 3, 0) == 0x44BC2CF5AD770999ULL,
+                  "Hash three bytes");
+  SC_CHECK_ABORT (sc_hash_bytes64 (text, len, 0) == 0xFBCEA83C8A378BF1ULL,
+                  "Hash long");
+  SC_CHECK_ABORT (sc_hash_bytes64 (text, len, 1) == 0x43F425448D954DB6ULL,
+                  "Hash seeded");
+
+  /* the result does not depend on the alignment of the data */
+  memcpy (buffer + 3, text, len + 1);
+  SC_CHECK_ABORT (sc_hash_bytes64 (buffer + 3, len, 0) ==
+                  sc_hash_bytes64 (text, len, 0), "Hash unaligned");
+
+  /* the string, seeded and binary variants agree */
+  b1.data = buffer + 3;
+  b1.size = len;
+  SC_CHECK_ABORT (sc_hash_function_string_fast (text, NULL) ==
+                  sc_hash_function_bytes (&b1, NULL), "Hash string");
+  SC_CHECK_ABORT (sc_hash_function_string_seeded (text, &seed) ==
+                  sc_hash_function_bytes (&b1, &seed), "Hash seeded string");
+  SC_CHECK_ABORT (sc_hash_function_string_seeded (text, &seed) !=
+                  sc_hash_function_string_fast (text, NULL), "Hash seed");
+
+  /* binary keys work in a hash table */
+  b2.data = text;
+  b2.size = len;
+  h = sc_hash_new (sc_hash_function_bytes, sc_hash_equal_bytes, &seed, NULL);
+  SC_CHECK_ABORT (sc_hash_insert_unique (h, &b1, NULL), "Hash bytes insert");
+  SC_CHECK_ABORT (sc_hash_lookup (h, &b2, NULL), "Hash bytes lookup");
+  b2.size = len - 1;
+  SC_CHECK_ABORT (!sc_hash_lookup (h, &b2, NULL), "Hash bytes prefix");
+  sc_hash_destroy (h);
+}
+
+static unsigned int
+test_hash_good (const void *v, const void *u)
+{
+  return (unsigned int) *(const int *) v;
+}
+
+static unsigned int
+test_hash_bad (const void *v, const void *u)
+{
+  return (unsigned int) (*(const int *) v % 4);
+}
+
+static int
+test_hash_equal (const void *v1, const void *v2, const void *u)
+{
+  return *(const int *) v1 == *(const int *) v2;
+}
+
+static int
+test_hash_stats (sc_MPI_Comm mpicomm)
+{
+  int                 num_failed_tests = 0;
+  int                 i, j, missing;
+  int                 values[1000];
+  double              probes[2];
+  sc_hash_t          *hash;
+  sc_statinfo_t      *si;
+  sc_statistics_t    *stats;
+
+  /* the same lookups need far more probes with a poor hash function */
+  for (j = 0; j < 2; ++j) {
+    hash = sc_hash_new (j == 0 ? test_hash_good : test_hash_bad,
+                        test_hash_equal, NULL, NULL);
+    sc_hash_set_count_probes (hash, 1);
+    for (i = 0; i < 1000; ++i) {
+      values[i] = i;
+      (void) sc_hash_insert_unique (hash, &values[i], NULL);
+    }
+    /* restart the counters for the lookups only */
+    sc_hash_set_count_probes (hash, 1);
+    for (i = 0; i < 1000; ++i) {
+      (void) sc_hash_lookup (hash, &values[i], NULL);
+    }
+    missing = -1;
+    (void) sc_hash_lookup (hash, &missing, NULL);
+    if (hash->lookups != 1001 || hash->hits != 1000) {
+      SC_GLOBAL_LERROR ("hash lookup counters\n");
+      ++num_failed_tests;
+    }
+    sc_hash_print_statistics (sc_package_id, SC_LP_INFO, hash);
+
+    stats = sc_statistics_new (mpicomm);
+    sc_statistics_set_hash (stats, "test_hash", hash);
+    sc_statistics_compute (stats);
+    si = (sc_statinfo_t *) sc_array_index_int
+      (stats->sarray, sc_statistics_get_handle (stats,
+                                                "test_hash chain length"));
+    if (si->max != (j == 0 ? 4. : 250.)) {
+      SC_GLOBAL_LERROR ("hash chain length\n");
+      ++num_failed_tests;
+    }
+    si = (sc_statinfo_t *) sc_array_index_int
+      (stats->sarray, sc_statistics_get_handle
+       (stats, "test_hash probes per lookup"));
+    probes[j] = si->average;
+    sc_statistics_print (stats, sc_package_id, SC_LP_INFO, 0, 0);
+    sc_statistics_destroy (stats);
+    sc_hash_destroy (hash);
+  }
+  if (probes[0] > 3. || probes[1] < 100.) {
+    SC_GLOBAL_LERROR ("hash probes per lookup\n");
+    ++num_failed_tests;
+  }
+
+  return num_failed_tests;
+}
+
+int
+main (int argc, char **argv)
+{
+  const int           num_keys = 50000;
+  const int           key_range = 80000;
+  int                 mpiret;
+  int                 i;
+  size_t              counted;
+  void              **pfound;
+  test_hash_entry_t  *keys;
+  sc_hash_t          *h;
+
+  mpiret = sc_MPI_Init (&argc, &argv);
+  SC_CHECK_MPI (mpiret);
+
+  sc_init (sc_MPI_COMM_WORLD, 1, 1, NULL, SC_LP_DEFAULT);
+
+  /* random keys with duplicates */
+  srand (12345);
+  keys = SC_ALLOC (test_hash_entry_t, num_keys);
+  for (i = 0; i < num_keys; ++i) {
+    keys[i].key = rand () % key_range;
+    keys[i].value = i;
+  }
+
+  /* the incremental resize must preserve all contents */
+  h = sc_hash_new_ext (test_hash_entry_hash, test_hash_entry_equal, NULL,
+                       NULL, 0, 1);
+  for (i = 0; i < num_keys; ++i) {
+    (void) sc_hash_insert_unique (h, &keys[i], &pfound);
+    SC_CHECK_ABORT (((test_hash_entry_t *) *pfound)->key == keys[i].key,
+                    "Incremental insert found");
+  }
+  SC_CHECK_ABORT (h->resize_actions > 0, "Incremental resize");
+  for (i = 0; i < num_keys; ++i) {
+    SC_CHECK_ABORT (sc_hash_lookup (h, &keys[i], NULL), "Incremental lookup");
+  }
+  for (i = 0; i < num_keys; ++i) {
+    if (keys[i].key % 2 == 0) {
+      (void) sc_hash_remove (h, &keys[i], NULL);
+    }
+  }
+  counted = 0;
+  h->user_data = &counted;
+  sc_hash_foreach (h, test_hash_count);
+  h->user_data = NULL;
+  SC_CHECK_ABORT (counted == h->elem_count, "Incremental foreach");
+  for (i = 0; i < num_keys; ++i) {
+    SC_CHECK_ABORT (sc_hash_lookup (h, &keys[i], NULL) ==
+                    (keys[i].key % 2 == 1), "Incremental remove");
+  }
+  sc_hash_print_statistics (sc_package_id, SC_LP_STATISTICS, h);
+  sc_hash_destroy (h);
+
+  /* a presized hash table does not resize */
+  h = sc_hash_new_ext (test_hash_entry_hash, test_hash_entry_equal, NULL,
+                       NULL, (size_t) num_keys, 0);
+  for (i = 0; i < num_keys; ++i) {
+    (void) sc_hash_insert_unique (h, &keys[i], NULL);
+  }
+  SC_CHECK_ABORT (h->resize_actions == 0, "Presized resize");
+  sc_hash_destroy (h);
+
+  /* the word-wise hashes agree with the reference values */
+  test_hash_bytes ();
+
+  /* the statistics count the lookups and the probes */
+  SC_CHECK_ABORT (test_hash_stats (sc_MPI_COMM_WORLD) == 0,
+                  "Hash statistics");
+
+  SC_FREE (keys);
+  sc_finalize ();
+
+  mpiret = sc_MPI_Finalize ();
+  SC_CHECK_MPI (mpiret);
+
+  return 0;
+}
@@ -0,0 +1,199 @@
+/*
+  This file is part of the SC Library.
+  The SC Library provides support for parallel scientific applications.
+
+  Copyright (C) 2010 The University of Texas System
+  Additional copyright (C) 2011 individual authors
+
+  The SC Library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  The SC Library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with the SC Library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+  02110-1301, USA.
+*/
+
+#include <sc_containers.h>
+
+typedef struct test_hash_array_entry
+{
+  int                 key;
+  int                 value;
+}
+test_hash_array_entry_t;
+
+static unsigned int
+test_hash_array_hash (const void *v, const void *u)
+{
+  const test_hash_array_entry_t *e = (const test_hash_array_entry_t *) v;
+  uint32_t            a, b, c;
+
+  a = (uint32_t) e->key;
+  b = 0xdeadbeef;
+  c = 0;
+  sc_hash_mix (a, b, c);
+  sc_hash_final (a, b, c);
+
+  return (unsigned int) c;
+}
+
+static int
+test_hash_array_equal (const void *v1, const void *v2, const void *u)
+{
+  return ((const test_hash_array_entry_t *) v1)->key ==
+    ((const test_hash_array_entry_t *) v2)->key;
+}
+
+static int
+test_hash_array_compare (const void *v1, const void *v2)
+{
+  return sc_int_compare (&((const test_hash_array_entry_t *) v1)->key,
+                         &((const test_hash_array_entry_t *) v2)->key);
+}
+
+/* freeze a hash array, look up all keys and rip it sorted */
+static void
+test_hash_array_frozen (sc_hash_array_t * ha, int key_range)
+{
+  int                 found;
+  size_t              zz, position, mem, count;
+  test_hash_array_entry_t e, *entries;
+  sc_array_t         *positions, *newindices, old, rip;
+
+  count = ha->a.elem_count;
+  mem = sc_hash_array_memory_used (ha);
+  sc_hash_array_freeze (ha);
+  sc_hash_array_freeze (ha);
+  SC_CHECK_ABORT (sc_hash_array_is_frozen (ha) &&
+                  sc_hash_array_memory_used (ha) < mem, "Frozen memory");
+  SC_CHECK_ABORT (sc_hash_array_is_valid (ha), "Frozen valid");
+
+  positions = sc_array_new (sizeof (size_t));
+  sc_array_init_count (&old, sizeof (test_hash_array_entry_t),
+                       (size_t) key_range);
+  for (e.key = 0; e.key < key_range; ++e.key) {
+    ((test_hash_array_entry_t *) sc_array_index_int (&old, e.key))->key =
+      e.key;
+  }
+  SC_CHECK_ABORT (sc_hash_array_lookup_batch (ha, &old, positions) == count,
+                  "Frozen batch count");
+  for (e.key = 0; e.key < key_range; ++e.key) {
+    found = sc_hash_array_lookup (ha, &e, &position);
+    SC_CHECK_ABORT (found ? position == *(size_t *)
+                    sc_array_index_int (positions, e.key) &&
+                    ((test_hash_array_entry_t *)
+                     sc_array_index (&ha->a, position))->key == e.key :
+                    *(size_t *) sc_array_index_int (positions, e.key) ==
+                    (size_t) -1, "Frozen lookup");
+  }
+
+  /* the new indices lead from the old to the sorted positions */
+  sc_array_reset (&old);
+  sc_array_init (&old, sizeof (test_hash_array_entry_t));
+  sc_array_copy (&old, &ha->a);
+  newindices = sc_array_new (sizeof (size_t));
+  sc_hash_array_rip_sorted (ha, &rip, test_hash_array_compare, newindices);
+  SC_CHECK_ABORT (rip.elem_count == count &&
+                  sc_array_is_sorted (&rip, test_hash_array_compare),
+                  "Rip sorted");
+  entries = (test_hash_array_entry_t *) rip.array;
+  for (zz = 0; zz < count; ++zz) {
+    position = *(size_t *) sc_array_index (newindices, zz);
+    SC_CHECK_ABORT (entries[position].key ==
+                    ((test_hash_array_entry_t *)
+                     sc_array_index (&old, zz))->key, "Rip sorted indices");
+  }
+  sc_array_destroy (newindices);
+  sc_array_destroy (positions);
+  sc_array_reset (&old);
+  sc_array_reset (&rip);
+}
+
+int
+main (int argc, char **argv)
+{
+  const int           num_keys = 50000;
+  const int           key_range = 80000;
+  int                 mpiret;
+  int                 i, added;
+  size_t              position, counted;
+  void               *found;
+  test_hash_array_entry_t e;
+  test_hash_array_entry_t *keys;
+  sc_hash_array_t    *ha, *ha2;
+  sc_array_t         *view, *positions;
+
+  mpiret = sc_MPI_Init (&argc, &argv);
+  SC_CHECK_MPI (mpiret);
+
+  sc_init (sc_MPI_COMM_WORLD, 1, 1, NULL, SC_LP_DEFAULT);
+
+  /* random keys with duplicates */
+  srand (12345);
+  keys = SC_ALLOC (test_hash_array_entry_t, num_keys);
+  for (i = 0; i < num_keys; ++i) {
+    keys[i].key = rand () % key_range;
+    keys[i].value = i;
+  }
+
+  /* insert the keys one by one for reference */
+  ha = sc_hash_array_new (sizeof (test_hash_array_entry_t),
+                          test_hash_array_hash, test_hash_array_equal, NULL);
+  for (i = 0; i < num_keys; ++i) {
+    found = sc_hash_array_insert_unique (ha, &keys[i], &position);
+    if (found != NULL) {
+      *(test_hash_array_entry_t *) found = keys[i];
+    }
+  }
+
+  /* the batch routines must agree with the one-by-one insertion */
+  view = sc_array_new_data (keys, sizeof (test_hash_array_entry_t),
+                            (size_t) num_keys);
+  positions = sc_array_new (sizeof (size_t));
+  ha2 = sc_hash_array_new (sizeof (test_hash_array_entry_t),
+                           test_hash_array_hash, test_hash_array_equal, NULL);
+  counted = sc_hash_array_insert_batch (ha2, view, positions);
+  SC_CHECK_ABORT (counted == ha->a.elem_count, "Batch insert count");
+  SC_CHECK_ABORT (sc_hash_array_is_valid (ha2), "Batch insert valid");
+  SC_CHECK_ABORT (sc_hash_array_insert_batch (ha2, view, positions) == 0,
+                  "Batch insert again");
+  for (i = 0; i < num_keys; ++i) {
+    SC_EXECUTE_ASSERT_TRUE (sc_hash_array_lookup (ha, &keys[i], &position));
+    SC_CHECK_ABORT (position == *(size_t *) sc_array_index_int (positions, i),
+                    "Batch insert position");
+  }
+  sc_array_destroy (view);
+  view = sc_array_new_count (sizeof (test_hash_array_entry_t), key_range);
+  for (i = 0; i < key_range; ++i) {
+    ((test_hash_array_entry_t *) sc_array_index_int (view, i))->key = i;
+  }
+  counted = sc_hash_array_lookup_batch (ha2, view, positions);
+  SC_CHECK_ABORT (counted == ha->a.elem_count, "Batch lookup count");
+  for (e.key = 0; e.key < key_range; ++e.key) {
+    added = sc_hash_array_lookup (ha2, &e, &position);
+    SC_CHECK_ABORT (added ? position == *(size_t *)
+                    sc_array_index_int (positions, e.key) :
+                    *(size_t *) sc_array_index_int (positions, e.key) ==
+                    (size_t) -1, "Batch lookup position");
+  }
+  sc_array_destroy (view);
+  sc_array_destroy (positions);
+  test_hash_array_frozen (ha2, key_range);
+  sc_hash_array_destroy (ha);
+
+  SC_FREE (keys);
+  sc_finalize ();
+
+  mpiret = sc_MPI_Finalize ();
+  SC_CHECK_MPI (mpiret);
+
+  return 0;
+}
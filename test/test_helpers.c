@@ -28,6 +28,14 @@
 */
 
 #include <sc_io.h>
+#include <sc_puff.h>
+#include <sc_thread.h>
+#ifdef SC_ENABLE_PTHREAD
+#include <pthread.h>
+#endif
+#ifdef SC_HAVE_ZLIB
+#include <zlib.h>
+#endif
 
 #define SC_TEST_TOOLONG 123456789012345678901234567890123456789
 #define SC_TEST_LONG    1234567890123456789
@@ -280,7 +288,7 @@ test_encode_decode (void)
  CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)\
  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE\
  POSSIBILITY OF SUCH DAMAGE.";
-  sc_array_t          src;
+  sc_array_t          src, stored, dest, back;
 
   sc_array_init_data (&src, (void *) "", 1, 1);
   encode_and_print (&src);
@@ -309,9 +317,873 @@ test_encode_decode (void)
     }
   }
 
+  /* repetitive data must shrink at every positive level */
+  slen = strlen (str2);
+  sc_array_init_count (&src, 1, 200 * slen);
+  for (j = 0; j < 200; ++j) {
+    memcpy (src.array + j * slen, str2, slen);
+  }
+  sc_array_init (&stored, 1);
+  sc_array_init (&dest, 1);
+  sc_array_init (&back, 1);
+  sc_io_encode_zlib (&src, &stored, 0, '=');
+  for (i = -1; i <= 9; i += 5) {
+    sc_io_encode_zlib (&src, &dest, i, '=');
+    if (dest.elem_count * 4 > stored.elem_count ||
+        sc_io_decode (&dest, &back, 0, NULL) ||
+        back.elem_count != src.elem_count ||
+        memcmp (back.array, src.array, src.elem_count)) {
+      SC_LERRORF ("compression error on level %d\n", i);
+      ++num_failed_tests;
+    }
+  }
+  sc_array_reset (&back);
+  sc_array_reset (&dest);
+  sc_array_reset (&stored);
+  sc_array_reset (&src);
+
+  return num_failed_tests;
+}
+
+static int
+test_memory_stats (void)
+{
+  int                 num_failed_tests = 0;
+  int                 package;
+  int                 i;
+  size_t              sum;
+  void               *p[4];
+  sc_memory_stats_t   stats;
+
+  package = sc_package_register (NULL, SC_LP_DEFAULT, "memstats",
+                                 "Test memory statistics");
+
+  /* allocate blocks of known size classes */
+  p[0] = sc_malloc (package, 1);
+  p[1] = sc_malloc (package, 100);
+  p[2] = sc_calloc (package, 10, 100);
+  p[3] = sc_malloc (package, 1000);
+  p[3] = sc_realloc (package, p[3], 5000);
+
+  sc_memory_stats (package, &stats);
+  if (stats.malloc_count != 4 || stats.free_count != 0) {
+    SC_LERRORF ("Memory stats count %d %d\n",
+                stats.malloc_count, stats.free_count);
+    ++num_failed_tests;
+  }
+  if (stats.histogram[0] != 1 || stats.histogram[6] != 1 ||
+      stats.histogram[9] != 2 || stats.histogram[12] != 1) {
+    SC_LERROR ("Memory stats histogram\n");
+    ++num_failed_tests;
+  }
+  sum = 1 + 100 + 1000 + 5000;
+  if (stats.bytes_tracked &&
+      (stats.live_bytes < sum || stats.peak_bytes < stats.live_bytes)) {
+    SC_LERRORF ("Memory stats bytes %llu %llu\n",
+                (unsigned long long) stats.live_bytes,
+                (unsigned long long) stats.peak_bytes);
+    ++num_failed_tests;
+  }
+  sc_package_print_summary (SC_LP_INFO);
+
+  /* after freeing everything the peak must remain */
+  for (i = 0; i < 4; ++i) {
+    sc_free (package, p[i]);
+  }
+  sc_memory_stats (package, &stats);
+  if (stats.malloc_count != stats.free_count || stats.live_bytes != 0 ||
+      (stats.bytes_tracked && stats.peak_bytes < sum)) {
+    SC_LERROR ("Memory stats after free\n");
+    ++num_failed_tests;
+  }
+
+  sc_package_unregister (package);
   return num_failed_tests;
 }
 
+#define TEST_NUM_PACKAGES 40
+
+/* the packages registered by thread 0 while the others allocate */
+static int          test_packages[TEST_NUM_PACKAGES];
+
+static void
+test_package_thread (int thread_id, int num_threads, void *user)
+{
+  int                 i, j;
+  void               *p;
+
+  for (i = 0; i < TEST_NUM_PACKAGES; ++i) {
+    if (thread_id == 0) {
+      test_packages[i] = sc_package_register (NULL, SC_LP_SILENT,
+                                              i % 2 ? "regodd" : "regeven",
+                                              "Test registration");
+      sc_package_unregister (test_packages[i]);
+    }
+    else {
+      sc_log_indent_push_count (sc_package_id, thread_id);
+      for (j = 0; j < 10; ++j) {
+        p = sc_malloc (sc_package_id, (size_t) (1 + i + j));
+        SC_GEN_LOG (sc_package_id, SC_LC_NORMAL, SC_LP_TRACE, "thread\n");
+        sc_free (sc_package_id, p);
+      }
+      sc_log_indent_pop_count (sc_package_id, thread_id);
+    }
+  }
+}
+
+static int
+test_package_threads (void)
+{
+  int                 num_failed_tests = 0;
+  int                 i, balance;
+  char                names[TEST_NUM_PACKAGES][16];
+
+  /* lookups by other threads do not take a lock during registration */
+  balance = sc_memory_status (sc_package_id);
+  sc_thread_fork_join (4, test_package_thread, NULL);
+  if (sc_memory_status (sc_package_id) != balance) {
+    SC_LERROR ("Package memory balance with threads\n");
+    ++num_failed_tests;
+  }
+
+  /* grow the package table over several segments */
+  for (i = 0; i < TEST_NUM_PACKAGES; ++i) {
+    snprintf (names[i], 16, "reg%d", i);
+    test_packages[i] = sc_package_register (NULL, SC_LP_SILENT, names[i],
+                                            "Test registration");
+    sc_free (test_packages[i], sc_malloc (test_packages[i], 10));
+  }
+  for (i = 0; i < TEST_NUM_PACKAGES; ++i) {
+    if (!sc_package_is_registered (test_packages[i]) ||
+        sc_memory_status (test_packages[i]) != 0) {
+      SC_LERRORF ("Package %d after registration\n", i);
+      ++num_failed_tests;
+    }
+    sc_package_unregister (test_packages[i]);
+  }
+  return num_failed_tests;
+}
+
+static int          test_log_calls = 0;
+
+static void
+test_log_count (FILE * log_stream, const char *filename, int lineno,
+                int package, int category, int priority, const char *msg)
+{
+  ++test_log_calls;
+}
+
+static int
+test_log_guard (void)
+{
+  int                 num_failed_tests = 0;
+  int                 package, evaluated = 0;
+  const int           compiled = SC_LP_ESSENTIAL >= SC_LP_THRESHOLD;
+
+  package = sc_package_register (test_log_count, SC_LP_ERROR,
+                                 "logguard", "Test log guard");
+
+  /* a dropped message must not evaluate its arguments */
+  SC_GEN_LOGF (package, SC_LC_NORMAL, SC_LP_ESSENTIAL, "%d\n", ++evaluated);
+  if (evaluated != 0 || test_log_calls != 0) {
+    SC_GLOBAL_LERROR ("log guard evaluated a dropped message\n");
+    ++num_failed_tests;
+  }
+
+  /* the guard follows a change of verbosity unless compiled out */
+  sc_package_set_verbosity (package, SC_LP_ESSENTIAL);
+  SC_GEN_LOGF (package, SC_LC_NORMAL, SC_LP_ESSENTIAL, "%d\n", ++evaluated);
+  if (evaluated != compiled || test_log_calls != compiled) {
+    SC_GLOBAL_LERROR ("log guard dropped an enabled message\n");
+    ++num_failed_tests;
+  }
+
+  sc_package_unregister (package);
+  return num_failed_tests;
+}
+
+static uint32_t
+test_adler32_reference (const unsigned char *p, size_t length)
+{
+  uint32_t            s1 = 1, s2 = 0;
+  size_t              zz;
+
+  for (zz = 0; zz < length; ++zz) {
+    s1 = (s1 + p[zz]) % 65521;
+    s2 = (s2 + s1) % 65521;
+  }
+  return (s2 << 16) | s1;
+}
+
+static uint32_t
+test_crc32c_reference (const unsigned char *p, size_t length)
+{
+  uint32_t            crc = 0xFFFFFFFFU;
+  size_t              zz;
+  int                 k;
+
+  for (zz = 0; zz < length; ++zz) {
+    crc ^= p[zz];
+    for (k = 0; k < 8; ++k) {
+      crc = (crc >> 1) ^ ((crc & 1) ? 0x82F63B78U : 0);
+    }
+  }
+  return ~crc;
+}
+
+static int
+test_checksums (void)
+{
+  const size_t        nbytes = 100003;
+  int                 num_failed_tests = 0;
+  char                fc;
+  size_t              zz, len, off, lens[6] = { 0, 1, 31, 33, 5553, 0 };
+  unsigned char      *buf;
+  sc_array_t          data, enc, dec;
+
+  SC_GLOBAL_INFOF ("Checksum kernels %s\n", sc_io_checksum_kernel ());
+  if (sc_io_crc32c (0, "123456789", 9) != 0xE3069283U ||
+      sc_io_adler32 (1, "Wikipedia", 9) != 0x11E60398U) {
+    SC_GLOBAL_LERROR ("checksum test vector mismatch\n");
+    ++num_failed_tests;
+  }
+
+  /* all-ones bytes stress the overflow bound of adler32 */
+  buf = SC_ALLOC (unsigned char, nbytes + 3);
+  for (zz = 0; zz < nbytes + 3; ++zz) {
+    buf[zz] = (unsigned char) (zz < nbytes / 2 ? 0xFF : rand ());
+  }
+  lens[5] = nbytes;
+  for (off = 0; off < 4; ++off) {
+    for (zz = 0; zz < 6; ++zz) {
+      len = lens[zz];
+      if (sc_io_adler32 (1, buf + off, len) !=
+          test_adler32_reference (buf + off, len) ||
+          sc_io_crc32c (0, buf + off, len) !=
+          test_crc32c_reference (buf + off, len)) {
+        SC_GLOBAL_LERRORF ("checksum mismatch length %llu offset %llu\n",
+                           (unsigned long long) len,
+                           (unsigned long long) off);
+        ++num_failed_tests;
+      }
+    }
+  }
+
+  /* checksums may be continued */
+  len = nbytes / 3;
+  if (sc_io_adler32 (sc_io_adler32 (1, buf, len), buf + len, nbytes - len)
+      != sc_io_adler32 (1, buf, nbytes) ||
+      sc_io_crc32c (sc_io_crc32c (0, buf, len), buf + len, nbytes - len)
+      != sc_io_crc32c (0, buf, nbytes)) {
+    SC_GLOBAL_LERROR ("checksum continuation mismatch\n");
+    ++num_failed_tests;
+  }
+
+  /* round trip the encoding with a CRC32C checksum */
+  sc_array_init_data (&data, buf, 1, nbytes);
+  sc_array_init (&enc, 1);
+  sc_array_init (&dec, 1);
+  sc_io_encode_ext (&data, &enc, 1, '=', SC_IO_CHECKSUM_CRC32C);
+  if (sc_io_decode_info (&enc, &len, &fc, NULL) || fc != 'C' ||
+      len != nbytes) {
+    SC_GLOBAL_LERROR ("crc32c decode info error\n");
+    ++num_failed_tests;
+  }
+  if (sc_io_decode (&enc, &dec, 0, NULL) || dec.elem_count != nbytes ||
+      memcmp (dec.array, buf, nbytes)) {
+    SC_GLOBAL_LERROR ("crc32c decode error\n");
+    ++num_failed_tests;
+  }
+
+  /* a corrupted character must be detected */
+  enc.array[enc.elem_count / 2] =
+    enc.array[enc.elem_count / 2] == 'A' ? 'B' : 'A';
+  if (!sc_io_decode (&enc, &dec, 0, NULL)) {
+    SC_GLOBAL_LERROR ("crc32c corruption undetected\n");
+    ++num_failed_tests;
+  }
+  sc_array_reset (&enc);
+  sc_array_reset (&dec);
+  SC_FREE (buf);
+
+  return num_failed_tests;
+}
+
+static void
+test_base64_reference (const unsigned char *p, size_t length, char *out)
+{
+  const char         *chars =
+    "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+  size_t              zz;
+  uint32_t            triple;
+
+  for (zz = 0; zz < length; zz += 3) {
+    triple = (uint32_t) p[zz] << 16;
+    if (zz + 1 < length) {
+      triple |= (uint32_t) p[zz + 1] << 8;
+    }
+    if (zz + 2 < length) {
+      triple |= p[zz + 2];
+    }
+    *out++ = chars[triple >> 18];
+    *out++ = chars[(triple >> 12) & 0x3f];
+    *out++ = zz + 1 < length ? chars[(triple >> 6) & 0x3f] : '=';
+    *out++ = zz + 2 < length ? chars[triple & 0x3f] : '=';
+  }
+  *out = '\0';
+}
+
+static int
+test_base64 (void)
+{
+  const size_t        nbytes = 10007;
+  int                 num_failed_tests = 0;
+  size_t              zz, yy, len, lens[7] = { 0, 1, 2, 23, 77, 1000, 0 };
+  unsigned char      *buf;
+  char               *ref, *got;
+  FILE               *file;
+  sc_array_t          data, enc, dec;
+
+  SC_GLOBAL_INFOF ("Base 64 kernel %s\n", sc_io_base64_kernel ());
+
+  /* the VTK writer codes its 4 byte header and the data as one stream */
+  buf = SC_ALLOC (unsigned char, nbytes + 4);
+  ref = SC_ALLOC (char, 4 * (nbytes + 6) / 3 + 1);
+  got = SC_ALLOC (char, 4 * (nbytes + 6) / 3 + 1);
+  lens[6] = nbytes;
+  for (zz = 0; zz < 7; ++zz) {
+    len = lens[zz];
+    *(uint32_t *) buf = (uint32_t) len;
+    for (yy = 0; yy < len; ++yy) {
+      buf[4 + yy] = (unsigned char) rand ();
+    }
+    test_base64_reference (buf, len + 4, ref);
+    file = tmpfile ();
+    SC_CHECK_ABORT (file != NULL, "base 64 temporary file");
+    if (sc_vtk_write_binary (file, (char *) buf + 4, len)) {
+      SC_GLOBAL_LERROR ("base 64 vtk write error\n");
+      ++num_failed_tests;
+    }
+    memset (got, 0, strlen (ref) + 1);
+    rewind (file);
+    if (fread (got, 1, strlen (ref) + 1, file) != strlen (ref) ||
+        strcmp (got, ref)) {
+      SC_GLOBAL_LERRORF ("base 64 mismatch length %llu\n",
+                         (unsigned long long) len);
+      ++num_failed_tests;
+    }
+    fclose (file);
+  }
+  SC_FREE (got);
+  SC_FREE (ref);
+
+  /* a character outside of the alphabet must be rejected */
+  sc_array_init_data (&data, buf, 1, nbytes);
+  sc_array_init (&enc, 1);
+  sc_array_init (&dec, 1);
+  sc_io_encode_zlib (&data, &enc, 0, '=');
+  enc.array[enc.elem_count / 2 - enc.elem_count / 2 % 78] = '*';
+  if (!sc_io_decode (&enc, &dec, 0, NULL)) {
+    SC_GLOBAL_LERROR ("base 64 invalid character undetected\n");
+    ++num_failed_tests;
+  }
+  sc_array_reset (&enc);
+  sc_array_reset (&dec);
+  SC_FREE (buf);
+
+  return num_failed_tests;
+}
+
+#ifdef SC_HAVE_ZLIB
+
+static int
+test_puff (void)
+{
+  const size_t        nbytes = 200003;
+  const int           strategies[4] = { Z_DEFAULT_STRATEGY, Z_FIXED,
+    Z_HUFFMAN_ONLY, Z_RLE
+  };
+  int                 num_failed_tests = 0;
+  int                 level, st, retval;
+  size_t              zz, len, lens[4] = { 0, 1, 1000, 0 };
+  unsigned char      *buf, *comp, *back;
+  unsigned long       destlen, sourcelen;
+  z_stream            zs;
+
+  /* text-like data with repetitions of varying distance */
+  buf = SC_ALLOC (unsigned char, nbytes);
+  for (zz = 0; zz < nbytes; ++zz) {
+    buf[zz] = (unsigned char)
+      (zz >= 300 && rand () % 4 ? buf[zz - 1 - rand () % 300] :
+       'a' + rand () % 26);
+  }
+  comp = SC_ALLOC (unsigned char, nbytes + nbytes / 8 + 64);
+  back = SC_ALLOC (unsigned char, nbytes);
+  lens[3] = nbytes;
+
+  /* sc_puff must reproduce every raw deflate stream of zlib */
+  for (level = 1; level <= 9; level += 4) {
+    for (st = 0; st < 4; ++st) {
+      for (zz = 0; zz < 4; ++zz) {
+        len = lens[zz];
+        memset (&zs, 0, sizeof (zs));
+        retval = deflateInit2 (&zs, level, Z_DEFLATED, -15, 8,
+                               strategies[st]);
+        SC_CHECK_ABORT (retval == Z_OK, "deflateInit2");
+        zs.next_in = buf;
+        zs.avail_in = (uInt) len;
+        zs.next_out = comp;
+        zs.avail_out = (uInt) (nbytes + nbytes / 8 + 64);
+        retval = deflate (&zs, Z_FINISH);
+        SC_CHECK_ABORT (retval == Z_STREAM_END, "deflate");
+        destlen = (unsigned long) len;
+        sourcelen = zs.total_out;
+        retval = sc_puff (back, &destlen, comp, &sourcelen);
+        if (retval != 0 || destlen != len || sourcelen != zs.total_out ||
+            memcmp (back, buf, len)) {
+          SC_GLOBAL_LERRORF ("puff mismatch level %d strategy %d"
+                             " length %llu\n", level, strategies[st],
+                             (unsigned long long) len);
+          ++num_failed_tests;
+        }
+
+        /* a truncated stream must be reported */
+        if (zs.total_out > 1) {
+          destlen = (unsigned long) len;
+          sourcelen = zs.total_out - 1;
+          if (sc_puff (back, &destlen, comp, &sourcelen) <= 0) {
+            SC_GLOBAL_LERROR ("puff truncation undetected\n");
+            ++num_failed_tests;
+          }
+        }
+        (void) deflateEnd (&zs);
+      }
+    }
+  }
+  SC_FREE (back);
+  SC_FREE (comp);
+  SC_FREE (buf);
+
+  return num_failed_tests;
+}
+
+#endif /* SC_HAVE_ZLIB */
+
+static int
+test_encode_parallel (void)
+{
+  const size_t        sizes[4] = { 0, 1, 1000, 3 << 19 };
+  const size_t        blocks[3] = { 0, 1000, 7 };
+  int                 num_failed_tests = 0;
+  int                 t;
+  char                fc;
+  size_t              zs, zb, zz, len;
+  sc_array_t          data, enc, dec;
+
+  for (zs = 0; zs < 4; ++zs) {
+    sc_array_init_count (&data, 1, sizes[zs]);
+    for (zz = 0; zz < sizes[zs]; ++zz) {
+      data.array[zz] = (char) (zz % 253 < 100 ? rand () : 'x');
+    }
+    for (zb = 0; zb < 3; ++zb) {
+      if (sizes[zs] / SC_MAX (blocks[zb], 1) > 10000) {
+        /* avoid tiny blocks of large data */
+        continue;
+      }
+      for (t = 1; t <= 3; t += 2) {
+        sc_array_init (&enc, 1);
+        sc_array_init (&dec, 1);
+        sc_io_encode_parallel (&data, &enc, 6, '=', blocks[zb], t);
+        if (sc_io_decode_info (&enc, &len, &fc, NULL) || fc != 'B' ||
+            len != sizes[zs]) {
+          SC_GLOBAL_LERRORF ("block decode info error %d %d %d\n",
+                             (int) zs, (int) zb, t);
+          ++num_failed_tests;
+        }
+
+        /* decode to a new array and in place */
+        if (sc_io_decode (&enc, &dec, 0, NULL) ||
+            !sc_array_is_equal (&data, &dec) ||
+            sc_io_decode (&enc, NULL, 0, NULL) ||
+            !sc_array_is_equal (&data, &enc)) {
+          SC_GLOBAL_LERRORF ("block decode error %d %d %d\n",
+                             (int) zs, (int) zb, t);
+          ++num_failed_tests;
+        }
+        sc_array_reset (&enc);
+        sc_array_reset (&dec);
+      }
+    }
+    sc_array_reset (&data);
+  }
+
+  return num_failed_tests;
+}
+
+static int
+test_encode_ints (void)
+{
+  const size_t        counts[5] = { 0, 1, 5, 63, 10007 };
+  int                 num_failed_tests = 0;
+  int                 w, k;
+  char                fc;
+  size_t              zc, zz, len, es;
+  int32_t            *i32;
+  int64_t            *i64;
+  sc_array_t          data, enc, dec, view;
+
+  SC_GLOBAL_INFOF ("Integer kernel %s\n", sc_io_ints_kernel ());
+
+  for (w = 0; w < 2; ++w) {
+    es = w == 0 ? 4 : 8;
+    for (zc = 0; zc < 5; ++zc) {
+      for (k = 0; k < 3; ++k) {
+        /* sorted offsets, random values and extremes of both signs */
+        sc_array_init_count (&data, es, counts[zc]);
+        i32 = (int32_t *) data.array;
+        i64 = (int64_t *) data.array;
+        for (zz = 0; zz < counts[zc]; ++zz) {
+          if (w == 0) {
+            i32[zz] = k == 0 ? (int32_t) (3 * zz + rand () % 3) :
+              k == 1 ? (int32_t) rand () - RAND_MAX / 2 :
+              zz % 2 ? INT32_MIN : INT32_MAX;
+          }
+          else {
+            i64[zz] = k == 0 ? (int64_t) (1000 * zz) :
+              k == 1 ? ((int64_t) rand () << 31) - (int64_t) rand () :
+              zz % 2 ? INT64_MIN : INT64_MAX;
+          }
+        }
+
+        /* the raw format decodes into a new array and a view */
+        sc_array_init (&enc, 1);
+        sc_array_init (&dec, es);
+        sc_io_encode_ints (&data, &enc);
+        if (k == 0 && counts[zc] > 1000 &&
+            enc.elem_count > counts[zc] * es / 2) {
+          SC_GLOBAL_LERRORF ("integer packing ineffective %d\n", (int) es);
+          ++num_failed_tests;
+        }
+        sc_array_init_count (&view, 1, counts[zc] * es + 1);
+        if (sc_io_decode_ints (&enc, &dec) ||
+            !sc_array_is_equal (&data, &dec) ||
+            sc_io_decode_ints (&enc, &view) ||
+            view.elem_count != counts[zc] * es ||
+            memcmp (view.array, data.array, view.elem_count)) {
+          SC_GLOBAL_LERRORF ("integer decode error %d %d %d\n",
+                             (int) es, (int) zc, k);
+          ++num_failed_tests;
+        }
+        sc_array_reset (&view);
+
+        /* truncated and overlong input is rejected */
+        if (enc.elem_count > 9) {
+          sc_array_resize (&enc, enc.elem_count - 1);
+          if (!sc_io_decode_ints (&enc, &dec)) {
+            SC_GLOBAL_LERROR ("integer truncation undetected\n");
+            ++num_failed_tests;
+          }
+          sc_array_resize (&enc, enc.elem_count + 2);
+          if (!sc_io_decode_ints (&enc, &dec)) {
+            SC_GLOBAL_LERROR ("integer trailing data undetected\n");
+            ++num_failed_tests;
+          }
+        }
+        sc_array_reset (&enc);
+
+        /* the compressed format is read by the general decoder */
+        sc_array_init (&enc, 1);
+        sc_io_encode_ints_zlib (&data, &enc, 9, '=');
+        if (sc_io_decode_info (&enc, &len, &fc, NULL) || fc != 'i' ||
+            len != counts[zc] * es ||
+            sc_io_decode (&enc, &dec, 0, NULL) ||
+            !sc_array_is_equal (&data, &dec) ||
+            sc_io_decode (&enc, NULL, 0, NULL) ||
+            enc.elem_count != len || memcmp (enc.array, data.array, len)) {
+          SC_GLOBAL_LERRORF ("integer zlib decode error %d %d %d\n",
+                             (int) es, (int) zc, k);
+          ++num_failed_tests;
+        }
+        sc_array_reset (&enc);
+        sc_array_reset (&dec);
+        sc_array_reset (&data);
+      }
+    }
+  }
+
+  return num_failed_tests;
+}
+
+static int
+test_encode_shuffle (void)
+{
+  const size_t        counts[4] = { 0, 1, 17, 10007 };
+  const size_t        sizes[6] = { 1, 2, 3, 4, 8, 16 };
+  int                 num_failed_tests = 0;
+  char                fc;
+  size_t              zc, zs, zz, len, es;
+  double             *d;
+  sc_array_t          data, enc, dec;
+
+  SC_GLOBAL_INFOF ("Shuffle kernel %s\n", sc_io_shuffle_kernel ());
+
+  /* the lossless transform restores every element size */
+  for (zs = 0; zs < 6; ++zs) {
+    es = sizes[zs];
+    for (zc = 0; zc < 4; ++zc) {
+      sc_array_init_count (&data, es, counts[zc]);
+      for (zz = 0; zz < es * counts[zc]; ++zz) {
+        data.array[zz] = (char) (zz % es == 0 ? (size_t) rand () :
+                                 zz / es / 100);
+      }
+      sc_array_init (&enc, 1);
+      sc_array_init (&dec, es);
+      sc_io_encode_shuffle (&data, &enc, 6, '=', -1);
+      len = 0;
+      if (sc_io_decode_info (&enc, &len, &fc, NULL) || fc != 's' ||
+          len != counts[zc] * es ||
+          sc_io_decode (&enc, &dec, 0, NULL) ||
+          !sc_array_is_equal (&data, &dec) ||
+          sc_io_decode (&enc, NULL, 0, NULL) ||
+          enc.elem_count != len || memcmp (enc.array, data.array, len)) {
+        SC_GLOBAL_LERRORF ("shuffle decode error %d %d\n",
+                           (int) es, (int) counts[zc]);
+        ++num_failed_tests;
+      }
+      sc_array_reset (&enc);
+      sc_array_reset (&dec);
+      sc_array_reset (&data);
+    }
+  }
+
+  /* a smooth field shrinks and keeps the requested precision */
+  sc_array_init_count (&data, sizeof (double), counts[3]);
+  d = (double *) data.array;
+  for (zz = 0; zz < counts[3]; ++zz) {
+    d[zz] = sin (.001 * zz) + 2.;
+  }
+  d[0] = -1. / 3.;
+  sc_array_init (&enc, 1);
+  sc_array_init (&dec, sizeof (double));
+  sc_io_encode_shuffle (&data, &enc, 9, '=', 10);
+  if (sc_io_decode (&enc, &dec, 0, NULL) ||
+      dec.elem_count != counts[3]) {
+    SC_GLOBAL_LERROR ("shuffle lossy decode error\n");
+    ++num_failed_tests;
+  }
+  else {
+    for (zz = 0; zz < counts[3]; ++zz) {
+      if (fabs (*(double *) sc_array_index (&dec, zz) - d[zz]) >
+          fabs (d[zz]) / 2048.) {
+        SC_GLOBAL_LERRORF ("shuffle lossy mismatch at %d\n", (int) zz);
+        ++num_failed_tests;
+        break;
+      }
+    }
+  }
+  len = enc.elem_count;
+  sc_array_reset (&enc);
+  sc_array_init (&enc, 1);
+  sc_io_encode_shuffle (&data, &enc, 9, '=', -1);
+  if (len >= enc.elem_count) {
+    SC_GLOBAL_LERROR ("shuffle lossy encoding ineffective\n");
+    ++num_failed_tests;
+  }
+  sc_array_reset (&enc);
+  sc_array_reset (&dec);
+  sc_array_reset (&data);
+
+  return num_failed_tests;
+}
+
+/* Decode a string in pieces through a sink and compare to the original. */
+static int
+test_decode_stream (sc_array_t *enc, size_t count, sc_array_t *data,
+                    size_t piece)
+{
+  int                 retval = 0;
+  size_t              zz, len, osize;
+  sc_array_t          dec;
+  sc_io_sink_t       *sink;
+  sc_io_decoder_t    *decoder;
+
+  sc_array_init (&dec, 1);
+  sink = sc_io_sink_new (SC_IO_TYPE_BUFFER, SC_IO_MODE_WRITE,
+                         SC_IO_ENCODE_NONE, &dec);
+  decoder = sc_io_decoder_new (sink, 0);
+  for (zz = 0; zz < count; zz += len) {
+    len = SC_MIN (piece, count - zz);
+    if (sc_io_decoder_write (decoder, enc->array + zz, len)) {
+      retval = 1;
+    }
+  }
+  if (sc_io_decoder_destroy (decoder, &osize)) {
+    retval = 1;
+  }
+  if (sc_io_sink_destroy (sink) || osize != data->elem_count ||
+      !sc_array_is_equal (&dec, data)) {
+    retval = 1;
+  }
+  sc_array_reset (&dec);
+  return retval;
+}
+
+static int
+test_encode_stream (void)
+{
+  const size_t        sizes[5] = { 0, 1, 56, 57 * 3, 300000 };
+  const size_t        pieces[3] = { 1, 77, 100000 };
+  int                 num_failed_tests = 0;
+  int                 k;
+  size_t              zs, zp, zz, len;
+  sc_array_t          data, enc, dec;
+  sc_io_sink_t       *sink;
+  sc_io_encoder_t    *encoder;
+
+  for (zs = 0; zs < 5; ++zs) {
+    sc_array_init_count (&data, 1, sizes[zs]);
+    for (zz = 0; zz < sizes[zs]; ++zz) {
+      data.array[zz] = (char) (zz % 211 < 50 ? rand () : 'y');
+    }
+    for (zp = 0; zp < 3; ++zp) {
+      /* encode in pieces and decode in one go */
+      sc_array_init (&enc, 1);
+      sink = sc_io_sink_new (SC_IO_TYPE_BUFFER, SC_IO_MODE_WRITE,
+                             SC_IO_ENCODE_NONE, &enc);
+      encoder = sc_io_encoder_new (sink, sizes[zs], 6, '=');
+      for (zz = 0; zz < sizes[zs]; zz += len) {
+        len = SC_MIN (pieces[zp], sizes[zs] - zz);
+        if (sc_io_encoder_write (encoder, data.array + zz, len)) {
+          ++num_failed_tests;
+        }
+      }
+      if (sc_io_encoder_destroy (encoder)) {
+        SC_GLOBAL_LERRORF ("stream encode error %d %d\n", (int) zs, (int) zp);
+        ++num_failed_tests;
+      }
+      if (sc_io_sink_destroy (sink)) {
+        ++num_failed_tests;
+      }
+      sc_array_init (&dec, 1);
+      if (sc_io_decode (&enc, &dec, 0, NULL) ||
+          !sc_array_is_equal (&data, &dec)) {
+        SC_GLOBAL_LERRORF ("stream encode mismatch %d %d\n",
+                           (int) zs, (int) zp);
+        ++num_failed_tests;
+      }
+      sc_array_reset (&dec);
+
+      /* decode each format in pieces */
+      for (k = 0; k < 4; ++k) {
+        if (k > 0) {
+          sc_array_reset (&enc);
+          sc_array_init (&enc, 1);
+          if (k < 3) {
+            sc_io_encode_ext (&data, &enc, 6, '=', k == 1 ?
+                              SC_IO_CHECKSUM_ADLER32 :
+                              SC_IO_CHECKSUM_CRC32C);
+          }
+          else {
+            sc_io_encode_parallel (&data, &enc, 6, '=', 1000, 2);
+          }
+        }
+        if (test_decode_stream (&enc, enc.elem_count, &data, pieces[zp])) {
+          SC_GLOBAL_LERRORF ("stream decode error %d %d %d\n",
+                             (int) zs, (int) zp, k);
+          ++num_failed_tests;
+        }
+      }
+
+      /* a string without its terminating NUL must not succeed */
+      if (!test_decode_stream (&enc, enc.elem_count - 1, &data,
+                               pieces[zp])) {
+        SC_GLOBAL_LERRORF ("stream decode truncation %d %d\n",
+                           (int) zs, (int) zp);
+        ++num_failed_tests;
+      }
+      sc_array_reset (&enc);
+    }
+    sc_array_reset (&data);
+  }
+
+  return num_failed_tests;
+}
+
+#ifdef SC_ENABLE_PTHREAD
+
+#define TEST_LOG_THREADS 4
+#define TEST_LOG_LINES 2000
+
+static void        *
+test_log_async_thread (void *v)
+{
+  int                 i;
+
+  for (i = 0; i < TEST_LOG_LINES; ++i) {
+    sc_logf (__FILE__, __LINE__, -1, SC_LC_NORMAL, SC_LP_ESSENTIAL,
+             "thread %d line %d\n", *(int *) v, i);
+  }
+  return NULL;
+}
+
+static int
+test_log_async (void)
+{
+  int                 num_failed_tests = 0;
+  int                 t, id[TEST_LOG_THREADS], count[TEST_LOG_THREADS];
+  int                 thread, line;
+  char                buf[BUFSIZ];
+  pthread_t           threads[TEST_LOG_THREADS];
+  FILE               *file;
+
+  file = tmpfile ();
+  SC_CHECK_ABORT (file != NULL, "Temporary file");
+
+  /* a small ring forces the threads to wait for the drain */
+  sc_log_async_start (1);
+  sc_set_log_defaults (file, NULL, SC_LP_ESSENTIAL);
+  for (t = 0; t < TEST_LOG_THREADS; ++t) {
+    id[t] = t;
+    count[t] = 0;
+    SC_CHECK_ABORT (!pthread_create (&threads[t], NULL,
+                                     test_log_async_thread, &id[t]),
+                    "Thread create");
+  }
+  for (t = 0; t < TEST_LOG_THREADS; ++t) {
+    SC_CHECK_ABORT (!pthread_join (threads[t], NULL), "Thread join");
+  }
+  sc_log_flush ();
+  sc_log_async_stop ();
+  sc_set_log_defaults (NULL, NULL, SC_LP_DEFAULT);
+
+  /* the lines of each thread must arrive complete and in order */
+  rewind (file);
+  while (fgets (buf, BUFSIZ, file) != NULL) {
+    if (sscanf (buf, "[%*d] thread %d line %d", &thread, &line) != 2 &&
+        sscanf (buf, "thread %d line %d", &thread, &line) != 2) {
+      continue;
+    }
+    if (thread < 0 || thread >= TEST_LOG_THREADS || line != count[thread]) {
+      SC_GLOBAL_LERRORF ("async log line out of order: %s", buf);
+      ++num_failed_tests;
+      break;
+    }
+    ++count[thread];
+  }
+  for (t = 0; t < TEST_LOG_THREADS; ++t) {
+    if (count[t] != TEST_LOG_LINES) {
+      SC_GLOBAL_LERRORF ("async log thread %d wrote %d lines\n", t,
+                         count[t]);
+      ++num_failed_tests;
+    }
+  }
+  fclose (file);
+
+  return num_failed_tests;
+}
+
+#endif /* SC_ENABLE_PTHREAD */
+
 int
 main (int argc, char **argv)
 {
@@ -335,6 +1207,39 @@ main (int argc, char **argv)
   /* test encode and decode functions */
   num_failed_tests += test_encode_decode ();
 
+  /* test the parallel block format */
+  num_failed_tests += test_encode_parallel ();
+  num_failed_tests += test_encode_ints ();
+  num_failed_tests += test_encode_shuffle ();
+
+  /* test the incremental encoder and decoder */
+  num_failed_tests += test_encode_stream ();
+
+  /* test the checksum functions and their use in encoding */
+  num_failed_tests += test_checksums ();
+
+  /* test the base 64 kernels against a reference */
+  num_failed_tests += test_base64 ();
+
+#ifdef SC_HAVE_ZLIB
+  /* test the builtin inflate against zlib */
+  num_failed_tests += test_puff ();
+#endif
+
+  /* test the per-package memory statistics */
+  num_failed_tests += test_memory_stats ();
+
+  /* test the inline check of the log threshold */
+  num_failed_tests += test_log_guard ();
+
+  /* test registration concurrent to lookups */
+  num_failed_tests += test_package_threads ();
+
+#ifdef SC_ENABLE_PTHREAD
+  /* test the buffered log from several threads */
+  num_failed_tests += test_log_async ();
+#endif
+
   /* clean up and exit */
   sc_finalize ();
 
@@ -21,6 +21,7 @@
   02110-1301, USA.
 */
 
+#include <sc_checkpoint.h>
 #include <sc_io.h>
 #include <sc_options.h>
 
@@ -62,6 +63,814 @@ the_test (const char *filename)
   }
 }
 
+static void
+the_mmap_test (const char *filename)
+{
+  int                 retval;
+  size_t              bytes_avail, bytes_out;
+  const char          input[] =
+    "This is a string for mapping without copying.\n";
+  const char         *data;
+  char                word[8];
+  sc_array_t          view;
+  sc_io_sink_t       *sink;
+  sc_io_source_t     *source;
+
+  sink = sc_io_sink_new (SC_IO_TYPE_FILENAME, SC_IO_MODE_WRITE,
+                         SC_IO_ENCODE_NONE, filename);
+  SC_CHECK_ABORT (sink != NULL, "Sink create");
+  retval = sc_io_sink_write (sink, input, strlen (input));
+  SC_CHECK_ABORT (retval == 0, "Sink write");
+  retval = sc_io_sink_destroy (sink);
+  SC_CHECK_ABORT (retval == 0, "Sink destroy");
+
+  source = sc_io_source_new (SC_IO_TYPE_MMAP, SC_IO_ENCODE_NONE, filename);
+  if (source == NULL) {
+    SC_GLOBAL_INFO ("Memory mapped source not available\n");
+    (void) remove (filename);
+    return;
+  }
+  retval = sc_io_source_advise (source, SC_IO_ADVICE_SEQUENTIAL);
+  SC_CHECK_ABORT (retval == 0, "Source advise");
+
+  /* wrap the whole mapping by an array view */
+  data = sc_io_source_peek (source, &bytes_avail);
+  SC_CHECK_ABORT (data != NULL && bytes_avail == strlen (input),
+                  "Source peek");
+  sc_array_init_data (&view, (void *) data, 1, bytes_avail);
+  SC_CHECK_ABORT (!memcmp (view.array, input, bytes_avail), "Source data");
+
+  /* read a few bytes and skip some to move the position */
+  retval = sc_io_source_read (source, word, 8, NULL);
+  SC_CHECK_ABORT (retval == 0 && !memcmp (word, input, 8), "Source read");
+  retval = sc_io_source_read (source, NULL, 2, NULL);
+  SC_CHECK_ABORT (retval == 0, "Source skip");
+  data = sc_io_source_peek (source, &bytes_avail);
+  SC_CHECK_ABORT (bytes_avail == strlen (input) - 10 &&
+                  !memcmp (data, input + 10, bytes_avail), "Source peek");
+  retval = sc_io_source_read (source, NULL, 100, &bytes_out);
+  SC_CHECK_ABORT (retval == 0 && bytes_out == bytes_avail, "Source end");
+
+  retval = sc_io_source_activate_mirror (source);
+  SC_CHECK_ABORT (retval != 0, "Source mirror");
+  retval = sc_io_source_destroy (source);
+  SC_CHECK_ABORT (retval == 0, "Source destroy");
+  (void) remove (filename);
+}
+
+static void
+the_readahead_test (const char *filename, int flags)
+{
+  int                 retval;
+  int                 i;
+  size_t              bytes_out, zz;
+  char                record[13], skipped[13];
+  sc_array_t         *data, *back;
+  sc_io_sink_t       *sink;
+  sc_io_source_t     *source;
+  FILE               *file;
+
+  /* write records whose bytes identify their position */
+  data = sc_array_new_count (1, 13 * 5000);
+  for (zz = 0; zz < data->elem_count; ++zz) {
+    data->array[zz] = (char) (zz / 13 + 3 * (zz % 13));
+  }
+  sink = sc_io_sink_new (SC_IO_TYPE_FILENAME, SC_IO_MODE_WRITE,
+                         SC_IO_ENCODE_NONE, filename);
+  SC_CHECK_ABORT (sink != NULL, "Sink create");
+  retval = sc_io_sink_write (sink, data->array, data->elem_count);
+  SC_CHECK_ABORT (retval == 0, "Sink write");
+  retval = sc_io_sink_destroy (sink);
+  SC_CHECK_ABORT (retval == 0, "Sink destroy");
+
+  /* read small pieces through a buffer of odd size */
+  source = sc_io_source_new (SC_IO_TYPE_FILENAME, SC_IO_ENCODE_NONE,
+                             filename);
+  SC_CHECK_ABORT (source != NULL, "Source create");
+  retval = sc_io_source_set_readahead (source, 1000, flags);
+  SC_CHECK_ABORT (retval == 0, "Source read-ahead");
+  retval = sc_io_source_set_readahead (source, 1000, flags);
+  SC_CHECK_ABORT (retval != 0, "Source read-ahead twice");
+  retval = sc_io_source_read (source, record, 13, NULL);
+  SC_CHECK_ABORT (retval == 0 && !memcmp (record, data->array, 13),
+                  "Source read");
+  retval = sc_io_source_activate_mirror (source);
+  SC_CHECK_ABORT (retval == 0, "Source mirror");
+  for (i = 1; i < 2000; ++i) {
+    retval = sc_io_source_read (source, record, 13, NULL);
+    SC_CHECK_ABORT (retval == 0 &&
+                    !memcmp (record, data->array + 13 * i, 13),
+                    "Source read");
+  }
+
+  /* skipped data is not mirrored, large requests bypass the buffer */
+  retval = sc_io_source_read (source, NULL, 13 * 1000, NULL);
+  SC_CHECK_ABORT (retval == 0, "Source skip");
+  back = sc_array_new_count (1, 13 * 5000);
+  retval = sc_io_source_read (source, back->array, 13 * 5000, &bytes_out);
+  SC_CHECK_ABORT (retval == 0 && bytes_out == 13 * 2000 &&
+                  !memcmp (back->array, data->array + 13 * 3000,
+                           bytes_out), "Source read end");
+  retval = sc_io_source_read_mirror (source, back->array, 13 * 5000,
+                                     &bytes_out);
+  SC_CHECK_ABORT (retval == 0 && bytes_out == 13 * 3999 &&
+                  !memcmp (back->array, data->array + 13, 13 * 1999) &&
+                  !memcmp (back->array + 13 * 1999,
+                           data->array + 13 * 3000, 13 * 2000),
+                  "Source mirror read");
+  retval = sc_io_source_destroy (source);
+  SC_CHECK_ABORT (retval == 0, "Source destroy");
+
+  /* the position of a file passed in is restored to the last byte read */
+  file = fopen (filename, "rb");
+  SC_CHECK_ABORT (file != NULL, "File open");
+  source = sc_io_source_new (SC_IO_TYPE_FILEFILE, SC_IO_ENCODE_NONE, file);
+  SC_CHECK_ABORT (source != NULL, "Source create");
+  retval = sc_io_source_set_readahead (source, 0, flags);
+  SC_CHECK_ABORT (retval == 0, "Source read-ahead");
+  retval = sc_io_source_read (source, record, 13, NULL);
+  SC_CHECK_ABORT (retval == 0, "Source read");
+  retval = sc_io_source_destroy (source);
+  SC_CHECK_ABORT (retval == 0, "Source destroy");
+  SC_CHECK_ABORT (fread (skipped, 1, 13, file) == 13 &&
+                  !memcmp (skipped, data->array + 13, 13), "File position");
+  SC_CHECK_ABORT (fclose (file) == 0, "File close");
+
+  sc_array_destroy (back);
+  sc_array_destroy (data);
+  (void) remove (filename);
+}
+
+static void
+the_writev_test (const char *filename)
+{
+  int                 retval;
+  int                 i;
+  size_t              bytes_in, bytes_out;
+  const char          head[] = "header", tail[] = "tail";
+  char                record[13];
+  sc_io_vec_t         vec[3];
+  sc_array_t         *buffer, *expect, *back;
+  sc_io_vec_t        *pieces;
+  sc_io_sink_t       *sink;
+  sc_io_source_t     *source;
+
+  /* compare a vectored write to single writes with alignment */
+  buffer = sc_array_new (4);
+  expect = sc_array_new (4);
+  sink = sc_io_sink_new (SC_IO_TYPE_BUFFER, SC_IO_MODE_WRITE,
+                         SC_IO_ENCODE_NONE, expect);
+  SC_CHECK_ABORT (sink != NULL, "Sink create");
+  retval = sc_io_sink_write (sink, head, 6);
+  retval = retval || sc_io_sink_write (sink, tail, 4);
+  retval = retval || sc_io_sink_align (sink, 16);
+  retval = retval || sc_io_sink_write (sink, head, 6);
+  retval = retval || sc_io_sink_align (sink, 4);
+  SC_CHECK_ABORT (retval == 0, "Sink write");
+  retval = sc_io_sink_destroy (sink);
+  SC_CHECK_ABORT (retval == 0, "Sink destroy");
+
+  sink = sc_io_sink_new (SC_IO_TYPE_BUFFER, SC_IO_MODE_WRITE,
+                         SC_IO_ENCODE_NONE, buffer);
+  SC_CHECK_ABORT (sink != NULL, "Sink create");
+  vec[0].data = head;
+  vec[0].bytes = 6;
+  vec[1].data = NULL;
+  vec[1].bytes = 0;
+  vec[2].data = tail;
+  vec[2].bytes = 4;
+  retval = sc_io_sink_writev (sink, vec, 3, 16);
+  SC_CHECK_ABORT (retval == 0 && buffer->elem_count == 4, "Sink writev");
+  retval = sc_io_sink_writev (sink, vec, 1, 0);
+  SC_CHECK_ABORT (retval == 0, "Sink writev");
+  retval = sc_io_sink_complete (sink, &bytes_in, &bytes_out);
+  SC_CHECK_ABORT (retval == SC_IO_ERROR_AGAIN, "Sink incomplete");
+  retval = sc_io_sink_writev (sink, vec, 0, 4);
+  SC_CHECK_ABORT (retval == 0, "Sink writev");
+  retval = sc_io_sink_complete (sink, &bytes_in, &bytes_out);
+  SC_CHECK_ABORT (retval == 0 && bytes_in == 24 && bytes_out == 24,
+                  "Sink complete");
+  retval = sc_io_sink_destroy (sink);
+  SC_CHECK_ABORT (retval == 0, "Sink destroy");
+  SC_CHECK_ABORT (buffer->elem_count == 6 && expect->elem_count == 6 &&
+                  !memcmp (buffer->array, head, 6) &&
+                  !memcmp (buffer->array + 16, head, 6) &&
+                  !memcmp (buffer->array, expect->array, 24),
+                  "Sink writev data");
+
+  /* write more pieces to a file than one system call may take */
+  pieces = SC_ALLOC (sc_io_vec_t, 5000);
+  for (i = 0; i < 5000; ++i) {
+    pieces[i].data = i % 2 ? (const void *) tail : (const void *) head;
+    pieces[i].bytes = i % 2 ? 4 : 6;
+  }
+  sink = sc_io_sink_new (SC_IO_TYPE_FILENAME, SC_IO_MODE_WRITE,
+                         SC_IO_ENCODE_NONE, filename);
+  SC_CHECK_ABORT (sink != NULL, "Sink create");
+  retval = sc_io_sink_write (sink, "x", 1);
+  retval = retval || sc_io_sink_writev (sink, pieces, 5000, 13);
+  retval = retval || sc_io_sink_writev (sink, pieces, 2, 0);
+  SC_CHECK_ABORT (retval == 0, "Sink writev");
+  retval = sc_io_sink_complete (sink, &bytes_in, &bytes_out);
+  SC_CHECK_ABORT (retval == 0 && bytes_in == 25012 + 10 &&
+                  bytes_out == bytes_in, "Sink complete");
+  retval = sc_io_sink_destroy (sink);
+  SC_CHECK_ABORT (retval == 0, "Sink destroy");
+
+  back = sc_array_new_count (1, 25022);
+  source = sc_io_source_new (SC_IO_TYPE_FILENAME, SC_IO_ENCODE_NONE,
+                             filename);
+  SC_CHECK_ABORT (source != NULL, "Source create");
+  retval = sc_io_source_read (source, back->array, 25022, NULL);
+  SC_CHECK_ABORT (retval == 0, "Source read");
+  retval = sc_io_source_read (source, record, 1, &bytes_out);
+  SC_CHECK_ABORT (retval == 0 && bytes_out == 0, "Source end");
+  retval = sc_io_source_destroy (source);
+  SC_CHECK_ABORT (retval == 0, "Source destroy");
+  SC_CHECK_ABORT (back->array[0] == 'x', "File head");
+  for (i = 0; i < 5000; ++i) {
+    SC_CHECK_ABORT (!memcmp (back->array + 1 + 10 * (i / 2) + 6 * (i % 2),
+                             pieces[i].data, pieces[i].bytes), "File data");
+  }
+  SC_CHECK_ABORT (!memcmp (back->array + 25001, "\0\0\0\0\0\0\0\0\0\0\0"
+                           "header" "tail", 21), "File tail");
+
+  SC_FREE (pieces);
+  sc_array_destroy (back);
+  sc_array_destroy (expect);
+  sc_array_destroy (buffer);
+  (void) remove (filename);
+}
+
+static void
+the_staged_test (const char *filename, int flags)
+{
+  int                 retval;
+  int                 i, j;
+  size_t              bytes_in, bytes_out, zz;
+  char                record[13];
+  sc_array_t         *buffer;
+  sc_io_sink_t       *sink;
+  sc_io_source_t     *source;
+
+  /* write many small records through small staging buffers */
+  sink = sc_io_sink_new_staged (filename, SC_IO_MODE_WRITE, 8192, flags);
+  SC_CHECK_ABORT (sink != NULL, "Staged sink create");
+  for (i = 0; i < 20000; ++i) {
+    for (j = 0; j < 13; ++j) {
+      record[j] = (char) (i + j);
+    }
+    retval = sc_io_sink_write (sink, record, 13);
+    SC_CHECK_ABORT (retval == 0, "Staged sink write");
+    if (i == 10000) {
+      /* completing in between must not disturb the data */
+      retval = sc_io_sink_complete (sink, &bytes_in, &bytes_out);
+      SC_CHECK_ABORT (retval == 0 && bytes_in == 13 * 10001 &&
+                      bytes_out == bytes_in, "Staged sink complete");
+    }
+  }
+  retval = sc_io_sink_destroy (sink);
+  SC_CHECK_ABORT (retval == 0, "Staged sink destroy");
+
+  /* append a short tail */
+  sink = sc_io_sink_new_staged (filename, SC_IO_MODE_APPEND, 0, flags);
+  SC_CHECK_ABORT (sink != NULL, "Staged sink append");
+  retval = sc_io_sink_write (sink, "tail", 4);
+  SC_CHECK_ABORT (retval == 0, "Staged sink write");
+  retval = sc_io_sink_destroy (sink);
+  SC_CHECK_ABORT (retval == 0, "Staged sink destroy");
+
+  /* read the file back */
+  buffer = sc_array_new_count (1, 13 * 20000 + 4);
+  source = sc_io_source_new (SC_IO_TYPE_FILENAME, SC_IO_ENCODE_NONE,
+                             filename);
+  SC_CHECK_ABORT (source != NULL, "Source create");
+  retval = sc_io_source_read (source, buffer->array, buffer->elem_count,
+                              NULL);
+  SC_CHECK_ABORT (retval == 0, "Source read");
+  retval = sc_io_source_read (source, record, 1, &bytes_out);
+  SC_CHECK_ABORT (retval == 0 && bytes_out == 0, "Source end");
+  retval = sc_io_source_destroy (source);
+  SC_CHECK_ABORT (retval == 0, "Source destroy");
+  for (zz = 0; zz < 13 * 20000; ++zz) {
+    SC_CHECK_ABORT (buffer->array[zz] == (char) (zz / 13 + zz % 13),
+                    "Staged data");
+  }
+  SC_CHECK_ABORT (!memcmp (buffer->array + zz, "tail", 4), "Staged tail");
+  sc_array_destroy (buffer);
+  (void) remove (filename);
+}
+
+static void
+the_encode_test (const char *filename, int ioencode)
+{
+  int                 retval;
+  int                 i, j;
+  size_t              bytes_in, bytes_out, zz;
+  char                record[13];
+  sc_array_t         *buffer, *data;
+  sc_io_sink_t       *sink;
+  sc_io_source_t     *source;
+
+  /* compress records into a buffer or a file */
+  buffer = sc_array_new (sizeof (char));
+  if (filename == NULL) {
+    sink = sc_io_sink_new (SC_IO_TYPE_BUFFER, SC_IO_MODE_WRITE, ioencode,
+                           buffer);
+  }
+  else {
+    sink = sc_io_sink_new (SC_IO_TYPE_STAGED, SC_IO_MODE_WRITE, ioencode,
+                           filename);
+  }
+  if (sink == NULL) {
+    SC_GLOBAL_INFO ("Compressing encoding not available\n");
+    sc_array_destroy (buffer);
+    return;
+  }
+  for (i = 0; i < 20000; ++i) {
+    for (j = 0; j < 13; ++j) {
+      record[j] = (char) (i % 7 + j);
+    }
+    retval = sc_io_sink_write (sink, record, 13);
+    SC_CHECK_ABORT (retval == 0, "Encode sink write");
+    if (i == 5000) {
+      /* this ends the first compressed stream */
+      retval = sc_io_sink_complete (sink, &bytes_in, &bytes_out);
+      SC_CHECK_ABORT (retval == 0 && bytes_in == 13 * 5001 &&
+                      bytes_out < bytes_in, "Encode sink complete");
+    }
+  }
+  retval = sc_io_sink_destroy (sink);
+  SC_CHECK_ABORT (retval == 0, "Encode sink destroy");
+
+  /* uncompress and compare */
+  data = sc_array_new_count (1, 13 * 20000);
+  if (filename == NULL) {
+    source = sc_io_source_new (SC_IO_TYPE_BUFFER, ioencode, buffer);
+  }
+  else {
+    source = sc_io_source_new (SC_IO_TYPE_FILENAME, ioencode, filename);
+  }
+  SC_CHECK_ABORT (source != NULL, "Encode source create");
+  retval = sc_io_source_read (source, data->array, 13 * 1000, NULL);
+  SC_CHECK_ABORT (retval == 0, "Encode source read");
+  retval = sc_io_source_read (source, NULL, 13 * 5000, NULL);
+  SC_CHECK_ABORT (retval == 0, "Encode source skip");
+  retval = sc_io_source_read (source, data->array + 13 * 6000,
+                              13 * 20000, &bytes_out);
+  SC_CHECK_ABORT (retval == 0 && bytes_out == 13 * 14000,
+                  "Encode source end");
+  retval = sc_io_source_complete (source, &bytes_in, &bytes_out);
+  SC_CHECK_ABORT (retval == 0 && bytes_out == 13 * 20000,
+                  "Encode source complete");
+  retval = sc_io_source_destroy (source);
+  SC_CHECK_ABORT (retval == 0, "Encode source destroy");
+  for (zz = 0; zz < 13 * 20000; ++zz) {
+    if (zz < 13 * 1000 || zz >= 13 * 6000) {
+      SC_CHECK_ABORT (data->array[zz] == (char) (zz / 13 % 7 + zz % 13),
+                      "Encode data");
+    }
+  }
+  sc_array_destroy (data);
+  sc_array_destroy (buffer);
+  if (filename != NULL) {
+    (void) remove (filename);
+  }
+}
+
+static void
+the_nonblocking_test (sc_MPI_Comm mpicomm, const char *filename)
+{
+  int                 mpiret, errcode;
+  int                 rank, flag, ocount;
+  int                 i;
+  char                data[64], back[64];
+  sc_MPI_File         file;
+  sc_io_request_t    *request;
+
+  mpiret = sc_MPI_Comm_rank (mpicomm, &rank);
+  SC_CHECK_MPI (mpiret);
+  for (i = 0; i < 64; ++i) {
+    data[i] = (char) (rank + i);
+  }
+
+  /* write one block per rank and poll for completion */
+  errcode = sc_io_open (mpicomm, filename, SC_IO_WRITE_CREATE,
+                        sc_MPI_INFO_NULL, &file);
+  SC_CHECK_ABORT (errcode == sc_MPI_SUCCESS, "Nonblocking open");
+  errcode = sc_io_iwrite_at_all (file, (sc_MPI_Offset) (64 * rank), data,
+                                 64, sc_MPI_BYTE, &request);
+  SC_CHECK_ABORT (errcode == sc_MPI_SUCCESS, "Nonblocking write");
+  do {
+    errcode = sc_io_test (&request, &flag, &ocount);
+    SC_CHECK_ABORT (errcode == sc_MPI_SUCCESS, "Nonblocking test");
+  }
+  while (!flag);
+  SC_CHECK_ABORT (request == NULL && ocount == 64, "Nonblocking count");
+  errcode = sc_io_close (&file);
+  SC_CHECK_ABORT (errcode == sc_MPI_SUCCESS, "Nonblocking close");
+
+  /* read the blocks back and wait for them */
+  errcode = sc_io_open (mpicomm, filename, SC_IO_READ,
+                        sc_MPI_INFO_NULL, &file);
+  SC_CHECK_ABORT (errcode == sc_MPI_SUCCESS, "Nonblocking open");
+  errcode = sc_io_iread_at_all (file, (sc_MPI_Offset) (64 * rank), back,
+                                64, sc_MPI_BYTE, &request);
+  SC_CHECK_ABORT (errcode == sc_MPI_SUCCESS, "Nonblocking read");
+  errcode = sc_io_wait (&request, &ocount);
+  SC_CHECK_ABORT (errcode == sc_MPI_SUCCESS && request == NULL &&
+                  ocount == 64 && !memcmp (data, back, 64),
+                  "Nonblocking wait");
+  errcode = sc_io_close (&file);
+  SC_CHECK_ABORT (errcode == sc_MPI_SUCCESS, "Nonblocking close");
+
+  mpiret = sc_MPI_Barrier (mpicomm);
+  SC_CHECK_MPI (mpiret);
+  if (rank == 0) {
+    (void) remove (filename);
+  }
+}
+
+static void
+the_hints_test (sc_MPI_Comm mpicomm, const char *filename)
+{
+  int                 mpiret, errcode;
+  int                 rank, size, ocount, first;
+  int                 i;
+  char                data[64], back[64];
+  char               *argv[5];
+  sc_io_hints_t       hints;
+  sc_options_t       *opt;
+  sc_MPI_File         file;
+
+  mpiret = sc_MPI_Comm_rank (mpicomm, &rank);
+  SC_CHECK_MPI (mpiret);
+  mpiret = sc_MPI_Comm_size (mpicomm, &size);
+  SC_CHECK_MPI (mpiret);
+  for (i = 0; i < 64; ++i) {
+    data[i] = (char) (rank - i);
+  }
+
+  /* set the hints from the command line */
+  sc_io_hints_init (&hints);
+  opt = sc_options_new ("hints");
+  sc_io_hints_add_options (&hints, opt);
+  argv[0] = "hints";
+  argv[1] = "--striping-factor=-1";
+  argv[2] = "--stripe-bytes=100";
+  argv[3] = "--cb-write=enable";
+  argv[4] = "--io-hints=romio_ds_write=disable,";
+  first = sc_options_parse (sc_package_id, SC_LP_INFO, opt, 5, argv);
+  SC_CHECK_ABORT (first == 5 && hints.striping_factor == -1 &&
+                  hints.stripe_bytes == 100, "Hints options");
+
+  /* the automatic stripes follow the file and communicator size */
+  SC_CHECK_ABORT (sc_io_hints_stripes (&hints, 8, 0) == 1 &&
+                  sc_io_hints_stripes (&hints, 8, 250) == 3 &&
+                  sc_io_hints_stripes (&hints, 2, 250) == 2,
+                  "Hints automatic stripes");
+  hints.max_stripes = 2;
+  SC_CHECK_ABORT (sc_io_hints_stripes (&hints, 8, 1000) == 2,
+                  "Hints maximum stripes");
+
+  /* the hints must not change the data */
+  errcode = sc_io_open_hints (mpicomm, filename, SC_IO_WRITE_CREATE,
+                              &hints, (size_t) 64 * size, &file);
+  SC_CHECK_ABORT (errcode == sc_MPI_SUCCESS, "Hints open");
+  errcode = sc_io_write_at_all (file, (sc_MPI_Offset) (64 * rank), data,
+                                64, sc_MPI_BYTE, &ocount);
+  SC_CHECK_ABORT (errcode == sc_MPI_SUCCESS && ocount == 64, "Hints write");
+  errcode = sc_io_close (&file);
+  SC_CHECK_ABORT (errcode == sc_MPI_SUCCESS, "Hints close");
+  errcode = sc_io_open_hints (mpicomm, filename, SC_IO_READ, &hints, 0,
+                              &file);
+  SC_CHECK_ABORT (errcode == sc_MPI_SUCCESS, "Hints open");
+  errcode = sc_io_read_at_all (file, (sc_MPI_Offset) (64 * rank), back,
+                               64, sc_MPI_BYTE, &ocount);
+  SC_CHECK_ABORT (errcode == sc_MPI_SUCCESS && ocount == 64 &&
+                  !memcmp (data, back, 64), "Hints read");
+  errcode = sc_io_close (&file);
+  SC_CHECK_ABORT (errcode == sc_MPI_SUCCESS, "Hints close");
+  sc_options_destroy (opt);
+
+  mpiret = sc_MPI_Barrier (mpicomm);
+  SC_CHECK_MPI (mpiret);
+  if (rank == 0) {
+    (void) remove (filename);
+  }
+}
+
+static void
+the_aggregated_test (sc_MPI_Comm mpicomm, const char *filename,
+                     int num_aggregators)
+{
+  int                 mpiret, errcode;
+  int                 rank, ocount;
+  int                 i;
+  char                data[64], back[64];
+  sc_MPI_File         file;
+
+  mpiret = sc_MPI_Comm_rank (mpicomm, &rank);
+  SC_CHECK_MPI (mpiret);
+  for (i = 0; i < 64; ++i) {
+    data[i] = (char) (3 * rank + i);
+  }
+
+  /* write one block per rank through the aggregators */
+  errcode = sc_io_open (mpicomm, filename, SC_IO_WRITE_CREATE,
+                        sc_MPI_INFO_NULL, &file);
+  SC_CHECK_ABORT (errcode == sc_MPI_SUCCESS, "Aggregated open");
+  errcode = sc_io_write_at_all_aggregated (mpicomm, file,
+                                           (sc_MPI_Offset) (64 * rank),
+                                           data, 64, sc_MPI_BYTE,
+                                           num_aggregators, &ocount);
+  SC_CHECK_ABORT (errcode == sc_MPI_SUCCESS && ocount == 64,
+                  "Aggregated write");
+  errcode = sc_io_close (&file);
+  SC_CHECK_ABORT (errcode == sc_MPI_SUCCESS, "Aggregated close");
+
+  /* read the blocks back */
+  errcode = sc_io_open (mpicomm, filename, SC_IO_READ,
+                        sc_MPI_INFO_NULL, &file);
+  SC_CHECK_ABORT (errcode == sc_MPI_SUCCESS, "Aggregated open");
+  errcode = sc_io_read_at_all (file, (sc_MPI_Offset) (64 * rank), back,
+                               64, sc_MPI_BYTE, &ocount);
+  SC_CHECK_ABORT (errcode == sc_MPI_SUCCESS && ocount == 64 &&
+                  !memcmp (data, back, 64), "Aggregated read");
+  errcode = sc_io_close (&file);
+  SC_CHECK_ABORT (errcode == sc_MPI_SUCCESS, "Aggregated close");
+
+  mpiret = sc_MPI_Barrier (mpicomm);
+  SC_CHECK_MPI (mpiret);
+  if (rank == 0) {
+    (void) remove (filename);
+  }
+}
+
+static void
+the_partition_test (sc_MPI_Comm mpicomm, const char *filename,
+                    int num_aggregators)
+{
+  int                 mpiret, errcode;
+  int                 rank, mpisize, ocount;
+  int                 i;
+  const int           old_size = 5;
+  const int64_t       total = 1000;
+  int64_t             old_partition[6] = { 0, 10, 10, 400, 990, 1000 };
+  int64_t            *new_partition, *values, zz;
+  sc_MPI_File         file;
+
+  mpiret = sc_MPI_Comm_rank (mpicomm, &rank);
+  SC_CHECK_MPI (mpiret);
+  mpiret = sc_MPI_Comm_size (mpicomm, &mpisize);
+  SC_CHECK_MPI (mpiret);
+
+  /* rank 0 writes the global indices after a header */
+  values = SC_ALLOC (int64_t, total);
+  for (zz = 0; zz < total; ++zz) {
+    values[zz] = 3 * zz + 1;
+  }
+  errcode = sc_io_open (mpicomm, filename, SC_IO_WRITE_CREATE,
+                        sc_MPI_INFO_NULL, &file);
+  SC_CHECK_ABORT (errcode == sc_MPI_SUCCESS, "Partition open");
+  errcode = sc_io_write_at_all (file, 8, values,
+                                rank == 0 ? (size_t) total : 0,
+                                sc_MPI_LONG_LONG_INT, &ocount);
+  SC_CHECK_ABORT (errcode == sc_MPI_SUCCESS, "Partition write");
+  errcode = sc_io_close (&file);
+  SC_CHECK_ABORT (errcode == sc_MPI_SUCCESS, "Partition close");
+
+  /* read back by an uneven partition with an empty first range */
+  new_partition = SC_ALLOC (int64_t, mpisize + 1);
+  new_partition[0] = 0;
+  for (i = 1; i < mpisize; ++i) {
+    new_partition[i] = total * i * i / mpisize / mpisize;
+  }
+  new_partition[mpisize] = total;
+  memset (values, 0, total * sizeof (int64_t));
+  errcode = sc_io_open (mpicomm, filename, SC_IO_READ,
+                        sc_MPI_INFO_NULL, &file);
+  SC_CHECK_ABORT (errcode == sc_MPI_SUCCESS, "Partition open");
+  errcode = sc_io_read_at_all_partition (mpicomm, file, 8, values,
+                                         sizeof (int64_t), old_partition,
+                                         old_size, new_partition,
+                                         num_aggregators);
+  SC_CHECK_ABORT (errcode == sc_MPI_SUCCESS, "Partition read");
+  errcode = sc_io_close (&file);
+  SC_CHECK_ABORT (errcode == sc_MPI_SUCCESS, "Partition close");
+  for (zz = new_partition[rank]; zz < new_partition[rank + 1]; ++zz) {
+    SC_CHECK_ABORT (values[zz - new_partition[rank]] == 3 * zz + 1,
+                    "Partition data");
+  }
+
+  SC_FREE (new_partition);
+  SC_FREE (values);
+  mpiret = sc_MPI_Barrier (mpicomm);
+  SC_CHECK_MPI (mpiret);
+  if (rank == 0) {
+    (void) remove (filename);
+  }
+}
+
+static void
+the_vtk_fill (int rank, sc_array_t *data)
+{
+  size_t              zz;
+
+  sc_array_resize (data, (size_t) (1000 * rank + 37));
+  for (zz = 0; zz < data->elem_count; ++zz) {
+    *(double *) sc_array_index (data, zz) = (double) (rank + zz % 17);
+  }
+}
+
+static void
+the_vtk_test (sc_MPI_Comm mpicomm, const char *filename)
+{
+  int                 mpiret, errcode;
+  int                 rank, size, r;
+  size_t              expected;
+  sc_MPI_Offset       offset, rank_offset;
+  sc_MPI_File         file;
+  sc_array_t         *data, *binary, *comp, *all, *back;
+  FILE               *fp;
+
+  mpiret = sc_MPI_Comm_rank (mpicomm, &rank);
+  SC_CHECK_MPI (mpiret);
+  mpiret = sc_MPI_Comm_size (mpicomm, &size);
+  SC_CHECK_MPI (mpiret);
+  data = sc_array_new (sizeof (double));
+  binary = sc_array_new (1);
+  comp = sc_array_new (1);
+
+  /* every rank writes one piece in both formats */
+  the_vtk_fill (rank, data);
+  sc_vtk_encode_binary (binary, data->array, data->elem_count * 8, 0);
+  sc_vtk_encode_compressed (comp, data->array, data->elem_count * 8, 0);
+  errcode = sc_io_open (mpicomm, filename, SC_IO_WRITE_CREATE,
+                        sc_MPI_INFO_NULL, &file);
+  SC_CHECK_ABORT (errcode == sc_MPI_SUCCESS, "VTK open");
+  offset = 0;
+  errcode = sc_vtk_write_appended_all (mpicomm, file, &offset, binary,
+                                       &rank_offset);
+  SC_CHECK_ABORT (errcode == sc_MPI_SUCCESS, "VTK write binary");
+  errcode = sc_vtk_write_appended_all (mpicomm, file, &offset, comp, NULL);
+  SC_CHECK_ABORT (errcode == sc_MPI_SUCCESS, "VTK write compressed");
+  errcode = sc_io_close (&file);
+  SC_CHECK_ABORT (errcode == sc_MPI_SUCCESS, "VTK close");
+
+  /* the file holds the binary and then the compressed pieces in order */
+  if (rank == 0) {
+    all = sc_array_new (1);
+    for (r = 0; r < 2 * size; ++r) {
+      the_vtk_fill (r % size, data);
+      if (r < size) {
+        sc_vtk_encode_binary (binary, data->array, data->elem_count * 8, 1);
+      }
+      else {
+        sc_vtk_encode_compressed (comp, data->array, data->elem_count * 8,
+                                  1);
+      }
+      back = r < size ? binary : comp;
+      expected = all->elem_count;
+      sc_array_resize (all, expected + back->elem_count);
+      memcpy (all->array + expected, back->array, back->elem_count);
+    }
+    SC_CHECK_ABORT (offset == (sc_MPI_Offset) all->elem_count, "VTK size");
+    back = sc_array_new_count (1, all->elem_count + 1);
+    fp = fopen (filename, "rb");
+    SC_CHECK_ABORT (fp != NULL, "VTK reopen");
+    SC_CHECK_ABORT (fread (back->array, 1, all->elem_count + 1, fp) ==
+                    all->elem_count && !memcmp (back->array, all->array,
+                                                all->elem_count),
+                    "VTK content");
+    fclose (fp);
+    (void) remove (filename);
+    sc_array_destroy (back);
+    sc_array_destroy (all);
+  }
+
+  /* the piece of a rank follows the binary pieces of all lower ranks */
+  for (expected = 0, r = 0; r < rank; ++r) {
+    the_vtk_fill (r, data);
+    sc_vtk_encode_binary (binary, data->array, data->elem_count * 8, 1);
+    expected += binary->elem_count;
+  }
+  SC_CHECK_ABORT (rank_offset == (sc_MPI_Offset) expected, "VTK offset");
+
+  sc_array_destroy (comp);
+  sc_array_destroy (binary);
+  sc_array_destroy (data);
+}
+
+/* block k of writer r holds compressible data for even and noise for odd k */
+static void
+the_checkpoint_fill (int writer, size_t k, sc_array_t *data)
+{
+  size_t              zz;
+
+  sc_array_resize (data, 100 * (k + 1) + (size_t) writer);
+  for (zz = 0; zz < data->elem_count; ++zz) {
+    *(int *) sc_array_index (data, zz) = k % 2 == 0 ? (int) (zz % 7) :
+      (int) ((zz + 1) * 2654435761u ^ (unsigned) writer);
+  }
+}
+
+static void
+the_checkpoint_test (sc_MPI_Comm mpicomm, const char *filename)
+{
+  int                 mpiret, errcode;
+  int                 rank, size, writer;
+  size_t              zz, n, total, block, local_index, bytes, elem_size;
+  sc_array_t         *blocks, *data, *back;
+  sc_checkpoint_t    *ckpt;
+  FILE               *fp;
+
+  mpiret = sc_MPI_Comm_rank (mpicomm, &rank);
+  SC_CHECK_MPI (mpiret);
+  mpiret = sc_MPI_Comm_size (mpicomm, &size);
+  SC_CHECK_MPI (mpiret);
+
+  /* rank r writes (r + 2) % 3 blocks, thus some ranks write none */
+  n = (size_t) ((rank + 2) % 3);
+  blocks = sc_array_new_count (sizeof (sc_array_t), n);
+  for (zz = 0; zz < n; ++zz) {
+    sc_array_init ((sc_array_t *) sc_array_index (blocks, zz), sizeof (int));
+    the_checkpoint_fill (rank, zz, (sc_array_t *) sc_array_index (blocks,
+                                                                  zz));
+  }
+  errcode = sc_checkpoint_write (mpicomm, filename, blocks, 6);
+  SC_CHECK_ABORT (errcode == sc_MPI_SUCCESS, "Checkpoint write");
+  for (zz = 0; zz < n; ++zz) {
+    sc_array_reset ((sc_array_t *) sc_array_index (blocks, zz));
+  }
+  sc_array_destroy (blocks);
+
+  /* read the blocks back in a different distribution */
+  ckpt = sc_checkpoint_open (mpicomm, filename, &errcode);
+  SC_CHECK_ABORT (ckpt != NULL && errcode == sc_MPI_SUCCESS,
+                  "Checkpoint open");
+  SC_CHECK_ABORT (sc_checkpoint_num_writers (ckpt) == size,
+                  "Checkpoint writers");
+  for (total = 0, writer = 0; writer < size; ++writer) {
+    n = (size_t) ((writer + 2) % 3);
+    SC_CHECK_ABORT (sc_checkpoint_find (ckpt, writer, n) ==
+                    SC_CHECKPOINT_NONE, "Checkpoint find");
+    if (n > 0) {
+      SC_CHECK_ABORT (sc_checkpoint_find (ckpt, writer, n - 1) ==
+                      total + n - 1, "Checkpoint find");
+    }
+    total += n;
+  }
+  SC_CHECK_ABORT (sc_checkpoint_num_blocks (ckpt) == total,
+                  "Checkpoint blocks");
+  data = sc_array_new (sizeof (int));
+  back = sc_array_new (sizeof (int));
+  for (zz = 0; zz < total; zz += (size_t) size) {
+    block = zz + (size_t) rank < total ?
+      total - 1 - zz - (size_t) rank : SC_CHECKPOINT_NONE;
+    errcode = sc_checkpoint_read_block (ckpt, block, back);
+    SC_CHECK_ABORT (errcode == sc_MPI_SUCCESS, "Checkpoint read");
+    if (block != SC_CHECKPOINT_NONE) {
+      sc_checkpoint_block_info (ckpt, block, &writer, &local_index,
+                                &bytes, &elem_size);
+      the_checkpoint_fill (writer, local_index, data);
+      SC_CHECK_ABORT (elem_size == sizeof (int) &&
+                      bytes == data->elem_count * sizeof (int) &&
+                      sc_array_is_equal (data, back), "Checkpoint data");
+    }
+  }
+  errcode = sc_checkpoint_close (ckpt);
+  SC_CHECK_ABORT (errcode == sc_MPI_SUCCESS, "Checkpoint close");
+
+  /* corrupt the last byte of the last block */
+  mpiret = sc_MPI_Barrier (mpicomm);
+  SC_CHECK_MPI (mpiret);
+  if (rank == 0) {
+    fp = fopen (filename, "r+b");
+    SC_CHECK_ABORT (fp != NULL, "Checkpoint reopen");
+    SC_CHECK_ABORT (fseek (fp, -1, SEEK_END) == 0 && fputc (0x5a, fp) != EOF
+                    && fclose (fp) == 0, "Checkpoint corrupt");
+  }
+  mpiret = sc_MPI_Barrier (mpicomm);
+  SC_CHECK_MPI (mpiret);
+  ckpt = sc_checkpoint_open (mpicomm, filename, &errcode);
+  SC_CHECK_ABORT (ckpt != NULL, "Checkpoint open");
+  errcode = sc_checkpoint_read_block (ckpt, rank == 0 ? total - 1 :
+                                      SC_CHECKPOINT_NONE, back);
+  SC_CHECK_ABORT ((rank == 0) == (errcode == sc_MPI_ERR_IO),
+                  "Checkpoint checksum");
+  errcode = sc_checkpoint_close (ckpt);
+  SC_CHECK_ABORT (errcode == sc_MPI_SUCCESS, "Checkpoint close");
+
+  sc_array_destroy (back);
+  sc_array_destroy (data);
+  mpiret = sc_MPI_Barrier (mpicomm);
+  SC_CHECK_MPI (mpiret);
+  if (rank == 0) {
+    (void) remove (filename);
+  }
+}
+
 int
 main (int argc, char **argv)
 {
@@ -85,8 +894,30 @@ main (int argc, char **argv)
 
   if (sc_is_root ()) {
     the_test (filename);
+    the_mmap_test ("sc_test_io_mmap.bin");
+    the_writev_test ("sc_test_io_writev.bin");
+    the_readahead_test ("sc_test_io_readahead.bin", 0);
+    the_readahead_test ("sc_test_io_readahead.bin",
+                        SC_IO_READAHEAD_PREFETCH);
+    the_staged_test ("sc_test_io_staged.bin", 0);
+    the_staged_test ("sc_test_io_staged.bin", SC_IO_STAGED_DIRECT);
+    the_encode_test (NULL, SC_IO_ENCODE_ZLIB);
+    the_encode_test ("sc_test_io_encode.bin", SC_IO_ENCODE_ZLIB_FAST);
   }
 
+  the_nonblocking_test (sc_MPI_COMM_WORLD, "sc_test_io_nonblocking.bin");
+  the_hints_test (sc_MPI_COMM_WORLD, "sc_test_io_hints.bin");
+  the_aggregated_test (sc_MPI_COMM_WORLD, "sc_test_io_aggregated.bin", 1);
+  the_aggregated_test (sc_MPI_COMM_WORLD, "sc_test_io_aggregated.bin", 2);
+  the_partition_test (sc_MPI_COMM_WORLD, "sc_test_io_partition.bin", 1);
+  the_partition_test (sc_MPI_COMM_WORLD, "sc_test_io_partition.bin", 3);
+  sc_mpi_comm_attach_node_comms (sc_MPI_COMM_WORLD, 0);
+  the_aggregated_test (sc_MPI_COMM_WORLD, "sc_test_io_aggregated.bin", 0);
+  the_partition_test (sc_MPI_COMM_WORLD, "sc_test_io_partition.bin", 0);
+  sc_mpi_comm_detach_node_comms (sc_MPI_COMM_WORLD);
+  the_vtk_test (sc_MPI_COMM_WORLD, "sc_test_io_vtk.bin");
+  the_checkpoint_test (sc_MPI_COMM_WORLD, "sc_test_io_checkpoint.bin");
+
   sc_options_destroy (opt);
   sc_finalize ();
 
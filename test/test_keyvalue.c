@@ -42,6 +42,12 @@ main (int argc, char **argv)
   const char         *stringTest;
   void               *pointerTest;
 
+  int                 i;
+  char                names[100][20];
+  sc_keyvalue_key_t   key, key2;
+  size_t              position;
+  sc_array_t         *buffer;
+
   /* Initialization stuff */
   mpiret = sc_MPI_Init (&argc, &argv);
   SC_CHECK_MPI (mpiret);
@@ -212,6 +218,68 @@ main (int argc, char **argv)
 
   sc_keyvalue_destroy (args2);
 
+  /* Test the access by prepared keys, also mixed with strings */
+  args2 = sc_keyvalue_new ();
+  sc_keyvalue_key_init (&key, "intKey");
+  sc_keyvalue_key_init (&key2, "doubleKey");
+  for (i = 0; i < 100; ++i) {
+    snprintf (names[i], 20, "element%d", i);
+    sc_keyvalue_set_int (args2, names[i], i);
+  }
+  sc_keyvalue_set_int_key (args2, &key, 5);
+  sc_keyvalue_set_double_key (args2, &key2, .5);
+  sc_keyvalue_set_int_key (args2, &key, sc_keyvalue_get_int_key
+                           (args2, &key, 0) + 1);
+  if (sc_keyvalue_get_int (args2, "intKey", 0) != 6 ||
+      sc_keyvalue_get_double_key (args2, &key2, 0.) != .5 ||
+      sc_keyvalue_exists_key (args2, &key2) != SC_KEYVALUE_ENTRY_DOUBLE) {
+    SC_VERBOSE ("Test failure on prepared keys\n");
+    num_failed_tests++;
+  }
+  for (i = 0; i < 100; i += 2) {
+    sc_keyvalue_unset (args2, names[i]);
+  }
+  for (i = 0; i < 100; ++i) {
+    sc_keyvalue_key_init (&key, names[i]);
+    if (sc_keyvalue_get_int_key (args2, &key, -1) != (i % 2 ? i : -1)) {
+      SC_VERBOSEF ("Test failure on element %d\n", i);
+      num_failed_tests++;
+    }
+  }
+  sc_keyvalue_destroy (args2);
+
+  /* Test the binary round trip, which skips pointers */
+  args = sc_keyvalue_new ();
+  sc_keyvalue_set_int (args, "intTest", -3);
+  sc_keyvalue_set_double (args, "doubleTest", 2.5);
+  sc_keyvalue_set_string (args, "stringTest", dummy);
+  sc_keyvalue_set_pointer (args, "pointerTest", (void *) dummy);
+  buffer = sc_array_new (1);
+  sc_keyvalue_pack (args, buffer);
+  sc_keyvalue_destroy (args);
+  args2 = sc_keyvalue_new ();
+  sc_keyvalue_set_int (args2, "intTest", 1);
+  position = 0;
+  if (sc_keyvalue_unpack (args2, buffer, &position) != 0 ||
+      position != buffer->elem_count ||
+      sc_keyvalue_get_int (args2, "intTest", 0) != -3 ||
+      sc_keyvalue_get_double (args2, "doubleTest", 0.) != 2.5 ||
+      strcmp (sc_keyvalue_get_string (args2, "stringTest", ""), dummy) ||
+      sc_keyvalue_exists (args2, "pointerTest")) {
+    SC_VERBOSE ("Test failure on pack\n");
+    num_failed_tests++;
+  }
+  sc_keyvalue_destroy (args2);
+  args2 = sc_keyvalue_new ();
+  sc_keyvalue_set_double (args2, "intTest", 1.);
+  position = 0;
+  if (sc_keyvalue_unpack (args2, buffer, &position) != -1) {
+    SC_VERBOSE ("Test failure on unpack type\n");
+    num_failed_tests++;
+  }
+  sc_keyvalue_destroy (args2);
+  sc_array_destroy (buffer);
+
   /* Shutdown procedures */
   sc_finalize ();
 
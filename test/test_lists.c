@@ -0,0 +1,205 @@
+/*
+  This file is part of the SC Library.
+  The SC Library provides support for parallel scientific applications.
+
+  Copyright (C) 2010 The University of Texas System
+  Additional copyright (C) 2011 individual authors
+
+  The SC Library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  The SC Library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with the SC Library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+  02110-1301, USA.
+*/
+
+#include <sc_lists.h>
+
+#define TEST_LISTS_COUNT 1000
+
+typedef struct test_item
+{
+  long                value;
+  sc_ilink_t          link;
+}
+test_item_t;
+
+/* check the values of an intrusive list in both directions */
+static void
+test_ilist_verify (sc_ilist_t * list, long first, long step)
+{
+  size_t              iz;
+  sc_ilink_t         *link;
+
+  iz = 0;
+  for (link = sc_ilist_first (list); link != NULL;
+       link = sc_ilist_next (list, link), ++iz) {
+    SC_CHECK_ABORT (SC_ILIST_ENTRY (link, test_item_t, link)->value ==
+                    first + (long) iz * step, "Intrusive forward");
+  }
+  SC_CHECK_ABORT (iz == list->elem_count, "Intrusive count");
+  for (link = sc_ilist_last (list); link != NULL;
+       link = sc_ilist_prev (list, link)) {
+    --iz;
+    SC_CHECK_ABORT (SC_ILIST_ENTRY (link, test_item_t, link)->value ==
+                    first + (long) iz * step, "Intrusive backward");
+  }
+}
+
+static void
+test_ilist (void)
+{
+  long                l;
+  test_item_t        *items;
+  sc_ilink_t         *link;
+  sc_ilist_t          list, other;
+
+  items = SC_ALLOC (test_item_t, TEST_LISTS_COUNT);
+  for (l = 0; l < TEST_LISTS_COUNT; ++l) {
+    items[l].value = l;
+  }
+
+  /* append the even and prepend the odd values */
+  sc_ilist_init (&list);
+  sc_ilist_init (&other);
+  SC_CHECK_ABORT (sc_ilist_first (&list) == NULL &&
+                  sc_ilist_pop (&list) == NULL, "Intrusive empty");
+  for (l = 0; l < TEST_LISTS_COUNT; l += 2) {
+    sc_ilist_append (&list, &items[l].link);
+    sc_ilist_prepend (&other, &items[TEST_LISTS_COUNT - 1 - l].link);
+  }
+  test_ilist_verify (&list, 0, 2);
+  test_ilist_verify (&other, 1, 2);
+
+  /* remove the odd values in the middle of the list one by one */
+  while (other.elem_count > 0) {
+    link = sc_ilist_pop (&other);
+    l = SC_ILIST_ENTRY (link, test_item_t, link)->value;
+    sc_ilist_insert (&list, &items[l - 1].link, link);
+  }
+  test_ilist_verify (&list, 0, 1);
+  test_ilist_verify (&other, 0, 1);
+  for (l = 1; l < TEST_LISTS_COUNT; l += 2) {
+    sc_ilist_remove (&list, &items[l].link);
+    sc_ilist_append (&other, &items[l].link);
+  }
+  test_ilist_verify (&list, 0, 2);
+  test_ilist_verify (&other, 1, 2);
+
+  /* concatenate in constant time */
+  sc_ilist_concat (&list, &other);
+  SC_CHECK_ABORT (list.elem_count == TEST_LISTS_COUNT &&
+                  other.elem_count == 0 && sc_ilist_first (&other) == NULL,
+                  "Intrusive concat");
+  link = sc_ilist_last (&list);
+  SC_CHECK_ABORT (SC_ILIST_ENTRY (link, test_item_t, link)->value ==
+                  TEST_LISTS_COUNT - 1, "Intrusive concat last");
+  sc_ilist_concat (&list, &other);
+  SC_CHECK_ABORT (list.elem_count == TEST_LISTS_COUNT, "Concat empty");
+
+  SC_FREE (items);
+}
+
+/* check the values of an unrolled list by traversal */
+static void
+test_ulist_verify (sc_ulist_t * list, long first)
+{
+  size_t              iz;
+  long               *elem;
+  sc_ulist_iter_t     iter;
+
+  iz = 0;
+  for (elem = (long *) sc_ulist_iter_first (list, &iter); elem != NULL;
+       elem = (long *) sc_ulist_iter_next (list, &iter), ++iz) {
+    SC_CHECK_ABORT (*elem == first + (long) iz, "Unrolled traversal");
+  }
+  SC_CHECK_ABORT (iz == list->elem_count, "Unrolled count");
+  SC_CHECK_ABORT (list->node_count <=
+                  (list->elem_count + 2 * list->node_elems - 2) /
+                  list->node_elems + 1, "Unrolled node count");
+}
+
+static void
+test_ulist (size_t node_elems)
+{
+  long                l, value, *stable;
+  sc_ulist_t         *list;
+
+  list = sc_ulist_new (sizeof (long), node_elems);
+  SC_CHECK_ABORT (sc_ulist_front (list) == NULL &&
+                  sc_ulist_back (list) == NULL, "Unrolled empty");
+  test_ulist_verify (list, 0);
+
+  /* grow at both ends while pointers stay valid */
+  stable = (long *) sc_ulist_push_back (list);
+  *stable = 0;
+  for (l = 1; l < TEST_LISTS_COUNT; ++l) {
+    *(long *) sc_ulist_push_back (list) = l;
+    *(long *) sc_ulist_push_front (list) = -l;
+  }
+  SC_CHECK_ABORT (*stable == 0, "Unrolled stable");
+  SC_CHECK_ABORT (*(long *) sc_ulist_front (list) == 1 - TEST_LISTS_COUNT &&
+                  *(long *) sc_ulist_back (list) == TEST_LISTS_COUNT - 1,
+                  "Unrolled ends");
+  test_ulist_verify (list, 1 - TEST_LISTS_COUNT);
+
+  /* use the list as a queue */
+  for (l = 1 - TEST_LISTS_COUNT; l < 0; ++l) {
+    sc_ulist_pop_front (list, &value);
+    SC_CHECK_ABORT (value == l, "Unrolled pop front");
+    *(long *) sc_ulist_push_back (list) = 2 * TEST_LISTS_COUNT - 1 + l;
+  }
+  test_ulist_verify (list, 0);
+  for (l = 2 * TEST_LISTS_COUNT - 2; l >= TEST_LISTS_COUNT / 2; --l) {
+    sc_ulist_pop_back (list, &value);
+    SC_CHECK_ABORT (value == l, "Unrolled pop back");
+  }
+  test_ulist_verify (list, 0);
+  while (list->elem_count > 0) {
+    sc_ulist_pop_back (list, NULL);
+  }
+  SC_CHECK_ABORT (list->node_count == 0 && list->first == NULL &&
+                  list->last == NULL, "Unrolled drained");
+
+  /* truncating keeps the memory for reuse */
+  for (l = 0; l < TEST_LISTS_COUNT; ++l) {
+    *(long *) sc_ulist_push_front (list) = -l;
+  }
+  sc_ulist_truncate (list);
+  SC_CHECK_ABORT (list->elem_count == 0 && list->node_count == 0,
+                  "Unrolled truncate");
+  SC_CHECK_ABORT (sc_ulist_memory_used (list, 1) > sizeof (sc_ulist_t),
+                  "Unrolled memory");
+  sc_ulist_destroy (list);
+}
+
+int
+main (int argc, char **argv)
+{
+  int                 mpiret;
+
+  mpiret = sc_MPI_Init (&argc, &argv);
+  SC_CHECK_MPI (mpiret);
+
+  sc_init (sc_MPI_COMM_WORLD, 1, 1, NULL, SC_LP_DEFAULT);
+
+  test_ilist ();
+  test_ulist (0);
+  test_ulist (1);
+  test_ulist (7);
+
+  sc_finalize ();
+
+  mpiret = sc_MPI_Finalize ();
+  SC_CHECK_MPI (mpiret);
+
+  return 0;
+}
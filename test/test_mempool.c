@@ -0,0 +1,254 @@
+/*
+  This file is part of the SC Library.
+  The SC Library provides support for parallel scientific applications.
+
+  Copyright (C) 2010 The University of Texas System
+  Additional copyright (C) 2011 individual authors
+
+  The SC Library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  The SC Library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with the SC Library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+  02110-1301, USA.
+*/
+
+#include <sc_containers.h>
+#ifdef SC_ENABLE_PTHREAD
+#include <pthread.h>
+#endif
+
+#define TEST_MEMPOOL_THREADS 4
+
+typedef struct test_mempool_thread
+{
+  int                 id;
+  int                 num_elems;
+  sc_mempool_concurrent_t *mempool;
+  size_t           ***elems;    /* one array of elements per thread */
+}
+test_mempool_thread_t;
+
+/* allocate elements and mark them with a unique number */
+static void        *
+test_mempool_alloc (void *v)
+{
+  test_mempool_thread_t *td = (test_mempool_thread_t *) v;
+  sc_mempool_cache_t *cache;
+  size_t             *e;
+  int                 i, j;
+
+  cache = sc_mempool_cache_new (td->mempool);
+  for (j = 0; j < 3; ++j) {
+    /* exercise the exchange of magazines with the depot */
+    for (i = 0; i < td->num_elems; ++i) {
+      td->elems[td->id][i] = e = (size_t *) sc_mempool_cache_alloc (cache);
+      *e = (size_t) td->id * td->num_elems + i;
+    }
+    if (j < 2) {
+      for (i = 0; i < td->num_elems; ++i) {
+        SC_CHECK_ABORT (*td->elems[td->id][i] ==
+                        (size_t) td->id * td->num_elems + i, "Overlap");
+        sc_mempool_cache_free (cache, td->elems[td->id][i]);
+      }
+    }
+  }
+  sc_mempool_cache_destroy (cache);
+
+  return NULL;
+}
+
+/* free the elements allocated by the next thread */
+static void        *
+test_mempool_free (void *v)
+{
+  test_mempool_thread_t *td = (test_mempool_thread_t *) v;
+  sc_mempool_cache_t *cache;
+  const int           other = (td->id + 1) % TEST_MEMPOOL_THREADS;
+  int                 i;
+
+  cache = sc_mempool_cache_new (td->mempool);
+  for (i = 0; i < td->num_elems; ++i) {
+    SC_CHECK_ABORT (*td->elems[other][i] ==
+                    (size_t) other * td->num_elems + i, "Element content");
+    sc_mempool_cache_free (cache, td->elems[other][i]);
+  }
+  sc_mempool_cache_destroy (cache);
+
+  return NULL;
+}
+
+static void
+test_mempool_run (test_mempool_thread_t * td, void *(*fn) (void *))
+{
+  int                 t;
+#ifdef SC_ENABLE_PTHREAD
+  pthread_t           threads[TEST_MEMPOOL_THREADS];
+
+  for (t = 0; t < TEST_MEMPOOL_THREADS; ++t) {
+    SC_CHECK_ABORT (!pthread_create (&threads[t], NULL, fn, &td[t]),
+                    "Thread creation");
+  }
+  for (t = 0; t < TEST_MEMPOOL_THREADS; ++t) {
+    SC_CHECK_ABORT (!pthread_join (threads[t], NULL), "Thread join");
+  }
+#else
+  for (t = 0; t < TEST_MEMPOOL_THREADS; ++t) {
+    (void) fn (&td[t]);
+  }
+#endif
+}
+
+static void
+test_mempool_trim (void)
+{
+  const size_t        n = 100000;
+  size_t              zz, before, released;
+  size_t            **elems;
+  sc_mempool_t       *mempool;
+
+  /* free every element except those of every 5000th index */
+  mempool = sc_mempool_new (sizeof (size_t));
+  elems = SC_ALLOC (size_t *, n);
+  for (zz = 0; zz < n; ++zz) {
+    elems[zz] = (size_t *) sc_mempool_alloc (mempool);
+    *elems[zz] = zz;
+  }
+  before = sc_mstamp_memory_used (&mempool->mstamp);
+  for (zz = 0; zz < n; ++zz) {
+    if (zz % 5000 != 0) {
+      sc_mempool_free (mempool, elems[zz]);
+    }
+  }
+  released = sc_mempool_trim (mempool);
+  SC_CHECK_ABORT (released > before / 2 &&
+                  sc_mstamp_memory_used (&mempool->mstamp) < before / 2,
+                  "Mempool trim released");
+  SC_CHECK_ABORT (sc_mempool_trim (mempool) == 0, "Mempool trim twice");
+
+  /* the live elements keep their values and freed ones are reused */
+  for (zz = 0; zz < n; zz += 5000) {
+    SC_CHECK_ABORT (*elems[zz] == zz, "Mempool trim value");
+  }
+  for (zz = 0; zz < n; ++zz) {
+    if (zz % 5000 != 0) {
+      elems[zz] = (size_t *) sc_mempool_alloc (mempool);
+      *elems[zz] = zz;
+    }
+  }
+  for (zz = 0; zz < n; ++zz) {
+    SC_CHECK_ABORT (*elems[zz] == zz, "Mempool trim reuse");
+  }
+  SC_CHECK_ABORT (mempool->elem_count == n, "Mempool trim count");
+
+  /* the automatic trim keeps the memory proportional to the live count */
+  sc_mempool_set_trim (mempool, .5);
+  for (zz = 0; zz < n; ++zz) {
+    if (zz % 5000 != 0) {
+      sc_mempool_free (mempool, elems[zz]);
+    }
+  }
+  SC_CHECK_ABORT (sc_mstamp_memory_used (&mempool->mstamp) < before / 2,
+                  "Mempool automatic trim");
+  for (zz = 0; zz < n; zz += 5000) {
+    sc_mempool_free (mempool, elems[zz]);
+  }
+  SC_FREE (elems);
+  sc_mempool_destroy (mempool);
+}
+
+static void
+test_mempool_aligned (void)
+{
+  const size_t        n = 10000;
+  size_t              zz, align;
+  char              **elems;
+  sc_mempool_t       *mempool;
+
+  /* every element begins at the alignment and is padded to it */
+  elems = SC_ALLOC (char *, n);
+  for (align = 1; align <= 256; align *= 4) {
+    mempool = sc_mempool_new_aligned (20, align, align == 256 ? 1 << 21 : 0);
+    for (zz = 0; zz < n; ++zz) {
+      elems[zz] = (char *) sc_mempool_alloc (mempool);
+      SC_CHECK_ABORT ((uintptr_t) elems[zz] % align == 0,
+                      "Mempool element alignment");
+      memset (elems[zz], (int) zz, 20);
+    }
+    SC_CHECK_ABORT (mempool->mstamp.elem_size ==
+                    SC_ALIGN_UP ((size_t) 20, align), "Mempool padding");
+    if (align == 256) {
+      SC_CHECK_ABORT ((uintptr_t) mempool->mstamp.current %
+                      ((size_t) 1 << 21) == 0, "Mempool stamp alignment");
+    }
+    for (zz = 0; zz < n; ++zz) {
+      SC_CHECK_ABORT (elems[zz][19] == (char) zz, "Mempool aligned value");
+      sc_mempool_free (mempool, elems[zz]);
+    }
+    sc_mempool_trim (mempool);
+    sc_mempool_truncate (mempool);
+    SC_CHECK_ABORT ((uintptr_t) sc_mempool_alloc (mempool) % align == 0,
+                    "Mempool truncate alignment");
+    sc_mempool_destroy (mempool);
+  }
+  SC_FREE (elems);
+}
+
+int
+main (int argc, char **argv)
+{
+  const int           num_elems = 10000;
+  int                 mpiret;
+  int                 t;
+  double              start;
+  size_t            **elems[TEST_MEMPOOL_THREADS];
+  sc_mempool_concurrent_t *mempool;
+  test_mempool_thread_t td[TEST_MEMPOOL_THREADS];
+
+  mpiret = sc_MPI_Init (&argc, &argv);
+  SC_CHECK_MPI (mpiret);
+
+  sc_init (sc_MPI_COMM_WORLD, 1, 1, NULL, SC_LP_DEFAULT);
+
+  test_mempool_trim ();
+  test_mempool_aligned ();
+
+  mempool = sc_mempool_concurrent_new (sizeof (size_t));
+  for (t = 0; t < TEST_MEMPOOL_THREADS; ++t) {
+    elems[t] = SC_ALLOC (size_t *, num_elems);
+    td[t].id = t;
+    td[t].num_elems = num_elems;
+    td[t].mempool = mempool;
+    td[t].elems = elems;
+  }
+
+  start = sc_MPI_Wtime ();
+  test_mempool_run (td, test_mempool_alloc);
+  SC_CHECK_ABORT (sc_mempool_concurrent_elem_count (mempool) ==
+                  (size_t) TEST_MEMPOOL_THREADS * num_elems, "Alloc count");
+  test_mempool_run (td, test_mempool_free);
+  SC_CHECK_ABORT (sc_mempool_concurrent_elem_count (mempool) == 0,
+                  "Free count");
+  SC_GLOBAL_STATISTICSF ("Concurrent mempool time %g memory %llu\n",
+                         sc_MPI_Wtime () - start, (unsigned long long)
+                         sc_mempool_concurrent_memory_used (mempool));
+
+  for (t = 0; t < TEST_MEMPOOL_THREADS; ++t) {
+    SC_FREE (elems[t]);
+  }
+  sc_mempool_concurrent_destroy (mempool);
+  sc_finalize ();
+
+  mpiret = sc_MPI_Finalize ();
+  SC_CHECK_MPI (mpiret);
+
+  return 0;
+}
@@ -0,0 +1,137 @@
+/*
+  This file is part of the SC Library.
+  The SC Library provides support for parallel scientific applications.
+
+  Copyright (C) 2010 The University of Texas System
+  Additional copyright (C) 2011 individual authors
+
+  The SC Library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  The SC Library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with the SC Library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+  02110-1301, USA.
+*/
+
+#include <sc_morton.h>
+#include <sc_random.h>
+
+#define TEST_MORTON_COUNT 10000
+
+/* draw 64 random bits */
+static uint64_t
+test_morton_bits (sc_rand_state_t * state)
+{
+  return (uint64_t) (sc_rand (state) * 4294967296.) << 32 |
+    (uint64_t) (sc_rand (state) * 4294967296.);
+}
+
+int
+main (int argc, char **argv)
+{
+  int                 mpiret;
+  int                 i, dim;
+  uint32_t            x32, y32, z32;
+  uint64_t            c[3], d[3], key64;
+  double              start;
+  sc_uint128_t        key, ref;
+  sc_rand_state_t     state = 7;
+  sc_array_t         *coords, *keys, *back;
+
+  mpiret = sc_MPI_Init (&argc, &argv);
+  SC_CHECK_MPI (mpiret);
+
+  sc_init (sc_MPI_COMM_WORLD, 1, 1, NULL, SC_LP_DEFAULT);
+  SC_GLOBAL_INFOF ("Using %s\n", sc_morton_kernel ());
+
+  /* all kernels agree with the bitwise reference and invert */
+  for (i = 0; i < TEST_MORTON_COUNT; ++i) {
+    c[0] = test_morton_bits (&state);
+    c[1] = test_morton_bits (&state);
+    c[2] = test_morton_bits (&state);
+
+    sc_uint128_interleave (c, 2, 32, &ref);
+    key64 = sc_morton_encode2 ((uint32_t) c[0], (uint32_t) c[1]);
+    SC_CHECK_ABORT (ref.high_bits == 0 && ref.low_bits == key64,
+                    "Morton encode2");
+    sc_morton_decode2 (key64, &x32, &y32);
+    SC_CHECK_ABORT (x32 == (uint32_t) c[0] && y32 == (uint32_t) c[1],
+                    "Morton decode2");
+
+    sc_uint128_interleave (c, 3, 21, &ref);
+    key64 = sc_morton_encode3 ((uint32_t) c[0], (uint32_t) c[1],
+                               (uint32_t) c[2]);
+    SC_CHECK_ABORT (ref.high_bits == 0 && ref.low_bits == key64,
+                    "Morton encode3");
+    sc_morton_decode3 (key64, &x32, &y32, &z32);
+    SC_CHECK_ABORT (x32 == (c[0] & 0x1fffff) && y32 == (c[1] & 0x1fffff) &&
+                    z32 == (c[2] & 0x1fffff), "Morton decode3");
+
+    sc_uint128_interleave (c, 2, 64, &ref);
+    sc_morton_encode2_128 (c[0], c[1], &key);
+    SC_CHECK_ABORT (sc_uint128_is_equal (&key, &ref), "Morton encode2 128");
+    sc_morton_decode2_128 (&key, &d[0], &d[1]);
+    SC_CHECK_ABORT (d[0] == c[0] && d[1] == c[1], "Morton decode2 128");
+
+    c[0] &= 0x3ffffffffffULL;
+    c[1] &= 0x3ffffffffffULL;
+    c[2] &= 0x3ffffffffffULL;
+    sc_uint128_interleave (c, 3, 42, &ref);
+    sc_morton_encode3_128 (c[0], c[1], c[2], &key);
+    SC_CHECK_ABORT (sc_uint128_is_equal (&key, &ref), "Morton encode3 128");
+    sc_morton_decode3_128 (&key, &d[0], &d[1], &d[2]);
+    SC_CHECK_ABORT (d[0] == c[0] && d[1] == c[1] && d[2] == c[2],
+                    "Morton decode3 128");
+  }
+
+  /* the array variants round trip and are timed */
+  for (dim = 2; dim <= 3; ++dim) {
+    coords = sc_array_new_count (dim * sizeof (uint32_t), TEST_MORTON_COUNT);
+    for (i = 0; i < dim * TEST_MORTON_COUNT; ++i) {
+      ((uint32_t *) coords->array)[i] =
+        (uint32_t) test_morton_bits (&state) & (dim == 2 ? 0xffffffffU :
+                                                0x1fffffU);
+    }
+    keys = sc_array_new (sizeof (uint64_t));
+    back = sc_array_new (dim * sizeof (uint32_t));
+    start = sc_MPI_Wtime ();
+    sc_morton_encode_array (coords, dim, keys);
+    sc_morton_decode_array (keys, dim, back);
+    SC_GLOBAL_INFOF ("Morton %dD round trip of %d keys took %g\n", dim,
+                     TEST_MORTON_COUNT, sc_MPI_Wtime () - start);
+    SC_CHECK_ABORT (sc_array_is_equal (coords, back), "Morton array");
+    sc_array_destroy (back);
+    sc_array_destroy (keys);
+    sc_array_destroy (coords);
+
+    coords = sc_array_new_count (dim * sizeof (uint64_t), TEST_MORTON_COUNT);
+    for (i = 0; i < dim * TEST_MORTON_COUNT; ++i) {
+      ((uint64_t *) coords->array)[i] =
+        test_morton_bits (&state) & (dim == 2 ? ~(uint64_t) 0 :
+                                     0x3ffffffffffULL);
+    }
+    keys = sc_array_new (sizeof (sc_uint128_t));
+    back = sc_array_new (dim * sizeof (uint64_t));
+    sc_morton_encode_array_128 (coords, dim, keys);
+    sc_morton_decode_array_128 (keys, dim, back);
+    SC_CHECK_ABORT (sc_array_is_equal (coords, back), "Morton array 128");
+    sc_array_destroy (back);
+    sc_array_destroy (keys);
+    sc_array_destroy (coords);
+  }
+
+  sc_finalize ();
+
+  mpiret = sc_MPI_Finalize ();
+  SC_CHECK_MPI (mpiret);
+
+  return 0;
+}
@@ -38,7 +38,7 @@ test_shmem (int count, sc_MPI_Comm comm, sc_shmem_type_t type)
 {
   int                 i, p, size, mpiret, check;
   long int           *myval, *recv_self, *recv_shmem, *scan_self, *scan_shmem,
-    *copy_shmem;
+    *copy_shmem, *recv_node;
 
   sc_shmem_set_type (comm, type);
 
@@ -96,12 +96,205 @@ test_shmem (int count, sc_MPI_Comm comm, sc_shmem_type_t type)
   }
   SC_SHMEM_FREE (scan_shmem, comm);
 
+  recv_node = SC_ALLOC (long int, count * size);
+  sc_shmem_node_allgather (myval, count, sc_MPI_LONG,
+                           recv_node, count, sc_MPI_LONG, comm);
+  check = memcmp (recv_self, recv_node, count * sizeof (long int) * size);
+  if (check) {
+    SC_GLOBAL_LERROR ("sc_shmem_node_allgather mismatch\n");
+    return 3;
+  }
+  sc_shmem_node_allreduce (myval, recv_node, count, sc_MPI_LONG,
+                           sc_MPI_SUM, comm);
+  check = memcmp (scan_self + count * size, recv_node,
+                  count * sizeof (long int));
+  if (check) {
+    SC_GLOBAL_LERROR ("sc_shmem_node_allreduce mismatch\n");
+    return 3;
+  }
+  SC_FREE (recv_node);
+
   SC_FREE (scan_self);
   SC_FREE (recv_self);
   SC_FREE (myval);
   return 0;
 }
 
+int
+test_shmem_array (sc_MPI_Comm comm, int double_buffered)
+{
+  int                 rank, size, mpiret;
+  size_t              i;
+  long int            slice[3];
+  const long int     *array;
+  sc_shmem_array_t   *sarr;
+
+  mpiret = sc_MPI_Comm_size (comm, &size);
+  SC_CHECK_MPI (mpiret);
+  mpiret = sc_MPI_Comm_rank (comm, &rank);
+  SC_CHECK_MPI (mpiret);
+
+  /* every process writes its own slice */
+  sarr = sc_shmem_array_new (comm, sizeof (long int), 3 * size,
+                             double_buffered);
+  for (i = 0; i < 3; i++) {
+    slice[i] = 10 * rank + i + 1;
+  }
+  sc_shmem_array_write (sarr, 3 * rank, 3, slice);
+  if (double_buffered) {
+    array = (const long int *) sc_shmem_array_read (sarr);
+    if (array[3 * rank] != 0) {
+      SC_GLOBAL_LERROR ("sc_shmem_array read before commit mismatch\n");
+      return 1;
+    }
+  }
+  sc_shmem_array_commit (sarr);
+  array = (const long int *) sc_shmem_array_read (sarr);
+  for (i = 0; i < 3 * (size_t) size; i++) {
+    if (array[i] != (long int) (10 * (i / 3) + i % 3 + 1)) {
+      SC_GLOBAL_LERROR ("sc_shmem_array commit mismatch\n");
+      return 1;
+    }
+  }
+
+  /* the last process updates a slice of the first one */
+  if (!double_buffered) {
+    /* without a second version, reading must be done before writing */
+    mpiret = sc_MPI_Barrier (comm);
+    SC_CHECK_MPI (mpiret);
+  }
+  slice[0] = slice[1] = -1;
+  if (rank == size - 1) {
+    sc_shmem_array_write (sarr, 1, 2, slice);
+  }
+  sc_shmem_array_commit (sarr);
+  sc_shmem_array_commit (sarr);
+  array = (const long int *) sc_shmem_array_read (sarr);
+  for (i = 0; i < 3 * (size_t) size; i++) {
+    if (array[i] != (i == 1 || i == 2 ? -1 :
+                     (long int) (10 * (i / 3) + i % 3 + 1))) {
+      SC_GLOBAL_LERROR ("sc_shmem_array update mismatch\n");
+      return 1;
+    }
+  }
+  sc_shmem_array_destroy (sarr);
+  return 0;
+}
+
+int
+test_shmem_allgatherv (sc_MPI_Comm comm)
+{
+  int                 rank, size, mpiret, q;
+  size_t              i;
+  const int          *array;
+  sc_array_t         *send, *offsets;
+  sc_shmem_array_t   *sarr;
+
+  mpiret = sc_MPI_Comm_size (comm, &size);
+  SC_CHECK_MPI (mpiret);
+  mpiret = sc_MPI_Comm_rank (comm, &rank);
+  SC_CHECK_MPI (mpiret);
+
+  /* process q contributes q elements */
+  send = sc_array_new_count (sizeof (int), (size_t) rank);
+  for (i = 0; i < (size_t) rank; i++) {
+    *(int *) sc_array_index (send, i) = 100 * rank + (int) i;
+  }
+  offsets = sc_array_new (sizeof (size_t));
+  sarr = sc_shmem_array_allgatherv (send, offsets, comm);
+  array = (const int *) sc_shmem_array_read (sarr);
+  for (q = 0; q < size; q++) {
+    if (*(size_t *) sc_array_index_int (offsets, q) !=
+        (size_t) q * (q - 1) / 2) {
+      SC_GLOBAL_LERROR ("sc_shmem_array_allgatherv offset mismatch\n");
+      return 1;
+    }
+    for (i = 0; i < (size_t) q; i++) {
+      if (array[(size_t) q * (q - 1) / 2 + i] != 100 * q + (int) i) {
+        SC_GLOBAL_LERROR ("sc_shmem_array_allgatherv mismatch\n");
+        return 1;
+      }
+    }
+  }
+  sc_shmem_array_destroy (sarr);
+  sc_array_destroy (offsets);
+  sc_array_destroy (send);
+  return 0;
+}
+
+int
+test_levels (sc_MPI_Comm comm)
+{
+  int                 mpiret, level, rank, above, intrasize, intersize;
+  sc_MPI_Comm         intra, inter, intranode, internode;
+
+  sc_mpi_comm_get_node_comms (comm, &intranode, &internode);
+  if (intranode == sc_MPI_COMM_NULL) {
+    return 0;
+  }
+  sc_mpi_comm_get_level_comms (comm, SC_MPI_LEVEL_NODE, &intra, &inter);
+  if (intra != intranode || inter != internode) {
+    SC_LERROR ("sc_mpi node level mismatch\n");
+    return 1;
+  }
+
+  /* each domain is part of the one above */
+  mpiret = sc_MPI_Comm_size (intranode, &above);
+  SC_CHECK_MPI (mpiret);
+  for (level = SC_MPI_LEVEL_SOCKET; level < SC_MPI_NUM_LEVELS; ++level) {
+    sc_mpi_comm_get_level_comms (comm, (sc_mpi_level_t) level,
+                                 &intra, &inter);
+    SC_CHECK_ABORT (intra != sc_MPI_COMM_NULL &&
+                    inter != sc_MPI_COMM_NULL, "sc_mpi level missing");
+    mpiret = sc_MPI_Comm_size (intra, &intrasize);
+    SC_CHECK_MPI (mpiret);
+    mpiret = sc_MPI_Comm_size (inter, &intersize);
+    SC_CHECK_MPI (mpiret);
+    mpiret = sc_MPI_Comm_rank (intra, &rank);
+    SC_CHECK_MPI (mpiret);
+    if (intrasize > above || intersize > above || rank >= intrasize) {
+      SC_LERROR ("sc_mpi level size mismatch\n");
+      return 1;
+    }
+    SC_GLOBAL_PRODUCTIONF ("Level %d communicator size is %d\n",
+                           level, intrasize);
+    above = intrasize;
+  }
+  return 0;
+}
+
+/* Node communicators attached lazily are split on first use, also on a
+ * duplicate made before, and agree in size with those split eagerly. */
+int
+test_lazy (sc_MPI_Comm comm, int intrasize)
+{
+  int                 mpiret, lazysize, retval = 0;
+  sc_MPI_Comm         dup, intranode, internode;
+
+  sc_mpi_comm_attach_node_comms_lazy (comm, 0);
+  mpiret = sc_MPI_Comm_dup (comm, &dup);
+  SC_CHECK_MPI (mpiret);
+
+  sc_mpi_comm_get_node_comms (comm, &intranode, &internode);
+  lazysize = 0;
+  if (intranode != sc_MPI_COMM_NULL) {
+    mpiret = sc_MPI_Comm_size (intranode, &lazysize);
+    SC_CHECK_MPI (mpiret);
+  }
+  if (lazysize != intrasize) {
+    SC_LERROR ("sc_mpi lazy node comm size mismatch\n");
+    retval = 1;
+  }
+  retval += test_levels (comm);
+  retval += test_levels (dup);
+  retval += test_shmem (1, dup, SC_SHMEM_BASIC);
+
+  mpiret = sc_MPI_Comm_free (&dup);
+  SC_CHECK_MPI (mpiret);
+  sc_mpi_comm_detach_node_comms (comm);
+  return retval;
+}
+
 int
 main (int argc, char **argv)
 {
@@ -122,6 +315,7 @@ main (int argc, char **argv)
   sc_init (mpicomm, 1, 1, NULL, SC_LP_DEFAULT);
   intrasize = sc_mpi_comm_get_and_attach (mpicomm);
   SC_GLOBAL_PRODUCTIONF ("Intra communicator size is %d\n", intrasize);
+  retval += test_levels (mpicomm);
 
   srandom (rank);
   for (itype = 0; itype < (int) SC_SHMEM_NUM_TYPES; itype++) {
@@ -132,6 +326,9 @@ main (int argc, char **argv)
       int                 retvalin = retval;
 
       SC_GLOBAL_PRODUCTIONF ("  count = %d\n", count);
+      /* the last count lets the node processes share the prefix scan */
+      sc_shmem_prefix_node_items = count == 3 ? 0 :
+        SC_SHMEM_PREFIX_NODE_ITEMS;
       retval += test_shmem (count, mpicomm, (sc_shmem_type_t) itype);
       if (retval != retvalin) {
         SC_GLOBAL_PRODUCTION ("    unsuccessful\n");
@@ -141,8 +338,33 @@ main (int argc, char **argv)
       }
     }
   }
+  retval += test_shmem_array (mpicomm, 0);
+  retval += test_shmem_array (mpicomm, 1);
+  retval += test_shmem_allgatherv (mpicomm);
+
+  SC_CHECK_ABORT (sc_shmem_set_type_probe (mpicomm, 3, 2) ==
+                  sc_shmem_get_type (mpicomm), "sc_shmem probe mismatch");
 
   sc_mpi_comm_detach_node_comms (mpicomm);
+
+  /* emulate two processes per node to involve the communication between
+   * the node roots */
+  if (size % 2 == 0) {
+    SC_GLOBAL_PRODUCTION ("Two processes per node\n");
+    sc_mpi_comm_attach_node_comms (mpicomm, 2);
+    retval += test_levels (mpicomm);
+    sc_shmem_prefix_node_items = 0;
+    for (itype = 0; itype < (int) SC_SHMEM_NUM_TYPES; itype++) {
+      retval += test_shmem (3, mpicomm, (sc_shmem_type_t) itype);
+    }
+    retval += test_shmem_array (mpicomm, 0);
+    retval += test_shmem_array (mpicomm, 1);
+    retval += test_shmem_allgatherv (mpicomm);
+    sc_mpi_comm_detach_node_comms (mpicomm);
+    sc_shmem_prefix_node_items = SC_SHMEM_PREFIX_NODE_ITEMS;
+  }
+  retval += test_lazy (mpicomm, intrasize);
+
   sc_finalize ();
 
   mpiret = sc_MPI_Finalize ();
@@ -21,7 +21,9 @@
   02110-1301, USA.
 */
 
+#include <sc_flops.h>
 #include <sc_notify.h>
+#include <sc_ranges.h>
 #include <sc_statistics.h>
 
 /** Remove duplicates from an array of non-decreasing non-negative integers */
@@ -102,6 +104,228 @@ compute_superset_trivial (sc_array_t * receivers,
   }
 }
 
+#ifdef SC_ENABLE_MPI
+
+/* count the callbacks executed by the superset notify */
+static void
+compute_superset_counted (sc_array_t * receivers,
+                          sc_array_t * extra_receivers,
+                          sc_array_t * super_senders, sc_notify_t * notify,
+                          void *ctx)
+{
+  ++*(int *) ctx;
+  compute_superset_trivial (receivers, extra_receivers, super_senders,
+                            notify, NULL);
+}
+
+/* reuse the superset over calls with different receivers */
+static void
+test_superset_cache (sc_MPI_Comm mpicomm)
+{
+  int                 mpiret;
+  int                 mpisize, mpirank;
+  int                 i, k, num_r, num_s, num_calls;
+  int                *receivers, *senders;
+  sc_array_t         *rec, *snd;
+  sc_notify_t        *notify;
+
+  mpiret = sc_MPI_Comm_size (mpicomm, &mpisize);
+  SC_CHECK_MPI (mpiret);
+  mpiret = sc_MPI_Comm_rank (mpicomm, &mpirank);
+  SC_CHECK_MPI (mpiret);
+
+  notify = sc_notify_new (mpicomm);
+  sc_notify_set_type (notify, SC_NOTIFY_SUPERSET);
+  num_calls = 0;
+  sc_notify_superset_set_callback (notify, compute_superset_counted,
+                                   &num_calls);
+  sc_notify_superset_set_cache (notify, 1);
+  SC_CHECK_ABORT (sc_notify_superset_get_cache (notify), "Superset cache");
+
+  receivers = SC_ALLOC (int, mpisize);
+  senders = SC_ALLOC (int, mpisize);
+  for (k = 0; k < 4; ++k) {
+    if (k == 3) {
+      sc_notify_superset_invalidate (notify);
+    }
+    num_r = 0;
+    for (i = 0; i < mpisize; ++i) {
+      if ((i + mpirank + k) % 3 == 0) {
+        receivers[num_r++] = i;
+      }
+    }
+    mpiret = sc_notify_allgather (receivers, num_r, senders, &num_s,
+                                  mpicomm);
+    SC_CHECK_MPI (mpiret);
+
+    rec = sc_array_new_data (receivers, sizeof (int), num_r);
+    snd = sc_array_new (sizeof (int));
+    sc_notify_payload (rec, snd, NULL, NULL, 1, notify);
+    SC_CHECK_ABORT ((int) snd->elem_count == num_s,
+                    "Mismatch superset sender count");
+    for (i = 0; i < num_s; ++i) {
+      SC_CHECK_ABORTF (*(int *) sc_array_index_int (snd, i) == senders[i],
+                       "Mismatch superset sender %d", i);
+    }
+    sc_array_destroy (rec);
+    sc_array_destroy (snd);
+  }
+  SC_CHECK_ABORT (num_calls == 2, "Mismatch superset callback count");
+
+  SC_FREE (senders);
+  SC_FREE (receivers);
+  sc_notify_destroy (notify);
+}
+
+#endif /* SC_ENABLE_MPI */
+
+/* compare the scalable senders with those of the global ranges */
+static void
+test_ranges_senders (sc_MPI_Comm mpicomm, const int *receivers,
+                     int num_receivers)
+{
+  const int           num_ranges = 3;
+  int                 mpiret;
+  int                 mpisize, mpirank;
+  int                 i, maxpeers, maxwin;
+  int                 ranges[2 * 3];
+  int                 num_r, num_s;
+  int                *procs, *global_ranges, *ranks;
+  sc_array_t          senders;
+
+  mpiret = sc_MPI_Comm_size (mpicomm, &mpisize);
+  SC_CHECK_MPI (mpiret);
+  mpiret = sc_MPI_Comm_rank (mpicomm, &mpirank);
+  SC_CHECK_MPI (mpiret);
+
+  procs = SC_ALLOC_ZERO (int, mpisize);
+  maxpeers = mpisize;
+  maxwin = -1;
+  for (i = 0; i < num_receivers; ++i) {
+    if (receivers[i] != mpirank) {
+      procs[receivers[i]] = 1;
+      maxpeers = SC_MIN (maxpeers, receivers[i]);
+      maxwin = SC_MAX (maxwin, receivers[i]);
+    }
+  }
+  (void) sc_ranges_adaptive (sc_package_id, mpicomm, procs, &maxpeers,
+                             &maxwin, num_ranges, ranges, &global_ranges);
+  ranks = SC_ALLOC (int, 2 * mpisize);
+  sc_ranges_decode (mpisize, mpirank, maxwin, global_ranges,
+                    &num_r, ranks, &num_s, ranks + mpisize);
+
+  sc_array_init (&senders, sizeof (int));
+  sc_ranges_senders (mpicomm, num_ranges, ranges, &senders);
+  SC_CHECK_ABORT ((int) senders.elem_count == num_s,
+                  "Mismatch ranges sender count");
+  for (i = 0; i < num_s; ++i) {
+    SC_CHECK_ABORTF (*(int *) sc_array_index_int (&senders, i) ==
+                     ranks[mpisize + i], "Mismatch ranges sender %d", i);
+  }
+
+  sc_array_reset (&senders);
+  SC_FREE (ranks);
+  SC_FREE (global_ranges);
+  SC_FREE (procs);
+}
+
+/* dense patterns send their sender lists by runs of consecutive ranks */
+static void
+test_dense_senders (sc_MPI_Comm mpicomm, int gap)
+{
+  int                 mpiret;
+  int                 mpisize, mpirank;
+  int                 i, num_r, num_s, num_expected;
+  int                *receivers, *senders;
+  sc_array_t         *rec, *snd;
+
+  mpiret = sc_MPI_Comm_size (mpicomm, &mpisize);
+  SC_CHECK_MPI (mpiret);
+  mpiret = sc_MPI_Comm_rank (mpicomm, &mpirank);
+  SC_CHECK_MPI (mpiret);
+
+  /* send to every rank except those at multiples of the gap */
+  receivers = SC_ALLOC (int, mpisize);
+  num_r = 0;
+  for (i = 0; i < mpisize; ++i) {
+    if ((i + mpirank) % gap != 0) {
+      receivers[num_r++] = i;
+    }
+  }
+  num_expected = num_r;
+
+  senders = SC_ALLOC (int, mpisize);
+  mpiret = sc_notify (receivers, num_r, senders, &num_s, mpicomm);
+  SC_CHECK_MPI (mpiret);
+  SC_CHECK_ABORT (num_s == num_expected, "Mismatch dense sender count");
+  for (i = 0; i < num_s; ++i) {
+    SC_CHECK_ABORTF (senders[i] == receivers[i], "Mismatch dense sender %d",
+                     i);
+  }
+
+  rec = sc_array_new_data (receivers, sizeof (int), num_r);
+  snd = sc_array_new (sizeof (int));
+  sc_notify_nary (rec, snd, NULL, NULL, mpicomm);
+  SC_CHECK_ABORT ((int) snd->elem_count == num_expected,
+                  "Mismatch dense nary sender count");
+  for (i = 0; i < num_expected; ++i) {
+    SC_CHECK_ABORTF (*(int *) sc_array_index_int (snd, i) == receivers[i],
+                     "Mismatch dense nary sender %d", i);
+  }
+  sc_array_destroy (rec);
+  sc_array_destroy (snd);
+
+  SC_FREE (senders);
+  SC_FREE (receivers);
+}
+
+/* count the occurrences of a string in a text */
+static int
+test_trace_count (const char *text, const char *key)
+{
+  int                 n = 0;
+
+  for (; (text = strstr (text, key)) != NULL; ++text) {
+    ++n;
+  }
+  return n;
+}
+
+/* the regions of a written trace must begin and end in pairs */
+static void
+test_trace_write (sc_MPI_Comm mpicomm, int mpirank)
+{
+  const char         *filename = "sc_test_notify.trace.json";
+  const char         *header = "{\"traceEvents\":[";
+  int                 num_begin;
+  long                length;
+  char               *text;
+  FILE               *file;
+
+  SC_CHECK_ABORT (sc_flops_trace_write (mpicomm, filename) ==
+                  sc_MPI_SUCCESS, "Trace write");
+  if (mpirank == 0) {
+    file = fopen (filename, "rb");
+    SC_CHECK_ABORT (file != NULL && !fseek (file, 0, SEEK_END) &&
+                    (length = ftell (file)) > 0 &&
+                    !fseek (file, 0, SEEK_SET), "Trace open");
+    text = SC_ALLOC (char, length + 1);
+    SC_CHECK_ABORT (fread (text, 1, length, file) == (size_t) length,
+                    "Trace read");
+    text[length] = '\0';
+    fclose (file);
+    remove (filename);
+
+    SC_CHECK_ABORT (!strncmp (text, header, strlen (header)),
+                    "Trace header");
+    num_begin = test_trace_count (text, "\"ph\":\"B\"");
+    SC_CHECK_ABORT (num_begin > 0 &&
+                    num_begin == test_trace_count (text, "\"ph\":\"E\""),
+                    "Trace pairs");
+    SC_FREE (text);
+  }
+}
+
 int
 main (int argc, char **argv)
 {
@@ -127,7 +351,10 @@ main (int argc, char **argv)
     *outpay5, *inoff5, *outoff5;
   sc_statinfo_t       stats[3 * SC_NOTIFY_NUM_TYPES + 2];
   sc_notify_t        *notify;
+  sc_notify_plan_t   *plan;
+  sc_notify_graph_t  *graph;
   char                namep[SC_NOTIFY_NUM_TYPES][2][BUFSIZ];
+  int                 own_trace;
 
   mpiret = sc_MPI_Init (&argc, &argv);
   SC_CHECK_MPI (mpiret);
@@ -139,6 +366,15 @@ main (int argc, char **argv)
 
   sc_init (mpicomm, 1, 1, NULL, SC_LP_DEFAULT);
 
+  /* record the communication and report it at sc_finalize */
+  sc_mpi_profile_enable (10);
+
+  /* record the notify regions unless the environment does */
+  own_trace = !sc_flops_trace_is_active ();
+  if (own_trace) {
+    sc_flops_trace_start (0);
+  }
+
   /* grap parameters for notify_nary from command line */
   ntop = sc_notify_nary_ntop_default;
   nint = sc_notify_nary_nint_default;
@@ -199,6 +435,20 @@ main (int argc, char **argv)
     SC_CHECK_ABORTF (senders1[i] == senders3[i], "Mismatch 13 sender %d", i);
   }
 
+  SC_GLOBAL_INFO ("Testing sc_ranges_senders\n");
+  sc_flops_trace_begin ("test_ranges_senders");
+  test_ranges_senders (mpicomm, receivers, num_receivers);
+  sc_flops_trace_end ("test_ranges_senders");
+
+  SC_GLOBAL_INFO ("Testing dense sender patterns\n");
+  test_dense_senders (mpicomm, 4);
+  test_dense_senders (mpicomm, mpisize + 1);
+
+#ifdef SC_ENABLE_MPI
+  SC_GLOBAL_INFO ("Testing the superset cache\n");
+  test_superset_cache (mpicomm);
+#endif
+
   for (j = 0; j < SC_NOTIFY_NUM_TYPES; j++) {
     const char         *name = sc_notify_type_strings[j];
 
@@ -229,6 +479,11 @@ main (int argc, char **argv)
       sc_notify_superset_set_callback (notify, compute_superset_trivial,
                                        NULL);
     }
+    if (j == SC_NOTIFY_HIERARCHICAL) {
+      /* pretend that pairs of processes share a node if possible */
+      sc_mpi_comm_attach_node_comms (mpicomm, mpisize % 2 ? 1 : 2);
+      sc_notify_hierarchical_set_type (notify, SC_NOTIFY_BINARY);
+    }
     rec2 = sc_array_new_data (receivers, sizeof (int), num_receivers);
     snd2 = sc_array_new (sizeof (int));
     mpiret = sc_MPI_Barrier (mpicomm);
@@ -290,6 +545,9 @@ main (int argc, char **argv)
     sc_stats_set1 (stats + 3 * j + 2, elapsed_paylv, namep[j][1]);
 
     sc_notify_destroy (notify);
+    if (j == SC_NOTIFY_HIERARCHICAL) {
+      sc_mpi_comm_detach_node_comms (mpicomm);
+    }
 
     SC_CHECK_ABORT (num_senders1 == num_senders2, "Mismatch 12 sender count");
     SC_CHECK_ABORT (num_senders1 == num_senders4, "Mismatch 14 sender count");
@@ -322,14 +580,218 @@ main (int argc, char **argv)
     sc_array_destroy (outoff5);
   }
 
+  /* the autotuned controller times a candidate on each call */
+  SC_GLOBAL_INFO ("Testing sc_notify_payload auto selection\n");
+  sc_notify_auto_clear_cache ();
+  for (k = 0; k < 2; ++k) {
+    notify = sc_notify_new (mpicomm);
+    sc_notify_set_type (notify, SC_NOTIFY_AUTO);
+    for (j = 0; j < 2 * SC_NOTIFY_NUM_TYPES; ++j) {
+      rec4 = sc_array_new_count (sizeof (int), num_receivers);
+      pay4 = sc_array_new_count (sizeof (int), num_receivers);
+      for (i = 0; i < num_receivers; ++i) {
+        *(int *) sc_array_index_int (rec4, i) = receivers[i];
+        *(int *) sc_array_index_int (pay4, i) = 2 * mpirank + 3;
+      }
+      sc_notify_payload (rec4, NULL, pay4, NULL, 1, notify);
+      SC_CHECK_ABORT ((int) rec4->elem_count == num_senders1,
+                      "Mismatch auto sender count");
+      for (i = 0; i < num_senders1; ++i) {
+        SC_CHECK_ABORTF (*(int *) sc_array_index_int (rec4, i) ==
+                         senders1[i], "Mismatch auto sender %d", i);
+        SC_CHECK_ABORTF (*(int *) sc_array_index_int (pay4, i) ==
+                         2 * senders1[i] + 3, "Mismatch auto payload %d", i);
+      }
+      sc_array_destroy (rec4);
+      sc_array_destroy (pay4);
+
+      /* a second controller finds the choice in the cache */
+      SC_CHECK_ABORT (k == 0 || sc_notify_auto_get_type
+                      (notify, NULL, NULL, NULL) != SC_NOTIFY_AUTO,
+                      "Auto choice not cached");
+    }
+    SC_CHECK_ABORT (sc_notify_auto_get_type (notify, &ntop, &nint, &nbot)
+                    != SC_NOTIFY_AUTO, "Auto choice not made");
+    sc_notify_destroy (notify);
+  }
+
+  /* repeated exchanges through a plan change the pattern once */
+  SC_GLOBAL_INFO ("Testing sc_notify_plan_exchange\n");
+  notify = sc_notify_new (mpicomm);
+  plan = sc_notify_plan_new (notify);
+  rec2 = sc_array_new (sizeof (int));
+  snd2 = sc_array_new (sizeof (int));
+  pay4 = sc_array_new (sizeof (int));
+  outpay5 = sc_array_new (sizeof (int));
+  for (k = 0; k < 4; ++k) {
+    sc_array_truncate (rec2);
+    if (k < 2) {
+      for (i = 0; i < num_receivers; ++i) {
+        *(int *) sc_array_push (rec2) = receivers[i];
+      }
+    }
+    else {
+      /* every process sends to itself and to its successor */
+      *(int *) sc_array_push (rec2) = mpirank;
+      if (mpisize > 1) {
+        *(int *) sc_array_push (rec2) = (mpirank + 1) % mpisize;
+        sc_array_sort (rec2, sc_int_compare);
+      }
+    }
+    sc_array_resize (pay4, rec2->elem_count);
+    for (i = 0; i < (int) rec2->elem_count; ++i) {
+      *(int *) sc_array_index_int (pay4, i) = 2 * mpirank + 3 + k;
+    }
+    sc_notify_plan_exchange (plan, rec2, snd2, pay4, outpay5);
+    senders2 = (int *) snd2->array;
+    num_senders2 = (int) snd2->elem_count;
+    if (k < 2) {
+      SC_CHECK_ABORT (num_senders1 == num_senders2,
+                      "Mismatch plan sender count");
+      for (i = 0; i < num_senders1; ++i) {
+        SC_CHECK_ABORTF (senders1[i] == senders2[i],
+                         "Mismatch plan sender %d", i);
+      }
+    }
+    else {
+      SC_CHECK_ABORT (num_senders2 == SC_MIN (mpisize, 2),
+                      "Mismatch plan changed sender count");
+      for (i = 0; i < num_senders2; ++i) {
+        SC_CHECK_ABORTF (senders2[i] == mpirank ||
+                         senders2[i] == (mpirank + mpisize - 1) % mpisize,
+                         "Mismatch plan changed sender %d", i);
+      }
+    }
+    for (i = 0; i < num_senders2; ++i) {
+      SC_CHECK_ABORTF (*(int *) sc_array_index_int (outpay5, i) ==
+                       2 * senders2[i] + 3 + k, "Mismatch plan payload %d",
+                       i);
+    }
+  }
+  sc_array_destroy (rec2);
+  sc_array_destroy (snd2);
+  sc_array_destroy (pay4);
+  sc_array_destroy (outpay5);
+  sc_notify_plan_destroy (plan);
+  sc_notify_destroy (notify);
+
+  /* a graph of the original pattern exchanges fixed and variable sizes */
+  SC_GLOBAL_INFO ("Testing sc_notify_graph_exchange\n");
+  rec2 = sc_array_new_data (receivers, sizeof (int), num_receivers);
+  snd2 = sc_array_new_data (senders1, sizeof (int), num_senders1);
+  graph = sc_notify_graph_new (mpicomm, rec2, snd2);
+  pay4 = sc_array_new_count (sizeof (int), num_receivers);
+  outpay5 = sc_array_new (sizeof (int));
+  for (i = 0; i < num_receivers; ++i) {
+    *(int *) sc_array_index_int (pay4, i) = 2 * mpirank + 3;
+  }
+  sc_notify_graph_exchange (graph, pay4, NULL, outpay5, NULL);
+  SC_CHECK_ABORT ((int) outpay5->elem_count == num_senders1,
+                  "Mismatch graph payload count");
+  for (i = 0; i < num_senders1; ++i) {
+    SC_CHECK_ABORTF (*(int *) sc_array_index_int (outpay5, i) ==
+                     2 * senders1[i] + 3, "Mismatch graph payload %d", i);
+  }
+  inpay5 = sc_array_new_count (sizeof (int), num_receivers * mpirank);
+  inoff5 = sc_array_new_count (sizeof (int), num_receivers + 1);
+  outoff5 = sc_array_new (sizeof (int));
+  *(int *) sc_array_index (inoff5, 0) = 0;
+  for (i = 0; i < num_receivers; ++i) {
+    *(int *) sc_array_index_int (inoff5, i + 1) = mpirank * (i + 1);
+    for (k = 0; k < mpirank; k++) {
+      *(int *) sc_array_index_int (inpay5, mpirank * i + k) =
+        3 * mpirank + 5;
+    }
+  }
+  sc_notify_graph_exchange (graph, inpay5, inoff5, outpay5, outoff5);
+  pay5 = (int *) outpay5->array;
+  off5 = (int *) outoff5->array;
+  SC_CHECK_ABORT ((int) outoff5->elem_count == num_senders1 + 1,
+                  "Mismatch graph offsets count");
+  for (i = 0; i < num_senders1; ++i) {
+    SC_CHECK_ABORTF (off5[i + 1] - off5[i] == senders1[i],
+                     "Mismatch graph payloadv size %d", i);
+    for (k = 0; k < senders1[i]; k++) {
+      SC_CHECK_ABORTF (pay5[off5[i] + k] == 3 * senders1[i] + 5,
+                       "Mismatch graph payloadv %d", i);
+    }
+  }
+  sc_notify_graph_destroy (graph);
+  sc_array_destroy (rec2);
+  sc_array_destroy (snd2);
+  sc_array_destroy (pay4);
+  sc_array_destroy (inpay5);
+  sc_array_destroy (inoff5);
+  sc_array_destroy (outpay5);
+  sc_array_destroy (outoff5);
+
+  /* messages are sent from and received into views without packing */
+  SC_GLOBAL_INFO ("Testing sc_notify_payloadv_views\n");
+  notify = sc_notify_new (mpicomm);
+  rec2 = sc_array_new_data (receivers, sizeof (int), num_receivers);
+  snd2 = sc_array_new (sizeof (int));
+  inpay5 = sc_array_new_count (sizeof (int), num_receivers * (mpisize + 3));
+  inoff5 = sc_array_new_count (sizeof (sc_array_t), num_receivers);
+  outpay5 = sc_array_new (sizeof (int));
+  outoff5 = sc_array_new (sizeof (sc_array_t));
+  for (i = 0; i < num_receivers; ++i) {
+    int                 count = mpirank % 3 + receivers[i] % 2;
+
+    sc_array_init_data ((sc_array_t *) sc_array_index_int (inoff5, i),
+                        sc_array_index_int (inpay5, i * (mpisize + 3)),
+                        sizeof (int), count);
+    for (k = 0; k < count; ++k) {
+      *(int *) sc_array_index_int (inpay5, i * (mpisize + 3) + k) =
+        1000 * mpirank + receivers[i];
+    }
+  }
+  sc_notify_payloadv_views (rec2, snd2, inoff5, outpay5, outoff5, 1, notify);
+  SC_CHECK_ABORT ((int) snd2->elem_count == num_senders1,
+                  "Mismatch views sender count");
+  for (j = 0, i = 0; i < num_senders1; ++i) {
+    sc_array_t         *view = (sc_array_t *) sc_array_index_int (outoff5, i);
+
+    SC_CHECK_ABORTF (*(int *) sc_array_index_int (snd2, i) == senders1[i],
+                     "Mismatch views sender %d", i);
+    SC_CHECK_ABORTF ((int) view->elem_count ==
+                     senders1[i] % 3 + mpirank % 2, "Mismatch views size %d",
+                     i);
+    SC_CHECK_ABORTF (view->elem_count == 0 ||
+                     view->array == sc_array_index_int (outpay5, j),
+                     "Mismatch views position %d", i);
+    for (k = 0; k < (int) view->elem_count; ++k) {
+      SC_CHECK_ABORTF (*(int *) sc_array_index_int (view, k) ==
+                       1000 * senders1[i] + mpirank,
+                       "Mismatch views payload %d", i);
+    }
+    j += (int) view->elem_count;
+  }
+  SC_CHECK_ABORT (j == (int) outpay5->elem_count, "Mismatch views total");
+  sc_array_destroy (rec2);
+  sc_array_destroy (snd2);
+  sc_array_destroy (inpay5);
+  sc_array_destroy (inoff5);
+  sc_array_destroy (outpay5);
+  sc_array_destroy (outoff5);
+  sc_notify_destroy (notify);
+
   SC_FREE (receivers);
   SC_FREE (senders1);
   SC_FREE (senders3);
 
+  /* every notify function leaves the module it has entered */
+  SC_CHECK_ABORT (sc_mpi_profile_get_caller () == SC_MPI_CALLER_USER,
+                  "Profile caller mismatch");
+
   sc_stats_compute (mpicomm, 3 * SC_NOTIFY_NUM_TYPES + 2, stats);
   sc_stats_print (sc_package_id, SC_LP_STATISTICS,
                   3 * SC_NOTIFY_NUM_TYPES + 2, stats, 1, 1);
 
+  if (own_trace) {
+    test_trace_write (mpicomm, mpirank);
+    sc_flops_trace_stop ();
+  }
+
   sc_finalize ();
 
   mpiret = sc_MPI_Finalize ();
@@ -0,0 +1,250 @@
+/*
+  This file is part of the SC Library.
+  The SC Library provides support for parallel scientific applications.
+
+  Copyright (C) 2010 The University of Texas System
+  Additional copyright (C) 2011 individual authors
+
+  The SC Library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  The SC Library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with the SC Library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+  02110-1301, USA.
+*/
+
+#include <sc_containers.h>
+
+typedef struct test_ohash_entry
+{
+  int                 key;
+  int                 value;
+}
+test_ohash_entry_t;
+
+static unsigned int
+test_ohash_hash (const void *v, const void *u)
+{
+  const test_ohash_entry_t *e = (const test_ohash_entry_t *) v;
+  uint32_t            a, b, c;
+
+  a = (uint32_t) e->key;
+  b = 0xdeadbeef;
+  c = 0;
+  sc_hash_mix (a, b, c);
+  sc_hash_final (a, b, c);
+
+  return (unsigned int) c;
+}
+
+static int
+test_ohash_equal (const void *v1, const void *v2, const void *u)
+{
+  return ((const test_ohash_entry_t *) v1)->key ==
+    ((const test_ohash_entry_t *) v2)->key;
+}
+
+static int
+test_ohash_count (void *v, const void *u)
+{
+  ++*(size_t *) u;
+  return 1;
+}
+
+static unsigned int
+test_ohash_constant (const void *v, const void *u)
+{
+  return 17;
+}
+
+/* identical hash values exceed the maximal probe distance */
+static void
+test_ohash_collisions (void)
+{
+  const int           num_keys = 1000;
+  int                 i, added;
+  size_t              counted;
+  void               *found;
+  test_ohash_entry_t  e, removed;
+  sc_ohash_t         *oh;
+
+  oh = sc_ohash_new (sizeof (test_ohash_entry_t), test_ohash_constant,
+                     test_ohash_equal, NULL);
+  for (i = 0; i < num_keys; ++i) {
+    e.key = i;
+    e.value = 3 * i;
+    added = sc_ohash_insert_unique (oh, &e, &found);
+    SC_CHECK_ABORT (added && ((test_ohash_entry_t *) found)->value == e.value,
+                    "Collision insert");
+  }
+  SC_CHECK_ABORT (oh->elem_count == (size_t) num_keys, "Collision count");
+  for (i = 0; i < num_keys; ++i) {
+    e.key = i;
+    SC_CHECK_ABORT (!sc_ohash_insert_unique (oh, &e, &found) &&
+                    ((test_ohash_entry_t *) found)->value == 3 * i,
+                    "Collision insert again");
+  }
+  counted = 0;
+  oh->user_data = &counted;
+  sc_ohash_foreach (oh, test_ohash_count);
+  oh->user_data = NULL;
+  SC_CHECK_ABORT (counted == oh->elem_count, "Collision foreach");
+  sc_ohash_print_statistics (sc_package_id, SC_LP_STATISTICS, oh);
+
+  /* remove from both the slots and the stash */
+  for (i = 0; i < num_keys; i += 2) {
+    e.key = i;
+    SC_CHECK_ABORT (sc_ohash_remove (oh, &e, &removed) &&
+                    removed.value == 3 * i, "Collision remove");
+  }
+  for (i = 0; i < num_keys; ++i) {
+    e.key = i;
+    SC_CHECK_ABORT (sc_ohash_lookup (oh, &e, &found) == (i % 2 == 1) &&
+                    (i % 2 == 0 ||
+                     ((test_ohash_entry_t *) found)->value == 3 * i),
+                    "Collision lookup");
+  }
+  sc_ohash_destroy (oh);
+}
+
+int
+main (int argc, char **argv)
+{
+  const int           num_keys = 50000;
+  const int           key_range = 80000;
+  int                 mpiret;
+  int                 i, added, oadded;
+  size_t              position, counted;
+  double              start, time_hash, time_ohash;
+  void               *found;
+  test_ohash_entry_t  e, removed, *fe;
+  test_ohash_entry_t *keys;
+  sc_hash_array_t    *ha;
+  sc_hash_t          *h;
+  sc_ohash_t         *oh;
+
+  mpiret = sc_MPI_Init (&argc, &argv);
+  SC_CHECK_MPI (mpiret);
+
+  sc_init (sc_MPI_COMM_WORLD, 1, 1, NULL, SC_LP_DEFAULT);
+
+  /* random keys with duplicates */
+  srand (12345);
+  keys = SC_ALLOC (test_ohash_entry_t, num_keys);
+  for (i = 0; i < num_keys; ++i) {
+    keys[i].key = rand () % key_range;
+    keys[i].value = i;
+  }
+
+  /* compare insertion and lookup against the chained hash array */
+  ha = sc_hash_array_new (sizeof (test_ohash_entry_t), test_ohash_hash,
+                          test_ohash_equal, NULL);
+  oh = sc_ohash_new (sizeof (test_ohash_entry_t), test_ohash_hash,
+                     test_ohash_equal, NULL);
+  for (i = 0; i < num_keys; ++i) {
+    found = sc_hash_array_insert_unique (ha, &keys[i], &position);
+    added = found != NULL;
+    if (added) {
+      *(test_ohash_entry_t *) found = keys[i];
+    }
+    oadded = sc_ohash_insert_unique (oh, &keys[i], &found);
+    SC_CHECK_ABORT (added == oadded, "Ohash insert mismatch");
+    fe = (test_ohash_entry_t *) found;
+    SC_CHECK_ABORT (fe->key == keys[i].key, "Ohash insert found");
+    SC_CHECK_ABORT (!oadded || fe->value == keys[i].value,
+                    "Ohash insert copy");
+  }
+  SC_CHECK_ABORT (oh->elem_count == ha->a.elem_count, "Ohash count");
+  counted = 0;
+  oh->user_data = &counted;
+  sc_ohash_foreach (oh, test_ohash_count);
+  oh->user_data = NULL;
+  SC_CHECK_ABORT (counted == oh->elem_count, "Ohash foreach");
+  sc_ohash_print_statistics (sc_package_id, SC_LP_STATISTICS, oh);
+
+  for (e.key = 0; e.key < key_range; ++e.key) {
+    added = sc_hash_array_lookup (ha, &e, &position);
+    oadded = sc_ohash_lookup (oh, &e, &found);
+    SC_CHECK_ABORT (added == oadded, "Ohash lookup mismatch");
+    if (oadded) {
+      SC_CHECK_ABORT (((test_ohash_entry_t *) found)->value ==
+                      ((test_ohash_entry_t *)
+                       sc_array_index (&ha->a, position))->value,
+                      "Ohash lookup value");
+    }
+  }
+
+  /* remove the even keys and verify the remaining contents */
+  for (e.key = 0; e.key < key_range; e.key += 2) {
+    added = sc_hash_array_lookup (ha, &e, &position);
+    removed.key = -1;
+    oadded = sc_ohash_remove (oh, &e, &removed);
+    SC_CHECK_ABORT (added == oadded, "Ohash remove mismatch");
+    SC_CHECK_ABORT (!oadded || removed.key == e.key, "Ohash remove copy");
+    SC_CHECK_ABORT (sc_ohash_remove (oh, &e, NULL) == 0, "Ohash remove");
+  }
+  for (e.key = 0; e.key < key_range; ++e.key) {
+    added = sc_hash_array_lookup (ha, &e, &position);
+    oadded = sc_ohash_lookup (oh, &e, NULL);
+    SC_CHECK_ABORT (oadded == (added && (e.key % 2 == 1)),
+                    "Ohash lookup after remove");
+  }
+  sc_hash_array_destroy (ha);
+
+  /* removing everything shrinks the table to its minimal size */
+  for (e.key = 0; e.key < key_range; ++e.key) {
+    (void) sc_ohash_remove (oh, &e, NULL);
+  }
+  SC_CHECK_ABORT (oh->elem_count == 0 && oh->slot_count == 16,
+                  "Ohash shrink");
+  sc_ohash_insert_unique (oh, &keys[0], NULL);
+  sc_ohash_truncate (oh);
+  SC_CHECK_ABORT (oh->elem_count == 0 && !sc_ohash_lookup (oh, &keys[0],
+                                                           NULL),
+                  "Ohash truncate");
+  sc_ohash_destroy (oh);
+  test_ohash_collisions ();
+
+  /* time the chained hash table against the open addressing one */
+  h = sc_hash_new (test_ohash_hash, test_ohash_equal, NULL, NULL);
+  start = sc_MPI_Wtime ();
+  for (i = 0; i < num_keys; ++i) {
+    (void) sc_hash_insert_unique (h, &keys[i], NULL);
+  }
+  for (i = 0; i < num_keys; ++i) {
+    SC_EXECUTE_ASSERT_TRUE (sc_hash_lookup (h, &keys[i], NULL));
+  }
+  time_hash = sc_MPI_Wtime () - start;
+  sc_hash_destroy (h);
+
+  oh = sc_ohash_new (sizeof (test_ohash_entry_t), test_ohash_hash,
+                     test_ohash_equal, NULL);
+  start = sc_MPI_Wtime ();
+  for (i = 0; i < num_keys; ++i) {
+    (void) sc_ohash_insert_unique (oh, &keys[i], NULL);
+  }
+  for (i = 0; i < num_keys; ++i) {
+    SC_EXECUTE_ASSERT_TRUE (sc_ohash_lookup (oh, &keys[i], NULL));
+  }
+  time_ohash = sc_MPI_Wtime () - start;
+  SC_GLOBAL_STATISTICSF ("Hash time %g ohash time %g memory %llu\n",
+                         time_hash, time_ohash,
+                         (unsigned long long) sc_ohash_memory_used (oh));
+  sc_ohash_destroy (oh);
+
+  SC_FREE (keys);
+  sc_finalize ();
+
+  mpiret = sc_MPI_Finalize ();
+  SC_CHECK_MPI (mpiret);
+
+  return 0;
+}
@@ -0,0 +1,281 @@
+/*
+  This file is part of the SC Library.
+  The SC Library provides support for parallel scientific applications.
+
+  Copyright (C) 2020 individual authors
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are met:
+
+  1. Redistributions of source code must retain the above copyright notice,
+  this list of conditions and the following disclaimer.
+
+  2. Redistributions in binary form must reproduce the above copyright notice,
+  this list of conditions and the following disclaimer in the documentation
+  and/or other materials provided with the distribution.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+  LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+  SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+  INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+  CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+  POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <sc_getopt.h>
+#include <sc_options.h>
+
+static int
+test_options_broadcast (sc_MPI_Comm mpicomm)
+{
+  int                 num_failed_tests = 0;
+  int                 mpiret, mpirank;
+  int                 ivalue, bvalue, retval;
+  size_t              zvalue;
+  double              dvalue;
+  const char         *svalue;
+  char               *argv[7];
+  sc_options_t       *opt;
+
+  mpiret = sc_MPI_Comm_rank (mpicomm, &mpirank);
+  SC_CHECK_MPI (mpiret);
+
+  opt = sc_options_new ("test_options");
+  sc_options_add_int (opt, 'i', "int", &ivalue, 1, "Integer");
+  sc_options_add_bool (opt, 'b', "bool", &bvalue, 0, "Boolean");
+  sc_options_add_size_t (opt, 'z', NULL, &zvalue, 2, "Size");
+  sc_options_add_double (opt, '\0', "double", &dvalue, 3., "Double");
+  sc_options_add_string (opt, 's', "string", &svalue, NULL, "String");
+
+  /* only the root parses and the others receive its values */
+  retval = 0;
+  if (mpirank == 0) {
+    argv[0] = (char *) "test_options";
+    argv[1] = (char *) "-i7";
+    argv[2] = (char *) "-b";
+    argv[3] = (char *) "-z";
+    argv[4] = (char *) "9";
+    argv[5] = (char *) "--double=0.5";
+    argv[6] = (char *) "--string=value";
+    optind = 0;
+    retval = sc_options_parse (sc_package_id, SC_LP_INFO, opt, 7, argv);
+  }
+  if (sc_options_broadcast (opt, mpicomm, 0, &retval) != 0 ||
+      retval != 7 || ivalue != 7 || !bvalue || zvalue != 9 ||
+      dvalue != .5 || svalue == NULL || strcmp (svalue, "value")) {
+    SC_LERROR ("options broadcast\n");
+    ++num_failed_tests;
+  }
+  sc_options_destroy (opt);
+
+  return num_failed_tests;
+}
+
+static int
+test_options_pack (void)
+{
+  int                 num_failed_tests = 0;
+  int                 ivalue, ivalue2;
+  double              dvalue, dvalue2;
+  const char         *svalue, *svalue2;
+  size_t              position;
+  sc_array_t         *buffer;
+  sc_options_t       *opt, *opt2;
+
+  opt = sc_options_new ("test_options");
+  sc_options_add_int (opt, 'i', "int", &ivalue, 4, "Integer");
+  sc_options_add_double (opt, 'd', "double", &dvalue, .25, "Double");
+  sc_options_add_string (opt, 's', "string", &svalue, "packed", "String");
+  opt2 = sc_options_new ("test_options");
+  sc_options_add_int (opt2, 'i', "int", &ivalue2, 0, "Integer");
+  sc_options_add_double (opt2, 'd', "double", &dvalue2, 0., "Double");
+  sc_options_add_string (opt2, 's', "string", &svalue2, NULL, "String");
+
+  /* the values follow other data in the buffer */
+  buffer = sc_array_new (1);
+  *(char *) sc_array_push (buffer) = 'x';
+  sc_options_pack (opt, buffer);
+  position = 1;
+  if (sc_options_unpack (opt2, buffer, &position) != 0 ||
+      position != buffer->elem_count || ivalue2 != 4 || dvalue2 != .25 ||
+      svalue2 == NULL || strcmp (svalue2, "packed")) {
+    SC_LERROR ("options pack\n");
+    ++num_failed_tests;
+  }
+
+  /* a truncated buffer is an error */
+  position = 1;
+  sc_array_resize (buffer, buffer->elem_count - 1);
+  if (sc_options_unpack (opt2, buffer, &position) != -1) {
+    SC_LERROR ("options unpack truncated\n");
+    ++num_failed_tests;
+  }
+  sc_array_destroy (buffer);
+  sc_options_destroy (opt);
+  sc_options_destroy (opt2);
+
+  return num_failed_tests;
+}
+
+static int
+test_options_collective (sc_MPI_Comm mpicomm)
+{
+  int                 num_failed_tests = 0;
+  int                 mpiret, mpirank;
+  int                 ivalue, retval;
+  double              dvalue;
+  const char         *filename = "test_options_options.ini";
+  char               *argv[2];
+  FILE               *file;
+  sc_options_t       *opt;
+
+  mpiret = sc_MPI_Comm_rank (mpicomm, &mpirank);
+  SC_CHECK_MPI (mpiret);
+
+  if (mpirank == 0) {
+    file = fopen (filename, "w");
+    SC_CHECK_ABORT (file != NULL, "Open options file");
+    fprintf (file, "[Options]\nint = 5\n\n[Sub]\ndouble = 2.5\n");
+    SC_CHECK_ABORT (fclose (file) == 0, "Close options file");
+  }
+
+  opt = sc_options_new ("test_options");
+  sc_options_add_int (opt, 'i', "int", &ivalue, 1, "Integer");
+  sc_options_add_double (opt, '\0', "Sub:double", &dvalue, 3., "Double");
+  sc_options_add_inifile (opt, '\0', "ini", "Ini file");
+
+  /* the file is only read by the first process */
+  retval = sc_options_load_ini_collective (sc_package_id, SC_LP_INFO, opt,
+                                           filename, mpicomm);
+  if (retval != 0 || ivalue != 5 || dvalue != 2.5) {
+    SC_LERROR ("options load collective\n");
+    ++num_failed_tests;
+  }
+  if (sc_options_load_ini_collective (sc_package_id, SC_LP_INFO, opt,
+                                      "test_options_missing.ini",
+                                      mpicomm) != -1) {
+    SC_LERROR ("options load collective missing\n");
+    ++num_failed_tests;
+  }
+
+  /* the file option of the command line reads collectively too */
+  ivalue = 0;
+  dvalue = 0.;
+  sc_options_set_collective (opt, mpicomm);
+  argv[0] = (char *) "test_options";
+  argv[1] = (char *) "--ini=test_options_options.ini";
+  optind = 0;
+  retval = sc_options_parse (sc_package_id, SC_LP_INFO, opt, 2, argv);
+  if (retval != 2 || ivalue != 5 || dvalue != 2.5) {
+    SC_LERROR ("options parse collective\n");
+    ++num_failed_tests;
+  }
+  sc_options_destroy (opt);
+
+  mpiret = sc_MPI_Barrier (mpicomm);
+  SC_CHECK_MPI (mpiret);
+  if (mpirank == 0) {
+    remove (filename);
+  }
+
+  return num_failed_tests;
+}
+
+static int
+test_options_buffer (void)
+{
+  int                 num_failed_tests = 0;
+  int                 ivalue, bvalue, retval;
+  double              dvalue;
+  size_t              zvalue;
+  const char         *svalue, *tvalue;
+  const char         *text =
+    "; a comment\n"
+    "# another comment\n"
+    "[ OPTIONS ]\n"
+    "  Int = 7 ; trailing comment\n"
+    "-b = yes\n"
+    "size = 12\\\n"
+    "34\n"
+    "string = \"quoted ; kept\"\n"
+    "empty = ''\n"
+    "int = 8\n"
+    "[Sub]\n"
+    "DOUBLE=0.25";
+  sc_options_t       *opt;
+
+  opt = sc_options_new ("test_options");
+  sc_options_add_int (opt, 'i', "int", &ivalue, 1, "Integer");
+  sc_options_add_bool (opt, 'b', NULL, &bvalue, 0, "Boolean");
+  sc_options_add_size_t (opt, '\0', "size", &zvalue, 0, "Size");
+  sc_options_add_string (opt, '\0', "string", &svalue, NULL, "String");
+  sc_options_add_string (opt, '\0', "empty", &tvalue, "x", "Empty");
+  sc_options_add_double (opt, '\0', "Sub:double", &dvalue, 3., "Double");
+
+  /* keys are case insensitive and the last of duplicates wins */
+  retval = sc_options_load_ini_buffer (sc_package_id, SC_LP_INFO, opt,
+                                       text, strlen (text), "test");
+  if (retval != 0 || ivalue != 8 || !bvalue || zvalue != 1234 ||
+      svalue == NULL || strcmp (svalue, "quoted ; kept") ||
+      tvalue == NULL || tvalue[0] != '\0' || dvalue != .25) {
+    SC_LERROR ("options load buffer\n");
+    ++num_failed_tests;
+  }
+
+  /* a line without an equal sign is a syntax error */
+  text = "[Options]\nint = 9\nnonsense\n";
+  if (sc_options_load_ini_buffer (sc_package_id, SC_LP_INFO, opt,
+                                  text, strlen (text), NULL) != -1) {
+    SC_LERROR ("options load buffer syntax\n");
+    ++num_failed_tests;
+  }
+
+  /* the short and long key of one option are exclusive */
+  text = "[Options]\nint = 9\n-i = 10\n";
+  if (sc_options_load_ini_buffer (sc_package_id, SC_LP_INFO, opt,
+                                  text, strlen (text), NULL) != -1) {
+    SC_LERROR ("options load buffer duplicate\n");
+    ++num_failed_tests;
+  }
+  sc_options_destroy (opt);
+
+  return num_failed_tests;
+}
+
+int
+main (int argc, char **argv)
+{
+  int                 mpiret;
+  sc_MPI_Comm         mpicomm;
+  int                 num_failed_tests;
+
+  /* standard initialization */
+  mpiret = sc_MPI_Init (&argc, &argv);
+  SC_CHECK_MPI (mpiret);
+  mpicomm = sc_MPI_COMM_WORLD;
+
+  sc_init (mpicomm, 1, 1, NULL, SC_LP_DEFAULT);
+
+  num_failed_tests = 0;
+
+  /* test the broadcast of option values */
+  num_failed_tests += test_options_broadcast (mpicomm);
+  num_failed_tests += test_options_pack ();
+
+  /* test the collective loading of option files */
+  num_failed_tests += test_options_collective (mpicomm);
+  num_failed_tests += test_options_buffer ();
+
+  /* clean up and exit */
+  sc_finalize ();
+
+  mpiret = sc_MPI_Finalize ();
+  SC_CHECK_MPI (mpiret);
+
+  return num_failed_tests ? EXIT_FAILURE : EXIT_SUCCESS;
+}
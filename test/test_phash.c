@@ -0,0 +1,163 @@
+/*
+  This file is part of the SC Library.
+  The SC Library provides support for parallel scientific applications.
+
+  Copyright (C) 2010 The University of Texas System
+  Additional copyright (C) 2011 individual authors
+
+  The SC Library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  The SC Library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with the SC Library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+  02110-1301, USA.
+*/
+
+#include <sc_phash.h>
+
+#define TEST_PHASH_KEYS 100000
+
+/* a key of twelve bytes, which is not a multiple of its alignment */
+typedef struct test_phash_key
+{
+  uint32_t            w[3];
+}
+test_phash_key_t;
+
+/* every key is mapped to its own number */
+static void
+test_phash_verify (sc_phash_t * phash, sc_array_t * keys)
+{
+  size_t              iz, pos;
+  char               *seen;
+
+  SC_CHECK_ABORT (phash->num_keys == keys->elem_count &&
+                  phash->key_size == keys->elem_size, "Phash sizes");
+  seen = SC_ALLOC_ZERO (char, keys->elem_count);
+  for (iz = 0; iz < keys->elem_count; ++iz) {
+    pos = sc_phash_lookup (phash, sc_array_index (keys, iz));
+    SC_CHECK_ABORT (pos < keys->elem_count && !seen[pos], "Phash lookup");
+    seen[pos] = 1;
+  }
+  SC_FREE (seen);
+}
+
+/* write the perfect hash to a buffer and use it in place and copied */
+static void
+test_phash_io (sc_phash_t * phash, sc_array_t * keys)
+{
+  size_t              iz;
+  sc_array_t         *buffer, *shifted;
+  sc_io_sink_t       *sink;
+  sc_io_source_t     *source;
+  sc_phash_t         *view, *copy;
+
+  buffer = sc_array_new (1);
+  sink = sc_io_sink_new (SC_IO_TYPE_BUFFER, SC_IO_MODE_WRITE,
+                         SC_IO_ENCODE_NONE, buffer);
+  SC_CHECK_ABORT (sink != NULL, "Phash sink");
+  SC_CHECK_ABORT (!sc_phash_write (phash, sink), "Phash write");
+  SC_CHECK_ABORT (!sc_io_sink_destroy (sink), "Phash sink destroy");
+  SC_CHECK_ABORT (buffer->elem_count == phash->data_bytes, "Phash bytes");
+
+  /* the buffer is used in place */
+  source = sc_io_source_new (SC_IO_TYPE_BUFFER, SC_IO_ENCODE_NONE, buffer);
+  SC_CHECK_ABORT (source != NULL, "Phash source");
+  view = sc_phash_read (source);
+  SC_CHECK_ABORT (view != NULL && view->owned == NULL &&
+                  view->data == buffer->array, "Phash read in place");
+  for (iz = 0; iz < keys->elem_count; ++iz) {
+    SC_CHECK_ABORT (sc_phash_lookup (view, sc_array_index (keys, iz)) ==
+                    sc_phash_lookup (phash, sc_array_index (keys, iz)),
+                    "Phash view lookup");
+  }
+  sc_phash_destroy (view);
+  SC_CHECK_ABORT (!sc_io_source_destroy (source), "Phash source destroy");
+
+  /* a misaligned buffer is copied */
+  shifted = sc_array_new_count (1, buffer->elem_count + 1);
+  memcpy (shifted->array + 1, buffer->array, buffer->elem_count);
+  SC_CHECK_ABORT (sc_phash_new_view (shifted->array + 1,
+                                     buffer->elem_count) == NULL,
+                  "Phash view misaligned");
+  source = sc_io_source_new (SC_IO_TYPE_BUFFER, SC_IO_ENCODE_NONE, shifted);
+  SC_CHECK_ABORT (!sc_io_source_read (source, NULL, 1, NULL), "Phash skip");
+  copy = sc_phash_read (source);
+  SC_CHECK_ABORT (copy != NULL && copy->owned != NULL, "Phash read copy");
+  test_phash_verify (copy, keys);
+  sc_phash_destroy (copy);
+  SC_CHECK_ABORT (!sc_io_source_destroy (source), "Phash source destroy");
+
+  /* a truncated or corrupted block is rejected */
+  SC_CHECK_ABORT (sc_phash_new_view (buffer->array,
+                                     buffer->elem_count - 1) == NULL,
+                  "Phash view truncated");
+  buffer->array[16] ^= 1;
+  SC_CHECK_ABORT (sc_phash_new_view (buffer->array,
+                                     buffer->elem_count) == NULL,
+                  "Phash view byte order");
+
+  sc_array_destroy (shifted);
+  sc_array_destroy (buffer);
+}
+
+int
+main (int argc, char **argv)
+{
+  int                 mpiret;
+  size_t              iz, n;
+  double              bits;
+  test_phash_key_t   *key;
+  sc_array_t         *keys;
+  sc_phash_t         *phash;
+
+  mpiret = sc_MPI_Init (&argc, &argv);
+  SC_CHECK_MPI (mpiret);
+
+  sc_init (sc_MPI_COMM_WORLD, 1, 1, NULL, SC_LP_DEFAULT);
+
+  /* distinct keys with structure in the low and high words */
+  keys = sc_array_new (sizeof (test_phash_key_t));
+  for (n = 0; n <= TEST_PHASH_KEYS; n = n < 8 ? n + 1 : 10 * n) {
+    sc_array_resize (keys, n);
+    for (iz = 0; iz < n; ++iz) {
+      key = (test_phash_key_t *) sc_array_index (keys, iz);
+      key->w[0] = (uint32_t) iz;
+      key->w[1] = (uint32_t) (iz * 7);
+      key->w[2] = 0;
+    }
+    phash = sc_phash_new (keys);
+    SC_CHECK_ABORT (phash != NULL, "Phash new");
+    test_phash_verify (phash, keys);
+    if (n > 0) {
+      test_phash_io (phash, keys);
+    }
+    bits = 8. * (double) sc_phash_memory_used (phash) / (double) SC_MAX (n, 1);
+    SC_GLOBAL_STATISTICSF ("Perfect hash of %llu keys uses %.2f bits"
+                           " per key\n", (unsigned long long) n, bits);
+    SC_CHECK_ABORT (n < TEST_PHASH_KEYS || bits < 4., "Phash memory");
+    sc_phash_destroy (phash);
+  }
+
+  /* duplicate keys are rejected */
+  sc_array_resize (keys, 100);
+  *(test_phash_key_t *) sc_array_index (keys, 99) =
+    *(test_phash_key_t *) sc_array_index (keys, 17);
+  SC_CHECK_ABORT (sc_phash_new (keys) == NULL, "Phash duplicates");
+
+  sc_array_destroy (keys);
+  sc_finalize ();
+
+  mpiret = sc_MPI_Finalize ();
+  SC_CHECK_MPI (mpiret);
+
+  return 0;
+}
@@ -0,0 +1,172 @@
+/*
+  This file is part of the SC Library.
+  The SC Library provides support for parallel scientific applications.
+
+  Copyright (C) 2010 The University of Texas System
+  Additional copyright (C) 2011 individual authors
+
+  The SC Library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  The SC Library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with the SC Library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+  02110-1301, USA.
+*/
+
+#include <sc_polynom.h>
+
+static int
+test_polynom_eval (void)
+{
+  int                 num_failed_tests = 0;
+  int                 j;
+  size_t              k;
+  const int           degree = 6;
+  double              points[7], weights[7];
+  double              x[150], values[150], basis[150 * 7];
+  double              sum;
+  sc_polynom_t       *p;
+
+  /* Chebyshev-Lobatto points and arguments including all of them */
+  for (j = 0; j <= degree; ++j) {
+    points[j] = -cos (M_PI * j / degree);
+  }
+  for (k = 0; k < 150; ++k) {
+    x[k] = k < 7 ? points[k] : -1.2 + 2.4 * k / 149.;
+  }
+  sc_polynom_lagrange_weights (degree, points, weights);
+  sc_polynom_lagrange_eval (degree, points, weights, 150, x, basis);
+
+  for (j = 0; j <= degree; ++j) {
+    p = sc_polynom_new_lagrange (degree, j, points);
+    sc_polynom_eval_points (p, 150, x, values);
+    for (k = 0; k < 150; ++k) {
+      if (fabs (values[k] - sc_polynom_eval (p, x[k])) > 1e-13 ||
+          fabs (values[k] - basis[k * 7 + j]) > 1e-12 ||
+          (k < 7 && basis[k * 7 + j] != (k == (size_t) j ? 1. : 0.))) {
+        ++num_failed_tests;
+      }
+    }
+    sc_polynom_destroy (p);
+  }
+
+  /* the basis is a partition of one, also with internal weights */
+  sc_polynom_lagrange_eval (degree, points, NULL, 150, x, basis);
+  for (k = 0; k < 150; ++k) {
+    for (sum = 0., j = 0; j <= degree; ++j) {
+      sum += basis[k * 7 + j];
+    }
+    if (fabs (sum - 1.) > 1e-13) {
+      ++num_failed_tests;
+    }
+  }
+
+  if (num_failed_tests) {
+    SC_GLOBAL_LERRORF ("polynom eval %d mismatches\n", num_failed_tests);
+  }
+  return num_failed_tests;
+}
+
+static int
+test_polynom_arith (void)
+{
+  int                 num_failed_tests = 0;
+  int                 i, j;
+  const double        points[4] = { -1., -.5, .25, 1. };
+  double              x[16], u[16], v[16];
+  sc_polynom_t       *p, *q, *s, *t;
+
+  for (i = 0; i < 16; ++i) {
+    x[i] = -1. + i / 7.5;
+  }
+
+  /* grow a scratch polynomial by in-place products beyond small storage */
+  p = sc_polynom_new_constant (1.);
+  q = sc_polynom_new ();
+  s = sc_polynom_new ();
+  for (j = 0; j < 4; ++j) {
+    sc_polynom_set_lagrange (q, 3, j, points);
+    t = sc_polynom_new_lagrange (3, j, points);
+    sc_polynom_set_product (s, p, q);
+    sc_polynom_multiply (p, t);
+    sc_polynom_destroy (t);
+  }
+  sc_polynom_set_product (q, s, s);
+  sc_polynom_multiply (s, s);
+  if (sc_polynom_degree (p) != 12 || sc_polynom_degree (s) != 24 ||
+      sc_polynom_degree (q) != 24) {
+    ++num_failed_tests;
+  }
+  sc_polynom_eval_points (p, 16, x, u);
+  sc_polynom_eval_points (s, 16, x, v);
+  for (i = 0; i < 16; ++i) {
+    if (fabs (v[i] - u[i] * u[i]) > 1e-12 ||
+        fabs (sc_polynom_eval (q, x[i]) - v[i]) > 1e-12) {
+      ++num_failed_tests;
+    }
+  }
+
+  /* sums in place of either summand and shrinking reused storage */
+  sc_polynom_set_sum (q, q, s);
+  sc_polynom_set_sum (s, p, s);
+  sc_polynom_set_sum (q, q, q);
+  t = sc_polynom_new_from_sum (p, p);
+  for (i = 0; i < 16; ++i) {
+    if (fabs (sc_polynom_eval (q, x[i]) - 4. * v[i]) > 1e-12 ||
+        fabs (sc_polynom_eval (s, x[i]) - u[i] - v[i]) > 1e-12 ||
+        fabs (sc_polynom_eval (t, x[i]) - 2. * u[i]) > 1e-12) {
+      ++num_failed_tests;
+    }
+  }
+  sc_polynom_set_lagrange (q, 3, 0, points);
+  if (sc_polynom_degree (q) != 3 ||
+      fabs (sc_polynom_eval (q, -1.) - 1.) > 1e-12) {
+    ++num_failed_tests;
+  }
+
+  sc_polynom_destroy (p);
+  sc_polynom_destroy (q);
+  sc_polynom_destroy (s);
+  sc_polynom_destroy (t);
+  if (num_failed_tests) {
+    SC_GLOBAL_LERRORF ("polynom arith %d mismatches\n", num_failed_tests);
+  }
+  return num_failed_tests;
+}
+
+int
+main (int argc, char **argv)
+{
+  int                 mpiret;
+  sc_MPI_Comm         mpicomm;
+  int                 num_failed_tests;
+
+  /* standard initialization */
+  mpiret = sc_MPI_Init (&argc, &argv);
+  SC_CHECK_MPI (mpiret);
+  mpicomm = sc_MPI_COMM_WORLD;
+
+  sc_init (mpicomm, 1, 1, NULL, SC_LP_DEFAULT);
+
+  num_failed_tests = 0;
+
+  /* test the batched and barycentric polynomial evaluation */
+  num_failed_tests += test_polynom_eval ();
+  num_failed_tests += test_polynom_arith ();
+
+  /* clean up and exit */
+  sc_finalize ();
+
+  mpiret = sc_MPI_Finalize ();
+  SC_CHECK_MPI (mpiret);
+
+  return num_failed_tests ? EXIT_FAILURE : EXIT_SUCCESS;
+}
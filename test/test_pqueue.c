@@ -22,9 +22,13 @@
 */
 
 #include <sc_containers.h>
+#include <sc_pqueue.h>
 
 /* #define THEBIGTEST */
 
+/* sc_array_pqueue_add and sc_array_pqueue_pop are disabled and abort */
+/* #define TEST_ARRAY_PQUEUE */
+
 static int
 compar (const void *p1, const void *p2)
 {
@@ -34,32 +38,23 @@ compar (const void *p1, const void *p2)
   return i1 - i2;
 }
 
-int
-main (int argc, char **argv)
+#ifdef TEST_ARRAY_PQUEUE
+
+/* test the sc_array_pqueue functions and return the time taken */
+static double
+test_array_pqueue (int count)
 {
-  int                 i, i1, i2, i3, i3last, i4, i4last, temp, count;
+  int                 i, i1, i2, i3, i3last, temp;
   size_t              s, swaps1, swaps2, swaps3, total1, total2, total3;
   ssize_t             searched;
   int                *pi;
-  sc_array_t         *a1, *a2, *a3, *a4;
-  int                 mpiret;
-  double              start, elapsed_pqueue, elapsed_qsort;
-
-  mpiret = sc_MPI_Init (&argc, &argv);
-  SC_CHECK_MPI (mpiret);
-
-  sc_init (sc_MPI_COMM_WORLD, 1, 1, NULL, SC_LP_DEFAULT);
+  sc_array_t         *a1, *a2, *a3;
+  double              start;
 
   a1 = sc_array_new (sizeof (int));
   a2 = sc_array_new (sizeof (int));
   a3 = sc_array_new (sizeof (int));
-  a4 = sc_array_new (sizeof (int));
 
-#ifdef THEBIGTEST
-  count = 325323;
-#else
-  count = 3251;
-#endif
   SC_INFOF ("Test pqueue with count %d\n", count);
 
   start = -sc_MPI_Wtime ();
@@ -117,12 +112,158 @@ main (int argc, char **argv)
                (long long) swaps1, (long long) swaps2, (long long) swaps3,
                (long long) total1, (long long) total2, (long long) total3);
 
-  elapsed_pqueue = start + sc_MPI_Wtime ();
+  start += sc_MPI_Wtime ();
 
   sc_array_destroy (a1);
   sc_array_destroy (a2);
   sc_array_destroy (a3);
 
+  return start;
+}
+
+#endif /* TEST_ARRAY_PQUEUE */
+
+/* run random pushes, key changes, removals and pops against a reference */
+static void
+test_pqueue_handles (int arity)
+{
+  const int           n = 1000;
+  int                 i, value, last, *live, *alive;
+  size_t              h, count;
+  sc_pqueue_t        *pq;
+
+  live = SC_ALLOC (int, n);
+  alive = SC_ALLOC_ZERO (int, n);
+  pq = sc_pqueue_new (sizeof (int), arity, compar);
+  for (i = 0; i < n; ++i) {
+    value = rand () % 500;
+    h = sc_pqueue_push (pq, &value);
+    SC_CHECK_ABORT (h < (size_t) n && !alive[h], "pqueue handle");
+    live[h] = value;
+    alive[h] = 1;
+
+    /* decrease, increase or remove a random queued element */
+    h = (size_t) (rand () % n);
+    if (alive[h]) {
+      switch (rand () % 3) {
+      case 0:
+        live[h] -= rand () % 100;
+        sc_pqueue_update (pq, h, &live[h]);
+        break;
+      case 1:
+        *(int *) sc_pqueue_get (pq, h) += rand () % 100;
+        live[h] = *(int *) sc_pqueue_get (pq, h);
+        sc_pqueue_update (pq, h, NULL);
+        break;
+      default:
+        sc_pqueue_remove (pq, h, &value);
+        SC_CHECK_ABORT (value == live[h], "pqueue remove");
+        alive[h] = 0;
+      }
+    }
+  }
+
+  for (count = 0, i = 0; i < n; ++i) {
+    count += alive[i];
+  }
+  SC_CHECK_ABORT (sc_pqueue_count (pq) == count, "pqueue count");
+  last = -1000;
+  while (sc_pqueue_count (pq) > 0) {
+    SC_CHECK_ABORT (*(int *) sc_pqueue_top (pq, &h) == live[h],
+                    "pqueue top");
+    SC_CHECK_ABORT (sc_pqueue_pop (pq, &value) == h, "pqueue pop handle");
+    SC_CHECK_ABORT (alive[h] && value == live[h] && value >= last,
+                    "pqueue pop");
+    SC_CHECK_ABORT (!sc_pqueue_contains (pq, h), "pqueue contains");
+    alive[h] = 0;
+    last = value;
+  }
+  sc_pqueue_destroy (pq);
+
+  SC_FREE (live);
+  SC_FREE (alive);
+}
+
+/* time binary and 4-ary heaps against sorting */
+static void
+test_pqueue_bench (int count)
+{
+  int                 i, value, last, arity;
+  double              start, elapsed_sort, elapsed_push[2], elapsed_heapify;
+  sc_array_t         *a, *values;
+  sc_pqueue_t        *pq;
+
+  values = sc_array_new_count (sizeof (int), (size_t) count);
+  for (i = 0; i < count; ++i) {
+    *(int *) sc_array_index_int (values, i) = rand ();
+  }
+
+  /* sorting a copy is the baseline */
+  start = -sc_MPI_Wtime ();
+  a = sc_array_new (sizeof (int));
+  sc_array_copy (a, values);
+  sc_array_sort (a, compar);
+  sc_array_destroy (a);
+  elapsed_sort = start + sc_MPI_Wtime ();
+
+  for (arity = 2; arity <= 4; arity += 2) {
+    start = -sc_MPI_Wtime ();
+    pq = sc_pqueue_new (sizeof (int), arity, compar);
+    for (i = 0; i < count; ++i) {
+      sc_pqueue_push (pq, sc_array_index_int (values, i));
+    }
+    for (last = 0, i = 0; i < count; ++i) {
+      sc_pqueue_pop (pq, &value);
+      SC_CHECK_ABORT (value >= last, "pqueue bench");
+      last = value;
+    }
+    sc_pqueue_destroy (pq);
+    elapsed_push[arity / 2 - 1] = start + sc_MPI_Wtime ();
+  }
+
+  start = -sc_MPI_Wtime ();
+  pq = sc_pqueue_new_heapify (values, 0, compar);
+  for (last = 0, i = 0; i < count; ++i) {
+    SC_CHECK_ABORT (*(int *) sc_array_index_int (values, (int)
+                                                 sc_pqueue_pop (pq, &value))
+                    == value && value >= last, "pqueue heapify");
+    last = value;
+  }
+  sc_pqueue_destroy (pq);
+  elapsed_heapify = start + sc_MPI_Wtime ();
+
+  SC_STATISTICSF ("Test timings sort %g binary heap %g 4-ary heap %g"
+                  " heapify %g\n", elapsed_sort, elapsed_push[0],
+                  elapsed_push[1], elapsed_heapify);
+  sc_array_destroy (values);
+}
+
+int
+main (int argc, char **argv)
+{
+  int                 i, i4, i4last, count;
+  sc_array_t         *a4;
+  int                 mpiret;
+  double              start, elapsed_pqueue, elapsed_qsort;
+
+  mpiret = sc_MPI_Init (&argc, &argv);
+  SC_CHECK_MPI (mpiret);
+
+  sc_init (sc_MPI_COMM_WORLD, 1, 1, NULL, SC_LP_DEFAULT);
+
+  a4 = sc_array_new (sizeof (int));
+
+#ifdef THEBIGTEST
+  count = 325323;
+#else
+  count = 3251;
+#endif
+#ifdef TEST_ARRAY_PQUEUE
+  elapsed_pqueue = test_array_pqueue (count);
+#else
+  elapsed_pqueue = 0.;
+#endif
+
   SC_INFOF ("Test array sort with count %d\n", count);
 
   start = -sc_MPI_Wtime ();
@@ -147,6 +288,12 @@ main (int argc, char **argv)
                   elapsed_pqueue, 3. * elapsed_qsort);
 
   sc_array_destroy (a4);
+
+  for (i = 2; i <= 8; ++i) {
+    test_pqueue_handles (i);
+  }
+  test_pqueue_bench (count);
+
   sc_finalize ();
 
   mpiret = sc_MPI_Finalize ();
@@ -0,0 +1,149 @@
+/*
+  This file is part of the SC Library.
+  The SC Library provides support for parallel scientific applications.
+
+  Copyright (C) 2010 The University of Texas System
+  Additional copyright (C) 2011 individual authors
+
+  The SC Library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  The SC Library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with the SC Library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+  02110-1301, USA.
+*/
+
+#include <sc_progress.h>
+
+/* an operation that completes after a number of steps */
+static int
+test_progress_countdown (void *state)
+{
+  return --*(int *) state <= 0;
+}
+
+static void
+test_progress_steps (void)
+{
+  int                 count1 = 3, count2 = 1;
+  sc_progress_t      *progress;
+  sc_progress_op_t   *op1, *op2;
+
+  progress = sc_progress_new ();
+  op1 = sc_progress_start (progress, test_progress_countdown, NULL, &count1);
+  op2 = sc_progress_start (progress, test_progress_countdown, NULL, &count2);
+  SC_CHECK_ABORT (count1 == 2 && count2 == 0, "Progress start");
+  SC_CHECK_ABORT (sc_progress_test (progress, op2), "Progress complete");
+  SC_CHECK_ABORT (!sc_progress_test (progress, op1) && count1 == 1,
+                  "Progress test");
+  SC_CHECK_ABORT (sc_progress_poll (progress) == 0 && count1 == 0,
+                  "Progress poll");
+  sc_progress_wait (progress, op1);
+  sc_progress_wait (progress, op2);
+  sc_progress_destroy (progress);
+}
+
+/* notify two successors and overlap the sum of all ranks on a duplicate */
+static void
+test_progress_notify (sc_MPI_Comm mpicomm, int use_thread)
+{
+  int                 mpiret, mpisize, mpirank;
+  int                 i, r, sum, expected, work;
+  int                *pay;
+  sc_array_t         *receivers, *senders, *in_payload, *out_payload;
+  sc_MPI_Comm         dupcomm;
+  sc_progress_t      *progress;
+  sc_progress_op_t   *nop, *rop;
+
+  mpiret = sc_MPI_Comm_size (mpicomm, &mpisize);
+  SC_CHECK_MPI (mpiret);
+  mpiret = sc_MPI_Comm_rank (mpicomm, &mpirank);
+  SC_CHECK_MPI (mpiret);
+  mpiret = sc_MPI_Comm_dup (mpicomm, &dupcomm);
+  SC_CHECK_MPI (mpiret);
+
+  receivers = sc_array_new (sizeof (int));
+  senders = sc_array_new (sizeof (int));
+  in_payload = sc_array_new (sizeof (int));
+  out_payload = sc_array_new (sizeof (int));
+  for (i = 1; i <= 2; ++i) {
+    *(int *) sc_array_push (receivers) = (mpirank + i) % mpisize;
+  }
+  sc_array_sort (receivers, sc_int_compare);
+  sc_array_uniq (receivers, sc_int_compare);
+  for (i = 0; i < (int) receivers->elem_count; ++i) {
+    r = *(int *) sc_array_index_int (receivers, i);
+    *(int *) sc_array_push (in_payload) = 1000 * mpirank + r;
+  }
+
+  progress = sc_progress_new ();
+  if (use_thread && !sc_progress_thread_start (progress, 10)) {
+    SC_GLOBAL_INFO ("Progress thread not available\n");
+  }
+  nop = sc_progress_notify (progress, receivers, senders, in_payload,
+                            out_payload, mpicomm);
+  rop = sc_progress_allreduce (progress, &mpirank, &sum, 1, sc_MPI_INT,
+                               sc_MPI_SUM, dupcomm);
+  for (work = 0; !sc_progress_test (progress, nop); ++work);
+  sc_progress_wait (progress, rop);
+  sc_progress_wait (progress, nop);
+  sc_progress_thread_stop (progress);
+  sc_progress_destroy (progress);
+  SC_GLOBAL_LDEBUGF ("Progress computed %d times before completion\n",
+                     work);
+
+  /* the senders are the distinct predecessors in ascending order */
+  SC_CHECK_ABORT (sum == mpisize * (mpisize - 1) / 2, "Progress allreduce");
+  SC_CHECK_ABORT (senders->elem_count == receivers->elem_count &&
+                  out_payload->elem_count == senders->elem_count,
+                  "Progress notify count");
+  expected = -1;
+  for (i = 0; i < (int) senders->elem_count; ++i) {
+    r = *(int *) sc_array_index_int (senders, i);
+    pay = (int *) sc_array_index_int (out_payload, i);
+    SC_CHECK_ABORT (r > expected && *pay == 1000 * r + mpirank &&
+                    ((mpirank - r + mpisize) % mpisize == 1 ||
+                     (mpirank - r + mpisize) % mpisize == 2 ||
+                     mpisize <= 2), "Progress notify sender");
+    expected = r;
+  }
+
+  sc_array_destroy (receivers);
+  sc_array_destroy (senders);
+  sc_array_destroy (in_payload);
+  sc_array_destroy (out_payload);
+  mpiret = sc_MPI_Comm_free (&dupcomm);
+  SC_CHECK_MPI (mpiret);
+}
+
+int
+main (int argc, char **argv)
+{
+  int                 mpiret;
+  int                 provided;
+
+  mpiret = sc_MPI_Init_thread (&argc, &argv, sc_MPI_THREAD_MULTIPLE,
+                               &provided);
+  SC_CHECK_MPI (mpiret);
+
+  sc_init (sc_MPI_COMM_WORLD, 1, 1, NULL, SC_LP_DEFAULT);
+
+  test_progress_steps ();
+  test_progress_notify (sc_MPI_COMM_WORLD, 0);
+  test_progress_notify (sc_MPI_COMM_WORLD, 1);
+
+  sc_finalize ();
+
+  mpiret = sc_MPI_Finalize ();
+  SC_CHECK_MPI (mpiret);
+
+  return 0;
+}
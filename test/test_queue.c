@@ -0,0 +1,177 @@
+/*
+  This file is part of the SC Library.
+  The SC Library provides support for parallel scientific applications.
+
+  Copyright (C) 2010 The University of Texas System
+  Additional copyright (C) 2011 individual authors
+
+  The SC Library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  The SC Library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with the SC Library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+  02110-1301, USA.
+*/
+
+#include <sc_queue.h>
+#if defined SC_ENABLE_PTHREAD && defined SC_HAVE_ATOMIC_BUILTINS
+#include <pthread.h>
+#include <sched.h>
+#define TEST_QUEUE_THREADS
+#endif
+
+#define TEST_QUEUE_ITEMS 100000
+#define TEST_QUEUE_PRODUCERS 3
+
+/* an element identifies its producer and its sequence number */
+typedef struct test_queue_item
+{
+  int                 producer;
+  int                 seq;
+}
+test_queue_item_t;
+
+typedef struct test_queue_producer
+{
+  sc_queue_t         *queue;
+  int                 producer;
+}
+test_queue_producer_t;
+
+static void
+test_queue_serial (int multi_producer)
+{
+  int                 i, v[12];
+  sc_queue_t         *queue;
+
+  queue = sc_queue_new (sizeof (int), 5, multi_producer);
+  SC_CHECK_ABORT (sc_queue_capacity (queue) == 8, "Queue capacity");
+  SC_CHECK_ABORT (!sc_queue_pop (queue, v), "Queue not empty");
+
+  /* fill the queue completely */
+  for (i = 0; i < 8; ++i) {
+    SC_CHECK_ABORT (sc_queue_push (queue, &i), "Queue push");
+  }
+  SC_CHECK_ABORT (!sc_queue_push (queue, &i), "Queue not full");
+  SC_CHECK_ABORT (sc_queue_count (queue) == 8, "Queue count");
+
+  /* a batch is cut at the free room and wraps around the end */
+  SC_CHECK_ABORT (sc_queue_pop_batch (queue, v, 3) == 3, "Queue pop");
+  for (i = 0; i < 12; ++i) {
+    v[i] = 8 + i;
+  }
+  SC_CHECK_ABORT (sc_queue_push_batch (queue, v, 12) == 3, "Queue batch");
+  SC_CHECK_ABORT (sc_queue_pop_batch (queue, v, 12) == 8, "Queue batch");
+  for (i = 0; i < 8; ++i) {
+    SC_CHECK_ABORT (v[i] == 3 + i, "Queue order");
+  }
+  SC_CHECK_ABORT (sc_queue_count (queue) == 0, "Queue empty");
+  SC_CHECK_ABORT (sc_queue_push_batch (queue, v, 0) == 0, "Queue none");
+
+  sc_queue_destroy (queue);
+}
+
+#ifdef TEST_QUEUE_THREADS
+
+static void        *
+test_queue_produce (void *arg)
+{
+  test_queue_producer_t *tp = (test_queue_producer_t *) arg;
+  int                 seq, b;
+  size_t              k;
+  test_queue_item_t   items[7];
+
+  /* push batches of varying size and spin while the queue is full */
+  for (seq = 0, b = 1; seq < TEST_QUEUE_ITEMS; b = b % 7 + 1) {
+    for (k = 0; k < (size_t) b; ++k) {
+      items[k].producer = tp->producer;
+      items[k].seq = seq + (int) k;
+    }
+    k = SC_MIN ((size_t) b, (size_t) (TEST_QUEUE_ITEMS - seq));
+    k = sc_queue_push_batch (tp->queue, items, k);
+    if (k == 0) {
+      /* let the consumer run when there are fewer cores than threads */
+      sched_yield ();
+    }
+    seq += (int) k;
+  }
+  return NULL;
+}
+
+static void
+test_queue_threads (int num_producers)
+{
+  int                 p, pth;
+  int                 next[TEST_QUEUE_PRODUCERS];
+  size_t              k, zz, total;
+  pthread_t           threads[TEST_QUEUE_PRODUCERS];
+  test_queue_producer_t tp[TEST_QUEUE_PRODUCERS];
+  test_queue_item_t   items[16];
+  sc_queue_t         *queue;
+
+  queue = sc_queue_new (sizeof (test_queue_item_t), 64, num_producers > 1);
+  for (p = 0; p < num_producers; ++p) {
+    next[p] = 0;
+    tp[p].queue = queue;
+    tp[p].producer = p;
+    pth = pthread_create (&threads[p], NULL, test_queue_produce, &tp[p]);
+    SC_CHECK_ABORTF (pth == 0, "pthread_create %d failed", pth);
+  }
+
+  /* the items of each producer arrive in the order they were pushed */
+  for (total = 0; total < (size_t) num_producers * TEST_QUEUE_ITEMS;) {
+    k = sc_queue_pop_batch (queue, items, 16);
+    if (k == 0) {
+      sched_yield ();
+    }
+    for (zz = 0; zz < k; ++zz) {
+      p = items[zz].producer;
+      SC_CHECK_ABORT (0 <= p && p < num_producers &&
+                      items[zz].seq == next[p], "Queue thread order");
+      ++next[p];
+    }
+    total += k;
+  }
+
+  for (p = 0; p < num_producers; ++p) {
+    pth = pthread_join (threads[p], NULL);
+    SC_CHECK_ABORTF (pth == 0, "pthread_join %d failed", pth);
+  }
+  SC_CHECK_ABORT (sc_queue_count (queue) == 0, "Queue thread empty");
+  sc_queue_destroy (queue);
+}
+
+#endif /* TEST_QUEUE_THREADS */
+
+int
+main (int argc, char **argv)
+{
+  int                 mpiret;
+
+  mpiret = sc_MPI_Init (&argc, &argv);
+  SC_CHECK_MPI (mpiret);
+
+  sc_init (sc_MPI_COMM_WORLD, 1, 1, NULL, SC_LP_DEFAULT);
+
+  test_queue_serial (0);
+  test_queue_serial (1);
+#ifdef TEST_QUEUE_THREADS
+  test_queue_threads (1);
+  test_queue_threads (TEST_QUEUE_PRODUCERS);
+#endif
+
+  sc_finalize ();
+
+  mpiret = sc_MPI_Finalize ();
+  SC_CHECK_MPI (mpiret);
+
+  return 0;
+}
@@ -0,0 +1,103 @@
+/*
+  This file is part of the SC Library.
+  The SC Library provides support for parallel scientific applications.
+
+  Copyright (C) 2010 The University of Texas System
+  Additional copyright (C) 2011 individual authors
+
+  The SC Library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  The SC Library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with the SC Library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+  02110-1301, USA.
+*/
+
+#include <sc_random.h>
+
+static int
+test_rand_fill (void)
+{
+  int                 num_failed_tests = 0;
+  size_t              i, s;
+  double              out[3 * 100];
+  sc_rand_state_t     state, copy, states[3], seq;
+
+  /* the batch agrees with single draws and random access */
+  state = copy = 0x123456789abcdefULL;
+  sc_rand_fill (&state, out, 100);
+  for (i = 0; i < 100; ++i) {
+    if (out[i] != sc_rand (&copy) || out[i] != sc_rand_at (state - 100, i)) {
+      ++num_failed_tests;
+    }
+  }
+  if (state != copy) {
+    ++num_failed_tests;
+  }
+
+  /* the streams agree with their own sequences */
+  for (s = 0; s < 3; ++s) {
+    states[s] = sc_rand_split (17, s);
+  }
+  if (states[0] == states[1] || states[1] == states[2] ||
+      states[0] != sc_rand_split (17, 0)) {
+    ++num_failed_tests;
+  }
+  sc_rand_fill_streams (states, 3, out, 100);
+  for (s = 0; s < 3; ++s) {
+    seq = sc_rand_split (17, s);
+    for (i = 0; i < 100; ++i) {
+      if (out[i * 3 + s] != sc_rand (&seq)) {
+        ++num_failed_tests;
+      }
+    }
+    if (seq != states[s]) {
+      ++num_failed_tests;
+    }
+  }
+
+  if (num_failed_tests) {
+    SC_GLOBAL_LERRORF ("rand fill %d mismatches\n", num_failed_tests);
+  }
+
+  /* validate the Poisson and normal samplers statistically */
+  state = 42;
+  num_failed_tests += sc_rand_test_poisson (&state, 2., 102., 2, 40000);
+  return num_failed_tests;
+}
+
+int
+main (int argc, char **argv)
+{
+  int                 mpiret;
+  sc_MPI_Comm         mpicomm;
+  int                 num_failed_tests;
+
+  /* standard initialization */
+  mpiret = sc_MPI_Init (&argc, &argv);
+  SC_CHECK_MPI (mpiret);
+  mpicomm = sc_MPI_COMM_WORLD;
+
+  sc_init (mpicomm, 1, 1, NULL, SC_LP_DEFAULT);
+
+  num_failed_tests = 0;
+
+  /* test the batched random numbers */
+  num_failed_tests += test_rand_fill ();
+
+  /* clean up and exit */
+  sc_finalize ();
+
+  mpiret = sc_MPI_Finalize ();
+  SC_CHECK_MPI (mpiret);
+
+  return num_failed_tests ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -21,7 +21,129 @@
   02110-1301, USA.
 */
 
+#include <sc_allgather.h>
+#include <sc_notify.h>
 #include <sc_reduce.h>
+#include <sc_thread.h>
+
+#define TEST_NUM_SLOTS 3
+
+/* run a sequence of collectives on the duplicate of one slot */
+static void
+test_slot (int slot, sc_MPI_Comm mpicomm)
+{
+  int                 mpiret, mpisize, mpirank, i;
+  int                 ivalue, iresult, receiver, sender, num_senders;
+  int                 gathered[64];
+
+  sc_mpi_thread_slot_set (slot);
+  SC_CHECK_ABORT (sc_mpi_thread_slot_get () == slot, "Slot mismatch");
+#ifdef SC_ENABLE_MPI
+  SC_CHECK_ABORT (sc_mpi_comm_thread (mpicomm) != mpicomm,
+                  "Slot communicator not attached");
+#endif
+  mpiret = sc_MPI_Comm_size (mpicomm, &mpisize);
+  SC_CHECK_MPI (mpiret);
+  mpiret = sc_MPI_Comm_rank (mpicomm, &mpirank);
+  SC_CHECK_MPI (mpiret);
+
+  for (i = 0; i < 10; ++i) {
+    ivalue = mpirank + slot;
+    sc_allreduce (&ivalue, &iresult, 1, sc_MPI_INT, sc_MPI_SUM, mpicomm);
+    SC_CHECK_ABORT (iresult == mpisize * (mpisize - 1) / 2 + mpisize * slot,
+                    "Slot allreduce mismatch");
+
+    if (mpisize <= 64) {
+      ivalue = 100 * slot + mpirank;
+      mpiret = sc_allgather (&ivalue, 1, sc_MPI_INT, gathered, 1,
+                             sc_MPI_INT, mpicomm);
+      SC_CHECK_MPI (mpiret);
+      for (ivalue = 0; ivalue < mpisize; ++ivalue) {
+        SC_CHECK_ABORT (gathered[ivalue] == 100 * slot + ivalue,
+                        "Slot allgather mismatch");
+      }
+    }
+
+    receiver = (mpirank + 1) % mpisize;
+    sc_notify (&receiver, 1, &sender, &num_senders, mpicomm);
+    SC_CHECK_ABORT (num_senders == 1 &&
+                    sender == (mpirank + mpisize - 1) % mpisize,
+                    "Slot notify mismatch");
+  }
+  sc_mpi_thread_slot_set (-1);
+}
+
+static void
+test_slot_thread (int thread_id, int num_threads, void *user)
+{
+  int                 slot;
+
+  /* with fewer threads than slots, each takes care of several */
+  for (slot = thread_id; slot < TEST_NUM_SLOTS; slot += num_threads) {
+    test_slot (slot, *(sc_MPI_Comm *) user);
+  }
+}
+
+static void
+test_exscan (sc_MPI_Comm mpicomm, int mpirank, int mpisize)
+{
+  int                 t;
+  long                n, first, total, lvalue, ltotal;
+  size_t              zz;
+  double              dtotal;
+  sc_array_t         *lvalues, *dvalues;
+
+  /* the values are the global indices with differing local counts */
+  n = 3 * SC_REDUCE_EXSCAN_PARALLEL_MIN + 17 * mpirank;
+  first = (3L * SC_REDUCE_EXSCAN_PARALLEL_MIN * mpirank +
+           17L * mpirank * (mpirank - 1) / 2);
+  total = (3L * SC_REDUCE_EXSCAN_PARALLEL_MIN * mpisize +
+           17L * mpisize * (mpisize - 1) / 2);
+  lvalues = sc_array_new_count (sizeof (long), (size_t) n);
+  dvalues = sc_array_new_count (sizeof (double), (size_t) n);
+  for (t = 1; t <= 4; t += 3) {
+    for (zz = 0; zz < (size_t) n; ++zz) {
+      *(long *) sc_array_index (lvalues, zz) = first + (long) zz;
+      *(double *) sc_array_index (dvalues, zz) = 1.;
+    }
+    sc_array_exscan (lvalues, sc_MPI_LONG, &ltotal, t, mpicomm);
+    sc_array_exscan (dvalues, sc_MPI_DOUBLE, &dtotal, t, mpicomm);
+    for (zz = 0; zz < (size_t) n; ++zz) {
+      lvalue = first + (long) zz;
+      SC_CHECK_ABORT (*(long *) sc_array_index (lvalues, zz) ==
+                      lvalue * (lvalue - 1) / 2, "Exscan long mismatch");
+      SC_CHECK_ABORT (*(double *) sc_array_index (dvalues, zz) ==
+                      (double) lvalue, "Exscan double mismatch");
+    }
+    SC_CHECK_ABORT (dtotal == (double) total && ltotal ==
+                    total * (total - 1) / 2, "Exscan total mismatch");
+  }
+  sc_array_destroy (lvalues);
+  sc_array_destroy (dvalues);
+}
+
+static void
+test_histogram (sc_MPI_Comm mpicomm, int mpirank, int mpisize)
+{
+  int                 i;
+  const double        edges[4] = { 0., 1., 10., 100. };
+  long long           counts[3];
+  sc_array_t         *values;
+
+  /* each rank holds the integers from -1 to 100 and its rank */
+  values = sc_array_new_count (sizeof (int), 103);
+  for (i = 0; i < 102; ++i) {
+    *(int *) sc_array_index_int (values, i) = i - 1;
+  }
+  *(int *) sc_array_index_int (values, 102) = mpirank;
+  sc_array_histogram (values, sc_MPI_INT, 3, edges, counts, mpicomm);
+  SC_CHECK_ABORT (counts[0] == mpisize + 1, "Histogram mismatch");
+  SC_CHECK_ABORT (counts[1] == 9 * mpisize + SC_MIN (mpisize, 10) - 1,
+                  "Histogram mismatch");
+  SC_CHECK_ABORT (counts[2] == 90 * mpisize + SC_MAX (mpisize - 10, 0),
+                  "Histogram mismatch");
+  sc_array_destroy (values);
+}
 
 int
 main (int argc, char **argv)
@@ -34,10 +156,15 @@ main (int argc, char **argv)
   unsigned short      usvalue, usresult;
   long                lvalue, lresult;
   float               fvalue[3], fresult[3], fexpect[3];
+  int                 level, n, *ivalues, *iresults;
+  size_t              segment_bytes, rabenseifner_bytes;
   double              dvalue, dresult;
+  sc_MPI_Request      requests[2];
   sc_MPI_Comm         mpicomm;
+  int                 provided;
 
-  mpiret = sc_MPI_Init (&argc, &argv);
+  mpiret = sc_MPI_Init_thread (&argc, &argv, sc_MPI_THREAD_MULTIPLE,
+                               &provided);
   SC_CHECK_MPI (mpiret);
 
   mpicomm = sc_MPI_COMM_WORLD;
@@ -101,6 +228,101 @@ main (int argc, char **argv)
     }
   }
 
+  /* test segmented allreduce int sum through the binary tree */
+  level = sc_reduce_alltoall_level;
+  segment_bytes = sc_reduce_segment_bytes;
+  sc_reduce_alltoall_level = 0;
+  sc_reduce_segment_bytes = 100 * sizeof (int);
+  n = 1001;
+  ivalues = SC_ALLOC (int, n);
+  iresults = SC_ALLOC (int, n);
+  for (j = 0; j < n; ++j) {
+    ivalues[j] = mpirank + j;
+  }
+  sc_allreduce (ivalues, iresults, n, sc_MPI_INT, sc_MPI_SUM, mpicomm);
+  for (j = 0; j < n; ++j) {
+    SC_CHECK_ABORT (iresults[j] == (mpisize - 1) * mpisize / 2 + j * mpisize,
+                    "Segmented allreduce mismatch");
+  }
+  SC_FREE (iresults);
+  SC_FREE (ivalues);
+  sc_reduce_segment_bytes = segment_bytes;
+  sc_reduce_alltoall_level = level;
+
+  /* test allreduce by reduce-scatter and allgather */
+  rabenseifner_bytes = sc_reduce_rabenseifner_bytes;
+  sc_reduce_rabenseifner_bytes = sizeof (int);
+  for (n = 1; n <= 37; n += 4) {
+    ivalues = SC_ALLOC (int, n);
+    iresults = SC_ALLOC (int, n);
+    for (j = 0; j < n; ++j) {
+      ivalues[j] = mpirank + j;
+    }
+    sc_allreduce (ivalues, iresults, n, sc_MPI_INT, sc_MPI_SUM, mpicomm);
+    for (j = 0; j < n; ++j) {
+      SC_CHECK_ABORT (iresults[j] ==
+                      (mpisize - 1) * mpisize / 2 + j * mpisize,
+                      "Rabenseifner allreduce mismatch");
+    }
+    sc_allreduce (ivalues, iresults, n, sc_MPI_INT, sc_MPI_MAX, mpicomm);
+    for (j = 0; j < n; ++j) {
+      SC_CHECK_ABORT (iresults[j] == mpisize - 1 + j,
+                      "Rabenseifner allreduce mismatch");
+    }
+    SC_FREE (iresults);
+    SC_FREE (ivalues);
+  }
+  sc_reduce_rabenseifner_bytes = rabenseifner_bytes;
+
+  /* test nonblocking allreduce and allgather */
+  n = 3;
+  ivalues = SC_ALLOC (int, 2 * n + mpisize);
+  iresults = ivalues + 2 * n;
+  for (j = 0; j < n; ++j) {
+    ivalues[j] = mpirank + j;
+  }
+  mpiret = sc_MPI_Iallreduce (ivalues, ivalues + n, n, sc_MPI_INT,
+                              sc_MPI_SUM, mpicomm, requests + 0);
+  SC_CHECK_MPI (mpiret);
+  mpiret = sc_MPI_Iallgather (&mpirank, 1, sc_MPI_INT, iresults, 1,
+                              sc_MPI_INT, mpicomm, requests + 1);
+  SC_CHECK_MPI (mpiret);
+  for (level = 0; level < 2; ++level) {
+    mpiret = sc_MPI_Waitany (2, requests, &i, sc_MPI_STATUS_IGNORE);
+    SC_CHECK_MPI (mpiret);
+    SC_CHECK_ABORT (i == sc_MPI_UNDEFINED || (0 <= i && i < 2),
+                    "Waitany index mismatch");
+  }
+  do {
+    mpiret = sc_MPI_Test (requests + 0, &level, sc_MPI_STATUS_IGNORE);
+    SC_CHECK_MPI (mpiret);
+  }
+  while (!level);
+  for (j = 0; j < n; ++j) {
+    SC_CHECK_ABORT (ivalues[n + j] ==
+                    (mpisize - 1) * mpisize / 2 + j * mpisize,
+                    "Iallreduce mismatch");
+  }
+  for (j = 0; j < mpisize; ++j) {
+    SC_CHECK_ABORT (iresults[j] == j, "Iallgather mismatch");
+  }
+  SC_FREE (ivalues);
+
+  test_exscan (mpicomm, mpirank, mpisize);
+  test_histogram (mpicomm, mpirank, mpisize);
+
+  /* concurrent collectives on per-thread duplicates */
+  sc_mpi_comm_attach_thread_comms (mpicomm, TEST_NUM_SLOTS);
+  SC_CHECK_ABORT (sc_mpi_comm_thread (mpicomm) == mpicomm,
+                  "No slot selected");
+  sc_thread_fork_join (provided >= sc_MPI_THREAD_MULTIPLE ?
+                       TEST_NUM_SLOTS : 1, test_slot_thread, &mpicomm);
+  sc_mpi_comm_detach_thread_comms (mpicomm);
+  sc_mpi_thread_slot_set (0);
+  SC_CHECK_ABORT (sc_mpi_comm_thread (mpicomm) == mpicomm,
+                  "Slot communicators not detached");
+  sc_mpi_thread_slot_set (-1);
+
   sc_finalize ();
 
   mpiret = sc_MPI_Finalize ();
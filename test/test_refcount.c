@@ -0,0 +1,84 @@
+/*
+  This file is part of the SC Library.
+  The SC Library provides support for parallel scientific applications.
+
+  Copyright (C) 2010 The University of Texas System
+  Additional copyright (C) 2011 individual authors
+
+  The SC Library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  The SC Library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with the SC Library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+  02110-1301, USA.
+*/
+
+#include <sc_refcount.h>
+#include <sc_thread.h>
+
+/* every thread takes and drops references to a shared counter */
+static void
+test_refcount_thread (int thread_id, int num_threads, void *user)
+{
+  sc_refcount_t      *rc = (sc_refcount_t *) user;
+  int                 i;
+
+  for (i = 0; i < 10000; ++i) {
+    sc_refcount_ref (rc);
+  }
+  for (i = 0; i < 10000; ++i) {
+    SC_CHECK_ABORT (!sc_refcount_unref (rc), "Refcount drop");
+  }
+}
+
+static int
+test_refcount_atomic (void)
+{
+  int                 num_failed_tests = 0;
+  sc_refcount_t       rc;
+
+  sc_refcount_init_atomic (&rc, sc_package_id);
+  sc_thread_fork_join (4, test_refcount_thread, &rc);
+  if (!sc_refcount_is_last (&rc) || !sc_refcount_unref (&rc) ||
+      sc_refcount_is_active (&rc)) {
+    ++num_failed_tests;
+    SC_GLOBAL_LERROR ("atomic refcount mismatch\n");
+  }
+  return num_failed_tests;
+}
+
+int
+main (int argc, char **argv)
+{
+  int                 mpiret;
+  sc_MPI_Comm         mpicomm;
+  int                 num_failed_tests;
+
+  /* standard initialization */
+  mpiret = sc_MPI_Init (&argc, &argv);
+  SC_CHECK_MPI (mpiret);
+  mpicomm = sc_MPI_COMM_WORLD;
+
+  sc_init (mpicomm, 1, 1, NULL, SC_LP_DEFAULT);
+
+  num_failed_tests = 0;
+
+  /* test the atomic reference counter */
+  num_failed_tests += test_refcount_atomic ();
+
+  /* clean up and exit */
+  sc_finalize ();
+
+  mpiret = sc_MPI_Finalize ();
+  SC_CHECK_MPI (mpiret);
+
+  return num_failed_tests ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -23,6 +23,139 @@
 
 #include <sc_search.h>
 
+static int
+test_compare64 (const void *a, const void *b)
+{
+  const int64_t       x = *(const int64_t *) a;
+  const int64_t       y = *(const int64_t *) b;
+
+  return x < y ? -1 : x > y ? 1 : 0;
+}
+
+/* compare the batched and tree searches against the scalar functions */
+static void
+test_search_batch (size_t nmemb)
+{
+  const size_t        num_targets = 3 * nmemb + 17;
+  size_t              zz, *ranges;
+  ssize_t            *batch, *treed, expect;
+  int64_t            *array, *targets;
+  int                 pass;
+  sc_search_tree_t   *tree;
+  sc_search_index_t  *index;
+
+  array = SC_ALLOC (int64_t, nmemb + 1);
+  targets = SC_ALLOC (int64_t, num_targets);
+  batch = SC_ALLOC (ssize_t, num_targets);
+  treed = SC_ALLOC (ssize_t, num_targets);
+  ranges = SC_ALLOC (size_t, num_targets);
+
+  /* a sorted array with runs of duplicates */
+  for (zz = 0; zz < nmemb; ++zz) {
+    array[zz] = (int64_t) (zz / 3) * 5 - (int64_t) nmemb;
+  }
+  if (nmemb > 1) {
+    array[0] = INT64_MIN;
+  }
+  if (nmemb > 0) {
+    array[nmemb - 1] = INT64_MAX;
+  }
+  for (zz = 0; zz < num_targets; ++zz) {
+    targets[zz] = (int64_t) (rand () % (4 * (int) nmemb + 9))
+      - 2 * (int64_t) nmemb - 4;
+  }
+  targets[0] = INT64_MIN;
+  targets[num_targets - 1] = INT64_MAX;
+
+  /* unsorted targets first, then sorted ones */
+  tree = sc_search_tree_new (array, nmemb);
+  index = sc_search_index_new (array, nmemb);
+  for (pass = 0; pass < 2; ++pass) {
+    if (pass == 1) {
+      qsort (targets, num_targets, sizeof (int64_t), test_compare64);
+    }
+    sc_search_lower_bound64_batch (targets, num_targets, array, nmemb,
+                                   batch);
+    sc_search_tree_lower_bound_batch (tree, targets, num_targets, treed);
+    if (nmemb > 0) {
+      sc_bsearch_range_batch (targets, num_targets, array, nmemb - 1,
+                              sizeof (int64_t), test_compare64, ranges);
+    }
+    for (zz = 0; zz < num_targets; ++zz) {
+      expect = sc_search_lower_bound64 (targets[zz], array, nmemb,
+                                        nmemb / 2);
+      SC_CHECK_ABORT (batch[zz] == expect, "Lower bound batch");
+      SC_CHECK_ABORT (treed[zz] == expect, "Lower bound tree batch");
+      SC_CHECK_ABORT (sc_search_tree_lower_bound (tree, targets[zz]) ==
+                      expect, "Lower bound tree");
+      SC_CHECK_ABORT (sc_search_index_lower_bound (index, targets[zz]) ==
+                      expect, "Lower bound index");
+      if (nmemb > 0) {
+        SC_CHECK_ABORT (ranges[zz] ==
+                        sc_bsearch_range (targets + zz, array, nmemb - 1,
+                                          sizeof (int64_t), test_compare64),
+                        "Range batch");
+      }
+    }
+  }
+  sc_search_tree_destroy (tree);
+  sc_search_index_destroy (index);
+
+  /* an index over evenly spread offsets as from a partition */
+  for (zz = 0; zz < nmemb; ++zz) {
+    array[zz] = (int64_t) zz * 1000 + (int64_t) (zz % 7);
+  }
+  index = sc_search_index_new (array, nmemb);
+  for (zz = 0; zz < num_targets; ++zz) {
+    targets[zz] = (int64_t) rand () % (1000 * (int64_t) nmemb + 2) - 1;
+    SC_CHECK_ABORT (sc_search_index_lower_bound (index, targets[zz]) ==
+                    sc_search_lower_bound64 (targets[zz], array, nmemb,
+                                             nmemb / 2), "Index offsets");
+  }
+  if (nmemb >= 10000) {
+    SC_GLOBAL_INFOF ("Search index of %llu entries uses %llu bytes,"
+                     " built in %g seconds\n", (unsigned long long) nmemb,
+                     (unsigned long long) sc_search_index_memory_used
+                     (index), sc_search_index_build_time (index));
+  }
+  sc_search_index_destroy (index);
+
+  SC_FREE (array);
+  SC_FREE (targets);
+  SC_FREE (batch);
+  SC_FREE (treed);
+  SC_FREE (ranges);
+}
+
+static void
+test_search_bias_array (void)
+{
+  const int           maxlevel = 10;
+  const size_t        n = 37;
+  int                 level;
+  int                 intervals[37], targets[37], results[37];
+  size_t              zz;
+
+  for (level = 0; level <= maxlevel; ++level) {
+    for (zz = 0; zz < n; ++zz) {
+      intervals[zz] = rand () % (1 << level);
+      targets[zz] = rand () % (1 << maxlevel);
+    }
+    sc_search_bias_array (maxlevel, level, intervals, targets, n, results);
+    for (zz = 0; zz < n; ++zz) {
+      SC_CHECK_ABORT (results[zz] == sc_search_bias (maxlevel, level,
+                                                     intervals[zz],
+                                                     targets[zz]),
+                      "Search bias array");
+    }
+
+    /* the results may overwrite the targets */
+    sc_search_bias_array (maxlevel, level, intervals, targets, n, targets);
+    SC_CHECK_ABORT (!memcmp (results, targets, sizeof (results)),
+                    "Search bias in place");
+  }
+}
+
 int
 main (int argc, char **argv)
 {
@@ -30,6 +163,7 @@ main (int argc, char **argv)
   int                 mpirank, mpisize;
   int                 maxlevel, level, target;
   int                 i, position;
+  size_t              zz;
   sc_MPI_Comm         mpicomm;
 
   mpiret = sc_MPI_Init (&argc, &argv);
@@ -54,6 +188,13 @@ main (int argc, char **argv)
                     maxlevel, level, i, target, position);
       }
     }
+
+    SC_GLOBAL_INFOF ("Search tree kernel %s\n", sc_search_tree_kernel ());
+    for (zz = 0; zz < 100; ++zz) {
+      test_search_batch (zz);
+    }
+    test_search_batch (10000);
+    test_search_bias_array ();
   }
 
   mpiret = sc_MPI_Finalize ();
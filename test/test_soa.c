@@ -0,0 +1,198 @@
+/*
+  This file is part of the SC Library.
+  The SC Library provides support for parallel scientific applications.
+
+  Copyright (C) 2010 The University of Texas System
+  Additional copyright (C) 2011 individual authors
+
+  The SC Library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  The SC Library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with the SC Library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+  02110-1301, USA.
+*/
+
+#include <sc_soa.h>
+#include <sc_random.h>
+
+#define TEST_SOA_COUNT 10000
+#define TEST_SOA_TYPES 7
+
+enum
+{
+  TEST_SOA_X,
+  TEST_SOA_TYPE,
+  TEST_SOA_ID,
+  TEST_SOA_TAG,
+  TEST_SOA_COLUMNS
+};
+
+static int
+test_soa_compare_double (const void *a, const void *b)
+{
+  double              x = *(const double *) a;
+  double              y = *(const double *) b;
+
+  return x < y ? -1 : x > y ? 1 : 0;
+}
+
+static int
+test_soa_compare_int (const void *a, const void *b)
+{
+  return *(const int *) a - *(const int *) b;
+}
+
+static size_t
+test_soa_type (sc_array_t * array, size_t index, void *data)
+{
+  return (size_t) * (int *) sc_array_index (array, index);
+}
+
+/* every element must still carry the fields it was created with */
+static void
+test_soa_verify (sc_soa_t * soa, const double *x, const int *type)
+{
+  size_t              iz, id;
+  const char         *tag;
+
+  SC_CHECK_ABORT (soa->elem_count == TEST_SOA_COUNT, "Count");
+  for (iz = 0; iz < soa->elem_count; ++iz) {
+    id = *(size_t *) sc_soa_index (soa, TEST_SOA_ID, iz);
+    tag = (const char *) sc_soa_index (soa, TEST_SOA_TAG, iz);
+    SC_CHECK_ABORT (id < TEST_SOA_COUNT &&
+                    *(double *) sc_soa_index (soa, TEST_SOA_X, iz) == x[id]
+                    && *(int *) sc_soa_index (soa, TEST_SOA_TYPE, iz) ==
+                    type[id] && tag[0] == (char) id &&
+                    tag[2] == (char) (id >> 8), "Element fields");
+  }
+}
+
+int
+main (int argc, char **argv)
+{
+  int                 mpiret;
+  int                 dt;
+  size_t              iz, c, k;
+  size_t              sizes[TEST_SOA_COLUMNS];
+  int                 type[TEST_SOA_COUNT];
+  double              x[TEST_SOA_COUNT];
+  char               *tag;
+  sc_rand_state_t     state = 5;
+  sc_soa_t           *soa;
+  sc_array_t         *offsets, *perm;
+
+  mpiret = sc_MPI_Init (&argc, &argv);
+  SC_CHECK_MPI (mpiret);
+
+  sc_init (sc_MPI_COMM_WORLD, 1, 1, NULL, SC_LP_DEFAULT);
+
+  sizes[TEST_SOA_X] = sizeof (double);
+  sizes[TEST_SOA_TYPE] = sizeof (int);
+  sizes[TEST_SOA_ID] = sizeof (size_t);
+  sizes[TEST_SOA_TAG] = 3;
+  soa = sc_soa_new (TEST_SOA_COLUMNS, sizes);
+
+  /* fill the columns one element at a time */
+  for (iz = 0; iz < TEST_SOA_COUNT; ++iz) {
+    k = sc_soa_push (soa);
+    SC_CHECK_ABORT (k == iz, "Push");
+    x[iz] = sc_rand (&state);
+    type[iz] = (int) (sc_rand (&state) * TEST_SOA_TYPES);
+    *(double *) sc_soa_index (soa, TEST_SOA_X, k) = x[iz];
+    *(int *) sc_soa_index (soa, TEST_SOA_TYPE, k) = type[iz];
+    *(size_t *) sc_soa_index (soa, TEST_SOA_ID, k) = iz;
+    tag = (char *) sc_soa_index (soa, TEST_SOA_TAG, k);
+    tag[0] = (char) iz;
+    tag[1] = 'x';
+    tag[2] = (char) (iz >> 8);
+  }
+  for (c = 0; c < TEST_SOA_COLUMNS; ++c) {
+    SC_CHECK_ABORT (sc_soa_column (soa, c)->elem_count == TEST_SOA_COUNT,
+                    "Column count");
+#ifdef SC_HAVE_POSIX_MEMALIGN
+    SC_CHECK_ABORT ((size_t) sc_soa_column (soa, c)->array %
+                    SC_SOA_ALIGN == 0, "Column alignment");
+#endif
+  }
+  test_soa_verify (soa, x, type);
+  SC_GLOBAL_STATISTICSF ("Structure of arrays memory %llu\n",
+                         (unsigned long long) sc_soa_memory_used (soa));
+
+  /* reverse the order by a permutation */
+  perm = sc_array_new_count (sizeof (size_t), TEST_SOA_COUNT);
+  for (iz = 0; iz < TEST_SOA_COUNT; ++iz) {
+    *(size_t *) sc_array_index (perm, iz) = TEST_SOA_COUNT - 1 - iz;
+  }
+  sc_soa_permute (soa, perm, 1);
+  SC_CHECK_ABORT (*(size_t *) sc_array_index (perm, 0) ==
+                  TEST_SOA_COUNT - 1, "Kept permutation");
+  for (iz = 0; iz < TEST_SOA_COUNT; ++iz) {
+    SC_CHECK_ABORT (*(size_t *) sc_soa_index (soa, TEST_SOA_ID, iz) ==
+                    TEST_SOA_COUNT - 1 - iz, "Permute");
+  }
+  test_soa_verify (soa, x, type);
+  sc_array_destroy (perm);
+
+  /* sort by one column and then stably by another */
+  sc_soa_sort (soa, TEST_SOA_X, test_soa_compare_double);
+  SC_CHECK_ABORT (sc_array_is_sorted (sc_soa_column (soa, TEST_SOA_X),
+                                      test_soa_compare_double), "Sort");
+  test_soa_verify (soa, x, type);
+  sc_soa_sort (soa, TEST_SOA_TYPE, test_soa_compare_int);
+  for (iz = 1; iz < TEST_SOA_COUNT; ++iz) {
+    dt = *(int *) sc_soa_index (soa, TEST_SOA_TYPE, iz - 1) -
+      *(int *) sc_soa_index (soa, TEST_SOA_TYPE, iz);
+    SC_CHECK_ABORT (dt < 0 || (dt == 0 &&
+                               *(double *) sc_soa_index (soa, TEST_SOA_X,
+                                                         iz - 1) <=
+                               *(double *) sc_soa_index (soa, TEST_SOA_X,
+                                                         iz)),
+                    "Stable sort");
+  }
+  test_soa_verify (soa, x, type);
+
+  /* the split of the sorted columns equals the permuting split */
+  offsets = sc_array_new (sizeof (size_t));
+  sc_soa_split (soa, TEST_SOA_TYPE, offsets, TEST_SOA_TYPES,
+                test_soa_type, NULL, 0);
+  perm = sc_array_new (sizeof (size_t));
+  sc_array_copy (perm, offsets);
+  sc_soa_sort (soa, TEST_SOA_X, test_soa_compare_double);
+  sc_soa_split (soa, TEST_SOA_TYPE, offsets, TEST_SOA_TYPES,
+                test_soa_type, NULL, 1);
+  SC_CHECK_ABORT (sc_array_is_equal (offsets, perm), "Split offsets");
+  for (k = 0; k < TEST_SOA_TYPES; ++k) {
+    for (iz = *(size_t *) sc_array_index (offsets, k);
+         iz < *(size_t *) sc_array_index (offsets, k + 1); ++iz) {
+      SC_CHECK_ABORT (*(int *) sc_soa_index (soa, TEST_SOA_TYPE, iz) ==
+                      (int) k, "Split type");
+      SC_CHECK_ABORT (iz == *(size_t *) sc_array_index (offsets, k) ||
+                      *(double *) sc_soa_index (soa, TEST_SOA_X, iz - 1) <=
+                      *(double *) sc_soa_index (soa, TEST_SOA_X, iz),
+                      "Split stable");
+    }
+  }
+  test_soa_verify (soa, x, type);
+  sc_array_destroy (perm);
+  sc_array_destroy (offsets);
+
+  sc_soa_resize (soa, 0);
+  SC_CHECK_ABORT (sc_soa_column (soa, TEST_SOA_TAG)->elem_count == 0,
+                  "Resize");
+  sc_soa_destroy (soa);
+  sc_finalize ();
+
+  mpiret = sc_MPI_Finalize ();
+  SC_CHECK_MPI (mpiret);
+
+  return 0;
+}
@@ -23,6 +23,202 @@
 
 #include <sc_allgather.h>
 #include <sc_sort.h>
+#include <sc_thread.h>
+
+/** Verify that the items are globally sorted in the given partition. */
+static void
+test_sort_verify (sc_MPI_Comm mpicomm, const double *ldata,
+                  const size_t * nmemb)
+{
+  int                 mpiret;
+  int                 rank, num_procs;
+  int                 i;
+  int                *recvc, *displ;
+  size_t              zz, gtotal;
+  double             *gdata;
+
+  mpiret = sc_MPI_Comm_size (mpicomm, &num_procs);
+  SC_CHECK_MPI (mpiret);
+  mpiret = sc_MPI_Comm_rank (mpicomm, &rank);
+  SC_CHECK_MPI (mpiret);
+
+  gtotal = 0;
+  recvc = NULL;
+  displ = NULL;
+  gdata = NULL;
+  if (rank == 0) {
+    recvc = SC_ALLOC (int, num_procs);
+    displ = SC_ALLOC (int, num_procs + 1);
+    displ[0] = 0;
+    for (i = 0; i < num_procs; ++i) {
+      recvc[i] = (int) nmemb[i];
+      displ[i + 1] = displ[i] + recvc[i];
+    }
+    gtotal = (size_t) displ[num_procs];
+    gdata = SC_ALLOC (double, gtotal);
+  }
+  mpiret = sc_MPI_Gatherv ((void *) ldata, (int) nmemb[rank], sc_MPI_DOUBLE,
+                           gdata, recvc, displ, sc_MPI_DOUBLE, 0, mpicomm);
+  SC_CHECK_MPI (mpiret);
+  if (rank == 0) {
+    for (zz = 0; zz + 1 < gtotal; ++zz) {
+      SC_CHECK_ABORT (gdata[zz] <= gdata[zz + 1], "Parallel sort failed");
+    }
+  }
+  SC_FREE (gdata);
+  SC_FREE (displ);
+  SC_FREE (recvc);
+}
+
+/** Compare two ints in the direction given by the context. */
+static int
+test_sort_compare_r (const void *v1, const void *v2, void *arg)
+{
+  return *(int *) arg * sc_int_compare (v1, v2);
+}
+
+/** Check the reentrant local sort and the parallel sort on int64 keys. */
+static void
+test_sort_keys (sc_MPI_Comm mpicomm, size_t *nmemb, int rank)
+{
+  int                 dir;
+  size_t              zz;
+  const size_t        lcount = nmemb[rank];
+  int                *idata;
+  int64_t            *kdata, *sdata;
+
+  idata = SC_ALLOC (int, lcount);
+  for (zz = 0; zz < lcount; ++zz) {
+    idata[zz] = rand () % 7;
+  }
+  dir = -1;
+  sc_qsort_r (idata, lcount, sizeof (int), test_sort_compare_r, &dir);
+  for (zz = 1; zz < lcount; ++zz) {
+    SC_CHECK_ABORT (idata[zz - 1] >= idata[zz], "Reentrant sort failed");
+  }
+  SC_FREE (idata);
+
+  /* the integer keys are compared inline by both parallel sorts */
+  kdata = SC_ALLOC (int64_t, lcount);
+  sdata = SC_ALLOC (int64_t, lcount);
+  for (zz = 0; zz < lcount; ++zz) {
+    kdata[zz] = sdata[zz] = (int64_t) (rand () % 100) << 33;
+  }
+  sc_psort (mpicomm, kdata, nmemb, sizeof (int64_t), sc_int64_compare);
+  sc_psort_sample (mpicomm, sdata, nmemb, sizeof (int64_t),
+                   sc_int64_compare);
+  for (zz = 0; zz < lcount; ++zz) {
+    SC_CHECK_ABORT (kdata[zz] == sdata[zz], "Int64 sort mismatch");
+  }
+  SC_FREE (sdata);
+  SC_FREE (kdata);
+}
+
+/** Repartition items by weight and check the order and the balance. */
+static void
+test_partition_weighted (sc_MPI_Comm mpicomm, size_t *nmemb, int rank,
+                         int num_procs)
+{
+  int                 q;
+  size_t              zz, offset;
+  size_t             *wmemb;
+  sc_array_t         *items, *weights;
+  sc_statinfo_t       imbalance;
+
+  /* the items are global indices with a skewed weight */
+  for (offset = 0, q = 0; q < rank; ++q) {
+    offset += nmemb[q];
+  }
+  items = sc_array_new_count (sizeof (int64_t), nmemb[rank]);
+  weights = sc_array_new_count (sizeof (double), nmemb[rank]);
+  for (zz = 0; zz < nmemb[rank]; ++zz) {
+    *(int64_t *) sc_array_index (items, zz) = (int64_t) (offset + zz);
+    *(double *) sc_array_index (weights, zz) =
+      1. + (double) ((offset + zz) % 5) + (rank == 0 ? 4. : 0.);
+  }
+
+  wmemb = SC_ALLOC (size_t, num_procs);
+  sc_partition_weighted (mpicomm, items, weights, wmemb, &imbalance);
+  SC_CHECK_ABORT (items->elem_count == wmemb[rank] &&
+                  weights->elem_count == wmemb[rank], "Weighted count");
+  for (offset = 0, q = 0; q < rank; ++q) {
+    offset += wmemb[q];
+  }
+  for (zz = 0; zz < items->elem_count; ++zz) {
+    SC_CHECK_ABORT (*(int64_t *) sc_array_index (items, zz) ==
+                    (int64_t) (offset + zz), "Weighted order");
+    SC_CHECK_ABORT (*(double *) sc_array_index (weights, zz) ==
+                    1. + (double) ((offset + zz) % 5) +
+                    ((offset + zz) < nmemb[0] ? 4. : 0.), "Weighted data");
+  }
+
+  /* no process is heavier than the average by more than one item */
+  SC_CHECK_ABORT (imbalance.count == num_procs &&
+                  imbalance.max <= imbalance.average + 9.,
+                  "Weighted imbalance");
+  SC_GLOBAL_PRODUCTIONF ("Weighted partition imbalance %g\n",
+                         imbalance.max / imbalance.average);
+
+  SC_FREE (wmemb);
+  sc_array_destroy (weights);
+  sc_array_destroy (items);
+}
+
+/** Compare pairs of ints by their first member only. */
+static int
+test_sort_compare_pair (const void *v1, const void *v2)
+{
+  return sc_int_compare (v1, v2);
+}
+
+/** Sort local arrays with various thread counts and verify them. */
+static void
+test_sort_parallel (void)
+{
+  const size_t        n = 5 * SC_SORT_PARALLEL_MIN + 17;
+  int                 t;
+  size_t              zz;
+  long long           sum, check;
+  int                *p;
+  double             *d;
+  sc_array_t         *pairs, *doubles;
+
+  pairs = sc_array_new_count (2 * sizeof (int), n);
+  doubles = sc_array_new_count (sizeof (double), n);
+  for (t = 1; t <= 6; ++t) {
+    sum = 0;
+    for (zz = 0; zz < n; ++zz) {
+      p = (int *) sc_array_index (pairs, zz);
+      p[0] = rand () % 1000;
+      p[1] = (int) zz;
+      sum += p[0];
+      *(double *) sc_array_index (doubles, zz) = rand () / (double) RAND_MAX;
+    }
+    sc_array_sort_parallel (pairs, test_sort_compare_pair, t);
+    sc_array_sort_parallel (doubles, sc_double_compare, t);
+    SC_CHECK_ABORT (sc_array_is_sorted (pairs, test_sort_compare_pair),
+                    "Parallel sort pairs");
+    SC_CHECK_ABORT (sc_array_is_sorted (doubles, sc_double_compare),
+                    "Parallel sort doubles");
+    for (check = 0, zz = 0; zz < n; ++zz) {
+      check += *(int *) sc_array_index (pairs, zz);
+    }
+    SC_CHECK_ABORT (check == sum, "Parallel sort content");
+  }
+  sc_array_destroy (pairs);
+  sc_array_destroy (doubles);
+
+  /* an array too small for threads */
+  d = SC_ALLOC (double, 3);
+  d[0] = 2.;
+  d[1] = 1.;
+  d[2] = 0.;
+  doubles = sc_array_new_data (d, sizeof (double), 3);
+  sc_array_sort_parallel (doubles, sc_double_compare, 4);
+  SC_CHECK_ABORT (d[0] == 0. && d[2] == 2., "Parallel sort small");
+  sc_array_destroy (doubles);
+  SC_FREE (d);
+}
 
 int
 main (int argc, char **argv)
@@ -32,12 +228,13 @@ main (int argc, char **argv)
   int                 rank, num_procs;
   int                 i, isizet;
   int                 k, printed;
-  int                *recvc, *displ;
   int                 timing;
   size_t              zz;
   size_t              lcount, gtotal;
   size_t             *nmemb;
-  double             *ldata, *gdata;
+  size_t             *bmemb;
+  double             *ldata, *sdata;
+  sc_array_t         *barray;
   sc_MPI_Comm         mpicomm;
   char                buffer[BUFSIZ];
 
@@ -86,6 +283,12 @@ main (int argc, char **argv)
     ldata[zz] = -50. + (100. * rand () / (RAND_MAX + 1.0));
   }
 
+  /* keep copies of the unsorted data for the sample sort */
+  sdata = SC_ALLOC (double, lcount);
+  memcpy (sdata, ldata, lcount * sizeof (double));
+  barray = sc_array_new_count (sizeof (double), lcount);
+  memcpy (barray->array, ldata, lcount * sizeof (double));
+
   /* output result before sort */
   if (!timing && gtotal < 1000) {
     SC_GLOBAL_PRODUCTION ("Values before sort\n");
@@ -126,35 +329,44 @@ main (int argc, char **argv)
   /* verify result always, if the numbers are not too many */
   if (gtotal < 100000) {
     SC_GLOBAL_PRODUCTION ("Verifying\n");
-    gtotal = 0;
-    recvc = NULL;
-    displ = NULL;
-    gdata = NULL;
-    if (rank == 0) {
-      recvc = SC_ALLOC (int, num_procs);
-      displ = SC_ALLOC (int, num_procs + 1);
-      displ[0] = 0;
-      for (i = 0; i < num_procs; ++i) {
-        recvc[i] = (int) nmemb[i];
-        displ[i + 1] = displ[i] + recvc[i];
-      }
-      gtotal = (size_t) displ[num_procs];
-      gdata = SC_ALLOC (double, gtotal);
-    }
-    mpiret = sc_MPI_Gatherv (ldata, (int) lcount, sc_MPI_DOUBLE,
-                             gdata, recvc, displ, sc_MPI_DOUBLE, 0, mpicomm);
-    SC_CHECK_MPI (mpiret);
-    if (rank == 0) {
-      for (zz = 0; zz < gtotal - 1; ++zz) {
-        SC_CHECK_ABORT (gdata[zz] <= gdata[zz + 1], "Parallel sort failed");
-      }
-    }
-    SC_FREE (gdata);
-    SC_FREE (displ);
-    SC_FREE (recvc);
+    test_sort_verify (mpicomm, ldata, nmemb);
+  }
+
+  /* the sample sort must produce the identical result */
+  SC_GLOBAL_PRODUCTIONF ("Sample sorting %ld\n", (long) gtotal);
+  sc_psort_sample (mpicomm, sdata, nmemb, sizeof (double),
+                   sc_double_compare);
+  for (zz = 0; zz < lcount; ++zz) {
+    SC_CHECK_ABORT (sdata[zz] == ldata[zz], "Sample sort mismatch");
   }
 
+  /* sample sort into a balanced partition */
+  bmemb = SC_ALLOC (size_t, num_procs);
+  memcpy (bmemb, nmemb, num_procs * sizeof (size_t));
+  sc_psort_sample_ext (mpicomm, barray, bmemb, sc_double_compare,
+                       SC_PSORT_BALANCED);
+  SC_CHECK_ABORT (barray->elem_count == bmemb[rank], "Balanced count");
+  for (zz = 0, i = 0; i < num_procs; ++i) {
+    zz += bmemb[i];
+  }
+  SC_CHECK_ABORT (zz == gtotal, "Balanced total");
+  if (gtotal < 100000) {
+    test_sort_verify (mpicomm, (double *) barray->array, bmemb);
+  }
+
+  /* sort other key types with the same partition */
+  test_sort_keys (mpicomm, nmemb, rank);
+
+  /* move items such that every process gets equal weight */
+  test_partition_weighted (mpicomm, nmemb, rank, num_procs);
+
+  /* sort process-local data with multiple threads */
+  test_sort_parallel ();
+
   /* clean up and exit */
+  sc_array_destroy (barray);
+  SC_FREE (bmemb);
+  SC_FREE (sdata);
   SC_FREE (ldata);
   SC_FREE (nmemb);
 
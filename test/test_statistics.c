@@ -0,0 +1,434 @@
+/*
+  This file is part of the SC Library.
+  The SC Library provides support for parallel scientific applications.
+
+  Copyright (C) 2020 individual authors
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are met:
+
+  1. Redistributions of source code must retain the above copyright notice,
+  this list of conditions and the following disclaimer.
+
+  2. Redistributions in binary form must reproduce the above copyright notice,
+  this list of conditions and the following disclaimer in the documentation
+  and/or other materials provided with the distribution.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+  LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+  SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+  INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+  CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+  POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <sc_getopt.h>
+#include <sc_statistics.h>
+
+static int
+test_stats_quantiles (sc_MPI_Comm mpicomm)
+{
+  int                 num_failed_tests = 0;
+  int                 mpiret, mpirank, i;
+  double              q[3] = { .5, .95, .99 }, v;
+  sc_statinfo_t       si[3];
+  sc_stats_request_t *req;
+
+  mpiret = sc_MPI_Comm_rank (mpicomm, &mpirank);
+  SC_CHECK_MPI (mpiret);
+
+  /* the second variable has no histogram and the third one value */
+  sc_stats_init (&si[0], "uniform");
+  sc_stats_set_histogram (&si[0], 1.e-3, 1.e6);
+  sc_stats_init (&si[1], "plain");
+  for (i = 1; i <= 1000; ++i) {
+    sc_stats_accumulate (&si[0], (double) i);
+    sc_stats_accumulate (&si[1], (double) i);
+  }
+  sc_stats_set1 (&si[2], 1. + mpirank, "rank");
+  sc_stats_set_histogram (&si[2], 1., 1.e3);
+
+  /* overlap the reduction with more local work */
+  req = sc_stats_compute_begin (mpicomm, 3, si);
+  for (i = 0, v = 0.; i < 1000; ++i) {
+    v += sqrt ((double) i);
+  }
+  sc_stats_compute_end (req);
+  sc_stats_print (sc_package_id, SC_LP_INFO, 3, si, 1, 0);
+
+  /* one bucket spans a ratio of less than 1.4 */
+  for (i = 0; i < 3; ++i) {
+    v = sc_stats_quantile (&si[0], q[i]);
+    if (v < 1000. * q[i] / 1.4 || v > 1000. * q[i] * 1.4) {
+      SC_GLOBAL_LERRORF ("quantile %g estimated %g\n", q[i], v);
+      ++num_failed_tests;
+    }
+  }
+  if (si[1].max != 1000. || sc_stats_quantile (&si[2], 0.) != 1. ||
+      sc_stats_quantile (&si[2], 1.) != si[2].max) {
+    SC_GLOBAL_LERROR ("quantile bounds\n");
+    ++num_failed_tests;
+  }
+
+  return num_failed_tests;
+}
+
+static int
+test_stats_window (sc_MPI_Comm mpicomm)
+{
+  int                 num_failed_tests = 0;
+  int                 step, h;
+  sc_statinfo_t      *si;
+  sc_statistics_t    *stats;
+
+  /* the value jumps from 1 to 3 and the window follows across resets */
+  stats = sc_statistics_new (mpicomm);
+  h = sc_statistics_add_empty (stats, "rolling");
+  sc_statistics_set_window (stats, "rolling", 8);
+  si = (sc_statinfo_t *) sc_array_index_int (stats->sarray, h);
+  for (step = 1; step <= 400; ++step) {
+    sc_statistics_accumulate_handle (stats, h, step <= 200 ? 1. : 3.);
+    if (step % 100 == 0) {
+      sc_statistics_compute (stats);
+      sc_statistics_print_window (stats, sc_package_id, SC_LP_INFO);
+      if (step == 200 && (fabs (si->window_average - 1.) > 1.e-12 ||
+                          si->window_standev > 1.e-6)) {
+        SC_GLOBAL_LERROR ("statistics window constant\n");
+        ++num_failed_tests;
+      }
+      if (step == 300 && fabs (si->window_average - 3.) > 1.e-5) {
+        SC_GLOBAL_LERROR ("statistics window jump\n");
+        ++num_failed_tests;
+      }
+      sc_statistics_reset (stats);
+    }
+    if (step == 205) {
+      /* five of eight steps into the new values */
+      sc_statistics_compute (stats);
+      if (!(si->window_average > 1.5 && si->window_average < 2.5) ||
+          si->average != 3.) {
+        SC_GLOBAL_LERROR ("statistics window blend\n");
+        ++num_failed_tests;
+      }
+      sc_statistics_reset (stats);
+    }
+  }
+  sc_statistics_destroy (stats);
+
+  return num_failed_tests;
+}
+
+static int
+test_statistics_handles (sc_MPI_Comm mpicomm)
+{
+  int                 num_failed_tests = 0;
+  int                 mpiret, mpisize;
+  int                 ha, hb;
+  sc_statinfo_t      *si;
+  sc_statistics_t    *stats;
+
+  mpiret = sc_MPI_Comm_size (mpicomm, &mpisize);
+  SC_CHECK_MPI (mpiret);
+
+  /* access by handle and by name must refer to the same variable */
+  stats = sc_statistics_new (mpicomm);
+  ha = sc_statistics_add_empty (stats, "accumulated");
+  hb = sc_statistics_add (stats, "set");
+  sc_statistics_accumulate_handle (stats, ha, 1.);
+  sc_statistics_accumulate (stats, "accumulated", 3.);
+  sc_statistics_set_handle (stats, hb, 5.);
+  if (sc_statistics_get_handle (stats, "accumulated") != ha ||
+      sc_statistics_get_handle (stats, "set") != hb ||
+      sc_statistics_get_handle (stats, "missing") != -1) {
+    SC_GLOBAL_LERROR ("statistics handle lookup\n");
+    ++num_failed_tests;
+  }
+  sc_statistics_compute (stats);
+  si = (sc_statinfo_t *) sc_array_index_int (stats->sarray, ha);
+  if (si->count != 2 * mpisize || si->average != 2.) {
+    SC_GLOBAL_LERROR ("statistics accumulate by handle\n");
+    ++num_failed_tests;
+  }
+  si = (sc_statinfo_t *) sc_array_index_int (stats->sarray, hb);
+  if (si->count != mpisize || si->max != 5.) {
+    SC_GLOBAL_LERROR ("statistics set by handle\n");
+    ++num_failed_tests;
+  }
+  sc_statistics_destroy (stats);
+
+  return num_failed_tests;
+}
+
+static int
+test_clock (void)
+{
+  int                 num_failed_tests = 0;
+  int                 i, use_clock;
+  double              t, last;
+  sc_flopinfo_t       fi, snap;
+
+  /* the clock must never run backwards */
+  last = sc_clock ();
+  for (i = 0; i < 1000; ++i) {
+    t = sc_clock ();
+    if (t < last) {
+      break;
+    }
+    last = t;
+  }
+  if (i < 1000 || sc_clock_resolution () <= 0.) {
+    SC_LERROR ("clock monotonicity\n");
+    ++num_failed_tests;
+  }
+
+  /* the flop info may take its times by the clock */
+  use_clock = sc_flops_use_clock;
+  sc_flops_use_clock = 1;
+  sc_flops_start_nopapi (&fi);
+  sc_flops_snap (&fi, &snap);
+  sc_flops_shot (&fi, &snap);
+  if (!fi.use_clock || snap.iwtime < 0. || fi.cwtime < snap.iwtime) {
+    SC_LERROR ("clock flop info\n");
+    ++num_failed_tests;
+  }
+  sc_flops_use_clock = use_clock;
+
+  return num_failed_tests;
+}
+
+static void
+test_probes_region (int i)
+{
+  SC_PROBE_BEGIN ("test_probes_region");
+  if (i % 2) {
+    SC_PROBE_BEGIN ("test_probes_odd");
+    SC_PROBE_END;
+  }
+  SC_PROBE_END;
+}
+
+static int
+test_probes (sc_MPI_Comm mpicomm)
+{
+  int                 num_failed_tests = 0;
+  int                 i, first_arg;
+  int                 handle;
+  char               *argv[2];
+  sc_options_t       *opt;
+  sc_statinfo_t      *si;
+  sc_statistics_t    *stats;
+
+  /* disabled probes do not record */
+  sc_probes_enabled = 0;
+  test_probes_region (1);
+
+  /* enable the probes by the command line */
+  opt = sc_options_new ("test_statistics");
+  sc_probes_add_options (opt);
+  argv[0] = (char *) "test_statistics";
+  argv[1] = (char *) "--probes";
+  optind = 0;
+  first_arg = sc_options_parse (sc_package_id, SC_LP_INFO, opt, 2, argv);
+  sc_options_destroy (opt);
+  if (first_arg != 2 || !sc_probes_enabled) {
+    SC_GLOBAL_LERROR ("probes option\n");
+    ++num_failed_tests;
+  }
+  sc_probes_reset ();
+  for (i = 0; i < 10; ++i) {
+    test_probes_region (i);
+  }
+  sc_probes_enabled = 0;
+
+  stats = sc_statistics_new (mpicomm);
+  sc_statistics_set_probes (stats);
+  sc_statistics_compute (stats);
+  handle = sc_statistics_get_handle (stats, "test_probes_odd calls");
+  if (stats->sarray->elem_count != 4 || handle != 0) {
+    SC_GLOBAL_LERROR ("probes statistics\n");
+    ++num_failed_tests;
+  }
+  else {
+    si = (sc_statinfo_t *) sc_array_index_int (stats->sarray, handle);
+    if (si->min != 5. || si->max != 5.) {
+      SC_GLOBAL_LERROR ("probes calls\n");
+      ++num_failed_tests;
+    }
+    si = (sc_statinfo_t *) sc_array_index_int (stats->sarray, 2);
+    if (si->min != 10. || si->max != 10.) {
+      SC_GLOBAL_LERROR ("probes nested calls\n");
+      ++num_failed_tests;
+    }
+  }
+  sc_statistics_print (stats, sc_package_id, SC_LP_INFO, 0, 0);
+  sc_statistics_destroy (stats);
+
+  return num_failed_tests;
+}
+
+static double
+test_counters_region (sc_statistics_t * stats, sc_flopinfo_t * fi)
+{
+  int                 i;
+  double              sum = 0.;
+  sc_flopinfo_t       snap;
+
+  SC_FUNC_SNAP (stats, fi, &snap);
+  for (i = 1; i <= 100000; ++i) {
+    sum += 1. / i;
+  }
+  SC_FUNC_SHOT (stats, fi, &snap);
+  return sum;
+}
+
+static int
+test_flops_counters (sc_MPI_Comm mpicomm)
+{
+  int                 num_failed_tests = 0;
+  int                 mpiret, mpisize;
+  int                 opened, allopened;
+  int                 handle;
+  const sc_flops_counter_t counters[2] =
+    { SC_FLOPS_CYCLES, SC_FLOPS_INSTRUCTIONS };
+  sc_flopinfo_t       fi;
+  sc_statinfo_t      *si;
+  sc_statistics_t    *stats;
+
+  mpiret = sc_MPI_Comm_size (mpicomm, &mpisize);
+  SC_CHECK_MPI (mpiret);
+
+  /* the counters may be unavailable, in particular in containers */
+  opened = sc_flops_counters_open (2, counters) == 0;
+  mpiret = sc_MPI_Allreduce (&opened, &allopened, 1, sc_MPI_INT,
+                             sc_MPI_MIN, mpicomm);
+  SC_CHECK_MPI (mpiret);
+  if (!allopened) {
+    SC_GLOBAL_INFO ("Hardware counters not available\n");
+    sc_flops_counters_close ();
+    return 0;
+  }
+  if (sc_flops_counters_num () != 2 ||
+      sc_flops_counters_event (1) != SC_FLOPS_INSTRUCTIONS) {
+    SC_GLOBAL_LERROR ("flops counters open\n");
+    ++num_failed_tests;
+  }
+
+  stats = sc_statistics_new (mpicomm);
+  sc_flops_start_nopapi (&fi);
+  test_counters_region (stats, &fi);
+  test_counters_region (stats, &fi);
+  if (fi.num_counters != 2 || fi.ccounters[0] <= 0 ||
+      fi.ccounters[1] < 100000) {
+    SC_GLOBAL_LERROR ("flops counters values\n");
+    ++num_failed_tests;
+  }
+  sc_statistics_compute (stats);
+  handle = sc_statistics_get_handle (stats,
+                                     "test_counters_region instructions");
+  if (stats->sarray->elem_count != 3 || handle < 0) {
+    SC_GLOBAL_LERROR ("flops counters statistics\n");
+    ++num_failed_tests;
+  }
+  else {
+    si = (sc_statinfo_t *) sc_array_index_int (stats->sarray, handle);
+    if (si->count != 2 * mpisize || si->min < 100000) {
+      SC_GLOBAL_LERROR ("flops counters statistics values\n");
+      ++num_failed_tests;
+    }
+  }
+  sc_statistics_destroy (stats);
+  sc_flops_counters_close ();
+
+  return num_failed_tests;
+}
+
+static int
+test_timer_tree (sc_MPI_Comm mpicomm)
+{
+  int                 num_failed_tests = 0;
+  int                 mpiret, mpirank, i;
+  sc_statinfo_t       si;
+  sc_timer_tree_t    *tree;
+
+  mpiret = sc_MPI_Comm_rank (mpicomm, &mpirank);
+  SC_CHECK_MPI (mpiret);
+
+  /* a variable without values on rank 0 must not alter the minimum */
+  sc_stats_init (&si, "sparse");
+  if (mpirank > 0) {
+    sc_stats_accumulate (&si, 1. + mpirank);
+  }
+  sc_stats_compute (mpicomm, 1, &si);
+  if (mpirank > 0 && (si.min != 2. || si.min_at_rank != 1)) {
+    SC_LERROR ("statistics minimum with empty rank\n");
+    ++num_failed_tests;
+  }
+
+  /* the trees differ between the processes */
+  tree = sc_timer_tree_new ();
+  sc_timer_push (tree, "outer");
+  for (i = 0; i < 3; ++i) {
+    sc_timer_push (tree, "inner");
+    if (mpirank % 2) {
+      sc_timer_push (tree, "odd");
+      sc_timer_pop (tree, "odd");
+    }
+    sc_timer_pop (tree, "inner");
+  }
+  sc_timer_pop (tree, "outer");
+  sc_timer_push (tree, mpirank % 2 ? "odd" : "even");
+  sc_timer_pop (tree, mpirank % 2 ? "odd" : "even");
+  sc_timer_tree_print (tree, mpicomm, sc_package_id, SC_LP_INFO);
+  sc_timer_tree_destroy (tree);
+
+  return num_failed_tests;
+}
+
+int
+main (int argc, char **argv)
+{
+  int                 mpiret;
+  sc_MPI_Comm         mpicomm;
+  int                 num_failed_tests;
+
+  /* standard initialization */
+  mpiret = sc_MPI_Init (&argc, &argv);
+  SC_CHECK_MPI (mpiret);
+  mpicomm = sc_MPI_COMM_WORLD;
+
+  sc_init (mpicomm, 1, 1, NULL, SC_LP_DEFAULT);
+
+  num_failed_tests = 0;
+
+  /* test the reduction of nested timers */
+  num_failed_tests += test_timer_tree (mpicomm);
+
+  /* test the histograms of statistics */
+  num_failed_tests += test_stats_quantiles (mpicomm);
+
+  /* test the access of statistics by handle */
+  num_failed_tests += test_statistics_handles (mpicomm);
+  num_failed_tests += test_stats_window (mpicomm);
+
+  /* test the monotonic clock */
+  num_failed_tests += test_clock ();
+
+  /* test the probe sites */
+  num_failed_tests += test_probes (mpicomm);
+
+  /* test the hardware counters of sc_flops */
+  num_failed_tests += test_flops_counters (mpicomm);
+
+  /* clean up and exit */
+  sc_finalize ();
+
+  mpiret = sc_MPI_Finalize ();
+  SC_CHECK_MPI (mpiret);
+
+  return num_failed_tests ? EXIT_FAILURE : EXIT_SUCCESS;
+}
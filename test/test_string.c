@@ -0,0 +1,115 @@
+/*
+  This file is part of the SC Library.
+  The SC Library provides support for parallel scientific applications.
+
+  Copyright (C) 2010 The University of Texas System
+  Additional copyright (C) 2011 individual authors
+
+  The SC Library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  The SC Library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with the SC Library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+  02110-1301, USA.
+*/
+
+#include <sc_io.h>
+#include <sc_string.h>
+
+static int
+test_strbuf (void)
+{
+  int                 num_failed_tests = 0;
+  int                 i;
+  size_t              length;
+  char               *s;
+  char                line[32];
+  const char         *content;
+  sc_array_t         *buffer;
+  sc_io_sink_t       *sink;
+  sc_strbuf_t         sb;
+
+  /* grow far beyond the small storage and the fixed size string */
+  sc_strbuf_init (&sb);
+  for (i = 0; i < 1000; ++i) {
+    if (sc_strbuf_putf (&sb, "%d,", i) || sc_strbuf_putc (&sb, ' ')) {
+      ++num_failed_tests;
+    }
+  }
+  (void) sc_strbuf_puts (&sb, "end");
+  content = sc_strbuf_get_content (&sb, &length);
+  if (length != strlen (content) || length <= SC_STRING_SIZE ||
+      strncmp (content, "0, 1, 2, ", 9) ||
+      strcmp (content + length - 8, "999, end")) {
+    ++num_failed_tests;
+  }
+
+  /* the content goes to a sink as is */
+  buffer = sc_array_new (1);
+  sink = sc_io_sink_new (SC_IO_TYPE_BUFFER, SC_IO_MODE_WRITE,
+                         SC_IO_ENCODE_NONE, buffer);
+  if (sink == NULL || sc_strbuf_write (&sb, sink) ||
+      sc_io_sink_destroy (sink) || buffer->elem_count != length ||
+      memcmp (buffer->array, content, length)) {
+    ++num_failed_tests;
+  }
+  sc_array_destroy (buffer);
+
+  /* detaching keeps the string valid and empties the builder */
+  s = sc_strbuf_detach (&sb, &length);
+  if (strlen (s) != length || sc_strbuf_get_content (&sb, NULL)[0] != '\0') {
+    ++num_failed_tests;
+  }
+  SC_FREE (s);
+  for (i = 0; i < 3; ++i) {
+    snprintf (line, 32, "line %d\n", i);
+    (void) sc_strbuf_puts (&sb, line);
+  }
+  s = sc_strbuf_detach (&sb, NULL);
+  if (strcmp (s, "line 0\nline 1\nline 2\n")) {
+    ++num_failed_tests;
+  }
+  SC_FREE (s);
+  sc_strbuf_reset (&sb);
+
+  if (num_failed_tests) {
+    SC_GLOBAL_LERRORF ("string builder %d mismatches\n", num_failed_tests);
+  }
+  return num_failed_tests;
+}
+
+int
+main (int argc, char **argv)
+{
+  int                 mpiret;
+  sc_MPI_Comm         mpicomm;
+  int                 num_failed_tests;
+
+  /* standard initialization */
+  mpiret = sc_MPI_Init (&argc, &argv);
+  SC_CHECK_MPI (mpiret);
+  mpicomm = sc_MPI_COMM_WORLD;
+
+  sc_init (mpicomm, 1, 1, NULL, SC_LP_DEFAULT);
+
+  num_failed_tests = 0;
+
+  /* test the growing string builder */
+  num_failed_tests += test_strbuf ();
+
+  /* clean up and exit */
+  sc_finalize ();
+
+  mpiret = sc_MPI_Finalize ();
+  SC_CHECK_MPI (mpiret);
+
+  return num_failed_tests ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,141 @@
+/*
+  This file is part of the SC Library.
+  The SC Library provides support for parallel scientific applications.
+
+  Copyright (C) 2010 The University of Texas System
+  Additional copyright (C) 2011 individual authors
+
+  The SC Library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  The SC Library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with the SC Library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+  02110-1301, USA.
+*/
+
+#include <sc_taskpool.h>
+
+#define TEST_TASKPOOL_COUNT 100003
+#define TEST_TASKPOOL_GRAIN 97
+
+/* the arguments of the recursive fork-join test */
+typedef struct test_taskpool_fib
+{
+  sc_taskpool_t      *pool;
+  int                 n;
+  long                result;
+}
+test_taskpool_fib_t;
+
+/* loop data that is written once per index */
+typedef struct test_taskpool_loop
+{
+  char               *visits;
+  size_t              grain;
+}
+test_taskpool_loop_t;
+
+static void
+test_taskpool_range (size_t begin, size_t end, void *user)
+{
+  test_taskpool_loop_t *loop = (test_taskpool_loop_t *) user;
+  size_t              i;
+
+  SC_CHECK_ABORT (begin < end && end - begin <= loop->grain, "Grain");
+  for (i = begin; i < end; ++i) {
+    ++loop->visits[i];
+  }
+}
+
+/* spawn one branch and compute the other while it may be stolen */
+static void
+test_taskpool_fib (void *user)
+{
+  test_taskpool_fib_t *f = (test_taskpool_fib_t *) user;
+  test_taskpool_fib_t a, b;
+  sc_taskgroup_t      group;
+
+  if (f->n < 2) {
+    f->result = f->n;
+    return;
+  }
+  a.pool = b.pool = f->pool;
+  a.n = f->n - 1;
+  b.n = f->n - 2;
+  sc_taskgroup_init (&group);
+  sc_taskpool_spawn (f->pool, &group, test_taskpool_fib, &a);
+  test_taskpool_fib (&b);
+  sc_taskpool_wait (f->pool, &group);
+  f->result = a.result + b.result;
+}
+
+static void
+test_taskpool (sc_taskpool_t * pool)
+{
+  size_t              i, begin;
+  test_taskpool_loop_t loop;
+  test_taskpool_fib_t f;
+
+  /* every index is visited exactly once for various grain sizes */
+  loop.visits = SC_ALLOC_ZERO (char, TEST_TASKPOOL_COUNT);
+  for (loop.grain = 1; loop.grain <= 10 * TEST_TASKPOOL_GRAIN;
+       loop.grain *= TEST_TASKPOOL_GRAIN) {
+    begin = loop.grain;
+    memset (loop.visits, 0, TEST_TASKPOOL_COUNT);
+    sc_taskpool_parallel_for (pool, begin, TEST_TASKPOOL_COUNT, loop.grain,
+                              test_taskpool_range, &loop);
+    for (i = 0; i < TEST_TASKPOOL_COUNT; ++i) {
+      SC_CHECK_ABORT (loop.visits[i] == (i >= begin), "Parallel for");
+    }
+  }
+  sc_taskpool_parallel_for (pool, 5, 5, 0, test_taskpool_range, &loop);
+  SC_FREE (loop.visits);
+
+  /* nested spawns and waits */
+  f.pool = pool;
+  f.n = 20;
+  test_taskpool_fib (&f);
+  SC_CHECK_ABORT (f.result == 6765, "Fork join");
+}
+
+int
+main (int argc, char **argv)
+{
+  int                 mpiret;
+  sc_taskpool_t      *pool;
+
+  mpiret = sc_MPI_Init (&argc, &argv);
+  SC_CHECK_MPI (mpiret);
+
+  sc_init (sc_MPI_COMM_WORLD, 1, 1, NULL, SC_LP_DEFAULT);
+
+  pool = sc_taskpool_new (1, 0);
+  SC_CHECK_ABORT (sc_taskpool_num_threads (pool) == 1, "Serial pool");
+  test_taskpool (pool);
+  sc_taskpool_destroy (pool);
+
+  pool = sc_taskpool_new (4, 1);
+  SC_CHECK_ABORT (sc_taskpool_num_threads (pool) == 4, "Pinned pool");
+  test_taskpool (pool);
+  sc_taskpool_destroy (pool);
+
+  /* the pool of the library is freed in sc_finalize */
+  pool = sc_taskpool_get ();
+  SC_CHECK_ABORT (pool == sc_taskpool_get (), "Library pool");
+  test_taskpool (pool);
+
+  sc_finalize ();
+
+  mpiret = sc_MPI_Finalize ();
+  SC_CHECK_MPI (mpiret);
+
+  return 0;
+}
@@ -0,0 +1,131 @@
+/*
+  This file is part of the SC Library.
+  The SC Library provides support for parallel scientific applications.
+
+  Copyright (C) 2010 The University of Texas System
+  Additional copyright (C) 2011 individual authors
+
+  The SC Library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  The SC Library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with the SC Library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+  02110-1301, USA.
+*/
+
+#include <sc_unique_counter.h>
+#ifdef SC_ENABLE_PTHREAD
+#include <pthread.h>
+#endif
+
+#define TEST_UNIQUE_COUNTER_THREADS 4
+
+typedef struct test_unique_counter_thread
+{
+  int                 num_values;
+  sc_unique_counter_concurrent_t *uc;
+  int                *values;   /* the values of this thread */
+}
+test_unique_counter_thread_t;
+
+/* draw unique values, releasing and reacquiring every other one */
+static void        *
+test_unique_counter_draw (void *v)
+{
+  test_unique_counter_thread_t *td = (test_unique_counter_thread_t *) v;
+  int                 i, j;
+
+  for (i = 0; i < td->num_values; ++i) {
+    td->values[i] = sc_unique_counter_concurrent_add (td->uc);
+  }
+  for (j = 0; j < 2; ++j) {
+    for (i = j; i < td->num_values; i += 2) {
+      sc_unique_counter_concurrent_release (td->uc, td->values[i]);
+    }
+    for (i = j; i < td->num_values; i += 2) {
+      td->values[i] = sc_unique_counter_concurrent_add (td->uc);
+    }
+  }
+
+  return NULL;
+}
+
+int
+main (int argc, char **argv)
+{
+  const int           num_values = 10000;
+  int                 mpiret;
+  int                 t, i;
+  int                 total, value;
+  char               *used;
+  sc_unique_counter_concurrent_t *uc;
+  test_unique_counter_thread_t td[TEST_UNIQUE_COUNTER_THREADS];
+#ifdef SC_ENABLE_PTHREAD
+  pthread_t           threads[TEST_UNIQUE_COUNTER_THREADS];
+#endif
+
+  mpiret = sc_MPI_Init (&argc, &argv);
+  SC_CHECK_MPI (mpiret);
+
+  sc_init (sc_MPI_COMM_WORLD, 1, 1, NULL, SC_LP_DEFAULT);
+
+  /* draw values on several threads at once */
+  total = TEST_UNIQUE_COUNTER_THREADS * num_values;
+  uc = sc_unique_counter_concurrent_new (7);
+  for (t = 0; t < TEST_UNIQUE_COUNTER_THREADS; ++t) {
+    td[t].num_values = num_values;
+    td[t].uc = uc;
+    td[t].values = SC_ALLOC (int, num_values);
+  }
+#ifdef SC_ENABLE_PTHREAD
+  for (t = 0; t < TEST_UNIQUE_COUNTER_THREADS; ++t) {
+    SC_CHECK_ABORT (!pthread_create (&threads[t], NULL,
+                                     test_unique_counter_draw, &td[t]),
+                    "Thread creation");
+  }
+  for (t = 0; t < TEST_UNIQUE_COUNTER_THREADS; ++t) {
+    SC_CHECK_ABORT (!pthread_join (threads[t], NULL), "Thread join");
+  }
+#else
+  for (t = 0; t < TEST_UNIQUE_COUNTER_THREADS; ++t) {
+    (void) test_unique_counter_draw (&td[t]);
+  }
+#endif
+
+  /* every value is in use exactly once and reuse keeps the range tight */
+  SC_CHECK_ABORT (sc_unique_counter_concurrent_count (uc) ==
+                  (size_t) total, "Counter count");
+  used = SC_ALLOC_ZERO (char, total);
+  for (t = 0; t < TEST_UNIQUE_COUNTER_THREADS; ++t) {
+    for (i = 0; i < num_values; ++i) {
+      value = td[t].values[i] - 7;
+      SC_CHECK_ABORT (0 <= value && value < total && !used[value],
+                      "Counter value");
+      used[value] = 1;
+      sc_unique_counter_concurrent_release (uc, td[t].values[i]);
+    }
+    SC_FREE (td[t].values);
+  }
+  SC_CHECK_ABORT (sc_unique_counter_concurrent_count (uc) == 0 &&
+                  sc_unique_counter_concurrent_add (uc) == 7 &&
+                  sc_unique_counter_concurrent_memory_used (uc) <=
+                  sizeof (uint64_t) * 2 * total / 64 + 1024, "Counter reuse");
+  sc_unique_counter_concurrent_release (uc, 7);
+  SC_FREE (used);
+  sc_unique_counter_concurrent_destroy (uc);
+
+  sc_finalize ();
+
+  mpiret = sc_MPI_Finalize ();
+  SC_CHECK_MPI (mpiret);
+
+  return 0;
+}
@@ -0,0 +1,169 @@
+/*
+  This file is part of the SC Library.
+  The SC Library provides support for parallel scientific applications.
+
+  Copyright (C) 2010 The University of Texas System
+  Additional copyright (C) 2011 individual authors
+
+  The SC Library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  The SC Library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with the SC Library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+  02110-1301, USA.
+*/
+
+#include <sc_v4l2.h>
+#include <sc_random.h>
+
+#define TEST_V4L2_WIDTH 322
+#define TEST_V4L2_HEIGHT 258
+
+/* the converted image with its layout */
+typedef struct test_v4l2_image
+{
+  size_t              bytesperline;
+  size_t              size;
+  char               *data;
+}
+test_v4l2_image_t;
+
+static void
+test_v4l2_convert (sc_v4l2_pixel_t srcformat, const char *src,
+                   size_t srcstride, sc_v4l2_pixel_t destformat,
+                   int num_threads, test_v4l2_image_t * image)
+{
+  const size_t        pad = 6;
+
+  image->bytesperline = (destformat <= SC_V4L2_PIXEL_YUYV ? 2 : 1) *
+    TEST_V4L2_WIDTH + pad;
+  image->size = image->bytesperline * TEST_V4L2_HEIGHT;
+  if (destformat >= SC_V4L2_PIXEL_NV12) {
+    image->size += image->size / 2;
+  }
+  image->data = SC_ALLOC_ZERO (char, image->size);
+  sc_v4l2_convert (srcformat, src, srcstride, destformat, image->data,
+                   image->bytesperline, TEST_V4L2_WIDTH, TEST_V4L2_HEIGHT,
+                   num_threads);
+}
+
+/* check the reference colors of BT.601 limited range */
+static void
+test_v4l2_colors (void)
+{
+  const unsigned char rgb[4][3] =
+    { {0, 0, 0}, {255, 255, 255}, {255, 0, 0}, {0, 0, 255} };
+  const unsigned char yuv[4][3] =
+    { {16, 128, 128}, {235, 128, 128}, {82, 90, 240}, {41, 240, 110} };
+  int                 c;
+  unsigned char       src[6], dest[4];
+
+  for (c = 0; c < 4; ++c) {
+    memcpy (src, rgb[c], 3);
+    memcpy (src + 3, rgb[c], 3);
+    sc_v4l2_convert (SC_V4L2_PIXEL_RGB24, (const char *) src, 6,
+                     SC_V4L2_PIXEL_YUYV, (char *) dest, 4, 2, 1, 1);
+    SC_CHECK_ABORT (dest[0] == yuv[c][0] && dest[2] == yuv[c][0], "Luma");
+    SC_CHECK_ABORT (dest[1] == yuv[c][1], "Cb");
+    SC_CHECK_ABORT (dest[3] == yuv[c][2], "Cr");
+  }
+
+  /* pure red in RGB 565 is little endian 0xf800 */
+  sc_v4l2_convert (SC_V4L2_PIXEL_RGB24, (const char *) rgb[2], 3,
+                   SC_V4L2_PIXEL_RGB565, (char *) dest, 2, 1, 1, 1);
+  SC_CHECK_ABORT (dest[0] == 0x00 && dest[1] == 0xf8, "RGB 565");
+}
+
+int
+main (int argc, char **argv)
+{
+  int                 mpiret;
+  int                 f;
+  size_t              i, j, k;
+  size_t              luma, rgbstride, rgbastride;
+  sc_rand_state_t     state = 11;
+  char               *rgb, *rgba;
+  test_v4l2_image_t   serial, threaded, other;
+
+  mpiret = sc_MPI_Init (&argc, &argv);
+  SC_CHECK_MPI (mpiret);
+
+  sc_init (sc_MPI_COMM_WORLD, 1, 1, NULL, SC_LP_DEFAULT);
+
+  test_v4l2_colors ();
+
+  /* a random image with padded rows in both source formats */
+  rgbstride = 3 * TEST_V4L2_WIDTH + 5;
+  rgbastride = 4 * TEST_V4L2_WIDTH;
+  rgb = SC_ALLOC (char, rgbstride * TEST_V4L2_HEIGHT);
+  rgba = SC_ALLOC (char, rgbastride * TEST_V4L2_HEIGHT);
+  for (i = 0; i < TEST_V4L2_HEIGHT; ++i) {
+    for (j = 0; j < TEST_V4L2_WIDTH; ++j) {
+      for (k = 0; k < 3; ++k) {
+        rgb[i * rgbstride + 3 * j + k] = rgba[i * rgbastride + 4 * j + k] =
+          (char) (256. * sc_rand (&state));
+      }
+      rgba[i * rgbastride + 4 * j + 3] = (char) j;
+    }
+  }
+
+  /* the result does not depend on threads or the source format */
+  for (f = SC_V4L2_PIXEL_RGB565; f <= SC_V4L2_PIXEL_I420; ++f) {
+    test_v4l2_convert (SC_V4L2_PIXEL_RGB24, rgb, rgbstride,
+                       (sc_v4l2_pixel_t) f, 1, &serial);
+    test_v4l2_convert (SC_V4L2_PIXEL_RGBA, rgba, rgbastride,
+                       (sc_v4l2_pixel_t) f, 3, &threaded);
+    SC_CHECK_ABORT (!memcmp (serial.data, threaded.data, serial.size),
+                    "Threaded conversion");
+    SC_FREE (threaded.data);
+    SC_FREE (serial.data);
+  }
+
+  /* the planar formats share the luma and differ in the chroma layout */
+  test_v4l2_convert (SC_V4L2_PIXEL_RGB24, rgb, rgbstride,
+                     SC_V4L2_PIXEL_NV12, 0, &serial);
+  test_v4l2_convert (SC_V4L2_PIXEL_RGB24, rgb, rgbstride,
+                     SC_V4L2_PIXEL_I420, 0, &other);
+  test_v4l2_convert (SC_V4L2_PIXEL_RGB24, rgb, rgbstride,
+                     SC_V4L2_PIXEL_YUYV, 0, &threaded);
+  luma = serial.bytesperline * TEST_V4L2_HEIGHT;
+  SC_CHECK_ABORT (!memcmp (serial.data, other.data, luma), "Luma planes");
+  for (i = 0; i < TEST_V4L2_HEIGHT; ++i) {
+    for (j = 0; j < TEST_V4L2_WIDTH; ++j) {
+      SC_CHECK_ABORT (serial.data[i * serial.bytesperline + j] ==
+                      threaded.data[i * threaded.bytesperline + 2 * j],
+                      "Packed luma");
+    }
+  }
+  for (i = 0; i < TEST_V4L2_HEIGHT / 2; ++i) {
+    for (j = 0; j < TEST_V4L2_WIDTH / 2; ++j) {
+      k = i * other.bytesperline / 2 + j;
+      SC_CHECK_ABORT (serial.data[luma + i * serial.bytesperline + 2 * j] ==
+                      other.data[luma + k], "Cb planes");
+      SC_CHECK_ABORT (serial.data[luma + i * serial.bytesperline + 2 * j +
+                                  1] == other.data[luma + luma / 4 + k],
+                      "Cr planes");
+    }
+  }
+  SC_FREE (threaded.data);
+  SC_FREE (other.data);
+  SC_FREE (serial.data);
+
+  SC_FREE (rgba);
+  SC_FREE (rgb);
+
+  sc_finalize ();
+
+  mpiret = sc_MPI_Finalize ();
+  SC_CHECK_MPI (mpiret);
+
+  return 0;
+}